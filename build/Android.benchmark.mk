@@ -0,0 +1,159 @@
+#
+# Copyright (C) 2014 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+########################################################################
+# Rules to run the runtime microbenchmarks of test/Benchmark with "mm test-art-host-benchmark"
+# or "mm test-art-target-benchmark". They print one "<name> <value> <unit>" line per measurement,
+# in a fixed order, so that the output of two builds can be compared. They are not part of
+# test-art: they use the non-debug runtime and take a while.
+#
+# ART_BENCHMARK_ARGS selects the benchmarks to run by name prefix, for example
+# "mm test-art-host-benchmark ART_BENCHMARK_ARGS=monitor.".
+
+ART_BENCHMARK_ARGS ?=
+# A fixed heap size, so that the collections don't depend on the heap growth.
+ART_BENCHMARK_DALVIKVM_FLAGS := -Xms64m -Xmx64m
+
+LIBARTBENCHMARK_COMMON_SRC_FILES := \
+	test/Benchmark/benchmark_jni.cc
+
+ART_TARGET_LIBARTBENCHMARK_$(ART_PHONY_TEST_TARGET_SUFFIX) += $(ART_TEST_OUT)/$(TARGET_ARCH)/libartbenchmark.so
+ifdef TARGET_2ND_ARCH
+  ART_TARGET_LIBARTBENCHMARK_$(2ND_ART_PHONY_TEST_TARGET_SUFFIX) += $(ART_TEST_OUT)/$(TARGET_2ND_ARCH)/libartbenchmark.so
+endif
+
+# The native methods of the benchmarks. Unlike libarttest, the library doesn't link against
+# libartd, so that it can be loaded in the non-debug runtime.
+# $(1): target or host
+define build-libartbenchmark
+  ifneq ($(1),target)
+    ifneq ($(1),host)
+      $$(error expected target or host for argument 1, received $(1))
+    endif
+  endif
+
+  art_target_or_host := $(1)
+
+  include $(CLEAR_VARS)
+  LOCAL_CPP_EXTENSION := $(ART_CPP_EXTENSION)
+  LOCAL_MODULE := libartbenchmark
+  ifeq ($$(art_target_or_host),target)
+    LOCAL_MODULE_TAGS := tests
+  endif
+  LOCAL_SRC_FILES := $(LIBARTBENCHMARK_COMMON_SRC_FILES)
+  LOCAL_C_INCLUDES += $(ART_C_INCLUDES) art/runtime
+  LOCAL_ADDITIONAL_DEPENDENCIES := $(LOCAL_PATH)/build/Android.common.mk
+  LOCAL_ADDITIONAL_DEPENDENCIES += $(LOCAL_PATH)/build/Android.benchmark.mk
+  ifeq ($$(art_target_or_host),target)
+    LOCAL_CLANG := $(ART_TARGET_CLANG)
+    LOCAL_CFLAGS := $(ART_TARGET_CFLAGS) $(ART_TARGET_NON_DEBUG_CFLAGS)
+    LOCAL_CFLAGS_x86 := $(ART_TARGET_CFLAGS_x86)
+    LOCAL_MULTILIB := both
+    LOCAL_MODULE_PATH_32 := $(ART_TEST_OUT)/$(ART_TARGET_ARCH_32)
+    LOCAL_MODULE_PATH_64 := $(ART_TEST_OUT)/$(ART_TARGET_ARCH_64)
+    LOCAL_MODULE_TARGET_ARCH := $(ART_SUPPORTED_ARCH)
+    include external/libcxx/libcxx.mk
+    include $(BUILD_SHARED_LIBRARY)
+  else # host
+    LOCAL_CLANG := $(ART_HOST_CLANG)
+    LOCAL_CFLAGS := $(ART_HOST_CFLAGS) $(ART_HOST_NON_DEBUG_CFLAGS)
+    LOCAL_IS_HOST_MODULE := true
+    include $(BUILD_HOST_SHARED_LIBRARY)
+  endif
+endef
+
+ifeq ($(ART_BUILD_TARGET),true)
+  $(eval $(call build-libartbenchmark,target))
+endif
+ifeq ($(WITH_HOST_DALVIK),true)
+  ifeq ($(ART_BUILD_HOST),true)
+    $(eval $(call build-libartbenchmark,host))
+  endif
+endif
+
+########################################################################
+
+$(HOST_OUT_JAVA_LIBRARIES)/$(ART_HOST_ARCH)/benchmark-dex-Benchmark.odex: $(HOST_OUT_JAVA_LIBRARIES)/benchmark-dex-Benchmark.jar $(HOST_CORE_IMG_OUT) | $(DEX2OATD)
+	$(DEX2OATD) $(DEX2OAT_FLAGS) --runtime-arg -Xms16m --runtime-arg -Xmx16m --boot-image=$(HOST_CORE_IMG_LOCATION) --dex-file=$(realpath $<) --oat-file=$@ --instruction-set=$(ART_HOST_ARCH) --host --android-root=$(HOST_OUT)
+
+.PHONY: test-art-host-benchmark
+test-art-host-benchmark: $(HOST_OUT_JAVA_LIBRARIES)/$(ART_HOST_ARCH)/benchmark-dex-Benchmark.odex test-art-host-dependencies
+	mkdir -p /tmp/android-data/test-art-host-benchmark
+	ANDROID_DATA=/tmp/android-data/test-art-host-benchmark \
+	  ANDROID_ROOT=$(HOST_OUT) \
+	  LD_LIBRARY_PATH=$(HOST_OUT_SHARED_LIBRARIES) \
+	  $(HOST_OUT_EXECUTABLES)/dalvikvm $(DALVIKVM_FLAGS) $(ART_BENCHMARK_DALVIKVM_FLAGS) -XXlib:libart.so -Ximage:$(HOST_CORE_IMG_LOCATION) -classpath $(HOST_OUT_JAVA_LIBRARIES)/benchmark-dex-Benchmark.jar -Djava.library.path=$(HOST_OUT_SHARED_LIBRARIES) Benchmark $(ART_BENCHMARK_ARGS)
+	$(hide) rm -r /tmp/android-data/test-art-host-benchmark
+
+# $(1): 2ND_ or undefined
+define declare-test-art-target-benchmark-impl
+.PHONY: test-art-target-benchmark$($(1)ART_PHONY_TEST_TARGET_SUFFIX)
+test-art-target-benchmark$($(1)ART_PHONY_TEST_TARGET_SUFFIX): test-art-target-sync
+	adb shell /system/bin/dalvikvm$($(1)ART_TARGET_BINARY_SUFFIX) $(DALVIKVM_FLAGS) $(ART_BENCHMARK_DALVIKVM_FLAGS) -XXlib:libart.so -Ximage:$(ART_TEST_DIR)/core.art -classpath $(ART_TEST_DIR)/benchmark-dex-Benchmark.jar -Djava.library.path=$(ART_TEST_DIR)/$(TARGET_$(1)ARCH) Benchmark $(ART_BENCHMARK_ARGS)
+endef
+
+ifdef TARGET_2ND_ARCH
+  $(eval $(call declare-test-art-target-benchmark-impl,2ND_))
+
+  # Bind the primary to the non-suffix rule
+  ifneq ($(ART_PHONY_TEST_TARGET_SUFFIX),)
+test-art-target-benchmark: test-art-target-benchmark$(ART_PHONY_TEST_TARGET_SUFFIX)
+  endif
+endif
+$(eval $(call declare-test-art-target-benchmark-impl,))
+
+.PHONY: test-art-benchmark
+test-art-benchmark: test-art-host-benchmark test-art-target-benchmark
+
+########################################################################
+# Rules to measure dex2oat with "mm test-art-host-compiler-benchmark": the host core dex files are
+# compiled with each backend into an image, the way the boot image is built, and the compile time,
+# peak arena memory and code size of each method are written to
+# $(ART_COMPILER_BENCHMARK_OUT)/<backend>.txt with --dump-method-stats. With
+# ART_COMPILER_BENCHMARK_BASELINE set to the directory of the files of a previous run, each file
+# is compared to its baseline with tools/compare-method-stats.py, which fails if the total code
+# size or arena memory grew. Run it without -j, so that the backends don't compete for the CPUs.
+
+ART_COMPILER_BENCHMARK_BACKENDS := Quick Optimizing
+ifeq ($(ART_USE_PORTABLE_COMPILER),true)
+  ART_COMPILER_BENCHMARK_BACKENDS += Portable
+endif
+ART_COMPILER_BENCHMARK_OUT := $(HOST_OUT)/art-compiler-benchmark
+ART_COMPILER_BENCHMARK_BASELINE ?=
+
+# $(1): backend
+define declare-test-art-host-compiler-benchmark
+.PHONY: test-art-host-compiler-benchmark-$(1)
+test-art-host-compiler-benchmark-$(1): $(HOST_CORE_DEX_FILES) $(DEX2OAT_DEPENDENCY)
+	rm -rf $(ART_COMPILER_BENCHMARK_OUT)/$(1) && mkdir -p $(ART_COMPILER_BENCHMARK_OUT)/$(1)
+	$(DEX2OAT) --runtime-arg -Xms16m --runtime-arg -Xmx16m --compiler-backend=$(1) \
+		--image-classes=$(PRELOADED_CLASSES) $(addprefix --dex-file=,$(HOST_CORE_DEX_FILES)) \
+		$(addprefix --dex-location=,$(HOST_CORE_DEX_LOCATIONS)) \
+		--oat-file=$(ART_COMPILER_BENCHMARK_OUT)/$(1)/core.oat \
+		--image=$(ART_COMPILER_BENCHMARK_OUT)/$(1)/core.art --base=$(LIBART_IMG_HOST_BASE_ADDRESS) \
+		--instruction-set=$(ART_HOST_ARCH) --host --android-root=$(HOST_OUT) --dump-timing \
+		--dump-method-stats=$(ART_COMPILER_BENCHMARK_OUT)/$(1).txt
+	$(hide) rm -r $(ART_COMPILER_BENCHMARK_OUT)/$(1)
+  ifneq ($(ART_COMPILER_BENCHMARK_BASELINE),)
+	art/tools/compare-method-stats.py $(ART_COMPILER_BENCHMARK_BASELINE)/$(1).txt $(ART_COMPILER_BENCHMARK_OUT)/$(1).txt
+  endif
+endef
+$(foreach backend, $(ART_COMPILER_BENCHMARK_BACKENDS), \
+  $(eval $(call declare-test-art-host-compiler-benchmark,$(backend))))
+
+.PHONY: test-art-host-compiler-benchmark
+test-art-host-compiler-benchmark: \
+  $(addprefix test-art-host-compiler-benchmark-, $(ART_COMPILER_BENCHMARK_BACKENDS))
@@ -19,11 +19,13 @@ LOCAL_PATH := art
 RUNTIME_GTEST_COMMON_SRC_FILES := \
 	runtime/arch/arch_test.cc \
 	runtime/arch/stub_test.cc \
+	runtime/arch/x86/instruction_size_x86_test.cc \
 	runtime/barrier_test.cc \
 	runtime/base/bit_field_test.cc \
 	runtime/base/bit_vector_test.cc \
 	runtime/base/hex_dump_test.cc \
 	runtime/base/histogram_test.cc \
+	runtime/base/latency_histogram_test.cc \
 	runtime/base/mutex_test.cc \
 	runtime/base/timing_logger_test.cc \
 	runtime/base/unix_file/fd_file_test.cc \
@@ -32,13 +34,18 @@ RUNTIME_GTEST_COMMON_SRC_FILES := \
 	runtime/base/unix_file/random_access_file_utils_test.cc \
 	runtime/base/unix_file/string_file_test.cc \
 	runtime/class_linker_test.cc \
+	runtime/class_preloader_test.cc \
+	runtime/class_table_test.cc \
 	runtime/dex_file_test.cc \
 	runtime/dex_instruction_visitor_test.cc \
 	runtime/dex_method_iterator_test.cc \
 	runtime/entrypoints/math_entrypoints_test.cc \
 	runtime/exception_test.cc \
+	runtime/gc/accounting/card_table_test.cc \
 	runtime/gc/accounting/space_bitmap_test.cc \
+	runtime/gc/allocation_sampler_test.cc \
 	runtime/gc/heap_test.cc \
+	runtime/gc/native_cleaner_test.cc \
 	runtime/gc/space/dlmalloc_space_base_test.cc \
 	runtime/gc/space/dlmalloc_space_static_test.cc \
 	runtime/gc/space/dlmalloc_space_random_test.cc \
@@ -57,9 +64,11 @@ RUNTIME_GTEST_COMMON_SRC_FILES := \
 	runtime/mirror/dex_cache_test.cc \
 	runtime/mirror/object_test.cc \
 	runtime/parsed_options_test.cc \
+	runtime/perf_map_test.cc \
 	runtime/reference_table_test.cc \
 	runtime/thread_pool_test.cc \
 	runtime/transaction_test.cc \
+	runtime/type_lookup_table_test.cc \
 	runtime/utils_test.cc \
 	runtime/verifier/method_verifier_test.cc \
 	runtime/verifier/reg_type_test.cc \
@@ -72,21 +81,35 @@ COMPILER_GTEST_COMMON_SRC_FILES := \
 	compiler/dex/local_value_numbering_test.cc \
 	compiler/dex/mir_optimization_test.cc \
 	compiler/driver/compiler_driver_test.cc \
+	compiler/driver/incremental_compilation_test.cc \
+	compiler/dex_layout_test.cc \
 	compiler/elf_writer_test.cc \
 	compiler/image_test.cc \
 	compiler/jni/jni_compiler_test.cc \
 	compiler/oat_test.cc \
+	compiler/optimizing/bounds_check_elimination_test.cc \
 	compiler/optimizing/codegen_test.cc \
+	compiler/optimizing/constant_folding_test.cc \
 	compiler/optimizing/dominator_test.cc \
 	compiler/optimizing/find_loops_test.cc \
+	compiler/optimizing/gvn_test.cc \
+	compiler/optimizing/licm_test.cc \
 	compiler/optimizing/linearize_test.cc \
 	compiler/optimizing/liveness_test.cc \
 	compiler/optimizing/live_ranges_test.cc \
+	compiler/optimizing/loop_vectorizer_test.cc \
+	compiler/optimizing/parallel_move_test.cc \
 	compiler/optimizing/pretty_printer_test.cc \
+	compiler/optimizing/register_allocator_test.cc \
+	compiler/optimizing/scalar_replacement_test.cc \
+	compiler/optimizing/ssa_phi_elimination_test.cc \
 	compiler/optimizing/ssa_test.cc \
+	compiler/optimizing/ssa_type_propagation_test.cc \
 	compiler/output_stream_test.cc \
+	compiler/stack_map_builder_test.cc \
 	compiler/utils/arena_allocator_test.cc \
 	compiler/utils/dedupe_set_test.cc \
+	compiler/utils/scoped_arena_hash_map_test.cc \
 	compiler/utils/arm/managed_register_arm_test.cc \
 	compiler/utils/arm64/managed_register_arm64_test.cc \
 	compiler/utils/x86/managed_register_x86_test.cc \
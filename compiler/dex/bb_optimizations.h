@@ -102,6 +102,24 @@ class CodeLayout : public Pass {
   bool WalkBasicBlocks(CompilationUnit* cUnit, BasicBlock* bb) const;
 };
 
+/**
+ * @class LoopOptimizations
+ * @brief Peel and unroll small innermost loops, before the SSA transformation.
+ */
+class LoopOptimizations : public Pass {
+ public:
+  LoopOptimizations() : Pass("LoopOptimizations", kNoNodes) {
+  }
+
+  bool Gate(const CompilationUnit* cUnit) const {
+    return ((cUnit->disable_opt & (1 << kLoopOpt)) == 0);
+  }
+
+  void Start(CompilationUnit* cUnit) const {
+    cUnit->mir_graph->OptimizeLoops();
+  }
+};
+
 /**
  * @class SSATransformation
  * @brief Perform an SSA representation pass on the CompilationUnit.
@@ -127,6 +127,16 @@ enum ExtendedMIROpcode {
   kMirOpCheckPart2,
   kMirOpSelect,
 
+  // @brief Guard of a virtual call devirtualized with class hierarchy analysis, or of an
+  // inline cache entry of a virtual or interface call.
+  // @details Null checks the receiver, and branches to the taken block unless its class
+  // dispatches the call to the method the invoke resolves to or, for an inline cache, unless
+  // its class is the cached one.
+  // vA: receiver
+  // vB: the address of the cached boot image class, 0 if not an inline cache
+  // meta.method_lowering_info: the lowering info of the guarded invoke
+  kMirOpVirtualTargetCheck,
+
   // Vector opcodes:
   // TypeSize is an encoded field giving the element type and the vector size.
   // It is encoded as OpSize << 16 | (number of bits in vector)
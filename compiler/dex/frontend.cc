@@ -53,6 +53,8 @@ static uint32_t kCompilerOptimizerDisableFlags = 0 |  // Disable specific optimi
   // (1 << kPromoteCompilerTemps) |
   // (1 << kSuppressExceptionEdges) |
   // (1 << kSuppressMethodInlining) |
+  // (1 << kListScheduling) |
+  // (1 << kLoopOpt) |
   0;
 
 static uint32_t kCompilerDebugFlags = 0 |     // Enable debug/testing modes
@@ -406,6 +408,7 @@ int arm64_support_list[] = {
     kMirOpCheck,
     // kMirOpCheckPart2,
     // kMirOpSelect,
+    // kMirOpVirtualTargetCheck,
     // kMirOpLast,
 };
 
@@ -683,6 +686,7 @@ int x86_64_support_list[] = {
     // kMirOpCheck,
     // kMirOpCheckPart2,
     // kMirOpSelect,
+    // kMirOpVirtualTargetCheck,
     // kMirOpLast,
 };
 
@@ -933,8 +937,9 @@ static CompiledMethod* CompileMethod(CompilerDriver& driver,
   cu.mir_graph->RemapRegLocations();
 
   /* Free Arenas from the cu.arena_stack for reuse by the cu.arena in the codegen. */
+  size_t peak_arena_bytes = cu.arena.BytesUsed() + cu.arena_stack.PeakBytesUsed();
   if (cu.enable_debug & (1 << kDebugShowMemoryUsage)) {
-    if (cu.arena_stack.PeakBytesAllocated() > 256 * 1024) {
+    if (cu.arena_stack.PeakBytesUsed() > 256 * 1024) {
       MemStats stack_stats(cu.arena_stack.GetPeakStats());
       LOG(INFO) << PrettyMethod(method_idx, dex_file) << " " << Dumpable<MemStats>(stack_stats);
     }
@@ -955,15 +960,18 @@ static CompiledMethod* CompileMethod(CompilerDriver& driver,
     VLOG(compiler) << "Deferred " << PrettyMethod(method_idx, dex_file);
   }
 
+  peak_arena_bytes = std::max(peak_arena_bytes, cu.arena.BytesUsed());
+  driver.RecordArenaUsage(dex_file, method_idx, peak_arena_bytes);
+
   if (cu.enable_debug & (1 << kDebugShowMemoryUsage)) {
-    if (cu.arena.BytesAllocated() > (1 * 1024 *1024)) {
+    if (cu.arena.BytesUsed() > (1 * 1024 *1024)) {
       MemStats mem_stats(cu.arena.GetMemStats());
       LOG(INFO) << PrettyMethod(method_idx, dex_file) << " " << Dumpable<MemStats>(mem_stats);
     }
   }
 
   if (cu.enable_debug & (1 << kDebugShowSummaryMemoryUsage)) {
-    LOG(INFO) << "MEMINFO " << cu.arena.BytesAllocated() << " " << cu.mir_graph->GetNumBlocks()
+    LOG(INFO) << "MEMINFO " << cu.arena.BytesUsed() << " " << cu.mir_graph->GetNumBlocks()
               << " " << PrettyMethod(method_idx, dex_file);
   }
 
@@ -54,6 +54,8 @@ enum opt_control_vector {
   kBranchFusing,
   kSuppressExceptionEdges,
   kSuppressMethodInlining,
+  kListScheduling,
+  kLoopOpt,
 };
 
 // Force code generation paths for testing.
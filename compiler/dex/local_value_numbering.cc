@@ -21,6 +21,66 @@
 
 namespace art {
 
+void LocalValueNumbering::EnterScope(bool only_predecessor_is_dominator) {
+  Scope scope;
+  scope.undo_log_size = undo_log_.size();
+  scope.global_memory_version = global_memory_version_;
+  scope.alias_epoch = alias_epoch_;
+  std::copy_n(unresolved_sfield_version_, kFieldTypeCount, scope.unresolved_sfield_version);
+  std::copy_n(unresolved_ifield_version_, kFieldTypeCount, scope.unresolved_ifield_version);
+  scopes_.push_back(scope);
+  if (!only_predecessor_is_dominator) {
+    // Other paths to the block may have written any memory location, including those of the
+    // non-aliasing references, which they may also have let escape.
+    AdvanceGlobalMemory();
+    alias_epoch_ = next_alias_epoch_;
+    ++next_alias_epoch_;
+  }
+}
+
+void LocalValueNumbering::LeaveScope() {
+  DCHECK(!scopes_.empty());
+  const Scope& scope = scopes_.back();
+  while (undo_log_.size() != scope.undo_log_size) {
+    const UndoRecord& record = undo_log_.back();
+    if (record.existed) {
+      record.map->Overwrite(record.key, record.old_value);
+    } else {
+      record.map->Erase(record.key);
+    }
+    undo_log_.pop_back();
+  }
+  // Memory versions and value names are not reused, the sibling blocks must not share them.
+  global_memory_version_ = scope.global_memory_version;
+  alias_epoch_ = scope.alias_epoch;
+  std::copy_n(scope.unresolved_sfield_version, kFieldTypeCount, unresolved_sfield_version_);
+  std::copy_n(scope.unresolved_ifield_version, kFieldTypeCount, unresolved_ifield_version_);
+  scopes_.pop_back();
+}
+
+void LocalValueNumbering::AddEntry(ScopedArenaHashMap<uint64_t, uint16_t>* map, uint64_t key,
+                                   uint16_t value) {
+  if (!scopes_.empty()) {
+    const uint16_t* old_value = map->Find(key);
+    UndoRecord record = { map, key, old_value != nullptr ? *old_value : 0u, old_value != nullptr };
+    undo_log_.push_back(record);
+  }
+  map->Overwrite(key, value);
+}
+
+void LocalValueNumbering::RemoveEntry(ScopedArenaHashMap<uint64_t, uint16_t>* map,
+                                      uint64_t key) {
+  const uint16_t* old_value = map->Find(key);
+  if (old_value == nullptr) {
+    return;
+  }
+  if (!scopes_.empty()) {
+    UndoRecord record = { map, key, *old_value, true };
+    undo_log_.push_back(record);
+  }
+  map->Erase(key);
+}
+
 uint16_t LocalValueNumbering::GetFieldId(const DexFile* dex_file, uint16_t field_idx) {
   FieldReference key = { dex_file, field_idx };
   auto it = field_index_map_.find(key);
@@ -40,15 +100,14 @@ void LocalValueNumbering::AdvanceGlobalMemory() {
 
 uint16_t LocalValueNumbering::GetMemoryVersion(uint16_t base, uint16_t field, uint16_t type) {
   // See AdvanceMemoryVersion() for explanation.
-  MemoryVersionKey key = { base, field, type };
-  MemoryVersionMap::iterator it = memory_version_map_.find(key);
-  uint16_t memory_version = (it != memory_version_map_.end()) ? it->second : 0u;
-  if (base != NO_VALUE && non_aliasing_refs_.find(base) == non_aliasing_refs_.end()) {
+  const uint16_t* version = memory_version_map_.Find(BuildMemoryVersionKey(base, field, type));
+  uint16_t memory_version = (version != nullptr) ? *version : 0u;
+  if (base != NO_VALUE && !IsNonAliasing(base)) {
     // Check modifications by potentially aliased access.
-    MemoryVersionKey aliased_access_key = { NO_VALUE, field, type };
-    auto aa_it = memory_version_map_.find(aliased_access_key);
-    if (aa_it != memory_version_map_.end() && aa_it->second > memory_version) {
-      memory_version = aa_it->second;
+    const uint16_t* aa_version =
+        memory_version_map_.Find(BuildMemoryVersionKey(NO_VALUE, field, type));
+    if (aa_version != nullptr && *aa_version > memory_version) {
+      memory_version = *aa_version;
     }
     memory_version = std::max(memory_version, global_memory_version_);
   } else if (base != NO_VALUE) {
@@ -78,12 +137,10 @@ uint16_t LocalValueNumbering::AdvanceMemoryVersion(uint16_t base, uint16_t field
 
   uint16_t result = next_memory_version_;
   ++next_memory_version_;
-  MemoryVersionKey key = { base, field, type };
-  memory_version_map_.Overwrite(key, result);
-  if (base != NO_VALUE && non_aliasing_refs_.find(base) == non_aliasing_refs_.end()) {
+  AddEntry(&memory_version_map_, BuildMemoryVersionKey(base, field, type), result);
+  if (base != NO_VALUE && !IsNonAliasing(base)) {
     // Advance memory version for aliased access.
-    MemoryVersionKey aliased_access_key = { NO_VALUE, field, type };
-    memory_version_map_.Overwrite(aliased_access_key, result);
+    AddEntry(&memory_version_map_, BuildMemoryVersionKey(NO_VALUE, field, type), result);
   }
   return result;
 };
@@ -91,27 +148,27 @@ uint16_t LocalValueNumbering::AdvanceMemoryVersion(uint16_t base, uint16_t field
 uint16_t LocalValueNumbering::MarkNonAliasingNonNull(MIR* mir) {
   uint16_t res = GetOperandValue(mir->ssa_rep->defs[0]);
   SetOperandValue(mir->ssa_rep->defs[0], res);
-  DCHECK(null_checked_.find(res) == null_checked_.end());
-  null_checked_.insert(res);
-  non_aliasing_refs_.insert(res);
+  DCHECK(null_checked_.Find(res) == nullptr);
+  AddEntry(&null_checked_, res, 0u);
+  AddEntry(&non_aliasing_refs_, res, alias_epoch_);
   return res;
 }
 
 void LocalValueNumbering::MakeArgsAliasing(MIR* mir) {
   for (size_t i = 0u, count = mir->ssa_rep->num_uses; i != count; ++i) {
     uint16_t reg = GetOperandValue(mir->ssa_rep->uses[i]);
-    non_aliasing_refs_.erase(reg);
+    RemoveEntry(&non_aliasing_refs_, reg);
   }
 }
 
 void LocalValueNumbering::HandleNullCheck(MIR* mir, uint16_t reg) {
-  if (null_checked_.find(reg) != null_checked_.end()) {
+  if (null_checked_.Find(reg) != nullptr) {
     if (cu_->verbose) {
       LOG(INFO) << "Removing null check for 0x" << std::hex << mir->offset;
     }
     mir->optimization_flags |= MIR_IGNORE_NULL_CHECK;
   } else {
-    null_checked_.insert(reg);
+    AddEntry(&null_checked_, reg, 0u);
   }
 }
 
@@ -129,7 +186,7 @@ void LocalValueNumbering::HandleRangeCheck(MIR* mir, uint16_t array, uint16_t in
 void LocalValueNumbering::HandlePutObject(MIR* mir) {
   // If we're storing a non-aliasing reference, stop tracking it as non-aliasing now.
   uint16_t base = GetOperandValue(mir->ssa_rep->uses[0]);
-  non_aliasing_refs_.erase(base);
+  RemoveEntry(&non_aliasing_refs_, base);
 }
 
 uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
@@ -202,6 +259,13 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
       }
       break;
 
+    case kMirOpVirtualTargetCheck: {
+        // Nothing defined but handle the null check.
+        uint16_t reg = GetOperandValue(mir->ssa_rep->uses[0]);
+        HandleNullCheck(mir, reg);
+      }
+      break;
+
     case Instruction::MOVE_RESULT:
     case Instruction::MOVE_RESULT_OBJECT:
     case Instruction::INSTANCE_OF:
@@ -226,8 +290,8 @@ uint16_t LocalValueNumbering::GetValueNumber(MIR* mir) {
 
     case kMirOpPhi:
       /*
-       * Because we'll only see phi nodes at the beginning of an extended basic block,
-       * we can ignore them.  Revisit if we shift to global value numbering.
+       * Phi nodes are only at the beginning of blocks with several predecessors. Their result
+       * gets a new value name on first use, like the results of other merges.
        */
       break;
 
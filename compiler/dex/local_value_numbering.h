@@ -22,6 +22,7 @@
 #include "compiler_internals.h"
 #include "utils/scoped_arena_allocator.h"
 #include "utils/scoped_arena_containers.h"
+#include "utils/scoped_arena_hash_map.h"
 
 #define NO_VALUE 0xffff
 #define ARRAY_REF 0xfffe
@@ -58,35 +59,33 @@ class LocalValueNumbering {
     }
   };
 
-  struct MemoryVersionKey {
-    uint16_t base;
-    uint16_t field_id;
-    uint16_t type;
-  };
-
-  struct MemoryVersionKeyComparator {
-    bool operator()(const MemoryVersionKey& lhs, const MemoryVersionKey& rhs) const {
-      if (lhs.base != rhs.base) {
-        return lhs.base < rhs.base;
-      }
-      if (lhs.field_id != rhs.field_id) {
-        return lhs.field_id < rhs.field_id;
-      }
-      return lhs.type < rhs.type;
-    }
-  };
-
   // Key is s_reg, value is value name.
-  typedef ScopedArenaSafeMap<uint16_t, uint16_t> SregValueMap;
+  typedef ScopedArenaHashMap<uint64_t, uint16_t> SregValueMap;
   // Key is concatenation of opcode, operand1, operand2 and modifier, value is value name.
-  typedef ScopedArenaSafeMap<uint64_t, uint16_t> ValueMap;
-  // Key represents a memory address, value is generation.
-  typedef ScopedArenaSafeMap<MemoryVersionKey, uint16_t, MemoryVersionKeyComparator
-      > MemoryVersionMap;
+  typedef ScopedArenaHashMap<uint64_t, uint16_t> ValueMap;
+  // Key is concatenation of base, field id and type of a memory location, value is generation.
+  typedef ScopedArenaHashMap<uint64_t, uint16_t> MemoryVersionMap;
   // Maps field key to field id for resolved fields.
   typedef ScopedArenaSafeMap<FieldReference, uint32_t, FieldReferenceComparator> FieldIndexMap;
-  // A set of value names.
-  typedef ScopedArenaSet<uint16_t> ValueNameSet;
+  // Key is value name; for non-aliasing references, value is the alias epoch they were added in.
+  typedef ScopedArenaHashMap<uint64_t, uint16_t> ValueNameSet;
+
+  // A change of one of the maps above, recorded to undo it when leaving a scope.
+  struct UndoRecord {
+    ScopedArenaHashMap<uint64_t, uint16_t>* map;
+    uint64_t key;
+    uint16_t old_value;
+    bool existed;
+  };
+
+  // The state to restore when leaving a scope, besides the undone map changes.
+  struct Scope {
+    size_t undo_log_size;
+    uint16_t global_memory_version;
+    uint16_t alias_epoch;
+    uint16_t unresolved_sfield_version[kFieldTypeCount];
+    uint16_t unresolved_ifield_version[kFieldTypeCount];
+  };
 
  public:
   static LocalValueNumbering* Create(CompilationUnit* cu) {
@@ -100,71 +99,85 @@ class LocalValueNumbering {
             static_cast<uint64_t>(operand2) << 16 | static_cast<uint64_t>(modifier));
   };
 
+  static uint64_t BuildMemoryVersionKey(uint16_t base, uint16_t field, uint16_t type) {
+    return (static_cast<uint64_t>(base) << 32 | static_cast<uint64_t>(field) << 16 |
+            static_cast<uint64_t>(type));
+  };
+
   uint16_t LookupValue(uint16_t op, uint16_t operand1, uint16_t operand2, uint16_t modifier) {
-    uint16_t res;
     uint64_t key = BuildKey(op, operand1, operand2, modifier);
-    ValueMap::iterator it = value_map_.find(key);
-    if (it != value_map_.end()) {
-      res = it->second;
-    } else {
-      res = value_map_.size() + 1;
-      value_map_.Put(key, res);
+    const uint16_t* value = value_map_.Find(key);
+    if (value != nullptr) {
+      return *value;
     }
+    uint16_t res = next_value_name_;
+    DCHECK_NE(res, NO_VALUE);
+    ++next_value_name_;
+    AddEntry(&value_map_, key, res);
     return res;
   };
 
   bool ValueExists(uint16_t op, uint16_t operand1, uint16_t operand2, uint16_t modifier) const {
     uint64_t key = BuildKey(op, operand1, operand2, modifier);
-    ValueMap::const_iterator it = value_map_.find(key);
-    return (it != value_map_.end());
+    return value_map_.Find(key) != nullptr;
   };
 
   void SetOperandValue(uint16_t s_reg, uint16_t value) {
-    SregValueMap::iterator it = sreg_value_map_.find(s_reg);
-    if (it != sreg_value_map_.end()) {
-      DCHECK_EQ(it->second, value);
+    const uint16_t* old_value = sreg_value_map_.Find(s_reg);
+    if (old_value != nullptr) {
+      DCHECK_EQ(*old_value, value);
     } else {
-      sreg_value_map_.Put(s_reg, value);
+      AddEntry(&sreg_value_map_, s_reg, value);
     }
   };
 
   uint16_t GetOperandValue(int s_reg) {
-    uint16_t res = NO_VALUE;
-    SregValueMap::iterator it = sreg_value_map_.find(s_reg);
-    if (it != sreg_value_map_.end()) {
-      res = it->second;
-    } else {
-      // First use
-      res = LookupValue(NO_VALUE, s_reg, NO_VALUE, NO_VALUE);
-      sreg_value_map_.Put(s_reg, res);
+    const uint16_t* value = sreg_value_map_.Find(s_reg);
+    if (value != nullptr) {
+      return *value;
     }
+    // First use
+    uint16_t res = LookupValue(NO_VALUE, s_reg, NO_VALUE, NO_VALUE);
+    AddEntry(&sreg_value_map_, s_reg, res);
     return res;
   };
 
   void SetOperandValueWide(uint16_t s_reg, uint16_t value) {
-    SregValueMap::iterator it = sreg_wide_value_map_.find(s_reg);
-    if (it != sreg_wide_value_map_.end()) {
-      DCHECK_EQ(it->second, value);
+    const uint16_t* old_value = sreg_wide_value_map_.Find(s_reg);
+    if (old_value != nullptr) {
+      DCHECK_EQ(*old_value, value);
     } else {
-      sreg_wide_value_map_.Put(s_reg, value);
+      AddEntry(&sreg_wide_value_map_, s_reg, value);
     }
   };
 
   uint16_t GetOperandValueWide(int s_reg) {
-    uint16_t res = NO_VALUE;
-    SregValueMap::iterator it = sreg_wide_value_map_.find(s_reg);
-    if (it != sreg_wide_value_map_.end()) {
-      res = it->second;
-    } else {
-      // First use
-      res = LookupValue(NO_VALUE, s_reg, NO_VALUE, NO_VALUE);
-      sreg_wide_value_map_.Put(s_reg, res);
+    const uint16_t* value = sreg_wide_value_map_.Find(s_reg);
+    if (value != nullptr) {
+      return *value;
     }
+    // First use
+    uint16_t res = LookupValue(NO_VALUE, s_reg, NO_VALUE, NO_VALUE);
+    AddEntry(&sreg_wide_value_map_, s_reg, res);
     return res;
   };
 
   uint16_t GetValueNumber(MIR* mir);
 
+  // Global value numbering: the blocks of a dominator tree can be numbered by one
+  // LocalValueNumbering in pre-order, entering a scope before each block and leaving it after
+  // the subtree of the block. A block then starts from the state at the end of its immediate
+  // dominator. If that is not its only predecessor, memory may have been written on the other
+  // paths, so the values loaded from memory are forgotten; value names of SSA registers and
+  // the checks done in dominators stay valid.
+  void EnterScope(bool only_predecessor_is_dominator);
+  void LeaveScope();
+
+  // An upper bound of the value names that numbering a MIR can create.
+  static size_t MaxNewValueNames(MIR* mir) {
+    return (mir->ssa_rep != nullptr) ? mir->ssa_rep->num_uses + mir->ssa_rep->num_defs + 4u : 4u;
+  }
+
   // Allow delete-expression to destroy a LocalValueNumbering object without deallocation.
   static void operator delete(void* ptr) { UNUSED(ptr); }
 
@@ -172,19 +185,33 @@ class LocalValueNumbering {
   LocalValueNumbering(CompilationUnit* cu, ScopedArenaAllocator* allocator)
       : cu_(cu),
         allocator_(allocator),
-        sreg_value_map_(std::less<uint16_t>(), allocator->Adapter()),
-        sreg_wide_value_map_(std::less<uint16_t>(), allocator->Adapter()),
-        value_map_(std::less<uint64_t>(), allocator->Adapter()),
+        sreg_value_map_(allocator),
+        sreg_wide_value_map_(allocator),
+        value_map_(allocator, 64u),
+        next_value_name_(1u),
         next_memory_version_(1u),
         global_memory_version_(0u),
-        memory_version_map_(MemoryVersionKeyComparator(), allocator->Adapter()),
+        memory_version_map_(allocator),
         field_index_map_(FieldReferenceComparator(), allocator->Adapter()),
-        non_aliasing_refs_(std::less<uint16_t>(), allocator->Adapter()),
-        null_checked_(std::less<uint16_t>(), allocator->Adapter()) {
+        alias_epoch_(0u),
+        next_alias_epoch_(1u),
+        non_aliasing_refs_(allocator),
+        null_checked_(allocator),
+        undo_log_(allocator->Adapter()),
+        scopes_(allocator->Adapter()) {
     std::fill_n(unresolved_sfield_version_, kFieldTypeCount, 0u);
     std::fill_n(unresolved_ifield_version_, kFieldTypeCount, 0u);
   }
 
+  // Change a map, recording the change if it must be undone when leaving the current scope.
+  void AddEntry(ScopedArenaHashMap<uint64_t, uint16_t>* map, uint64_t key, uint16_t value);
+  void RemoveEntry(ScopedArenaHashMap<uint64_t, uint16_t>* map, uint64_t key);
+
+  bool IsNonAliasing(uint16_t reg) const {
+    const uint16_t* epoch = non_aliasing_refs_.Find(reg);
+    return epoch != nullptr && *epoch == alias_epoch_;
+  }
+
   uint16_t GetFieldId(const DexFile* dex_file, uint16_t field_idx);
   void AdvanceGlobalMemory();
   uint16_t GetMemoryVersion(uint16_t base, uint16_t field, uint16_t type);
@@ -200,15 +227,22 @@ class LocalValueNumbering {
   SregValueMap sreg_value_map_;
   SregValueMap sreg_wide_value_map_;
   ValueMap value_map_;
+  uint16_t next_value_name_;
   uint16_t next_memory_version_;
   uint16_t global_memory_version_;
   uint16_t unresolved_sfield_version_[kFieldTypeCount];
   uint16_t unresolved_ifield_version_[kFieldTypeCount];
   MemoryVersionMap memory_version_map_;
   FieldIndexMap field_index_map_;
+  // Entering a block with other predecessors than its dominator starts a new alias epoch,
+  // making the references added to non_aliasing_refs_ before aliasing.
+  uint16_t alias_epoch_;
+  uint16_t next_alias_epoch_;
   // Value names of references to objects that cannot be reached through a different value name.
   ValueNameSet non_aliasing_refs_;
   ValueNameSet null_checked_;
+  ScopedArenaVector<UndoRecord> undo_log_;
+  ScopedArenaVector<Scope> scopes_;
 
   DISALLOW_COPY_AND_ASSIGN(LocalValueNumbering);
 };
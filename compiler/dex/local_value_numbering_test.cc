@@ -160,8 +160,12 @@ class LocalValueNumberingTest : public testing::Test {
   }
 
   void PerformLVN() {
+    PerformLVN(0u, mir_count_);
+  }
+
+  void PerformLVN(size_t start, size_t end) {
     value_names_.resize(mir_count_);
-    for (size_t i = 0; i != mir_count_; ++i) {
+    for (size_t i = start; i != end; ++i) {
       value_names_[i] =  lvn_->GetValueNumber(&mirs_[i]);
     }
   }
@@ -323,4 +327,68 @@ TEST_F(LocalValueNumberingTest, TestVolatile) {
   EXPECT_EQ(mirs_[3].optimization_flags, 0u);
 }
 
+TEST_F(LocalValueNumberingTest, TestScopes) {
+  static const IFieldDef ifields[] = {
+      { 1u, 1u, 1u, false },
+  };
+  static const MIRDef mirs[] = {
+      DEF_IGET(Instruction::IGET, 0u, 10u, 0u),  // Dominator.
+      DEF_IGET(Instruction::IGET, 1u, 10u, 0u),  // Block with the dominator as only predecessor.
+      DEF_IGET(Instruction::IGET, 2u, 11u, 0u),
+      DEF_IGET(Instruction::IGET, 3u, 10u, 0u),  // Block with other predecessors.
+      DEF_IGET(Instruction::IGET, 4u, 11u, 0u),
+  };
+
+  PrepareIFields(ifields);
+  PrepareMIRs(mirs);
+  lvn_->EnterScope(false);
+  PerformLVN(0u, 1u);
+  lvn_->EnterScope(true);
+  PerformLVN(1u, 3u);
+  lvn_->LeaveScope();
+  lvn_->EnterScope(false);
+  PerformLVN(3u, 5u);
+  lvn_->LeaveScope();
+  lvn_->LeaveScope();
+  ASSERT_EQ(value_names_.size(), 5u);
+  EXPECT_EQ(value_names_[0], value_names_[1]);
+  EXPECT_NE(value_names_[0], value_names_[3]);  // Memory may have been written on other paths.
+  EXPECT_EQ(mirs_[0].optimization_flags, 0u);
+  EXPECT_EQ(mirs_[1].optimization_flags, MIR_IGNORE_NULL_CHECK);
+  EXPECT_EQ(mirs_[2].optimization_flags, 0u);
+  EXPECT_EQ(mirs_[3].optimization_flags, MIR_IGNORE_NULL_CHECK);
+  EXPECT_EQ(mirs_[4].optimization_flags, 0u);  // The null check of 11u was in a sibling.
+}
+
+TEST_F(LocalValueNumberingTest, TestScopesUnique) {
+  static const IFieldDef ifields[] = {
+      { 1u, 1u, 1u, false },
+  };
+  static const MIRDef mirs[] = {
+      DEF_UNIQUE_REF(Instruction::NEW_INSTANCE, 10u),
+      DEF_IGET(Instruction::IGET, 0u, 10u, 0u),
+      DEF_IPUT(Instruction::IPUT, 1u, 11u, 0u),  // No aliasing since 10u is unique.
+      DEF_IGET(Instruction::IGET, 2u, 10u, 0u),  // Block with other predecessors.
+      DEF_IPUT(Instruction::IPUT, 3u, 11u, 0u),  // May alias, 10u may have escaped.
+      DEF_IGET(Instruction::IGET, 4u, 10u, 0u),
+  };
+
+  PrepareIFields(ifields);
+  PrepareMIRs(mirs);
+  lvn_->EnterScope(false);
+  PerformLVN(0u, 2u);
+  lvn_->EnterScope(true);
+  PerformLVN(2u, 3u);
+  lvn_->LeaveScope();
+  lvn_->EnterScope(false);
+  PerformLVN(3u, 6u);
+  lvn_->LeaveScope();
+  lvn_->LeaveScope();
+  ASSERT_EQ(value_names_.size(), 6u);
+  EXPECT_NE(value_names_[1], value_names_[3]);
+  EXPECT_NE(value_names_[3], value_names_[5]);
+  EXPECT_EQ(mirs_[3].optimization_flags, MIR_IGNORE_NULL_CHECK);
+  EXPECT_EQ(mirs_[5].optimization_flags, MIR_IGNORE_NULL_CHECK);
+}
+
 }  // namespace art
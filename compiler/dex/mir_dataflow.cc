@@ -840,6 +840,9 @@ const uint64_t MIRGraph::oat_data_flow_attributes_[kMirOpLast] = {
 
   // 113 MIR_SELECT
   DF_DA | DF_UB,
+
+  // 114 MIR_VIRTUAL_TARGET_CHECK
+  DF_UA | DF_NULL_CHK_0 | DF_REF_A,
 };
 
 /* Return the base virtual register for a SSA name */
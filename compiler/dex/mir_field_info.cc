@@ -113,7 +113,7 @@ void MirSFieldLoweringInfo::Resolve(CompilerDriver* compiler_driver,
     bool is_referrers_class, is_initialized;
     std::pair<bool, bool> fast_path = compiler_driver->IsFastStaticField(
         dex_cache.Get(), referrer_class.Get(), resolved_field, field_idx, &it->field_offset_,
-        &it->storage_index_, &is_referrers_class, &is_initialized);
+        &it->storage_index_, &is_referrers_class, &is_initialized, &it->direct_storage_ptr_);
     it->flags_ = kFlagIsStatic |
         (is_volatile ? kFlagIsVolatile : 0u) |
         (fast_path.first ? kFlagFastGet : 0u) |
@@ -147,7 +147,8 @@ class MirSFieldLoweringInfo : public MirFieldInfo {
   // IGET/IPUT. For fast path fields (at least for IGET), retrieve the information needed for
   // the field access, i.e. the field offset, whether the field is in the same class as the
   // method being compiled, whether the declaring class can be safely assumed to be initialized
-  // and the type index of the declaring class in the compiled method's dex file.
+  // and the type index of the declaring class in the compiled method's dex file, or else the
+  // address of the declaring class if it's an initialized class of the boot image.
   static void Resolve(CompilerDriver* compiler_driver, const DexCompilationUnit* mUnit,
                       MirSFieldLoweringInfo* field_infos, size_t count)
       LOCKS_EXCLUDED(Locks::mutator_lock_);
@@ -156,7 +157,8 @@ class MirSFieldLoweringInfo : public MirFieldInfo {
   explicit MirSFieldLoweringInfo(uint16_t field_idx)
       : MirFieldInfo(field_idx, kFlagIsVolatile | kFlagIsStatic),
         field_offset_(0u),
-        storage_index_(DexFile::kDexNoIndex) {
+        storage_index_(DexFile::kDexNoIndex),
+        direct_storage_ptr_(0u) {
   }
 
   bool FastGet() const {
@@ -183,6 +185,10 @@ class MirSFieldLoweringInfo : public MirFieldInfo {
     return storage_index_;
   }
 
+  uintptr_t DirectStoragePtr() const {
+    return direct_storage_ptr_;
+  }
+
  private:
   enum {
     kBitFastGet = kFieldInfoBitEnd,
@@ -202,6 +208,9 @@ class MirSFieldLoweringInfo : public MirFieldInfo {
   // The type index of the declaring class in the compiling method's dex file,
   // -1 if the field is unresolved or there's no appropriate TypeId in that dex file.
   uint32_t storage_index_;
+  // The address of the declaring class if it's an initialized class of the boot image that
+  // can't be assumed to be in the dex cache, 0u otherwise.
+  uintptr_t direct_storage_ptr_;
 
   friend class ClassInitCheckEliminationTest;
   friend class LocalValueNumberingTest;
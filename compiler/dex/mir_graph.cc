@@ -45,6 +45,7 @@ const char* MIRGraph::extended_mir_op_names_[kMirOpLast - kMirOpFirst] = {
   "Check1",
   "Check2",
   "Select",
+  "VirtualTargetCheck",
   "ConstVector",
   "MoveVector",
   "PackedMultiply",
@@ -83,6 +84,7 @@ MIRGraph::MIRGraph(CompilationUnit* cu, ArenaAllocator* arena)
       temp_insn_data_(nullptr),
       temp_bit_vector_size_(0u),
       temp_bit_vector_(nullptr),
+      max_inlined_code_units_(0u),
       block_list_(arena, 100, kGrowableArrayBlockList),
       try_block_addr_(NULL),
       entry_block_(NULL),
@@ -123,14 +125,7 @@ MIRGraph::~MIRGraph() {
  */
 int MIRGraph::ParseInsn(const uint16_t* code_ptr, MIR::DecodedInstruction* decoded_instruction) {
   const Instruction* inst = Instruction::At(code_ptr);
-  decoded_instruction->opcode = inst->Opcode();
-  decoded_instruction->vA = inst->HasVRegA() ? inst->VRegA() : 0;
-  decoded_instruction->vB = inst->HasVRegB() ? inst->VRegB() : 0;
-  decoded_instruction->vB_wide = inst->HasWideVRegB() ? inst->WideVRegB() : 0;
-  decoded_instruction->vC = inst->HasVRegC() ?  inst->VRegC() : 0;
-  if (inst->HasVarArgs()) {
-    inst->GetVarArgs(decoded_instruction->arg);
-  }
+  inst->Decode(decoded_instruction);
   return inst->SizeInCodeUnits();
 }
 
@@ -812,7 +807,7 @@ void MIRGraph::DumpCFG(const char* dir_prefix, bool all_blocks, const char *suff
                 bb->first_mir_insn ? " | " : " ");
         for (mir = bb->first_mir_insn; mir; mir = mir->next) {
             int opcode = mir->dalvikInsn.opcode;
-            if (opcode > kMirOpSelect && opcode < kMirOpLast) {
+            if (opcode >= kMirOpConstVector && opcode < kMirOpLast) {
               if (opcode == kMirOpConstVector) {
                 fprintf(file, "    {%04x %s %d %d %d %d %d %d\\l}%s\\\n", mir->offset,
                         extended_mir_op_names_[kMirOpConstVector - kMirOpFirst],
@@ -31,6 +31,8 @@
 
 namespace art {
 
+class LocalValueNumbering;
+
 enum InstructionAnalysisAttributePos {
   kUninterestingOp = 0,
   kArithmeticOp,
@@ -254,14 +256,8 @@ struct MIR {
    * additional fields on as-needed basis.  Question: how to support MIR Pseudo-ops; probably
    * need to carry aux data pointer.
    */
-  struct DecodedInstruction {
-    uint32_t vA;
-    uint32_t vB;
-    uint64_t vB_wide;        /* for k51l */
-    uint32_t vC;
-    uint32_t arg[5];         /* vC/D/E/F/G in invoke or filled-new-array */
-    Instruction::Code opcode;
-  } dalvikInsn;
+  typedef ::art::Instruction::Decoded DecodedInstruction;
+  DecodedInstruction dalvikInsn;
 
   uint16_t width;                 // Note: width can include switch table or fill array data.
   NarrowDexOffset offset;         // Offset of the instruction in code units.
@@ -565,6 +561,12 @@ class MIRGraph {
 
   void ComputeInlineIFieldLoweringInfo(uint16_t field_idx, MIR* invoke, MIR* iget_or_iput);
 
+  // The size, in code units, of the largest straight-line method InlineCalls() copies into
+  // this method. Set by InlineCallsStart().
+  uint32_t GetMaxInlinedCodeUnits() const {
+    return max_inlined_code_units_;
+  }
+
   void InitRegLocations();
 
   void RemapRegLocations();
@@ -573,6 +575,8 @@ class MIRGraph {
 
   void BasicBlockOptimization();
 
+  void OptimizeLoops();
+
   bool IsConst(int32_t s_reg) const {
     return is_constant_v_->IsBitSet(s_reg);
   }
@@ -948,7 +952,16 @@ class MIRGraph {
   void SetConstant(int32_t ssa_reg, int value);
   void SetConstantWide(int ssa_reg, int64_t value);
   int GetSSAUseCount(int s_reg);
-  bool BasicBlockOpt(BasicBlock* bb);
+  bool BasicBlockOpt(BasicBlock* bb, LocalValueNumbering* global_valnum);
+  MIR* FindSSADef(int s_reg);
+  bool IsShortCountedLoopBackedge(BasicBlock* bb);
+  bool FindSimpleLoop(BasicBlock* latch, std::vector<BasicBlockId>* loop, size_t* num_mirs);
+  bool HasHoistableChecks(const std::vector<BasicBlockId>& loop);
+  void CloneLoop(const std::vector<BasicBlockId>& loop, std::vector<BasicBlockId>* copies);
+  void RedirectEdge(BasicBlock* from, BasicBlock* old_target, BasicBlock* new_target);
+  void PeelLoop(const std::vector<BasicBlockId>& loop, BasicBlock* latch);
+  void UnrollLoop(const std::vector<BasicBlockId>& loop, BasicBlock* latch);
+  void DominatorTreeBasicBlockOpt();
   bool BuildExtendedBBList(struct BasicBlock* bb);
   bool FillDefBlockMatrix(BasicBlock* bb);
   void InitializeDominationInfo(BasicBlock* bb);
@@ -959,6 +972,12 @@ class MIRGraph {
   bool ComputeDominanceFrontier(BasicBlock* bb);
 
   void CountChecks(BasicBlock* bb);
+  bool InlineGuardedVirtualCall(BasicBlock* bb, MIR* invoke, const MethodReference& target);
+  bool InlineCacheCall(BasicBlock* bb, MIR* invoke);
+  MIR* FindGuardableCallEnd(BasicBlock* bb, MIR* invoke);
+  BasicBlock* NewCallCopyBlock(MIR* invoke, MIR* last);
+  BasicBlock* InsertCallGuard(BasicBlock* bb, MIR* invoke, MIR* last, BasicBlock* fast_bb,
+                              uint32_t receiver_class);
   void AnalyzeBlock(BasicBlock* bb, struct MethodStats* stats);
   bool ComputeSkipCompilation(struct MethodStats* stats, bool skip_default);
 
@@ -984,6 +1003,7 @@ class MIRGraph {
   uint16_t* temp_insn_data_;
   uint32_t temp_bit_vector_size_;
   ArenaBitVector* temp_bit_vector_;
+  uint32_t max_inlined_code_units_;
   static const int kInvalidEntry = -1;
   GrowableArray<BasicBlock*> block_list_;
   ArenaBitVector* try_block_addr_;
@@ -19,8 +19,13 @@
 #include "driver/compiler_driver.h"
 #include "driver/dex_compilation_unit.h"
 #include "driver/compiler_driver-inl.h"
+#include "gc/heap.h"
+#include "gc/space/space.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
 #include "mirror/class_loader.h"  // Only to allow casts in Handle<ClassLoader>.
 #include "mirror/dex_cache.h"     // Only to allow casts in Handle<DexCache>.
+#include "runtime.h"
 #include "scoped_thread_state_change.h"
 #include "handle_scope-inl.h"
 
@@ -78,16 +83,58 @@ void MirMethodLoweringInfo::Resolve(CompilerDriver* compiler_driver,
         &target_method, devirt_target, &it->direct_code_, &it->direct_method_);
     bool needs_clinit =
         compiler_driver->NeedsClassInitialization(referrer_class.Get(), resolved_method);
+    bool is_effectively_final = fast_path_flags != 0 && invoke_type == kVirtual &&
+        !compiler_driver->IsMethodOverridden(resolved_method);
     uint16_t other_flags = it->flags_ &
-        ~(kFlagFastPath | kFlagNeedsClassInitialization | (kInvokeTypeMask << kBitSharpTypeBegin));
+        ~(kFlagFastPath | kFlagNeedsClassInitialization | kFlagIsEffectivelyFinal |
+          (kInvokeTypeMask << kBitSharpTypeBegin));
     it->flags_ = other_flags |
         (fast_path_flags != 0 ? kFlagFastPath : 0u) |
         (static_cast<uint16_t>(invoke_type) << kBitSharpTypeBegin) |
-        (needs_clinit ? kFlagNeedsClassInitialization : 0u);
+        (needs_clinit ? kFlagNeedsClassInitialization : 0u) |
+        (is_effectively_final ? kFlagIsEffectivelyFinal : 0u);
     it->target_dex_file_ = target_method.dex_file;
     it->target_method_idx_ = target_method.dex_method_index;
     it->stats_flags_ = fast_path_flags;
   }
 }
 
+bool MirMethodLoweringInfo::ResolveInlineCacheTarget(CompilerDriver* compiler_driver,
+                                                     const DexCompilationUnit* mUnit,
+                                                     const MirMethodLoweringInfo& method_info,
+                                                     const char* descriptor,
+                                                     uint32_t* receiver_class,
+                                                     MethodReference* target) {
+  DCHECK(method_info.IsResolved());
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<2> hs(soa.Self());
+  Handle<mirror::DexCache> dex_cache(hs.NewHandle(compiler_driver->GetDexCache(mUnit)));
+  Handle<mirror::ClassLoader> class_loader(
+      hs.NewHandle(compiler_driver->GetClassLoader(soa, mUnit)));
+  mirror::ArtMethod* resolved_method =
+      compiler_driver->ResolveMethod(soa, dex_cache, class_loader, mUnit, method_info.MethodIndex(),
+                                     method_info.GetInvokeType());
+  if (UNLIKELY(resolved_method == nullptr)) {
+    return false;
+  }
+  // Only the boot class loader's classes are looked up, the others may not be loaded yet.
+  mirror::Class* klass = mUnit->GetClassLinker()->LookupClass(descriptor, nullptr);
+  if (klass == nullptr || !klass->IsInstantiable() ||
+      !resolved_method->GetDeclaringClass()->IsAssignableFrom(klass)) {
+    return false;
+  }
+  gc::space::Space* space = Runtime::Current()->GetHeap()->FindSpaceFromObject(klass, true);
+  if (space == nullptr || !space->IsImageSpace()) {
+    return false;
+  }
+  mirror::ArtMethod* called_method = klass->FindVirtualMethodForVirtualOrInterface(resolved_method);
+  if (called_method == nullptr || called_method->IsAbstract()) {
+    return false;
+  }
+  *receiver_class = PointerToLowMemUInt32(klass);
+  *target = MethodReference(called_method->GetDeclaringClass()->GetDexCache()->GetDexFile(),
+                            called_method->GetDexMethodIndex());
+  return true;
+}
+
 }  // namespace art
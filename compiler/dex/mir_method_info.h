@@ -98,6 +98,17 @@ class MirMethodLoweringInfo : public MirMethodInfo {
                       MirMethodLoweringInfo* method_infos, size_t count)
       LOCKS_EXCLUDED(Locks::mutator_lock_);
 
+  // For an inline cache of the resolved method's call, find the receiver class with the given
+  // descriptor and the method the call dispatches to for it. Returns false unless the class can
+  // be a receiver of the call and is in the boot image, so that the compiled code can refer to
+  // it directly.
+  static bool ResolveInlineCacheTarget(CompilerDriver* compiler_driver,
+                                       const DexCompilationUnit* mUnit,
+                                       const MirMethodLoweringInfo& method_info,
+                                       const char* descriptor, uint32_t* receiver_class,
+                                       MethodReference* target)
+      LOCKS_EXCLUDED(Locks::mutator_lock_);
+
   MirMethodLoweringInfo(uint16_t method_idx, InvokeType type)
       : MirMethodInfo(method_idx,
                       ((type == kStatic) ? kFlagIsStatic : 0u) |
@@ -127,6 +138,12 @@ class MirMethodLoweringInfo : public MirMethodInfo {
     return (flags_ & kFlagNeedsClassInitialization) != 0u;
   }
 
+  // Whether the virtual call has a single target among the classes loaded by the compiler.
+  // Classes loaded at run time may still override it, so calls to it must be guarded.
+  bool IsEffectivelyFinal() const {
+    return (flags_ & kFlagIsEffectivelyFinal) != 0u;
+  }
+
   InvokeType GetInvokeType() const {
     return static_cast<InvokeType>((flags_ >> kBitInvokeTypeBegin) & kInvokeTypeMask);
   }
@@ -139,6 +156,17 @@ class MirMethodLoweringInfo : public MirMethodInfo {
     return MethodReference(target_dex_file_, target_method_idx_);
   }
 
+  // The method whose code the invoke runs, in the dex file defining it, where the verifier
+  // analysed it for inlining. The target method may instead refer to a method of another dex
+  // file through an index of the compiling method's dex file. Devirtualized invokes keep their
+  // target method, as the resolved method is not the one called.
+  MethodReference GetInlineTargetMethod() const {
+    if (IsResolved() && GetSharpType() == GetInvokeType()) {
+      return MethodReference(declaring_dex_file_, declaring_method_idx_);
+    }
+    return GetTargetMethod();
+  }
+
   uint16_t VTableIndex() const {
     return vtable_idx_;
   }
@@ -163,11 +191,13 @@ class MirMethodLoweringInfo : public MirMethodInfo {
     kBitSharpTypeBegin,
     kBitSharpTypeEnd = kBitSharpTypeBegin + 3,  // 3 bits for sharp type.
     kBitNeedsClassInitialization = kBitSharpTypeEnd,
+    kBitIsEffectivelyFinal,
     kMethodLoweringInfoEnd
   };
   COMPILE_ASSERT(kMethodLoweringInfoEnd <= 16, too_many_flags);
   static constexpr uint16_t kFlagFastPath = 1u << kBitFastPath;
   static constexpr uint16_t kFlagNeedsClassInitialization = 1u << kBitNeedsClassInitialization;
+  static constexpr uint16_t kFlagIsEffectivelyFinal = 1u << kBitIsEffectivelyFinal;
   static constexpr uint16_t kInvokeTypeMask = 7u;
   COMPILE_ASSERT((1u << (kBitInvokeTypeEnd - kBitInvokeTypeBegin)) - 1u == kInvokeTypeMask,
                  assert_invoke_type_bits_ok);
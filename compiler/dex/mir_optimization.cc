@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <limits>
+
 #include "compiler_internals.h"
 #include "local_value_numbering.h"
 #include "dataflow_iterator-inl.h"
@@ -23,6 +26,23 @@
 
 namespace art {
 
+// The size, in code units, of the largest straight-line method inlined into methods that
+// the profile does not show to be hot.
+static constexpr uint32_t kMaxInlinedCodeUnits = 8u;
+
+// The number of receiver classes cached for a call. Calls the profile saw more classes for
+// are megamorphic, and keep the virtual dispatch only.
+static constexpr size_t kMaxInlineCacheTypes = 2u;
+
+// Counted loops which provably run at most this many iterations don't need a suspend check on
+// their back edge, the suspend checks before and after the loop come soon enough.
+static constexpr int64_t kMaxSuspendCheckFreeLoopIterations = 64;
+
+// The largest loops OptimizeLoops() copies: in blocks, and in MIRs for peeling and unrolling.
+static constexpr size_t kMaxLoopOptBlocks = 8u;
+static constexpr size_t kMaxPeeledLoopMirs = 32u;
+static constexpr size_t kMaxUnrolledLoopMirs = 12u;
+
 static unsigned int Predecessors(BasicBlock* bb) {
   return bb->predecessors->Size();
 }
@@ -225,6 +245,61 @@ COMPILE_ASSERT(ConditionCodeForIfCcZ(Instruction::IF_GEZ) == kCondGe, check_if_g
 COMPILE_ASSERT(ConditionCodeForIfCcZ(Instruction::IF_GTZ) == kCondGt, check_if_gtz_ccode);
 COMPILE_ASSERT(ConditionCodeForIfCcZ(Instruction::IF_LEZ) == kCondLe, check_if_lez_ccode);
 
+static ConditionCode ConditionCodeForIfCc(Instruction::Code opcode) {
+  switch (opcode) {
+    case Instruction::IF_EQ: return kCondEq;
+    case Instruction::IF_NE: return kCondNe;
+    case Instruction::IF_LT: return kCondLt;
+    case Instruction::IF_GE: return kCondGe;
+    case Instruction::IF_GT: return kCondGt;
+    case Instruction::IF_LE: return kCondLe;
+    default:
+      LOG(FATAL) << "Unexpected opcode " << opcode;
+      return kCondEq;
+  }
+}
+
+// The condition with the operands swapped.
+static ConditionCode SwapOperands(ConditionCode cc) {
+  switch (cc) {
+    case kCondLt: return kCondGt;
+    case kCondGe: return kCondLe;
+    case kCondGt: return kCondLt;
+    case kCondLe: return kCondGe;
+    default: return cc;
+  }
+}
+
+static ConditionCode Negate(ConditionCode cc) {
+  switch (cc) {
+    case kCondEq: return kCondNe;
+    case kCondNe: return kCondEq;
+    case kCondLt: return kCondGe;
+    case kCondGe: return kCondLt;
+    case kCondGt: return kCondLe;
+    case kCondLe: return kCondGt;
+    default:
+      LOG(FATAL) << "Unexpected condition " << cc;
+      return cc;
+  }
+}
+
+static bool EndsWithIf(BasicBlock* bb) {
+  return bb->last_mir_insn != nullptr &&
+      bb->last_mir_insn->dalvikInsn.opcode >= Instruction::IF_EQ &&
+      bb->last_mir_insn->dalvikInsn.opcode <= Instruction::IF_LEZ;
+}
+
+static MIR* FindPhiDef(BasicBlock* bb, int ssa_name) {
+  for (MIR* mir = bb->first_mir_insn; mir != NULL; mir = mir->next) {
+    if (static_cast<int>(mir->dalvikInsn.opcode) == kMirOpPhi &&
+        mir->ssa_rep->defs[0] == ssa_name) {
+      return mir;
+    }
+  }
+  return NULL;
+}
+
 int MIRGraph::GetSSAUseCount(int s_reg) {
   return raw_use_counts_.Get(s_reg);
 }
@@ -305,21 +380,25 @@ CompilerTemp* MIRGraph::GetNewCompilerTemp(CompilerTempType ct_type, bool wide)
   return compiler_temp;
 }
 
-/* Do some MIR-level extended basic block optimizations */
-bool MIRGraph::BasicBlockOpt(BasicBlock* bb) {
+/*
+ * Do some MIR-level extended basic block optimizations. Values are numbered by global_valnum
+ * if not null, or by a new LocalValueNumbering if the block needs it.
+ */
+bool MIRGraph::BasicBlockOpt(BasicBlock* bb, LocalValueNumbering* global_valnum) {
   if (bb->block_type == kDead) {
     return true;
   }
-  bool use_lvn = bb->use_lvn;
+  LocalValueNumbering* valnum = global_valnum;
   std::unique_ptr<LocalValueNumbering> local_valnum;
-  if (use_lvn) {
+  if (valnum == nullptr && bb->use_lvn) {
     local_valnum.reset(LocalValueNumbering::Create(cu_));
+    valnum = local_valnum.get();
   }
   while (bb != NULL) {
     for (MIR* mir = bb->first_mir_insn; mir != NULL; mir = mir->next) {
       // TUNING: use the returned value number for CSE.
-      if (use_lvn) {
-        local_valnum->GetValueNumber(mir);
+      if (valnum != nullptr) {
+        valnum->GetValueNumber(mir);
       }
       // Look for interesting opcodes, skip otherwise
       Instruction::Code opcode = mir->dalvikInsn.opcode;
@@ -397,6 +476,12 @@ bool MIRGraph::BasicBlockOpt(BasicBlock* bb) {
               LOG(INFO) << "Suppressed suspend check on branch to return at 0x" << std::hex
                         << mir->offset;
             }
+          } else if (IsShortCountedLoopBackedge(bb)) {
+            mir->optimization_flags |= MIR_IGNORE_SUSPEND_CHECK;
+            if (cu_->verbose) {
+              LOG(INFO) << "Suppressed suspend check on short counted loop at 0x" << std::hex
+                        << mir->offset;
+            }
           }
           break;
         default:
@@ -978,7 +1063,8 @@ bool MIRGraph::EliminateClassInitChecksGate() {
             mir->dalvikInsn.opcode <= Instruction::SPUT_SHORT) {
           const MirSFieldLoweringInfo& field_info = GetSFieldLoweringInfo(mir);
           uint16_t index = 0xffffu;
-          if (field_info.IsResolved() && !field_info.IsInitialized()) {
+          if (field_info.IsResolved() && !field_info.IsInitialized() &&
+              field_info.DirectStoragePtr() == 0u) {
             DCHECK_LT(class_to_index_map.size(), 0xffffu);
             MapEntry entry = {
                 field_info.DeclaringDexFile(),
@@ -1115,14 +1201,16 @@ void MIRGraph::EliminateClassInitChecksEnd() {
 
 void MIRGraph::ComputeInlineIFieldLoweringInfo(uint16_t field_idx, MIR* invoke, MIR* iget_or_iput) {
   uint32_t method_index = invoke->meta.method_lowering_info;
-  if (temp_bit_vector_->IsBitSet(method_index)) {
+  // The lowering infos of inline cache targets, added by the pass, are not cached.
+  bool cacheable = method_index < temp_bit_vector_size_;
+  if (cacheable && temp_bit_vector_->IsBitSet(method_index)) {
     iget_or_iput->meta.ifield_lowering_info = temp_insn_data_[method_index];
     DCHECK_EQ(field_idx, GetIFieldLoweringInfo(iget_or_iput).FieldIndex());
     return;
   }
 
   const MirMethodLoweringInfo& method_info = GetMethodLoweringInfo(invoke);
-  MethodReference target = method_info.GetTargetMethod();
+  MethodReference target = method_info.GetInlineTargetMethod();
   DexCompilationUnit inlined_unit(
       cu_, cu_->class_loader, cu_->class_linker, *target.dex_file,
       nullptr /* code_item not used */, 0u /* class_def_idx not used */, target.dex_method_index,
@@ -1133,8 +1221,10 @@ void MIRGraph::ComputeInlineIFieldLoweringInfo(uint16_t field_idx, MIR* invoke,
 
   uint32_t field_info_index = ifield_lowering_infos_.Size();
   ifield_lowering_infos_.Insert(inlined_field_info);
-  temp_bit_vector_->SetBit(method_index);
-  temp_insn_data_[method_index] = field_info_index;
+  if (cacheable) {
+    temp_bit_vector_->SetBit(method_index);
+    temp_insn_data_[method_index] = field_info_index;
+  }
   iget_or_iput->meta.ifield_lowering_info = field_info_index;
 }
 
@@ -1162,6 +1252,14 @@ void MIRGraph::InlineCallsStart() {
   temp_bit_vector_->ClearAllBits();
   temp_insn_data_ = static_cast<uint16_t*>(temp_scoped_alloc_->Alloc(
       temp_bit_vector_size_ * sizeof(*temp_insn_data_), kArenaAllocGrowableArray));
+
+  // Copying straight-line methods pays off for short ones only, unless the profile shows
+  // this method is hot.
+  max_inlined_code_units_ = kMaxInlinedCodeUnits;
+  if (cu_->compiler_driver->ProfilePresent() &&
+      cu_->compiler_driver->IsHotMethod(PrettyMethod(cu_->method_idx, *cu_->dex_file))) {
+    max_inlined_code_units_ = InlineMethodAnalyser::kMaxStraightLineCodeUnits;
+  }
 }
 
 void MIRGraph::InlineCalls(BasicBlock* bb) {
@@ -1169,7 +1267,8 @@ void MIRGraph::InlineCalls(BasicBlock* bb) {
     return;
   }
   for (MIR* mir = bb->first_mir_insn; mir != NULL; mir = mir->next) {
-    if (!(Instruction::FlagsOf(mir->dalvikInsn.opcode) & Instruction::kInvoke)) {
+    if (!(Instruction::FlagsOf(mir->dalvikInsn.opcode) & Instruction::kInvoke) ||
+        (mir->optimization_flags & (MIR_INLINED | MIR_INLINED_PRED)) != 0) {
       continue;
     }
     const MirMethodLoweringInfo& method_info = GetMethodLoweringInfo(mir);
@@ -1177,14 +1276,42 @@ void MIRGraph::InlineCalls(BasicBlock* bb) {
       continue;
     }
     InvokeType sharp_type = method_info.GetSharpType();
+    if (sharp_type == kVirtual && method_info.IsEffectivelyFinal() &&
+        !Is64BitInstructionSet(cu_->instruction_set)) {
+      // The blocks following the guard are visited later by the pass.
+      if (InlineGuardedVirtualCall(bb, mir, method_info.GetInlineTargetMethod())) {
+        return;
+      }
+      continue;
+    }
+    if ((sharp_type == kVirtual || sharp_type == kInterface) &&
+        cu_->compiler_driver->ProfilePresent() && !Is64BitInstructionSet(cu_->instruction_set)) {
+      // As above, the blocks following the guards are visited later.
+      if (InlineCacheCall(bb, mir)) {
+        return;
+      }
+      continue;
+    }
     if ((sharp_type != kDirect) &&
         (sharp_type != kStatic || method_info.NeedsClassInitialization())) {
       continue;
     }
     DCHECK(cu_->compiler_driver->GetMethodInlinerMap() != nullptr);
-    MethodReference target = method_info.GetTargetMethod();
-    if (cu_->compiler_driver->GetMethodInlinerMap()->GetMethodInliner(target.dex_file)
-            ->GenInline(this, bb, mir, target.dex_method_index)) {
+    // Look the method up where it is defined, so that calls into the other dex files of a
+    // multi-dex application are inlined too.
+    MethodReference target = method_info.GetInlineTargetMethod();
+    // A call the profile's call graph shows is hot may copy as much code as a hot method.
+    uint32_t max_inlined_code_units = max_inlined_code_units_;
+    if (max_inlined_code_units_ < InlineMethodAnalyser::kMaxStraightLineCodeUnits &&
+        cu_->compiler_driver->ProfilePresent() &&
+        cu_->compiler_driver->IsHotCallSite(PrettyMethod(cu_->method_idx, *cu_->dex_file),
+                                            mir->offset)) {
+      max_inlined_code_units_ = InlineMethodAnalyser::kMaxStraightLineCodeUnits;
+    }
+    bool inlined = cu_->compiler_driver->GetMethodInlinerMap()->GetMethodInliner(target.dex_file)
+        ->GenInline(this, bb, mir, target.dex_method_index);
+    max_inlined_code_units_ = max_inlined_code_units;
+    if (inlined) {
       if (cu_->verbose) {
         LOG(INFO) << "In \"" << PrettyMethod(cu_->method_idx, *cu_->dex_file)
             << "\" @0x" << std::hex << mir->offset
@@ -1195,6 +1322,209 @@ void MIRGraph::InlineCalls(BasicBlock* bb) {
   }
 }
 
+/*
+ * Inline a virtual call that no loaded class overrides behind a guard checking that the
+ * receiver's class dispatches the call to the resolved method. Returns false, leaving the
+ * graph unchanged, if the target is not inlined.
+ */
+bool MIRGraph::InlineGuardedVirtualCall(BasicBlock* bb, MIR* invoke,
+                                        const MethodReference& target) {
+  MIR* last = FindGuardableCallEnd(bb, invoke);
+  if (last == nullptr) {
+    return false;
+  }
+  BasicBlock* fast_bb = NewCallCopyBlock(invoke, last);
+  DCHECK(cu_->compiler_driver->GetMethodInlinerMap() != nullptr);
+  if (!cu_->compiler_driver->GetMethodInlinerMap()->GetMethodInliner(target.dex_file)
+          ->GenInline(this, fast_bb, fast_bb->first_mir_insn, target.dex_method_index)) {
+    fast_bb->block_type = kDead;
+    fast_bb->first_mir_insn = nullptr;
+    fast_bb->last_mir_insn = nullptr;
+    return false;
+  }
+  InsertCallGuard(bb, invoke, last, fast_bb, 0u);
+  return true;
+}
+
+/*
+ * Guard a virtual or interface call with an inline cache of the receiver classes the profile
+ * recorded for it. For each cached class, a guard compares the receiver's class with it and
+ * the fast path calls the method the class dispatches to directly, or inlines it. The caches
+ * of a polymorphic call are chained, the slow path of one holding the guard of the next.
+ * Only classes of the boot image are cached, as the guard and the direct call refer to them
+ * and their methods by address. Returns false if no class is cached.
+ */
+bool MIRGraph::InlineCacheCall(BasicBlock* bb, MIR* invoke) {
+  std::vector<std::string> receiver_types = cu_->compiler_driver->GetProfiledReceiverTypes(
+      PrettyMethod(cu_->method_idx, *cu_->dex_file), invoke->offset);
+  if (receiver_types.empty() || receiver_types.size() > kMaxInlineCacheTypes) {
+    return false;  // Not profiled, or megamorphic.
+  }
+  // Copy the lowering info, inserting new ones may move it.
+  const MirMethodLoweringInfo method_info = GetMethodLoweringInfo(invoke);
+  const DexCompilationUnit* m_unit = m_units_[invoke->m_unit_index];
+  bool cached = false;
+  for (const std::string& receiver_type : receiver_types) {
+    MIR* last = FindGuardableCallEnd(bb, invoke);
+    if (last == nullptr) {
+      break;
+    }
+    std::string descriptor = DotToDescriptor(receiver_type.c_str());
+    uint32_t receiver_class;
+    MethodReference target(nullptr, 0u);
+    if (!MirMethodLoweringInfo::ResolveInlineCacheTarget(cu_->compiler_driver, m_unit, method_info,
+                                                         descriptor.c_str(), &receiver_class,
+                                                         &target)) {
+      continue;
+    }
+    // The fast path is the invoke devirtualized to the target.
+    MirMethodLoweringInfo target_info(method_info.MethodIndex(), method_info.GetInvokeType());
+    target_info.SetDevirtualizationTarget(target);
+    MirMethodLoweringInfo::Resolve(cu_->compiler_driver, m_unit, &target_info, 1u);
+    if (!target_info.FastPath() || target_info.GetSharpType() != kDirect ||
+        target_info.DirectMethod() == 0u ||
+        target_info.DirectMethod() == static_cast<uintptr_t>(-1)) {
+      continue;
+    }
+    uint32_t target_info_index = method_lowering_infos_.Size();
+    method_lowering_infos_.Insert(target_info);
+    BasicBlock* fast_bb = NewCallCopyBlock(invoke, last);
+    fast_bb->first_mir_insn->meta.method_lowering_info = target_info_index;
+    if (cu_->verbose) {
+      LOG(INFO) << "In \"" << PrettyMethod(cu_->method_idx, *cu_->dex_file)
+          << "\" @0x" << std::hex << invoke->offset
+          << " cached " << method_info.GetInvokeType() << " call to \""
+          << PrettyMethod(target.dex_method_index, *target.dex_file) << "\" for " << receiver_type;
+    }
+    // The fast path is visited later by the pass, which may inline the target.
+    bb = InsertCallGuard(bb, invoke, last, fast_bb, receiver_class);
+    cached = true;
+  }
+  return cached;
+}
+
+/*
+ * Returns the last MIR of the call of invoke, its move-result if any, or nullptr if the call
+ * cannot be moved to a block of its own.
+ */
+MIR* MIRGraph::FindGuardableCallEnd(BasicBlock* bb, MIR* invoke) {
+  if (bb->successor_block_list_type != kNotUsed) {
+    return nullptr;  // In a try block, or ending with a switch.
+  }
+  MIR* move_result = FindMoveResult(bb, invoke);
+  if (move_result != nullptr && move_result != invoke->next) {
+    return nullptr;
+  }
+  return (move_result != nullptr) ? move_result : invoke;
+}
+
+/*
+ * Returns a new block holding copies of the MIRs from invoke to last, to be the fast path of
+ * a guarded call.
+ */
+BasicBlock* MIRGraph::NewCallCopyBlock(MIR* invoke, MIR* last) {
+  BasicBlock* fast_bb = NewMemBB(kDalvikByteCode, num_blocks_++);
+  block_list_.Insert(fast_bb);
+  fast_bb->start_offset = invoke->offset;
+  for (MIR* mir = invoke; ; mir = mir->next) {
+    MIR* copy = static_cast<MIR*>(arena_->Alloc(sizeof(MIR), kArenaAllocMIR));
+    *copy = *mir;
+    fast_bb->AppendMIR(copy);
+    if (mir == last) {
+      break;
+    }
+  }
+  // The invoke may be the slow path of a previous guard, but its copy is not.
+  fast_bb->first_mir_insn->optimization_flags &= ~MIR_INLINED_PRED;
+  return fast_bb;
+}
+
+/*
+ * Move the call from invoke to last to a block of its own, the slow path, split the block
+ * after it and end the block with a guard choosing between the slow path and fast_bb:
+ *
+ *   bb: ... VirtualTargetCheck  --taken-->  slow path: invoke, move-result  --\
+ *            |                                                                +--> join: ...
+ *            +--fall through-->  fast path  -----------------------------------/
+ *
+ * The guard compares the receiver's class with receiver_class if it is not 0, and checks that
+ * the class dispatches the call to the resolved method otherwise. Like the work half of a
+ * potentially throwing instruction, the new blocks are not entered into the
+ * dex_pc_to_block_map_. Returns the slow path.
+ */
+BasicBlock* MIRGraph::InsertCallGuard(BasicBlock* bb, MIR* invoke, MIR* last, BasicBlock* fast_bb,
+                                      uint32_t receiver_class) {
+  // The slow path keeps the call; its receiver is null checked by the guard.
+  MIR* prev = nullptr;
+  for (MIR* mir = bb->first_mir_insn; mir != invoke; mir = mir->next) {
+    prev = mir;
+  }
+  MIR* rest = last->next;
+  BasicBlock* slow_bb = NewMemBB(kDalvikByteCode, num_blocks_++);
+  block_list_.Insert(slow_bb);
+  slow_bb->start_offset = invoke->offset;
+  slow_bb->first_mir_insn = invoke;
+  slow_bb->last_mir_insn = last;
+  last->next = nullptr;
+  invoke->optimization_flags |= MIR_INLINED_PRED;
+
+  // The join block takes the rest of the block and its successors.
+  BasicBlock* join_bb;
+  if (rest == nullptr) {
+    DCHECK_EQ(bb->taken, NullBasicBlockId);
+    join_bb = GetBasicBlock(bb->fall_through);
+    join_bb->predecessors->Delete(bb->id);
+  } else {
+    join_bb = NewMemBB(kDalvikByteCode, num_blocks_++);
+    block_list_.Insert(join_bb);
+    join_bb->start_offset = rest->offset;
+    join_bb->first_mir_insn = rest;
+    join_bb->last_mir_insn = bb->last_mir_insn;
+    join_bb->terminated_by_return = bb->terminated_by_return;
+    join_bb->explicit_throw = bb->explicit_throw;
+    join_bb->conditional_branch = bb->conditional_branch;
+    join_bb->taken = bb->taken;
+    join_bb->fall_through = bb->fall_through;
+    if (join_bb->taken != NullBasicBlockId) {
+      BasicBlock* bb_taken = GetBasicBlock(join_bb->taken);
+      bb_taken->predecessors->Delete(bb->id);
+      bb_taken->predecessors->Insert(join_bb->id);
+    }
+    if (join_bb->fall_through != NullBasicBlockId) {
+      BasicBlock* bb_fall_through = GetBasicBlock(join_bb->fall_through);
+      bb_fall_through->predecessors->Delete(bb->id);
+      bb_fall_through->predecessors->Insert(join_bb->id);
+    }
+  }
+  slow_bb->fall_through = join_bb->id;
+  fast_bb->fall_through = join_bb->id;
+  join_bb->predecessors->Insert(slow_bb->id);
+  join_bb->predecessors->Insert(fast_bb->id);
+
+  // End the block with the guard.
+  MIR* check = static_cast<MIR*>(arena_->Alloc(sizeof(MIR), kArenaAllocMIR));
+  check->dalvikInsn.opcode = static_cast<Instruction::Code>(kMirOpVirtualTargetCheck);
+  check->dalvikInsn.vA = invoke->dalvikInsn.vC;  // The receiver, for both invoke formats.
+  check->dalvikInsn.vB = receiver_class;
+  check->offset = invoke->offset;
+  check->m_unit_index = invoke->m_unit_index;
+  check->meta.method_lowering_info = invoke->meta.method_lowering_info;
+  if (prev == nullptr) {
+    bb->first_mir_insn = check;
+  } else {
+    prev->next = check;
+  }
+  bb->last_mir_insn = check;
+  bb->terminated_by_return = false;
+  bb->explicit_throw = false;
+  bb->conditional_branch = false;
+  bb->taken = slow_bb->id;
+  bb->fall_through = fast_bb->id;
+  slow_bb->predecessors->Insert(bb->id);
+  fast_bb->predecessors->Insert(bb->id);
+  return slow_bb;
+}
+
 void MIRGraph::InlineCallsEnd() {
   DCHECK(temp_insn_data_ != nullptr);
   temp_insn_data_ = nullptr;
@@ -1260,6 +1590,416 @@ bool MIRGraph::BuildExtendedBBList(struct BasicBlock* bb) {
   return false;  // Not iterative - return value will be ignored
 }
 
+MIR* MIRGraph::FindSSADef(int s_reg) {
+  AllNodesIterator iter(this);
+  for (BasicBlock* bb = iter.Next(); bb != nullptr; bb = iter.Next()) {
+    for (MIR* mir = bb->first_mir_insn; mir != nullptr; mir = mir->next) {
+      if (mir->ssa_rep != nullptr && mir->ssa_rep->num_defs != 0 &&
+          mir->ssa_rep->defs[0] == s_reg) {
+        return mir;
+      }
+    }
+  }
+  return nullptr;
+}
+
+/*
+ * Recognize the back edge of a loop counting a variable from a constant towards a constant bound
+ * by a constant step, in at most kMaxSuspendCheckFreeLoopIterations iterations. The loop header
+ * must only be entered from before the loop and from bb, and the loop test must either end bb or
+ * the header, so that it runs on every iteration.
+ */
+bool MIRGraph::IsShortCountedLoopBackedge(BasicBlock* bb) {
+  BasicBlockId header_id = IsBackedge(bb, bb->taken) ? bb->taken :
+      (IsBackedge(bb, bb->fall_through) ? bb->fall_through : NullBasicBlockId);
+  if (header_id == NullBasicBlockId || bb->dominators == nullptr) {
+    return false;
+  }
+  BasicBlock* header = GetBasicBlock(header_id);
+  if (Predecessors(header) != 2u) {
+    return false;
+  }
+  BasicBlock* test_bb = bb;
+  BasicBlockId loop_side = header_id;
+  if (!EndsWithIf(bb)) {
+    // A goto back to a test at the top of the loop, which stays in the loop through the successor
+    // dominating the back edge.
+    test_bb = header;
+    if (!EndsWithIf(header)) {
+      return false;
+    }
+    bool taken_in_loop = bb->dominators->IsBitSet(header->taken);
+    if (taken_in_loop == bb->dominators->IsBitSet(header->fall_through)) {
+      return false;
+    }
+    loop_side = taken_in_loop ? header->taken : header->fall_through;
+  }
+  MIR* test = test_bb->last_mir_insn;
+  if (test->ssa_rep == nullptr) {
+    return false;
+  }
+  // Normalize the test to "var cc bound", cc being the condition to stay in the loop.
+  Instruction::Code opcode = test->dalvikInsn.opcode;
+  int var;
+  int32_t bound;
+  ConditionCode cc;
+  if (opcode >= Instruction::IF_EQ && opcode <= Instruction::IF_LE) {
+    cc = ConditionCodeForIfCc(opcode);
+    if (IsConst(test->ssa_rep->uses[1])) {
+      var = test->ssa_rep->uses[0];
+      bound = ConstantValue(test->ssa_rep->uses[1]);
+    } else if (IsConst(test->ssa_rep->uses[0])) {
+      var = test->ssa_rep->uses[1];
+      bound = ConstantValue(test->ssa_rep->uses[0]);
+      cc = SwapOperands(cc);
+    } else {
+      return false;
+    }
+  } else if (opcode >= Instruction::IF_EQZ && opcode <= Instruction::IF_LEZ) {
+    cc = ConditionCodeForIfCcZ(opcode);
+    var = test->ssa_rep->uses[0];
+    bound = 0;
+  } else {
+    return false;
+  }
+  if (test_bb->taken != loop_side) {
+    cc = Negate(cc);
+  }
+  // The variable is either the phi of the header or its increment.
+  MIR* phi = FindPhiDef(header, var);
+  MIR* increment = nullptr;
+  if (phi == nullptr) {
+    increment = FindSSADef(var);
+    if (increment == nullptr || increment->ssa_rep->num_uses == 0) {
+      return false;
+    }
+    phi = FindPhiDef(header, increment->ssa_rep->uses[0]);
+  }
+  if (phi == nullptr || phi->ssa_rep->num_uses != 2) {
+    return false;
+  }
+  int next_index = (phi->meta.phi_incoming[0] == bb->id) ? 0 : 1;
+  if (phi->meta.phi_incoming[next_index] != bb->id ||
+      !IsConst(phi->ssa_rep->uses[1 - next_index])) {
+    return false;
+  }
+  int32_t init = ConstantValue(phi->ssa_rep->uses[1 - next_index]);
+  if (increment == nullptr) {
+    increment = FindSSADef(phi->ssa_rep->uses[next_index]);
+  } else if (increment->ssa_rep->defs[0] != phi->ssa_rep->uses[next_index]) {
+    return false;
+  }
+  if (increment == nullptr || increment->ssa_rep->num_uses == 0 ||
+      increment->ssa_rep->uses[0] != phi->ssa_rep->defs[0]) {
+    return false;
+  }
+  int64_t step;
+  switch (increment->dalvikInsn.opcode) {
+    case Instruction::ADD_INT_LIT8:
+    case Instruction::ADD_INT_LIT16:
+      step = static_cast<int32_t>(increment->dalvikInsn.vC);
+      break;
+    case Instruction::ADD_INT:
+    case Instruction::ADD_INT_2ADDR:
+      if (!IsConst(increment->ssa_rep->uses[1])) {
+        return false;
+      }
+      step = ConstantValue(increment->ssa_rep->uses[1]);
+      break;
+    default:
+      return false;
+  }
+  // The variable must move towards the bound, without wrapping around before passing it.
+  int64_t distance;
+  if ((cc == kCondLt || cc == kCondLe) && step > 0) {
+    distance = static_cast<int64_t>(bound) - init;
+  } else if ((cc == kCondGt || cc == kCondGe) && step < 0) {
+    distance = static_cast<int64_t>(init) - bound;
+    step = -step;
+  } else {
+    return false;
+  }
+  int64_t last = static_cast<int64_t>(bound) + ((cc == kCondLt || cc == kCondLe) ? step : -step);
+  if (last > std::numeric_limits<int32_t>::max() || last < std::numeric_limits<int32_t>::min()) {
+    return false;
+  }
+  // Two more iterations cover the inclusive conditions and tests of the incremented variable.
+  return distance / step + 2 <= kMaxSuspendCheckFreeLoopIterations;
+}
+
+static bool IsInLoop(const std::vector<BasicBlockId>& loop, BasicBlockId id) {
+  return std::find(loop.begin(), loop.end(), id) != loop.end();
+}
+
+// Returns the copy of id if it is a block of the loop, id otherwise.
+static BasicBlockId CopyOf(const std::vector<BasicBlockId>& loop,
+                           const std::vector<BasicBlockId>& copies, BasicBlockId id) {
+  auto it = std::find(loop.begin(), loop.end(), id);
+  return (it != loop.end()) ? copies[it - loop.begin()] : id;
+}
+
+/*
+ * Recognize the innermost loop closed by the taken branch of latch, a goto or if. The loop is
+ * the header, the target of the branch, followed by the blocks between it and latch in the dex
+ * code; its only entry must be a single edge from outside into the header and none of its
+ * blocks may be in a try block, end with a switch or hold an extended MIR. Sets num_mirs to
+ * the number of MIRs of the loop.
+ */
+bool MIRGraph::FindSimpleLoop(BasicBlock* latch, std::vector<BasicBlockId>* loop,
+                              size_t* num_mirs) {
+  if (latch->block_type != kDalvikByteCode || latch->hidden || latch->last_mir_insn == nullptr ||
+      !IsBackedge(latch, latch->taken)) {
+    return false;
+  }
+  Instruction::Code opcode = latch->last_mir_insn->dalvikInsn.opcode;
+  if (!EndsWithIf(latch) && opcode != Instruction::GOTO && opcode != Instruction::GOTO_16 &&
+      opcode != Instruction::GOTO_32) {
+    return false;
+  }
+  BasicBlock* header = GetBasicBlock(latch->taken);
+  if (header->block_type != kDalvikByteCode || Predecessors(header) != 2u) {
+    return false;
+  }
+  loop->clear();
+  loop->push_back(header->id);
+  GrowableArray<BasicBlock*>::Iterator iter(&block_list_);
+  for (BasicBlock* bb = iter.Next(); bb != nullptr; bb = iter.Next()) {
+    if (bb != header && bb->block_type == kDalvikByteCode && !bb->hidden &&
+        bb->start_offset >= header->start_offset && bb->start_offset <= latch->start_offset) {
+      if (loop->size() == kMaxLoopOptBlocks) {
+        return false;
+      }
+      loop->push_back(bb->id);
+    }
+  }
+  *num_mirs = 0u;
+  for (BasicBlockId id : *loop) {
+    BasicBlock* bb = GetBasicBlock(id);
+    if (bb->successor_block_list_type != kNotUsed || bb->catch_entry ||
+        (bb->taken != NullBasicBlockId && bb->taken == bb->fall_through)) {
+      return false;
+    }
+    for (MIR* mir = bb->first_mir_insn; mir != nullptr; mir = mir->next) {
+      if (static_cast<int>(mir->dalvikInsn.opcode) >= kMirOpFirst) {
+        return false;
+      }
+      ++*num_mirs;
+    }
+    // Only the latch may branch back, and only to the header.
+    if ((bb != latch && IsInLoop(*loop, bb->taken) && IsBackedge(bb, bb->taken)) ||
+        (IsInLoop(*loop, bb->fall_through) && IsBackedge(bb, bb->fall_through))) {
+      return false;
+    }
+    GrowableArray<BasicBlockId>::Iterator pred_iter(bb->predecessors);
+    for (BasicBlockId pred_id = pred_iter.Next(); pred_id != NullBasicBlockId;
+         pred_id = pred_iter.Next()) {
+      if (bb == header) {
+        if (pred_id != latch->id &&
+            (IsInLoop(*loop, pred_id) ||
+             GetBasicBlock(pred_id)->successor_block_list_type != kNotUsed)) {
+          return false;
+        }
+      } else if (!IsInLoop(*loop, pred_id)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/*
+ * Returns whether a first iteration of the loop would let the null check and class
+ * initialization check eliminations remove checks from the others: the loop null checks a
+ * register it doesn't define, or accesses a static field of a class that may not be
+ * initialized.
+ */
+bool MIRGraph::HasHoistableChecks(const std::vector<BasicBlockId>& loop) {
+  bool check_nulls = (cu_->disable_opt & (1 << kNullCheckElimination)) == 0;
+  bool check_clinits = (cu_->disable_opt & (1 << kClassInitCheckElimination)) == 0;
+  ArenaBitVector defined(arena_, cu_->num_dalvik_registers, true, kBitMapMisc);
+  for (BasicBlockId id : loop) {
+    for (MIR* mir = GetBasicBlock(id)->first_mir_insn; mir != nullptr; mir = mir->next) {
+      uint64_t df_attributes = GetDataFlowAttributes(mir);
+      if ((df_attributes & DF_DA) != 0) {
+        defined.SetBit(mir->dalvikInsn.vA);
+        if ((df_attributes & DF_A_WIDE) != 0) {
+          defined.SetBit(mir->dalvikInsn.vA + 1);
+        }
+      }
+    }
+  }
+  // "this" is never null.
+  int this_reg = ((cu_->access_flags & kAccStatic) == 0)
+      ? cu_->num_dalvik_registers - cu_->num_ins : -1;
+  for (BasicBlockId id : loop) {
+    for (MIR* mir = GetBasicBlock(id)->first_mir_insn; mir != nullptr; mir = mir->next) {
+      uint64_t df_attributes = GetDataFlowAttributes(mir);
+      if (check_clinits && (df_attributes & DF_SFIELD) != 0) {
+        const MirSFieldLoweringInfo& field_info = GetSFieldLoweringInfo(mir);
+        if (!field_info.IsReferrersClass() && !field_info.IsInitialized() &&
+            field_info.DirectStoragePtr() == 0u) {
+          return true;
+        }
+      }
+      if (!check_nulls || (df_attributes & DF_HAS_NULL_CHKS) == 0) {
+        continue;
+      }
+      const MIR::DecodedInstruction& insn = mir->dalvikInsn;
+      int vreg;
+      switch (Instruction::FormatOf(insn.opcode)) {
+        case Instruction::k11x:
+          vreg = insn.vA;
+          break;
+        case Instruction::k12x:
+        case Instruction::k22c:
+        case Instruction::k23x:
+          vreg = insn.vB;
+          break;
+        case Instruction::k35c:
+          vreg = insn.arg[0];
+          break;
+        case Instruction::k3rc:
+          vreg = insn.vC;
+          break;
+        default:
+          continue;
+      }
+      if (vreg != this_reg && !defined.IsBitSet(vreg)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/*
+ * Copy the blocks of the loop, its header first, and set copies to the new blocks in the same
+ * order. The edges between the blocks of the loop are copied to edges between their copies,
+ * the edges leaving the loop to edges from the copies to the same blocks. Like the fast path
+ * of a guarded call, the copies are not entered into the dex_pc_to_block_map_.
+ */
+void MIRGraph::CloneLoop(const std::vector<BasicBlockId>& loop,
+                         std::vector<BasicBlockId>* copies) {
+  copies->clear();
+  for (BasicBlockId id : loop) {
+    BasicBlock* bb = GetBasicBlock(id);
+    BasicBlock* copy_bb = NewMemBB(kDalvikByteCode, num_blocks_++);
+    block_list_.Insert(copy_bb);
+    copy_bb->start_offset = bb->start_offset;
+    copy_bb->nesting_depth = bb->nesting_depth;
+    copy_bb->explicit_throw = bb->explicit_throw;
+    copy_bb->conditional_branch = bb->conditional_branch;
+    copy_bb->terminated_by_return = bb->terminated_by_return;
+    copy_bb->use_lvn = bb->use_lvn;
+    for (MIR* mir = bb->first_mir_insn; mir != nullptr; mir = mir->next) {
+      MIR* copy = static_cast<MIR*>(arena_->Alloc(sizeof(MIR), kArenaAllocMIR));
+      *copy = *mir;
+      copy_bb->AppendMIR(copy);
+    }
+    copies->push_back(copy_bb->id);
+  }
+  for (size_t i = 0; i != loop.size(); ++i) {
+    BasicBlock* bb = GetBasicBlock(loop[i]);
+    BasicBlock* copy_bb = GetBasicBlock((*copies)[i]);
+    if (bb->taken != NullBasicBlockId) {
+      copy_bb->taken = CopyOf(loop, *copies, bb->taken);
+      GetBasicBlock(copy_bb->taken)->predecessors->Insert(copy_bb->id);
+    }
+    if (bb->fall_through != NullBasicBlockId) {
+      copy_bb->fall_through = CopyOf(loop, *copies, bb->fall_through);
+      GetBasicBlock(copy_bb->fall_through)->predecessors->Insert(copy_bb->id);
+    }
+  }
+}
+
+void MIRGraph::RedirectEdge(BasicBlock* from, BasicBlock* old_target, BasicBlock* new_target) {
+  if (from->taken == old_target->id) {
+    from->taken = new_target->id;
+  } else {
+    DCHECK_EQ(from->fall_through, old_target->id);
+    from->fall_through = new_target->id;
+  }
+  old_target->predecessors->Delete(from->id);
+  new_target->predecessors->Insert(from->id);
+}
+
+/*
+ * Peel the first iteration of the loop: the loop is entered through a copy of its blocks,
+ * whose latch continues to the original header. The checks of the copy then cover the same
+ * checks in the loop.
+ */
+void MIRGraph::PeelLoop(const std::vector<BasicBlockId>& loop, BasicBlock* latch) {
+  BasicBlock* header = GetBasicBlock(loop[0]);
+  BasicBlockId entry_id = header->predecessors->Get(0);
+  if (entry_id == latch->id) {
+    entry_id = header->predecessors->Get(1);
+  }
+  std::vector<BasicBlockId> copies;
+  CloneLoop(loop, &copies);
+  BasicBlock* copy_header = GetBasicBlock(copies[0]);
+  BasicBlock* copy_latch = GetBasicBlock(CopyOf(loop, copies, latch->id));
+  RedirectEdge(GetBasicBlock(entry_id), header, copy_header);
+  RedirectEdge(copy_latch, copy_header, header);
+  // The copy runs once, entering the loop is not a back edge.
+  copy_latch->last_mir_insn->optimization_flags |= MIR_IGNORE_SUSPEND_CHECK;
+}
+
+/*
+ * Unroll the loop by two: its latch continues to a copy of its blocks, whose latch continues
+ * to the header. Each copy keeps the loop test, so the trip count need not be known; the loop
+ * is only suspend checked on the back edge of the copy.
+ */
+void MIRGraph::UnrollLoop(const std::vector<BasicBlockId>& loop, BasicBlock* latch) {
+  BasicBlock* header = GetBasicBlock(loop[0]);
+  std::vector<BasicBlockId> copies;
+  CloneLoop(loop, &copies);
+  BasicBlock* copy_header = GetBasicBlock(copies[0]);
+  BasicBlock* copy_latch = GetBasicBlock(CopyOf(loop, copies, latch->id));
+  RedirectEdge(latch, header, copy_header);
+  RedirectEdge(copy_latch, copy_header, header);
+  latch->last_mir_insn->optimization_flags |= MIR_IGNORE_SUSPEND_CHECK;
+}
+
+/*
+ * Peel and unroll small innermost loops before the SSA transformation, so that the copies
+ * need no renaming. Peeling lets the null check and class initialization check eliminations
+ * hoist the checks of loop invariant registers and classes out of the loop; unrolling halves
+ * the back edges taken and their suspend checks.
+ */
+void MIRGraph::OptimizeLoops() {
+  // Only the latches of the original blocks, copies of a loop are not transformed again.
+  const size_t num_blocks = block_list_.Size();
+  std::vector<BasicBlockId> loop;
+  for (size_t i = 0; i != num_blocks; ++i) {
+    BasicBlock* latch = block_list_.Get(i);
+    size_t num_mirs;
+    if (latch == nullptr || !FindSimpleLoop(latch, &loop, &num_mirs)) {
+      continue;
+    }
+    bool peel = num_mirs <= kMaxPeeledLoopMirs && HasHoistableChecks(loop);
+    bool unroll = num_mirs <= kMaxUnrolledLoopMirs;
+    for (BasicBlockId id : loop) {
+      for (MIR* mir = GetBasicBlock(id)->first_mir_insn; unroll && mir != nullptr;
+           mir = mir->next) {
+        // The loop is not worth unrolling around a call.
+        unroll = (Instruction::FlagsOf(mir->dalvikInsn.opcode) & Instruction::kInvoke) == 0;
+      }
+    }
+    if (peel) {
+      PeelLoop(loop, latch);
+    }
+    if (unroll) {
+      UnrollLoop(loop, latch);
+    }
+    if ((peel || unroll) && cu_->verbose) {
+      LOG(INFO) << "In \"" << PrettyMethod(cu_->method_idx, *cu_->dex_file)
+          << "\" loop @0x" << std::hex << GetBasicBlock(loop[0])->start_offset << std::dec
+          << " of " << num_mirs << " MIRs" << (peel ? " peeled" : "")
+          << (unroll ? " unrolled" : "");
+    }
+  }
+}
+
 void MIRGraph::BasicBlockOptimization() {
   if ((cu_->disable_opt & (1 << kSuppressExceptionEdges)) != 0) {
     ClearAllVisitedFlags();
@@ -1269,12 +2009,62 @@ void MIRGraph::BasicBlockOptimization() {
     }
     // Perform extended basic block optimizations.
     for (unsigned int i = 0; i < extended_basic_blocks_.size(); i++) {
-      BasicBlockOpt(GetBasicBlock(extended_basic_blocks_[i]));
+      BasicBlockOpt(GetBasicBlock(extended_basic_blocks_[i]), nullptr);
     }
+    return;
+  }
+  // Number values globally if any block needs it and the value names and memory versions,
+  // fewer than the value names, cannot run out.
+  bool use_lvn = false;
+  size_t max_value_names = GetNumBlocks();
+  AllNodesIterator iter(this);
+  for (BasicBlock* bb = iter.Next(); bb != NULL; bb = iter.Next()) {
+    use_lvn |= bb->use_lvn;
+    for (MIR* mir = bb->first_mir_insn; mir != NULL; mir = mir->next) {
+      max_value_names += LocalValueNumbering::MaxNewValueNames(mir);
+    }
+  }
+  if (use_lvn && GetEntryBlock()->i_dominated != nullptr && max_value_names < NO_VALUE) {
+    DominatorTreeBasicBlockOpt();
   } else {
-    PreOrderDfsIterator iter(this);
-    for (BasicBlock* bb = iter.Next(); bb != NULL; bb = iter.Next()) {
-      BasicBlockOpt(bb);
+    PreOrderDfsIterator iter2(this);
+    for (BasicBlock* bb = iter2.Next(); bb != NULL; bb = iter2.Next()) {
+      BasicBlockOpt(bb, nullptr);
+    }
+  }
+}
+
+/*
+ * Do the basic block optimizations in a pre-order walk of the dominator tree, numbering the
+ * values of each block from the state at the end of its immediate dominator.
+ */
+void MIRGraph::DominatorTreeBasicBlockOpt() {
+  // A catch handler is entered from the middle of a throwing instruction, where the checks
+  // it does have not passed yet; number the subtree of each handler separately.
+  std::vector<BasicBlock*> roots;
+  roots.push_back(GetEntryBlock());
+  std::vector<std::pair<BasicBlock*, ArenaBitVector::Iterator*>> work_stack;
+  for (size_t i = 0; i != roots.size(); ++i) {
+    std::unique_ptr<LocalValueNumbering> global_valnum(LocalValueNumbering::Create(cu_));
+    BasicBlock* root = roots[i];
+    global_valnum->EnterScope(false);
+    BasicBlockOpt(root, global_valnum.get());
+    work_stack.push_back(std::make_pair(root, root->i_dominated->GetIterator()));
+    while (!work_stack.empty()) {
+      int bb_idx = work_stack.back().second->Next();
+      if (bb_idx == -1) {
+        global_valnum->LeaveScope();
+        work_stack.pop_back();
+        continue;
+      }
+      BasicBlock* bb = GetBasicBlock(bb_idx);
+      if (bb->catch_entry) {
+        roots.push_back(bb);
+        continue;
+      }
+      global_valnum->EnterScope(Predecessors(bb) == 1u);
+      BasicBlockOpt(bb, global_valnum.get());
+      work_stack.push_back(std::make_pair(bb, bb->i_dominated->GetIterator()));
     }
   }
 }
@@ -30,6 +30,7 @@ class ClassInitCheckEliminationTest : public testing::Test {
     uintptr_t declaring_dex_file;
     uint16_t declaring_class_idx;
     uint16_t declaring_field_idx;
+    uintptr_t direct_storage_ptr;  // 0u unless the class is in the boot image.
   };
 
   struct BBDef {
@@ -86,6 +87,7 @@ class ClassInitCheckEliminationTest : public testing::Test {
         field_info.declaring_class_idx_ = def->declaring_class_idx;
         field_info.declaring_field_idx_ = def->declaring_field_idx;
         field_info.flags_ = MirSFieldLoweringInfo::kFlagIsStatic;
+        field_info.direct_storage_ptr_ = def->direct_storage_ptr;
       }
       ASSERT_EQ(def->declaring_dex_file != 0u, field_info.IsResolved());
       ASSERT_FALSE(field_info.IsInitialized());
@@ -259,6 +261,39 @@ TEST_F(ClassInitCheckEliminationTest, SingleBlock) {
   }
 }
 
+TEST_F(ClassInitCheckEliminationTest, BootImageClass) {
+  static const SFieldDef sfields[] = {
+      { 0u, 1u, 0u, 0u, 0x1000u },  // Initialized class of the boot image.
+      { 1u, 1u, 1u, 1u },
+  };
+  static const BBDef bbs[] = {
+      DEF_BB(kNullBlock, DEF_SUCC0(), DEF_PRED0()),
+      DEF_BB(kEntryBlock, DEF_SUCC1(3), DEF_PRED0()),
+      DEF_BB(kExitBlock, DEF_SUCC0(), DEF_PRED1(3)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC1(2), DEF_PRED1(1)),
+  };
+  static const MIRDef mirs[] = {
+      DEF_MIR(Instruction::SGET, 3u, 0u),
+      DEF_MIR(Instruction::SGET, 3u, 1u),
+      DEF_MIR(Instruction::SGET, 3u, 0u),
+      DEF_MIR(Instruction::SGET, 3u, 1u),
+  };
+  // The boot image class is not tracked, its accesses have no check to eliminate.
+  static const bool expected_ignore_clinit_check[] = {
+      false, false, false, true
+  };
+
+  PrepareSFields(sfields);
+  PrepareBasicBlocks(bbs);
+  PrepareMIRs(mirs);
+  PerformClassInitCheckElimination();
+  ASSERT_EQ(arraysize(expected_ignore_clinit_check), mir_count_);
+  for (size_t i = 0u; i != arraysize(mirs); ++i) {
+    EXPECT_EQ(expected_ignore_clinit_check[i],
+              (mirs_[i].optimization_flags & MIR_IGNORE_CLINIT_CHECK) != 0) << i;
+  }
+}
+
 TEST_F(ClassInitCheckEliminationTest, Diamond) {
   static const SFieldDef sfields[] = {
       { 0u, 1u, 0u, 0u },
@@ -366,6 +401,53 @@ TEST_F(ClassInitCheckEliminationTest, Loop) {
   }
 }
 
+TEST_F(ClassInitCheckEliminationTest, PeeledLoop) {
+  static const SFieldDef sfields[] = {
+      { 0u, 1u, 0u, 0u },
+      { 1u, 1u, 1u, 1u },
+  };
+  static const BBDef bbs[] = {
+      DEF_BB(kNullBlock, DEF_SUCC0(), DEF_PRED0()),
+      DEF_BB(kEntryBlock, DEF_SUCC1(3), DEF_PRED0()),
+      DEF_BB(kExitBlock, DEF_SUCC0(), DEF_PRED1(5)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC1(4), DEF_PRED1(1)),
+      DEF_BB(kDalvikByteCode, DEF_SUCC2(5, 4), DEF_PRED2(3, 4)),  // "taken" loops to self.
+      DEF_BB(kDalvikByteCode, DEF_SUCC1(2), DEF_PRED1(4)),
+  };
+  static const MIRDef mirs[] = {
+      DEF_MIR(Instruction::SGET, 3u, 1u),
+      DEF_MIR(Instruction::SGET, 4u, 0u),  // Eliminated, checked by the peeled iteration.
+      DEF_MIR(Instruction::IF_EQZ, 4u, 0u),
+      DEF_MIR(Instruction::SGET, 5u, 0u),  // Eliminated.
+  };
+  static const bool expected_ignore_clinit_check[] = {
+      false, true, false, true
+  };
+
+  PrepareSFields(sfields);
+  PrepareBasicBlocks(bbs);
+  PrepareMIRs(mirs);
+  for (size_t i = 3u; i != arraysize(bbs); ++i) {
+    BasicBlock* bb = cu_.mir_graph->GetBasicBlock(i);
+    bb->start_offset = bb->first_mir_insn->offset;
+  }
+  cu_.mir_graph->OptimizeLoops();
+  // The loop is peeled and, being small, unrolled.
+  const size_t num_blocks = cu_.mir_graph->GetNumBlocks();
+  ASSERT_EQ(arraysize(bbs) + 2u, num_blocks);
+  for (size_t i = arraysize(bbs); i != num_blocks; ++i) {
+    BasicBlock* bb = cu_.mir_graph->GetBasicBlock(i);
+    bb->data_flow_info = static_cast<BasicBlockDataFlow*>(
+        cu_.arena.Alloc(sizeof(BasicBlockDataFlow), kArenaAllocDFInfo));
+  }
+  PerformClassInitCheckElimination();
+  ASSERT_EQ(arraysize(expected_ignore_clinit_check), mir_count_);
+  for (size_t i = 0u; i != arraysize(mirs); ++i) {
+    EXPECT_EQ(expected_ignore_clinit_check[i],
+              (mirs_[i].optimization_flags & MIR_IGNORE_CLINIT_CHECK) != 0) << i;
+  }
+}
+
 TEST_F(ClassInitCheckEliminationTest, Catch) {
   static const SFieldDef sfields[] = {
       { 0u, 1u, 0u, 0u },
@@ -16,6 +16,9 @@
 
 #include <dlfcn.h>
 
+#include <algorithm>
+
+#include "atomic.h"
 #include "base/logging.h"
 #include "base/macros.h"
 #include "bb_optimizations.h"
@@ -24,6 +27,7 @@
 #include "dataflow_iterator-inl.h"
 #include "pass.h"
 #include "pass_driver.h"
+#include "utils.h"
 
 namespace art {
 
@@ -94,6 +98,7 @@ static const Pass* const gPasses[] = {
   GetPassInstance<CacheMethodLoweringInfo>(),
   GetPassInstance<CallInlining>(),
   GetPassInstance<CodeLayout>(),
+  GetPassInstance<LoopOptimizations>(),
   GetPassInstance<SSATransformation>(),
   GetPassInstance<ConstantPropagation>(),
   GetPassInstance<InitRegLocations>(),
@@ -104,6 +109,35 @@ static const Pass* const gPasses[] = {
   GetPassInstance<BBOptimizations>(),
 };
 
+/**
+ * @brief The cost of a pass of gPasses, summed over the methods it was applied to.
+ */
+struct PassStatistics {
+  Atomic<int64_t> runs;
+  Atomic<int64_t> time_ns;
+  Atomic<int64_t> arena_bytes;         // Growth of the CompilationUnit's arena.
+  Atomic<int64_t> arena_stack_bytes;   // Growth of the high-water mark of its arena stack.
+  Atomic<int64_t> mirs;                // MIRs in the graph when the pass started.
+};
+
+static PassStatistics gPassStatistics[arraysize(gPasses)];
+
+static PassStatistics* GetPassStatistics(const Pass* pass) {
+  const Pass* const* it = std::find(gPasses, gPasses + arraysize(gPasses), pass);
+  return (it != gPasses + arraysize(gPasses)) ? &gPassStatistics[it - gPasses] : nullptr;
+}
+
+static size_t CountMIRs(const MIRGraph* mir_graph) {
+  size_t count = 0u;
+  for (size_t i = 0; i != mir_graph->GetBasicBlockListCount(); ++i) {
+    const BasicBlock* bb = mir_graph->GetBasicBlock(i);
+    for (const MIR* mir = bb->first_mir_insn; mir != nullptr; mir = mir->next) {
+      ++count;
+    }
+  }
+  return count;
+}
+
 // The default pass list is used by CreatePasses to initialize pass_list_.
 static std::vector<const Pass*> gDefaultPassList(gPasses, gPasses + arraysize(gPasses));
 
@@ -121,6 +155,17 @@ void PassDriver::CreateDefaultPassList(const std::string& disable_passes) {
   }
 }
 
+std::string PassDriver::GetDefaultPassListNames() {
+  std::string names;
+  for (const Pass* pass : gDefaultPassList) {
+    if (!names.empty()) {
+      names += ',';
+    }
+    names += pass->GetName();
+  }
+  return names;
+}
+
 void PassDriver::CreatePasses() {
   // Insert each pass into the list via the InsertPass method.
   pass_list_.reserve(gDefaultPassList.size());
@@ -191,9 +236,31 @@ bool PassDriver::RunPass(CompilationUnit* c_unit, const Pass* pass, bool time_sp
   bool should_apply_pass = pass->Gate(c_unit);
 
   if (should_apply_pass) {
+    PassStatistics* statistics =
+        (c_unit->compiler_driver != nullptr && c_unit->compiler_driver->GetDumpPasses())
+        ? GetPassStatistics(pass)
+        : nullptr;
+    size_t start_arena_bytes = 0u;
+    size_t start_arena_stack_bytes = 0u;
+    uint64_t start_ns = 0u;
+    if (statistics != nullptr) {
+      statistics->mirs.FetchAndAdd(CountMIRs(c_unit->mir_graph.get()));
+      start_arena_bytes = c_unit->arena.BytesUsed();
+      start_arena_stack_bytes = c_unit->arena_stack.PeakBytesUsed();
+      start_ns = NanoTime();
+    }
+
     // Applying the pass: first start, doWork, and end calls.
     ApplyPass(c_unit, pass);
 
+    if (statistics != nullptr) {
+      statistics->time_ns.FetchAndAdd(NanoTime() - start_ns);
+      statistics->arena_bytes.FetchAndAdd(c_unit->arena.BytesUsed() - start_arena_bytes);
+      statistics->arena_stack_bytes.FetchAndAdd(
+          c_unit->arena_stack.PeakBytesUsed() - start_arena_stack_bytes);
+      ++statistics->runs;
+    }
+
     // Clean up if need be.
     HandlePassFlag(c_unit, pass);
 
@@ -247,6 +314,32 @@ void PassDriver::PrintPassNames() {
   }
 }
 
+void PassDriver::DumpStatistics(std::ostream& os) {
+  std::vector<size_t> order;
+  for (size_t i = 0; i != arraysize(gPasses); ++i) {
+    if (gPassStatistics[i].runs.Load() != 0) {
+      order.push_back(i);
+    }
+  }
+  std::sort(order.begin(), order.end(), [](size_t lhs, size_t rhs) {
+    return gPassStatistics[lhs].time_ns.Load() > gPassStatistics[rhs].time_ns.Load();
+  });
+  os << "Pass statistics:\n";
+  for (size_t i : order) {
+    const PassStatistics& statistics = gPassStatistics[i];
+    int64_t mirs = statistics.mirs.Load();
+    os << "  " << gPasses[i]->GetName() << ": " << PrettyDuration(statistics.time_ns.Load())
+       << " in " << statistics.runs.Load() << " methods, "
+       << PrettySize(statistics.arena_bytes.Load()) << " arena, "
+       << PrettySize(statistics.arena_stack_bytes.Load()) << " arena stack, "
+       << mirs << " MIRs";
+    if (mirs != 0) {
+      os << " (" << statistics.time_ns.Load() / mirs << "ns/MIR)";
+    }
+    os << "\n";
+  }
+}
+
 const Pass* PassDriver::GetPass(const char* name) const {
   for (const Pass* cur_pass : pass_list_) {
     if (strcmp(name, cur_pass->GetName()) == 0) {
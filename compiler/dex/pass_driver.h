@@ -17,6 +17,7 @@
 #ifndef ART_COMPILER_DEX_PASS_DRIVER_H_
 #define ART_COMPILER_DEX_PASS_DRIVER_H_
 
+#include <ostream>
 #include <vector>
 #include "pass.h"
 #include "safe_map.h"
@@ -76,6 +77,17 @@ class PassDriver {
   static void PrintPassNames();
   static void CreateDefaultPassList(const std::string& disable_passes);
 
+  /**
+   * @brief The names of the passes of the default pass list, in order, separated by commas.
+   */
+  static std::string GetDefaultPassListNames();
+
+  /**
+   * @brief Dump the time, arena memory and MIRs of each pass, summed over the methods compiled
+   * with the dumping of passes enabled, the most costly pass first.
+   */
+  static void DumpStatistics(std::ostream& os);
+
   const Pass* GetPass(const char* name) const;
 
   const char* GetDumpCFGFolder() const {
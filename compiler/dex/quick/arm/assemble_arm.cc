@@ -1207,10 +1207,87 @@ uint8_t* ArmMir2Lir::EncodeLIRs(uint8_t* write_pos, LIR* lir) {
 }
 
 // Assemble the LIR into binary instruction format.
+// Whether the condition codes at lir are overwritten before anything reads them. Conservatively
+// false when control leaves the straight line code first.
+bool ArmMir2Lir::FlagsDeadAt(LIR* lir) {
+  for (; lir != nullptr; lir = NEXT_LIR(lir)) {
+    if (lir->flags.is_nop || IsPseudoLirOp(lir->opcode)) {
+      continue;
+    }
+    uint64_t flags = GetTargetInstFlags(lir->opcode);
+    if ((flags & (USES_CCODES | IS_BRANCH)) != 0) {
+      return false;
+    }
+    if ((flags & SETS_CCODES) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Replaces the conditional branches over a single data processing instruction with an IT block:
+ *     b<c>  label             it    <!c>
+ *     mov   rX, #imm    =>    mov   rX, #imm
+ * label:                  label:
+ * which has the same size but neither takes a branch nor flushes the pipeline when mispredicted.
+ * The 16-bit instructions which set the flags don't in an IT block, those are only made conditional
+ * if the flags are dead at the label.
+ */
+void ArmMir2Lir::FormITBlocks() {
+  for (LIR* lir = first_lir_insn_; lir != nullptr; lir = NEXT_LIR(lir)) {
+    if (lir->flags.is_nop || (lir->opcode != kThumbBCond && lir->opcode != kThumb2BCond)) {
+      continue;
+    }
+    ArmConditionCode code = static_cast<ArmConditionCode>(lir->operands[1]);
+    LIR* insn = NEXT_LIR(lir);
+    if (code == kArmCondAl || insn == nullptr || insn->flags.is_nop) {
+      continue;
+    }
+    bool sets_flags;
+    switch (insn->opcode) {
+      case kThumbMovRR_H2H:
+      case kThumbMovRR_H2L:
+      case kThumbMovRR_L2H:
+      case kThumb2MovRR:
+      case kThumb2MovI8M:
+      case kThumb2MovImm16:
+        sets_flags = false;
+        break;
+      case kThumbMovImm:
+      case kThumbMovRR:
+      case kThumbAddRRI3:
+      case kThumbAddRI8:
+      case kThumbSubRI8:
+        sets_flags = true;
+        break;
+      default:
+        continue;
+    }
+    // The branch must skip just that instruction, other labels on the way are fine.
+    LIR* next = NEXT_LIR(insn);
+    while (next != nullptr && next != lir->target &&
+           (next->flags.is_nop || IsPseudoLirOp(next->opcode))) {
+      next = NEXT_LIR(next);
+    }
+    if (next != lir->target || (sets_flags && !FlagsDeadAt(next))) {
+      continue;
+    }
+    // The opposite conditions only differ by their lowest bit.
+    LIR* it = RawLIR(lir->dalvik_offset, kThumb2It, code ^ 1, 0x8 /* one "then" instruction */);
+    InsertLIRBefore(lir, it);
+    NopLIR(lir);
+    lir = insn;
+  }
+}
+
 void ArmMir2Lir::AssembleLIR() {
   LIR* lir;
   LIR* prev_lir;
   cu_->NewTimingSplit("Assemble");
+  if (!(cu_->disable_opt & (1 << kSafeOptimizations))) {
+    FormITBlocks();
+  }
   int assembler_retries = 0;
   CodeOffset starting_offset = LinkFixupInsns(first_lir_insn_, last_lir_insn_, 0);
   data_offset_ = RoundUp(starting_offset, 4);
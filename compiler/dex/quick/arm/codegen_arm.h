@@ -22,6 +22,8 @@
 
 namespace art {
 
+struct ArmLatencies;
+
 class ArmMir2Lir FINAL : public Mir2Lir {
   public:
     ArmMir2Lir(CompilationUnit* cu, MIRGraph* mir_graph, ArenaAllocator* arena);
@@ -54,6 +56,7 @@ class ArmMir2Lir FINAL : public Mir2Lir {
     void MarkGCCard(RegStorage val_reg, RegStorage tgt_addr_reg);
 
     // Required for target - register utilities.
+    RegStorage AllocTemp() OVERRIDE;
     RegStorage AllocTypedTemp(bool fp_hint, int reg_class);
     RegStorage AllocTypedTempWide(bool fp_hint, int reg_class);
     RegStorage TargetReg(SpecialTargetRegister reg);
@@ -75,6 +78,8 @@ class ArmMir2Lir FINAL : public Mir2Lir {
     RegStorage AllocPreservedDouble(int s_reg);
 
     // Required for target - miscellaneous.
+    void FormITBlocks();
+    bool FlagsDeadAt(LIR* lir);
     void AssembleLIR();
     uint32_t LinkFixupInsns(LIR* head_lir, LIR* tail_lir, CodeOffset offset);
     int AssignInsnOffsets();
@@ -89,6 +94,8 @@ class ArmMir2Lir FINAL : public Mir2Lir {
     uint64_t GetTargetInstFlags(int opcode);
     int GetInsnSize(LIR* lir);
     bool IsUnconditionalBranch(LIR* lir);
+    int GetInstructionLatency(LIR* lir) OVERRIDE;
+    int GetSchedulingBarrierLength(LIR* lir) OVERRIDE;
 
     // Check support for volatile load/store of a given size.
     bool SupportsVolatileLoadStore(OpSize size) OVERRIDE;
@@ -119,6 +126,10 @@ class ArmMir2Lir FINAL : public Mir2Lir {
     void GenConversion(Instruction::Code opcode, RegLocation rl_dest, RegLocation rl_src);
     bool GenInlinedCas(CallInfo* info, bool is_long, bool is_object);
     bool GenInlinedMinMaxInt(CallInfo* info, bool is_min);
+    bool GenInlinedMinMaxLong(CallInfo* info, bool is_min);
+    bool GenInlinedStringEquals(CallInfo* info);
+    bool GenInlinedArrayCopy(CallInfo* info);
+    bool GenInlinedArraysFill(CallInfo* info, OpSize size);
     bool GenInlinedSqrt(CallInfo* info);
     bool GenInlinedPeek(CallInfo* info, OpSize size);
     bool GenInlinedPoke(CallInfo* info, OpSize size);
@@ -148,8 +159,8 @@ class ArmMir2Lir FINAL : public Mir2Lir {
                                        int first_bit, int second_bit);
     void GenNegDouble(RegLocation rl_dest, RegLocation rl_src);
     void GenNegFloat(RegLocation rl_dest, RegLocation rl_src);
-    void GenPackedSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src);
-    void GenSparseSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src);
+    void GenPackedSwitch(MIR* mir, const uint16_t* table, RegLocation rl_src);
+    void GenSparseSwitch(MIR* mir, const uint16_t* table, RegLocation rl_src);
 
     // Required for target - single operation generators.
     LIR* OpUnconditionalBranch(LIR* target);
@@ -215,6 +226,9 @@ class ArmMir2Lir FINAL : public Mir2Lir {
     bool GetEasyMultiplyOp(int lit, EasyMultiplyOp* op);
     bool GetEasyMultiplyTwoOps(int lit, EasyMultiplyOp* ops);
     void GenEasyMultiplyTwoOps(RegStorage r_dest, RegStorage r_src, EasyMultiplyOp* ops);
+
+    // Latencies of the core selected by --instruction-set-features, or nullptr for none.
+    const ArmLatencies* const latencies_;
 };
 
 }  // namespace art
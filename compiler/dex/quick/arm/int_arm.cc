@@ -21,6 +21,8 @@
 #include "dex/quick/mir_to_lir-inl.h"
 #include "entrypoints/quick/quick_entrypoints.h"
 #include "mirror/array.h"
+#include "mirror/class.h"
+#include "mirror/string.h"
 
 namespace art {
 
@@ -701,6 +703,238 @@ bool ArmMir2Lir::GenInlinedMinMaxInt(CallInfo* info, bool is_min) {
   return true;
 }
 
+bool ArmMir2Lir::GenInlinedMinMaxLong(CallInfo* info, bool is_min) {
+  DCHECK_EQ(cu_->instruction_set, kThumb2);
+  // As in GenLong3Addr, the two sources and the result may need six temps; lend lr.
+  MarkTemp(TargetReg(kLr));
+  FreeTemp(TargetReg(kLr));
+  RegLocation rl_src1 = LoadValueWide(info->args[0], kCoreReg);
+  RegLocation rl_src2 = LoadValueWide(info->args[2], kCoreReg);
+  RegLocation rl_dest = InlineTargetWide(info);
+  RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
+  RegStorage r_sources[] = { rl_src1.reg.GetLow(), rl_src1.reg.GetHigh(),
+                             rl_src2.reg.GetLow(), rl_src2.reg.GetHigh() };
+  bool overlap = false;
+  for (RegStorage reg : r_sources) {
+    overlap |= (reg == rl_result.reg.GetLow() || reg == rl_result.reg.GetHigh());
+  }
+  // cmp/sbcs sets the flags of src1 - src2, where only lt and ge are meaningful. The high half
+  // of the result is overwritten below and can take the difference unless it is a source.
+  RegStorage t_reg = overlap ? AllocTemp() : rl_result.reg.GetHigh();
+  OpRegReg(kOpCmp, rl_src1.reg.GetLow(), rl_src2.reg.GetLow());
+  OpRegRegReg(kOpSbc, t_reg, rl_src1.reg.GetHigh(), rl_src2.reg.GetHigh());
+  if (overlap) {
+    FreeTemp(t_reg);
+  }
+  LIR* it = OpIT((is_min) ? kCondLt : kCondGe, "TEE");
+  for (RegStorage src : { rl_src1.reg, rl_src2.reg }) {
+    // Move the high half first if the low half of the result is where it comes from.
+    if (rl_result.reg.GetLow() == src.GetHigh()) {
+      OpRegReg(kOpMov, rl_result.reg.GetHigh(), src.GetHigh());
+      OpRegReg(kOpMov, rl_result.reg.GetLow(), src.GetLow());
+    } else {
+      OpRegReg(kOpMov, rl_result.reg.GetLow(), src.GetLow());
+      OpRegReg(kOpMov, rl_result.reg.GetHigh(), src.GetHigh());
+    }
+  }
+  OpEndIT(it);
+  FreeRegLocTemps(rl_result, rl_src1);
+  FreeRegLocTemps(rl_result, rl_src2);
+  StoreValueWide(rl_dest, rl_result);
+  Clobber(TargetReg(kLr));
+  UnmarkTemp(TargetReg(kLr));  // Remove lr from the temp pool
+  return true;
+}
+
+/*
+ * Fast String.equals(Object). Compares the characters inline, so that no path calls the
+ * library code:
+ *
+ *     if (this == other) return true;
+ *     if (other == null || other.getClass() != String.class) return false;
+ *     if (this.count != other.count) return false;
+ *     compare count chars of this.value[this.offset..] and other.value[other.offset..]
+ */
+bool ArmMir2Lir::GenInlinedStringEquals(CallInfo* info) {
+  int value_offset = mirror::String::ValueOffset().Int32Value();
+  int count_offset = mirror::String::CountOffset().Int32Value();
+  int offset_offset = mirror::String::OffsetOffset().Int32Value();
+  int data_offset = mirror::Array::DataOffset(sizeof(uint16_t)).Int32Value();
+  int class_offset = mirror::Object::ClassOffset().Int32Value();
+
+  RegLocation rl_this = LoadValue(info->args[0], kCoreReg);
+  RegLocation rl_cmp = LoadValue(info->args[1], kCoreReg);
+  GenExplicitNullCheck(rl_this.reg, info->opt_flags);
+  LIR* same_branch = OpCmpBranch(kCondEq, rl_this.reg, rl_cmp.reg, nullptr);
+  LIR* null_branch = OpCmpImmBranch(kCondEq, rl_cmp.reg, 0, nullptr);
+  // String is final, so the other object is a String if it has the same class.
+  RegStorage r_count = AllocTemp();
+  RegStorage r_tmp = AllocTemp();
+  LoadRefDisp(rl_this.reg, class_offset, r_count);
+  LoadRefDisp(rl_cmp.reg, class_offset, r_tmp);
+  LIR* class_branch = OpCmpBranch(kCondNe, r_count, r_tmp, nullptr);
+  Load32Disp(rl_this.reg, count_offset, r_count);
+  Load32Disp(rl_cmp.reg, count_offset, r_tmp);
+  LIR* count_branch = OpCmpBranch(kCondNe, r_count, r_tmp, nullptr);
+  LIR* empty_branch = OpCmpImmBranch(kCondEq, r_count, 0, nullptr);
+
+  // Point at the first char of each string, less the data offset of the arrays.
+  RegStorage r_this_ptr = AllocTemp();
+  Load32Disp(rl_this.reg, offset_offset, r_tmp);
+  LoadRefDisp(rl_this.reg, value_offset, r_this_ptr);
+  OpRegRegRegShift(kOpAdd, r_this_ptr, r_this_ptr, r_tmp, EncodeShift(kArmLsl, 1));
+  if (rl_this.reg.GetReg() != rl_cmp.reg.GetReg()) {
+    FreeTemp(rl_this.reg);
+  }
+  RegStorage r_cmp_ptr = AllocTemp();
+  Load32Disp(rl_cmp.reg, offset_offset, r_tmp);
+  LoadRefDisp(rl_cmp.reg, value_offset, r_cmp_ptr);
+  OpRegRegRegShift(kOpAdd, r_cmp_ptr, r_cmp_ptr, r_tmp, EncodeShift(kArmLsl, 1));
+  FreeTemp(rl_cmp.reg);
+
+  RegStorage r_char = AllocTemp();
+  LIR* loop = NewLIR0(kPseudoTargetLabel);
+  LoadBaseDisp(r_this_ptr, data_offset, r_tmp, kUnsignedHalf);
+  LoadBaseDisp(r_cmp_ptr, data_offset, r_char, kUnsignedHalf);
+  LIR* char_branch = OpCmpBranch(kCondNe, r_tmp, r_char, nullptr);
+  OpRegImm(kOpAdd, r_this_ptr, sizeof(uint16_t));
+  OpRegImm(kOpAdd, r_cmp_ptr, sizeof(uint16_t));
+  OpDecAndBranch(kCondNe, r_count, loop);
+  FreeTemp(r_count);
+  FreeTemp(r_tmp);
+  FreeTemp(r_this_ptr);
+  FreeTemp(r_cmp_ptr);
+  FreeTemp(r_char);
+
+  RegLocation rl_dest = InlineTarget(info);
+  RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
+  LIR* true_target = NewLIR0(kPseudoTargetLabel);
+  LoadConstant(rl_result.reg, 1);
+  LIR* done_branch = OpUnconditionalBranch(nullptr);
+  LIR* false_target = NewLIR0(kPseudoTargetLabel);
+  LoadConstant(rl_result.reg, 0);
+  done_branch->target = NewLIR0(kPseudoTargetLabel);
+  StoreValue(rl_dest, rl_result);
+
+  same_branch->target = true_target;
+  empty_branch->target = true_target;
+  null_branch->target = false_target;
+  class_branch->target = false_target;
+  count_branch->target = false_target;
+  char_branch->target = false_target;
+  return true;
+}
+
+/*
+ * Fast System.arraycopy for short copies between char arrays, the bulk of the copies of
+ * String and StringBuilder. Anything else, including every copy that throws, calls the
+ * native.
+ */
+bool ArmMir2Lir::GenInlinedArrayCopy(CallInfo* info) {
+  // Longer copies are faster in the memmove of the native.
+  constexpr int kMaxInlinedLength = 32;
+  int class_offset = mirror::Object::ClassOffset().Int32Value();
+  int component_type_offset = mirror::Class::ComponentTypeOffset().Int32Value();
+  int primitive_type_offset = mirror::Class::PrimitiveTypeOffset().Int32Value();
+  int length_offset = mirror::Array::LengthOffset().Int32Value();
+  int data_offset = mirror::Array::DataOffset(sizeof(uint16_t)).Int32Value();
+
+  // The checks branch to a call of the native, placed after the fast path.
+  LIR* slow_target = RawLIR(current_dalvik_offset_, kPseudoTargetLabel);
+
+  // A negative length is a large unsigned value.
+  RegLocation rl_length = LoadValue(info->args[4], kCoreReg);
+  OpCmpImmBranch(kCondHi, rl_length.reg, kMaxInlinedLength, slow_target);
+  RegLocation rl_src = LoadValue(info->args[0], kCoreReg);
+  RegLocation rl_dst = LoadValue(info->args[2], kCoreReg);
+  OpCmpImmBranch(kCondEq, rl_src.reg, 0, slow_target);
+  OpCmpImmBranch(kCondEq, rl_dst.reg, 0, slow_target);
+  RegStorage r_src_ptr = AllocTemp();
+  RegStorage r_dst_ptr = AllocTemp();
+  LoadRefDisp(rl_src.reg, class_offset, r_src_ptr);
+  LoadRefDisp(rl_dst.reg, class_offset, r_dst_ptr);
+  OpCmpBranch(kCondNe, r_src_ptr, r_dst_ptr, slow_target);
+  LoadRefDisp(r_src_ptr, component_type_offset, r_src_ptr);
+  OpCmpImmBranch(kCondEq, r_src_ptr, 0, slow_target);
+  Load32Disp(r_src_ptr, primitive_type_offset, r_src_ptr);
+  OpCmpImmBranch(kCondNe, r_src_ptr, Primitive::kPrimChar, slow_target);
+
+  // Check 0 <= pos <= array.length - length for each array, then point at the chars to copy,
+  // less the data offset. A negative pos is a large unsigned value.
+  LoadValueDirectFixed(info->args[1], r_src_ptr);
+  Load32Disp(rl_src.reg, length_offset, r_dst_ptr);
+  OpRegReg(kOpSub, r_dst_ptr, rl_length.reg);
+  OpCmpImmBranch(kCondLt, r_dst_ptr, 0, slow_target);
+  OpCmpBranch(kCondHi, r_src_ptr, r_dst_ptr, slow_target);
+  OpRegRegRegShift(kOpAdd, r_src_ptr, rl_src.reg, r_src_ptr, EncodeShift(kArmLsl, 1));
+  if (rl_src.reg.GetReg() != rl_dst.reg.GetReg()) {
+    FreeTemp(rl_src.reg);
+  }
+  LoadValueDirectFixed(info->args[3], r_dst_ptr);
+  RegStorage r_tmp = AllocTemp();
+  Load32Disp(rl_dst.reg, length_offset, r_tmp);
+  OpRegReg(kOpSub, r_tmp, rl_length.reg);
+  OpCmpImmBranch(kCondLt, r_tmp, 0, slow_target);
+  OpCmpBranch(kCondHi, r_dst_ptr, r_tmp, slow_target);
+  OpRegRegRegShift(kOpAdd, r_dst_ptr, rl_dst.reg, r_dst_ptr, EncodeShift(kArmLsl, 1));
+  FreeTemp(rl_dst.reg);
+
+  // Copying forward is wrong only if the destination starts within the source, which can
+  // happen only within one array.
+  OpRegRegRegShift(kOpAdd, r_tmp, r_src_ptr, rl_length.reg, EncodeShift(kArmLsl, 1));
+  LIR* forward_branch = OpCmpBranch(kCondUge, r_src_ptr, r_dst_ptr, nullptr);
+  OpCmpBranch(kCondUlt, r_dst_ptr, r_tmp, slow_target);
+  forward_branch->target = NewLIR0(kPseudoTargetLabel);
+
+  OpRegCopy(r_tmp, rl_length.reg);
+  FreeTemp(rl_length.reg);
+  LIR* empty_branch = OpCmpImmBranch(kCondEq, r_tmp, 0, nullptr);
+  RegStorage r_char = AllocTemp();
+  LIR* loop = NewLIR0(kPseudoTargetLabel);
+  LoadBaseDisp(r_src_ptr, data_offset, r_char, kUnsignedHalf);
+  StoreBaseDisp(r_dst_ptr, data_offset, r_char, kUnsignedHalf);
+  OpRegImm(kOpAdd, r_src_ptr, sizeof(uint16_t));
+  OpRegImm(kOpAdd, r_dst_ptr, sizeof(uint16_t));
+  OpDecAndBranch(kCondNe, r_tmp, loop);
+  FreeTemp(r_src_ptr);
+  FreeTemp(r_dst_ptr);
+  FreeTemp(r_tmp);
+  FreeTemp(r_char);
+  LIR* done_branch = OpUnconditionalBranch(nullptr);
+
+  AppendLIR(slow_target);
+  LIR* call_branch = OpUnconditionalBranch(nullptr);
+  LIR* resume_target = NewLIR0(kPseudoTargetLabel);
+  empty_branch->target = resume_target;
+  done_branch->target = resume_target;
+  AddIntrinsicSlowPath(info, call_branch, resume_target);
+  return true;
+}
+
+bool ArmMir2Lir::GenInlinedArraysFill(CallInfo* info, OpSize size) {
+  int element_size = (size == k32) ? 4 : ((size == kUnsignedHalf) ? 2 : 1);
+  int length_offset = mirror::Array::LengthOffset().Int32Value();
+  int data_offset = mirror::Array::DataOffset(element_size).Int32Value();
+
+  RegLocation rl_array = LoadValue(info->args[0], kCoreReg);
+  RegLocation rl_value = LoadValue(info->args[1], kCoreReg);
+  // The null check flags of a static invoke do not cover its arguments.
+  GenExplicitNullCheck(rl_array.reg, 0);
+  RegStorage r_count = AllocTemp();
+  RegStorage r_ptr = AllocTemp();
+  Load32Disp(rl_array.reg, length_offset, r_count);
+  OpRegRegImm(kOpAdd, r_ptr, rl_array.reg, data_offset);
+  LIR* empty_branch = OpCmpImmBranch(kCondEq, r_count, 0, nullptr);
+  LIR* loop = NewLIR0(kPseudoTargetLabel);
+  StoreBaseDisp(r_ptr, 0, rl_value.reg, size);
+  OpRegImm(kOpAdd, r_ptr, element_size);
+  OpDecAndBranch(kCondNe, r_count, loop);
+  empty_branch->target = NewLIR0(kPseudoTargetLabel);
+  FreeTemp(r_count);
+  FreeTemp(r_ptr);
+  return true;
+}
+
 bool ArmMir2Lir::GenInlinedPeek(CallInfo* info, OpSize size) {
   RegLocation rl_src_address = info->args[0];  // long address
   rl_src_address = NarrowRegLoc(rl_src_address);  // ignore high half in info->args[1]
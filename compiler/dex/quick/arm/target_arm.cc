@@ -537,8 +537,36 @@ RegisterClass ArmMir2Lir::RegClassForFieldLoadStore(OpSize size, bool is_volatil
   return RegClassBySize(size);
 }
 
+// Cycles until the result of an instruction of each class can be used, as given by the
+// technical reference manuals. The list scheduler only needs them to be right relative to
+// each other.
+struct ArmLatencies {
+  int alu;
+  int mul;
+  int div;
+  int load;
+  int fp_alu;
+  int fp_mul;
+  int fp_div;
+  int transfer;  // Between core and VFP registers, including vmrs APSR_nzcv.
+};
+
+static const ArmLatencies kArmLatencies[] = {
+  // alu, mul, div, load, fp_alu, fp_mul, fp_div, transfer
+  {  0,   0,   0,   0,    0,      0,      0,      0 },  // kArmCpuGeneric: no scheduling.
+  {  1,   3,   6,   3,    4,      5,     18,      4 },  // kArmCpuCortexA7
+  {  1,   4,  20,   4,    4,      5,     15,      3 },  // kArmCpuCortexA9
+  {  1,   4,  10,   4,    4,      5,     16,      5 },  // kArmCpuCortexA15
+};
+
+static const ArmLatencies* GetArmLatencies(CompilationUnit* cu) {
+  ArmCpu cpu = cu->GetInstructionSetFeatures().GetArmCpu();
+  return (cpu == kArmCpuGeneric) ? nullptr : &kArmLatencies[cpu];
+}
+
 ArmMir2Lir::ArmMir2Lir(CompilationUnit* cu, MIRGraph* mir_graph, ArenaAllocator* arena)
-    : Mir2Lir(cu, mir_graph, arena) {
+    : Mir2Lir(cu, mir_graph, arena),
+      latencies_(GetArmLatencies(cu)) {
   // Sanity check - make sure encoding map lines up.
   for (int i = 0; i < kArmLast; i++) {
     if (ArmMir2Lir::EncodingMap[i].opcode != i) {
@@ -565,6 +593,28 @@ RegStorage ArmMir2Lir::AllocTypedTempWide(bool fp_hint, int reg_class) {
   }
 }
 
+RegStorage ArmMir2Lir::AllocTemp() {
+  // Prefer the low temps to r12, which only the 32-bit Thumb2 encodings can address. The base
+  // allocation, which may also pick r12 or kill a live temp, is the fallback.
+  GrowableArray<RegisterInfo*>& regs = reg_pool_->core_regs_;
+  int num_regs = regs.Size();
+  int next = reg_pool_->next_core_reg_;
+  for (int i = 0; i < num_regs; i++, next++) {
+    if (next >= num_regs) {
+      next = 0;
+    }
+    RegisterInfo* info = regs.Get(next);
+    if (info->GetReg().Low8() && info->IsTemp() && !info->InUse() && info->IsDead()) {
+      Clobber(info->GetReg());
+      info->MarkInUse();
+      info->SetIsWide(false);
+      reg_pool_->next_core_reg_ = next + 1;
+      return info->GetReg();
+    }
+  }
+  return Mir2Lir::AllocTemp();
+}
+
 RegStorage ArmMir2Lir::AllocTypedTemp(bool fp_hint, int reg_class) {
   if (((reg_class == kAnyReg) && fp_hint) || (reg_class == kFPReg))
     return AllocTempSingle();
@@ -743,6 +793,72 @@ uint64_t ArmMir2Lir::GetTargetInstFlags(int opcode) {
   return ArmMir2Lir::EncodingMap[opcode].flags;
 }
 
+int ArmMir2Lir::GetInstructionLatency(LIR* lir) {
+  if (latencies_ == nullptr) {
+    return 0;
+  }
+  switch (lir->opcode) {
+    case kThumbMul:
+    case kThumb2MulRRR:
+    case kThumb2Mla:
+    case kThumb2Umull:
+    case kThumb2Smull:
+      return latencies_->mul;
+    case kThumb2SdivRRR:
+    case kThumb2UdivRRR:
+      return latencies_->div;
+    case kThumb2Vadds:
+    case kThumb2Vaddd:
+    case kThumb2Vsubs:
+    case kThumb2Vsubd:
+    case kThumb2VcvtIF:
+    case kThumb2VcvtFI:
+    case kThumb2VcvtDI:
+    case kThumb2VcvtFd:
+    case kThumb2VcvtDF:
+    case kThumb2VcvtF64S32:
+    case kThumb2VcvtF64U32:
+    case kThumb2Vcmps:
+    case kThumb2Vcmpd:
+      return latencies_->fp_alu;
+    case kThumb2Vmuls:
+    case kThumb2Vmuld:
+    case kThumb2VmlaF64:
+      return latencies_->fp_mul;
+    case kThumb2Vdivs:
+    case kThumb2Vdivd:
+    case kThumb2Vsqrts:
+    case kThumb2Vsqrtd:
+      return latencies_->fp_div;
+    case kThumb2Fmrs:
+    case kThumb2Fmsr:
+    case kThumb2Fmrrd:
+    case kThumb2Fmdrr:
+    case kThumb2Fmstat:
+      return latencies_->transfer;
+    default:
+      return (GetTargetInstFlags(lir->opcode) & IS_LOAD) ? latencies_->load : latencies_->alu;
+  }
+}
+
+int ArmMir2Lir::GetSchedulingBarrierLength(LIR* lir) {
+  switch (lir->opcode) {
+    case kThumb2It:
+      // The IT and the 1 to 4 instructions it predicates; the mask's lowest set bit ends it.
+      return 1 + 4 - CTZ(lir->operands[1]);
+    case kThumb2Ldrex:
+    case kThumb2Ldrexd:
+    case kThumb2Strex:
+    case kThumb2Strexd:
+    case kThumb2Clrex:
+    case kThumb2Dmb:
+      // Keep other memory accesses out of exclusive sequences.
+      return 1;
+    default:
+      return 0;
+  }
+}
+
 const char* ArmMir2Lir::GetTargetInstName(int opcode) {
   DCHECK(!IsPseudoLirOp(opcode));
   return ArmMir2Lir::EncodingMap[opcode].name;
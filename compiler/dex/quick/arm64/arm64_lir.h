@@ -258,6 +258,9 @@ enum ArmOpcode {
   kA64Frintz2ff,     // frintz [000111100s100101110000] rn[9-5] rd[4-0].
   kA64Fsqrt2ff,      // fsqrt[000111100s100001110000] rn[9-5] rd[4-0].
   kA64Fsub3fff,      // fsub[000111100s1] rm[20-16] [001110] rn[9-5] rd[4-0].
+  kA64Ldar2rX,       // ldar[1s00100011011111111111] rn[9-5] rt[4-0].
+  kA64Ldarb2wX,      // ldarb[0000100011011111111111] rn[9-5] rt[4-0].
+  kA64Ldarh2wX,      // ldarh[0100100011011111111111] rn[9-5] rt[4-0].
   kA64Ldrb3wXd,      // ldrb[0011100101] imm_12[21-10] rn[9-5] rt[4-0].
   kA64Ldrb3wXx,      // ldrb[00111000011] rm[20-16] [011] S[12] [10] rn[9-5] rt[4-0].
   kA64Ldrsb3rXd,     // ldrsb[001110011s] imm_12[21-10] rn[9-5] rt[4-0].
@@ -301,6 +304,9 @@ enum ArmOpcode {
   kA64Scvtf2fx,      // scvtf  [100111100s100010000000] rn[9-5] rd[4-0].
   kA64Sdiv3rrr,      // sdiv[s0011010110] rm[20-16] [000011] rn[9-5] rd[4-0].
   kA64Smaddl4xwwx,   // smaddl [10011011001] rm[20-16] [0] ra[14-10] rn[9-5] rd[4-0].
+  kA64Stlr2rX,       // stlr[1s00100010011111111111] rn[9-5] rt[4-0].
+  kA64Stlrb2wX,      // stlrb[0000100010011111111111] rn[9-5] rt[4-0].
+  kA64Stlrh2wX,      // stlrh[0100100010011111111111] rn[9-5] rt[4-0].
   kA64Stp4ffXD,      // stp [0s10110100] imm_7[21-15] rt2[14-10] rn[9-5] rt[4-0].
   kA64Stp4rrXD,      // stp [s010100100] imm_7[21-15] rt2[14-10] rn[9-5] rt[4-0].
   kA64StpPost4rrXD,  // stp [s010100010] imm_7[21-15] rt2[14-10] rn[9-5] rt[4-0].
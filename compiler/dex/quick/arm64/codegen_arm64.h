@@ -91,6 +91,7 @@ class Arm64Mir2Lir : public Mir2Lir {
 
     // Check support for volatile load/store of a given size.
     bool SupportsVolatileLoadStore(OpSize size) OVERRIDE;
+    bool VolatileLoadStoreIsAcquireRelease(OpSize size) OVERRIDE;
     // Get the register class for load/store of a field.
     RegisterClass RegClassForFieldLoadStore(OpSize size, bool is_volatile) OVERRIDE;
 
@@ -148,8 +149,8 @@ class Arm64Mir2Lir : public Mir2Lir {
                                        int first_bit, int second_bit);
     void GenNegDouble(RegLocation rl_dest, RegLocation rl_src);
     void GenNegFloat(RegLocation rl_dest, RegLocation rl_src);
-    void GenPackedSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src);
-    void GenSparseSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src);
+    void GenPackedSwitch(MIR* mir, const uint16_t* table, RegLocation rl_src);
+    void GenSparseSwitch(MIR* mir, const uint16_t* table, RegLocation rl_src);
     bool GenSpecialCase(BasicBlock* bb, MIR* mir, const InlineMethod& special);
 
     uint32_t GenPairWise(uint32_t reg_mask, int* reg1, int* reg2);
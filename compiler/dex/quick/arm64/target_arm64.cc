@@ -551,12 +551,16 @@ bool Arm64Mir2Lir::SupportsVolatileLoadStore(OpSize size) {
   return true;
 }
 
+bool Arm64Mir2Lir::VolatileLoadStoreIsAcquireRelease(OpSize size) {
+  // ldar/stlr. There is no sign extending load-acquire, signed loads keep the barriers.
+  return size != kSignedByte && size != kSignedHalf;
+}
+
 RegisterClass Arm64Mir2Lir::RegClassForFieldLoadStore(OpSize size, bool is_volatile) {
   if (UNLIKELY(is_volatile)) {
-    // On arm64, fp register load/store is atomic only for single bytes.
-    if (size != kSignedByte && size != kUnsignedByte) {
-      return kCoreReg;
-    }
+    // On arm64, fp register load/store is atomic only for single bytes, and ldar/stlr only
+    // take core registers.
+    return kCoreReg;
   }
   return RegClassBySize(size);
 }
@@ -896,9 +896,46 @@ LIR* Arm64Mir2Lir::LoadBaseDispBody(RegStorage r_base, int displacement, RegStor
 
 LIR* Arm64Mir2Lir::LoadBaseDispVolatile(RegStorage r_base, int displacement, RegStorage r_dest,
                                         OpSize size) {
-  // LoadBaseDisp() will emit correct insn for atomic load on arm64
-  // assuming r_dest is correctly prepared using RegClassForFieldLoadStore().
-  return LoadBaseDisp(r_base, displacement, r_dest, size);
+  if (!VolatileLoadStoreIsAcquireRelease(size)) {
+    // LoadBaseDisp() will emit correct insn for atomic load on arm64
+    // assuming r_dest is correctly prepared using RegClassForFieldLoadStore().
+    return LoadBaseDisp(r_base, displacement, r_dest, size);
+  }
+
+  // Load-acquire only takes a base register.
+  DCHECK(!r_dest.IsFloat());
+  RegStorage r_addr = r_base;
+  if (displacement != 0) {
+    r_addr = AllocTemp();
+    OpRegRegImm(kOpAdd, r_addr, r_base, displacement);
+  }
+  ArmOpcode opcode = kA64Brk1d;
+  switch (size) {
+    case kDouble:     // Intentional fall-through.
+    case kWord:       // Intentional fall-through.
+    case k64:
+      opcode = WIDE(kA64Ldar2rX);
+      break;
+    case kSingle:     // Intentional fall-through.
+    case k32:         // Intentional fall-trough.
+    case kReference:
+      opcode = kA64Ldar2rX;
+      break;
+    case kUnsignedHalf:
+      opcode = kA64Ldarh2wX;
+      break;
+    case kUnsignedByte:
+      opcode = kA64Ldarb2wX;
+      break;
+    default:
+      LOG(FATAL) << "Bad size: " << size;
+  }
+  // The load must be the last insn, for MarkPossibleNullPointerException().
+  LIR* load = NewLIR2(opcode, r_dest.GetReg(), r_addr.GetReg());
+  if (r_addr != r_base) {
+    FreeTemp(r_addr);
+  }
+  return load;
 }
 
 LIR* Arm64Mir2Lir::LoadBaseDisp(RegStorage r_base, int displacement, RegStorage r_dest,
@@ -977,9 +1014,46 @@ LIR* Arm64Mir2Lir::StoreBaseDispBody(RegStorage r_base, int displacement, RegSto
 
 LIR* Arm64Mir2Lir::StoreBaseDispVolatile(RegStorage r_base, int displacement, RegStorage r_src,
                                          OpSize size) {
-  // StoreBaseDisp() will emit correct insn for atomic store on arm64
-  // assuming r_dest is correctly prepared using RegClassForFieldLoadStore().
-  return StoreBaseDisp(r_base, displacement, r_src, size);
+  if (!VolatileLoadStoreIsAcquireRelease(size)) {
+    // StoreBaseDisp() will emit correct insn for atomic store on arm64
+    // assuming r_dest is correctly prepared using RegClassForFieldLoadStore().
+    return StoreBaseDisp(r_base, displacement, r_src, size);
+  }
+
+  // Store-release only takes a base register.
+  DCHECK(!r_src.IsFloat());
+  RegStorage r_addr = r_base;
+  if (displacement != 0) {
+    r_addr = AllocTemp();
+    OpRegRegImm(kOpAdd, r_addr, r_base, displacement);
+  }
+  ArmOpcode opcode = kA64Brk1d;
+  switch (size) {
+    case kDouble:     // Intentional fall-through.
+    case kWord:       // Intentional fall-through.
+    case k64:
+      opcode = WIDE(kA64Stlr2rX);
+      break;
+    case kSingle:     // Intentional fall-through.
+    case k32:         // Intentional fall-trough.
+    case kReference:
+      opcode = kA64Stlr2rX;
+      break;
+    case kUnsignedHalf:
+      opcode = kA64Stlrh2wX;
+      break;
+    case kUnsignedByte:
+      opcode = kA64Stlrb2wX;
+      break;
+    default:
+      LOG(FATAL) << "Bad size: " << size;
+  }
+  // The store must be the last insn, for MarkPossibleNullPointerException().
+  LIR* store = NewLIR2(opcode, r_src.GetReg(), r_addr.GetReg());
+  if (r_addr != r_base) {
+    FreeTemp(r_addr);
+  }
+  return store;
 }
 
 LIR* Arm64Mir2Lir::StoreBaseDisp(RegStorage r_base, int displacement, RegStorage r_src,
@@ -573,7 +573,10 @@ bool Mir2Lir::VerifyCatchEntries() {
   std::vector<uint32_t> dex_pcs;
   dex_pcs.reserve(table.DexToPcSize());
   for (auto it = table.DexToPcBegin(), end = table.DexToPcEnd(); it != end; ++it) {
-    dex_pcs.push_back(it.DexPc());
+    if (std::find(osr_entry_dex_pcs_.begin(), osr_entry_dex_pcs_.end(), it.DexPc()) ==
+        osr_entry_dex_pcs_.end()) {
+      dex_pcs.push_back(it.DexPc());
+    }
   }
   // Sort dex_pcs, so that we can quickly check it against the ordered mir_graph_->catches_.
   std::sort(dex_pcs.begin(), dex_pcs.end());
@@ -961,6 +964,7 @@ Mir2Lir::Mir2Lir(CompilationUnit* cu, MIRGraph* mir_graph, ArenaAllocator* arena
       first_lir_insn_(NULL),
       last_lir_insn_(NULL),
       slow_paths_(arena, 32, kGrowableArraySlowPaths) {
+  std::fill_n(last_throw_slow_paths_, static_cast<size_t>(ThrowSlowPath::kNumKinds), nullptr);
   // Reserve pointer id 0 for NULL.
   size_t null_idx = WrapPointer(NULL);
   DCHECK_EQ(null_idx, 0U);
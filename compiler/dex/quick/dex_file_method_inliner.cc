@@ -63,6 +63,67 @@ bool WideArgIsInConsecutiveDalvikRegs(MIR* invoke, uint32_t arg) {
       invoke->dalvikInsn.arg[arg + 1u] == invoke->dalvikInsn.arg[arg] + 1u;
 }
 
+/**
+ * Maps the registers of a straight-line method to the registers of the caller holding their
+ * values: the arguments are in the registers of the invoke, and the other registers are
+ * mapped to the registers receiving the result of the invoke.
+ */
+class StraightLineRegisterMap {
+ public:
+  StraightLineRegisterMap(MIR* invoke, uint32_t num_locals, uint32_t result_reg)
+      : invoke_(invoke), num_locals_(num_locals), result_reg_(result_reg) {
+    std::fill_n(defined_, arraysize(defined_), false);
+  }
+
+  // Maps the register `*reg` read by an instruction. Returns false if its value is not
+  // available in the caller.
+  bool MapUse(uint32_t* reg, bool wide) {
+    bool is_arg = *reg >= num_locals_;
+    if (!Map(reg, wide)) {
+      return false;
+    }
+    // An argument in a register receiving the result is lost once a value is defined there.
+    return !is_arg || (!IsDefined(*reg) && !(wide && IsDefined(*reg + 1u)));
+  }
+
+  // Maps the register `*reg` written by an instruction.
+  bool MapDef(uint32_t* reg, bool wide) {
+    DCHECK_LT(*reg + (wide ? 1u : 0u), num_locals_);
+    if (!Map(reg, wide)) {
+      return false;
+    }
+    defined_[*reg - result_reg_] = true;
+    if (wide) {
+      defined_[*reg + 1u - result_reg_] = true;
+    }
+    return true;
+  }
+
+ private:
+  uint32_t Map(uint32_t reg) const {
+    return (reg < num_locals_) ? result_reg_ + reg : GetInvokeReg(invoke_, reg - num_locals_);
+  }
+
+  bool Map(uint32_t* reg, bool wide) const {
+    uint32_t caller_reg = Map(*reg);
+    if (wide && Map(*reg + 1u) != caller_reg + 1u) {
+      return false;  // The two halfs of the value are not in consecutive registers.
+    }
+    *reg = caller_reg;
+    return true;
+  }
+
+  bool IsDefined(uint32_t caller_reg) const {
+    uint32_t index = caller_reg - result_reg_;
+    return index < arraysize(defined_) && defined_[index];
+  }
+
+  MIR* const invoke_;
+  const uint32_t num_locals_;
+  const uint32_t result_reg_;
+  bool defined_[InlineMethodAnalyser::kMaxStraightLineLocals];
+};
+
 }  // anonymous namespace
 
 const uint32_t DexFileMethodInliner::kIndexUnresolved;
@@ -76,6 +137,9 @@ const char* const DexFileMethodInliner::kClassCacheNames[] = {
     "F",                       // kClassCacheFloat
     "D",                       // kClassCacheDouble
     "V",                       // kClassCacheVoid
+    "[B",                      // kClassCacheByteArray
+    "[C",                      // kClassCacheCharArray
+    "[I",                      // kClassCacheIntArray
     "Ljava/lang/Object;",      // kClassCacheJavaLangObject
     "Ljava/lang/String;",      // kClassCacheJavaLangString
     "Ljava/lang/Double;",      // kClassCacheJavaLangDouble
@@ -85,13 +149,16 @@ const char* const DexFileMethodInliner::kClassCacheNames[] = {
     "Ljava/lang/Short;",       // kClassCacheJavaLangShort
     "Ljava/lang/Math;",        // kClassCacheJavaLangMath
     "Ljava/lang/StrictMath;",  // kClassCacheJavaLangStrictMath
+    "Ljava/lang/System;",      // kClassCacheJavaLangSystem
     "Ljava/lang/Thread;",      // kClassCacheJavaLangThread
+    "Ljava/util/Arrays;",      // kClassCacheJavaUtilArrays
     "Llibcore/io/Memory;",     // kClassCacheLibcoreIoMemory
     "Lsun/misc/Unsafe;",       // kClassCacheSunMiscUnsafe
 };
 
 const char* const DexFileMethodInliner::kNameCacheNames[] = {
     "reverseBytes",          // kNameCacheReverseBytes
+    "bitCount",              // kNameCacheBitCount
     "doubleToRawLongBits",   // kNameCacheDoubleToRawLongBits
     "longBitsToDouble",      // kNameCacheLongBitsToDouble
     "floatToRawIntBits",     // kNameCacheFloatToRawIntBits
@@ -102,10 +169,13 @@ const char* const DexFileMethodInliner::kNameCacheNames[] = {
     "sqrt",                  // kNameCacheSqrt
     "charAt",                // kNameCacheCharAt
     "compareTo",             // kNameCacheCompareTo
+    "equals",                // kNameCacheEquals
     "isEmpty",               // kNameCacheIsEmpty
     "indexOf",               // kNameCacheIndexOf
     "length",                // kNameCacheLength
     "currentThread",         // kNameCacheCurrentThread
+    "arraycopy",             // kNameCacheArraycopy
+    "fill",                  // kNameCacheFill
     "peekByte",              // kNameCachePeekByte
     "peekIntNative",         // kNameCachePeekIntNative
     "peekLongNative",        // kNameCachePeekLongNative
@@ -155,10 +225,18 @@ const DexFileMethodInliner::ProtoDef DexFileMethodInliner::kProtoCacheDefs[] = {
     { kClassCacheFloat, 1, { kClassCacheInt } },
     // kProtoCacheII_I
     { kClassCacheInt, 2, { kClassCacheInt, kClassCacheInt } },
+    // kProtoCacheJJ_J
+    { kClassCacheLong, 2, { kClassCacheLong, kClassCacheLong } },
+    // kProtoCacheFF_F
+    { kClassCacheFloat, 2, { kClassCacheFloat, kClassCacheFloat } },
+    // kProtoCacheDD_D
+    { kClassCacheDouble, 2, { kClassCacheDouble, kClassCacheDouble } },
     // kProtoCacheI_C
     { kClassCacheChar, 1, { kClassCacheInt } },
     // kProtoCacheString_I
     { kClassCacheInt, 1, { kClassCacheJavaLangString } },
+    // kProtoCacheObject_Z
+    { kClassCacheBoolean, 1, { kClassCacheJavaLangObject } },
     // kProtoCache_Z
     { kClassCacheBoolean, 0, { } },
     // kProtoCache_I
@@ -201,6 +279,15 @@ const DexFileMethodInliner::ProtoDef DexFileMethodInliner::kProtoCacheDefs[] = {
     // kProtoCacheObjectJObject_V
     { kClassCacheVoid, 3, { kClassCacheJavaLangObject, kClassCacheLong,
         kClassCacheJavaLangObject } },
+    // kProtoCacheObjectIObjectII_V
+    { kClassCacheVoid, 5, { kClassCacheJavaLangObject, kClassCacheInt,
+        kClassCacheJavaLangObject, kClassCacheInt, kClassCacheInt } },
+    // kProtoCacheByteArrayB_V
+    { kClassCacheVoid, 2, { kClassCacheByteArray, kClassCacheByte } },
+    // kProtoCacheCharArrayC_V
+    { kClassCacheVoid, 2, { kClassCacheCharArray, kClassCacheChar } },
+    // kProtoCacheIntArrayI_V
+    { kClassCacheVoid, 2, { kClassCacheIntArray, kClassCacheInt } },
 };
 
 const DexFileMethodInliner::IntrinsicDef DexFileMethodInliner::kIntrinsicMethods[] = {
@@ -216,6 +303,9 @@ const DexFileMethodInliner::IntrinsicDef DexFileMethodInliner::kIntrinsicMethods
     INTRINSIC(JavaLangLong, ReverseBytes, J_J, kIntrinsicReverseBytes, k64),
     INTRINSIC(JavaLangShort, ReverseBytes, S_S, kIntrinsicReverseBytes, kSignedHalf),
 
+    INTRINSIC(JavaLangInteger, BitCount, I_I, kIntrinsicBitCount, k32),
+    INTRINSIC(JavaLangLong, BitCount, J_I, kIntrinsicBitCount, k64),
+
     INTRINSIC(JavaLangMath,       Abs, I_I, kIntrinsicAbsInt, 0),
     INTRINSIC(JavaLangStrictMath, Abs, I_I, kIntrinsicAbsInt, 0),
     INTRINSIC(JavaLangMath,       Abs, J_J, kIntrinsicAbsLong, 0),
@@ -228,11 +318,24 @@ const DexFileMethodInliner::IntrinsicDef DexFileMethodInliner::kIntrinsicMethods
     INTRINSIC(JavaLangStrictMath, Min, II_I, kIntrinsicMinMaxInt, kIntrinsicFlagMin),
     INTRINSIC(JavaLangMath,       Max, II_I, kIntrinsicMinMaxInt, kIntrinsicFlagMax),
     INTRINSIC(JavaLangStrictMath, Max, II_I, kIntrinsicMinMaxInt, kIntrinsicFlagMax),
+    INTRINSIC(JavaLangMath,       Min, JJ_J, kIntrinsicMinMaxLong, kIntrinsicFlagMin),
+    INTRINSIC(JavaLangStrictMath, Min, JJ_J, kIntrinsicMinMaxLong, kIntrinsicFlagMin),
+    INTRINSIC(JavaLangMath,       Max, JJ_J, kIntrinsicMinMaxLong, kIntrinsicFlagMax),
+    INTRINSIC(JavaLangStrictMath, Max, JJ_J, kIntrinsicMinMaxLong, kIntrinsicFlagMax),
+    INTRINSIC(JavaLangMath,       Min, FF_F, kIntrinsicMinMaxFloat, kIntrinsicFlagMin),
+    INTRINSIC(JavaLangStrictMath, Min, FF_F, kIntrinsicMinMaxFloat, kIntrinsicFlagMin),
+    INTRINSIC(JavaLangMath,       Max, FF_F, kIntrinsicMinMaxFloat, kIntrinsicFlagMax),
+    INTRINSIC(JavaLangStrictMath, Max, FF_F, kIntrinsicMinMaxFloat, kIntrinsicFlagMax),
+    INTRINSIC(JavaLangMath,       Min, DD_D, kIntrinsicMinMaxDouble, kIntrinsicFlagMin),
+    INTRINSIC(JavaLangStrictMath, Min, DD_D, kIntrinsicMinMaxDouble, kIntrinsicFlagMin),
+    INTRINSIC(JavaLangMath,       Max, DD_D, kIntrinsicMinMaxDouble, kIntrinsicFlagMax),
+    INTRINSIC(JavaLangStrictMath, Max, DD_D, kIntrinsicMinMaxDouble, kIntrinsicFlagMax),
     INTRINSIC(JavaLangMath,       Sqrt, D_D, kIntrinsicSqrt, 0),
     INTRINSIC(JavaLangStrictMath, Sqrt, D_D, kIntrinsicSqrt, 0),
 
     INTRINSIC(JavaLangString, CharAt, I_C, kIntrinsicCharAt, 0),
     INTRINSIC(JavaLangString, CompareTo, String_I, kIntrinsicCompareTo, 0),
+    INTRINSIC(JavaLangString, Equals, Object_Z, kIntrinsicEquals, 0),
     INTRINSIC(JavaLangString, IsEmpty, _Z, kIntrinsicIsEmptyOrLength, kIntrinsicFlagIsEmpty),
     INTRINSIC(JavaLangString, IndexOf, II_I, kIntrinsicIndexOf, kIntrinsicFlagNone),
     INTRINSIC(JavaLangString, IndexOf, I_I, kIntrinsicIndexOf, kIntrinsicFlagBase0),
@@ -240,6 +343,12 @@ const DexFileMethodInliner::IntrinsicDef DexFileMethodInliner::kIntrinsicMethods
 
     INTRINSIC(JavaLangThread, CurrentThread, _Thread, kIntrinsicCurrentThread, 0),
 
+    INTRINSIC(JavaLangSystem, Arraycopy, ObjectIObjectII_V, kIntrinsicSystemArrayCopy, 0),
+
+    INTRINSIC(JavaUtilArrays, Fill, ByteArrayB_V, kIntrinsicArraysFill, kUnsignedByte),
+    INTRINSIC(JavaUtilArrays, Fill, CharArrayC_V, kIntrinsicArraysFill, kUnsignedHalf),
+    INTRINSIC(JavaUtilArrays, Fill, IntArrayI_V, kIntrinsicArraysFill, k32),
+
     INTRINSIC(LibcoreIoMemory, PeekByte, J_B, kIntrinsicPeek, kSignedByte),
     INTRINSIC(LibcoreIoMemory, PeekIntNative, J_I, kIntrinsicPeek, k32),
     INTRINSIC(LibcoreIoMemory, PeekLongNative, J_J, kIntrinsicPeek, k64),
@@ -319,6 +428,8 @@ bool DexFileMethodInliner::GenIntrinsic(Mir2Lir* backend, CallInfo* info) {
       return backend->GenInlinedFloatCvt(info);
     case kIntrinsicReverseBytes:
       return backend->GenInlinedReverseBytes(info, static_cast<OpSize>(intrinsic.d.data));
+    case kIntrinsicBitCount:
+      return backend->GenInlinedBitCount(info, static_cast<OpSize>(intrinsic.d.data));
     case kIntrinsicAbsInt:
       return backend->GenInlinedAbsInt(info);
     case kIntrinsicAbsLong:
@@ -329,12 +440,20 @@ bool DexFileMethodInliner::GenIntrinsic(Mir2Lir* backend, CallInfo* info) {
       return backend->GenInlinedAbsDouble(info);
     case kIntrinsicMinMaxInt:
       return backend->GenInlinedMinMaxInt(info, intrinsic.d.data & kIntrinsicFlagMin);
+    case kIntrinsicMinMaxLong:
+      return backend->GenInlinedMinMaxLong(info, intrinsic.d.data & kIntrinsicFlagMin);
+    case kIntrinsicMinMaxFloat:
+      return backend->GenInlinedMinMaxFP(info, intrinsic.d.data & kIntrinsicFlagMin, false);
+    case kIntrinsicMinMaxDouble:
+      return backend->GenInlinedMinMaxFP(info, intrinsic.d.data & kIntrinsicFlagMin, true);
     case kIntrinsicSqrt:
       return backend->GenInlinedSqrt(info);
     case kIntrinsicCharAt:
       return backend->GenInlinedCharAt(info);
     case kIntrinsicCompareTo:
       return backend->GenInlinedStringCompareTo(info);
+    case kIntrinsicEquals:
+      return backend->GenInlinedStringEquals(info);
     case kIntrinsicIsEmptyOrLength:
       return backend->GenInlinedStringIsEmptyOrLength(
           info, intrinsic.d.data & kIntrinsicFlagIsEmpty);
@@ -357,6 +476,10 @@ bool DexFileMethodInliner::GenIntrinsic(Mir2Lir* backend, CallInfo* info) {
                                           intrinsic.d.data & kIntrinsicFlagIsObject,
                                           intrinsic.d.data & kIntrinsicFlagIsVolatile,
                                           intrinsic.d.data & kIntrinsicFlagIsOrdered);
+    case kIntrinsicSystemArrayCopy:
+      return backend->GenInlinedArrayCopy(info);
+    case kIntrinsicArraysFill:
+      return backend->GenInlinedArraysFill(info, static_cast<OpSize>(intrinsic.d.data));
     default:
       LOG(FATAL) << "Unexpected intrinsic opcode: " << intrinsic.opcode;
       return false;  // avoid warning "control reaches end of non-void function"
@@ -388,7 +511,7 @@ bool DexFileMethodInliner::GenInline(MIRGraph* mir_graph, BasicBlock* bb, MIR* i
   {
     ReaderMutexLock mu(Thread::Current(), lock_);
     auto it = inline_methods_.find(method_idx);
-    if (it == inline_methods_.end() || (it->second.flags & kInlineSpecial) == 0) {
+    if (it == inline_methods_.end() || (it->second.flags & (kInlineSpecial | kInlineBody)) == 0) {
       return false;
     }
     method = it->second;
@@ -415,6 +538,15 @@ bool DexFileMethodInliner::GenInline(MIRGraph* mir_graph, BasicBlock* bb, MIR* i
       move_result = mir_graph->FindMoveResult(bb, invoke);
       result = GenInlineIPut(mir_graph, bb, invoke, move_result, method, method_idx);
       break;
+    case kInlineOpSGet:
+    case kInlineOpSPut:
+      // Only compiled without a frame, the caller may need to initialize the class.
+      result = false;
+      break;
+    case kInlineOpStraightLine:
+      move_result = mir_graph->FindMoveResult(bb, invoke);
+      result = GenInlineStraightLine(mir_graph, bb, invoke, move_result, method, dex_file_);
+      break;
     default:
       LOG(FATAL) << "Unexpected inline op: " << method.opcode;
   }
@@ -555,7 +687,9 @@ bool DexFileMethodInliner::AddInlineMethod(int32_t method_idx, const InlineMetho
     inline_methods_.Put(method_idx, method);
     return true;
   } else {
-    if (PrettyMethod(method_idx, *dex_file_) == "int java.lang.String.length()") {
+    if ((method.flags & kInlineBody) != 0) {
+      // Keep the intrinsic, it is better than the copy of a straight-line method.
+    } else if (PrettyMethod(method_idx, *dex_file_) == "int java.lang.String.length()") {
       // TODO: String.length is both kIntrinsicIsEmptyOrLength and kInlineOpIGet.
     } else {
       LOG(ERROR) << "Inliner: " << PrettyMethod(method_idx, *dex_file_) << " already inline";
@@ -649,7 +783,7 @@ bool DexFileMethodInliner::GenInlineIGet(MIRGraph* mir_graph, BasicBlock* bb, MI
     // TODO: Implement inlining of IGET on non-"this" registers (needs correct stack trace for NPE).
     // Allow synthetic accessors. We don't care about losing their stack frame in NPE.
     if (!InlineMethodAnalyser::IsSyntheticAccessor(
-        mir_graph->GetMethodLoweringInfo(invoke).GetTargetMethod())) {
+        mir_graph->GetMethodLoweringInfo(invoke).GetInlineTargetMethod())) {
       return false;
     }
   }
@@ -712,7 +846,7 @@ bool DexFileMethodInliner::GenInlineIPut(MIRGraph* mir_graph, BasicBlock* bb, MI
     // TODO: Implement inlining of IPUT on non-"this" registers (needs correct stack trace for NPE).
     // Allow synthetic accessors. We don't care about losing their stack frame in NPE.
     if (!InlineMethodAnalyser::IsSyntheticAccessor(
-        mir_graph->GetMethodLoweringInfo(invoke).GetTargetMethod())) {
+        mir_graph->GetMethodLoweringInfo(invoke).GetInlineTargetMethod())) {
       return false;
     }
   }
@@ -755,4 +889,94 @@ bool DexFileMethodInliner::GenInlineIPut(MIRGraph* mir_graph, BasicBlock* bb, MI
   return true;
 }
 
+bool DexFileMethodInliner::GenInlineStraightLine(MIRGraph* mir_graph, BasicBlock* bb,
+                                                 MIR* invoke, MIR* move_result,
+                                                 const InlineMethod& method,
+                                                 const DexFile* dex_file) {
+  if (move_result == nullptr) {
+    // Result is unused and the code has no side effects.
+    return true;
+  }
+
+  const InlineStraightLineData& data = method.d.straight_line_data;
+  if (data.insns_size > mir_graph->GetMaxInlinedCodeUnits()) {
+    return false;
+  }
+  const DexFile::CodeItem* code_item = dex_file->GetCodeItem(data.code_item_offset);
+  uint32_t num_locals = code_item->registers_size_ - code_item->ins_size_;
+  bool result_is_wide = (move_result->dalvikInsn.opcode == Instruction::MOVE_RESULT_WIDE);
+  if (num_locals > (result_is_wide ? 2u : 1u)) {
+    // The registers receiving the result cannot hold all the values of the method.
+    return false;
+  }
+  uint32_t result_reg = move_result->dalvikInsn.vA;
+  StraightLineRegisterMap registers(invoke, num_locals, result_reg);
+
+  // Rewrite all the instructions before changing the graph, as any may fail.
+  MIR::DecodedInstruction insns[InlineMethodAnalyser::kMaxStraightLineCodeUnits];
+  size_t num_insns = 0u;
+  const Instruction* instruction = Instruction::At(code_item->insns_);
+  for (; !instruction->IsReturn(); instruction = instruction->Next()) {
+    DCHECK(InlineMethodAnalyser::IsStraightLineInstruction(instruction->Opcode()));
+    DCHECK_LT(num_insns, arraysize(insns));
+    MIR::DecodedInstruction* insn = &insns[num_insns++];
+    *insn = MIR::DecodedInstruction();
+    insn->opcode = instruction->Opcode();
+    insn->vA = instruction->VRegA();
+    insn->vB = instruction->HasVRegB() ? instruction->VRegB() : 0;
+    insn->vB_wide = instruction->HasWideVRegB() ? instruction->WideVRegB() : 0;
+    insn->vC = instruction->HasVRegC() ? instruction->VRegC() : 0;
+
+    uint64_t df_attributes = MIRGraph::GetDataFlowAttributes(insn->opcode);
+    if ((df_attributes & DF_UB) != 0 &&
+        !registers.MapUse(&insn->vB, (df_attributes & DF_B_WIDE) != 0)) {
+      return false;
+    }
+    if ((df_attributes & DF_UC) != 0 &&
+        !registers.MapUse(&insn->vC, (df_attributes & DF_C_WIDE) != 0)) {
+      return false;
+    }
+    bool a_is_wide = (df_attributes & DF_A_WIDE) != 0;
+    uint32_t use_a = insn->vA;
+    if ((df_attributes & DF_UA) != 0 && !registers.MapUse(&use_a, a_is_wide)) {
+      return false;
+    }
+    DCHECK_NE(df_attributes & DF_DA, 0u);
+    if (!registers.MapDef(&insn->vA, a_is_wide)) {
+      return false;
+    }
+  }
+
+  // Move the returned value to the registers receiving the result if it is not there.
+  Instruction::Code return_opcode = instruction->Opcode();
+  DCHECK_NE(return_opcode, Instruction::RETURN_VOID);
+  uint32_t return_reg = instruction->VRegA_11x();
+  if (!registers.MapUse(&return_reg, return_opcode == Instruction::RETURN_WIDE)) {
+    return false;
+  }
+
+  MIR* last = move_result;
+  for (size_t i = 0u; i != num_insns; ++i) {
+    MIR* insn = AllocReplacementMIR(mir_graph, invoke, move_result);
+    insn->dalvikInsn = insns[i];
+    bb->InsertMIRAfter(last, insn);
+    last = insn;
+  }
+  if (return_reg != result_reg) {
+    MIR* move = AllocReplacementMIR(mir_graph, invoke, move_result);
+    if (return_opcode == Instruction::RETURN_OBJECT) {
+      move->dalvikInsn.opcode = Instruction::MOVE_OBJECT_FROM16;
+    } else if (return_opcode == Instruction::RETURN_WIDE) {
+      move->dalvikInsn.opcode = Instruction::MOVE_WIDE_FROM16;
+    } else {
+      DCHECK_EQ(return_opcode, Instruction::RETURN);
+      move->dalvikInsn.opcode = Instruction::MOVE_FROM16;
+    }
+    move->dalvikInsn.vA = result_reg;
+    move->dalvikInsn.vB = return_reg;
+    bb->InsertMIRAfter(last, move);
+  }
+  return true;
+}
+
 }  // namespace art
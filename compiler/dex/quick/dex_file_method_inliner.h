@@ -106,6 +106,9 @@ class DexFileMethodInliner {
       kClassCacheFloat,
       kClassCacheDouble,
       kClassCacheVoid,
+      kClassCacheByteArray,
+      kClassCacheCharArray,
+      kClassCacheIntArray,
       kClassCacheJavaLangObject,
       kClassCacheJavaLangString,
       kClassCacheJavaLangDouble,
@@ -115,7 +118,9 @@ class DexFileMethodInliner {
       kClassCacheJavaLangShort,
       kClassCacheJavaLangMath,
       kClassCacheJavaLangStrictMath,
+      kClassCacheJavaLangSystem,
       kClassCacheJavaLangThread,
+      kClassCacheJavaUtilArrays,
       kClassCacheLibcoreIoMemory,
       kClassCacheSunMiscUnsafe,
       kClassCacheLast
@@ -129,6 +134,7 @@ class DexFileMethodInliner {
     enum NameCacheIndex : uint8_t {  // unit8_t to save space, make larger if needed
       kNameCacheFirst = 0,
       kNameCacheReverseBytes = kNameCacheFirst,
+      kNameCacheBitCount,
       kNameCacheDoubleToRawLongBits,
       kNameCacheLongBitsToDouble,
       kNameCacheFloatToRawIntBits,
@@ -139,10 +145,13 @@ class DexFileMethodInliner {
       kNameCacheSqrt,
       kNameCacheCharAt,
       kNameCacheCompareTo,
+      kNameCacheEquals,
       kNameCacheIsEmpty,
       kNameCacheIndexOf,
       kNameCacheLength,
       kNameCacheCurrentThread,
+      kNameCacheArraycopy,
+      kNameCacheFill,
       kNameCachePeekByte,
       kNameCachePeekIntNative,
       kNameCachePeekLongNative,
@@ -189,8 +198,12 @@ class DexFileMethodInliner {
       kProtoCacheF_I,
       kProtoCacheI_F,
       kProtoCacheII_I,
+      kProtoCacheJJ_J,
+      kProtoCacheFF_F,
+      kProtoCacheDD_D,
       kProtoCacheI_C,
       kProtoCacheString_I,
+      kProtoCacheObject_Z,
       kProtoCache_Z,
       kProtoCache_I,
       kProtoCache_Thread,
@@ -210,6 +223,10 @@ class DexFileMethodInliner {
       kProtoCacheObjectJJ_V,
       kProtoCacheObjectJ_Object,
       kProtoCacheObjectJObject_V,
+      kProtoCacheObjectIObjectII_V,
+      kProtoCacheByteArrayB_V,
+      kProtoCacheCharArrayC_V,
+      kProtoCacheIntArrayI_V,
       kProtoCacheLast
     };
 
@@ -303,6 +320,9 @@ class DexFileMethodInliner {
                               MIR* move_result, const InlineMethod& method, uint32_t method_idx);
     static bool GenInlineIPut(MIRGraph* mir_graph, BasicBlock* bb, MIR* invoke,
                               MIR* move_result, const InlineMethod& method, uint32_t method_idx);
+    static bool GenInlineStraightLine(MIRGraph* mir_graph, BasicBlock* bb, MIR* invoke,
+                                      MIR* move_result, const InlineMethod& method,
+                                      const DexFile* dex_file);
 
     ReaderWriterMutex lock_;
     /*
@@ -17,6 +17,7 @@
 #include "dex/compiler_internals.h"
 #include "dex/quick/arm/arm_lir.h"
 #include "dex/quick/mir_to_lir-inl.h"
+#include "driver/compiler_options.h"
 #include "entrypoints/quick/quick_entrypoints.h"
 #include "mirror/array.h"
 #include "mirror/object_array-inl.h"
@@ -63,25 +64,56 @@ void Mir2Lir::GenDivZeroCheck(RegStorage reg) {
 }
 
 void Mir2Lir::AddDivZeroCheckSlowPath(LIR* branch) {
-  class DivZeroCheckSlowPath : public Mir2Lir::LIRSlowPath {
-   public:
-    DivZeroCheckSlowPath(Mir2Lir* m2l, LIR* branch)
-        : LIRSlowPath(m2l, m2l->GetCurrentDexPc(), branch) {
-    }
+  AddThrowSlowPath(branch, ThrowSlowPath::kDivZero);
+}
 
-    void Compile() OVERRIDE {
-      m2l_->ResetRegPool();
-      m2l_->ResetDefTracking();
-      GenerateTargetLabel(kPseudoThrowTarget);
-      if (Is64BitInstructionSet(m2l_->cu_->instruction_set)) {
-        m2l_->CallRuntimeHelper(QUICK_ENTRYPOINT_OFFSET(8, pThrowDivZero), true);
-      } else {
-        m2l_->CallRuntimeHelper(QUICK_ENTRYPOINT_OFFSET(4, pThrowDivZero), true);
-      }
+void Mir2Lir::ThrowSlowPath::AddBranch(LIR* branch) {
+  if (label_ != nullptr) {
+    branch->target = label_;
+  } else {
+    shared_branches_.Insert(branch);
+  }
+}
+
+void Mir2Lir::ThrowSlowPath::Compile() {
+  m2l_->ResetRegPool();
+  m2l_->ResetDefTracking();
+  label_ = GenerateTargetLabel(kPseudoThrowTarget);
+  GrowableArray<LIR*>::Iterator iter(&shared_branches_);
+  for (LIR* branch = iter.Next(); branch != nullptr; branch = iter.Next()) {
+    branch->target = label_;
+  }
+  bool is_64bit = Is64BitInstructionSet(cu_->instruction_set);
+  if (kind_ == kNullPointer) {
+    if (is_64bit) {
+      m2l_->CallRuntimeHelper(QUICK_ENTRYPOINT_OFFSET(8, pThrowNullPointer), true);
+    } else {
+      m2l_->CallRuntimeHelper(QUICK_ENTRYPOINT_OFFSET(4, pThrowNullPointer), true);
     }
-  };
+  } else {
+    DCHECK_EQ(kind_, kDivZero);
+    if (is_64bit) {
+      m2l_->CallRuntimeHelper(QUICK_ENTRYPOINT_OFFSET(8, pThrowDivZero), true);
+    } else {
+      m2l_->CallRuntimeHelper(QUICK_ENTRYPOINT_OFFSET(4, pThrowDivZero), true);
+    }
+  }
+}
 
-  AddSlowPath(new (arena_) DivZeroCheckSlowPath(this, branch));
+/*
+ * The throw slow path of a check. The safepoint of its call maps to the dex pc of the check,
+ * which the runtime uses to find the catch handler, the line number and, for a null pointer,
+ * the message of the exception; so only the checks of one instruction can share it.
+ */
+void Mir2Lir::AddThrowSlowPath(LIR* branch, ThrowSlowPath::Kind kind) {
+  ThrowSlowPath* slow_path = last_throw_slow_paths_[kind];
+  if (slow_path != nullptr && slow_path->GetDexPc() == GetCurrentDexPc()) {
+    slow_path->AddBranch(branch);
+    return;
+  }
+  slow_path = new (arena_) ThrowSlowPath(this, branch, kind);
+  AddSlowPath(slow_path);
+  last_throw_slow_paths_[kind] = slow_path;
 }
 
 void Mir2Lir::GenArrayBoundsCheck(RegStorage index, RegStorage length) {
@@ -148,26 +180,8 @@ void Mir2Lir::GenArrayBoundsCheck(int index, RegStorage length) {
 }
 
 LIR* Mir2Lir::GenNullCheck(RegStorage reg) {
-  class NullCheckSlowPath : public Mir2Lir::LIRSlowPath {
-   public:
-    NullCheckSlowPath(Mir2Lir* m2l, LIR* branch)
-        : LIRSlowPath(m2l, m2l->GetCurrentDexPc(), branch) {
-    }
-
-    void Compile() OVERRIDE {
-      m2l_->ResetRegPool();
-      m2l_->ResetDefTracking();
-      GenerateTargetLabel(kPseudoThrowTarget);
-      if (Is64BitInstructionSet(m2l_->cu_->instruction_set)) {
-        m2l_->CallRuntimeHelper(QUICK_ENTRYPOINT_OFFSET(8, pThrowNullPointer), true);
-      } else {
-        m2l_->CallRuntimeHelper(QUICK_ENTRYPOINT_OFFSET(4, pThrowNullPointer), true);
-      }
-    }
-  };
-
   LIR* branch = OpCmpImmBranch(kCondEq, reg, 0, nullptr);
-  AddSlowPath(new (arena_) NullCheckSlowPath(this, branch));
+  AddThrowSlowPath(branch, ThrowSlowPath::kNullPointer);
   return branch;
 }
 
@@ -299,6 +313,132 @@ void Mir2Lir::GenCompareZeroAndBranch(Instruction::Code opcode, RegLocation rl_s
   OpCmpImmBranch(cond, rl_src.reg, 0, taken);
 }
 
+// Sparse switches with fewer cases keep the target's linear search.
+static constexpr size_t kMinSwitchSearchCases = 8u;
+// Runs of at least kMinJumpTableCases cases, covering at least kMinJumpTableDensity percent
+// of their key range, are dispatched through a jump table.
+static constexpr size_t kMinJumpTableCases = 4u;
+static constexpr int64_t kMinJumpTableDensity = 40;
+static constexpr int64_t kMaxJumpTableSize = 4096;
+// The most clusters compared one after the other at a leaf of the binary search.
+static constexpr size_t kMaxSwitchLeafClusters = 3u;
+
+static bool IsDenseSwitchRange(int32_t first_key, int32_t last_key, size_t num_cases) {
+  int64_t range = static_cast<int64_t>(last_key) - first_key + 1;
+  return range <= kMaxJumpTableSize &&
+      static_cast<int64_t>(num_cases) * 100 >= range * kMinJumpTableDensity;
+}
+
+/*
+ * Lower a packed or sparse switch. The cases which don't branch to the fall through are
+ * grouped in clusters, dense runs of keys dispatched through a jump table of their own and
+ * single keys, and the clusters are found by a binary search on their first key. A dense
+ * packed switch keeps its single jump table and a small sparse switch the target's linear
+ * search.
+ */
+void Mir2Lir::GenSwitch(MIR* mir, BasicBlock* bb, const uint16_t* table, RegLocation rl_src) {
+  const bool is_packed = (table[0] == Instruction::kPackedSwitchSignature);
+  const int entries = table[1];
+  const int32_t default_target =
+      static_cast<int32_t>(mir_graph_->GetBasicBlock(bb->fall_through)->start_offset) -
+      static_cast<int32_t>(current_dalvik_offset_);
+  std::vector<std::pair<int32_t, int32_t>> cases;  // Sorted keys, with their targets.
+  if (is_packed) {
+    int32_t low_key = s4FromSwitchData(&table[2]);
+    const int32_t* targets = reinterpret_cast<const int32_t*>(&table[4]);
+    for (int i = 0; i < entries; i++) {
+      if (targets[i] != default_target) {
+        cases.push_back(std::make_pair(low_key + i, targets[i]));
+      }
+    }
+  } else {
+    if (static_cast<size_t>(entries) < kMinSwitchSearchCases) {
+      GenSparseSwitch(mir, table, rl_src);
+      return;
+    }
+    const int32_t* keys = reinterpret_cast<const int32_t*>(&table[2]);
+    const int32_t* targets = &keys[entries];
+    for (int i = 0; i < entries; i++) {
+      if (targets[i] != default_target) {
+        cases.push_back(std::make_pair(keys[i], targets[i]));
+      }
+    }
+  }
+
+  std::vector<SwitchCluster> clusters;
+  for (size_t i = 0; i != cases.size(); ) {
+    size_t end = i + 1;
+    while (end != cases.size() && IsDenseSwitchRange(cases[i].first, cases[end].first,
+                                                     end + 1 - i)) {
+      ++end;
+    }
+    if (end - i < kMinJumpTableCases) {
+      SwitchCluster cluster = { cases[i].first, cases[i].second, nullptr };
+      clusters.push_back(cluster);
+      ++i;
+      continue;
+    }
+    if (is_packed && i == 0 && end == cases.size()) {
+      GenPackedSwitch(mir, table, rl_src);
+      return;
+    }
+    // A packed switch payload for the run, whose gaps branch to the fall through.
+    int32_t size = cases[end - 1].first - cases[i].first + 1;
+    uint16_t* payload = static_cast<uint16_t*>(
+        arena_->Alloc((4 + 2 * size) * sizeof(uint16_t), kArenaAllocData));
+    payload[0] = Instruction::kPackedSwitchSignature;
+    payload[1] = static_cast<uint16_t>(size);
+    payload[2] = static_cast<uint16_t>(cases[i].first);
+    payload[3] = static_cast<uint16_t>(static_cast<uint32_t>(cases[i].first) >> 16);
+    int32_t* targets = reinterpret_cast<int32_t*>(&payload[4]);
+    std::fill_n(targets, size, default_target);
+    for (size_t j = i; j != end; ++j) {
+      targets[cases[j].first - cases[i].first] = cases[j].second;
+    }
+    SwitchCluster cluster = { cases[i].first, 0, payload };
+    clusters.push_back(cluster);
+    i = end;
+  }
+  rl_src = LoadValue(rl_src, kCoreReg);
+  GenSwitchClusters(mir, clusters.data(), clusters.size(), rl_src,
+                    &block_label_list_[bb->fall_through]);
+}
+
+void Mir2Lir::GenSwitchClusters(MIR* mir, const SwitchCluster* clusters, size_t count,
+                                RegLocation rl_src, LIR* default_label) {
+  if (count > kMaxSwitchLeafClusters) {
+    size_t mid = count / 2;
+    LIR* branch_low = OpCmpImmBranch(kCondLt, rl_src.reg, clusters[mid].first_key, nullptr);
+    GenSwitchClusters(mir, clusters + mid, count - mid, rl_src, default_label);
+    branch_low->target = NewLIR0(kPseudoTargetLabel);
+    GenSwitchClusters(mir, clusters, mid, rl_src, default_label);
+    return;
+  }
+  for (size_t i = 0; i != count; ++i) {
+    const SwitchCluster& cluster = clusters[i];
+    if (cluster.table == nullptr) {
+      BasicBlock* case_block = mir_graph_->FindBlock(current_dalvik_offset_ + cluster.target);
+      OpCmpImmBranch(kCondEq, rl_src.reg, cluster.first_key, &block_label_list_[case_block->id]);
+      continue;
+    }
+    // The targets keep the temps of a jump table, free them for the next one.
+    std::vector<bool> was_in_use;
+    GrowableArray<RegisterInfo*>::Iterator iter(&tempreg_info_);
+    for (RegisterInfo* info = iter.Next(); info != nullptr; info = iter.Next()) {
+      was_in_use.push_back(info->InUse());
+    }
+    // Keys out of the table's range fall through to the next cluster.
+    GenPackedSwitch(mir, cluster.table, rl_src);
+    for (size_t j = 0; j != was_in_use.size(); ++j) {
+      RegisterInfo* info = tempreg_info_.Get(j);
+      if (!was_in_use[j] && info->InUse()) {
+        FreeTemp(info->GetReg());
+      }
+    }
+  }
+  OpUnconditionalBranch(default_label);
+}
+
 void Mir2Lir::GenIntToLong(RegLocation rl_dest, RegLocation rl_src) {
   RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
   if (rl_src.location == kLocPhysReg) {
@@ -568,6 +708,10 @@ void Mir2Lir::GenSput(MIR* mir, RegLocation rl_src, bool is_long_or_double,
       if (IsTemp(rl_method.reg)) {
         FreeTemp(rl_method.reg);
       }
+    } else if (field_info.DirectStoragePtr() != 0u) {
+      // Fast path, static storage base is an initialized class of the boot image.
+      r_base = AllocTemp();
+      LoadConstant(r_base, static_cast<int>(field_info.DirectStoragePtr()));
     } else {
       // Medium path, static storage base in a different class which requires checks that the other
       // class is initialized.
@@ -614,11 +758,15 @@ void Mir2Lir::GenSput(MIR* mir, RegLocation rl_src, bool is_long_or_double,
       rl_src = LoadValue(rl_src, reg_class);
     }
     if (field_info.IsVolatile()) {
-      // There might have been a store before this volatile one so insert StoreStore barrier.
-      GenMemBarrier(kStoreStore);
+      if (!VolatileLoadStoreIsAcquireRelease(store_size)) {
+        // There might have been a store before this volatile one so insert StoreStore barrier.
+        GenMemBarrier(kStoreStore);
+      }
       StoreBaseDispVolatile(r_base, field_info.FieldOffset().Int32Value(), rl_src.reg, store_size);
-      // A load might follow the volatile store so insert a StoreLoad barrier.
-      GenMemBarrier(kStoreLoad);
+      if (!VolatileLoadStoreIsAcquireRelease(store_size)) {
+        // A load might follow the volatile store so insert a StoreLoad barrier.
+        GenMemBarrier(kStoreLoad);
+      }
     } else {
       StoreBaseDisp(r_base, field_info.FieldOffset().Int32Value(), rl_src.reg, store_size);
     }
@@ -660,6 +808,10 @@ void Mir2Lir::GenSget(MIR* mir, RegLocation rl_dest,
       RegLocation rl_method  = LoadCurrMethod();
       r_base = AllocTemp();
       LoadRefDisp(rl_method.reg, mirror::ArtMethod::DeclaringClassOffset().Int32Value(), r_base);
+    } else if (field_info.DirectStoragePtr() != 0u) {
+      // Fast path, static storage base is an initialized class of the boot image.
+      r_base = AllocTemp();
+      LoadConstant(r_base, static_cast<int>(field_info.DirectStoragePtr()));
     } else {
       // Medium path, static storage base in a different class which requires checks that the other
       // class is initialized
@@ -704,10 +856,12 @@ void Mir2Lir::GenSget(MIR* mir, RegLocation rl_dest,
     int field_offset = field_info.FieldOffset().Int32Value();
     if (field_info.IsVolatile()) {
       LoadBaseDispVolatile(r_base, field_offset, rl_result.reg, load_size);
-      // Without context sensitive analysis, we must issue the most conservative barriers.
-      // In this case, either a load or store may follow so we issue both barriers.
-      GenMemBarrier(kLoadLoad);
-      GenMemBarrier(kLoadStore);
+      if (!VolatileLoadStoreIsAcquireRelease(load_size)) {
+        // Without context sensitive analysis, we must issue the most conservative barriers.
+        // In this case, either a load or store may follow so we issue both barriers.
+        GenMemBarrier(kLoadLoad);
+        GenMemBarrier(kLoadStore);
+      }
     } else {
       LoadBaseDisp(r_base, field_offset, rl_result.reg, load_size);
     }
@@ -773,10 +927,12 @@ void Mir2Lir::GenIGet(MIR* mir, int opt_flags, OpSize size,
     if (field_info.IsVolatile()) {
       LoadBaseDispVolatile(rl_obj.reg, field_offset, rl_result.reg, load_size);
       MarkPossibleNullPointerException(opt_flags);
-      // Without context sensitive analysis, we must issue the most conservative barriers.
-      // In this case, either a load or store may follow so we issue both barriers.
-      GenMemBarrier(kLoadLoad);
-      GenMemBarrier(kLoadStore);
+      if (!VolatileLoadStoreIsAcquireRelease(load_size)) {
+        // Without context sensitive analysis, we must issue the most conservative barriers.
+        // In this case, either a load or store may follow so we issue both barriers.
+        GenMemBarrier(kLoadLoad);
+        GenMemBarrier(kLoadStore);
+      }
     } else {
       LoadBaseDisp(rl_obj.reg, field_offset, rl_result.reg, load_size);
       MarkPossibleNullPointerException(opt_flags);
@@ -833,12 +989,16 @@ void Mir2Lir::GenIPut(MIR* mir, int opt_flags, OpSize size,
     GenNullCheck(rl_obj.reg, opt_flags);
     int field_offset = field_info.FieldOffset().Int32Value();
     if (field_info.IsVolatile()) {
-      // There might have been a store before this volatile one so insert StoreStore barrier.
-      GenMemBarrier(kStoreStore);
+      if (!VolatileLoadStoreIsAcquireRelease(store_size)) {
+        // There might have been a store before this volatile one so insert StoreStore barrier.
+        GenMemBarrier(kStoreStore);
+      }
       StoreBaseDispVolatile(rl_obj.reg, field_offset, rl_src.reg, store_size);
       MarkPossibleNullPointerException(opt_flags);
-      // A load might follow the volatile store so insert a StoreLoad barrier.
-      GenMemBarrier(kStoreLoad);
+      if (!VolatileLoadStoreIsAcquireRelease(store_size)) {
+        // A load might follow the volatile store so insert a StoreLoad barrier.
+        GenMemBarrier(kStoreLoad);
+      }
     } else {
       StoreBaseDisp(rl_obj.reg, field_offset, rl_src.reg, store_size);
       MarkPossibleNullPointerException(opt_flags);
@@ -882,6 +1042,10 @@ void Mir2Lir::GenConstClass(uint32_t type_idx, RegLocation rl_dest) {
   RegLocation rl_method = LoadCurrMethod();
   RegStorage res_reg = AllocTemp();
   RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
+  bool is_type_initialized;
+  bool use_direct_type_ptr;
+  uintptr_t direct_type_ptr;
+  bool is_finalizable;
   if (!cu_->compiler_driver->CanAccessTypeWithoutChecks(cu_->method_idx,
                                                    *cu_->dex_file,
                                                    type_idx)) {
@@ -896,6 +1060,14 @@ void Mir2Lir::GenConstClass(uint32_t type_idx, RegLocation rl_dest) {
     }
     RegLocation rl_result = GetReturn(false);
     StoreValue(rl_dest, rl_result);
+  } else if (!SLOW_TYPE_PATH &&
+             cu_->compiler_driver->CanEmbedTypeInCode(*cu_->dex_file, type_idx,
+                                                      &is_type_initialized, &use_direct_type_ptr,
+                                                      &direct_type_ptr, &is_finalizable) &&
+             use_direct_type_ptr) {
+    // The class is in the boot image, at a fixed address.
+    LoadConstant(rl_result.reg, static_cast<int>(direct_type_ptr));
+    StoreValue(rl_dest, rl_result);
   } else {
     // We're don't need access checks, load type from dex cache
     int32_t dex_cache_offset =
@@ -955,7 +1127,14 @@ void Mir2Lir::GenConstString(uint32_t string_idx, RegLocation rl_dest) {
   /* NOTE: Most strings should be available at compile time */
   int32_t offset_of_string = mirror::ObjectArray<mirror::String>::OffsetOfElement(string_idx).
                                                                                       Int32Value();
-  if (!cu_->compiler_driver->CanAssumeStringIsPresentInDexCache(
+  uintptr_t direct_string_ptr;
+  if (!SLOW_STRING_PATH &&
+      cu_->compiler_driver->CanEmbedStringInCode(*cu_->dex_file, string_idx, &direct_string_ptr)) {
+    // The string is in the boot image, at a fixed address.
+    RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
+    LoadConstant(rl_result.reg, static_cast<int>(direct_string_ptr));
+    StoreValue(rl_dest, rl_result);
+  } else if (!cu_->compiler_driver->CanAssumeStringIsPresentInDexCache(
       *cu_->dex_file, string_idx) || SLOW_STRING_PATH) {
     // slow path, resolve string if not in dex cache
     FlushAllRegs();
@@ -2203,6 +2382,25 @@ void Mir2Lir::GenMonitorExit(int opt_flags, RegLocation rl_src) {
   }
 }
 
+/*
+ * The card table base is biased so that its low byte is the dirty card value. With conditional
+ * card marks the card is read first, and not written when it is already dirty: cores storing to
+ * objects covered by the same cache line of cards then don't take the line from each other.
+ */
+void Mir2Lir::StoreGCCard(RegStorage reg_card_base, RegStorage reg_card_no) {
+  LIR* branch_dirty = nullptr;
+  if (cu_->compiler_driver->GetCompilerOptions().GetConditionalCardMarks()) {
+    RegStorage reg_card = AllocTemp();
+    LoadBaseIndexed(reg_card_base, reg_card_no, reg_card, 0, kUnsignedByte);
+    branch_dirty = OpCmpImmBranch(kCondEq, reg_card, gc::accounting::CardTable::kCardDirty, NULL);
+    FreeTemp(reg_card);
+  }
+  StoreBaseIndexed(reg_card_base, reg_card_no, reg_card_base, 0, kUnsignedByte);
+  if (branch_dirty != NULL) {
+    branch_dirty->target = NewLIR0(kPseudoTargetLabel);
+  }
+}
+
 /* Generic code for generating a wide constant into a VR. */
 void Mir2Lir::GenConstWide(RegLocation rl_dest, int64_t value) {
   RegLocation rl_result = EvalLoc(rl_dest, kAnyReg, true);
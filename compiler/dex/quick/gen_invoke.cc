@@ -1560,8 +1560,8 @@ bool Mir2Lir::GenInlinedCurrentThread(CallInfo* info) {
 
 bool Mir2Lir::GenInlinedUnsafeGet(CallInfo* info,
                                   bool is_long, bool is_volatile) {
-  if (cu_->instruction_set == kMips) {
-    // TODO - add Mips implementation
+  if (cu_->instruction_set == kMips && is_long && is_volatile) {
+    // A pair of 32-bit loads is not atomic.
     return false;
   }
   // Unused - RegLocation rl_src_unsafe = info->args[0];
@@ -1573,7 +1573,14 @@ bool Mir2Lir::GenInlinedUnsafeGet(CallInfo* info,
   RegLocation rl_object = LoadValue(rl_src_obj, kCoreReg);
   RegLocation rl_offset = LoadValue(rl_src_offset, kCoreReg);
   RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
-  if (is_long) {
+  OpSize size = is_long ? k64 : k32;
+  bool acquire_release = is_volatile && VolatileLoadStoreIsAcquireRelease(size);
+  if (acquire_release) {
+    RegStorage rl_temp_offset = AllocTemp();
+    OpRegRegReg(kOpAdd, rl_temp_offset, rl_object.reg, rl_offset.reg);
+    LoadBaseDispVolatile(rl_temp_offset, 0, rl_result.reg, size);
+    FreeTemp(rl_temp_offset);
+  } else if (is_long) {
     if (cu_->instruction_set == kX86 || cu_->instruction_set == kX86_64) {
       LoadBaseIndexedDisp(rl_object.reg, rl_offset.reg, 0, 0, rl_result.reg, k64);
     } else {
@@ -1586,7 +1593,7 @@ bool Mir2Lir::GenInlinedUnsafeGet(CallInfo* info,
     LoadBaseIndexed(rl_object.reg, rl_offset.reg, rl_result.reg, 0, k32);
   }
 
-  if (is_volatile) {
+  if (is_volatile && !acquire_release) {
     // Without context sensitive analysis, we must issue the most conservative barriers.
     // In this case, either a load or store may follow so we issue both barriers.
     GenMemBarrier(kLoadLoad);
@@ -1603,8 +1610,8 @@ bool Mir2Lir::GenInlinedUnsafeGet(CallInfo* info,
 
 bool Mir2Lir::GenInlinedUnsafePut(CallInfo* info, bool is_long,
                                   bool is_object, bool is_volatile, bool is_ordered) {
-  if (cu_->instruction_set == kMips) {
-    // TODO - add Mips implementation
+  if (cu_->instruction_set == kMips && is_long && (is_volatile || is_ordered)) {
+    // A pair of 32-bit stores is not atomic.
     return false;
   }
   // Unused - RegLocation rl_src_unsafe = info->args[0];
@@ -1612,14 +1619,22 @@ bool Mir2Lir::GenInlinedUnsafePut(CallInfo* info, bool is_long,
   RegLocation rl_src_offset = info->args[2];  // long low
   rl_src_offset = NarrowRegLoc(rl_src_offset);  // ignore high half in info->args[3]
   RegLocation rl_src_value = info->args[4];  // value to store
-  if (is_volatile || is_ordered) {
+  OpSize size = is_long ? k64 : k32;
+  bool acquire_release = is_volatile && VolatileLoadStoreIsAcquireRelease(size);
+  if ((is_volatile && !acquire_release) || is_ordered) {
     // There might have been a store before this volatile one so insert StoreStore barrier.
     GenMemBarrier(kStoreStore);
   }
   RegLocation rl_object = LoadValue(rl_src_obj, kCoreReg);
   RegLocation rl_offset = LoadValue(rl_src_offset, kCoreReg);
   RegLocation rl_value;
-  if (is_long) {
+  if (acquire_release) {
+    rl_value = is_long ? LoadValueWide(rl_src_value, kCoreReg) : LoadValue(rl_src_value, kCoreReg);
+    RegStorage rl_temp_offset = AllocTemp();
+    OpRegRegReg(kOpAdd, rl_temp_offset, rl_object.reg, rl_offset.reg);
+    StoreBaseDispVolatile(rl_temp_offset, 0, rl_value.reg, size);
+    FreeTemp(rl_temp_offset);
+  } else if (is_long) {
     rl_value = LoadValueWide(rl_src_value, kCoreReg);
     if (cu_->instruction_set == kX86 || cu_->instruction_set == kX86_64) {
       StoreBaseIndexedDisp(rl_object.reg, rl_offset.reg, 0, 0, rl_value.reg, k64);
@@ -1637,7 +1652,7 @@ bool Mir2Lir::GenInlinedUnsafePut(CallInfo* info, bool is_long,
   // Free up the temp early, to ensure x86 doesn't run out of temporaries in MarkGCCard.
   FreeTemp(rl_offset.reg);
 
-  if (is_volatile) {
+  if (is_volatile && !acquire_release) {
     // A load might follow the volatile store so insert a StoreLoad barrier.
     GenMemBarrier(kStoreLoad);
   }
@@ -1647,6 +1662,30 @@ bool Mir2Lir::GenInlinedUnsafePut(CallInfo* info, bool is_long,
   return true;
 }
 
+bool Mir2Lir::GenInlinedMinMaxLong(CallInfo* info, bool is_min) {
+  return false;
+}
+
+bool Mir2Lir::GenInlinedMinMaxFP(CallInfo* info, bool is_min, bool is_double) {
+  return false;
+}
+
+bool Mir2Lir::GenInlinedStringEquals(CallInfo* info) {
+  return false;
+}
+
+bool Mir2Lir::GenInlinedArrayCopy(CallInfo* info) {
+  return false;
+}
+
+bool Mir2Lir::GenInlinedArraysFill(CallInfo* info, OpSize size) {
+  return false;
+}
+
+bool Mir2Lir::GenInlinedBitCount(CallInfo* info, OpSize size) {
+  return false;
+}
+
 void Mir2Lir::GenInvoke(CallInfo* info) {
   if ((info->opt_flags & MIR_INLINED) != 0) {
     // Already inlined but we may still need the null check.
@@ -1666,6 +1705,41 @@ void Mir2Lir::GenInvoke(CallInfo* info) {
   GenInvokeNoInline(info);
 }
 
+void Mir2Lir::GenVirtualTargetCheck(BasicBlock* bb, MIR* mir) {
+  const MirMethodLoweringInfo& method_info = mir_graph_->GetMethodLoweringInfo(mir);
+  RegLocation rl_obj = LoadValue(mir_graph_->GetSrc(mir, 0), kCoreReg);
+  if (mir->dalvikInsn.vB != 0u) {
+    // An inline cache: compare this->klass_ with the cached boot image class.
+    RegStorage r_class = AllocTemp();
+    GenNullCheck(rl_obj.reg, mir->optimization_flags);
+    LoadRefDisp(rl_obj.reg, mirror::Object::ClassOffset().Int32Value(), r_class);
+    MarkPossibleNullPointerException(mir->optimization_flags);
+    OpCmpImmBranch(kCondNe, r_class, static_cast<int>(mir->dalvikInsn.vB),
+                   &block_label_list_[bb->taken]);
+    FreeTemp(r_class);
+    return;
+  }
+  // Get this->klass_->vtable_[vtable_idx].
+  RegStorage r_vtable_method = AllocTemp();
+  GenNullCheck(rl_obj.reg, mir->optimization_flags);
+  LoadRefDisp(rl_obj.reg, mirror::Object::ClassOffset().Int32Value(), r_vtable_method);
+  MarkPossibleNullPointerException(mir->optimization_flags);
+  LoadRefDisp(r_vtable_method, mirror::Class::VTableOffset().Int32Value(), r_vtable_method);
+  LoadRefDisp(r_vtable_method, ObjArray::OffsetOfElement(method_info.VTableIndex()).Int32Value(),
+              r_vtable_method);
+  // Get the resolved method from method->dex_cache_resolved_methods_, null or the resolution
+  // method until the slow path has resolved it.
+  RegStorage r_resolved_method = AllocTemp();
+  LoadCurrMethodDirect(r_resolved_method);
+  LoadRefDisp(r_resolved_method, mirror::ArtMethod::DexCacheResolvedMethodsOffset().Int32Value(),
+              r_resolved_method);
+  LoadRefDisp(r_resolved_method, ObjArray::OffsetOfElement(method_info.MethodIndex()).Int32Value(),
+              r_resolved_method);
+  OpCmpBranch(kCondNe, r_vtable_method, r_resolved_method, &block_label_list_[bb->taken]);
+  FreeTemp(r_vtable_method);
+  FreeTemp(r_resolved_method);
+}
+
 template <size_t pointer_size>
 static LIR* GenInvokeNoInlineCall(Mir2Lir* mir_to_lir, InvokeType type) {
   ThreadOffset<pointer_size> trampoline(-1);
@@ -1705,7 +1779,10 @@ void Mir2Lir::GenInvokeNoInline(CallInfo* info) {
   BeginInvoke(info);
   InvokeType original_type = static_cast<InvokeType>(method_info.GetInvokeType());
   info->type = static_cast<InvokeType>(method_info.GetSharpType());
-  bool fast_path = method_info.FastPath();
+  // The slow path of a guarded inlined call resolves the method into the dex cache, where
+  // the guard finds it. Inline caches compare classes and need no such resolution.
+  bool fast_path = method_info.FastPath() &&
+      ((info->opt_flags & MIR_INLINED_PRED) == 0 || !method_info.IsEffectivelyFinal());
   bool skip_this;
   if (info->type == kInterface) {
     next_call_insn = fast_path ? NextInterfaceCallInsn : NextInterfaceCallInsnWithAccessCheck;
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include "dex/compiler_internals.h"
 
 namespace art {
@@ -28,6 +30,7 @@ namespace art {
 #define MAX_HOIST_DISTANCE 20
 #define LDLD_DISTANCE 4
 #define LD_LATENCY 2
+#define MAX_SCHEDULE_REGION 64
 
 static bool IsDalvikRegisterClobbered(LIR* lir1, LIR* lir2) {
   int reg1Lo = DECODE_ALIAS_INFO_REG(lir1->flags.alias_info);
@@ -465,6 +468,208 @@ void Mir2Lir::ApplyLoadHoisting(LIR* head_lir, LIR* tail_lir) {
   }
 }
 
+int Mir2Lir::GetInstructionLatency(LIR* lir) {
+  return 0;
+}
+
+int Mir2Lir::GetSchedulingBarrierLength(LIR* lir) {
+  return 0;
+}
+
+/* Whether lir2, later in the list than lir1, must stay after it because of memory */
+static bool HasMemoryDependency(LIR* lir1, LIR* lir2) {
+  uint64_t mem1 = (lir1->u.m.use_mask | lir1->u.m.def_mask) & ENCODE_MEM;
+  uint64_t mem2 = (lir2->u.m.use_mask | lir2->u.m.def_mask) & ENCODE_MEM;
+  uint64_t conflict = ((lir1->u.m.def_mask & mem2) | (mem1 & lir2->u.m.def_mask)) & ENCODE_MEM;
+  if (conflict == 0) {
+    return false;
+  }
+  /* We can fully disambiguate accesses to Dalvik registers only */
+  if (mem1 == ENCODE_DALVIK_REG && mem2 == ENCODE_DALVIK_REG) {
+    return (lir1->flags.alias_info == lir2->flags.alias_info) ||
+        IsDalvikRegisterClobbered(lir1, lir2);
+  }
+  return true;
+}
+
+/*
+ * Reorder a region of at most MAX_SCHEDULE_REGION instructions with no barrier in it to hide
+ * the latencies given by GetInstructionLatency(). This is a list scheduler for a single-issue
+ * in-order pipeline: at each cycle, issue the ready instruction with the longest latency path
+ * to the end of the region, or stall until one is ready. Ties keep the original order.
+ */
+void Mir2Lir::ScheduleRegion(LIR** region, size_t size) {
+  if (size < 2) {
+    return;
+  }
+  DCHECK_LE(size, MAX_SCHEDULE_REGION);
+  int latency[MAX_SCHEDULE_REGION];
+  for (size_t i = 0; i < size; i++) {
+    if (region[i]->flags.is_nop) {
+      latency[i] = 0;
+      continue;
+    }
+    latency[i] = GetInstructionLatency(region[i]);
+    if (latency[i] == 0) {
+      return;  // No model for this target.
+    }
+  }
+
+  /* Dependency graph: succs[i] has bit j set if j must follow i, raw_succs[i] if it reads i */
+  uint64_t succs[MAX_SCHEDULE_REGION];
+  uint64_t raw_succs[MAX_SCHEDULE_REGION];
+  int num_preds[MAX_SCHEDULE_REGION];
+  for (size_t j = 0; j < size; j++) {
+    succs[j] = 0;
+    raw_succs[j] = 0;
+    num_preds[j] = 0;
+  }
+  for (size_t i = 0; i < size; i++) {
+    LIR* lir1 = region[i];
+    if (lir1->flags.is_nop) {
+      continue;
+    }
+    uint64_t use1 = lir1->u.m.use_mask & ~ENCODE_MEM;
+    uint64_t def1 = lir1->u.m.def_mask & ~ENCODE_MEM;
+    for (size_t j = i + 1; j < size; j++) {
+      LIR* lir2 = region[j];
+      if (lir2->flags.is_nop) {
+        continue;
+      }
+      uint64_t use2 = lir2->u.m.use_mask & ~ENCODE_MEM;
+      uint64_t def2 = lir2->u.m.def_mask & ~ENCODE_MEM;
+      bool raw = (def1 & use2) != 0;
+      if (raw || ((use1 | def1) & def2) != 0 || HasMemoryDependency(lir1, lir2)) {
+        succs[i] |= UINT64_C(1) << j;
+        if (raw) {
+          raw_succs[i] |= UINT64_C(1) << j;
+        }
+        num_preds[j]++;
+      }
+    }
+  }
+
+  /* Priority: the longest latency path from each instruction to the end of the region */
+  int height[MAX_SCHEDULE_REGION];
+  for (size_t i = size; i-- != 0;) {
+    height[i] = latency[i];
+    for (size_t j = i + 1; j < size; j++) {
+      if ((succs[i] & (UINT64_C(1) << j)) != 0) {
+        int delay = ((raw_succs[i] & (UINT64_C(1) << j)) != 0) ? latency[i] : 1;
+        height[i] = std::max(height[i], delay + height[j]);
+      }
+    }
+  }
+
+  int earliest[MAX_SCHEDULE_REGION];
+  bool scheduled[MAX_SCHEDULE_REGION];
+  for (size_t i = 0; i < size; i++) {
+    earliest[i] = 0;
+    scheduled[i] = false;
+  }
+  LIR* order[MAX_SCHEDULE_REGION];
+  bool reordered = false;
+  int cycle = 0;
+  for (size_t pos = 0; pos < size; pos++) {
+    /* Prefer an instruction that can issue now; otherwise stall for the first one ready */
+    int best = -1;
+    for (size_t i = 0; i < size; i++) {
+      if (scheduled[i] || num_preds[i] != 0) {
+        continue;
+      }
+      if (best < 0) {
+        best = i;
+        continue;
+      }
+      bool ready = earliest[i] <= cycle;
+      bool best_ready = earliest[best] <= cycle;
+      if (ready != best_ready) {
+        if (ready) {
+          best = i;
+        }
+      } else if (ready ? (height[i] > height[best]) : (earliest[i] < earliest[best])) {
+        best = i;
+      }
+    }
+    DCHECK_GE(best, 0);
+    cycle = std::max(cycle, earliest[best]);
+    scheduled[best] = true;
+    order[pos] = region[best];
+    reordered |= (static_cast<size_t>(best) != pos);
+    for (size_t j = best + 1; j < size; j++) {
+      if ((succs[best] & (UINT64_C(1) << j)) != 0) {
+        num_preds[j]--;
+        int delay = ((raw_succs[best] & (UINT64_C(1) << j)) != 0) ? latency[best] : 1;
+        earliest[j] = std::max(earliest[j], cycle + delay);
+      }
+    }
+    if (!region[best]->flags.is_nop) {
+      cycle++;
+    }
+  }
+  if (!reordered) {
+    return;
+  }
+
+  /* Relink the region in the new order; it is contiguous in the list */
+  LIR* prev_lir = PREV_LIR(region[0]);
+  LIR* next_lir = NEXT_LIR(region[size - 1]);
+  DCHECK(prev_lir != NULL);
+  for (size_t pos = 0; pos < size; pos++) {
+    order[pos]->prev = prev_lir;
+    prev_lir->next = order[pos];
+    prev_lir = order[pos];
+  }
+  prev_lir->next = next_lir;
+  if (next_lir != NULL) {
+    next_lir->prev = prev_lir;
+  } else {
+    last_lir_insn_ = prev_lir;
+  }
+}
+
+/*
+ * Split the superblock into regions between scheduling barriers - labels and other pseudo
+ * instructions, branches, anything that defines or uses ENCODE_ALL and target-specific
+ * sequences - and list-schedule each of them.
+ */
+void Mir2Lir::ApplyListScheduling(LIR* head_lir, LIR* tail_lir) {
+  if (head_lir == tail_lir) {
+    return;
+  }
+  LIR* region[MAX_SCHEDULE_REGION];
+  size_t size = 0;
+  int pinned = 0;
+  LIR* end_lir = NEXT_LIR(tail_lir);
+  for (LIR* this_lir = NEXT_LIR(head_lir); this_lir != end_lir; this_lir = NEXT_LIR(this_lir)) {
+    bool barrier;
+    if (IsPseudoLirOp(this_lir->opcode)) {
+      barrier = true;
+    } else if (this_lir->flags.is_nop) {
+      barrier = false;
+    } else if (pinned != 0) {
+      barrier = true;
+      pinned--;
+    } else {
+      pinned = GetSchedulingBarrierLength(this_lir);
+      barrier = (pinned != 0) || this_lir->flags.use_def_invalid ||
+          (this_lir->u.m.def_mask == ENCODE_ALL) || (this_lir->u.m.use_mask == ENCODE_ALL) ||
+          ((GetTargetInstFlags(this_lir->opcode) & IS_BRANCH) != 0);
+      if (pinned != 0) {
+        pinned--;
+      }
+    }
+    if (barrier || size == MAX_SCHEDULE_REGION) {
+      ScheduleRegion(region, size);
+      size = 0;
+    }
+    if (!barrier) {
+      region[size++] = this_lir;
+    }
+  }
+  ScheduleRegion(region, size);
+}
+
 void Mir2Lir::ApplyLocalOptimizations(LIR* head_lir, LIR* tail_lir) {
   if (!(cu_->disable_opt & (1 << kLoadStoreElimination))) {
     ApplyLoadStoreElimination(head_lir, tail_lir);
@@ -472,6 +677,9 @@ void Mir2Lir::ApplyLocalOptimizations(LIR* head_lir, LIR* tail_lir) {
   if (!(cu_->disable_opt & (1 << kLoadHoisting))) {
     ApplyLoadHoisting(head_lir, tail_lir);
   }
+  if (!(cu_->disable_opt & (1 << kListScheduling))) {
+    ApplyListScheduling(head_lir, tail_lir);
+  }
 }
 
 }  // namespace art
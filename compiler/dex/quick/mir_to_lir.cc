@@ -17,9 +17,11 @@
 #include "dex/compiler_internals.h"
 #include "dex/dataflow_iterator-inl.h"
 #include "dex/quick/dex_file_method_inliner.h"
+#include "driver/compiler_options.h"
 #include "mir_to_lir-inl.h"
 #include "object_utils.h"
 #include "thread-inl.h"
+#include "x86/codegen_x86.h"
 
 namespace art {
 
@@ -149,13 +151,43 @@ bool Mir2Lir::GenSpecialIGet(MIR* mir, const InlineMethod& special) {
     return false;
   }
 
-  // The inliner doesn't distinguish kDouble or kFloat, use shorty.
-  bool double_or_float = cu_->shorty[0] == 'F' || cu_->shorty[0] == 'D';
-
   // Point of no return - no aborts after this
   GenPrintLabel(mir);
   LockArg(data.object_arg);
   RegStorage reg_obj = LoadArg(data.object_arg, kCoreReg);
+  GenSpecialFieldGet(reg_obj, data, wide, size);
+  return true;
+}
+
+bool Mir2Lir::GenSpecialSGet(MIR* mir, const InlineMethod& special) {
+  // The field belongs to the method's own class, it needs no initialization check.
+  const InlineIGetIPutData& data = special.d.ifield_data;
+  bool wide = (data.op_variant == InlineMethodAnalyser::SGetVariant(Instruction::SGET_WIDE));
+  bool ref = (data.op_variant == InlineMethodAnalyser::SGetVariant(Instruction::SGET_OBJECT));
+  OpSize size = LoadStoreOpSize(wide, ref);
+  if (data.is_volatile && !SupportsVolatileLoadStore(size)) {
+    return false;
+  }
+
+  // Point of no return - no aborts after this
+  GenPrintLabel(mir);
+  RegStorage reg_class = LoadDeclaringClassOnEntry();
+  GenSpecialFieldGet(reg_class, data, wide, size);
+  return true;
+}
+
+RegStorage Mir2Lir::LoadDeclaringClassOnEntry() {
+  // Without a frame, the method is only available in the register it was passed in.
+  RegStorage reg_method = TargetReg(kArg0);
+  LockTemp(reg_method);
+  LoadRefDisp(reg_method, mirror::ArtMethod::DeclaringClassOffset().Int32Value(), reg_method);
+  return reg_method;
+}
+
+void Mir2Lir::GenSpecialFieldGet(RegStorage reg_obj, const InlineIGetIPutData& data, bool wide,
+                                 OpSize size) {
+  // The inliner doesn't distinguish kDouble or kFloat, use shorty.
+  bool double_or_float = cu_->shorty[0] == 'F' || cu_->shorty[0] == 'D';
   RegLocation rl_dest = wide ? GetReturnWide(double_or_float) : GetReturn(double_or_float);
   RegisterClass reg_class = RegClassForFieldLoadStore(size, data.is_volatile);
   RegStorage r_result = rl_dest.reg;
@@ -165,10 +197,12 @@ bool Mir2Lir::GenSpecialIGet(MIR* mir, const InlineMethod& special) {
   }
   if (data.is_volatile) {
     LoadBaseDispVolatile(reg_obj, data.field_offset, r_result, size);
-    // Without context sensitive analysis, we must issue the most conservative barriers.
-    // In this case, either a load or store may follow so we issue both barriers.
-    GenMemBarrier(kLoadLoad);
-    GenMemBarrier(kLoadStore);
+    if (!VolatileLoadStoreIsAcquireRelease(size)) {
+      // Without context sensitive analysis, we must issue the most conservative barriers.
+      // In this case, either a load or store may follow so we issue both barriers.
+      GenMemBarrier(kLoadLoad);
+      GenMemBarrier(kLoadStore);
+    }
   } else {
     LoadBaseDisp(reg_obj, data.field_offset, r_result, size);
   }
@@ -179,7 +213,6 @@ bool Mir2Lir::GenSpecialIGet(MIR* mir, const InlineMethod& special) {
       OpRegCopy(rl_dest.reg, r_result);
     }
   }
-  return true;
 }
 
 bool Mir2Lir::GenSpecialIPut(MIR* mir, const InlineMethod& special) {
@@ -206,21 +239,48 @@ bool Mir2Lir::GenSpecialIPut(MIR* mir, const InlineMethod& special) {
   LockArg(data.object_arg);
   LockArg(data.src_arg, wide);
   RegStorage reg_obj = LoadArg(data.object_arg, kCoreReg);
+  GenSpecialFieldPut(reg_obj, data, wide, ref, size);
+  return true;
+}
+
+bool Mir2Lir::GenSpecialSPut(MIR* mir, const InlineMethod& special) {
+  // No initialization check, see GenSpecialSGet().
+  const InlineIGetIPutData& data = special.d.ifield_data;
+  bool wide = (data.op_variant == InlineMethodAnalyser::SPutVariant(Instruction::SPUT_WIDE));
+  bool ref = (data.op_variant == InlineMethodAnalyser::SPutVariant(Instruction::SPUT_OBJECT));
+  OpSize size = LoadStoreOpSize(wide, ref);
+  if (data.is_volatile && !SupportsVolatileLoadStore(size)) {
+    return false;
+  }
+
+  // Point of no return - no aborts after this
+  GenPrintLabel(mir);
+  LockArg(data.src_arg, wide);
+  RegStorage reg_class = LoadDeclaringClassOnEntry();
+  GenSpecialFieldPut(reg_class, data, wide, ref, size);
+  return true;
+}
+
+void Mir2Lir::GenSpecialFieldPut(RegStorage reg_obj, const InlineIGetIPutData& data, bool wide,
+                                 bool ref, OpSize size) {
   RegisterClass reg_class = RegClassForFieldLoadStore(size, data.is_volatile);
   RegStorage reg_src = LoadArg(data.src_arg, reg_class, wide);
   if (data.is_volatile) {
-    // There might have been a store before this volatile one so insert StoreStore barrier.
-    GenMemBarrier(kStoreStore);
+    if (!VolatileLoadStoreIsAcquireRelease(size)) {
+      // There might have been a store before this volatile one so insert StoreStore barrier.
+      GenMemBarrier(kStoreStore);
+    }
     StoreBaseDispVolatile(reg_obj, data.field_offset, reg_src, size);
-    // A load might follow the volatile store so insert a StoreLoad barrier.
-    GenMemBarrier(kStoreLoad);
+    if (!VolatileLoadStoreIsAcquireRelease(size)) {
+      // A load might follow the volatile store so insert a StoreLoad barrier.
+      GenMemBarrier(kStoreLoad);
+    }
   } else {
     StoreBaseDisp(reg_obj, data.field_offset, reg_src, size);
   }
   if (ref) {
     MarkGCCard(reg_src, reg_obj);
   }
-  return true;
 }
 
 bool Mir2Lir::GenSpecialIdentity(MIR* mir, const InlineMethod& special) {
@@ -272,6 +332,14 @@ bool Mir2Lir::GenSpecialCase(BasicBlock* bb, MIR* mir, const InlineMethod& speci
       successful = GenSpecialIPut(mir, special);
       return_mir = bb->GetNextUnconditionalMir(mir_graph_, mir);
       break;
+    case kInlineOpSGet:
+      successful = GenSpecialSGet(mir, special);
+      return_mir = bb->GetNextUnconditionalMir(mir_graph_, mir);
+      break;
+    case kInlineOpSPut:
+      successful = GenSpecialSPut(mir, special);
+      return_mir = bb->GetNextUnconditionalMir(mir_graph_, mir);
+      break;
     default:
       break;
   }
@@ -520,11 +588,8 @@ void Mir2Lir::CompileDalvikInstruction(MIR* mir, BasicBlock* bb, LIR* label_list
       break;
 
     case Instruction::PACKED_SWITCH:
-      GenPackedSwitch(mir, vB, rl_src[0]);
-      break;
-
     case Instruction::SPARSE_SWITCH:
-      GenSparseSwitch(mir, vB, rl_src[0]);
+      GenSwitch(mir, bb, cu_->insns + current_dalvik_offset_ + vB, rl_src[0]);
       break;
 
     case Instruction::CMPL_FLOAT:
@@ -968,6 +1033,9 @@ void Mir2Lir::HandleExtendedMethodMIR(BasicBlock* bb, MIR* mir) {
     case kMirOpSelect:
       GenSelect(bb, mir);
       break;
+    case kMirOpVirtualTargetCheck:
+      GenVirtualTargetCheck(bb, mir);
+      break;
     case kMirOpPhi:
     case kMirOpNop:
     case kMirOpNullCheck:
@@ -992,8 +1060,19 @@ void Mir2Lir::GenPrintLabel(MIR* mir) {
   }
 }
 
+// Returns whether the temps still hold the values the register pool tracks when entering bb,
+// because the only way into bb is falling through from prev_bb, the block generated just before.
+bool Mir2Lir::CanKeepLiveTemps(BasicBlock* bb, BasicBlock* prev_bb) {
+  if (prev_bb == nullptr || (cu_->disable_opt & (1 << kTrackLiveTemps)) != 0) {
+    return false;
+  }
+  return bb->block_type == kDalvikByteCode && !bb->catch_entry &&
+      prev_bb->block_type == kDalvikByteCode && prev_bb->fall_through == bb->id &&
+      bb->predecessors->Size() == 1u && bb->predecessors->Get(0) == prev_bb->id;
+}
+
 // Handle the content in each basic block.
-bool Mir2Lir::MethodBlockCodeGen(BasicBlock* bb) {
+bool Mir2Lir::MethodBlockCodeGen(BasicBlock* bb, BasicBlock* prev_bb) {
   if (bb->block_type == kDead) return false;
   current_dalvik_offset_ = bb->start_offset;
   MIR* mir;
@@ -1013,8 +1092,16 @@ bool Mir2Lir::MethodBlockCodeGen(BasicBlock* bb) {
     head_lir = NewLIR0(kPseudoExportedPC);
   }
 
-  // Free temp registers and reset redundant store tracking.
-  ClobberAllTemps();
+  // Free temp registers and reset redundant store tracking. A block with no other way in than
+  // falling through from the previous one keeps the temps, so that a value loaded before the
+  // branch of a loop test or a null check is not loaded again after it.
+  if (CanKeepLiveTemps(bb, prev_bb)) {
+    // The stores of prev_bb may be read on its other outgoing edges; don't let a redefinition
+    // here eliminate them.
+    ResetDefTracking();
+  } else {
+    ClobberAllTemps();
+  }
 
   if (bb->block_type == kEntryBlock) {
     ResetRegPool();
@@ -1123,23 +1210,115 @@ void Mir2Lir::MethodMIR2LIR() {
                                       kArenaAllocLIR));
 
   PreOrderDfsIterator iter(mir_graph_);
+  BasicBlock* prev_bb = NULL;
   BasicBlock* curr_bb = iter.Next();
   BasicBlock* next_bb = iter.Next();
   while (curr_bb != NULL) {
-    MethodBlockCodeGen(curr_bb);
+    MethodBlockCodeGen(curr_bb, prev_bb);
     // If the fall_through block is no longer laid out consecutively, drop in a branch.
     BasicBlock* curr_bb_fall_through = mir_graph_->GetBasicBlock(curr_bb->fall_through);
     if ((curr_bb_fall_through != NULL) && (curr_bb_fall_through != next_bb)) {
       OpUnconditionalBranch(&block_label_list_[curr_bb->fall_through]);
     }
+    prev_bb = curr_bb;
     curr_bb = next_bb;
     do {
       next_bb = iter.Next();
     } while ((next_bb != NULL) && (next_bb->block_type == kDead));
   }
+  if (cu_->compiler_driver->GetCompilerOptions().GetIncludeOsrEntries()) {
+    GenOsrEntries();
+  }
   HandleSlowPaths();
 }
 
+// Returns whether bb is the header of a loop of the dex code, which the interpreter gets to by a
+// backward branch. The interpreter doesn't transfer frames at catch handlers.
+bool Mir2Lir::IsOsrEntryBlock(BasicBlock* bb) {
+  if (bb->block_type != kDalvikByteCode || bb->catch_entry || bb->predecessors->Size() < 2u) {
+    return false;
+  }
+  for (size_t i = 0; i < bb->predecessors->Size(); ++i) {
+    BasicBlock* pred_bb = mir_graph_->GetBasicBlock(bb->predecessors->Get(i));
+    if (pred_bb->block_type == kDalvikByteCode && pred_bb->start_offset >= bb->start_offset) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Generate an OSR entry for each loop header, for the runtime to move an interpreted frame
+ * running the loop into the compiled code. The runtime calls the entry as the method, with the
+ * current values of the ins as the arguments, and points Thread::osr_locals at the values of the
+ * locals. The entry sets up the frame as the method entry does, loads the locals and jumps to the
+ * loop header. It is exported to the dex-to-pc mapping table with the dex pc of the header.
+ */
+void Mir2Lir::GenOsrEntries() {
+  if (cu_->instruction_set != kThumb2 && cu_->instruction_set != kX86) {
+    // No OSR stub in the runtime.
+    return;
+  }
+  int start_vreg = cu_->num_dalvik_registers - cu_->num_ins;
+  PreOrderDfsIterator iter(mir_graph_);
+  for (BasicBlock* bb = iter.Next(); bb != NULL; bb = iter.Next()) {
+    if (!IsOsrEntryBlock(bb)) {
+      continue;
+    }
+    ResetRegPool();
+    ClobberAllTemps();
+    ResetDefTracking();
+    current_dalvik_offset_ = bb->start_offset;
+    NewLIR0(kPseudoExportedPC);
+    GenOsrEntrySequence(&mir_graph_->reg_location_[start_vreg],
+                        mir_graph_->reg_location_[mir_graph_->GetMethodSReg()]);
+    LoadOsrVRegs();
+    OpUnconditionalBranch(&block_label_list_[bb->id]);
+    osr_entry_dex_pcs_.push_back(bb->start_offset);
+  }
+}
+
+void Mir2Lir::GenOsrEntrySequence(RegLocation* ArgLocs, RegLocation rl_method) {
+  GenEntrySequence(ArgLocs, rl_method);
+}
+
+/*
+ * Copy the locals of the interpreted frame to their home locations and promoted registers, and
+ * load the promoted ins from the home locations the call stored them to: the dex code may have
+ * reused an in with another type than the one FlushIns went by.
+ */
+void Mir2Lir::LoadOsrVRegs() {
+  RegStorage r_locals = AllocTemp();
+  switch (cu_->instruction_set) {
+    case kThumb2:
+      LoadWordDisp(TargetReg(kSelf), Thread::OsrLocalsOffset<4>().Int32Value(), r_locals);
+      break;
+    case kX86:
+      reinterpret_cast<X86Mir2Lir*>(this)->OpRegThreadMem(kOpMov, r_locals,
+                                                          Thread::OsrLocalsOffset<4>());
+      break;
+    default:
+      LOG(FATAL) << "Unexpected isa " << cu_->instruction_set;
+  }
+  RegStorage r_value = AllocTemp();
+  int num_locals = cu_->num_dalvik_registers - cu_->num_ins;
+  for (int v_reg = 0; v_reg < cu_->num_dalvik_registers; v_reg++) {
+    if (v_reg < num_locals) {
+      Load32Disp(r_locals, v_reg * sizeof(uint32_t), r_value);
+      Store32Disp(TargetReg(kSp), VRegOffset(v_reg), r_value);
+    }
+    PromotionMap* v_map = &promotion_map_[v_reg];
+    if (v_map->core_location == kLocPhysReg) {
+      Load32Disp(TargetReg(kSp), VRegOffset(v_reg), RegStorage::Solo32(v_map->core_reg));
+    }
+    if (v_map->fp_location == kLocPhysReg) {
+      Load32Disp(TargetReg(kSp), VRegOffset(v_reg), RegStorage::Solo32(v_map->FpReg));
+    }
+  }
+  FreeTemp(r_locals);
+  FreeTemp(r_value);
+}
+
 //
 // LIR Slow Path
 //
@@ -239,6 +239,13 @@ class Mir2Lir : public Backend {
       LIR** targets;              // Array of case targets.
     };
 
+    // Cases of a switch lowered together: one key compared for equality, or a jump table.
+    struct SwitchCluster {
+      int32_t first_key;
+      int32_t target;             // Target of the single key, relative to the switch.
+      const uint16_t* table;      // Packed switch payload of the jump table, or nullptr.
+    };
+
     /* Static register use counts */
     struct RefCounts {
       int count;
@@ -512,6 +519,36 @@ class Mir2Lir : public Backend {
       LIR* const cont_;
     };
 
+    /*
+     * The slow path throwing the exception of a check without arguments. The checks of the same
+     * kind at one dex pc, which the runtime cannot tell apart, branch to a single slow path.
+     */
+    class ThrowSlowPath : public LIRSlowPath {
+     public:
+      enum Kind {
+        kNullPointer,
+        kDivZero,
+        kNumKinds
+      };
+
+      ThrowSlowPath(Mir2Lir* m2l, LIR* branch, Kind kind)
+          : LIRSlowPath(m2l, m2l->GetCurrentDexPc(), branch), kind_(kind),
+            shared_branches_(m2l->arena_, 2, kGrowableArraySlowPaths), label_(nullptr) {
+      }
+
+      DexOffset GetDexPc() const {
+        return current_dex_pc_;
+      }
+
+      void AddBranch(LIR* branch);
+      void Compile() OVERRIDE;
+
+     private:
+      const Kind kind_;
+      GrowableArray<LIR*> shared_branches_;  // Branches of the other checks, until compiled.
+      LIR* label_;
+    };
+
     virtual ~Mir2Lir() {}
 
     int32_t s4FromSwitchData(const void* switch_data) {
@@ -647,8 +684,18 @@ class Mir2Lir : public Backend {
     void ConvertMemOpIntoMove(LIR* orig_lir, RegStorage dest, RegStorage src);
     void ApplyLoadStoreElimination(LIR* head_lir, LIR* tail_lir);
     void ApplyLoadHoisting(LIR* head_lir, LIR* tail_lir);
+    void ApplyListScheduling(LIR* head_lir, LIR* tail_lir);
+    void ScheduleRegion(LIR** region, size_t size);
     virtual void ApplyLocalOptimizations(LIR* head_lir, LIR* tail_lir);
 
+    // Optional for target - the defaults in local_optimizations.cc disable list scheduling.
+    // Cycles until the results of lir can be used, or 0 if the target has no model of the core
+    // it compiles for.
+    virtual int GetInstructionLatency(LIR* lir);
+    // Number of instructions from lir on that the scheduler must leave in place besides labels,
+    // branches and full barriers, e.g. a predicating instruction and the ones it predicates.
+    virtual int GetSchedulingBarrierLength(LIR* lir);
+
     // Shared by all targets - implemented in ralloc_util.cc
     int GetSRegHi(int lowSreg);
     bool LiveOut(int s_reg);
@@ -764,6 +811,9 @@ class Mir2Lir : public Backend {
                              RegLocation rl_src2, LIR* taken, LIR* fall_through);
     void GenCompareZeroAndBranch(Instruction::Code opcode, RegLocation rl_src,
                                  LIR* taken, LIR* fall_through);
+    void GenSwitch(MIR* mir, BasicBlock* bb, const uint16_t* table, RegLocation rl_src);
+    void GenSwitchClusters(MIR* mir, const SwitchCluster* clusters, size_t count,
+                           RegLocation rl_src, LIR* default_label);
     void GenIntToLong(RegLocation rl_dest, RegLocation rl_src);
     void GenIntNarrowing(Instruction::Code opcode, RegLocation rl_dest,
                          RegLocation rl_src);
@@ -872,6 +922,7 @@ class Mir2Lir : public Backend {
                                                             bool safepoint_pc);
     void GenInvoke(CallInfo* info);
     void GenInvokeNoInline(CallInfo* info);
+    void GenVirtualTargetCheck(BasicBlock* bb, MIR* mir);
     virtual void FlushIns(RegLocation* ArgLocs, RegLocation rl_method);
     int GenDalvikArgsNoRange(CallInfo* info, int call_state, LIR** pcrLabel,
                              NextCallInsn next_call_insn,
@@ -919,6 +970,22 @@ class Mir2Lir : public Backend {
     bool GenInlinedUnsafeGet(CallInfo* info, bool is_long, bool is_volatile);
     bool GenInlinedUnsafePut(CallInfo* info, bool is_long, bool is_object,
                              bool is_volatile, bool is_ordered);
+
+    /*
+     * The following intrinsics are optional: the default implementations return false, which
+     * keeps the regular invoke, and backends override those they can generate.
+     */
+    virtual bool GenInlinedMinMaxLong(CallInfo* info, bool is_min);
+    // Math.min/max on float or double: NaN if either argument is NaN, and -0.0 < +0.0.
+    virtual bool GenInlinedMinMaxFP(CallInfo* info, bool is_min, bool is_double);
+    virtual bool GenInlinedStringEquals(CallInfo* info);
+    // System.arraycopy; the fast path may cover only some arrays and call the native otherwise.
+    virtual bool GenInlinedArrayCopy(CallInfo* info);
+    // Arrays.fill on a whole array of elements of the given size.
+    virtual bool GenInlinedArraysFill(CallInfo* info, OpSize size);
+    // Integer.bitCount or Long.bitCount, for backends with a population count instruction.
+    virtual bool GenInlinedBitCount(CallInfo* info, OpSize size);
+
     virtual int LoadArgRegs(CallInfo* info, int call_state,
                     NextCallInsn next_call_insn,
                     const MethodReference& target_method,
@@ -1010,9 +1077,13 @@ class Mir2Lir : public Backend {
     // Shared by all targets - implemented in mir_to_lir.cc.
     void CompileDalvikInstruction(MIR* mir, BasicBlock* bb, LIR* label_list);
     virtual void HandleExtendedMethodMIR(BasicBlock* bb, MIR* mir);
-    bool MethodBlockCodeGen(BasicBlock* bb);
+    bool CanKeepLiveTemps(BasicBlock* bb, BasicBlock* prev_bb);
+    bool MethodBlockCodeGen(BasicBlock* bb, BasicBlock* prev_bb);
     bool SpecialMIR2LIR(const InlineMethod& special);
     virtual void MethodMIR2LIR();
+    bool IsOsrEntryBlock(BasicBlock* bb);
+    void GenOsrEntries();
+    void LoadOsrVRegs();
     // Update LIR for verbose listings.
     void UpdateLIROffsets();
 
@@ -1086,6 +1157,8 @@ class Mir2Lir : public Backend {
     virtual LIR* StoreBaseIndexedDisp(RegStorage r_base, RegStorage r_index, int scale,
                                       int displacement, RegStorage r_src, OpSize size) = 0;
     virtual void MarkGCCard(RegStorage val_reg, RegStorage tgt_addr_reg) = 0;
+    // Dirties the card at index reg_card_no of the card table at reg_card_base, for MarkGCCard.
+    virtual void StoreGCCard(RegStorage reg_card_base, RegStorage reg_card_no);
 
     // Required for target - register utilities.
     virtual RegStorage AllocTypedTemp(bool fp_hint, int reg_class) = 0;
@@ -1121,6 +1194,11 @@ class Mir2Lir : public Backend {
 
     // Check support for volatile load/store of a given size.
     virtual bool SupportsVolatileLoadStore(OpSize size) = 0;
+    // Check whether the volatile load/store of a given size has acquire/release semantics, so
+    // that it needs no memory barriers around it.
+    virtual bool VolatileLoadStoreIsAcquireRelease(OpSize size) {
+      return false;
+    }
     // Get the register class for load/store of a field.
     virtual RegisterClass RegClassForFieldLoadStore(OpSize size, bool is_volatile) = 0;
 
@@ -1202,6 +1280,8 @@ class Mir2Lir : public Backend {
     virtual void GenDivZeroCheckWide(RegStorage reg) = 0;
 
     virtual void GenEntrySequence(RegLocation* ArgLocs, RegLocation rl_method) = 0;
+    // The entry sequence of an OSR entry, see GenOsrEntries.
+    virtual void GenOsrEntrySequence(RegLocation* ArgLocs, RegLocation rl_method);
     virtual void GenExitSequence() = 0;
     virtual void GenFillArrayData(DexOffset table_offset, RegLocation rl_src) = 0;
     virtual void GenFusedFPCmpBranch(BasicBlock* bb, MIR* mir, bool gt_bias, bool is_double) = 0;
@@ -1238,8 +1318,8 @@ class Mir2Lir : public Backend {
                                                int first_bit, int second_bit) = 0;
     virtual void GenNegDouble(RegLocation rl_dest, RegLocation rl_src) = 0;
     virtual void GenNegFloat(RegLocation rl_dest, RegLocation rl_src) = 0;
-    virtual void GenPackedSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src) = 0;
-    virtual void GenSparseSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src) = 0;
+    virtual void GenPackedSwitch(MIR* mir, const uint16_t* table, RegLocation rl_src) = 0;
+    virtual void GenSparseSwitch(MIR* mir, const uint16_t* table, RegLocation rl_src) = 0;
     virtual void GenArrayGet(int opt_flags, OpSize size, RegLocation rl_array,
                              RegLocation rl_index, RegLocation rl_dest, int scale) = 0;
     virtual void GenArrayPut(int opt_flags, OpSize size, RegLocation rl_array,
@@ -1460,6 +1540,43 @@ class Mir2Lir : public Backend {
      */
     bool GenSpecialIPut(MIR* mir, const InlineMethod& special);
 
+    /**
+     * @brief Used to generate LIR for special static getter method.
+     * @param mir The mir that represents the sget.
+     * @param special Information about the special static getter method.
+     * @return Returns whether LIR was successfully generated.
+     */
+    bool GenSpecialSGet(MIR* mir, const InlineMethod& special);
+
+    /**
+     * @brief Used to generate LIR for special static setter method.
+     * @param mir The mir that represents the sput.
+     * @param special Information about the special static setter method.
+     * @return Returns whether LIR was successfully generated.
+     */
+    bool GenSpecialSPut(MIR* mir, const InlineMethod& special);
+
+    /**
+     * @brief Used to load the declaring class of a special method, which has no frame.
+     * @return Returns the register holding the class, which held the method on entry.
+     */
+    RegStorage LoadDeclaringClassOnEntry();
+
+    /**
+     * @brief Used to load the field of a special getter method into the return register.
+     * @param reg_obj The object, or class of a static field, holding the field.
+     */
+    void GenSpecialFieldGet(RegStorage reg_obj, const InlineIGetIPutData& data, bool wide,
+                            OpSize size);
+
+    /**
+     * @brief Used to store the argument of a special setter method into the field.
+     * @details LockArg must have been previously called for the source argument.
+     * @param reg_obj The object, or class of a static field, holding the field.
+     */
+    void GenSpecialFieldPut(RegStorage reg_obj, const InlineIGetIPutData& data, bool wide,
+                            bool ref, OpSize size);
+
     /**
      * @brief Used to generate LIR for special return-args method.
      * @param mir The mir that represents the return of argument.
@@ -1469,6 +1586,7 @@ class Mir2Lir : public Backend {
     bool GenSpecialIdentity(MIR* mir, const InlineMethod& special);
 
     void AddDivZeroCheckSlowPath(LIR* branch);
+    void AddThrowSlowPath(LIR* branch, ThrowSlowPath::Kind kind);
 
     // Copy arg0 and arg1 to kArg0 and kArg1 safely, possibly using
     // kArg2 as temp.
@@ -1525,6 +1643,8 @@ class Mir2Lir : public Backend {
     std::vector<uint8_t> encoded_mapping_table_;
     std::vector<uint32_t> core_vmap_table_;
     std::vector<uint32_t> fp_vmap_table_;
+    // The dex pcs of the loop headers with an OSR entry, exported next to the catch entries.
+    std::vector<DexOffset> osr_entry_dex_pcs_;
     std::vector<uint8_t> native_gc_map_;
     int num_core_spills_;
     int num_fp_spills_;
@@ -1535,6 +1655,8 @@ class Mir2Lir : public Backend {
     LIR* last_lir_insn_;
 
     GrowableArray<LIRSlowPath*> slow_paths_;
+    // The last throw slow path of each kind, shared by the following checks at its dex pc.
+    ThrowSlowPath* last_throw_slow_paths_[ThrowSlowPath::kNumKinds];
 };  // Class Mir2Lir
 
 }  // namespace art
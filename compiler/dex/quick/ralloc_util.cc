@@ -669,11 +669,11 @@ void Mir2Lir::ResetDefTracking() {
   for (RegisterInfo* info = core_it.Next(); info != nullptr; info = core_it.Next()) {
     info->ResetDefBody();
   }
-  GrowableArray<RegisterInfo*>::Iterator sp_it(&reg_pool_->core_regs_);
+  GrowableArray<RegisterInfo*>::Iterator sp_it(&reg_pool_->sp_regs_);
   for (RegisterInfo* info = sp_it.Next(); info != nullptr; info = sp_it.Next()) {
     info->ResetDefBody();
   }
-  GrowableArray<RegisterInfo*>::Iterator dp_it(&reg_pool_->core_regs_);
+  GrowableArray<RegisterInfo*>::Iterator dp_it(&reg_pool_->dp_regs_);
   for (RegisterInfo* info = dp_it.Next(); info != nullptr; info = dp_it.Next()) {
     info->ResetDefBody();
   }
@@ -18,6 +18,7 @@
 
 #include "codegen_x86.h"
 #include "dex/quick/mir_to_lir-inl.h"
+#include "driver/compiler_options.h"
 #include "x86_lir.h"
 
 namespace art {
@@ -26,9 +27,7 @@ namespace art {
  * The sparse table in the literal pool is an array of <key,displacement>
  * pairs.
  */
-void X86Mir2Lir::GenSparseSwitch(MIR* mir, DexOffset table_offset,
-                                 RegLocation rl_src) {
-  const uint16_t* table = cu_->insns + current_dalvik_offset_ + table_offset;
+void X86Mir2Lir::GenSparseSwitch(MIR* mir, const uint16_t* table, RegLocation rl_src) {
   if (cu_->verbose) {
     DumpSparseSwitchTable(table);
   }
@@ -60,9 +59,7 @@ void X86Mir2Lir::GenSparseSwitch(MIR* mir, DexOffset table_offset,
  * jmp  r_start_of_method
  * done:
  */
-void X86Mir2Lir::GenPackedSwitch(MIR* mir, DexOffset table_offset,
-                                 RegLocation rl_src) {
-  const uint16_t* table = cu_->insns + current_dalvik_offset_ + table_offset;
+void X86Mir2Lir::GenPackedSwitch(MIR* mir, const uint16_t* table, RegLocation rl_src) {
   if (cu_->verbose) {
     DumpPackedSwitchTable(table);
   }
@@ -191,13 +188,29 @@ void X86Mir2Lir::MarkGCCard(RegStorage val_reg, RegStorage tgt_addr_reg) {
     NewLIR2(kX86Mov32RT, reg_card_base.GetReg(), ct_offset);
   }
   OpRegRegImm(kOpLsr, reg_card_no, tgt_addr_reg, gc::accounting::CardTable::kCardShift);
-  StoreBaseIndexed(reg_card_base, reg_card_no, reg_card_base, 0, kUnsignedByte);
+  StoreGCCard(reg_card_base, reg_card_no);
   LIR* target = NewLIR0(kPseudoTargetLabel);
   branch_over->target = target;
   FreeTemp(reg_card_base);
   FreeTemp(reg_card_no);
 }
 
+/*
+ * The card is compared in memory, MarkGCCard callers leave no temp to spare for loading it.
+ */
+void X86Mir2Lir::StoreGCCard(RegStorage reg_card_base, RegStorage reg_card_no) {
+  LIR* branch_dirty = NULL;
+  if (cu_->compiler_driver->GetCompilerOptions().GetConditionalCardMarks()) {
+    NewLIR5(kX86Cmp8AI, reg_card_base.GetReg(), reg_card_no.GetReg(), 0, 0,
+            gc::accounting::CardTable::kCardDirty);
+    branch_dirty = OpCondBranch(kCondEq, NULL);
+  }
+  StoreBaseIndexed(reg_card_base, reg_card_no, reg_card_base, 0, kUnsignedByte);
+  if (branch_dirty != NULL) {
+    branch_dirty->target = NewLIR0(kPseudoTargetLabel);
+  }
+}
+
 void X86Mir2Lir::GenEntrySequence(RegLocation* ArgLocs, RegLocation rl_method) {
   /*
    * On entry, rX86_ARG0, rX86_ARG1, rX86_ARG2 are live.  Let the register
@@ -283,6 +296,17 @@ void X86Mir2Lir::GenEntrySequence(RegLocation* ArgLocs, RegLocation rl_method) {
   FreeTemp(rs_rX86_ARG2);
 }
 
+void X86Mir2Lir::GenOsrEntrySequence(RegLocation* ArgLocs, RegLocation rl_method) {
+  // The call frame information and the removal of an unused base of code go by the method entry.
+  // An OSR entry keeps setting up the base of code even if the method turns out not to use it.
+  LIR* stack_decrement = stack_decrement_;
+  LIR* setup_method_address[2] = { setup_method_address_[0], setup_method_address_[1] };
+  GenEntrySequence(ArgLocs, rl_method);
+  stack_decrement_ = stack_decrement;
+  setup_method_address_[0] = setup_method_address[0];
+  setup_method_address_[1] = setup_method_address[1];
+}
+
 void X86Mir2Lir::GenExitSequence() {
   /*
    * In the exit path, rX86_RET0/rX86_RET1 are live - make sure they aren't
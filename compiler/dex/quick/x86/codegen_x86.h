@@ -51,7 +51,11 @@ class X86Mir2Lir : public Mir2Lir {
                           OpSize size) OVERRIDE;
     LIR* StoreBaseIndexedDisp(RegStorage r_base, RegStorage r_index, int scale, int displacement,
                               RegStorage r_src, OpSize size) OVERRIDE;
+    // Stores an immediate of at most 32 bits, with no register to hold it.
+    LIR* StoreBaseIndexedDispImm(RegStorage r_base, RegStorage r_index, int scale,
+                                 int displacement, int32_t value, OpSize size);
     void MarkGCCard(RegStorage val_reg, RegStorage tgt_addr_reg);
+    void StoreGCCard(RegStorage reg_card_base, RegStorage reg_card_no);
 
     // Required for target - register utilities.
     RegStorage AllocTypedTemp(bool fp_hint, int reg_class);
@@ -117,6 +121,8 @@ class X86Mir2Lir : public Mir2Lir {
     void GenConversion(Instruction::Code opcode, RegLocation rl_dest, RegLocation rl_src);
     bool GenInlinedCas(CallInfo* info, bool is_long, bool is_object);
     bool GenInlinedMinMaxInt(CallInfo* info, bool is_min);
+    bool GenInlinedMinMaxFP(CallInfo* info, bool is_min, bool is_double);
+    bool GenInlinedBitCount(CallInfo* info, OpSize size);
     bool GenInlinedSqrt(CallInfo* info);
     bool GenInlinedPeek(CallInfo* info, OpSize size);
     bool GenInlinedPoke(CallInfo* info, OpSize size);
@@ -135,6 +141,7 @@ class X86Mir2Lir : public Mir2Lir {
     void GenArrayBoundsCheck(RegStorage index, RegStorage array_base, int32_t len_offset);
     void GenArrayBoundsCheck(int32_t index, RegStorage array_base, int32_t len_offset);
     void GenEntrySequence(RegLocation* ArgLocs, RegLocation rl_method);
+    void GenOsrEntrySequence(RegLocation* ArgLocs, RegLocation rl_method) OVERRIDE;
     void GenExitSequence();
     void GenSpecialExitSequence();
     void GenFillArrayData(DexOffset table_offset, RegLocation rl_src);
@@ -147,8 +154,8 @@ class X86Mir2Lir : public Mir2Lir {
                                        int first_bit, int second_bit);
     void GenNegDouble(RegLocation rl_dest, RegLocation rl_src);
     void GenNegFloat(RegLocation rl_dest, RegLocation rl_src);
-    void GenPackedSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src);
-    void GenSparseSwitch(MIR* mir, DexOffset table_offset, RegLocation rl_src);
+    void GenPackedSwitch(MIR* mir, const uint16_t* table, RegLocation rl_src);
+    void GenSparseSwitch(MIR* mir, const uint16_t* table, RegLocation rl_src);
 
     /*
      * @brief Generate a two address long operation with a constant value
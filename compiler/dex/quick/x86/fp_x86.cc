@@ -450,6 +450,52 @@ bool X86Mir2Lir::GenInlinedSqrt(CallInfo* info) {
   return true;
 }
 
+bool X86Mir2Lir::GenInlinedMinMaxFP(CallInfo* info, bool is_min, bool is_double) {
+  RegLocation rl_src1 = info->args[0];
+  RegLocation rl_src2 = info->args[is_double ? 2 : 1];
+  RegLocation rl_dest = is_double ? InlineTargetWide(info) : InlineTarget(info);
+  if (is_double) {
+    rl_src1 = LoadValueWide(rl_src1, kFPReg);
+    rl_src2 = LoadValueWide(rl_src2, kFPReg);
+  } else {
+    rl_src1 = LoadValue(rl_src1, kFPReg);
+    rl_src2 = LoadValue(rl_src2, kFPReg);
+  }
+  RegLocation rl_result = EvalLoc(rl_dest, kFPReg, true);
+  // The result starts as one argument and is compared with the other. Every case below is
+  // symmetric in the arguments, so swap them if the result register holds the second one.
+  if (rl_result.reg == rl_src2.reg) {
+    std::swap(rl_src1, rl_src2);
+  }
+  OpRegCopy(rl_result.reg, rl_src1.reg);
+  NewLIR2(is_double ? kX86UcomisdRR : kX86UcomissRR, rl_result.reg.GetReg(),
+          rl_src2.reg.GetReg());
+  LIR* nan_branch = NewLIR2(kX86Jcc8, 0, kX86CondPE);
+  LIR* not_equal_branch = NewLIR2(kX86Jcc8, 0, kX86CondNe);
+  // Equal values differ at most in the sign of a zero: or-ing the bits yields -0.0 for min,
+  // and-ing them yields +0.0 for max.
+  NewLIR2(is_min ? kX86OrpsRR : kX86AndpsRR, rl_result.reg.GetReg(), rl_src2.reg.GetReg());
+  LIR* equal_done_branch = NewLIR1(kX86Jmp8, 0);
+  // Unordered: the sum is NaN.
+  nan_branch->target = NewLIR0(kPseudoTargetLabel);
+  NewLIR2(is_double ? kX86AddsdRR : kX86AddssRR, rl_result.reg.GetReg(), rl_src2.reg.GetReg());
+  LIR* nan_done_branch = NewLIR1(kX86Jmp8, 0);
+  // Ordered and different: keep the first argument if it is below (min) or above (max).
+  not_equal_branch->target = NewLIR0(kPseudoTargetLabel);
+  LIR* keep_branch = NewLIR2(kX86Jcc8, 0, is_min ? kX86CondB : kX86CondA);
+  OpRegCopy(rl_result.reg, rl_src2.reg);
+  LIR* done = NewLIR0(kPseudoTargetLabel);
+  equal_done_branch->target = done;
+  nan_done_branch->target = done;
+  keep_branch->target = done;
+  if (is_double) {
+    StoreValueWide(rl_dest, rl_result);
+  } else {
+    StoreValue(rl_dest, rl_result);
+  }
+  return true;
+}
+
 
 
 }  // namespace art
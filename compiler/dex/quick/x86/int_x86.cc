@@ -684,6 +684,33 @@ bool X86Mir2Lir::GenInlinedMinMaxInt(CallInfo* info, bool is_min) {
   return true;
 }
 
+bool X86Mir2Lir::GenInlinedBitCount(CallInfo* info, OpSize size) {
+  if (!cu_->GetInstructionSetFeatures().HasPopcnt()) {
+    return false;
+  }
+  if (size == k64 && Gen64Bit()) {
+    // TODO: a 64-bit popcnt for longs held in a single register.
+    return false;
+  }
+  RegLocation rl_dest = InlineTarget(info);
+  RegLocation rl_result = EvalLoc(rl_dest, kCoreReg, true);
+  if (size == k64) {
+    // Count each half; the high half goes first as the result may share the register of either.
+    RegLocation rl_src = LoadValueWide(info->args[0], kCoreReg);
+    RegStorage t_reg = AllocTemp();
+    NewLIR2(kX86Popcnt32RR, t_reg.GetReg(), rl_src.reg.GetHighReg());
+    NewLIR2(kX86Popcnt32RR, rl_result.reg.GetReg(), rl_src.reg.GetLowReg());
+    OpRegReg(kOpAdd, rl_result.reg, t_reg);
+    FreeTemp(t_reg);
+  } else {
+    DCHECK_EQ(size, k32);
+    RegLocation rl_src = LoadValue(info->args[0], kCoreReg);
+    NewLIR2(kX86Popcnt32RR, rl_result.reg.GetReg(), rl_src.reg.GetReg());
+  }
+  StoreValue(rl_dest, rl_result);
+  return true;
+}
+
 bool X86Mir2Lir::GenInlinedPeek(CallInfo* info, OpSize size) {
   RegLocation rl_src_address = info->args[0];  // long address
   rl_src_address = NarrowRegLoc(rl_src_address);  // ignore high half in info->args[1]
@@ -856,6 +883,16 @@ LIR* X86Mir2Lir::OpVstm(RegStorage r_base, int count) {
 void X86Mir2Lir::GenMultiplyByTwoBitMultiplier(RegLocation rl_src,
                                                RegLocation rl_result, int lit,
                                                int first_bit, int second_bit) {
+  int shift = second_bit - first_bit;
+  if (shift <= 3 && rl_src.reg != rs_rBP) {
+    // lea result, [src + src << shift] multiplies by 3, 5 or 9 at once (rbp can't be the base).
+    NewLIR5(kX86Lea32RA, rl_result.reg.GetReg(), rl_src.reg.GetReg() /* base */,
+            rl_src.reg.GetReg() /* index */, shift /* scale */, 0 /* disp */);
+    if (first_bit != 0) {
+      OpRegRegImm(kOpLsl, rl_result.reg, rl_result.reg, first_bit);
+    }
+    return;
+  }
   RegStorage t_reg = AllocTemp();
   OpRegRegImm(kOpLsl, t_reg, rl_src.reg, second_bit - first_bit);
   OpRegRegReg(kOpAdd, rl_result.reg, rl_src.reg, t_reg);
@@ -1511,6 +1548,20 @@ void X86Mir2Lir::GenArrayPut(int opt_flags, OpSize size, RegLocation rl_array,
       GenArrayBoundsCheck(rl_index.reg, rl_array.reg, len_offset);
     }
   }
+  if (rl_src.is_const && !card_mark) {
+    // Store the constant as an immediate, it needn't be loaded in a register.
+    if ((size == k64) || (size == kDouble)) {
+      int64_t value = mir_graph_->ConstantValueWide(rl_src);
+      StoreBaseIndexedDispImm(rl_array.reg, rl_index.reg, scale, data_offset + LOWORD_OFFSET,
+                              Low32Bits(value), k32);
+      StoreBaseIndexedDispImm(rl_array.reg, rl_index.reg, scale, data_offset + HIWORD_OFFSET,
+                              High32Bits(value), k32);
+    } else {
+      StoreBaseIndexedDispImm(rl_array.reg, rl_index.reg, scale, data_offset,
+                              mir_graph_->ConstantValue(rl_src), size);
+    }
+    return;
+  }
   if ((size == k64) || (size == kDouble)) {
     rl_src = LoadValueWide(rl_src, reg_class);
   } else {
@@ -2169,8 +2220,7 @@ void X86Mir2Lir::GenArithOpInt(Instruction::Code opcode, RegLocation rl_dest,
       OpRegRegReg(op, rl_result.reg, rl_lhs.reg, t_reg);
       FreeTemp(t_reg);
     } else {
-      // Multiply is 3 operand only (sort of).
-      if (is_two_addr && op != kOpMul) {
+      if (is_two_addr) {
         // Can we do this directly into memory?
         rl_result = UpdateLocTyped(rl_dest, kCoreReg);
         if (rl_result.location == kLocPhysReg) {
@@ -2189,11 +2239,11 @@ void X86Mir2Lir::GenArithOpInt(Instruction::Code opcode, RegLocation rl_dest,
           }
         }
         rl_rhs = LoadValue(rl_rhs, kCoreReg);
-        if (rl_result.location != kLocPhysReg) {
-          // Okay, we can do this into memory.
+        if (rl_result.location != kLocPhysReg && op != kOpMul) {
+          // Okay, we can do this into memory, but there is no imul with a memory destination.
           OpMemReg(op, rl_result, rl_rhs.reg.GetReg());
           return;
-        } else if (!rl_result.reg.IsFloat()) {
+        } else if (rl_result.location == kLocPhysReg && !rl_result.reg.IsFloat()) {
           // Can do this directly into the result register.
           OpRegReg(op, rl_result.reg, rl_rhs.reg);
           StoreFinalValue(rl_dest, rl_result);
@@ -811,6 +811,41 @@ LIR* X86Mir2Lir::StoreBaseIndexedDisp(RegStorage r_base, RegStorage r_index, int
   return store;
 }
 
+LIR* X86Mir2Lir::StoreBaseIndexedDispImm(RegStorage r_base, RegStorage r_index, int scale,
+                                         int displacement, int32_t value, OpSize size) {
+  bool is_array = r_index.Valid();
+  X86OpCode opcode = kX86Nop;
+  switch (size) {
+    case k32:
+    case kSingle:
+    case kReference:
+      opcode = is_array ? kX86Mov32AI : kX86Mov32MI;
+      DCHECK_EQ((displacement & 0x3), 0);
+      break;
+    case kUnsignedHalf:
+    case kSignedHalf:
+      opcode = is_array ? kX86Mov16AI : kX86Mov16MI;
+      DCHECK_EQ((displacement & 0x1), 0);
+      break;
+    case kUnsignedByte:
+    case kSignedByte:
+      opcode = is_array ? kX86Mov8AI : kX86Mov8MI;
+      break;
+    default:
+      LOG(FATAL) << "Bad case in StoreBaseIndexedDispImm " << size;
+  }
+  LIR* store;
+  if (!is_array) {
+    store = NewLIR3(opcode, r_base.GetReg(), displacement, value);
+    if (r_base == rs_rX86_SP) {
+      AnnotateDalvikRegAccess(store, displacement >> 2, false /* is_load */, false /* is_64bit */);
+    }
+  } else {
+    store = NewLIR5(opcode, r_base.GetReg(), r_index.GetReg(), scale, displacement, value);
+  }
+  return store;
+}
+
 /* store value base base + scaled index. */
 LIR* X86Mir2Lir::StoreBaseIndexed(RegStorage r_base, RegStorage r_index, RegStorage r_src,
                       int scale, OpSize size) {
@@ -405,6 +405,7 @@ enum X86OpCode {
   Binary0fOpCode(kX86Ucomiss),  // unordered float compare
   Binary0fOpCode(kX86Comisd),   // double compare
   Binary0fOpCode(kX86Comiss),   // float compare
+  Binary0fOpCode(kX86Andps),    // and of floating point registers
   Binary0fOpCode(kX86Orps),     // or of floating point registers
   Binary0fOpCode(kX86Xorps),    // xor of floating point registers
   Binary0fOpCode(kX86Addsd),    // double add
@@ -441,6 +442,7 @@ enum X86OpCode {
   kX86Mfence,                   // memory barrier
   Binary0fOpCode(kX86Imul16),   // 16bit multiply
   Binary0fOpCode(kX86Imul32),   // 32bit multiply
+  Binary0fOpCode(kX86Popcnt32),  // 32bit population count
   kX86CmpxchgRR, kX86CmpxchgMR, kX86CmpxchgAR,  // compare and exchange
   kX86LockCmpxchgMR, kX86LockCmpxchgAR,  // locked compare and exchange
   kX86LockCmpxchg8bM, kX86LockCmpxchg8bA,  // locked compare and exchange
@@ -426,21 +426,16 @@ void MIRGraph::ComputeDominators() {
 
 /*
  * Perform dest U= src1 ^ ~src2
- * This is probably not general enough to be placed in BitVector.[ch].
+ * The sets may be sparse, see ArenaBitVector.
  */
 void MIRGraph::ComputeSuccLineIn(ArenaBitVector* dest, const ArenaBitVector* src1,
                                  const ArenaBitVector* src2) {
-  if (dest->GetStorageSize() != src1->GetStorageSize() ||
-      dest->GetStorageSize() != src2->GetStorageSize() ||
-      dest->IsExpandable() != src1->IsExpandable() ||
+  if (dest->IsExpandable() != src1->IsExpandable() ||
       dest->IsExpandable() != src2->IsExpandable()) {
     LOG(FATAL) << "Incompatible set properties";
   }
 
-  unsigned int idx;
-  for (idx = 0; idx < dest->GetStorageSize(); idx++) {
-    dest->GetRawStorage()[idx] |= src1->GetRawStorageWord(idx) & ~(src2->GetRawStorageWord(idx));
-  }
+  dest->UnionIfNotIn(src1, src2);
 }
 
 /*
@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dex_layout.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include <algorithm>
+#include <limits>
+
+#include "base/logging.h"
+#include "dex_file-inl.h"
+#include "dex_instruction-inl.h"
+#include "leb128.h"
+#include "safe_map.h"
+#include "utils.h"
+
+namespace art {
+
+namespace {
+
+// A code item, or the string data of a string, and its tier.
+struct LayoutItem {
+  uint32_t offset;
+  uint32_t size;
+  uint32_t tier;
+};
+
+// A code_off of a class_data_item: the place and length of its ULEB128, and its value.
+struct CodeOffRef {
+  uint32_t position;
+  uint32_t length;
+  uint32_t code_off;
+};
+
+size_t CodeItemSize(const DexFile::CodeItem& code_item) {
+  const byte* start = reinterpret_cast<const byte*>(&code_item);
+  if (code_item.tries_size_ == 0) {
+    return reinterpret_cast<const byte*>(&code_item.insns_[code_item.insns_size_in_code_units_]) -
+        start;
+  }
+  const byte* ptr = DexFile::GetCatchHandlerData(code_item, 0);
+  uint32_t handlers_size = DecodeUnsignedLeb128(&ptr);
+  for (uint32_t i = 0; i != handlers_size; ++i) {
+    int32_t size = DecodeSignedLeb128(&ptr);
+    for (int32_t j = 0; j != std::abs(size); ++j) {
+      DecodeUnsignedLeb128(&ptr);  // type_idx
+      DecodeUnsignedLeb128(&ptr);  // addr
+    }
+    if (size <= 0) {
+      DecodeUnsignedLeb128(&ptr);  // catch_all_addr
+    }
+  }
+  return ptr - start;
+}
+
+size_t StringDataSize(const byte* string_data) {
+  const byte* ptr = string_data;
+  DecodeUnsignedLeb128(&ptr);  // utf16_size
+  return (ptr - string_data) + strlen(reinterpret_cast<const char*>(ptr)) + 1;
+}
+
+const DexFile::MapItem* FindMapItem(const DexFile& dex_file, uint16_t type) {
+  const DexFile::MapList* map_list =
+      reinterpret_cast<const DexFile::MapList*>(dex_file.Begin() + dex_file.GetHeader().map_off_);
+  for (uint32_t i = 0; i != map_list->size_; ++i) {
+    if (map_list->list_[i].type_ == type) {
+      return &map_list->list_[i];
+    }
+  }
+  return nullptr;
+}
+
+// Puts the new offsets of the items, sorted by offset, in new_offsets. Returns false if they
+// don't fill the section of map_item back to back, as dx writes them.
+bool LayoutSection(const DexFile::MapItem* map_item, size_t alignment,
+                   const std::vector<LayoutItem>& items, SafeMap<uint32_t, uint32_t>* new_offsets) {
+  if (items.empty()) {
+    return true;
+  }
+  if (map_item == nullptr || map_item->size_ != items.size() ||
+      map_item->offset_ != items[0].offset) {
+    return false;
+  }
+  for (size_t i = 1; i != items.size(); ++i) {
+    if (items[i].offset != RoundUp(items[i - 1].offset + items[i - 1].size, alignment)) {
+      return false;
+    }
+  }
+  std::vector<const LayoutItem*> order;
+  for (const LayoutItem& item : items) {
+    order.push_back(&item);
+  }
+  std::stable_sort(order.begin(), order.end(), [](const LayoutItem* lhs, const LayoutItem* rhs) {
+    return lhs->tier < rhs->tier;
+  });
+  // Only the last item may end unaligned, it then stays last so that the items still fit.
+  const LayoutItem* last = &items.back();
+  if (!IsAlignedParam(last->size, alignment)) {
+    order.erase(std::find(order.begin(), order.end(), last));
+    order.push_back(last);
+  }
+  uint32_t offset = items[0].offset;
+  for (const LayoutItem* item : order) {
+    offset = RoundUp(offset, alignment);
+    new_offsets->Put(item->offset, offset);
+    offset += item->size;
+  }
+  DCHECK_EQ(offset, last->offset + last->size);
+  return true;
+}
+
+// Copies the items to their new offsets, zeroing the alignment padding.
+void CopySection(const byte* in, const std::vector<LayoutItem>& items,
+                 const SafeMap<uint32_t, uint32_t>& new_offsets, byte* out) {
+  if (items.empty()) {
+    return;
+  }
+  uint32_t begin = items.front().offset;
+  uint32_t end = items.back().offset + items.back().size;
+  memset(out + begin, 0, end - begin);
+  for (const LayoutItem& item : items) {
+    memcpy(out + new_offsets.Get(item.offset), in + item.offset, item.size);
+  }
+}
+
+}  // namespace
+
+bool DexLayout::Layout(const DexFile& dex_file, const std::vector<uint32_t>& method_tiers,
+                       std::vector<uint8_t>* out) {
+  CHECK_EQ(method_tiers.size(), dex_file.NumMethodIds());
+  const byte* begin = dex_file.Begin();
+
+  // Find the tiers of the code items and strings, and the code_offs to rewrite.
+  std::vector<uint32_t> string_tiers(dex_file.NumStringIds(), std::numeric_limits<uint32_t>::max());
+  auto use_string = [&string_tiers](uint32_t string_idx, uint32_t tier) {
+    string_tiers[string_idx] = std::min(string_tiers[string_idx], tier);
+  };
+  SafeMap<uint32_t, uint32_t> code_item_tiers;
+  std::vector<CodeOffRef> code_off_refs;
+  for (size_t class_def_index = 0; class_def_index != dex_file.NumClassDefs(); ++class_def_index) {
+    const DexFile::ClassDef& class_def = dex_file.GetClassDef(class_def_index);
+    if (class_def.class_data_off_ == 0u) {
+      continue;
+    }
+    const byte* ptr = begin + class_def.class_data_off_;
+    uint32_t num_fields = DecodeUnsignedLeb128(&ptr);
+    num_fields += DecodeUnsignedLeb128(&ptr);
+    uint32_t num_direct_methods = DecodeUnsignedLeb128(&ptr);
+    uint32_t num_methods = num_direct_methods + DecodeUnsignedLeb128(&ptr);
+    for (uint32_t i = 0; i != num_fields; ++i) {
+      DecodeUnsignedLeb128(&ptr);  // field_idx_diff
+      DecodeUnsignedLeb128(&ptr);  // access_flags
+    }
+    uint32_t method_idx = 0u;
+    for (uint32_t i = 0; i != num_methods; ++i) {
+      if (i == num_direct_methods) {
+        method_idx = 0u;  // The index differences start again with the virtual methods.
+      }
+      method_idx += DecodeUnsignedLeb128(&ptr);
+      DecodeUnsignedLeb128(&ptr);  // access_flags
+      const byte* code_off_ptr = ptr;
+      uint32_t code_off = DecodeUnsignedLeb128(&ptr);
+      if (code_off == 0u) {
+        continue;
+      }
+      CodeOffRef ref = { static_cast<uint32_t>(code_off_ptr - begin),
+                         static_cast<uint32_t>(ptr - code_off_ptr), code_off };
+      code_off_refs.push_back(ref);
+      uint32_t tier = method_tiers[method_idx];
+      auto it = code_item_tiers.find(code_off);
+      if (it == code_item_tiers.end()) {
+        code_item_tiers.Put(code_off, tier);
+      } else {
+        it->second = std::min(it->second, tier);
+      }
+      const DexFile::MethodId& method_id = dex_file.GetMethodId(method_idx);
+      use_string(method_id.name_idx_, tier);
+      use_string(dex_file.GetTypeId(method_id.class_idx_).descriptor_idx_, tier);
+      const DexFile::CodeItem* code_item = dex_file.GetCodeItem(code_off);
+      const uint16_t* insns = code_item->insns_;
+      const uint16_t* insns_end = insns + code_item->insns_size_in_code_units_;
+      while (insns < insns_end) {
+        const Instruction* inst = Instruction::At(insns);
+        if (inst->Opcode() == Instruction::CONST_STRING) {
+          use_string(inst->VRegB_21c(), tier);
+        } else if (inst->Opcode() == Instruction::CONST_STRING_JUMBO) {
+          use_string(inst->VRegB_31c(), tier);
+        }
+        insns += inst->SizeInCodeUnits();
+      }
+    }
+  }
+
+  std::vector<LayoutItem> code_items;
+  for (const auto& entry : code_item_tiers) {
+    LayoutItem item = { entry.first,
+                        static_cast<uint32_t>(CodeItemSize(*dex_file.GetCodeItem(entry.first))),
+                        entry.second };
+    code_items.push_back(item);
+  }
+  std::vector<LayoutItem> string_data_items;
+  for (size_t string_idx = 0; string_idx != dex_file.NumStringIds(); ++string_idx) {
+    uint32_t offset = dex_file.GetStringId(string_idx).string_data_off_;
+    LayoutItem item = { offset, static_cast<uint32_t>(StringDataSize(begin + offset)),
+                        string_tiers[string_idx] };
+    string_data_items.push_back(item);
+  }
+  std::sort(string_data_items.begin(), string_data_items.end(),
+            [](const LayoutItem& lhs, const LayoutItem& rhs) { return lhs.offset < rhs.offset; });
+
+  SafeMap<uint32_t, uint32_t> code_item_offsets;
+  SafeMap<uint32_t, uint32_t> string_data_offsets;
+  if (!LayoutSection(FindMapItem(dex_file, DexFile::kDexTypeCodeItem), 4u, code_items,
+                     &code_item_offsets) ||
+      !LayoutSection(FindMapItem(dex_file, DexFile::kDexTypeStringDataItem), 1u,
+                     string_data_items, &string_data_offsets)) {
+    return false;
+  }
+  for (const CodeOffRef& ref : code_off_refs) {
+    if (UnsignedLeb128Size(code_item_offsets.Get(ref.code_off)) > ref.length) {
+      return false;
+    }
+  }
+
+  out->assign(begin, begin + dex_file.GetHeader().file_size_);
+  byte* out_begin = &(*out)[0];
+  CopySection(begin, code_items, code_item_offsets, out_begin);
+  CopySection(begin, string_data_items, string_data_offsets, out_begin);
+  DexFile::StringId* string_ids =
+      reinterpret_cast<DexFile::StringId*>(out_begin + dex_file.GetHeader().string_ids_off_);
+  for (size_t string_idx = 0; string_idx != dex_file.NumStringIds(); ++string_idx) {
+    string_ids[string_idx].string_data_off_ =
+        string_data_offsets.Get(string_ids[string_idx].string_data_off_);
+  }
+  for (const CodeOffRef& ref : code_off_refs) {
+    // Keep the length of the ULEB128 with continuation bits, so that nothing else moves.
+    uint32_t value = code_item_offsets.Get(ref.code_off);
+    byte* ptr = out_begin + ref.position;
+    for (uint32_t i = 0; i != ref.length; ++i) {
+      ptr[i] = (value & 0x7f) | ((i + 1 != ref.length) ? 0x80 : 0);
+      value >>= 7;
+    }
+  }
+  DexFile::Header* header = reinterpret_cast<DexFile::Header*>(out_begin);
+  const size_t non_sum = sizeof(header->magic_) + sizeof(header->checksum_);
+  header->checksum_ = adler32(adler32(0L, Z_NULL, 0), out_begin + non_sum, out->size() - non_sum);
+  return true;
+}
+
+}  // namespace art
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_DEX_LAYOUT_H_
+#define ART_COMPILER_DEX_LAYOUT_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "base/macros.h"
+
+namespace art {
+
+class DexFile;
+
+// Lays out a copy of a dex file for the way the app runs, which dx doesn't know about: the code
+// items of the hot methods, and the string data of the strings they use, go to the front of their
+// sections, so that running them faults in fewer pages of the dex file. Items only move within
+// their sections, so the map list and the ids keep their places. The class_data_items keep their
+// size, their code_off values are rewritten with the same number of bytes.
+class DexLayout {
+ public:
+  // Writes the laid out copy of dex_file to out. method_tiers holds a tier for each method id,
+  // the code items of the lower tiers come first and the order within a tier is kept. A string
+  // gets the lowest tier of the methods whose code or name uses it. Returns false if dex_file
+  // can't be laid out this way, e.g. when a code_off doesn't fit in its bytes any more.
+  static bool Layout(const DexFile& dex_file, const std::vector<uint32_t>& method_tiers,
+                     std::vector<uint8_t>* out);
+
+ private:
+  DISALLOW_IMPLICIT_CONSTRUCTORS(DexLayout);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_DEX_LAYOUT_H_
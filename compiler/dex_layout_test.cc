@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dex_layout.h"
+
+#include <string.h>
+#include <algorithm>
+#include <memory>
+
+#include "common_runtime_test.h"
+#include "dex_file-inl.h"
+#include "dex_file_verifier.h"
+
+namespace art {
+
+class DexLayoutTest : public CommonRuntimeTest {};
+
+TEST_F(DexLayoutTest, LayoutKeepsContents) {
+  ScopedObjectAccess soa(Thread::Current());
+  const DexFile* dex_file = OpenTestDexFile("ExceptionHandle");
+  // The methods with the higher ids first, so that most code items and strings move.
+  std::vector<uint32_t> method_tiers(dex_file->NumMethodIds());
+  for (uint32_t method_idx = 0; method_idx != method_tiers.size(); ++method_idx) {
+    method_tiers[method_idx] = method_tiers.size() - method_idx;
+  }
+  std::vector<uint8_t> data;
+  ASSERT_TRUE(DexLayout::Layout(*dex_file, method_tiers, &data));
+  ASSERT_EQ(dex_file->GetHeader().file_size_, data.size());
+  EXPECT_NE(0, memcmp(dex_file->Begin(), &data[0], data.size()));
+
+  std::string error_msg;
+  std::unique_ptr<const DexFile> laid_out(DexFile::Open(&data[0], data.size(),
+                                                        dex_file->GetLocation(),
+                                                        dex_file->GetLocationChecksum(), nullptr,
+                                                        &error_msg));
+  ASSERT_TRUE(laid_out.get() != nullptr) << error_msg;
+  ASSERT_TRUE(DexFileVerifier::Verify(laid_out.get(), &data[0], data.size(),
+                                      dex_file->GetLocation().c_str(), &error_msg)) << error_msg;
+
+  for (uint32_t string_idx = 0; string_idx != dex_file->NumStringIds(); ++string_idx) {
+    EXPECT_STREQ(dex_file->StringDataByIdx(string_idx), laid_out->StringDataByIdx(string_idx));
+  }
+  uint32_t num_code_items = 0u;
+  uint32_t first_code_off = 0u;
+  uint32_t last_code_off = 0u;
+  // Of the method with code with the highest id, which is in the lowest tier.
+  uint32_t max_method_idx = 0u;
+  uint32_t max_method_code_off = 0u;
+  uint32_t max_method_laid_out_code_off = 0u;
+  for (size_t class_def_index = 0; class_def_index != dex_file->NumClassDefs();
+       ++class_def_index) {
+    const byte* class_data = dex_file->GetClassData(dex_file->GetClassDef(class_def_index));
+    const byte* laid_out_class_data =
+        laid_out->GetClassData(laid_out->GetClassDef(class_def_index));
+    if (class_data == nullptr) {
+      EXPECT_TRUE(laid_out_class_data == nullptr);
+      continue;
+    }
+    ClassDataItemIterator it(*dex_file, class_data);
+    ClassDataItemIterator laid_out_it(*laid_out, laid_out_class_data);
+    while (it.HasNextStaticField() || it.HasNextInstanceField()) {
+      it.Next();
+      laid_out_it.Next();
+    }
+    while (it.HasNextDirectMethod() || it.HasNextVirtualMethod()) {
+      ASSERT_TRUE(laid_out_it.HasNext());
+      EXPECT_EQ(it.GetMemberIndex(), laid_out_it.GetMemberIndex());
+      const DexFile::CodeItem* code_item = it.GetMethodCodeItem();
+      const DexFile::CodeItem* laid_out_code_item = laid_out_it.GetMethodCodeItem();
+      if (code_item == nullptr) {
+        EXPECT_TRUE(laid_out_code_item == nullptr);
+      } else {
+        ASSERT_TRUE(laid_out_code_item != nullptr);
+        ASSERT_EQ(code_item->insns_size_in_code_units_,
+                  laid_out_code_item->insns_size_in_code_units_);
+        EXPECT_EQ(code_item->tries_size_, laid_out_code_item->tries_size_);
+        EXPECT_EQ(0, memcmp(code_item->insns_, laid_out_code_item->insns_,
+                            code_item->insns_size_in_code_units_ * sizeof(uint16_t)));
+        uint32_t code_off = it.GetMethodCodeItemOffset();
+        if (num_code_items == 0u || code_off < first_code_off) {
+          first_code_off = code_off;
+        }
+        last_code_off = std::max(last_code_off, code_off);
+        if (num_code_items == 0u || it.GetMemberIndex() > max_method_idx) {
+          max_method_idx = it.GetMemberIndex();
+          max_method_code_off = code_off;
+          max_method_laid_out_code_off = laid_out_it.GetMethodCodeItemOffset();
+        }
+        ++num_code_items;
+      }
+      it.Next();
+      laid_out_it.Next();
+    }
+  }
+  ASSERT_NE(0u, num_code_items);
+  // Its code item comes first, unless it was the last one, which stays last if it ends unaligned.
+  if (max_method_code_off != last_code_off) {
+    EXPECT_EQ(first_code_off, max_method_laid_out_code_off);
+  }
+}
+
+}  // namespace art
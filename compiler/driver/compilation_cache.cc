@@ -0,0 +1,607 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compilation_cache.h"
+
+#include <dlfcn.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "base/stringprintf.h"
+#include "base/unix_file/fd_file.h"
+#include "compiled_method.h"
+#include "dex/pass_driver.h"
+#include "driver/compiler_driver.h"
+#include "driver/compiler_options.h"
+#include "driver/incremental_compilation.h"
+#include "gc/heap.h"
+#include "gc/space/image_space.h"
+#include "oat.h"
+#include "os.h"
+#include "runtime.h"
+#include "utils.h"
+
+namespace art {
+
+static constexpr uint8_t kEntryMagic[] = { 'c', 'c', 'h', '\n' };
+static constexpr uint8_t kEntryVersion[] = { '0', '0', '1', '\0' };
+
+// Two 64-bit hashes of the same data, FNV-1a and a multiply-xorshift one, so that a collision
+// of both, which would make a method use the code of another, is unlikely.
+class KeyHasher {
+ public:
+  KeyHasher() : hash1_(UINT64_C(0xcbf29ce484222325)), hash2_(UINT64_C(0x9e3779b97f4a7c15)) {
+  }
+
+  void Update(const void* data, size_t size) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    for (size_t i = 0; i != size; ++i) {
+      hash1_ = (hash1_ ^ bytes[i]) * UINT64_C(0x100000001b3);
+      hash2_ = (hash2_ ^ bytes[i]) * UINT64_C(0xff51afd7ed558ccd);
+      hash2_ ^= hash2_ >> 29;
+    }
+  }
+
+  // Integers are hashed in little-endian order, so that keys do not depend on the host.
+  void Update(uint64_t value) {
+    uint8_t bytes[8];
+    for (size_t i = 0; i != 8u; ++i) {
+      bytes[i] = static_cast<uint8_t>(value >> (8u * i));
+    }
+    Update(bytes, sizeof(bytes));
+  }
+
+  void Update(const char* string) {
+    Update(string, strlen(string) + 1u);
+  }
+
+  void Update(const CompilationCache::Key& key) {
+    Update(key.hash1);
+    Update(key.hash2);
+  }
+
+  CompilationCache::Key Finish() const {
+    CompilationCache::Key key = { hash1_, hash2_ };
+    return key;
+  }
+
+ private:
+  uint64_t hash1_;
+  uint64_t hash2_;
+};
+
+static bool operator<(const CompilationCache::Key& lhs, const CompilationCache::Key& rhs) {
+  return (lhs.hash1 != rhs.hash1) ? lhs.hash1 < rhs.hash1 : lhs.hash2 < rhs.hash2;
+}
+
+static bool operator==(const CompilationCache::Key& lhs, const CompilationCache::Key& rhs) {
+  return lhs.hash1 == rhs.hash1 && lhs.hash2 == rhs.hash2;
+}
+
+static void HashTypeList(const DexFile::TypeList* list, KeyHasher* hasher) {
+  size_t size = (list != nullptr) ? list->Size() : 0u;
+  hasher->Update(static_cast<uint64_t>(size));
+  for (size_t i = 0; i != size; ++i) {
+    hasher->Update(static_cast<uint64_t>(list->GetTypeItem(i).type_idx_));
+  }
+}
+
+// Hash what IncrementalCompilation::HaveSameIds() compares.
+static CompilationCache::Key HashIds(const DexFile& dex_file) {
+  KeyHasher hasher;
+  hasher.Update(static_cast<uint64_t>(dex_file.NumStringIds()));
+  for (size_t i = 0; i != dex_file.NumStringIds(); ++i) {
+    hasher.Update(dex_file.StringDataByIdx(i));
+  }
+  hasher.Update(static_cast<uint64_t>(dex_file.NumTypeIds()));
+  for (size_t i = 0; i != dex_file.NumTypeIds(); ++i) {
+    hasher.Update(static_cast<uint64_t>(dex_file.GetTypeId(i).descriptor_idx_));
+  }
+  hasher.Update(static_cast<uint64_t>(dex_file.NumProtoIds()));
+  for (size_t i = 0; i != dex_file.NumProtoIds(); ++i) {
+    const DexFile::ProtoId& proto_id = dex_file.GetProtoId(i);
+    hasher.Update(static_cast<uint64_t>(proto_id.shorty_idx_));
+    hasher.Update(static_cast<uint64_t>(proto_id.return_type_idx_));
+    HashTypeList(dex_file.GetProtoParameters(proto_id), &hasher);
+  }
+  hasher.Update(static_cast<uint64_t>(dex_file.NumFieldIds()));
+  for (size_t i = 0; i != dex_file.NumFieldIds(); ++i) {
+    const DexFile::FieldId& field_id = dex_file.GetFieldId(i);
+    hasher.Update(static_cast<uint64_t>(field_id.class_idx_));
+    hasher.Update(static_cast<uint64_t>(field_id.type_idx_));
+    hasher.Update(static_cast<uint64_t>(field_id.name_idx_));
+  }
+  hasher.Update(static_cast<uint64_t>(dex_file.NumMethodIds()));
+  for (size_t i = 0; i != dex_file.NumMethodIds(); ++i) {
+    const DexFile::MethodId& method_id = dex_file.GetMethodId(i);
+    hasher.Update(static_cast<uint64_t>(method_id.class_idx_));
+    hasher.Update(static_cast<uint64_t>(method_id.proto_idx_));
+    hasher.Update(static_cast<uint64_t>(method_id.name_idx_));
+  }
+  return hasher.Finish();
+}
+
+static void HashCode(const DexFile::CodeItem* code_item, KeyHasher* hasher) {
+  if (code_item == nullptr) {
+    hasher->Update(UINT64_C(0));
+    return;
+  }
+  hasher->Update(UINT64_C(1));
+  hasher->Update(static_cast<uint64_t>(code_item->registers_size_));
+  hasher->Update(static_cast<uint64_t>(code_item->ins_size_));
+  hasher->Update(static_cast<uint64_t>(code_item->outs_size_));
+  hasher->Update(static_cast<uint64_t>(code_item->insns_size_in_code_units_));
+  for (uint32_t i = 0; i != code_item->insns_size_in_code_units_; ++i) {
+    hasher->Update(static_cast<uint64_t>(code_item->insns_[i]));
+  }
+  hasher->Update(static_cast<uint64_t>(code_item->tries_size_));
+  for (uint32_t i = 0; i != code_item->tries_size_; ++i) {
+    const DexFile::TryItem* try_item = DexFile::GetTryItems(*code_item, i);
+    hasher->Update(static_cast<uint64_t>(try_item->start_addr_));
+    hasher->Update(static_cast<uint64_t>(try_item->insn_count_));
+    for (CatchHandlerIterator it(*code_item, *try_item); it.HasNext(); it.Next()) {
+      hasher->Update(static_cast<uint64_t>(it.GetHandlerTypeIndex()));
+      hasher->Update(static_cast<uint64_t>(it.GetHandlerAddress()));
+    }
+    hasher->Update(static_cast<uint64_t>(DexFile::kDexNoIndex));
+  }
+}
+
+// Hash what IncrementalCompilation::HaveSameClassDef() compares, and the ids giving meaning to
+// the indices of the class definition.
+static CompilationCache::Key HashClassDef(const DexFile& dex_file,
+                                          const CompilationCache::Key& ids_key,
+                                          const DexFile::ClassDef& class_def) {
+  KeyHasher hasher;
+  hasher.Update(ids_key);
+  hasher.Update(static_cast<uint64_t>(class_def.class_idx_));
+  hasher.Update(static_cast<uint64_t>(class_def.access_flags_));
+  hasher.Update(static_cast<uint64_t>(class_def.superclass_idx_));
+  HashTypeList(dex_file.GetInterfacesList(class_def), &hasher);
+  const byte* class_data = dex_file.GetClassData(class_def);
+  if (class_data != nullptr) {
+    ClassDataItemIterator it(dex_file, class_data);
+    hasher.Update(static_cast<uint64_t>(it.NumStaticFields()));
+    hasher.Update(static_cast<uint64_t>(it.NumInstanceFields()));
+    hasher.Update(static_cast<uint64_t>(it.NumDirectMethods()));
+    hasher.Update(static_cast<uint64_t>(it.NumVirtualMethods()));
+    for (; it.HasNext(); it.Next()) {
+      hasher.Update(static_cast<uint64_t>(it.GetMemberIndex()));
+      hasher.Update(static_cast<uint64_t>(it.GetMemberAccessFlags()));
+      if (it.HasNextDirectMethod() || it.HasNextVirtualMethod()) {
+        HashCode(it.GetMethodCodeItem(), &hasher);
+      }
+    }
+  }
+  return hasher.Finish();
+}
+
+// The compiler library or executable containing this function.
+static bool HashCompilerBinary(KeyHasher* hasher) {
+  Dl_info info;
+  if (dladdr(reinterpret_cast<void*>(&HashCompilerBinary), &info) == 0 ||
+      info.dli_fname == nullptr) {
+    LOG(WARNING) << "Failed to find the compiler binary";
+    return false;
+  }
+  std::unique_ptr<File> file(OS::OpenFileForReading(info.dli_fname));
+  if (file.get() == nullptr) {
+    PLOG(WARNING) << "Failed to open the compiler binary " << info.dli_fname;
+    return false;
+  }
+  int64_t length = file->GetLength();
+  std::vector<uint8_t> data(length > 0 ? static_cast<size_t>(length) : 0u);
+  if (length < 0 || !file->ReadFully(&data[0], data.size())) {
+    PLOG(WARNING) << "Failed to read the compiler binary " << info.dli_fname;
+    return false;
+  }
+  hasher->Update(&data[0], data.size());
+  return true;
+}
+
+CompilationCache::CompilationCache(const std::string& directory)
+    : directory_(directory),
+      enabled_(false),
+      compiler_key_(),
+      hits_(0),
+      misses_(0) {
+}
+
+CompilationCache::~CompilationCache() {
+  if (enabled_) {
+    VLOG(compiler) << "Compilation cache " << directory_ << ": " << hits_.Load() << " hits, "
+                   << misses_.Load() << " misses";
+  }
+}
+
+bool CompilationCache::ComputeCompilerKey(const CompilerDriver& driver) {
+  if (driver.IsImage() || driver.GetCompiler()->IsPortable()) {
+    LOG(WARNING) << "Not using compilation cache " << directory_
+                 << ": only the Quick code of applications is cached";
+    return false;
+  }
+  if (!OS::DirectoryExists(directory_.c_str())) {
+    LOG(WARNING) << "Not using compilation cache " << directory_ << ": no such directory";
+    return false;
+  }
+  // The code refers to the classes and methods of the boot image by address.
+  gc::space::ImageSpace* image_space = Runtime::Current()->GetHeap()->GetImageSpace();
+  if (image_space == nullptr) {
+    LOG(WARNING) << "Not using compilation cache " << directory_ << ": no boot image";
+    return false;
+  }
+  KeyHasher hasher;
+  hasher.Update(kEntryVersion, sizeof(kEntryVersion));
+  hasher.Update(OatHeader::kOatVersion, sizeof(OatHeader::kOatVersion));
+  if (!HashCompilerBinary(&hasher)) {
+    return false;
+  }
+  hasher.Update(static_cast<uint64_t>(driver.GetInstructionSet()));
+  hasher.Update(driver.GetInstructionSetFeatures().GetFeatureString().c_str());
+  const CompilerOptions& options = driver.GetCompilerOptions();
+  hasher.Update(static_cast<uint64_t>(options.GetCompilerFilter()));
+  hasher.Update(static_cast<uint64_t>(options.GetHugeMethodThreshold()));
+  hasher.Update(static_cast<uint64_t>(options.GetLargeMethodThreshold()));
+  hasher.Update(static_cast<uint64_t>(options.GetSmallMethodThreshold()));
+  hasher.Update(static_cast<uint64_t>(options.GetTinyMethodThreshold()));
+  hasher.Update(static_cast<uint64_t>(options.GetNumDexMethodsThreshold()));
+  hasher.Update(static_cast<uint64_t>(options.GetGenerateGDBInformation()));
+  hasher.Update(PassDriver::GetDefaultPassListNames().c_str());
+  hasher.Update(static_cast<uint64_t>(image_space->GetImageHeader().GetOatChecksum()));
+  // The profile guides inlining and inline caches.
+  hasher.Update(static_cast<uint64_t>(driver.ProfilePresent()));
+  if (driver.ProfilePresent()) {
+    for (const auto& entry : driver.GetProfileMap()) {
+      const ProfileData& data = entry.second;
+      uint64_t used_percent;
+      uint64_t top_k_used_percentage;
+      double value = data.GetUsedPercent();
+      memcpy(&used_percent, &value, sizeof(used_percent));
+      value = data.GetTopKUsedPercentage();
+      memcpy(&top_k_used_percentage, &value, sizeof(top_k_used_percentage));
+      hasher.Update(entry.first.c_str());
+      hasher.Update(static_cast<uint64_t>(data.GetCount()));
+      hasher.Update(used_percent);
+      hasher.Update(top_k_used_percentage);
+      for (const auto& call_site : data.GetCallSites()) {
+        hasher.Update(static_cast<uint64_t>(call_site.first));
+        for (const auto& receiver : call_site.second) {
+          hasher.Update(receiver.first.c_str());
+          hasher.Update(static_cast<uint64_t>(receiver.second));
+        }
+      }
+    }
+  }
+  compiler_key_ = hasher.Finish();
+  return true;
+}
+
+void CompilationCache::ComputeClassKeys(const CompilerDriver& driver, jobject class_loader,
+                                        const std::vector<const DexFile*>& dex_files) {
+  enabled_ = ComputeCompilerKey(driver);
+  if (!enabled_) {
+    return;
+  }
+
+  // The classes of the class path, the first definition of each descriptor, which is the one
+  // the compiler resolves. The classes of the boot class path are those of the boot image.
+  std::vector<ClassReference> classes;
+  std::vector<Key> content_keys;
+  SafeMap<std::string, size_t> class_indexes;
+  const std::vector<const DexFile*>& class_path = (class_loader != nullptr)
+      ? Runtime::Current()->GetCompileTimeClassPath(class_loader)
+      : dex_files;
+  for (const DexFile* dex_file : class_path) {
+    Key ids_key = HashIds(*dex_file);
+    for (size_t i = 0; i != dex_file->NumClassDefs(); ++i) {
+      const DexFile::ClassDef& class_def = dex_file->GetClassDef(i);
+      std::string descriptor(dex_file->GetClassDescriptor(class_def));
+      if (class_indexes.find(descriptor) == class_indexes.end()) {
+        class_indexes.Put(descriptor, classes.size());
+        classes.push_back(ClassReference(dex_file, i));
+        content_keys.push_back(HashClassDef(*dex_file, ids_key, class_def));
+      }
+    }
+  }
+  size_t num_classes = classes.size();
+  std::vector<std::vector<size_t>> dependencies(num_classes);
+  for (size_t index = 0; index != num_classes; ++index) {
+    const DexFile& dex_file = *classes[index].first;
+    std::vector<const char*> descriptors;
+    IncrementalCompilation::GetClassDependencies(
+        dex_file, dex_file.GetClassDef(classes[index].second), &descriptors);
+    for (const char* descriptor : descriptors) {
+      auto it = class_indexes.find(descriptor);
+      if (it != class_indexes.end()) {
+        dependencies[index].push_back(it->second);
+      }
+    }
+  }
+
+  // The dependencies of a class may form cycles. Tarjan's algorithm finds the strongly connected
+  // components of the dependency graph after those they depend on, so that the key of each
+  // component hashes the keys of its members and of the components they depend on.
+  static constexpr size_t kNotVisited = static_cast<size_t>(-1);
+  std::vector<size_t> visit_index(num_classes, kNotVisited);
+  std::vector<size_t> low_link(num_classes);
+  std::vector<size_t> component(num_classes, kNotVisited);
+  std::vector<Key> component_keys;
+  std::vector<size_t> stack;
+  std::vector<std::pair<size_t, size_t>> visits;  // The class and its next dependency.
+  size_t next_visit_index = 0u;
+  for (size_t root = 0; root != num_classes; ++root) {
+    if (visit_index[root] != kNotVisited) {
+      continue;
+    }
+    visit_index[root] = low_link[root] = next_visit_index++;
+    stack.push_back(root);
+    visits.push_back(std::make_pair(root, 0u));
+    while (!visits.empty()) {
+      size_t index = visits.back().first;
+      if (visits.back().second != dependencies[index].size()) {
+        size_t dependency = dependencies[index][visits.back().second++];
+        if (visit_index[dependency] == kNotVisited) {
+          visit_index[dependency] = low_link[dependency] = next_visit_index++;
+          stack.push_back(dependency);
+          visits.push_back(std::make_pair(dependency, 0u));
+        } else if (component[dependency] == kNotVisited) {
+          low_link[index] = std::min(low_link[index], visit_index[dependency]);
+        }
+        continue;
+      }
+      visits.pop_back();
+      if (!visits.empty()) {
+        size_t parent = visits.back().first;
+        low_link[parent] = std::min(low_link[parent], low_link[index]);
+      }
+      if (low_link[index] != visit_index[index]) {
+        continue;
+      }
+      size_t current = component_keys.size();
+      std::vector<size_t> members;
+      do {
+        members.push_back(stack.back());
+        component[stack.back()] = current;
+        stack.pop_back();
+      } while (members.back() != index);
+      std::vector<Key> member_keys;
+      std::vector<Key> dependency_keys;
+      for (size_t member : members) {
+        member_keys.push_back(content_keys[member]);
+        for (size_t dependency : dependencies[member]) {
+          if (component[dependency] != current) {
+            dependency_keys.push_back(component_keys[component[dependency]]);
+          }
+        }
+      }
+      std::sort(member_keys.begin(), member_keys.end());
+      std::sort(dependency_keys.begin(), dependency_keys.end());
+      dependency_keys.erase(std::unique(dependency_keys.begin(), dependency_keys.end()),
+                            dependency_keys.end());
+      KeyHasher hasher;
+      hasher.Update(static_cast<uint64_t>(member_keys.size()));
+      for (const Key& key : member_keys) {
+        hasher.Update(key);
+      }
+      hasher.Update(static_cast<uint64_t>(dependency_keys.size()));
+      for (const Key& key : dependency_keys) {
+        hasher.Update(key);
+      }
+      component_keys.push_back(hasher.Finish());
+    }
+  }
+
+  for (size_t index = 0; index != num_classes; ++index) {
+    if (std::find(dex_files.begin(), dex_files.end(), classes[index].first) != dex_files.end()) {
+      KeyHasher hasher;
+      hasher.Update(content_keys[index]);
+      hasher.Update(component_keys[component[index]]);
+      class_keys_.Put(classes[index], hasher.Finish());
+    }
+  }
+}
+
+bool CompilationCache::GetMethodKey(const DexFile& dex_file, uint16_t class_def_idx,
+                                    uint32_t method_idx, Key* key) const {
+  if (!enabled_) {
+    return false;
+  }
+  auto it = class_keys_.find(ClassReference(&dex_file, class_def_idx));
+  if (it == class_keys_.end()) {
+    return false;  // Another definition of the class comes first in the class path.
+  }
+  KeyHasher hasher;
+  hasher.Update(compiler_key_);
+  hasher.Update(it->second);
+  hasher.Update(static_cast<uint64_t>(method_idx));
+  *key = hasher.Finish();
+  return true;
+}
+
+std::string CompilationCache::GetEntryFileName(const Key& key) const {
+  return StringPrintf("%s/%016" PRIx64 "%016" PRIx64, directory_.c_str(), key.hash1, key.hash2);
+}
+
+static void AppendUint32(uint32_t value, std::vector<uint8_t>* data) {
+  for (size_t i = 0; i != 4u; ++i) {
+    data->push_back(static_cast<uint8_t>(value >> (8u * i)));
+  }
+}
+
+static void AppendUint64(uint64_t value, std::vector<uint8_t>* data) {
+  AppendUint32(static_cast<uint32_t>(value), data);
+  AppendUint32(static_cast<uint32_t>(value >> 32), data);
+}
+
+static void AppendTable(const std::vector<uint8_t>& table, std::vector<uint8_t>* data) {
+  AppendUint32(table.size(), data);
+  data->insert(data->end(), table.begin(), table.end());
+}
+
+// Reads the data of an entry, in the order of Insert().
+class EntryReader {
+ public:
+  explicit EntryReader(const std::vector<uint8_t>& data)
+      : pos_(data.empty() ? nullptr : &data[0]), end_(pos_ + data.size()) {
+  }
+
+  bool ReadBytes(const uint8_t* expected, size_t size) {
+    if (static_cast<size_t>(end_ - pos_) < size || memcmp(pos_, expected, size) != 0) {
+      return false;
+    }
+    pos_ += size;
+    return true;
+  }
+
+  bool ReadUint32(uint32_t* value) {
+    if (end_ - pos_ < 4) {
+      return false;
+    }
+    *value = 0u;
+    for (size_t i = 0; i != 4u; ++i) {
+      *value |= static_cast<uint32_t>(*pos_++) << (8u * i);
+    }
+    return true;
+  }
+
+  bool ReadUint64(uint64_t* value) {
+    uint32_t low;
+    uint32_t high;
+    if (!ReadUint32(&low) || !ReadUint32(&high)) {
+      return false;
+    }
+    *value = (static_cast<uint64_t>(high) << 32) | low;
+    return true;
+  }
+
+  bool ReadTable(std::vector<uint8_t>* table) {
+    uint32_t size;
+    if (!ReadUint32(&size) || static_cast<size_t>(end_ - pos_) < size) {
+      return false;
+    }
+    table->assign(pos_, pos_ + size);
+    pos_ += size;
+    return true;
+  }
+
+  bool AtEnd() const {
+    return pos_ == end_;
+  }
+
+ private:
+  const uint8_t* pos_;
+  const uint8_t* const end_;
+};
+
+CompiledMethod* CompilationCache::Lookup(CompilerDriver* driver, const DexFile& dex_file,
+                                         uint16_t class_def_idx, uint32_t method_idx) {
+  Key key;
+  if (!GetMethodKey(dex_file, class_def_idx, method_idx, &key)) {
+    return nullptr;
+  }
+  std::string file_name = GetEntryFileName(key);
+  std::unique_ptr<File> file(OS::OpenFileForReading(file_name.c_str()));
+  if (file.get() == nullptr) {
+    ++misses_;
+    return nullptr;
+  }
+  int64_t length = file->GetLength();
+  std::vector<uint8_t> data(length > 0 ? static_cast<size_t>(length) : 0u);
+  if (length < 0 || (length != 0 && !file->ReadFully(&data[0], data.size()))) {
+    PLOG(WARNING) << "Failed to read compilation cache entry " << file_name;
+    ++misses_;
+    return nullptr;
+  }
+  EntryReader reader(data);
+  Key entry_key;
+  uint32_t frame_size_in_bytes;
+  uint32_t core_spill_mask;
+  uint32_t fp_spill_mask;
+  std::vector<uint8_t> quick_code;
+  std::vector<uint8_t> mapping_table;
+  std::vector<uint8_t> vmap_table;
+  std::vector<uint8_t> native_gc_map;
+  uint32_t has_cfi_info;
+  std::vector<uint8_t> cfi_info;
+  if (!reader.ReadBytes(kEntryMagic, sizeof(kEntryMagic)) ||
+      !reader.ReadBytes(kEntryVersion, sizeof(kEntryVersion)) ||
+      !reader.ReadUint64(&entry_key.hash1) || !reader.ReadUint64(&entry_key.hash2) ||
+      !(entry_key == key) ||
+      !reader.ReadUint32(&frame_size_in_bytes) || !reader.ReadUint32(&core_spill_mask) ||
+      !reader.ReadUint32(&fp_spill_mask) || !reader.ReadTable(&quick_code) ||
+      !reader.ReadTable(&mapping_table) || !reader.ReadTable(&vmap_table) ||
+      !reader.ReadTable(&native_gc_map) || !reader.ReadUint32(&has_cfi_info) ||
+      (has_cfi_info != 0u && !reader.ReadTable(&cfi_info)) || !reader.AtEnd() ||
+      quick_code.empty()) {
+    LOG(WARNING) << "Ignoring corrupt compilation cache entry " << file_name;
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  return new CompiledMethod(driver, driver->GetInstructionSet(), quick_code, frame_size_in_bytes,
+                            core_spill_mask, fp_spill_mask, mapping_table, vmap_table,
+                            native_gc_map, (has_cfi_info != 0u) ? &cfi_info : nullptr);
+}
+
+void CompilationCache::Insert(const DexFile& dex_file, uint16_t class_def_idx,
+                              uint32_t method_idx, const CompiledMethod& compiled_method) {
+  Key key;
+  if (compiled_method.GetQuickCode() == nullptr ||
+      !GetMethodKey(dex_file, class_def_idx, method_idx, &key)) {
+    return;
+  }
+  std::vector<uint8_t> data(kEntryMagic, kEntryMagic + sizeof(kEntryMagic));
+  data.insert(data.end(), kEntryVersion, kEntryVersion + sizeof(kEntryVersion));
+  AppendUint64(key.hash1, &data);
+  AppendUint64(key.hash2, &data);
+  AppendUint32(compiled_method.GetFrameSizeInBytes(), &data);
+  AppendUint32(compiled_method.GetCoreSpillMask(), &data);
+  AppendUint32(compiled_method.GetFpSpillMask(), &data);
+  AppendTable(*compiled_method.GetQuickCode(), &data);
+  AppendTable(compiled_method.GetMappingTable(), &data);
+  AppendTable(compiled_method.GetVmapTable(), &data);
+  AppendTable(compiled_method.GetGcMap(), &data);
+  const std::vector<uint8_t>* cfi_info = compiled_method.GetCFIInfo();
+  AppendUint32((cfi_info != nullptr) ? 1u : 0u, &data);
+  if (cfi_info != nullptr) {
+    AppendTable(*cfi_info, &data);
+  }
+
+  // Write to a temporary file and rename it so that readers never see a partial entry.
+  std::string file_name = GetEntryFileName(key);
+  std::string temp_file_name = StringPrintf("%s.%d.%d.tmp", file_name.c_str(), getpid(), GetTid());
+  std::unique_ptr<File> file(OS::CreateEmptyFile(temp_file_name.c_str()));
+  if (file.get() == nullptr) {
+    PLOG(WARNING) << "Failed to create compilation cache entry " << temp_file_name;
+    return;
+  }
+  if (!file->WriteFully(&data[0], data.size()) || file->Close() != 0) {
+    PLOG(WARNING) << "Failed to write compilation cache entry " << temp_file_name;
+    unlink(temp_file_name.c_str());
+    return;
+  }
+  if (rename(temp_file_name.c_str(), file_name.c_str()) != 0) {
+    PLOG(WARNING) << "Failed to rename " << temp_file_name << " to " << file_name;
+    unlink(temp_file_name.c_str());
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_DRIVER_COMPILATION_CACHE_H_
+#define ART_COMPILER_DRIVER_COMPILATION_CACHE_H_
+
+#include <string>
+#include <vector>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "class_reference.h"
+#include "dex_file.h"
+#include "jni.h"
+#include "safe_map.h"
+
+namespace art {
+
+class CompiledMethod;
+class CompilerDriver;
+
+// A cache of the Quick code of methods in a directory, shared by dex2oat invocations that
+// compile the same dex files, e.g. the same libraries in different builds.
+//
+// The code of a method depends on more than its code item, so the key of a method hashes:
+//  - the compiler binary, its options and passes, the instruction set features, the profile
+//    and the boot image the code refers to by address;
+//  - the ids of the dex file of the method, which give meaning to the indices in its code;
+//  - the definition and code of its class and, transitively, of every class of the class path
+//    it depends on through its superclass, interfaces and code.
+// Each entry is written to a temporary file and renamed, so concurrent compilations may share
+// the directory.
+class CompilationCache {
+ public:
+  struct Key {
+    uint64_t hash1;
+    uint64_t hash2;
+  };
+
+  explicit CompilationCache(const std::string& directory);
+  ~CompilationCache();
+
+  // Compute the keys of the classes of the dex files to compile. Must be called before the
+  // dex-to-dex compiler modifies them. Disables the cache if the compilation cannot use it.
+  void ComputeClassKeys(const CompilerDriver& driver, jobject class_loader,
+                        const std::vector<const DexFile*>& dex_files);
+
+  // Returns the cached code of the method, or nullptr if there is none.
+  CompiledMethod* Lookup(CompilerDriver* driver, const DexFile& dex_file, uint16_t class_def_idx,
+                         uint32_t method_idx);
+
+  // Adds the code of the method to the cache.
+  void Insert(const DexFile& dex_file, uint16_t class_def_idx, uint32_t method_idx,
+              const CompiledMethod& compiled_method);
+
+ private:
+  bool ComputeCompilerKey(const CompilerDriver& driver);
+  bool GetMethodKey(const DexFile& dex_file, uint16_t class_def_idx, uint32_t method_idx,
+                    Key* key) const;
+  std::string GetEntryFileName(const Key& key) const;
+
+  const std::string directory_;
+  bool enabled_;
+  // The hash of everything the code depends on besides the classes of the class path.
+  Key compiler_key_;
+  // The keys of the classes to compile.
+  SafeMap<ClassReference, Key> class_keys_;
+
+  AtomicInteger hits_;
+  AtomicInteger misses_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompilationCache);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_DRIVER_COMPILATION_CACHE_H_
@@ -109,8 +109,10 @@ inline std::pair<bool, bool> CompilerDriver::IsFastInstanceField(
 inline std::pair<bool, bool> CompilerDriver::IsFastStaticField(
     mirror::DexCache* dex_cache, mirror::Class* referrer_class,
     mirror::ArtField* resolved_field, uint16_t field_idx, MemberOffset* field_offset,
-    uint32_t* storage_index, bool* is_referrers_class, bool* is_initialized) {
+    uint32_t* storage_index, bool* is_referrers_class, bool* is_initialized,
+    uintptr_t* direct_storage_ptr) {
   DCHECK(resolved_field->IsStatic());
+  *direct_storage_ptr = 0u;
   if (LIKELY(referrer_class != nullptr)) {
     mirror::Class* fields_class = resolved_field->GetDeclaringClass();
     if (fields_class == referrer_class) {
@@ -150,8 +152,12 @@ inline std::pair<bool, bool> CompilerDriver::IsFastStaticField(
         *field_offset = resolved_field->GetOffset();
         *storage_index = storage_idx;
         *is_referrers_class = false;
-        *is_initialized = fields_class->IsInitialized() &&
-            CanAssumeTypeIsPresentInDexCache(*dex_file, storage_idx);
+        *is_initialized = (fields_class->IsInitialized() &&
+            CanAssumeTypeIsPresentInDexCache(*dex_file, storage_idx)) ||
+            IsSuperclassResolvedWithReferrer(dex_cache, referrer_class, fields_class);
+        if (!*is_initialized) {
+          *direct_storage_ptr = GetInitializedBootImageClassAddress(fields_class);
+        }
         return std::make_pair(true, !resolved_field->IsFinal());
       }
     }
@@ -19,8 +19,12 @@
 #define ATRACE_TAG ATRACE_TAG_DALVIK
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <functional>
+#include <limits>
 #include <vector>
 #include <unistd.h>
+#include <zlib.h>
 
 #include "base/stl_util.h"
 #include "base/timing_logger.h"
@@ -32,7 +36,9 @@
 #include "dex/verification_results.h"
 #include "dex/verified_method.h"
 #include "dex/quick/dex_file_method_inliner.h"
+#include "driver/compilation_cache.h"
 #include "driver/compiler_options.h"
+#include "driver/incremental_compilation.h"
 #include "jni_internal.h"
 #include "object_utils.h"
 #include "runtime.h"
@@ -84,7 +90,8 @@ class CompilerDriver::AOTCompilationStats {
         resolved_instance_fields_(0), unresolved_instance_fields_(0),
         resolved_local_static_fields_(0), resolved_static_fields_(0), unresolved_static_fields_(0),
         type_based_devirtualization_(0),
-        safe_casts_(0), not_safe_casts_(0) {
+        safe_casts_(0), not_safe_casts_(0),
+        peak_arena_bytes_(0) {
     for (size_t i = 0; i <= kMaxInvokeType; i++) {
       resolved_methods_[i] = 0;
       unresolved_methods_[i] = 0;
@@ -138,6 +145,10 @@ class CompilerDriver::AOTCompilationStats {
                  oss2.str().c_str());
       }
     }
+    if (peak_arena_bytes_ != 0) {
+      LOG(INFO) << "Peak arena memory of a method: " << PrettySize(peak_arena_bytes_) << " for "
+                << peak_arena_method_;
+    }
   }
 
 // Allow lossy statistics in non-debug builds.
@@ -281,6 +292,15 @@ class CompilerDriver::AOTCompilationStats {
     not_safe_casts_++;
   }
 
+  // The compilation of a method used the given arena memory at its peak.
+  void ArenaUsage(const DexFile& dex_file, uint32_t method_idx, size_t bytes) {
+    MutexLock mu(Thread::Current(), stats_lock_);
+    if (bytes > peak_arena_bytes_) {
+      peak_arena_bytes_ = bytes;
+      peak_arena_method_ = PrettyMethod(method_idx, dex_file);
+    }
+  }
+
  private:
   Mutex stats_lock_;
 
@@ -311,6 +331,9 @@ class CompilerDriver::AOTCompilationStats {
   size_t safe_casts_;
   size_t not_safe_casts_;
 
+  size_t peak_arena_bytes_;
+  std::string peak_arena_method_;
+
   DISALLOW_COPY_AND_ASSIGN(AOTCompilationStats);
 };
 
@@ -324,6 +347,19 @@ extern "C" art::CompiledMethod* ArtCompileDEX(art::CompilerDriver& compiler,
                                               jobject class_loader,
                                               const art::DexFile& dex_file);
 
+// The number of shards of the dedupe sets when the options leave it to the driver. All the
+// compiler threads add the code and tables of every method they compile to them, a few shards
+// per thread keep them from contending on the shard locks.
+static constexpr size_t kDedupeShardsPerThread = 4;
+
+static size_t DedupeShards(const CompilerOptions* compiler_options, size_t thread_count) {
+  size_t dedupe_shards = compiler_options->GetDedupeShards();
+  if (dedupe_shards != 0) {
+    return dedupe_shards;
+  }
+  return RoundUpToPowerOfTwo(std::max<size_t>(thread_count, 1) * kDedupeShardsPerThread);
+}
+
 CompilerDriver::CompilerDriver(const CompilerOptions* compiler_options,
                                VerificationResults* verification_results,
                                DexFileToMethodInlinerMap* method_inliner_map,
@@ -336,6 +372,7 @@ CompilerDriver::CompilerDriver(const CompilerOptions* compiler_options,
     : profile_ok_(false), compiler_options_(compiler_options),
       verification_results_(verification_results),
       method_inliner_map_(method_inliner_map),
+      compiler_kind_(compiler_kind),
       compiler_(Compiler::Create(this, compiler_kind)),
       instruction_set_(instruction_set),
       instruction_set_features_(instruction_set_features),
@@ -344,8 +381,14 @@ CompilerDriver::CompilerDriver(const CompilerOptions* compiler_options,
       compiled_methods_lock_("compiled method lock"),
       image_(image),
       image_classes_(image_classes),
+      class_hierarchy_analyzed_(false),
       thread_count_(thread_count),
       start_ns_(0),
+      wall_time_budget_ns_(0u),
+      cpu_time_budget_ns_(0u),
+      compile_all_start_ns_(0u),
+      method_stats_enabled_(false),
+      method_stats_lock_("method stats lock"),
       stats_(new AOTCompilationStats),
       dump_stats_(dump_stats),
       dump_passes_(dump_passes),
@@ -356,11 +399,11 @@ CompilerDriver::CompilerDriver(const CompilerOptions* compiler_options,
       compiler_get_method_code_addr_(NULL),
       support_boot_image_fixup_(instruction_set != kMips),
       cfi_info_(nullptr),
-      dedupe_code_("dedupe code"),
-      dedupe_mapping_table_("dedupe mapping table"),
-      dedupe_vmap_table_("dedupe vmap table"),
-      dedupe_gc_map_("dedupe gc map"),
-      dedupe_cfi_info_("dedupe cfi info") {
+      dedupe_code_("dedupe code", DedupeShards(compiler_options, thread_count)),
+      dedupe_mapping_table_("dedupe mapping table", DedupeShards(compiler_options, thread_count)),
+      dedupe_vmap_table_("dedupe vmap table", DedupeShards(compiler_options, thread_count)),
+      dedupe_gc_map_("dedupe gc map", DedupeShards(compiler_options, thread_count)),
+      dedupe_cfi_info_("dedupe cfi info", DedupeShards(compiler_options, thread_count)) {
   DCHECK(compiler_options_ != nullptr);
   DCHECK(verification_results_ != nullptr);
   DCHECK(method_inliner_map_ != nullptr);
@@ -376,7 +419,9 @@ CompilerDriver::CompilerDriver(const CompilerOptions* compiler_options,
 
   compiler_->Init();
 
-  CHECK(!Runtime::Current()->IsStarted());
+  // Ahead-of-time compilation happens before the runtime starts, only the JIT compiles methods
+  // of a started runtime.
+  CHECK(!Runtime::Current()->IsStarted() || !Runtime::Current()->IsCompiler());
   if (image_) {
     CHECK(image_classes_.get() != nullptr);
   } else {
@@ -384,7 +429,8 @@ CompilerDriver::CompilerDriver(const CompilerOptions* compiler_options,
   }
 
   // Are we generating CFI information?
-  if (compiler_options->GetGenerateGDBInformation()) {
+  if (compiler_options->GetGenerateGDBInformation() ||
+      compiler_options->GetGenerateMiniDebugInfo()) {
     cfi_info_.reset(compiler_->GetCallFrameInformationInitialization(*this));
   }
 }
@@ -412,6 +458,25 @@ std::vector<uint8_t>* CompilerDriver::DeduplicateCFIInfo(const std::vector<uint8
   return dedupe_cfi_info_.Add(Thread::Current(), *cfi_info);
 }
 
+uint32_t CompilerDriver::GetCompilerOptionsChecksum() const {
+  const CompilerOptions& options = *compiler_options_;
+  const uint32_t values[] = {
+    static_cast<uint32_t>(compiler_kind_),
+    static_cast<uint32_t>(options.GetCompilerFilter()),
+    static_cast<uint32_t>(options.GetHugeMethodThreshold()),
+    static_cast<uint32_t>(options.GetLargeMethodThreshold()),
+    static_cast<uint32_t>(options.GetSmallMethodThreshold()),
+    static_cast<uint32_t>(options.GetTinyMethodThreshold()),
+    static_cast<uint32_t>(options.GetNumDexMethodsThreshold()),
+    options.GetGenerateGDBInformation(),
+    options.GetGenerateMiniDebugInfo(),
+    options.GetIncludeOsrEntries(),
+    options.GetPortableVectorize(),
+    options.GetConditionalCardMarks(),
+  };
+  return adler32(adler32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(values), sizeof(values));
+}
+
 CompilerDriver::~CompilerDriver() {
   Thread* self = Thread::Current();
   {
@@ -502,14 +567,47 @@ void CompilerDriver::CompileAll(jobject class_loader,
                                 const std::vector<const DexFile*>& dex_files,
                                 TimingLogger* timings) {
   DCHECK(!Runtime::Current()->IsStarted());
+  compile_all_start_ns_ = NanoTime();
   std::unique_ptr<ThreadPool> thread_pool(new ThreadPool("Compiler driver thread pool", thread_count_ - 1));
+  if (compiler_options_->GetPinCompilerThreads()) {
+    thread_pool->PinWorkers();
+  }
   PreCompile(class_loader, dex_files, thread_pool.get(), timings);
+  if (incremental_compilation_.get() != nullptr) {
+    timings->NewSplit("Find reusable classes");
+    incremental_compilation_->FindReusableClasses(*this, class_loader, dex_files);
+  }
+  if (compilation_cache_.get() != nullptr) {
+    timings->NewSplit("Compute compilation cache keys");
+    compilation_cache_->ComputeClassKeys(*this, class_loader, dex_files);
+  }
   Compile(class_loader, dex_files, thread_pool.get(), timings);
   if (dump_stats_) {
     stats_->Dump();
   }
 }
 
+void CompilerDriver::SetPreviousOatFile(const OatFile* previous_oat_file) {
+  incremental_compilation_.reset(new IncrementalCompilation(previous_oat_file));
+}
+
+void CompilerDriver::SetCompilationCacheDirectory(const std::string& directory) {
+  compilation_cache_.reset(new CompilationCache(directory));
+}
+
+void CompilerDriver::SetCompileTimeBudget(uint64_t wall_time_ms, uint64_t cpu_time_ms) {
+  wall_time_budget_ns_ = MsToNs(wall_time_ms);
+  cpu_time_budget_ns_ = MsToNs(cpu_time_ms);
+}
+
+bool CompilerDriver::IsCompileTimeBudgetExhausted() const {
+  if (wall_time_budget_ns_ != 0u && NanoTime() - compile_all_start_ns_ >= wall_time_budget_ns_) {
+    return true;
+  }
+  return cpu_time_budget_ns_ != 0u &&
+      static_cast<uint64_t>(compile_cpu_time_ns_.Load()) >= cpu_time_budget_ns_;
+}
+
 static DexToDexCompilationLevel GetDexToDexCompilationlevel(
     Thread* self, Handle<mirror::ClassLoader>& class_loader, const DexFile& dex_file,
     const DexFile::ClassDef& class_def) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
@@ -590,6 +688,42 @@ void CompilerDriver::CompileOne(mirror::ArtMethod* method, TimingLogger* timings
   self->TransitionFromSuspendedToRunnable();
 }
 
+CompiledMethod* CompilerDriver::CompileMethodForJit(const DexFile::CodeItem* code_item,
+                                                    uint32_t access_flags,
+                                                    InvokeType invoke_type,
+                                                    uint16_t class_def_idx,
+                                                    uint32_t method_idx,
+                                                    jobject class_loader,
+                                                    const DexFile& dex_file) {
+  DCHECK(Runtime::Current()->IsStarted());
+  // No DEX-to-DEX fallback: it would rewrite the dex code the interpreter is running.
+  CompileMethod(code_item, access_flags, invoke_type, class_def_idx, method_idx, class_loader,
+                dex_file, kDontDexToDexCompile);
+  // The method goes to the caller rather than to an oat file, don't keep it.
+  MutexLock mu(Thread::Current(), compiled_methods_lock_);
+  MethodTable::iterator it = compiled_methods_.find(MethodReference(&dex_file, method_idx));
+  if (it == compiled_methods_.end()) {
+    return nullptr;
+  }
+  CompiledMethod* compiled_method = it->second;
+  compiled_methods_.erase(it);
+  return compiled_method;
+}
+
+void CompilerDriver::FreeCompiledMethodForJit(CompiledMethod* compiled_method) {
+  Thread* self = Thread::Current();
+  if (kIsDebugBuild) {
+    MutexLock mu(self, compiled_methods_lock_);
+    DCHECK(compiled_methods_.empty());
+  }
+  delete compiled_method;
+  dedupe_code_.Clear(self);
+  dedupe_mapping_table_.Clear(self);
+  dedupe_vmap_table_.Clear(self);
+  dedupe_gc_map_.Clear(self);
+  dedupe_cfi_info_.Clear(self);
+}
+
 void CompilerDriver::Resolve(jobject class_loader, const std::vector<const DexFile*>& dex_files,
                              ThreadPool* thread_pool, TimingLogger* timings) {
   for (size_t i = 0; i != dex_files.size(); ++i) {
@@ -615,6 +749,8 @@ void CompilerDriver::PreCompile(jobject class_loader, const std::vector<const De
   InitializeClasses(class_loader, dex_files, thread_pool, timings);
 
   UpdateImageClasses(timings);
+
+  AnalyzeClassHierarchy(timings);
 }
 
 bool CompilerDriver::IsImageClass(const char* descriptor) const {
@@ -808,6 +944,53 @@ void CompilerDriver::UpdateImageClasses(TimingLogger* timings) {
   }
 }
 
+static bool RecordOverriddenMethodsVisitor(mirror::Class* klass, void* arg)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  std::set<MethodReference, MethodReferenceComparator>* overridden_methods =
+      reinterpret_cast<std::set<MethodReference, MethodReferenceComparator>*>(arg);
+  mirror::Class* super_class = klass->GetSuperClass();
+  if (super_class == nullptr || klass->IsInterface() || !klass->IsResolved()) {
+    return true;
+  }
+  mirror::ObjectArray<mirror::ArtMethod>* vtable = klass->GetVTable();
+  mirror::ObjectArray<mirror::ArtMethod>* super_vtable = super_class->GetVTable();
+  if (vtable == nullptr || super_vtable == nullptr) {
+    return true;
+  }
+  // The class overrides exactly the methods whose vtable entries differ from its superclass'.
+  for (int32_t i = 0; i < super_vtable->GetLength(); ++i) {
+    mirror::ArtMethod* super_method = super_vtable->Get(i);
+    if (vtable->Get(i) != super_method) {
+      mirror::DexCache* dex_cache = super_method->GetDeclaringClass()->GetDexCache();
+      if (dex_cache != nullptr) {
+        overridden_methods->insert(
+            MethodReference(dex_cache->GetDexFile(), super_method->GetDexMethodIndex()));
+      }
+    }
+  }
+  return true;
+}
+
+void CompilerDriver::AnalyzeClassHierarchy(TimingLogger* timings) {
+  timings->NewSplit("AnalyzeClassHierarchy");
+  ScopedObjectAccess soa(Thread::Current());
+  overridden_methods_.clear();
+  Runtime::Current()->GetClassLinker()->VisitClasses(RecordOverriddenMethodsVisitor,
+                                                     &overridden_methods_);
+  class_hierarchy_analyzed_ = true;
+  VLOG(compiler) << "Class hierarchy analysis found " << overridden_methods_.size()
+                 << " overridden methods";
+}
+
+bool CompilerDriver::IsMethodOverridden(mirror::ArtMethod* resolved_method) const {
+  if (!class_hierarchy_analyzed_ || resolved_method->IsAbstract()) {
+    return true;
+  }
+  const DexFile* dex_file = resolved_method->GetDeclaringClass()->GetDexCache()->GetDexFile();
+  MethodReference ref(dex_file, resolved_method->GetDexMethodIndex());
+  return overridden_methods_.find(ref) != overridden_methods_.end();
+}
+
 bool CompilerDriver::CanAssumeTypeIsPresentInDexCache(const DexFile& dex_file, uint32_t type_idx) {
   if (IsImage() &&
       IsImageClass(dex_file.StringDataByIdx(dex_file.GetTypeId(type_idx).descriptor_idx_))) {
@@ -968,6 +1151,29 @@ bool CompilerDriver::CanEmbedTypeInCode(const DexFile& dex_file, uint32_t type_i
   }
 }
 
+bool CompilerDriver::CanEmbedStringInCode(const DexFile& dex_file, uint32_t string_idx,
+                                          uintptr_t* direct_string_ptr) {
+  if (Runtime::Current()->GetHeap()->IsCompilingBoot()) {
+    // The strings of the image being compiled don't have their final address yet.
+    return false;
+  }
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<1> hs(soa.Self());
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  Handle<mirror::DexCache> dex_cache(hs.NewHandle(class_linker->FindDexCache(dex_file)));
+  mirror::String* resolved_string = class_linker->ResolveString(dex_file, string_idx, dex_cache);
+  if (resolved_string == nullptr) {
+    soa.Self()->ClearException();
+    return false;
+  }
+  // The strings of the image are interned, the string resolves to the same one at runtime.
+  if (!Runtime::Current()->GetHeap()->FindSpaceFromObject(resolved_string, false)->IsImageSpace()) {
+    return false;
+  }
+  *direct_string_ptr = reinterpret_cast<uintptr_t>(resolved_string);
+  return true;
+}
+
 void CompilerDriver::ProcessedInstanceField(bool resolved) {
   if (!resolved) {
     stats_->UnresolvedInstanceField();
@@ -990,6 +1196,45 @@ void CompilerDriver::ProcessedInvoke(InvokeType invoke_type, int flags) {
   stats_->ProcessedInvoke(invoke_type, flags);
 }
 
+void CompilerDriver::RecordArenaUsage(const DexFile& dex_file, uint32_t method_idx,
+                                      size_t bytes) {
+  stats_->ArenaUsage(dex_file, method_idx, bytes);
+  if (method_stats_enabled_) {
+    MethodReference ref(&dex_file, method_idx);
+    MutexLock mu(Thread::Current(), method_stats_lock_);
+    MethodStats stats;
+    auto it = method_stats_.find(ref);
+    if (it != method_stats_.end()) {
+      stats = it->second;
+    }
+    stats.arena_bytes = std::max(stats.arena_bytes, bytes);
+    method_stats_.Overwrite(ref, stats);
+  }
+}
+
+void CompilerDriver::DumpMethodStats(std::ostream& os) const {
+  std::vector<std::pair<std::string, MethodStats>> lines;
+  {
+    MutexLock mu(Thread::Current(), method_stats_lock_);
+    for (const auto& entry : method_stats_) {
+      if (entry.second.code_bytes != 0u) {
+        lines.push_back(std::make_pair(PrettyMethod(entry.first.dex_method_index,
+                                                    *entry.first.dex_file),
+                                       entry.second));
+      }
+    }
+  }
+  std::sort(lines.begin(), lines.end(),
+            [](const std::pair<std::string, MethodStats>& lhs,
+               const std::pair<std::string, MethodStats>& rhs) {
+    return lhs.first < rhs.first;
+  });
+  for (const auto& line : lines) {
+    os << line.second.compile_time_ns << " " << line.second.arena_bytes << " "
+       << line.second.code_bytes << " " << line.first << "\n";
+  }
+}
+
 bool CompilerDriver::ComputeInstanceFieldInfo(uint32_t field_idx, const DexCompilationUnit* mUnit,
                                               bool is_put, MemberOffset* field_offset,
                                               bool* is_volatile) {
@@ -1052,9 +1297,10 @@ bool CompilerDriver::ComputeStaticFieldInfo(uint32_t field_idx, const DexCompila
   bool result = false;
   if (resolved_field != nullptr && referrer_class != nullptr) {
     *is_volatile = IsFieldVolatile(resolved_field);
+    uintptr_t direct_storage_ptr;  // Unused, the class is loaded from the dex cache.
     std::pair<bool, bool> fast_path = IsFastStaticField(
         dex_cache, referrer_class, resolved_field, field_idx, field_offset,
-        storage_index, is_referrers_class, is_initialized);
+        storage_index, is_referrers_class, is_initialized, &direct_storage_ptr);
     result = is_put ? fast_path.second : fast_path.first;
   }
   if (!result) {
@@ -1069,6 +1315,32 @@ bool CompilerDriver::ComputeStaticFieldInfo(uint32_t field_idx, const DexCompila
   return result;
 }
 
+bool CompilerDriver::IsSuperclassResolvedWithReferrer(mirror::DexCache* dex_cache,
+                                                      mirror::Class* referrer_class,
+                                                      mirror::Class* klass) {
+  // Initializing a class initializes its superclasses first, and linking a class resolves its
+  // superclass in the class's dex cache.
+  for (mirror::Class* k = referrer_class; k->GetDexCache() == dex_cache; ) {
+    k = k->GetSuperClass();
+    if (k == nullptr) {
+      return false;
+    }
+    if (k == klass) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uintptr_t CompilerDriver::GetInitializedBootImageClassAddress(mirror::Class* klass) {
+  // The classes of the boot image being compiled don't have their final address yet.
+  if (Runtime::Current()->GetHeap()->IsCompilingBoot() || !klass->IsInitialized()) {
+    return 0u;
+  }
+  gc::space::Space* space = Runtime::Current()->GetHeap()->FindSpaceFromObject(klass, false);
+  return space->IsImageSpace() ? reinterpret_cast<uintptr_t>(klass) : 0u;
+}
+
 void CompilerDriver::GetCodeAndMethodForDirectCall(InvokeType* type, InvokeType sharp_type,
                                                    bool no_guarantee_of_dex_cache_entry,
                                                    mirror::Class* referrer_class,
@@ -1750,6 +2022,8 @@ static void InitializeClass(const ParallelCompilationManager* manager, size_t cl
                   << exception->Dump();
               soa.Self()->ClearException();
               transaction.Abort();
+              // The interpreter may have cached fields of classes whose initialization got undone.
+              soa.Self()->GetInterpreterCache()->Clear();
               CHECK_EQ(old_status, klass->GetStatus()) << "Previous class status not restored";
             }
             soa.Self()->EndAssertNoThreadSuspension(old_casue);
@@ -1797,17 +2071,34 @@ void CompilerDriver::InitializeClasses(jobject class_loader,
 
 void CompilerDriver::Compile(jobject class_loader, const std::vector<const DexFile*>& dex_files,
                              ThreadPool* thread_pool, TimingLogger* timings) {
-  for (size_t i = 0; i != dex_files.size(); ++i) {
-    const DexFile* dex_file = dex_files[i];
-    CHECK(dex_file != NULL);
-    CompileDexFile(class_loader, *dex_file, thread_pool, timings);
+  if (wall_time_budget_ns_ != 0u || cpu_time_budget_ns_ != 0u) {
+    CompileWithinBudget(class_loader, dex_files, thread_pool, timings);
+  } else {
+    for (size_t i = 0; i != dex_files.size(); ++i) {
+      const DexFile* dex_file = dex_files[i];
+      CHECK(dex_file != NULL);
+      CompileDexFile(class_loader, *dex_file, thread_pool, timings);
+    }
   }
+  // The arenas are not needed again until the next compilation, if any.
+  arena_pool_.TrimMaps();
 }
 
 void CompilerDriver::CompileClass(const ParallelCompilationManager* manager, size_t class_def_index) {
+  CompileClassMethods(manager, *manager->GetDexFile(), class_def_index, 0u,
+                      std::numeric_limits<size_t>::max());
+}
+
+void CompilerDriver::CompileWork(const ParallelCompilationManager* manager, size_t work_index) {
+  const CompilationWork& work = manager->GetCompiler()->compilation_work_[work_index];
+  CompileClassMethods(manager, *work.dex_file, work.class_def_index, work.begin, work.end);
+}
+
+void CompilerDriver::CompileClassMethods(const ParallelCompilationManager* manager,
+                                         const DexFile& dex_file, size_t class_def_index,
+                                         size_t begin, size_t end) {
   ATRACE_CALL();
   jobject jclass_loader = manager->GetClassLoader();
-  const DexFile& dex_file = *manager->GetDexFile();
   const DexFile::ClassDef& class_def = dex_file.GetClassDef(class_def_index);
   ClassLinker* class_linker = manager->GetClassLinker();
   if (SkipClass(class_linker, jclass_loader, dex_file, class_def)) {
@@ -1843,17 +2134,22 @@ void CompilerDriver::CompileClass(const ParallelCompilationManager* manager, siz
     it.Next();
   }
   CompilerDriver* driver = manager->GetCompiler();
+  size_t position = 0u;
   // Compile direct methods
   int64_t previous_direct_method_idx = -1;
   while (it.HasNextDirectMethod()) {
     uint32_t method_idx = it.GetMemberIndex();
-    if (method_idx == previous_direct_method_idx) {
+    if (method_idx == previous_direct_method_idx || position < begin || position >= end) {
       // smali can create dex files with two encoded_methods sharing the same method_idx
       // http://code.google.com/p/smali/issues/detail?id=119
+      // Methods out of the range are compiled by another piece of work.
+      previous_direct_method_idx = method_idx;
+      ++position;
       it.Next();
       continue;
     }
     previous_direct_method_idx = method_idx;
+    ++position;
     driver->CompileMethod(it.GetMethodCodeItem(), it.GetMemberAccessFlags(),
                           it.GetMethodInvokeType(class_def), class_def_index,
                           method_idx, jclass_loader, dex_file, dex_to_dex_compilation_level);
@@ -1863,13 +2159,17 @@ void CompilerDriver::CompileClass(const ParallelCompilationManager* manager, siz
   int64_t previous_virtual_method_idx = -1;
   while (it.HasNextVirtualMethod()) {
     uint32_t method_idx = it.GetMemberIndex();
-    if (method_idx == previous_virtual_method_idx) {
+    if (method_idx == previous_virtual_method_idx || position < begin || position >= end) {
       // smali can create dex files with two encoded_methods sharing the same method_idx
       // http://code.google.com/p/smali/issues/detail?id=119
+      // Methods out of the range are compiled by another piece of work.
+      previous_virtual_method_idx = method_idx;
+      ++position;
       it.Next();
       continue;
     }
     previous_virtual_method_idx = method_idx;
+    ++position;
     driver->CompileMethod(it.GetMethodCodeItem(), it.GetMemberAccessFlags(),
                           it.GetMethodInvokeType(class_def), class_def_index,
                           method_idx, jclass_loader, dex_file, dex_to_dex_compilation_level);
@@ -1883,7 +2183,153 @@ void CompilerDriver::CompileDexFile(jobject class_loader, const DexFile& dex_fil
   timings->NewSplit("Compile Dex File");
   ParallelCompilationManager context(Runtime::Current()->GetClassLinker(), class_loader, this,
                                      &dex_file, thread_pool);
-  context.ForAll(0, dex_file.NumClassDefs(), CompilerDriver::CompileClass, thread_count_);
+  if (thread_count_ == 1) {
+    context.ForAll(0, dex_file.NumClassDefs(), CompilerDriver::CompileClass, thread_count_);
+    return;
+  }
+  // Hand the most costly work out first, so that the threads do not end up waiting for one of
+  // them to compile a large class.
+  EstimateCompilationWork(dex_file);
+  context.ForAll(0, compilation_work_.size(), CompilerDriver::CompileWork, thread_count_);
+  compilation_work_.clear();
+}
+
+// The cost of compiling a method, in code units, over its code size.
+static constexpr uint32_t kMethodCompilationOverhead = 16u;
+// The number of pieces of work each thread gets, on average, that a class is split into
+// pieces of, when its cost is larger.
+static constexpr uint32_t kCompilationWorkPerThread = 8u;
+// The cost below which classes are not split.
+static constexpr uint32_t kMinSplitCompilationCost = 1024u;
+
+void CompilerDriver::GetMethodCosts(const DexFile& dex_file,
+                                    std::vector<std::vector<uint32_t>>* method_costs,
+                                    uint64_t* total_cost) {
+  method_costs->resize(dex_file.NumClassDefs());
+  for (size_t class_def_index = 0; class_def_index != dex_file.NumClassDefs(); ++class_def_index) {
+    const byte* class_data = dex_file.GetClassData(dex_file.GetClassDef(class_def_index));
+    if (class_data == nullptr) {
+      continue;
+    }
+    ClassDataItemIterator it(dex_file, class_data);
+    while (it.HasNextStaticField() || it.HasNextInstanceField()) {
+      it.Next();
+    }
+    while (it.HasNextDirectMethod() || it.HasNextVirtualMethod()) {
+      const DexFile::CodeItem* code_item = it.GetMethodCodeItem();
+      uint32_t cost = kMethodCompilationOverhead +
+          ((code_item != nullptr) ? code_item->insns_size_in_code_units_ : 0u);
+      (*method_costs)[class_def_index].push_back(cost);
+      *total_cost += cost;
+      it.Next();
+    }
+  }
+}
+
+void CompilerDriver::AddCompilationWork(const DexFile& dex_file, uint32_t class_def_index,
+                                        const std::vector<uint32_t>& method_costs,
+                                        uint64_t max_work_cost, bool with_hotness) {
+  if (method_costs.empty()) {
+    return;
+  }
+  std::vector<double> hotness(method_costs.size(), 0.0);
+  if (with_hotness && profile_ok_) {
+    const byte* class_data = dex_file.GetClassData(dex_file.GetClassDef(class_def_index));
+    ClassDataItemIterator it(dex_file, class_data);
+    while (it.HasNextStaticField() || it.HasNextInstanceField()) {
+      it.Next();
+    }
+    for (size_t position = 0; it.HasNextDirectMethod() || it.HasNextVirtualMethod(); ++position) {
+      auto data = profile_map_.find(PrettyMethod(it.GetMemberIndex(), dex_file));
+      if (data != profile_map_.end()) {
+        hotness[position] = data->second.GetUsedPercent();
+      }
+      it.Next();
+    }
+  }
+  CompilationWork work = { &dex_file, class_def_index, 0u, 0u, 0u, 0.0 };
+  for (size_t position = 0; position != method_costs.size(); ++position) {
+    uint32_t cost = method_costs[position];
+    if (work.cost != 0u && (work.cost + cost > max_work_cost || hotness[position] != 0.0)) {
+      compilation_work_.push_back(work);
+      work.begin = work.end;
+      work.cost = 0u;
+    }
+    work.end++;
+    work.cost += cost;
+    if (hotness[position] != 0.0) {
+      work.hotness = hotness[position];
+      compilation_work_.push_back(work);
+      work.begin = work.end;
+      work.cost = 0u;
+      work.hotness = 0.0;
+    }
+  }
+  if (work.cost != 0u) {
+    compilation_work_.push_back(work);
+  }
+}
+
+void CompilerDriver::EstimateCompilationWork(const DexFile& dex_file) {
+  DCHECK(compilation_work_.empty());
+  // The costs of the methods, in the order CompileClassMethods() counts them, by class def.
+  std::vector<std::vector<uint32_t>> method_costs;
+  uint64_t total_cost = 0u;
+  GetMethodCosts(dex_file, &method_costs, &total_cost);
+
+  // Split the classes costing more than a piece of work.
+  uint64_t max_work_cost = std::max<uint64_t>(
+      total_cost / (thread_count_ * kCompilationWorkPerThread), kMinSplitCompilationCost);
+  for (size_t class_def_index = 0; class_def_index != dex_file.NumClassDefs(); ++class_def_index) {
+    AddCompilationWork(dex_file, class_def_index, method_costs[class_def_index], max_work_cost,
+                       false);
+  }
+  std::stable_sort(compilation_work_.begin(), compilation_work_.end(),
+                   [](const CompilationWork& lhs, const CompilationWork& rhs) {
+                     return lhs.cost > rhs.cost;
+                   });
+}
+
+void CompilerDriver::CompileWithinBudget(jobject class_loader,
+                                         const std::vector<const DexFile*>& dex_files,
+                                         ThreadPool* thread_pool, TimingLogger* timings) {
+  timings->NewSplit("Compile Within Budget");
+  DCHECK(compilation_work_.empty());
+  std::vector<std::vector<std::vector<uint32_t>>> method_costs(dex_files.size());
+  uint64_t total_cost = 0u;
+  for (size_t i = 0; i != dex_files.size(); ++i) {
+    CHECK(dex_files[i] != nullptr);
+    GetMethodCosts(*dex_files[i], &method_costs[i], &total_cost);
+  }
+  uint64_t max_work_cost = std::max<uint64_t>(
+      total_cost / (thread_count_ * kCompilationWorkPerThread), kMinSplitCompilationCost);
+  for (size_t i = 0; i != dex_files.size(); ++i) {
+    for (size_t class_def_index = 0; class_def_index != dex_files[i]->NumClassDefs();
+         ++class_def_index) {
+      AddCompilationWork(*dex_files[i], class_def_index, method_costs[i][class_def_index],
+                         max_work_cost, true);
+    }
+  }
+  // The hottest methods of all the dex files first, then the cheapest work so that as many
+  // methods as possible are compiled before the budget runs out. The order of the work is
+  // that of the compilation with one thread, and close to it with more.
+  std::stable_sort(compilation_work_.begin(), compilation_work_.end(),
+                   [](const CompilationWork& lhs, const CompilationWork& rhs) {
+                     if (lhs.hotness != rhs.hotness) {
+                       return lhs.hotness > rhs.hotness;
+                     }
+                     return lhs.cost < rhs.cost;
+                   });
+  ParallelCompilationManager context(Runtime::Current()->GetClassLinker(), class_loader, this,
+                                     nullptr, thread_pool);
+  context.ForAll(0, compilation_work_.size(), CompilerDriver::CompileWork, thread_count_);
+  compilation_work_.clear();
+  if (methods_over_budget_.Load() != 0) {
+    LOG(INFO) << "Compile-time budget exhausted after " << PrettyDuration(NanoTime() -
+              compile_all_start_ns_) << " and " << PrettyDuration(compile_cpu_time_ns_.Load())
+              << " of CPU time compiling methods, " << methods_over_budget_.Load()
+              << " methods left to the interpreter";
+  }
 }
 
 void CompilerDriver::CompileMethod(const DexFile::CodeItem* code_item, uint32_t access_flags,
@@ -1907,10 +2353,31 @@ void CompilerDriver::CompileMethod(const DexFile::CodeItem* code_item, uint32_t
   } else {
     MethodReference method_ref(&dex_file, method_idx);
     bool compile = verification_results_->IsCandidateForCompilation(method_ref, access_flags);
+    if (compile && incremental_compilation_.get() != nullptr) {
+      compiled_method = incremental_compilation_->ReuseCompiledMethod(this, dex_file,
+                                                                      class_def_idx, method_idx);
+      compile = (compiled_method == nullptr);
+    }
+    if (compile && compilation_cache_.get() != nullptr) {
+      compiled_method = compilation_cache_->Lookup(this, dex_file, class_def_idx, method_idx);
+      compile = (compiled_method == nullptr);
+    }
+    if (compile && IsCompileTimeBudgetExhausted()) {
+      // Leave the method to the interpreter, quickened by the DEX-to-DEX compiler.
+      methods_over_budget_++;
+      compile = false;
+    }
     if (compile) {
+      uint64_t start_cpu_ns = (cpu_time_budget_ns_ != 0u) ? ThreadCpuNanoTime() : 0u;
       // NOTE: if compiler declines to compile this method, it will return NULL.
       compiled_method = compiler_->Compile(code_item, access_flags, invoke_type, class_def_idx,
                                            method_idx, class_loader, dex_file);
+      if (cpu_time_budget_ns_ != 0u) {
+        compile_cpu_time_ns_.FetchAndAdd(ThreadCpuNanoTime() - start_cpu_ns);
+      }
+      if (compiled_method != nullptr && compilation_cache_.get() != nullptr) {
+        compilation_cache_->Insert(dex_file, class_def_idx, method_idx, *compiled_method);
+      }
     }
     if (compiled_method == nullptr && dex_to_dex_compilation_level != kDontDexToDexCompile) {
       // TODO: add a command-line option to disable DEX-to-DEX compilation ?
@@ -1927,6 +2394,21 @@ void CompilerDriver::CompileMethod(const DexFile::CodeItem* code_item, uint32_t
   }
 
   Thread* self = Thread::Current();
+  if (compiled_method != NULL && method_stats_enabled_) {
+    const std::vector<uint8_t>* code = (compiled_method->GetQuickCode() != nullptr)
+        ? compiled_method->GetQuickCode()
+        : compiled_method->GetPortableCode();
+    MethodReference ref(&dex_file, method_idx);
+    MutexLock mu(self, method_stats_lock_);
+    MethodStats stats;
+    auto it = method_stats_.find(ref);
+    if (it != method_stats_.end()) {
+      stats = it->second;
+    }
+    stats.compile_time_ns = duration_ns;
+    stats.code_bytes = (code != nullptr) ? code->size() : 0u;
+    method_stats_.Overwrite(ref, stats);
+  }
   if (compiled_method != NULL) {
     MethodReference ref(&dex_file, method_idx);
     DCHECK(GetCompiledMethod(ref) == NULL) << PrettyMethod(method_idx, dex_file);
@@ -2080,10 +2562,97 @@ bool CompilerDriver::SkipCompilation(const std::string& method_name) {
   if (compile) {
     LOG(INFO) << "compiling method " << method_name << " because its usage is part of top "
         << data.GetTopKUsedPercentage() << "% with a percent of " << data.GetUsedPercent() << "%";
+  } else if (HasHotCallSite(method_name)) {
+    // Calls from the interpreter into compiled code are slow, and hot calls may be inlined.
+    compile = true;
+    LOG(INFO) << "compiling method " << method_name << " because it makes hot calls";
   } else {
     VLOG(compiler) << "not compiling method " << method_name << " because it's not part of leading "
         << topKPercentThreshold << "% samples)";
   }
   return !compile;
 }
+
+bool CompilerDriver::IsHotMethod(const std::string& method_name) const {
+  if (!profile_ok_) {
+    return false;
+  }
+  // Methods that comprise kHotTopKPercent % of the total samples are hot.
+  static constexpr double kHotTopKPercent = 50.0;
+  ProfileMap::const_iterator i = profile_map_.find(method_name);
+  if (i == profile_map_.end()) {
+    return false;
+  }
+  const ProfileData& data = i->second;
+  return data.GetTopKUsedPercentage() - data.GetUsedPercent() <= kHotTopKPercent;
+}
+
+// A call site is hot when at least kHotCallEdgePercent % of the samples of a hot callee were
+// taken in calls from it.
+static constexpr uint32_t kHotCallEdgePercent = 20;
+
+static bool IsHotCallEdge(const CompilerDriver* driver, const ProfileMap& profile_map,
+                          const std::map<std::string, uint32_t>& callees) {
+  for (const auto& callee : callees) {
+    ProfileMap::const_iterator data = profile_map.find(callee.first);
+    if (data != profile_map.end() && driver->IsHotMethod(callee.first) &&
+        callee.second * 100u >= data->second.GetCount() * kHotCallEdgePercent) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool CompilerDriver::IsHotCallSite(const std::string& method_name, uint32_t dex_pc) const {
+  if (!profile_ok_) {
+    return false;
+  }
+  ProfileMap::const_iterator i = profile_map_.find(method_name);
+  if (i == profile_map_.end()) {
+    return false;
+  }
+  ProfileCallSites::const_iterator site = i->second.GetCallees().find(dex_pc);
+  return site != i->second.GetCallees().end() && IsHotCallEdge(this, profile_map_, site->second);
+}
+
+bool CompilerDriver::HasHotCallSite(const std::string& method_name) const {
+  if (!profile_ok_) {
+    return false;
+  }
+  ProfileMap::const_iterator i = profile_map_.find(method_name);
+  if (i == profile_map_.end()) {
+    return false;
+  }
+  for (const auto& site : i->second.GetCallees()) {
+    if (IsHotCallEdge(this, profile_map_, site.second)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<std::string> CompilerDriver::GetProfiledReceiverTypes(const std::string& method_name,
+                                                                  uint32_t dex_pc) const {
+  std::vector<std::string> types;
+  if (!profile_ok_) {
+    return types;
+  }
+  ProfileMap::const_iterator i = profile_map_.find(method_name);
+  if (i == profile_map_.end()) {
+    return types;
+  }
+  ProfileCallSites::const_iterator site = i->second.GetCallSites().find(dex_pc);
+  if (site == i->second.GetCallSites().end()) {
+    return types;
+  }
+  std::vector<std::pair<uint32_t, std::string>> by_count;
+  for (const auto& type : site->second) {
+    by_count.push_back(std::make_pair(type.second, type.first));
+  }
+  std::sort(by_count.begin(), by_count.end(), std::greater<std::pair<uint32_t, std::string>>());
+  for (const auto& type : by_count) {
+    types.push_back(type.second);
+  }
+  return types;
+}
 }  // namespace art
@@ -21,6 +21,7 @@
 #include <string>
 #include <vector>
 
+#include "atomic.h"
 #include "base/mutex.h"
 #include "base/timing_logger.h"
 #include "class_reference.h"
@@ -45,10 +46,13 @@ namespace verifier {
 class MethodVerifier;
 }  // namespace verifier
 
+class CompilationCache;
 class CompilerOptions;
 class DexCompilationUnit;
 class DexFileToMethodInlinerMap;
+class IncrementalCompilation;
 struct InlineIGetIPutData;
+class OatFile;
 class OatWriter;
 class ParallelCompilationManager;
 class ScopedObjectAccess;
@@ -114,10 +118,49 @@ class CompilerDriver {
                   TimingLogger* timings)
       LOCKS_EXCLUDED(Locks::mutator_lock_);
 
+  // Reuse the code of the unchanged classes of a previous compilation of the dex files. Takes
+  // ownership of the oat file. Must be called before CompileAll.
+  void SetPreviousOatFile(const OatFile* previous_oat_file);
+
+  // Look up the code of methods in, and add it to, the compilation cache in the directory.
+  // Must be called before CompileAll.
+  void SetCompilationCacheDirectory(const std::string& directory);
+
+  // Stop compiling methods, leaving the rest to the interpreter, once the wall-clock time since
+  // the start of CompileAll or the CPU time spent compiling methods reaches its budget, in
+  // milliseconds, zero meaning no budget. The methods are then compiled by decreasing profile
+  // hotness, the cheapest first where there is no profile. Must be called before CompileAll.
+  void SetCompileTimeBudget(uint64_t wall_time_ms, uint64_t cpu_time_ms);
+
+  // Record the compile time, peak arena memory and code size of each method, for
+  // DumpMethodStats. Must be called before CompileAll.
+  void EnableMethodStats() {
+    method_stats_enabled_ = true;
+  }
+
+  // Write a "<compile ns> <peak arena bytes> <code bytes> <method>" line per compiled method,
+  // sorted by method, so that the output for a fixed set of dex files can be diffed.
+  void DumpMethodStats(std::ostream& os) const LOCKS_EXCLUDED(method_stats_lock_);
+
   // Compile a single Method.
   void CompileOne(mirror::ArtMethod* method, TimingLogger* timings)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Compile a method of a class loaded in the running runtime, for the JIT. The verification
+  // results of the method must have been recorded. Returns the compiled method, which the caller
+  // frees with FreeCompiledMethodForJit once it has copied its code, or null if the compiler
+  // declined it.
+  CompiledMethod* CompileMethodForJit(const DexFile::CodeItem* code_item,
+                                      uint32_t access_flags, InvokeType invoke_type,
+                                      uint16_t class_def_idx, uint32_t method_idx,
+                                      jobject class_loader, const DexFile& dex_file)
+      LOCKS_EXCLUDED(Locks::mutator_lock_, compiled_methods_lock_);
+
+  // Frees a method returned by CompileMethodForJit, with the code and tables it deduplicated. The
+  // JIT compiles one method at a time, no other compiled method shares them.
+  void FreeCompiledMethodForJit(CompiledMethod* compiled_method)
+      LOCKS_EXCLUDED(compiled_methods_lock_);
+
   VerificationResults* GetVerificationResults() const {
     return verification_results_;
   }
@@ -142,10 +185,18 @@ class CompilerDriver {
     return compiler_.get();
   }
 
+  // A checksum of the compiler and of the compiler options which change the generated code. The
+  // oat header records it, so that the code of an oat file is only reused with the same options.
+  uint32_t GetCompilerOptionsChecksum() const;
+
   bool ProfilePresent() const {
     return profile_ok_;
   }
 
+  const ProfileMap& GetProfileMap() const {
+    return profile_map_;
+  }
+
   // Are we compiling and creating an image file?
   bool IsImage() const {
     return image_;
@@ -212,6 +263,12 @@ class CompilerDriver {
                           bool* is_type_initialized, bool* use_direct_type_ptr,
                           uintptr_t* direct_type_ptr, bool* out_is_finalizable);
 
+  // Is the string a string of the boot image we are compiling against? If yes, the code can
+  // use its address instead of loading it from the dex cache.
+  bool CanEmbedStringInCode(const DexFile& dex_file, uint32_t string_idx,
+                            uintptr_t* direct_string_ptr)
+      LOCKS_EXCLUDED(Locks::mutator_lock_);
+
   // Get the DexCache for the
   mirror::DexCache* GetDexCache(const DexCompilationUnit* mUnit)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -249,11 +306,14 @@ class CompilerDriver {
 
   // Can we fast-path an SGET/SPUT access to a static field? If yes, compute the field offset,
   // the type index of the declaring class in the referrer's dex file and whether the declaring
-  // class is the referrer's class or at least can be assumed to be initialized.
+  // class is the referrer's class or at least can be assumed to be initialized. If it can't,
+  // but the declaring class is an initialized class of the boot image, also compute its
+  // address for the code to use instead of the dex cache entry, 0 otherwise.
   std::pair<bool, bool> IsFastStaticField(
       mirror::DexCache* dex_cache, mirror::Class* referrer_class,
       mirror::ArtField* resolved_field, uint16_t field_idx, MemberOffset* field_offset,
-      uint32_t* storage_index, bool* is_referrers_class, bool* is_initialized)
+      uint32_t* storage_index, bool* is_referrers_class, bool* is_initialized,
+      uintptr_t* direct_storage_ptr)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // Resolve a method. Returns nullptr on failure, including incompatible class change.
@@ -288,10 +348,18 @@ class CompilerDriver {
   bool NeedsClassInitialization(mirror::Class* referrer_class, mirror::ArtMethod* resolved_method)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Can a loaded class override the resolved virtual method? Conservatively true for abstract
+  // methods and before the class hierarchy has been analyzed.
+  bool IsMethodOverridden(mirror::ArtMethod* resolved_method) const
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   void ProcessedInstanceField(bool resolved);
   void ProcessedStaticField(bool resolved, bool local);
   void ProcessedInvoke(InvokeType invoke_type, int flags);
 
+  // The compilation of a method used the given arena memory at its peak.
+  void RecordArenaUsage(const DexFile& dex_file, uint32_t method_idx, size_t bytes);
+
   // Can we fast path instance field access? Computes field's offset and volatility.
   bool ComputeInstanceFieldInfo(uint32_t field_idx, const DexCompilationUnit* mUnit, bool is_put,
                                 MemberOffset* field_offset, bool* is_volatile)
@@ -601,6 +669,21 @@ class CompilerDriver {
   // Should the compiler run on this method given profile information?
   bool SkipCompilation(const std::string& method_name);
 
+  // Is the method among the ones the profile shows take most of the samples?
+  bool IsHotMethod(const std::string& method_name) const;
+
+  // Does the call at dex_pc of the method account for a good part of the samples of a hot
+  // callee, according to the call graph of the profile?
+  bool IsHotCallSite(const std::string& method_name, uint32_t dex_pc) const;
+
+  // Does the method have a hot call site?
+  bool HasHotCallSite(const std::string& method_name) const;
+
+  // The receiver classes, by pretty descriptor, the profile saw at the call at dex_pc of the
+  // method, the most frequent first. Empty if the profile has no receiver types for the call.
+  std::vector<std::string> GetProfiledReceiverTypes(const std::string& method_name,
+                                                    uint32_t dex_pc) const;
+
  private:
   // These flags are internal to CompilerDriver for collecting INVOKE resolution statistics.
   // The only external contract is that unresolved method has flags 0 and resolved non-0.
@@ -633,6 +716,18 @@ class CompilerDriver {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
  private:
+  // Is `klass` a superclass of `referrer_class` resolved in `dex_cache`, the referrer's dex
+  // cache, when linking the referrer? It is then initialized whenever code of the referrer
+  // runs, and present in the dex cache.
+  bool IsSuperclassResolvedWithReferrer(mirror::DexCache* dex_cache,
+                                        mirror::Class* referrer_class, mirror::Class* klass)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Returns the address of `klass` if it is an initialized class of the boot image we are
+  // compiling against, 0 otherwise.
+  uintptr_t GetInitializedBootImageClassAddress(mirror::Class* klass)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   void PreCompile(jobject class_loader, const std::vector<const DexFile*>& dex_files,
                   ThreadPool* thread_pool, TimingLogger* timings)
       LOCKS_EXCLUDED(Locks::mutator_lock_);
@@ -666,6 +761,10 @@ class CompilerDriver {
   static void FindClinitImageClassesCallback(mirror::Object* object, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Record the virtual methods overridden by the loaded classes, from the boot class path and
+  // the compiled dex files.
+  void AnalyzeClassHierarchy(TimingLogger* timings) LOCKS_EXCLUDED(Locks::mutator_lock_);
+
   void Compile(jobject class_loader, const std::vector<const DexFile*>& dex_files,
                ThreadPool* thread_pool, TimingLogger* timings);
   void CompileDexFile(jobject class_loader, const DexFile& dex_file,
@@ -679,6 +778,61 @@ class CompilerDriver {
 
   static void CompileClass(const ParallelCompilationManager* context, size_t class_def_index)
       LOCKS_EXCLUDED(Locks::mutator_lock_);
+  static void CompileWork(const ParallelCompilationManager* context, size_t work_index)
+      LOCKS_EXCLUDED(Locks::mutator_lock_);
+  // Compile the methods of the class def from the begin-th to the end-th, counting the direct
+  // then the virtual methods in class data order.
+  static void CompileClassMethods(const ParallelCompilationManager* context,
+                                  const DexFile& dex_file, size_t class_def_index, size_t begin,
+                                  size_t end)
+      LOCKS_EXCLUDED(Locks::mutator_lock_);
+
+  // A part of the compilation: some methods of a class def, as compiled by
+  // CompileClassMethods(), their estimated cost and, with a compile-time budget, the percentage
+  // of the profile samples in them.
+  struct CompilationWork {
+    const DexFile* dex_file;
+    uint32_t class_def_index;
+    uint32_t begin;
+    uint32_t end;
+    uint32_t cost;
+    double hotness;
+  };
+  // Split the methods of a class def into pieces of work of at most max_work_cost, except
+  // those in the profile if with_hotness, which get a piece each.
+  void AddCompilationWork(const DexFile& dex_file, uint32_t class_def_index,
+                          const std::vector<uint32_t>& method_costs, uint64_t max_work_cost,
+                          bool with_hotness);
+  void GetMethodCosts(const DexFile& dex_file,
+                      std::vector<std::vector<uint32_t>>* method_costs, uint64_t* total_cost);
+  void EstimateCompilationWork(const DexFile& dex_file);
+
+  void CompileWithinBudget(jobject class_loader, const std::vector<const DexFile*>& dex_files,
+                           ThreadPool* thread_pool, TimingLogger* timings);
+  bool IsCompileTimeBudgetExhausted() const;
+
+  // The work being compiled, the most costly first, or in budget order.
+  std::vector<CompilationWork> compilation_work_;
+
+  // The compile-time budgets in ns, zero if none, and what was spent of them.
+  uint64_t wall_time_budget_ns_;
+  uint64_t cpu_time_budget_ns_;
+  uint64_t compile_all_start_ns_;
+  Atomic<int64_t> compile_cpu_time_ns_;
+  AtomicInteger methods_over_budget_;
+
+  struct MethodStats {
+    MethodStats() : compile_time_ns(0u), arena_bytes(0u), code_bytes(0u) { }
+
+    uint64_t compile_time_ns;
+    size_t arena_bytes;
+    size_t code_bytes;
+  };
+  typedef SafeMap<const MethodReference, MethodStats, MethodReferenceComparator> MethodStatsTable;
+  // The stats of the compiled methods, if EnableMethodStats was called.
+  bool method_stats_enabled_;
+  mutable Mutex method_stats_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  MethodStatsTable method_stats_ GUARDED_BY(method_stats_lock_);
 
   std::vector<const CallPatchInformation*> code_to_patch_;
   std::vector<const CallPatchInformation*> methods_to_patch_;
@@ -688,8 +842,15 @@ class CompilerDriver {
   VerificationResults* const verification_results_;
   DexFileToMethodInlinerMap* const method_inliner_map_;
 
+  const Compiler::Kind compiler_kind_;
   std::unique_ptr<Compiler> compiler_;
 
+  // The code of a previous compilation to reuse, if any.
+  std::unique_ptr<IncrementalCompilation> incremental_compilation_;
+
+  // The persistent cache of compiled code, if any.
+  std::unique_ptr<CompilationCache> compilation_cache_;
+
   const InstructionSet instruction_set_;
   const InstructionSetFeatures instruction_set_features_;
 
@@ -714,6 +875,12 @@ class CompilerDriver {
   // included in the image.
   std::unique_ptr<DescriptorSet> image_classes_;
 
+  typedef std::set<MethodReference, MethodReferenceComparator> MethodSet;
+  // The virtual methods a loaded class overrides, filled in by AnalyzeClassHierarchy() and
+  // read-only once compilation starts.
+  MethodSet overridden_methods_;
+  bool class_hierarchy_analyzed_;
+
   size_t thread_count_;
   uint64_t start_ns_;
 
@@ -791,11 +958,11 @@ class CompilerDriver {
       return hash;
     }
   };
-  DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc, 4> dedupe_code_;
-  DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc, 4> dedupe_mapping_table_;
-  DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc, 4> dedupe_vmap_table_;
-  DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc, 4> dedupe_gc_map_;
-  DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc, 4> dedupe_cfi_info_;
+  DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc> dedupe_code_;
+  DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc> dedupe_mapping_table_;
+  DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc> dedupe_vmap_table_;
+  DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc> dedupe_gc_map_;
+  DedupeSet<std::vector<uint8_t>, size_t, DedupeHashFunc> dedupe_cfi_info_;
 
   DISALLOW_COPY_AND_ASSIGN(CompilerDriver);
 };
@@ -50,7 +50,14 @@ class CompilerOptions {
     small_method_threshold_(kDefaultSmallMethodThreshold),
     tiny_method_threshold_(kDefaultTinyMethodThreshold),
     num_dex_methods_threshold_(kDefaultNumDexMethodsThreshold),
-    generate_gdb_information_(false)
+    generate_gdb_information_(false),
+    generate_mini_debug_info_(false),
+    include_osr_entries_(false),
+    portable_vectorize_(false),
+    dedupe_shards_(0),
+    pin_compiler_threads_(false),
+    conditional_card_marks_(false),
+    layout_dex_files_(false)
 #ifdef ART_SEA_IR_MODE
     , sea_ir_mode_(false)
 #endif
@@ -62,7 +69,8 @@ class CompilerOptions {
                   size_t small_method_threshold,
                   size_t tiny_method_threshold,
                   size_t num_dex_methods_threshold,
-                  bool generate_gdb_information
+                  bool generate_gdb_information,
+                  bool generate_mini_debug_info
 #ifdef ART_SEA_IR_MODE
                   , bool sea_ir_mode
 #endif
@@ -73,7 +81,14 @@ class CompilerOptions {
     small_method_threshold_(small_method_threshold),
     tiny_method_threshold_(tiny_method_threshold),
     num_dex_methods_threshold_(num_dex_methods_threshold),
-    generate_gdb_information_(generate_gdb_information)
+    generate_gdb_information_(generate_gdb_information),
+    generate_mini_debug_info_(generate_mini_debug_info),
+    include_osr_entries_(false),
+    portable_vectorize_(false),
+    dedupe_shards_(0),
+    pin_compiler_threads_(false),
+    conditional_card_marks_(false),
+    layout_dex_files_(false)
 #ifdef ART_SEA_IR_MODE
     , sea_ir_mode_(sea_ir_mode)
 #endif
@@ -140,6 +155,71 @@ class CompilerOptions {
     return generate_gdb_information_;
   }
 
+  // Whether to emit only method symbols and compressed call frame information, which is enough
+  // to unwind and symbolize native stacks at a fraction of the size of the full debug sections.
+  bool GetGenerateMiniDebugInfo() const {
+    return generate_mini_debug_info_;
+  }
+
+  // Whether to generate entries at the loop headers of methods, for the runtime to move
+  // interpreted frames into the compiled code by on-stack replacement. Only the JIT does.
+  bool GetIncludeOsrEntries() const {
+    return include_osr_entries_;
+  }
+
+  void SetIncludeOsrEntries(bool include_osr_entries) {
+    include_osr_entries_ = include_osr_entries;
+  }
+
+  // Whether the Portable backend runs LLVM's loop and SLP vectorizers, with the cost model of
+  // the target. Off by default as it makes the code larger and the compilation slower.
+  bool GetPortableVectorize() const {
+    return portable_vectorize_;
+  }
+
+  void SetPortableVectorize(bool portable_vectorize) {
+    portable_vectorize_ = portable_vectorize;
+  }
+
+  // The number of shards of the sets deduplicating the code and tables of the compiled methods.
+  // Zero, the default, scales it with the number of compiler threads.
+  size_t GetDedupeShards() const {
+    return dedupe_shards_;
+  }
+
+  void SetDedupeShards(size_t dedupe_shards) {
+    dedupe_shards_ = dedupe_shards;
+  }
+
+  // Whether the compiler threads are pinned to CPUs, see ThreadPool::PinWorkers.
+  bool GetPinCompilerThreads() const {
+    return pin_compiler_threads_;
+  }
+
+  void SetPinCompilerThreads(bool pin_compiler_threads) {
+    pin_compiler_threads_ = pin_compiler_threads;
+  }
+
+  // Whether the generated code reads a card before marking it, and skips the store when the
+  // card is already dirty.
+  bool GetConditionalCardMarks() const {
+    return conditional_card_marks_;
+  }
+
+  void SetConditionalCardMarks(bool conditional_card_marks) {
+    conditional_card_marks_ = conditional_card_marks;
+  }
+
+  // Whether the copies of the dex files in the oat file put the code items and strings of the
+  // methods in the profile first.
+  bool GetLayoutDexFiles() const {
+    return layout_dex_files_;
+  }
+
+  void SetLayoutDexFiles(bool layout_dex_files) {
+    layout_dex_files_ = layout_dex_files;
+  }
+
  private:
   CompilerFilter compiler_filter_;
   size_t huge_method_threshold_;
@@ -148,6 +228,13 @@ class CompilerOptions {
   size_t tiny_method_threshold_;
   size_t num_dex_methods_threshold_;
   bool generate_gdb_information_;
+  bool generate_mini_debug_info_;
+  bool include_osr_entries_;
+  bool portable_vectorize_;
+  size_t dedupe_shards_;
+  bool pin_compiler_threads_;
+  bool conditional_card_marks_;
+  bool layout_dex_files_;
 
 #ifdef ART_SEA_IR_MODE
   bool sea_ir_mode_;
@@ -0,0 +1,453 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "incremental_compilation.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+#include <string>
+
+#include "base/stl_util.h"
+#include "compiled_method.h"
+#include "dex_instruction-inl.h"
+#include "driver/compiler_driver.h"
+#include "gc/heap.h"
+#include "gc/space/image_space.h"
+#include "leb128.h"
+#include "oat_file.h"
+#include "runtime.h"
+
+namespace art {
+
+struct IncrementalCompilation::PreviousDexFile {
+  const OatFile::OatDexFile* oat_dex_file;
+  std::unique_ptr<const DexFile> dex_file;
+};
+
+IncrementalCompilation::IncrementalCompilation(const OatFile* previous_oat_file)
+    : previous_oat_file_(previous_oat_file) {
+}
+
+IncrementalCompilation::~IncrementalCompilation() {
+  STLDeleteValues(&previous_dex_files_);
+}
+
+bool IncrementalCompilation::IsCompatible(const CompilerDriver& driver) const {
+  const OatHeader& header = previous_oat_file_->GetOatHeader();
+  if (driver.IsImage() || driver.GetCompiler()->IsPortable()) {
+    LOG(WARNING) << "Not reusing " << previous_oat_file_->GetLocation()
+                 << ": only the Quick code of applications is reused";
+    return false;
+  }
+  if (header.GetInstructionSet() != driver.GetInstructionSet() ||
+      !(header.GetInstructionSetFeatures() == driver.GetInstructionSetFeatures())) {
+    LOG(WARNING) << "Not reusing " << previous_oat_file_->GetLocation()
+                 << ": compiled for another instruction set";
+    return false;
+  }
+  // The compiler filter, the method size thresholds and the debug and code generation options
+  // decide what is compiled and how.
+  if (header.GetCompilerOptionsChecksum() != driver.GetCompilerOptionsChecksum()) {
+    LOG(WARNING) << "Not reusing " << previous_oat_file_->GetLocation()
+                 << ": compiled with other compiler options";
+    return false;
+  }
+  // The code refers to the classes and methods of the boot image by address.
+  gc::space::ImageSpace* image_space = Runtime::Current()->GetHeap()->GetImageSpace();
+  if (image_space == nullptr ||
+      header.GetImageFileLocationOatChecksum() != image_space->GetImageHeader().GetOatChecksum()) {
+    LOG(WARNING) << "Not reusing " << previous_oat_file_->GetLocation()
+                 << ": compiled against another boot image";
+    return false;
+  }
+  return true;
+}
+
+static bool HaveSameTypeLists(const DexFile::TypeList* list, const DexFile::TypeList* other_list) {
+  size_t size = (list != nullptr) ? list->Size() : 0u;
+  size_t other_size = (other_list != nullptr) ? other_list->Size() : 0u;
+  if (size != other_size) {
+    return false;
+  }
+  for (size_t i = 0; i != size; ++i) {
+    if (list->GetTypeItem(i).type_idx_ != other_list->GetTypeItem(i).type_idx_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IncrementalCompilation::HaveSameIds(const DexFile& dex_file,
+                                         const DexFile& other_dex_file) {
+  if (dex_file.NumStringIds() != other_dex_file.NumStringIds() ||
+      dex_file.NumTypeIds() != other_dex_file.NumTypeIds() ||
+      dex_file.NumProtoIds() != other_dex_file.NumProtoIds() ||
+      dex_file.NumFieldIds() != other_dex_file.NumFieldIds() ||
+      dex_file.NumMethodIds() != other_dex_file.NumMethodIds()) {
+    return false;
+  }
+  for (size_t i = 0; i != dex_file.NumStringIds(); ++i) {
+    if (strcmp(dex_file.StringDataByIdx(i), other_dex_file.StringDataByIdx(i)) != 0) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i != dex_file.NumTypeIds(); ++i) {
+    if (dex_file.GetTypeId(i).descriptor_idx_ != other_dex_file.GetTypeId(i).descriptor_idx_) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i != dex_file.NumProtoIds(); ++i) {
+    const DexFile::ProtoId& proto_id = dex_file.GetProtoId(i);
+    const DexFile::ProtoId& other_proto_id = other_dex_file.GetProtoId(i);
+    if (proto_id.shorty_idx_ != other_proto_id.shorty_idx_ ||
+        proto_id.return_type_idx_ != other_proto_id.return_type_idx_ ||
+        !HaveSameTypeLists(dex_file.GetProtoParameters(proto_id),
+                           other_dex_file.GetProtoParameters(other_proto_id))) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i != dex_file.NumFieldIds(); ++i) {
+    const DexFile::FieldId& field_id = dex_file.GetFieldId(i);
+    const DexFile::FieldId& other_field_id = other_dex_file.GetFieldId(i);
+    if (field_id.class_idx_ != other_field_id.class_idx_ ||
+        field_id.type_idx_ != other_field_id.type_idx_ ||
+        field_id.name_idx_ != other_field_id.name_idx_) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i != dex_file.NumMethodIds(); ++i) {
+    const DexFile::MethodId& method_id = dex_file.GetMethodId(i);
+    const DexFile::MethodId& other_method_id = other_dex_file.GetMethodId(i);
+    if (method_id.class_idx_ != other_method_id.class_idx_ ||
+        method_id.proto_idx_ != other_method_id.proto_idx_ ||
+        method_id.name_idx_ != other_method_id.name_idx_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool HaveSameCode(const DexFile::CodeItem* code_item,
+                         const DexFile::CodeItem* other_code_item) {
+  if (code_item == nullptr || other_code_item == nullptr) {
+    return code_item == other_code_item;
+  }
+  if (code_item->registers_size_ != other_code_item->registers_size_ ||
+      code_item->ins_size_ != other_code_item->ins_size_ ||
+      code_item->outs_size_ != other_code_item->outs_size_ ||
+      code_item->tries_size_ != other_code_item->tries_size_ ||
+      code_item->insns_size_in_code_units_ != other_code_item->insns_size_in_code_units_ ||
+      memcmp(code_item->insns_, other_code_item->insns_,
+             code_item->insns_size_in_code_units_ * sizeof(code_item->insns_[0])) != 0) {
+    return false;
+  }
+  for (uint32_t i = 0; i != code_item->tries_size_; ++i) {
+    const DexFile::TryItem* try_item = DexFile::GetTryItems(*code_item, i);
+    const DexFile::TryItem* other_try_item = DexFile::GetTryItems(*other_code_item, i);
+    if (try_item->start_addr_ != other_try_item->start_addr_ ||
+        try_item->insn_count_ != other_try_item->insn_count_) {
+      return false;
+    }
+    CatchHandlerIterator it(*code_item, *try_item);
+    CatchHandlerIterator other_it(*other_code_item, *other_try_item);
+    for (; it.HasNext() && other_it.HasNext(); it.Next(), other_it.Next()) {
+      if (it.GetHandlerTypeIndex() != other_it.GetHandlerTypeIndex() ||
+          it.GetHandlerAddress() != other_it.GetHandlerAddress()) {
+        return false;
+      }
+    }
+    if (it.HasNext() || other_it.HasNext()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IncrementalCompilation::HaveSameClassDef(const DexFile& dex_file,
+                                              const DexFile::ClassDef& class_def,
+                                              const DexFile& other_dex_file,
+                                              const DexFile::ClassDef& other_class_def) {
+  if (class_def.class_idx_ != other_class_def.class_idx_ ||
+      class_def.access_flags_ != other_class_def.access_flags_ ||
+      class_def.superclass_idx_ != other_class_def.superclass_idx_ ||
+      !HaveSameTypeLists(dex_file.GetInterfacesList(class_def),
+                         other_dex_file.GetInterfacesList(other_class_def))) {
+    return false;
+  }
+  const byte* class_data = dex_file.GetClassData(class_def);
+  const byte* other_class_data = other_dex_file.GetClassData(other_class_def);
+  if (class_data == nullptr || other_class_data == nullptr) {
+    return class_data == other_class_data;
+  }
+  ClassDataItemIterator it(dex_file, class_data);
+  ClassDataItemIterator other_it(other_dex_file, other_class_data);
+  if (it.NumStaticFields() != other_it.NumStaticFields() ||
+      it.NumInstanceFields() != other_it.NumInstanceFields() ||
+      it.NumDirectMethods() != other_it.NumDirectMethods() ||
+      it.NumVirtualMethods() != other_it.NumVirtualMethods()) {
+    return false;
+  }
+  for (; it.HasNext(); it.Next(), other_it.Next()) {
+    if (it.GetMemberIndex() != other_it.GetMemberIndex() ||
+        it.GetMemberAccessFlags() != other_it.GetMemberAccessFlags() ||
+        ((it.HasNextDirectMethod() || it.HasNextVirtualMethod()) &&
+         !HaveSameCode(it.GetMethodCodeItem(), other_it.GetMethodCodeItem()))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Add the descriptors of the classes the code of a method refers to.
+static void AddReferencedClasses(const DexFile& dex_file, const DexFile::CodeItem* code_item,
+                                 std::vector<const char*>* descriptors) {
+  if (code_item == nullptr) {
+    return;
+  }
+  const uint16_t* insns = code_item->insns_;
+  const uint16_t* end = insns + code_item->insns_size_in_code_units_;
+  while (insns < end) {
+    const Instruction* inst = Instruction::At(insns);
+    int flags = Instruction::VerifyFlagsOf(inst->Opcode());
+    if ((flags & (Instruction::kVerifyRegBType | Instruction::kVerifyRegBNewInstance)) != 0) {
+      descriptors->push_back(dex_file.StringByTypeIdx(inst->VRegB()));
+    } else if ((flags & (Instruction::kVerifyRegCType | Instruction::kVerifyRegCNewArray)) != 0) {
+      descriptors->push_back(dex_file.StringByTypeIdx(inst->VRegC()));
+    } else if ((flags & Instruction::kVerifyRegBField) != 0) {
+      descriptors->push_back(dex_file.GetFieldDeclaringClassDescriptor(
+          dex_file.GetFieldId(inst->VRegB())));
+    } else if ((flags & Instruction::kVerifyRegCField) != 0) {
+      descriptors->push_back(dex_file.GetFieldDeclaringClassDescriptor(
+          dex_file.GetFieldId(inst->VRegC())));
+    } else if ((flags & Instruction::kVerifyRegBMethod) != 0) {
+      descriptors->push_back(dex_file.GetMethodDeclaringClassDescriptor(
+          dex_file.GetMethodId(inst->VRegB())));
+    }
+    insns += inst->SizeInCodeUnits();
+  }
+}
+
+void IncrementalCompilation::GetClassDependencies(const DexFile& dex_file,
+                                                  const DexFile::ClassDef& class_def,
+                                                  std::vector<const char*>* descriptors) {
+  size_t start = descriptors->size();
+  if (class_def.superclass_idx_ != DexFile::kDexNoIndex16) {
+    descriptors->push_back(dex_file.StringByTypeIdx(class_def.superclass_idx_));
+  }
+  const DexFile::TypeList* interfaces = dex_file.GetInterfacesList(class_def);
+  for (size_t i = 0; interfaces != nullptr && i != interfaces->Size(); ++i) {
+    descriptors->push_back(dex_file.StringByTypeIdx(interfaces->GetTypeItem(i).type_idx_));
+  }
+  const byte* class_data = dex_file.GetClassData(class_def);
+  if (class_data != nullptr) {
+    for (ClassDataItemIterator it(dex_file, class_data); it.HasNext(); it.Next()) {
+      if (it.HasNextDirectMethod() || it.HasNextVirtualMethod()) {
+        AddReferencedClasses(dex_file, it.GetMethodCodeItem(), descriptors);
+      }
+    }
+  }
+  // Array classes depend on their element class.
+  for (size_t i = start; i != descriptors->size(); ++i) {
+    while ((*descriptors)[i][0] == '[') {
+      ++(*descriptors)[i];
+    }
+  }
+}
+
+void IncrementalCompilation::FindReusableClasses(const CompilerDriver& driver,
+                                                 jobject class_loader,
+                                                 const std::vector<const DexFile*>& dex_files) {
+  if (!IsCompatible(driver)) {
+    return;
+  }
+
+  // The classes of the dex files, by descriptor, and whether they are unchanged.
+  struct ClassNode {
+    ClassReference ref;
+    uint16_t previous_class_def_idx;
+    bool reusable;
+    std::vector<size_t> dependents;
+  };
+  std::vector<ClassNode> classes;
+  SafeMap<std::string, size_t> class_indexes;
+  // The class path starts with the dex files to compile. The classes of the other dex files of
+  // the class path may have changed, so the classes depending on them are compiled again.
+  const std::vector<const DexFile*>& class_path = (class_loader != nullptr)
+      ? Runtime::Current()->GetCompileTimeClassPath(class_loader)
+      : dex_files;
+  for (const DexFile* dex_file : class_path) {
+    PreviousDexFile* previous = nullptr;
+    const OatFile::OatDexFile* oat_dex_file =
+        (std::find(dex_files.begin(), dex_files.end(), dex_file) != dex_files.end())
+        ? previous_oat_file_->GetOatDexFile(dex_file->GetLocation().c_str(), nullptr, false)
+        : nullptr;
+    if (oat_dex_file != nullptr) {
+      std::string error_msg;
+      std::unique_ptr<const DexFile> previous_dex_file(oat_dex_file->OpenDexFile(&error_msg));
+      if (previous_dex_file.get() == nullptr) {
+        LOG(WARNING) << "Failed to open the previous version of " << dex_file->GetLocation()
+                     << ": " << error_msg;
+      } else if (HaveSameIds(*dex_file, *previous_dex_file)) {
+        previous = new PreviousDexFile();
+        previous->oat_dex_file = oat_dex_file;
+        previous->dex_file.reset(previous_dex_file.release());
+        previous_dex_files_.Put(dex_file, previous);
+      }
+    }
+    for (size_t i = 0; i != dex_file->NumClassDefs(); ++i) {
+      const DexFile::ClassDef& class_def = dex_file->GetClassDef(i);
+      std::string descriptor(dex_file->GetClassDescriptor(class_def));
+      if (class_indexes.find(descriptor) != class_indexes.end()) {
+        continue;  // Only the first definition of a class is used.
+      }
+      ClassNode node = { ClassReference(dex_file, i), 0u, false, std::vector<size_t>() };
+      if (previous != nullptr) {
+        const DexFile::ClassDef* previous_class_def =
+            previous->dex_file->FindClassDef(class_def.class_idx_);
+        if (previous_class_def != nullptr &&
+            HaveSameClassDef(*dex_file, class_def, *previous->dex_file, *previous_class_def)) {
+          node.previous_class_def_idx =
+              previous->dex_file->GetIndexForClassDef(*previous_class_def);
+          node.reusable = true;
+        }
+      }
+      class_indexes.Put(descriptor, classes.size());
+      classes.push_back(node);
+    }
+  }
+
+  // Record which classes depend on which, through their superclass, interfaces and code.
+  std::deque<size_t> changed;
+  for (size_t index = 0; index != classes.size(); ++index) {
+    if (!classes[index].reusable) {
+      changed.push_back(index);
+    }
+    const DexFile& dex_file = *classes[index].ref.first;
+    const DexFile::ClassDef& class_def = dex_file.GetClassDef(classes[index].ref.second);
+    std::vector<const char*> descriptors;
+    GetClassDependencies(dex_file, class_def, &descriptors);
+    for (const char* descriptor : descriptors) {
+      // The classes of the boot class path are those of the boot image, and did not change.
+      auto it = class_indexes.find(descriptor);
+      if (it != class_indexes.end() && it->second != index) {
+        classes[it->second].dependents.push_back(index);
+      }
+    }
+  }
+
+  // The classes depending on changed classes cannot reuse their code either.
+  while (!changed.empty()) {
+    const ClassNode& node = classes[changed.front()];
+    changed.pop_front();
+    for (size_t dependent : node.dependents) {
+      if (classes[dependent].reusable) {
+        classes[dependent].reusable = false;
+        changed.push_back(dependent);
+      }
+    }
+  }
+  for (const ClassNode& node : classes) {
+    if (node.reusable) {
+      reusable_classes_.Put(node.ref, node.previous_class_def_idx);
+    }
+  }
+  VLOG(compiler) << "Reusing the code of " << reusable_classes_.size() << " of "
+                 << classes.size() << " classes from " << previous_oat_file_->GetLocation();
+}
+
+// The sizes of the encoded tables of a method, as written by the Quick compiler.
+
+static size_t MappingTableSize(const uint8_t* table) {
+  const uint8_t* data = table;
+  uint32_t total_size = DecodeUnsignedLeb128(&data);
+  DecodeUnsignedLeb128(&data);  // Skip the pc to dex size.
+  for (uint32_t i = 0; i != total_size; ++i) {
+    DecodeUnsignedLeb128(&data);  // Skip the native pc delta.
+    DecodeSignedLeb128(&data);  // Skip the dex pc delta.
+  }
+  return data - table;
+}
+
+static size_t VmapTableSize(const uint8_t* table) {
+  const uint8_t* data = table;
+  uint32_t size = DecodeUnsignedLeb128(&data);
+  for (uint32_t i = 0; i != size; ++i) {
+    DecodeUnsignedLeb128(&data);
+  }
+  return data - table;
+}
+
+static size_t NativeGcMapSize(const uint8_t* map) {
+  size_t native_offset_width = map[0] & 7;
+  size_t reg_width = (static_cast<size_t>(map[0]) | (static_cast<size_t>(map[1]) << 8)) >> 3;
+  size_t num_entries = map[2] | (map[3] << 8);
+  return 4u + num_entries * (native_offset_width + reg_width);
+}
+
+static std::vector<uint8_t> CopyTable(const uint8_t* table, size_t (*size_of)(const uint8_t*)) {
+  if (table == nullptr) {
+    return std::vector<uint8_t>();
+  }
+  return std::vector<uint8_t>(table, table + size_of(table));
+}
+
+CompiledMethod* IncrementalCompilation::ReuseCompiledMethod(CompilerDriver* driver,
+                                                            const DexFile& dex_file,
+                                                            uint16_t class_def_idx,
+                                                            uint32_t method_idx) const {
+  auto class_it = reusable_classes_.find(ClassReference(&dex_file, class_def_idx));
+  if (class_it == reusable_classes_.end()) {
+    return nullptr;
+  }
+  const PreviousDexFile* previous = previous_dex_files_.find(&dex_file)->second;
+  const DexFile& previous_dex_file = *previous->dex_file;
+  // The oat methods of a class are indexed like its methods, the direct ones first.
+  const byte* class_data =
+      previous_dex_file.GetClassData(previous_dex_file.GetClassDef(class_it->second));
+  DCHECK(class_data != nullptr);
+  ClassDataItemIterator it(previous_dex_file, class_data);
+  while (it.HasNextStaticField() || it.HasNextInstanceField()) {
+    it.Next();
+  }
+  uint32_t method_index = 0u;
+  while (it.HasNext() && it.GetMemberIndex() != method_idx) {
+    ++method_index;
+    it.Next();
+  }
+  if (!it.HasNext()) {
+    return nullptr;
+  }
+  const OatFile::OatMethod oat_method =
+      previous->oat_dex_file->GetOatClass(class_it->second).GetOatMethod(method_index);
+  if (oat_method.GetQuickCode() == nullptr) {
+    return nullptr;  // Interpreted, or left to the generic JNI trampoline.
+  }
+  // Clear the Thumb bit to get at the code.
+  const uint8_t* code = reinterpret_cast<const uint8_t*>(
+      reinterpret_cast<uintptr_t>(oat_method.GetQuickCode()) & ~static_cast<uintptr_t>(1));
+  std::vector<uint8_t> quick_code(code, code + oat_method.GetQuickCodeSize());
+  return new CompiledMethod(driver, driver->GetInstructionSet(), quick_code,
+                            oat_method.GetFrameSizeInBytes(), oat_method.GetCoreSpillMask(),
+                            oat_method.GetFpSpillMask(),
+                            CopyTable(oat_method.GetMappingTable(), MappingTableSize),
+                            CopyTable(oat_method.GetVmapTable(), VmapTableSize),
+                            CopyTable(oat_method.GetNativeGcMap(), NativeGcMapSize),
+                            nullptr);
+}
+
+}  // namespace art
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_DRIVER_INCREMENTAL_COMPILATION_H_
+#define ART_COMPILER_DRIVER_INCREMENTAL_COMPILATION_H_
+
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "class_reference.h"
+#include "dex_file.h"
+#include "jni.h"
+#include "safe_map.h"
+
+namespace art {
+
+class CompiledMethod;
+class CompilerDriver;
+class OatFile;
+
+// Reuses the code of a previous oat file of the dex files being compiled, for the classes
+// that did not change since.
+//
+// The code of a method depends on more than its own code item: on the meaning of the dex
+// file indices it uses, on the layout of the classes it refers to and on the code of the
+// methods it inlines. The code of a class is reused only if the ids of its dex file are the
+// same as in the previous version, its class definition and code are the same, and so are,
+// transitively, those of its superclass, interfaces, and of the classes its code refers to.
+// The boot image and the compiler options must be those the previous oat file was compiled with.
+class IncrementalCompilation {
+ public:
+  // Takes ownership of the previous oat file.
+  explicit IncrementalCompilation(const OatFile* previous_oat_file);
+  ~IncrementalCompilation();
+
+  // Find the unchanged classes of the dex files to compile. Must be called before the
+  // dex-to-dex compiler modifies them.
+  void FindReusableClasses(const CompilerDriver& driver, jobject class_loader,
+                           const std::vector<const DexFile*>& dex_files);
+
+  // Returns a copy of the previous code of the method, or nullptr if it cannot be reused.
+  CompiledMethod* ReuseCompiledMethod(CompilerDriver* driver, const DexFile& dex_file,
+                                      uint16_t class_def_idx, uint32_t method_idx) const;
+
+  // Whether the ids of two dex files refer to the same strings, types, prototypes, fields and
+  // methods.
+  static bool HaveSameIds(const DexFile& dex_file, const DexFile& other_dex_file);
+
+  // Whether two class definitions of dex files with the same ids are the same, including the
+  // code of their methods.
+  static bool HaveSameClassDef(const DexFile& dex_file, const DexFile::ClassDef& class_def,
+                               const DexFile& other_dex_file,
+                               const DexFile::ClassDef& other_class_def);
+
+  // Add the descriptors of the classes the code of a class may depend on: its superclass, its
+  // interfaces, and the classes its code refers to, or the element classes of arrays.
+  static void GetClassDependencies(const DexFile& dex_file, const DexFile::ClassDef& class_def,
+                                   std::vector<const char*>* descriptors);
+
+ private:
+  struct PreviousDexFile;
+
+  bool IsCompatible(const CompilerDriver& driver) const;
+
+  std::unique_ptr<const OatFile> previous_oat_file_;
+  // The previous versions of the dex files to compile, by dex file.
+  SafeMap<const DexFile*, PreviousDexFile*> previous_dex_files_;
+  // The class def index in the previous dex file of the classes whose code can be reused.
+  SafeMap<ClassReference, uint16_t> reusable_classes_;
+
+  DISALLOW_COPY_AND_ASSIGN(IncrementalCompilation);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_DRIVER_INCREMENTAL_COMPILATION_H_
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "driver/incremental_compilation.h"
+
+#include "common_runtime_test.h"
+
+namespace art {
+
+class IncrementalCompilationTest : public CommonRuntimeTest {};
+
+TEST_F(IncrementalCompilationTest, HaveSameIds) {
+  ScopedObjectAccess soa(Thread::Current());
+  const DexFile* nested = OpenTestDexFile("Nested");
+  const DexFile* nested_again = OpenTestDexFile("Nested");
+  const DexFile* main = OpenTestDexFile("Main");
+  ASSERT_TRUE(nested != nullptr);
+  ASSERT_TRUE(nested_again != nullptr);
+  ASSERT_TRUE(main != nullptr);
+
+  EXPECT_TRUE(IncrementalCompilation::HaveSameIds(*nested, *nested_again));
+  EXPECT_FALSE(IncrementalCompilation::HaveSameIds(*nested, *main));
+}
+
+TEST_F(IncrementalCompilationTest, HaveSameClassDef) {
+  ScopedObjectAccess soa(Thread::Current());
+  const DexFile* nested = OpenTestDexFile("Nested");
+  const DexFile* nested_again = OpenTestDexFile("Nested");
+  ASSERT_TRUE(nested != nullptr);
+  ASSERT_TRUE(nested_again != nullptr);
+  ASSERT_EQ(nested->NumClassDefs(), nested_again->NumClassDefs());
+
+  for (size_t i = 0; i != nested->NumClassDefs(); ++i) {
+    EXPECT_TRUE(IncrementalCompilation::HaveSameClassDef(*nested, nested->GetClassDef(i),
+                                                         *nested_again,
+                                                         nested_again->GetClassDef(i)));
+  }
+  // The classes of a dex file differ at least in their type.
+  ASSERT_LE(2u, nested->NumClassDefs());
+  EXPECT_FALSE(IncrementalCompilation::HaveSameClassDef(*nested, nested->GetClassDef(0),
+                                                        *nested_again,
+                                                        nested_again->GetClassDef(1)));
+}
+
+}  // namespace art
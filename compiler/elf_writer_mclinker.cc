@@ -16,6 +16,8 @@
 
 #include "elf_writer_mclinker.h"
 
+#include <unistd.h>
+
 #include <llvm/Support/ELF.h>
 #include <llvm/Support/TargetSelect.h>
 
@@ -30,17 +32,19 @@
 #include <mcld/Support/TargetSelect.h>
 
 #include "base/unix_file/fd_file.h"
+#include "buffered_output_stream.h"
 #include "class_linker.h"
 #include "dex_method_iterator.h"
 #include "driver/compiler_driver.h"
 #include "elf_file.h"
+#include "file_output_stream.h"
 #include "globals.h"
 #include "mirror/art_method.h"
 #include "mirror/art_method-inl.h"
 #include "mirror/object-inl.h"
 #include "oat_writer.h"
+#include "os.h"
 #include "scoped_thread_state_change.h"
-#include "vector_output_stream.h"
 
 namespace art {
 
@@ -65,14 +69,13 @@ bool ElfWriterMclinker::Write(OatWriter* oat_writer,
                               const std::vector<const DexFile*>& dex_files,
                               const std::string& android_root,
                               bool is_host) {
-  std::vector<uint8_t> oat_contents;
-  oat_contents.reserve(oat_writer->GetSize());
-  VectorOutputStream output_stream("oat contents", oat_contents);
-  CHECK(oat_writer->Write(&output_stream));
-  CHECK_EQ(oat_writer->GetSize(), oat_contents.size());
+  std::unique_ptr<MemMap> oat_contents(WriteOatContents(oat_writer));
+  if (oat_contents.get() == nullptr) {
+    return false;
+  }
 
   Init();
-  AddOatInput(oat_contents);
+  AddOatInput(oat_contents->Begin(), oat_contents->Size());
   if (kUsePortableCompiler) {
     AddMethodInputs(dex_files);
     AddRuntimeInputs(android_root, is_host);
@@ -80,7 +83,7 @@ bool ElfWriterMclinker::Write(OatWriter* oat_writer,
   if (!Link()) {
     return false;
   }
-  oat_contents.clear();
+  oat_contents.reset();
   if (kUsePortableCompiler) {
     FixupOatMethodOffsets(dex_files);
   }
@@ -156,10 +159,41 @@ void ElfWriterMclinker::Init() {
   linker_->emulate(*linker_script_.get(), *linker_config_.get());
 }
 
-void ElfWriterMclinker::AddOatInput(std::vector<uint8_t>& oat_contents) {
+// MCLinker takes the oat contents as a memory input. Rather than building them in a buffer, stream
+// them to an unlinked scratch file and map it: the pages are then file backed and can be dropped
+// under memory pressure instead of being swapped out.
+MemMap* ElfWriterMclinker::WriteOatContents(OatWriter* oat_writer) {
+  std::string filename(elf_file_->GetPath() + ".contents");
+  std::unique_ptr<File> file(OS::CreateEmptyFile(filename.c_str()));
+  if (file.get() == nullptr) {
+    PLOG(ERROR) << "Failed to create oat contents file " << filename;
+    return nullptr;
+  }
+  // Only the mapping refers to the contents from here on.
+  unlink(filename.c_str());
+  {
+    BufferedOutputStream output_stream(new FileOutputStream(file.get()));
+    if (!oat_writer->Write(&output_stream)) {
+      PLOG(ERROR) << "Failed to write oat contents to " << filename;
+      return nullptr;
+    }
+  }
+  CHECK_EQ(static_cast<int64_t>(oat_writer->GetSize()), file->GetLength());
+  std::string error_msg;
+  // Writable as MCLinker takes non-const regions, the private mapping never writes back.
+  MemMap* map = MemMap::MapFile(oat_writer->GetSize(), PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                                file->Fd(), 0, filename.c_str(), &error_msg);
+  if (map == nullptr) {
+    LOG(ERROR) << "Failed to map oat contents: " << error_msg;
+  }
+  return map;
+}
+
+void ElfWriterMclinker::AddOatInput(const byte* oat_contents, size_t size) {
   // Add an artificial memory input. Based on LinkerTest.
   std::string error_msg;
-  std::unique_ptr<OatFile> oat_file(OatFile::OpenMemory(oat_contents, elf_file_->GetPath(), &error_msg));
+  std::unique_ptr<OatFile> oat_file(OatFile::OpenMemory(oat_contents, size, elf_file_->GetPath(),
+                                                        &error_msg));
   CHECK(oat_file.get() != NULL) << elf_file_->GetPath() << ": " << error_msg;
 
   const char* oat_data_start = reinterpret_cast<const char*>(&oat_file->GetOatHeader());
@@ -20,6 +20,7 @@
 #include <memory>
 
 #include "elf_writer.h"
+#include "mem_map.h"
 #include "safe_map.h"
 
 namespace mcld {
@@ -61,7 +62,8 @@ class ElfWriterMclinker FINAL : public ElfWriter {
   ~ElfWriterMclinker();
 
   void Init();
-  void AddOatInput(std::vector<uint8_t>& oat_contents);
+  MemMap* WriteOatContents(OatWriter* oat_writer);
+  void AddOatInput(const byte* oat_contents, size_t size);
   void AddMethodInputs(const std::vector<const DexFile*>& dex_files);
   void AddCompiledCodeInput(const CompiledCode& compiled_code);
   void AddRuntimeInputs(const std::string& android_root, bool is_host);
@@ -16,10 +16,13 @@
 
 #include "elf_writer_quick.h"
 
+#include <zlib.h>
+
 #include "base/logging.h"
 #include "base/unix_file/fd_file.h"
 #include "buffered_output_stream.h"
 #include "driver/compiler_driver.h"
+#include "driver/compiler_options.h"
 #include "elf_utils.h"
 #include "file_output_stream.h"
 #include "globals.h"
@@ -275,6 +278,15 @@ bool ElfWriterQuick::Write(OatWriter* oat_writer,
   uint32_t shstrtab_debug_frame_offset = shstrtab.size();
   shstrtab += ".debug_frame";
   shstrtab += '\0';
+  uint32_t shstrtab_symtab_offset = shstrtab.size();
+  shstrtab += ".symtab";
+  shstrtab += '\0';
+  uint32_t shstrtab_strtab_offset = shstrtab.size();
+  shstrtab += ".strtab";
+  shstrtab += '\0';
+  uint32_t shstrtab_zdebug_frame_offset = shstrtab.size();
+  shstrtab += ".zdebug_frame";
+  shstrtab += '\0';
   uint32_t shstrtab_size = shstrtab.size();
   expected_offset += shstrtab_size;
   if (debug) {
@@ -283,7 +295,9 @@ bool ElfWriterQuick::Write(OatWriter* oat_writer,
   }
 
   // Create debug informatin, if we have it.
-  bool generateDebugInformation = compiler_driver_->GetCallFrameInformation() != nullptr;
+  const CompilerOptions& compiler_options = compiler_driver_->GetCompilerOptions();
+  bool generateDebugInformation = compiler_options.GetGenerateGDBInformation() &&
+      compiler_driver_->GetCallFrameInformation() != nullptr;
   std::vector<uint8_t> dbg_info;
   std::vector<uint8_t> dbg_abbrev;
   std::vector<uint8_t> dbg_str;
@@ -328,6 +342,43 @@ bool ElfWriterQuick::Write(OatWriter* oat_writer,
     LOG(INFO) << "shdbg_str_size=" << shdbg_str_size << std::hex << " " << shdbg_str_size;
   }
 
+  // Otherwise create the mini debug information, if requested.
+  bool generateMiniDebugInformation =
+      !generateDebugInformation && compiler_options.GetGenerateMiniDebugInfo();
+  std::vector<Elf32_Sym> symtab;
+  std::string strtab;
+  std::vector<uint8_t> zdbg_frm;
+  if (generateMiniDebugInformation) {
+    FillInMiniDebugInformation(oat_writer, oat_exec_offset, &symtab, &strtab, &zdbg_frm);
+  }
+
+  uint32_t symtab_alignment = sizeof(Elf32_Word);
+  uint32_t symtab_offset = expected_offset = RoundUp(expected_offset, symtab_alignment);
+  uint32_t symtab_size = sizeof(Elf32_Sym) * symtab.size();
+  expected_offset += symtab_size;
+  if (debug) {
+    LOG(INFO) << "symtab_offset=" << symtab_offset << std::hex << " " << symtab_offset;
+    LOG(INFO) << "symtab_size=" << symtab_size << std::hex << " " << symtab_size;
+  }
+
+  uint32_t strtab_alignment = 1;
+  uint32_t strtab_offset = expected_offset;
+  uint32_t strtab_size = strtab.size();
+  expected_offset += strtab_size;
+  if (debug) {
+    LOG(INFO) << "strtab_offset=" << strtab_offset << std::hex << " " << strtab_offset;
+    LOG(INFO) << "strtab_size=" << strtab_size << std::hex << " " << strtab_size;
+  }
+
+  uint32_t zdbg_frm_alignment = 1;
+  uint32_t zdbg_frm_offset = expected_offset;
+  uint32_t zdbg_frm_size = zdbg_frm.size();
+  expected_offset += zdbg_frm_size;
+  if (debug) {
+    LOG(INFO) << "zdbg_frm_offset=" << zdbg_frm_offset << std::hex << " " << zdbg_frm_offset;
+    LOG(INFO) << "zdbg_frm_size=" << zdbg_frm_size << std::hex << " " << zdbg_frm_size;
+  }
+
   // section headers (after all sections)
   uint32_t shdr_alignment = sizeof(Elf32_Word);
   uint32_t shdr_offset = expected_offset = RoundUp(expected_offset, shdr_alignment);
@@ -343,7 +394,13 @@ bool ElfWriterQuick::Write(OatWriter* oat_writer,
   const uint8_t SH_DBG_ABRV = 9;
   const uint8_t SH_DBG_FRM  = 10;
   const uint8_t SH_DBG_STR  = 11;
-  const uint8_t SH_NUM      = generateDebugInformation ? 12 : 8;
+  // The mini debug information replaces the full debug sections.
+  const uint8_t SH_SYMTAB   = 8;
+  const uint8_t SH_STRTAB   = 9;
+  const uint8_t SH_ZDBG_FRM = 10;
+  const uint8_t SH_NUM      = generateDebugInformation ? 12 :
+                              !generateMiniDebugInformation ? 8 :
+                              zdbg_frm.empty() ? 10 : 11;
   uint32_t shdr_size = sizeof(Elf32_Shdr) * SH_NUM;
   expected_offset += shdr_size;
   if (debug) {
@@ -677,6 +734,48 @@ bool ElfWriterQuick::Write(OatWriter* oat_writer,
     section_headers[SH_DBG_STR].sh_entsize   = 0;
   }
 
+  if (generateMiniDebugInformation) {
+    // All the method symbols are in .text, only the undefined symbol 0 is not.
+    for (size_t i = 1; i < symtab.size(); ++i) {
+      symtab[i].st_shndx = SH_TEXT;
+    }
+
+    section_headers[SH_SYMTAB].sh_name      = shstrtab_symtab_offset;
+    section_headers[SH_SYMTAB].sh_type      = SHT_SYMTAB;
+    section_headers[SH_SYMTAB].sh_flags     = 0;
+    section_headers[SH_SYMTAB].sh_addr      = 0;
+    section_headers[SH_SYMTAB].sh_offset    = symtab_offset;
+    section_headers[SH_SYMTAB].sh_size      = symtab_size;
+    section_headers[SH_SYMTAB].sh_link      = SH_STRTAB;
+    section_headers[SH_SYMTAB].sh_info      = symtab.size();  // All symbols are STB_LOCAL.
+    section_headers[SH_SYMTAB].sh_addralign = symtab_alignment;
+    section_headers[SH_SYMTAB].sh_entsize   = sizeof(Elf32_Sym);
+
+    section_headers[SH_STRTAB].sh_name      = shstrtab_strtab_offset;
+    section_headers[SH_STRTAB].sh_type      = SHT_STRTAB;
+    section_headers[SH_STRTAB].sh_flags     = 0;
+    section_headers[SH_STRTAB].sh_addr      = 0;
+    section_headers[SH_STRTAB].sh_offset    = strtab_offset;
+    section_headers[SH_STRTAB].sh_size      = strtab_size;
+    section_headers[SH_STRTAB].sh_link      = 0;
+    section_headers[SH_STRTAB].sh_info      = 0;
+    section_headers[SH_STRTAB].sh_addralign = strtab_alignment;
+    section_headers[SH_STRTAB].sh_entsize   = 0;
+
+    if (!zdbg_frm.empty()) {
+      section_headers[SH_ZDBG_FRM].sh_name      = shstrtab_zdebug_frame_offset;
+      section_headers[SH_ZDBG_FRM].sh_type      = SHT_PROGBITS;
+      section_headers[SH_ZDBG_FRM].sh_flags     = 0;
+      section_headers[SH_ZDBG_FRM].sh_addr      = 0;
+      section_headers[SH_ZDBG_FRM].sh_offset    = zdbg_frm_offset;
+      section_headers[SH_ZDBG_FRM].sh_size      = zdbg_frm_size;
+      section_headers[SH_ZDBG_FRM].sh_link      = 0;
+      section_headers[SH_ZDBG_FRM].sh_info      = 0;
+      section_headers[SH_ZDBG_FRM].sh_addralign = zdbg_frm_alignment;
+      section_headers[SH_ZDBG_FRM].sh_entsize   = 0;
+    }
+  }
+
   // phase 3: writing file
 
   // Elf32_Ehdr
@@ -819,9 +918,52 @@ bool ElfWriterQuick::Write(OatWriter* oat_writer,
     }
   }
 
+  if (generateMiniDebugInformation) {
+    // .symtab
+    DCHECK_LE(shstrtab_offset + shstrtab_size, symtab_offset);
+    if (static_cast<off_t>(symtab_offset) != lseek(elf_file_->Fd(), symtab_offset, SEEK_SET)) {
+      PLOG(ERROR) << "Failed to seek to .symtab offset " << symtab_offset
+                  << " for " << elf_file_->GetPath();
+      return false;
+    }
+    if (!elf_file_->WriteFully(&symtab[0], symtab_size)) {
+      PLOG(ERROR) << "Failed to write .symtab for " << elf_file_->GetPath();
+      return false;
+    }
+
+    // .strtab
+    DCHECK_LE(symtab_offset + symtab_size, strtab_offset);
+    if (static_cast<off_t>(strtab_offset) != lseek(elf_file_->Fd(), strtab_offset, SEEK_SET)) {
+      PLOG(ERROR) << "Failed to seek to .strtab offset " << strtab_offset
+                  << " for " << elf_file_->GetPath();
+      return false;
+    }
+    if (!elf_file_->WriteFully(&strtab[0], strtab_size)) {
+      PLOG(ERROR) << "Failed to write .strtab for " << elf_file_->GetPath();
+      return false;
+    }
+
+    // .zdebug_frame
+    if (!zdbg_frm.empty()) {
+      DCHECK_LE(strtab_offset + strtab_size, zdbg_frm_offset);
+      if (static_cast<off_t>(zdbg_frm_offset) !=
+          lseek(elf_file_->Fd(), zdbg_frm_offset, SEEK_SET)) {
+        PLOG(ERROR) << "Failed to seek to .zdebug_frame offset " << zdbg_frm_offset
+                    << " for " << elf_file_->GetPath();
+        return false;
+      }
+      if (!elf_file_->WriteFully(&zdbg_frm[0], zdbg_frm_size)) {
+        PLOG(ERROR) << "Failed to write .zdebug_frame for " << elf_file_->GetPath();
+        return false;
+      }
+    }
+  }
+
   // section headers (after all sections)
   if (generateDebugInformation) {
     DCHECK_LE(shdbg_str_offset + shdbg_str_size, shdr_offset);
+  } else if (generateMiniDebugInformation) {
+    DCHECK_LE(zdbg_frm_offset + zdbg_frm_size, shdr_offset);
   } else {
     DCHECK_LE(shstrtab_offset + shstrtab_size, shdr_offset);
   }
@@ -997,4 +1139,67 @@ void ElfWriterQuick::FillInCFIInformation(OatWriter* oat_writer,
   UpdateWord(dbg_info, low_pc_offset + 4, high_pc);
 }
 
+// Compresses a debug section the way the GNU tools expect of a .zdebug section: the magic "ZLIB",
+// the uncompressed size as a 64-bit big-endian value, then the zlib stream.
+static bool CompressDebugSection(const std::vector<uint8_t>& section,
+                                 std::vector<uint8_t>* compressed) {
+  static const char kMagic[] = "ZLIB";
+  compressed->assign(kMagic, kMagic + strlen(kMagic));
+  uint64_t section_size = section.size();
+  for (int shift = 56; shift >= 0; shift -= 8) {
+    compressed->push_back(static_cast<uint8_t>(section_size >> shift));
+  }
+  size_t header_size = compressed->size();
+  uLongf stream_size = compressBound(section.size());
+  compressed->resize(header_size + stream_size);
+  if (compress2(&(*compressed)[header_size], &stream_size, &section[0], section.size(),
+                Z_BEST_COMPRESSION) != Z_OK) {
+    return false;
+  }
+  compressed->resize(header_size + stream_size);
+  return true;
+}
+
+void ElfWriterQuick::FillInMiniDebugInformation(OatWriter* oat_writer,
+                                                uint32_t text_address,
+                                                std::vector<Elf32_Sym>* symtab,
+                                                std::string* strtab,
+                                                std::vector<uint8_t>* zdbg_frm) {
+  // Symbol 0 is the undefined symbol, string 0 the empty string.
+  Elf32_Sym symbol;
+  memset(&symbol, 0, sizeof(symbol));
+  symtab->push_back(symbol);
+  *strtab += '\0';
+
+  // The method names have no signature to keep .strtab small. On Thumb2 the low bit of the
+  // value is set, as for any Thumb function symbol.
+  const std::vector<OatWriter::DebugInfo>& methods = oat_writer->GetCFIMethodInfo();
+  symtab->reserve(methods.size() + 1);
+  for (const OatWriter::DebugInfo& info : methods) {
+    symbol.st_name  = strtab->size();
+    symbol.st_value = text_address + info.low_pc_;
+    symbol.st_size  = info.high_pc_ - info.low_pc_;
+    SetBindingAndType(&symbol, STB_LOCAL, STT_FUNC);
+    symbol.st_other = STV_DEFAULT;
+    symtab->push_back(symbol);
+    *strtab += info.method_name_;
+    *strtab += '\0';
+  }
+
+  // Only some backends produce call frame information. The FDEs locate their method relative
+  // to .text, make them use the addresses of the symbols.
+  const std::vector<uint8_t>* cfi_info = compiler_driver_->GetCallFrameInformation();
+  if (cfi_info != nullptr && !cfi_info->empty()) {
+    std::vector<uint8_t> debug_frame(*cfi_info);
+    for (size_t offset = 0; offset + 3 * sizeof(uint32_t) <= debug_frame.size(); ) {
+      const uint32_t* entry = reinterpret_cast<const uint32_t*>(&debug_frame[offset]);
+      if (entry[1] != 0xFFFFFFFFU) {  // Not a CIE.
+        UpdateWord(&debug_frame, offset + 2 * sizeof(uint32_t), entry[2] + text_address);
+      }
+      offset += sizeof(uint32_t) + entry[0];
+    }
+    CHECK(CompressDebugSection(debug_frame, zdbg_frm));
+  }
+}
+
 }  // namespace art
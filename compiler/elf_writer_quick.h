@@ -17,6 +17,7 @@
 #ifndef ART_COMPILER_ELF_WRITER_QUICK_H_
 #define ART_COMPILER_ELF_WRITER_QUICK_H_
 
+#include "elf_utils.h"
 #include "elf_writer.h"
 
 namespace art {
@@ -55,6 +56,18 @@ class ElfWriterQuick FINAL : public ElfWriter {
   void FillInCFIInformation(OatWriter* oat_writer, std::vector<uint8_t>* dbg_info,
                             std::vector<uint8_t>* dbg_abbrev, std::vector<uint8_t>* dbg_str);
 
+  /*
+   * @brief Generate the mini debug information: method symbols and compressed CFI
+   * @param oat_writer The Oat file Writer.
+   * @param text_address Address of the .text section.
+   * @param symtab Symbols of the methods, in .text.
+   * @param strtab Names of the symbols.
+   * @param zdbg_frm Compressed debug_frame section, empty if there is no CFI.
+   */
+  void FillInMiniDebugInformation(OatWriter* oat_writer, uint32_t text_address,
+                                  std::vector<Elf32_Sym>* symtab, std::string* strtab,
+                                  std::vector<uint8_t>* zdbg_frm);
+
   DISALLOW_IMPLICIT_CONSTRUCTORS(ElfWriterQuick);
 };
 
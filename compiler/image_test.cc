@@ -109,6 +109,10 @@ TEST_F(ImageTest, WriteRead) {
     ASSERT_TRUE(image_header.IsValid());
     ASSERT_GE(image_header.GetImageBitmapOffset(), sizeof(image_header));
     ASSERT_NE(0U, image_header.GetImageBitmapSize());
+    ASSERT_GE(image_header.GetRelocationBitmapOffset(),
+              image_header.GetImageBitmapOffset() + image_header.GetImageBitmapSize());
+    ASSERT_NE(0U, image_header.GetRelocationBitmapSize());
+    ASSERT_EQ(0, image_header.GetPatchDelta());
 
     gc::Heap* heap = Runtime::Current()->GetHeap();
     ASSERT_TRUE(!heap->GetContinuousSpaces().empty());
@@ -216,4 +220,21 @@ TEST_F(ImageTest, ImageHeaderIsValid) {
     ASSERT_FALSE(image_header.IsValid());
 }
 
+TEST_F(ImageTest, ImageHeaderRelocate) {
+    uint32_t image_begin = ART_BASE_ADDRESS;
+    uint32_t oat_file_begin = ART_BASE_ADDRESS + (4 * KB);
+    uint32_t oat_data_begin = ART_BASE_ADDRESS + (8 * KB);
+    ImageHeader image_header(image_begin, 16 * KB, 0, 0, ART_BASE_ADDRESS + (1 * KB), 0,
+                             oat_file_begin, oat_data_begin, ART_BASE_ADDRESS + (9 * KB),
+                             ART_BASE_ADDRESS + (10 * KB));
+    int32_t delta = -8 * static_cast<int32_t>(KB);
+    image_header.Relocate(delta);
+    image_header.Relocate(3 * delta);
+    ASSERT_EQ(4 * delta, image_header.GetPatchDelta());
+    ASSERT_EQ(reinterpret_cast<byte*>(image_begin + 4 * delta), image_header.GetImageBegin());
+    ASSERT_EQ(reinterpret_cast<byte*>(oat_file_begin + 4 * delta), image_header.GetOatFileBegin());
+    ASSERT_EQ(reinterpret_cast<byte*>(oat_data_begin + 4 * delta), image_header.GetOatDataBegin());
+    ASSERT_TRUE(image_header.IsValid());
+}
+
 }  // namespace art
@@ -18,6 +18,7 @@
 
 #include <sys/stat.h>
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -53,6 +54,7 @@
 #include "runtime.h"
 #include "scoped_thread_state_change.h"
 #include "handle_scope-inl.h"
+#include "thread_pool.h"
 #include "utils.h"
 
 using ::art::mirror::ArtField;
@@ -118,6 +120,7 @@ bool ImageWriter::Write(const std::string& image_filename,
     PruneNonImageClasses();  // Remove junk
     ComputeLazyFieldsForImageClasses();  // Add useful information
     ComputeEagerResolvedStrings();
+    ShareStringArrays();  // Before the GC, which frees the arrays no string uses anymore.
     Thread::Current()->TransitionFromRunnableToSuspended(kNative);
   }
   gc::Heap* heap = Runtime::Current()->GetHeap();
@@ -132,12 +135,15 @@ bool ImageWriter::Write(const std::string& image_filename,
     CheckNonImageClassesRemoved();
   }
 
+  // The workers attach to the runtime, so create them before becoming runnable.
+  ThreadPool thread_pool("Image writer thread pool", compiler_driver_.GetThreadCount() - 1);
+
   Thread::Current()->TransitionFromSuspendedToRunnable();
   size_t oat_loaded_size = 0;
   size_t oat_data_offset = 0;
   ElfWriter::GetOatElfInformation(oat_file.get(), oat_loaded_size, oat_data_offset);
   CalculateNewObjectOffsets(oat_loaded_size, oat_data_offset);
-  CopyAndFixupObjects();
+  CopyAndFixupObjects(&thread_pool);
   PatchOatCodeAndMethods();
   Thread::Current()->TransitionFromRunnableToSuspended(kNative);
 
@@ -152,6 +158,11 @@ bool ImageWriter::Write(const std::string& image_filename,
     return EXIT_FAILURE;
   }
 
+  if (!WriteRelocations(image_file.get())) {
+    PLOG(ERROR) << "Failed to write image relocations " << image_filename;
+    return false;
+  }
+
   // Write out the image.
   CHECK_EQ(image_end_, image_header->GetImageSize());
   if (!image_file->WriteFully(image_->Begin(), image_end_)) {
@@ -171,6 +182,33 @@ bool ImageWriter::Write(const std::string& image_filename,
   return true;
 }
 
+bool ImageWriter::WriteRelocations(File* image_file) {
+  ImageHeader* image_header = reinterpret_cast<ImageHeader*>(image_->Begin());
+  const size_t image_bytes_per_bitmap_byte = kBitsPerByte * kRelocationAlignment;
+  const size_t bitmap_bytes = RoundUp(image_end_, image_bytes_per_bitmap_byte) /
+      image_bytes_per_bitmap_byte;
+  const size_t bitmap_offset =
+      image_header->GetImageBitmapOffset() + image_header->GetImageBitmapSize();
+  const size_t oat_relocations_offset = RoundUp(bitmap_offset + bitmap_bytes, sizeof(uint32_t));
+  std::sort(oat_relocations_.begin(), oat_relocations_.end());
+  image_header->relocation_bitmap_offset_ = bitmap_offset;
+  image_header->relocation_bitmap_size_ = bitmap_bytes;
+  image_header->oat_relocations_offset_ = oat_relocations_offset;
+  image_header->oat_relocations_size_ = oat_relocations_.size() * sizeof(uint32_t);
+
+  if (image_file->Write(reinterpret_cast<char*>(relocation_bitmap_->Begin()), bitmap_bytes,
+                        bitmap_offset) != static_cast<int64_t>(bitmap_bytes)) {
+    return false;
+  }
+  const int64_t oat_relocations_size = image_header->oat_relocations_size_;
+  if (!oat_relocations_.empty() &&
+      image_file->Write(reinterpret_cast<char*>(&oat_relocations_[0]), oat_relocations_size,
+                        oat_relocations_offset) != oat_relocations_size) {
+    return false;
+  }
+  return true;
+}
+
 void ImageWriter::SetImageOffset(mirror::Object* object, size_t offset) {
   DCHECK(object != nullptr);
   DCHECK_NE(offset, 0U);
@@ -242,6 +280,14 @@ bool ImageWriter::AllocMemory() {
     LOG(ERROR) << "Failed to allocate memory for image bitmap";
     return false;
   }
+
+  // Create the relocation bitmap.
+  relocation_bitmap_.reset(gc::accounting::RelocationBitmap::Create("image relocation bitmap",
+                                                                    image_->Begin(), length));
+  if (relocation_bitmap_.get() == nullptr) {
+    LOG(ERROR) << "Failed to allocate memory for image relocation bitmap";
+    return false;
+  }
   return true;
 }
 
@@ -286,6 +332,47 @@ void ImageWriter::ComputeEagerResolvedStrings() SHARED_LOCKS_REQUIRED(Locks::mut
   Runtime::Current()->GetHeap()->VisitObjects(ComputeEagerResolvedStringsCallback, this);
 }
 
+void ImageWriter::CollectStringsCallback(Object* obj, void* arg) {
+  if (obj->GetClass()->IsStringClass()) {
+    reinterpret_cast<std::vector<String*>*>(arg)->push_back(obj->AsString());
+  }
+}
+
+struct StringLess {
+  bool operator()(String* lhs, String* rhs) const SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    return lhs->CompareTo(rhs) < 0;
+  }
+};
+
+void ImageWriter::ShareStringArrays() {
+  std::vector<String*> strings;
+  {
+    ReaderMutexLock mu(Thread::Current(), *Locks::heap_bitmap_lock_);
+    Runtime::Current()->GetHeap()->VisitObjects(CollectStringsCallback, &strings);
+  }
+  // Once sorted, the strings starting with a given string directly follow it. Going backwards,
+  // each string either starts the array of the following string, or starts a new one.
+  std::sort(strings.begin(), strings.end(), StringLess());
+  String* base = nullptr;
+  size_t shared_chars = 0;
+  for (auto it = strings.rbegin(); it != strings.rend(); ++it) {
+    String* string = *it;
+    const uint16_t* chars = string->GetCharArray()->GetData() + string->GetOffset();
+    if (base != nullptr && string->GetLength() <= base->GetLength() &&
+        memcmp(base->GetCharArray()->GetData() + base->GetOffset(), chars,
+               string->GetLength() * sizeof(uint16_t)) == 0) {
+      if (string->GetCharArray() != base->GetCharArray()) {
+        string->ShareArray(base->GetCharArray(), base->GetOffset());
+        shared_chars += string->GetLength();
+      }
+    } else {
+      base = string;
+    }
+  }
+  VLOG(compiler) << "Shared the char arrays of " << strings.size() << " strings, saving up to "
+                 << shared_chars << " chars";
+}
+
 bool ImageWriter::IsImageClass(Class* klass) {
   return compiler_driver_.IsImageClass(klass->GetDescriptor().c_str());
 }
@@ -548,8 +635,35 @@ void ImageWriter::CalculateNewObjectOffsets(size_t oat_loaded_size, size_t oat_d
   // Note that image_end_ is left at end of used space
 }
 
-void ImageWriter::CopyAndFixupObjects()
+// Copies and fixes up a range of the objects of the image. Objects only read the forwarding
+// addresses in the lock words of the originals and write their own copy, so ranges are
+// independent.
+class CopyAndFixupObjectsTask : public Task {
+ public:
+  CopyAndFixupObjectsTask(ImageWriter* image_writer, Object* const* begin, Object* const* end)
+      : image_writer_(image_writer), begin_(begin), end_(end) {
+  }
+
+  // The thread waiting for the tasks holds the mutator lock and the heap bitmap lock.
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    for (Object* const* it = begin_; it != end_; ++it) {
+      image_writer_->CopyAndFixupObject(*it);
+    }
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  ImageWriter* const image_writer_;
+  Object* const* const begin_;
+  Object* const* const end_;
+};
+
+void ImageWriter::CopyAndFixupObjects(ThreadPool* thread_pool)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  static constexpr size_t kObjectsPerTask = 4 * KB;
   Thread* self = Thread::Current();
   const char* old_cause = self->StartAssertNoThreadSuspension("ImageWriter");
   gc::Heap* heap = Runtime::Current()->GetHeap();
@@ -557,7 +671,15 @@ void ImageWriter::CopyAndFixupObjects()
   heap->DisableObjectValidation();
   // TODO: Image spaces only?
   WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
-  heap->VisitObjects(CopyAndFixupObjectsCallback, this);
+  std::vector<Object*> objects;
+  heap->VisitObjects(CollectObjectsCallback, &objects);
+  for (size_t begin = 0; begin < objects.size(); begin += kObjectsPerTask) {
+    size_t end = std::min(begin + kObjectsPerTask, objects.size());
+    thread_pool->AddTask(self, new CopyAndFixupObjectsTask(this, &objects[begin], &objects[end]));
+  }
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
   // Fix up the object previously had hash codes.
   for (const std::pair<mirror::Object*, uint32_t>& hash_pair : saved_hashes_) {
     hash_pair.first->SetLockWord(LockWord::FromHashCode(hash_pair.second), false);
@@ -566,22 +688,25 @@ void ImageWriter::CopyAndFixupObjects()
   self->EndAssertNoThreadSuspension(old_cause);
 }
 
-void ImageWriter::CopyAndFixupObjectsCallback(Object* obj, void* arg) {
+void ImageWriter::CollectObjectsCallback(Object* obj, void* arg) {
+  DCHECK(obj != nullptr);
+  reinterpret_cast<std::vector<Object*>*>(arg)->push_back(obj);
+}
+
+void ImageWriter::CopyAndFixupObject(Object* obj) {
   DCHECK(obj != nullptr);
-  DCHECK(arg != nullptr);
-  ImageWriter* image_writer = reinterpret_cast<ImageWriter*>(arg);
   // see GetLocalAddress for similar computation
-  size_t offset = image_writer->GetImageOffset(obj);
-  byte* dst = image_writer->image_->Begin() + offset;
+  size_t offset = GetImageOffset(obj);
+  byte* dst = image_->Begin() + offset;
   const byte* src = reinterpret_cast<const byte*>(obj);
   size_t n = obj->SizeOf();
-  DCHECK_LT(offset + n, image_writer->image_->Size());
+  DCHECK_LT(offset + n, image_->Size());
   memcpy(dst, src, n);
   Object* copy = reinterpret_cast<Object*>(dst);
   // Write in a hash code of objects which have inflated monitors or a hash code in their monitor
   // word.
   copy->SetLockWord(LockWord(), false);
-  image_writer->FixupObject(obj, copy);
+  FixupObject(obj, copy);
 }
 
 class FixupVisitor {
@@ -596,6 +721,9 @@ class FixupVisitor {
     // image.
     copy_->SetFieldObjectWithoutWriteBarrier<false, true, kVerifyNone>(
         offset, image_writer_->GetImageAddress(ref));
+    if (ref != nullptr) {
+      image_writer_->RecordRelocation(copy_, offset);
+    }
   }
 
   // java.lang.ref.Reference visitor.
@@ -604,6 +732,9 @@ class FixupVisitor {
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_) {
     copy_->SetFieldObjectWithoutWriteBarrier<false, true, kVerifyNone>(
         mirror::Reference::ReferentOffset(), image_writer_->GetImageAddress(ref->GetReferent()));
+    if (ref->GetReferent() != nullptr) {
+      image_writer_->RecordRelocation(copy_, mirror::Reference::ReferentOffset());
+    }
   }
 
  private:
@@ -620,12 +751,42 @@ void ImageWriter::FixupObject(Object* orig, Object* copy) {
       // Note the address 'copy' isn't the same as the image address of 'orig'.
       copy->SetReadBarrierPointer(GetImageAddress(orig));
       DCHECK_EQ(copy->GetReadBarrierPointer(), GetImageAddress(orig));
+#ifdef USE_BAKER_OR_BROOKS_READ_BARRIER
+      RecordRelocation(copy, OFFSET_OF_OBJECT_MEMBER(Object, x_rb_ptr_));
+#endif
     }
   }
   FixupVisitor visitor(this, copy);
   orig->VisitReferences<true /*visit class*/>(visitor, visitor);
   if (orig->IsArtMethod<kVerifyNone>()) {
     FixupMethod(orig->AsArtMethod<kVerifyNone>(), down_cast<ArtMethod*>(copy));
+    RecordMethodRelocations(down_cast<ArtMethod*>(copy));
+  }
+}
+
+void ImageWriter::RecordRelocation(Object* copy, MemberOffset offset) {
+  const byte* word = reinterpret_cast<const byte*>(copy) + offset.Uint32Value();
+  DCHECK_ALIGNED(word, kRelocationAlignment);
+  // The bitmap covers the copy of the image, one bit per word rather than per object.
+  relocation_bitmap_->AtomicTestAndSet(reinterpret_cast<const Object*>(word));
+}
+
+void ImageWriter::RecordMethodRelocations(ArtMethod* copy) {
+  // Only pointers set by FixupMethod() point into the oat file, the others are left as copied.
+  const MemberOffset offsets[] = {
+    ArtMethod::EntryPointFromInterpreterOffset(),
+    ArtMethod::NativeMethodOffset(),
+    ArtMethod::EntryPointFromPortableCompiledCodeOffset(),
+    ArtMethod::EntryPointFromQuickCompiledCodeOffset(),
+    ArtMethod::NativeGcMapOffset(),
+  };
+  const uint32_t oat_data_begin = PointerToLowMemUInt32(oat_data_begin_);
+  for (const MemberOffset& offset : offsets) {
+    // Pointers are below 4GB, their low word is the one to relocate.
+    uint32_t value = copy->GetField32<kVerifyNone>(offset);
+    if (value >= oat_data_begin && value - oat_data_begin < oat_file_->Size()) {
+      RecordRelocation(copy, offset);
+    }
   }
 }
 
@@ -637,7 +798,7 @@ void ImageWriter::FixupMethod(ArtMethod* orig, ArtMethod* copy) {
   if (UNLIKELY(orig == Runtime::Current()->GetResolutionMethod())) {
     copy->SetEntryPointFromPortableCompiledCode<kVerifyNone>(GetOatAddress(portable_resolution_trampoline_offset_));
     copy->SetEntryPointFromQuickCompiledCode<kVerifyNone>(GetOatAddress(quick_resolution_trampoline_offset_));
-  } else if (UNLIKELY(orig == Runtime::Current()->GetImtConflictMethod())) {
+  } else if (UNLIKELY(orig->IsImtConflictMethod())) {
     copy->SetEntryPointFromPortableCompiledCode<kVerifyNone>(GetOatAddress(portable_imt_conflict_trampoline_offset_));
     copy->SetEntryPointFromQuickCompiledCode<kVerifyNone>(GetOatAddress(quick_imt_conflict_trampoline_offset_));
   } else {
@@ -692,12 +853,12 @@ void ImageWriter::FixupMethod(ArtMethod* orig, ArtMethod* copy) {
   }
 }
 
-static ArtMethod* GetTargetMethod(const CompilerDriver::CallPatchInformation* patch)
+static ArtMethod* GetTargetMethod(const CompilerDriver::CallPatchInformation* patch,
+                                  mirror::DexCache* target_dex_cache)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
   StackHandleScope<2> hs(Thread::Current());
-  Handle<mirror::DexCache> dex_cache(
-      hs.NewHandle(class_linker->FindDexCache(*patch->GetTargetDexFile())));
+  Handle<mirror::DexCache> dex_cache(hs.NewHandle(target_dex_cache));
   auto class_loader(hs.NewHandle<mirror::ClassLoader>(nullptr));
   ArtMethod* method = class_linker->ResolveMethod(*patch->GetTargetDexFile(),
                                                   patch->GetTargetMethodIdx(),
@@ -716,11 +877,12 @@ static ArtMethod* GetTargetMethod(const CompilerDriver::CallPatchInformation* pa
   return method;
 }
 
-static Class* GetTargetType(const CompilerDriver::TypePatchInformation* patch)
+static Class* GetTargetType(const CompilerDriver::TypePatchInformation* patch,
+                            mirror::DexCache* target_dex_cache)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
   StackHandleScope<2> hs(Thread::Current());
-  Handle<mirror::DexCache> dex_cache(hs.NewHandle(class_linker->FindDexCache(patch->GetDexFile())));
+  Handle<mirror::DexCache> dex_cache(hs.NewHandle(target_dex_cache));
   auto class_loader(hs.NewHandle<mirror::ClassLoader>(nullptr));
   Class* klass = class_linker->ResolveType(patch->GetDexFile(),
                                            patch->GetTargetTypeIdx(),
@@ -735,6 +897,30 @@ static Class* GetTargetType(const CompilerDriver::TypePatchInformation* patch)
   return klass;
 }
 
+mirror::DexCache* ImageWriter::GetPatchDexCache(const DexFile& dex_file) {
+  auto it = patch_dex_caches_.find(&dex_file);
+  if (it != patch_dex_caches_.end()) {
+    return it->second;
+  }
+  mirror::DexCache* dex_cache = Runtime::Current()->GetClassLinker()->FindDexCache(dex_file);
+  patch_dex_caches_.Put(&dex_file, dex_cache);
+  return dex_cache;
+}
+
+const void* ImageWriter::GetPatchReferrerCode(const CompilerDriver::PatchInformation* patch) {
+  MethodReference referrer(&patch->GetDexFile(), patch->GetReferrerMethodIdx());
+  auto it = patch_referrer_code_.find(referrer);
+  if (it != patch_referrer_code_.end()) {
+    return it->second;
+  }
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  const void* quick_oat_code = class_linker->GetQuickOatCodeFor(patch->GetDexFile(),
+                                                                patch->GetReferrerClassDefIdx(),
+                                                                patch->GetReferrerMethodIdx());
+  patch_referrer_code_.Put(referrer, quick_oat_code);
+  return quick_oat_code;
+}
+
 void ImageWriter::PatchOatCodeAndMethods() {
   Thread* self = Thread::Current();
   ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
@@ -744,16 +930,13 @@ void ImageWriter::PatchOatCodeAndMethods() {
   const CallPatches& code_to_patch = compiler_driver_.GetCodeToPatch();
   for (size_t i = 0; i < code_to_patch.size(); i++) {
     const CompilerDriver::CallPatchInformation* patch = code_to_patch[i];
-    ArtMethod* target = GetTargetMethod(patch);
+    ArtMethod* target = GetTargetMethod(patch, GetPatchDexCache(*patch->GetTargetDexFile()));
     uintptr_t quick_code = reinterpret_cast<uintptr_t>(class_linker->GetQuickOatCodeFor(target));
     uintptr_t code_base = reinterpret_cast<uintptr_t>(&oat_file_->GetOatHeader());
     uintptr_t code_offset = quick_code - code_base;
     if (patch->IsRelative()) {
       // value to patch is relative to the location being patched
-      const void* quick_oat_code =
-        class_linker->GetQuickOatCodeFor(patch->GetDexFile(),
-                                         patch->GetReferrerClassDefIdx(),
-                                         patch->GetReferrerMethodIdx());
+      const void* quick_oat_code = GetPatchReferrerCode(patch);
       uintptr_t base = reinterpret_cast<uintptr_t>(quick_oat_code);
       uintptr_t patch_location = base + patch->GetLiteralOffset();
       uintptr_t value = quick_code - patch_location + patch->RelativeOffset();
@@ -775,7 +958,7 @@ void ImageWriter::PatchOatCodeAndMethods() {
   const CallPatches& methods_to_patch = compiler_driver_.GetMethodsToPatch();
   for (size_t i = 0; i < methods_to_patch.size(); i++) {
     const CompilerDriver::CallPatchInformation* patch = methods_to_patch[i];
-    ArtMethod* target = GetTargetMethod(patch);
+    ArtMethod* target = GetTargetMethod(patch, GetPatchDexCache(*patch->GetTargetDexFile()));
     SetPatchLocation(patch, PointerToLowMemUInt32(GetImageAddress(target)));
   }
 
@@ -783,21 +966,20 @@ void ImageWriter::PatchOatCodeAndMethods() {
       compiler_driver_.GetClassesToPatch();
   for (size_t i = 0; i < classes_to_patch.size(); i++) {
     const CompilerDriver::TypePatchInformation* patch = classes_to_patch[i];
-    Class* target = GetTargetType(patch);
+    Class* target = GetTargetType(patch, GetPatchDexCache(patch->GetDexFile()));
     SetPatchLocation(patch, PointerToLowMemUInt32(GetImageAddress(target)));
   }
 
   // Update the image header with the new checksum after patching
   ImageHeader* image_header = reinterpret_cast<ImageHeader*>(image_->Begin());
   image_header->SetOatChecksum(oat_file_->GetOatHeader().GetChecksum());
+  patch_dex_caches_.clear();
+  patch_referrer_code_.clear();
   self->EndAssertNoThreadSuspension(old_cause);
 }
 
 void ImageWriter::SetPatchLocation(const CompilerDriver::PatchInformation* patch, uint32_t value) {
-  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
-  const void* quick_oat_code = class_linker->GetQuickOatCodeFor(patch->GetDexFile(),
-                                                                patch->GetReferrerClassDefIdx(),
-                                                                patch->GetReferrerMethodIdx());
+  const void* quick_oat_code = GetPatchReferrerCode(patch);
   OatHeader& oat_header = const_cast<OatHeader&>(oat_file_->GetOatHeader());
   // TODO: make this Thumb2 specific
   uint8_t* base = reinterpret_cast<uint8_t*>(reinterpret_cast<uintptr_t>(quick_oat_code) & ~0x1);
@@ -826,6 +1008,11 @@ void ImageWriter::SetPatchLocation(const CompilerDriver::PatchInformation* patch
   }
   *patch_location = value;
   oat_header.UpdateChecksum(patch_location, sizeof(value));
+  if (!patch->IsCall() || !patch->AsCall()->IsRelative()) {
+    // Absolute addresses of the image or oat file move with them.
+    oat_relocations_.push_back(reinterpret_cast<uint8_t*>(patch_location) -
+                               reinterpret_cast<uint8_t*>(&oat_header));
+  }
 }
 
 }  // namespace art
@@ -115,6 +115,12 @@ class ImageWriter {
   static void ComputeEagerResolvedStringsCallback(mirror::Object* obj, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Makes the strings that are prefixes of other strings, or equal to them, use their char arrays,
+  // so that the image only holds the longest ones.
+  void ShareStringArrays() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static void CollectStringsCallback(mirror::Object* obj, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Remove unwanted classes from various roots.
   void PruneNonImageClasses() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   static bool NonImageClassesVisitor(mirror::Class* c, void* arg)
@@ -140,20 +146,37 @@ class ImageWriter {
   static void WalkFieldsCallback(mirror::Object* obj, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  // Creates the contiguous image in memory and adjusts pointers.
-  void CopyAndFixupObjects();
-  static void CopyAndFixupObjectsCallback(mirror::Object* obj, void* arg)
+  // Creates the contiguous image in memory and adjusts pointers, splitting the objects
+  // between the threads of `thread_pool`.
+  void CopyAndFixupObjects(ThreadPool* thread_pool);
+  static void CollectObjectsCallback(mirror::Object* obj, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void CopyAndFixupObject(mirror::Object* obj)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void FixupMethod(mirror::ArtMethod* orig, mirror::ArtMethod* copy)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void FixupObject(mirror::Object* orig, mirror::Object* copy)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Marks the word at `offset` in `copy` as holding an absolute address for relocation. Safe to
+  // call from several threads.
+  void RecordRelocation(mirror::Object* copy, MemberOffset offset);
+  // Marks the native pointers of `copy` which point into the oat file.
+  void RecordMethodRelocations(mirror::ArtMethod* copy)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Writes the relocation tables after the image bitmap and records them in the image header.
+  bool WriteRelocations(File* image_file);
+
   // Patches references in OatFile to expect runtime addresses.
   void PatchOatCodeAndMethods()
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void SetPatchLocation(const CompilerDriver::PatchInformation* patch, uint32_t value)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Lookups shared by many patches, cached for the duration of PatchOatCodeAndMethods().
+  mirror::DexCache* GetPatchDexCache(const DexFile& dex_file)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  const void* GetPatchReferrerCode(const CompilerDriver::PatchInformation* patch)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   const CompilerDriver& compiler_driver_;
 
@@ -175,9 +198,19 @@ class ImageWriter {
   // Beginning target oat address for the pointers from the output image to its oat file.
   const byte* oat_data_begin_;
 
+  // Caches of GetPatchDexCache() and GetPatchReferrerCode().
+  SafeMap<const DexFile*, mirror::DexCache*> patch_dex_caches_;
+  SafeMap<MethodReference, const void*, MethodReferenceComparator> patch_referrer_code_;
+
   // Image bitmap which lets us know where the objects inside of the image reside.
   std::unique_ptr<gc::accounting::ContinuousSpaceBitmap> image_bitmap_;
 
+  // Words of the image holding absolute addresses, which move when the image is relocated.
+  std::unique_ptr<gc::accounting::RelocationBitmap> relocation_bitmap_;
+
+  // Offsets from oat_data_begin_ of the absolute addresses patched into the oat file's code.
+  std::vector<uint32_t> oat_relocations_;
+
   // Offset from oat_data_begin_ to the stubs.
   uint32_t interpreter_to_interpreter_bridge_offset_;
   uint32_t interpreter_to_compiled_code_bridge_offset_;
@@ -190,6 +223,7 @@ class ImageWriter {
   uint32_t quick_resolution_trampoline_offset_;
   uint32_t quick_to_interpreter_bridge_offset_;
 
+  friend class CopyAndFixupObjectsTask;
   friend class FixupVisitor;
   DISALLOW_COPY_AND_ASSIGN(ImageWriter);
 };
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_compiler.h"
+
+#include <vector>
+
+#include "ScopedLocalRef.h"
+
+#include "class_linker.h"
+#include "dex/quick/dex_file_method_inliner.h"
+#include "dex_file-inl.h"
+#include "entrypoints/entrypoint_utils.h"
+#include "handle_scope-inl.h"
+#include "interpreter/interpreter.h"
+#include "jit/jit.h"
+#include "jit/jit_code_cache.h"
+#include "jni_internal.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/class_loader.h"
+#include "mirror/dex_cache-inl.h"
+#include "oat.h"
+#include "object_utils.h"
+#include "perf_map.h"
+#include "runtime.h"
+#include "scoped_thread_state_change.h"
+#include "thread.h"
+#include "verifier/method_verifier-inl.h"
+
+namespace art {
+namespace jit {
+
+JitCompiler* JitCompiler::Create() {
+  return new JitCompiler();
+}
+
+JitCompiler::JitCompiler()
+    : compiler_options_(new CompilerOptions()),
+      cumulative_logger_(new CumulativeLogger("jit times")) {
+  compiler_options_->SetIncludeOsrEntries(true);
+  verification_results_.reset(new VerificationResults(compiler_options_.get()));
+  method_inliner_map_.reset(new DexFileToMethodInlinerMap());
+  // The Quick compiler generates Thumb2 code for ARM, as for dex2oat.
+  InstructionSet instruction_set = (kRuntimeISA == kArm) ? kThumb2 : kRuntimeISA;
+  compiler_driver_.reset(new CompilerDriver(compiler_options_.get(),
+                                            verification_results_.get(),
+                                            method_inliner_map_.get(),
+                                            Compiler::kQuick, instruction_set,
+                                            InstructionSetFeatures(),
+                                            false, nullptr, 1, false, false,
+                                            cumulative_logger_.get()));
+}
+
+JitCompiler::~JitCompiler() {
+}
+
+bool JitCompiler::CompileMethod(Thread* self, jobject jmethod) {
+  const DexFile* dex_file;
+  const DexFile::CodeItem* code_item;
+  uint32_t access_flags;
+  InvokeType invoke_type;
+  uint16_t class_def_idx;
+  uint32_t method_idx;
+  jobject jclass_loader;
+  {
+    ScopedObjectAccess soa(self);
+    mirror::ArtMethod* method = soa.Decode<mirror::ArtMethod*>(jmethod);
+    if (method->IsNative() || method->IsAbstract() || method->IsProxyMethod() ||
+        method->IsRuntimeMethod()) {
+      return false;
+    }
+    // The code of static methods of classes being initialized would have to run the class
+    // initialization check, leave them to the interpreter. The class initializer is only
+    // compiled for on-stack replacement, see InstallCode.
+    mirror::Class* klass = method->GetDeclaringClass();
+    if (!klass->IsInitialized() && !(method->IsStatic() && method->IsConstructor())) {
+      return false;
+    }
+    // Already compiled, ahead of time or by an earlier request.
+    ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+    if (class_linker->GetQuickOatCodeFor(method) != GetQuickToInterpreterBridge()) {
+      return false;
+    }
+    MethodHelper mh(method);
+    dex_file = &mh.GetDexFile();
+    class_def_idx = mh.GetClassDefIndex();
+    method_idx = method->GetDexMethodIndex();
+    access_flags = method->GetAccessFlags();
+    invoke_type = method->GetInvokeType();
+    code_item = dex_file->GetCodeItem(method->GetCodeItemOffset());
+    if (!VerifyMethod(self, method)) {
+      return false;
+    }
+    ScopedLocalRef<jobject> local_class_loader(
+        soa.Env(), soa.AddLocalReference<jobject>(klass->GetClassLoader()));
+    jclass_loader = soa.Env()->NewGlobalRef(local_class_loader.get());
+  }
+
+  uint64_t start_ns = NanoTime();
+  CompiledMethod* compiled_method =
+      compiler_driver_->CompileMethodForJit(code_item, access_flags, invoke_type, class_def_idx,
+                                            method_idx, jclass_loader, *dex_file);
+  self->GetJniEnv()->DeleteGlobalRef(jclass_loader);
+  if (compiled_method == nullptr) {
+    return false;
+  }
+
+  ScopedObjectAccess soa(self);
+  // The method may have moved while compiling.
+  mirror::ArtMethod* method = soa.Decode<mirror::ArtMethod*>(jmethod);
+  // The code cache keeps a copy of the code and tables.
+  bool installed =
+      compiled_method->GetQuickCode() != nullptr && InstallCode(self, method, *compiled_method);
+  compiler_driver_->FreeCompiledMethodForJit(compiled_method);
+  if (!installed) {
+    return false;
+  }
+  VLOG(compiler) << "JIT compiled " << PrettyMethod(method) << " in "
+                 << PrettyDuration(NanoTime() - start_ns);
+  return true;
+}
+
+bool JitCompiler::VerifyMethod(Thread* self, mirror::ArtMethod* method) {
+  StackHandleScope<3> hs(self);
+  Handle<mirror::ArtMethod> h_method(hs.NewHandle(method));
+  Handle<mirror::DexCache> dex_cache(hs.NewHandle(method->GetDeclaringClass()->GetDexCache()));
+  Handle<mirror::ClassLoader> class_loader(
+      hs.NewHandle(method->GetDeclaringClass()->GetClassLoader()));
+  MethodHelper mh(h_method.Get());
+  const DexFile* dex_file = &mh.GetDexFile();
+  const DexFile::ClassDef* class_def = &mh.GetClassDef();
+  const DexFile::CodeItem* code_item = dex_file->GetCodeItem(h_method->GetCodeItemOffset());
+  // The classes the method refers to were loaded when it was interpreted, if it got that far.
+  verifier::MethodVerifier verifier(dex_file, &dex_cache, &class_loader, class_def, code_item,
+                                    h_method->GetDexMethodIndex(), h_method.Get(),
+                                    h_method->GetAccessFlags(), false, true);
+  if (!verifier.Verify() || verifier.HasFailures()) {
+    return false;
+  }
+  if (!verification_results_->ProcessVerifiedMethod(&verifier)) {
+    return false;
+  }
+  method_inliner_map_->GetMethodInliner(dex_file)->AnalyseMethodCode(&verifier);
+  return true;
+}
+
+bool JitCompiler::InstallCode(Thread* self, mirror::ArtMethod* method,
+                              const CompiledMethod& compiled_method) {
+  const std::vector<uint8_t>& code = *compiled_method.GetQuickCode();
+  const std::vector<uint8_t>& gc_map = compiled_method.GetGcMap();
+  const std::vector<uint8_t>& mapping_table = compiled_method.GetMappingTable();
+  const std::vector<uint8_t>& vmap_table = compiled_method.GetVmapTable();
+  // Laid out as in an oat file, the tables then the method header right before the code.
+  const size_t mapping_table_begin = gc_map.size();
+  const size_t vmap_table_begin = mapping_table_begin + mapping_table.size();
+  const size_t code_offset = compiled_method.AlignCode(
+      vmap_table_begin + vmap_table.size() + sizeof(OatQuickMethodHeader));
+  OatQuickMethodHeader method_header(
+      mapping_table.empty() ? 0u : code_offset - mapping_table_begin,
+      vmap_table.empty() ? 0u : code_offset - vmap_table_begin,
+      compiled_method.GetFrameSizeInBytes(), compiled_method.GetCoreSpillMask(),
+      compiled_method.GetFpSpillMask(), code.size());
+  std::vector<uint8_t> data;
+  data.reserve(code_offset + code.size());
+  data.insert(data.end(), gc_map.begin(), gc_map.end());
+  data.insert(data.end(), mapping_table.begin(), mapping_table.end());
+  data.insert(data.end(), vmap_table.begin(), vmap_table.end());
+  data.resize(code_offset - sizeof(method_header), 0u);
+  const uint8_t* header_begin = reinterpret_cast<const uint8_t*>(&method_header);
+  data.insert(data.end(), header_begin, header_begin + sizeof(method_header));
+  data.insert(data.end(), code.begin(), code.end());
+  DCHECK_EQ(data.size(), code_offset + code.size());
+
+  JitCodeCache* code_cache = Runtime::Current()->GetJit()->GetCodeCache();
+  uint8_t* base = code_cache->CommitData(self, data);
+  if (base == nullptr) {
+    VLOG(compiler) << "JIT code cache full, not compiling " << PrettyMethod(method);
+    return false;
+  }
+  const void* entry_point =
+      CompiledMethod::CodePointer(base + code_offset, compiled_method.GetInstructionSet());
+  // Stack walks of the compiled code need the GC map as soon as the code can run.
+  method->SetNativeGcMap(gc_map.empty() ? nullptr : base);
+  code_cache->SaveCompiledCode(self, method, entry_point);
+  PerfMap* perf_map = Runtime::Current()->GetPerfMap();
+  if (perf_map != nullptr) {
+    perf_map->AddCode(entry_point, code.size(), PrettyMethod(method));
+  }
+  // Until its class is initialized, the class initializer is entered by on-stack replacement
+  // only; its entry points stay with the class initialization check.
+  if (method->GetDeclaringClass()->IsInitialized()) {
+    Runtime::Current()->GetInstrumentation()->UpdateMethodsCode(method, entry_point,
+                                                                GetPortableToQuickBridge(), false);
+    method->SetEntryPointFromInterpreter(artInterpreterToCompiledCodeBridge);
+  }
+  return true;
+}
+
+}  // namespace jit
+}  // namespace art
+
+extern "C" void* jit_load() {
+  return art::jit::JitCompiler::Create();
+}
+
+extern "C" void jit_unload(void* handle) {
+  delete reinterpret_cast<art::jit::JitCompiler*>(handle);
+}
+
+extern "C" bool jit_compile_method(void* handle, jobject method, art::Thread* self) {
+  return reinterpret_cast<art::jit::JitCompiler*>(handle)->CompileMethod(self, method);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_JIT_JIT_COMPILER_H_
+#define ART_COMPILER_JIT_JIT_COMPILER_H_
+
+#include <jni.h>
+
+#include <memory>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "base/timing_logger.h"
+#include "compiled_method.h"
+#include "dex/quick/dex_file_to_method_inliner_map.h"
+#include "dex/verification_results.h"
+#include "driver/compiler_driver.h"
+#include "driver/compiler_options.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+}  // namespace mirror
+class Thread;
+
+namespace jit {
+
+// The compiler side of the runtime's JIT, created by the runtime through the jit_load entry
+// point of the compiler library. Compiles single methods of loaded classes with the Quick
+// compiler and installs their code from the JIT code cache.
+class JitCompiler {
+ public:
+  static JitCompiler* Create();
+  ~JitCompiler();
+
+  // Compiles `method` and switches its entry points to the code. Called in the native state.
+  // Returns false if the method can't or shouldn't be compiled.
+  bool CompileMethod(Thread* self, jobject method) LOCKS_EXCLUDED(Locks::mutator_lock_);
+
+ private:
+  JitCompiler();
+
+  // Verifies `method` again to record the verification results the compiler needs. Returns
+  // false if the method has any verification failure.
+  bool VerifyMethod(Thread* self, mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Copies the code and tables of `compiled_method` to the code cache and makes them the code
+  // of `method`.
+  bool InstallCode(Thread* self, mirror::ArtMethod* method, const CompiledMethod& compiled_method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  std::unique_ptr<CompilerOptions> compiler_options_;
+  std::unique_ptr<VerificationResults> verification_results_;
+  std::unique_ptr<DexFileToMethodInlinerMap> method_inliner_map_;
+  std::unique_ptr<CumulativeLogger> cumulative_logger_;
+  std::unique_ptr<CompilerDriver> compiler_driver_;
+
+  DISALLOW_COPY_AND_ASSIGN(JitCompiler);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_COMPILER_JIT_JIT_COMPILER_H_
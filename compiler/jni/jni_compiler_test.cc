@@ -1496,4 +1496,26 @@ TEST_F(JniCompilerTest, StackArgsMixed) {
                              f7, i8, f8, i9, f9, i10, f10);
 }
 
+int gJava_MyClassNatives_fastSbar_calls = 0;
+jint Java_MyClassNatives_fastSbar(JNIEnv* env, jclass klass, jint count) {
+  // Fast native methods are called without leaving the runnable state.
+  EXPECT_EQ(kRunnable, Thread::Current()->GetState());
+  Locks::mutator_lock_->AssertSharedHeld(Thread::Current());
+  EXPECT_EQ(Thread::Current()->GetJniEnv(), env);
+  EXPECT_TRUE(klass != NULL);
+  gJava_MyClassNatives_fastSbar_calls++;
+  return count + 1;
+}
+
+TEST_F(JniCompilerTest, FastNativeAnnotation) {
+  TEST_DISABLED_FOR_PORTABLE();
+  SetUpForTest(true, "fastSbar", "(I)I",
+               reinterpret_cast<void*>(&Java_MyClassNatives_fastSbar));
+
+  EXPECT_EQ(0, gJava_MyClassNatives_fastSbar_calls);
+  jint result = env_->CallStaticIntMethod(jklass_, jmethod_, 42);
+  EXPECT_EQ(43, result);
+  EXPECT_EQ(1, gJava_MyClassNatives_fastSbar_calls);
+}
+
 }  // namespace art
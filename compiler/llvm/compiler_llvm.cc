@@ -83,6 +83,7 @@ void InitializeLLVM() {
 
   llvm::initializeCore(registry);
   llvm::initializeScalarOpts(registry);
+  llvm::initializeVectorization(registry);
   llvm::initializeIPO(registry);
   llvm::initializeAnalysis(registry);
   llvm::initializeIPA(registry);
@@ -276,6 +276,13 @@ bool LlvmCompilationUnit::MaterializeToRawOStream(::llvm::raw_ostream& out_strea
   // pm_builder.Inliner = ::llvm::createPartialInliningPass();
   pm_builder.OptLevel = 3;
   pm_builder.DisableUnitAtATime = 1;
+  if (driver_->GetCompilerOptions().GetPortableVectorize()) {
+    // The vectorizers need the cost model of the target to find profitable vector widths.
+    target_machine->addAnalysisPasses(pm);
+    target_machine->addAnalysisPasses(fpm);
+    pm_builder.LoopVectorize = true;
+    pm_builder.SLPVectorize = true;
+  }
   pm_builder.populateFunctionPassManager(fpm);
   pm_builder.populateModulePassManager(pm);
   pm.add(::llvm::createStripDeadPrototypesPass());
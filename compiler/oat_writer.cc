@@ -23,7 +23,9 @@
 #include "base/unix_file/fd_file.h"
 #include "class_linker.h"
 #include "dex_file-inl.h"
+#include "dex_layout.h"
 #include "dex/verification_results.h"
+#include "driver/compiler_options.h"
 #include "gc/space/space.h"
 #include "mirror/art_method-inl.h"
 #include "mirror/array.h"
@@ -34,6 +36,7 @@
 #include "safe_map.h"
 #include "scoped_thread_state_change.h"
 #include "handle_scope-inl.h"
+#include "thread_pool.h"
 #include "verifier/method_verifier.h"
 
 namespace art {
@@ -53,6 +56,7 @@ OatWriter::OatWriter(const std::vector<const DexFile*>& dex_files,
                      const CompilerDriver* compiler,
                      TimingLogger* timings)
   : compiler_driver_(compiler),
+    first_layout_tier_(compiler->ProfilePresent() ? kLayoutTierHot : kLayoutTierCold),
     dex_files_(&dex_files),
     image_file_location_oat_checksum_(image_file_location_oat_checksum),
     image_file_location_oat_begin_(image_file_location_oat_begin),
@@ -63,6 +67,8 @@ OatWriter::OatWriter(const std::vector<const DexFile*>& dex_files,
     size_oat_header_(0),
     size_oat_header_image_file_location_(0),
     size_dex_file_(0),
+    size_lookup_table_alignment_(0),
+    size_lookup_table_(0),
     size_interpreter_to_interpreter_bridge_(0),
     size_interpreter_to_compiled_code_bridge_(0),
     size_jni_dlsym_lookup_(0),
@@ -77,6 +83,7 @@ OatWriter::OatWriter(const std::vector<const DexFile*>& dex_files,
     size_method_header_(0),
     size_code_(0),
     size_code_alignment_(0),
+    size_layout_tier_alignment_(0),
     size_mapping_table_(0),
     size_vmap_table_(0),
     size_gc_map_(0),
@@ -84,6 +91,7 @@ OatWriter::OatWriter(const std::vector<const DexFile*>& dex_files,
     size_oat_dex_file_location_data_(0),
     size_oat_dex_file_location_checksum_(0),
     size_oat_dex_file_offset_(0),
+    size_oat_dex_file_lookup_table_offset_(0),
     size_oat_dex_file_methods_offsets_(0),
     size_oat_class_type_(0),
     size_oat_class_status_(0),
@@ -102,6 +110,10 @@ OatWriter::OatWriter(const std::vector<const DexFile*>& dex_files,
     TimingLogger::ScopedSplit split("InitDexFiles", timings);
     offset = InitDexFiles(offset);
   }
+  {
+    TimingLogger::ScopedSplit split("InitLookupTables", timings);
+    offset = InitLookupTables(offset);
+  }
   {
     TimingLogger::ScopedSplit split("InitOatClasses", timings);
     offset = InitOatClasses(offset);
@@ -242,7 +254,16 @@ class OatWriter::OatDexMethodVisitor : public DexMethodVisitor {
   OatDexMethodVisitor(OatWriter* writer, size_t offset)
     : DexMethodVisitor(writer, offset),
       oat_class_index_(0u),
-      method_offsets_index_(0u) {
+      method_offsets_index_(0u),
+      layout_tier_(kLayoutTierCount) {
+  }
+
+  // Starts a pass over the methods of `tier` at `offset`. The visitor keeps its
+  // deduplication state from the passes over the previous tiers.
+  void StartLayoutTier(LayoutTier tier, size_t offset) {
+    oat_class_index_ = 0u;
+    layout_tier_ = tier;
+    offset_ = offset;
   }
 
   bool StartClass(const DexFile* dex_file, size_t class_def_index) {
@@ -258,14 +279,28 @@ class OatWriter::OatDexMethodVisitor : public DexMethodVisitor {
   }
 
  protected:
+  // Whether the method is in another tier than the one being laid out, in which
+  // case it is only stepped over.
+  bool SkipMethod(OatClass* oat_class, size_t class_def_method_index) {
+    if (oat_class->GetLayoutTier(class_def_method_index) == layout_tier_) {
+      return false;
+    }
+    if (oat_class->GetCompiledMethod(class_def_method_index) != nullptr) {
+      ++method_offsets_index_;
+    }
+    return true;
+  }
+
   size_t oat_class_index_;
   size_t method_offsets_index_;
+  LayoutTier layout_tier_;
 };
 
 class OatWriter::InitOatClassesMethodVisitor : public DexMethodVisitor {
  public:
-  InitOatClassesMethodVisitor(OatWriter* writer, size_t offset)
+  InitOatClassesMethodVisitor(OatWriter* writer, size_t offset, std::vector<OatClass*>* oat_classes)
     : DexMethodVisitor(writer, offset),
+      oat_classes_(oat_classes),
       compiled_methods_(),
       num_non_null_compiled_methods_(0u) {
     compiled_methods_.reserve(256u);
@@ -274,6 +309,7 @@ class OatWriter::InitOatClassesMethodVisitor : public DexMethodVisitor {
   bool StartClass(const DexFile* dex_file, size_t class_def_index) {
     DexMethodVisitor::StartClass(dex_file, class_def_index);
     compiled_methods_.clear();
+    layout_tiers_.clear();
     num_non_null_compiled_methods_ = 0u;
     return true;
   }
@@ -289,6 +325,9 @@ class OatWriter::InitOatClassesMethodVisitor : public DexMethodVisitor {
     compiled_methods_.push_back(compiled_method);
     if (compiled_method != nullptr) {
         ++num_non_null_compiled_methods_;
+        layout_tiers_.push_back(writer_->GetLayoutTier(*dex_file_, method_idx));
+    } else {
+        layout_tiers_.push_back(kLayoutTierCold);
     }
     return true;
   }
@@ -305,18 +344,59 @@ class OatWriter::InitOatClassesMethodVisitor : public DexMethodVisitor {
       status = mirror::Class::kStatusNotReady;
     }
 
-    OatClass* oat_class = new OatClass(offset_, compiled_methods_,
+    OatClass* oat_class = new OatClass(offset_, compiled_methods_, layout_tiers_,
                                        num_non_null_compiled_methods_, status);
-    writer_->oat_classes_.push_back(oat_class);
+    oat_classes_->push_back(oat_class);
     offset_ += oat_class->SizeOf();
     return DexMethodVisitor::EndClass();
   }
 
  private:
+  std::vector<OatClass*>* const oat_classes_;
   std::vector<CompiledMethod*> compiled_methods_;
+  std::vector<LayoutTier> layout_tiers_;
   size_t num_non_null_compiled_methods_;
 };
 
+// Creates the OatClasses of a range of the class defs of a dex file, at offsets from the start of
+// the range. Looking up the compiled methods and classes only reads the compiler driver, so the
+// ranges are independent; InitOatClasses() concatenates them in order.
+class OatWriter::InitOatClassesTask : public Task {
+ public:
+  InitOatClassesTask(OatWriter* writer, const DexFile* dex_file, size_t class_def_begin,
+                     size_t class_def_end)
+    : writer_(writer),
+      dex_file_(dex_file),
+      class_def_begin_(class_def_begin),
+      class_def_end_(class_def_end),
+      size_(0u) {
+  }
+
+  virtual void Run(Thread* self) {
+    InitOatClassesMethodVisitor visitor(writer_, 0u, &oat_classes_);
+    bool success =
+        writer_->VisitDexFileMethods(&visitor, dex_file_, class_def_begin_, class_def_end_);
+    CHECK(success);
+    size_ = visitor.GetOffset();
+  }
+
+  const std::vector<OatClass*>& GetOatClasses() const {
+    return oat_classes_;
+  }
+
+  size_t GetSize() const {
+    return size_;
+  }
+
+ private:
+  OatWriter* const writer_;
+  const DexFile* const dex_file_;
+  const size_t class_def_begin_;
+  const size_t class_def_end_;
+  std::vector<OatClass*> oat_classes_;
+  size_t size_;
+};
+
 class OatWriter::InitCodeMethodVisitor : public OatDexMethodVisitor {
  public:
   InitCodeMethodVisitor(OatWriter* writer, size_t offset)
@@ -326,6 +406,9 @@ class OatWriter::InitCodeMethodVisitor : public OatDexMethodVisitor {
   bool VisitMethod(size_t class_def_method_index, const ClassDataItemIterator& it)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     OatClass* oat_class = writer_->oat_classes_[oat_class_index_];
+    if (SkipMethod(oat_class, class_def_method_index)) {
+      return true;
+    }
     CompiledMethod* compiled_method = oat_class->GetCompiledMethod(class_def_method_index);
 
     if (compiled_method != nullptr) {
@@ -350,6 +433,17 @@ class OatWriter::InitCodeMethodVisitor : public OatDexMethodVisitor {
         uint32_t thumb_offset = compiled_method->CodeDelta();
         quick_code_offset = offset_ + sizeof(OatQuickMethodHeader) + thumb_offset;
 
+        // Deduplicate code arrays.
+        auto code_iter = dedupe_map_.find(compiled_method);
+        if (code_iter != dedupe_map_.end()) {
+          quick_code_offset = code_iter->second;
+        } else {
+          dedupe_map_.Put(compiled_method, quick_code_offset);
+        }
+
+        // The debug information refers to the code that is kept when duplicates are dropped.
+        uint32_t code_start = quick_code_offset - writer_->oat_header_->GetExecutableOffset();
+        bool has_fde = false;
         std::vector<uint8_t>* cfi_info = writer_->compiler_driver_->GetCallFrameInformation();
         if (cfi_info != nullptr) {
           // Copy in the FDE, if present
@@ -360,23 +454,19 @@ class OatWriter::InitCodeMethodVisitor : public OatDexMethodVisitor {
             cfi_info->insert(cfi_info->end(), fde->begin(), fde->end());
 
             // Set the 'initial_location' field to address the start of the method.
-            uint32_t new_value = quick_code_offset - writer_->oat_header_->GetExecutableOffset();
             uint32_t offset_to_update = cur_offset + 2*sizeof(uint32_t);
-            (*cfi_info)[offset_to_update+0] = new_value;
-            (*cfi_info)[offset_to_update+1] = new_value >> 8;
-            (*cfi_info)[offset_to_update+2] = new_value >> 16;
-            (*cfi_info)[offset_to_update+3] = new_value >> 24;
-            std::string name = PrettyMethod(it.GetMemberIndex(), *dex_file_, false);
-            writer_->method_info_.push_back(DebugInfo(name, new_value, new_value + code_size));
+            (*cfi_info)[offset_to_update+0] = code_start;
+            (*cfi_info)[offset_to_update+1] = code_start >> 8;
+            (*cfi_info)[offset_to_update+2] = code_start >> 16;
+            (*cfi_info)[offset_to_update+3] = code_start >> 24;
+            has_fde = true;
           }
         }
-
-        // Deduplicate code arrays.
-        auto code_iter = dedupe_map_.find(compiled_method);
-        if (code_iter != dedupe_map_.end()) {
-          quick_code_offset = code_iter->second;
-        } else {
-          dedupe_map_.Put(compiled_method, quick_code_offset);
+        // Mini debug information names every method, including those the backend has no
+        // call frame information for, so that native stacks can at least be symbolized.
+        if (has_fde || writer_->compiler_driver_->GetCompilerOptions().GetGenerateMiniDebugInfo()) {
+          std::string name = PrettyMethod(it.GetMemberIndex(), *dex_file_, false);
+          writer_->method_info_.push_back(DebugInfo(name, code_start, code_start + code_size));
         }
 
         // Update quick method header.
@@ -412,7 +502,8 @@ class OatWriter::InitCodeMethodVisitor : public OatDexMethodVisitor {
       }
 
       if (kIsDebugBuild) {
-        // We expect GC maps except when the class hasn't been verified or the method is native.
+        // We expect GC maps except when the class hasn't been verified, the method is native,
+        // or its references are described by stack maps.
         const CompilerDriver* compiler_driver = writer_->compiler_driver_;
         ClassReference class_ref(dex_file_, class_def_index_);
         CompiledClass* compiled_class = compiler_driver->GetCompiledClass(class_ref);
@@ -427,7 +518,10 @@ class OatWriter::InitCodeMethodVisitor : public OatDexMethodVisitor {
         const std::vector<uint8_t>& gc_map = compiled_method->GetGcMap();
         size_t gc_map_size = gc_map.size() * sizeof(gc_map[0]);
         bool is_native = (it.GetMemberAccessFlags() & kAccNative) != 0;
-        CHECK(gc_map_size != 0 || is_native || status < mirror::Class::kStatusVerified)
+        bool has_stack_maps = compiled_method->GetMappingTable().empty() &&
+            !compiled_method->GetVmapTable().empty();
+        CHECK(gc_map_size != 0 || is_native || has_stack_maps ||
+              status < mirror::Class::kStatusVerified)
             << &gc_map << " " << gc_map_size << " " << (is_native ? "true" : "false") << " "
             << (status < mirror::Class::kStatusVerified) << " " << status << " "
             << PrettyMethod(it.GetMemberIndex(), *dex_file_);
@@ -458,6 +552,9 @@ class OatWriter::InitMapMethodVisitor : public OatDexMethodVisitor {
   bool VisitMethod(size_t class_def_method_index, const ClassDataItemIterator& it)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     OatClass* oat_class = writer_->oat_classes_[oat_class_index_];
+    if (SkipMethod(oat_class, class_def_method_index)) {
+      return true;
+    }
     CompiledMethod* compiled_method = oat_class->GetCompiledMethod(class_def_method_index);
 
     if (compiled_method != nullptr) {
@@ -536,6 +633,9 @@ class OatWriter::WriteCodeMethodVisitor : public OatDexMethodVisitor {
 
   bool VisitMethod(size_t class_def_method_index, const ClassDataItemIterator& it) {
     OatClass* oat_class = writer_->oat_classes_[oat_class_index_];
+    if (SkipMethod(oat_class, class_def_method_index)) {
+      return true;
+    }
     const CompiledMethod* compiled_method = oat_class->GetCompiledMethod(class_def_method_index);
 
     if (compiled_method != NULL) {  // ie. not an abstract method
@@ -616,6 +716,9 @@ class OatWriter::WriteMapMethodVisitor : public OatDexMethodVisitor {
 
   bool VisitMethod(size_t class_def_method_index, const ClassDataItemIterator& it) {
     OatClass* oat_class = writer_->oat_classes_[oat_class_index_];
+    if (SkipMethod(oat_class, class_def_method_index)) {
+      return true;
+    }
     const CompiledMethod* compiled_method = oat_class->GetCompiledMethod(class_def_method_index);
 
     if (compiled_method != NULL) {  // ie. not an abstract method
@@ -657,41 +760,49 @@ class OatWriter::WriteMapMethodVisitor : public OatDexMethodVisitor {
 // Visit all methods from all classes in all dex files with the specified visitor.
 bool OatWriter::VisitDexMethods(DexMethodVisitor* visitor) {
   for (const DexFile* dex_file : *dex_files_) {
-    const size_t class_def_count = dex_file->NumClassDefs();
-    for (size_t class_def_index = 0; class_def_index != class_def_count; ++class_def_index) {
-      if (UNLIKELY(!visitor->StartClass(dex_file, class_def_index))) {
-        return false;
+    if (UNLIKELY(!VisitDexFileMethods(visitor, dex_file, 0u, dex_file->NumClassDefs()))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool OatWriter::VisitDexFileMethods(DexMethodVisitor* visitor, const DexFile* dex_file,
+                                    size_t class_def_begin, size_t class_def_end) {
+  for (size_t class_def_index = class_def_begin; class_def_index != class_def_end;
+       ++class_def_index) {
+    if (UNLIKELY(!visitor->StartClass(dex_file, class_def_index))) {
+      return false;
+    }
+    const DexFile::ClassDef& class_def = dex_file->GetClassDef(class_def_index);
+    const byte* class_data = dex_file->GetClassData(class_def);
+    if (class_data != NULL) {  // ie not an empty class, such as a marker interface
+      ClassDataItemIterator it(*dex_file, class_data);
+      while (it.HasNextStaticField()) {
+        it.Next();
       }
-      const DexFile::ClassDef& class_def = dex_file->GetClassDef(class_def_index);
-      const byte* class_data = dex_file->GetClassData(class_def);
-      if (class_data != NULL) {  // ie not an empty class, such as a marker interface
-        ClassDataItemIterator it(*dex_file, class_data);
-        while (it.HasNextStaticField()) {
-          it.Next();
-        }
-        while (it.HasNextInstanceField()) {
-          it.Next();
-        }
-        size_t class_def_method_index = 0u;
-        while (it.HasNextDirectMethod()) {
-          if (!visitor->VisitMethod(class_def_method_index, it)) {
-            return false;
-          }
-          ++class_def_method_index;
-          it.Next();
-        }
-        while (it.HasNextVirtualMethod()) {
-          if (UNLIKELY(!visitor->VisitMethod(class_def_method_index, it))) {
-            return false;
-          }
-          ++class_def_method_index;
-          it.Next();
+      while (it.HasNextInstanceField()) {
+        it.Next();
+      }
+      size_t class_def_method_index = 0u;
+      while (it.HasNextDirectMethod()) {
+        if (!visitor->VisitMethod(class_def_method_index, it)) {
+          return false;
         }
+        ++class_def_method_index;
+        it.Next();
       }
-      if (UNLIKELY(!visitor->EndClass())) {
-        return false;
+      while (it.HasNextVirtualMethod()) {
+        if (UNLIKELY(!visitor->VisitMethod(class_def_method_index, it))) {
+          return false;
+        }
+        ++class_def_method_index;
+        it.Next();
       }
     }
+    if (UNLIKELY(!visitor->EndClass())) {
+      return false;
+    }
   }
   return true;
 }
@@ -700,6 +811,7 @@ size_t OatWriter::InitOatHeader() {
   // create the OatHeader
   oat_header_ = new OatHeader(compiler_driver_->GetInstructionSet(),
                               compiler_driver_->GetInstructionSetFeatures(),
+                              compiler_driver_->GetCompilerOptionsChecksum(),
                               dex_files_,
                               image_file_location_oat_checksum_,
                               image_file_location_oat_begin_,
@@ -734,16 +846,76 @@ size_t OatWriter::InitDexFiles(size_t offset) {
 
     const DexFile* dex_file = (*dex_files_)[i];
     offset += dex_file->GetHeader().file_size_;
+
+    if (LayoutDexFiles()) {
+      std::vector<uint32_t> method_tiers(dex_file->NumMethodIds());
+      for (uint32_t method_idx = 0; method_idx != method_tiers.size(); ++method_idx) {
+        method_tiers[method_idx] = GetLayoutTier(*dex_file, method_idx);
+      }
+      if (!DexLayout::Layout(*dex_file, method_tiers, &oat_dex_files_[i]->laid_out_dex_file_)) {
+        LOG(WARNING) << "Could not lay out " << dex_file->GetLocation() << " for the profile";
+        oat_dex_files_[i]->laid_out_dex_file_.clear();
+      }
+    }
+  }
+  return offset;
+}
+
+size_t OatWriter::InitLookupTables(size_t offset) {
+  for (size_t i = 0; i != dex_files_->size(); ++i) {
+    const DexFile* dex_file = (*dex_files_)[i];
+    if (!TypeLookupTable::SupportedSize(dex_file->NumClassDefs())) {
+      continue;
+    }
+    // The table entries are 32-bit aligned.
+    size_t original_offset = offset;
+    offset = RoundUp(offset, 4);
+    size_lookup_table_alignment_ += offset - original_offset;
+
+    OatDexFile* oat_dex_file = oat_dex_files_[i];
+    oat_dex_file->lookup_table_offset_ = offset;
+    // The table holds the offsets of the string data, build it from the copy which is written.
+    std::unique_ptr<const DexFile> laid_out_dex_file;
+    if (!oat_dex_file->laid_out_dex_file_.empty()) {
+      std::string error_msg;
+      laid_out_dex_file.reset(DexFile::Open(&oat_dex_file->laid_out_dex_file_[0],
+                                            oat_dex_file->laid_out_dex_file_.size(),
+                                            dex_file->GetLocation(),
+                                            dex_file->GetLocationChecksum(), nullptr, &error_msg));
+      CHECK(laid_out_dex_file.get() != nullptr) << error_msg;
+      dex_file = laid_out_dex_file.get();
+    }
+    oat_dex_file->lookup_table_.reset(TypeLookupTable::Create(*dex_file));
+    offset += oat_dex_file->lookup_table_->RawDataLength();
   }
   return offset;
 }
 
 size_t OatWriter::InitOatClasses(size_t offset) {
-  // calculate the offsets within OatDexFiles to OatClasses
-  InitOatClassesMethodVisitor visitor(this, offset);
-  bool success = VisitDexMethods(&visitor);
-  CHECK(success);
-  offset = visitor.GetOffset();
+  // calculate the offsets within OatDexFiles to OatClasses, creating the OatClasses of ranges of
+  // class defs in parallel
+  static constexpr size_t kClassDefsPerTask = 256u;
+  Thread* self = Thread::Current();
+  ThreadPool thread_pool("Oat writer thread pool", compiler_driver_->GetThreadCount() - 1);
+  std::vector<std::unique_ptr<InitOatClassesTask>> tasks;
+  for (const DexFile* dex_file : *dex_files_) {
+    const size_t class_def_count = dex_file->NumClassDefs();
+    for (size_t begin = 0; begin < class_def_count; begin += kClassDefsPerTask) {
+      size_t end = std::min(begin + kClassDefsPerTask, class_def_count);
+      tasks.emplace_back(new InitOatClassesTask(this, dex_file, begin, end));
+      thread_pool.AddTask(self, tasks.back().get());
+    }
+  }
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, true, true);
+  thread_pool.StopWorkers(self);
+  for (const std::unique_ptr<InitOatClassesTask>& task : tasks) {
+    for (OatClass* oat_class : task->GetOatClasses()) {
+      oat_class->offset_ += offset;
+      oat_classes_.push_back(oat_class);
+    }
+    offset += task->GetSize();
+  }
 
   // Update oat_dex_files_.
   auto oat_class_it = oat_classes_.begin();
@@ -760,20 +932,55 @@ size_t OatWriter::InitOatClasses(size_t offset) {
   return offset;
 }
 
-size_t OatWriter::InitOatMaps(size_t offset) {
-  #define VISIT(VisitorType)                          \
-    do {                                              \
-      VisitorType visitor(this, offset);              \
-      bool success = VisitDexMethods(&visitor);       \
-      DCHECK(success);                                \
-      offset = visitor.GetOffset();                   \
-    } while (false)
+OatWriter::LayoutTier OatWriter::GetLayoutTier(const DexFile& dex_file, uint32_t method_idx) const {
+  if (!compiler_driver_->ProfilePresent()) {
+    return kLayoutTierCold;
+  }
+  std::string method_name = PrettyMethod(method_idx, dex_file);
+  // The callers that make the hot calls are placed with the hot methods they call.
+  if (compiler_driver_->IsHotMethod(method_name) || compiler_driver_->HasHotCallSite(method_name)) {
+    return kLayoutTierHot;
+  }
+  const ProfileMap& profile_map = compiler_driver_->GetProfileMap();
+  return (profile_map.find(method_name) != profile_map.end()) ? kLayoutTierWarm : kLayoutTierCold;
+}
 
-  VISIT(InitMapMethodVisitor<GcMapDataAccess>);
-  VISIT(InitMapMethodVisitor<MappingTableDataAccess>);
-  VISIT(InitMapMethodVisitor<VmapTableDataAccess>);
+bool OatWriter::LayoutDexFiles() const {
+  // The methods in an image hold the offsets of their code items in the dex files as compiled.
+  return compiler_driver_->GetCompilerOptions().GetLayoutDexFiles() &&
+      compiler_driver_->ProfilePresent() && !compiler_driver_->IsImage();
+}
 
-  #undef VISIT
+size_t OatWriter::AlignLayoutTier(LayoutTier tier, size_t tiers_offset, size_t offset) const {
+  if (tier == first_layout_tier_ || offset == tiers_offset) {
+    return offset;
+  }
+  return RoundUp(offset, kPageSize);
+}
+
+size_t OatWriter::InitOatMaps(size_t offset) {
+  // The maps of a tier are kept together, and each kind of map is deduplicated across tiers.
+  InitMapMethodVisitor<GcMapDataAccess> gc_map_visitor(this, offset);
+  InitMapMethodVisitor<MappingTableDataAccess> mapping_table_visitor(this, offset);
+  InitMapMethodVisitor<VmapTableDataAccess> vmap_table_visitor(this, offset);
+  OatDexMethodVisitor* const visitors[] = {
+      &gc_map_visitor, &mapping_table_visitor, &vmap_table_visitor
+  };
+
+  const size_t maps_offset = offset;
+  for (size_t i = first_layout_tier_; i != kLayoutTierCount; ++i) {
+    LayoutTier tier = static_cast<LayoutTier>(i);
+    offset = AlignLayoutTier(tier, maps_offset, offset);
+    if (tier == kLayoutTierCold && tier != first_layout_tier_) {
+      oat_header_->SetStartupMaps(maps_offset, offset - maps_offset);
+    }
+    for (OatDexMethodVisitor* visitor : visitors) {
+      visitor->StartLayoutTier(tier, offset);
+      bool success = VisitDexMethods(visitor);
+      DCHECK(success);
+      offset = visitor->GetOffset();
+    }
+  }
 
   return offset;
 }
@@ -787,11 +994,18 @@ size_t OatWriter::InitOatCode(size_t offset) {
   size_executable_offset_alignment_ = offset - old_offset;
   if (compiler_driver_->IsImage()) {
     InstructionSet instruction_set = compiler_driver_->GetInstructionSet();
+    // Mini debug information names the trampolines too, as perf finds no other symbol for them.
+    bool name_trampolines = compiler_driver_->GetCompilerOptions().GetGenerateMiniDebugInfo();
+    uint32_t executable_offset = oat_header_->GetExecutableOffset();
 
     #define DO_TRAMPOLINE(field, fn_name) \
       offset = CompiledCode::AlignCode(offset, instruction_set); \
       oat_header_->Set ## fn_name ## Offset(offset); \
       field.reset(compiler_driver_->Create ## fn_name()); \
+      if (name_trampolines) { \
+        method_info_.push_back(DebugInfo(#fn_name, offset - executable_offset, \
+                                         offset - executable_offset + field->size())); \
+      } \
       offset += field->size();
 
     DO_TRAMPOLINE(interpreter_to_interpreter_bridge_, InterpreterToInterpreterBridge);
@@ -822,20 +1036,27 @@ size_t OatWriter::InitOatCode(size_t offset) {
 }
 
 size_t OatWriter::InitOatCodeDexFiles(size_t offset) {
-  #define VISIT(VisitorType)                          \
-    do {                                              \
-      VisitorType visitor(this, offset);              \
-      bool success = VisitDexMethods(&visitor);       \
-      DCHECK(success);                                \
-      offset = visitor.GetOffset();                   \
-    } while (false)
-
-  VISIT(InitCodeMethodVisitor);
-  if (compiler_driver_->IsImage()) {
-    VISIT(InitImageMethodVisitor);
+  InitCodeMethodVisitor code_visitor(this, offset);
+  const size_t code_offset = offset;
+  for (size_t i = first_layout_tier_; i != kLayoutTierCount; ++i) {
+    LayoutTier tier = static_cast<LayoutTier>(i);
+    offset = AlignLayoutTier(tier, code_offset, offset);
+    if (tier == kLayoutTierCold && tier != first_layout_tier_) {
+      oat_header_->SetStartupCode(code_offset, offset - code_offset);
+    }
+    code_visitor.StartLayoutTier(tier, offset);
+    bool success = VisitDexMethods(&code_visitor);
+    DCHECK(success);
+    offset = code_visitor.GetOffset();
   }
 
-  #undef VISIT
+  if (compiler_driver_->IsImage()) {
+    // Visits all methods, whatever their tier.
+    InitImageMethodVisitor image_visitor(this, offset);
+    bool success = VisitDexMethods(&image_visitor);
+    DCHECK(success);
+    offset = image_visitor.GetOffset();
+  }
 
   return offset;
 }
@@ -890,6 +1111,8 @@ bool OatWriter::Write(OutputStream* out) {
     DO_STAT(size_oat_header_);
     DO_STAT(size_oat_header_image_file_location_);
     DO_STAT(size_dex_file_);
+    DO_STAT(size_lookup_table_alignment_);
+    DO_STAT(size_lookup_table_);
     DO_STAT(size_interpreter_to_interpreter_bridge_);
     DO_STAT(size_interpreter_to_compiled_code_bridge_);
     DO_STAT(size_jni_dlsym_lookup_);
@@ -904,6 +1127,7 @@ bool OatWriter::Write(OutputStream* out) {
     DO_STAT(size_method_header_);
     DO_STAT(size_code_);
     DO_STAT(size_code_alignment_);
+    DO_STAT(size_layout_tier_alignment_);
     DO_STAT(size_mapping_table_);
     DO_STAT(size_vmap_table_);
     DO_STAT(size_gc_map_);
@@ -911,6 +1135,7 @@ bool OatWriter::Write(OutputStream* out) {
     DO_STAT(size_oat_dex_file_location_data_);
     DO_STAT(size_oat_dex_file_location_checksum_);
     DO_STAT(size_oat_dex_file_offset_);
+    DO_STAT(size_oat_dex_file_lookup_table_offset_);
     DO_STAT(size_oat_dex_file_methods_offsets_);
     DO_STAT(size_oat_class_type_);
     DO_STAT(size_oat_class_status_);
@@ -946,13 +1171,38 @@ bool OatWriter::WriteTables(OutputStream* out, const size_t file_offset) {
       return false;
     }
     const DexFile* dex_file = (*dex_files_)[i];
-    if (!out->WriteFully(&dex_file->GetHeader(), dex_file->GetHeader().file_size_)) {
+    const std::vector<uint8_t>& laid_out_dex_file = oat_dex_files_[i]->laid_out_dex_file_;
+    const void* dex_file_data = laid_out_dex_file.empty()
+        ? static_cast<const void*>(&dex_file->GetHeader())
+        : static_cast<const void*>(&laid_out_dex_file[0]);
+    if (!out->WriteFully(dex_file_data, dex_file->GetHeader().file_size_)) {
       PLOG(ERROR) << "Failed to write dex file " << dex_file->GetLocation()
                   << " to " << out->GetLocation();
       return false;
     }
     size_dex_file_ += dex_file->GetHeader().file_size_;
   }
+  for (size_t i = 0; i != oat_dex_files_.size(); ++i) {
+    const OatDexFile* oat_dex_file = oat_dex_files_[i];
+    if (oat_dex_file->lookup_table_offset_ == 0u) {
+      continue;
+    }
+    uint32_t expected_offset = file_offset + oat_dex_file->lookup_table_offset_;
+    off_t actual_offset = out->Seek(expected_offset, kSeekSet);
+    if (static_cast<uint32_t>(actual_offset) != expected_offset) {
+      const DexFile* dex_file = (*dex_files_)[i];
+      PLOG(ERROR) << "Failed to seek to lookup table section. Actual: " << actual_offset
+                  << " Expected: " << expected_offset << " File: " << dex_file->GetLocation();
+      return false;
+    }
+    const TypeLookupTable& lookup_table = *oat_dex_file->lookup_table_;
+    if (!out->WriteFully(lookup_table.RawData(), lookup_table.RawDataLength())) {
+      PLOG(ERROR) << "Failed to write lookup table of " << (*dex_files_)[i]->GetLocation()
+                  << " to " << out->GetLocation();
+      return false;
+    }
+    size_lookup_table_ += lookup_table.RawDataLength();
+  }
   for (size_t i = 0; i != oat_classes_.size(); ++i) {
     if (!oat_classes_[i]->Write(this, out, file_offset)) {
       PLOG(ERROR) << "Failed to write oat methods information to " << out->GetLocation();
@@ -962,29 +1212,51 @@ bool OatWriter::WriteTables(OutputStream* out, const size_t file_offset) {
   return true;
 }
 
-size_t OatWriter::WriteMaps(OutputStream* out, const size_t file_offset, size_t relative_offset) {
-  #define VISIT(VisitorType)                                              \
-    do {                                                                  \
-      VisitorType visitor(this, out, file_offset, relative_offset);       \
-      if (UNLIKELY(!VisitDexMethods(&visitor))) {                         \
-        return 0;                                                         \
-      }                                                                   \
-      relative_offset = visitor.GetOffset();                              \
-    } while (false)
-
-  size_t gc_maps_offset = relative_offset;
-  VISIT(WriteMapMethodVisitor<GcMapDataAccess>);
-  size_gc_map_ = relative_offset - gc_maps_offset;
-
-  size_t mapping_tables_offset = relative_offset;
-  VISIT(WriteMapMethodVisitor<MappingTableDataAccess>);
-  size_mapping_table_ = relative_offset - mapping_tables_offset;
-
-  size_t vmap_tables_offset = relative_offset;
-  VISIT(WriteMapMethodVisitor<VmapTableDataAccess>);
-  size_vmap_table_ = relative_offset - vmap_tables_offset;
+bool OatWriter::WriteLayoutTierAlignment(OutputStream* out, const size_t file_offset,
+                                         LayoutTier tier, size_t tiers_offset,
+                                         size_t* relative_offset) {
+  size_t aligned_offset = AlignLayoutTier(tier, tiers_offset, *relative_offset);
+  size_t alignment_padding = aligned_offset - *relative_offset;
+  if (alignment_padding != 0u) {
+    off_t new_offset = out->Seek(alignment_padding, kSeekCurrent);
+    if (static_cast<size_t>(new_offset) != file_offset + aligned_offset) {
+      PLOG(ERROR) << "Failed to seek to layout tier " << static_cast<int>(tier)
+                  << ". Actual: " << new_offset << " Expected: " << file_offset + aligned_offset
+                  << " File: " << out->GetLocation();
+      return false;
+    }
+    size_layout_tier_alignment_ += alignment_padding;
+    *relative_offset = aligned_offset;
+  }
+  return true;
+}
 
-  #undef VISIT
+size_t OatWriter::WriteMaps(OutputStream* out, const size_t file_offset, size_t relative_offset) {
+  WriteMapMethodVisitor<GcMapDataAccess> gc_map_visitor(this, out, file_offset, relative_offset);
+  WriteMapMethodVisitor<MappingTableDataAccess> mapping_table_visitor(this, out, file_offset,
+                                                                      relative_offset);
+  WriteMapMethodVisitor<VmapTableDataAccess> vmap_table_visitor(this, out, file_offset,
+                                                                relative_offset);
+  OatDexMethodVisitor* const visitors[] = {
+      &gc_map_visitor, &mapping_table_visitor, &vmap_table_visitor
+  };
+  uint32_t* const sizes[] = { &size_gc_map_, &size_mapping_table_, &size_vmap_table_ };
+
+  const size_t maps_offset = relative_offset;
+  for (size_t i = first_layout_tier_; i != kLayoutTierCount; ++i) {
+    LayoutTier tier = static_cast<LayoutTier>(i);
+    if (!WriteLayoutTierAlignment(out, file_offset, tier, maps_offset, &relative_offset)) {
+      return 0;
+    }
+    for (size_t j = 0; j != arraysize(visitors); ++j) {
+      visitors[j]->StartLayoutTier(tier, relative_offset);
+      if (UNLIKELY(!VisitDexMethods(visitors[j]))) {
+        return 0;
+      }
+      *sizes[j] += visitors[j]->GetOffset() - relative_offset;
+      relative_offset = visitors[j]->GetOffset();
+    }
+  }
 
   return relative_offset;
 }
@@ -1036,18 +1308,19 @@ size_t OatWriter::WriteCode(OutputStream* out, const size_t file_offset, size_t
 size_t OatWriter::WriteCodeDexFiles(OutputStream* out,
                                     const size_t file_offset,
                                     size_t relative_offset) {
-  #define VISIT(VisitorType)                                              \
-    do {                                                                  \
-      VisitorType visitor(this, out, file_offset, relative_offset);       \
-      if (UNLIKELY(!VisitDexMethods(&visitor))) {                         \
-        return 0;                                                         \
-      }                                                                   \
-      relative_offset = visitor.GetOffset();                              \
-    } while (false)
-
-  VISIT(WriteCodeMethodVisitor);
-
-  #undef VISIT
+  WriteCodeMethodVisitor visitor(this, out, file_offset, relative_offset);
+  const size_t code_offset = relative_offset;
+  for (size_t i = first_layout_tier_; i != kLayoutTierCount; ++i) {
+    LayoutTier tier = static_cast<LayoutTier>(i);
+    if (!WriteLayoutTierAlignment(out, file_offset, tier, code_offset, &relative_offset)) {
+      return 0;
+    }
+    visitor.StartLayoutTier(tier, relative_offset);
+    if (UNLIKELY(!VisitDexMethods(&visitor))) {
+      return 0;
+    }
+    relative_offset = visitor.GetOffset();
+  }
 
   return relative_offset;
 }
@@ -1059,6 +1332,7 @@ OatWriter::OatDexFile::OatDexFile(size_t offset, const DexFile& dex_file) {
   dex_file_location_data_ = reinterpret_cast<const uint8_t*>(location.data());
   dex_file_location_checksum_ = dex_file.GetLocationChecksum();
   dex_file_offset_ = 0;
+  lookup_table_offset_ = 0;
   methods_offsets_.resize(dex_file.NumClassDefs());
 }
 
@@ -1067,6 +1341,7 @@ size_t OatWriter::OatDexFile::SizeOf() const {
           + dex_file_location_size_
           + sizeof(dex_file_location_checksum_)
           + sizeof(dex_file_offset_)
+          + sizeof(lookup_table_offset_)
           + (sizeof(methods_offsets_[0]) * methods_offsets_.size());
 }
 
@@ -1075,6 +1350,10 @@ void OatWriter::OatDexFile::UpdateChecksum(OatHeader* oat_header) const {
   oat_header->UpdateChecksum(dex_file_location_data_, dex_file_location_size_);
   oat_header->UpdateChecksum(&dex_file_location_checksum_, sizeof(dex_file_location_checksum_));
   oat_header->UpdateChecksum(&dex_file_offset_, sizeof(dex_file_offset_));
+  oat_header->UpdateChecksum(&lookup_table_offset_, sizeof(lookup_table_offset_));
+  if (lookup_table_.get() != nullptr) {
+    oat_header->UpdateChecksum(lookup_table_->RawData(), lookup_table_->RawDataLength());
+  }
   oat_header->UpdateChecksum(&methods_offsets_[0],
                             sizeof(methods_offsets_[0]) * methods_offsets_.size());
 }
@@ -1103,6 +1382,11 @@ bool OatWriter::OatDexFile::Write(OatWriter* oat_writer,
     return false;
   }
   oat_writer->size_oat_dex_file_offset_ += sizeof(dex_file_offset_);
+  if (!out->WriteFully(&lookup_table_offset_, sizeof(lookup_table_offset_))) {
+    PLOG(ERROR) << "Failed to write lookup table offset to " << out->GetLocation();
+    return false;
+  }
+  oat_writer->size_oat_dex_file_lookup_table_offset_ += sizeof(lookup_table_offset_);
   if (!out->WriteFully(&methods_offsets_[0],
                       sizeof(methods_offsets_[0]) * methods_offsets_.size())) {
     PLOG(ERROR) << "Failed to write methods offsets to " << out->GetLocation();
@@ -1115,9 +1399,11 @@ bool OatWriter::OatDexFile::Write(OatWriter* oat_writer,
 
 OatWriter::OatClass::OatClass(size_t offset,
                               const std::vector<CompiledMethod*>& compiled_methods,
+                              const std::vector<LayoutTier>& layout_tiers,
                               uint32_t num_non_null_compiled_methods,
                               mirror::Class::Status status)
-    : compiled_methods_(compiled_methods) {
+    : compiled_methods_(compiled_methods), layout_tiers_(layout_tiers) {
+  DCHECK_EQ(compiled_methods.size(), layout_tiers.size());
   uint32_t num_methods = compiled_methods.size();
   CHECK_LE(num_non_null_compiled_methods, num_methods);
 
@@ -26,6 +26,7 @@
 #include "oat.h"
 #include "mirror/class.h"
 #include "safe_map.h"
+#include "type_lookup_table.h"
 
 namespace art {
 
@@ -44,6 +45,11 @@ class OutputStream;
 // ...
 // Dex[D]
 //
+// TypeLookupTable[0] one TypeLookupTable for each DexFile with a supported number of class defs,
+// TypeLookupTable[1] from the class descriptors to the class def indexes.
+// ...
+// TypeLookupTable[D]
+//
 // OatClass[0]       one variable sized OatClass for each of C DexFile::ClassDefs
 // OatClass[1]       contains OatClass entries with class status, offsets to code, etc.
 // ...
@@ -74,6 +80,12 @@ class OutputStream;
 // OatMethodHeader
 // MethodCode
 //
+// With a profile, the maps and code are laid out by LayoutTier: all the maps and then all the
+// code of the hot methods come first, each tier after the first starting on a new page so that
+// launching the app faults in as few pages as possible. Without a profile, all methods are in
+// a single tier, in definition order. With CompilerOptions::GetLayoutDexFiles(), the copies of
+// the dex files are laid out by the same tiers, see DexLayout.
+//
 class OatWriter {
  public:
   OatWriter(const std::vector<const DexFile*>& dex_files,
@@ -116,6 +128,15 @@ class OatWriter {
   struct MappingTableDataAccess;
   struct VmapTableDataAccess;
 
+  // The layout tier of a compiled method, from its profile samples. Tiers are laid out in
+  // this order, the methods of each in their definition order.
+  enum LayoutTier : uint8_t {
+    kLayoutTierHot,     // Among the methods that take most of the profile samples.
+    kLayoutTierWarm,    // Run while profiling, such as at app launch.
+    kLayoutTierCold,    // Not in the profile, or there is no profile.
+    kLayoutTierCount
+  };
+
   // The function VisitDexMethods() below iterates through all the methods in all
   // the compiled dex files in order of their definitions. The method visitor
   // classes provide individual bits of processing for each of the passes we need to
@@ -124,6 +145,7 @@ class OatWriter {
   class DexMethodVisitor;
   class OatDexMethodVisitor;
   class InitOatClassesMethodVisitor;
+  class InitOatClassesTask;
   class InitCodeMethodVisitor;
   template <typename DataAccess>
   class InitMapMethodVisitor;
@@ -136,9 +158,23 @@ class OatWriter {
   // with a given DexMethodVisitor.
   bool VisitDexMethods(DexMethodVisitor* visitor);
 
+  // Visit the methods of the class defs [class_def_begin, class_def_end) of a dex file.
+  bool VisitDexFileMethods(DexMethodVisitor* visitor, const DexFile* dex_file,
+                           size_t class_def_begin, size_t class_def_end);
+
+  LayoutTier GetLayoutTier(const DexFile& dex_file, uint32_t method_idx) const;
+
+  // Whether the copies of the dex files are laid out by the tiers of their methods.
+  bool LayoutDexFiles() const;
+
+  // The offset at which `tier` starts, given that the previous tiers took from
+  // `tiers_offset` to `offset`.
+  size_t AlignLayoutTier(LayoutTier tier, size_t tiers_offset, size_t offset) const;
+
   size_t InitOatHeader();
   size_t InitOatDexFiles(size_t offset);
   size_t InitDexFiles(size_t offset);
+  size_t InitLookupTables(size_t offset);
   size_t InitOatClasses(size_t offset);
   size_t InitOatMaps(size_t offset);
   size_t InitOatCode(size_t offset)
@@ -150,6 +186,8 @@ class OatWriter {
   size_t WriteMaps(OutputStream* out, const size_t file_offset, size_t relative_offset);
   size_t WriteCode(OutputStream* out, const size_t file_offset, size_t relative_offset);
   size_t WriteCodeDexFiles(OutputStream* out, const size_t file_offset, size_t relative_offset);
+  bool WriteLayoutTierAlignment(OutputStream* out, const size_t file_offset, LayoutTier tier,
+                                size_t tiers_offset, size_t* relative_offset);
 
   class OatDexFile {
    public:
@@ -167,8 +205,15 @@ class OatWriter {
     const uint8_t* dex_file_location_data_;
     uint32_t dex_file_location_checksum_;
     uint32_t dex_file_offset_;
+    // 0 if the dex file has no lookup table.
+    uint32_t lookup_table_offset_;
     std::vector<uint32_t> methods_offsets_;
 
+    std::unique_ptr<TypeLookupTable> lookup_table_;
+
+    // The laid out copy of the dex file to write, empty to write the dex file as it is.
+    std::vector<uint8_t> laid_out_dex_file_;
+
    private:
     DISALLOW_COPY_AND_ASSIGN(OatDexFile);
   };
@@ -177,6 +222,7 @@ class OatWriter {
    public:
     explicit OatClass(size_t offset,
                       const std::vector<CompiledMethod*>& compiled_methods,
+                      const std::vector<LayoutTier>& layout_tiers,
                       uint32_t num_non_null_compiled_methods,
                       mirror::Class::Status status);
     ~OatClass();
@@ -191,6 +237,11 @@ class OatWriter {
       return compiled_methods_[class_def_method_index];
     }
 
+    LayoutTier GetLayoutTier(size_t class_def_method_index) const {
+      DCHECK_LT(class_def_method_index, layout_tiers_.size());
+      return layout_tiers_[class_def_method_index];
+    }
+
     // Offset of start of OatClass from beginning of OatHeader. It is
     // used to validate file position when writing. For Portable, it
     // is also used to calculate the position of the OatMethodOffsets
@@ -201,6 +252,9 @@ class OatWriter {
     // CompiledMethods for each class_def_method_index, or NULL if no method is available.
     std::vector<CompiledMethod*> compiled_methods_;
 
+    // LayoutTier for each class_def_method_index, kLayoutTierCold if no method is available.
+    std::vector<LayoutTier> layout_tiers_;
+
     // Offset from OatClass::offset_ to the OatMethodOffsets for the
     // class_def_method_index. If 0, it means the corresponding
     // CompiledMethod entry in OatClass::compiled_methods_ should be
@@ -240,6 +294,9 @@ class OatWriter {
 
   const CompilerDriver* const compiler_driver_;
 
+  // kLayoutTierCold without a profile, as all methods are cold then.
+  const LayoutTier first_layout_tier_;
+
   // note OatFile does not take ownership of the DexFiles
   const std::vector<const DexFile*>* dex_files_;
 
@@ -272,6 +329,8 @@ class OatWriter {
   uint32_t size_oat_header_;
   uint32_t size_oat_header_image_file_location_;
   uint32_t size_dex_file_;
+  uint32_t size_lookup_table_alignment_;
+  uint32_t size_lookup_table_;
   uint32_t size_interpreter_to_interpreter_bridge_;
   uint32_t size_interpreter_to_compiled_code_bridge_;
   uint32_t size_jni_dlsym_lookup_;
@@ -286,6 +345,7 @@ class OatWriter {
   uint32_t size_method_header_;
   uint32_t size_code_;
   uint32_t size_code_alignment_;
+  uint32_t size_layout_tier_alignment_;
   uint32_t size_mapping_table_;
   uint32_t size_vmap_table_;
   uint32_t size_gc_map_;
@@ -293,6 +353,7 @@ class OatWriter {
   uint32_t size_oat_dex_file_location_data_;
   uint32_t size_oat_dex_file_location_checksum_;
   uint32_t size_oat_dex_file_offset_;
+  uint32_t size_oat_dex_file_lookup_table_offset_;
   uint32_t size_oat_dex_file_methods_offsets_;
   uint32_t size_oat_class_type_;
   uint32_t size_oat_class_status_;
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bounds_check_elimination.h"
+
+namespace art {
+
+static bool IsIntConstant(HInstruction* instruction, int32_t* value) {
+  HIntConstant* constant = instruction->AsIntConstant();
+  if (constant == nullptr) {
+    return false;
+  }
+  *value = constant->GetValue();
+  return true;
+}
+
+static HInstruction* SkipNullChecks(HInstruction* instruction) {
+  while (instruction->AsNullCheck() != nullptr) {
+    instruction = instruction->InputAt(0);
+  }
+  return instruction;
+}
+
+// Returns whether `first` and `second` are the length of the same array.
+static bool IsSameLength(HInstruction* first, HInstruction* second) {
+  if (first == second) {
+    return true;
+  }
+  HArrayLength* first_length = first->AsArrayLength();
+  HArrayLength* second_length = second->AsArrayLength();
+  return first_length != nullptr
+      && second_length != nullptr
+      && SkipNullChecks(first_length->InputAt(0)) == SkipNullChecks(second_length->InputAt(0));
+}
+
+// Returns whether `instruction` is `value` plus the constant `*constant`.
+static bool IsAddConstant(HInstruction* instruction, HInstruction* value, int32_t* constant) {
+  if (instruction->AsAdd() != nullptr) {
+    if (instruction->InputAt(0) == value) {
+      return IsIntConstant(instruction->InputAt(1), constant);
+    } else if (instruction->InputAt(1) == value) {
+      return IsIntConstant(instruction->InputAt(0), constant);
+    }
+  } else if (instruction->AsSub() != nullptr && instruction->InputAt(0) == value) {
+    if (IsIntConstant(instruction->InputAt(1), constant) && *constant != INT32_MIN) {
+      *constant = -*constant;
+      return true;
+    }
+  }
+  return false;
+}
+
+void BoundsCheckElimination::Run() {
+  for (HPostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    if (block->IsLoopHeader()) {
+      VisitLoop(block);
+    }
+  }
+}
+
+void BoundsCheckElimination::VisitLoop(HBasicBlock* header) {
+  HLoopInformation* info = header->GetLoopInformation();
+  HIf* if_instruction = header->GetLastInstruction()->AsIf();
+  if (if_instruction == nullptr) {
+    return;
+  }
+
+  // Find the successor of the header that stays in the loop. All the blocks
+  // of the loop, but the header, are dominated by it.
+  HBasicBlock* body = nullptr;
+  bool condition_holds_in_body = false;
+  if (info->Contains(*if_instruction->IfTrueSuccessor())
+      && !info->Contains(*if_instruction->IfFalseSuccessor())) {
+    body = if_instruction->IfTrueSuccessor();
+    condition_holds_in_body = true;
+  } else if (info->Contains(*if_instruction->IfFalseSuccessor())
+      && !info->Contains(*if_instruction->IfTrueSuccessor())) {
+    body = if_instruction->IfFalseSuccessor();
+  } else {
+    return;
+  }
+
+  HInstruction* input = if_instruction->InputAt(0);
+  while (input->AsNot() != nullptr) {
+    condition_holds_in_body = !condition_holds_in_body;
+    input = input->InputAt(0);
+  }
+  HCondition* condition = input->AsCondition();
+  if (condition == nullptr) {
+    return;
+  }
+  IfCondition cond = condition_holds_in_body
+      ? condition->GetCondition()
+      : NegateCondition(condition->GetCondition());
+
+  size_t pre_header_index = header->GetPredecessorIndexOf(info->GetPreHeader());
+  size_t back_edge_index = 1 - pre_header_index;
+
+  for (HInstructionIterator it(header->GetPhis()); !it.Done(); it.Advance()) {
+    HPhi* phi = it.Current()->AsPhi();
+    if (phi->GetType() != Primitive::kPrimInt) {
+      continue;
+    }
+
+    // The condition holding in the body, as `phi cond bound`.
+    IfCondition phi_cond;
+    HInstruction* bound;
+    if (condition->GetLeft() == phi) {
+      phi_cond = cond;
+      bound = condition->GetRight();
+    } else if (condition->GetRight() == phi) {
+      phi_cond = MirrorCondition(cond);
+      bound = condition->GetLeft();
+    } else {
+      continue;
+    }
+
+    // The phi must be incremented or decremented by one in the body, where
+    // the condition guarantees it does not overflow.
+    HInstruction* update = phi->InputAt(back_edge_index);
+    int32_t stride;
+    if (!IsAddConstant(update, phi, &stride)
+        || (stride != 1 && stride != -1)
+        || !body->Dominates(update->GetBlock())) {
+      continue;
+    }
+
+    HInstruction* initial = phi->InputAt(pre_header_index);
+    HInstruction* length = nullptr;
+    int32_t constant;
+    if (stride == 1) {
+      // The phi is in [initial, bound) in the body.
+      if (phi_cond == kCondLT && IsIntConstant(initial, &constant) && constant >= 0) {
+        length = bound;
+      }
+    } else {
+      // The phi is in [0, initial] in the body, and initial is below the
+      // length of an array.
+      bool is_positive = IsIntConstant(bound, &constant)
+          && ((phi_cond == kCondGE && constant >= 0) || (phi_cond == kCondGT && constant >= -1));
+      if (is_positive) {
+        for (HInputIterator inputs(initial); !inputs.Done(); inputs.Advance()) {
+          HInstruction* array_length = inputs.Current();
+          int32_t offset;
+          if (array_length->AsArrayLength() != nullptr
+              && IsAddConstant(initial, array_length, &offset)
+              && offset < 0) {
+            length = array_length;
+            break;
+          }
+        }
+      }
+    }
+    if (length == nullptr) {
+      continue;
+    }
+
+    // Collect the checks first, as removing them updates the uses of the phi.
+    GrowableArray<HBoundsCheck*> checks(graph_->GetArena(), 4);
+    for (HUseIterator<HInstruction> uses(phi->GetUses()); !uses.Done(); uses.Advance()) {
+      HBoundsCheck* check = uses.Current()->GetUser()->AsBoundsCheck();
+      if (check != nullptr
+          && uses.Current()->GetIndex() == 0
+          && body->Dominates(check->GetBlock())
+          && IsSameLength(check->InputAt(1), length)) {
+        checks.Add(check);
+      }
+    }
+    for (size_t i = 0, e = checks.Size(); i < e; ++i) {
+      HBoundsCheck* check = checks.Get(i);
+      check->ReplaceWith(phi);
+      check->GetBlock()->RemoveInstruction(check);
+    }
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_BOUNDS_CHECK_ELIMINATION_H_
+#define ART_COMPILER_OPTIMIZING_BOUNDS_CHECK_ELIMINATION_H_
+
+#include "nodes.h"
+
+namespace art {
+
+/**
+ * Optimization phase that removes the bounds checks of array accesses
+ * indexed by the induction variable of a counted loop, when the condition
+ * of the loop proves the index is in bounds:
+ *
+ *   for (int i = <constant >= 0>; i < array.length; ++i) { ... array[i] ... }
+ *   for (int i = array.length - <constant >= 1>; i >= 0; --i) { ... array[i] ... }
+ *
+ * The graph must be in SSA form, and its loops must have been found. The
+ * pass expects GVN to have run, so that the lengths of the same array are
+ * the same instruction.
+ */
+class BoundsCheckElimination : public ValueObject {
+ public:
+  explicit BoundsCheckElimination(HGraph* graph) : graph_(graph) {}
+
+  void Run();
+
+ private:
+  // Removes the bounds checks in the loop of `header` that are proven safe by
+  // the condition of the loop on its induction variables.
+  void VisitLoop(HBasicBlock* header);
+
+  HGraph* const graph_;
+
+  DISALLOW_COPY_AND_ASSIGN(BoundsCheckElimination);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_BOUNDS_CHECK_ELIMINATION_H_
@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bounds_check_elimination.h"
+#include "nodes.h"
+#include "optimizing_unit_test.h"
+#include "utils/arena_allocator.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+/**
+ * Fixture building the graph of a counted loop over an array:
+ *
+ *        entry
+ *          |
+ *      pre_header
+ *          |
+ *        header <---+
+ *        /    \     |
+ *    return   body -+
+ *      |
+ *     exit
+ *
+ * The header holds the induction variable and the condition of the loop, the
+ * body the array access and the update of the induction variable.
+ */
+class BoundsCheckEliminationTest : public testing::Test {
+ public:
+  BoundsCheckEliminationTest() : pool_(), allocator_(&pool_) {
+    graph_ = new (&allocator_) HGraph(&allocator_);
+    entry_ = new (&allocator_) HBasicBlock(graph_);
+    pre_header_ = new (&allocator_) HBasicBlock(graph_);
+    header_ = new (&allocator_) HBasicBlock(graph_);
+    body_ = new (&allocator_) HBasicBlock(graph_);
+    return_ = new (&allocator_) HBasicBlock(graph_);
+    exit_ = new (&allocator_) HBasicBlock(graph_);
+
+    graph_->AddBlock(entry_);
+    graph_->AddBlock(pre_header_);
+    graph_->AddBlock(header_);
+    graph_->AddBlock(body_);
+    graph_->AddBlock(return_);
+    graph_->AddBlock(exit_);
+    graph_->SetEntryBlock(entry_);
+    graph_->SetExitBlock(exit_);
+
+    entry_->AddSuccessor(pre_header_);
+    pre_header_->AddSuccessor(header_);
+    body_->AddSuccessor(header_);
+    return_->AddSuccessor(exit_);
+
+    array_ = new (&allocator_) HParameterValue(0, Primitive::kPrimNot);
+    entry_->AddInstruction(array_);
+    return_->AddInstruction(new (&allocator_) HReturnVoid());
+    exit_->AddInstruction(new (&allocator_) HExit());
+  }
+
+  HInstruction* NewConstant(int32_t value) {
+    HInstruction* constant = new (&allocator_) HIntConstant(value);
+    entry_->AddInstruction(constant);
+    return constant;
+  }
+
+  HPhi* NewInductionVariable(HInstruction* initial) {
+    HPhi* phi = new (&allocator_) HPhi(&allocator_, 0, 0, Primitive::kPrimInt);
+    header_->AddPhi(phi);
+    phi->AddInput(initial);
+    return phi;
+  }
+
+  HInstruction* NewLengthIn(HBasicBlock* block) {
+    HInstruction* length = new (&allocator_) HArrayLength(array_);
+    block->AddInstruction(length);
+    return length;
+  }
+
+  // Ends the header with `condition`, which exits the loop when it is
+  // `exit_if_true`, and stays in it otherwise.
+  void SetCondition(HInstruction* condition, bool exit_if_true) {
+    header_->AddInstruction(condition);
+    header_->AddInstruction(new (&allocator_) HIf(condition));
+    if (exit_if_true) {
+      header_->AddSuccessor(return_);
+      header_->AddSuccessor(body_);
+    } else {
+      header_->AddSuccessor(body_);
+      header_->AddSuccessor(return_);
+    }
+  }
+
+  HInstruction* NewArrayAccess(HInstruction* index, HInstruction* length) {
+    HInstruction* check = new (&allocator_) HBoundsCheck(index, length, 0);
+    body_->AddInstruction(check);
+    body_->AddInstruction(new (&allocator_) HArrayGet(array_, check, Primitive::kPrimInt));
+    return check;
+  }
+
+  // Ends the body with the update of `phi` by `stride`.
+  void SetUpdate(HPhi* phi, int32_t stride) {
+    HInstruction* update = new (&allocator_) HAdd(Primitive::kPrimInt, phi, NewConstant(stride));
+    body_->AddInstruction(update);
+    body_->AddInstruction(new (&allocator_) HGoto());
+    phi->AddInput(update);
+  }
+
+  // Ends the entry and the pre-header, and finds the loop.
+  void FinishGraph() {
+    entry_->AddInstruction(new (&allocator_) HGoto());
+    pre_header_->AddInstruction(new (&allocator_) HGoto());
+    graph_->BuildDominatorTree();
+    ASSERT_TRUE(graph_->FindNaturalLoops());
+  }
+
+  void RunBoundsCheckElimination() {
+    FinishGraph();
+    BoundsCheckElimination(graph_).Run();
+  }
+
+  ArenaPool pool_;
+  ArenaAllocator allocator_;
+  HGraph* graph_;
+
+  HBasicBlock* entry_;
+  HBasicBlock* pre_header_;
+  HBasicBlock* header_;
+  HBasicBlock* body_;
+  HBasicBlock* return_;
+  HBasicBlock* exit_;
+
+  HInstruction* array_;
+};
+
+// for (int i = 0; i < array.length; i++) { array[i] }
+TEST_F(BoundsCheckEliminationTest, IncreasingLoop) {
+  HPhi* phi = NewInductionVariable(NewConstant(0));
+  HInstruction* length = NewLengthIn(header_);
+  SetCondition(new (&allocator_) HGreaterThanOrEqual(phi, length), true);
+  HInstruction* check = NewArrayAccess(phi, length);
+  SetUpdate(phi, 1);
+
+  RunBoundsCheckElimination();
+
+  ASSERT_EQ(check->GetBlock(), nullptr);
+  ASSERT_EQ(body_->GetFirstInstruction()->AsArrayGet()->InputAt(1), phi);
+}
+
+// Same loop, with the condition staying in the loop when it holds, and
+// written `array.length > i`.
+TEST_F(BoundsCheckEliminationTest, IncreasingLoopMirroredCondition) {
+  HPhi* phi = NewInductionVariable(NewConstant(2));
+  HInstruction* length = NewLengthIn(header_);
+  SetCondition(new (&allocator_) HGreaterThan(length, phi), false);
+  HInstruction* check = NewArrayAccess(phi, length);
+  SetUpdate(phi, 1);
+
+  RunBoundsCheckElimination();
+
+  ASSERT_EQ(check->GetBlock(), nullptr);
+}
+
+// for (int i = -1; i < array.length; i++) { array[i] }
+TEST_F(BoundsCheckEliminationTest, NegativeInitialValue) {
+  HPhi* phi = NewInductionVariable(NewConstant(-1));
+  HInstruction* length = NewLengthIn(header_);
+  SetCondition(new (&allocator_) HGreaterThanOrEqual(phi, length), true);
+  HInstruction* check = NewArrayAccess(phi, length);
+  SetUpdate(phi, 1);
+
+  RunBoundsCheckElimination();
+
+  ASSERT_EQ(check->GetBlock(), body_);
+}
+
+// for (int i = 0; i <= array.length; i++) { array[i] }
+TEST_F(BoundsCheckEliminationTest, InclusiveUpperBound) {
+  HPhi* phi = NewInductionVariable(NewConstant(0));
+  HInstruction* length = NewLengthIn(header_);
+  SetCondition(new (&allocator_) HGreaterThan(phi, length), true);
+  HInstruction* check = NewArrayAccess(phi, length);
+  SetUpdate(phi, 1);
+
+  RunBoundsCheckElimination();
+
+  ASSERT_EQ(check->GetBlock(), body_);
+}
+
+// for (int i = 0; i < array.length; i += 2) { array[i] }
+TEST_F(BoundsCheckEliminationTest, LargerStride) {
+  HPhi* phi = NewInductionVariable(NewConstant(0));
+  HInstruction* length = NewLengthIn(header_);
+  SetCondition(new (&allocator_) HGreaterThanOrEqual(phi, length), true);
+  HInstruction* check = NewArrayAccess(phi, length);
+  SetUpdate(phi, 2);
+
+  RunBoundsCheckElimination();
+
+  ASSERT_EQ(check->GetBlock(), body_);
+}
+
+// for (int i = array.length - 1; i >= 0; i--) { array[i] }
+TEST_F(BoundsCheckEliminationTest, DecreasingLoop) {
+  HInstruction* initial_length = NewLengthIn(pre_header_);
+  HInstruction* initial =
+      new (&allocator_) HSub(Primitive::kPrimInt, initial_length, NewConstant(1));
+  pre_header_->AddInstruction(initial);
+  HPhi* phi = NewInductionVariable(initial);
+  SetCondition(new (&allocator_) HLessThan(phi, NewConstant(0)), true);
+  // The length checked against is another instruction, for the same array.
+  HInstruction* check = NewArrayAccess(phi, NewLengthIn(body_));
+  SetUpdate(phi, -1);
+
+  RunBoundsCheckElimination();
+
+  ASSERT_EQ(check->GetBlock(), nullptr);
+}
+
+// for (int i = array.length; i >= 0; i--) { array[i] }
+TEST_F(BoundsCheckEliminationTest, DecreasingLoopFromLength) {
+  HInstruction* length = NewLengthIn(pre_header_);
+  HPhi* phi = NewInductionVariable(length);
+  SetCondition(new (&allocator_) HLessThan(phi, NewConstant(0)), true);
+  HInstruction* check = NewArrayAccess(phi, length);
+  SetUpdate(phi, -1);
+
+  RunBoundsCheckElimination();
+
+  ASSERT_EQ(check->GetBlock(), body_);
+}
+
+// The optimizing compiler removes the bounds check of the increasing loop,
+// and generates its code with the register allocator.
+TEST_F(BoundsCheckEliminationTest, CompileOptimized) {
+  HPhi* phi = NewInductionVariable(NewConstant(0));
+  HInstruction* length = NewLengthIn(header_);
+  SetCondition(new (&allocator_) HGreaterThanOrEqual(phi, length), true);
+  HInstruction* check = NewArrayAccess(phi, length);
+  SetUpdate(phi, 1);
+
+  FinishGraph();
+  ASSERT_TRUE(CompileOptimized(graph_, kX86, InstructionSetFeatures()));
+  ASSERT_EQ(check->GetBlock(), nullptr);
+}
+
+}  // namespace art
@@ -15,16 +15,48 @@
  * limitations under the License.
  */
 
+#include "builder.h"
+
 #include "dex_file.h"
 #include "dex_file-inl.h"
 #include "dex_instruction.h"
 #include "dex_instruction-inl.h"
-#include "builder.h"
 #include "nodes.h"
 #include "primitive.h"
 
 namespace art {
 
+/**
+ * Helper class to add HTemporary instructions. This class is used when
+ * converting a DEX instruction to multiple HInstruction, and where those
+ * instructions do not die at the following instruction, but instead spans
+ * multiple instructions.
+ */
+class Temporaries : public ValueObject {
+ public:
+  Temporaries(HGraph* graph, size_t count) : graph_(graph), count_(count), index_(0) {
+    graph_->UpdateNumberOfTemporaries(count_);
+  }
+
+  void Add(HInstruction* instruction) {
+    // We currently only support vreg size temps.
+    DCHECK(instruction->GetType() != Primitive::kPrimLong
+           && instruction->GetType() != Primitive::kPrimDouble);
+    HInstruction* temp = new (graph_->GetArena()) HTemporary(index_++);
+    instruction->GetBlock()->AddInstruction(temp);
+    DCHECK(temp->GetPrevious() == instruction);
+  }
+
+ private:
+  HGraph* const graph_;
+
+  // The total number of temporaries that will be used.
+  const size_t count_;
+
+  // Current index in the temporary stack, updated by `Add`.
+  size_t index_;
+};
+
 void HGraphBuilder::InitializeLocals(uint16_t count) {
   graph_->SetNumberOfVRegs(count);
   locals_.SetSize(count);
@@ -58,28 +90,19 @@ bool HGraphBuilder::InitializeParameters(uint16_t number_of_parameters) {
 
   uint32_t pos = 1;
   for (int i = 0; i < number_of_parameters; i++) {
-    switch (shorty[pos++]) {
-      case 'F':
-      case 'D': {
-        return false;
-      }
-
-      default: {
-        // integer and reference parameters.
-        HParameterValue* parameter =
-            new (arena_) HParameterValue(parameter_index++, Primitive::GetType(shorty[pos - 1]));
-        entry_block_->AddInstruction(parameter);
-        HLocal* local = GetLocalAt(locals_index++);
-        // Store the parameter value in the local that the dex code will use
-        // to reference that parameter.
-        entry_block_->AddInstruction(new (arena_) HStoreLocal(local, parameter));
-        if (parameter->GetType() == Primitive::kPrimLong) {
-          i++;
-          locals_index++;
-          parameter_index++;
-        }
-        break;
-      }
+    HParameterValue* parameter =
+        new (arena_) HParameterValue(parameter_index++, Primitive::GetType(shorty[pos++]));
+    entry_block_->AddInstruction(parameter);
+    HLocal* local = GetLocalAt(locals_index++);
+    // Store the parameter value in the local that the dex code will use
+    // to reference that parameter.
+    entry_block_->AddInstruction(new (arena_) HStoreLocal(local, parameter));
+    bool is_wide = (parameter->GetType() == Primitive::kPrimLong)
+        || (parameter->GetType() == Primitive::kPrimDouble);
+    if (is_wide) {
+      i++;
+      locals_index++;
+      parameter_index++;
     }
   }
   return true;
@@ -100,6 +123,17 @@ void HGraphBuilder::If_22t(const Instruction& instruction, int32_t dex_offset, b
   if (is_not) {
     current_block_->AddInstruction(new (arena_) HNot(current_block_->GetLastInstruction()));
   }
+  BuildIf(instruction, dex_offset);
+}
+
+template<typename T>
+void HGraphBuilder::If_21t(const Instruction& instruction, int32_t dex_offset) {
+  HInstruction* value = LoadLocal(instruction.VRegA(), Primitive::kPrimInt);
+  current_block_->AddInstruction(new (arena_) T(value, GetIntConstant0()));
+  BuildIf(instruction, dex_offset);
+}
+
+void HGraphBuilder::BuildIf(const Instruction& instruction, int32_t dex_offset) {
   current_block_->AddInstruction(new (arena_) HIf(current_block_->GetLastInstruction()));
   HBasicBlock* target = FindBlockStartingAt(instruction.GetTargetOffset() + dex_offset);
   DCHECK(target != nullptr);
@@ -211,7 +245,7 @@ HBasicBlock* HGraphBuilder::FindBlockStartingAt(int32_t index) const {
 }
 
 template<typename T>
-void HGraphBuilder::Binop_32x(const Instruction& instruction, Primitive::Type type) {
+void HGraphBuilder::Binop_23x(const Instruction& instruction, Primitive::Type type) {
   HInstruction* first = LoadLocal(instruction.VRegB(), type);
   HInstruction* second = LoadLocal(instruction.VRegC(), type);
   current_block_->AddInstruction(new (arena_) T(type, first, second));
@@ -248,10 +282,47 @@ void HGraphBuilder::Binop_22b(const Instruction& instruction, bool reverse) {
   UpdateLocal(instruction.VRegA(), current_block_->GetLastInstruction());
 }
 
+template<typename T>
+void HGraphBuilder::BuildCheckedDiv(uint16_t out_reg,
+                                    uint16_t first_reg,
+                                    int32_t second_reg_or_constant,
+                                    uint32_t dex_offset,
+                                    Primitive::Type type,
+                                    bool second_is_lit) {
+  HInstruction* first = LoadLocal(first_reg, type);
+  HInstruction* second = second_is_lit
+      ? GetIntConstant(second_reg_or_constant)
+      : LoadLocal(second_reg_or_constant, type);
+  bool is_integral = (type == Primitive::kPrimInt) || (type == Primitive::kPrimLong);
+  if (is_integral && (!second_is_lit || second_reg_or_constant == 0)) {
+    second = new (arena_) HDivZeroCheck(second, dex_offset);
+    current_block_->AddInstruction(second);
+  }
+  current_block_->AddInstruction(new (arena_) T(type, first, second));
+  UpdateLocal(out_reg, current_block_->GetLastInstruction());
+}
+
+void HGraphBuilder::BuildCompare(const Instruction& instruction,
+                                 Primitive::Type type,
+                                 HCompare::Bias bias) {
+  HInstruction* first = LoadLocal(instruction.VRegB(), type);
+  HInstruction* second = LoadLocal(instruction.VRegC(), type);
+  current_block_->AddInstruction(new (arena_) HCompare(type, first, second, bias));
+  UpdateLocal(instruction.VRegA(), current_block_->GetLastInstruction());
+}
+
 void HGraphBuilder::BuildReturn(const Instruction& instruction, Primitive::Type type) {
   if (type == Primitive::kPrimVoid) {
     current_block_->AddInstruction(new (arena_) HReturnVoid());
   } else {
+    if (dex_compilation_unit_ != nullptr) {
+      // RETURN and RETURN_WIDE are also used for floating point values, which
+      // some calling conventions return in different registers.
+      Primitive::Type return_type = Primitive::GetType(dex_compilation_unit_->GetShorty()[0]);
+      if (return_type == Primitive::kPrimFloat || return_type == Primitive::kPrimDouble) {
+        type = return_type;
+      }
+    }
     HInstruction* value = LoadLocal(instruction.VRegA(), type);
     current_block_->AddInstruction(new (arena_) HReturn(value));
   }
@@ -259,6 +330,11 @@ void HGraphBuilder::BuildReturn(const Instruction& instruction, Primitive::Type
   current_block_ = nullptr;
 }
 
+static bool IsObjectConstructor(const DexFile& dex_file, const DexFile::MethodId& method_id) {
+  return strcmp(dex_file.GetMethodName(method_id), "<init>") == 0
+      && strcmp(dex_file.GetMethodDeclaringClassDescriptor(method_id), "Ljava/lang/Object;") == 0;
+}
+
 bool HGraphBuilder::BuildInvoke(const Instruction& instruction,
                                 uint32_t dex_offset,
                                 uint32_t method_idx,
@@ -266,22 +342,87 @@ bool HGraphBuilder::BuildInvoke(const Instruction& instruction,
                                 bool is_range,
                                 uint32_t* args,
                                 uint32_t register_index) {
+  Instruction::Code opcode = instruction.Opcode();
+  InvokeType invoke_type;
+  switch (opcode) {
+    case Instruction::INVOKE_STATIC:
+    case Instruction::INVOKE_STATIC_RANGE:
+      invoke_type = kStatic;
+      break;
+    case Instruction::INVOKE_DIRECT:
+    case Instruction::INVOKE_DIRECT_RANGE:
+      invoke_type = kDirect;
+      break;
+    case Instruction::INVOKE_VIRTUAL:
+    case Instruction::INVOKE_VIRTUAL_RANGE:
+      invoke_type = kVirtual;
+      break;
+    case Instruction::INVOKE_INTERFACE:
+    case Instruction::INVOKE_INTERFACE_RANGE:
+      invoke_type = kInterface;
+      break;
+    default:
+      LOG(FATAL) << "Unexpected invoke op: " << opcode;
+      return false;
+  }
+
   const DexFile::MethodId& method_id = dex_file_->GetMethodId(method_idx);
   const DexFile::ProtoId& proto_id = dex_file_->GetProtoId(method_id.proto_idx_);
   const char* descriptor = dex_file_->StringDataByIdx(proto_id.shorty_idx_);
   Primitive::Type return_type = Primitive::GetType(descriptor[0]);
-  bool is_instance_call =
-      instruction.Opcode() != Instruction::INVOKE_STATIC
-      && instruction.Opcode() != Instruction::INVOKE_STATIC_RANGE;
+  bool is_instance_call = invoke_type != kStatic;
   const size_t number_of_arguments = strlen(descriptor) - (is_instance_call ? 0 : 1);
 
-  // Treat invoke-direct like static calls for now.
-  HInvoke* invoke = new (arena_) HInvokeStatic(
-      arena_, number_of_arguments, return_type, dex_offset, method_idx);
+  if (invoke_type == kDirect && IsObjectConstructor(*dex_file_, method_id)) {
+    // java.lang.Object.<init> is empty, and the verifier ensures its receiver
+    // is a new instance or `this`, which are not null. Not calling it lets
+    // objects that are only initialized by their fields be scalar replaced.
+    return true;
+  }
+
+  HInvoke* invoke = nullptr;
+  if (invoke_type == kVirtual) {
+    if (compiler_driver_ == nullptr) {
+      return false;
+    }
+    MethodReference target_method(dex_file_, method_idx);
+    uintptr_t direct_code;
+    uintptr_t direct_method;
+    int vtable_index;
+    // We do not want the devirtualization of the driver, that would turn
+    // the call into a direct call we do not know how to emit yet.
+    if (!compiler_driver_->ComputeInvokeInfo(dex_compilation_unit_, dex_offset, false, false,
+                                             &invoke_type, &target_method, &vtable_index,
+                                             &direct_code, &direct_method)
+        || invoke_type != kVirtual) {
+      LOG(INFO) << "Did not compile " << PrettyMethod(method_idx, *dex_file_)
+                << " because a method call could not be resolved";
+      return false;
+    }
+    invoke = new (arena_) HInvokeVirtual(
+        arena_, number_of_arguments, return_type, dex_offset, vtable_index);
+  } else if (invoke_type == kInterface) {
+    // The target is looked up at runtime, by the interface trampoline.
+    invoke = new (arena_) HInvokeInterface(
+        arena_, number_of_arguments, return_type, dex_offset, method_idx);
+  } else {
+    // Treat invoke-direct like static calls for now.
+    invoke = new (arena_) HInvokeStatic(
+        arena_, number_of_arguments, return_type, dex_offset, method_idx);
+  }
 
   size_t start_index = 0;
   if (is_instance_call) {
     HInstruction* arg = LoadLocal(is_range ? register_index : args[0], Primitive::kPrimNot);
+    if (invoke_type == kVirtual || invoke_type == kInterface) {
+      // The class of the receiver is read to find the target, or by the trampoline.
+      // We need one temporary for the null check.
+      Temporaries temps(graph_, 1);
+      HNullCheck* null_check = new (arena_) HNullCheck(arg, dex_offset);
+      current_block_->AddInstruction(null_check);
+      temps.Add(null_check);
+      arg = null_check;
+    }
     invoke->SetArgumentAt(0, arg);
     start_index = 1;
   }
@@ -290,36 +431,125 @@ bool HGraphBuilder::BuildInvoke(const Instruction& instruction,
   uint32_t argument_index = start_index;
   for (size_t i = start_index; i < number_of_vreg_arguments; i++, argument_index++) {
     Primitive::Type type = Primitive::GetType(descriptor[descriptor_index++]);
-    switch (type) {
-      case Primitive::kPrimFloat:
-      case Primitive::kPrimDouble:
-        return false;
-
-      default: {
-        if (!is_range && type == Primitive::kPrimLong && args[i] + 1 != args[i + 1]) {
-          LOG(WARNING) << "Non sequential register pair in " << dex_compilation_unit_->GetSymbol()
-                       << " at " << dex_offset;
-          // We do not implement non sequential register pair.
-          return false;
-        }
-        HInstruction* arg = LoadLocal(is_range ? register_index + i : args[i], type);
-        invoke->SetArgumentAt(argument_index, arg);
-        if (type == Primitive::kPrimLong) {
-          i++;
-        }
-      }
+    bool is_wide = (type == Primitive::kPrimLong) || (type == Primitive::kPrimDouble);
+    if (!is_range && is_wide && args[i] + 1 != args[i + 1]) {
+      LOG(WARNING) << "Non sequential register pair in " << dex_compilation_unit_->GetSymbol()
+                   << " at " << dex_offset;
+      // We do not implement non sequential register pair.
+      return false;
+    }
+    HInstruction* arg = LoadLocal(is_range ? register_index + i : args[i], type);
+    invoke->SetArgumentAt(argument_index, arg);
+    if (is_wide) {
+      i++;
     }
   }
 
-  if (return_type == Primitive::kPrimDouble || return_type == Primitive::kPrimFloat) {
+  DCHECK_EQ(argument_index, number_of_arguments);
+  current_block_->AddInstruction(invoke);
+  return true;
+}
+
+bool HGraphBuilder::CanRemoveAllocation(uint16_t type_index) const {
+  if (compiler_driver_ == nullptr) {
     return false;
   }
+  bool is_type_initialized;
+  bool use_direct_type_ptr;
+  uintptr_t direct_type_ptr;
+  bool is_finalizable;
+  return compiler_driver_->CanAccessInstantiableTypeWithoutChecks(
+             dex_compilation_unit_->GetDexMethodIndex(), *dex_file_, type_index)
+      && compiler_driver_->CanEmbedTypeInCode(*dex_file_, type_index, &is_type_initialized,
+                                              &use_direct_type_ptr, &direct_type_ptr,
+                                              &is_finalizable)
+      && is_type_initialized
+      && !is_finalizable;
+}
 
-  DCHECK_EQ(argument_index, number_of_arguments);
-  current_block_->AddInstruction(invoke);
+static Primitive::Type GetFieldType(const DexFile& dex_file, uint32_t field_index) {
+  const DexFile::FieldId& field_id = dex_file.GetFieldId(field_index);
+  return Primitive::GetType(dex_file.GetFieldTypeDescriptor(field_id)[0]);
+}
+
+bool HGraphBuilder::BuildFieldAccess(const Instruction& instruction,
+                                     uint32_t dex_offset,
+                                     bool is_put) {
+  uint32_t source_or_dest_reg = instruction.VRegA_22c();
+  uint32_t obj_reg = instruction.VRegB_22c();
+  uint16_t field_index = instruction.VRegC_22c();
+
+  if (compiler_driver_ == nullptr) {
+    return false;
+  }
+  MemberOffset field_offset(0u);
+  bool is_volatile;
+  if (!compiler_driver_->ComputeInstanceFieldInfo(
+          field_index, dex_compilation_unit_, is_put, &field_offset, &is_volatile)) {
+    return false;
+  }
+  if (is_volatile) {
+    // Volatile accesses need memory barriers, which the code generators do
+    // not emit. Reject the method, and let another backend compile it.
+    return false;
+  }
+
+  Primitive::Type field_type = GetFieldType(*dex_file_, field_index);
+
+  HInstruction* object = LoadLocal(obj_reg, Primitive::kPrimNot);
+  current_block_->AddInstruction(new (arena_) HNullCheck(object, dex_offset));
+  if (is_put) {
+    // We need one temporary for the null check.
+    Temporaries temps(graph_, 1);
+    HInstruction* null_check = current_block_->GetLastInstruction();
+    temps.Add(null_check);
+    HInstruction* value = LoadLocal(source_or_dest_reg, field_type);
+    current_block_->AddInstruction(new (arena_) HInstanceFieldSet(
+        null_check, value, field_type, field_offset));
+  } else {
+    current_block_->AddInstruction(new (arena_) HInstanceFieldGet(
+        current_block_->GetLastInstruction(), field_type, field_offset));
+    UpdateLocal(source_or_dest_reg, current_block_->GetLastInstruction());
+  }
   return true;
 }
 
+void HGraphBuilder::BuildArrayAccess(const Instruction& instruction,
+                                     uint32_t dex_offset,
+                                     bool is_put,
+                                     Primitive::Type anticipated_type) {
+  uint8_t source_or_dest_reg = instruction.VRegA_23x();
+  uint8_t array_reg = instruction.VRegB_23x();
+  uint8_t index_reg = instruction.VRegC_23x();
+
+  // We need one temporary for the null check, one for the index, and one for the length.
+  Temporaries temps(graph_, 3);
+
+  HInstruction* object = LoadLocal(array_reg, Primitive::kPrimNot);
+  object = new (arena_) HNullCheck(object, dex_offset);
+  current_block_->AddInstruction(object);
+  temps.Add(object);
+
+  HInstruction* length = new (arena_) HArrayLength(object);
+  current_block_->AddInstruction(length);
+  temps.Add(length);
+  HInstruction* index = LoadLocal(index_reg, Primitive::kPrimInt);
+  index = new (arena_) HBoundsCheck(index, length, dex_offset);
+  current_block_->AddInstruction(index);
+  temps.Add(index);
+  if (is_put) {
+    HInstruction* value = LoadLocal(source_or_dest_reg, anticipated_type);
+    // A store of a reference does not need a type check node: the code
+    // generators store it with the pAputObject entrypoint, which checks the
+    // type and throws ArrayStoreException.
+    current_block_->AddInstruction(new (arena_) HArraySet(
+        object, index, value, anticipated_type, dex_offset));
+  } else {
+    current_block_->AddInstruction(new (arena_) HArrayGet(object, index, anticipated_type));
+    UpdateLocal(source_or_dest_reg, current_block_->GetLastInstruction());
+  }
+}
+
 bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_t dex_offset) {
   if (current_block_ == nullptr) {
     return true;  // Dead code
@@ -361,12 +591,52 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
       break;
     }
 
-    case Instruction::MOVE: {
+    case Instruction::CONST: {
+      int32_t register_index = instruction.VRegA();
+      HIntConstant* constant = GetIntConstant(instruction.VRegB_31i());
+      UpdateLocal(register_index, constant);
+      break;
+    }
+
+    case Instruction::CONST_HIGH16: {
+      int32_t register_index = instruction.VRegA();
+      HIntConstant* constant = GetIntConstant(instruction.VRegB_21h() << 16);
+      UpdateLocal(register_index, constant);
+      break;
+    }
+
+    case Instruction::CONST_WIDE_HIGH16: {
+      int32_t register_index = instruction.VRegA();
+      int64_t value = static_cast<int64_t>(instruction.VRegB_21h()) << 48;
+      HLongConstant* constant = GetLongConstant(value);
+      UpdateLocal(register_index, constant);
+      break;
+    }
+
+    case Instruction::MOVE:
+    case Instruction::MOVE_FROM16:
+    case Instruction::MOVE_16: {
       HInstruction* value = LoadLocal(instruction.VRegB(), Primitive::kPrimInt);
       UpdateLocal(instruction.VRegA(), value);
       break;
     }
 
+    case Instruction::MOVE_WIDE:
+    case Instruction::MOVE_WIDE_FROM16:
+    case Instruction::MOVE_WIDE_16: {
+      HInstruction* value = LoadLocal(instruction.VRegB(), Primitive::kPrimLong);
+      UpdateLocal(instruction.VRegA(), value);
+      break;
+    }
+
+    case Instruction::MOVE_OBJECT:
+    case Instruction::MOVE_OBJECT_FROM16:
+    case Instruction::MOVE_OBJECT_16: {
+      HInstruction* value = LoadLocal(instruction.VRegB(), Primitive::kPrimNot);
+      UpdateLocal(instruction.VRegA(), value);
+      break;
+    }
+
     case Instruction::RETURN_VOID: {
       BuildReturn(instruction, Primitive::kPrimVoid);
       break;
@@ -382,6 +652,56 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
       break;
     }
 
+    case Instruction::IF_LT: {
+      If_22t<HLessThan>(instruction, dex_offset, false);
+      break;
+    }
+
+    case Instruction::IF_LE: {
+      If_22t<HLessThanOrEqual>(instruction, dex_offset, false);
+      break;
+    }
+
+    case Instruction::IF_GT: {
+      If_22t<HGreaterThan>(instruction, dex_offset, false);
+      break;
+    }
+
+    case Instruction::IF_GE: {
+      If_22t<HGreaterThanOrEqual>(instruction, dex_offset, false);
+      break;
+    }
+
+    case Instruction::IF_EQZ: {
+      If_21t<HEqual>(instruction, dex_offset);
+      break;
+    }
+
+    case Instruction::IF_NEZ: {
+      If_21t<HNotEqual>(instruction, dex_offset);
+      break;
+    }
+
+    case Instruction::IF_LTZ: {
+      If_21t<HLessThan>(instruction, dex_offset);
+      break;
+    }
+
+    case Instruction::IF_LEZ: {
+      If_21t<HLessThanOrEqual>(instruction, dex_offset);
+      break;
+    }
+
+    case Instruction::IF_GTZ: {
+      If_21t<HGreaterThan>(instruction, dex_offset);
+      break;
+    }
+
+    case Instruction::IF_GEZ: {
+      If_21t<HGreaterThanOrEqual>(instruction, dex_offset);
+      break;
+    }
+
     case Instruction::GOTO:
     case Instruction::GOTO_16:
     case Instruction::GOTO_32: {
@@ -409,7 +729,9 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
     }
 
     case Instruction::INVOKE_STATIC:
-    case Instruction::INVOKE_DIRECT: {
+    case Instruction::INVOKE_DIRECT:
+    case Instruction::INVOKE_VIRTUAL:
+    case Instruction::INVOKE_INTERFACE: {
       uint32_t method_idx = instruction.VRegB_35c();
       uint32_t number_of_vreg_arguments = instruction.VRegA_35c();
       uint32_t args[5];
@@ -421,7 +743,9 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
     }
 
     case Instruction::INVOKE_STATIC_RANGE:
-    case Instruction::INVOKE_DIRECT_RANGE: {
+    case Instruction::INVOKE_DIRECT_RANGE:
+    case Instruction::INVOKE_VIRTUAL_RANGE:
+    case Instruction::INVOKE_INTERFACE_RANGE: {
       uint32_t method_idx = instruction.VRegB_3rc();
       uint32_t number_of_vreg_arguments = instruction.VRegA_3rc();
       uint32_t register_index = instruction.VRegC();
@@ -433,22 +757,110 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
     }
 
     case Instruction::ADD_INT: {
-      Binop_32x<HAdd>(instruction, Primitive::kPrimInt);
+      Binop_23x<HAdd>(instruction, Primitive::kPrimInt);
       break;
     }
 
     case Instruction::ADD_LONG: {
-      Binop_32x<HAdd>(instruction, Primitive::kPrimLong);
+      Binop_23x<HAdd>(instruction, Primitive::kPrimLong);
       break;
     }
 
     case Instruction::SUB_INT: {
-      Binop_32x<HSub>(instruction, Primitive::kPrimInt);
+      Binop_23x<HSub>(instruction, Primitive::kPrimInt);
       break;
     }
 
     case Instruction::SUB_LONG: {
-      Binop_32x<HSub>(instruction, Primitive::kPrimLong);
+      Binop_23x<HSub>(instruction, Primitive::kPrimLong);
+      break;
+    }
+
+    case Instruction::ADD_FLOAT: {
+      Binop_23x<HAdd>(instruction, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::ADD_DOUBLE: {
+      Binop_23x<HAdd>(instruction, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::SUB_FLOAT: {
+      Binop_23x<HSub>(instruction, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::SUB_DOUBLE: {
+      Binop_23x<HSub>(instruction, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::MUL_INT: {
+      Binop_23x<HMul>(instruction, Primitive::kPrimInt);
+      break;
+    }
+
+    case Instruction::MUL_LONG: {
+      Binop_23x<HMul>(instruction, Primitive::kPrimLong);
+      break;
+    }
+
+    case Instruction::MUL_FLOAT: {
+      Binop_23x<HMul>(instruction, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::MUL_DOUBLE: {
+      Binop_23x<HMul>(instruction, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::DIV_INT: {
+      BuildCheckedDiv<HDiv>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC(),
+                            dex_offset, Primitive::kPrimInt, false);
+      break;
+    }
+
+    case Instruction::DIV_LONG: {
+      BuildCheckedDiv<HDiv>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC(),
+                            dex_offset, Primitive::kPrimLong, false);
+      break;
+    }
+
+    case Instruction::DIV_FLOAT: {
+      BuildCheckedDiv<HDiv>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC(),
+                            dex_offset, Primitive::kPrimFloat, false);
+      break;
+    }
+
+    case Instruction::DIV_DOUBLE: {
+      BuildCheckedDiv<HDiv>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC(),
+                            dex_offset, Primitive::kPrimDouble, false);
+      break;
+    }
+
+    case Instruction::REM_INT: {
+      BuildCheckedDiv<HRem>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC(),
+                            dex_offset, Primitive::kPrimInt, false);
+      break;
+    }
+
+    case Instruction::REM_LONG: {
+      BuildCheckedDiv<HRem>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC(),
+                            dex_offset, Primitive::kPrimLong, false);
+      break;
+    }
+
+    case Instruction::REM_FLOAT: {
+      BuildCheckedDiv<HRem>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC(),
+                            dex_offset, Primitive::kPrimFloat, false);
+      break;
+    }
+
+    case Instruction::REM_DOUBLE: {
+      BuildCheckedDiv<HRem>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC(),
+                            dex_offset, Primitive::kPrimDouble, false);
       break;
     }
 
@@ -472,6 +884,94 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
       break;
     }
 
+    case Instruction::ADD_FLOAT_2ADDR: {
+      Binop_12x<HAdd>(instruction, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::ADD_DOUBLE_2ADDR: {
+      Binop_12x<HAdd>(instruction, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::SUB_FLOAT_2ADDR: {
+      Binop_12x<HSub>(instruction, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::SUB_DOUBLE_2ADDR: {
+      Binop_12x<HSub>(instruction, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::MUL_INT_2ADDR: {
+      Binop_12x<HMul>(instruction, Primitive::kPrimInt);
+      break;
+    }
+
+    case Instruction::MUL_LONG_2ADDR: {
+      Binop_12x<HMul>(instruction, Primitive::kPrimLong);
+      break;
+    }
+
+    case Instruction::MUL_FLOAT_2ADDR: {
+      Binop_12x<HMul>(instruction, Primitive::kPrimFloat);
+      break;
+    }
+
+    case Instruction::MUL_DOUBLE_2ADDR: {
+      Binop_12x<HMul>(instruction, Primitive::kPrimDouble);
+      break;
+    }
+
+    case Instruction::DIV_INT_2ADDR: {
+      BuildCheckedDiv<HDiv>(instruction.VRegA(), instruction.VRegA(), instruction.VRegB(),
+                            dex_offset, Primitive::kPrimInt, false);
+      break;
+    }
+
+    case Instruction::DIV_LONG_2ADDR: {
+      BuildCheckedDiv<HDiv>(instruction.VRegA(), instruction.VRegA(), instruction.VRegB(),
+                            dex_offset, Primitive::kPrimLong, false);
+      break;
+    }
+
+    case Instruction::DIV_FLOAT_2ADDR: {
+      BuildCheckedDiv<HDiv>(instruction.VRegA(), instruction.VRegA(), instruction.VRegB(),
+                            dex_offset, Primitive::kPrimFloat, false);
+      break;
+    }
+
+    case Instruction::DIV_DOUBLE_2ADDR: {
+      BuildCheckedDiv<HDiv>(instruction.VRegA(), instruction.VRegA(), instruction.VRegB(),
+                            dex_offset, Primitive::kPrimDouble, false);
+      break;
+    }
+
+    case Instruction::REM_INT_2ADDR: {
+      BuildCheckedDiv<HRem>(instruction.VRegA(), instruction.VRegA(), instruction.VRegB(),
+                            dex_offset, Primitive::kPrimInt, false);
+      break;
+    }
+
+    case Instruction::REM_LONG_2ADDR: {
+      BuildCheckedDiv<HRem>(instruction.VRegA(), instruction.VRegA(), instruction.VRegB(),
+                            dex_offset, Primitive::kPrimLong, false);
+      break;
+    }
+
+    case Instruction::REM_FLOAT_2ADDR: {
+      BuildCheckedDiv<HRem>(instruction.VRegA(), instruction.VRegA(), instruction.VRegB(),
+                            dex_offset, Primitive::kPrimFloat, false);
+      break;
+    }
+
+    case Instruction::REM_DOUBLE_2ADDR: {
+      BuildCheckedDiv<HRem>(instruction.VRegA(), instruction.VRegA(), instruction.VRegB(),
+                            dex_offset, Primitive::kPrimDouble, false);
+      break;
+    }
+
     case Instruction::ADD_INT_LIT16: {
       Binop_22s<HAdd>(instruction, false);
       break;
@@ -492,19 +992,134 @@ bool HGraphBuilder::AnalyzeDexInstruction(const Instruction& instruction, int32_
       break;
     }
 
+    case Instruction::MUL_INT_LIT16: {
+      Binop_22s<HMul>(instruction, false);
+      break;
+    }
+
+    case Instruction::DIV_INT_LIT16: {
+      BuildCheckedDiv<HDiv>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC_22s(),
+                            dex_offset, Primitive::kPrimInt, true);
+      break;
+    }
+
+    case Instruction::REM_INT_LIT16: {
+      BuildCheckedDiv<HRem>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC_22s(),
+                            dex_offset, Primitive::kPrimInt, true);
+      break;
+    }
+
+    case Instruction::MUL_INT_LIT8: {
+      Binop_22b<HMul>(instruction, false);
+      break;
+    }
+
+    case Instruction::DIV_INT_LIT8: {
+      BuildCheckedDiv<HDiv>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC_22b(),
+                            dex_offset, Primitive::kPrimInt, true);
+      break;
+    }
+
+    case Instruction::REM_INT_LIT8: {
+      BuildCheckedDiv<HRem>(instruction.VRegA(), instruction.VRegB(), instruction.VRegC_22b(),
+                            dex_offset, Primitive::kPrimInt, true);
+      break;
+    }
+
+    case Instruction::CMP_LONG: {
+      BuildCompare(instruction, Primitive::kPrimLong, HCompare::kNoBias);
+      break;
+    }
+
+    case Instruction::CMPG_FLOAT: {
+      BuildCompare(instruction, Primitive::kPrimFloat, HCompare::kGtBias);
+      break;
+    }
+
+    case Instruction::CMPL_FLOAT: {
+      BuildCompare(instruction, Primitive::kPrimFloat, HCompare::kLtBias);
+      break;
+    }
+
+    case Instruction::CMPG_DOUBLE: {
+      BuildCompare(instruction, Primitive::kPrimDouble, HCompare::kGtBias);
+      break;
+    }
+
+    case Instruction::CMPL_DOUBLE: {
+      BuildCompare(instruction, Primitive::kPrimDouble, HCompare::kLtBias);
+      break;
+    }
+
     case Instruction::NEW_INSTANCE: {
-      current_block_->AddInstruction(
-          new (arena_) HNewInstance(dex_offset, instruction.VRegB_21c()));
+      uint16_t type_index = instruction.VRegB_21c();
+      current_block_->AddInstruction(new (arena_) HNewInstance(
+          dex_offset, type_index, CanRemoveAllocation(type_index)));
       UpdateLocal(instruction.VRegA(), current_block_->GetLastInstruction());
       break;
     }
 
     case Instruction::MOVE_RESULT:
-    case Instruction::MOVE_RESULT_WIDE: {
+    case Instruction::MOVE_RESULT_WIDE:
+    case Instruction::MOVE_RESULT_OBJECT: {
       UpdateLocal(instruction.VRegA(), current_block_->GetLastInstruction());
       break;
     }
 
+    case Instruction::IGET:
+    case Instruction::IGET_WIDE:
+    case Instruction::IGET_OBJECT:
+    case Instruction::IGET_BOOLEAN:
+    case Instruction::IGET_BYTE:
+    case Instruction::IGET_CHAR:
+    case Instruction::IGET_SHORT: {
+      if (!BuildFieldAccess(instruction, dex_offset, false)) {
+        return false;
+      }
+      break;
+    }
+
+    case Instruction::IPUT:
+    case Instruction::IPUT_WIDE:
+    case Instruction::IPUT_OBJECT:
+    case Instruction::IPUT_BOOLEAN:
+    case Instruction::IPUT_BYTE:
+    case Instruction::IPUT_CHAR:
+    case Instruction::IPUT_SHORT: {
+      if (!BuildFieldAccess(instruction, dex_offset, true)) {
+        return false;
+      }
+      break;
+    }
+
+#define ARRAY_XX(kind, anticipated_type)                                          \
+    case Instruction::AGET##kind: {                                               \
+      BuildArrayAccess(instruction, dex_offset, false, anticipated_type);         \
+      break;                                                                      \
+    }                                                                             \
+    case Instruction::APUT##kind: {                                               \
+      BuildArrayAccess(instruction, dex_offset, true, anticipated_type);          \
+      break;                                                                      \
+    }
+
+    ARRAY_XX(, Primitive::kPrimInt);
+    ARRAY_XX(_WIDE, Primitive::kPrimLong);
+    ARRAY_XX(_OBJECT, Primitive::kPrimNot);
+    ARRAY_XX(_BOOLEAN, Primitive::kPrimBoolean);
+    ARRAY_XX(_BYTE, Primitive::kPrimByte);
+    ARRAY_XX(_CHAR, Primitive::kPrimChar);
+    ARRAY_XX(_SHORT, Primitive::kPrimShort);
+#undef ARRAY_XX
+
+    case Instruction::ARRAY_LENGTH: {
+      HInstruction* object = LoadLocal(instruction.VRegB_12x(), Primitive::kPrimNot);
+      current_block_->AddInstruction(new (arena_) HNullCheck(object, dex_offset));
+      current_block_->AddInstruction(
+          new (arena_) HArrayLength(current_block_->GetLastInstruction()));
+      UpdateLocal(instruction.VRegA_12x(), current_block_->GetLastInstruction());
+      break;
+    }
+
     case Instruction::NOP:
       break;
 
@@ -18,7 +18,9 @@
 #define ART_COMPILER_OPTIMIZING_BUILDER_H_
 
 #include "dex_file.h"
+#include "driver/compiler_driver.h"
 #include "driver/dex_compilation_unit.h"
+#include "nodes.h"
 #include "primitive.h"
 #include "utils/allocation.h"
 #include "utils/growable_array.h"
@@ -38,7 +40,8 @@ class HGraphBuilder : public ValueObject {
  public:
   HGraphBuilder(ArenaAllocator* arena,
                 DexCompilationUnit* dex_compilation_unit = nullptr,
-                const DexFile* dex_file = nullptr)
+                const DexFile* dex_file = nullptr,
+                CompilerDriver* driver = nullptr)
       : arena_(arena),
         branch_targets_(arena, 0),
         locals_(arena, 0),
@@ -49,7 +52,8 @@ class HGraphBuilder : public ValueObject {
         constant0_(nullptr),
         constant1_(nullptr),
         dex_file_(dex_file),
-        dex_compilation_unit_(dex_compilation_unit) { }
+        dex_compilation_unit_(dex_compilation_unit),
+        compiler_driver_(driver) { }
 
   HGraph* BuildGraph(const DexFile::CodeItem& code);
 
@@ -79,7 +83,7 @@ class HGraphBuilder : public ValueObject {
   bool InitializeParameters(uint16_t number_of_parameters);
 
   template<typename T>
-  void Binop_32x(const Instruction& instruction, Primitive::Type type);
+  void Binop_23x(const Instruction& instruction, Primitive::Type type);
 
   template<typename T>
   void Binop_12x(const Instruction& instruction, Primitive::Type type);
@@ -90,10 +94,36 @@ class HGraphBuilder : public ValueObject {
   template<typename T>
   void Binop_22s(const Instruction& instruction, bool reverse);
 
+  // Builds a division or a remainder, preceded by a check against zero of the
+  // divisor for integral types.
+  template<typename T>
+  void BuildCheckedDiv(uint16_t out_reg,
+                       uint16_t first_reg,
+                       int32_t second_reg_or_constant,
+                       uint32_t dex_offset,
+                       Primitive::Type type,
+                       bool second_is_lit);
+
+  void BuildCompare(const Instruction& instruction, Primitive::Type type, HCompare::Bias bias);
+
   template<typename T> void If_22t(const Instruction& instruction, int32_t dex_offset, bool is_not);
+  template<typename T> void If_21t(const Instruction& instruction, int32_t dex_offset);
+  void BuildIf(const Instruction& instruction, int32_t dex_offset);
 
   void BuildReturn(const Instruction& instruction, Primitive::Type type);
 
+  // Builds an instance field access node and returns whether the instruction is supported.
+  bool BuildFieldAccess(const Instruction& instruction, uint32_t dex_offset, bool is_put);
+
+  void BuildArrayAccess(const Instruction& instruction,
+                        uint32_t dex_offset,
+                        bool is_put,
+                        Primitive::Type anticipated_type);
+
+  // Returns whether an allocation of the class at `type_index` has no effect
+  // other than allocating, see HNewInstance::CanBeRemoved.
+  bool CanRemoveAllocation(uint16_t type_index) const;
+
   // Builds an invocation node and returns whether the instruction is supported.
   bool BuildInvoke(const Instruction& instruction,
                    uint32_t dex_offset,
@@ -122,6 +152,7 @@ class HGraphBuilder : public ValueObject {
 
   const DexFile* const dex_file_;
   DexCompilationUnit* const dex_compilation_unit_;
+  CompilerDriver* const compiler_driver_;
 
   DISALLOW_COPY_AND_ASSIGN(HGraphBuilder);
 };
@@ -18,31 +18,86 @@
 
 #include "code_generator_arm.h"
 #include "code_generator_x86.h"
+#include "code_generator_x86_64.h"
 #include "dex/verified_method.h"
 #include "driver/dex_compilation_unit.h"
-#include "gc_map_builder.h"
-#include "leb128.h"
-#include "mapping_table.h"
+#include "stack_map_builder.h"
 #include "utils/assembler.h"
 #include "verifier/dex_gc_map.h"
-#include "vmap_table.h"
 
 namespace art {
 
-void CodeGenerator::Compile(CodeAllocator* allocator) {
+void CodeGenerator::CompileBaseline(CodeAllocator* allocator) {
   const GrowableArray<HBasicBlock*>& blocks = GetGraph()->GetBlocks();
   DCHECK(blocks.Get(0) == GetGraph()->GetEntryBlock());
   DCHECK(GoesToNextBlock(GetGraph()->GetEntryBlock(), blocks.Get(1)));
+  is_baseline_ = true;
+  ComputeFrameSize(0);
   GenerateFrameEntry();
   for (size_t i = 0, e = blocks.Size(); i < e; ++i) {
     CompileBlock(blocks.Get(i));
   }
+  GenerateSlowPaths();
+  Finalize(allocator);
+}
+
+void CodeGenerator::CompileOptimized(CodeAllocator* allocator) {
+  // The register allocator has already computed the frame size and set up the
+  // locations of all instructions.
+  const GrowableArray<HBasicBlock*>& blocks = GetGraph()->GetBlocks();
+  DCHECK(blocks.Get(0) == GetGraph()->GetEntryBlock());
+  DCHECK(GoesToNextBlock(GetGraph()->GetEntryBlock(), blocks.Get(1)));
+  GenerateFrameEntry();
+  HGraphVisitor* instruction_visitor = GetInstructionVisitor();
+  for (size_t i = 0, e = blocks.Size(); i < e; ++i) {
+    HBasicBlock* block = blocks.Get(i);
+    Bind(GetLabelOf(block));
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      it.Current()->Accept(instruction_visitor);
+    }
+  }
+  GenerateSlowPaths();
+  Finalize(allocator);
+}
+
+void CodeGenerator::GenerateSlowPaths() {
+  for (size_t i = 0, e = slow_paths_.Size(); i < e; ++i) {
+    slow_paths_.Get(i)->EmitNativeCode(this);
+  }
+}
+
+void CodeGenerator::Finalize(CodeAllocator* allocator) {
   size_t code_size = GetAssembler()->CodeSize();
   uint8_t* buffer = allocator->Allocate(code_size);
   MemoryRegion code(buffer, code_size);
   GetAssembler()->FinalizeInstructions(code);
 }
 
+void CodeGenerator::ComputeFrameSize(size_t number_of_spill_slots) {
+  SetFrameSize(RoundUp(
+      GetWordSize()  // ART method
+      + (GetGraph()->GetMaximumNumberOfOutVRegs() + number_of_spill_slots) * kVRegSize
+      + GetGraph()->GetNumberOfTemporaries() * kVRegSize
+      + GetGraph()->GetNumberOfVRegs() * kVRegSize
+      + kVRegSize  // filler
+      + FrameEntrySpillSize(),
+      kStackAlignment));
+}
+
+int32_t CodeGenerator::GetStackOffsetOfSpillSlot(size_t spill_slot) const {
+  return GetWordSize()  // ART method
+      + (GetGraph()->GetMaximumNumberOfOutVRegs() + spill_slot) * kVRegSize;
+}
+
+Location CodeGenerator::GetTemporaryLocation(HTemporary* temp) const {
+  DCHECK_LT(temp->GetIndex(), GetGraph()->GetNumberOfTemporaries());
+  int32_t slot = GetFrameSize() - FrameEntrySpillSize()
+                                - kVRegSize  // filler
+                                - (GetGraph()->GetNumberOfVRegs() * kVRegSize)
+                                - ((1 + temp->GetIndex()) * kVRegSize);
+  return Location::StackSlot(slot);
+}
+
 void CodeGenerator::CompileBlock(HBasicBlock* block) {
   Bind(GetLabelOf(block));
   HGraphVisitor* location_builder = GetLocationBuilder();
@@ -156,14 +211,32 @@ void CodeGenerator::AllocateRegistersLocally(HInstruction* instruction) const {
 
 void CodeGenerator::InitLocations(HInstruction* instruction) {
   if (instruction->GetLocations() == nullptr) {
+    if (instruction->AsTemporary() != nullptr) {
+      // Spill the value of the previous instruction, and let its users find
+      // it in the temporary's stack slot.
+      HInstruction* previous = instruction->GetPrevious();
+      Location temp_location = GetTemporaryLocation(instruction->AsTemporary());
+      Move(previous, temp_location, instruction);
+      previous->GetLocations()->SetOut(temp_location);
+    }
     return;
   }
   AllocateRegistersLocally(instruction);
+  // Move first the input that is the result of the previous instruction: the
+  // moves of locals and constants may clobber the register it is in.
+  for (size_t i = 0, e = instruction->InputCount(); i < e; ++i) {
+    Location location = instruction->GetLocations()->InAt(i);
+    HInstruction* input = instruction->InputAt(i);
+    if (location.IsValid() && input->GetNext() == instruction) {
+      Move(input, location, instruction);
+    }
+  }
   for (size_t i = 0, e = instruction->InputCount(); i < e; ++i) {
     Location location = instruction->GetLocations()->InAt(i);
-    if (location.IsValid()) {
+    HInstruction* input = instruction->InputAt(i);
+    if (location.IsValid() && input->GetNext() != instruction) {
       // Move the input to the desired location.
-      Move(instruction->InputAt(i), location, instruction);
+      Move(input, location, instruction);
     }
   }
 }
@@ -191,107 +264,90 @@ CodeGenerator* CodeGenerator::Create(ArenaAllocator* allocator,
       return new (allocator) x86::CodeGeneratorX86(graph);
     }
     case kX86_64: {
-      return new (allocator) x86::CodeGeneratorX86(graph);
+      return new (allocator) x86_64::CodeGeneratorX86_64(graph);
     }
     default:
       return nullptr;
   }
 }
 
-void CodeGenerator::BuildNativeGCMap(
+void CodeGenerator::BuildStackMaps(
     std::vector<uint8_t>* data, const DexCompilationUnit& dex_compilation_unit) const {
+  if (!is_baseline_) {
+    BuildOptimizedStackMaps(data);
+    return;
+  }
   const std::vector<uint8_t>& gc_map_raw =
       dex_compilation_unit.GetVerifiedMethod()->GetDexGcMap();
   verifier::DexPcToReferenceMap dex_gc_map(&(gc_map_raw)[0]);
+  uint16_t number_of_vregs = GetGraph()->GetNumberOfVRegs();
+  size_t number_of_reference_vregs =
+      std::min(dex_gc_map.RegWidth() * kBitsPerByte, static_cast<size_t>(number_of_vregs));
 
-  uint32_t max_native_offset = 0;
-  for (size_t i = 0; i < pc_infos_.Size(); i++) {
-    uint32_t native_offset = pc_infos_.Get(i).native_pc;
-    if (native_offset > max_native_offset) {
-      max_native_offset = native_offset;
-    }
-  }
-
-  GcMapBuilder builder(data, pc_infos_.Size(), max_native_offset, dex_gc_map.RegWidth());
+  StackMapBuilder builder(number_of_vregs);
   for (size_t i = 0; i < pc_infos_.Size(); i++) {
     struct PcInfo pc_info = pc_infos_.Get(i);
-    uint32_t native_offset = pc_info.native_pc;
-    uint32_t dex_pc = pc_info.dex_pc;
-    const uint8_t* references = dex_gc_map.FindBitMap(dex_pc, false);
-    CHECK(references != NULL) << "Missing ref for dex pc 0x" << std::hex << dex_pc;
-    builder.AddEntry(native_offset, references);
+    const uint8_t* references = dex_gc_map.FindBitMap(pc_info.dex_pc, false);
+    CHECK(references != NULL) << "Missing ref for dex pc 0x" << std::hex << pc_info.dex_pc;
+    // Baseline code keeps the dex registers in their stack slots and does not
+    // use callee-saved registers.
+    builder.AddStackMap(pc_info.dex_pc, pc_info.native_pc, 0u);
+    for (uint16_t reg = 0; reg < number_of_vregs; ++reg) {
+      int32_t stack_slot = GetStackSlotOfDexRegister(reg);
+      builder.AddDexRegister(DexRegisterMap::kInStack, stack_slot);
+      if (reg < number_of_reference_vregs
+          && ((references[reg / kBitsPerByte] >> (reg % kBitsPerByte)) & 1) != 0) {
+        builder.AddStackReference(stack_slot);
+      }
+    }
   }
+  builder.Encode(data);
 }
 
-void CodeGenerator::BuildMappingTable(std::vector<uint8_t>* data) const {
-  uint32_t pc2dex_data_size = 0u;
-  uint32_t pc2dex_entries = pc_infos_.Size();
-  uint32_t pc2dex_offset = 0u;
-  int32_t pc2dex_dalvik_offset = 0;
-  uint32_t dex2pc_data_size = 0u;
-  uint32_t dex2pc_entries = 0u;
-
-  // We currently only have pc2dex entries.
-  for (size_t i = 0; i < pc2dex_entries; i++) {
-    struct PcInfo pc_info = pc_infos_.Get(i);
-    pc2dex_data_size += UnsignedLeb128Size(pc_info.native_pc - pc2dex_offset);
-    pc2dex_data_size += SignedLeb128Size(pc_info.dex_pc - pc2dex_dalvik_offset);
-    pc2dex_offset = pc_info.native_pc;
-    pc2dex_dalvik_offset = pc_info.dex_pc;
-  }
-
-  uint32_t total_entries = pc2dex_entries + dex2pc_entries;
-  uint32_t hdr_data_size = UnsignedLeb128Size(total_entries) + UnsignedLeb128Size(pc2dex_entries);
-  uint32_t data_size = hdr_data_size + pc2dex_data_size + dex2pc_data_size;
-  data->resize(data_size);
-
-  uint8_t* data_ptr = &(*data)[0];
-  uint8_t* write_pos = data_ptr;
-  write_pos = EncodeUnsignedLeb128(write_pos, total_entries);
-  write_pos = EncodeUnsignedLeb128(write_pos, pc2dex_entries);
-  DCHECK_EQ(static_cast<size_t>(write_pos - data_ptr), hdr_data_size);
-  uint8_t* write_pos2 = write_pos + pc2dex_data_size;
-
-  pc2dex_offset = 0u;
-  pc2dex_dalvik_offset = 0u;
-  for (size_t i = 0; i < pc2dex_entries; i++) {
+void CodeGenerator::BuildOptimizedStackMaps(std::vector<uint8_t>* data) const {
+  uint16_t number_of_vregs = GetGraph()->GetNumberOfVRegs();
+  StackMapBuilder builder(number_of_vregs);
+  for (size_t i = 0; i < pc_infos_.Size(); i++) {
     struct PcInfo pc_info = pc_infos_.Get(i);
-    DCHECK(pc2dex_offset <= pc_info.native_pc);
-    write_pos = EncodeUnsignedLeb128(write_pos, pc_info.native_pc - pc2dex_offset);
-    write_pos = EncodeSignedLeb128(write_pos, pc_info.dex_pc - pc2dex_dalvik_offset);
-    pc2dex_offset = pc_info.native_pc;
-    pc2dex_dalvik_offset = pc_info.dex_pc;
-  }
-  DCHECK_EQ(static_cast<size_t>(write_pos - data_ptr), hdr_data_size + pc2dex_data_size);
-  DCHECK_EQ(static_cast<size_t>(write_pos2 - data_ptr), data_size);
-
-  if (kIsDebugBuild) {
-    // Verify the encoded table holds the expected data.
-    MappingTable table(data_ptr);
-    CHECK_EQ(table.TotalSize(), total_entries);
-    CHECK_EQ(table.PcToDexSize(), pc2dex_entries);
-    auto it = table.PcToDexBegin();
-    auto it2 = table.DexToPcBegin();
-    for (size_t i = 0; i < pc2dex_entries; i++) {
-      struct PcInfo pc_info = pc_infos_.Get(i);
-      CHECK_EQ(pc_info.native_pc, it.NativePcOffset());
-      CHECK_EQ(pc_info.dex_pc, it.DexPc());
-      ++it;
+    // Optimized code only records safepoints in the slow paths of checks,
+    // which throw. The frame is never resumed, so no reference needs to be
+    // visited, and the dex registers are only described for the debugger.
+    builder.AddStackMap(pc_info.dex_pc, pc_info.native_pc, 0u);
+    LocationSummary* locations = pc_info.instruction->GetLocations();
+    for (uint16_t reg = 0; reg < number_of_vregs; ++reg) {
+      Location location = reg < locations->GetEnvironmentSize()
+          ? locations->GetEnvironmentAt(reg)
+          : Location::NoLocation();
+      if (location.IsConstant()) {
+        HIntConstant* constant = location.GetConstant()->AsIntConstant();
+        DCHECK(constant != nullptr);
+        builder.AddDexRegister(DexRegisterMap::kConstant, constant->GetValue());
+      } else if (location.IsStackSlot()) {
+        builder.AddDexRegister(DexRegisterMap::kInStack, location.GetStackIndex());
+      } else if (location.IsRegister()) {
+        builder.AddDexRegister(DexRegisterMap::kInRegister, location.reg().RegId());
+      } else {
+        builder.AddDexRegister(DexRegisterMap::kNone, 0);
+      }
     }
-    CHECK(it == table.PcToDexEnd());
-    CHECK(it2 == table.DexToPcEnd());
   }
+  builder.Encode(data);
 }
 
-void CodeGenerator::BuildVMapTable(std::vector<uint8_t>* data) const {
-  Leb128EncodingVector vmap_encoder;
-  // We currently don't use callee-saved registers.
-  size_t size = 0 + 1 /* marker */ + 0;
-  vmap_encoder.Reserve(size + 1u);  // All values are likely to be one byte in ULEB128 (<128).
-  vmap_encoder.PushBackUnsigned(size);
-  vmap_encoder.PushBackUnsigned(VmapTable::kAdjustedFpMarker);
-
-  *data = vmap_encoder.GetData();
+int32_t CodeGenerator::GetStackSlotOfDexRegister(uint16_t reg_number) const {
+  uint16_t number_of_vregs = GetGraph()->GetNumberOfVRegs();
+  uint16_t number_of_in_vregs = GetGraph()->GetNumberOfInVRegs();
+  if (reg_number >= number_of_vregs - number_of_in_vregs) {
+    // Local is a parameter of the method. It is stored in the caller's frame.
+    return GetFrameSize() + GetWordSize()  // ART method
+                          + (reg_number - number_of_vregs + number_of_in_vregs) * kVRegSize;
+  } else {
+    // Local is a temporary in this method. It is stored in this method's frame.
+    return GetFrameSize() - FrameEntrySpillSize()
+                          - kVRegSize  // filler.
+                          - (number_of_vregs * kVRegSize)
+                          + (reg_number * kVRegSize);
+  }
 }
 
 }  // namespace art
@@ -20,8 +20,10 @@
 #include "utils/arm/managed_register_arm.h"
 
 #include "entrypoints/quick/quick_entrypoints.h"
+#include "gc/accounting/card_table.h"
 #include "mirror/array.h"
 #include "mirror/art_method.h"
+#include "mirror/class.h"
 #include "thread.h"
 
 #define __ reinterpret_cast<ArmAssembler*>(GetAssembler())->
@@ -40,7 +42,8 @@ static constexpr int kCurrentMethodStackOffset = 0;
 CodeGeneratorARM::CodeGeneratorARM(HGraph* graph)
     : CodeGenerator(graph, kNumberOfRegIds),
       location_builder_(graph, this),
-      instruction_visitor_(graph, this) {}
+      instruction_visitor_(graph, this),
+      move_resolver_(graph->GetArena(), this) {}
 
 static bool* GetBlockedRegisterPairs(bool* blocked_registers) {
   return blocked_registers + kNumberOfAllocIds;
@@ -49,7 +52,8 @@ static bool* GetBlockedRegisterPairs(bool* blocked_registers) {
 ManagedRegister CodeGeneratorARM::AllocateFreeRegister(Primitive::Type type,
                                                        bool* blocked_registers) const {
   switch (type) {
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       size_t reg = AllocateFreeRegisterInternal(
           GetBlockedRegisterPairs(blocked_registers), kNumberOfRegisterPairs);
       ArmManagedRegister pair =
@@ -64,15 +68,14 @@ ManagedRegister CodeGeneratorARM::AllocateFreeRegister(Primitive::Type type,
     case Primitive::kPrimChar:
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
     case Primitive::kPrimNot: {
+      // Float values are kept in core registers, as in the soft float calling
+      // convention, and moved to VFP registers by the instructions operating on them.
       size_t reg = AllocateFreeRegisterInternal(blocked_registers, kNumberOfCoreRegisters);
       return ArmManagedRegister::FromCoreRegister(static_cast<Register>(reg));
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << type;
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << type;
   }
@@ -98,6 +101,10 @@ void CodeGeneratorARM::SetupBlockedRegisters(bool* blocked_registers) const {
   // Reserve thread register.
   blocked_registers[TR] = true;
 
+  // Reserve IP, the scratch register of the assembler and of the moves between
+  // two stack slots.
+  blocked_registers[IP] = true;
+
   // TODO: We currently don't use Quick's callee saved registers.
   blocked_registers[R5] = true;
   blocked_registers[R6] = true;
@@ -112,10 +119,116 @@ size_t CodeGeneratorARM::GetNumberOfRegisters() const {
   return kNumberOfRegIds;
 }
 
+size_t CodeGeneratorARM::GetNumberOfCoreRegisters() const {
+  return kNumberOfCoreRegisters;
+}
+
+size_t CodeGeneratorARM::FrameEntrySpillSize() const {
+  return kNumberOfPushedRegistersAtEntry * kArmWordSize;
+}
+
 static Location ArmCoreLocation(Register reg) {
   return Location::RegisterLocation(ArmManagedRegister::FromCoreRegister(reg));
 }
 
+static Location ArmPairLocation(RegisterPair pair) {
+  return Location::RegisterLocation(ArmManagedRegister::FromRegisterPair(pair));
+}
+
+static constexpr Register kRuntimeParameterCoreRegisters[] = { R0, R1, R2 };
+static constexpr size_t kRuntimeParameterCoreRegistersLength =
+    arraysize(kRuntimeParameterCoreRegisters);
+
+class InvokeRuntimeCallingConvention : public CallingConvention<Register> {
+ public:
+  InvokeRuntimeCallingConvention()
+      : CallingConvention(kRuntimeParameterCoreRegisters,
+                          kRuntimeParameterCoreRegistersLength) {}
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(InvokeRuntimeCallingConvention);
+};
+
+#undef __
+#define __ reinterpret_cast<ArmAssembler*>(codegen->GetAssembler())->
+
+class NullCheckSlowPathARM : public SlowPathCode {
+ public:
+  explicit NullCheckSlowPathARM(HNullCheck* instruction) : instruction_(instruction) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    int32_t offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pThrowNullPointer).Int32Value();
+    __ ldr(LR, Address(TR, offset));
+    __ blx(LR);
+    codegen->RecordPcInfo(instruction_, instruction_->GetDexPc());
+  }
+
+ private:
+  HNullCheck* const instruction_;
+
+  DISALLOW_COPY_AND_ASSIGN(NullCheckSlowPathARM);
+};
+
+class DeoptimizationSlowPathARM : public SlowPathCode {
+ public:
+  explicit DeoptimizationSlowPathARM(HDeoptimize* instruction) : instruction_(instruction) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    int32_t offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pDeoptimize).Int32Value();
+    __ ldr(LR, Address(TR, offset));
+    __ blx(LR);
+    codegen->RecordPcInfo(instruction_, instruction_->GetDexPc());
+  }
+
+ private:
+  HDeoptimize* const instruction_;
+
+  DISALLOW_COPY_AND_ASSIGN(DeoptimizationSlowPathARM);
+};
+
+class DivZeroCheckSlowPathARM : public SlowPathCode {
+ public:
+  explicit DivZeroCheckSlowPathARM(HDivZeroCheck* instruction) : instruction_(instruction) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    int32_t offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pThrowDivZero).Int32Value();
+    __ ldr(LR, Address(TR, offset));
+    __ blx(LR);
+    codegen->RecordPcInfo(instruction_, instruction_->GetDexPc());
+  }
+
+ private:
+  HDivZeroCheck* const instruction_;
+
+  DISALLOW_COPY_AND_ASSIGN(DivZeroCheckSlowPathARM);
+};
+
+class BoundsCheckSlowPathARM : public SlowPathCode {
+ public:
+  explicit BoundsCheckSlowPathARM(HBoundsCheck* instruction) : instruction_(instruction) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    // The index and the length are already in the registers of the runtime
+    // calling convention.
+    __ Bind(GetEntryLabel());
+    int32_t offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pThrowArrayBounds).Int32Value();
+    __ ldr(LR, Address(TR, offset));
+    __ blx(LR);
+    codegen->RecordPcInfo(instruction_, instruction_->GetDexPc());
+  }
+
+ private:
+  HBoundsCheck* const instruction_;
+
+  DISALLOW_COPY_AND_ASSIGN(BoundsCheckSlowPathARM);
+};
+
+#undef __
+#define __ reinterpret_cast<ArmAssembler*>(GetAssembler())->
+
 InstructionCodeGeneratorARM::InstructionCodeGeneratorARM(HGraph* graph, CodeGeneratorARM* codegen)
       : HGraphVisitor(graph),
         assembler_(codegen->GetAssembler()),
@@ -125,12 +238,6 @@ void CodeGeneratorARM::GenerateFrameEntry() {
   core_spill_mask_ |= (1 << LR);
   __ PushList((1 << LR));
 
-  SetFrameSize(RoundUp(
-      (GetGraph()->GetMaximumNumberOfOutVRegs() + GetGraph()->GetNumberOfVRegs()) * kVRegSize
-      + kVRegSize  // filler
-      + kArmWordSize  // Art method
-      + kNumberOfPushedRegistersAtEntry * kArmWordSize,
-      kStackAlignment));
   // The return PC has already been pushed on the stack.
   __ AddConstant(SP, -(GetFrameSize() - kNumberOfPushedRegistersAtEntry * kArmWordSize));
   __ str(R0, Address(SP, 0));
@@ -145,36 +252,17 @@ void CodeGeneratorARM::Bind(Label* label) {
   __ Bind(label);
 }
 
-int32_t CodeGeneratorARM::GetStackSlot(HLocal* local) const {
-  uint16_t reg_number = local->GetRegNumber();
-  uint16_t number_of_vregs = GetGraph()->GetNumberOfVRegs();
-  uint16_t number_of_in_vregs = GetGraph()->GetNumberOfInVRegs();
-  if (reg_number >= number_of_vregs - number_of_in_vregs) {
-    // Local is a parameter of the method. It is stored in the caller's frame.
-    return GetFrameSize() + kArmWordSize  // ART method
-                          + (reg_number - number_of_vregs + number_of_in_vregs) * kVRegSize;
-  } else {
-    // Local is a temporary in this method. It is stored in this method's frame.
-    return GetFrameSize() - (kNumberOfPushedRegistersAtEntry * kArmWordSize)
-                          - kVRegSize  // filler.
-                          - (number_of_vregs * kVRegSize)
-                          + (reg_number * kVRegSize);
-  }
-}
-
 Location CodeGeneratorARM::GetStackLocation(HLoadLocal* load) const {
   switch (load->GetType()) {
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       return Location::DoubleStackSlot(GetStackSlot(load->GetLocal()));
       break;
 
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
-      return Location::StackSlot(GetStackSlot(load->GetLocal()));
-
     case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented type " << load->GetType();
+      return Location::StackSlot(GetStackSlot(load->GetLocal()));
 
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
@@ -195,6 +283,7 @@ Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type
     case Primitive::kPrimChar:
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
     case Primitive::kPrimNot: {
       uint32_t index = gp_index_++;
       if (index < calling_convention.GetNumberOfRegisters()) {
@@ -204,7 +293,8 @@ Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type
       }
     }
 
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       uint32_t index = gp_index_;
       gp_index_ += 2;
       if (index + 1 < calling_convention.GetNumberOfRegisters()) {
@@ -217,11 +307,6 @@ Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type
       }
     }
 
-    case Primitive::kPrimDouble:
-    case Primitive::kPrimFloat:
-      LOG(FATAL) << "Unimplemented parameter type " << type;
-      break;
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unexpected parameter type " << type;
       break;
@@ -244,8 +329,8 @@ void CodeGeneratorARM::Move32(Location destination, Location source) {
     if (source.IsRegister()) {
       __ str(source.AsArm().AsCoreRegister(), Address(SP, destination.GetStackIndex()));
     } else {
-      __ ldr(R0, Address(SP, source.GetStackIndex()));
-      __ str(R0, Address(SP, destination.GetStackIndex()));
+      __ ldr(IP, Address(SP, source.GetStackIndex()));
+      __ str(IP, Address(SP, destination.GetStackIndex()));
     }
   }
 }
@@ -256,8 +341,24 @@ void CodeGeneratorARM::Move64(Location destination, Location source) {
   }
   if (destination.IsRegister()) {
     if (source.IsRegister()) {
-      __ Mov(destination.AsArm().AsRegisterPairLow(), source.AsArm().AsRegisterPairLow());
-      __ Mov(destination.AsArm().AsRegisterPairHigh(), source.AsArm().AsRegisterPairHigh());
+      Register source_low = source.AsArm().AsRegisterPairLow();
+      Register source_high = source.AsArm().AsRegisterPairHigh();
+      Register destination_low = destination.AsArm().AsRegisterPairLow();
+      Register destination_high = destination.AsArm().AsRegisterPairHigh();
+      if (destination_low == source_high) {
+        // Do not overwrite the high word before it is read.
+        if (destination_high == source_low) {
+          __ Mov(IP, source_low);
+          __ Mov(destination_low, source_high);
+          __ Mov(destination_high, IP);
+        } else {
+          __ Mov(destination_high, source_high);
+          __ Mov(destination_low, source_low);
+        }
+      } else {
+        __ Mov(destination_low, source_low);
+        __ Mov(destination_high, source_high);
+      }
     } else if (source.IsQuickParameter()) {
       uint32_t argument_index = source.GetQuickParameterIndex();
       InvokeDexCallingConvention calling_convention;
@@ -322,8 +423,8 @@ void CodeGeneratorARM::Move(HInstruction* instruction, Location location, HInstr
     if (location.IsRegister()) {
       __ LoadImmediate(location.AsArm().AsCoreRegister(), value);
     } else {
-      __ LoadImmediate(R0, value);
-      __ str(R0, Address(SP, location.GetStackIndex()));
+      __ LoadImmediate(IP, value);
+      __ str(IP, Address(SP, location.GetStackIndex()));
     }
   } else if (instruction->AsLongConstant() != nullptr) {
     int64_t value = instruction->AsLongConstant()->GetValue();
@@ -345,10 +446,12 @@ void CodeGeneratorARM::Move(HInstruction* instruction, Location location, HInstr
       case Primitive::kPrimShort:
       case Primitive::kPrimInt:
       case Primitive::kPrimNot:
+      case Primitive::kPrimFloat:
         Move32(location, Location::StackSlot(stack_slot));
         break;
 
       case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
         Move64(location, Location::DoubleStackSlot(stack_slot));
         break;
 
@@ -357,8 +460,9 @@ void CodeGeneratorARM::Move(HInstruction* instruction, Location location, HInstr
     }
   } else {
     // This can currently only happen when the instruction that requests the move
-    // is the next to be compiled.
-    DCHECK_EQ(instruction->GetNext(), move_for);
+    // is the next to be compiled, or when the value was saved in a temporary.
+    DCHECK((instruction->GetNext() == move_for) ||
+           instruction->GetNext()->AsTemporary() != nullptr);
     switch (instruction->GetType()) {
       case Primitive::kPrimBoolean:
       case Primitive::kPrimByte:
@@ -366,10 +470,12 @@ void CodeGeneratorARM::Move(HInstruction* instruction, Location location, HInstr
       case Primitive::kPrimShort:
       case Primitive::kPrimNot:
       case Primitive::kPrimInt:
+      case Primitive::kPrimFloat:
         Move32(location, instruction->GetLocations()->Out());
         break;
 
       case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
         Move64(location, instruction->GetLocations()->Out());
         break;
 
@@ -379,6 +485,18 @@ void CodeGeneratorARM::Move(HInstruction* instruction, Location location, HInstr
   }
 }
 
+void CodeGeneratorARM::MarkGCCard(Register temp, Register card, Register object, Register value) {
+  Label is_null;
+  __ cmp(value, ShifterOperand(0));
+  __ b(&is_null, EQ);
+  __ LoadFromOffset(kLoadWord, card, TR, Thread::CardTableOffset<kArmWordSize>().Int32Value());
+  __ Lsr(temp, object, gc::accounting::CardTable::kCardShift);
+  __ add(temp, card, ShifterOperand(temp));
+  // The card table base is biased so that its low byte is the dirty card value.
+  __ strb(card, Address(temp, 0));
+  __ Bind(&is_null);
+}
+
 void LocationsBuilderARM::VisitGoto(HGoto* got) {
   got->SetLocations(nullptr);
 }
@@ -418,20 +536,111 @@ void InstructionCodeGeneratorARM::VisitIf(HIf* if_instr) {
   }
 }
 
-void LocationsBuilderARM::VisitEqual(HEqual* equal) {
-  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(equal);
+void LocationsBuilderARM::VisitDeoptimize(HDeoptimize* deoptimize) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(deoptimize);
+  locations->SetInAt(0, Location::RequiresRegister());
+  deoptimize->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitDeoptimize(HDeoptimize* deoptimize) {
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) DeoptimizationSlowPathARM(deoptimize);
+  codegen_->AddSlowPath(slow_path);
+
+  __ cmp(deoptimize->GetLocations()->InAt(0).AsArm().AsCoreRegister(), ShifterOperand(0));
+  __ b(slow_path->GetEntryLabel(), NE);
+}
+
+static Condition ARMCondition(IfCondition cond) {
+  switch (cond) {
+    case kCondEQ: return EQ;
+    case kCondNE: return NE;
+    case kCondLT: return LT;
+    case kCondLE: return LE;
+    case kCondGT: return GT;
+    case kCondGE: return GE;
+  }
+  LOG(FATAL) << "Unreachable";
+  return EQ;
+}
+
+static Condition ARMOppositeCondition(IfCondition cond) {
+  switch (cond) {
+    case kCondEQ: return NE;
+    case kCondNE: return EQ;
+    case kCondLT: return GE;
+    case kCondLE: return GT;
+    case kCondGT: return LE;
+    case kCondGE: return LT;
+  }
+  LOG(FATAL) << "Unreachable";
+  return EQ;
+}
+
+void LocationsBuilderARM::HandleCondition(HCondition* condition) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(condition);
   locations->SetInAt(0, Location::RequiresRegister());
   locations->SetInAt(1, Location::RequiresRegister());
   locations->SetOut(Location::RequiresRegister());
-  equal->SetLocations(locations);
+  condition->SetLocations(locations);
 }
 
-void InstructionCodeGeneratorARM::VisitEqual(HEqual* equal) {
-  LocationSummary* locations = equal->GetLocations();
-  __ teq(locations->InAt(0).AsArm().AsCoreRegister(),
+void InstructionCodeGeneratorARM::HandleCondition(HCondition* condition) {
+  LocationSummary* locations = condition->GetLocations();
+  __ cmp(locations->InAt(0).AsArm().AsCoreRegister(),
          ShifterOperand(locations->InAt(1).AsArm().AsCoreRegister()));
-  __ mov(locations->Out().AsArm().AsCoreRegister(), ShifterOperand(1), EQ);
-  __ mov(locations->Out().AsArm().AsCoreRegister(), ShifterOperand(0), NE);
+  __ mov(locations->Out().AsArm().AsCoreRegister(), ShifterOperand(1),
+         ARMCondition(condition->GetCondition()));
+  __ mov(locations->Out().AsArm().AsCoreRegister(), ShifterOperand(0),
+         ARMOppositeCondition(condition->GetCondition()));
+}
+
+void LocationsBuilderARM::VisitEqual(HEqual* equal) {
+  HandleCondition(equal);
+}
+
+void InstructionCodeGeneratorARM::VisitEqual(HEqual* equal) {
+  HandleCondition(equal);
+}
+
+void LocationsBuilderARM::VisitNotEqual(HNotEqual* comp) {
+  HandleCondition(comp);
+}
+
+void InstructionCodeGeneratorARM::VisitNotEqual(HNotEqual* comp) {
+  HandleCondition(comp);
+}
+
+void LocationsBuilderARM::VisitLessThan(HLessThan* comp) {
+  HandleCondition(comp);
+}
+
+void InstructionCodeGeneratorARM::VisitLessThan(HLessThan* comp) {
+  HandleCondition(comp);
+}
+
+void LocationsBuilderARM::VisitLessThanOrEqual(HLessThanOrEqual* comp) {
+  HandleCondition(comp);
+}
+
+void InstructionCodeGeneratorARM::VisitLessThanOrEqual(HLessThanOrEqual* comp) {
+  HandleCondition(comp);
+}
+
+void LocationsBuilderARM::VisitGreaterThan(HGreaterThan* comp) {
+  HandleCondition(comp);
+}
+
+void InstructionCodeGeneratorARM::VisitGreaterThan(HGreaterThan* comp) {
+  HandleCondition(comp);
+}
+
+void LocationsBuilderARM::VisitGreaterThanOrEqual(HGreaterThanOrEqual* comp) {
+  HandleCondition(comp);
+}
+
+void InstructionCodeGeneratorARM::VisitGreaterThanOrEqual(HGreaterThanOrEqual* comp) {
+  HandleCondition(comp);
 }
 
 void LocationsBuilderARM::VisitLocal(HLocal* local) {
@@ -459,10 +668,12 @@ void LocationsBuilderARM::VisitStoreLocal(HStoreLocal* store) {
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
       locations->SetInAt(1, Location::StackSlot(codegen_->GetStackSlot(store->GetLocal())));
       break;
 
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       locations->SetInAt(1, Location::DoubleStackSlot(codegen_->GetStackSlot(store->GetLocal())));
       break;
 
@@ -476,7 +687,9 @@ void InstructionCodeGeneratorARM::VisitStoreLocal(HStoreLocal* store) {
 }
 
 void LocationsBuilderARM::VisitIntConstant(HIntConstant* constant) {
-  constant->SetLocations(nullptr);
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(constant);
+  locations->SetOut(Location::ConstantLocation(constant));
+  constant->SetLocations(locations);
 }
 
 void InstructionCodeGeneratorARM::VisitIntConstant(HIntConstant* constant) {
@@ -508,10 +721,12 @@ void LocationsBuilderARM::VisitReturn(HReturn* ret) {
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
       locations->SetInAt(0, ArmCoreLocation(R0));
       break;
 
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       locations->SetInAt(
           0, Location::RegisterLocation(ArmManagedRegister::FromRegisterPair(R0_R1)));
       break;
@@ -532,10 +747,12 @@ void InstructionCodeGeneratorARM::VisitReturn(HReturn* ret) {
       case Primitive::kPrimShort:
       case Primitive::kPrimInt:
       case Primitive::kPrimNot:
+      case Primitive::kPrimFloat:
         DCHECK_EQ(ret->GetLocations()->InAt(0).AsArm().AsCoreRegister(), R0);
         break;
 
       case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
         DCHECK_EQ(ret->GetLocations()->InAt(0).AsArm().AsRegisterPair(), R0_R1);
         break;
 
@@ -547,6 +764,10 @@ void InstructionCodeGeneratorARM::VisitReturn(HReturn* ret) {
 }
 
 void LocationsBuilderARM::VisitInvokeStatic(HInvokeStatic* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderARM::HandleInvoke(HInvoke* invoke) {
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(invoke);
   locations->AddTemp(Location::RequiresRegister());
 
@@ -563,20 +784,17 @@ void LocationsBuilderARM::VisitInvokeStatic(HInvokeStatic* invoke) {
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
       locations->SetOut(ArmCoreLocation(R0));
       break;
 
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       locations->SetOut(Location::RegisterLocation(ArmManagedRegister::FromRegisterPair(R0_R1)));
       break;
 
     case Primitive::kPrimVoid:
       break;
-
-    case Primitive::kPrimDouble:
-    case Primitive::kPrimFloat:
-      LOG(FATAL) << "Unimplemented return type " << invoke->GetType();
-      break;
   }
 
   invoke->SetLocations(locations);
@@ -610,14 +828,53 @@ void InstructionCodeGeneratorARM::VisitInvokeStatic(HInvokeStatic* invoke) {
   // LR()
   __ blx(LR);
 
-  codegen_->RecordPcInfo(invoke->GetDexPc());
+  codegen_->RecordPcInfo(invoke, invoke->GetDexPc());
+}
+
+void InstructionCodeGeneratorARM::GenerateFloatingPointBinop(HBinaryOperation* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Location first = locations->InAt(0);
+  Location second = locations->InAt(1);
+  Location out = locations->Out();
+  if (instruction->GetResultType() == Primitive::kPrimFloat) {
+    __ vmovsr(S0, first.AsArm().AsCoreRegister());
+    __ vmovsr(S1, second.AsArm().AsCoreRegister());
+    if (instruction->AsAdd() != nullptr) {
+      __ vadds(S0, S0, S1);
+    } else if (instruction->AsSub() != nullptr) {
+      __ vsubs(S0, S0, S1);
+    } else if (instruction->AsMul() != nullptr) {
+      __ vmuls(S0, S0, S1);
+    } else {
+      DCHECK(instruction->AsDiv() != nullptr);
+      __ vdivs(S0, S0, S1);
+    }
+    __ vmovrs(out.AsArm().AsCoreRegister(), S0);
+  } else {
+    DCHECK_EQ(instruction->GetResultType(), Primitive::kPrimDouble);
+    __ vmovdrr(D0, first.AsArm().AsRegisterPairLow(), first.AsArm().AsRegisterPairHigh());
+    __ vmovdrr(D1, second.AsArm().AsRegisterPairLow(), second.AsArm().AsRegisterPairHigh());
+    if (instruction->AsAdd() != nullptr) {
+      __ vaddd(D0, D0, D1);
+    } else if (instruction->AsSub() != nullptr) {
+      __ vsubd(D0, D0, D1);
+    } else if (instruction->AsMul() != nullptr) {
+      __ vmuld(D0, D0, D1);
+    } else {
+      DCHECK(instruction->AsDiv() != nullptr);
+      __ vdivd(D0, D0, D1);
+    }
+    __ vmovrrd(out.AsArm().AsRegisterPairLow(), out.AsArm().AsRegisterPairHigh(), D0);
+  }
 }
 
 void LocationsBuilderARM::VisitAdd(HAdd* add) {
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(add);
   switch (add->GetResultType()) {
     case Primitive::kPrimInt:
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
       locations->SetInAt(0, Location::RequiresRegister());
       locations->SetInAt(1, Location::RequiresRegister());
       locations->SetOut(Location::RequiresRegister());
@@ -655,6 +912,11 @@ void InstructionCodeGeneratorARM::VisitAdd(HAdd* add) {
              ShifterOperand(locations->InAt(1).AsArm().AsRegisterPairHigh()));
       break;
 
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      GenerateFloatingPointBinop(add);
+      break;
+
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
     case Primitive::kPrimChar:
@@ -671,7 +933,9 @@ void LocationsBuilderARM::VisitSub(HSub* sub) {
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(sub);
   switch (sub->GetResultType()) {
     case Primitive::kPrimInt:
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
       locations->SetInAt(0, Location::RequiresRegister());
       locations->SetInAt(1, Location::RequiresRegister());
       locations->SetOut(Location::RequiresRegister());
@@ -709,6 +973,11 @@ void InstructionCodeGeneratorARM::VisitSub(HSub* sub) {
              ShifterOperand(locations->InAt(1).AsArm().AsRegisterPairHigh()));
       break;
 
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      GenerateFloatingPointBinop(sub);
+      break;
+
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
     case Primitive::kPrimChar:
@@ -721,76 +990,883 @@ void InstructionCodeGeneratorARM::VisitSub(HSub* sub) {
   }
 }
 
-static constexpr Register kRuntimeParameterCoreRegisters[] = { R0, R1 };
-static constexpr size_t kRuntimeParameterCoreRegistersLength =
-    arraysize(kRuntimeParameterCoreRegisters);
-
-class InvokeRuntimeCallingConvention : public CallingConvention<Register> {
- public:
-  InvokeRuntimeCallingConvention()
-      : CallingConvention(kRuntimeParameterCoreRegisters,
-                          kRuntimeParameterCoreRegistersLength) {}
+void LocationsBuilderARM::VisitMul(HMul* mul) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(mul);
+  switch (mul->GetResultType()) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::RequiresRegister());
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
 
- private:
-  DISALLOW_COPY_AND_ASSIGN(InvokeRuntimeCallingConvention);
-};
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      LOG(FATAL) << "Unexpected mul type " << mul->GetResultType();
+      break;
 
-void LocationsBuilderARM::VisitNewInstance(HNewInstance* instruction) {
-  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
-  InvokeRuntimeCallingConvention calling_convention;
-  locations->AddTemp(ArmCoreLocation(calling_convention.GetRegisterAt(0)));
-  locations->AddTemp(ArmCoreLocation(calling_convention.GetRegisterAt(1)));
-  locations->SetOut(ArmCoreLocation(R0));
-  instruction->SetLocations(locations);
+    default:
+      LOG(FATAL) << "Unimplemented mul type " << mul->GetResultType();
+  }
+  mul->SetLocations(locations);
 }
 
-void InstructionCodeGeneratorARM::VisitNewInstance(HNewInstance* instruction) {
-  InvokeRuntimeCallingConvention calling_convention;
-  LoadCurrentMethod(calling_convention.GetRegisterAt(1));
-  __ LoadImmediate(calling_convention.GetRegisterAt(0), instruction->GetTypeIndex());
+void InstructionCodeGeneratorARM::VisitMul(HMul* mul) {
+  LocationSummary* locations = mul->GetLocations();
+  switch (mul->GetResultType()) {
+    case Primitive::kPrimInt:
+      __ mul(locations->Out().AsArm().AsCoreRegister(),
+             locations->InAt(0).AsArm().AsCoreRegister(),
+             locations->InAt(1).AsArm().AsCoreRegister());
+      break;
 
-  int32_t offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pAllocObjectWithAccessCheck).Int32Value();
-  __ ldr(LR, Address(TR, offset));
-  __ blx(LR);
+    case Primitive::kPrimLong: {
+      Register first_low = locations->InAt(0).AsArm().AsRegisterPairLow();
+      Register first_high = locations->InAt(0).AsArm().AsRegisterPairHigh();
+      Register second_low = locations->InAt(1).AsArm().AsRegisterPairLow();
+      Register second_high = locations->InAt(1).AsArm().AsRegisterPairHigh();
+      Register out_low = locations->Out().AsArm().AsRegisterPairLow();
+      Register out_high = locations->Out().AsArm().AsRegisterPairHigh();
+      // IP = first_low * second_high + first_high * second_low, the cross products
+      // that end up in the high word.
+      __ mul(IP, first_low, second_high);
+      __ mla(IP, first_high, second_low, IP);
+      // The output may alias the inputs: they are all read by umull.
+      __ umull(out_low, out_high, first_low, second_low);
+      __ add(out_high, out_high, ShifterOperand(IP));
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      GenerateFloatingPointBinop(mul);
+      break;
 
-  codegen_->RecordPcInfo(instruction->GetDexPc());
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      LOG(FATAL) << "Unexpected mul type " << mul->GetResultType();
+      break;
+
+    default:
+      LOG(FATAL) << "Unimplemented mul type " << mul->GetResultType();
+  }
 }
 
-void LocationsBuilderARM::VisitParameterValue(HParameterValue* instruction) {
+void LocationsBuilderARM::HandleDivRem(HBinaryOperation* instruction) {
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
-  Location location = parameter_visitor_.GetNextLocation(instruction->GetType());
-  if (location.IsStackSlot()) {
-    location = Location::StackSlot(location.GetStackIndex() + codegen_->GetFrameSize());
-  } else if (location.IsDoubleStackSlot()) {
-    location = Location::DoubleStackSlot(location.GetStackIndex() + codegen_->GetFrameSize());
+  bool is_div = instruction->AsDiv() != nullptr;
+  switch (instruction->GetResultType()) {
+    case Primitive::kPrimInt:
+      // __aeabi_idivmod returns the quotient in R0 and the remainder in R1.
+      locations->SetInAt(0, ArmCoreLocation(R0));
+      locations->SetInAt(1, ArmCoreLocation(R1));
+      locations->SetOut(ArmCoreLocation(is_div ? R0 : R1));
+      break;
+
+    case Primitive::kPrimLong:
+      // __aeabi_ldivmod returns the quotient in R0_R1 and the remainder in R2_R3.
+      locations->SetInAt(0, ArmPairLocation(R0_R1));
+      locations->SetInAt(1, ArmPairLocation(R2_R3));
+      locations->SetOut(ArmPairLocation(is_div ? R0_R1 : R2_R3));
+      break;
+
+    case Primitive::kPrimFloat:
+      if (is_div) {
+        locations->SetInAt(0, Location::RequiresRegister());
+        locations->SetInAt(1, Location::RequiresRegister());
+        locations->SetOut(Location::RequiresRegister());
+      } else {
+        locations->SetInAt(0, ArmCoreLocation(R0));
+        locations->SetInAt(1, ArmCoreLocation(R1));
+        locations->SetOut(ArmCoreLocation(R0));
+      }
+      break;
+
+    case Primitive::kPrimDouble:
+      if (is_div) {
+        locations->SetInAt(0, Location::RequiresRegister());
+        locations->SetInAt(1, Location::RequiresRegister());
+        locations->SetOut(Location::RequiresRegister());
+      } else {
+        locations->SetInAt(0, ArmPairLocation(R0_R1));
+        locations->SetInAt(1, ArmPairLocation(R2_R3));
+        locations->SetOut(ArmPairLocation(R0_R1));
+      }
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected type " << instruction->GetResultType();
   }
-  locations->SetOut(location);
   instruction->SetLocations(locations);
 }
 
-void InstructionCodeGeneratorARM::VisitParameterValue(HParameterValue* instruction) {
-  // Nothing to do, the parameter is already at its location.
-}
+void InstructionCodeGeneratorARM::GenerateDivRem(HBinaryOperation* instruction) {
+  bool is_div = instruction->AsDiv() != nullptr;
+  int32_t offset;
+  switch (instruction->GetResultType()) {
+    case Primitive::kPrimInt:
+      offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pIdivmod).Int32Value();
+      break;
 
-void LocationsBuilderARM::VisitNot(HNot* instruction) {
-  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
-  locations->SetInAt(0, Location::RequiresRegister());
-  locations->SetOut(Location::RequiresRegister());
-  instruction->SetLocations(locations);
-}
+    case Primitive::kPrimLong:
+      offset = is_div
+          ? QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pLdiv).Int32Value()
+          : QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pLmod).Int32Value();
+      break;
 
-void InstructionCodeGeneratorARM::VisitNot(HNot* instruction) {
-  LocationSummary* locations = instruction->GetLocations();
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      if (is_div) {
+        GenerateFloatingPointBinop(instruction);
+        return;
+      }
+      offset = instruction->GetResultType() == Primitive::kPrimFloat
+          ? QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pFmodf).Int32Value()
+          : QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pFmod).Int32Value();
+      break;
+
+    default:
+      LOG(FATAL) << "Unexpected type " << instruction->GetResultType();
+      return;
+  }
+  // The inputs and the output are in the registers of the helper, which does
+  // not throw: the divisor has been checked by a HDivZeroCheck.
+  __ ldr(LR, Address(TR, offset));
+  __ blx(LR);
+}
+
+void LocationsBuilderARM::VisitDiv(HDiv* div) {
+  HandleDivRem(div);
+}
+
+void InstructionCodeGeneratorARM::VisitDiv(HDiv* div) {
+  GenerateDivRem(div);
+}
+
+void LocationsBuilderARM::VisitRem(HRem* rem) {
+  HandleDivRem(rem);
+}
+
+void InstructionCodeGeneratorARM::VisitRem(HRem* rem) {
+  GenerateDivRem(rem);
+}
+
+void LocationsBuilderARM::VisitDivZeroCheck(HDivZeroCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  if (instruction->HasUses()) {
+    locations->SetOut(Location::SameAsFirstInput());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitDivZeroCheck(HDivZeroCheck* instruction) {
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) DivZeroCheckSlowPathARM(instruction);
+  codegen_->AddSlowPath(slow_path);
+
+  Location value = instruction->GetLocations()->InAt(0);
+  if (instruction->GetType() == Primitive::kPrimLong) {
+    __ orrs(IP, value.AsArm().AsRegisterPairLow(),
+            ShifterOperand(value.AsArm().AsRegisterPairHigh()));
+  } else {
+    DCHECK_EQ(instruction->GetType(), Primitive::kPrimInt);
+    __ cmp(value.AsArm().AsCoreRegister(), ShifterOperand(0));
+  }
+  __ b(slow_path->GetEntryLabel(), EQ);
+}
+
+void LocationsBuilderARM::VisitCompare(HCompare* compare) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(compare);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  compare->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitCompare(HCompare* compare) {
+  Label greater, less, done;
+  LocationSummary* locations = compare->GetLocations();
+  Location left = locations->InAt(0);
+  Location right = locations->InAt(1);
+  switch (compare->GetInputType()) {
+    case Primitive::kPrimLong: {
+      __ cmp(left.AsArm().AsRegisterPairHigh(),
+             ShifterOperand(right.AsArm().AsRegisterPairHigh()));
+      __ b(&less, LT);  // Signed compare.
+      __ b(&greater, GT);  // Signed compare.
+      __ cmp(left.AsArm().AsRegisterPairLow(),
+             ShifterOperand(right.AsArm().AsRegisterPairLow()));
+      __ b(&less, CC);  // Unsigned compare.
+      __ b(&greater, HI);  // Unsigned compare.
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+      __ vmovsr(S0, left.AsArm().AsCoreRegister());
+      __ vmovsr(S1, right.AsArm().AsCoreRegister());
+      __ vcmps(S0, S1);
+      __ vmstat();  // Transfer the FP status flags to the ARM flags.
+      // An unordered result means one of the inputs is NaN.
+      __ b(compare->IsGtBias() ? &greater : &less, VS);
+      __ b(&less, LT);
+      __ b(&greater, GT);
+      break;
+
+    case Primitive::kPrimDouble:
+      __ vmovdrr(D0, left.AsArm().AsRegisterPairLow(), left.AsArm().AsRegisterPairHigh());
+      __ vmovdrr(D1, right.AsArm().AsRegisterPairLow(), right.AsArm().AsRegisterPairHigh());
+      __ vcmpd(D0, D1);
+      __ vmstat();  // Transfer the FP status flags to the ARM flags.
+      // An unordered result means one of the inputs is NaN.
+      __ b(compare->IsGtBias() ? &greater : &less, VS);
+      __ b(&less, LT);
+      __ b(&greater, GT);
+      break;
+
+    default:
+      LOG(FATAL) << "Unimplemented compare type " << compare->GetInputType();
+  }
+
+  // The output may alias the inputs, so it is only written once they have been read.
+  Register out = locations->Out().AsArm().AsCoreRegister();
+  __ LoadImmediate(out, 0);
+  __ b(&done);
+  __ Bind(&less);
+  __ LoadImmediate(out, -1);
+  __ b(&done);
+  __ Bind(&greater);
+  __ LoadImmediate(out, 1);
+  __ Bind(&done);
+}
+
+void LocationsBuilderARM::VisitNullCheck(HNullCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  if (instruction->HasUses()) {
+    locations->SetOut(Location::SameAsFirstInput());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitNullCheck(HNullCheck* instruction) {
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) NullCheckSlowPathARM(instruction);
+  codegen_->AddSlowPath(slow_path);
+
+  LocationSummary* locations = instruction->GetLocations();
+  Location obj = locations->InAt(0);
+  DCHECK(!instruction->HasUses() || obj.Equals(locations->Out()));
+
+  __ cmp(obj.AsArm().AsCoreRegister(), ShifterOperand(0));
+  __ b(slow_path->GetEntryLabel(), EQ);
+}
+
+void LocationsBuilderARM::VisitBoundsCheck(HBoundsCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  // The slow path passes the index and the length to the runtime.
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, ArmCoreLocation(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, ArmCoreLocation(calling_convention.GetRegisterAt(1)));
+  if (instruction->HasUses()) {
+    locations->SetOut(Location::SameAsFirstInput());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitBoundsCheck(HBoundsCheck* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) BoundsCheckSlowPathARM(instruction);
+  codegen_->AddSlowPath(slow_path);
+
+  Register index = locations->InAt(0).AsArm().AsCoreRegister();
+  Register length = locations->InAt(1).AsArm().AsCoreRegister();
+
+  // An unsigned compare also catches negative indices.
+  __ cmp(index, ShifterOperand(length));
+  __ b(slow_path->GetEntryLabel(), CS);
+}
+
+void LocationsBuilderARM::VisitArrayLength(HArrayLength* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitArrayLength(HArrayLength* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  uint32_t offset = mirror::Array::LengthOffset().Uint32Value();
+  Register obj = locations->InAt(0).AsArm().AsCoreRegister();
+  Register out = locations->Out().AsArm().AsCoreRegister();
+  __ LoadFromOffset(kLoadWord, out, obj, offset);
+}
+
+void LocationsBuilderARM::VisitInstanceFieldGet(HInstanceFieldGet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitInstanceFieldGet(HInstanceFieldGet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsArm().AsCoreRegister();
+  uint32_t offset = instruction->GetFieldOffset().Uint32Value();
+
+  switch (instruction->GetType()) {
+    case Primitive::kPrimBoolean: {
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ LoadFromOffset(kLoadUnsignedByte, out, obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimByte: {
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ LoadFromOffset(kLoadSignedByte, out, obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimShort: {
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ LoadFromOffset(kLoadSignedHalfword, out, obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimChar: {
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ LoadFromOffset(kLoadUnsignedHalfword, out, obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat: {
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ LoadFromOffset(kLoadWord, out, obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
+      // ldrd reads both words before writing the pair, which may alias the object.
+      Register out = locations->Out().AsArm().AsRegisterPairLow();
+      __ LoadFromOffset(kLoadWordPair, out, obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetType();
+  }
+}
+
+void LocationsBuilderARM::VisitInstanceFieldSet(HInstanceFieldSet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  if (CodeGenerator::StoreNeedsWriteBarrier(instruction->GetFieldType(), instruction->InputAt(1))) {
+    // Temporary registers for the write barrier.
+    locations->AddTemp(Location::RequiresRegister());
+    locations->AddTemp(Location::RequiresRegister());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitInstanceFieldSet(HInstanceFieldSet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsArm().AsCoreRegister();
+  uint32_t offset = instruction->GetFieldOffset().Uint32Value();
+  Location value = locations->InAt(1);
+
+  switch (instruction->GetFieldType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte: {
+      __ StoreToOffset(kStoreByte, value.AsArm().AsCoreRegister(), obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimShort:
+    case Primitive::kPrimChar: {
+      __ StoreToOffset(kStoreHalfword, value.AsArm().AsCoreRegister(), obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimFloat: {
+      __ StoreToOffset(kStoreWord, value.AsArm().AsCoreRegister(), obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimNot: {
+      __ StoreToOffset(kStoreWord, value.AsArm().AsCoreRegister(), obj, offset);
+      if (CodeGenerator::StoreNeedsWriteBarrier(Primitive::kPrimNot, instruction->InputAt(1))) {
+        Register temp = locations->GetTemp(0).AsArm().AsCoreRegister();
+        Register card = locations->GetTemp(1).AsArm().AsCoreRegister();
+        codegen_->MarkGCCard(temp, card, obj, value.AsArm().AsCoreRegister());
+      }
+      break;
+    }
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
+      __ StoreToOffset(kStoreWordPair, value.AsArm().AsRegisterPairLow(), obj, offset);
+      break;
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetFieldType();
+  }
+}
+
+void LocationsBuilderARM::VisitArrayGet(HArrayGet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitArrayGet(HArrayGet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsArm().AsCoreRegister();
+  Register index = locations->InAt(1).AsArm().AsCoreRegister();
+
+  // The address of the element is computed in IP, as the output may alias the inputs.
+  switch (instruction->GetType()) {
+    case Primitive::kPrimBoolean: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint8_t)).Uint32Value();
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ add(IP, obj, ShifterOperand(index));
+      __ LoadFromOffset(kLoadUnsignedByte, out, IP, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimByte: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int8_t)).Uint32Value();
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ add(IP, obj, ShifterOperand(index));
+      __ LoadFromOffset(kLoadSignedByte, out, IP, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimShort: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int16_t)).Uint32Value();
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ add(IP, obj, ShifterOperand(index, LSL, TIMES_2));
+      __ LoadFromOffset(kLoadSignedHalfword, out, IP, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimChar: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint16_t)).Uint32Value();
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ add(IP, obj, ShifterOperand(index, LSL, TIMES_2));
+      __ LoadFromOffset(kLoadUnsignedHalfword, out, IP, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
+      Register out = locations->Out().AsArm().AsCoreRegister();
+      __ add(IP, obj, ShifterOperand(index, LSL, TIMES_4));
+      __ LoadFromOffset(kLoadWord, out, IP, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
+      Register out = locations->Out().AsArm().AsRegisterPairLow();
+      __ add(IP, obj, ShifterOperand(index, LSL, TIMES_8));
+      __ LoadFromOffset(kLoadWordPair, out, IP, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetType();
+  }
+}
+
+void LocationsBuilderARM::VisitArraySet(HArraySet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  if (instruction->GetComponentType() == Primitive::kPrimNot) {
+    // The store, with its type check and write barrier, is done by the runtime.
+    InvokeRuntimeCallingConvention calling_convention;
+    locations->SetInAt(0, ArmCoreLocation(calling_convention.GetRegisterAt(0)));
+    locations->SetInAt(1, ArmCoreLocation(calling_convention.GetRegisterAt(1)));
+    locations->SetInAt(2, ArmCoreLocation(calling_convention.GetRegisterAt(2)));
+  } else {
+    locations->SetInAt(0, Location::RequiresRegister());
+    locations->SetInAt(1, Location::RequiresRegister());
+    locations->SetInAt(2, Location::RequiresRegister());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitArraySet(HArraySet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsArm().AsCoreRegister();
+  Register index = locations->InAt(1).AsArm().AsCoreRegister();
+  Location value = locations->InAt(2);
+
+  switch (instruction->GetComponentType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint8_t)).Uint32Value();
+      __ add(IP, obj, ShifterOperand(index));
+      __ StoreToOffset(kStoreByte, value.AsArm().AsCoreRegister(), IP, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimShort:
+    case Primitive::kPrimChar: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint16_t)).Uint32Value();
+      __ add(IP, obj, ShifterOperand(index, LSL, TIMES_2));
+      __ StoreToOffset(kStoreHalfword, value.AsArm().AsCoreRegister(), IP, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimFloat: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
+      __ add(IP, obj, ShifterOperand(index, LSL, TIMES_4));
+      __ StoreToOffset(kStoreWord, value.AsArm().AsCoreRegister(), IP, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimNot: {
+      int32_t offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pAputObject).Int32Value();
+      __ ldr(LR, Address(TR, offset));
+      __ blx(LR);
+      codegen_->RecordPcInfo(instruction, instruction->GetDexPc());
+      break;
+    }
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
+      __ add(IP, obj, ShifterOperand(index, LSL, TIMES_8));
+      __ StoreToOffset(kStoreWordPair, value.AsArm().AsRegisterPairLow(), IP, data_offset);
+      break;
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetComponentType();
+  }
+}
+
+void LocationsBuilderARM::VisitVectorizedLoop(HVectorizedLoop* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  // The start is the index of the loop, updated in place.
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::Any());
+  for (size_t i = 2, e = instruction->InputCount(); i < e; ++i) {
+    locations->SetInAt(i, instruction->IsArrayInput(i)
+                          ? Location::RequiresRegister()
+                          : Location::Any());
+  }
+  locations->SetOut(Location::SameAsFirstInput());
+  instruction->SetLocations(locations);
+}
+
+static Register LoadCoreRegister(ArmAssembler* assembler, Location location, Register scratch) {
+  if (location.IsRegister()) {
+    return location.AsArm().AsCoreRegister();
+  }
+  assembler->ldr(scratch, Address(SP, location.GetStackIndex()));
+  return scratch;
+}
+
+void InstructionCodeGeneratorARM::VisitVectorizedLoop(HVectorizedLoop* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register index = locations->Out().AsArm().AsCoreRegister();
+  DCHECK_EQ(index, locations->InAt(0).AsArm().AsCoreRegister());
+  size_t component_size = Primitive::ComponentSize(instruction->GetComponentType());
+  uint32_t shift = CTZ(component_size);
+  NeonElementSize size = static_cast<NeonElementSize>(shift);
+  int32_t vector_length = instruction->GetVectorLength();
+  uint32_t data_offset = mirror::Array::DataOffset(component_size).Uint32Value();
+  uint32_t length_offset = mirror::Array::LengthOffset().Uint32Value();
+
+  // Broadcast the loop invariant operands: left to Q2, right to Q3.
+  for (size_t i = 3, e = instruction->InputCount(); i < e; ++i) {
+    if (!instruction->IsArrayInput(i)) {
+      __ vdup(size, (i == 3) ? Q2 : Q3, LoadCoreRegister(GetAssembler(), locations->InAt(i), IP));
+    }
+  }
+
+  // LR holds the index to stop at: it is saved by the frame entry, and not
+  // allocated.
+  Register end = LR;
+  Location bound = locations->InAt(1);
+  __ mov(end, ShifterOperand(LoadCoreRegister(GetAssembler(), bound, IP)));
+
+  Label loop, done;
+  __ cmp(index, ShifterOperand(0));
+  __ b(&done, LT);
+  for (size_t i = 2, e = instruction->InputCount(); i < e; ++i) {
+    if (!instruction->IsArrayInput(i)) {
+      continue;
+    }
+    Register array = locations->InAt(i).AsArm().AsCoreRegister();
+    __ cmp(array, ShifterOperand(0));
+    __ b(&done, EQ);
+    __ LoadFromOffset(kLoadWord, IP, array, length_offset);
+    __ cmp(end, ShifterOperand(IP));
+    __ mov(end, ShifterOperand(IP), GT);
+  }
+  // Only perform whole vectors.
+  __ cmp(end, ShifterOperand(index));
+  __ b(&done, LE);
+  __ sub(end, end, ShifterOperand(index));
+  __ bic(end, end, ShifterOperand(vector_length - 1));
+  __ cmp(end, ShifterOperand(0));
+  __ b(&done, EQ);
+  __ add(end, end, ShifterOperand(index));
+
+  // The address of the elements is computed in IP.
+  __ Bind(&loop);
+  Register destination = locations->InAt(2).AsArm().AsCoreRegister();
+  switch (instruction->GetOperation()) {
+    case HVectorizedLoop::kFill:
+      __ add(IP, destination, ShifterOperand(index, LSL, shift));
+      __ add(IP, IP, ShifterOperand(data_offset));
+      __ vst1(size, Q2, IP);
+      break;
+
+    case HVectorizedLoop::kCopy: {
+      Register source = locations->InAt(3).AsArm().AsCoreRegister();
+      __ add(IP, source, ShifterOperand(index, LSL, shift));
+      __ add(IP, IP, ShifterOperand(data_offset));
+      __ vld1(size, Q0, IP);
+      __ add(IP, destination, ShifterOperand(index, LSL, shift));
+      __ add(IP, IP, ShifterOperand(data_offset));
+      __ vst1(size, Q0, IP);
+      break;
+    }
+
+    case HVectorizedLoop::kAdd:
+    case HVectorizedLoop::kSub:
+    case HVectorizedLoop::kMul: {
+      QRegister left = Q2;
+      if (instruction->IsArrayInput(3)) {
+        Register left_array = locations->InAt(3).AsArm().AsCoreRegister();
+        __ add(IP, left_array, ShifterOperand(index, LSL, shift));
+        __ add(IP, IP, ShifterOperand(data_offset));
+        __ vld1(size, Q0, IP);
+        left = Q0;
+      }
+      QRegister right = Q3;
+      if (instruction->IsArrayInput(4)) {
+        Register right_array = locations->InAt(4).AsArm().AsCoreRegister();
+        __ add(IP, right_array, ShifterOperand(index, LSL, shift));
+        __ add(IP, IP, ShifterOperand(data_offset));
+        __ vld1(size, Q1, IP);
+        right = Q1;
+      }
+      if (instruction->GetOperation() == HVectorizedLoop::kAdd) {
+        __ vaddi(size, Q0, left, right);
+      } else if (instruction->GetOperation() == HVectorizedLoop::kSub) {
+        __ vsubi(size, Q0, left, right);
+      } else {
+        __ vmuli(size, Q0, left, right);
+      }
+      __ add(IP, destination, ShifterOperand(index, LSL, shift));
+      __ add(IP, IP, ShifterOperand(data_offset));
+      __ vst1(size, Q0, IP);
+      break;
+    }
+  }
+  __ add(index, index, ShifterOperand(vector_length));
+  __ cmp(index, ShifterOperand(end));
+  __ b(&loop, LT);
+  __ Bind(&done);
+}
+
+void LocationsBuilderARM::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  HandleInvoke(invoke);
+}
+
+void InstructionCodeGeneratorARM::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  LocationSummary* locations = invoke->GetLocations();
+  Register temp = locations->GetTemp(0).AsArm().AsCoreRegister();
+  Register receiver = locations->InAt(0).AsArm().AsCoreRegister();
+  size_t reference_size = sizeof(mirror::HeapReference<mirror::Object>);
+  uint32_t method_offset = mirror::Array::DataOffset(reference_size).Uint32Value()
+      + invoke->GetVTableIndex() * reference_size;
+
+  // temp = receiver->klass_;
+  __ LoadFromOffset(kLoadWord, temp, receiver, mirror::Object::ClassOffset().Int32Value());
+  // temp = temp->vtable_;
+  __ LoadFromOffset(kLoadWord, temp, temp, mirror::Class::VTableOffset().Int32Value());
+  // temp = temp[vtable_index]
+  __ LoadFromOffset(kLoadWord, temp, temp, method_offset);
+  // LR = temp[offset_of_quick_compiled_code]
+  __ LoadFromOffset(kLoadWord, LR, temp,
+                    mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset().Int32Value());
+  // LR()
+  __ blx(LR);
+
+  codegen_->RecordPcInfo(invoke, invoke->GetDexPc());
+}
+
+void LocationsBuilderARM::VisitInvokeInterface(HInvokeInterface* invoke) {
+  HandleInvoke(invoke);
+  // The method index is passed in the register of the callee method.
+  invoke->GetLocations()->SetTempAt(0, ArmCoreLocation(R0));
+}
+
+void InstructionCodeGeneratorARM::VisitInvokeInterface(HInvokeInterface* invoke) {
+  Register temp = invoke->GetLocations()->GetTemp(0).AsArm().AsCoreRegister();
+  // The trampoline finds the target from the method index, passed where the
+  // target expects its method, and calls it with the arguments in place.
+  __ LoadImmediate(temp, invoke->GetDexMethodIndex());
+  int32_t offset =
+      QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pInvokeInterfaceTrampolineWithAccessCheck).Int32Value();
+  __ ldr(LR, Address(TR, offset));
+  __ blx(LR);
+
+  codegen_->RecordPcInfo(invoke, invoke->GetDexPc());
+}
+
+void LocationsBuilderARM::VisitTemporary(HTemporary* temp) {
+  temp->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorARM::VisitTemporary(HTemporary* temp) {
+  // Nothing to do, this is driven by the code generator.
+}
+
+void LocationsBuilderARM::VisitNewInstance(HNewInstance* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->AddTemp(ArmCoreLocation(calling_convention.GetRegisterAt(0)));
+  locations->AddTemp(ArmCoreLocation(calling_convention.GetRegisterAt(1)));
+  locations->SetOut(ArmCoreLocation(R0));
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitNewInstance(HNewInstance* instruction) {
+  InvokeRuntimeCallingConvention calling_convention;
+  LoadCurrentMethod(calling_convention.GetRegisterAt(1));
+  __ LoadImmediate(calling_convention.GetRegisterAt(0), instruction->GetTypeIndex());
+
+  int32_t offset = QUICK_ENTRYPOINT_OFFSET(kArmWordSize, pAllocObjectWithAccessCheck).Int32Value();
+  __ ldr(LR, Address(TR, offset));
+  __ blx(LR);
+
+  codegen_->RecordPcInfo(instruction, instruction->GetDexPc());
+}
+
+void LocationsBuilderARM::VisitParameterValue(HParameterValue* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  Location location = parameter_visitor_.GetNextLocation(instruction->GetType());
+  if (location.IsStackSlot()) {
+    location = Location::StackSlot(location.GetStackIndex() + codegen_->GetFrameSize());
+  } else if (location.IsDoubleStackSlot()) {
+    location = Location::DoubleStackSlot(location.GetStackIndex() + codegen_->GetFrameSize());
+  }
+  locations->SetOut(location);
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitParameterValue(HParameterValue* instruction) {
+  // Nothing to do, the parameter is already at its location.
+}
+
+void LocationsBuilderARM::VisitNot(HNot* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorARM::VisitNot(HNot* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
   __ eor(locations->Out().AsArm().AsCoreRegister(),
          locations->InAt(0).AsArm().AsCoreRegister(), ShifterOperand(1));
 }
 
 void LocationsBuilderARM::VisitPhi(HPhi* instruction) {
-  LOG(FATAL) << "Unimplemented";
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  for (size_t i = 0, e = instruction->InputCount(); i < e; ++i) {
+    locations->SetInAt(i, Location::Any());
+  }
+  locations->SetOut(Location::Any());
+  instruction->SetLocations(locations);
 }
 
 void InstructionCodeGeneratorARM::VisitPhi(HPhi* instruction) {
-  LOG(FATAL) << "Unimplemented";
+  LOG(FATAL) << "Unreachable";
+}
+
+void LocationsBuilderARM::VisitParallelMove(HParallelMove* instruction) {
+  LOG(FATAL) << "Unreachable";
+}
+
+void InstructionCodeGeneratorARM::VisitParallelMove(HParallelMove* instruction) {
+  codegen_->GetMoveResolver()->EmitNativeCode(instruction);
+}
+
+ArmAssembler* ParallelMoveResolverARM::GetAssembler() const {
+  return codegen_->GetAssembler();
+}
+
+void ParallelMoveResolverARM::EmitMove(size_t index) {
+  MoveOperands* move = moves_.Get(index);
+  Location source = move->GetSource();
+  if (source.IsConstant()) {
+    codegen_->Move(source.GetConstant(), move->GetDestination(), nullptr);
+  } else {
+    codegen_->Move32(move->GetDestination(), source);
+  }
+}
+
+void ParallelMoveResolverARM::Exchange(Register reg, int mem) {
+  __ Mov(IP, reg);
+  __ ldr(reg, Address(SP, mem));
+  __ str(IP, Address(SP, mem));
+}
+
+void ParallelMoveResolverARM::Exchange(int mem1, int mem2) {
+  // IP is the only scratch register, temporarily free R0 for the second value.
+  // The offsets need to take into account the pushed register.
+  __ PushList(1 << R0);
+  __ ldr(R0, Address(SP, mem1 + kArmWordSize));
+  __ ldr(IP, Address(SP, mem2 + kArmWordSize));
+  __ str(R0, Address(SP, mem2 + kArmWordSize));
+  __ str(IP, Address(SP, mem1 + kArmWordSize));
+  __ PopList(1 << R0);
+}
+
+void ParallelMoveResolverARM::EmitSwap(size_t index) {
+  MoveOperands* move = moves_.Get(index);
+  Location source = move->GetSource();
+  Location destination = move->GetDestination();
+
+  if (source.IsRegister() && destination.IsRegister()) {
+    __ Mov(IP, source.AsArm().AsCoreRegister());
+    __ Mov(source.AsArm().AsCoreRegister(), destination.AsArm().AsCoreRegister());
+    __ Mov(destination.AsArm().AsCoreRegister(), IP);
+  } else if (source.IsRegister() && destination.IsStackSlot()) {
+    Exchange(source.AsArm().AsCoreRegister(), destination.GetStackIndex());
+  } else if (source.IsStackSlot() && destination.IsRegister()) {
+    Exchange(destination.AsArm().AsCoreRegister(), source.GetStackIndex());
+  } else if (source.IsStackSlot() && destination.IsStackSlot()) {
+    Exchange(source.GetStackIndex(), destination.GetStackIndex());
+  } else {
+    LOG(FATAL) << "Unimplemented";
+  }
 }
 
 }  // namespace arm
@@ -20,8 +20,10 @@
 #include "utils/x86/managed_register_x86.h"
 
 #include "entrypoints/quick/quick_entrypoints.h"
+#include "gc/accounting/card_table.h"
 #include "mirror/array.h"
 #include "mirror/art_method.h"
+#include "mirror/class.h"
 #include "thread.h"
 
 #define __ reinterpret_cast<X86Assembler*>(GetAssembler())->
@@ -40,7 +42,8 @@ static constexpr int kCurrentMethodStackOffset = 0;
 CodeGeneratorX86::CodeGeneratorX86(HGraph* graph)
     : CodeGenerator(graph, kNumberOfRegIds),
       location_builder_(graph, this),
-      instruction_visitor_(graph, this) {}
+      instruction_visitor_(graph, this),
+      move_resolver_(graph->GetArena(), this) {}
 
 static bool* GetBlockedRegisterPairs(bool* blocked_registers) {
   return blocked_registers + kNumberOfAllocIds;
@@ -49,7 +52,8 @@ static bool* GetBlockedRegisterPairs(bool* blocked_registers) {
 ManagedRegister CodeGeneratorX86::AllocateFreeRegister(Primitive::Type type,
                                                        bool* blocked_registers) const {
   switch (type) {
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       size_t reg = AllocateFreeRegisterInternal(
           GetBlockedRegisterPairs(blocked_registers), kNumberOfRegisterPairs);
       X86ManagedRegister pair =
@@ -64,15 +68,14 @@ ManagedRegister CodeGeneratorX86::AllocateFreeRegister(Primitive::Type type,
     case Primitive::kPrimChar:
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
     case Primitive::kPrimNot: {
+      // Float values are kept in core registers, and moved to an XMM register
+      // by the instructions operating on them.
       size_t reg = AllocateFreeRegisterInternal(blocked_registers, kNumberOfCpuRegisters);
       return X86ManagedRegister::FromCpuRegister(static_cast<Register>(reg));
     }
 
-    case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented register type " << type;
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unreachable type " << type;
   }
@@ -103,10 +106,22 @@ size_t CodeGeneratorX86::GetNumberOfRegisters() const {
   return kNumberOfRegIds;
 }
 
+size_t CodeGeneratorX86::GetNumberOfCoreRegisters() const {
+  return kNumberOfCpuRegisters;
+}
+
+size_t CodeGeneratorX86::FrameEntrySpillSize() const {
+  return kNumberOfPushedRegistersAtEntry * kX86WordSize;
+}
+
 static Location X86CpuLocation(Register reg) {
   return Location::RegisterLocation(X86ManagedRegister::FromCpuRegister(reg));
 }
 
+static Location X86PairLocation(RegisterPair pair) {
+  return Location::RegisterLocation(X86ManagedRegister::FromRegisterPair(pair));
+}
+
 InstructionCodeGeneratorX86::InstructionCodeGeneratorX86(HGraph* graph, CodeGeneratorX86* codegen)
       : HGraphVisitor(graph),
         assembler_(codegen->GetAssembler()),
@@ -117,13 +132,6 @@ void CodeGeneratorX86::GenerateFrameEntry() {
   static const int kFakeReturnRegister = 8;
   core_spill_mask_ |= (1 << kFakeReturnRegister);
 
-  SetFrameSize(RoundUp(
-      (GetGraph()->GetMaximumNumberOfOutVRegs() + GetGraph()->GetNumberOfVRegs()) * kVRegSize
-      + kVRegSize  // filler
-      + kX86WordSize  // Art method
-      + kNumberOfPushedRegistersAtEntry * kX86WordSize,
-      kStackAlignment));
-
   // The return PC has already been pushed on the stack.
   __ subl(ESP, Immediate(GetFrameSize() - kNumberOfPushedRegistersAtEntry * kX86WordSize));
   __ movl(Address(ESP, kCurrentMethodStackOffset), EAX);
@@ -141,37 +149,61 @@ void InstructionCodeGeneratorX86::LoadCurrentMethod(Register reg) {
   __ movl(reg, Address(ESP, kCurrentMethodStackOffset));
 }
 
-int32_t CodeGeneratorX86::GetStackSlot(HLocal* local) const {
-  uint16_t reg_number = local->GetRegNumber();
-  uint16_t number_of_vregs = GetGraph()->GetNumberOfVRegs();
-  uint16_t number_of_in_vregs = GetGraph()->GetNumberOfInVRegs();
-  if (reg_number >= number_of_vregs - number_of_in_vregs) {
-    // Local is a parameter of the method. It is stored in the caller's frame.
-    return GetFrameSize() + kX86WordSize  // ART method
-                          + (reg_number - number_of_vregs + number_of_in_vregs) * kVRegSize;
+void InstructionCodeGeneratorX86::LoadFloatingPoint(XmmRegister destination,
+                                                    Location source,
+                                                    bool is_double) {
+  if (is_double) {
+    if (source.IsRegister()) {
+      // Go through the stack to assemble the two words.
+      __ pushl(source.AsX86().AsRegisterPairHigh());
+      __ pushl(source.AsX86().AsRegisterPairLow());
+      __ movsd(destination, Address(ESP, 0));
+      __ addl(ESP, Immediate(2 * kX86WordSize));
+    } else {
+      DCHECK(source.IsDoubleStackSlot());
+      __ movsd(destination, Address(ESP, source.GetStackIndex()));
+    }
+  } else {
+    if (source.IsRegister()) {
+      __ movd(destination, source.AsX86().AsCpuRegister());
+    } else {
+      DCHECK(source.IsStackSlot());
+      __ movss(destination, Address(ESP, source.GetStackIndex()));
+    }
+  }
+}
+
+void InstructionCodeGeneratorX86::StoreFloatingPoint(Location destination,
+                                                     XmmRegister source,
+                                                     bool is_double) {
+  if (is_double) {
+    __ subl(ESP, Immediate(2 * kX86WordSize));
+    __ movsd(Address(ESP, 0), source);
+    __ popl(destination.AsX86().AsRegisterPairLow());
+    __ popl(destination.AsX86().AsRegisterPairHigh());
   } else {
-    // Local is a temporary in this method. It is stored in this method's frame.
-    return GetFrameSize() - (kNumberOfPushedRegistersAtEntry * kX86WordSize)
-                          - kVRegSize  // filler.
-                          - (number_of_vregs * kVRegSize)
-                          + (reg_number * kVRegSize);
+    __ movd(destination.AsX86().AsCpuRegister(), source);
   }
 }
 
+void InstructionCodeGeneratorX86::MoveFloatingPointResult(HInstruction* instruction) {
+  Primitive::Type type = instruction->GetType();
+  if (type == Primitive::kPrimFloat || type == Primitive::kPrimDouble) {
+    StoreFloatingPoint(instruction->GetLocations()->Out(), XMM0, type == Primitive::kPrimDouble);
+  }
+}
 
 Location CodeGeneratorX86::GetStackLocation(HLoadLocal* load) const {
   switch (load->GetType()) {
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       return Location::DoubleStackSlot(GetStackSlot(load->GetLocal()));
       break;
 
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
-      return Location::StackSlot(GetStackSlot(load->GetLocal()));
-
     case Primitive::kPrimFloat:
-    case Primitive::kPrimDouble:
-      LOG(FATAL) << "Unimplemented type " << load->GetType();
+      return Location::StackSlot(GetStackSlot(load->GetLocal()));
 
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
@@ -199,6 +231,78 @@ class InvokeRuntimeCallingConvention : public CallingConvention<Register> {
   DISALLOW_COPY_AND_ASSIGN(InvokeRuntimeCallingConvention);
 };
 
+#undef __
+#define __ reinterpret_cast<X86Assembler*>(codegen->GetAssembler())->
+
+class NullCheckSlowPathX86 : public SlowPathCode {
+ public:
+  explicit NullCheckSlowPathX86(HNullCheck* instruction) : instruction_(instruction) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pThrowNullPointer)));
+    codegen->RecordPcInfo(instruction_, instruction_->GetDexPc());
+  }
+
+ private:
+  HNullCheck* const instruction_;
+
+  DISALLOW_COPY_AND_ASSIGN(NullCheckSlowPathX86);
+};
+
+class DivZeroCheckSlowPathX86 : public SlowPathCode {
+ public:
+  explicit DivZeroCheckSlowPathX86(HDivZeroCheck* instruction) : instruction_(instruction) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pThrowDivZero)));
+    codegen->RecordPcInfo(instruction_, instruction_->GetDexPc());
+  }
+
+ private:
+  HDivZeroCheck* const instruction_;
+
+  DISALLOW_COPY_AND_ASSIGN(DivZeroCheckSlowPathX86);
+};
+
+class BoundsCheckSlowPathX86 : public SlowPathCode {
+ public:
+  explicit BoundsCheckSlowPathX86(HBoundsCheck* instruction) : instruction_(instruction) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    // The index and the length are already in the registers of the runtime
+    // calling convention.
+    __ Bind(GetEntryLabel());
+    __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pThrowArrayBounds)));
+    codegen->RecordPcInfo(instruction_, instruction_->GetDexPc());
+  }
+
+ private:
+  HBoundsCheck* const instruction_;
+
+  DISALLOW_COPY_AND_ASSIGN(BoundsCheckSlowPathX86);
+};
+
+class DeoptimizationSlowPathX86 : public SlowPathCode {
+ public:
+  explicit DeoptimizationSlowPathX86(HDeoptimize* instruction) : instruction_(instruction) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pDeoptimize)));
+    codegen->RecordPcInfo(instruction_, instruction_->GetDexPc());
+  }
+
+ private:
+  HDeoptimize* const instruction_;
+
+  DISALLOW_COPY_AND_ASSIGN(DeoptimizationSlowPathX86);
+};
+
+#undef __
+#define __ reinterpret_cast<X86Assembler*>(GetAssembler())->
+
 Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type) {
   switch (type) {
     case Primitive::kPrimBoolean:
@@ -206,6 +310,7 @@ Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type
     case Primitive::kPrimChar:
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
     case Primitive::kPrimNot: {
       uint32_t index = gp_index_++;
       if (index < calling_convention.GetNumberOfRegisters()) {
@@ -215,7 +320,8 @@ Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type
       }
     }
 
-    case Primitive::kPrimLong: {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
       uint32_t index = gp_index_;
       gp_index_ += 2;
       if (index + 1 < calling_convention.GetNumberOfRegisters()) {
@@ -228,11 +334,6 @@ Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type
       }
     }
 
-    case Primitive::kPrimDouble:
-    case Primitive::kPrimFloat:
-      LOG(FATAL) << "Unimplemented parameter type " << type;
-      break;
-
     case Primitive::kPrimVoid:
       LOG(FATAL) << "Unexpected parameter type " << type;
       break;
@@ -256,8 +357,9 @@ void CodeGeneratorX86::Move32(Location destination, Location source) {
       __ movl(Address(ESP, destination.GetStackIndex()), source.AsX86().AsCpuRegister());
     } else {
       DCHECK(source.IsStackSlot());
-      __ movl(EAX, Address(ESP, source.GetStackIndex()));
-      __ movl(Address(ESP, destination.GetStackIndex()), EAX);
+      // Go through the stack to not clobber a register.
+      __ pushl(Address(ESP, source.GetStackIndex()));
+      __ popl(Address(ESP, destination.GetStackIndex()));
     }
   }
 }
@@ -268,8 +370,22 @@ void CodeGeneratorX86::Move64(Location destination, Location source) {
   }
   if (destination.IsRegister()) {
     if (source.IsRegister()) {
-      __ movl(destination.AsX86().AsRegisterPairLow(), source.AsX86().AsRegisterPairLow());
-      __ movl(destination.AsX86().AsRegisterPairHigh(), source.AsX86().AsRegisterPairHigh());
+      Register source_low = source.AsX86().AsRegisterPairLow();
+      Register source_high = source.AsX86().AsRegisterPairHigh();
+      Register destination_low = destination.AsX86().AsRegisterPairLow();
+      Register destination_high = destination.AsX86().AsRegisterPairHigh();
+      if (destination_low == source_high) {
+        // Do not overwrite the high word before it is read.
+        if (destination_high == source_low) {
+          __ xchgl(destination_low, destination_high);
+        } else {
+          __ movl(destination_high, source_high);
+          __ movl(destination_low, source_low);
+        }
+      } else {
+        __ movl(destination_low, source_low);
+        __ movl(destination_high, source_high);
+      }
     } else if (source.IsQuickParameter()) {
       uint32_t argument_index = source.GetQuickParameterIndex();
       InvokeDexCallingConvention calling_convention;
@@ -345,10 +461,12 @@ void CodeGeneratorX86::Move(HInstruction* instruction, Location location, HInstr
       case Primitive::kPrimShort:
       case Primitive::kPrimInt:
       case Primitive::kPrimNot:
+      case Primitive::kPrimFloat:
         Move32(location, Location::StackSlot(GetStackSlot(instruction->AsLoadLocal()->GetLocal())));
         break;
 
       case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
         Move64(location, Location::DoubleStackSlot(
             GetStackSlot(instruction->AsLoadLocal()->GetLocal())));
         break;
@@ -358,8 +476,9 @@ void CodeGeneratorX86::Move(HInstruction* instruction, Location location, HInstr
     }
   } else {
     // This can currently only happen when the instruction that requests the move
-    // is the next to be compiled.
-    DCHECK_EQ(instruction->GetNext(), move_for);
+    // is the next to be compiled, or when the value was saved in a temporary.
+    DCHECK((instruction->GetNext() == move_for) ||
+           instruction->GetNext()->AsTemporary() != nullptr);
     switch (instruction->GetType()) {
       case Primitive::kPrimBoolean:
       case Primitive::kPrimByte:
@@ -367,10 +486,12 @@ void CodeGeneratorX86::Move(HInstruction* instruction, Location location, HInstr
       case Primitive::kPrimShort:
       case Primitive::kPrimInt:
       case Primitive::kPrimNot:
+      case Primitive::kPrimFloat:
         Move32(location, instruction->GetLocations()->Out());
         break;
 
       case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
         Move64(location, instruction->GetLocations()->Out());
         break;
 
@@ -380,6 +501,19 @@ void CodeGeneratorX86::Move(HInstruction* instruction, Location location, HInstr
   }
 }
 
+void CodeGeneratorX86::MarkGCCard(Register temp, Register card, Register object, Register value) {
+  Label is_null;
+  __ testl(value, value);
+  __ j(kEqual, &is_null);
+  __ fs()->movl(card, Address::Absolute(Thread::CardTableOffset<kX86WordSize>()));
+  __ movl(temp, object);
+  __ shrl(temp, Immediate(gc::accounting::CardTable::kCardShift));
+  // The card table base is biased so that its low byte is the dirty card value.
+  __ movb(Address(temp, card, TIMES_1, 0),
+          X86ManagedRegister::FromCpuRegister(card).AsByteRegister());
+  __ Bind(&is_null);
+}
+
 void LocationsBuilderX86::VisitGoto(HGoto* got) {
   got->SetLocations(nullptr);
 }
@@ -424,6 +558,26 @@ void InstructionCodeGeneratorX86::VisitIf(HIf* if_instr) {
   }
 }
 
+void LocationsBuilderX86::VisitDeoptimize(HDeoptimize* deoptimize) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(deoptimize);
+  locations->SetInAt(0, Location::Any());
+  deoptimize->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitDeoptimize(HDeoptimize* deoptimize) {
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) DeoptimizationSlowPathX86(deoptimize);
+  codegen_->AddSlowPath(slow_path);
+
+  Location location = deoptimize->GetLocations()->InAt(0);
+  if (location.IsRegister()) {
+    __ cmpl(location.AsX86().AsCpuRegister(), Immediate(0));
+  } else {
+    __ cmpl(Address(ESP, location.GetStackIndex()), Immediate(0));
+  }
+  __ j(kNotEqual, slow_path->GetEntryLabel());
+}
+
 void LocationsBuilderX86::VisitLocal(HLocal* local) {
   local->SetLocations(nullptr);
 }
@@ -449,10 +603,12 @@ void LocationsBuilderX86::VisitStoreLocal(HStoreLocal* store) {
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
       locations->SetInAt(1, Location::StackSlot(codegen_->GetStackSlot(store->GetLocal())));
       break;
 
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       locations->SetInAt(1, Location::DoubleStackSlot(codegen_->GetStackSlot(store->GetLocal())));
       break;
 
@@ -465,16 +621,29 @@ void LocationsBuilderX86::VisitStoreLocal(HStoreLocal* store) {
 void InstructionCodeGeneratorX86::VisitStoreLocal(HStoreLocal* store) {
 }
 
-void LocationsBuilderX86::VisitEqual(HEqual* equal) {
-  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(equal);
+static Condition X86Condition(IfCondition cond) {
+  switch (cond) {
+    case kCondEQ: return kEqual;
+    case kCondNE: return kNotEqual;
+    case kCondLT: return kLess;
+    case kCondLE: return kLessEqual;
+    case kCondGT: return kGreater;
+    case kCondGE: return kGreaterEqual;
+  }
+  LOG(FATAL) << "Unreachable";
+  return kEqual;
+}
+
+void LocationsBuilderX86::HandleCondition(HCondition* condition) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(condition);
   locations->SetInAt(0, Location::RequiresRegister());
   locations->SetInAt(1, Location::Any());
   locations->SetOut(Location::SameAsFirstInput());
-  equal->SetLocations(locations);
+  condition->SetLocations(locations);
 }
 
-void InstructionCodeGeneratorX86::VisitEqual(HEqual* equal) {
-  LocationSummary* locations = equal->GetLocations();
+void InstructionCodeGeneratorX86::HandleCondition(HCondition* condition) {
+  LocationSummary* locations = condition->GetLocations();
   if (locations->InAt(1).IsRegister()) {
     __ cmpl(locations->InAt(0).AsX86().AsCpuRegister(),
             locations->InAt(1).AsX86().AsCpuRegister());
@@ -482,11 +651,64 @@ void InstructionCodeGeneratorX86::VisitEqual(HEqual* equal) {
     __ cmpl(locations->InAt(0).AsX86().AsCpuRegister(),
             Address(ESP, locations->InAt(1).GetStackIndex()));
   }
-  __ setb(kEqual, locations->Out().AsX86().AsCpuRegister());
+  Register out = locations->Out().AsX86().AsCpuRegister();
+  __ setb(X86Condition(condition->GetCondition()), out);
+  // setb only sets the low byte of the register.
+  __ movzxb(out, static_cast<ByteRegister>(out));
+}
+
+void LocationsBuilderX86::VisitEqual(HEqual* equal) {
+  HandleCondition(equal);
+}
+
+void InstructionCodeGeneratorX86::VisitEqual(HEqual* equal) {
+  HandleCondition(equal);
+}
+
+void LocationsBuilderX86::VisitNotEqual(HNotEqual* comp) {
+  HandleCondition(comp);
+}
+
+void InstructionCodeGeneratorX86::VisitNotEqual(HNotEqual* comp) {
+  HandleCondition(comp);
+}
+
+void LocationsBuilderX86::VisitLessThan(HLessThan* comp) {
+  HandleCondition(comp);
+}
+
+void InstructionCodeGeneratorX86::VisitLessThan(HLessThan* comp) {
+  HandleCondition(comp);
+}
+
+void LocationsBuilderX86::VisitLessThanOrEqual(HLessThanOrEqual* comp) {
+  HandleCondition(comp);
+}
+
+void InstructionCodeGeneratorX86::VisitLessThanOrEqual(HLessThanOrEqual* comp) {
+  HandleCondition(comp);
+}
+
+void LocationsBuilderX86::VisitGreaterThan(HGreaterThan* comp) {
+  HandleCondition(comp);
+}
+
+void InstructionCodeGeneratorX86::VisitGreaterThan(HGreaterThan* comp) {
+  HandleCondition(comp);
+}
+
+void LocationsBuilderX86::VisitGreaterThanOrEqual(HGreaterThanOrEqual* comp) {
+  HandleCondition(comp);
+}
+
+void InstructionCodeGeneratorX86::VisitGreaterThanOrEqual(HGreaterThanOrEqual* comp) {
+  HandleCondition(comp);
 }
 
 void LocationsBuilderX86::VisitIntConstant(HIntConstant* constant) {
-  constant->SetLocations(nullptr);
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(constant);
+  locations->SetOut(Location::ConstantLocation(constant));
+  constant->SetLocations(locations);
 }
 
 void InstructionCodeGeneratorX86::VisitIntConstant(HIntConstant* constant) {
@@ -519,10 +741,12 @@ void LocationsBuilderX86::VisitReturn(HReturn* ret) {
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
       locations->SetInAt(0, X86CpuLocation(EAX));
       break;
 
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       locations->SetInAt(
           0, Location::RegisterLocation(X86ManagedRegister::FromRegisterPair(EAX_EDX)));
       break;
@@ -545,7 +769,12 @@ void InstructionCodeGeneratorX86::VisitReturn(HReturn* ret) {
         DCHECK_EQ(ret->GetLocations()->InAt(0).AsX86().AsCpuRegister(), EAX);
         break;
 
+      case Primitive::kPrimFloat:
+        DCHECK_EQ(ret->GetLocations()->InAt(0).AsX86().AsCpuRegister(), EAX);
+        break;
+
       case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
         DCHECK_EQ(ret->GetLocations()->InAt(0).AsX86().AsRegisterPair(), EAX_EDX);
         break;
 
@@ -553,11 +782,20 @@ void InstructionCodeGeneratorX86::VisitReturn(HReturn* ret) {
         LOG(FATAL) << "Unimplemented return type " << ret->InputAt(0)->GetType();
     }
   }
+  Primitive::Type type = ret->InputAt(0)->GetType();
+  if (type == Primitive::kPrimFloat || type == Primitive::kPrimDouble) {
+    // The managed calling convention returns floating point values in XMM0.
+    LoadFloatingPoint(XMM0, ret->GetLocations()->InAt(0), type == Primitive::kPrimDouble);
+  }
   codegen_->GenerateFrameExit();
   __ ret();
 }
 
 void LocationsBuilderX86::VisitInvokeStatic(HInvokeStatic* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderX86::HandleInvoke(HInvoke* invoke) {
   LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(invoke);
   locations->AddTemp(Location::RequiresRegister());
 
@@ -574,20 +812,17 @@ void LocationsBuilderX86::VisitInvokeStatic(HInvokeStatic* invoke) {
     case Primitive::kPrimShort:
     case Primitive::kPrimInt:
     case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
       locations->SetOut(X86CpuLocation(EAX));
       break;
 
     case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
       locations->SetOut(Location::RegisterLocation(X86ManagedRegister::FromRegisterPair(EAX_EDX)));
       break;
 
     case Primitive::kPrimVoid:
       break;
-
-    case Primitive::kPrimDouble:
-    case Primitive::kPrimFloat:
-      LOG(FATAL) << "Unimplemented return type " << invoke->GetType();
-      break;
   }
 
   invoke->SetLocations(locations);
@@ -614,7 +849,8 @@ void InstructionCodeGeneratorX86::VisitInvokeStatic(HInvokeStatic* invoke) {
   // (temp + offset_of_quick_compiled_code)()
   __ call(Address(temp, mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset().Int32Value()));
 
-  codegen_->RecordPcInfo(invoke->GetDexPc());
+  codegen_->RecordPcInfo(invoke, invoke->GetDexPc());
+  MoveFloatingPointResult(invoke);
 }
 
 void LocationsBuilderX86::VisitAdd(HAdd* add) {
@@ -628,6 +864,14 @@ void LocationsBuilderX86::VisitAdd(HAdd* add) {
       break;
     }
 
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::Any());
+      locations->SetInAt(1, Location::Any());
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
     case Primitive::kPrimChar:
@@ -674,6 +918,20 @@ void InstructionCodeGeneratorX86::VisitAdd(HAdd* add) {
       break;
     }
 
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      bool is_double = add->GetResultType() == Primitive::kPrimDouble;
+      LoadFloatingPoint(XMM0, locations->InAt(0), is_double);
+      LoadFloatingPoint(XMM1, locations->InAt(1), is_double);
+      if (is_double) {
+        __ addsd(XMM0, XMM1);
+      } else {
+        __ addss(XMM0, XMM1);
+      }
+      StoreFloatingPoint(locations->Out(), XMM0, is_double);
+      break;
+    }
+
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
     case Primitive::kPrimChar:
@@ -697,6 +955,14 @@ void LocationsBuilderX86::VisitSub(HSub* sub) {
       break;
     }
 
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::Any());
+      locations->SetInAt(1, Location::Any());
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
     case Primitive::kPrimChar:
@@ -743,6 +1009,20 @@ void InstructionCodeGeneratorX86::VisitSub(HSub* sub) {
       break;
     }
 
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      bool is_double = sub->GetResultType() == Primitive::kPrimDouble;
+      LoadFloatingPoint(XMM0, locations->InAt(0), is_double);
+      LoadFloatingPoint(XMM1, locations->InAt(1), is_double);
+      if (is_double) {
+        __ subsd(XMM0, XMM1);
+      } else {
+        __ subss(XMM0, XMM1);
+      }
+      StoreFloatingPoint(locations->Out(), XMM0, is_double);
+      break;
+    }
+
     case Primitive::kPrimBoolean:
     case Primitive::kPrimByte:
     case Primitive::kPrimChar:
@@ -772,7 +1052,7 @@ void InstructionCodeGeneratorX86::VisitNewInstance(HNewInstance* instruction) {
   __ fs()->call(
       Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pAllocObjectWithAccessCheck)));
 
-  codegen_->RecordPcInfo(instruction->GetDexPc());
+  codegen_->RecordPcInfo(instruction, instruction->GetDexPc());
 }
 
 void LocationsBuilderX86::VisitParameterValue(HParameterValue* instruction) {
@@ -805,12 +1085,887 @@ void InstructionCodeGeneratorX86::VisitNot(HNot* instruction) {
   __ xorl(out.AsX86().AsCpuRegister(), Immediate(1));
 }
 
-void LocationsBuilderX86::VisitPhi(HPhi* instruction) {
-  LOG(FATAL) << "Unimplemented";
+void LocationsBuilderX86::VisitMul(HMul* mul) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(mul);
+  switch (mul->GetResultType()) {
+    case Primitive::kPrimInt: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::Any());
+      locations->SetOut(Location::SameAsFirstInput());
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      // The multiplication is done by the runtime.
+      locations->SetInAt(0, X86PairLocation(EAX_ECX));
+      locations->SetInAt(1, X86PairLocation(EDX_EBX));
+      locations->SetOut(X86PairLocation(EAX_EDX));
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::Any());
+      locations->SetInAt(1, Location::Any());
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected mul type " << mul->GetResultType();
+  }
+  mul->SetLocations(locations);
 }
 
-void InstructionCodeGeneratorX86::VisitPhi(HPhi* instruction) {
-  LOG(FATAL) << "Unimplemented";
+void InstructionCodeGeneratorX86::VisitMul(HMul* mul) {
+  LocationSummary* locations = mul->GetLocations();
+  switch (mul->GetResultType()) {
+    case Primitive::kPrimInt: {
+      DCHECK_EQ(locations->InAt(0).AsX86().AsCpuRegister(),
+                locations->Out().AsX86().AsCpuRegister());
+      if (locations->InAt(1).IsRegister()) {
+        __ imull(locations->InAt(0).AsX86().AsCpuRegister(),
+                 locations->InAt(1).AsX86().AsCpuRegister());
+      } else {
+        __ imull(locations->InAt(0).AsX86().AsCpuRegister(),
+                 Address(ESP, locations->InAt(1).GetStackIndex()));
+      }
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pLmul)));
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      bool is_double = mul->GetResultType() == Primitive::kPrimDouble;
+      LoadFloatingPoint(XMM0, locations->InAt(0), is_double);
+      LoadFloatingPoint(XMM1, locations->InAt(1), is_double);
+      if (is_double) {
+        __ mulsd(XMM0, XMM1);
+      } else {
+        __ mulss(XMM0, XMM1);
+      }
+      StoreFloatingPoint(locations->Out(), XMM0, is_double);
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected mul type " << mul->GetResultType();
+  }
+}
+
+void LocationsBuilderX86::HandleDivRem(HBinaryOperation* instruction) {
+  bool is_div = instruction->AsDiv() != nullptr;
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  switch (instruction->GetResultType()) {
+    case Primitive::kPrimInt: {
+      // idivl divides EDX:EAX, and puts the quotient in EAX and the remainder in EDX.
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::RequiresRegister());
+      locations->AddTemp(X86CpuLocation(EAX));
+      locations->AddTemp(X86CpuLocation(EDX));
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      // The division is done by the runtime.
+      locations->SetInAt(0, X86PairLocation(EAX_ECX));
+      locations->SetInAt(1, X86PairLocation(EDX_EBX));
+      locations->SetOut(X86PairLocation(EAX_EDX));
+      break;
+    }
+
+    case Primitive::kPrimFloat: {
+      if (is_div) {
+        locations->SetInAt(0, Location::Any());
+        locations->SetInAt(1, Location::Any());
+      } else {
+        // The remainder is computed by the runtime.
+        InvokeRuntimeCallingConvention calling_convention;
+        locations->SetInAt(0, X86CpuLocation(calling_convention.GetRegisterAt(0)));
+        locations->SetInAt(1, X86CpuLocation(calling_convention.GetRegisterAt(1)));
+      }
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
+    case Primitive::kPrimDouble: {
+      if (is_div) {
+        locations->SetInAt(0, Location::Any());
+        locations->SetInAt(1, Location::Any());
+      } else {
+        // The remainder is computed by the runtime.
+        locations->SetInAt(0, X86PairLocation(EAX_ECX));
+        locations->SetInAt(1, X86PairLocation(EDX_EBX));
+      }
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected div type " << instruction->GetResultType();
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::GenerateDivRem(HBinaryOperation* instruction) {
+  bool is_div = instruction->AsDiv() != nullptr;
+  LocationSummary* locations = instruction->GetLocations();
+  switch (instruction->GetResultType()) {
+    case Primitive::kPrimInt: {
+      Register first = locations->InAt(0).AsX86().AsCpuRegister();
+      Register second = locations->InAt(1).AsX86().AsCpuRegister();
+      DCHECK_EQ(EAX, locations->GetTemp(0).AsX86().AsCpuRegister());
+      DCHECK_EQ(EDX, locations->GetTemp(1).AsX86().AsCpuRegister());
+      Label not_minus_one;
+      Label done;
+      __ movl(EAX, first);
+      // idivl faults on kMinInt / -1, whose quotient is kMinInt and remainder is 0.
+      __ cmpl(second, Immediate(-1));
+      __ j(kNotEqual, &not_minus_one);
+      if (is_div) {
+        __ negl(EAX);
+      } else {
+        __ xorl(EDX, EDX);
+      }
+      __ jmp(&done);
+      __ Bind(&not_minus_one);
+      __ cdq();
+      __ idivl(second);
+      __ Bind(&done);
+      __ movl(locations->Out().AsX86().AsCpuRegister(), is_div ? EAX : EDX);
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      if (is_div) {
+        __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pLdiv)));
+      } else {
+        __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pLmod)));
+      }
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      bool is_double = instruction->GetResultType() == Primitive::kPrimDouble;
+      if (is_div) {
+        LoadFloatingPoint(XMM0, locations->InAt(0), is_double);
+        LoadFloatingPoint(XMM1, locations->InAt(1), is_double);
+        if (is_double) {
+          __ divsd(XMM0, XMM1);
+        } else {
+          __ divss(XMM0, XMM1);
+        }
+      } else if (is_double) {
+        __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pFmod)));
+      } else {
+        __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pFmodf)));
+      }
+      StoreFloatingPoint(locations->Out(), XMM0, is_double);
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected div type " << instruction->GetResultType();
+  }
+}
+
+void LocationsBuilderX86::VisitDiv(HDiv* div) {
+  HandleDivRem(div);
+}
+
+void InstructionCodeGeneratorX86::VisitDiv(HDiv* div) {
+  GenerateDivRem(div);
+}
+
+void LocationsBuilderX86::VisitRem(HRem* rem) {
+  HandleDivRem(rem);
+}
+
+void InstructionCodeGeneratorX86::VisitRem(HRem* rem) {
+  GenerateDivRem(rem);
+}
+
+void LocationsBuilderX86::VisitDivZeroCheck(HDivZeroCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::Any());
+  if (instruction->HasUses()) {
+    locations->SetOut(Location::SameAsFirstInput());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitDivZeroCheck(HDivZeroCheck* instruction) {
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) DivZeroCheckSlowPathX86(instruction);
+  codegen_->AddSlowPath(slow_path);
+
+  LocationSummary* locations = instruction->GetLocations();
+  Location value = locations->InAt(0);
+
+  if (instruction->GetType() == Primitive::kPrimLong) {
+    Label not_zero;
+    if (value.IsRegister()) {
+      __ testl(value.AsX86().AsRegisterPairLow(), value.AsX86().AsRegisterPairLow());
+      __ j(kNotEqual, &not_zero);
+      __ testl(value.AsX86().AsRegisterPairHigh(), value.AsX86().AsRegisterPairHigh());
+    } else {
+      DCHECK(value.IsDoubleStackSlot());
+      __ cmpl(Address(ESP, value.GetStackIndex()), Immediate(0));
+      __ j(kNotEqual, &not_zero);
+      __ cmpl(Address(ESP, value.GetHighStackIndex(kX86WordSize)), Immediate(0));
+    }
+    __ j(kEqual, slow_path->GetEntryLabel());
+    __ Bind(&not_zero);
+  } else {
+    DCHECK_EQ(instruction->GetType(), Primitive::kPrimInt);
+    if (value.IsRegister()) {
+      __ testl(value.AsX86().AsCpuRegister(), value.AsX86().AsCpuRegister());
+    } else {
+      DCHECK(value.IsStackSlot());
+      __ cmpl(Address(ESP, value.GetStackIndex()), Immediate(0));
+    }
+    __ j(kEqual, slow_path->GetEntryLabel());
+  }
+}
+
+void LocationsBuilderX86::VisitCompare(HCompare* compare) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(compare);
+  if (compare->GetInputType() == Primitive::kPrimLong) {
+    locations->SetInAt(0, Location::RequiresRegister());
+  } else {
+    locations->SetInAt(0, Location::Any());
+  }
+  locations->SetInAt(1, Location::Any());
+  locations->SetOut(Location::RequiresRegister());
+  compare->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitCompare(HCompare* compare) {
+  Label greater, less, done;
+  LocationSummary* locations = compare->GetLocations();
+  Location left = locations->InAt(0);
+  Location right = locations->InAt(1);
+  switch (compare->GetInputType()) {
+    case Primitive::kPrimLong: {
+      Register left_low = left.AsX86().AsRegisterPairLow();
+      Register left_high = left.AsX86().AsRegisterPairHigh();
+      if (right.IsRegister()) {
+        __ cmpl(left_high, right.AsX86().AsRegisterPairHigh());
+      } else {
+        DCHECK(right.IsDoubleStackSlot());
+        __ cmpl(left_high, Address(ESP, right.GetHighStackIndex(kX86WordSize)));
+      }
+      __ j(kLess, &less);  // Signed compare.
+      __ j(kGreater, &greater);  // Signed compare.
+      if (right.IsRegister()) {
+        __ cmpl(left_low, right.AsX86().AsRegisterPairLow());
+      } else {
+        __ cmpl(left_low, Address(ESP, right.GetStackIndex()));
+      }
+      __ j(kBelow, &less);  // Unsigned compare.
+      __ j(kAbove, &greater);  // Unsigned compare.
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      bool is_double = compare->GetInputType() == Primitive::kPrimDouble;
+      LoadFloatingPoint(XMM0, left, is_double);
+      LoadFloatingPoint(XMM1, right, is_double);
+      if (is_double) {
+        __ comisd(XMM0, XMM1);
+      } else {
+        __ comiss(XMM0, XMM1);
+      }
+      // An unordered result means one of the inputs is NaN.
+      __ j(kParityEven, compare->IsGtBias() ? &greater : &less);
+      __ j(kBelow, &less);
+      __ j(kAbove, &greater);
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unimplemented compare type " << compare->GetInputType();
+  }
+
+  // The output may alias the inputs, so it is only written once they have been read.
+  Register out = locations->Out().AsX86().AsCpuRegister();
+  __ movl(out, Immediate(0));
+  __ jmp(&done);
+  __ Bind(&less);
+  __ movl(out, Immediate(-1));
+  __ jmp(&done);
+  __ Bind(&greater);
+  __ movl(out, Immediate(1));
+  __ Bind(&done);
+}
+
+void LocationsBuilderX86::VisitNullCheck(HNullCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::Any());
+  if (instruction->HasUses()) {
+    locations->SetOut(Location::SameAsFirstInput());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitNullCheck(HNullCheck* instruction) {
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) NullCheckSlowPathX86(instruction);
+  codegen_->AddSlowPath(slow_path);
+
+  LocationSummary* locations = instruction->GetLocations();
+  Location obj = locations->InAt(0);
+  DCHECK(!instruction->HasUses() || obj.Equals(locations->Out()));
+
+  if (obj.IsRegister()) {
+    __ cmpl(obj.AsX86().AsCpuRegister(), Immediate(0));
+  } else {
+    DCHECK(obj.IsStackSlot());
+    __ cmpl(Address(ESP, obj.GetStackIndex()), Immediate(0));
+  }
+  __ j(kEqual, slow_path->GetEntryLabel());
+}
+
+void LocationsBuilderX86::VisitBoundsCheck(HBoundsCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  // The slow path passes the index and the length to the runtime.
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, X86CpuLocation(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, X86CpuLocation(calling_convention.GetRegisterAt(1)));
+  if (instruction->HasUses()) {
+    locations->SetOut(Location::SameAsFirstInput());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitBoundsCheck(HBoundsCheck* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) BoundsCheckSlowPathX86(instruction);
+  codegen_->AddSlowPath(slow_path);
+
+  Register index = locations->InAt(0).AsX86().AsCpuRegister();
+  Register length = locations->InAt(1).AsX86().AsCpuRegister();
+
+  // An unsigned compare also catches negative indices.
+  __ cmpl(index, length);
+  __ j(kAboveEqual, slow_path->GetEntryLabel());
+}
+
+void LocationsBuilderX86::VisitArrayLength(HArrayLength* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitArrayLength(HArrayLength* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  uint32_t offset = mirror::Array::LengthOffset().Uint32Value();
+  Register obj = locations->InAt(0).AsX86().AsCpuRegister();
+  Register out = locations->Out().AsX86().AsCpuRegister();
+  __ movl(out, Address(obj, offset));
+}
+
+void LocationsBuilderX86::VisitInstanceFieldGet(HInstanceFieldGet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitInstanceFieldGet(HInstanceFieldGet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsX86().AsCpuRegister();
+  uint32_t offset = instruction->GetFieldOffset().Uint32Value();
+
+  switch (instruction->GetType()) {
+    case Primitive::kPrimBoolean: {
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movzxb(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimByte: {
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movsxb(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimShort: {
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movsxw(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimChar: {
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movzxw(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat: {
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movl(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
+      Register out_low = locations->Out().AsX86().AsRegisterPairLow();
+      Register out_high = locations->Out().AsX86().AsRegisterPairHigh();
+      // The output may alias the object: load the word that overwrites it last.
+      if (out_low == obj) {
+        __ movl(out_high, Address(obj, kX86WordSize + offset));
+        __ movl(out_low, Address(obj, offset));
+      } else {
+        __ movl(out_low, Address(obj, offset));
+        __ movl(out_high, Address(obj, kX86WordSize + offset));
+      }
+      break;
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetType();
+  }
+}
+
+void LocationsBuilderX86::VisitInstanceFieldSet(HInstanceFieldSet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  if (CodeGenerator::StoreNeedsWriteBarrier(instruction->GetFieldType(), instruction->InputAt(1))) {
+    // Temporary registers for the write barrier.
+    locations->AddTemp(Location::RequiresRegister());
+    locations->AddTemp(Location::RequiresRegister());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitInstanceFieldSet(HInstanceFieldSet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsX86().AsCpuRegister();
+  uint32_t offset = instruction->GetFieldOffset().Uint32Value();
+  Location value = locations->InAt(1);
+
+  switch (instruction->GetFieldType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte: {
+      __ movb(Address(obj, offset), value.AsX86().AsByteRegister());
+      break;
+    }
+
+    case Primitive::kPrimShort:
+    case Primitive::kPrimChar: {
+      __ movw(Address(obj, offset), value.AsX86().AsCpuRegister());
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimFloat: {
+      __ movl(Address(obj, offset), value.AsX86().AsCpuRegister());
+      break;
+    }
+
+    case Primitive::kPrimNot: {
+      __ movl(Address(obj, offset), value.AsX86().AsCpuRegister());
+      if (CodeGenerator::StoreNeedsWriteBarrier(Primitive::kPrimNot, instruction->InputAt(1))) {
+        Register temp = locations->GetTemp(0).AsX86().AsCpuRegister();
+        Register card = locations->GetTemp(1).AsX86().AsCpuRegister();
+        codegen_->MarkGCCard(temp, card, obj, value.AsX86().AsCpuRegister());
+      }
+      break;
+    }
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
+      __ movl(Address(obj, offset), value.AsX86().AsRegisterPairLow());
+      __ movl(Address(obj, kX86WordSize + offset), value.AsX86().AsRegisterPairHigh());
+      break;
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetFieldType();
+  }
+}
+
+void LocationsBuilderX86::VisitArrayGet(HArrayGet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitArrayGet(HArrayGet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsX86().AsCpuRegister();
+  Register index = locations->InAt(1).AsX86().AsCpuRegister();
+
+  switch (instruction->GetType()) {
+    case Primitive::kPrimBoolean: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint8_t)).Uint32Value();
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movzxb(out, Address(obj, index, TIMES_1, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimByte: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int8_t)).Uint32Value();
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movsxb(out, Address(obj, index, TIMES_1, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimShort: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int16_t)).Uint32Value();
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movsxw(out, Address(obj, index, TIMES_2, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimChar: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint16_t)).Uint32Value();
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movzxw(out, Address(obj, index, TIMES_2, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
+      Register out = locations->Out().AsX86().AsCpuRegister();
+      __ movl(out, Address(obj, index, TIMES_4, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
+      // Load the two words at once: the output pair may alias both the array
+      // and the index.
+      __ movsd(XMM0, Address(obj, index, TIMES_8, data_offset));
+      StoreFloatingPoint(locations->Out(), XMM0, true);
+      break;
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetType();
+  }
+}
+
+void LocationsBuilderX86::VisitArraySet(HArraySet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  if (instruction->GetComponentType() == Primitive::kPrimNot) {
+    // The store, with its type check and write barrier, is done by the runtime.
+    InvokeRuntimeCallingConvention calling_convention;
+    locations->SetInAt(0, X86CpuLocation(calling_convention.GetRegisterAt(0)));
+    locations->SetInAt(1, X86CpuLocation(calling_convention.GetRegisterAt(1)));
+    locations->SetInAt(2, X86CpuLocation(calling_convention.GetRegisterAt(2)));
+  } else {
+    locations->SetInAt(0, Location::RequiresRegister());
+    locations->SetInAt(1, Location::RequiresRegister());
+    locations->SetInAt(2, Location::RequiresRegister());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitArraySet(HArraySet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register obj = locations->InAt(0).AsX86().AsCpuRegister();
+  Register index = locations->InAt(1).AsX86().AsCpuRegister();
+  Location value = locations->InAt(2);
+
+  switch (instruction->GetComponentType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint8_t)).Uint32Value();
+      __ movb(Address(obj, index, TIMES_1, data_offset), value.AsX86().AsByteRegister());
+      break;
+    }
+
+    case Primitive::kPrimShort:
+    case Primitive::kPrimChar: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint16_t)).Uint32Value();
+      __ movw(Address(obj, index, TIMES_2, data_offset), value.AsX86().AsCpuRegister());
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimFloat: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
+      __ movl(Address(obj, index, TIMES_4, data_offset), value.AsX86().AsCpuRegister());
+      break;
+    }
+
+    case Primitive::kPrimNot: {
+      __ fs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pAputObject)));
+      codegen_->RecordPcInfo(instruction, instruction->GetDexPc());
+      break;
+    }
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
+      __ movl(Address(obj, index, TIMES_8, data_offset), value.AsX86().AsRegisterPairLow());
+      __ movl(Address(obj, index, TIMES_8, data_offset + kX86WordSize),
+              value.AsX86().AsRegisterPairHigh());
+      break;
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetComponentType();
+  }
+}
+
+void LocationsBuilderX86::VisitVectorizedLoop(HVectorizedLoop* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  // The start is the index of the loop, updated in place.
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::Any());
+  for (size_t i = 2, e = instruction->InputCount(); i < e; ++i) {
+    locations->SetInAt(i, instruction->IsArrayInput(i)
+                          ? Location::RequiresRegister()
+                          : Location::Any());
+  }
+  locations->SetOut(Location::SameAsFirstInput());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitVectorizedLoop(HVectorizedLoop* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  Register index = locations->Out().AsX86().AsCpuRegister();
+  DCHECK_EQ(index, locations->InAt(0).AsX86().AsCpuRegister());
+  size_t component_size = Primitive::ComponentSize(instruction->GetComponentType());
+  int32_t vector_length = instruction->GetVectorLength();
+  ScaleFactor scale = static_cast<ScaleFactor>(CTZ(component_size));
+  uint32_t data_offset = mirror::Array::DataOffset(component_size).Uint32Value();
+  uint32_t length_offset = mirror::Array::LengthOffset().Uint32Value();
+
+  // Broadcast the loop invariant operands: left to XMM2, right to XMM3.
+  for (size_t i = 3, e = instruction->InputCount(); i < e; ++i) {
+    if (instruction->IsArrayInput(i)) {
+      continue;
+    }
+    XmmRegister vector = (i == 3) ? XMM2 : XMM3;
+    LoadFloatingPoint(vector, locations->InAt(i), false);
+    if (component_size == 1) {
+      __ punpcklbw(vector, vector);
+    }
+    if (component_size <= 2) {
+      __ punpcklwd(vector, vector);
+    }
+    __ pshufd(vector, vector, Immediate(0));
+  }
+
+  // ESI holds the index to stop at. It is not allocated, but must be preserved
+  // for the caller.
+  Register end = ESI;
+  __ pushl(end);
+  Location bound = locations->InAt(1);
+  if (bound.IsRegister()) {
+    __ movl(end, bound.AsX86().AsCpuRegister());
+  } else {
+    __ movl(end, Address(ESP, bound.GetStackIndex() + kX86WordSize));
+  }
+
+  Label loop, done;
+  __ cmpl(index, Immediate(0));
+  __ j(kLess, &done);
+  for (size_t i = 2, e = instruction->InputCount(); i < e; ++i) {
+    if (!instruction->IsArrayInput(i)) {
+      continue;
+    }
+    Register array = locations->InAt(i).AsX86().AsCpuRegister();
+    Label in_bounds;
+    __ testl(array, array);
+    __ j(kEqual, &done);
+    __ cmpl(end, Address(array, length_offset));
+    __ j(kLessEqual, &in_bounds);
+    __ movl(end, Address(array, length_offset));
+    __ Bind(&in_bounds);
+  }
+  // Only perform whole vectors.
+  __ cmpl(end, index);
+  __ j(kLessEqual, &done);
+  __ subl(end, index);
+  __ andl(end, Immediate(-vector_length));
+  __ j(kEqual, &done);
+  __ addl(end, index);
+
+  __ Bind(&loop);
+  Register destination = locations->InAt(2).AsX86().AsCpuRegister();
+  switch (instruction->GetOperation()) {
+    case HVectorizedLoop::kFill:
+      __ movdqu(Address(destination, index, scale, data_offset), XMM2);
+      break;
+
+    case HVectorizedLoop::kCopy: {
+      Register source = locations->InAt(3).AsX86().AsCpuRegister();
+      __ movdqu(XMM0, Address(source, index, scale, data_offset));
+      __ movdqu(Address(destination, index, scale, data_offset), XMM0);
+      break;
+    }
+
+    case HVectorizedLoop::kAdd:
+    case HVectorizedLoop::kSub:
+    case HVectorizedLoop::kMul: {
+      if (instruction->IsArrayInput(3)) {
+        Register left = locations->InAt(3).AsX86().AsCpuRegister();
+        __ movdqu(XMM0, Address(left, index, scale, data_offset));
+      } else {
+        __ movdqa(XMM0, XMM2);
+      }
+      XmmRegister right = XMM3;
+      if (instruction->IsArrayInput(4)) {
+        Register right_array = locations->InAt(4).AsX86().AsCpuRegister();
+        __ movdqu(XMM1, Address(right_array, index, scale, data_offset));
+        right = XMM1;
+      }
+      if (instruction->GetOperation() == HVectorizedLoop::kAdd) {
+        __ paddd(XMM0, right);
+      } else if (instruction->GetOperation() == HVectorizedLoop::kSub) {
+        __ psubd(XMM0, right);
+      } else {
+        __ pmulld(XMM0, right);
+      }
+      __ movdqu(Address(destination, index, scale, data_offset), XMM0);
+      break;
+    }
+  }
+  __ addl(index, Immediate(vector_length));
+  __ cmpl(index, end);
+  __ j(kLess, &loop);
+
+  __ Bind(&done);
+  __ popl(end);
+}
+
+void LocationsBuilderX86::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  HandleInvoke(invoke);
+}
+
+void InstructionCodeGeneratorX86::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  LocationSummary* locations = invoke->GetLocations();
+  Register temp = locations->GetTemp(0).AsX86().AsCpuRegister();
+  Register receiver = locations->InAt(0).AsX86().AsCpuRegister();
+  size_t reference_size = sizeof(mirror::HeapReference<mirror::Object>);
+  uint32_t method_offset = mirror::Array::DataOffset(reference_size).Uint32Value()
+      + invoke->GetVTableIndex() * reference_size;
+
+  // temp = receiver->klass_;
+  __ movl(temp, Address(receiver, mirror::Object::ClassOffset().Int32Value()));
+  // temp = temp->vtable_;
+  __ movl(temp, Address(temp, mirror::Class::VTableOffset().Int32Value()));
+  // temp = temp[vtable_index]
+  __ movl(temp, Address(temp, method_offset));
+  // (temp + offset_of_quick_compiled_code)()
+  __ call(Address(temp, mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset().Int32Value()));
+
+  codegen_->RecordPcInfo(invoke, invoke->GetDexPc());
+  MoveFloatingPointResult(invoke);
+}
+
+void LocationsBuilderX86::VisitInvokeInterface(HInvokeInterface* invoke) {
+  HandleInvoke(invoke);
+  // The method index is passed in the register of the callee method.
+  invoke->GetLocations()->SetTempAt(0, X86CpuLocation(EAX));
+}
+
+void InstructionCodeGeneratorX86::VisitInvokeInterface(HInvokeInterface* invoke) {
+  Register temp = invoke->GetLocations()->GetTemp(0).AsX86().AsCpuRegister();
+  // The trampoline finds the target from the method index, passed where the
+  // target expects its method, and calls it with the arguments in place.
+  __ movl(temp, Immediate(invoke->GetDexMethodIndex()));
+  __ fs()->call(Address::Absolute(
+      QUICK_ENTRYPOINT_OFFSET(kX86WordSize, pInvokeInterfaceTrampolineWithAccessCheck)));
+
+  codegen_->RecordPcInfo(invoke, invoke->GetDexPc());
+  MoveFloatingPointResult(invoke);
+}
+
+void LocationsBuilderX86::VisitTemporary(HTemporary* temp) {
+  temp->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorX86::VisitTemporary(HTemporary* temp) {
+  // Nothing to do, this is driven by the code generator.
+}
+
+void LocationsBuilderX86::VisitPhi(HPhi* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  for (size_t i = 0, e = instruction->InputCount(); i < e; ++i) {
+    locations->SetInAt(i, Location::Any());
+  }
+  locations->SetOut(Location::Any());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86::VisitPhi(HPhi* instruction) {
+  LOG(FATAL) << "Unreachable";
+}
+
+void LocationsBuilderX86::VisitParallelMove(HParallelMove* instruction) {
+  LOG(FATAL) << "Unreachable";
+}
+
+void InstructionCodeGeneratorX86::VisitParallelMove(HParallelMove* instruction) {
+  codegen_->GetMoveResolver()->EmitNativeCode(instruction);
+}
+
+X86Assembler* ParallelMoveResolverX86::GetAssembler() const {
+  return codegen_->GetAssembler();
+}
+
+void ParallelMoveResolverX86::EmitMove(size_t index) {
+  MoveOperands* move = moves_.Get(index);
+  Location source = move->GetSource();
+  if (source.IsConstant()) {
+    codegen_->Move(source.GetConstant(), move->GetDestination(), nullptr);
+  } else {
+    codegen_->Move32(move->GetDestination(), source);
+  }
+}
+
+void ParallelMoveResolverX86::Exchange(Register reg, int mem) {
+  __ xchgl(reg, Address(ESP, mem));
+}
+
+void ParallelMoveResolverX86::Exchange(int mem1, int mem2) {
+  // Go through the stack to not clobber a register. Addresses that are computed
+  // after a push or before a pop need to take into account the pushed words.
+  __ pushl(Address(ESP, mem1));
+  __ pushl(Address(ESP, mem2 + kX86WordSize));
+  __ popl(Address(ESP, mem1 + kX86WordSize));
+  __ popl(Address(ESP, mem2));
+}
+
+void ParallelMoveResolverX86::EmitSwap(size_t index) {
+  MoveOperands* move = moves_.Get(index);
+  Location source = move->GetSource();
+  Location destination = move->GetDestination();
+
+  if (source.IsRegister() && destination.IsRegister()) {
+    __ xchgl(destination.AsX86().AsCpuRegister(), source.AsX86().AsCpuRegister());
+  } else if (source.IsRegister() && destination.IsStackSlot()) {
+    Exchange(source.AsX86().AsCpuRegister(), destination.GetStackIndex());
+  } else if (source.IsStackSlot() && destination.IsRegister()) {
+    Exchange(destination.AsX86().AsCpuRegister(), source.GetStackIndex());
+  } else if (source.IsStackSlot() && destination.IsStackSlot()) {
+    Exchange(destination.GetStackIndex(), source.GetStackIndex());
+  } else {
+    LOG(FATAL) << "Unimplemented";
+  }
 }
 
 }  // namespace x86
@@ -19,6 +19,7 @@
 
 #include "code_generator.h"
 #include "nodes.h"
+#include "parallel_move_resolver.h"
 #include "utils/x86/assembler_x86.h"
 
 namespace art {
@@ -59,6 +60,25 @@ class InvokeDexCallingConventionVisitor {
   DISALLOW_COPY_AND_ASSIGN(InvokeDexCallingConventionVisitor);
 };
 
+class ParallelMoveResolverX86 : public ParallelMoveResolver {
+ public:
+  ParallelMoveResolverX86(ArenaAllocator* allocator, CodeGeneratorX86* codegen)
+      : ParallelMoveResolver(allocator), codegen_(codegen) {}
+
+  virtual void EmitMove(size_t index) OVERRIDE;
+  virtual void EmitSwap(size_t index) OVERRIDE;
+
+  X86Assembler* GetAssembler() const;
+
+ private:
+  void Exchange(Register reg, int mem);
+  void Exchange(int mem1, int mem2);
+
+  CodeGeneratorX86* const codegen_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelMoveResolverX86);
+};
+
 class LocationsBuilderX86 : public HGraphVisitor {
  public:
   LocationsBuilderX86(HGraph* graph, CodeGeneratorX86* codegen)
@@ -71,6 +91,10 @@ class LocationsBuilderX86 : public HGraphVisitor {
 
 #undef DECLARE_VISIT_INSTRUCTION
 
+  void HandleInvoke(HInvoke* invoke);
+  void HandleCondition(HCondition* condition);
+  void HandleDivRem(HBinaryOperation* instruction);
+
  private:
   CodeGeneratorX86* const codegen_;
   InvokeDexCallingConventionVisitor parameter_visitor_;
@@ -94,6 +118,17 @@ class InstructionCodeGeneratorX86 : public HGraphVisitor {
   X86Assembler* GetAssembler() const { return assembler_; }
 
  private:
+  void HandleCondition(HCondition* condition);
+  void GenerateDivRem(HBinaryOperation* instruction);
+
+  // Float and double values are kept in core registers and stack slots. These
+  // helpers move them from and to the XMM registers computations are done in.
+  void LoadFloatingPoint(XmmRegister destination, Location source, bool is_double);
+  void StoreFloatingPoint(Location destination, XmmRegister source, bool is_double);
+  // Moves the float or double result of a call, returned in XMM0, to the output
+  // location of `instruction`.
+  void MoveFloatingPointResult(HInstruction* instruction);
+
   X86Assembler* const assembler_;
   CodeGeneratorX86* const codegen_;
 
@@ -126,22 +161,33 @@ class CodeGeneratorX86 : public CodeGenerator {
     return &assembler_;
   }
 
+  virtual ParallelMoveResolverX86* GetMoveResolver() OVERRIDE {
+    return &move_resolver_;
+  }
+
   virtual size_t GetNumberOfRegisters() const OVERRIDE;
+  virtual size_t GetNumberOfCoreRegisters() const OVERRIDE;
   virtual void SetupBlockedRegisters(bool* blocked_registers) const OVERRIDE;
   virtual ManagedRegister AllocateFreeRegister(
       Primitive::Type type, bool* blocked_registers) const OVERRIDE;
 
-  int32_t GetStackSlot(HLocal* local) const;
   virtual Location GetStackLocation(HLoadLocal* load) const OVERRIDE;
 
- private:
   // Helper method to move a 32bits value between two locations.
   void Move32(Location destination, Location source);
   // Helper method to move a 64bits value between two locations.
   void Move64(Location destination, Location source);
 
+  // Emit a write barrier.
+  void MarkGCCard(Register temp, Register card, Register object, Register value);
+
+ protected:
+  virtual size_t FrameEntrySpillSize() const OVERRIDE;
+
+ private:
   LocationsBuilderX86 location_builder_;
   InstructionCodeGeneratorX86 instruction_visitor_;
+  ParallelMoveResolverX86 move_resolver_;
   X86Assembler assembler_;
 
   DISALLOW_COPY_AND_ASSIGN(CodeGeneratorX86);
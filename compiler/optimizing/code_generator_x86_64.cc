@@ -0,0 +1,1885 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "code_generator_x86_64.h"
+#include "utils/assembler.h"
+#include "utils/x86_64/assembler_x86_64.h"
+#include "utils/x86_64/managed_register_x86_64.h"
+
+#include "entrypoints/quick/quick_entrypoints.h"
+#include "gc/accounting/card_table.h"
+#include "mirror/array.h"
+#include "mirror/art_method.h"
+#include "mirror/class.h"
+#include "thread.h"
+
+#define __ reinterpret_cast<X86_64Assembler*>(GetAssembler())->
+
+namespace art {
+
+x86_64::X86_64ManagedRegister Location::AsX86_64() const {
+  return reg().AsX86_64();
+}
+
+namespace x86_64 {
+
+static constexpr int kNumberOfPushedRegistersAtEntry = 1;
+static constexpr int kCurrentMethodStackOffset = 0;
+
+// Not allocated, and used by moves between stack slots and by the loop
+// vectorizer.
+static constexpr Register TMP = R11;
+
+CodeGeneratorX86_64::CodeGeneratorX86_64(HGraph* graph)
+    : CodeGenerator(graph, kNumberOfRegIds),
+      location_builder_(graph, this),
+      instruction_visitor_(graph, this),
+      move_resolver_(graph->GetArena(), this) {}
+
+ManagedRegister CodeGeneratorX86_64::AllocateFreeRegister(Primitive::Type type,
+                                                          bool* blocked_registers) const {
+  switch (type) {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimInt:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimNot: {
+      // All values fit in a core register. Float and double values are moved
+      // to an XMM register by the instructions operating on them.
+      size_t reg = AllocateFreeRegisterInternal(blocked_registers, kNumberOfCpuRegisters);
+      return X86_64ManagedRegister::FromCpuRegister(static_cast<Register>(reg));
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << type;
+  }
+
+  return ManagedRegister::NoRegister();
+}
+
+void CodeGeneratorX86_64::SetupBlockedRegisters(bool* blocked_registers) const {
+  // Stack register is always reserved.
+  blocked_registers[RSP] = true;
+
+  // Block the register used as TMP.
+  blocked_registers[TMP] = true;
+
+  // TODO: We currently don't use Quick's callee saved registers.
+  blocked_registers[RBX] = true;
+  blocked_registers[RBP] = true;
+  blocked_registers[R12] = true;
+  blocked_registers[R13] = true;
+  blocked_registers[R14] = true;
+  blocked_registers[R15] = true;
+}
+
+size_t CodeGeneratorX86_64::GetNumberOfRegisters() const {
+  return kNumberOfRegIds;
+}
+
+size_t CodeGeneratorX86_64::GetNumberOfCoreRegisters() const {
+  return kNumberOfCpuRegisters;
+}
+
+size_t CodeGeneratorX86_64::FrameEntrySpillSize() const {
+  return kNumberOfPushedRegistersAtEntry * kX86_64WordSize;
+}
+
+static Location X86_64CpuLocation(Register reg) {
+  return Location::RegisterLocation(X86_64ManagedRegister::FromCpuRegister(reg));
+}
+
+static Location X86_64XmmLocation(FloatRegister reg) {
+  return Location::RegisterLocation(X86_64ManagedRegister::FromXmmRegister(reg));
+}
+
+static bool IsXmmLocation(Location location) {
+  return location.IsRegister() && location.AsX86_64().IsXmmRegister();
+}
+
+InstructionCodeGeneratorX86_64::InstructionCodeGeneratorX86_64(HGraph* graph,
+                                                               CodeGeneratorX86_64* codegen)
+      : HGraphVisitor(graph),
+        assembler_(codegen->GetAssembler()),
+        codegen_(codegen) {}
+
+void CodeGeneratorX86_64::GenerateFrameEntry() {
+  // Create a fake register to mimic Quick.
+  static const int kFakeReturnRegister = 16;
+  core_spill_mask_ |= (1 << kFakeReturnRegister);
+
+  // The return PC has already been pushed on the stack.
+  __ subq(CpuRegister(RSP),
+          Immediate(GetFrameSize() - kNumberOfPushedRegistersAtEntry * kX86_64WordSize));
+  __ movq(Address(CpuRegister(RSP), kCurrentMethodStackOffset), CpuRegister(RDI));
+}
+
+void CodeGeneratorX86_64::GenerateFrameExit() {
+  __ addq(CpuRegister(RSP),
+          Immediate(GetFrameSize() - kNumberOfPushedRegistersAtEntry * kX86_64WordSize));
+}
+
+void CodeGeneratorX86_64::Bind(Label* label) {
+  __ Bind(label);
+}
+
+void InstructionCodeGeneratorX86_64::LoadCurrentMethod(CpuRegister reg) {
+  __ movl(reg, Address(CpuRegister(RSP), kCurrentMethodStackOffset));
+}
+
+void InstructionCodeGeneratorX86_64::LoadFloatingPoint(XmmRegister destination,
+                                                       Location source,
+                                                       bool is_double) {
+  if (IsXmmLocation(source)) {
+    if (is_double) {
+      __ movsd(destination, source.AsX86_64().AsXmmRegister());
+    } else {
+      __ movss(destination, source.AsX86_64().AsXmmRegister());
+    }
+  } else if (source.IsRegister()) {
+    if (is_double) {
+      __ movq(destination, source.AsX86_64().AsCpuRegister());
+    } else {
+      __ movd(destination, source.AsX86_64().AsCpuRegister());
+    }
+  } else if (is_double) {
+    DCHECK(source.IsDoubleStackSlot());
+    __ movsd(destination, Address(CpuRegister(RSP), source.GetStackIndex()));
+  } else {
+    DCHECK(source.IsStackSlot());
+    __ movss(destination, Address(CpuRegister(RSP), source.GetStackIndex()));
+  }
+}
+
+void InstructionCodeGeneratorX86_64::StoreFloatingPoint(Location destination,
+                                                        XmmRegister source,
+                                                        bool is_double) {
+  if (is_double) {
+    __ movq(destination.AsX86_64().AsCpuRegister(), source);
+  } else {
+    __ movd(destination.AsX86_64().AsCpuRegister(), source);
+  }
+}
+
+void InstructionCodeGeneratorX86_64::MoveFloatingPointResult(HInstruction* instruction) {
+  Primitive::Type type = instruction->GetType();
+  if (type == Primitive::kPrimFloat || type == Primitive::kPrimDouble) {
+    StoreFloatingPoint(instruction->GetLocations()->Out(), XmmRegister(XMM0),
+                       type == Primitive::kPrimDouble);
+  }
+}
+
+Location CodeGeneratorX86_64::GetStackLocation(HLoadLocal* load) const {
+  switch (load->GetType()) {
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
+      return Location::DoubleStackSlot(GetStackSlot(load->GetLocal()));
+      break;
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
+      return Location::StackSlot(GetStackSlot(load->GetLocal()));
+
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unexpected type " << load->GetType();
+  }
+
+  LOG(FATAL) << "Unreachable";
+  return Location();
+}
+
+static constexpr Register kRuntimeParameterCoreRegisters[] = { RDI, RSI, RDX };
+static constexpr size_t kRuntimeParameterCoreRegistersLength =
+    arraysize(kRuntimeParameterCoreRegisters);
+
+class InvokeRuntimeCallingConvention : public CallingConvention<Register> {
+ public:
+  InvokeRuntimeCallingConvention()
+      : CallingConvention(kRuntimeParameterCoreRegisters,
+                          kRuntimeParameterCoreRegistersLength) {}
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(InvokeRuntimeCallingConvention);
+};
+
+#undef __
+#define __ reinterpret_cast<X86_64Assembler*>(codegen->GetAssembler())->
+
+class NullCheckSlowPathX86_64 : public SlowPathCode {
+ public:
+  explicit NullCheckSlowPathX86_64(HNullCheck* instruction) : instruction_(instruction) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    __ gs()->call(
+        Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86_64WordSize, pThrowNullPointer), true));
+    codegen->RecordPcInfo(instruction_, instruction_->GetDexPc());
+  }
+
+ private:
+  HNullCheck* const instruction_;
+
+  DISALLOW_COPY_AND_ASSIGN(NullCheckSlowPathX86_64);
+};
+
+class DeoptimizationSlowPathX86_64 : public SlowPathCode {
+ public:
+  explicit DeoptimizationSlowPathX86_64(HDeoptimize* instruction) : instruction_(instruction) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    __ gs()->call(
+        Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86_64WordSize, pDeoptimize), true));
+    codegen->RecordPcInfo(instruction_, instruction_->GetDexPc());
+  }
+
+ private:
+  HDeoptimize* const instruction_;
+
+  DISALLOW_COPY_AND_ASSIGN(DeoptimizationSlowPathX86_64);
+};
+
+class DivZeroCheckSlowPathX86_64 : public SlowPathCode {
+ public:
+  explicit DivZeroCheckSlowPathX86_64(HDivZeroCheck* instruction) : instruction_(instruction) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    __ Bind(GetEntryLabel());
+    __ gs()->call(
+        Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86_64WordSize, pThrowDivZero), true));
+    codegen->RecordPcInfo(instruction_, instruction_->GetDexPc());
+  }
+
+ private:
+  HDivZeroCheck* const instruction_;
+
+  DISALLOW_COPY_AND_ASSIGN(DivZeroCheckSlowPathX86_64);
+};
+
+class BoundsCheckSlowPathX86_64 : public SlowPathCode {
+ public:
+  explicit BoundsCheckSlowPathX86_64(HBoundsCheck* instruction) : instruction_(instruction) {}
+
+  virtual void EmitNativeCode(CodeGenerator* codegen) OVERRIDE {
+    // The index and the length are already in the registers of the runtime
+    // calling convention.
+    __ Bind(GetEntryLabel());
+    __ gs()->call(
+        Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86_64WordSize, pThrowArrayBounds), true));
+    codegen->RecordPcInfo(instruction_, instruction_->GetDexPc());
+  }
+
+ private:
+  HBoundsCheck* const instruction_;
+
+  DISALLOW_COPY_AND_ASSIGN(BoundsCheckSlowPathX86_64);
+};
+
+#undef __
+#define __ reinterpret_cast<X86_64Assembler*>(GetAssembler())->
+
+Location InvokeDexCallingConventionVisitor::GetNextLocation(Primitive::Type type) {
+  switch (type) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot: {
+      uint32_t index = gp_index_++;
+      uint32_t stack_index = stack_index_++;
+      if (index < calling_convention.GetNumberOfRegisters()) {
+        return X86_64CpuLocation(calling_convention.GetRegisterAt(index));
+      } else {
+        return Location::StackSlot(
+            calling_convention.GetStackOffsetOf(stack_index, kX86_64WordSize));
+      }
+    }
+
+    case Primitive::kPrimLong: {
+      uint32_t index = gp_index_++;
+      uint32_t stack_index = stack_index_;
+      stack_index_ += 2;
+      if (index < calling_convention.GetNumberOfRegisters()) {
+        return X86_64CpuLocation(calling_convention.GetRegisterAt(index));
+      } else {
+        return Location::DoubleStackSlot(
+            calling_convention.GetStackOffsetOf(stack_index, kX86_64WordSize));
+      }
+    }
+
+    case Primitive::kPrimFloat: {
+      uint32_t index = fp_index_++;
+      uint32_t stack_index = stack_index_++;
+      if (index < calling_convention.GetNumberOfFloatRegisters()) {
+        return X86_64XmmLocation(calling_convention.GetFloatRegisterAt(index));
+      } else {
+        return Location::StackSlot(
+            calling_convention.GetStackOffsetOf(stack_index, kX86_64WordSize));
+      }
+    }
+
+    case Primitive::kPrimDouble: {
+      uint32_t index = fp_index_++;
+      uint32_t stack_index = stack_index_;
+      stack_index_ += 2;
+      if (index < calling_convention.GetNumberOfFloatRegisters()) {
+        return X86_64XmmLocation(calling_convention.GetFloatRegisterAt(index));
+      } else {
+        return Location::DoubleStackSlot(
+            calling_convention.GetStackOffsetOf(stack_index, kX86_64WordSize));
+      }
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unexpected parameter type " << type;
+      break;
+  }
+  return Location();
+}
+
+void CodeGeneratorX86_64::Move32(Location destination, Location source) {
+  if (source.Equals(destination)) {
+    return;
+  }
+  if (IsXmmLocation(destination)) {
+    XmmRegister dest = destination.AsX86_64().AsXmmRegister();
+    if (IsXmmLocation(source)) {
+      __ movss(dest, source.AsX86_64().AsXmmRegister());
+    } else if (source.IsRegister()) {
+      __ movd(dest, source.AsX86_64().AsCpuRegister());
+    } else {
+      DCHECK(source.IsStackSlot());
+      __ movss(dest, Address(CpuRegister(RSP), source.GetStackIndex()));
+    }
+  } else if (destination.IsRegister()) {
+    CpuRegister dest = destination.AsX86_64().AsCpuRegister();
+    if (IsXmmLocation(source)) {
+      __ movd(dest, source.AsX86_64().AsXmmRegister());
+    } else if (source.IsRegister()) {
+      __ movl(dest, source.AsX86_64().AsCpuRegister());
+    } else {
+      DCHECK(source.IsStackSlot());
+      __ movl(dest, Address(CpuRegister(RSP), source.GetStackIndex()));
+    }
+  } else {
+    DCHECK(destination.IsStackSlot());
+    Address dest(CpuRegister(RSP), destination.GetStackIndex());
+    if (IsXmmLocation(source)) {
+      __ movss(dest, source.AsX86_64().AsXmmRegister());
+    } else if (source.IsRegister()) {
+      __ movl(dest, source.AsX86_64().AsCpuRegister());
+    } else {
+      DCHECK(source.IsStackSlot());
+      __ movl(CpuRegister(TMP), Address(CpuRegister(RSP), source.GetStackIndex()));
+      __ movl(dest, CpuRegister(TMP));
+    }
+  }
+}
+
+void CodeGeneratorX86_64::Move64(Location destination, Location source) {
+  if (source.Equals(destination)) {
+    return;
+  }
+  if (IsXmmLocation(destination)) {
+    XmmRegister dest = destination.AsX86_64().AsXmmRegister();
+    if (IsXmmLocation(source)) {
+      __ movsd(dest, source.AsX86_64().AsXmmRegister());
+    } else if (source.IsRegister()) {
+      __ movq(dest, source.AsX86_64().AsCpuRegister());
+    } else {
+      DCHECK(source.IsDoubleStackSlot());
+      __ movsd(dest, Address(CpuRegister(RSP), source.GetStackIndex()));
+    }
+  } else if (destination.IsRegister()) {
+    CpuRegister dest = destination.AsX86_64().AsCpuRegister();
+    if (IsXmmLocation(source)) {
+      __ movq(dest, source.AsX86_64().AsXmmRegister());
+    } else if (source.IsRegister()) {
+      __ movq(dest, source.AsX86_64().AsCpuRegister());
+    } else {
+      DCHECK(source.IsDoubleStackSlot());
+      __ movq(dest, Address(CpuRegister(RSP), source.GetStackIndex()));
+    }
+  } else {
+    DCHECK(destination.IsDoubleStackSlot());
+    Address dest(CpuRegister(RSP), destination.GetStackIndex());
+    if (IsXmmLocation(source)) {
+      __ movsd(dest, source.AsX86_64().AsXmmRegister());
+    } else if (source.IsRegister()) {
+      __ movq(dest, source.AsX86_64().AsCpuRegister());
+    } else {
+      DCHECK(source.IsDoubleStackSlot());
+      __ movq(CpuRegister(TMP), Address(CpuRegister(RSP), source.GetStackIndex()));
+      __ movq(dest, CpuRegister(TMP));
+    }
+  }
+}
+
+void CodeGeneratorX86_64::Move(HInstruction* instruction,
+                               Location location,
+                               HInstruction* move_for) {
+  if (instruction->AsIntConstant() != nullptr) {
+    Immediate imm(instruction->AsIntConstant()->GetValue());
+    if (location.IsRegister()) {
+      __ movl(location.AsX86_64().AsCpuRegister(), imm);
+    } else {
+      __ movl(Address(CpuRegister(RSP), location.GetStackIndex()), imm);
+    }
+  } else if (instruction->AsLongConstant() != nullptr) {
+    int64_t value = instruction->AsLongConstant()->GetValue();
+    if (location.IsRegister()) {
+      __ movq(location.AsX86_64().AsCpuRegister(), Immediate(value));
+    } else {
+      __ movq(CpuRegister(TMP), Immediate(value));
+      __ movq(Address(CpuRegister(RSP), location.GetStackIndex()), CpuRegister(TMP));
+    }
+  } else if (instruction->AsLoadLocal() != nullptr) {
+    switch (instruction->GetType()) {
+      case Primitive::kPrimBoolean:
+      case Primitive::kPrimByte:
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+      case Primitive::kPrimInt:
+      case Primitive::kPrimNot:
+      case Primitive::kPrimFloat:
+        Move32(location, Location::StackSlot(GetStackSlot(instruction->AsLoadLocal()->GetLocal())));
+        break;
+
+      case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
+        Move64(location, Location::DoubleStackSlot(
+            GetStackSlot(instruction->AsLoadLocal()->GetLocal())));
+        break;
+
+      default:
+        LOG(FATAL) << "Unimplemented local type " << instruction->GetType();
+    }
+  } else {
+    // This can currently only happen when the instruction that requests the move
+    // is the next to be compiled, or when the value was saved in a temporary.
+    DCHECK((instruction->GetNext() == move_for)
+           || instruction->GetNext()->AsTemporary() != nullptr);
+    switch (instruction->GetType()) {
+      case Primitive::kPrimBoolean:
+      case Primitive::kPrimByte:
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+      case Primitive::kPrimInt:
+      case Primitive::kPrimNot:
+      case Primitive::kPrimFloat:
+        Move32(location, instruction->GetLocations()->Out());
+        break;
+
+      case Primitive::kPrimLong:
+      case Primitive::kPrimDouble:
+        Move64(location, instruction->GetLocations()->Out());
+        break;
+
+      default:
+        LOG(FATAL) << "Unimplemented type " << instruction->GetType();
+    }
+  }
+}
+
+void CodeGeneratorX86_64::MarkGCCard(CpuRegister temp,
+                                     CpuRegister card,
+                                     CpuRegister object,
+                                     CpuRegister value) {
+  Label is_null;
+  __ testl(value, value);
+  __ j(kEqual, &is_null);
+  __ gs()->movq(card, Address::Absolute(Thread::CardTableOffset<kX86_64WordSize>(), true));
+  __ movl(temp, object);
+  __ shrl(temp, Immediate(gc::accounting::CardTable::kCardShift));
+  // The card table base is biased so that its low byte is the dirty card value.
+  __ movb(Address(temp, card, TIMES_1, 0), card);
+  __ Bind(&is_null);
+}
+
+void LocationsBuilderX86_64::VisitGoto(HGoto* got) {
+  got->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorX86_64::VisitGoto(HGoto* got) {
+  HBasicBlock* successor = got->GetSuccessor();
+  if (GetGraph()->GetExitBlock() == successor) {
+    codegen_->GenerateFrameExit();
+  } else if (!codegen_->GoesToNextBlock(got->GetBlock(), successor)) {
+    __ jmp(codegen_->GetLabelOf(successor));
+  }
+}
+
+void LocationsBuilderX86_64::VisitExit(HExit* exit) {
+  exit->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorX86_64::VisitExit(HExit* exit) {
+  if (kIsDebugBuild) {
+    __ Comment("Unreachable");
+    __ int3();
+  }
+}
+
+void LocationsBuilderX86_64::VisitIf(HIf* if_instr) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(if_instr);
+  locations->SetInAt(0, Location::Any());
+  if_instr->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitIf(HIf* if_instr) {
+  // TODO: Generate the input as a condition, instead of materializing in a register.
+  Location location = if_instr->GetLocations()->InAt(0);
+  if (location.IsRegister()) {
+    __ cmpl(location.AsX86_64().AsCpuRegister(), Immediate(0));
+  } else {
+    __ cmpl(Address(CpuRegister(RSP), location.GetStackIndex()), Immediate(0));
+  }
+  __ j(kEqual, codegen_->GetLabelOf(if_instr->IfFalseSuccessor()));
+  if (!codegen_->GoesToNextBlock(if_instr->GetBlock(), if_instr->IfTrueSuccessor())) {
+    __ jmp(codegen_->GetLabelOf(if_instr->IfTrueSuccessor()));
+  }
+}
+
+void LocationsBuilderX86_64::VisitDeoptimize(HDeoptimize* deoptimize) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(deoptimize);
+  locations->SetInAt(0, Location::Any());
+  deoptimize->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitDeoptimize(HDeoptimize* deoptimize) {
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) DeoptimizationSlowPathX86_64(deoptimize);
+  codegen_->AddSlowPath(slow_path);
+
+  Location location = deoptimize->GetLocations()->InAt(0);
+  if (location.IsRegister()) {
+    __ cmpl(location.AsX86_64().AsCpuRegister(), Immediate(0));
+  } else {
+    __ cmpl(Address(CpuRegister(RSP), location.GetStackIndex()), Immediate(0));
+  }
+  __ j(kNotEqual, slow_path->GetEntryLabel());
+}
+
+void LocationsBuilderX86_64::VisitLocal(HLocal* local) {
+  local->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorX86_64::VisitLocal(HLocal* local) {
+  DCHECK_EQ(local->GetBlock(), GetGraph()->GetEntryBlock());
+}
+
+void LocationsBuilderX86_64::VisitLoadLocal(HLoadLocal* local) {
+  local->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorX86_64::VisitLoadLocal(HLoadLocal* load) {
+  // Nothing to do, this is driven by the code generator.
+}
+
+void LocationsBuilderX86_64::VisitStoreLocal(HStoreLocal* store) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(store);
+  switch (store->InputAt(1)->GetType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat:
+      locations->SetInAt(1, Location::StackSlot(codegen_->GetStackSlot(store->GetLocal())));
+      break;
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble:
+      locations->SetInAt(1, Location::DoubleStackSlot(codegen_->GetStackSlot(store->GetLocal())));
+      break;
+
+    default:
+      LOG(FATAL) << "Unimplemented local type " << store->InputAt(1)->GetType();
+  }
+  store->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitStoreLocal(HStoreLocal* store) {
+}
+
+static Condition X86_64Condition(IfCondition cond) {
+  switch (cond) {
+    case kCondEQ: return kEqual;
+    case kCondNE: return kNotEqual;
+    case kCondLT: return kLess;
+    case kCondLE: return kLessEqual;
+    case kCondGT: return kGreater;
+    case kCondGE: return kGreaterEqual;
+  }
+  LOG(FATAL) << "Unreachable";
+  return kEqual;
+}
+
+void LocationsBuilderX86_64::HandleCondition(HCondition* condition) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(condition);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::Any());
+  locations->SetOut(Location::SameAsFirstInput());
+  condition->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::HandleCondition(HCondition* condition) {
+  LocationSummary* locations = condition->GetLocations();
+  if (locations->InAt(1).IsRegister()) {
+    __ cmpl(locations->InAt(0).AsX86_64().AsCpuRegister(),
+            locations->InAt(1).AsX86_64().AsCpuRegister());
+  } else {
+    __ cmpl(locations->InAt(0).AsX86_64().AsCpuRegister(),
+            Address(CpuRegister(RSP), locations->InAt(1).GetStackIndex()));
+  }
+  CpuRegister out = locations->Out().AsX86_64().AsCpuRegister();
+  __ setcc(X86_64Condition(condition->GetCondition()), out);
+  // setcc only sets the low byte of the register.
+  __ movzxb(out, out);
+}
+
+void LocationsBuilderX86_64::VisitEqual(HEqual* equal) {
+  HandleCondition(equal);
+}
+
+void InstructionCodeGeneratorX86_64::VisitEqual(HEqual* equal) {
+  HandleCondition(equal);
+}
+
+void LocationsBuilderX86_64::VisitNotEqual(HNotEqual* comp) {
+  HandleCondition(comp);
+}
+
+void InstructionCodeGeneratorX86_64::VisitNotEqual(HNotEqual* comp) {
+  HandleCondition(comp);
+}
+
+void LocationsBuilderX86_64::VisitLessThan(HLessThan* comp) {
+  HandleCondition(comp);
+}
+
+void InstructionCodeGeneratorX86_64::VisitLessThan(HLessThan* comp) {
+  HandleCondition(comp);
+}
+
+void LocationsBuilderX86_64::VisitLessThanOrEqual(HLessThanOrEqual* comp) {
+  HandleCondition(comp);
+}
+
+void InstructionCodeGeneratorX86_64::VisitLessThanOrEqual(HLessThanOrEqual* comp) {
+  HandleCondition(comp);
+}
+
+void LocationsBuilderX86_64::VisitGreaterThan(HGreaterThan* comp) {
+  HandleCondition(comp);
+}
+
+void InstructionCodeGeneratorX86_64::VisitGreaterThan(HGreaterThan* comp) {
+  HandleCondition(comp);
+}
+
+void LocationsBuilderX86_64::VisitGreaterThanOrEqual(HGreaterThanOrEqual* comp) {
+  HandleCondition(comp);
+}
+
+void InstructionCodeGeneratorX86_64::VisitGreaterThanOrEqual(HGreaterThanOrEqual* comp) {
+  HandleCondition(comp);
+}
+
+void LocationsBuilderX86_64::VisitIntConstant(HIntConstant* constant) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(constant);
+  locations->SetOut(Location::ConstantLocation(constant));
+  constant->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitIntConstant(HIntConstant* constant) {
+  // Will be generated at use site.
+}
+
+void LocationsBuilderX86_64::VisitLongConstant(HLongConstant* constant) {
+  constant->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorX86_64::VisitLongConstant(HLongConstant* constant) {
+  // Will be generated at use site.
+}
+
+void LocationsBuilderX86_64::VisitReturnVoid(HReturnVoid* ret) {
+  ret->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorX86_64::VisitReturnVoid(HReturnVoid* ret) {
+  codegen_->GenerateFrameExit();
+  __ ret();
+}
+
+void LocationsBuilderX86_64::VisitReturn(HReturn* ret) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(ret);
+  switch (ret->InputAt(0)->GetType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      locations->SetInAt(0, X86_64CpuLocation(RAX));
+      break;
+
+    default:
+      LOG(FATAL) << "Unimplemented return type " << ret->InputAt(0)->GetType();
+  }
+  ret->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitReturn(HReturn* ret) {
+  if (kIsDebugBuild) {
+    switch (ret->InputAt(0)->GetType()) {
+      case Primitive::kPrimBoolean:
+      case Primitive::kPrimByte:
+      case Primitive::kPrimChar:
+      case Primitive::kPrimShort:
+      case Primitive::kPrimInt:
+      case Primitive::kPrimNot:
+      case Primitive::kPrimLong:
+      case Primitive::kPrimFloat:
+      case Primitive::kPrimDouble:
+        DCHECK_EQ(ret->GetLocations()->InAt(0).AsX86_64().AsCpuRegister().AsRegister(), RAX);
+        break;
+
+      default:
+        LOG(FATAL) << "Unimplemented return type " << ret->InputAt(0)->GetType();
+    }
+  }
+  Primitive::Type type = ret->InputAt(0)->GetType();
+  if (type == Primitive::kPrimFloat || type == Primitive::kPrimDouble) {
+    // The managed calling convention returns floating point values in XMM0.
+    LoadFloatingPoint(XmmRegister(XMM0), ret->GetLocations()->InAt(0),
+                      type == Primitive::kPrimDouble);
+  }
+  codegen_->GenerateFrameExit();
+  __ ret();
+}
+
+void LocationsBuilderX86_64::VisitInvokeStatic(HInvokeStatic* invoke) {
+  HandleInvoke(invoke);
+}
+
+void LocationsBuilderX86_64::HandleInvoke(HInvoke* invoke) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(invoke);
+  // The callee expects its method in RDI.
+  locations->AddTemp(X86_64CpuLocation(RDI));
+
+  InvokeDexCallingConventionVisitor calling_convention_visitor;
+  for (size_t i = 0; i < invoke->InputCount(); i++) {
+    HInstruction* input = invoke->InputAt(i);
+    locations->SetInAt(i, calling_convention_visitor.GetNextLocation(input->GetType()));
+  }
+
+  switch (invoke->GetType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimLong:
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+      locations->SetOut(X86_64CpuLocation(RAX));
+      break;
+
+    case Primitive::kPrimVoid:
+      break;
+  }
+
+  invoke->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitInvokeStatic(HInvokeStatic* invoke) {
+  CpuRegister temp = invoke->GetLocations()->GetTemp(0).AsX86_64().AsCpuRegister();
+  size_t index_in_cache = mirror::Array::DataOffset(sizeof(mirror::Object*)).Int32Value() +
+      invoke->GetIndexInDexCache() * sizeof(mirror::HeapReference<mirror::Object>);
+
+  // TODO: Implement all kinds of calls:
+  // 1) boot -> boot
+  // 2) app -> boot
+  // 3) app -> app
+  //
+  // Currently we implement the app -> app logic, which looks up in the resolve cache.
+
+  // temp = method;
+  LoadCurrentMethod(temp);
+  // temp = temp->dex_cache_resolved_methods_;
+  __ movl(temp, Address(temp, mirror::ArtMethod::DexCacheResolvedMethodsOffset().Int32Value()));
+  // temp = temp[index_in_cache]
+  __ movl(temp, Address(temp, index_in_cache));
+  // (temp + offset_of_quick_compiled_code)()
+  __ call(Address(temp, mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset().Int32Value()));
+
+  codegen_->RecordPcInfo(invoke, invoke->GetDexPc());
+  MoveFloatingPointResult(invoke);
+}
+
+void LocationsBuilderX86_64::VisitAdd(HAdd* add) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(add);
+  switch (add->GetResultType()) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::Any());
+      locations->SetOut(Location::SameAsFirstInput());
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::Any());
+      locations->SetInAt(1, Location::Any());
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      LOG(FATAL) << "Unexpected add type " << add->GetResultType();
+      break;
+
+    default:
+      LOG(FATAL) << "Unimplemented add type " << add->GetResultType();
+  }
+  add->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitAdd(HAdd* add) {
+  LocationSummary* locations = add->GetLocations();
+  switch (add->GetResultType()) {
+    case Primitive::kPrimInt: {
+      CpuRegister first = locations->InAt(0).AsX86_64().AsCpuRegister();
+      DCHECK_EQ(first.AsRegister(), locations->Out().AsX86_64().AsCpuRegister().AsRegister());
+      if (locations->InAt(1).IsRegister()) {
+        __ addl(first, locations->InAt(1).AsX86_64().AsCpuRegister());
+      } else {
+        __ addl(first, Address(CpuRegister(RSP), locations->InAt(1).GetStackIndex()));
+      }
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      CpuRegister first = locations->InAt(0).AsX86_64().AsCpuRegister();
+      DCHECK_EQ(first.AsRegister(), locations->Out().AsX86_64().AsCpuRegister().AsRegister());
+      if (locations->InAt(1).IsRegister()) {
+        __ addq(first, locations->InAt(1).AsX86_64().AsCpuRegister());
+      } else {
+        __ addq(first, Address(CpuRegister(RSP), locations->InAt(1).GetStackIndex()));
+      }
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      bool is_double = add->GetResultType() == Primitive::kPrimDouble;
+      LoadFloatingPoint(XmmRegister(XMM0), locations->InAt(0), is_double);
+      LoadFloatingPoint(XmmRegister(XMM1), locations->InAt(1), is_double);
+      if (is_double) {
+        __ addsd(XmmRegister(XMM0), XmmRegister(XMM1));
+      } else {
+        __ addss(XmmRegister(XMM0), XmmRegister(XMM1));
+      }
+      StoreFloatingPoint(locations->Out(), XmmRegister(XMM0), is_double);
+      break;
+    }
+
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      LOG(FATAL) << "Unexpected add type " << add->GetResultType();
+      break;
+
+    default:
+      LOG(FATAL) << "Unimplemented add type " << add->GetResultType();
+  }
+}
+
+void LocationsBuilderX86_64::VisitSub(HSub* sub) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(sub);
+  switch (sub->GetResultType()) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::Any());
+      locations->SetOut(Location::SameAsFirstInput());
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::Any());
+      locations->SetInAt(1, Location::Any());
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      LOG(FATAL) << "Unexpected sub type " << sub->GetResultType();
+      break;
+
+    default:
+      LOG(FATAL) << "Unimplemented sub type " << sub->GetResultType();
+  }
+  sub->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitSub(HSub* sub) {
+  LocationSummary* locations = sub->GetLocations();
+  switch (sub->GetResultType()) {
+    case Primitive::kPrimInt: {
+      CpuRegister first = locations->InAt(0).AsX86_64().AsCpuRegister();
+      DCHECK_EQ(first.AsRegister(), locations->Out().AsX86_64().AsCpuRegister().AsRegister());
+      if (locations->InAt(1).IsRegister()) {
+        __ subl(first, locations->InAt(1).AsX86_64().AsCpuRegister());
+      } else {
+        __ subl(first, Address(CpuRegister(RSP), locations->InAt(1).GetStackIndex()));
+      }
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      CpuRegister first = locations->InAt(0).AsX86_64().AsCpuRegister();
+      DCHECK_EQ(first.AsRegister(), locations->Out().AsX86_64().AsCpuRegister().AsRegister());
+      if (locations->InAt(1).IsRegister()) {
+        __ subq(first, locations->InAt(1).AsX86_64().AsCpuRegister());
+      } else {
+        __ subq(first, Address(CpuRegister(RSP), locations->InAt(1).GetStackIndex()));
+      }
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      bool is_double = sub->GetResultType() == Primitive::kPrimDouble;
+      LoadFloatingPoint(XmmRegister(XMM0), locations->InAt(0), is_double);
+      LoadFloatingPoint(XmmRegister(XMM1), locations->InAt(1), is_double);
+      if (is_double) {
+        __ subsd(XmmRegister(XMM0), XmmRegister(XMM1));
+      } else {
+        __ subss(XmmRegister(XMM0), XmmRegister(XMM1));
+      }
+      StoreFloatingPoint(locations->Out(), XmmRegister(XMM0), is_double);
+      break;
+    }
+
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+      LOG(FATAL) << "Unexpected sub type " << sub->GetResultType();
+      break;
+
+    default:
+      LOG(FATAL) << "Unimplemented sub type " << sub->GetResultType();
+  }
+}
+
+void LocationsBuilderX86_64::VisitNewInstance(HNewInstance* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetOut(X86_64CpuLocation(RAX));
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->AddTemp(X86_64CpuLocation(calling_convention.GetRegisterAt(0)));
+  locations->AddTemp(X86_64CpuLocation(calling_convention.GetRegisterAt(1)));
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitNewInstance(HNewInstance* instruction) {
+  InvokeRuntimeCallingConvention calling_convention;
+  LoadCurrentMethod(CpuRegister(calling_convention.GetRegisterAt(1)));
+  __ movl(CpuRegister(calling_convention.GetRegisterAt(0)),
+          Immediate(instruction->GetTypeIndex()));
+
+  __ gs()->call(Address::Absolute(
+      QUICK_ENTRYPOINT_OFFSET(kX86_64WordSize, pAllocObjectWithAccessCheck), true));
+
+  codegen_->RecordPcInfo(instruction, instruction->GetDexPc());
+}
+
+void LocationsBuilderX86_64::VisitParameterValue(HParameterValue* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  Location location = parameter_visitor_.GetNextLocation(instruction->GetType());
+  if (location.IsStackSlot()) {
+    location = Location::StackSlot(location.GetStackIndex() + codegen_->GetFrameSize());
+  } else if (location.IsDoubleStackSlot()) {
+    location = Location::DoubleStackSlot(location.GetStackIndex() + codegen_->GetFrameSize());
+  }
+  locations->SetOut(location);
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitParameterValue(HParameterValue* instruction) {
+  // Nothing to do, the parameter is already at its location.
+}
+
+void LocationsBuilderX86_64::VisitNot(HNot* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::SameAsFirstInput());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitNot(HNot* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  CpuRegister out = locations->Out().AsX86_64().AsCpuRegister();
+  DCHECK_EQ(locations->InAt(0).AsX86_64().AsCpuRegister().AsRegister(), out.AsRegister());
+  __ xorq(out, Immediate(1));
+}
+
+void LocationsBuilderX86_64::VisitMul(HMul* mul) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(mul);
+  switch (mul->GetResultType()) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong: {
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::Any());
+      locations->SetOut(Location::SameAsFirstInput());
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      locations->SetInAt(0, Location::Any());
+      locations->SetInAt(1, Location::Any());
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected mul type " << mul->GetResultType();
+  }
+  mul->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitMul(HMul* mul) {
+  LocationSummary* locations = mul->GetLocations();
+  switch (mul->GetResultType()) {
+    case Primitive::kPrimInt: {
+      CpuRegister first = locations->InAt(0).AsX86_64().AsCpuRegister();
+      DCHECK_EQ(first.AsRegister(), locations->Out().AsX86_64().AsCpuRegister().AsRegister());
+      if (locations->InAt(1).IsRegister()) {
+        __ imull(first, locations->InAt(1).AsX86_64().AsCpuRegister());
+      } else {
+        __ imull(first, Address(CpuRegister(RSP), locations->InAt(1).GetStackIndex()));
+      }
+      break;
+    }
+
+    case Primitive::kPrimLong: {
+      CpuRegister first = locations->InAt(0).AsX86_64().AsCpuRegister();
+      DCHECK_EQ(first.AsRegister(), locations->Out().AsX86_64().AsCpuRegister().AsRegister());
+      if (locations->InAt(1).IsRegister()) {
+        __ imulq(first, locations->InAt(1).AsX86_64().AsCpuRegister());
+      } else {
+        __ imulq(first, Address(CpuRegister(RSP), locations->InAt(1).GetStackIndex()));
+      }
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      bool is_double = mul->GetResultType() == Primitive::kPrimDouble;
+      LoadFloatingPoint(XmmRegister(XMM0), locations->InAt(0), is_double);
+      LoadFloatingPoint(XmmRegister(XMM1), locations->InAt(1), is_double);
+      if (is_double) {
+        __ mulsd(XmmRegister(XMM0), XmmRegister(XMM1));
+      } else {
+        __ mulss(XmmRegister(XMM0), XmmRegister(XMM1));
+      }
+      StoreFloatingPoint(locations->Out(), XmmRegister(XMM0), is_double);
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected mul type " << mul->GetResultType();
+  }
+}
+
+void LocationsBuilderX86_64::HandleDivRem(HBinaryOperation* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  switch (instruction->GetResultType()) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong: {
+      // idiv divides RDX:RAX, and puts the quotient in RAX and the remainder in RDX.
+      locations->SetInAt(0, Location::RequiresRegister());
+      locations->SetInAt(1, Location::RequiresRegister());
+      locations->AddTemp(X86_64CpuLocation(RAX));
+      locations->AddTemp(X86_64CpuLocation(RDX));
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      // The remainder is computed by the runtime, from the operands loaded in
+      // XMM0 and XMM1.
+      locations->SetInAt(0, Location::Any());
+      locations->SetInAt(1, Location::Any());
+      locations->SetOut(Location::RequiresRegister());
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected div type " << instruction->GetResultType();
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::GenerateDivRem(HBinaryOperation* instruction) {
+  bool is_div = instruction->AsDiv() != nullptr;
+  LocationSummary* locations = instruction->GetLocations();
+  switch (instruction->GetResultType()) {
+    case Primitive::kPrimInt:
+    case Primitive::kPrimLong: {
+      bool is_long = instruction->GetResultType() == Primitive::kPrimLong;
+      CpuRegister first = locations->InAt(0).AsX86_64().AsCpuRegister();
+      CpuRegister second = locations->InAt(1).AsX86_64().AsCpuRegister();
+      DCHECK_EQ(RAX, locations->GetTemp(0).AsX86_64().AsCpuRegister().AsRegister());
+      DCHECK_EQ(RDX, locations->GetTemp(1).AsX86_64().AsCpuRegister().AsRegister());
+      Label not_minus_one;
+      Label done;
+      // idiv faults on the minimum value divided by -1, whose quotient is the
+      // minimum value and remainder is 0.
+      if (is_long) {
+        __ movq(CpuRegister(RAX), first);
+        __ cmpq(second, Immediate(-1));
+      } else {
+        __ movl(CpuRegister(RAX), first);
+        __ cmpl(second, Immediate(-1));
+      }
+      __ j(kNotEqual, &not_minus_one);
+      if (!is_div) {
+        __ xorl(CpuRegister(RDX), CpuRegister(RDX));
+      } else if (is_long) {
+        __ negq(CpuRegister(RAX));
+      } else {
+        __ negl(CpuRegister(RAX));
+      }
+      __ jmp(&done);
+      __ Bind(&not_minus_one);
+      if (is_long) {
+        __ cqo();
+        __ idivq(second);
+      } else {
+        __ cdq();
+        __ idivl(second);
+      }
+      __ Bind(&done);
+      __ movq(locations->Out().AsX86_64().AsCpuRegister(), CpuRegister(is_div ? RAX : RDX));
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      bool is_double = instruction->GetResultType() == Primitive::kPrimDouble;
+      LoadFloatingPoint(XmmRegister(XMM0), locations->InAt(0), is_double);
+      LoadFloatingPoint(XmmRegister(XMM1), locations->InAt(1), is_double);
+      if (is_div) {
+        if (is_double) {
+          __ divsd(XmmRegister(XMM0), XmmRegister(XMM1));
+        } else {
+          __ divss(XmmRegister(XMM0), XmmRegister(XMM1));
+        }
+      } else if (is_double) {
+        __ gs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86_64WordSize, pFmod), true));
+      } else {
+        __ gs()->call(Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86_64WordSize, pFmodf), true));
+      }
+      StoreFloatingPoint(locations->Out(), XmmRegister(XMM0), is_double);
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unexpected div type " << instruction->GetResultType();
+  }
+}
+
+void LocationsBuilderX86_64::VisitDiv(HDiv* div) {
+  HandleDivRem(div);
+}
+
+void InstructionCodeGeneratorX86_64::VisitDiv(HDiv* div) {
+  GenerateDivRem(div);
+}
+
+void LocationsBuilderX86_64::VisitRem(HRem* rem) {
+  HandleDivRem(rem);
+}
+
+void InstructionCodeGeneratorX86_64::VisitRem(HRem* rem) {
+  GenerateDivRem(rem);
+}
+
+void LocationsBuilderX86_64::VisitDivZeroCheck(HDivZeroCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::Any());
+  if (instruction->HasUses()) {
+    locations->SetOut(Location::SameAsFirstInput());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitDivZeroCheck(HDivZeroCheck* instruction) {
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) DivZeroCheckSlowPathX86_64(instruction);
+  codegen_->AddSlowPath(slow_path);
+
+  LocationSummary* locations = instruction->GetLocations();
+  Location value = locations->InAt(0);
+
+  if (instruction->GetType() == Primitive::kPrimLong) {
+    if (value.IsRegister()) {
+      __ testq(value.AsX86_64().AsCpuRegister(), value.AsX86_64().AsCpuRegister());
+    } else {
+      DCHECK(value.IsDoubleStackSlot());
+      __ movq(CpuRegister(TMP), Address(CpuRegister(RSP), value.GetStackIndex()));
+      __ testq(CpuRegister(TMP), CpuRegister(TMP));
+    }
+  } else {
+    DCHECK_EQ(instruction->GetType(), Primitive::kPrimInt);
+    if (value.IsRegister()) {
+      __ testl(value.AsX86_64().AsCpuRegister(), value.AsX86_64().AsCpuRegister());
+    } else {
+      DCHECK(value.IsStackSlot());
+      __ cmpl(Address(CpuRegister(RSP), value.GetStackIndex()), Immediate(0));
+    }
+  }
+  __ j(kEqual, slow_path->GetEntryLabel());
+}
+
+void LocationsBuilderX86_64::VisitCompare(HCompare* compare) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(compare);
+  if (compare->GetInputType() == Primitive::kPrimLong) {
+    locations->SetInAt(0, Location::RequiresRegister());
+  } else {
+    locations->SetInAt(0, Location::Any());
+  }
+  locations->SetInAt(1, Location::Any());
+  locations->SetOut(Location::RequiresRegister());
+  compare->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitCompare(HCompare* compare) {
+  Label greater, less, done;
+  LocationSummary* locations = compare->GetLocations();
+  Location left = locations->InAt(0);
+  Location right = locations->InAt(1);
+  switch (compare->GetInputType()) {
+    case Primitive::kPrimLong: {
+      if (right.IsRegister()) {
+        __ cmpq(left.AsX86_64().AsCpuRegister(), right.AsX86_64().AsCpuRegister());
+      } else {
+        DCHECK(right.IsDoubleStackSlot());
+        __ cmpq(left.AsX86_64().AsCpuRegister(),
+                Address(CpuRegister(RSP), right.GetStackIndex()));
+      }
+      __ j(kLess, &less);  // Signed compare.
+      __ j(kGreater, &greater);  // Signed compare.
+      break;
+    }
+
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble: {
+      bool is_double = compare->GetInputType() == Primitive::kPrimDouble;
+      LoadFloatingPoint(XmmRegister(XMM0), left, is_double);
+      LoadFloatingPoint(XmmRegister(XMM1), right, is_double);
+      if (is_double) {
+        __ comisd(XmmRegister(XMM0), XmmRegister(XMM1));
+      } else {
+        __ comiss(XmmRegister(XMM0), XmmRegister(XMM1));
+      }
+      // An unordered result means one of the inputs is NaN.
+      __ j(kParityEven, compare->IsGtBias() ? &greater : &less);
+      __ j(kBelow, &less);
+      __ j(kAbove, &greater);
+      break;
+    }
+
+    default:
+      LOG(FATAL) << "Unimplemented compare type " << compare->GetInputType();
+  }
+
+  // The output may alias the inputs, so it is only written once they have been read.
+  CpuRegister out = locations->Out().AsX86_64().AsCpuRegister();
+  __ movl(out, Immediate(0));
+  __ jmp(&done);
+  __ Bind(&less);
+  __ movl(out, Immediate(-1));
+  __ jmp(&done);
+  __ Bind(&greater);
+  __ movl(out, Immediate(1));
+  __ Bind(&done);
+}
+
+void LocationsBuilderX86_64::VisitNullCheck(HNullCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::Any());
+  if (instruction->HasUses()) {
+    locations->SetOut(Location::SameAsFirstInput());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitNullCheck(HNullCheck* instruction) {
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) NullCheckSlowPathX86_64(instruction);
+  codegen_->AddSlowPath(slow_path);
+
+  LocationSummary* locations = instruction->GetLocations();
+  Location obj = locations->InAt(0);
+  DCHECK(!instruction->HasUses() || obj.Equals(locations->Out()));
+
+  if (obj.IsRegister()) {
+    __ cmpl(obj.AsX86_64().AsCpuRegister(), Immediate(0));
+  } else {
+    DCHECK(obj.IsStackSlot());
+    __ cmpl(Address(CpuRegister(RSP), obj.GetStackIndex()), Immediate(0));
+  }
+  __ j(kEqual, slow_path->GetEntryLabel());
+}
+
+void LocationsBuilderX86_64::VisitBoundsCheck(HBoundsCheck* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  // The slow path passes the index and the length to the runtime.
+  InvokeRuntimeCallingConvention calling_convention;
+  locations->SetInAt(0, X86_64CpuLocation(calling_convention.GetRegisterAt(0)));
+  locations->SetInAt(1, X86_64CpuLocation(calling_convention.GetRegisterAt(1)));
+  if (instruction->HasUses()) {
+    locations->SetOut(Location::SameAsFirstInput());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitBoundsCheck(HBoundsCheck* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  SlowPathCode* slow_path =
+      new (GetGraph()->GetArena()) BoundsCheckSlowPathX86_64(instruction);
+  codegen_->AddSlowPath(slow_path);
+
+  CpuRegister index = locations->InAt(0).AsX86_64().AsCpuRegister();
+  CpuRegister length = locations->InAt(1).AsX86_64().AsCpuRegister();
+
+  // An unsigned compare also catches negative indices.
+  __ cmpl(index, length);
+  __ j(kAboveEqual, slow_path->GetEntryLabel());
+}
+
+void LocationsBuilderX86_64::VisitArrayLength(HArrayLength* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitArrayLength(HArrayLength* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  uint32_t offset = mirror::Array::LengthOffset().Uint32Value();
+  CpuRegister obj = locations->InAt(0).AsX86_64().AsCpuRegister();
+  CpuRegister out = locations->Out().AsX86_64().AsCpuRegister();
+  __ movl(out, Address(obj, offset));
+}
+
+void LocationsBuilderX86_64::VisitInstanceFieldGet(HInstanceFieldGet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitInstanceFieldGet(HInstanceFieldGet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  CpuRegister obj = locations->InAt(0).AsX86_64().AsCpuRegister();
+  CpuRegister out = locations->Out().AsX86_64().AsCpuRegister();
+  uint32_t offset = instruction->GetFieldOffset().Uint32Value();
+
+  switch (instruction->GetType()) {
+    case Primitive::kPrimBoolean: {
+      __ movzxb(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimByte: {
+      __ movsxb(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimShort: {
+      __ movsxw(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimChar: {
+      __ movzxw(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat: {
+      __ movl(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
+      __ movq(out, Address(obj, offset));
+      break;
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetType();
+  }
+}
+
+void LocationsBuilderX86_64::VisitInstanceFieldSet(HInstanceFieldSet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  if (CodeGenerator::StoreNeedsWriteBarrier(instruction->GetFieldType(), instruction->InputAt(1))) {
+    // Temporary registers for the write barrier.
+    locations->AddTemp(Location::RequiresRegister());
+    locations->AddTemp(Location::RequiresRegister());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitInstanceFieldSet(HInstanceFieldSet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  CpuRegister obj = locations->InAt(0).AsX86_64().AsCpuRegister();
+  CpuRegister value = locations->InAt(1).AsX86_64().AsCpuRegister();
+  uint32_t offset = instruction->GetFieldOffset().Uint32Value();
+
+  switch (instruction->GetFieldType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte: {
+      __ movb(Address(obj, offset), value);
+      break;
+    }
+
+    case Primitive::kPrimShort:
+    case Primitive::kPrimChar: {
+      __ movw(Address(obj, offset), value);
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimFloat: {
+      __ movl(Address(obj, offset), value);
+      break;
+    }
+
+    case Primitive::kPrimNot: {
+      __ movl(Address(obj, offset), value);
+      if (CodeGenerator::StoreNeedsWriteBarrier(Primitive::kPrimNot, instruction->InputAt(1))) {
+        CpuRegister temp = locations->GetTemp(0).AsX86_64().AsCpuRegister();
+        CpuRegister card = locations->GetTemp(1).AsX86_64().AsCpuRegister();
+        codegen_->MarkGCCard(temp, card, obj, value);
+      }
+      break;
+    }
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
+      __ movq(Address(obj, offset), value);
+      break;
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetFieldType();
+  }
+}
+
+void LocationsBuilderX86_64::VisitArrayGet(HArrayGet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitArrayGet(HArrayGet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  CpuRegister obj = locations->InAt(0).AsX86_64().AsCpuRegister();
+  CpuRegister index = locations->InAt(1).AsX86_64().AsCpuRegister();
+  CpuRegister out = locations->Out().AsX86_64().AsCpuRegister();
+
+  switch (instruction->GetType()) {
+    case Primitive::kPrimBoolean: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint8_t)).Uint32Value();
+      __ movzxb(out, Address(obj, index, TIMES_1, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimByte: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int8_t)).Uint32Value();
+      __ movsxb(out, Address(obj, index, TIMES_1, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimShort: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int16_t)).Uint32Value();
+      __ movsxw(out, Address(obj, index, TIMES_2, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimChar: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint16_t)).Uint32Value();
+      __ movzxw(out, Address(obj, index, TIMES_2, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimNot:
+    case Primitive::kPrimFloat: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
+      __ movl(out, Address(obj, index, TIMES_4, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
+      __ movq(out, Address(obj, index, TIMES_8, data_offset));
+      break;
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetType();
+  }
+}
+
+void LocationsBuilderX86_64::VisitArraySet(HArraySet* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  if (instruction->GetComponentType() == Primitive::kPrimNot) {
+    // The store, with its type check and write barrier, is done by the runtime.
+    InvokeRuntimeCallingConvention calling_convention;
+    locations->SetInAt(0, X86_64CpuLocation(calling_convention.GetRegisterAt(0)));
+    locations->SetInAt(1, X86_64CpuLocation(calling_convention.GetRegisterAt(1)));
+    locations->SetInAt(2, X86_64CpuLocation(calling_convention.GetRegisterAt(2)));
+  } else {
+    locations->SetInAt(0, Location::RequiresRegister());
+    locations->SetInAt(1, Location::RequiresRegister());
+    locations->SetInAt(2, Location::RequiresRegister());
+  }
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitArraySet(HArraySet* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  CpuRegister obj = locations->InAt(0).AsX86_64().AsCpuRegister();
+  CpuRegister index = locations->InAt(1).AsX86_64().AsCpuRegister();
+  CpuRegister value = locations->InAt(2).AsX86_64().AsCpuRegister();
+
+  switch (instruction->GetComponentType()) {
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint8_t)).Uint32Value();
+      __ movb(Address(obj, index, TIMES_1, data_offset), value);
+      break;
+    }
+
+    case Primitive::kPrimShort:
+    case Primitive::kPrimChar: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(uint16_t)).Uint32Value();
+      __ movw(Address(obj, index, TIMES_2, data_offset), value);
+      break;
+    }
+
+    case Primitive::kPrimInt:
+    case Primitive::kPrimFloat: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).Uint32Value();
+      __ movl(Address(obj, index, TIMES_4, data_offset), value);
+      break;
+    }
+
+    case Primitive::kPrimNot: {
+      __ gs()->call(
+          Address::Absolute(QUICK_ENTRYPOINT_OFFSET(kX86_64WordSize, pAputObject), true));
+      codegen_->RecordPcInfo(instruction, instruction->GetDexPc());
+      break;
+    }
+
+    case Primitive::kPrimLong:
+    case Primitive::kPrimDouble: {
+      uint32_t data_offset = mirror::Array::DataOffset(sizeof(int64_t)).Uint32Value();
+      __ movq(Address(obj, index, TIMES_8, data_offset), value);
+      break;
+    }
+
+    case Primitive::kPrimVoid:
+      LOG(FATAL) << "Unreachable type " << instruction->GetComponentType();
+  }
+}
+
+void LocationsBuilderX86_64::VisitVectorizedLoop(HVectorizedLoop* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  // The start is the index of the loop, updated in place.
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::Any());
+  for (size_t i = 2, e = instruction->InputCount(); i < e; ++i) {
+    locations->SetInAt(i, instruction->IsArrayInput(i)
+                          ? Location::RequiresRegister()
+                          : Location::Any());
+  }
+  locations->SetOut(Location::SameAsFirstInput());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitVectorizedLoop(HVectorizedLoop* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  CpuRegister index = locations->Out().AsX86_64().AsCpuRegister();
+  DCHECK_EQ(index.AsRegister(), locations->InAt(0).AsX86_64().AsCpuRegister().AsRegister());
+  size_t component_size = Primitive::ComponentSize(instruction->GetComponentType());
+  int32_t vector_length = instruction->GetVectorLength();
+  ScaleFactor scale = static_cast<ScaleFactor>(CTZ(component_size));
+  uint32_t data_offset = mirror::Array::DataOffset(component_size).Uint32Value();
+  uint32_t length_offset = mirror::Array::LengthOffset().Uint32Value();
+
+  // Broadcast the loop invariant operands: left to XMM2, right to XMM3.
+  for (size_t i = 3, e = instruction->InputCount(); i < e; ++i) {
+    if (instruction->IsArrayInput(i)) {
+      continue;
+    }
+    XmmRegister vector((i == 3) ? XMM2 : XMM3);
+    LoadFloatingPoint(vector, locations->InAt(i), false);
+    if (component_size == 1) {
+      __ punpcklbw(vector, vector);
+    }
+    if (component_size <= 2) {
+      __ punpcklwd(vector, vector);
+    }
+    __ pshufd(vector, vector, Immediate(0));
+  }
+
+  // TMP holds the index to stop at.
+  CpuRegister end(TMP);
+  Location bound = locations->InAt(1);
+  if (bound.IsRegister()) {
+    __ movl(end, bound.AsX86_64().AsCpuRegister());
+  } else {
+    __ movl(end, Address(CpuRegister(RSP), bound.GetStackIndex()));
+  }
+
+  Label loop, done;
+  __ cmpl(index, Immediate(0));
+  __ j(kLess, &done);
+  for (size_t i = 2, e = instruction->InputCount(); i < e; ++i) {
+    if (!instruction->IsArrayInput(i)) {
+      continue;
+    }
+    CpuRegister array = locations->InAt(i).AsX86_64().AsCpuRegister();
+    Label in_bounds;
+    __ testl(array, array);
+    __ j(kEqual, &done);
+    __ cmpl(end, Address(array, length_offset));
+    __ j(kLessEqual, &in_bounds);
+    __ movl(end, Address(array, length_offset));
+    __ Bind(&in_bounds);
+  }
+  // Only perform whole vectors.
+  __ cmpl(end, index);
+  __ j(kLessEqual, &done);
+  __ subl(end, index);
+  __ andl(end, Immediate(-vector_length));
+  __ j(kEqual, &done);
+  __ addl(end, index);
+
+  __ Bind(&loop);
+  CpuRegister destination = locations->InAt(2).AsX86_64().AsCpuRegister();
+  switch (instruction->GetOperation()) {
+    case HVectorizedLoop::kFill:
+      __ movdqu(Address(destination, index, scale, data_offset), XmmRegister(XMM2));
+      break;
+
+    case HVectorizedLoop::kCopy: {
+      CpuRegister source = locations->InAt(3).AsX86_64().AsCpuRegister();
+      __ movdqu(XmmRegister(XMM0), Address(source, index, scale, data_offset));
+      __ movdqu(Address(destination, index, scale, data_offset), XmmRegister(XMM0));
+      break;
+    }
+
+    case HVectorizedLoop::kAdd:
+    case HVectorizedLoop::kSub:
+    case HVectorizedLoop::kMul: {
+      if (instruction->IsArrayInput(3)) {
+        CpuRegister left = locations->InAt(3).AsX86_64().AsCpuRegister();
+        __ movdqu(XmmRegister(XMM0), Address(left, index, scale, data_offset));
+      } else {
+        __ movdqa(XmmRegister(XMM0), XmmRegister(XMM2));
+      }
+      FloatRegister right = XMM3;
+      if (instruction->IsArrayInput(4)) {
+        CpuRegister right_array = locations->InAt(4).AsX86_64().AsCpuRegister();
+        __ movdqu(XmmRegister(XMM1), Address(right_array, index, scale, data_offset));
+        right = XMM1;
+      }
+      if (instruction->GetOperation() == HVectorizedLoop::kAdd) {
+        __ paddd(XmmRegister(XMM0), XmmRegister(right));
+      } else if (instruction->GetOperation() == HVectorizedLoop::kSub) {
+        __ psubd(XmmRegister(XMM0), XmmRegister(right));
+      } else {
+        __ pmulld(XmmRegister(XMM0), XmmRegister(right));
+      }
+      __ movdqu(Address(destination, index, scale, data_offset), XmmRegister(XMM0));
+      break;
+    }
+  }
+  __ addl(index, Immediate(vector_length));
+  __ cmpl(index, end);
+  __ j(kLess, &loop);
+
+  __ Bind(&done);
+}
+
+void LocationsBuilderX86_64::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  HandleInvoke(invoke);
+}
+
+void InstructionCodeGeneratorX86_64::VisitInvokeVirtual(HInvokeVirtual* invoke) {
+  LocationSummary* locations = invoke->GetLocations();
+  CpuRegister temp = locations->GetTemp(0).AsX86_64().AsCpuRegister();
+  CpuRegister receiver = locations->InAt(0).AsX86_64().AsCpuRegister();
+  size_t reference_size = sizeof(mirror::HeapReference<mirror::Object>);
+  uint32_t method_offset = mirror::Array::DataOffset(reference_size).Uint32Value()
+      + invoke->GetVTableIndex() * reference_size;
+
+  // temp = receiver->klass_;
+  __ movl(temp, Address(receiver, mirror::Object::ClassOffset().Int32Value()));
+  // temp = temp->vtable_;
+  __ movl(temp, Address(temp, mirror::Class::VTableOffset().Int32Value()));
+  // temp = temp[vtable_index]
+  __ movl(temp, Address(temp, method_offset));
+  // (temp + offset_of_quick_compiled_code)()
+  __ call(Address(temp, mirror::ArtMethod::EntryPointFromQuickCompiledCodeOffset().Int32Value()));
+
+  codegen_->RecordPcInfo(invoke, invoke->GetDexPc());
+  MoveFloatingPointResult(invoke);
+}
+
+void LocationsBuilderX86_64::VisitInvokeInterface(HInvokeInterface* invoke) {
+  HandleInvoke(invoke);
+}
+
+void InstructionCodeGeneratorX86_64::VisitInvokeInterface(HInvokeInterface* invoke) {
+  CpuRegister temp = invoke->GetLocations()->GetTemp(0).AsX86_64().AsCpuRegister();
+  // The trampoline finds the target from the method index, passed where the
+  // target expects its method, and calls it with the arguments in place.
+  __ movl(temp, Immediate(invoke->GetDexMethodIndex()));
+  __ gs()->call(Address::Absolute(
+      QUICK_ENTRYPOINT_OFFSET(kX86_64WordSize, pInvokeInterfaceTrampolineWithAccessCheck), true));
+
+  codegen_->RecordPcInfo(invoke, invoke->GetDexPc());
+  MoveFloatingPointResult(invoke);
+}
+
+void LocationsBuilderX86_64::VisitTemporary(HTemporary* temp) {
+  temp->SetLocations(nullptr);
+}
+
+void InstructionCodeGeneratorX86_64::VisitTemporary(HTemporary* temp) {
+  // Nothing to do, this is driven by the code generator.
+}
+
+void LocationsBuilderX86_64::VisitPhi(HPhi* instruction) {
+  LocationSummary* locations = new (GetGraph()->GetArena()) LocationSummary(instruction);
+  for (size_t i = 0, e = instruction->InputCount(); i < e; ++i) {
+    locations->SetInAt(i, Location::Any());
+  }
+  locations->SetOut(Location::Any());
+  instruction->SetLocations(locations);
+}
+
+void InstructionCodeGeneratorX86_64::VisitPhi(HPhi* instruction) {
+  LOG(FATAL) << "Unreachable";
+}
+
+void LocationsBuilderX86_64::VisitParallelMove(HParallelMove* instruction) {
+  LOG(FATAL) << "Unreachable";
+}
+
+void InstructionCodeGeneratorX86_64::VisitParallelMove(HParallelMove* instruction) {
+  codegen_->GetMoveResolver()->EmitNativeCode(instruction);
+}
+
+X86_64Assembler* ParallelMoveResolverX86_64::GetAssembler() const {
+  return codegen_->GetAssembler();
+}
+
+void ParallelMoveResolverX86_64::EmitMove(size_t index) {
+  MoveOperands* move = moves_.Get(index);
+  Location source = move->GetSource();
+  if (source.IsConstant()) {
+    codegen_->Move(source.GetConstant(), move->GetDestination(), nullptr);
+  } else {
+    codegen_->Move32(move->GetDestination(), source);
+  }
+}
+
+void ParallelMoveResolverX86_64::Exchange(CpuRegister reg, int mem) {
+  __ xchgl(reg, Address(CpuRegister(RSP), mem));
+}
+
+void ParallelMoveResolverX86_64::Exchange(int mem1, int mem2) {
+  __ movl(CpuRegister(TMP), Address(CpuRegister(RSP), mem1));
+  __ xchgl(CpuRegister(TMP), Address(CpuRegister(RSP), mem2));
+  __ movl(Address(CpuRegister(RSP), mem1), CpuRegister(TMP));
+}
+
+void ParallelMoveResolverX86_64::EmitSwap(size_t index) {
+  MoveOperands* move = moves_.Get(index);
+  Location source = move->GetSource();
+  Location destination = move->GetDestination();
+
+  if (source.IsRegister() && destination.IsRegister()) {
+    __ xchgl(destination.AsX86_64().AsCpuRegister(), source.AsX86_64().AsCpuRegister());
+  } else if (source.IsRegister() && destination.IsStackSlot()) {
+    Exchange(source.AsX86_64().AsCpuRegister(), destination.GetStackIndex());
+  } else if (source.IsStackSlot() && destination.IsRegister()) {
+    Exchange(destination.AsX86_64().AsCpuRegister(), source.GetStackIndex());
+  } else if (source.IsStackSlot() && destination.IsStackSlot()) {
+    Exchange(destination.GetStackIndex(), source.GetStackIndex());
+  } else {
+    LOG(FATAL) << "Unimplemented";
+  }
+}
+
+}  // namespace x86_64
+}  // namespace art
@@ -22,6 +22,8 @@
 #include "instruction_set.h"
 #include "nodes.h"
 #include "optimizing_unit_test.h"
+#include "register_allocator.h"
+#include "ssa_liveness_analysis.h"
 
 #include "gtest/gtest.h"
 
@@ -47,35 +49,89 @@ class InternalCodeAllocator : public CodeAllocator {
   DISALLOW_COPY_AND_ASSIGN(InternalCodeAllocator);
 };
 
-static void TestCode(const uint16_t* data, bool has_result = false, int32_t expected = 0) {
+#if defined(__i386__) || defined(__arm__) || defined(__x86_64__)
+static void Run(const InternalCodeAllocator& allocator, bool has_result, int32_t expected) {
+  typedef int32_t (*fptr)();
+  CommonCompilerTest::MakeExecutable(allocator.GetMemory(), allocator.GetSize());
+  int32_t result = reinterpret_cast<fptr>(allocator.GetMemory())();
+  if (has_result) {
+    CHECK_EQ(result, expected);
+  }
+}
+#endif
+
+static void RunCodeBaseline(HGraph* graph, bool has_result, int32_t expected) {
+  InternalCodeAllocator allocator;
+  CodeGenerator* codegen = CodeGenerator::Create(graph->GetArena(), graph, kX86);
+  codegen->CompileBaseline(&allocator);
+#if defined(__i386__)
+  Run(allocator, has_result, expected);
+#endif
+  codegen = CodeGenerator::Create(graph->GetArena(), graph, kArm);
+  codegen->CompileBaseline(&allocator);
+#if defined(__arm__)
+  Run(allocator, has_result, expected);
+#endif
+  codegen = CodeGenerator::Create(graph->GetArena(), graph, kX86_64);
+  codegen->CompileBaseline(&allocator);
+#if defined(__x86_64__)
+  Run(allocator, has_result, expected);
+#endif
+}
+
+static void RunCodeOptimized(const uint16_t* data,
+                             InstructionSet instruction_set,
+                             bool has_result,
+                             int32_t expected) {
   ArenaPool pool;
   ArenaAllocator arena(&pool);
   HGraphBuilder builder(&arena);
   const DexFile::CodeItem* item = reinterpret_cast<const DexFile::CodeItem*>(data);
   HGraph* graph = builder.BuildGraph(*item);
   ASSERT_NE(graph, nullptr);
+  if (!RegisterAllocator::CanAllocateRegistersFor(*graph, instruction_set)) {
+    return;
+  }
+  graph->BuildDominatorTree();
+  graph->TransformToSSA();
+  graph->FindNaturalLoops();
+
+  CodeGenerator* codegen = CodeGenerator::Create(&arena, graph, instruction_set);
+  SsaLivenessAnalysis liveness(*graph);
+  liveness.Analyze();
+  RegisterAllocator(&arena, codegen, liveness).AllocateRegisters();
+
   InternalCodeAllocator allocator;
-  CodeGenerator* codegen = CodeGenerator::Create(&arena, graph, kX86);
-  codegen->Compile(&allocator);
-  typedef int32_t (*fptr)();
+  codegen->CompileOptimized(&allocator);
 #if defined(__i386__)
-  CommonCompilerTest::MakeExecutable(allocator.GetMemory(), allocator.GetSize());
-  int32_t result = reinterpret_cast<fptr>(allocator.GetMemory())();
-  if (has_result) {
-    CHECK_EQ(result, expected);
+  if (instruction_set == kX86) {
+    Run(allocator, has_result, expected);
   }
-#endif
-  codegen = CodeGenerator::Create(&arena, graph, kArm);
-  codegen->Compile(&allocator);
-#if defined(__arm__)
-  CommonCompilerTest::MakeExecutable(allocator.GetMemory(), allocator.GetSize());
-  int32_t result = reinterpret_cast<fptr>(allocator.GetMemory())();
-  if (has_result) {
-    CHECK_EQ(result, expected);
+#elif defined(__arm__)
+  if (instruction_set == kArm) {
+    Run(allocator, has_result, expected);
+  }
+#elif defined(__x86_64__)
+  if (instruction_set == kX86_64) {
+    Run(allocator, has_result, expected);
   }
 #endif
 }
 
+static void TestCode(const uint16_t* data, bool has_result = false, int32_t expected = 0) {
+  ArenaPool pool;
+  ArenaAllocator arena(&pool);
+  HGraphBuilder builder(&arena);
+  const DexFile::CodeItem* item = reinterpret_cast<const DexFile::CodeItem*>(data);
+  HGraph* graph = builder.BuildGraph(*item);
+  ASSERT_NE(graph, nullptr);
+  RunCodeBaseline(graph, has_result, expected);
+
+  RunCodeOptimized(data, kX86, has_result, expected);
+  RunCodeOptimized(data, kArm, has_result, expected);
+  RunCodeOptimized(data, kX86_64, has_result, expected);
+}
+
 TEST(CodegenTest, ReturnVoid) {
   const uint16_t data[] = ZERO_REGISTER_CODE_ITEM(Instruction::RETURN_VOID);
   TestCode(data);
@@ -234,4 +290,180 @@ TEST(CodegenTest, ReturnAdd4) {
   TestCode(data, true, 7);
 }
 
+TEST(CodegenTest, ReturnAddSpill) {
+  // Keep more values alive than there are registers on x86.
+  const uint16_t data[] = {
+    6, 0, 0, 0, 0, 0, 17, 0,
+    Instruction::CONST_4 | 0 << 8 | 0 << 12,
+    Instruction::CONST_4 | 1 << 8 | 1 << 12,
+    Instruction::CONST_4 | 2 << 8 | 2 << 12,
+    Instruction::CONST_4 | 3 << 8 | 3 << 12,
+    Instruction::CONST_4 | 4 << 8 | 4 << 12,
+    Instruction::CONST_4 | 5 << 8 | 5 << 12,
+    Instruction::ADD_INT | 0 << 8, 0 | 1 << 8,
+    Instruction::ADD_INT | 0 << 8, 0 | 2 << 8,
+    Instruction::ADD_INT | 0 << 8, 0 | 3 << 8,
+    Instruction::ADD_INT | 0 << 8, 0 | 4 << 8,
+    Instruction::ADD_INT | 0 << 8, 0 | 5 << 8,
+    Instruction::RETURN | 0 << 8
+  };
+
+  TestCode(data, true, 15);
+}
+
+TEST(CodegenTest, ReturnLoop) {
+  /*
+   * Test the following snippet:
+   *  var a = 0;
+   *  var b = 5;
+   *  while (a != b) {
+   *    a = a + 1;
+   *  }
+   *  return a;
+   */
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::CONST_4 | 1 << 8 | 5 << 12,
+    Instruction::IF_EQ | 0 << 8 | 1 << 12, 5,
+    Instruction::ADD_INT_LIT8 | 0 << 8, 1 << 8,
+    Instruction::GOTO | 0xFC00,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data, true, 5);
+}
+
+TEST(CodegenTest, ReturnCriticalEdge) {
+  /*
+   * Test the following snippet, where the phi for b has an input
+   * flowing through a critical edge:
+   *  var a = 1;
+   *  var b = 2;
+   *  if (a != a) {
+   *    b = a;
+   *  }
+   *  return b;
+   */
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 1 << 12,
+    Instruction::CONST_4 | 1 << 8 | 2 << 12,
+    Instruction::IF_EQ | 0 << 8 | 0 << 12, 3,
+    Instruction::MOVE | 1 << 8 | 0 << 12,
+    Instruction::RETURN | 1 << 8);
+
+  TestCode(data, true, 2);
+}
+
+TEST(CodegenTest, ReturnMul1) {
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 3 << 12 | 0,
+    Instruction::CONST_4 | 4 << 12 | 1 << 8,
+    Instruction::MUL_INT, 1 << 8 | 0,
+    Instruction::RETURN);
+
+  TestCode(data, true, 12);
+}
+
+TEST(CodegenTest, ReturnMul2) {
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 3 << 12 | 0,
+    Instruction::CONST_4 | 4 << 12 | 1 << 8,
+    Instruction::MUL_INT_2ADDR | 1 << 12,
+    Instruction::RETURN);
+
+  TestCode(data, true, 12);
+}
+
+TEST(CodegenTest, ReturnMul3) {
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 4 << 12 | 0 << 8,
+    Instruction::MUL_INT_LIT8, 3 << 8 | 0,
+    Instruction::RETURN);
+
+  TestCode(data, true, 12);
+}
+
+TEST(CodegenTest, ReturnMul4) {
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 4 << 12 | 0 << 8,
+    Instruction::MUL_INT_LIT16, 3,
+    Instruction::RETURN);
+
+  TestCode(data, true, 12);
+}
+
+TEST(CodegenTest, ReturnIfLt) {
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::CONST_4 | 1 << 8 | 1 << 12,
+    Instruction::IF_LT | 0 << 8 | 1 << 12, 3,
+    Instruction::RETURN | 0 << 8,
+    Instruction::RETURN | 1 << 8);
+
+  TestCode(data, true, 1);
+}
+
+TEST(CodegenTest, ReturnIfGe) {
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::CONST_4 | 1 << 8 | 1 << 12,
+    Instruction::IF_GE | 0 << 8 | 1 << 12, 3,
+    Instruction::RETURN | 0 << 8,
+    Instruction::RETURN | 1 << 8);
+
+  TestCode(data, true, 0);
+}
+
+TEST(CodegenTest, ReturnIfLez) {
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 << 8 | 0xF << 12,
+    Instruction::IF_LEZ | 0 << 8, 3,
+    Instruction::CONST_4 | 0 << 8 | 2 << 12,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data, true, -1);
+}
+
+TEST(CodegenTest, ReturnIfGtz) {
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 << 8 | 0xF << 12,
+    Instruction::IF_GTZ | 0 << 8, 3,
+    Instruction::CONST_4 | 0 << 8 | 2 << 12,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data, true, 2);
+}
+
+TEST(CodegenTest, ReturnCmpLong1) {
+  // The high words are equal, the result depends on an unsigned compare
+  // of the low words.
+  const uint16_t data[] = FOUR_REGISTERS_CODE_ITEM(
+    Instruction::CONST_WIDE_16 | 0 << 8, 5,
+    Instruction::CONST_WIDE_16 | 2 << 8, 0xFFFD,
+    Instruction::CMP_LONG | 0 << 8, 2 << 8 | 0,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data, true, 1);
+}
+
+TEST(CodegenTest, ReturnCmpLong2) {
+  // The result comes from a signed compare of the high words.
+  const uint16_t data[] = FOUR_REGISTERS_CODE_ITEM(
+    Instruction::CONST_WIDE_16 | 0 << 8, 5,
+    Instruction::CONST_WIDE_HIGH16 | 2 << 8, 1,
+    Instruction::CMP_LONG | 0 << 8, 2 << 8 | 0,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data, true, -1);
+}
+
+TEST(CodegenTest, ReturnCmpLong3) {
+  const uint16_t data[] = FOUR_REGISTERS_CODE_ITEM(
+    Instruction::CONST_WIDE_16 | 0 << 8, 5,
+    Instruction::CONST_WIDE_16 | 2 << 8, 5,
+    Instruction::CMP_LONG | 0 << 8, 2 << 8 | 0,
+    Instruction::RETURN | 0 << 8);
+
+  TestCode(data, true, 0);
+}
+
 }  // namespace art
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "constant_folding.h"
+
+#include <type_traits>
+
+namespace art {
+
+// Computes the arithmetic operation `instruction` on `left` and `right`, with
+// the wrap-around semantics of Java. Returns false if the operation is not
+// foldable.
+template <typename T>
+static bool ComputeArithmetic(HInstruction* instruction, T left, T right, T* result) {
+  typedef typename std::make_unsigned<T>::type U;
+  if (instruction->AsAdd() != nullptr) {
+    *result = static_cast<T>(static_cast<U>(left) + static_cast<U>(right));
+  } else if (instruction->AsSub() != nullptr) {
+    *result = static_cast<T>(static_cast<U>(left) - static_cast<U>(right));
+  } else if (instruction->AsMul() != nullptr) {
+    *result = static_cast<T>(static_cast<U>(left) * static_cast<U>(right));
+  } else if (instruction->AsDiv() != nullptr || instruction->AsRem() != nullptr) {
+    if (right == 0) {
+      return false;
+    }
+    bool is_div = instruction->AsDiv() != nullptr;
+    if (right == -1) {
+      // The minimum value divided by -1 overflows to itself in Java.
+      *result = is_div ? static_cast<T>(static_cast<U>(0) - static_cast<U>(left)) : 0;
+    } else {
+      *result = is_div ? left / right : left % right;
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool EvaluateCondition(IfCondition condition, int32_t left, int32_t right) {
+  switch (condition) {
+    case kCondEQ: return left == right;
+    case kCondNE: return left != right;
+    case kCondLT: return left < right;
+    case kCondLE: return left <= right;
+    case kCondGT: return left > right;
+    case kCondGE: return left >= right;
+  }
+  LOG(FATAL) << "Unreachable";
+  return false;
+}
+
+HInstruction* ConstantFolding::AddConstant(HInstruction* constant, HInstruction* folded) {
+  HBasicBlock* entry = graph_->GetEntryBlock();
+  // A folded instruction of the entry block has users before the end of it.
+  HInstruction* cursor = folded->GetBlock() == entry ? folded : entry->GetLastInstruction();
+  entry->InsertInstructionBefore(constant, cursor);
+  return constant;
+}
+
+HInstruction* ConstantFolding::TryFold(HInstruction* instruction) {
+  if (instruction->AsDivZeroCheck() != nullptr) {
+    HInstruction* input = instruction->InputAt(0);
+    HIntConstant* int_input = input->AsIntConstant();
+    HLongConstant* long_input = input->AsLongConstant();
+    if ((int_input != nullptr && int_input->GetValue() != 0)
+        || (long_input != nullptr && long_input->GetValue() != 0)) {
+      return input;
+    }
+    return nullptr;
+  }
+
+  ArenaAllocator* arena = graph_->GetArena();
+  if (instruction->AsNot() != nullptr) {
+    HIntConstant* input = instruction->InputAt(0)->AsIntConstant();
+    if (input == nullptr) {
+      return nullptr;
+    }
+    return AddConstant(new (arena) HIntConstant(input->GetValue() == 0 ? 1 : 0), instruction);
+  }
+
+  if (instruction->InputCount() != 2 || instruction->AsPhi() != nullptr) {
+    return nullptr;
+  }
+  HIntConstant* int_left = instruction->InputAt(0)->AsIntConstant();
+  HIntConstant* int_right = instruction->InputAt(1)->AsIntConstant();
+  HLongConstant* long_left = instruction->InputAt(0)->AsLongConstant();
+  HLongConstant* long_right = instruction->InputAt(1)->AsLongConstant();
+
+  HCondition* condition = instruction->AsCondition();
+  if (condition != nullptr) {
+    if (int_left == nullptr || int_right == nullptr) {
+      return nullptr;
+    }
+    bool value = EvaluateCondition(
+        condition->GetCondition(), int_left->GetValue(), int_right->GetValue());
+    return AddConstant(new (arena) HIntConstant(value ? 1 : 0), instruction);
+  }
+
+  HCompare* compare = instruction->AsCompare();
+  if (compare != nullptr) {
+    // Floating point comparisons have constant inputs of the wrong type, the
+    // bits of the values.
+    if (compare->GetInputType() != Primitive::kPrimLong
+        || long_left == nullptr || long_right == nullptr) {
+      return nullptr;
+    }
+    int64_t left = long_left->GetValue();
+    int64_t right = long_right->GetValue();
+    int32_t value = left == right ? 0 : (left < right ? -1 : 1);
+    return AddConstant(new (arena) HIntConstant(value), instruction);
+  }
+
+  switch (instruction->GetType()) {
+    case Primitive::kPrimInt: {
+      int32_t result;
+      if (int_left != nullptr && int_right != nullptr
+          && ComputeArithmetic(instruction, int_left->GetValue(), int_right->GetValue(), &result)) {
+        return AddConstant(new (arena) HIntConstant(result), instruction);
+      }
+      return nullptr;
+    }
+    case Primitive::kPrimLong: {
+      int64_t result;
+      if (long_left != nullptr && long_right != nullptr
+          && ComputeArithmetic(
+              instruction, long_left->GetValue(), long_right->GetValue(), &result)) {
+        return AddConstant(new (arena) HLongConstant(result), instruction);
+      }
+      return nullptr;
+    }
+    default:
+      return nullptr;
+  }
+}
+
+void ConstantFolding::Run() {
+  // Visiting in reverse post order folds the inputs of an instruction before
+  // the instruction. Phis are left to the phi elimination.
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HInstructionIterator inst_it(block->GetInstructions()); !inst_it.Done();
+         inst_it.Advance()) {
+      HInstruction* instruction = inst_it.Current();
+      HInstruction* value = TryFold(instruction);
+      if (value != nullptr) {
+        instruction->ReplaceWith(value);
+        block->RemoveInstruction(instruction);
+      }
+    }
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_CONSTANT_FOLDING_H_
+#define ART_COMPILER_OPTIMIZING_CONSTANT_FOLDING_H_
+
+#include "nodes.h"
+
+namespace art {
+
+/**
+ * Constant folding: replaces the arithmetic operations, comparisons and
+ * division checks whose inputs are constants with their result. The new
+ * constants are added to the entry block. Divisions by zero are left to
+ * throw at run time.
+ */
+class ConstantFolding : public ValueObject {
+ public:
+  explicit ConstantFolding(HGraph* graph) : graph_(graph) {}
+
+  void Run();
+
+ private:
+  // Returns the value of `instruction` if it can be computed at compile
+  // time, or null otherwise.
+  HInstruction* TryFold(HInstruction* instruction);
+
+  // Adds `constant`, the value of `folded`, to the entry block.
+  HInstruction* AddConstant(HInstruction* constant, HInstruction* folded);
+
+  HGraph* const graph_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConstantFolding);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_CONSTANT_FOLDING_H_
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "constant_folding.h"
+#include "dead_code_elimination.h"
+#include "instruction_simplifier.h"
+#include "nodes.h"
+#include "utils/arena_allocator.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+/**
+ * Fixture building the graph of a method without branches:
+ *
+ *   entry -> block -> exit
+ *
+ * The tests add their instructions to `block`, before its return.
+ */
+class ConstantFoldingTest : public testing::Test {
+ public:
+  ConstantFoldingTest() : pool_(), allocator_(&pool_) {
+    graph_ = new (&allocator_) HGraph(&allocator_);
+  }
+
+  void BuildGraph(Primitive::Type parameter_type) {
+    entry_ = new (&allocator_) HBasicBlock(graph_);
+    block_ = new (&allocator_) HBasicBlock(graph_);
+    exit_ = new (&allocator_) HBasicBlock(graph_);
+
+    graph_->AddBlock(entry_);
+    graph_->AddBlock(block_);
+    graph_->AddBlock(exit_);
+    graph_->SetEntryBlock(entry_);
+    graph_->SetExitBlock(exit_);
+
+    entry_->AddSuccessor(block_);
+    block_->AddSuccessor(exit_);
+
+    parameter_ = new (&allocator_) HParameterValue(0, parameter_type);
+    entry_->AddInstruction(parameter_);
+    entry_->AddInstruction(new (&allocator_) HGoto());
+    block_->AddInstruction(new (&allocator_) HReturnVoid());
+    exit_->AddInstruction(new (&allocator_) HExit());
+  }
+
+  HInstruction* AddConstant(int32_t value) {
+    HInstruction* constant = new (&allocator_) HIntConstant(value);
+    entry_->InsertInstructionBefore(constant, entry_->GetLastInstruction());
+    return constant;
+  }
+
+  // Adds `instruction` to the block, and a return of its value, which
+  // replaces the return void.
+  void AddReturned(HInstruction* instruction) {
+    block_->InsertInstructionBefore(instruction, block_->GetLastInstruction());
+    HInstruction* return_void = block_->GetLastInstruction();
+    block_->AddInstruction(new (&allocator_) HReturn(instruction));
+    block_->RemoveInstruction(return_void);
+  }
+
+  HInstruction* ReturnedValue() const {
+    return block_->GetLastInstruction()->InputAt(0);
+  }
+
+  void RunPasses() {
+    graph_->BuildDominatorTree();
+    graph_->TransformToSSA();
+    ConstantFolding(graph_).Run();
+    InstructionSimplifier(graph_).Run();
+    DeadCodeElimination(graph_).Run();
+  }
+
+  ArenaPool pool_;
+  ArenaAllocator allocator_;
+  HGraph* graph_;
+
+  HBasicBlock* entry_;
+  HBasicBlock* block_;
+  HBasicBlock* exit_;
+
+  HInstruction* parameter_;
+};
+
+TEST_F(ConstantFoldingTest, FoldArithmetic) {
+  BuildGraph(Primitive::kPrimInt);
+  HInstruction* add = new (&allocator_) HAdd(Primitive::kPrimInt, AddConstant(3), AddConstant(4));
+  block_->InsertInstructionBefore(add, block_->GetLastInstruction());
+  HInstruction* mul = new (&allocator_) HMul(Primitive::kPrimInt, add, AddConstant(0x40000000));
+  AddReturned(mul);
+
+  RunPasses();
+
+  // The multiplication wraps around, and is folded once its input is.
+  ASSERT_TRUE(ReturnedValue()->AsIntConstant() != nullptr);
+  ASSERT_EQ(ReturnedValue()->AsIntConstant()->GetValue(), static_cast<int32_t>(0xc0000000));
+  ASSERT_EQ(ReturnedValue()->GetBlock(), entry_);
+  ASSERT_TRUE(add->GetBlock() == nullptr);
+  ASSERT_TRUE(mul->GetBlock() == nullptr);
+}
+
+TEST_F(ConstantFoldingTest, FoldMinValueDivision) {
+  BuildGraph(Primitive::kPrimInt);
+  HInstruction* div = new (&allocator_) HDiv(
+      Primitive::kPrimInt, AddConstant(static_cast<int32_t>(0x80000000)), AddConstant(-1));
+  AddReturned(div);
+
+  RunPasses();
+
+  ASSERT_TRUE(ReturnedValue()->AsIntConstant() != nullptr);
+  ASSERT_EQ(ReturnedValue()->AsIntConstant()->GetValue(), static_cast<int32_t>(0x80000000));
+}
+
+TEST_F(ConstantFoldingTest, NoDivisionByZeroFolding) {
+  BuildGraph(Primitive::kPrimInt);
+  HInstruction* div = new (&allocator_) HDiv(Primitive::kPrimInt, AddConstant(1), AddConstant(0));
+  AddReturned(div);
+
+  RunPasses();
+
+  ASSERT_EQ(ReturnedValue(), div);
+}
+
+TEST_F(ConstantFoldingTest, FoldCondition) {
+  BuildGraph(Primitive::kPrimInt);
+  HInstruction* less_than = new (&allocator_) HLessThan(AddConstant(-2), AddConstant(1));
+  AddReturned(less_than);
+
+  RunPasses();
+
+  ASSERT_TRUE(ReturnedValue()->AsIntConstant() != nullptr);
+  ASSERT_EQ(ReturnedValue()->AsIntConstant()->GetValue(), 1);
+}
+
+TEST_F(ConstantFoldingTest, SimplifyAddZero) {
+  BuildGraph(Primitive::kPrimInt);
+  HInstruction* add = new (&allocator_) HAdd(Primitive::kPrimInt, parameter_, AddConstant(0));
+  AddReturned(add);
+
+  RunPasses();
+
+  ASSERT_EQ(ReturnedValue(), parameter_);
+  ASSERT_TRUE(add->GetBlock() == nullptr);
+}
+
+TEST_F(ConstantFoldingTest, DeadCodeElimination) {
+  BuildGraph(Primitive::kPrimNot);
+  HInstruction* get_field =
+      new (&allocator_) HInstanceFieldGet(parameter_, Primitive::kPrimInt, MemberOffset(10));
+  block_->InsertInstructionBefore(get_field, block_->GetLastInstruction());
+  HInstruction* add = new (&allocator_) HAdd(Primitive::kPrimInt, get_field, get_field);
+  block_->InsertInstructionBefore(add, block_->GetLastInstruction());
+  HInstruction* null_check = new (&allocator_) HNullCheck(parameter_, 0);
+  block_->InsertInstructionBefore(null_check, block_->GetLastInstruction());
+
+  RunPasses();
+
+  // The unused addition and the load it used are removed, the null check
+  // may throw and is kept.
+  ASSERT_TRUE(add->GetBlock() == nullptr);
+  ASSERT_TRUE(get_field->GetBlock() == nullptr);
+  ASSERT_EQ(null_check->GetBlock(), block_);
+}
+
+}  // namespace art
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dead_code_elimination.h"
+
+namespace art {
+
+void DeadCodeElimination::Run() {
+  // Visiting in post order, and the instructions of a block backwards, sees
+  // the users of an instruction before the instruction, so that a chain of
+  // dead instructions is removed in one pass. Only the inputs of the phis of
+  // loop headers are seen after them, and phis are not removed.
+  for (HPostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HBackwardInstructionIterator inst_it(block->GetInstructions()); !inst_it.Done();
+         inst_it.Advance()) {
+      HInstruction* instruction = inst_it.Current();
+      if (!instruction->HasUses()
+          && instruction->CanBeMoved()
+          && !instruction->CanThrow()
+          && !instruction->GetSideEffects().HasSideEffects()) {
+        block->RemoveInstruction(instruction);
+      }
+    }
+  }
+}
+
+}  // namespace art
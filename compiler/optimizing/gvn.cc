@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gvn.h"
+
+namespace art {
+
+void ValueSet::Add(HInstruction* instruction) {
+  DCHECK(Lookup(instruction) == nullptr);
+  size_t hash_code = instruction->ComputeHashCode();
+  size_t index = hash_code % kNumberOfBuckets;
+  buckets_[index] = new (allocator_) ValueSetNode(instruction, hash_code, buckets_[index]);
+  ++number_of_entries_;
+}
+
+HInstruction* ValueSet::Lookup(HInstruction* instruction) const {
+  size_t hash_code = instruction->ComputeHashCode();
+  for (ValueSetNode* node = buckets_[hash_code % kNumberOfBuckets];
+       node != nullptr;
+       node = node->GetNext()) {
+    if (node->GetHashCode() == hash_code && node->GetInstruction()->Equals(instruction)) {
+      return node->GetInstruction();
+    }
+  }
+  return nullptr;
+}
+
+bool ValueSet::Contains(HInstruction* instruction) const {
+  size_t hash_code = instruction->ComputeHashCode();
+  for (ValueSetNode* node = buckets_[hash_code % kNumberOfBuckets];
+       node != nullptr;
+       node = node->GetNext()) {
+    if (node->GetInstruction() == instruction) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ValueSet::Kill(SideEffects side_effects) {
+  if (!side_effects.HasSideEffects()) {
+    return;
+  }
+  for (size_t i = 0; i < kNumberOfBuckets; ++i) {
+    ValueSetNode* previous = nullptr;
+    for (ValueSetNode* node = buckets_[i]; node != nullptr; node = node->GetNext()) {
+      if (node->GetInstruction()->GetSideEffects().DependsOn(side_effects)) {
+        if (previous == nullptr) {
+          buckets_[i] = node->GetNext();
+        } else {
+          previous->SetNext(node->GetNext());
+        }
+        --number_of_entries_;
+      } else {
+        previous = node;
+      }
+    }
+  }
+}
+
+ValueSet* ValueSet::Copy() const {
+  ValueSet* copy = new (allocator_) ValueSet(allocator_);
+  for (size_t i = 0; i < kNumberOfBuckets; ++i) {
+    for (ValueSetNode* node = buckets_[i]; node != nullptr; node = node->GetNext()) {
+      copy->buckets_[i] = new (allocator_) ValueSetNode(
+          node->GetInstruction(), node->GetHashCode(), copy->buckets_[i]);
+    }
+  }
+  copy->number_of_entries_ = number_of_entries_;
+  return copy;
+}
+
+void ValueSet::IntersectionWith(ValueSet* other) {
+  for (size_t i = 0; i < kNumberOfBuckets; ++i) {
+    ValueSetNode* previous = nullptr;
+    for (ValueSetNode* node = buckets_[i]; node != nullptr; node = node->GetNext()) {
+      if (!other->Contains(node->GetInstruction())) {
+        if (previous == nullptr) {
+          buckets_[i] = node->GetNext();
+        } else {
+          previous->SetNext(node->GetNext());
+        }
+        --number_of_entries_;
+      } else {
+        previous = node;
+      }
+    }
+  }
+}
+
+void GlobalValueNumberer::Run() {
+  DCHECK(side_effects_.HasRun());
+  sets_.Put(graph_->GetEntryBlock()->GetBlockId(), new (allocator_) ValueSet(allocator_));
+
+  // Visit blocks in reverse post order, so that the predecessors of a block
+  // are visited before it, except for back edges of loops.
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    VisitBasicBlock(it.Current());
+  }
+}
+
+void GlobalValueNumberer::VisitBasicBlock(HBasicBlock* block) {
+  ValueSet* set = nullptr;
+  const GrowableArray<HBasicBlock*>& predecessors = block->GetPredecessors();
+  if (predecessors.Size() == 0) {
+    DCHECK_EQ(block, graph_->GetEntryBlock());
+    set = sets_.Get(block->GetBlockId());
+  } else if (block->IsLoopHeader()) {
+    // Only the values computed before the loop, and not written by the loop,
+    // are available in the header.
+    HBasicBlock* pre_header = block->GetLoopInformation()->GetPreHeader();
+    set = sets_.Get(pre_header->GetBlockId());
+    if (pre_header->GetSuccessors().Size() != 1) {
+      set = set->Copy();
+    }
+    set->Kill(side_effects_.GetLoopEffects(block));
+  } else {
+    HBasicBlock* first = predecessors.Get(0);
+    set = sets_.Get(first->GetBlockId());
+    if (first->GetSuccessors().Size() != 1) {
+      set = set->Copy();
+    }
+    // At a merge point, only the values available in all the predecessors
+    // are available.
+    for (size_t i = 1, e = predecessors.Size(); i < e; ++i) {
+      set->IntersectionWith(sets_.Get(predecessors.Get(i)->GetBlockId()));
+    }
+  }
+  sets_.Put(block->GetBlockId(), set);
+
+  for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* current = it.Current();
+    set->Kill(current->GetSideEffects());
+    if (current->CanBeMoved()) {
+      HInstruction* existing = set->Lookup(current);
+      if (existing != nullptr) {
+        current->ReplaceWith(existing);
+        block->RemoveInstruction(current);
+      } else {
+        set->Add(current);
+      }
+    }
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_GVN_H_
+#define ART_COMPILER_OPTIMIZING_GVN_H_
+
+#include "nodes.h"
+#include "side_effects_analysis.h"
+
+namespace art {
+
+/**
+ * A node in a bucket of a ValueSet. Encodes the instruction, its hash code,
+ * and the next node in the bucket.
+ */
+class ValueSetNode : public ArenaObject {
+ public:
+  ValueSetNode(HInstruction* instruction, size_t hash_code, ValueSetNode* next)
+      : instruction_(instruction), hash_code_(hash_code), next_(next) {}
+
+  size_t GetHashCode() const { return hash_code_; }
+  HInstruction* GetInstruction() const { return instruction_; }
+  ValueSetNode* GetNext() const { return next_; }
+  void SetNext(ValueSetNode* node) { next_ = node; }
+
+ private:
+  HInstruction* const instruction_;
+  const size_t hash_code_;
+  ValueSetNode* next_;
+
+  DISALLOW_COPY_AND_ASSIGN(ValueSetNode);
+};
+
+/**
+ * A ValueSet holds instructions that can replace other instructions. It is
+ * updated through the `Add` method, and the `Kill` method. The `Kill` method
+ * removes instructions that are affected by the given side effect.
+ *
+ * The `Lookup` method returns an equivalent instruction to the given instruction
+ * if there is one in the set. In GVN, we would say those instructions have the
+ * same "number".
+ */
+class ValueSet : public ArenaObject {
+ public:
+  explicit ValueSet(ArenaAllocator* allocator)
+      : allocator_(allocator), number_of_entries_(0) {
+    for (size_t i = 0; i < kNumberOfBuckets; ++i) {
+      buckets_[i] = nullptr;
+    }
+  }
+
+  // Adds an instruction in the set.
+  void Add(HInstruction* instruction);
+
+  // If in the set, returns an equivalent instruction to the given instruction. Returns
+  // null otherwise.
+  HInstruction* Lookup(HInstruction* instruction) const;
+
+  // Removes all instructions in the set that are affected by the given side effects.
+  void Kill(SideEffects side_effects);
+
+  // Returns a copy of this set.
+  ValueSet* Copy() const;
+
+  // Removes all instructions in the set that are not in `other`.
+  void IntersectionWith(ValueSet* other);
+
+  bool IsEmpty() const { return number_of_entries_ == 0; }
+  size_t GetNumberOfEntries() const { return number_of_entries_; }
+
+ private:
+  // Returns whether `instruction` itself is in the set.
+  bool Contains(HInstruction* instruction) const;
+
+  static constexpr size_t kNumberOfBuckets = 16;
+
+  ArenaAllocator* const allocator_;
+
+  // The number of entries in the set.
+  size_t number_of_entries_;
+
+  // Instructions of the set, chained by the hash code of the instruction.
+  ValueSetNode* buckets_[kNumberOfBuckets];
+
+  DISALLOW_COPY_AND_ASSIGN(ValueSet);
+};
+
+/**
+ * Optimization phase that removes redundant instructions: an instruction that
+ * can be moved is replaced by an equal instruction that dominates it, as long
+ * as no instruction in between writes the memory it depends on.
+ */
+class GlobalValueNumberer : public ValueObject {
+ public:
+  GlobalValueNumberer(ArenaAllocator* allocator,
+                      HGraph* graph,
+                      const SideEffectsAnalysis& side_effects)
+      : allocator_(allocator),
+        graph_(graph),
+        side_effects_(side_effects),
+        sets_(allocator, graph->GetBlocks().Size()) {
+    sets_.SetSize(graph->GetBlocks().Size());
+  }
+
+  void Run();
+
+ private:
+  // Per-block GVN. The ValueSet of the block is computed from the ones of
+  // its predecessors, which have all been visited, except for back edges.
+  void VisitBasicBlock(HBasicBlock* block);
+
+  ArenaAllocator* const allocator_;
+  HGraph* const graph_;
+  const SideEffectsAnalysis& side_effects_;
+
+  // The ValueSet at the end of each visited block, indexed by block id.
+  // A set is reused by the successor of a block that has only one
+  // successor, and copied otherwise.
+  GrowableArray<ValueSet*> sets_;
+
+  DISALLOW_COPY_AND_ASSIGN(GlobalValueNumberer);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_GVN_H_
@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gvn.h"
+#include "nodes.h"
+#include "side_effects_analysis.h"
+#include "utils/arena_allocator.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+static void RunGvn(HGraph* graph) {
+  graph->BuildDominatorTree();
+  graph->TransformToSSA();
+  ASSERT_TRUE(graph->FindNaturalLoops());
+  SideEffectsAnalysis side_effects(graph);
+  side_effects.Run();
+  GlobalValueNumberer(graph->GetArena(), graph, side_effects).Run();
+}
+
+TEST(GVNTest, LocalFieldElimination) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = new (&allocator) HGraph(&allocator);
+  HBasicBlock* entry = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(entry);
+  graph->SetEntryBlock(entry);
+  HInstruction* parameter = new (&allocator) HParameterValue(0, Primitive::kPrimNot);
+  entry->AddInstruction(parameter);
+
+  HBasicBlock* block = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(block);
+  entry->AddSuccessor(block);
+
+  HInstruction* get1 =
+      new (&allocator) HInstanceFieldGet(parameter, Primitive::kPrimNot, MemberOffset(42));
+  HInstruction* get2 =
+      new (&allocator) HInstanceFieldGet(parameter, Primitive::kPrimNot, MemberOffset(42));
+  HInstruction* get3 =
+      new (&allocator) HInstanceFieldGet(parameter, Primitive::kPrimNot, MemberOffset(43));
+  HInstruction* set =
+      new (&allocator) HInstanceFieldSet(parameter, parameter, Primitive::kPrimNot,
+                                         MemberOffset(42));
+  HInstruction* get4 =
+      new (&allocator) HInstanceFieldGet(parameter, Primitive::kPrimNot, MemberOffset(42));
+  block->AddInstruction(get1);
+  block->AddInstruction(get2);
+  block->AddInstruction(get3);
+  block->AddInstruction(set);
+  block->AddInstruction(get4);
+  HInstruction* use = new (&allocator) HReturn(get2);
+  block->AddInstruction(use);
+
+  HBasicBlock* exit = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(exit);
+  graph->SetExitBlock(exit);
+  block->AddSuccessor(exit);
+  exit->AddInstruction(new (&allocator) HExit());
+
+  RunGvn(graph);
+
+  // The second load of the field is replaced by the first one. The load of
+  // another field, and the load after the store, are kept.
+  ASSERT_EQ(get1->GetBlock(), block);
+  ASSERT_EQ(get2->GetBlock(), nullptr);
+  ASSERT_EQ(get3->GetBlock(), block);
+  ASSERT_EQ(get4->GetBlock(), block);
+  ASSERT_EQ(use->InputAt(0), get1);
+}
+
+TEST(GVNTest, GlobalFieldElimination) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = new (&allocator) HGraph(&allocator);
+  HBasicBlock* entry = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(entry);
+  graph->SetEntryBlock(entry);
+  HInstruction* parameter = new (&allocator) HParameterValue(0, Primitive::kPrimNot);
+  entry->AddInstruction(parameter);
+
+  HBasicBlock* block = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(block);
+  entry->AddSuccessor(block);
+  HInstruction* get_in_block =
+      new (&allocator) HInstanceFieldGet(parameter, Primitive::kPrimBoolean, MemberOffset(42));
+  block->AddInstruction(get_in_block);
+  block->AddInstruction(new (&allocator) HIf(get_in_block));
+
+  HBasicBlock* then = new (&allocator) HBasicBlock(graph);
+  HBasicBlock* else_ = new (&allocator) HBasicBlock(graph);
+  HBasicBlock* join = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(then);
+  graph->AddBlock(else_);
+  graph->AddBlock(join);
+
+  block->AddSuccessor(then);
+  block->AddSuccessor(else_);
+  then->AddSuccessor(join);
+  else_->AddSuccessor(join);
+
+  HInstruction* get_in_then =
+      new (&allocator) HInstanceFieldGet(parameter, Primitive::kPrimBoolean, MemberOffset(42));
+  then->AddInstruction(get_in_then);
+  then->AddInstruction(new (&allocator) HGoto());
+  HInstruction* get_in_else =
+      new (&allocator) HInstanceFieldGet(parameter, Primitive::kPrimBoolean, MemberOffset(42));
+  else_->AddInstruction(get_in_else);
+  else_->AddInstruction(new (&allocator) HGoto());
+  HInstruction* get_in_join =
+      new (&allocator) HInstanceFieldGet(parameter, Primitive::kPrimBoolean, MemberOffset(42));
+  join->AddInstruction(get_in_join);
+  join->AddInstruction(new (&allocator) HReturnVoid());
+
+  HBasicBlock* exit = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(exit);
+  graph->SetExitBlock(exit);
+  join->AddSuccessor(exit);
+  exit->AddInstruction(new (&allocator) HExit());
+
+  RunGvn(graph);
+
+  // All the loads are replaced by the one that dominates them.
+  ASSERT_EQ(get_in_block->GetBlock(), block);
+  ASSERT_EQ(get_in_then->GetBlock(), nullptr);
+  ASSERT_EQ(get_in_else->GetBlock(), nullptr);
+  ASSERT_EQ(get_in_join->GetBlock(), nullptr);
+}
+
+TEST(GVNTest, MergeKill) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = new (&allocator) HGraph(&allocator);
+  HBasicBlock* entry = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(entry);
+  graph->SetEntryBlock(entry);
+  HInstruction* parameter = new (&allocator) HParameterValue(0, Primitive::kPrimNot);
+  entry->AddInstruction(parameter);
+
+  HBasicBlock* block = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(block);
+  entry->AddSuccessor(block);
+  HInstruction* get_in_block =
+      new (&allocator) HInstanceFieldGet(parameter, Primitive::kPrimBoolean, MemberOffset(42));
+  block->AddInstruction(get_in_block);
+  block->AddInstruction(new (&allocator) HIf(get_in_block));
+
+  HBasicBlock* then = new (&allocator) HBasicBlock(graph);
+  HBasicBlock* else_ = new (&allocator) HBasicBlock(graph);
+  HBasicBlock* join = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(then);
+  graph->AddBlock(else_);
+  graph->AddBlock(join);
+
+  block->AddSuccessor(then);
+  block->AddSuccessor(else_);
+  then->AddSuccessor(join);
+  else_->AddSuccessor(join);
+
+  then->AddInstruction(new (&allocator) HInstanceFieldSet(
+      parameter, get_in_block, Primitive::kPrimBoolean, MemberOffset(42)));
+  then->AddInstruction(new (&allocator) HGoto());
+  else_->AddInstruction(new (&allocator) HGoto());
+  HInstruction* get_in_join =
+      new (&allocator) HInstanceFieldGet(parameter, Primitive::kPrimBoolean, MemberOffset(42));
+  join->AddInstruction(get_in_join);
+  join->AddInstruction(new (&allocator) HReturnVoid());
+
+  HBasicBlock* exit = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(exit);
+  graph->SetExitBlock(exit);
+  join->AddSuccessor(exit);
+  exit->AddInstruction(new (&allocator) HExit());
+
+  RunGvn(graph);
+
+  // The store on one path to the join block kills the first load.
+  ASSERT_EQ(get_in_block->GetBlock(), block);
+  ASSERT_EQ(get_in_join->GetBlock(), join);
+}
+
+TEST(GVNTest, LoopFieldElimination) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+
+  HGraph* graph = new (&allocator) HGraph(&allocator);
+  HBasicBlock* entry = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(entry);
+  graph->SetEntryBlock(entry);
+
+  HInstruction* parameter = new (&allocator) HParameterValue(0, Primitive::kPrimNot);
+  entry->AddInstruction(parameter);
+
+  HBasicBlock* block = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(block);
+  entry->AddSuccessor(block);
+  HInstruction* get_in_block =
+      new (&allocator) HInstanceFieldGet(parameter, Primitive::kPrimBoolean, MemberOffset(42));
+  block->AddInstruction(get_in_block);
+  block->AddInstruction(new (&allocator) HGoto());
+
+  HBasicBlock* loop_header = new (&allocator) HBasicBlock(graph);
+  HBasicBlock* loop_body = new (&allocator) HBasicBlock(graph);
+  HBasicBlock* exit = new (&allocator) HBasicBlock(graph);
+
+  graph->AddBlock(loop_header);
+  graph->AddBlock(loop_body);
+  graph->AddBlock(exit);
+  block->AddSuccessor(loop_header);
+  loop_header->AddSuccessor(loop_body);
+  loop_header->AddSuccessor(exit);
+  loop_body->AddSuccessor(loop_header);
+
+  HInstruction* get_in_header =
+      new (&allocator) HInstanceFieldGet(parameter, Primitive::kPrimBoolean, MemberOffset(42));
+  loop_header->AddInstruction(get_in_header);
+  loop_header->AddInstruction(new (&allocator) HIf(get_in_header));
+
+  // Kill inside the loop body to prevent field gets inside the loop header
+  // and the body to be GVN'ed.
+  HInstruction* get_in_body =
+      new (&allocator) HInstanceFieldGet(parameter, Primitive::kPrimBoolean, MemberOffset(42));
+  loop_body->AddInstruction(get_in_body);
+  loop_body->AddInstruction(new (&allocator) HInstanceFieldSet(
+      parameter, get_in_body, Primitive::kPrimBoolean, MemberOffset(42)));
+  loop_body->AddInstruction(new (&allocator) HGoto());
+
+  HInstruction* get_in_exit =
+      new (&allocator) HInstanceFieldGet(parameter, Primitive::kPrimBoolean, MemberOffset(42));
+  exit->AddInstruction(get_in_exit);
+  exit->AddInstruction(new (&allocator) HExit());
+  graph->SetExitBlock(exit);
+
+  RunGvn(graph);
+
+  // The load in the header is kept, because the loop writes the field. The
+  // loads it dominates, before the store, are replaced by it.
+  ASSERT_EQ(get_in_block->GetBlock(), block);
+  ASSERT_EQ(get_in_header->GetBlock(), loop_header);
+  ASSERT_EQ(get_in_body->GetBlock(), nullptr);
+  ASSERT_EQ(get_in_exit->GetBlock(), nullptr);
+}
+
+}  // namespace art
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "instruction_simplifier.h"
+
+namespace art {
+
+// Returns whether `instruction` is the integral constant `value`.
+static bool IsConstant(HInstruction* instruction, int32_t value) {
+  HIntConstant* int_constant = instruction->AsIntConstant();
+  if (int_constant != nullptr) {
+    return int_constant->GetValue() == value;
+  }
+  HLongConstant* long_constant = instruction->AsLongConstant();
+  return long_constant != nullptr && long_constant->GetValue() == value;
+}
+
+// Returns the input `instruction` can be replaced with, or null.
+static HInstruction* Simplify(HInstruction* instruction) {
+  if (instruction->AsNot() != nullptr) {
+    HInstruction* input = instruction->InputAt(0);
+    return input->AsNot() != nullptr ? input->InputAt(0) : nullptr;
+  }
+
+  // Adding zero to a floating point value is not an identity, -0.0 + 0.0 is
+  // 0.0, and their constants are bits of the wrong type.
+  Primitive::Type type = instruction->GetType();
+  if ((type != Primitive::kPrimInt && type != Primitive::kPrimLong)
+      || instruction->InputCount() != 2) {
+    return nullptr;
+  }
+  HInstruction* left = instruction->InputAt(0);
+  HInstruction* right = instruction->InputAt(1);
+  if (instruction->AsAdd() != nullptr) {
+    if (IsConstant(right, 0)) {
+      return left;
+    } else if (IsConstant(left, 0)) {
+      return right;
+    }
+  } else if (instruction->AsSub() != nullptr) {
+    if (IsConstant(right, 0)) {
+      return left;
+    }
+  } else if (instruction->AsMul() != nullptr) {
+    if (IsConstant(right, 1)) {
+      return left;
+    } else if (IsConstant(left, 1)) {
+      return right;
+    }
+  } else if (instruction->AsDiv() != nullptr) {
+    if (IsConstant(right, 1)) {
+      return left;
+    }
+  }
+  return nullptr;
+}
+
+void InstructionSimplifier::Run() {
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HInstructionIterator inst_it(block->GetInstructions()); !inst_it.Done();
+         inst_it.Advance()) {
+      HInstruction* instruction = inst_it.Current();
+      HInstruction* replacement = Simplify(instruction);
+      if (replacement != nullptr) {
+        instruction->ReplaceWith(replacement);
+        block->RemoveInstruction(instruction);
+      }
+    }
+  }
+}
+
+}  // namespace art
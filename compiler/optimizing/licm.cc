@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "licm.h"
+
+namespace art {
+
+static bool IsPhiOf(HInstruction* instruction, HBasicBlock* block) {
+  return instruction->AsPhi() != nullptr && instruction->GetBlock() == block;
+}
+
+// Returns whether `instruction` has all its inputs defined outside the loop.
+static bool InputsAreDefinedBeforeLoop(HInstruction* instruction) {
+  HLoopInformation* info = instruction->GetBlock()->GetLoopInformation();
+  for (HInputIterator it(instruction); !it.Done(); it.Advance()) {
+    if (info->Contains(*it.Current()->GetBlock())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns whether the environment of `instruction`, which is in a loop
+// header, only refers to values defined outside the loop, or to phis of the
+// header, which can be replaced by their value on entry of the loop.
+static bool EnvironmentIsValidBeforeLoop(HInstruction* instruction) {
+  HEnvironment* environment = instruction->GetEnvironment();
+  if (environment == nullptr) {
+    return true;
+  }
+  HBasicBlock* header = instruction->GetBlock();
+  HLoopInformation* info = header->GetLoopInformation();
+  GrowableArray<HInstruction*>* vregs = environment->GetVRegs();
+  for (size_t i = 0, e = vregs->Size(); i < e; ++i) {
+    HInstruction* input = vregs->Get(i);
+    if (input != nullptr && info->Contains(*input->GetBlock()) && !IsPhiOf(input, header)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Update the environment of `instruction`, which is moved before `header`,
+// with the values the phis of the header have on entry of the loop.
+static void UpdateEnvironmentForPreHeader(HInstruction* instruction, HBasicBlock* header) {
+  HEnvironment* environment = instruction->GetEnvironment();
+  if (environment == nullptr) {
+    return;
+  }
+  size_t pre_header_index =
+      header->GetPredecessorIndexOf(header->GetLoopInformation()->GetPreHeader());
+  GrowableArray<HInstruction*>* vregs = environment->GetVRegs();
+  for (size_t i = 0, e = vregs->Size(); i < e; ++i) {
+    HInstruction* input = vregs->Get(i);
+    if (input != nullptr && IsPhiOf(input, header)) {
+      environment->ReplaceEnvAt(i, input->InputAt(pre_header_index));
+    }
+  }
+}
+
+void LICM::Run() {
+  DCHECK(side_effects_.HasRun());
+
+  // Visit inner loops first, so that the instructions they hoist are
+  // candidates for the outer loops.
+  for (HPostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* header = it.Current();
+    if (!header->IsLoopHeader()) {
+      continue;
+    }
+
+    HLoopInformation* loop_info = header->GetLoopInformation();
+    HBasicBlock* pre_header = loop_info->GetPreHeader();
+    SideEffects loop_effects = side_effects_.GetLoopEffects(header);
+
+    // Visit the blocks of the loop in reverse post order, so that an
+    // instruction is visited after its inputs. Blocks of inner loops have
+    // already been visited with their loop.
+    for (HReversePostOrderIterator block_it(*graph_); !block_it.Done(); block_it.Advance()) {
+      HBasicBlock* block = block_it.Current();
+      if (block->GetLoopInformation() != loop_info) {
+        continue;
+      }
+
+      // Whether an instruction that stays in the loop, and that throws or
+      // writes memory, has been seen. A throwing instruction after it is
+      // not always executed first, when the loop is entered.
+      bool found_visible_instruction = (block != header);
+      for (HInstructionIterator inst_it(block->GetInstructions());
+           !inst_it.Done();
+           inst_it.Advance()) {
+        HInstruction* instruction = inst_it.Current();
+        if (instruction->CanBeMoved()
+            && InputsAreDefinedBeforeLoop(instruction)
+            && !instruction->GetSideEffects().DependsOn(loop_effects)
+            && (!instruction->CanThrow()
+                || (!found_visible_instruction && EnvironmentIsValidBeforeLoop(instruction)))) {
+          UpdateEnvironmentForPreHeader(instruction, header);
+          instruction->MoveBefore(pre_header->GetLastInstruction());
+        } else if (instruction->CanThrow() || instruction->GetSideEffects().HasSideEffects()) {
+          found_visible_instruction = true;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "licm.h"
+#include "nodes.h"
+#include "side_effects_analysis.h"
+#include "utils/arena_allocator.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+/**
+ * Fixture building the graph of a loop:
+ *
+ *        entry
+ *          |
+ *        block
+ *          |
+ *        header <---+
+ *        /    \     |
+ *     exit    body -+
+ */
+class LICMTest : public testing::Test {
+ public:
+  LICMTest() : pool_(), allocator_(&pool_) {
+    graph_ = new (&allocator_) HGraph(&allocator_);
+  }
+
+  void BuildLoop() {
+    entry_ = new (&allocator_) HBasicBlock(graph_);
+    block_ = new (&allocator_) HBasicBlock(graph_);
+    header_ = new (&allocator_) HBasicBlock(graph_);
+    body_ = new (&allocator_) HBasicBlock(graph_);
+    exit_ = new (&allocator_) HBasicBlock(graph_);
+
+    graph_->AddBlock(entry_);
+    graph_->AddBlock(block_);
+    graph_->AddBlock(header_);
+    graph_->AddBlock(body_);
+    graph_->AddBlock(exit_);
+    graph_->SetEntryBlock(entry_);
+    graph_->SetExitBlock(exit_);
+
+    entry_->AddSuccessor(block_);
+    block_->AddSuccessor(header_);
+    header_->AddSuccessor(body_);
+    header_->AddSuccessor(exit_);
+    body_->AddSuccessor(header_);
+
+    parameter_ = new (&allocator_) HParameterValue(0, Primitive::kPrimNot);
+    entry_->AddInstruction(parameter_);
+    condition_ = new (&allocator_) HParameterValue(1, Primitive::kPrimBoolean);
+    entry_->AddInstruction(condition_);
+    block_->AddInstruction(new (&allocator_) HGoto());
+    header_->AddInstruction(new (&allocator_) HIf(condition_));
+    body_->AddInstruction(new (&allocator_) HGoto());
+    exit_->AddInstruction(new (&allocator_) HExit());
+  }
+
+  void RunLICM() {
+    graph_->BuildDominatorTree();
+    graph_->TransformToSSA();
+    ASSERT_TRUE(graph_->FindNaturalLoops());
+    SideEffectsAnalysis side_effects(graph_);
+    side_effects.Run();
+    LICM(graph_, side_effects).Run();
+  }
+
+  HBasicBlock* PreHeader() const {
+    return header_->GetLoopInformation()->GetPreHeader();
+  }
+
+  ArenaPool pool_;
+  ArenaAllocator allocator_;
+  HGraph* graph_;
+
+  HBasicBlock* entry_;
+  HBasicBlock* block_;
+  HBasicBlock* header_;
+  HBasicBlock* body_;
+  HBasicBlock* exit_;
+
+  HInstruction* parameter_;
+  HInstruction* condition_;
+};
+
+TEST_F(LICMTest, FieldHoisting) {
+  BuildLoop();
+
+  HInstruction* get_field =
+      new (&allocator_) HInstanceFieldGet(parameter_, Primitive::kPrimLong, MemberOffset(10));
+  body_->InsertInstructionBefore(get_field, body_->GetLastInstruction());
+
+  RunLICM();
+
+  // The loop does not write memory, the load is moved out of it.
+  ASSERT_EQ(get_field->GetBlock(), PreHeader());
+  ASSERT_EQ(get_field->GetNext(), PreHeader()->GetLastInstruction());
+}
+
+TEST_F(LICMTest, NoFieldHoisting) {
+  BuildLoop();
+
+  HInstruction* get_field =
+      new (&allocator_) HInstanceFieldGet(parameter_, Primitive::kPrimInt, MemberOffset(10));
+  body_->InsertInstructionBefore(get_field, body_->GetLastInstruction());
+  HInstruction* set_field = new (&allocator_) HInstanceFieldSet(
+      parameter_, get_field, Primitive::kPrimInt, MemberOffset(20));
+  body_->InsertInstructionBefore(set_field, body_->GetLastInstruction());
+
+  RunLICM();
+
+  // The loop writes a field, which may alias the one loaded.
+  ASSERT_EQ(get_field->GetBlock(), body_);
+  ASSERT_EQ(set_field->GetBlock(), body_);
+}
+
+TEST_F(LICMTest, ArrayHoisting) {
+  BuildLoop();
+
+  HInstruction* index = new (&allocator_) HIntConstant(0);
+  entry_->AddInstruction(index);
+  HInstruction* length = new (&allocator_) HArrayLength(parameter_);
+  header_->InsertInstructionBefore(length, header_->GetLastInstruction());
+  HInstruction* check = new (&allocator_) HBoundsCheck(index, length, 0);
+  header_->InsertInstructionBefore(check, header_->GetLastInstruction());
+  HInstruction* get_array = new (&allocator_) HArrayGet(parameter_, check, Primitive::kPrimInt);
+  body_->InsertInstructionBefore(get_array, body_->GetLastInstruction());
+  HInstruction* set_field = new (&allocator_) HInstanceFieldSet(
+      parameter_, get_array, Primitive::kPrimInt, MemberOffset(20));
+  body_->InsertInstructionBefore(set_field, body_->GetLastInstruction());
+
+  RunLICM();
+
+  // The length, the bounds check executed first in the header, and the
+  // array load that only depends on them are moved out of the loop.
+  // Writing a field does not alias array elements.
+  ASSERT_EQ(length->GetBlock(), PreHeader());
+  ASSERT_EQ(check->GetBlock(), PreHeader());
+  ASSERT_EQ(get_array->GetBlock(), PreHeader());
+  ASSERT_EQ(set_field->GetBlock(), body_);
+}
+
+TEST_F(LICMTest, NoCheckHoisting) {
+  BuildLoop();
+
+  HInstruction* index = new (&allocator_) HIntConstant(0);
+  entry_->AddInstruction(index);
+  HInstruction* length = new (&allocator_) HArrayLength(parameter_);
+  body_->InsertInstructionBefore(length, body_->GetLastInstruction());
+  HInstruction* check = new (&allocator_) HBoundsCheck(index, length, 0);
+  body_->InsertInstructionBefore(check, body_->GetLastInstruction());
+
+  RunLICM();
+
+  // The check is not executed when the loop exits without running its body,
+  // so it cannot be moved before the loop.
+  ASSERT_EQ(length->GetBlock(), PreHeader());
+  ASSERT_EQ(check->GetBlock(), body_);
+}
+
+TEST_F(LICMTest, NoArrayHoisting) {
+  BuildLoop();
+
+  HInstruction* index = new (&allocator_) HIntConstant(0);
+  entry_->AddInstruction(index);
+  HInstruction* get_array = new (&allocator_) HArrayGet(parameter_, index, Primitive::kPrimInt);
+  body_->InsertInstructionBefore(get_array, body_->GetLastInstruction());
+  HInstruction* set_array = new (&allocator_) HArraySet(
+      parameter_, index, get_array, Primitive::kPrimInt, 0);
+  body_->InsertInstructionBefore(set_array, body_->GetLastInstruction());
+
+  RunLICM();
+
+  // The loop writes an array element.
+  ASSERT_EQ(get_array->GetBlock(), body_);
+}
+
+}  // namespace art
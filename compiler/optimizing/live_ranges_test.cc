@@ -154,28 +154,28 @@ TEST(LiveRangesTest, CFG3) {
 
   // Test for the 0 constant.
   LiveInterval* interval = liveness.GetInstructionFromSsaIndex(0)->GetLiveInterval();
-  ASSERT_EQ(1u, interval->GetRanges().Size());
-  LiveRange range = interval->GetRanges().Get(0);
-  ASSERT_EQ(2u, range.GetStart());
-  // Last use is the phi at the return block so instruction is live until
-  // the end of the then block.
-  ASSERT_EQ(12u, range.GetEnd());
-
-  // Test for the 4 constant.
-  interval = liveness.GetInstructionFromSsaIndex(1)->GetLiveInterval();
-  // The then branch is a hole for this constant, therefore its interval has 2 ranges.
+  // The else branch is a hole for this constant, therefore its interval has 2 ranges.
   ASSERT_EQ(2u, interval->GetRanges().Size());
-  // First range is the else block.
-  range = interval->GetRanges().Get(0);
+  // First range is the then block.
+  LiveRange range = interval->GetRanges().Get(0);
   ASSERT_EQ(13u, range.GetStart());
   // Last use is the phi at the return block.
   ASSERT_EQ(15u, range.GetEnd());
   // Second range starts from the definition and ends at the if block.
   range = interval->GetRanges().Get(1);
-  ASSERT_EQ(3u, range.GetStart());
+  ASSERT_EQ(2u, range.GetStart());
   // 9 is the end of the if block.
   ASSERT_EQ(9u, range.GetEnd());
 
+  // Test for the 4 constant.
+  interval = liveness.GetInstructionFromSsaIndex(1)->GetLiveInterval();
+  ASSERT_EQ(1u, interval->GetRanges().Size());
+  range = interval->GetRanges().Get(0);
+  ASSERT_EQ(3u, range.GetStart());
+  // Last use is the phi at the return block so instruction is live until
+  // the end of the else block.
+  ASSERT_EQ(12u, range.GetEnd());
+
   // Test for the phi.
   interval = liveness.GetInstructionFromSsaIndex(3)->GetLiveInterval();
   ASSERT_EQ(1u, interval->GetRanges().Size());
@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "loop_vectorizer.h"
+
+namespace art {
+
+/**
+ * The statement of a loop body, `destination[i] = left op right`, with the
+ * arrays read and written by it. Its checks are only allowed on these arrays.
+ */
+class VectorStatement : public ValueObject {
+ public:
+  VectorStatement(HLoopInformation* info, HPhi* induction)
+      : info_(info),
+        induction_(induction),
+        store_(nullptr),
+        value_(nullptr),
+        destination_(nullptr),
+        left_(nullptr),
+        right_(nullptr),
+        operation_(HVectorizedLoop::kFill) {}
+
+  // Matches `store` and the value it stores. Returns false if they do not
+  // form a statement that can be vectorized.
+  bool Match(HArraySet* store) {
+    if (!IsInductionIndex(store->InputAt(1))) {
+      return false;
+    }
+    destination_ = GetInvariantArray(store->InputAt(0));
+    if (destination_ == nullptr) {
+      return false;
+    }
+    store_ = store;
+    value_ = store->InputAt(2);
+    size_t component_size = Primitive::ComponentSize(store->GetComponentType());
+
+    if (IsInvariant(value_)) {
+      operation_ = HVectorizedLoop::kFill;
+      left_ = value_;
+      return true;
+    }
+
+    HArrayGet* load = value_->AsArrayGet();
+    if (load != nullptr) {
+      operation_ = HVectorizedLoop::kCopy;
+      left_ = GetLoadedArray(load);
+      return left_ != nullptr && Primitive::ComponentSize(load->GetType()) == component_size;
+    }
+
+    if (value_->AsAdd() != nullptr) {
+      operation_ = HVectorizedLoop::kAdd;
+    } else if (value_->AsSub() != nullptr) {
+      operation_ = HVectorizedLoop::kSub;
+    } else if (value_->AsMul() != nullptr) {
+      operation_ = HVectorizedLoop::kMul;
+    } else {
+      return false;
+    }
+    if (value_->GetType() != Primitive::kPrimInt
+        || store->GetComponentType() != Primitive::kPrimInt
+        || !info_->Contains(*value_->GetBlock())) {
+      return false;
+    }
+    left_ = GetOperand(value_->InputAt(0));
+    right_ = GetOperand(value_->InputAt(1));
+    return left_ != nullptr
+        && right_ != nullptr
+        && (left_->GetType() == Primitive::kPrimNot || right_->GetType() == Primitive::kPrimNot);
+  }
+
+  // Returns whether `instruction`, in the loop body, belongs to the statement,
+  // or only checks the arrays or the index of the statement.
+  bool IsPartOfStatement(HInstruction* instruction) const {
+    if (instruction == store_ || instruction == value_) {
+      return true;
+    }
+    if (instruction->AsArrayGet() != nullptr) {
+      // An operand of the arithmetic operation, and nothing else.
+      for (HUseIterator<HInstruction> it(instruction->GetUses()); !it.Done(); it.Advance()) {
+        if (it.Current()->GetUser() != value_) {
+          return false;
+        }
+      }
+      return instruction->GetUses() != nullptr;
+    }
+    if (instruction->AsNullCheck() != nullptr) {
+      return IsStatementArray(instruction->InputAt(0));
+    }
+    if (instruction->AsArrayLength() != nullptr) {
+      return IsStatementArray(GetInvariantArray(instruction->InputAt(0)));
+    }
+    if (instruction->AsBoundsCheck() != nullptr) {
+      HInstruction* length = instruction->InputAt(1);
+      return instruction->InputAt(0) == induction_
+          && length->AsArrayLength() != nullptr
+          && IsStatementArray(GetInvariantArray(length->InputAt(0)));
+    }
+    return false;
+  }
+
+  HInstruction* GetDestination() const { return destination_; }
+  HInstruction* GetLeft() const { return left_; }
+  HInstruction* GetRight() const { return right_; }
+  HVectorizedLoop::Operation GetOperation() const { return operation_; }
+
+ private:
+  bool IsInvariant(HInstruction* instruction) const {
+    return !info_->Contains(*instruction->GetBlock());
+  }
+
+  bool IsInductionIndex(HInstruction* index) const {
+    return index == induction_
+        || (index->AsBoundsCheck() != nullptr && index->InputAt(0) == induction_);
+  }
+
+  // Returns the loop invariant array `array` is, or null checks, or nullptr.
+  HInstruction* GetInvariantArray(HInstruction* array) const {
+    if (array->AsNullCheck() != nullptr && !IsInvariant(array)) {
+      array = array->InputAt(0);
+    }
+    return IsInvariant(array) && array->GetType() == Primitive::kPrimNot ? array : nullptr;
+  }
+
+  // Returns the array `load` reads at the induction variable, or nullptr.
+  HInstruction* GetLoadedArray(HArrayGet* load) const {
+    if (!info_->Contains(*load->GetBlock()) || !IsInductionIndex(load->InputAt(1))) {
+      return nullptr;
+    }
+    return GetInvariantArray(load->InputAt(0));
+  }
+
+  // Returns the array or the invariant value `operand` of the arithmetic
+  // operation stands for, or nullptr.
+  HInstruction* GetOperand(HInstruction* operand) const {
+    if (IsInvariant(operand)) {
+      return operand->GetType() == Primitive::kPrimInt ? operand : nullptr;
+    }
+    HArrayGet* load = operand->AsArrayGet();
+    if (load == nullptr || load->GetType() != Primitive::kPrimInt) {
+      return nullptr;
+    }
+    return GetLoadedArray(load);
+  }
+
+  bool IsStatementArray(HInstruction* array) const {
+    if (array == nullptr) {
+      return false;
+    }
+    return array == destination_
+        || (operation_ != HVectorizedLoop::kFill && (array == left_ || array == right_));
+  }
+
+  HLoopInformation* const info_;
+  HPhi* const induction_;
+  HArraySet* store_;
+  HInstruction* value_;
+  HInstruction* destination_;
+  HInstruction* left_;
+  HInstruction* right_;
+  HVectorizedLoop::Operation operation_;
+
+  DISALLOW_COPY_AND_ASSIGN(VectorStatement);
+};
+
+void LoopVectorizer::Run() {
+  for (HPostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    if (block->IsLoopHeader()) {
+      VisitLoop(block);
+    }
+  }
+}
+
+bool LoopVectorizer::CanVectorize(HVectorizedLoop::Operation operation,
+                                  Primitive::Type component_type) const {
+  if (component_type == Primitive::kPrimNot
+      || Primitive::ComponentSize(component_type) > 4) {
+    return false;
+  }
+  switch (instruction_set_) {
+    case kArm:
+    case kThumb2:
+      return features_.HasNeon();
+    case kX86:
+    case kX86_64:
+      // SSE2 is part of the baseline, but the 32-bit multiply needs SSE4.1.
+      return operation != HVectorizedLoop::kMul || features_.HasSse4_1();
+    default:
+      return false;
+  }
+}
+
+void LoopVectorizer::VisitLoop(HBasicBlock* header) {
+  HLoopInformation* info = header->GetLoopInformation();
+  if (info->NumberOfBackEdges() != 1) {
+    return;
+  }
+
+  // The loop must be the header, holding only the condition, and a single
+  // body block.
+  HBasicBlock* body = info->GetBackEdges().Get(0);
+  if (body->GetPredecessors().Size() != 1 || body->GetPredecessors().Get(0) != header) {
+    return;
+  }
+  HIf* if_instruction = header->GetLastInstruction()->AsIf();
+  if (if_instruction == nullptr) {
+    return;
+  }
+  HCondition* condition = if_instruction->InputAt(0)->AsCondition();
+  if (condition == nullptr
+      || header->GetFirstInstruction() != condition
+      || condition->GetNext() != if_instruction) {
+    return;
+  }
+  IfCondition cond;
+  if (if_instruction->IfTrueSuccessor() == body) {
+    cond = condition->GetCondition();
+  } else if (if_instruction->IfFalseSuccessor() == body) {
+    cond = NegateCondition(condition->GetCondition());
+  } else {
+    return;
+  }
+
+  // The induction variable must be the only phi, and not a reduction.
+  HInstructionIterator phis(header->GetPhis());
+  if (phis.Done()) {
+    return;
+  }
+  HPhi* phi = phis.Current()->AsPhi();
+  phis.Advance();
+  if (!phis.Done() || phi->GetType() != Primitive::kPrimInt) {
+    return;
+  }
+
+  // The condition holding in the body must be `phi < bound`.
+  HInstruction* bound;
+  if (condition->GetLeft() == phi && cond == kCondLT) {
+    bound = condition->GetRight();
+  } else if (condition->GetRight() == phi && MirrorCondition(cond) == kCondLT) {
+    bound = condition->GetLeft();
+  } else {
+    return;
+  }
+  if (info->Contains(*bound->GetBlock())) {
+    return;
+  }
+
+  size_t pre_header_index = header->GetPredecessorIndexOf(info->GetPreHeader());
+  size_t back_edge_index = 1 - pre_header_index;
+  HInstruction* update = phi->InputAt(back_edge_index);
+  HIntConstant* stride = nullptr;
+  if (update->AsAdd() != nullptr && update->GetBlock() == body) {
+    if (update->InputAt(0) == phi) {
+      stride = update->InputAt(1)->AsIntConstant();
+    } else if (update->InputAt(1) == phi) {
+      stride = update->InputAt(0)->AsIntConstant();
+    }
+  }
+  if (stride == nullptr || stride->GetValue() != 1) {
+    return;
+  }
+
+  // The body must hold exactly one array store, and the instructions computing
+  // its value and checking its arrays.
+  HArraySet* store = nullptr;
+  for (HInstructionIterator it(body->GetInstructions()); !it.Done(); it.Advance()) {
+    HArraySet* current = it.Current()->AsArraySet();
+    if (current != nullptr) {
+      if (store != nullptr) {
+        return;
+      }
+      store = current;
+    }
+  }
+  if (store == nullptr) {
+    return;
+  }
+  VectorStatement statement(info, phi);
+  if (!statement.Match(store)
+      || !CanVectorize(statement.GetOperation(), store->GetComponentType())) {
+    return;
+  }
+  for (HInstructionIterator it(body->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* current = it.Current();
+    if (current != update
+        && current->AsGoto() == nullptr
+        && !statement.IsPartOfStatement(current)) {
+      return;
+    }
+  }
+
+  HInstruction* start = phi->InputAt(pre_header_index);
+  HVectorizedLoop* vectorized = new (graph_->GetArena()) HVectorizedLoop(
+      graph_->GetArena(),
+      statement.GetOperation(),
+      store->GetComponentType(),
+      start,
+      bound,
+      statement.GetDestination(),
+      statement.GetLeft(),
+      statement.GetRight());
+  HBasicBlock* pre_header = info->GetPreHeader();
+  pre_header->InsertInstructionBefore(vectorized, pre_header->GetLastInstruction());
+
+  // The scalar loop resumes where the vectorized iterations stopped.
+  start->RemoveUser(phi, pre_header_index);
+  phi->SetRawInputAt(pre_header_index, vectorized);
+  vectorized->AddUseAt(phi, pre_header_index);
+}
+
+}  // namespace art
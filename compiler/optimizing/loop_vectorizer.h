@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_LOOP_VECTORIZER_H_
+#define ART_COMPILER_OPTIMIZING_LOOP_VECTORIZER_H_
+
+#include "instruction_set.h"
+#include "nodes.h"
+
+namespace art {
+
+/**
+ * Optimization phase that performs the bulk of simple counted loops over
+ * primitive arrays with vector instructions:
+ *
+ *   for (int i = start; i < bound; ++i) { a[i] = <value>; }
+ *   for (int i = start; i < bound; ++i) { a[i] = b[i]; }
+ *   for (int i = start; i < bound; ++i) { a[i] = b[i] <+,-,*> c[i]; }
+ *
+ * where the operands may also be loop invariant ints. An HVectorizedLoop is
+ * added to the pre-header, and the induction variable of the loop starts at
+ * the index it returns: the loop itself, with its checks, is kept to perform
+ * the remaining iterations. As all the accesses of the statement are at the
+ * same index, the iterations are independent, even when arrays alias.
+ *
+ * The graph must be in SSA form, and its loops must have been found. The pass
+ * expects LICM to have run, so that the loop header only holds the condition.
+ */
+class LoopVectorizer : public ValueObject {
+ public:
+  LoopVectorizer(HGraph* graph,
+                 InstructionSet instruction_set,
+                 const InstructionSetFeatures& features)
+      : graph_(graph), instruction_set_(instruction_set), features_(features) {}
+
+  void Run();
+
+ private:
+  // Returns whether the code generator of the target has vector instructions
+  // for `operation` on arrays of `component_type`.
+  bool CanVectorize(HVectorizedLoop::Operation operation, Primitive::Type component_type) const;
+
+  void VisitLoop(HBasicBlock* header);
+
+  HGraph* const graph_;
+  const InstructionSet instruction_set_;
+  const InstructionSetFeatures features_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoopVectorizer);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_LOOP_VECTORIZER_H_
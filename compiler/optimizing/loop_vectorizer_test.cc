@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "loop_vectorizer.h"
+#include "nodes.h"
+#include "optimizing_unit_test.h"
+#include "utils/arena_allocator.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+/**
+ * Fixture building the graph of `for (int i = 0; i < bound; i++) { body }`:
+ *
+ *        entry
+ *          |
+ *      pre_header
+ *          |
+ *        header <---+
+ *        /    \     |
+ *    return   body -+
+ *      |
+ *     exit
+ *
+ * The arrays and the invariant values are parameters of the method.
+ */
+class LoopVectorizerTest : public testing::Test {
+ public:
+  LoopVectorizerTest() : pool_(), allocator_(&pool_), parameters_(0) {
+    graph_ = new (&allocator_) HGraph(&allocator_);
+    entry_ = new (&allocator_) HBasicBlock(graph_);
+    pre_header_ = new (&allocator_) HBasicBlock(graph_);
+    header_ = new (&allocator_) HBasicBlock(graph_);
+    body_ = new (&allocator_) HBasicBlock(graph_);
+    return_ = new (&allocator_) HBasicBlock(graph_);
+    exit_ = new (&allocator_) HBasicBlock(graph_);
+
+    graph_->AddBlock(entry_);
+    graph_->AddBlock(pre_header_);
+    graph_->AddBlock(header_);
+    graph_->AddBlock(body_);
+    graph_->AddBlock(return_);
+    graph_->AddBlock(exit_);
+    graph_->SetEntryBlock(entry_);
+    graph_->SetExitBlock(exit_);
+
+    entry_->AddSuccessor(pre_header_);
+    pre_header_->AddSuccessor(header_);
+    header_->AddSuccessor(return_);
+    header_->AddSuccessor(body_);
+    body_->AddSuccessor(header_);
+    return_->AddSuccessor(exit_);
+
+    start_ = new (&allocator_) HIntConstant(0);
+    entry_->AddInstruction(start_);
+    one_ = new (&allocator_) HIntConstant(1);
+    entry_->AddInstruction(one_);
+    bound_ = NewParameter(Primitive::kPrimInt);
+    pre_header_->AddInstruction(new (&allocator_) HGoto());
+
+    // The loop exits when `i >= bound`.
+    phi_ = new (&allocator_) HPhi(&allocator_, 0, 0, Primitive::kPrimInt);
+    header_->AddPhi(phi_);
+    phi_->AddInput(start_);
+    HInstruction* condition = new (&allocator_) HGreaterThanOrEqual(phi_, bound_);
+    header_->AddInstruction(condition);
+    header_->AddInstruction(new (&allocator_) HIf(condition));
+
+    return_->AddInstruction(new (&allocator_) HReturnVoid());
+    exit_->AddInstruction(new (&allocator_) HExit());
+  }
+
+  HInstruction* NewParameter(Primitive::Type type) {
+    HInstruction* parameter = new (&allocator_) HParameterValue(parameters_++, type);
+    entry_->AddInstruction(parameter);
+    return parameter;
+  }
+
+  // Adds the null and bounds checks of an access to `array` at `i` to the body.
+  void AddChecks(HInstruction* array, HInstruction** checked_array, HInstruction** index) {
+    *checked_array = new (&allocator_) HNullCheck(array, 0);
+    body_->AddInstruction(*checked_array);
+    HInstruction* length = new (&allocator_) HArrayLength(*checked_array);
+    body_->AddInstruction(length);
+    *index = new (&allocator_) HBoundsCheck(phi_, length, 0);
+    body_->AddInstruction(*index);
+  }
+
+  HInstruction* NewLoad(HInstruction* array) {
+    HInstruction* checked_array;
+    HInstruction* index;
+    AddChecks(array, &checked_array, &index);
+    HInstruction* load = new (&allocator_) HArrayGet(checked_array, index, Primitive::kPrimInt);
+    body_->AddInstruction(load);
+    return load;
+  }
+
+  void NewStore(HInstruction* array, HInstruction* value, Primitive::Type type) {
+    HInstruction* checked_array;
+    HInstruction* index;
+    AddChecks(array, &checked_array, &index);
+    body_->AddInstruction(new (&allocator_) HArraySet(checked_array, index, value, type, 0));
+  }
+
+  // Ends the body with the update of the induction variable.
+  void EndBody() {
+    HInstruction* update = new (&allocator_) HAdd(Primitive::kPrimInt, phi_, one_);
+    body_->AddInstruction(update);
+    body_->AddInstruction(new (&allocator_) HGoto());
+    phi_->AddInput(update);
+  }
+
+  // Runs the vectorizer, and returns the instruction it added, if any.
+  HVectorizedLoop* RunLoopVectorizer(InstructionSet instruction_set,
+                                     const InstructionSetFeatures& features) {
+    graph_->BuildDominatorTree();
+    EXPECT_TRUE(graph_->FindNaturalLoops());
+    LoopVectorizer(graph_, instruction_set, features).Run();
+    HInstruction* first = pre_header_->GetFirstInstruction();
+    if (first->AsVectorizedLoop() != nullptr) {
+      EXPECT_EQ(first, phi_->InputAt(0));
+      EXPECT_EQ(start_, first->AsVectorizedLoop()->GetStart());
+    } else {
+      EXPECT_EQ(start_, phi_->InputAt(0));
+    }
+    return first->AsVectorizedLoop();
+  }
+
+  static InstructionSetFeatures Neon() {
+    InstructionSetFeatures features;
+    features.SetHasNeon(true);
+    return features;
+  }
+
+  ArenaPool pool_;
+  ArenaAllocator allocator_;
+  HGraph* graph_;
+  size_t parameters_;
+
+  HBasicBlock* entry_;
+  HBasicBlock* pre_header_;
+  HBasicBlock* header_;
+  HBasicBlock* body_;
+  HBasicBlock* return_;
+  HBasicBlock* exit_;
+
+  HInstruction* start_;
+  HInstruction* one_;
+  HInstruction* bound_;
+  HPhi* phi_;
+};
+
+// a[i] = value
+TEST_F(LoopVectorizerTest, Fill) {
+  HInstruction* array = NewParameter(Primitive::kPrimNot);
+  HInstruction* value = NewParameter(Primitive::kPrimInt);
+  NewStore(array, value, Primitive::kPrimShort);
+  EndBody();
+
+  HVectorizedLoop* vectorized = RunLoopVectorizer(kArm, Neon());
+
+  ASSERT_NE(vectorized, nullptr);
+  ASSERT_EQ(vectorized->GetOperation(), HVectorizedLoop::kFill);
+  ASSERT_EQ(vectorized->GetComponentType(), Primitive::kPrimShort);
+  ASSERT_EQ(vectorized->GetVectorLength(), 8u);
+  ASSERT_EQ(vectorized->GetBound(), bound_);
+  ASSERT_EQ(vectorized->GetDestination(), array);
+  ASSERT_EQ(vectorized->GetLeft(), value);
+  ASSERT_FALSE(vectorized->IsArrayInput(3));
+}
+
+// a[i] = b[i] + c[i]
+TEST_F(LoopVectorizerTest, AddArrays) {
+  HInstruction* a = NewParameter(Primitive::kPrimNot);
+  HInstruction* b = NewParameter(Primitive::kPrimNot);
+  HInstruction* c = NewParameter(Primitive::kPrimNot);
+  HInstruction* add = new (&allocator_) HAdd(Primitive::kPrimInt, NewLoad(b), NewLoad(c));
+  body_->AddInstruction(add);
+  NewStore(a, add, Primitive::kPrimInt);
+  EndBody();
+
+  HVectorizedLoop* vectorized = RunLoopVectorizer(kX86, InstructionSetFeatures());
+
+  ASSERT_NE(vectorized, nullptr);
+  ASSERT_EQ(vectorized->GetOperation(), HVectorizedLoop::kAdd);
+  ASSERT_EQ(vectorized->GetDestination(), a);
+  ASSERT_EQ(vectorized->GetLeft(), b);
+  ASSERT_EQ(vectorized->GetRight(), c);
+  ASSERT_TRUE(vectorized->IsArrayInput(3));
+  ASSERT_TRUE(vectorized->IsArrayInput(4));
+}
+
+// a[i] = value - a[i]
+TEST_F(LoopVectorizerTest, SubFromInvariant) {
+  HInstruction* a = NewParameter(Primitive::kPrimNot);
+  HInstruction* value = NewParameter(Primitive::kPrimInt);
+  HInstruction* sub = new (&allocator_) HSub(Primitive::kPrimInt, value, NewLoad(a));
+  body_->AddInstruction(sub);
+  NewStore(a, sub, Primitive::kPrimInt);
+  EndBody();
+
+  HVectorizedLoop* vectorized = RunLoopVectorizer(kArm, Neon());
+
+  ASSERT_NE(vectorized, nullptr);
+  ASSERT_EQ(vectorized->GetOperation(), HVectorizedLoop::kSub);
+  ASSERT_EQ(vectorized->GetLeft(), value);
+  ASSERT_EQ(vectorized->GetRight(), a);
+  ASSERT_FALSE(vectorized->IsArrayInput(3));
+  ASSERT_TRUE(vectorized->IsArrayInput(4));
+}
+
+// a[i] = a[i] * b[i], which needs SSE4.1 on x86.
+TEST_F(LoopVectorizerTest, MulWithoutSse4_1) {
+  HInstruction* a = NewParameter(Primitive::kPrimNot);
+  HInstruction* b = NewParameter(Primitive::kPrimNot);
+  HInstruction* mul = new (&allocator_) HMul(Primitive::kPrimInt, NewLoad(a), NewLoad(b));
+  body_->AddInstruction(mul);
+  NewStore(a, mul, Primitive::kPrimInt);
+  EndBody();
+
+  ASSERT_EQ(RunLoopVectorizer(kX86, InstructionSetFeatures()), nullptr);
+}
+
+TEST_F(LoopVectorizerTest, MulWithSse4_1) {
+  HInstruction* a = NewParameter(Primitive::kPrimNot);
+  HInstruction* b = NewParameter(Primitive::kPrimNot);
+  HInstruction* mul = new (&allocator_) HMul(Primitive::kPrimInt, NewLoad(a), NewLoad(b));
+  body_->AddInstruction(mul);
+  NewStore(a, mul, Primitive::kPrimInt);
+  EndBody();
+
+  InstructionSetFeatures features;
+  features.SetHasSse4_1(true);
+  HVectorizedLoop* vectorized = RunLoopVectorizer(kX86, features);
+  ASSERT_NE(vectorized, nullptr);
+  ASSERT_EQ(vectorized->GetOperation(), HVectorizedLoop::kMul);
+  ASSERT_EQ(vectorized->GetLeft(), a);
+  ASSERT_EQ(vectorized->GetRight(), b);
+}
+
+// a[i] = b[i], without NEON.
+TEST_F(LoopVectorizerTest, CopyNeedsNeon) {
+  HInstruction* a = NewParameter(Primitive::kPrimNot);
+  HInstruction* b = NewParameter(Primitive::kPrimNot);
+  NewStore(a, NewLoad(b), Primitive::kPrimInt);
+  EndBody();
+
+  ASSERT_EQ(RunLoopVectorizer(kArm, InstructionSetFeatures()), nullptr);
+}
+
+// a[i] = b[i], with a check on another array: the iterations would not throw
+// at the same point.
+TEST_F(LoopVectorizerTest, CheckOnOtherArray) {
+  HInstruction* a = NewParameter(Primitive::kPrimNot);
+  HInstruction* b = NewParameter(Primitive::kPrimNot);
+  HInstruction* other = NewParameter(Primitive::kPrimNot);
+  body_->AddInstruction(new (&allocator_) HNullCheck(other, 0));
+  NewStore(a, NewLoad(b), Primitive::kPrimInt);
+  EndBody();
+
+  ASSERT_EQ(RunLoopVectorizer(kArm, Neon()), nullptr);
+}
+
+// sum += a[i]; a[i] = 0: the loop has a reduction.
+TEST_F(LoopVectorizerTest, Reduction) {
+  HInstruction* a = NewParameter(Primitive::kPrimNot);
+  HPhi* sum = new (&allocator_) HPhi(&allocator_, 1, 0, Primitive::kPrimInt);
+  header_->AddPhi(sum);
+  sum->AddInput(start_);
+  HInstruction* add = new (&allocator_) HAdd(Primitive::kPrimInt, sum, NewLoad(a));
+  body_->AddInstruction(add);
+  sum->AddInput(add);
+  NewStore(a, start_, Primitive::kPrimInt);
+  EndBody();
+
+  ASSERT_EQ(RunLoopVectorizer(kArm, Neon()), nullptr);
+}
+
+// a[i] = b[i]; b[i] = 0: the body holds two statements.
+TEST_F(LoopVectorizerTest, TwoStores) {
+  HInstruction* a = NewParameter(Primitive::kPrimNot);
+  HInstruction* b = NewParameter(Primitive::kPrimNot);
+  NewStore(a, NewLoad(b), Primitive::kPrimInt);
+  NewStore(b, start_, Primitive::kPrimInt);
+  EndBody();
+
+  ASSERT_EQ(RunLoopVectorizer(kX86, InstructionSetFeatures()), nullptr);
+}
+
+// a[i] = b[i] + c[i], through all the passes of the optimizing compiler: the
+// loop is vectorized, and its code is generated with the register allocator.
+TEST_F(LoopVectorizerTest, CompileOptimized) {
+  HInstruction* a = NewParameter(Primitive::kPrimNot);
+  HInstruction* b = NewParameter(Primitive::kPrimNot);
+  HInstruction* c = NewParameter(Primitive::kPrimNot);
+  HInstruction* add = new (&allocator_) HAdd(Primitive::kPrimInt, NewLoad(b), NewLoad(c));
+  body_->AddInstruction(add);
+  NewStore(a, add, Primitive::kPrimInt);
+  EndBody();
+  entry_->AddInstruction(new (&allocator_) HGoto());
+
+  graph_->BuildDominatorTree();
+  ASSERT_TRUE(graph_->FindNaturalLoops());
+  ASSERT_TRUE(CompileOptimized(graph_, kX86, InstructionSetFeatures()));
+  ASSERT_NE(phi_->InputAt(0)->AsVectorizedLoop(), nullptr);
+}
+
+}  // namespace art
@@ -16,6 +16,7 @@
 
 #include "nodes.h"
 #include "ssa_builder.h"
+#include "ssa_type_propagation.h"
 #include "utils/growable_array.h"
 
 namespace art {
@@ -135,6 +136,7 @@ void HGraph::TransformToSSA() {
   DCHECK(!reverse_post_order_.IsEmpty());
   SsaBuilder ssa_builder(this);
   ssa_builder.BuildSsa();
+  SsaTypePropagation(this).Run();
 }
 
 void HGraph::SplitCriticalEdge(HBasicBlock* block, HBasicBlock* successor) {
@@ -143,8 +145,7 @@ void HGraph::SplitCriticalEdge(HBasicBlock* block, HBasicBlock* successor) {
   HBasicBlock* new_block = new (arena_) HBasicBlock(this);
   AddBlock(new_block);
   new_block->AddInstruction(new (arena_) HGoto());
-  block->RemoveSuccessor(successor);
-  block->AddSuccessor(new_block);
+  block->ReplaceSuccessor(successor, new_block);
   new_block->AddSuccessor(successor);
   if (successor->IsLoopHeader()) {
     // If we split at a back edge boundary, make the new block the back edge.
@@ -168,8 +169,7 @@ void HGraph::SimplifyLoop(HBasicBlock* header) {
     new_back_edge->AddInstruction(new (arena_) HGoto());
     for (size_t pred = 0, e = info->GetBackEdges().Size(); pred < e; ++pred) {
       HBasicBlock* back_edge = info->GetBackEdges().Get(pred);
-      header->RemovePredecessor(back_edge);
-      back_edge->AddSuccessor(new_back_edge);
+      back_edge->ReplaceSuccessor(header, new_back_edge);
     }
     info->ClearBackEdges();
     info->AddBackEdge(new_back_edge);
@@ -190,9 +190,8 @@ void HGraph::SimplifyLoop(HBasicBlock* header) {
     for (size_t pred = 0; pred < header->GetPredecessors().Size(); ++pred) {
       HBasicBlock* predecessor = header->GetPredecessors().Get(pred);
       if (predecessor != back_edge) {
-        header->RemovePredecessor(predecessor);
+        predecessor->ReplaceSuccessor(header, pre_header);
         pred--;
-        predecessor->AddSuccessor(pre_header);
       }
     }
     pre_header->AddSuccessor(header);
@@ -305,6 +304,15 @@ void HBasicBlock::AddInstruction(HInstruction* instruction) {
   Add(&instructions_, this, instruction);
 }
 
+void HBasicBlock::InsertInstructionBefore(HInstruction* instruction, HInstruction* cursor) {
+  DCHECK_EQ(cursor->GetBlock(), this);
+  DCHECK(cursor->AsPhi() == nullptr);
+  DCHECK(instruction->AsPhi() == nullptr);
+  instruction->SetBlock(this);
+  instruction->SetId(GetGraph()->GetNextInstructionId());
+  instructions_.InsertInstructionBefore(instruction, cursor);
+}
+
 void HBasicBlock::AddPhi(HPhi* phi) {
   Add(&phis_, this, phi);
 }
@@ -321,6 +329,11 @@ static void Remove(HInstructionList* instruction_list,
   for (size_t i = 0; i < instruction->InputCount(); i++) {
     instruction->InputAt(i)->RemoveUser(instruction, i);
   }
+
+  HEnvironment* environment = instruction->GetEnvironment();
+  if (environment != nullptr) {
+    environment->RemoveAsUserOfAllInputs();
+  }
 }
 
 void HBasicBlock::RemoveInstruction(HInstruction* instruction) {
@@ -331,13 +344,16 @@ void HBasicBlock::RemovePhi(HPhi* phi) {
   Remove(&phis_, this, phi);
 }
 
-void HInstruction::RemoveUser(HInstruction* user, size_t input_index) {
-  HUseListNode<HInstruction>* previous = nullptr;
-  HUseListNode<HInstruction>* current = uses_;
+template <typename T>
+static void RemoveFromUseList(T* user,
+                              size_t input_index,
+                              HUseListNode<T>** list) {
+  HUseListNode<T>* previous = nullptr;
+  HUseListNode<T>* current = *list;
   while (current != nullptr) {
     if (current->GetUser() == user && current->GetIndex() == input_index) {
       if (previous == NULL) {
-        uses_ = current->GetTail();
+        *list = current->GetTail();
       } else {
         previous->SetTail(current->GetTail());
       }
@@ -347,6 +363,68 @@ void HInstruction::RemoveUser(HInstruction* user, size_t input_index) {
   }
 }
 
+void HInstruction::RemoveUser(HInstruction* user, size_t input_index) {
+  RemoveFromUseList(user, input_index, &uses_);
+}
+
+void HInstruction::RemoveEnvironmentUser(HEnvironment* user, size_t input_index) {
+  RemoveFromUseList(user, input_index, &env_uses_);
+}
+
+void HEnvironment::ReplaceEnvAt(size_t index, HInstruction* instruction) {
+  HInstruction* previous = vregs_.Get(index);
+  if (previous != nullptr) {
+    previous->RemoveEnvironmentUser(this, index);
+  }
+  vregs_.Put(index, instruction);
+  if (instruction != nullptr) {
+    instruction->AddEnvUseAt(this, index);
+  }
+}
+
+void HEnvironment::RemoveAsUserOfAllInputs() {
+  for (size_t i = 0, e = vregs_.Size(); i < e; ++i) {
+    HInstruction* instruction = vregs_.Get(i);
+    if (instruction != nullptr) {
+      instruction->RemoveEnvironmentUser(this, i);
+    }
+  }
+}
+
+bool HInstruction::Equals(HInstruction* other) const {
+  if (!InstructionTypeEquals(other)) return false;
+  if (!InstructionDataEquals(other)) return false;
+  if (GetType() != other->GetType()) return false;
+  if (InputCount() != other->InputCount()) return false;
+
+  for (size_t i = 0, e = InputCount(); i < e; ++i) {
+    if (InputAt(i) != other->InputAt(i)) return false;
+  }
+  return true;
+}
+
+void HInstruction::MoveBefore(HInstruction* cursor) {
+  DCHECK(next_ != nullptr) << "Cannot move the last instruction of a block";
+  DCHECK(AsPhi() == nullptr);
+  DCHECK(cursor->AsPhi() == nullptr);
+  // Unlink from the current block.
+  HInstructionList* list = &block_->instructions_;
+  list->RemoveInstruction(this);
+
+  // Link before `cursor`, without touching the use lists.
+  HInstructionList* cursor_list = &cursor->GetBlock()->instructions_;
+  if (cursor == cursor_list->first_instruction_) {
+    cursor_list->first_instruction_ = this;
+    previous_ = nullptr;
+  } else {
+    previous_ = cursor->previous_;
+    previous_->next_ = this;
+  }
+  next_ = cursor;
+  cursor->previous_ = this;
+  block_ = cursor->GetBlock();
+}
+
 void HInstructionList::AddInstruction(HInstruction* instruction) {
   if (first_instruction_ == nullptr) {
     DCHECK(last_instruction_ == nullptr);
@@ -361,6 +439,23 @@ void HInstructionList::AddInstruction(HInstruction* instruction) {
   }
 }
 
+void HInstructionList::InsertInstructionBefore(HInstruction* instruction,
+                                               HInstruction* cursor) {
+  if (cursor == first_instruction_) {
+    cursor->previous_ = instruction;
+    instruction->next_ = cursor;
+    first_instruction_ = instruction;
+  } else {
+    instruction->previous_ = cursor->previous_;
+    instruction->next_ = cursor;
+    cursor->previous_ = instruction;
+    instruction->previous_->next_ = instruction;
+  }
+  for (size_t i = 0; i < instruction->InputCount(); i++) {
+    instruction->InputAt(i)->AddUseAt(instruction, i);
+  }
+}
+
 void HInstructionList::RemoveInstruction(HInstruction* instruction) {
   if (instruction->previous_ != nullptr) {
     instruction->previous_->next_ = instruction->next_;
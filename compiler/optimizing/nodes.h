@@ -17,6 +17,9 @@
 #ifndef ART_COMPILER_OPTIMIZING_NODES_H_
 #define ART_COMPILER_OPTIMIZING_NODES_H_
 
+#include "locations.h"
+#include "offsets.h"
+#include "primitive.h"
 #include "utils/allocation.h"
 #include "utils/arena_bit_vector.h"
 #include "utils/growable_array.h"
@@ -24,13 +27,13 @@
 namespace art {
 
 class HBasicBlock;
+class HCondition;
 class HEnvironment;
 class HInstruction;
 class HIntConstant;
 class HGraphVisitor;
 class HPhi;
 class LiveInterval;
-class LocationSummary;
 
 static const int kDefaultNumberOfBlocks = 8;
 static const int kDefaultNumberOfSuccessors = 2;
@@ -44,11 +47,15 @@ class HInstructionList {
   void AddInstruction(HInstruction* instruction);
   void RemoveInstruction(HInstruction* instruction);
 
+  // Insert `instruction` before `cursor`, which must be in this list.
+  void InsertInstructionBefore(HInstruction* instruction, HInstruction* cursor);
+
  private:
   HInstruction* first_instruction_;
   HInstruction* last_instruction_;
 
   friend class HBasicBlock;
+  friend class HInstruction;
   friend class HInstructionIterator;
   friend class HBackwardInstructionIterator;
 
@@ -65,6 +72,7 @@ class HGraph : public ArenaObject {
         maximum_number_of_out_vregs_(0),
         number_of_vregs_(0),
         number_of_in_vregs_(0),
+        number_of_temporaries_(0),
         current_instruction_id_(0) { }
 
   ArenaAllocator* GetArena() const { return arena_; }
@@ -94,6 +102,11 @@ class HGraph : public ArenaObject {
     return current_instruction_id_++;
   }
 
+  // Returns an upper bound of the ids of the instructions of the graph.
+  int GetCurrentInstructionId() const {
+    return current_instruction_id_;
+  }
+
   uint16_t GetMaximumNumberOfOutVRegs() const {
     return maximum_number_of_out_vregs_;
   }
@@ -118,6 +131,14 @@ class HGraph : public ArenaObject {
     return number_of_in_vregs_;
   }
 
+  void UpdateNumberOfTemporaries(size_t count) {
+    number_of_temporaries_ = std::max(count, number_of_temporaries_);
+  }
+
+  size_t GetNumberOfTemporaries() const {
+    return number_of_temporaries_;
+  }
+
   const GrowableArray<HBasicBlock*>& GetReversePostOrder() const {
     return reverse_post_order_;
   }
@@ -153,6 +174,10 @@ class HGraph : public ArenaObject {
   // The number of virtual registers used by parameters of this method.
   uint16_t number_of_in_vregs_;
 
+  // The number of stack slots needed by the baseline code generator to keep
+  // HTemporary values.
+  size_t number_of_temporaries_;
+
   // The current id to assign to a newly added instruction. See HInstruction.id_.
   int current_instruction_id_;
 
@@ -164,7 +189,8 @@ class HLoopInformation : public ArenaObject {
   HLoopInformation(HBasicBlock* header, HGraph* graph)
       : header_(header),
         back_edges_(graph->GetArena(), kDefaultNumberOfBackEdges),
-        blocks_(graph->GetArena(), graph->GetBlocks().Size(), false) {}
+        // Make bit vector growable, as the number of blocks may change.
+        blocks_(graph->GetArena(), graph->GetBlocks().Size(), true) {}
 
   HBasicBlock* GetHeader() const {
     return header_;
@@ -295,6 +321,16 @@ class HBasicBlock : public ArenaObject {
     }
   }
 
+  // Replace the successor `existing` with `new_block`, keeping its position in the
+  // list of successors. The position matters for blocks ending with an HIf.
+  void ReplaceSuccessor(HBasicBlock* existing, HBasicBlock* new_block) {
+    size_t successor_index = GetSuccessorIndexOf(existing);
+    DCHECK_NE(successor_index, static_cast<size_t>(-1));
+    existing->RemovePredecessor(this, false);
+    new_block->predecessors_.Add(this);
+    successors_.Put(successor_index, new_block);
+  }
+
   void ClearAllPredecessors() {
     predecessors_.Reset();
   }
@@ -313,8 +349,18 @@ class HBasicBlock : public ArenaObject {
     return -1;
   }
 
+  size_t GetSuccessorIndexOf(HBasicBlock* successor) {
+    for (size_t i = 0, e = successors_.Size(); i < e; ++i) {
+      if (successors_.Get(i) == successor) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
   void AddInstruction(HInstruction* instruction);
   void RemoveInstruction(HInstruction* instruction);
+  void InsertInstructionBefore(HInstruction* instruction, HInstruction* cursor);
   void AddPhi(HPhi* phi);
   void RemovePhi(HPhi* phi);
 
@@ -366,37 +412,100 @@ class HBasicBlock : public ArenaObject {
   size_t lifetime_start_;
   size_t lifetime_end_;
 
+  friend class HInstruction;
+
   DISALLOW_COPY_AND_ASSIGN(HBasicBlock);
 };
 
 #define FOR_EACH_INSTRUCTION(M)                            \
   M(Add)                                                   \
+  M(ArrayGet)                                              \
+  M(ArrayLength)                                           \
+  M(ArraySet)                                              \
+  M(BoundsCheck)                                           \
+  M(Compare)                                               \
+  M(Deoptimize)                                            \
+  M(Div)                                                   \
+  M(DivZeroCheck)                                          \
   M(Equal)                                                 \
   M(Exit)                                                  \
   M(Goto)                                                  \
+  M(GreaterThan)                                           \
+  M(GreaterThanOrEqual)                                    \
   M(If)                                                    \
+  M(InstanceFieldGet)                                      \
+  M(InstanceFieldSet)                                      \
   M(IntConstant)                                           \
+  M(InvokeInterface)                                       \
   M(InvokeStatic)                                          \
+  M(InvokeVirtual)                                         \
+  M(LessThan)                                              \
+  M(LessThanOrEqual)                                       \
   M(LoadLocal)                                             \
   M(Local)                                                 \
   M(LongConstant)                                          \
+  M(Mul)                                                   \
   M(NewInstance)                                           \
   M(Not)                                                   \
+  M(NotEqual)                                              \
+  M(NullCheck)                                             \
+  M(ParallelMove)                                          \
   M(ParameterValue)                                        \
   M(Phi)                                                   \
+  M(Rem)                                                   \
   M(Return)                                                \
   M(ReturnVoid)                                            \
   M(StoreLocal)                                            \
   M(Sub)                                                   \
+  M(Temporary)                                             \
+  M(VectorizedLoop)                                        \
 
 #define FORWARD_DECLARATION(type) class H##type;
 FOR_EACH_INSTRUCTION(FORWARD_DECLARATION)
 #undef FORWARD_DECLARATION
 
-#define DECLARE_INSTRUCTION(type)                          \
-  virtual void Accept(HGraphVisitor* visitor);             \
-  virtual const char* DebugName() const { return #type; }  \
-  virtual H##type* As##type() { return this; }             \
+#define DECLARE_INSTRUCTION(type)                                        \
+  virtual void Accept(HGraphVisitor* visitor);                           \
+  virtual const char* DebugName() const { return #type; }                \
+  virtual H##type* As##type() { return this; }                           \
+  virtual bool InstructionTypeEquals(HInstruction* other) const {        \
+    return other->As##type() != nullptr;                                 \
+  }                                                                      \
+
+// The memory an instruction may write, and the memory its result may depend on.
+// Fields and array elements are the only memory the compiler reasons about;
+// calls write and read all of it.
+class SideEffects : public ValueObject {
+ public:
+  static SideEffects None() { return SideEffects(0); }
+  static SideEffects All() { return SideEffects(kAllWrites | kAllReads); }
+  static SideEffects FieldWrite() { return SideEffects(kFieldWriteBit); }
+  static SideEffects ArrayWrite() { return SideEffects(kArrayWriteBit); }
+  static SideEffects FieldRead() { return SideEffects(kFieldWriteBit << kReadShift); }
+  static SideEffects ArrayRead() { return SideEffects(kArrayWriteBit << kReadShift); }
+
+  SideEffects Union(SideEffects other) const { return SideEffects(flags_ | other.flags_); }
+
+  bool HasSideEffects() const { return (flags_ & kAllWrites) != 0; }
+  bool HasDependencies() const { return (flags_ & kAllReads) != 0; }
+
+  // Returns whether the memory read by an instruction with these effects may
+  // be written by an instruction with the `other` effects.
+  bool DependsOn(SideEffects other) const {
+    return ((other.flags_ & kAllWrites) << kReadShift & flags_) != 0;
+  }
+
+ private:
+  static constexpr uint32_t kFieldWriteBit = 1 << 0;
+  static constexpr uint32_t kArrayWriteBit = 1 << 1;
+  static constexpr uint32_t kReadShift = 2;
+  static constexpr uint32_t kAllWrites = kFieldWriteBit | kArrayWriteBit;
+  static constexpr uint32_t kAllReads = kAllWrites << kReadShift;
+
+  explicit SideEffects(uint32_t flags) : flags_(flags) {}
+
+  uint32_t flags_;
+};
 
 template <typename T>
 class HUseListNode : public ArenaObject {
@@ -452,6 +561,40 @@ class HInstruction : public ArenaObject {
 
   virtual bool NeedsEnvironment() const { return false; }
 
+  virtual SideEffects GetSideEffects() const { return SideEffects::None(); }
+
+  // Returns whether the instruction only computes a value from its inputs and
+  // the memory described by its side effects. Such instructions can be moved,
+  // or replaced by an equal one, as long as their inputs and their
+  // dependencies are preserved.
+  virtual bool CanBeMoved() const { return false; }
+
+  // Returns whether the instruction may throw an exception. Moving it before
+  // other throwing or writing instructions would change the program.
+  virtual bool CanThrow() const { return false; }
+
+  // Returns whether `other` is an instruction of the same kind.
+  virtual bool InstructionTypeEquals(HInstruction* other) const { return false; }
+
+  // Returns whether the data of the instruction, other than its type and
+  // inputs, is the same as the one of `other`, of the same kind.
+  virtual bool InstructionDataEquals(HInstruction* other) const { return false; }
+
+  // Returns whether the instruction computes the same value as `other`.
+  bool Equals(HInstruction* other) const;
+
+  virtual size_t ComputeHashCode() const {
+    size_t result = InputCount();
+    for (size_t i = 0, e = InputCount(); i < e; ++i) {
+      result = (result * 31) + InputAt(i)->GetId();
+    }
+    return result;
+  }
+
+  // Move the instruction, which must not be the last of its block, before
+  // `cursor`. Uses and inputs are unchanged.
+  void MoveBefore(HInstruction* cursor);
+
   void AddUseAt(HInstruction* user, size_t index) {
     uses_ = new (block_->GetGraph()->GetArena()) HUseListNode<HInstruction>(user, index, uses_);
   }
@@ -462,6 +605,7 @@ class HInstruction : public ArenaObject {
   }
 
   void RemoveUser(HInstruction* user, size_t index);
+  void RemoveEnvironmentUser(HEnvironment* user, size_t index);
 
   HUseListNode<HInstruction>* GetUses() const { return uses_; }
   HUseListNode<HEnvironment>* GetEnvUses() const { return env_uses_; }
@@ -501,6 +645,9 @@ class HInstruction : public ArenaObject {
   FOR_EACH_INSTRUCTION(INSTRUCTION_TYPE_CHECK)
 #undef INSTRUCTION_TYPE_CHECK
 
+  // HCondition is abstract, and does not have a type check in the list above.
+  virtual HCondition* AsCondition() { return nullptr; }
+
   size_t GetLifetimePosition() const { return lifetime_position_; }
   void SetLifetimePosition(size_t position) { lifetime_position_ = position; }
   LiveInterval* GetLiveInterval() const { return live_interval_; }
@@ -591,6 +738,12 @@ class HEnvironment : public ArenaObject {
     vregs_.Put(index, instruction);
   }
 
+  // Replace the value at `index`, updating the use lists.
+  void ReplaceEnvAt(size_t index, HInstruction* instruction);
+
+  // Remove this environment from the use lists of the instructions it contains.
+  void RemoveAsUserOfAllInputs();
+
   GrowableArray<HInstruction*>* GetVRegs() {
     return &vregs_;
   }
@@ -801,6 +954,30 @@ class HIf : public HTemplateInstruction<1> {
   DISALLOW_COPY_AND_ASSIGN(HIf);
 };
 
+// Guard of a speculative optimization: if its input is true, the method
+// continues in the interpreter at the dex instruction of the guard, which
+// has not been executed yet. The dex registers are rebuilt from the stack
+// map recorded at the guard, see artDeoptimizeFromCompiledCode.
+class HDeoptimize : public HTemplateInstruction<1> {
+ public:
+  HDeoptimize(HInstruction* condition, uint32_t dex_pc) : dex_pc_(dex_pc) {
+    SetRawInputAt(0, condition);
+  }
+
+  virtual bool NeedsEnvironment() const { return true; }
+  // The code after the guard relies on what it checks.
+  virtual SideEffects GetSideEffects() const { return SideEffects::All(); }
+
+  uint32_t GetDexPc() const { return dex_pc_; }
+
+  DECLARE_INSTRUCTION(Deoptimize);
+
+ private:
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(HDeoptimize);
+};
+
 class HBinaryOperation : public HTemplateInstruction<2> {
  public:
   HBinaryOperation(Primitive::Type result_type,
@@ -817,6 +994,9 @@ class HBinaryOperation : public HTemplateInstruction<2> {
   virtual bool IsCommutative() { return false; }
   virtual Primitive::Type GetType() const { return GetResultType(); }
 
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+
  private:
   const Primitive::Type result_type_;
 
@@ -824,22 +1004,176 @@ class HBinaryOperation : public HTemplateInstruction<2> {
 };
 
 
+enum IfCondition {
+  kCondEQ,
+  kCondNE,
+  kCondLT,
+  kCondLE,
+  kCondGT,
+  kCondGE,
+};
+
+// Returns the condition that holds when the condition `cond` is false.
+static inline IfCondition NegateCondition(IfCondition cond) {
+  switch (cond) {
+    case kCondEQ: return kCondNE;
+    case kCondNE: return kCondEQ;
+    case kCondLT: return kCondGE;
+    case kCondLE: return kCondGT;
+    case kCondGT: return kCondLE;
+    case kCondGE: return kCondLT;
+  }
+  LOG(FATAL) << "Unreachable";
+  return kCondEQ;
+}
+
+// Returns the condition that holds when the inputs of `cond` are swapped.
+static inline IfCondition MirrorCondition(IfCondition cond) {
+  switch (cond) {
+    case kCondEQ: return kCondEQ;
+    case kCondNE: return kCondNE;
+    case kCondLT: return kCondGT;
+    case kCondLE: return kCondGE;
+    case kCondGT: return kCondLT;
+    case kCondGE: return kCondLE;
+  }
+  LOG(FATAL) << "Unreachable";
+  return kCondEQ;
+}
+
+// Base class of the instructions comparing two integral inputs and
+// producing a boolean.
+class HCondition : public HBinaryOperation {
+ public:
+  HCondition(HInstruction* first, HInstruction* second)
+      : HBinaryOperation(Primitive::kPrimBoolean, first, second) {}
+
+  virtual Primitive::Type GetType() const { return Primitive::kPrimBoolean; }
+
+  virtual IfCondition GetCondition() const = 0;
+
+  virtual HCondition* AsCondition() { return this; }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HCondition);
+};
+
 // Instruction to check if two inputs are equal to each other.
-class HEqual : public HBinaryOperation {
+class HEqual : public HCondition {
  public:
   HEqual(HInstruction* first, HInstruction* second)
-      : HBinaryOperation(Primitive::kPrimBoolean, first, second) {}
+      : HCondition(first, second) {}
 
   virtual bool IsCommutative() { return true; }
 
-  virtual Primitive::Type GetType() const { return Primitive::kPrimBoolean; }
-
   DECLARE_INSTRUCTION(Equal)
 
+  virtual IfCondition GetCondition() const { return kCondEQ; }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(HEqual);
 };
 
+class HNotEqual : public HCondition {
+ public:
+  HNotEqual(HInstruction* first, HInstruction* second)
+      : HCondition(first, second) {}
+
+  virtual bool IsCommutative() { return true; }
+
+  DECLARE_INSTRUCTION(NotEqual)
+
+  virtual IfCondition GetCondition() const { return kCondNE; }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HNotEqual);
+};
+
+class HLessThan : public HCondition {
+ public:
+  HLessThan(HInstruction* first, HInstruction* second)
+      : HCondition(first, second) {}
+
+  DECLARE_INSTRUCTION(LessThan)
+
+  virtual IfCondition GetCondition() const { return kCondLT; }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HLessThan);
+};
+
+class HLessThanOrEqual : public HCondition {
+ public:
+  HLessThanOrEqual(HInstruction* first, HInstruction* second)
+      : HCondition(first, second) {}
+
+  DECLARE_INSTRUCTION(LessThanOrEqual)
+
+  virtual IfCondition GetCondition() const { return kCondLE; }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HLessThanOrEqual);
+};
+
+class HGreaterThan : public HCondition {
+ public:
+  HGreaterThan(HInstruction* first, HInstruction* second)
+      : HCondition(first, second) {}
+
+  DECLARE_INSTRUCTION(GreaterThan)
+
+  virtual IfCondition GetCondition() const { return kCondGT; }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HGreaterThan);
+};
+
+class HGreaterThanOrEqual : public HCondition {
+ public:
+  HGreaterThanOrEqual(HInstruction* first, HInstruction* second)
+      : HCondition(first, second) {}
+
+  DECLARE_INSTRUCTION(GreaterThanOrEqual)
+
+  virtual IfCondition GetCondition() const { return kCondGE; }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HGreaterThanOrEqual);
+};
+
+// Instruction to compare two long, float or double inputs. Results in -1, 0
+// or 1. On an unordered floating point comparison, the result is the bias
+// (1 for cmpg, -1 for cmpl).
+class HCompare : public HBinaryOperation {
+ public:
+  enum Bias {
+    kNoBias,  // For long comparisons.
+    kGtBias,  // NaN compares greater than anything.
+    kLtBias,  // NaN compares less than anything.
+  };
+
+  HCompare(Primitive::Type type, HInstruction* first, HInstruction* second, Bias bias)
+      : HBinaryOperation(Primitive::kPrimInt, first, second), input_type_(type), bias_(bias) {
+    DCHECK_EQ(type == Primitive::kPrimLong, bias == kNoBias);
+  }
+
+  Primitive::Type GetInputType() const { return input_type_; }
+  bool IsGtBias() const { return bias_ == kGtBias; }
+
+  virtual bool InstructionDataEquals(HInstruction* other) const {
+    HCompare* other_compare = other->AsCompare();
+    return input_type_ == other_compare->input_type_ && bias_ == other_compare->bias_;
+  }
+
+  DECLARE_INSTRUCTION(Compare)
+
+ private:
+  const Primitive::Type input_type_;
+  const Bias bias_;
+
+  DISALLOW_COPY_AND_ASSIGN(HCompare);
+};
+
 // A local in the graph. Corresponds to a Dex register.
 class HLocal : public HTemplateInstruction<0> {
  public:
@@ -901,6 +1235,12 @@ class HIntConstant : public HTemplateInstruction<0> {
   int32_t GetValue() const { return value_; }
   virtual Primitive::Type GetType() const { return Primitive::kPrimInt; }
 
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const {
+    return other->AsIntConstant()->value_ == value_;
+  }
+  virtual size_t ComputeHashCode() const { return GetValue(); }
+
   DECLARE_INSTRUCTION(IntConstant)
 
  private:
@@ -917,6 +1257,12 @@ class HLongConstant : public HTemplateInstruction<0> {
 
   virtual Primitive::Type GetType() const { return Primitive::kPrimLong; }
 
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const {
+    return other->AsLongConstant()->value_ == value_;
+  }
+  virtual size_t ComputeHashCode() const { return static_cast<size_t>(GetValue()); }
+
   DECLARE_INSTRUCTION(LongConstant)
 
  private:
@@ -944,6 +1290,9 @@ class HInvoke : public HInstruction {
   // know their environment.
   virtual bool NeedsEnvironment() const { return true; }
 
+  virtual SideEffects GetSideEffects() const { return SideEffects::All(); }
+  virtual bool CanThrow() const { return true; }
+
   void SetArgumentAt(size_t index, HInstruction* argument) {
     SetRawInputAt(index, argument);
   }
@@ -985,23 +1334,78 @@ class HInvokeStatic : public HInvoke {
   DISALLOW_COPY_AND_ASSIGN(HInvokeStatic);
 };
 
+// A virtual call, dispatched through the vtable of the receiver's class. The
+// receiver is the first argument and must have been null checked.
+class HInvokeVirtual : public HInvoke {
+ public:
+  HInvokeVirtual(ArenaAllocator* arena,
+                 uint32_t number_of_arguments,
+                 Primitive::Type return_type,
+                 uint32_t dex_pc,
+                 uint32_t vtable_index)
+      : HInvoke(arena, number_of_arguments, return_type, dex_pc),
+        vtable_index_(vtable_index) {}
+
+  uint32_t GetVTableIndex() const { return vtable_index_; }
+
+  DECLARE_INSTRUCTION(InvokeVirtual)
+
+ private:
+  const uint32_t vtable_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(HInvokeVirtual);
+};
+
+// An interface call. The target is resolved by the runtime, which also
+// throws if the receiver is null.
+class HInvokeInterface : public HInvoke {
+ public:
+  HInvokeInterface(ArenaAllocator* arena,
+                   uint32_t number_of_arguments,
+                   Primitive::Type return_type,
+                   uint32_t dex_pc,
+                   uint32_t dex_method_index)
+      : HInvoke(arena, number_of_arguments, return_type, dex_pc),
+        dex_method_index_(dex_method_index) {}
+
+  uint32_t GetDexMethodIndex() const { return dex_method_index_; }
+
+  DECLARE_INSTRUCTION(InvokeInterface)
+
+ private:
+  const uint32_t dex_method_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(HInvokeInterface);
+};
+
 class HNewInstance : public HTemplateInstruction<0> {
  public:
-  HNewInstance(uint32_t dex_pc, uint16_t type_index) : dex_pc_(dex_pc), type_index_(type_index) {}
+  HNewInstance(uint32_t dex_pc, uint16_t type_index, bool can_be_removed)
+      : dex_pc_(dex_pc), type_index_(type_index), can_be_removed_(can_be_removed) {}
 
   uint32_t GetDexPc() const { return dex_pc_; }
   uint16_t GetTypeIndex() const { return type_index_; }
 
+  // Returns whether the allocation only allocates: the class is known to be
+  // accessible, instantiable, initialized and not finalizable. The object is
+  // then not needed if it doesn't escape.
+  bool CanBeRemoved() const { return can_be_removed_; }
+
   virtual Primitive::Type GetType() const { return Primitive::kPrimNot; }
 
   // Calls runtime so needs an environment.
   virtual bool NeedsEnvironment() const { return true; }
 
+  // The allocation may run class initializers.
+  virtual SideEffects GetSideEffects() const { return SideEffects::All(); }
+  virtual bool CanThrow() const { return true; }
+
   DECLARE_INSTRUCTION(NewInstance)
 
  private:
   const uint32_t dex_pc_;
   const uint16_t type_index_;
+  const bool can_be_removed_;
 
   DISALLOW_COPY_AND_ASSIGN(HNewInstance);
 };
@@ -1032,6 +1436,69 @@ class HSub : public HBinaryOperation {
   DISALLOW_COPY_AND_ASSIGN(HSub);
 };
 
+class HMul : public HBinaryOperation {
+ public:
+  HMul(Primitive::Type result_type, HInstruction* left, HInstruction* right)
+      : HBinaryOperation(result_type, left, right) {}
+
+  virtual bool IsCommutative() { return true; }
+
+  DECLARE_INSTRUCTION(Mul);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HMul);
+};
+
+// Integral divisions expect their divisor to have been checked against zero
+// with a HDivZeroCheck.
+class HDiv : public HBinaryOperation {
+ public:
+  HDiv(Primitive::Type result_type, HInstruction* left, HInstruction* right)
+      : HBinaryOperation(result_type, left, right) {}
+
+  DECLARE_INSTRUCTION(Div);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HDiv);
+};
+
+class HRem : public HBinaryOperation {
+ public:
+  HRem(Primitive::Type result_type, HInstruction* left, HInstruction* right)
+      : HBinaryOperation(result_type, left, right) {}
+
+  DECLARE_INSTRUCTION(Rem);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HRem);
+};
+
+// Throws an ArithmeticException if its input is zero, and otherwise
+// forwards it.
+class HDivZeroCheck : public HTemplateInstruction<1> {
+ public:
+  HDivZeroCheck(HInstruction* value, uint32_t dex_pc) : dex_pc_(dex_pc) {
+    SetRawInputAt(0, value);
+  }
+
+  virtual Primitive::Type GetType() const { return InputAt(0)->GetType(); }
+
+  virtual bool NeedsEnvironment() const { return true; }
+
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+  virtual bool CanThrow() const { return true; }
+
+  uint32_t GetDexPc() const { return dex_pc_; }
+
+  DECLARE_INSTRUCTION(DivZeroCheck);
+
+ private:
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(HDivZeroCheck);
+};
+
 // The value of a parameter in this method. Its location depends on
 // the calling convention.
 class HParameterValue : public HTemplateInstruction<0> {
@@ -1063,6 +1530,9 @@ class HNot : public HTemplateInstruction<1> {
 
   virtual Primitive::Type GetType() const { return Primitive::kPrimBoolean; }
 
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+
   DECLARE_INSTRUCTION(Not);
 
  private:
@@ -1088,6 +1558,7 @@ class HPhi : public HInstruction {
   void AddInput(HInstruction* input);
 
   virtual Primitive::Type GetType() const { return type_; }
+  void SetType(Primitive::Type type) { type_ = type; }
 
   uint32_t GetRegNumber() const { return reg_number_; }
 
@@ -1096,12 +1567,414 @@ class HPhi : public HInstruction {
  protected:
   GrowableArray<HInstruction*> inputs_;
   const uint32_t reg_number_;
-  const Primitive::Type type_;
+  Primitive::Type type_;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(HPhi);
 };
 
+// Throws a NullPointerException if its input is null, and otherwise
+// forwards it.
+class HNullCheck : public HTemplateInstruction<1> {
+ public:
+  HNullCheck(HInstruction* value, uint32_t dex_pc) : dex_pc_(dex_pc) {
+    SetRawInputAt(0, value);
+  }
+
+  virtual Primitive::Type GetType() const { return Primitive::kPrimNot; }
+
+  virtual bool NeedsEnvironment() const { return true; }
+
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+  virtual bool CanThrow() const { return true; }
+
+  uint32_t GetDexPc() const { return dex_pc_; }
+
+  DECLARE_INSTRUCTION(NullCheck);
+
+ private:
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(HNullCheck);
+};
+
+class FieldInfo : public ValueObject {
+ public:
+  FieldInfo(MemberOffset field_offset, Primitive::Type field_type)
+      : field_offset_(field_offset), field_type_(field_type) {}
+
+  MemberOffset GetFieldOffset() const { return field_offset_; }
+  Primitive::Type GetFieldType() const { return field_type_; }
+
+ private:
+  const MemberOffset field_offset_;
+  const Primitive::Type field_type_;
+};
+
+// Reads a non volatile instance field. The object must have been null checked.
+class HInstanceFieldGet : public HTemplateInstruction<1> {
+ public:
+  HInstanceFieldGet(HInstruction* object, Primitive::Type field_type, MemberOffset field_offset)
+      : field_info_(field_offset, field_type) {
+    SetRawInputAt(0, object);
+  }
+
+  MemberOffset GetFieldOffset() const { return field_info_.GetFieldOffset(); }
+  Primitive::Type GetFieldType() const { return field_info_.GetFieldType(); }
+
+  virtual Primitive::Type GetType() const { return GetFieldType(); }
+
+  virtual SideEffects GetSideEffects() const { return SideEffects::FieldRead(); }
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const {
+    size_t other_offset = other->AsInstanceFieldGet()->GetFieldOffset().SizeValue();
+    return other_offset == GetFieldOffset().SizeValue();
+  }
+  virtual size_t ComputeHashCode() const {
+    return (HInstruction::ComputeHashCode() << 7) | GetFieldOffset().SizeValue();
+  }
+
+  DECLARE_INSTRUCTION(InstanceFieldGet);
+
+ private:
+  const FieldInfo field_info_;
+
+  DISALLOW_COPY_AND_ASSIGN(HInstanceFieldGet);
+};
+
+// Writes a non volatile instance field. The object must have been null checked.
+class HInstanceFieldSet : public HTemplateInstruction<2> {
+ public:
+  HInstanceFieldSet(HInstruction* object,
+                    HInstruction* value,
+                    Primitive::Type field_type,
+                    MemberOffset field_offset)
+      : field_info_(field_offset, field_type) {
+    SetRawInputAt(0, object);
+    SetRawInputAt(1, value);
+  }
+
+  MemberOffset GetFieldOffset() const { return field_info_.GetFieldOffset(); }
+  Primitive::Type GetFieldType() const { return field_info_.GetFieldType(); }
+
+  virtual SideEffects GetSideEffects() const { return SideEffects::FieldWrite(); }
+
+  DECLARE_INSTRUCTION(InstanceFieldSet);
+
+ private:
+  const FieldInfo field_info_;
+
+  DISALLOW_COPY_AND_ASSIGN(HInstanceFieldSet);
+};
+
+// Reads an element of an array. The array must have been null checked and
+// the index bounds checked.
+class HArrayGet : public HTemplateInstruction<2> {
+ public:
+  HArrayGet(HInstruction* array, HInstruction* index, Primitive::Type type) : type_(type) {
+    SetRawInputAt(0, array);
+    SetRawInputAt(1, index);
+  }
+
+  virtual Primitive::Type GetType() const { return type_; }
+
+  virtual SideEffects GetSideEffects() const { return SideEffects::ArrayRead(); }
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+
+  DECLARE_INSTRUCTION(ArrayGet);
+
+ private:
+  const Primitive::Type type_;
+
+  DISALLOW_COPY_AND_ASSIGN(HArrayGet);
+};
+
+// Writes an element of an array. The array must have been null checked and
+// the index bounds checked. Storing a reference calls the runtime, which
+// performs the type check.
+class HArraySet : public HTemplateInstruction<3> {
+ public:
+  HArraySet(HInstruction* array,
+            HInstruction* index,
+            HInstruction* value,
+            Primitive::Type component_type,
+            uint32_t dex_pc)
+      : component_type_(component_type), dex_pc_(dex_pc) {
+    SetRawInputAt(0, array);
+    SetRawInputAt(1, index);
+    SetRawInputAt(2, value);
+  }
+
+  virtual bool NeedsEnvironment() const {
+    // We currently always call a runtime method to catch array store
+    // exceptions.
+    return InputAt(2)->GetType() == Primitive::kPrimNot;
+  }
+
+  virtual SideEffects GetSideEffects() const { return SideEffects::ArrayWrite(); }
+  virtual bool CanThrow() const { return NeedsEnvironment(); }
+
+  uint32_t GetDexPc() const { return dex_pc_; }
+
+  Primitive::Type GetComponentType() const { return component_type_; }
+
+  DECLARE_INSTRUCTION(ArraySet);
+
+ private:
+  const Primitive::Type component_type_;
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(HArraySet);
+};
+
+// The length of an array. The array must have been null checked.
+class HArrayLength : public HTemplateInstruction<1> {
+ public:
+  explicit HArrayLength(HInstruction* array) {
+    SetRawInputAt(0, array);
+  }
+
+  virtual Primitive::Type GetType() const { return Primitive::kPrimInt; }
+
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+
+  DECLARE_INSTRUCTION(ArrayLength);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HArrayLength);
+};
+
+// Throws an ArrayIndexOutOfBoundsException if the index does not lie in
+// [0, length), and otherwise forwards the index.
+class HBoundsCheck : public HTemplateInstruction<2> {
+ public:
+  HBoundsCheck(HInstruction* index, HInstruction* length, uint32_t dex_pc) : dex_pc_(dex_pc) {
+    DCHECK(index->GetType() == Primitive::kPrimInt);
+    SetRawInputAt(0, index);
+    SetRawInputAt(1, length);
+  }
+
+  virtual bool NeedsEnvironment() const { return true; }
+
+  virtual Primitive::Type GetType() const { return Primitive::kPrimInt; }
+
+  virtual bool CanBeMoved() const { return true; }
+  virtual bool InstructionDataEquals(HInstruction* other) const { return true; }
+  virtual bool CanThrow() const { return true; }
+
+  uint32_t GetDexPc() const { return dex_pc_; }
+
+  DECLARE_INSTRUCTION(BoundsCheck);
+
+ private:
+  const uint32_t dex_pc_;
+
+  DISALLOW_COPY_AND_ASSIGN(HBoundsCheck);
+};
+
+// Performs with vector instructions the first iterations of a counted loop
+// `for (int i = start; i < bound; ++i)` whose body is the single statement:
+//
+//   destination[i] = left           (kFill)
+//   destination[i] = left[i]        (kCopy)
+//   destination[i] = left op right  (kAdd, kSub, kMul)
+//
+// The operands of `op` are either arrays, read at `i`, or loop invariant
+// ints. Iterations are performed as long as they fill whole vectors, and
+// would not throw: the instruction stops before a null array, an index out of
+// the bounds of one of the arrays, or a negative start. It returns the index
+// the scalar loop resumes at.
+class HVectorizedLoop : public HInstruction {
+ public:
+  enum Operation {
+    kFill,
+    kCopy,
+    kAdd,
+    kSub,
+    kMul,
+  };
+
+  // Size in bytes of the vectors, for both NEON Q registers and XMM registers.
+  static constexpr size_t kVectorSize = 16;
+
+  HVectorizedLoop(ArenaAllocator* arena,
+                  Operation operation,
+                  Primitive::Type component_type,
+                  HInstruction* start,
+                  HInstruction* bound,
+                  HInstruction* destination,
+                  HInstruction* left,
+                  HInstruction* right)
+      : inputs_(arena, 5),
+        operation_(operation),
+        component_type_(component_type) {
+    DCHECK_EQ(right == nullptr, operation == kFill || operation == kCopy);
+    inputs_.SetSize(right == nullptr ? 4 : 5);
+    SetRawInputAt(0, start);
+    SetRawInputAt(1, bound);
+    SetRawInputAt(2, destination);
+    SetRawInputAt(3, left);
+    if (right != nullptr) {
+      SetRawInputAt(4, right);
+    }
+  }
+
+  virtual size_t InputCount() const { return inputs_.Size(); }
+  virtual HInstruction* InputAt(size_t i) const { return inputs_.Get(i); }
+
+  virtual void SetRawInputAt(size_t index, HInstruction* input) {
+    inputs_.Put(index, input);
+  }
+
+  virtual Primitive::Type GetType() const { return Primitive::kPrimInt; }
+
+  virtual SideEffects GetSideEffects() const {
+    return SideEffects::ArrayWrite().Union(SideEffects::ArrayRead());
+  }
+
+  Operation GetOperation() const { return operation_; }
+  Primitive::Type GetComponentType() const { return component_type_; }
+
+  HInstruction* GetStart() const { return InputAt(0); }
+  HInstruction* GetBound() const { return InputAt(1); }
+  HInstruction* GetDestination() const { return InputAt(2); }
+  HInstruction* GetLeft() const { return InputAt(3); }
+  HInstruction* GetRight() const { return InputCount() > 4 ? InputAt(4) : nullptr; }
+
+  // Returns whether input `index` is an array, read at `i`, rather than a value.
+  bool IsArrayInput(size_t index) const {
+    return index >= 2
+        && (index != 3 || operation_ != kFill)
+        && InputAt(index)->GetType() == Primitive::kPrimNot;
+  }
+
+  // Number of iterations each vector instruction performs.
+  size_t GetVectorLength() const {
+    return kVectorSize / Primitive::ComponentSize(component_type_);
+  }
+
+  DECLARE_INSTRUCTION(VectorizedLoop);
+
+ private:
+  GrowableArray<HInstruction*> inputs_;
+  const Operation operation_;
+  const Primitive::Type component_type_;
+
+  DISALLOW_COPY_AND_ASSIGN(HVectorizedLoop);
+};
+
+/**
+ * Some DEX instructions are folded into multiple HInstructions that need
+ * to stay live until the last HInstruction. This class
+ * is used as a marker for the baseline compiler to ensure its preceding
+ * HInstruction stays live. `index` is the temporary number that is used
+ * for knowing the stack offset where to store the instruction.
+ */
+class HTemporary : public HTemplateInstruction<0> {
+ public:
+  explicit HTemporary(size_t index) : index_(index) {}
+
+  size_t GetIndex() const { return index_; }
+
+  // The temporary holds the value of the instruction preceding it.
+  virtual Primitive::Type GetType() const { return GetPrevious()->GetType(); }
+
+  DECLARE_INSTRUCTION(Temporary);
+
+ private:
+  const size_t index_;
+
+  DISALLOW_COPY_AND_ASSIGN(HTemporary);
+};
+
+class MoveOperands : public ArenaObject {
+ public:
+  MoveOperands(Location source, Location destination)
+      : source_(source), destination_(destination) {}
+
+  Location GetSource() const { return source_; }
+  Location GetDestination() const { return destination_; }
+
+  void SetSource(Location value) { source_ = value; }
+  void SetDestination(Location value) { destination_ = value; }
+
+  // The parallel move resolver marks moves as "in-progress" by clearing the
+  // destination (but not the source).
+  Location MarkPending() {
+    DCHECK(!IsPending());
+    Location dest = destination_;
+    destination_ = Location::NoLocation();
+    return dest;
+  }
+
+  void ClearPending(Location dest) {
+    DCHECK(IsPending());
+    destination_ = dest;
+  }
+
+  bool IsPending() const {
+    DCHECK(source_.IsValid() || !destination_.IsValid());
+    return !destination_.IsValid() && source_.IsValid();
+  }
+
+  // True if this blocks a move from the given location.
+  bool Blocks(Location loc) const {
+    return !IsEliminated() && source_.Equals(loc);
+  }
+
+  // A move is redundant if it's been eliminated, if its source and
+  // destination are the same, or if its destination is unneeded.
+  bool IsRedundant() const {
+    return IsEliminated() || !destination_.IsValid() || source_.Equals(destination_);
+  }
+
+  // We clear both operands to indicate move that's been eliminated.
+  void Eliminate() {
+    source_ = destination_ = Location::NoLocation();
+  }
+
+  bool IsEliminated() const {
+    DCHECK(source_.IsValid() || !destination_.IsValid());
+    return !source_.IsValid();
+  }
+
+ private:
+  Location source_;
+  Location destination_;
+
+  DISALLOW_COPY_AND_ASSIGN(MoveOperands);
+};
+
+static constexpr size_t kDefaultNumberOfMoves = 4;
+
+// A set of moves that happen simultaneously: all sources are read before any
+// destination is written. Inserted by the register allocator to connect split
+// intervals and to resolve phis.
+class HParallelMove : public HTemplateInstruction<0> {
+ public:
+  explicit HParallelMove(ArenaAllocator* arena) : moves_(arena, kDefaultNumberOfMoves) {}
+
+  void AddMove(MoveOperands* move) {
+    moves_.Add(move);
+  }
+
+  MoveOperands* MoveOperandsAt(size_t index) const {
+    return moves_.Get(index);
+  }
+
+  size_t NumMoves() const { return moves_.Size(); }
+
+  DECLARE_INSTRUCTION(ParallelMove)
+
+ private:
+  GrowableArray<MoveOperands*> moves_;
+
+  DISALLOW_COPY_AND_ASSIGN(HParallelMove);
+};
+
 class HGraphVisitor : public ValueObject {
  public:
   explicit HGraphVisitor(HGraph* graph) : graph_(graph) { }
@@ -14,17 +14,31 @@
  * limitations under the License.
  */
 
+#include "optimizing_compiler.h"
+
 #include <fstream>
 #include <stdint.h>
 
+#include "bounds_check_elimination.h"
 #include "builder.h"
 #include "code_generator.h"
 #include "compilers.h"
+#include "constant_folding.h"
+#include "dead_code_elimination.h"
 #include "driver/compiler_driver.h"
 #include "driver/dex_compilation_unit.h"
 #include "graph_visualizer.h"
+#include "gvn.h"
+#include "instruction_simplifier.h"
+#include "licm.h"
+#include "loop_vectorizer.h"
 #include "nodes.h"
+#include "prepare_for_register_allocation.h"
+#include "register_allocator.h"
+#include "scalar_replacement.h"
+#include "side_effects_analysis.h"
 #include "ssa_liveness_analysis.h"
+#include "ssa_phi_elimination.h"
 #include "utils/arena_allocator.h"
 
 namespace art {
@@ -52,6 +66,70 @@ class CodeVectorAllocator FINAL : public CodeAllocator {
   DISALLOW_COPY_AND_ASSIGN(CodeVectorAllocator);
 };
 
+/**
+ * Runs the optimizations that remove redundant phis, fold constants, simplify
+ * instructions, replace non escaping objects with their fields, remove
+ * redundant instructions and bounds checks, move loop invariant instructions
+ * out of loops, vectorize simple array loops, and remove dead instructions.
+ * The graph is dumped after each pass. It must be in SSA form, and its loops
+ * must have been found.
+ */
+static void RunOptimizations(HGraph* graph,
+                             InstructionSet instruction_set,
+                             const InstructionSetFeatures& features,
+                             HGraphVisualizer* visualizer) {
+  SsaRedundantPhiElimination(graph).Run();
+  visualizer->DumpGraph("redundant_phi_elimination");
+  SsaDeadPhiElimination(graph).Run();
+  visualizer->DumpGraph("dead_phi_elimination");
+  ConstantFolding(graph).Run();
+  visualizer->DumpGraph("constant_folding");
+  InstructionSimplifier(graph).Run();
+  visualizer->DumpGraph("instruction_simplifier");
+  ScalarReplacement(graph).Run();
+  visualizer->DumpGraph("scalar_replacement");
+  SideEffectsAnalysis side_effects(graph);
+  side_effects.Run();
+  GlobalValueNumberer(graph->GetArena(), graph, side_effects).Run();
+  visualizer->DumpGraph("gvn");
+  BoundsCheckElimination(graph).Run();
+  visualizer->DumpGraph("bce");
+  LICM(graph, side_effects).Run();
+  visualizer->DumpGraph("licm");
+  LoopVectorizer(graph, instruction_set, features).Run();
+  visualizer->DumpGraph("vectorizer");
+  DeadCodeElimination(graph).Run();
+  visualizer->DumpGraph("dead_code_elimination");
+}
+
+CodeGenerator* TryCompileOptimized(HGraph* graph,
+                                   InstructionSet instruction_set,
+                                   const InstructionSetFeatures& features,
+                                   CodeAllocator* allocator,
+                                   HGraphVisualizer* visualizer) {
+  // The optimizations run first, as they can remove the instructions the
+  // register allocator does not support yet.
+  RunOptimizations(graph, instruction_set, features, visualizer);
+  if (!RegisterAllocator::CanAllocateRegistersFor(*graph, instruction_set)) {
+    return nullptr;
+  }
+
+  // The code generator is created once the blocks of the graph are final.
+  CodeGenerator* codegen = CodeGenerator::Create(graph->GetArena(), graph, instruction_set);
+  DCHECK(codegen != nullptr);
+
+  PrepareForRegisterAllocation(graph).Run();
+  SsaLivenessAnalysis liveness(*graph);
+  liveness.Analyze();
+  visualizer->DumpGraph("liveness");
+
+  RegisterAllocator(graph->GetArena(), codegen, liveness).AllocateRegisters();
+  visualizer->DumpGraph("register");
+
+  codegen->CompileOptimized(allocator);
+  return codegen;
+}
+
 /**
  * If set to true, generates a file suitable for the c1visualizer tool and IRHydra.
  */
@@ -87,7 +165,7 @@ CompiledMethod* OptimizingCompiler::TryCompile(const DexFile::CodeItem* code_ite
 
   ArenaPool pool;
   ArenaAllocator arena(&pool);
-  HGraphBuilder builder(&arena, &dex_compilation_unit, &dex_file);
+  HGraphBuilder builder(&arena, &dex_compilation_unit, &dex_file, GetCompilerDriver());
 
   HGraph* graph = builder.BuildGraph(*code_item);
   if (graph == nullptr) {
@@ -104,42 +182,50 @@ CompiledMethod* OptimizingCompiler::TryCompile(const DexFile::CodeItem* code_ite
   if (instruction_set == kThumb2) {
     instruction_set = kArm;
   }
-  CodeGenerator* codegen = CodeGenerator::Create(&arena, graph, instruction_set);
-  if (codegen == nullptr) {
-    if (shouldCompile) {
-      LOG(FATAL) << "Could not find code generator for optimizing compiler";
-    }
-    return nullptr;
-  }
 
   CodeVectorAllocator allocator;
-  codegen->Compile(&allocator);
+  InstructionSetFeatures features = GetCompilerDriver()->GetInstructionSetFeatures();
 
-  std::vector<uint8_t> mapping_table;
-  codegen->BuildMappingTable(&mapping_table);
-  std::vector<uint8_t> vmap_table;
-  codegen->BuildVMapTable(&vmap_table);
-  std::vector<uint8_t> gc_map;
-  codegen->BuildNativeGCMap(&gc_map, dex_compilation_unit);
-
-  // Run these phases to get some test coverage.
   graph->BuildDominatorTree();
   graph->TransformToSSA();
   visualizer.DumpGraph("ssa");
+  CodeGenerator* codegen = nullptr;
+  if (graph->FindNaturalLoops()) {
+    codegen = TryCompileOptimized(graph, instruction_set, features, &allocator, &visualizer);
+  }
+
+  if (codegen == nullptr) {
+    // The baseline code generator needs the graph as built, with the dex
+    // registers in locals.
+    HGraphBuilder baseline_builder(
+        &arena, &dex_compilation_unit, &dex_file, GetCompilerDriver());
+    graph = baseline_builder.BuildGraph(*code_item);
+    DCHECK(graph != nullptr);
+    codegen = CodeGenerator::Create(&arena, graph, instruction_set);
+    if (codegen == nullptr) {
+      if (shouldCompile) {
+        LOG(FATAL) << "Could not find code generator for optimizing compiler";
+      }
+      return nullptr;
+    }
+    codegen->CompileBaseline(&allocator);
+  }
 
-  graph->FindNaturalLoops();
-  SsaLivenessAnalysis(*graph).Analyze();
-  visualizer.DumpGraph("liveness");
+  // The stack maps are stored in place of the vmap table, and the method has
+  // no mapping table nor GC map. This is how the runtime tells them apart.
+  std::vector<uint8_t> stack_maps;
+  codegen->BuildStackMaps(&stack_maps, dex_compilation_unit);
 
+  GetCompilerDriver()->RecordArenaUsage(dex_file, method_idx, arena.BytesUsed());
   return new CompiledMethod(GetCompilerDriver(),
                             instruction_set,
                             allocator.GetMemory(),
                             codegen->GetFrameSize(),
                             codegen->GetCoreSpillMask(),
                             0, /* FPR spill mask, unused */
-                            mapping_table,
-                            vmap_table,
-                            gc_map,
+                            std::vector<uint8_t>(),
+                            stack_maps,
+                            std::vector<uint8_t>(),
                             nullptr);
 }
 
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_OPTIMIZING_COMPILER_H_
+#define ART_COMPILER_OPTIMIZING_OPTIMIZING_COMPILER_H_
+
+#include "instruction_set.h"
+
+namespace art {
+
+class CodeAllocator;
+class CodeGenerator;
+class HGraph;
+class HGraphVisualizer;
+
+/**
+ * Optimizes `graph`, which must be in SSA form and have its loops found, and
+ * generates its code with the register allocator if the optimized graph allows
+ * it. Returns the code generator that emitted the code, or null if the graph
+ * still has instructions that only the baseline code generator supports. As
+ * the baseline code generator works on the graph as built by HGraphBuilder,
+ * the graph must then be built again.
+ */
+CodeGenerator* TryCompileOptimized(HGraph* graph,
+                                   InstructionSet instruction_set,
+                                   const InstructionSetFeatures& features,
+                                   CodeAllocator* allocator,
+                                   HGraphVisualizer* visualizer);
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_OPTIMIZING_COMPILER_H_
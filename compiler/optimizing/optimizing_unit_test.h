@@ -17,6 +17,13 @@
 #ifndef ART_COMPILER_OPTIMIZING_OPTIMIZING_UNIT_TEST_H_
 #define ART_COMPILER_OPTIMIZING_OPTIMIZING_UNIT_TEST_H_
 
+#include <vector>
+
+#include "code_generator.h"
+#include "graph_visualizer.h"
+#include "nodes.h"
+#include "optimizing_compiler.h"
+
 #define NUM_INSTRUCTIONS(...)  \
   (sizeof((uint16_t[]) {__VA_ARGS__}) /sizeof(uint16_t))
 
@@ -29,4 +36,42 @@
 #define TWO_REGISTERS_CODE_ITEM(...)                                       \
     { 2, 0, 0, 0, 0, 0, NUM_INSTRUCTIONS(__VA_ARGS__), 0, __VA_ARGS__ }
 
+#define FOUR_REGISTERS_CODE_ITEM(...)                                      \
+    { 4, 0, 0, 0, 0, 0, NUM_INSTRUCTIONS(__VA_ARGS__), 0, __VA_ARGS__ }
+
+namespace art {
+
+/**
+ * Code allocator for the tests that only check that code gets generated.
+ */
+class TestCodeAllocator : public CodeAllocator {
+ public:
+  TestCodeAllocator() { }
+
+  virtual uint8_t* Allocate(size_t size) {
+    memory_.resize(size);
+    return &memory_[0];
+  }
+
+ private:
+  std::vector<uint8_t> memory_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestCodeAllocator);
+};
+
+/**
+ * Optimizes `graph`, which must be in SSA form and have its loops found, and
+ * generates its code as the optimizing compiler does. Returns whether the
+ * code was generated with the register allocator.
+ */
+inline bool CompileOptimized(HGraph* graph,
+                             InstructionSet instruction_set,
+                             const InstructionSetFeatures& features) {
+  TestCodeAllocator allocator;
+  HGraphVisualizer visualizer(nullptr, graph, "");
+  return TryCompileOptimized(graph, instruction_set, features, &allocator, &visualizer) != nullptr;
+}
+
+}  // namespace art
+
 #endif  // ART_COMPILER_OPTIMIZING_OPTIMIZING_UNIT_TEST_H_
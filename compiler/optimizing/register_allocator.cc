@@ -0,0 +1,1021 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "register_allocator.h"
+
+#include "code_generator.h"
+#include "nodes.h"
+#include "ssa_liveness_analysis.h"
+#include "utils/arena_bit_vector.h"
+
+namespace art {
+
+static constexpr size_t kMaxLifetimePosition = -1;
+static constexpr size_t kDefaultNumberOfSpillSlots = 4;
+
+// Returns the last position where the instruction of `interval` is live.
+static size_t GetLifetimeEnd(LiveInterval* interval) {
+  LiveInterval* last_sibling = interval;
+  while (last_sibling->GetNextSibling() != nullptr) {
+    last_sibling = last_sibling->GetNextSibling();
+  }
+  return last_sibling->GetEnd();
+}
+
+static bool HasConstantLocation(HInstruction* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  return locations != nullptr && locations->Out().IsConstant();
+}
+
+// Constants are never spilled: the parts of their lifetime that are not in a
+// register use the constant location, from which the code generators
+// materialize the value again.
+static bool IsConstantInterval(LiveInterval* interval) {
+  return !interval->IsTemp()
+      && interval->GetDefinedBy() != nullptr
+      && HasConstantLocation(interval->GetDefinedBy());
+}
+
+RegisterAllocator::RegisterAllocator(ArenaAllocator* allocator,
+                                     CodeGenerator* codegen,
+                                     const SsaLivenessAnalysis& liveness)
+      : allocator_(allocator),
+        codegen_(codegen),
+        liveness_(liveness),
+        unhandled_(allocator, 0),
+        handled_(allocator, 0),
+        active_(allocator, 0),
+        inactive_(allocator, 0),
+        physical_register_intervals_(allocator, codegen->GetNumberOfCoreRegisters()),
+        instruction_intervals_(allocator, 0),
+        temp_intervals_(allocator, 0),
+        spill_slots_(allocator, kDefaultNumberOfSpillSlots),
+        blocked_registers_(static_cast<bool*>(
+            allocator->Alloc(codegen->GetNumberOfRegisters() * sizeof(bool),
+                             kArenaAllocRegAlloc))),
+        number_of_registers_(codegen->GetNumberOfCoreRegisters()),
+        registers_array_(static_cast<size_t*>(
+            allocator->Alloc(codegen->GetNumberOfCoreRegisters() * sizeof(size_t),
+                             kArenaAllocRegAlloc))) {
+  for (size_t i = 0, e = codegen->GetNumberOfRegisters(); i < e; ++i) {
+    blocked_registers_[i] = false;
+  }
+  codegen->SetupBlockedRegisters(blocked_registers_);
+  physical_register_intervals_.SetSize(number_of_registers_);
+  for (size_t i = 0; i < number_of_registers_; ++i) {
+    physical_register_intervals_.Put(i, nullptr);
+  }
+}
+
+bool RegisterAllocator::CanAllocateRegistersFor(const HGraph& graph,
+                                                InstructionSet instruction_set) {
+  if (instruction_set != kArm
+      && instruction_set != kThumb2
+      && instruction_set != kX86
+      && instruction_set != kX86_64) {
+    return false;
+  }
+  const GrowableArray<HBasicBlock*>& blocks = graph.GetBlocks();
+  for (size_t i = 0, e = blocks.Size(); i < e; ++i) {
+    for (HInstructionIterator it(blocks.Get(i)->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* current = it.Current();
+      if (current->NeedsEnvironment()
+          && current->AsNullCheck() == nullptr
+          && current->AsBoundsCheck() == nullptr
+          && current->AsDivZeroCheck() == nullptr) {
+        // Instructions that call into the runtime and return need the values
+        // they keep alive to be described to the GC, and the registers the
+        // call clobbers to be saved, which we do not support yet. The checks
+        // only call into the runtime to throw, and the methods we compile
+        // have no catch handlers: their frame is never resumed.
+        return false;
+      }
+      if (current->GetType() == Primitive::kPrimLong
+          || current->GetType() == Primitive::kPrimFloat
+          || current->GetType() == Primitive::kPrimDouble) {
+        // Register pairs and floating point registers are not supported yet.
+        return false;
+      }
+      if ((current->AsDiv() != nullptr || current->AsRem() != nullptr)
+          && instruction_set != kX86
+          && instruction_set != kX86_64) {
+        // On ARM, divisions are calls to runtime helpers, which clobber registers.
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void RegisterAllocator::AllocateRegisters() {
+  BuildLocations();
+  BuildIntervals();
+  LinearScan();
+  Resolve();
+
+  if (kIsDebugBuild) {
+    Validate(true);
+  }
+}
+
+void RegisterAllocator::BuildLocations() {
+  // Visit in linear order, so that parameters are visited in the order the
+  // calling convention expects.
+  HGraphVisitor* location_builder = codegen_->GetLocationBuilder();
+  for (HLinearOrderIterator it(liveness_.GetLinearPostOrder()); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HInstructionIterator inst_it(block->GetPhis()); !inst_it.Done(); inst_it.Advance()) {
+      inst_it.Current()->Accept(location_builder);
+    }
+    for (HInstructionIterator inst_it(block->GetInstructions());
+         !inst_it.Done();
+         inst_it.Advance()) {
+      inst_it.Current()->Accept(location_builder);
+    }
+  }
+}
+
+void RegisterAllocator::BuildIntervals() {
+  // Register uses must be added in decreasing order, so visit the graph backwards.
+  for (HLinearPostOrderIterator it(liveness_.GetLinearPostOrder()); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HBackwardInstructionIterator inst_it(block->GetInstructions());
+         !inst_it.Done();
+         inst_it.Advance()) {
+      ProcessInstruction(inst_it.Current());
+    }
+    for (HInstructionIterator inst_it(block->GetPhis()); !inst_it.Done(); inst_it.Advance()) {
+      ProcessInstruction(inst_it.Current());
+    }
+  }
+
+  for (size_t i = 0; i < number_of_registers_; ++i) {
+    LiveInterval* fixed = physical_register_intervals_.Get(i);
+    if (fixed != nullptr) {
+      inactive_.Add(fixed);
+    }
+  }
+}
+
+void RegisterAllocator::ProcessInstruction(HInstruction* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  if (locations == nullptr) {
+    return;
+  }
+  size_t position = instruction->GetLifetimePosition();
+
+  // Phi inputs are moved at the end of the predecessors, they do not need a
+  // register at the phi.
+  if (instruction->AsPhi() == nullptr) {
+    for (size_t i = 0; i < instruction->InputCount(); ++i) {
+      Location input = locations->InAt(i);
+      if (input.IsRegister()) {
+        // The resolution moves the input to its register right before the
+        // instruction. Make sure no other value lives in that register.
+        BlockRegister(input, position, position);
+      } else if (input.IsUnallocated()
+                 && (input.GetPolicy() == Location::kRequiresRegister
+                     || HasConstantLocation(instruction->InputAt(i)))) {
+        // The code generators read an input that can be anywhere from a
+        // register or a stack slot, so a constant is moved to a register.
+        instruction->InputAt(i)->GetLiveInterval()->AddRegisterUse(position);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < locations->GetTempCount(); ++i) {
+    Location temp = locations->GetTemp(i);
+    if (temp.IsRegister()) {
+      BlockRegister(temp, position, position);
+    } else {
+      DCHECK(temp.IsUnallocated());
+      DCHECK_EQ(temp.GetPolicy(), Location::kRequiresRegister);
+      LiveInterval* interval = LiveInterval::MakeTempInterval(allocator_, instruction, position);
+      temp_intervals_.Add(interval);
+      AddToUnhandled(interval);
+    }
+  }
+
+  Location output = locations->Out();
+  LiveInterval* current = instruction->GetLiveInterval();
+  if (!output.IsValid()) {
+    DCHECK(current == nullptr);
+    return;
+  }
+
+  if (current == nullptr) {
+    if (instruction->AsPhi() != nullptr) {
+      // A phi without uses does not need to be resolved.
+      return;
+    }
+    // The instruction has no uses, but the code generator still writes its
+    // output somewhere.
+    current = new (allocator_) LiveInterval(allocator_, instruction);
+    current->AddRange(position, position);
+    instruction->SetLiveInterval(current);
+  }
+  instruction_intervals_.Add(current);
+
+  if (output.IsRegister()) {
+    // The instruction is forced to define its output in that register. A
+    // parameter is in its register from the entry of the method.
+    size_t start = instruction->AsParameterValue() != nullptr
+        ? instruction->GetBlock()->GetLifetimeStart()
+        : position;
+    BlockRegister(output, start, position);
+  } else if (output.IsStackSlot()) {
+    // A parameter passed on the stack. The parent stays in the caller's slot,
+    // and the uses that need a register get a split sibling.
+    DCHECK(instruction->AsParameterValue() != nullptr);
+    current->SetSpillSlot(output.GetStackIndex());
+    handled_.Add(current);
+    size_t first_register_use = current->FirstRegisterUse();
+    if (first_register_use != kNoLifetime) {
+      Split(current, first_register_use);
+    }
+    return;
+  } else if (output.IsConstant()) {
+    // Likewise, a constant is not put in a register at its definition, but
+    // moved to one right before the uses that need it.
+    handled_.Add(current);
+    size_t first_register_use = current->FirstRegisterUse();
+    if (first_register_use != kNoLifetime) {
+      Split(current, first_register_use);
+    }
+    return;
+  } else {
+    DCHECK(output.IsUnallocated());
+    if (output.GetPolicy() == Location::kRequiresRegister
+        || output.GetPolicy() == Location::kSameAsFirstInput) {
+      current->AddRegisterUse(position);
+    }
+  }
+  AddToUnhandled(current);
+}
+
+void RegisterAllocator::BlockRegister(Location location, size_t start, size_t end) {
+  int reg = location.reg().RegId();
+  DCHECK_LT(static_cast<size_t>(reg), number_of_registers_);
+  LiveInterval* interval = physical_register_intervals_.Get(reg);
+  if (interval == nullptr) {
+    interval = new (allocator_) LiveInterval(allocator_, nullptr, true, reg);
+    physical_register_intervals_.Put(reg, interval);
+  }
+  DCHECK(interval->GetRanges().IsEmpty() || end < interval->GetStart());
+  interval->AddRange(start, end);
+}
+
+void RegisterAllocator::AddToUnhandled(LiveInterval* interval) {
+  // Intervals are mostly added in decreasing start order, so search from the end.
+  size_t insert_at = unhandled_.Size();
+  while (insert_at > 0 && unhandled_.Get(insert_at - 1)->GetStart() < interval->GetStart()) {
+    --insert_at;
+  }
+  unhandled_.InsertAt(insert_at, interval);
+}
+
+// By the book implementation of a linear scan register allocator
+// (Wimmer and Franz, "Linear Scan Register Allocation on SSA Form").
+void RegisterAllocator::LinearScan() {
+  while (!unhandled_.IsEmpty()) {
+    // (1) Remove interval with the lowest start position from unhandled.
+    LiveInterval* current = unhandled_.Pop();
+    size_t position = current->GetStart();
+
+    // (2) Remove currently active intervals that are dead at this position.
+    //     Move active intervals that have a lifetime hole at this position
+    //     to inactive.
+    for (size_t i = 0; i < active_.Size(); ++i) {
+      LiveInterval* interval = active_.Get(i);
+      if (interval->GetEnd() < position) {
+        active_.Delete(interval);
+        --i;
+        handled_.Add(interval);
+      } else if (!interval->Covers(position)) {
+        active_.Delete(interval);
+        --i;
+        inactive_.Add(interval);
+      }
+    }
+
+    // (3) Remove currently inactive intervals that are dead at this position.
+    //     Move inactive intervals that cover this position to active.
+    for (size_t i = 0; i < inactive_.Size(); ++i) {
+      LiveInterval* interval = inactive_.Get(i);
+      if (interval->GetEnd() < position) {
+        inactive_.Delete(interval);
+        --i;
+        handled_.Add(interval);
+      } else if (interval->Covers(position)) {
+        inactive_.Delete(interval);
+        --i;
+        active_.Add(interval);
+      }
+    }
+
+    if (current != current->GetParent()
+        && (current->HasSpillSlot() || IsConstantInterval(current))
+        && current->FirstRegisterUse() == kNoLifetime) {
+      // The value is already in its spill slot or is a constant, and this
+      // part of its lifetime does not need a register.
+      handled_.Add(current);
+      continue;
+    }
+
+    // (4) Try to find an available register.
+    bool success = TryAllocateFreeReg(current);
+
+    // (5) If no register could be found, we need to spill.
+    if (!success) {
+      success = AllocateBlockedReg(current);
+    }
+
+    // (6) If the interval had a register allocated, add it to the list of active
+    //     intervals.
+    if (success) {
+      active_.Add(current);
+    } else {
+      handled_.Add(current);
+    }
+  }
+}
+
+int RegisterAllocator::FindReusableInputRegister(LiveInterval* interval) const {
+  HInstruction* defined_by = interval->GetDefinedBy();
+  size_t position = interval->GetStart();
+  LocationSummary* locations = defined_by->GetLocations();
+  Location output = locations->Out();
+  // With a same-as-first-input output, only the first input can share the
+  // output register: the others are read after the output is written.
+  size_t number_of_inputs = output.IsUnallocated()
+      && output.GetPolicy() == Location::kSameAsFirstInput
+      ? std::min(defined_by->InputCount(), static_cast<size_t>(1))
+      : defined_by->InputCount();
+  for (size_t i = 0; i < number_of_inputs; ++i) {
+    LiveInterval* input = defined_by->InputAt(i)->GetLiveInterval()->GetSiblingAt(position);
+    if (input != nullptr
+        && input->HasRegister()
+        && input->GetEnd() == position
+        && input->GetNextSibling() == nullptr) {
+      return input->GetRegister();
+    }
+  }
+  return kNoRegister;
+}
+
+// Find a free register. If multiple are found, pick the register that
+// is free the longest.
+bool RegisterAllocator::TryAllocateFreeReg(LiveInterval* current) {
+  size_t* free_until = registers_array_;
+  size_t position = current->GetStart();
+
+  // An instruction can reuse the register of an input that dies at its
+  // definition, and can be forced to define its output in a fixed register.
+  int reusable_register = kNoRegister;
+  int fixed_register = kNoRegister;
+  HInstruction* defined_by = current->GetDefinedBy();
+  if (current == current->GetParent()
+      && !current->IsTemp()
+      && defined_by != nullptr
+      && defined_by->AsPhi() == nullptr
+      && defined_by->GetLifetimePosition() == position) {
+    reusable_register = FindReusableInputRegister(current);
+    Location output = defined_by->GetLocations()->Out();
+    if (output.IsRegister()) {
+      fixed_register = output.reg().RegId();
+    }
+  }
+
+  // First set all registers to be free.
+  for (size_t i = 0; i < number_of_registers_; ++i) {
+    free_until[i] = blocked_registers_[i] ? 0 : kMaxLifetimePosition;
+  }
+
+  // For each active interval, set its register to not free.
+  for (size_t i = 0, e = active_.Size(); i < e; ++i) {
+    LiveInterval* interval = active_.Get(i);
+    int reg = interval->GetRegister();
+    if (interval->IsFixed() && reg == fixed_register) {
+      // The fixed interval blocks the register for this output. It is only
+      // unavailable at the next intersection.
+      size_t next_intersection = interval->FirstIntersectionWith(*current, position + 1);
+      free_until[reg] = std::min(free_until[reg], next_intersection);
+    } else if (!interval->IsFixed()
+               && reg == reusable_register
+               && interval->GetEnd() == position) {
+      // The input dies at this instruction, its register can be reused.
+      continue;
+    } else {
+      free_until[reg] = 0;
+    }
+  }
+
+  // For each inactive interval, set its register to be free until
+  // the next intersection with `current`.
+  for (size_t i = 0, e = inactive_.Size(); i < e; ++i) {
+    LiveInterval* interval = inactive_.Get(i);
+    int reg = interval->GetRegister();
+    size_t min_position = (interval->IsFixed() && reg == fixed_register) ? position + 1 : 0;
+    size_t next_intersection = interval->FirstIntersectionWith(*current, min_position);
+    if (next_intersection != kNoLifetime) {
+      free_until[reg] = std::min(free_until[reg], next_intersection);
+    }
+  }
+
+  int reg;
+  if (fixed_register != kNoRegister) {
+    reg = fixed_register;
+    DCHECK_GT(free_until[reg], position);
+  } else if (reusable_register != kNoRegister
+             && free_until[reusable_register] > current->GetEnd()) {
+    reg = reusable_register;
+  } else {
+    // Pick the register that is free the longest.
+    reg = 0;
+    for (size_t i = 1; i < number_of_registers_; ++i) {
+      if (free_until[i] > free_until[reg]) {
+        reg = i;
+      }
+    }
+  }
+
+  // If we could not find a register, we need to spill.
+  if (free_until[reg] <= position) {
+    return false;
+  }
+
+  current->SetRegister(reg);
+  if (free_until[reg] <= current->GetEnd()) {
+    // If the register is only available for a subset of live ranges
+    // covered by `current`, split `current` at the position where
+    // the register is not available anymore.
+    Split(current, free_until[reg]);
+  }
+  return true;
+}
+
+// Find the register that is used the last, and spill the interval
+// that holds it. If the first use of `current` is after that register
+// we spill `current` instead.
+bool RegisterAllocator::AllocateBlockedReg(LiveInterval* current) {
+  size_t position = current->GetStart();
+  size_t first_register_use = current->FirstRegisterUse();
+  if (first_register_use == kNoLifetime) {
+    AllocateSpillSlotFor(current);
+    return false;
+  }
+
+  // First set all registers as not being used, and compute the position
+  // where fixed intervals block them.
+  size_t* next_use = registers_array_;
+  for (size_t i = 0; i < number_of_registers_; ++i) {
+    next_use[i] = blocked_registers_[i] ? 0 : kMaxLifetimePosition;
+  }
+  size_t* block_position = static_cast<size_t*>(
+      allocator_->Alloc(number_of_registers_ * sizeof(size_t), kArenaAllocRegAlloc));
+  for (size_t i = 0; i < number_of_registers_; ++i) {
+    block_position[i] = kMaxLifetimePosition;
+  }
+
+  // For each active interval, find the next use of its register after the
+  // current position.
+  for (size_t i = 0, e = active_.Size(); i < e; ++i) {
+    LiveInterval* interval = active_.Get(i);
+    int reg = interval->GetRegister();
+    if (interval->IsFixed()) {
+      next_use[reg] = position;
+      block_position[reg] = position;
+    } else {
+      size_t use = interval->FirstRegisterUseAfter(position);
+      if (use != kNoLifetime) {
+        next_use[reg] = std::min(next_use[reg], use);
+      }
+    }
+  }
+
+  // For each inactive interval, find the next use of its register after the
+  // current position.
+  for (size_t i = 0, e = inactive_.Size(); i < e; ++i) {
+    LiveInterval* interval = inactive_.Get(i);
+    size_t next_intersection = interval->FirstIntersectionWith(*current);
+    if (next_intersection == kNoLifetime) {
+      continue;
+    }
+    int reg = interval->GetRegister();
+    if (interval->IsFixed()) {
+      next_use[reg] = std::min(next_use[reg], next_intersection);
+      block_position[reg] = std::min(block_position[reg], next_intersection);
+    } else {
+      size_t use = interval->FirstRegisterUseAfter(position);
+      if (use != kNoLifetime) {
+        next_use[reg] = std::min(next_use[reg], use);
+      }
+    }
+  }
+
+  // Pick the register that is used the last.
+  int reg = 0;
+  for (size_t i = 1; i < number_of_registers_; ++i) {
+    if (next_use[i] > next_use[reg]) {
+      reg = i;
+    }
+  }
+
+  if (first_register_use >= next_use[reg]) {
+    // If the first use of that instruction is after the last use of the found
+    // register, we split this interval just before its first register use.
+    CHECK_GT(first_register_use, position) << "Not enough registers to allocate an interval";
+    AllocateSpillSlotFor(current);
+    Split(current, first_register_use);
+    return false;
+  }
+
+  // Use this register and spill the intervals that have it.
+  current->SetRegister(reg);
+  for (size_t i = 0; i < active_.Size(); ++i) {
+    LiveInterval* interval = active_.Get(i);
+    if (interval->IsFixed() || interval->GetRegister() != reg) {
+      continue;
+    }
+    active_.Delete(interval);
+    --i;
+    if (interval->GetStart() == position) {
+      // The interval was allocated at this position, it does not need the
+      // register here.
+      interval->ClearRegister();
+      Spill(interval);
+    } else {
+      handled_.Add(interval);
+      Spill(interval->SplitAt(position));
+    }
+  }
+
+  for (size_t i = 0; i < inactive_.Size(); ++i) {
+    LiveInterval* interval = inactive_.Get(i);
+    if (interval->IsFixed()
+        || interval->GetRegister() != reg
+        || interval->FirstIntersectionWith(*current) == kNoLifetime) {
+      continue;
+    }
+    DCHECK_LT(interval->GetStart(), position);
+    inactive_.Delete(interval);
+    --i;
+    handled_.Add(interval);
+    Spill(interval->SplitAt(position));
+  }
+
+  // If a fixed interval needs the register later, split `current` before.
+  if (block_position[reg] <= current->GetEnd()) {
+    Split(current, block_position[reg]);
+  }
+  return true;
+}
+
+void RegisterAllocator::Spill(LiveInterval* interval) {
+  DCHECK(!interval->HasRegister());
+  AllocateSpillSlotFor(interval);
+  size_t use = interval->FirstRegisterUse();
+  if (use == kNoLifetime) {
+    handled_.Add(interval);
+  } else if (use == interval->GetStart()) {
+    AddToUnhandled(interval);
+  } else {
+    handled_.Add(interval);
+    Split(interval, use);
+  }
+}
+
+LiveInterval* RegisterAllocator::Split(LiveInterval* interval, size_t position) {
+  DCHECK_GT(position, interval->GetStart());
+  DCHECK_LE(position, interval->GetEnd());
+  LiveInterval* new_interval = interval->SplitAt(position);
+  AddToUnhandled(new_interval);
+  return new_interval;
+}
+
+void RegisterAllocator::AllocateSpillSlotFor(LiveInterval* interval) {
+  LiveInterval* parent = interval->GetParent();
+  if (parent->HasSpillSlot() || IsConstantInterval(interval)) {
+    return;
+  }
+
+  // The spill slot holds the value for the whole lifetime of the instruction.
+  size_t start = parent->GetStart();
+  size_t end = GetLifetimeEnd(interval);
+
+  // Find an available spill slot.
+  size_t slot = 0;
+  for (size_t e = spill_slots_.Size(); slot < e; ++slot) {
+    if (spill_slots_.Get(slot) < start) {
+      break;
+    }
+  }
+
+  if (slot == spill_slots_.Size()) {
+    // We need a new spill slot.
+    spill_slots_.Add(end);
+  } else {
+    spill_slots_.Put(slot, end);
+  }
+
+  // The offset of spill slots does not depend on the final frame size, so it
+  // can be computed before the number of spill slots is known.
+  parent->SetSpillSlot(codegen_->GetStackOffsetOfSpillSlot(slot));
+}
+
+Location RegisterAllocator::ConvertToLocation(LiveInterval* interval) const {
+  if (interval->HasRegister()) {
+    return Location::RegisterLocation(ManagedRegister(interval->GetRegister()));
+  }
+  if (IsConstantInterval(interval)) {
+    return interval->GetDefinedBy()->GetLocations()->Out();
+  }
+  DCHECK(interval->HasSpillSlot());
+  return Location::StackSlot(interval->GetSpillSlot());
+}
+
+Location RegisterAllocator::LocationAt(HInstruction* instruction, size_t position) const {
+  LiveInterval* sibling = instruction->GetLiveInterval()->GetSiblingAt(position);
+  DCHECK(sibling != nullptr) << instruction->DebugName() << " is not live at " << position;
+  return ConvertToLocation(sibling);
+}
+
+void RegisterAllocator::Resolve() {
+  codegen_->ComputeFrameSize(spill_slots_.Size());
+
+  // Parameters passed on the stack are in the frame of the caller.
+  for (size_t i = 0, e = instruction_intervals_.Size(); i < e; ++i) {
+    LiveInterval* interval = instruction_intervals_.Get(i);
+    HInstruction* instruction = interval->GetDefinedBy();
+    Location output = instruction->GetLocations()->Out();
+    if (output.IsStackSlot()) {
+      DCHECK(instruction->AsParameterValue() != nullptr);
+      Location location = Location::StackSlot(output.GetStackIndex() + codegen_->GetFrameSize());
+      interval->SetSpillSlot(location.GetStackIndex());
+      instruction->GetLocations()->SetOut(location);
+    }
+  }
+
+  // Set the locations of instructions, and connect the siblings of their
+  // intervals within blocks.
+  for (HLinearOrderIterator it(liveness_.GetLinearPostOrder()); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HInstructionIterator inst_it(block->GetPhis()); !inst_it.Done(); inst_it.Advance()) {
+      HInstruction* phi = inst_it.Current();
+      LiveInterval* interval = phi->GetLiveInterval();
+      if (interval != nullptr) {
+        Location location = ConvertToLocation(interval);
+        phi->GetLocations()->SetOut(location);
+        if (interval->HasSpillSlot() && location.IsRegister()) {
+          InsertParallelMoveAt(block->GetLifetimeStart() + 1,
+                               location,
+                               Location::StackSlot(interval->GetSpillSlot()));
+        }
+        ConnectSiblings(interval);
+      }
+    }
+    for (HInstructionIterator inst_it(block->GetInstructions());
+         !inst_it.Done();
+         inst_it.Advance()) {
+      ResolveInputs(inst_it.Current());
+    }
+  }
+
+  // Connect the siblings of intervals across control flow edges.
+  for (HLinearOrderIterator it(liveness_.GetLinearPostOrder()); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    BitVector* live = liveness_.GetLiveInSet(*block);
+    for (size_t i = 0, e = block->GetPredecessors().Size(); i < e; ++i) {
+      HBasicBlock* predecessor = block->GetPredecessors().Get(i);
+      BitVector::Iterator iterator(live);
+      for (int32_t index = iterator.Next(); index != -1; index = iterator.Next()) {
+        ConnectSplitSiblings(liveness_.GetInstructionFromSsaIndex(index), predecessor, block);
+      }
+    }
+  }
+
+  // Resolve phi inputs, now that the intervals of all instructions are connected.
+  for (HLinearOrderIterator it(liveness_.GetLinearPostOrder()); !it.Done(); it.Advance()) {
+    ResolvePhis(it.Current());
+  }
+
+  // Assign temp locations, in the order the temps were created.
+  for (size_t i = 0, e = temp_intervals_.Size(); i < e; ++i) {
+    LiveInterval* temp = temp_intervals_.Get(i);
+    LocationSummary* locations = temp->GetDefinedBy()->GetLocations();
+    for (size_t j = 0; j < locations->GetTempCount(); ++j) {
+      if (locations->GetTemp(j).IsUnallocated()) {
+        locations->SetTempAt(j, ConvertToLocation(temp));
+        break;
+      }
+    }
+  }
+}
+
+void RegisterAllocator::ResolveInputs(HInstruction* instruction) {
+  LocationSummary* locations = instruction->GetLocations();
+  if (locations == nullptr) {
+    return;
+  }
+  size_t position = instruction->GetLifetimePosition();
+
+  Location output = locations->Out();
+  bool same_as_first_input = output.IsUnallocated()
+      && output.GetPolicy() == Location::kSameAsFirstInput;
+  LiveInterval* interval = instruction->GetLiveInterval();
+  if (interval != nullptr) {
+    Location location = ConvertToLocation(interval);
+    if (output.IsUnallocated()) {
+      locations->SetOut(location);
+    } else {
+      DCHECK(output.Equals(location));
+    }
+    if (interval->HasSpillSlot() && location.IsRegister()) {
+      // Spilled values are stored eagerly in their spill slot after their
+      // definition: the siblings that are spilled then do not need moves.
+      InsertParallelMoveAt(position + 1, location, Location::StackSlot(interval->GetSpillSlot()));
+    }
+    ConnectSiblings(interval);
+  }
+
+  for (size_t i = 0, e = instruction->InputCount(); i < e; ++i) {
+    Location expected = locations->InAt(i);
+    if (!expected.IsValid()) {
+      continue;
+    }
+    HInstruction* input = instruction->InputAt(i);
+    if (expected.IsUnallocated()) {
+      Location actual = LocationAt(input, position);
+      DCHECK(expected.GetPolicy() != Location::kRequiresRegister || actual.IsRegister());
+      locations->SetInAt(i, actual);
+    } else {
+      // The instruction needs the input in a fixed location, move it there
+      // right before the instruction.
+      InsertParallelMoveAt(position, LocationAt(input, position - 1), expected);
+    }
+  }
+
+  if (instruction->HasEnvironment()) {
+    // The liveness analysis keeps the values of the environment alive at the
+    // instruction, so the stack maps can describe where they are.
+    GrowableArray<HInstruction*>* environment = instruction->GetEnvironment()->GetVRegs();
+    for (size_t i = 0, e = environment->Size(); i < e; ++i) {
+      HInstruction* value = environment->Get(i);
+      if (value != nullptr) {
+        locations->SetEnvironmentAt(i, LocationAt(value, position));
+      }
+    }
+  }
+
+  if (same_as_first_input && !locations->InAt(0).Equals(locations->Out())) {
+    InsertParallelMoveAt(position,
+                         LocationAt(instruction->InputAt(0), position - 1),
+                         locations->Out());
+    locations->SetInAt(0, locations->Out());
+  }
+}
+
+void RegisterAllocator::ConnectSiblings(LiveInterval* interval) {
+  LiveInterval* current = interval;
+  while (current->GetNextSibling() != nullptr) {
+    LiveInterval* next_sibling = current->GetNextSibling();
+    size_t position = next_sibling->GetStart();
+    // Siblings that start at a block boundary are connected by the moves on
+    // the control flow edges.
+    if (liveness_.GetInstructionFromPosition(position) != nullptr) {
+      DCHECK_EQ(current->GetEnd() + 1, position);
+      Location destination = ConvertToLocation(next_sibling);
+      // The spill slot already holds the value.
+      if (destination.IsRegister()) {
+        InsertParallelMoveAt(position, ConvertToLocation(current), destination);
+      }
+    }
+    current = next_sibling;
+  }
+}
+
+void RegisterAllocator::ConnectSplitSiblings(HInstruction* instruction,
+                                             HBasicBlock* from,
+                                             HBasicBlock* to) {
+  LiveInterval* parent = instruction->GetLiveInterval();
+  LiveInterval* source = parent->GetSiblingAt(from->GetLifetimeEnd());
+  LiveInterval* destination = parent->GetSiblingAt(to->GetLifetimeStart());
+  DCHECK(source != nullptr);
+  DCHECK(destination != nullptr);
+  if (source == destination || !destination->HasRegister()) {
+    // Same location, or the value is already in its spill slot.
+    return;
+  }
+
+  // Since critical edges have been split, either `from` has a single
+  // successor, or `to` has a single predecessor.
+  if (from->GetSuccessors().Size() == 1) {
+    InsertParallelMoveAtExitOf(from, ConvertToLocation(source), ConvertToLocation(destination));
+  } else {
+    DCHECK_EQ(to->GetPredecessors().Size(), 1u);
+    InsertParallelMoveAtEntryOf(to, ConvertToLocation(source), ConvertToLocation(destination));
+  }
+}
+
+void RegisterAllocator::ResolvePhis(HBasicBlock* block) {
+  for (HInstructionIterator it(block->GetPhis()); !it.Done(); it.Advance()) {
+    HInstruction* phi = it.Current();
+    if (phi->GetLiveInterval() == nullptr) {
+      continue;
+    }
+    Location destination = phi->GetLocations()->Out();
+    for (size_t i = 0, e = block->GetPredecessors().Size(); i < e; ++i) {
+      HBasicBlock* predecessor = block->GetPredecessors().Get(i);
+      DCHECK_EQ(predecessor->GetSuccessors().Size(), 1u);
+      Location source = LocationAt(phi->InputAt(i), predecessor->GetLifetimeEnd());
+      InsertParallelMoveAtExitOf(predecessor, source, destination);
+    }
+  }
+}
+
+void RegisterAllocator::AddMove(HParallelMove* move, Location source, Location destination) {
+  if (kIsDebugBuild) {
+    for (size_t i = 0, e = move->NumMoves(); i < e; ++i) {
+      DCHECK(!move->MoveOperandsAt(i)->GetDestination().Equals(destination));
+    }
+  }
+  move->AddMove(new (allocator_) MoveOperands(source, destination));
+}
+
+HParallelMove* RegisterAllocator::GetOrCreateParallelMoveBefore(HInstruction* instruction,
+                                                                size_t position) {
+  // Moves for the same position are grouped in one parallel move, identified
+  // by its lifetime position.
+  HInstruction* previous = instruction->GetPrevious();
+  HParallelMove* move = previous == nullptr ? nullptr : previous->AsParallelMove();
+  if (move == nullptr || move->GetLifetimePosition() != position) {
+    move = new (allocator_) HParallelMove(allocator_);
+    move->SetLifetimePosition(position);
+    instruction->GetBlock()->InsertInstructionBefore(move, instruction);
+  }
+  return move;
+}
+
+void RegisterAllocator::InsertParallelMoveAt(size_t position,
+                                             Location source,
+                                             Location destination) {
+  if (source.Equals(destination)) {
+    return;
+  }
+  HInstruction* at = liveness_.GetInstructionFromPosition(position);
+  DCHECK(at != nullptr) << "No instruction at " << position;
+  AddMove(GetOrCreateParallelMoveBefore(at, position), source, destination);
+}
+
+void RegisterAllocator::InsertParallelMoveAtExitOf(HBasicBlock* block,
+                                                   Location source,
+                                                   Location destination) {
+  if (source.Equals(destination)) {
+    return;
+  }
+  // Insert before the control flow instruction, after the moves the
+  // instruction itself needs.
+  HInstruction* last = block->GetLastInstruction();
+  DCHECK_EQ(block->GetSuccessors().Size(), 1u);
+  DCHECK(last->GetLocations() == nullptr || last->InputCount() == 0);
+  AddMove(GetOrCreateParallelMoveBefore(last, block->GetLifetimeEnd()), source, destination);
+}
+
+void RegisterAllocator::InsertParallelMoveAtEntryOf(HBasicBlock* block,
+                                                    Location source,
+                                                    Location destination) {
+  if (source.Equals(destination)) {
+    return;
+  }
+  // Insert before the moves of the first instruction: they expect the values
+  // to be in their locations at the block entry.
+  HInstruction* first = block->GetFirstInstruction();
+  HParallelMove* move = first->AsParallelMove();
+  if (move == nullptr || move->GetLifetimePosition() != block->GetLifetimeStart()) {
+    move = new (allocator_) HParallelMove(allocator_);
+    move->SetLifetimePosition(block->GetLifetimeStart());
+    block->InsertInstructionBefore(move, first);
+  }
+  AddMove(move, source, destination);
+}
+
+// Each lifetime position is split in two units: an instruction reads its
+// inputs in the first unit, and writes its output in the second one. This
+// allows an output to reuse the register of an input that dies at the
+// instruction.
+static void ComputeUnits(LiveInterval* interval,
+                         const LiveRange& range,
+                         const SsaLivenessAnalysis& liveness,
+                         size_t* start_unit,
+                         size_t* end_unit) {
+  *start_unit = range.GetStart() * 2;
+  *end_unit = range.GetEnd() * 2 + 1;
+  if (interval->IsTemp()) {
+    return;
+  }
+  HInstruction* defined_by = interval->GetDefinedBy();
+  if (interval == interval->GetParent()
+      && defined_by->AsPhi() == nullptr
+      && range.GetStart() == defined_by->GetLifetimePosition()) {
+    ++*start_unit;
+  }
+  if (interval->GetNextSibling() == nullptr
+      && range.GetEnd() == interval->GetEnd()
+      && liveness.GetInstructionFromPosition(range.GetEnd()) != nullptr) {
+    *end_unit = std::max(*start_unit, *end_unit - 1);
+  }
+}
+
+bool RegisterAllocator::Validate(bool log_fatal_on_failure) {
+  // Fixed intervals are not validated: the code generators check that values
+  // are in the register they require.
+  GrowableArray<LiveInterval*> intervals(allocator_, 0);
+  for (size_t i = 0, e = instruction_intervals_.Size(); i < e; ++i) {
+    for (LiveInterval* current = instruction_intervals_.Get(i);
+         current != nullptr;
+         current = current->GetNextSibling()) {
+      intervals.Add(current);
+    }
+  }
+  for (size_t i = 0, e = temp_intervals_.Size(); i < e; ++i) {
+    intervals.Add(temp_intervals_.Get(i));
+  }
+
+  size_t number_of_units = liveness_.GetMaxLifetimePosition() * 2;
+  GrowableArray<ArenaBitVector*> liveness_of_registers(allocator_, number_of_registers_);
+  for (size_t i = 0; i < number_of_registers_; ++i) {
+    liveness_of_registers.Add(new (allocator_) ArenaBitVector(allocator_, number_of_units, false));
+  }
+
+  for (size_t i = 0, e = intervals.Size(); i < e; ++i) {
+    LiveInterval* current = intervals.Get(i);
+    if (!current->HasRegister()) {
+      if (!current->HasSpillSlot() && !IsConstantInterval(current)) {
+        if (log_fatal_on_failure) {
+          LOG(FATAL) << "Interval has neither a register nor a spill slot";
+        }
+        return false;
+      }
+      continue;
+    }
+    BitVector* live = liveness_of_registers.Get(current->GetRegister());
+    const GrowableArray<LiveRange>& ranges = current->GetRanges();
+    for (size_t j = 0, f = ranges.Size(); j < f; ++j) {
+      size_t start_unit;
+      size_t end_unit;
+      ComputeUnits(current, ranges.Get(j), liveness_, &start_unit, &end_unit);
+      for (size_t unit = start_unit; unit <= end_unit; ++unit) {
+        if (live->IsBitSet(unit)) {
+          if (log_fatal_on_failure) {
+            std::ostringstream message;
+            message << "Register conflict at " << unit / 2
+                    << " for register " << current->GetRegister() << " and interval ";
+            current->Dump(message);
+            LOG(FATAL) << message.str();
+          }
+          return false;
+        }
+        live->SetBit(unit);
+      }
+    }
+  }
+
+  // Check that values sharing a spill slot are not live at the same time.
+  for (size_t i = 0, e = instruction_intervals_.Size(); i < e; ++i) {
+    LiveInterval* first = instruction_intervals_.Get(i);
+    if (!first->HasSpillSlot() || first->GetDefinedBy()->AsParameterValue() != nullptr) {
+      continue;
+    }
+    for (size_t j = i + 1; j < e; ++j) {
+      LiveInterval* second = instruction_intervals_.Get(j);
+      if (second->GetSpillSlot() != first->GetSpillSlot()
+          || second->GetDefinedBy()->AsParameterValue() != nullptr) {
+        continue;
+      }
+      if (first->GetStart() <= GetLifetimeEnd(second)
+          && second->GetStart() <= GetLifetimeEnd(first)) {
+        if (log_fatal_on_failure) {
+          LOG(FATAL) << "Spill slot conflict for " << first->GetDefinedBy()->DebugName()
+                     << " and " << second->GetDefinedBy()->DebugName();
+        }
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace art
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_REGISTER_ALLOCATOR_H_
+#define ART_COMPILER_OPTIMIZING_REGISTER_ALLOCATOR_H_
+
+#include "base/macros.h"
+#include "instruction_set.h"
+#include "locations.h"
+#include "utils/growable_array.h"
+
+namespace art {
+
+class CodeGenerator;
+class HBasicBlock;
+class HGraph;
+class HInstruction;
+class HParallelMove;
+class LiveInterval;
+class SsaLivenessAnalysis;
+
+/**
+ * An implementation of a linear scan register allocator on an `HGraph` with SSA form.
+ *
+ * The allocator works on the live intervals of `SsaLivenessAnalysis` and the
+ * location policies of the code generator. Intervals are split and spilled
+ * when there are not enough registers: a value that gets spilled is stored in
+ * its spill slot right after its definition, and reloaded before the uses that
+ * need a register. The moves connecting the split intervals, and the ones
+ * resolving phis, are inserted in the graph as `HParallelMove` instructions.
+ */
+class RegisterAllocator {
+ public:
+  RegisterAllocator(ArenaAllocator* allocator,
+                    CodeGenerator* codegen,
+                    const SsaLivenessAnalysis& liveness);
+
+  // Main entry point for the register allocator. Given the liveness analysis,
+  // allocates registers to live intervals, computes the frame size, and sets the
+  // locations of all instructions.
+  void AllocateRegisters();
+
+  // Validate that the register allocator did not allocate the same register to
+  // intervals that intersect each other. Returns false if it did.
+  bool Validate(bool log_fatal_on_failure);
+
+  // Returns whether the register allocator and the code generator of
+  // `instruction_set` support all instructions of `graph`.
+  static bool CanAllocateRegistersFor(const HGraph& graph, InstructionSet instruction_set);
+
+  size_t GetNumberOfSpillSlots() const {
+    return spill_slots_.Size();
+  }
+
+ private:
+  // Set up the locations of all instructions, and the intervals and
+  // register uses the linear scan needs.
+  void BuildLocations();
+  void BuildIntervals();
+  void ProcessInstruction(HInstruction* instruction);
+  void BlockRegister(Location location, size_t start, size_t end);
+
+  // Main methods of the allocator.
+  void LinearScan();
+  bool TryAllocateFreeReg(LiveInterval* interval);
+  bool AllocateBlockedReg(LiveInterval* interval);
+
+  // Add `interval` in the sorted list of unhandled intervals.
+  void AddToUnhandled(LiveInterval* interval);
+
+  // Split `interval` at `position`, and put the new sibling in the unhandled
+  // list if it needs a register.
+  LiveInterval* Split(LiveInterval* interval, size_t position);
+
+  // Spill `interval` and reload it before its next register use.
+  void Spill(LiveInterval* interval);
+
+  // Allocate a spill slot to the parent of `interval`.
+  void AllocateSpillSlotFor(LiveInterval* interval);
+
+  // Returns the register of the interval of an input of `defined_by` that dies
+  // at the definition and can be reused by `interval`, or kNoRegister.
+  int FindReusableInputRegister(LiveInterval* interval) const;
+
+  // Resolution of the locations, and insertion of the moves between siblings.
+  void Resolve();
+  Location ConvertToLocation(LiveInterval* interval) const;
+  Location LocationAt(HInstruction* instruction, size_t position) const;
+  void ResolveInputs(HInstruction* instruction);
+  void ConnectSiblings(LiveInterval* interval);
+  void ConnectSplitSiblings(HInstruction* instruction, HBasicBlock* from, HBasicBlock* to);
+  void ResolvePhis(HBasicBlock* block);
+
+  // Helpers to insert parallel moves.
+  void InsertParallelMoveAt(size_t position, Location source, Location destination);
+  void InsertParallelMoveAtExitOf(HBasicBlock* block, Location source, Location destination);
+  void InsertParallelMoveAtEntryOf(HBasicBlock* block, Location source, Location destination);
+  HParallelMove* GetOrCreateParallelMoveBefore(HInstruction* instruction, size_t position);
+  void AddMove(HParallelMove* move, Location source, Location destination);
+
+  ArenaAllocator* const allocator_;
+  CodeGenerator* const codegen_;
+  const SsaLivenessAnalysis& liveness_;
+
+  // Intervals of instructions, sorted by decreasing start position: the next
+  // interval to handle is the last one.
+  GrowableArray<LiveInterval*> unhandled_;
+
+  // Intervals that have been processed.
+  GrowableArray<LiveInterval*> handled_;
+
+  // Intervals that are currently being processed, and that cover the current
+  // position.
+  GrowableArray<LiveInterval*> active_;
+
+  // Intervals that are currently being processed, but are in a lifetime hole at
+  // the current position.
+  GrowableArray<LiveInterval*> inactive_;
+
+  // Fixed intervals for physical registers. Such an interval covers the positions
+  // where an instruction requires that specific register.
+  GrowableArray<LiveInterval*> physical_register_intervals_;
+
+  // The parent intervals of all instructions, used by the resolution phase.
+  GrowableArray<LiveInterval*> instruction_intervals_;
+
+  // Intervals for temporaries. Such an interval covers the position of the
+  // instruction that needs the temporary.
+  GrowableArray<LiveInterval*> temp_intervals_;
+
+  // The end position of the last interval using each spill slot.
+  GrowableArray<size_t> spill_slots_;
+
+  // Registers that cannot be allocated, as set up by the code generator.
+  bool* const blocked_registers_;
+
+  // Number of core registers that can be allocated.
+  const size_t number_of_registers_;
+
+  // Temporary array, allocated ahead of time, to compute the free or next use
+  // position of each register.
+  size_t* const registers_array_;
+
+  DISALLOW_COPY_AND_ASSIGN(RegisterAllocator);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_REGISTER_ALLOCATOR_H_
@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "builder.h"
+#include "code_generator.h"
+#include "dex_file.h"
+#include "dex_instruction.h"
+#include "nodes.h"
+#include "optimizing_unit_test.h"
+#include "prepare_for_register_allocation.h"
+#include "register_allocator.h"
+#include "ssa_liveness_analysis.h"
+#include "utils/arena_allocator.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+// Note: the register allocator tests rely on the fact that constants have live
+// intervals, and registers get allocated to them at their uses.
+
+static HGraph* BuildSSAGraph(const uint16_t* data, ArenaAllocator* allocator) {
+  HGraphBuilder builder(allocator);
+  const DexFile::CodeItem* item = reinterpret_cast<const DexFile::CodeItem*>(data);
+  HGraph* graph = builder.BuildGraph(*item);
+  graph->BuildDominatorTree();
+  graph->TransformToSSA();
+  graph->FindNaturalLoops();
+  return graph;
+}
+
+static bool Check(const uint16_t* data, InstructionSet instruction_set) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = BuildSSAGraph(data, &allocator);
+  CodeGenerator* codegen = CodeGenerator::Create(&allocator, graph, instruction_set);
+  SsaLivenessAnalysis liveness(*graph);
+  liveness.Analyze();
+  RegisterAllocator register_allocator(&allocator, codegen, liveness);
+  register_allocator.AllocateRegisters();
+  return register_allocator.Validate(false);
+}
+
+static void TestCode(const uint16_t* data) {
+  ASSERT_TRUE(Check(data, kX86));
+  ASSERT_TRUE(Check(data, kArm));
+}
+
+TEST(RegisterAllocatorTest, ReturnConstant) {
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::RETURN);
+
+  TestCode(data);
+}
+
+TEST(RegisterAllocatorTest, Add) {
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::CONST_4 | 1 << 8 | 1 << 12,
+    Instruction::ADD_INT_2ADDR | 1 << 12,
+    Instruction::ADD_INT_2ADDR | 1 << 12,
+    Instruction::RETURN);
+
+  TestCode(data);
+}
+
+TEST(RegisterAllocatorTest, Diamond) {
+  /*
+   * Test the following snippet:
+   *  var a = 0;
+   *  var b = 1;
+   *  if (a == 0) {
+   *    a = b + 2;
+   *  } else {
+   *    a = b + 3;
+   *  }
+   *  return a + b;
+   */
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::CONST_4 | 1 << 8 | 1 << 12,
+    Instruction::IF_EQ, 5,
+    Instruction::ADD_INT_LIT8 | 0 << 8, 1 | 3 << 8,
+    Instruction::GOTO | 0x300,
+    Instruction::ADD_INT_LIT8 | 0 << 8, 1 | 2 << 8,
+    Instruction::ADD_INT_2ADDR | 1 << 12,
+    Instruction::RETURN);
+
+  TestCode(data);
+}
+
+TEST(RegisterAllocatorTest, Loop) {
+  /*
+   * Test the following snippet:
+   *  var a = 0;
+   *  while (a == a) {
+   *    a = a + 1;
+   *  }
+   *  return a;
+   */
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::IF_NE, 5,
+    Instruction::ADD_INT_LIT8 | 0 << 8, 1 << 8,
+    Instruction::GOTO | 0xFC00,
+    Instruction::RETURN);
+
+  TestCode(data);
+}
+
+TEST(RegisterAllocatorTest, Spill) {
+  /*
+   * Test the following snippet, which keeps more values alive than there are
+   * registers:
+   *  var g = 0;
+   *  var a = g + 0; var b = g + 1; var c = g + 2; var d = g + 3; var e = g + 4; var f = g + 5;
+   *  return ((((a + b) + c) + d) + e) + f;
+   */
+  const uint16_t data[] = {
+    7, 0, 0, 0, 0, 0, 24, 0,
+    Instruction::CONST_4 | 6 << 8 | 0 << 12,
+    Instruction::ADD_INT_LIT8 | 0 << 8, 6 | 0 << 8,
+    Instruction::ADD_INT_LIT8 | 1 << 8, 6 | 1 << 8,
+    Instruction::ADD_INT_LIT8 | 2 << 8, 6 | 2 << 8,
+    Instruction::ADD_INT_LIT8 | 3 << 8, 6 | 3 << 8,
+    Instruction::ADD_INT_LIT8 | 4 << 8, 6 | 4 << 8,
+    Instruction::ADD_INT_LIT8 | 5 << 8, 6 | 5 << 8,
+    Instruction::ADD_INT | 0 << 8, 0 | 1 << 8,
+    Instruction::ADD_INT | 0 << 8, 0 | 2 << 8,
+    Instruction::ADD_INT | 0 << 8, 0 | 3 << 8,
+    Instruction::ADD_INT | 0 << 8, 0 | 4 << 8,
+    Instruction::ADD_INT | 0 << 8, 0 | 5 << 8,
+    Instruction::RETURN | 0 << 8
+  };
+
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = BuildSSAGraph(data, &allocator);
+  CodeGenerator* codegen = CodeGenerator::Create(&allocator, graph, kX86);
+  SsaLivenessAnalysis liveness(*graph);
+  liveness.Analyze();
+  RegisterAllocator register_allocator(&allocator, codegen, liveness);
+  register_allocator.AllocateRegisters();
+  ASSERT_TRUE(register_allocator.Validate(false));
+  // Six values live at the same time do not fit in the registers of x86.
+  ASSERT_GT(register_allocator.GetNumberOfSpillSlots(), 0u);
+
+  // Each addition gets a register for its result and its first input.
+  HBasicBlock* block = graph->GetBlocks().Get(1);
+  for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* instruction = it.Current();
+    if (instruction->AsAdd() != nullptr) {
+      LocationSummary* locations = instruction->GetLocations();
+      ASSERT_TRUE(locations->Out().IsRegister());
+      ASSERT_TRUE(locations->InAt(0).Equals(locations->Out()));
+    }
+  }
+}
+
+TEST(RegisterAllocatorTest, ConstantLocation) {
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::RETURN);
+
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = BuildSSAGraph(data, &allocator);
+  CodeGenerator* codegen = CodeGenerator::Create(&allocator, graph, kX86);
+  SsaLivenessAnalysis liveness(*graph);
+  liveness.Analyze();
+  RegisterAllocator register_allocator(&allocator, codegen, liveness);
+  register_allocator.AllocateRegisters();
+  ASSERT_TRUE(register_allocator.Validate(false));
+  ASSERT_EQ(register_allocator.GetNumberOfSpillSlots(), 0u);
+
+  // The constant does not get a register at its definition: it is moved from
+  // its constant location to the return register right before the return.
+  HInstruction* ret = graph->GetBlocks().Get(1)->GetLastInstruction();
+  ASSERT_TRUE(ret->AsReturn() != nullptr);
+  HInstruction* constant = ret->InputAt(0);
+  ASSERT_TRUE(constant->GetLocations()->Out().IsConstant());
+  ASSERT_EQ(constant->GetLocations()->Out().GetConstant(), constant);
+  HParallelMove* move = ret->GetPrevious()->AsParallelMove();
+  ASSERT_TRUE(move != nullptr);
+  ASSERT_EQ(move->NumMoves(), 1u);
+  ASSERT_TRUE(move->MoveOperandsAt(0)->GetSource().Equals(constant->GetLocations()->Out()));
+  ASSERT_TRUE(move->MoveOperandsAt(0)->GetDestination().Equals(ret->GetLocations()->InAt(0)));
+}
+
+TEST(RegisterAllocatorTest, DivZeroCheck) {
+  const uint16_t data[] = TWO_REGISTERS_CODE_ITEM(
+    Instruction::CONST_4 | 6 << 12,
+    Instruction::CONST_4 | 1 << 8 | 3 << 12,
+    Instruction::DIV_INT_2ADDR | 1 << 12,
+    Instruction::RETURN);
+
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = BuildSSAGraph(data, &allocator);
+  HDiv* div = nullptr;
+  for (HInstructionIterator it(graph->GetBlocks().Get(1)->GetInstructions());
+       !it.Done();
+       it.Advance()) {
+    if (it.Current()->AsDiv() != nullptr) {
+      div = it.Current()->AsDiv();
+    }
+  }
+  ASSERT_TRUE(div != nullptr);
+  HDivZeroCheck* check = div->InputAt(1)->AsDivZeroCheck();
+  ASSERT_TRUE(check != nullptr);
+
+  // The division uses the divisor directly, and the check defines no value.
+  PrepareForRegisterAllocation(graph).Run();
+  ASSERT_EQ(div->InputAt(1), check->InputAt(0));
+  ASSERT_FALSE(check->HasUses());
+
+  CodeGenerator* codegen = CodeGenerator::Create(&allocator, graph, kX86);
+  SsaLivenessAnalysis liveness(*graph);
+  liveness.Analyze();
+  RegisterAllocator register_allocator(&allocator, codegen, liveness);
+  register_allocator.AllocateRegisters();
+  ASSERT_TRUE(register_allocator.Validate(false));
+  ASSERT_FALSE(check->GetLocations()->Out().IsValid());
+}
+
+TEST(RegisterAllocatorTest, CanAllocateRegistersFor) {
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::RETURN);
+
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraphBuilder builder(&allocator);
+  const DexFile::CodeItem* item = reinterpret_cast<const DexFile::CodeItem*>(data);
+  HGraph* graph = builder.BuildGraph(*item);
+  ASSERT_TRUE(RegisterAllocator::CanAllocateRegistersFor(*graph, kX86));
+  ASSERT_TRUE(RegisterAllocator::CanAllocateRegistersFor(*graph, kArm));
+  ASSERT_FALSE(RegisterAllocator::CanAllocateRegistersFor(*graph, kMips));
+}
+
+}  // namespace art
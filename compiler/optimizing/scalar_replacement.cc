@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scalar_replacement.h"
+
+namespace art {
+
+// Only the fields whose value is read back as it was written can be replaced:
+// a narrower field would truncate the value written to it.
+static bool IsReplaceableFieldType(Primitive::Type type) {
+  return type == Primitive::kPrimInt
+      || type == Primitive::kPrimLong
+      || type == Primitive::kPrimNot;
+}
+
+static MemberOffset GetFieldOffset(HInstruction* access) {
+  return access->AsInstanceFieldGet() != nullptr
+      ? access->AsInstanceFieldGet()->GetFieldOffset()
+      : access->AsInstanceFieldSet()->GetFieldOffset();
+}
+
+static Primitive::Type GetFieldType(HInstruction* access) {
+  return access->AsInstanceFieldGet() != nullptr
+      ? access->AsInstanceFieldGet()->GetFieldType()
+      : access->AsInstanceFieldSet()->GetFieldType();
+}
+
+// Returns whether `user`, which has an object as input at `index`, only reads
+// or writes a field of that object, in `block`.
+static bool IsFieldAccessOf(HInstruction* user, size_t index, HBasicBlock* block) {
+  if (user->GetBlock() != block || index != 0) {
+    return false;
+  }
+  if (user->AsInstanceFieldGet() == nullptr && user->AsInstanceFieldSet() == nullptr) {
+    return false;
+  }
+  return IsReplaceableFieldType(GetFieldType(user));
+}
+
+// Removes `instruction` from the environments that contain it.
+static void RemoveEnvironmentUses(HInstruction* instruction) {
+  while (instruction->GetEnvUses() != nullptr) {
+    HUseListNode<HEnvironment>* use = instruction->GetEnvUses();
+    use->GetUser()->ReplaceEnvAt(use->GetIndex(), nullptr);
+  }
+}
+
+bool ScalarReplacement::CollectAccesses(HNewInstance* allocation,
+                                        GrowableArray<HInstruction*>* accesses) const {
+  HBasicBlock* block = allocation->GetBlock();
+  size_t number_of_accesses = 0;
+  for (HUseIterator<HInstruction> it(allocation->GetUses()); !it.Done(); it.Advance()) {
+    HInstruction* user = it.Current()->GetUser();
+    if (user->AsNullCheck() != nullptr && user->GetBlock() == block) {
+      for (HUseIterator<HInstruction> it2(user->GetUses()); !it2.Done(); it2.Advance()) {
+        if (!IsFieldAccessOf(it2.Current()->GetUser(), it2.Current()->GetIndex(), block)) {
+          return false;
+        }
+        ++number_of_accesses;
+      }
+    } else if (!IsFieldAccessOf(user, it.Current()->GetIndex(), block)) {
+      return false;
+    }
+    ++number_of_accesses;
+  }
+
+  // The instructions of the block after the allocation are in execution order.
+  for (HInstruction* current = allocation->GetNext();
+       current != nullptr;
+       current = current->GetNext()) {
+    if (current->InputCount() == 0) {
+      continue;
+    }
+    HInstruction* object = current->InputAt(0);
+    if (object == allocation
+        || (object->AsNullCheck() != nullptr && object->InputAt(0) == allocation)) {
+      accesses->Add(current);
+    }
+  }
+  DCHECK_EQ(accesses->Size(), number_of_accesses);
+  return true;
+}
+
+HInstruction* ScalarReplacement::GetDefaultValue(Primitive::Type type) {
+  HInstruction** zero = (type == Primitive::kPrimLong) ? &long_zero_ : &int_zero_;
+  if (*zero == nullptr) {
+    if (type == Primitive::kPrimLong) {
+      *zero = new (graph_->GetArena()) HLongConstant(0);
+    } else {
+      DCHECK_EQ(type, Primitive::kPrimInt);
+      *zero = new (graph_->GetArena()) HIntConstant(0);
+    }
+    HBasicBlock* entry = graph_->GetEntryBlock();
+    entry->InsertInstructionBefore(*zero, entry->GetLastInstruction());
+  }
+  return *zero;
+}
+
+bool ScalarReplacement::Replace(HNewInstance* allocation,
+                                const GrowableArray<HInstruction*>& accesses) {
+  // The fields written so far, by their last write.
+  GrowableArray<HInstruction*> stores(graph_->GetArena(), 4);
+
+  // There is no null constant for a reference field read before any write.
+  for (size_t i = 0, e = accesses.Size(); i < e; ++i) {
+    HInstruction* access = accesses.Get(i);
+    if (access->AsInstanceFieldSet() != nullptr) {
+      stores.Add(access);
+    } else if (access->AsInstanceFieldGet() != nullptr
+               && GetFieldType(access) == Primitive::kPrimNot) {
+      bool is_written = false;
+      for (size_t j = 0, e2 = stores.Size(); j < e2 && !is_written; ++j) {
+        is_written = GetFieldOffset(stores.Get(j)).Uint32Value() ==
+            GetFieldOffset(access).Uint32Value();
+      }
+      if (!is_written) {
+        return false;
+      }
+    }
+  }
+  stores.Reset();
+
+  HBasicBlock* block = allocation->GetBlock();
+  for (size_t i = 0, e = accesses.Size(); i < e; ++i) {
+    HInstruction* access = accesses.Get(i);
+    if (access->AsNullCheck() != nullptr) {
+      // Removed once its users are.
+      continue;
+    }
+    uint32_t offset = GetFieldOffset(access).Uint32Value();
+    size_t store_index = 0;
+    while (store_index < stores.Size()
+           && GetFieldOffset(stores.Get(store_index)).Uint32Value() != offset) {
+      ++store_index;
+    }
+    if (access->AsInstanceFieldSet() != nullptr) {
+      if (store_index == stores.Size()) {
+        stores.Add(access);
+      } else {
+        stores.Put(store_index, access);
+      }
+      continue;
+    }
+    HInstruction* value = (store_index == stores.Size())
+        ? GetDefaultValue(GetFieldType(access))
+        : stores.Get(store_index)->InputAt(1);
+    access->ReplaceWith(value);
+    block->RemoveInstruction(access);
+  }
+
+  for (size_t i = 0, e = accesses.Size(); i < e; ++i) {
+    HInstruction* access = accesses.Get(i);
+    if (access->AsInstanceFieldSet() != nullptr) {
+      block->RemoveInstruction(access);
+    }
+  }
+  for (size_t i = 0, e = accesses.Size(); i < e; ++i) {
+    HInstruction* access = accesses.Get(i);
+    if (access->AsNullCheck() != nullptr) {
+      // A new instance is not null.
+      RemoveEnvironmentUses(access);
+      block->RemoveInstruction(access);
+    }
+  }
+  RemoveEnvironmentUses(allocation);
+  block->RemoveInstruction(allocation);
+  return true;
+}
+
+void ScalarReplacement::Run() {
+  GrowableArray<HNewInstance*> allocations(graph_->GetArena(), 8);
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HInstructionIterator inst_it(block->GetInstructions());
+         !inst_it.Done();
+         inst_it.Advance()) {
+      HNewInstance* allocation = inst_it.Current()->AsNewInstance();
+      if (allocation != nullptr && allocation->CanBeRemoved()) {
+        allocations.Add(allocation);
+      }
+    }
+  }
+
+  GrowableArray<HInstruction*> accesses(graph_->GetArena(), 8);
+  for (size_t i = 0, e = allocations.Size(); i < e; ++i) {
+    HNewInstance* allocation = allocations.Get(i);
+    accesses.Reset();
+    if (CollectAccesses(allocation, &accesses)) {
+      Replace(allocation, accesses);
+    }
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_SCALAR_REPLACEMENT_H_
+#define ART_COMPILER_OPTIMIZING_SCALAR_REPLACEMENT_H_
+
+#include "nodes.h"
+
+namespace art {
+
+/**
+ * Scalar replacement of the objects that don't escape the block allocating
+ * them: an object that is only null checked, and whose fields are only read
+ * and written in the block of its allocation, is not allocated, and each
+ * read of a field is replaced by the value last written to it, or by its
+ * default value.
+ *
+ * The object must not be passed to any other instruction, but it may be in
+ * environments: as no code needs to rebuild the object from the environment
+ * of an instruction, it is removed from them.
+ */
+class ScalarReplacement : public ValueObject {
+ public:
+  explicit ScalarReplacement(HGraph* graph)
+      : graph_(graph), int_zero_(nullptr), long_zero_(nullptr) {}
+
+  void Run();
+
+ private:
+  // Returns whether `allocation` doesn't escape, and adds the instructions
+  // using it to `accesses` in their order in the block.
+  bool CollectAccesses(HNewInstance* allocation, GrowableArray<HInstruction*>* accesses) const;
+
+  // Replaces the field reads of `allocation` and removes it with its
+  // accesses. Returns whether it did, which it doesn't when a reference field
+  // is read before being written: there is no null constant.
+  bool Replace(HNewInstance* allocation, const GrowableArray<HInstruction*>& accesses);
+
+  // Returns the zero constant of `type`, an int or a long, added to the
+  // entry block if needed.
+  HInstruction* GetDefaultValue(Primitive::Type type);
+
+  HGraph* const graph_;
+  HInstruction* int_zero_;
+  HInstruction* long_zero_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScalarReplacement);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_SCALAR_REPLACEMENT_H_
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nodes.h"
+#include "optimizing_unit_test.h"
+#include "scalar_replacement.h"
+#include "utils/arena_allocator.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+/**
+ * Fixture building the graph of a method with a single block, to which the
+ * tests add instructions before its return.
+ */
+class ScalarReplacementTest : public testing::Test {
+ public:
+  ScalarReplacementTest() : pool_(), allocator_(&pool_) {
+    graph_ = new (&allocator_) HGraph(&allocator_);
+    entry_ = new (&allocator_) HBasicBlock(graph_);
+    block_ = new (&allocator_) HBasicBlock(graph_);
+    exit_ = new (&allocator_) HBasicBlock(graph_);
+    graph_->AddBlock(entry_);
+    graph_->AddBlock(block_);
+    graph_->AddBlock(exit_);
+    graph_->SetEntryBlock(entry_);
+    graph_->SetExitBlock(exit_);
+    entry_->AddSuccessor(block_);
+    block_->AddSuccessor(exit_);
+
+    parameter_ = new (&allocator_) HParameterValue(0, Primitive::kPrimInt);
+    entry_->AddInstruction(parameter_);
+    entry_->AddInstruction(new (&allocator_) HGoto());
+    exit_->AddInstruction(new (&allocator_) HExit());
+  }
+
+  void RunScalarReplacement() {
+    graph_->BuildDominatorTree();
+    graph_->TransformToSSA();
+    ScalarReplacement(graph_).Run();
+  }
+
+  ArenaPool pool_;
+  ArenaAllocator allocator_;
+  HGraph* graph_;
+
+  HBasicBlock* entry_;
+  HBasicBlock* block_;
+  HBasicBlock* exit_;
+
+  HInstruction* parameter_;
+};
+
+TEST_F(ScalarReplacementTest, ReplaceFields) {
+  HNewInstance* allocation = new (&allocator_) HNewInstance(0, 0, true);
+  block_->AddInstruction(allocation);
+  HInstruction* null_check = new (&allocator_) HNullCheck(allocation, 0);
+  block_->AddInstruction(null_check);
+  HInstruction* set = new (&allocator_) HInstanceFieldSet(
+      null_check, parameter_, Primitive::kPrimInt, MemberOffset(8));
+  block_->AddInstruction(set);
+  HInstruction* get_written =
+      new (&allocator_) HInstanceFieldGet(allocation, Primitive::kPrimInt, MemberOffset(8));
+  block_->AddInstruction(get_written);
+  HInstruction* get_default =
+      new (&allocator_) HInstanceFieldGet(allocation, Primitive::kPrimLong, MemberOffset(16));
+  block_->AddInstruction(get_default);
+  HInstruction* add = new (&allocator_) HAdd(Primitive::kPrimInt, get_written, get_written);
+  block_->AddInstruction(add);
+  HInstruction* ret = new (&allocator_) HReturn(add);
+  block_->AddInstruction(ret);
+
+  RunScalarReplacement();
+
+  // The object is not allocated, its fields are read from the values
+  // written to them, or their default value.
+  ASSERT_EQ(allocation->GetBlock(), nullptr);
+  ASSERT_EQ(null_check->GetBlock(), nullptr);
+  ASSERT_EQ(set->GetBlock(), nullptr);
+  ASSERT_EQ(get_written->GetBlock(), nullptr);
+  ASSERT_EQ(get_default->GetBlock(), nullptr);
+  ASSERT_EQ(add->InputAt(0), parameter_);
+  ASSERT_EQ(add->InputAt(1), parameter_);
+  ASSERT_EQ(block_->GetFirstInstruction(), add);
+}
+
+TEST_F(ScalarReplacementTest, EscapingObject) {
+  HNewInstance* allocation = new (&allocator_) HNewInstance(0, 0, true);
+  block_->AddInstruction(allocation);
+  HInstruction* set = new (&allocator_) HInstanceFieldSet(
+      allocation, parameter_, Primitive::kPrimInt, MemberOffset(8));
+  block_->AddInstruction(set);
+  block_->AddInstruction(new (&allocator_) HReturn(allocation));
+
+  RunScalarReplacement();
+
+  // The object is returned.
+  ASSERT_EQ(allocation->GetBlock(), block_);
+  ASSERT_EQ(set->GetBlock(), block_);
+}
+
+TEST_F(ScalarReplacementTest, NarrowField) {
+  HNewInstance* allocation = new (&allocator_) HNewInstance(0, 0, true);
+  block_->AddInstruction(allocation);
+  HInstruction* set = new (&allocator_) HInstanceFieldSet(
+      allocation, parameter_, Primitive::kPrimByte, MemberOffset(8));
+  block_->AddInstruction(set);
+  HInstruction* get =
+      new (&allocator_) HInstanceFieldGet(allocation, Primitive::kPrimByte, MemberOffset(8));
+  block_->AddInstruction(get);
+  block_->AddInstruction(new (&allocator_) HReturn(get));
+
+  RunScalarReplacement();
+
+  // The field truncates the value written to it.
+  ASSERT_EQ(allocation->GetBlock(), block_);
+  ASSERT_EQ(get->GetBlock(), block_);
+}
+
+TEST_F(ScalarReplacementTest, AllocationWithSideEffects) {
+  // The class may need to be initialized.
+  HNewInstance* allocation = new (&allocator_) HNewInstance(0, 0, false);
+  block_->AddInstruction(allocation);
+  block_->AddInstruction(new (&allocator_) HReturnVoid());
+
+  RunScalarReplacement();
+
+  ASSERT_EQ(allocation->GetBlock(), block_);
+}
+
+TEST_F(ScalarReplacementTest, CompileOptimized) {
+  HNewInstance* allocation = new (&allocator_) HNewInstance(0, 0, true);
+  block_->AddInstruction(allocation);
+  HInstruction* null_check = new (&allocator_) HNullCheck(allocation, 0);
+  block_->AddInstruction(null_check);
+  block_->AddInstruction(new (&allocator_) HInstanceFieldSet(
+      null_check, parameter_, Primitive::kPrimInt, MemberOffset(8)));
+  HInstruction* get =
+      new (&allocator_) HInstanceFieldGet(allocation, Primitive::kPrimInt, MemberOffset(8));
+  block_->AddInstruction(get);
+  block_->AddInstruction(new (&allocator_) HReturn(get));
+
+  graph_->BuildDominatorTree();
+  graph_->TransformToSSA();
+  ASSERT_TRUE(graph_->FindNaturalLoops());
+
+  // Once the allocation is replaced, the method no longer needs the baseline
+  // code generator.
+  ASSERT_TRUE(CompileOptimized(graph_, kX86, InstructionSetFeatures()));
+  ASSERT_EQ(allocation->GetBlock(), nullptr);
+  ASSERT_EQ(null_check->GetBlock(), nullptr);
+}
+
+}  // namespace art
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "side_effects_analysis.h"
+
+namespace art {
+
+void SideEffectsAnalysis::Run() {
+  size_t number_of_blocks = graph_->GetBlocks().Size();
+  block_effects_.SetSize(number_of_blocks);
+  loop_effects_.SetSize(number_of_blocks);
+  for (size_t i = 0; i < number_of_blocks; ++i) {
+    block_effects_.Put(i, SideEffects::None());
+    loop_effects_.Put(i, SideEffects::None());
+  }
+
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    SideEffects effects = SideEffects::None();
+    for (HInstructionIterator inst_it(block->GetInstructions());
+         !inst_it.Done();
+         inst_it.Advance()) {
+      effects = effects.Union(inst_it.Current()->GetSideEffects());
+    }
+    block_effects_.Put(block->GetBlockId(), effects);
+  }
+
+  // The effects of a loop are the ones of all its blocks, including the
+  // blocks of its inner loops.
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* header = it.Current();
+    if (!header->IsLoopHeader()) continue;
+    SideEffects effects = SideEffects::None();
+    BitVector::Iterator blocks_it(&header->GetLoopInformation()->GetBlocks());
+    for (int32_t id = blocks_it.Next(); id != -1; id = blocks_it.Next()) {
+      effects = effects.Union(block_effects_.Get(id));
+    }
+    loop_effects_.Put(header->GetBlockId(), effects);
+  }
+  has_run_ = true;
+}
+
+SideEffects SideEffectsAnalysis::GetBlockEffects(HBasicBlock* block) const {
+  DCHECK(has_run_);
+  return block_effects_.Get(block->GetBlockId());
+}
+
+SideEffects SideEffectsAnalysis::GetLoopEffects(HBasicBlock* block) const {
+  DCHECK(has_run_);
+  DCHECK(block->IsLoopHeader());
+  return loop_effects_.Get(block->GetBlockId());
+}
+
+}  // namespace art
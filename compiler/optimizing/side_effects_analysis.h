@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_SIDE_EFFECTS_ANALYSIS_H_
+#define ART_COMPILER_OPTIMIZING_SIDE_EFFECTS_ANALYSIS_H_
+
+#include "nodes.h"
+
+namespace art {
+
+// Computes the union of the side effects of the instructions of each block,
+// and of each loop. Loops must have been found before running the analysis.
+class SideEffectsAnalysis : public ValueObject {
+ public:
+  explicit SideEffectsAnalysis(HGraph* graph)
+      : graph_(graph),
+        block_effects_(graph->GetArena(), graph->GetBlocks().Size()),
+        loop_effects_(graph->GetArena(), graph->GetBlocks().Size()),
+        has_run_(false) {}
+
+  void Run();
+
+  SideEffects GetBlockEffects(HBasicBlock* block) const;
+
+  // Returns the side effects of the loop whose header is `block`.
+  SideEffects GetLoopEffects(HBasicBlock* block) const;
+
+  bool HasRun() const { return has_run_; }
+
+ private:
+  HGraph* graph_;
+
+  // Side effects of each block, indexed by block id.
+  GrowableArray<SideEffects> block_effects_;
+
+  // Side effects of each loop, indexed by the block id of the loop header.
+  GrowableArray<SideEffects> loop_effects_;
+
+  bool has_run_;
+
+  DISALLOW_COPY_AND_ASSIGN(SideEffectsAnalysis);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_SIDE_EFFECTS_ANALYSIS_H_
@@ -65,9 +65,9 @@ void SsaBuilder::VisitBasicBlock(HBasicBlock* block) {
     for (size_t local = 0; local < current_locals_->Size(); local++) {
       HInstruction* incoming = ValueOfLocal(block->GetLoopInformation()->GetPreHeader(), local);
       if (incoming != nullptr) {
-        // TODO: Compute union type.
+        // The type is computed by SsaTypePropagation.
         HPhi* phi = new (GetGraph()->GetArena()) HPhi(
-            GetGraph()->GetArena(), local, 0, Primitive::kPrimVoid);
+            GetGraph()->GetArena(), local, 0, incoming->GetType());
         block->AddPhi(phi);
         current_locals_->Put(local, phi);
       }
@@ -81,16 +81,25 @@ void SsaBuilder::VisitBasicBlock(HBasicBlock* block) {
     for (size_t local = 0; local < current_locals_->Size(); local++) {
       bool is_different = false;
       HInstruction* value = ValueOfLocal(block->GetPredecessors().Get(0), local);
+      bool is_undefined = (value == nullptr);
       for (size_t i = 1; i < block->GetPredecessors().Size(); i++) {
-        if (ValueOfLocal(block->GetPredecessors().Get(i), local) != value) {
-          is_different = true;
+        HInstruction* current = ValueOfLocal(block->GetPredecessors().Get(i), local);
+        if (current == nullptr) {
+          is_undefined = true;
           break;
         }
+        if (current != value) {
+          is_different = true;
+        }
       }
-      if (is_different) {
-        // TODO: Compute union type.
+      if (is_undefined) {
+        // The local is not initialized on all incoming paths, so it cannot be used
+        // after the merge.
+        value = nullptr;
+      } else if (is_different) {
+        // The type is computed by SsaTypePropagation.
         HPhi* phi = new (GetGraph()->GetArena()) HPhi(
-            GetGraph()->GetArena(), local, block->GetPredecessors().Size(), Primitive::kPrimVoid);
+            GetGraph()->GetArena(), local, block->GetPredecessors().Size(), value->GetType());
         for (size_t i = 0; i < block->GetPredecessors().Size(); i++) {
           phi->SetRawInputAt(i, ValueOfLocal(block->GetPredecessors().Get(i), local));
         }
@@ -121,6 +130,11 @@ void SsaBuilder::VisitStoreLocal(HStoreLocal* store) {
   store->GetBlock()->RemoveInstruction(store);
 }
 
+void SsaBuilder::VisitTemporary(HTemporary* temp) {
+  // Temporaries are only used by the baseline register allocator.
+  temp->GetBlock()->RemoveInstruction(temp);
+}
+
 void SsaBuilder::VisitInstruction(HInstruction* instruction) {
   if (!instruction->NeedsEnvironment()) {
     return;
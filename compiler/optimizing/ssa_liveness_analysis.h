@@ -46,12 +46,12 @@ class BlockInfo : public ArenaObject {
 
 /**
  * A live range contains the start and end of a range where an instruction
- * is live.
+ * is live. Both bounds are inclusive.
  */
 class LiveRange : public ValueObject {
  public:
   LiveRange(size_t start, size_t end) : start_(start), end_(end) {
-    DCHECK_LT(start, end);
+    DCHECK_LE(start, end);
   }
 
   size_t GetStart() const { return start_; }
@@ -63,14 +63,45 @@ class LiveRange : public ValueObject {
 };
 
 static constexpr int kDefaultNumberOfRanges = 3;
+static constexpr int kNoRegister = -1;
+static constexpr int kNoSpillSlot = -1;
 
 /**
  * An interval is a list of disjoint live ranges where an instruction is live.
  * Each instruction that has uses gets an interval.
+ *
+ * The register allocator splits intervals into siblings: each sibling covers
+ * a disjoint part of the lifetime of the instruction, and either lives in a
+ * register or in the spill slot of its parent. Fixed intervals do not belong
+ * to an instruction, they block their register for the positions they cover.
  */
 class LiveInterval : public ArenaObject {
  public:
-  explicit LiveInterval(ArenaAllocator* allocator) : ranges_(allocator, kDefaultNumberOfRanges) {}
+  explicit LiveInterval(ArenaAllocator* allocator,
+                        HInstruction* defined_by = nullptr,
+                        bool is_fixed = false,
+                        int reg = kNoRegister)
+      : allocator_(allocator),
+        ranges_(allocator, kDefaultNumberOfRanges),
+        register_uses_(allocator, kDefaultNumberOfRanges),
+        parent_(this),
+        next_sibling_(nullptr),
+        defined_by_(defined_by),
+        register_(reg),
+        spill_slot_(kNoSpillSlot),
+        is_fixed_(is_fixed),
+        is_temp_(false) {}
+
+  // Create an interval for a temporary register `defined_by` needs at `position`.
+  static LiveInterval* MakeTempInterval(ArenaAllocator* allocator,
+                                        HInstruction* defined_by,
+                                        size_t position) {
+    LiveInterval* temp = new (allocator) LiveInterval(allocator, defined_by);
+    temp->is_temp_ = true;
+    temp->AddRange(position, position);
+    temp->AddRegisterUse(position);
+    return temp;
+  }
 
   void AddUse(HInstruction* instruction) {
     size_t position = instruction->GetLifetimePosition();
@@ -129,12 +160,216 @@ class LiveInterval : public ArenaObject {
 
   const GrowableArray<LiveRange>& GetRanges() const { return ranges_; }
 
+  // Ranges are stored from the last one to the first one.
+  size_t GetStart() const { return ranges_.Peek().GetStart(); }
+  size_t GetEnd() const { return ranges_.Get(0).GetEnd(); }
+
+  bool IsFixed() const { return is_fixed_; }
+  bool IsTemp() const { return is_temp_; }
+  HInstruction* GetDefinedBy() const { return defined_by_; }
+
+  LiveInterval* GetParent() const { return parent_; }
+  LiveInterval* GetNextSibling() const { return next_sibling_; }
+
+  bool HasRegister() const { return register_ != kNoRegister; }
+  int GetRegister() const { return register_; }
+  void SetRegister(int reg) { register_ = reg; }
+  void ClearRegister() { register_ = kNoRegister; }
+
+  // Spill slots are shared by all siblings, and only recorded in the parent.
+  bool HasSpillSlot() const { return parent_->spill_slot_ != kNoSpillSlot; }
+  int GetSpillSlot() const { return parent_->spill_slot_; }
+  void SetSpillSlot(int slot) { parent_->spill_slot_ = slot; }
+
+  // Record that the instruction needs the value in a register at `position`.
+  // Uses are recorded in the parent, and must be added in decreasing order.
+  void AddRegisterUse(size_t position) {
+    DCHECK_EQ(parent_, this);
+    if (!register_uses_.IsEmpty()) {
+      if (register_uses_.Peek() == position) {
+        // The same instruction uses the value more than once.
+        return;
+      }
+      DCHECK_LT(position, register_uses_.Peek());
+    }
+    register_uses_.Add(position);
+  }
+
+  bool Covers(size_t position) const {
+    for (size_t i = 0, e = ranges_.Size(); i < e; ++i) {
+      LiveRange range = ranges_.Get(i);
+      if (position >= range.GetStart() && position <= range.GetEnd()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Returns the first position after `min_position` covered by both this
+  // interval and `other`, or kNoLifetime if there is none.
+  size_t FirstIntersectionWith(const LiveInterval& other, size_t min_position = 0) const {
+    size_t index = ranges_.Size();
+    size_t other_index = other.ranges_.Size();
+    while (index > 0 && other_index > 0) {
+      LiveRange range = ranges_.Get(index - 1);
+      LiveRange other_range = other.ranges_.Get(other_index - 1);
+      size_t end = std::min(range.GetEnd(), other_range.GetEnd());
+      size_t start = std::max(std::max(range.GetStart(), other_range.GetStart()), min_position);
+      if (start <= end) {
+        return start;
+      }
+      // Advance the range that ends first.
+      if (range.GetEnd() == end) {
+        --index;
+      } else {
+        --other_index;
+      }
+    }
+    return kNoLifetime;
+  }
+
+  // Returns the first register use of the instruction in this sibling at or
+  // after `position`, or kNoLifetime if there is none.
+  size_t FirstRegisterUseAfter(size_t position) const {
+    const GrowableArray<size_t>& uses = parent_->register_uses_;
+    size_t end = GetEnd();
+    for (size_t i = uses.Size(); i > 0; --i) {
+      size_t use = uses.Get(i - 1);
+      if (use > end) {
+        break;
+      }
+      if (use >= position) {
+        return use;
+      }
+    }
+    return kNoLifetime;
+  }
+
+  size_t FirstRegisterUse() const {
+    return FirstRegisterUseAfter(GetStart());
+  }
+
+  // Split this interval at `position`. This interval keeps the ranges before
+  // `position`, and the returned sibling gets the ones after. Returns nullptr
+  // if the interval ends before `position`.
+  LiveInterval* SplitAt(size_t position) {
+    DCHECK(!is_fixed_);
+    DCHECK_GT(position, GetStart());
+    if (GetEnd() < position) {
+      return nullptr;
+    }
+
+    LiveInterval* new_interval = new (allocator_) LiveInterval(allocator_, defined_by_);
+    new_interval->parent_ = parent_;
+    new_interval->next_sibling_ = next_sibling_;
+    next_sibling_ = new_interval;
+
+    size_t index = 0;
+    while (ranges_.Get(index).GetStart() >= position) {
+      new_interval->ranges_.Add(ranges_.Get(index));
+      ++index;
+    }
+    LiveRange range = ranges_.Get(index);
+    if (range.GetEnd() >= position) {
+      // `position` is within the range, cut the range in two.
+      new_interval->ranges_.Add(LiveRange(position, range.GetEnd()));
+      ranges_.Put(index, LiveRange(range.GetStart(), position - 1));
+    }
+    // Remove the ranges given to the new sibling.
+    size_t size = ranges_.Size();
+    for (size_t i = index; i < size; ++i) {
+      ranges_.Put(i - index, ranges_.Get(i));
+    }
+    ranges_.SetSize(size - index);
+    return new_interval;
+  }
+
+  // Returns the sibling of this interval that covers `position`, or nullptr
+  // if the instruction is not live at `position`.
+  LiveInterval* GetSiblingAt(size_t position) {
+    for (LiveInterval* current = parent_; current != nullptr; current = current->next_sibling_) {
+      if (current->Covers(position)) {
+        return current;
+      }
+    }
+    return nullptr;
+  }
+
+  void Dump(std::ostream& stream) const {
+    stream << "ranges: {";
+    for (size_t i = ranges_.Size(); i > 0; --i) {
+      LiveRange range = ranges_.Get(i - 1);
+      stream << "[" << range.GetStart() << ", " << range.GetEnd() << "]";
+      if (i != 1) {
+        stream << " ";
+      }
+    }
+    stream << "}, register: " << register_ << ", spill slot: " << GetSpillSlot();
+  }
+
  private:
+  ArenaAllocator* const allocator_;
   GrowableArray<LiveRange> ranges_;
 
+  // Positions where the instruction needs the value in a register, in
+  // decreasing order. Only used by the parent.
+  GrowableArray<size_t> register_uses_;
+
+  // The first interval of the instruction, and the next part of its lifetime.
+  LiveInterval* parent_;
+  LiveInterval* next_sibling_;
+
+  // The instruction represented by this interval, or the instruction using the
+  // temporary. nullptr for fixed intervals.
+  HInstruction* const defined_by_;
+
+  // The register allocated to this interval, or kNoRegister.
+  int register_;
+
+  // The spill slot allocated to the parent, or kNoSpillSlot.
+  int spill_slot_;
+
+  // Whether this interval blocks a physical register.
+  const bool is_fixed_;
+
+  // Whether this interval is for a temporary register of `defined_by_`.
+  bool is_temp_;
+
   DISALLOW_COPY_AND_ASSIGN(LiveInterval);
 };
 
+class HLinearOrderIterator : public ValueObject {
+ public:
+  explicit HLinearOrderIterator(const GrowableArray<HBasicBlock*>& post_order)
+      : post_order_(post_order), index_(post_order.Size()) {}
+
+  bool Done() const { return index_ == 0; }
+  HBasicBlock* Current() const { return post_order_.Get(index_ -1); }
+  void Advance() { --index_; DCHECK_GE(index_, 0U); }
+
+ private:
+  const GrowableArray<HBasicBlock*>& post_order_;
+  size_t index_;
+
+  DISALLOW_COPY_AND_ASSIGN(HLinearOrderIterator);
+};
+
+class HLinearPostOrderIterator : public ValueObject {
+ public:
+  explicit HLinearPostOrderIterator(const GrowableArray<HBasicBlock*>& post_order)
+      : post_order_(post_order), index_(0) {}
+
+  bool Done() const { return index_ == post_order_.Size(); }
+  HBasicBlock* Current() const { return post_order_.Get(index_); }
+  void Advance() { ++index_; }
+
+ private:
+  const GrowableArray<HBasicBlock*>& post_order_;
+  size_t index_;
+
+  DISALLOW_COPY_AND_ASSIGN(HLinearPostOrderIterator);
+};
+
 class SsaLivenessAnalysis : public ValueObject {
  public:
   explicit SsaLivenessAnalysis(const HGraph& graph)
@@ -142,6 +377,7 @@ class SsaLivenessAnalysis : public ValueObject {
         linear_post_order_(graph.GetArena(), graph.GetBlocks().Size()),
         block_infos_(graph.GetArena(), graph.GetBlocks().Size()),
         instructions_from_ssa_index_(graph.GetArena(), 0),
+        instructions_from_lifetime_position_(graph.GetArena(), 0),
         number_of_ssa_values_(0) {
     block_infos_.SetSize(graph.GetBlocks().Size());
   }
@@ -164,10 +400,25 @@ class SsaLivenessAnalysis : public ValueObject {
     return linear_post_order_;
   }
 
-  HInstruction* GetInstructionFromSsaIndex(size_t index) {
+  HInstruction* GetInstructionFromSsaIndex(size_t index) const {
     return instructions_from_ssa_index_.Get(index);
   }
 
+  // Returns the non-phi instruction at lifetime `position`, or nullptr if the
+  // position is the start or the end of a block.
+  HInstruction* GetInstructionFromPosition(size_t position) const {
+    return instructions_from_lifetime_position_.Get(position);
+  }
+
+  size_t GetNumberOfSsaValues() const {
+    return number_of_ssa_values_;
+  }
+
+  // Returns the number of lifetime positions used by the graph.
+  size_t GetMaxLifetimePosition() const {
+    return instructions_from_lifetime_position_.Size();
+  }
+
  private:
   // Linearize the graph so that:
   // (1): a block is always after its dominator,
@@ -201,6 +452,7 @@ class SsaLivenessAnalysis : public ValueObject {
   GrowableArray<HBasicBlock*> linear_post_order_;
   GrowableArray<BlockInfo*> block_infos_;
   GrowableArray<HInstruction*> instructions_from_ssa_index_;
+  GrowableArray<HInstruction*> instructions_from_lifetime_position_;
   size_t number_of_ssa_values_;
 
   DISALLOW_COPY_AND_ASSIGN(SsaLivenessAnalysis);
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ssa_phi_elimination.h"
+
+namespace art {
+
+void SsaRedundantPhiElimination::Run() {
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    for (HInstructionIterator inst_it(it.Current()->GetPhis()); !inst_it.Done();
+         inst_it.Advance()) {
+      worklist_.Add(inst_it.Current()->AsPhi());
+    }
+  }
+
+  while (!worklist_.IsEmpty()) {
+    HPhi* phi = worklist_.Pop();
+    if (phi->GetBlock() == nullptr) {
+      // Already removed.
+      continue;
+    }
+
+    HInstruction* candidate = nullptr;
+    bool is_redundant = true;
+    for (size_t i = 0, e = phi->InputCount(); i < e; ++i) {
+      HInstruction* input = phi->InputAt(i);
+      if (input == phi) {
+        continue;
+      } else if (candidate == nullptr) {
+        candidate = input;
+      } else if (input != candidate) {
+        is_redundant = false;
+        break;
+      }
+    }
+    // The type check keeps the phis typed as floating point or reference
+    // values of the int constants they merge.
+    if (!is_redundant || candidate == nullptr || candidate->GetType() != phi->GetType()) {
+      continue;
+    }
+
+    // The phis using `phi` may merge a single value once it is replaced.
+    for (HUseIterator<HInstruction> use_it(phi->GetUses()); !use_it.Done(); use_it.Advance()) {
+      HPhi* user = use_it.Current()->GetUser()->AsPhi();
+      if (user != nullptr && user != phi) {
+        worklist_.Add(user);
+      }
+    }
+    phi->ReplaceWith(candidate);
+    phi->GetBlock()->RemovePhi(phi);
+  }
+}
+
+void SsaDeadPhiElimination::Run() {
+  ArenaBitVector live(graph_->GetArena(), graph_->GetCurrentInstructionId(), false);
+
+  // The phis used by an instruction other than a phi, or by an environment,
+  // are live.
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    for (HInstructionIterator inst_it(it.Current()->GetPhis()); !inst_it.Done();
+         inst_it.Advance()) {
+      HPhi* phi = inst_it.Current()->AsPhi();
+      bool is_live = phi->GetEnvUses() != nullptr;
+      for (HUseIterator<HInstruction> use_it(phi->GetUses()); !is_live && !use_it.Done();
+           use_it.Advance()) {
+        is_live = use_it.Current()->GetUser()->AsPhi() == nullptr;
+      }
+      if (is_live) {
+        live.SetBit(phi->GetId());
+        worklist_.Add(phi);
+      }
+    }
+  }
+
+  // The phis merged by a live phi are live.
+  while (!worklist_.IsEmpty()) {
+    HPhi* phi = worklist_.Pop();
+    for (size_t i = 0, e = phi->InputCount(); i < e; ++i) {
+      HPhi* input = phi->InputAt(i)->AsPhi();
+      if (input != nullptr && !live.IsBitSet(input->GetId())) {
+        live.SetBit(input->GetId());
+        worklist_.Add(input);
+      }
+    }
+  }
+
+  // A dead phi may be used by other dead phis: unlink all of them from their
+  // inputs before removing them.
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    for (HInstructionIterator inst_it(it.Current()->GetPhis()); !inst_it.Done();
+         inst_it.Advance()) {
+      HPhi* phi = inst_it.Current()->AsPhi();
+      if (!live.IsBitSet(phi->GetId())) {
+        for (size_t i = 0, e = phi->InputCount(); i < e; ++i) {
+          phi->InputAt(i)->RemoveUser(phi, i);
+        }
+      }
+    }
+  }
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    HBasicBlock* block = it.Current();
+    for (HInstructionIterator inst_it(block->GetPhis()); !inst_it.Done(); inst_it.Advance()) {
+      HPhi* phi = inst_it.Current()->AsPhi();
+      if (!live.IsBitSet(phi->GetId())) {
+        block->RemovePhi(phi);
+      }
+    }
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nodes.h"
+#include "ssa_phi_elimination.h"
+#include "utils/arena_allocator.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+/**
+ * Fixture building the graph of a loop, with a local initialized to the
+ * int constant 0 before it:
+ *
+ *        entry
+ *          |
+ *        block
+ *          |
+ *        header <---+
+ *        /    \     |
+ *     exit    body -+
+ */
+class SsaPhiEliminationTest : public testing::Test {
+ public:
+  SsaPhiEliminationTest() : pool_(), allocator_(&pool_) {
+    graph_ = new (&allocator_) HGraph(&allocator_);
+    entry_ = new (&allocator_) HBasicBlock(graph_);
+    block_ = new (&allocator_) HBasicBlock(graph_);
+    header_ = new (&allocator_) HBasicBlock(graph_);
+    body_ = new (&allocator_) HBasicBlock(graph_);
+    exit_ = new (&allocator_) HBasicBlock(graph_);
+
+    graph_->AddBlock(entry_);
+    graph_->AddBlock(block_);
+    graph_->AddBlock(header_);
+    graph_->AddBlock(body_);
+    graph_->AddBlock(exit_);
+    graph_->SetEntryBlock(entry_);
+    graph_->SetExitBlock(exit_);
+    graph_->SetNumberOfVRegs(1);
+
+    entry_->AddSuccessor(block_);
+    block_->AddSuccessor(header_);
+    header_->AddSuccessor(body_);
+    header_->AddSuccessor(exit_);
+    body_->AddSuccessor(header_);
+
+    local_ = new (&allocator_) HLocal(0);
+    entry_->AddInstruction(local_);
+    parameter_ = new (&allocator_) HParameterValue(0, Primitive::kPrimNot);
+    entry_->AddInstruction(parameter_);
+    condition_ = new (&allocator_) HParameterValue(1, Primitive::kPrimBoolean);
+    entry_->AddInstruction(condition_);
+    zero_ = new (&allocator_) HIntConstant(0);
+    entry_->AddInstruction(zero_);
+    entry_->AddInstruction(new (&allocator_) HGoto());
+    block_->AddInstruction(new (&allocator_) HStoreLocal(local_, zero_));
+    block_->AddInstruction(new (&allocator_) HGoto());
+    header_->AddInstruction(new (&allocator_) HIf(condition_));
+    body_->AddInstruction(new (&allocator_) HGoto());
+    exit_->AddInstruction(new (&allocator_) HExit());
+  }
+
+  // Adds to the body a write of the value of the local at the start of the
+  // body to a field, and returns the field write.
+  HInstruction* UseInBody() {
+    HInstruction* load = new (&allocator_) HLoadLocal(local_, Primitive::kPrimInt);
+    body_->InsertInstructionBefore(load, body_->GetLastInstruction());
+    HInstruction* set_field = new (&allocator_) HInstanceFieldSet(
+        parameter_, load, Primitive::kPrimInt, MemberOffset(20));
+    body_->InsertInstructionBefore(set_field, body_->GetLastInstruction());
+    return set_field;
+  }
+
+  void StoreInBody(HInstruction* value) {
+    body_->InsertInstructionBefore(value, body_->GetLastInstruction());
+    body_->InsertInstructionBefore(
+        new (&allocator_) HStoreLocal(local_, value), body_->GetLastInstruction());
+  }
+
+  // Builds the SSA form, and returns the phi of the local.
+  HPhi* TransformToSSA() {
+    graph_->BuildDominatorTree();
+    graph_->TransformToSSA();
+    HInstructionIterator it(header_->GetPhis());
+    return it.Done() ? nullptr : it.Current()->AsPhi();
+  }
+
+  void RunPhiElimination() {
+    SsaRedundantPhiElimination(graph_).Run();
+    SsaDeadPhiElimination(graph_).Run();
+  }
+
+  ArenaPool pool_;
+  ArenaAllocator allocator_;
+  HGraph* graph_;
+
+  HBasicBlock* entry_;
+  HBasicBlock* block_;
+  HBasicBlock* header_;
+  HBasicBlock* body_;
+  HBasicBlock* exit_;
+
+  HLocal* local_;
+  HInstruction* parameter_;
+  HInstruction* condition_;
+  HInstruction* zero_;
+};
+
+TEST_F(SsaPhiEliminationTest, RedundantPhi) {
+  HInstruction* set_field = UseInBody();
+
+  HPhi* phi = TransformToSSA();
+  ASSERT_NE(phi, nullptr);
+
+  RunPhiElimination();
+
+  // The loop does not write the local, the phi only merges the constant.
+  ASSERT_TRUE(HInstructionIterator(header_->GetPhis()).Done());
+  ASSERT_EQ(set_field->InputAt(1), zero_);
+}
+
+TEST_F(SsaPhiEliminationTest, DeadPhi) {
+  StoreInBody(new (&allocator_) HIntConstant(1));
+
+  HPhi* phi = TransformToSSA();
+  ASSERT_NE(phi, nullptr);
+
+  RunPhiElimination();
+
+  // The value of the local is never read.
+  ASSERT_TRUE(HInstructionIterator(header_->GetPhis()).Done());
+}
+
+TEST_F(SsaPhiEliminationTest, LivePhi) {
+  HInstruction* set_field = UseInBody();
+  StoreInBody(new (&allocator_) HIntConstant(1));
+
+  HPhi* phi = TransformToSSA();
+  ASSERT_NE(phi, nullptr);
+
+  RunPhiElimination();
+
+  ASSERT_EQ(phi->GetBlock(), header_);
+  ASSERT_EQ(set_field->InputAt(1), phi);
+}
+
+}  // namespace art
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ssa_type_propagation.h"
+
+namespace art {
+
+// The verifier has already checked that the merged values are compatible:
+// a float, double or reference value can only be merged with constants,
+// whose type is int or long.
+static Primitive::Type MergeTypes(Primitive::Type existing, Primitive::Type new_type) {
+  switch (existing) {
+    case Primitive::kPrimFloat:
+    case Primitive::kPrimDouble:
+    case Primitive::kPrimNot:
+      return existing;
+    default:
+      return new_type;
+  }
+}
+
+void SsaTypePropagation::Run() {
+  for (HReversePostOrderIterator it(*graph_); !it.Done(); it.Advance()) {
+    VisitBasicBlock(it.Current());
+  }
+  ProcessWorklist();
+}
+
+void SsaTypePropagation::VisitBasicBlock(HBasicBlock* block) {
+  if (block->IsLoopHeader()) {
+    // The inputs from the back edges are not typed yet: start from the input
+    // from the pre-header, and revisit the phi once they are.
+    for (HInstructionIterator it(block->GetPhis()); !it.Done(); it.Advance()) {
+      HPhi* phi = it.Current()->AsPhi();
+      phi->SetType(phi->InputAt(0)->GetType());
+      AddToWorklist(phi);
+    }
+  } else {
+    for (HInstructionIterator it(block->GetPhis()); !it.Done(); it.Advance()) {
+      HPhi* phi = it.Current()->AsPhi();
+      if (UpdateType(phi)) {
+        AddDependentInstructionsToWorklist(phi);
+      }
+    }
+  }
+}
+
+void SsaTypePropagation::ProcessWorklist() {
+  while (!worklist_.IsEmpty()) {
+    HPhi* phi = worklist_.Pop();
+    if (UpdateType(phi)) {
+      AddDependentInstructionsToWorklist(phi);
+    }
+  }
+}
+
+void SsaTypePropagation::AddToWorklist(HPhi* phi) {
+  worklist_.Add(phi);
+}
+
+void SsaTypePropagation::AddDependentInstructionsToWorklist(HPhi* phi) {
+  for (HUseIterator<HInstruction> it(phi->GetUses()); !it.Done(); it.Advance()) {
+    HPhi* user = it.Current()->GetUser()->AsPhi();
+    if (user != nullptr) {
+      AddToWorklist(user);
+    }
+  }
+}
+
+bool SsaTypePropagation::UpdateType(HPhi* phi) {
+  Primitive::Type existing = phi->GetType();
+  Primitive::Type new_type = Primitive::kPrimVoid;
+  for (size_t i = 0, e = phi->InputCount(); i < e; ++i) {
+    new_type = MergeTypes(new_type, phi->InputAt(i)->GetType());
+  }
+  phi->SetType(new_type);
+  return existing != new_type;
+}
+
+}  // namespace art
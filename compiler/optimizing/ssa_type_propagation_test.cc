@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nodes.h"
+#include "ssa_type_propagation.h"
+#include "utils/arena_allocator.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+/**
+ * Fixture building the graph of a loop, with a local initialized to the
+ * int constant 0 before it and written in its body:
+ *
+ *        entry
+ *          |
+ *        block
+ *          |
+ *        header <---+
+ *        /    \     |
+ *     exit    body -+
+ */
+class SsaTypePropagationTest : public testing::Test {
+ public:
+  SsaTypePropagationTest() : pool_(), allocator_(&pool_) {
+    graph_ = new (&allocator_) HGraph(&allocator_);
+    entry_ = new (&allocator_) HBasicBlock(graph_);
+    block_ = new (&allocator_) HBasicBlock(graph_);
+    header_ = new (&allocator_) HBasicBlock(graph_);
+    body_ = new (&allocator_) HBasicBlock(graph_);
+    exit_ = new (&allocator_) HBasicBlock(graph_);
+
+    graph_->AddBlock(entry_);
+    graph_->AddBlock(block_);
+    graph_->AddBlock(header_);
+    graph_->AddBlock(body_);
+    graph_->AddBlock(exit_);
+    graph_->SetEntryBlock(entry_);
+    graph_->SetExitBlock(exit_);
+    graph_->SetNumberOfVRegs(1);
+
+    entry_->AddSuccessor(block_);
+    block_->AddSuccessor(header_);
+    header_->AddSuccessor(body_);
+    header_->AddSuccessor(exit_);
+    body_->AddSuccessor(header_);
+
+    local_ = new (&allocator_) HLocal(0);
+    entry_->AddInstruction(local_);
+    parameter_ = new (&allocator_) HParameterValue(0, Primitive::kPrimNot);
+    entry_->AddInstruction(parameter_);
+    condition_ = new (&allocator_) HParameterValue(1, Primitive::kPrimBoolean);
+    entry_->AddInstruction(condition_);
+    HInstruction* zero = new (&allocator_) HIntConstant(0);
+    entry_->AddInstruction(zero);
+    entry_->AddInstruction(new (&allocator_) HGoto());
+    block_->AddInstruction(new (&allocator_) HStoreLocal(local_, zero));
+    block_->AddInstruction(new (&allocator_) HGoto());
+    header_->AddInstruction(new (&allocator_) HIf(condition_));
+    body_->AddInstruction(new (&allocator_) HGoto());
+    exit_->AddInstruction(new (&allocator_) HExit());
+  }
+
+  // Adds the instructions computing the value of the local in the body of
+  // the loop, from its value at the start of the body when `load` is not null.
+  void StoreInBody(HInstruction* value, HInstruction* load = nullptr) {
+    if (load != nullptr) {
+      body_->InsertInstructionBefore(load, body_->GetLastInstruction());
+    }
+    body_->InsertInstructionBefore(value, body_->GetLastInstruction());
+    body_->InsertInstructionBefore(
+        new (&allocator_) HStoreLocal(local_, value), body_->GetLastInstruction());
+  }
+
+  // Builds the SSA form, which propagates the types, and returns the phi of the local.
+  HPhi* TransformToSSA() {
+    graph_->BuildDominatorTree();
+    graph_->TransformToSSA();
+    HInstructionIterator it(header_->GetPhis());
+    return it.Done() ? nullptr : it.Current()->AsPhi();
+  }
+
+  ArenaPool pool_;
+  ArenaAllocator allocator_;
+  HGraph* graph_;
+
+  HBasicBlock* entry_;
+  HBasicBlock* block_;
+  HBasicBlock* header_;
+  HBasicBlock* body_;
+  HBasicBlock* exit_;
+
+  HLocal* local_;
+  HInstruction* parameter_;
+  HInstruction* condition_;
+};
+
+TEST_F(SsaTypePropagationTest, NullAndReference) {
+  HInstruction* null_check = new (&allocator_) HNullCheck(parameter_, 0);
+  StoreInBody(null_check);
+
+  HPhi* phi = TransformToSSA();
+
+  // The local is null before the loop, and a reference in it.
+  ASSERT_NE(phi, nullptr);
+  ASSERT_EQ(phi->GetType(), Primitive::kPrimNot);
+}
+
+TEST_F(SsaTypePropagationTest, FloatFromIntConstant) {
+  HInstruction* load = new (&allocator_) HLoadLocal(local_, Primitive::kPrimFloat);
+  HInstruction* add = new (&allocator_) HAdd(Primitive::kPrimFloat, load, load);
+  StoreInBody(add, load);
+
+  HPhi* phi = TransformToSSA();
+
+  // The int constant is the bits of 0.0f.
+  ASSERT_NE(phi, nullptr);
+  ASSERT_EQ(phi->GetType(), Primitive::kPrimFloat);
+  ASSERT_EQ(add->InputAt(0), phi);
+}
+
+TEST_F(SsaTypePropagationTest, IntCounter) {
+  HInstruction* load = new (&allocator_) HLoadLocal(local_, Primitive::kPrimInt);
+  HInstruction* add = new (&allocator_) HAdd(Primitive::kPrimInt, load, load);
+  StoreInBody(add, load);
+
+  HPhi* phi = TransformToSSA();
+
+  ASSERT_NE(phi, nullptr);
+  ASSERT_EQ(phi->GetType(), Primitive::kPrimInt);
+}
+
+}  // namespace art
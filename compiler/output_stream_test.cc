@@ -87,6 +87,18 @@ TEST_F(OutputStreamTest, Buffered) {
   CheckTestOutput(actual);
 }
 
+TEST_F(OutputStreamTest, BufferedFlushesOnDestruction) {
+  ScratchFile tmp;
+  {
+    BufferedOutputStream buffered_output_stream(new FileOutputStream(tmp.GetFile()));
+    uint8_t buf[] = { 1, 2, 3 };
+    EXPECT_TRUE(buffered_output_stream.WriteFully(buf, sizeof(buf)));
+  }
+  std::unique_ptr<File> in(OS::OpenFileForReading(tmp.GetFilename().c_str()));
+  EXPECT_TRUE(in.get() != NULL);
+  EXPECT_EQ(3, in->GetLength());
+}
+
 TEST_F(OutputStreamTest, Vector) {
   std::vector<uint8_t> output;
   VectorOutputStream output_stream("test vector output", output);
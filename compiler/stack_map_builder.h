@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_STACK_MAP_BUILDER_H_
+#define ART_COMPILER_STACK_MAP_BUILDER_H_
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "leb128.h"
+#include "stack_map.h"
+#include "utils.h"
+
+namespace art {
+
+// Builds the stack maps of a method, see stack_map.h for the encoding. Stack
+// maps are added one safepoint at a time: AddStackMap() starts one, and the
+// locations of all its dex registers and its references follow.
+class StackMapBuilder {
+ public:
+  explicit StackMapBuilder(uint16_t number_of_dex_registers)
+      : number_of_dex_registers_(number_of_dex_registers) {}
+
+  void AddStackMap(uint32_t dex_pc, uint32_t native_pc_offset, uint32_t register_mask) {
+    DCHECK(entries_.empty() || CurrentEntry().dex_registers_added == number_of_dex_registers_);
+    entries_.push_back(Entry());
+    Entry& entry = CurrentEntry();
+    entry.dex_pc = dex_pc;
+    entry.native_pc_offset = native_pc_offset;
+    entry.register_mask = register_mask;
+    entry.dex_registers_added = 0;
+  }
+
+  // Adds the location of the next dex register of the current stack map. For
+  // kInStack, `value` is the offset in bytes from the stack pointer.
+  void AddDexRegister(DexRegisterMap::LocationKind kind, int32_t value) {
+    Entry& entry = CurrentEntry();
+    DCHECK_LT(entry.dex_registers_added, number_of_dex_registers_);
+    ++entry.dex_registers_added;
+    switch (kind) {
+      case DexRegisterMap::kNone:
+        PushBackUnsignedLeb128(&entry.dex_register_map, DexRegisterMap::kNone);
+        break;
+      case DexRegisterMap::kInStack:
+        DCHECK_GE(value, 0);
+        DCHECK_EQ(value % static_cast<int32_t>(kVRegSize), 0);
+        value /= static_cast<int32_t>(kVRegSize);
+        // Fall-through.
+      case DexRegisterMap::kInRegister:
+        DCHECK_GE(value, 0);
+        PushBackUnsignedLeb128(&entry.dex_register_map,
+            (static_cast<uint32_t>(value) << DexRegisterMap::kLocationKindBits) | kind);
+        break;
+      case DexRegisterMap::kConstant:
+        PushBackUnsignedLeb128(&entry.dex_register_map, DexRegisterMap::kConstant);
+        PushBackSignedLeb128(&entry.dex_register_map, value);
+        break;
+    }
+  }
+
+  // Records that the stack slot at `offset` bytes from the stack pointer holds
+  // a reference at the current safepoint.
+  void AddStackReference(size_t offset) {
+    DCHECK_EQ(offset % kVRegSize, 0u);
+    CurrentEntry().stack_references.push_back(offset / kVRegSize);
+  }
+
+  void Encode(std::vector<uint8_t>* data) {
+    DCHECK(entries_.empty() || CurrentEntry().dex_registers_added == number_of_dex_registers_);
+    std::stable_sort(entries_.begin(), entries_.end(), CompareNativePcOffsets);
+
+    // Lay out the shared dex register maps, and find the widest value of each field.
+    std::map<std::vector<uint8_t>, uint32_t> dex_register_maps;
+    std::vector<uint32_t> dex_register_map_offsets;
+    uint32_t dex_register_maps_size = 0;
+    uint32_t max_dex_register_map_offset = 0;
+    uint32_t max_native_pc_offset = 0;
+    uint32_t max_dex_pc = 0;
+    uint32_t max_register_mask = 0;
+    size_t number_of_stack_slots = 0;
+    for (const Entry& entry : entries_) {
+      const std::vector<uint8_t>& map = entry.dex_register_map;
+      auto it = dex_register_maps.find(map);
+      if (it == dex_register_maps.end()) {
+        it = dex_register_maps.insert(std::make_pair(map, dex_register_maps_size)).first;
+        dex_register_maps_size += map.size();
+      }
+      dex_register_map_offsets.push_back(it->second);
+      max_dex_register_map_offset = std::max(max_dex_register_map_offset, it->second);
+      max_native_pc_offset = std::max(max_native_pc_offset, entry.native_pc_offset);
+      max_dex_pc = std::max(max_dex_pc, entry.dex_pc);
+      max_register_mask |= entry.register_mask;
+      for (size_t slot : entry.stack_references) {
+        number_of_stack_slots = std::max(number_of_stack_slots, slot + 1);
+      }
+    }
+
+    size_t native_pc_offset_size = BytesFor(max_native_pc_offset);
+    size_t dex_pc_size = BytesFor(max_dex_pc);
+    size_t dex_register_map_offset_size = BytesFor(max_dex_register_map_offset);
+    size_t register_mask_size = BytesFor(max_register_mask);
+    size_t stack_mask_size = RoundUp(number_of_stack_slots, kBitsPerByte) / kBitsPerByte;
+    CHECK_LT(stack_mask_size, 1u << 16);
+    size_t stack_map_size = native_pc_offset_size + dex_pc_size + dex_register_map_offset_size
+        + register_mask_size + stack_mask_size;
+
+    data->clear();
+    data->resize(CodeInfo::kHeaderSize + entries_.size() * stack_map_size);
+    uint8_t* header = &(*data)[0];
+    header[0] = native_pc_offset_size;
+    header[1] = dex_pc_size;
+    header[2] = dex_register_map_offset_size;
+    header[3] = register_mask_size;
+    StoreUnsigned(header + 4, 2, stack_mask_size);
+    StoreUnsigned(header + 6, 2, number_of_dex_registers_);
+    StoreUnsigned(header + 8, 4, entries_.size());
+
+    uint8_t* stack_map = header + CodeInfo::kHeaderSize;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+      const Entry& entry = entries_[i];
+      DCHECK(i == 0 || entries_[i - 1].native_pc_offset < entry.native_pc_offset)
+          << "Two safepoints at native pc offset " << entry.native_pc_offset;
+      StoreUnsigned(stack_map, native_pc_offset_size, entry.native_pc_offset);
+      stack_map += native_pc_offset_size;
+      StoreUnsigned(stack_map, dex_pc_size, entry.dex_pc);
+      stack_map += dex_pc_size;
+      StoreUnsigned(stack_map, dex_register_map_offset_size, dex_register_map_offsets[i]);
+      stack_map += dex_register_map_offset_size;
+      StoreUnsigned(stack_map, register_mask_size, entry.register_mask);
+      stack_map += register_mask_size;
+      for (size_t slot : entry.stack_references) {
+        stack_map[slot / kBitsPerByte] |= 1 << (slot % kBitsPerByte);
+      }
+      stack_map += stack_mask_size;
+    }
+
+    data->resize(data->size() + dex_register_maps_size);
+    uint8_t* dex_register_maps_start = &(*data)[0] + data->size() - dex_register_maps_size;
+    for (const auto& map : dex_register_maps) {
+      std::copy(map.first.begin(), map.first.end(), dex_register_maps_start + map.second);
+    }
+  }
+
+ private:
+  struct Entry {
+    uint32_t dex_pc;
+    uint32_t native_pc_offset;
+    uint32_t register_mask;
+    uint16_t dex_registers_added;
+    std::vector<uint8_t> dex_register_map;
+    std::vector<size_t> stack_references;
+  };
+
+  Entry& CurrentEntry() {
+    DCHECK(!entries_.empty());
+    return entries_.back();
+  }
+
+  static void PushBackUnsignedLeb128(std::vector<uint8_t>* data, uint32_t value) {
+    uint8_t buffer[5];
+    uint8_t* end = EncodeUnsignedLeb128(buffer, value);
+    data->insert(data->end(), buffer, end);
+  }
+
+  static void PushBackSignedLeb128(std::vector<uint8_t>* data, int32_t value) {
+    uint8_t buffer[5];
+    uint8_t* end = EncodeSignedLeb128(buffer, value);
+    data->insert(data->end(), buffer, end);
+  }
+
+  static bool CompareNativePcOffsets(const Entry& a, const Entry& b) {
+    return a.native_pc_offset < b.native_pc_offset;
+  }
+
+  static size_t BytesFor(uint32_t value) {
+    return (value == 0) ? 0 : sizeof(value) - CLZ(value) / kBitsPerByte;
+  }
+
+  static void StoreUnsigned(uint8_t* data, size_t size, uint32_t value) {
+    for (size_t i = 0; i < size; ++i) {
+      data[i] = (value >> (i * kBitsPerByte)) & 0xFF;
+    }
+  }
+
+  const uint16_t number_of_dex_registers_;
+  std::vector<Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(StackMapBuilder);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_STACK_MAP_BUILDER_H_
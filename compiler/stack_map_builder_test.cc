@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stack_map_builder.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+TEST(StackMapBuilder, Empty) {
+  StackMapBuilder builder(2);
+  std::vector<uint8_t> data;
+  builder.Encode(&data);
+  size_t header_size = CodeInfo::kHeaderSize;
+  ASSERT_EQ(header_size, data.size());
+
+  CodeInfo code_info(&data[0]);
+  ASSERT_EQ(0u, code_info.GetNumberOfStackMaps());
+  ASSERT_EQ(2u, code_info.GetNumberOfDexRegisters());
+  StackMap stack_map;
+  ASSERT_FALSE(code_info.FindStackMapForNativePcOffset(0, &stack_map));
+  ASSERT_FALSE(code_info.FindStackMapForDexPc(0, &stack_map));
+}
+
+TEST(StackMapBuilder, Roundtrip) {
+  StackMapBuilder builder(3);
+  // Added out of native pc order: encoding sorts them.
+  builder.AddStackMap(7, 0x140, 0);
+  builder.AddDexRegister(DexRegisterMap::kInStack, 8);
+  builder.AddDexRegister(DexRegisterMap::kConstant, -3);
+  builder.AddDexRegister(DexRegisterMap::kNone, 0);
+  builder.AddStackReference(8);
+
+  builder.AddStackMap(2, 0x20, 1 << 5);
+  builder.AddDexRegister(DexRegisterMap::kInRegister, 5);
+  builder.AddDexRegister(DexRegisterMap::kInStack, 12);
+  builder.AddDexRegister(DexRegisterMap::kConstant, 100000);
+  builder.AddStackReference(12);
+  builder.AddStackReference(40);
+
+  std::vector<uint8_t> data;
+  builder.Encode(&data);
+  CodeInfo code_info(&data[0]);
+  ASSERT_EQ(2u, code_info.GetNumberOfStackMaps());
+  ASSERT_EQ(2u, code_info.GetNativePcOffsetSize());
+  ASSERT_EQ(1u, code_info.GetDexPcSize());
+  ASSERT_EQ(1u, code_info.GetRegisterMaskSize());
+  ASSERT_EQ(2u, code_info.GetStackMaskSize());
+
+  StackMap stack_map;
+  ASSERT_TRUE(code_info.FindStackMapForNativePcOffset(0x20, &stack_map));
+  ASSERT_EQ(0x20u, stack_map.GetNativePcOffset());
+  ASSERT_EQ(2u, stack_map.GetDexPc());
+  ASSERT_EQ(1u << 5, stack_map.GetRegisterMask());
+  for (size_t slot = 0; slot < stack_map.GetNumberOfStackSlots(); ++slot) {
+    ASSERT_EQ(slot == 3 || slot == 10, stack_map.IsStackSlotReference(slot));
+  }
+  DexRegisterMap dex_registers = code_info.GetDexRegisterMapOf(stack_map);
+  int32_t value;
+  ASSERT_EQ(DexRegisterMap::kInRegister, dex_registers.GetLocation(0, &value));
+  ASSERT_EQ(5, value);
+  ASSERT_EQ(DexRegisterMap::kInStack, dex_registers.GetLocation(1, &value));
+  ASSERT_EQ(12, value);
+  ASSERT_EQ(DexRegisterMap::kConstant, dex_registers.GetLocation(2, &value));
+  ASSERT_EQ(100000, value);
+
+  ASSERT_TRUE(code_info.FindStackMapForDexPc(7, &stack_map));
+  ASSERT_EQ(0x140u, stack_map.GetNativePcOffset());
+  ASSERT_EQ(0u, stack_map.GetRegisterMask());
+  for (size_t slot = 0; slot < stack_map.GetNumberOfStackSlots(); ++slot) {
+    ASSERT_EQ(slot == 2, stack_map.IsStackSlotReference(slot));
+  }
+  DexRegisterMap other_dex_registers = code_info.GetDexRegisterMapOf(stack_map);
+  ASSERT_EQ(DexRegisterMap::kInStack, other_dex_registers.GetLocation(0, &value));
+  ASSERT_EQ(8, value);
+  ASSERT_EQ(DexRegisterMap::kConstant, other_dex_registers.GetLocation(1, &value));
+  ASSERT_EQ(-3, value);
+  ASSERT_EQ(DexRegisterMap::kNone, other_dex_registers.GetLocation(2, &value));
+
+  ASSERT_FALSE(code_info.FindStackMapForNativePcOffset(0x21, &stack_map));
+  ASSERT_FALSE(code_info.FindStackMapForNativePcOffset(0x200, &stack_map));
+  ASSERT_FALSE(code_info.FindStackMapForDexPc(3, &stack_map));
+}
+
+TEST(StackMapBuilder, SharesDexRegisterMaps) {
+  StackMapBuilder builder(2);
+  for (uint32_t i = 0; i < 100; ++i) {
+    builder.AddStackMap(i, i * 4, 0);
+    builder.AddDexRegister(DexRegisterMap::kInStack, 4);
+    builder.AddDexRegister(DexRegisterMap::kInStack, (i % 2 == 0) ? 8 : 16);
+  }
+  std::vector<uint8_t> data;
+  builder.Encode(&data);
+  CodeInfo code_info(&data[0]);
+  ASSERT_EQ(100u, code_info.GetNumberOfStackMaps());
+  // Two distinct maps of two single byte entries each.
+  ASSERT_EQ(CodeInfo::kHeaderSize + 100 * code_info.GetStackMapSize() + 4, data.size());
+
+  for (uint32_t i = 0; i < 100; ++i) {
+    StackMap stack_map;
+    ASSERT_TRUE(code_info.FindStackMapForNativePcOffset(i * 4, &stack_map));
+    ASSERT_EQ(i, stack_map.GetDexPc());
+    int32_t value;
+    DexRegisterMap dex_registers = code_info.GetDexRegisterMapOf(stack_map);
+    ASSERT_EQ(DexRegisterMap::kInStack, dex_registers.GetLocation(1, &value));
+    ASSERT_EQ((i % 2 == 0) ? 8 : 16, value);
+  }
+}
+
+}  // namespace art
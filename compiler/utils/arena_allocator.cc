@@ -145,27 +145,37 @@ void Arena::Reset() {
   }
 }
 
-ArenaPool::ArenaPool()
-    : lock_("Arena pool lock"),
-      free_arenas_(nullptr) {
+void Arena::Release() {
+  if (kUseMemMap && bytes_allocated_ != 0) {
+    // The pages read as zero when touched again.
+    madvise(Begin(), bytes_allocated_, MADV_DONTNEED);
+    bytes_allocated_ = 0;
+  }
+}
+
+ArenaPool::ArenaPool() {
 }
 
 ArenaPool::~ArenaPool() {
-  while (free_arenas_ != nullptr) {
-    auto* arena = free_arenas_;
-    free_arenas_ = free_arenas_->next_;
-    delete arena;
+  for (FreeList& free_list : free_lists_) {
+    while (free_list.arenas != nullptr) {
+      auto* arena = free_list.arenas;
+      free_list.arenas = free_list.arenas->next_;
+      delete arena;
+    }
   }
 }
 
 Arena* ArenaPool::AllocArena(size_t size) {
   Thread* self = Thread::Current();
   Arena* ret = nullptr;
-  {
-    MutexLock lock(self, lock_);
-    if (free_arenas_ != nullptr && LIKELY(free_arenas_->Size() >= size)) {
-      ret = free_arenas_;
-      free_arenas_ = free_arenas_->next_;
+  size_t home = GetFreeListIndex();
+  for (size_t i = 0; i != kNumFreeLists && ret == nullptr; ++i) {
+    FreeList& free_list = free_lists_[(home + i) % kNumFreeLists];
+    MutexLock lock(self, free_list.lock);
+    if (free_list.arenas != nullptr && LIKELY(free_list.arenas->Size() >= size)) {
+      ret = free_list.arenas;
+      free_list.arenas = free_list.arenas->next_;
     }
   }
   if (ret == nullptr) {
@@ -187,9 +197,35 @@ void ArenaPool::FreeArenaChain(Arena* first) {
       last = last->next_;
     }
     Thread* self = Thread::Current();
-    MutexLock lock(self, lock_);
-    last->next_ = free_arenas_;
-    free_arenas_ = first;
+    FreeList& free_list = free_lists_[GetFreeListIndex()];
+    MutexLock lock(self, free_list.lock);
+    last->next_ = free_list.arenas;
+    free_list.arenas = first;
+  }
+}
+
+void ArenaPool::TrimMaps() {
+  Thread* self = Thread::Current();
+  for (FreeList& free_list : free_lists_) {
+    Arena* arenas = nullptr;
+    {
+      MutexLock lock(self, free_list.lock);
+      if (kUseMemMap) {
+        // Keep the maps, without their pages.
+        for (Arena* arena = free_list.arenas; arena != nullptr; arena = arena->next_) {
+          arena->Release();
+        }
+      } else {
+        arenas = free_list.arenas;
+        free_list.arenas = nullptr;
+      }
+    }
+    // Memory from malloc cannot be released in place, give it back.
+    while (arenas != nullptr) {
+      Arena* arena = arenas;
+      arenas = arenas->next_;
+      delete arena;
+    }
   }
 }
 
@@ -197,6 +233,17 @@ size_t ArenaAllocator::BytesAllocated() const {
   return ArenaAllocatorStats::BytesAllocated();
 }
 
+size_t ArenaAllocator::BytesUsed() const {
+  size_t total = ptr_ - begin_;
+  if (arena_head_ != nullptr) {
+    for (const Arena* cur_arena = arena_head_->next_; cur_arena != nullptr;
+         cur_arena = cur_arena->next_) {
+      total += cur_arena->bytes_allocated_;
+    }
+  }
+  return total;
+}
+
 ArenaAllocator::ArenaAllocator(ArenaPool* pool)
   : pool_(pool),
     begin_(nullptr),
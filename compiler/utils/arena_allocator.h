@@ -102,7 +102,10 @@ class Arena {
   static constexpr size_t kDefaultSize = 128 * KB;
   explicit Arena(size_t size = kDefaultSize);
   ~Arena();
+  // Zero the bytes used since the last reset.
   void Reset();
+  // Give the used pages back to the kernel, if the arena is a memory map.
+  void Release();
   uint8_t* Begin() {
     return memory_;
   }
@@ -139,10 +142,25 @@ class ArenaPool {
   ~ArenaPool();
   Arena* AllocArena(size_t size);
   void FreeArenaChain(Arena* first);
+  // Release the memory of the free arenas, when the compiler is done with them for a while.
+  void TrimMaps();
 
  private:
-  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
-  Arena* free_arenas_ GUARDED_BY(lock_);
+  // Threads free arenas to, and take them first from, their own free list, so that compiler
+  // threads rarely contend for a lock and tend to reuse the arenas they touched last.
+  static constexpr size_t kNumFreeLists = 8;
+
+  struct FreeList {
+    FreeList() : lock("Arena pool lock"), arenas(nullptr) { }
+    Mutex lock DEFAULT_MUTEX_ACQUIRED_AFTER;
+    Arena* arenas GUARDED_BY(lock);
+  };
+
+  static size_t GetFreeListIndex() {
+    return static_cast<size_t>(GetTid()) % kNumFreeLists;
+  }
+
+  FreeList free_lists_[kNumFreeLists];
   DISALLOW_COPY_AND_ASSIGN(ArenaPool);
 };
 
@@ -175,6 +193,10 @@ class ArenaAllocator : private ArenaAllocatorStats {
   size_t BytesAllocated() const;
   MemStats GetMemStats() const;
 
+  // The bytes taken from the arenas so far. Unlike BytesAllocated(), this does not depend on
+  // kArenaAllocatorCountAllocations.
+  size_t BytesUsed() const;
+
  private:
   void UpdateBytesAllocated();
 
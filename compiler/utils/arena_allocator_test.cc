@@ -30,4 +30,32 @@ TEST(ArenaAllocator, Test) {
   EXPECT_EQ(2U, bv.GetStorageSize());
 }
 
+TEST(ArenaAllocator, ReuseAndTrim) {
+  ArenaPool pool;
+  {
+    ArenaAllocator arena(&pool);
+    uint8_t* data = reinterpret_cast<uint8_t*>(arena.Alloc(1000, kArenaAllocMisc));
+    EXPECT_EQ(1000U, arena.BytesUsed());
+    memset(data, 0xff, 1000);
+  }
+  {
+    // The arena freed above is reused, zeroed.
+    ArenaAllocator arena(&pool);
+    uint8_t* data = reinterpret_cast<uint8_t*>(arena.Alloc(1000, kArenaAllocMisc));
+    for (size_t i = 0; i != 1000; ++i) {
+      ASSERT_EQ(0U, data[i]);
+    }
+    memset(data, 0xff, 1000);
+  }
+  pool.TrimMaps();
+  {
+    ArenaAllocator arena(&pool);
+    uint8_t* data = reinterpret_cast<uint8_t*>(arena.Alloc(Arena::kDefaultSize, kArenaAllocMisc));
+    for (size_t i = 0; i != Arena::kDefaultSize; ++i) {
+      ASSERT_EQ(0U, data[i]);
+    }
+    EXPECT_EQ(Arena::kDefaultSize, arena.BytesUsed());
+  }
+}
+
 }  // namespace art
@@ -41,17 +41,40 @@ class ArenaBitVectorAllocator : public Allocator {
   DISALLOW_COPY_AND_ASSIGN(ArenaBitVectorAllocator);
 };
 
+// Huge methods have thousands of blocks and registers, while each block only uses or defines a
+// few registers, and has a few blocks in its dominance frontier. Above this size, these sets are
+// sparse, the other ones stay dense: the dominator sets and the live-in sets fill up.
+static constexpr uint32_t kMinSparseBits = 2048;
+
+static bool UseSparseStorage(uint32_t start_bits, OatBitMapKind kind) {
+  if (start_bits < kMinSparseBits) {
+    return false;
+  }
+  switch (kind) {
+    case kBitMapUse:
+    case kBitMapDef:
+    case kBitMapBMatrix:
+    case kBitMapIDominated:
+    case kBitMapDomFrontier:
+      return true;
+    default:
+      return false;
+  }
+}
+
 ArenaBitVector::ArenaBitVector(ArenaAllocator* arena, unsigned int start_bits,
                                bool expandable, OatBitMapKind kind)
   :  BitVector(start_bits, expandable,
-               new (arena) ArenaBitVectorAllocator<ArenaAllocator>(arena)), kind_(kind) {
+               new (arena) ArenaBitVectorAllocator<ArenaAllocator>(arena), 0U, nullptr,
+               UseSparseStorage(start_bits, kind)), kind_(kind) {
   UNUSED(kind_);
 }
 
 ArenaBitVector::ArenaBitVector(ScopedArenaAllocator* arena, unsigned int start_bits,
                                bool expandable, OatBitMapKind kind)
   :  BitVector(start_bits, expandable,
-               new (arena) ArenaBitVectorAllocator<ScopedArenaAllocator>(arena)), kind_(kind) {
+               new (arena) ArenaBitVectorAllocator<ScopedArenaAllocator>(arena), 0U, nullptr,
+               UseSparseStorage(start_bits, kind)), kind_(kind) {
   UNUSED(kind_);
 }
 
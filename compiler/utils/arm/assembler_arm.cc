@@ -1028,6 +1028,94 @@ void ArmAssembler::vmstat(Condition cond) {  // VMRS APSR_nzcv, FPSCR
 }
 
 
+void ArmAssembler::vld1(NeonElementSize size, QRegister qd, Register rn) {
+  EmitNeonLoadStore(B21, size, qd, rn);
+}
+
+
+void ArmAssembler::vst1(NeonElementSize size, QRegister qd, Register rn) {
+  EmitNeonLoadStore(0, size, qd, rn);
+}
+
+
+void ArmAssembler::vdup(NeonElementSize size, QRegister qd, Register rt, Condition cond) {
+  CHECK_NE(qd, kNoQRegister);
+  CHECK_NE(rt, kNoRegister);
+  CHECK_NE(rt, PC);
+  CHECK_NE(cond, kNoCondition);
+  CHECK_NE(size, kNeonDoubleword);
+  int32_t d = static_cast<int32_t>(qd) * 2;
+  int32_t encoding = (static_cast<int32_t>(cond) << kConditionShift) |
+                     B27 | B26 | B25 | B23 | B21 | B11 | B9 | B8 | B4 |
+                     ((size == kNeonByte) ? B22 : 0) |
+                     ((size == kNeonHalfword) ? B5 : 0) |
+                     ((d & 0xf)*B16) |
+                     (static_cast<int32_t>(rt)*B12) |
+                     ((d >> 4)*B7);
+  Emit(encoding);
+}
+
+
+void ArmAssembler::vaddi(NeonElementSize size, QRegister qd, QRegister qn, QRegister qm) {
+  EmitNeonQqq(B11, size, qd, qn, qm);
+}
+
+
+void ArmAssembler::vsubi(NeonElementSize size, QRegister qd, QRegister qn, QRegister qm) {
+  EmitNeonQqq(B24 | B11, size, qd, qn, qm);
+}
+
+
+void ArmAssembler::vmuli(NeonElementSize size, QRegister qd, QRegister qn, QRegister qm) {
+  CHECK_NE(size, kNeonDoubleword);
+  EmitNeonQqq(B11 | B8 | B4, size, qd, qn, qm);
+}
+
+
+void ArmAssembler::EmitNeonLoadStore(int32_t opcode,
+                                     NeonElementSize size,
+                                     QRegister qd,
+                                     Register rn) {
+  CHECK_NE(qd, kNoQRegister);
+  CHECK_NE(rn, kNoRegister);
+  CHECK_NE(rn, PC);
+  int32_t d = static_cast<int32_t>(qd) * 2;
+  // Two consecutive D registers (type 0b1010), no alignment, no writeback.
+  int32_t encoding = (static_cast<int32_t>(kSpecialCondition) << kConditionShift) |
+                     B26 | opcode | B11 | B9 |
+                     ((d >> 4)*B22) |
+                     (static_cast<int32_t>(rn)*B16) |
+                     ((d & 0xf)*B12) |
+                     (static_cast<int32_t>(size)*B6) |
+                     static_cast<int32_t>(PC);
+  Emit(encoding);
+}
+
+
+void ArmAssembler::EmitNeonQqq(int32_t opcode,
+                               NeonElementSize size,
+                               QRegister qd,
+                               QRegister qn,
+                               QRegister qm) {
+  CHECK_NE(qd, kNoQRegister);
+  CHECK_NE(qn, kNoQRegister);
+  CHECK_NE(qm, kNoQRegister);
+  int32_t d = static_cast<int32_t>(qd) * 2;
+  int32_t n = static_cast<int32_t>(qn) * 2;
+  int32_t m = static_cast<int32_t>(qm) * 2;
+  int32_t encoding = (static_cast<int32_t>(kSpecialCondition) << kConditionShift) |
+                     B25 | opcode | B6 |
+                     ((d >> 4)*B22) |
+                     (static_cast<int32_t>(size)*B20) |
+                     ((n & 0xf)*B16) |
+                     ((d & 0xf)*B12) |
+                     ((n >> 4)*B7) |
+                     ((m >> 4)*B5) |
+                     (m & 0xf);
+  Emit(encoding);
+}
+
+
 void ArmAssembler::svc(uint32_t imm24) {
   CHECK(IsUint(24, imm24)) << imm24;
   int32_t encoding = (AL << kConditionShift) | B27 | B26 | B25 | B24 | imm24;
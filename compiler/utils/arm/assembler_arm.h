@@ -129,6 +129,16 @@ enum LoadOperandType {
 };
 
 
+// Size of the elements of the vectors Advanced SIMD instructions operate on,
+// as encoded in their size field.
+enum NeonElementSize {
+  kNeonByte = 0,
+  kNeonHalfword = 1,
+  kNeonWord = 2,
+  kNeonDoubleword = 3
+};
+
+
 enum StoreOperandType {
   kStoreByte,
   kStoreHalfword,
@@ -358,6 +368,15 @@ class ArmAssembler FINAL : public Assembler {
   void vcmpdz(DRegister dd, Condition cond = AL);
   void vmstat(Condition cond = AL);  // VMRS APSR_nzcv, FPSCR
 
+  // Advanced SIMD (NEON) instructions. They are unconditional, and operate on
+  // whole Q registers.
+  void vld1(NeonElementSize size, QRegister qd, Register rn);  // VLD1 {qd}, [rn]
+  void vst1(NeonElementSize size, QRegister qd, Register rn);  // VST1 {qd}, [rn]
+  void vdup(NeonElementSize size, QRegister qd, Register rt, Condition cond = AL);
+  void vaddi(NeonElementSize size, QRegister qd, QRegister qn, QRegister qm);
+  void vsubi(NeonElementSize size, QRegister qd, QRegister qn, QRegister qm);
+  void vmuli(NeonElementSize size, QRegister qd, QRegister qn, QRegister qm);
+
   // Branch instructions.
   void b(Label* label, Condition cond = AL);
   void bl(Label* label, Condition cond = AL);
@@ -609,6 +628,17 @@ class ArmAssembler FINAL : public Assembler {
                   DRegister dn,
                   DRegister dm);
 
+  void EmitNeonLoadStore(int32_t opcode,
+                         NeonElementSize size,
+                         QRegister qd,
+                         Register rn);
+
+  void EmitNeonQqq(int32_t opcode,
+                   NeonElementSize size,
+                   QRegister qd,
+                   QRegister qn,
+                   QRegister qm);
+
   void EmitVFPsd(Condition cond,
                  int32_t opcode,
                  SRegister sd,
@@ -100,6 +100,23 @@ enum DRegister {
 std::ostream& operator<<(std::ostream& os, const DRegister& rhs);
 
 
+// Values for the quad-word registers of the Advanced SIMD (NEON) extension.
+// Qn overlaps D(2n) and D(2n+1); only the ones overlapping the VFPv3-D16
+// registers are listed.
+enum QRegister {
+  Q0 = 0,
+  Q1 = 1,
+  Q2 = 2,
+  Q3 = 3,
+  Q4 = 4,
+  Q5 = 5,
+  Q6 = 6,
+  Q7 = 7,
+  kNumberOfQRegisters = 8,
+  kNoQRegister = -1,
+};
+
+
 // Values for the condition field as defined in section A3.2.
 enum Condition {
   kNoCondition = -1,
@@ -19,6 +19,7 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "base/mutex.h"
 #include "base/stl_util.h"
@@ -28,7 +29,8 @@ namespace art {
 
 // A set of Keys that support a HashFunc returning HashType. Used to find duplicates of Key in the
 // Add method. The data-structure is thread-safe through the use of internal locks, it also
-// supports the lock being sharded.
+// supports the lock being sharded. kShard is the default number of shards, a set may be given
+// another one when created, to scale with the number of threads adding to it.
 template <typename Key, typename HashType, typename HashFunc, HashType kShard = 1>
 class DedupeSet {
   typedef std::pair<HashType, Key*> HashedKey;
@@ -47,8 +49,8 @@ class DedupeSet {
  public:
   Key* Add(Thread* self, const Key& key) {
     HashType raw_hash = HashFunc()(key);
-    HashType shard_hash = raw_hash / kShard;
-    HashType shard_bin = raw_hash % kShard;
+    HashType shard_hash = raw_hash / num_shards_;
+    HashType shard_bin = raw_hash % num_shards_;
     HashedKey hashed_key(shard_hash, const_cast<Key*>(&key));
     MutexLock lock(self, *lock_[shard_bin]);
     auto it = keys_[shard_bin].find(hashed_key);
@@ -60,8 +62,10 @@ class DedupeSet {
     return hashed_key.second;
   }
 
-  explicit DedupeSet(const char* set_name) {
-    for (HashType i = 0; i < kShard; ++i) {
+  explicit DedupeSet(const char* set_name, HashType num_shards = kShard)
+      : num_shards_(num_shards), lock_name_(num_shards), lock_(num_shards), keys_(num_shards) {
+    DCHECK_NE(num_shards, 0U);
+    for (HashType i = 0; i < num_shards_; ++i) {
       std::ostringstream oss;
       oss << set_name << " lock " << i;
       lock_name_[i] = oss.str();
@@ -70,15 +74,24 @@ class DedupeSet {
   }
 
   ~DedupeSet() {
-    for (HashType i = 0; i < kShard; ++i) {
+    for (HashType i = 0; i < num_shards_; ++i) {
+      STLDeleteValues(&keys_[i]);
+    }
+  }
+
+  // Frees the keys, none of those Add returned may be used anymore.
+  void Clear(Thread* self) {
+    for (HashType i = 0; i < num_shards_; ++i) {
+      MutexLock lock(self, *lock_[i]);
       STLDeleteValues(&keys_[i]);
     }
   }
 
  private:
-  std::string lock_name_[kShard];
-  std::unique_ptr<Mutex> lock_[kShard];
-  std::set<HashedKey, Comparator> keys_[kShard];
+  const HashType num_shards_;
+  std::vector<std::string> lock_name_;
+  std::vector<std::unique_ptr<Mutex>> lock_;
+  std::vector<std::set<HashedKey, Comparator>> keys_;
 
   DISALLOW_COPY_AND_ASSIGN(DedupeSet);
 };
@@ -72,4 +72,20 @@ TEST(DedupeSetTest, Test) {
   }
 }
 
+TEST(DedupeSetTest, Shards) {
+  Thread* self = Thread::Current();
+  typedef std::vector<uint8_t> ByteArray;
+  DedupeSet<ByteArray, size_t, DedupeHashFunc> deduplicator("test", 16);
+  std::vector<ByteArray*> added;
+  for (uint8_t i = 0; i < 64; ++i) {
+    ByteArray test(3, i);
+    added.push_back(deduplicator.Add(self, test));
+    ASSERT_EQ(test, *added.back());
+  }
+  for (uint8_t i = 0; i < 64; ++i) {
+    ByteArray test(3, i);
+    ASSERT_EQ(added[i], deduplicator.Add(self, test));
+  }
+}
+
 }  // namespace art
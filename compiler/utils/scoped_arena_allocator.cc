@@ -53,6 +53,15 @@ MemStats ArenaStack::GetPeakStats() const {
                   bottom_arena_);
 }
 
+size_t ArenaStack::PeakBytesUsed() {
+  UpdateBytesAllocated();
+  size_t total = 0u;
+  for (const Arena* cur_arena = bottom_arena_; cur_arena != nullptr; cur_arena = cur_arena->next_) {
+    total += cur_arena->bytes_allocated_;
+  }
+  return total;
+}
+
 uint8_t* ArenaStack::AllocateFromNextArena(size_t rounded_bytes) {
   UpdateBytesAllocated();
   size_t allocation_size = std::max(Arena::kDefaultSize, rounded_bytes);
@@ -45,6 +45,10 @@ class ArenaStack : private DebugStackRefCounter {
 
   MemStats GetPeakStats() const;
 
+  // The sum of the highest use of each arena, at least the peak of the bytes allocated so far.
+  // Unlike PeakBytesAllocated(), this does not depend on kArenaAllocatorCountAllocations.
+  size_t PeakBytesUsed();
+
  private:
   struct Peak;
   struct Current;
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_UTILS_SCOPED_ARENA_HASH_MAP_H_
+#define ART_COMPILER_UTILS_SCOPED_ARENA_HASH_MAP_H_
+
+#include <type_traits>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "utils.h"
+#include "utils/scoped_arena_allocator.h"
+
+namespace art {
+
+// A hash map with integral keys, using open addressing with linear probing in a single table
+// allocated from a ScopedArenaAllocator. A lookup is a multiplication and, usually, a single
+// cache line, where a ScopedArenaSafeMap chases a pointer per level of its tree.
+//
+// The table doubles when it is 3/4 full. The old table is not freed until the allocator is.
+template <typename K, typename V>
+class ScopedArenaHashMap {
+  static_assert(std::is_integral<K>::value, "ScopedArenaHashMap needs integral keys");
+
+ public:
+  explicit ScopedArenaHashMap(ScopedArenaAllocator* allocator, size_t initial_capacity = 16u)
+      : allocator_(allocator),
+        entries_(nullptr),
+        capacity_(0u),
+        hash_shift_(0u),
+        size_(0u) {
+    size_t capacity = 8u;
+    while (capacity < initial_capacity) {
+      capacity *= 2u;
+    }
+    Allocate(capacity);
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0u;
+  }
+
+  // Returns the value of the key, or nullptr if the map does not contain it.
+  V* Find(K key) {
+    Entry* entry = &entries_[FindSlot(key)];
+    return entry->used ? &entry->value : nullptr;
+  }
+
+  const V* Find(K key) const {
+    const Entry* entry = &entries_[FindSlot(key)];
+    return entry->used ? &entry->value : nullptr;
+  }
+
+  // Adds a key that the map does not contain.
+  void Put(K key, const V& value) {
+    DCHECK(Find(key) == nullptr);
+    Overwrite(key, value);
+  }
+
+  // Adds the key or replaces its value.
+  void Overwrite(K key, const V& value) {
+    Entry* entry = &entries_[FindSlot(key)];
+    if (!entry->used) {
+      if (size_ + 1u > capacity_ / 4u * 3u) {
+        Grow();
+        entry = &entries_[FindSlot(key)];
+      }
+      entry->key = key;
+      entry->used = true;
+      ++size_;
+    }
+    entry->value = value;
+  }
+
+  // Removes the key if the map contains it.
+  void Erase(K key) {
+    size_t slot = FindSlot(key);
+    if (!entries_[slot].used) {
+      return;
+    }
+    // Shift back the entries of the probe sequence that follows so that no lookup can stop at
+    // the empty slot before reaching its key.
+    size_t mask = capacity_ - 1u;
+    size_t next = slot;
+    while (true) {
+      next = (next + 1u) & mask;
+      if (!entries_[next].used) {
+        break;
+      }
+      size_t home = HomeSlot(entries_[next].key);
+      // Move the entry to the empty slot unless its home lies cyclically in (slot, next].
+      bool keep = (slot <= next) ? (slot < home && home <= next) : (slot < home || home <= next);
+      if (!keep) {
+        entries_[slot] = entries_[next];
+        slot = next;
+      }
+    }
+    entries_[slot].used = false;
+    --size_;
+  }
+
+  void Clear() {
+    for (size_t i = 0u; i != capacity_; ++i) {
+      entries_[i].used = false;
+    }
+    size_ = 0u;
+  }
+
+ private:
+  struct Entry {
+    K key;
+    V value;
+    bool used;
+  };
+
+  size_t HomeSlot(K key) const {
+    // Fibonacci hashing: the high bits of the product depend on all bits of the key.
+    uint64_t hash = static_cast<uint64_t>(key) * UINT64_C(0x9e3779b97f4a7c15);
+    return static_cast<size_t>(hash >> hash_shift_);
+  }
+
+  size_t FindSlot(K key) const {
+    size_t mask = capacity_ - 1u;
+    size_t slot = HomeSlot(key);
+    while (entries_[slot].used && entries_[slot].key != key) {
+      slot = (slot + 1u) & mask;
+    }
+    return slot;
+  }
+
+  void Allocate(size_t capacity) {
+    DCHECK_EQ(capacity & (capacity - 1u), 0u);
+    entries_ = static_cast<Entry*>(allocator_->Alloc(sizeof(Entry) * capacity, kArenaAllocSTL));
+    capacity_ = capacity;
+    hash_shift_ = 64u - CTZ(capacity);
+    for (size_t i = 0u; i != capacity; ++i) {
+      entries_[i].used = false;
+    }
+  }
+
+  void Grow() {
+    Entry* old_entries = entries_;
+    size_t old_capacity = capacity_;
+    Allocate(old_capacity * 2u);
+    for (size_t i = 0u; i != old_capacity; ++i) {
+      if (old_entries[i].used) {
+        entries_[FindSlot(old_entries[i].key)] = old_entries[i];
+      }
+    }
+  }
+
+  ScopedArenaAllocator* const allocator_;
+  Entry* entries_;
+  size_t capacity_;
+  size_t hash_shift_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedArenaHashMap);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_UTILS_SCOPED_ARENA_HASH_MAP_H_
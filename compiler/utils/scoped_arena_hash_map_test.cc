@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+
+#include "gtest/gtest.h"
+#include "utils/scoped_arena_hash_map.h"
+
+namespace art {
+
+TEST(ScopedArenaHashMap, Basics) {
+  ArenaPool pool;
+  ArenaStack arena_stack(&pool);
+  ScopedArenaAllocator allocator(&arena_stack);
+  ScopedArenaHashMap<uint64_t, uint16_t> map(&allocator);
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.Find(1u) == nullptr);
+  map.Put(1u, 10u);
+  map.Put(UINT64_C(0xffff000000000000), 20u);
+  ASSERT_TRUE(map.Find(1u) != nullptr);
+  EXPECT_EQ(10u, *map.Find(1u));
+  EXPECT_EQ(20u, *map.Find(UINT64_C(0xffff000000000000)));
+  map.Overwrite(1u, 11u);
+  EXPECT_EQ(11u, *map.Find(1u));
+  EXPECT_EQ(2u, map.size());
+  map.Erase(1u);
+  EXPECT_TRUE(map.Find(1u) == nullptr);
+  EXPECT_EQ(1u, map.size());
+  map.Clear();
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(ScopedArenaHashMap, GrowAndErase) {
+  ArenaPool pool;
+  ArenaStack arena_stack(&pool);
+  ScopedArenaAllocator allocator(&arena_stack);
+  ScopedArenaHashMap<uint32_t, uint32_t> map(&allocator);
+  std::map<uint32_t, uint32_t> expected;
+  // Keys differing only in their high bits, and erasures in the middle of probe sequences.
+  for (uint32_t i = 0u; i != 1000u; ++i) {
+    uint32_t key = (i % 7u == 0u) ? (i << 20) : i * 3u;
+    map.Overwrite(key, i);
+    expected[key] = i;
+    if (i % 3u == 0u) {
+      uint32_t erased_key = (i / 2u) * 3u;
+      map.Erase(erased_key);
+      expected.erase(erased_key);
+    }
+  }
+  EXPECT_EQ(expected.size(), map.size());
+  for (uint32_t key = 0u; key != 3000u; ++key) {
+    auto it = expected.find(key);
+    const uint32_t* value = map.Find(key);
+    if (it == expected.end()) {
+      EXPECT_TRUE(value == nullptr) << key;
+    } else {
+      ASSERT_TRUE(value != nullptr) << key;
+      EXPECT_EQ(it->second, *value);
+    }
+  }
+  for (const auto& entry : expected) {
+    ASSERT_TRUE(map.Find(entry.first) != nullptr) << entry.first;
+    EXPECT_EQ(entry.second, *map.Find(entry.first));
+  }
+}
+
+}  // namespace art
@@ -120,6 +120,30 @@ TEST_F(AssemblerX86_64Test, CmpqRegs) {
   DriverStr(RepeatRR(&x86_64::X86_64Assembler::cmpq, "cmpq %{reg2}, %{reg1}"), "cmpq");
 }
 
+TEST_F(AssemblerX86_64Test, CmpqImm) {
+  DriverStr(RepeatRI(&x86_64::X86_64Assembler::cmpq, 4U, "cmpq ${imm}, %{reg}"), "cmpqi");
+}
+
+
+TEST_F(AssemblerX86_64Test, TestqRegs) {
+  DriverStr(RepeatRR(&x86_64::X86_64Assembler::testq, "testq %{reg2}, %{reg1}"), "testq");
+}
+
+
+TEST_F(AssemblerX86_64Test, ImulqRegs) {
+  DriverStr(RepeatRR(&x86_64::X86_64Assembler::imulq, "imulq %{reg2}, %{reg1}"), "imulq");
+}
+
+
+TEST_F(AssemblerX86_64Test, IdivqRegs) {
+  DriverStr(RepeatR(&x86_64::X86_64Assembler::idivq, "idivq %{reg}"), "idivq");
+}
+
+
+TEST_F(AssemblerX86_64Test, NegqRegs) {
+  DriverStr(RepeatR(&x86_64::X86_64Assembler::negq, "negq %{reg}"), "negq");
+}
+
 
 TEST_F(AssemblerX86_64Test, XorqImm) {
   DriverStr(RepeatRI(&x86_64::X86_64Assembler::xorq, 4U, "xorq ${imm}, %{reg}"), "xorqi");
@@ -200,4 +224,29 @@ TEST_F(AssemblerX86_64Test, SetCC) {
   DriverFn(&setcc_test_fn, "setcc");
 }
 
+
+std::string shll_test_fn(x86_64::X86_64Assembler* assembler) {
+  // The shifts operate on the 32-bit registers, and need a REX prefix for R8 to R15.
+  std::string regs[16] = { "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+                           "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d" };
+
+  std::ostringstream str;
+
+  for (int i = 0; i < 16; ++i) {
+    x86_64::CpuRegister reg(static_cast<x86_64::Register>(i));
+    assembler->shll(reg, x86_64::Immediate(1));
+    str << "shll $1, %" << regs[i] << "\n";
+    assembler->shll(reg, x86_64::Immediate(7));
+    str << "shll $7, %" << regs[i] << "\n";
+    assembler->shll(reg, x86_64::CpuRegister(x86_64::RCX));
+    str << "shll %cl, %" << regs[i] << "\n";
+  }
+
+  return str.str();
+}
+
+TEST_F(AssemblerX86_64Test, ShllRegs) {
+  DriverFn(&shll_test_fn, "shll");
+}
+
 }  // namespace art
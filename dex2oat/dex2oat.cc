@@ -49,6 +49,7 @@
 #include "mirror/class_loader.h"
 #include "mirror/object-inl.h"
 #include "mirror/object_array-inl.h"
+#include "oat_file.h"
 #include "oat_writer.h"
 #include "object_utils.h"
 #include "os.h"
@@ -146,6 +147,9 @@ static void Usage(const char* fmt, ...) {
   UsageError("");
   UsageError("  --instruction-set-features=...,: Specify instruction set features");
   UsageError("      Example: --instruction-set-features=div");
+  UsageError("      ARM: div, lpae, neon, vfpv4, crypto. x86: ssse3, sse4.1, sse4.2, popcnt, avx.");
+  UsageError("      A 'no' prefix turns a feature off, e.g. nodiv.");
+  UsageError("      cortex-a7, cortex-a9 or cortex-a15 schedules the code for that ARM core.");
   UsageError("      Default: default");
   UsageError("");
   UsageError("  --compiler-backend=(Quick|Optimizing|Portable): select compiler backend");
@@ -196,14 +200,64 @@ static void Usage(const char* fmt, ...) {
   UsageError("");
   UsageError("  --host: used with Portable backend to link against host runtime libraries");
   UsageError("");
+  UsageError("  --portable-vectorize: used with Portable backend to run the LLVM loop and SLP");
+  UsageError("      vectorizers, for compute heavy code.");
+  UsageError("");
+  UsageError("  --dedupe-shards=<count>: the number of shards of the sets deduplicating the");
+  UsageError("      compiled code and tables. Default: four per compiler thread.");
+  UsageError("");
+  UsageError("  --pin-compiler-threads: pin each compiler thread to a CPU, filling a NUMA node");
+  UsageError("      before using the next one.");
+  UsageError("");
+  UsageError("  --conditional-card-marks: test a card before marking it, so that stores to");
+  UsageError("      objects whose card is already dirty don't write the card table. This cuts");
+  UsageError("      the cache line sharing between cores storing to nearby objects.");
+  UsageError("");
+  UsageError("  --gen-mini-debug-info: emit a symbol for each compiled method and trampoline and");
+  UsageError("      the call frame information, compressed, instead of the full debug sections.");
+  UsageError("      This is enough to unwind and symbolize native stacks when profiling.");
+  UsageError("");
   UsageError("  --dump-timing: display a breakdown of where time was spent");
   UsageError("");
+  UsageError("  --dump-passes: display the time of the compiler phases, and the time, arena");
+  UsageError("      memory and MIRs of each optimization pass, summed over all methods");
+  UsageError("");
+  UsageError("  --dump-method-stats=<file>: write the compile time in ns, the peak arena memory");
+  UsageError("      and the code size of each compiled method to the file, a line per method");
+  UsageError("      sorted by method name, to compare compiler changes on the same dex files.");
+  UsageError("      Example: --dump-method-stats=/tmp/method-stats.txt");
+  UsageError("");
   UsageError("  --runtime-arg <argument>: used to specify various arguments for the runtime,");
   UsageError("      such as initial heap size, maximum heap size, and verbose output.");
   UsageError("      Use a separate --runtime-arg switch for each argument.");
   UsageError("      Example: --runtime-arg -Xms256m");
   UsageError("");
   UsageError("  --profile-file=<filename>: specify profiler output file to use for compilation.");
+  UsageError("      The oat file then lays out the code and maps of the hot methods first.");
+  UsageError("");
+  UsageError("  --layout-dex-files: with --profile-file, also lay out the copies of the dex files");
+  UsageError("      in the oat file with the code items, and the strings they use, of the methods");
+  UsageError("      in the profile first. Not supported with --image.");
+  UsageError("");
+  UsageError("  --previous-oat-file=<file.oat>: specifies a previous compilation of the dex");
+  UsageError("      files, whose code is reused for the classes that did not change. It must not");
+  UsageError("      be the output oat file.");
+  UsageError("      Example: --previous-oat-file=/tmp/app.oat.old");
+  UsageError("");
+  UsageError("  --compilation-cache-dir=<directory>: specifies a directory where the Quick code");
+  UsageError("      of methods is cached, to be shared by compilations of the same dex files.");
+  UsageError("      Example: --compilation-cache-dir=/tmp/dex2oat-cache");
+  UsageError("");
+  UsageError("  --compile-time-budget=<milliseconds>: stop compiling methods, leaving the rest");
+  UsageError("      to the interpreter, once this wall-clock time has passed since the start of");
+  UsageError("      the compilation. Methods are compiled by decreasing profile hotness.");
+  UsageError("      Example: --compile-time-budget=20000");
+  UsageError("      Default: no budget");
+  UsageError("");
+  UsageError("  --compile-cpu-time-budget=<milliseconds>: like --compile-time-budget, for the");
+  UsageError("      CPU time spent compiling methods, summed over the compiler threads.");
+  UsageError("      Example: --compile-cpu-time-budget=60000");
+  UsageError("      Default: no budget");
   UsageError("");
   UsageError("  --print-pass-names: print a list of pass names");
   UsageError("");
@@ -320,7 +374,12 @@ class Dex2Oat {
                                       bool dump_passes,
                                       TimingLogger& timings,
                                       CumulativeLogger& compiler_phases_timings,
-                                      std::string profile_file) {
+                                      std::string profile_file,
+                                      const std::string& previous_oat_filename,
+                                      const std::string& compilation_cache_dir,
+                                      int compile_time_budget_ms,
+                                      int compile_cpu_time_budget_ms,
+                                      bool method_stats) {
     // Handle and ClassLoader creation needs to come after Runtime::Create
     jobject class_loader = nullptr;
     Thread* self = Thread::Current();
@@ -355,6 +414,32 @@ class Dex2Oat {
 
     driver->GetCompiler()->SetBitcodeFileName(*driver.get(), bitcode_filename);
 
+    if (!previous_oat_filename.empty()) {
+      std::string error_msg;
+      OatFile* previous_oat_file = OatFile::Open(previous_oat_filename, previous_oat_filename,
+                                                 nullptr, false, &error_msg);
+      if (previous_oat_file == nullptr) {
+        LOG(WARNING) << "Failed to open previous oat file " << previous_oat_filename << ": "
+                     << error_msg;
+      } else {
+        driver->SetPreviousOatFile(previous_oat_file);
+      }
+    }
+    if (!compilation_cache_dir.empty()) {
+      if (compiler_kind_ != Compiler::kQuick) {
+        LOG(WARNING) << "Not using compilation cache " << compilation_cache_dir
+                     << ": only the Quick code of methods is cached";
+      } else {
+        driver->SetCompilationCacheDirectory(compilation_cache_dir);
+      }
+    }
+    if (compile_time_budget_ms != 0 || compile_cpu_time_budget_ms != 0) {
+      driver->SetCompileTimeBudget(compile_time_budget_ms, compile_cpu_time_budget_ms);
+    }
+    if (method_stats) {
+      driver->EnableMethodStats();
+    }
+
     driver->CompileAll(class_loader, dex_files, &timings);
 
     timings.NewSplit("dex2oat OatWriter");
@@ -694,6 +779,66 @@ static InstructionSetFeatures ParseFeatureList(std::string str) {
     } else if (feature == "nolpae") {
       // Turn off support for Large Physical Address Extension.
       result.SetHasLpae(false);
+    } else if (feature == "neon") {
+      // Supports the Advanced SIMD instructions.
+      result.SetHasNeon(true);
+    } else if (feature == "noneon") {
+      // Turn off support for the Advanced SIMD instructions.
+      result.SetHasNeon(false);
+    } else if (feature == "sse4.1") {
+      // Supports the SSE4.1 instructions.
+      result.SetHasSse4_1(true);
+    } else if (feature == "nosse4.1") {
+      // Turn off support for the SSE4.1 instructions.
+      result.SetHasSse4_1(false);
+    } else if (feature == "sse4.2") {
+      // Supports the SSE4.2 instructions.
+      result.SetHasSse4_2(true);
+    } else if (feature == "nosse4.2") {
+      // Turn off support for the SSE4.2 instructions.
+      result.SetHasSse4_2(false);
+    } else if (feature == "vfpv4") {
+      // Supports the VFPv4 fused multiply-accumulate instructions.
+      result.SetHasVfpv4(true);
+    } else if (feature == "novfpv4") {
+      // Turn off support for the VFPv4 fused multiply-accumulate instructions.
+      result.SetHasVfpv4(false);
+    } else if (feature == "crypto") {
+      // Supports the ARMv8 cryptography instructions.
+      result.SetHasCrypto(true);
+    } else if (feature == "nocrypto") {
+      // Turn off support for the ARMv8 cryptography instructions.
+      result.SetHasCrypto(false);
+    } else if (feature == "ssse3") {
+      // Supports the SSSE3 instructions.
+      result.SetHasSsse3(true);
+    } else if (feature == "nossse3") {
+      // Turn off support for the SSSE3 instructions.
+      result.SetHasSsse3(false);
+    } else if (feature == "popcnt") {
+      // Supports the POPCNT instruction.
+      result.SetHasPopcnt(true);
+    } else if (feature == "nopopcnt") {
+      // Turn off support for the POPCNT instruction.
+      result.SetHasPopcnt(false);
+    } else if (feature == "avx") {
+      // Supports the AVX instructions.
+      result.SetHasAvx(true);
+    } else if (feature == "noavx") {
+      // Turn off support for the AVX instructions.
+      result.SetHasAvx(false);
+    } else if (feature == "cortex-a7") {
+      // Schedule for the in-order Cortex-A7.
+      result.SetArmCpu(kArmCpuCortexA7);
+    } else if (feature == "cortex-a9") {
+      // Schedule for the Cortex-A9.
+      result.SetArmCpu(kArmCpuCortexA9);
+    } else if (feature == "cortex-a15") {
+      // Schedule for the Cortex-A15.
+      result.SetArmCpu(kArmCpuCortexA15);
+    } else if (feature == "generic") {
+      // Don't schedule for a particular core.
+      result.SetArmCpu(kArmCpuGeneric);
     } else {
       Usage("Unknown instruction set feature: '%s'", feature.c_str());
     }
@@ -754,6 +899,11 @@ static int dex2oat(int argc, char** argv) {
 
   // Profile file to use
   std::string profile_file;
+  std::string previous_oat_filename;
+  std::string compilation_cache_dir;
+  int compile_time_budget_ms = 0;
+  int compile_cpu_time_budget_ms = 0;
+  std::string method_stats_filename;
 
   bool is_host = false;
   bool dump_stats = false;
@@ -762,6 +912,12 @@ static int dex2oat(int argc, char** argv) {
   bool dump_slow_timing = kIsDebugBuild;
   bool watch_dog_enabled = !kIsTargetBuild;
   bool generate_gdb_information = kIsDebugBuild;
+  bool generate_mini_debug_info = false;
+  bool portable_vectorize = false;
+  int dedupe_shards = 0;
+  bool pin_compiler_threads = false;
+  bool conditional_card_marks = false;
+  bool layout_dex_files = false;
 
   for (int i = 0; i < argc; i++) {
     const StringPiece option(argv[i]);
@@ -803,6 +959,12 @@ static int dex2oat(int argc, char** argv) {
       generate_gdb_information = true;
     } else if (option == "--no-gen-gdb-info") {
       generate_gdb_information = false;
+    } else if (option == "--portable-vectorize") {
+      portable_vectorize = true;
+    } else if (option == "--gen-mini-debug-info") {
+      generate_mini_debug_info = true;
+    } else if (option == "--no-gen-mini-debug-info") {
+      generate_mini_debug_info = false;
     } else if (option.starts_with("-j")) {
       const char* thread_count_str = option.substr(strlen("-j")).data();
       if (!ParseInt(thread_count_str, &thread_count)) {
@@ -896,6 +1058,20 @@ static int dex2oat(int argc, char** argv) {
       if (num_dex_methods_threshold < 0) {
         Usage("--num-dex-methods passed a negative value %s", num_dex_methods_threshold);
       }
+    } else if (option.starts_with("--dedupe-shards=")) {
+      const char* shards = option.substr(strlen("--dedupe-shards=")).data();
+      if (!ParseInt(shards, &dedupe_shards)) {
+        Usage("Failed to parse --dedupe-shards '%s' as an integer", shards);
+      }
+      if (dedupe_shards <= 0) {
+        Usage("--dedupe-shards passed a non-positive value %d", dedupe_shards);
+      }
+    } else if (option == "--pin-compiler-threads") {
+      pin_compiler_threads = true;
+    } else if (option == "--conditional-card-marks") {
+      conditional_card_marks = true;
+    } else if (option == "--layout-dex-files") {
+      layout_dex_files = true;
     } else if (option == "--host") {
       is_host = true;
     } else if (option == "--runtime-arg") {
@@ -912,11 +1088,34 @@ static int dex2oat(int argc, char** argv) {
       dump_passes = true;
     } else if (option == "--dump-stats") {
       dump_stats = true;
+    } else if (option.starts_with("--dump-method-stats=")) {
+      method_stats_filename = option.substr(strlen("--dump-method-stats=")).data();
     } else if (option.starts_with("--profile-file=")) {
       profile_file = option.substr(strlen("--profile-file=")).data();
       VLOG(compiler) << "dex2oat: profile file is " << profile_file;
     } else if (option == "--no-profile-file") {
       // No profile
+    } else if (option.starts_with("--previous-oat-file=")) {
+      previous_oat_filename = option.substr(strlen("--previous-oat-file=")).data();
+    } else if (option.starts_with("--compilation-cache-dir=")) {
+      compilation_cache_dir = option.substr(strlen("--compilation-cache-dir=")).data();
+    } else if (option.starts_with("--compile-time-budget=")) {
+      const char* budget = option.substr(strlen("--compile-time-budget=")).data();
+      if (!ParseInt(budget, &compile_time_budget_ms)) {
+        Usage("Failed to parse --compile-time-budget '%s' as an integer", budget);
+      }
+      if (compile_time_budget_ms < 0) {
+        Usage("--compile-time-budget passed a negative value %d", compile_time_budget_ms);
+      }
+    } else if (option.starts_with("--compile-cpu-time-budget=")) {
+      const char* budget = option.substr(strlen("--compile-cpu-time-budget=")).data();
+      if (!ParseInt(budget, &compile_cpu_time_budget_ms)) {
+        Usage("Failed to parse --compile-cpu-time-budget '%s' as an integer", budget);
+      }
+      if (compile_cpu_time_budget_ms < 0) {
+        Usage("--compile-cpu-time-budget passed a negative value %d",
+              compile_cpu_time_budget_ms);
+      }
     } else if (option == "--print-pass-names") {
       PassDriver::PrintPassNames();
     } else if (option.starts_with("--disable-passes=")) {
@@ -978,6 +1177,14 @@ static int dex2oat(int argc, char** argv) {
     Usage("--image-classes-zip should be used with --image-classes");
   }
 
+  if (layout_dex_files && image) {
+    Usage("--layout-dex-files should not be used with --image");
+  }
+
+  if (layout_dex_files && profile_file.empty()) {
+    Usage("--layout-dex-files should be used with --profile-file");
+  }
+
   if (dex_filenames.empty() && zip_fd == -1) {
     Usage("Input must be supplied with either --dex-file or --zip-fd");
   }
@@ -1054,11 +1261,17 @@ static int dex2oat(int argc, char** argv) {
                                    small_method_threshold,
                                    tiny_method_threshold,
                                    num_dex_methods_threshold,
-                                   generate_gdb_information
+                                   generate_gdb_information,
+                                   generate_mini_debug_info
 #ifdef ART_SEA_IR_MODE
                                    , compiler_options.sea_ir_ = true;
 #endif
                                    );  // NOLINT(whitespace/parens)
+  compiler_options.SetPortableVectorize(portable_vectorize);
+  compiler_options.SetDedupeShards(dedupe_shards);
+  compiler_options.SetPinCompilerThreads(pin_compiler_threads);
+  compiler_options.SetConditionalCardMarks(conditional_card_marks);
+  compiler_options.SetLayoutDexFiles(layout_dex_files);
 
   // Done with usage checks, enable watchdog if requested
   WatchDog watch_dog(watch_dog_enabled);
@@ -1237,7 +1450,12 @@ static int dex2oat(int argc, char** argv) {
                                                                   dump_passes,
                                                                   timings,
                                                                   compiler_phases_timings,
-                                                                  profile_file));
+                                                                  profile_file,
+                                                                  previous_oat_filename,
+                                                                  compilation_cache_dir,
+                                                                  compile_time_budget_ms,
+                                                                  compile_cpu_time_budget_ms,
+                                                                  !method_stats_filename.empty()));
 
   if (compiler.get() == nullptr) {
     LOG(ERROR) << "Failed to create oat file: " << oat_location;
@@ -1246,6 +1464,15 @@ static int dex2oat(int argc, char** argv) {
 
   VLOG(compiler) << "Oat file written successfully (unstripped): " << oat_location;
 
+  if (!method_stats_filename.empty()) {
+    std::ofstream method_stats_file(method_stats_filename.c_str());
+    compiler->DumpMethodStats(method_stats_file);
+    if (method_stats_file.fail()) {
+      LOG(ERROR) << "Failed to write method stats to " << method_stats_filename;
+      return EXIT_FAILURE;
+    }
+  }
+
   // Notes on the interleaving of creating the image and oat file to
   // ensure the references between the two are correct.
   //
@@ -1315,6 +1542,7 @@ static int dex2oat(int argc, char** argv) {
     }
     if (dump_passes) {
       LOG(INFO) << Dumpable<CumulativeLogger>(*compiler.get()->GetTimingsLogger());
+      PassDriver::DumpStatistics(LOG(INFO));
     }
     return EXIT_SUCCESS;
   }
@@ -1360,6 +1588,7 @@ static int dex2oat(int argc, char** argv) {
   }
   if (dump_passes) {
     LOG(INFO) << Dumpable<CumulativeLogger>(compiler_phases_timings);
+    PassDriver::DumpStatistics(LOG(INFO));
   }
 
   // Everything was successfully written, do an explicit exit here to avoid running Runtime
@@ -17,6 +17,7 @@
 #include "disassembler.h"
 
 #include <iostream>
+#include <streambuf>
 
 #include "base/logging.h"
 #include "disassembler_arm.h"
@@ -43,4 +44,28 @@ Disassembler* Disassembler::Create(InstructionSet instruction_set) {
   }
 }
 
+// Discards what is written to it.
+class NullStreambuf : public std::streambuf {
+ protected:
+  int_type overflow(int_type c) OVERRIDE {
+    return traits_type::not_eof(c);
+  }
+};
+
+void Disassembler::Decode(const uint8_t* begin, const uint8_t* end,
+                          std::vector<DecodedInstruction>* instructions) {
+  for (const uint8_t* cur = begin; cur < end; ) {
+    DecodedInstruction instruction = { cur, GetInstructionLength(cur) };
+    DCHECK_NE(instruction.length, 0u);
+    instructions->push_back(instruction);
+    cur += instruction.length;
+  }
+}
+
+size_t Disassembler::GetInstructionLength(const uint8_t* begin) {
+  NullStreambuf null_buf;
+  std::ostream null_os(&null_buf);
+  return Dump(null_os, begin);
+}
+
 }  // namespace art
@@ -20,12 +20,20 @@
 #include <stdint.h>
 
 #include <iosfwd>
+#include <vector>
 
 #include "base/macros.h"
 #include "instruction_set.h"
 
 namespace art {
 
+// An instruction found by Disassembler::Decode(), to be formatted with Disassembler::Dump() only
+// if it is printed.
+struct DecodedInstruction {
+  const uint8_t* begin;
+  size_t length;
+};
+
 class Disassembler {
  public:
   static Disassembler* Create(InstructionSet instruction_set);
@@ -36,9 +44,21 @@ class Disassembler {
   // Dump instructions within a range.
   virtual void Dump(std::ostream& os, const uint8_t* begin, const uint8_t* end) = 0;
 
+  // Append the instructions within a range to `instructions` without formatting them, for the
+  // tools that only need their bounds or print few of them. An ARM Thumb range is given with
+  // the Thumb bit set, as to Dump(). Instructions in a Thumb IT block only get their condition
+  // when formatted after the IT instruction, by the same disassembler.
+  void Decode(const uint8_t* begin, const uint8_t* end,
+              std::vector<DecodedInstruction>* instructions);
+
  protected:
   Disassembler() {}
 
+  // Return the length of the instruction at `begin`. By default, the instruction is formatted
+  // and the text discarded; the instruction sets that can tell the length from the first bytes
+  // override this.
+  virtual size_t GetInstructionLength(const uint8_t* begin);
+
  private:
   DISALLOW_COPY_AND_ASSIGN(Disassembler);
 };
@@ -105,6 +105,17 @@ static uint32_t ReadU32(const uint8_t* ptr) {
   return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | (ptr[3] << 24);
 }
 
+size_t DisassemblerArm::GetInstructionLength(const uint8_t* begin) {
+  if ((reinterpret_cast<intptr_t>(begin) & 1) == 0) {
+    return 4;
+  }
+  // remove thumb specifier bits
+  begin = reinterpret_cast<const uint8_t*>(reinterpret_cast<uintptr_t>(begin) & ~1);
+  uint16_t instr = ReadU16(begin);
+  bool is_32bit = ((instr & 0xF000) == 0xF000) || ((instr & 0xF800) == 0xE800);
+  return is_32bit ? 4 : 2;
+}
+
 static const char* kDataProcessingOperations[] = {
   "and", "eor", "sub", "rsb", "add", "adc", "sbc", "rsc",
   "tst", "teq", "cmp", "cmn", "orr", "mov", "bic", "mvn",
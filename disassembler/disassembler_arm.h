@@ -33,6 +33,8 @@ class DisassemblerArm FINAL : public Disassembler {
   void Dump(std::ostream& os, const uint8_t* begin, const uint8_t* end) OVERRIDE;
 
  private:
+  size_t GetInstructionLength(const uint8_t* begin) OVERRIDE;
+
   void DumpArm(std::ostream& os, const uint8_t* instr);
 
   // Returns the size of the instruction just decoded
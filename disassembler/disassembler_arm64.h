@@ -35,6 +35,10 @@ class DisassemblerArm64 FINAL : public Disassembler {
   void Dump(std::ostream& os, const uint8_t* begin, const uint8_t* end) OVERRIDE;
 
  private:
+  size_t GetInstructionLength(const uint8_t* begin) OVERRIDE {
+    return vixl::kInstructionSize;
+  }
+
   vixl::Decoder decoder;
   vixl::Disassembler disasm;
 
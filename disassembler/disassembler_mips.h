@@ -33,6 +33,10 @@ class DisassemblerMips FINAL : public Disassembler {
   void Dump(std::ostream& os, const uint8_t* begin, const uint8_t* end) OVERRIDE;
 
  private:
+  size_t GetInstructionLength(const uint8_t* begin) OVERRIDE {
+    return 4;
+  }
+
   DISALLOW_COPY_AND_ASSIGN(DisassemblerMips);
 };
 
@@ -17,8 +17,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -47,6 +50,7 @@
 #include "oat_file-inl.h"
 #include "object_utils.h"
 #include "os.h"
+#include "profiler.h"
 #include "runtime.h"
 #include "safe_map.h"
 #include "scoped_thread_state_change.h"
@@ -84,6 +88,23 @@ static void usage() {
           "    Example: --dump:raw_gc_map\n"
           "    Default: neither\n"
           "\n");
+  fprintf(stderr,
+          "  --stats: instead of dumping each method of the oat file, print the bytes of code,\n"
+          "      mapping tables, vmap tables and GC maps per package and class, and how much\n"
+          "      deduplication saved.\n"
+          "\n");
+  fprintf(stderr,
+          "  --profile-file=<file>: with --stats, also split the bytes between the methods\n"
+          "      in the profile and the others.\n"
+          "      Example: --profile-file=/data/dalvik-cache/profiles/com.android.settings\n"
+          "\n");
+  fprintf(stderr,
+          "  --output-format=(text|json): with json, print the oat header and the code, frame\n"
+          "      and map offsets and sizes of each method, and for an image its header and\n"
+          "      statistics, as JSON for tools to process or diff.\n"
+          "      Example: --output-format=json\n"
+          "      Default: text\n"
+          "\n");
   exit(EXIT_FAILURE);
 }
 
@@ -98,6 +119,112 @@ const char* image_roots_descriptions_[] = {
   "kClassRoots",
 };
 
+// Writes the JSON of --output-format=json, one value per line so that the output of two oat files
+// diffs well. The caller nests the objects and arrays, the writer adds the separators and escapes
+// the strings.
+class JsonWriter {
+ public:
+  explicit JsonWriter(std::ostream& os) : os_(os), depth_(0), first_(true) {}
+
+  // Begins an object, named if it is a field of the enclosing object.
+  void BeginObject(const char* name = nullptr) {
+    Begin(name, '{');
+  }
+
+  void EndObject() {
+    End('}');
+  }
+
+  void BeginArray(const char* name) {
+    Begin(name, '[');
+  }
+
+  void EndArray() {
+    End(']');
+  }
+
+  void StringField(const char* name, const std::string& value) {
+    Name(name);
+    WriteString(value);
+  }
+
+  template <typename T>
+  void NumberField(const char* name, T value) {
+    Name(name);
+    os_ << value;
+  }
+
+  void BoolField(const char* name, bool value) {
+    Name(name);
+    os_ << (value ? "true" : "false");
+  }
+
+ private:
+  void Name(const char* name) {
+    if (!first_) {
+      os_ << ",";
+    }
+    first_ = false;
+    os_ << "\n" << std::string(depth_ * kIndentBy1Count, kIndentChar);
+    if (name != nullptr) {
+      WriteString(name);
+      os_ << ": ";
+    }
+  }
+
+  void Begin(const char* name, char c) {
+    if (depth_ != 0) {
+      Name(name);
+    }
+    os_ << c;
+    ++depth_;
+    first_ = true;
+  }
+
+  void End(char c) {
+    CHECK_NE(depth_, 0u);
+    --depth_;
+    if (!first_) {
+      os_ << "\n" << std::string(depth_ * kIndentBy1Count, kIndentChar);
+    }
+    os_ << c;
+    first_ = false;
+    if (depth_ == 0) {
+      os_ << "\n" << std::flush;
+    }
+  }
+
+  void WriteString(const std::string& s) {
+    os_ << '"';
+    for (char c : s) {
+      if (c == '"' || c == '\\') {
+        os_ << '\\' << c;
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        os_ << StringPrintf("\\u%04x", c);
+      } else {
+        os_ << c;
+      }
+    }
+    os_ << '"';
+  }
+
+  std::ostream& os_;
+  size_t depth_;
+  // Whether the current object or array has no value yet.
+  bool first_;
+
+  DISALLOW_COPY_AND_ASSIGN(JsonWriter);
+};
+
+// Discards what is written to it: with --output-format=json, the image is still walked as for the
+// text output, to compute its statistics, but that text is not printed.
+class NullStreambuf : public std::streambuf {
+ protected:
+  int_type overflow(int_type c) {
+    return traits_type::not_eof(c);
+  }
+};
+
 class OatDumper {
  public:
   explicit OatDumper(const OatFile& oat_file, bool dump_raw_mapping_table, bool dump_raw_gc_map)
@@ -124,6 +251,9 @@ class OatDumper {
     os << "INSTRUCTION SET FEATURES:\n";
     os << oat_header.GetInstructionSetFeatures().GetFeatureString() << "\n\n";
 
+    os << "COMPILER OPTIONS CHECKSUM:\n";
+    os << StringPrintf("0x%08x\n\n", oat_header.GetCompilerOptionsChecksum());
+
     os << "DEX FILE COUNT:\n";
     os << oat_header.GetDexFileCount() << "\n\n";
 
@@ -158,6 +288,14 @@ class OatDumper {
                            GetQuickToInterpreterBridgeOffset);
 #undef DUMP_OAT_HEADER_OFFSET
 
+    os << "STARTUP MAPS:\n";
+    os << StringPrintf("0x%08x-0x%08x\n\n", oat_header.GetStartupMapsOffset(),
+                       oat_header.GetStartupMapsOffset() + oat_header.GetStartupMapsSize());
+
+    os << "STARTUP CODE:\n";
+    os << StringPrintf("0x%08x-0x%08x\n\n", oat_header.GetStartupCodeOffset(),
+                       oat_header.GetStartupCodeOffset() + oat_header.GetStartupCodeSize());
+
     os << "IMAGE FILE LOCATION OAT CHECKSUM:\n";
     os << StringPrintf("0x%08x\n\n", oat_header.GetImageFileLocationOatChecksum());
 
@@ -184,6 +322,175 @@ class OatDumper {
     }
   }
 
+  // Print where the bytes of the oat file go: the code and maps of the methods, summed per package
+  // and class, with how many of them are shared between methods by deduplication. The shared
+  // data is attributed to the first method that uses it. Given a profile, also split the bytes
+  // between the methods in it and the others.
+  void DumpStatistics(std::ostream& os, const ProfileMap* profile) {
+    std::set<uint32_t> seen_offsets;
+    SizeStats total;
+    SizeStats hot;
+    SizeStats cold;
+    DedupeStats dedupe[kNumDataKinds];
+    std::map<std::string, SizeStats> packages;
+    std::map<std::string, SizeStats> classes;
+    size_t dex_file_bytes = 0u;
+    size_t methods = 0u;
+    for (const OatFile::OatDexFile* oat_dex_file : oat_dex_files_) {
+      std::string error_msg;
+      std::unique_ptr<const DexFile> dex_file(oat_dex_file->OpenDexFile(&error_msg));
+      if (dex_file.get() == nullptr) {
+        LOG(WARNING) << "Failed to open dex file '" << oat_dex_file->GetDexFileLocation()
+            << "': " << error_msg;
+        continue;
+      }
+      dex_file_bytes += dex_file->GetHeader().file_size_;
+      for (size_t class_def_index = 0;
+           class_def_index < dex_file->NumClassDefs();
+           class_def_index++) {
+        const DexFile::ClassDef& class_def = dex_file->GetClassDef(class_def_index);
+        const OatFile::OatClass oat_class = oat_dex_file->GetOatClass(class_def_index);
+        const byte* class_data = dex_file->GetClassData(class_def);
+        if (class_data == nullptr) {
+          continue;
+        }
+        SizeStats class_stats;
+        ClassDataItemIterator it(*dex_file, class_data);
+        SkipAllFields(it);
+        for (uint32_t class_method_index = 0; it.HasNextDirectMethod() || it.HasNextVirtualMethod();
+             class_method_index++, it.Next()) {
+          ++methods;
+          SizeStats method_stats;
+          AddMethodSizes(oat_class.GetOatMethod(class_method_index), &seen_offsets,
+                         &method_stats, dedupe);
+          class_stats.Add(method_stats);
+          if (profile != nullptr) {
+            bool is_hot = profile->find(PrettyMethod(it.GetMemberIndex(), *dex_file)) !=
+                profile->end();
+            (is_hot ? &hot : &cold)->Add(method_stats);
+          }
+        }
+        std::string descriptor = PrettyDescriptor(dex_file->GetClassDescriptor(class_def));
+        size_t last_dot = descriptor.rfind('.');
+        std::string package =
+            (last_dot == std::string::npos) ? "(default)" : descriptor.substr(0, last_dot);
+        packages[package].Add(class_stats);
+        classes[descriptor].Add(class_stats);
+        total.Add(class_stats);
+      }
+    }
+
+    size_t file_bytes = oat_file_.Size();
+    os << "OAT FILE STATISTICS:\n";
+    os << StringPrintf("file: %zd bytes\n", file_bytes);
+    os << StringPrintf("dex files: %zd bytes (%.1f%%)\n", dex_file_bytes,
+                       Percentage(dex_file_bytes, file_bytes));
+    for (size_t kind = 0; kind != kNumDataKinds; ++kind) {
+      DataKind data_kind = static_cast<DataKind>(kind);
+      size_t bytes = total.Get(data_kind);
+      os << StringPrintf("%s: %zd bytes (%.1f%%)\n", GetDataKindName(data_kind), bytes,
+                         Percentage(bytes, file_bytes));
+    }
+    size_t other_bytes = file_bytes - std::min(file_bytes, dex_file_bytes + total.Total());
+    os << StringPrintf("other (headers, oat classes, trampolines, alignment): %zd bytes (%.1f%%)\n",
+                       other_bytes, Percentage(other_bytes, file_bytes));
+    os << StringPrintf("methods: %zd, with code: %zd\n\n", methods, total.methods);
+
+    os << "DEDUPLICATION:\n";
+    for (size_t kind = 0; kind != kNumDataKinds; ++kind) {
+      const DedupeStats& stats = dedupe[kind];
+      os << StringPrintf("%s: %zd of %zd shared (%.1f%%), saving %zd bytes\n",
+                         GetDataKindName(static_cast<DataKind>(kind)), stats.shared, stats.uses,
+                         Percentage(stats.shared, stats.uses), stats.saved_bytes);
+    }
+    os << "\n";
+
+    if (profile != nullptr) {
+      os << "PROFILE:\n";
+      DumpSizeStatsHeader(os);
+      DumpSizeStats(os, "in profile", hot, total.Total());
+      DumpSizeStats(os, "not in profile", cold, total.Total());
+      os << "\n";
+    }
+
+    os << "PACKAGES:\n";
+    DumpSizeStatsHeader(os);
+    DumpLargest(os, packages, packages.size(), total.Total());
+    os << "\n";
+
+    os << StringPrintf("CLASSES (largest %zd):\n", kMaxClassesDumped);
+    DumpSizeStatsHeader(os);
+    DumpLargest(os, classes, kMaxClassesDumped, total.Total());
+    os << std::flush;
+  }
+
+  // Write the oat header and, for each method, its code and frame layout and where its maps are,
+  // as the fields of the object `writer` is in. Only offsets into the oat file are written, not
+  // addresses, so that the output doesn't depend on where the file was loaded.
+  void DumpJson(JsonWriter* writer) {
+    const OatHeader& oat_header = oat_file_.GetOatHeader();
+    writer->BeginObject("header");
+    writer->StringField("magic", oat_header.GetMagic());
+    writer->NumberField("checksum", oat_header.GetChecksum());
+    writer->StringField("instruction_set", ToStr<InstructionSet>(GetInstructionSet()).str());
+    writer->StringField("instruction_set_features",
+                        oat_header.GetInstructionSetFeatures().GetFeatureString());
+    writer->NumberField("dex_file_count", oat_header.GetDexFileCount());
+#define DUMP_OAT_HEADER_OFFSET(name, offset) \
+    writer->NumberField(name "_offset", oat_header.offset());
+    DUMP_OAT_HEADER_OFFSET("executable", GetExecutableOffset);
+    DUMP_OAT_HEADER_OFFSET("interpreter_to_interpreter_bridge",
+                           GetInterpreterToInterpreterBridgeOffset);
+    DUMP_OAT_HEADER_OFFSET("interpreter_to_compiled_code_bridge",
+                           GetInterpreterToCompiledCodeBridgeOffset);
+    DUMP_OAT_HEADER_OFFSET("jni_dlsym_lookup", GetJniDlsymLookupOffset);
+    DUMP_OAT_HEADER_OFFSET("portable_imt_conflict_trampoline",
+                           GetPortableImtConflictTrampolineOffset);
+    DUMP_OAT_HEADER_OFFSET("portable_resolution_trampoline",
+                           GetPortableResolutionTrampolineOffset);
+    DUMP_OAT_HEADER_OFFSET("portable_to_interpreter_bridge",
+                           GetPortableToInterpreterBridgeOffset);
+    DUMP_OAT_HEADER_OFFSET("quick_generic_jni_trampoline", GetQuickGenericJniTrampolineOffset);
+    DUMP_OAT_HEADER_OFFSET("quick_imt_conflict_trampoline", GetQuickImtConflictTrampolineOffset);
+    DUMP_OAT_HEADER_OFFSET("quick_resolution_trampoline", GetQuickResolutionTrampolineOffset);
+    DUMP_OAT_HEADER_OFFSET("quick_to_interpreter_bridge", GetQuickToInterpreterBridgeOffset);
+    DUMP_OAT_HEADER_OFFSET("startup_maps", GetStartupMapsOffset);
+    DUMP_OAT_HEADER_OFFSET("startup_code", GetStartupCodeOffset);
+#undef DUMP_OAT_HEADER_OFFSET
+    writer->NumberField("startup_maps_size", oat_header.GetStartupMapsSize());
+    writer->NumberField("startup_code_size", oat_header.GetStartupCodeSize());
+    writer->NumberField("image_file_location_oat_checksum",
+                        oat_header.GetImageFileLocationOatChecksum());
+    writer->NumberField("image_file_location_oat_begin",
+                        oat_header.GetImageFileLocationOatDataBegin());
+    writer->StringField("image_file_location", oat_header.GetImageFileLocation());
+    writer->NumberField("file_size", oat_file_.Size());
+    writer->EndObject();
+
+    writer->BeginArray("dex_files");
+    for (const OatFile::OatDexFile* oat_dex_file : oat_dex_files_) {
+      CHECK(oat_dex_file != nullptr);
+      writer->BeginObject();
+      writer->StringField("location", oat_dex_file->GetDexFileLocation());
+      writer->NumberField("checksum", oat_dex_file->GetDexFileLocationChecksum());
+      std::string error_msg;
+      std::unique_ptr<const DexFile> dex_file(oat_dex_file->OpenDexFile(&error_msg));
+      if (dex_file.get() == nullptr) {
+        writer->StringField("error", error_msg);
+      } else {
+        writer->BeginArray("classes");
+        for (size_t class_def_index = 0;
+             class_def_index < dex_file->NumClassDefs();
+             class_def_index++) {
+          DumpOatClassJson(writer, *oat_dex_file, *dex_file, class_def_index);
+        }
+        writer->EndArray();
+      }
+      writer->EndObject();
+    }
+    writer->EndArray();
+  }
+
   size_t ComputeSize(const void* oat_data) {
     if (reinterpret_cast<const byte*>(oat_data) < oat_file_.Begin() ||
         reinterpret_cast<const byte*>(oat_data) > oat_file_.End()) {
@@ -226,6 +533,133 @@ class OatDumper {
   }
 
  private:
+  enum DataKind {
+    kCode,
+    kMappingTable,
+    kVmapTable,
+    kGcMap,
+    kNumDataKinds
+  };
+
+  static const char* GetDataKindName(DataKind kind) {
+    switch (kind) {
+      case kCode: return "code";
+      case kMappingTable: return "mapping tables";
+      case kVmapTable: return "vmap tables";
+      case kGcMap: return "gc maps";
+      default: LOG(FATAL) << "Unexpected data kind " << static_cast<int>(kind); return nullptr;
+    }
+  }
+
+  static constexpr size_t kMaxClassesDumped = 50u;
+
+  // The bytes of the code and maps of a set of methods.
+  struct SizeStats {
+    SizeStats() : methods(0u) {
+      std::fill_n(bytes, static_cast<size_t>(kNumDataKinds), 0u);
+    }
+
+    size_t Get(DataKind kind) const {
+      return bytes[kind];
+    }
+
+    size_t Total() const {
+      return bytes[kCode] + bytes[kMappingTable] + bytes[kVmapTable] + bytes[kGcMap];
+    }
+
+    void Add(const SizeStats& other) {
+      methods += other.methods;
+      for (size_t kind = 0; kind != kNumDataKinds; ++kind) {
+        bytes[kind] += other.bytes[kind];
+      }
+    }
+
+    size_t methods;  // The methods with code.
+    size_t bytes[kNumDataKinds];
+  };
+
+  // How many of the uses of a kind of data by the methods are of data already used by another.
+  struct DedupeStats {
+    DedupeStats() : uses(0u), shared(0u), saved_bytes(0u) { }
+
+    size_t uses;
+    size_t shared;
+    size_t saved_bytes;
+  };
+
+  static double Percentage(size_t part, size_t whole) {
+    return (whole != 0u) ? 100.0 * part / whole : 0.0;
+  }
+
+  void AddMethodSizes(const OatFile::OatMethod& oat_method, std::set<uint32_t>* seen_offsets,
+                      SizeStats* stats, DedupeStats* dedupe) {
+    uint32_t code_offset = oat_method.GetCodeOffset();
+    if (oat_file_.GetOatHeader().GetInstructionSet() == kThumb2) {
+      code_offset &= ~0x1;
+    }
+    size_t code_size = oat_method.GetQuickCodeSize();
+    if (code_size == 0u && oat_method.GetPortableCode() != nullptr) {
+      code_size = ComputeSize(oat_method.GetPortableCode());
+    }
+    if (code_size == 0u) {
+      return;
+    }
+    stats->methods++;
+    AddData(kCode, code_offset, code_size, seen_offsets, stats, dedupe);
+    AddData(kMappingTable, oat_method.GetMappingTableOffset(),
+            ComputeSize(oat_method.GetMappingTable()), seen_offsets, stats, dedupe);
+    AddData(kVmapTable, oat_method.GetVmapTableOffset(),
+            ComputeSize(oat_method.GetVmapTable()), seen_offsets, stats, dedupe);
+    AddData(kGcMap, oat_method.GetNativeGcMapOffset(),
+            ComputeSize(oat_method.GetNativeGcMap()), seen_offsets, stats, dedupe);
+  }
+
+  // Count the data at `offset` in `stats` the first time it is seen, as shared afterwards.
+  static void AddData(DataKind kind, uint32_t offset, size_t size,
+                      std::set<uint32_t>* seen_offsets, SizeStats* stats, DedupeStats* dedupe) {
+    if (offset == 0u || size == 0u) {
+      return;
+    }
+    dedupe[kind].uses++;
+    if (seen_offsets->insert(offset).second) {
+      stats->bytes[kind] += size;
+    } else {
+      dedupe[kind].shared++;
+      dedupe[kind].saved_bytes += size;
+    }
+  }
+
+  static void DumpSizeStatsHeader(std::ostream& os) {
+    os << StringPrintf("%10s %6s %10s %10s %10s %10s %7s  %s\n", "bytes", "%", "code",
+                       "mapping", "vmap", "gc map", "methods", "name");
+  }
+
+  static void DumpSizeStats(std::ostream& os, const std::string& name, const SizeStats& stats,
+                            size_t total_bytes) {
+    os << StringPrintf("%10zd %6.2f %10zd %10zd %10zd %10zd %7zd  %s\n", stats.Total(),
+                       Percentage(stats.Total(), total_bytes), stats.Get(kCode),
+                       stats.Get(kMappingTable), stats.Get(kVmapTable), stats.Get(kGcMap),
+                       stats.methods, name.c_str());
+  }
+
+  // Dump the `max_count` largest entries of `stats`, the largest first.
+  static void DumpLargest(std::ostream& os, const std::map<std::string, SizeStats>& stats,
+                          size_t max_count, size_t total_bytes) {
+    typedef std::map<std::string, SizeStats>::const_iterator Iterator;
+    std::vector<Iterator> entries;
+    for (Iterator it = stats.begin(); it != stats.end(); ++it) {
+      if (it->second.Total() != 0u) {
+        entries.push_back(it);
+      }
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](Iterator lhs, Iterator rhs) {
+      return lhs->second.Total() > rhs->second.Total();
+    });
+    for (size_t i = 0; i != entries.size() && i != max_count; ++i) {
+      DumpSizeStats(os, entries[i]->first, entries[i]->second, total_bytes);
+    }
+  }
+
   void AddAllOffsets() {
     // We don't know the length of the code for each method, but we need to know where to stop
     // when disassembling. What we do know is that a region of code will be followed by some other
@@ -321,6 +755,56 @@ class OatDumper {
     }
   }
 
+  void DumpOatClassJson(JsonWriter* writer, const OatFile::OatDexFile& oat_dex_file,
+                        const DexFile& dex_file, size_t class_def_index) {
+    const DexFile::ClassDef& class_def = dex_file.GetClassDef(class_def_index);
+    const OatFile::OatClass oat_class = oat_dex_file.GetOatClass(class_def_index);
+    writer->BeginObject();
+    writer->NumberField("class_def_index", class_def_index);
+    writer->StringField("descriptor", dex_file.GetClassDescriptor(class_def));
+    writer->NumberField("type_idx", class_def.class_idx_);
+    writer->StringField("status", ToStr<mirror::Class::Status>(oat_class.GetStatus()).str());
+    writer->StringField("type", ToStr<OatClassType>(oat_class.GetType()).str());
+    writer->BeginArray("methods");
+    const byte* class_data = dex_file.GetClassData(class_def);
+    if (class_data != nullptr) {
+      ClassDataItemIterator it(dex_file, class_data);
+      SkipAllFields(it);
+      for (uint32_t class_method_index = 0; it.HasNextDirectMethod() || it.HasNextVirtualMethod();
+           class_method_index++, it.Next()) {
+        DumpOatMethodJson(writer, class_method_index, oat_class.GetOatMethod(class_method_index),
+                          dex_file, it.GetMemberIndex());
+      }
+    }
+    writer->EndArray();
+    writer->EndObject();
+  }
+
+  void DumpOatMethodJson(JsonWriter* writer, uint32_t class_method_index,
+                         const OatFile::OatMethod& oat_method, const DexFile& dex_file,
+                         uint32_t dex_method_idx) {
+    uint32_t code_size = oat_method.GetQuickCodeSize();
+    if (oat_method.GetQuickCode() == nullptr) {
+      code_size = oat_method.GetPortableCodeSize();
+    }
+    writer->BeginObject();
+    writer->NumberField("class_method_index", class_method_index);
+    writer->NumberField("dex_method_idx", dex_method_idx);
+    writer->StringField("name", PrettyMethod(dex_method_idx, dex_file, true));
+    writer->NumberField("code_offset", oat_method.GetCodeOffset());
+    writer->NumberField("code_size", code_size);
+    writer->NumberField("frame_size_in_bytes", oat_method.GetFrameSizeInBytes());
+    writer->NumberField("core_spill_mask", oat_method.GetCoreSpillMask());
+    writer->NumberField("fp_spill_mask", oat_method.GetFpSpillMask());
+    writer->NumberField("mapping_table_offset", oat_method.GetMappingTableOffset());
+    writer->NumberField("mapping_table_size", ComputeSize(oat_method.GetMappingTable()));
+    writer->NumberField("vmap_table_offset", oat_method.GetVmapTableOffset());
+    writer->NumberField("vmap_table_size", ComputeSize(oat_method.GetVmapTable()));
+    writer->NumberField("gc_map_offset", oat_method.GetNativeGcMapOffset());
+    writer->NumberField("gc_map_size", ComputeSize(oat_method.GetNativeGcMap()));
+    writer->EndObject();
+  }
+
   void DumpOatClass(std::ostream& os, const OatFile::OatClass& oat_class, const DexFile& dex_file,
                     const DexFile::ClassDef& class_def) {
     const byte* class_data = dex_file.GetClassData(class_def);
@@ -582,27 +1066,38 @@ class OatDumper {
     }
   }
 
-  uint32_t DumpMappingAtOffset(std::ostream& os, const OatFile::OatMethod& oat_method,
-                               size_t offset, bool suspend_point_mapping) {
+  // Map the native PC offsets of the suspend points, or of the catch entries, of `oat_method` to
+  // their dex PCs, once per method rather than scanning the mapping table at each instruction.
+  static void GetDexPcsByNativePcOffset(const OatFile::OatMethod& oat_method,
+                                        bool suspend_point_mapping,
+                                        std::map<uint32_t, uint32_t>* dex_pcs) {
     MappingTable table(oat_method.GetMappingTable());
     if (suspend_point_mapping && table.PcToDexSize() > 0) {
       typedef MappingTable::PcToDexIterator It;
       for (It cur = table.PcToDexBegin(), end = table.PcToDexEnd(); cur != end; ++cur) {
-        if (offset == cur.NativePcOffset()) {
-          os << StringPrintf("suspend point dex PC: 0x%04x\n", cur.DexPc());
-          return cur.DexPc();
-        }
+        // Keeps the first entry of an offset.
+        dex_pcs->insert(std::make_pair(cur.NativePcOffset(), cur.DexPc()));
       }
     } else if (!suspend_point_mapping && table.DexToPcSize() > 0) {
       typedef MappingTable::DexToPcIterator It;
       for (It cur = table.DexToPcBegin(), end = table.DexToPcEnd(); cur != end; ++cur) {
-        if (offset == cur.NativePcOffset()) {
-          os << StringPrintf("catch entry dex PC: 0x%04x\n", cur.DexPc());
-          return cur.DexPc();
-        }
+        dex_pcs->insert(std::make_pair(cur.NativePcOffset(), cur.DexPc()));
       }
     }
-    return DexFile::kDexNoIndex;
+  }
+
+  uint32_t DumpMappingAtOffset(std::ostream& os, const std::map<uint32_t, uint32_t>& dex_pcs,
+                               size_t offset, bool suspend_point_mapping) {
+    auto it = dex_pcs.find(offset);
+    if (it == dex_pcs.end()) {
+      return DexFile::kDexNoIndex;
+    }
+    if (suspend_point_mapping) {
+      os << StringPrintf("suspend point dex PC: 0x%04x\n", it->second);
+    } else {
+      os << StringPrintf("catch entry dex PC: 0x%04x\n", it->second);
+    }
+    return it->second;
   }
 
   void DumpGcMapAtNativePcOffset(std::ostream& os, const OatFile::OatMethod& oat_method,
@@ -709,11 +1204,15 @@ class OatDumper {
       return;
     } else if (quick_code != nullptr) {
       const uint8_t* quick_native_pc = reinterpret_cast<const uint8_t*>(quick_code);
+      std::map<uint32_t, uint32_t> catch_entries;
+      GetDexPcsByNativePcOffset(oat_method, false, &catch_entries);
+      std::map<uint32_t, uint32_t> suspend_points;
+      GetDexPcsByNativePcOffset(oat_method, true, &suspend_points);
       size_t offset = 0;
       while (offset < code_size) {
-        DumpMappingAtOffset(os, oat_method, offset, false);
+        DumpMappingAtOffset(os, catch_entries, offset, false);
         offset += disassembler_->Dump(os, quick_native_pc + offset);
-        uint32_t dex_pc = DumpMappingAtOffset(os, oat_method, offset, true);
+        uint32_t dex_pc = DumpMappingAtOffset(os, suspend_points, offset, true);
         if (dex_pc != DexFile::kDexNoIndex) {
           DumpGcMapAtNativePcOffset(os, oat_method, code_item, offset);
           if (verifier != nullptr) {
@@ -739,10 +1238,13 @@ class ImageDumper {
  public:
   explicit ImageDumper(std::ostream* os, gc::space::ImageSpace& image_space,
                        const ImageHeader& image_header, bool dump_raw_mapping_table,
-                       bool dump_raw_gc_map)
+                       bool dump_raw_gc_map, JsonWriter* json_writer)
       : os_(os), image_space_(image_space), image_header_(image_header),
         dump_raw_mapping_table_(dump_raw_mapping_table),
-        dump_raw_gc_map_(dump_raw_gc_map) {}
+        dump_raw_gc_map_(dump_raw_gc_map), json_writer_(json_writer) {}
+
+  // With a `json_writer`, `os` is only given the text the statistics are computed along with, and
+  // Dump() ends by writing the JSON.
 
   void Dump() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     std::ostream& os = *os_;
@@ -753,6 +1255,14 @@ class ImageDumper {
     os << "IMAGE BITMAP OFFSET: " << reinterpret_cast<void*>(image_header_.GetImageBitmapOffset())
        << " SIZE: " << reinterpret_cast<void*>(image_header_.GetImageBitmapSize()) << "\n\n";
 
+    os << "RELOCATION BITMAP OFFSET: "
+       << reinterpret_cast<void*>(image_header_.GetRelocationBitmapOffset())
+       << " SIZE: " << reinterpret_cast<void*>(image_header_.GetRelocationBitmapSize()) << "\n\n";
+
+    os << "OAT RELOCATIONS: " << image_header_.GetOatRelocationsCount() << "\n\n";
+
+    os << "PATCH DELTA: " << image_header_.GetPatchDelta() << "\n\n";
+
     os << "OAT CHECKSUM: " << StringPrintf("0x%08x\n\n", image_header_.GetOatChecksum());
 
     os << "OAT FILE BEGIN:" << reinterpret_cast<void*>(image_header_.GetOatFileBegin()) << "\n\n";
@@ -814,6 +1324,9 @@ class ImageDumper {
     const OatFile* oat_file = class_linker->FindOatFileFromOatLocation(oat_location, &error_msg);
     if (oat_file == NULL) {
       os << "NOT FOUND: " << error_msg << "\n";
+      if (json_writer_ != nullptr) {
+        LOG(ERROR) << "Failed to find oat file " << oat_location << ": " << error_msg;
+      }
       return;
     }
     os << "\n";
@@ -889,10 +1402,46 @@ class ImageDumper {
 
     os << std::flush;
 
+    if (json_writer_ != nullptr) {
+      DumpJson(oat_location);
+      return;
+    }
     oat_dumper_->Dump(os);
   }
 
  private:
+  // Write the image header, the statistics of the image and the oat file as one JSON object.
+  void DumpJson(const std::string& oat_location) {
+    JsonWriter* writer = json_writer_;
+    writer->BeginObject();
+    writer->BeginObject("image_header");
+    writer->StringField("magic", image_header_.GetMagic());
+    writer->NumberField("image_begin", reinterpret_cast<uintptr_t>(image_header_.GetImageBegin()));
+    writer->NumberField("image_size", image_header_.GetImageSize());
+    writer->NumberField("image_bitmap_offset", image_header_.GetImageBitmapOffset());
+    writer->NumberField("image_bitmap_size", image_header_.GetImageBitmapSize());
+    writer->NumberField("relocation_bitmap_offset", image_header_.GetRelocationBitmapOffset());
+    writer->NumberField("relocation_bitmap_size", image_header_.GetRelocationBitmapSize());
+    writer->NumberField("oat_relocations_count", image_header_.GetOatRelocationsCount());
+    writer->NumberField("patch_delta", image_header_.GetPatchDelta());
+    writer->NumberField("oat_checksum", image_header_.GetOatChecksum());
+    writer->NumberField("oat_file_begin",
+                        reinterpret_cast<uintptr_t>(image_header_.GetOatFileBegin()));
+    writer->NumberField("oat_data_begin",
+                        reinterpret_cast<uintptr_t>(image_header_.GetOatDataBegin()));
+    writer->NumberField("oat_data_end", reinterpret_cast<uintptr_t>(image_header_.GetOatDataEnd()));
+    writer->NumberField("oat_file_end", reinterpret_cast<uintptr_t>(image_header_.GetOatFileEnd()));
+    writer->StringField("oat_location", oat_location);
+    writer->EndObject();
+    writer->BeginObject("stats");
+    stats_.DumpJson(writer);
+    writer->EndObject();
+    writer->BeginObject("oat_file");
+    oat_dumper_->DumpJson(writer);
+    writer->EndObject();
+    writer->EndObject();
+  }
+
   static void PrettyObjectValue(std::ostream& os, mirror::Class* type, mirror::Object* value)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     CHECK(type != NULL);
@@ -1427,6 +1976,45 @@ class ImageDumper {
 
       DumpOutliers(os);
     }
+
+    void DumpJson(JsonWriter* writer) {
+#define DUMP_STAT(name) writer->NumberField(#name, name)
+      DUMP_STAT(file_bytes);
+      DUMP_STAT(header_bytes);
+      DUMP_STAT(object_bytes);
+      DUMP_STAT(bitmap_bytes);
+      DUMP_STAT(alignment_bytes);
+      DUMP_STAT(oat_file_bytes);
+      DUMP_STAT(managed_code_bytes);
+      DUMP_STAT(managed_code_bytes_ignoring_deduplication);
+      DUMP_STAT(managed_to_native_code_bytes);
+      DUMP_STAT(native_to_managed_code_bytes);
+      DUMP_STAT(class_initializer_code_bytes);
+      DUMP_STAT(large_initializer_code_bytes);
+      DUMP_STAT(large_method_code_bytes);
+      DUMP_STAT(gc_map_bytes);
+      DUMP_STAT(pc_mapping_table_bytes);
+      DUMP_STAT(vmap_table_bytes);
+      DUMP_STAT(dex_instruction_bytes);
+#undef DUMP_STAT
+      writer->BeginArray("objects");
+      for (const auto& sizes_and_count : sizes_and_counts) {
+        writer->BeginObject();
+        writer->StringField("descriptor", sizes_and_count.first);
+        writer->NumberField("count", sizes_and_count.second.count);
+        writer->NumberField("bytes", sizes_and_count.second.bytes);
+        writer->EndObject();
+      }
+      writer->EndArray();
+      writer->BeginArray("dex_files");
+      for (const std::pair<std::string, size_t>& oat_dex_file_size : oat_dex_file_sizes) {
+        writer->BeginObject();
+        writer->StringField("location", oat_dex_file_size.first);
+        writer->NumberField("bytes", oat_dex_file_size.second);
+        writer->EndObject();
+      }
+      writer->EndArray();
+    }
   } stats_;
 
  private:
@@ -1444,6 +2032,7 @@ class ImageDumper {
   const ImageHeader& image_header_;
   bool dump_raw_mapping_table_;
   bool dump_raw_gc_map_;
+  JsonWriter* const json_writer_;
 
   DISALLOW_COPY_AND_ASSIGN(ImageDumper);
 };
@@ -1468,6 +2057,9 @@ static int oatdump(int argc, char** argv) {
   std::unique_ptr<std::ofstream> out;
   bool dump_raw_mapping_table = false;
   bool dump_raw_gc_map = false;
+  bool dump_stats = false;
+  std::string profile_file;
+  bool json = false;
 
   for (int i = 0; i < argc; i++) {
     const StringPiece option(argv[i]);
@@ -1486,6 +2078,20 @@ static int oatdump(int argc, char** argv) {
           fprintf(stderr, "Unknown argument %s\n", option.data());
           usage();
         }
+    } else if (option == "--stats") {
+      dump_stats = true;
+    } else if (option.starts_with("--profile-file=")) {
+      profile_file = option.substr(strlen("--profile-file=")).data();
+    } else if (option.starts_with("--output-format=")) {
+      StringPiece format = option.substr(strlen("--output-format="));
+      if (format == "json") {
+        json = true;
+      } else if (format == "text") {
+        json = false;
+      } else {
+        fprintf(stderr, "Unknown output format %s\n", format.data());
+        usage();
+      }
     } else if (option.starts_with("--output=")) {
       const char* filename = option.substr(strlen("--output=")).data();
       out.reset(new std::ofstream(filename));
@@ -1510,6 +2116,21 @@ static int oatdump(int argc, char** argv) {
     return EXIT_FAILURE;
   }
 
+  if (dump_stats && oat_filename == NULL) {
+    fprintf(stderr, "--stats requires --oat-file\n");
+    return EXIT_FAILURE;
+  }
+
+  if (!profile_file.empty() && !dump_stats) {
+    fprintf(stderr, "--profile-file requires --stats\n");
+    return EXIT_FAILURE;
+  }
+
+  if (dump_stats && json) {
+    fprintf(stderr, "--stats doesn't support --output-format=json\n");
+    return EXIT_FAILURE;
+  }
+
   if (oat_filename != NULL) {
     std::string error_msg;
     OatFile* oat_file =
@@ -1519,7 +2140,21 @@ static int oatdump(int argc, char** argv) {
       return EXIT_FAILURE;
     }
     OatDumper oat_dumper(*oat_file, dump_raw_mapping_table, dump_raw_gc_map);
-    oat_dumper.Dump(*os);
+    if (dump_stats) {
+      ProfileMap profile;
+      if (!profile_file.empty() && !ProfileHelper::LoadProfileMap(profile, profile_file)) {
+        fprintf(stderr, "Failed to load profile file '%s'\n", profile_file.c_str());
+        return EXIT_FAILURE;
+      }
+      oat_dumper.DumpStatistics(*os, profile_file.empty() ? nullptr : &profile);
+    } else if (json) {
+      JsonWriter writer(*os);
+      writer.BeginObject();
+      oat_dumper.DumpJson(&writer);
+      writer.EndObject();
+    } else {
+      oat_dumper.Dump(*os);
+    }
     return EXIT_SUCCESS;
   }
 
@@ -1561,8 +2196,11 @@ static int oatdump(int argc, char** argv) {
     fprintf(stderr, "Invalid image header %s\n", image_filename);
     return EXIT_FAILURE;
   }
-  ImageDumper image_dumper(os, *image_space, image_header,
-                           dump_raw_mapping_table, dump_raw_gc_map);
+  NullStreambuf null_buf;
+  std::ostream null_os(&null_buf);
+  std::unique_ptr<JsonWriter> json_writer(json ? new JsonWriter(*os) : nullptr);
+  ImageDumper image_dumper(json ? &null_os : os, *image_space, image_header,
+                           dump_raw_mapping_table, dump_raw_gc_map, json_writer.get());
   image_dumper.Dump();
   return EXIT_SUCCESS;
 }
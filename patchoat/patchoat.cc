@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/stringpiece.h"
+#include "base/stringprintf.h"
+#include "base/unix_file/fd_file.h"
+#include "elf_file.h"
+#include "elf_fixup.h"
+#include "image.h"
+#include "os.h"
+#include "utils.h"
+
+namespace art {
+
+static void usage() {
+  fprintf(stderr,
+          "Usage: patchoat [options] ...\n"
+          "    Moves a boot image and its oat file to a new base address by patching the\n"
+          "    addresses recorded in the image's relocation tables, without recompiling.\n"
+          "    Example: patchoat --input-image=/system/framework/arm/boot.art \\\n"
+          "        --output-image=/data/dalvik-cache/arm/system@framework@boot.art \\\n"
+          "        --base-offset-delta=0x100000\n"
+          "\n");
+  fprintf(stderr,
+          "  --input-image=<file.art>: specifies the image to relocate. The oat file is found\n"
+          "      next to it, as for the runtime.\n"
+          "      Example: --input-image=/system/framework/arm/boot.art\n"
+          "\n");
+  fprintf(stderr,
+          "  --output-image=<file.art>: specifies the relocated image to write. The relocated\n"
+          "      oat file is written next to it.\n"
+          "      Example: --output-image=/data/dalvik-cache/arm/system@framework@boot.art\n"
+          "\n");
+  fprintf(stderr,
+          "  --base-offset-delta=<delta>: page aligned number of bytes to move the image and\n"
+          "      oat file by, may be negative.\n"
+          "      Example: --base-offset-delta=-0x200000\n"
+          "\n");
+  exit(EXIT_FAILURE);
+}
+
+class PatchOat {
+ public:
+  // Writes the image and oat file found at `input_image_filename`, moved by `delta` bytes, to
+  // `output_image_filename` and the oat file next to it.
+  static bool Patch(const std::string& input_image_filename,
+                    const std::string& output_image_filename,
+                    int32_t delta, std::string* error_msg) {
+    std::unique_ptr<File> input_image(OS::OpenFileForReading(input_image_filename.c_str()));
+    if (input_image.get() == nullptr) {
+      *error_msg = StringPrintf("Failed to open image '%s'", input_image_filename.c_str());
+      return false;
+    }
+    int64_t image_length = input_image->GetLength();
+    if (image_length < static_cast<int64_t>(sizeof(ImageHeader))) {
+      *error_msg = StringPrintf("Image '%s' is too short", input_image_filename.c_str());
+      return false;
+    }
+    std::vector<byte> image(image_length);
+    if (!input_image->ReadFully(&image[0], image_length)) {
+      *error_msg = StringPrintf("Failed to read image '%s'", input_image_filename.c_str());
+      return false;
+    }
+    ImageHeader* image_header = reinterpret_cast<ImageHeader*>(&image[0]);
+    if (!image_header->IsValid()) {
+      *error_msg = StringPrintf("Invalid image header in '%s'", input_image_filename.c_str());
+      return false;
+    }
+    if (image_header->GetRelocationBitmapSize() == 0 ||
+        image_header->GetRelocationBitmapOffset() + image_header->GetRelocationBitmapSize() >
+            image.size() ||
+        image_header->GetOatRelocationsOffset() +
+            image_header->GetOatRelocationsCount() * sizeof(uint32_t) > image.size()) {
+      *error_msg = StringPrintf("Image '%s' has no valid relocation tables",
+                                input_image_filename.c_str());
+      return false;
+    }
+
+    // Write the oat file first so that the image, which is what the runtime looks for, never
+    // refers to a partially patched oat file.
+    std::string input_oat_filename =
+        ImageHeader::GetOatLocationFromImageLocation(input_image_filename);
+    std::string output_oat_filename =
+        ImageHeader::GetOatLocationFromImageLocation(output_image_filename);
+    std::unique_ptr<File> output_oat(CopyFile(input_oat_filename, output_oat_filename, error_msg));
+    if (output_oat.get() == nullptr) {
+      return false;
+    }
+    const uint32_t* oat_relocations =
+        reinterpret_cast<const uint32_t*>(&image[image_header->GetOatRelocationsOffset()]);
+    if (!PatchOatFile(output_oat.get(), oat_relocations, image_header->GetOatRelocationsCount(),
+                      delta, error_msg)) {
+      return false;
+    }
+    // The ELF fixup moves the oat file from where it currently is to the given oat data begin.
+    image_header->Relocate(delta);
+    if (!ElfFixup::Fixup(output_oat.get(),
+                         reinterpret_cast<uintptr_t>(image_header->GetOatDataBegin()))) {
+      *error_msg = StringPrintf("Failed to fix up ELF of '%s'", output_oat_filename.c_str());
+      return false;
+    }
+
+    PatchImage(&image, delta);
+    std::unique_ptr<File> output_image(OS::CreateEmptyFile(output_image_filename.c_str()));
+    if (output_image.get() == nullptr ||
+        fchmod(output_image->Fd(), 0644) != 0 ||
+        !output_image->WriteFully(&image[0], image.size())) {
+      *error_msg = StringPrintf("Failed to write image '%s': %s", output_image_filename.c_str(),
+                                strerror(errno));
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  static File* CopyFile(const std::string& input_filename, const std::string& output_filename,
+                        std::string* error_msg) {
+    std::unique_ptr<File> input(OS::OpenFileForReading(input_filename.c_str()));
+    if (input.get() == nullptr) {
+      *error_msg = StringPrintf("Failed to open '%s'", input_filename.c_str());
+      return nullptr;
+    }
+    int64_t length = input->GetLength();
+    if (length <= 0) {
+      *error_msg = StringPrintf("Failed to get length of '%s'", input_filename.c_str());
+      return nullptr;
+    }
+    std::vector<byte> contents(length);
+    if (!input->ReadFully(&contents[0], length)) {
+      *error_msg = StringPrintf("Failed to read '%s'", input_filename.c_str());
+      return nullptr;
+    }
+    std::unique_ptr<File> output(OS::CreateEmptyFile(output_filename.c_str()));
+    if (output.get() == nullptr ||
+        fchmod(output->Fd(), 0644) != 0 ||
+        !output->WriteFully(&contents[0], length)) {
+      *error_msg = StringPrintf("Failed to write '%s': %s", output_filename.c_str(),
+                                strerror(errno));
+      return nullptr;
+    }
+    return output.release();
+  }
+
+  // Moves the absolute addresses patched into the oat file's code by the image writer.
+  static bool PatchOatFile(File* oat_file, const uint32_t* relocations, size_t count,
+                           int32_t delta, std::string* error_msg) {
+    std::unique_ptr<ElfFile> elf_file(ElfFile::Open(oat_file, true, false, error_msg));
+    if (elf_file.get() == nullptr) {
+      return false;
+    }
+    Elf32_Sym* oatdata = elf_file->FindSymbolByName(SHT_DYNSYM, "oatdata", false);
+    if (oatdata == nullptr) {
+      *error_msg = StringPrintf("No oatdata symbol in '%s'", oat_file->GetPath().c_str());
+      return false;
+    }
+    Elf32_Shdr& section = elf_file->GetSectionHeader(oatdata->st_shndx);
+    byte* oat_data = elf_file->Begin() + section.sh_offset + (oatdata->st_value - section.sh_addr);
+    for (size_t i = 0; i < count; ++i) {
+      if (relocations[i] + sizeof(uint32_t) > oatdata->st_size) {
+        *error_msg = StringPrintf("Oat relocation 0x%x out of range", relocations[i]);
+        return false;
+      }
+      *reinterpret_cast<uint32_t*>(oat_data + relocations[i]) += delta;
+    }
+    // The changes reach the file when the shared mapping of the ElfFile goes away.
+    return true;
+  }
+
+  // Moves the image words marked in the relocation bitmap. A bitmap byte covers
+  // kBitsPerByte words, lowest bit first, whatever the word size of the writer.
+  static void PatchImage(std::vector<byte>* image, int32_t delta) {
+    const ImageHeader* image_header = reinterpret_cast<const ImageHeader*>(&(*image)[0]);
+    const byte* bitmap = &(*image)[image_header->GetRelocationBitmapOffset()];
+    const size_t bitmap_size = image_header->GetRelocationBitmapSize();
+    const size_t image_size = image_header->GetImageSize();
+    for (size_t i = 0; i < bitmap_size; ++i) {
+      for (uint32_t bits = bitmap[i]; bits != 0; bits &= bits - 1) {
+        size_t offset = (i * kBitsPerByte + CTZ(bits)) * kRelocationAlignment;
+        CHECK_LE(offset + sizeof(uint32_t), image_size);
+        *reinterpret_cast<uint32_t*>(&(*image)[offset]) += delta;
+      }
+    }
+  }
+};
+
+static int patchoat(int argc, char** argv) {
+  InitLogging(argv);
+
+  // Skip over argv[0].
+  argv++;
+  argc--;
+
+  if (argc == 0) {
+    fprintf(stderr, "No arguments specified\n");
+    usage();
+  }
+
+  std::string input_image_filename;
+  std::string output_image_filename;
+  bool have_delta = false;
+  int32_t delta = 0;
+
+  for (int i = 0; i < argc; i++) {
+    const StringPiece option(argv[i]);
+    if (option.starts_with("--input-image=")) {
+      input_image_filename = option.substr(strlen("--input-image=")).data();
+    } else if (option.starts_with("--output-image=")) {
+      output_image_filename = option.substr(strlen("--output-image=")).data();
+    } else if (option.starts_with("--base-offset-delta=")) {
+      const char* delta_str = option.substr(strlen("--base-offset-delta=")).data();
+      char* end;
+      delta = strtol(delta_str, &end, 0);
+      if (*delta_str == '\0' || *end != '\0') {
+        fprintf(stderr, "Failed to parse --base-offset-delta argument '%s'\n", delta_str);
+        usage();
+      }
+      have_delta = true;
+    } else {
+      fprintf(stderr, "Unknown argument %s\n", option.data());
+      usage();
+    }
+  }
+
+  if (input_image_filename.empty() || output_image_filename.empty() || !have_delta) {
+    fprintf(stderr, "--input-image, --output-image and --base-offset-delta must be specified\n");
+    usage();
+  }
+  if (!IsAligned<kPageSize>(delta)) {
+    fprintf(stderr, "--base-offset-delta must be a multiple of the page size %d\n", kPageSize);
+    return EXIT_FAILURE;
+  }
+
+  uint64_t start_ns = NanoTime();
+  std::string error_msg;
+  if (!PatchOat::Patch(input_image_filename, output_image_filename, delta, &error_msg)) {
+    LOG(ERROR) << "Failed to relocate '" << input_image_filename << "': " << error_msg;
+    return EXIT_FAILURE;
+  }
+  LOG(INFO) << "Relocated '" << input_image_filename << "' by " << delta << " bytes to '"
+            << output_image_filename << "' in " << PrettyDuration(NanoTime() - start_ns);
+  return EXIT_SUCCESS;
+}
+
+}  // namespace art
+
+int main(int argc, char** argv) {
+  return art::patchoat(argc, argv);
+}
@@ -24,6 +24,7 @@ LIBART_COMMON_SRC_FILES := \
 	base/allocator.cc \
 	base/bit_vector.cc \
 	base/hex_dump.cc \
+	base/latency_histogram.cc \
 	base/logging.cc \
 	base/mutex.cc \
 	base/stringpiece.cc \
@@ -37,6 +38,8 @@ LIBART_COMMON_SRC_FILES := \
 	check_jni.cc \
 	catch_block_stack_visitor.cc \
 	class_linker.cc \
+	class_preloader.cc \
+	class_table.cc \
 	common_throws.cc \
 	debugger.cc \
 	deoptimize_stack_visitor.cc \
@@ -52,6 +55,7 @@ LIBART_COMMON_SRC_FILES := \
 	gc/accounting/mod_union_table.cc \
 	gc/accounting/remembered_set.cc \
 	gc/accounting/space_bitmap.cc \
+	gc/allocation_sampler.cc \
 	gc/collector/concurrent_copying.cc \
 	gc/collector/garbage_collector.cc \
 	gc/collector/immune_region.cc \
@@ -59,8 +63,10 @@ LIBART_COMMON_SRC_FILES := \
 	gc/collector/partial_mark_sweep.cc \
 	gc/collector/semi_space.cc \
 	gc/collector/sticky_mark_sweep.cc \
+	gc/collector/work_stealing_mark_stack.cc \
 	gc/gc_cause.cc \
 	gc/heap.cc \
+	gc/native_cleaner.cc \
 	gc/reference_processor.cc \
 	gc/reference_queue.cc \
 	gc/space/bump_pointer_space.cc \
@@ -87,6 +93,8 @@ LIBART_COMMON_SRC_FILES := \
 	jdwp/jdwp_request.cc \
 	jdwp/jdwp_socket.cc \
 	jdwp/object_registry.cc \
+	jit/jit.cc \
+	jit/jit_code_cache.cc \
 	jni_internal.cc \
 	jobject_comparator.cc \
 	mem_map.cc \
@@ -130,9 +138,11 @@ LIBART_COMMON_SRC_FILES := \
 	offsets.cc \
 	os_linux.cc \
 	parsed_options.cc \
+	perf_map.cc \
 	primitive.cc \
 	quick_exception_handler.cc \
 	quick/inline_method_analyser.cc \
+	read_barrier.cc \
 	reference_table.cc \
 	reflection.cc \
 	runtime.cc \
@@ -144,6 +154,7 @@ LIBART_COMMON_SRC_FILES := \
 	throw_location.cc \
 	trace.cc \
 	transaction.cc \
+	type_lookup_table.cc \
 	profiler.cc \
 	fault_handler.cc \
 	utf.cc \
@@ -87,6 +87,15 @@ TEST_F(ArchTest, ARM) {
 #ifdef THREAD_ID_OFFSET
 #undef THREAD_ID_OFFSET
 #endif
+#ifdef THREAD_LOCAL_POS_OFFSET
+#undef THREAD_LOCAL_POS_OFFSET
+#endif
+#ifdef THREAD_LOCAL_END_OFFSET
+#undef THREAD_LOCAL_END_OFFSET
+#endif
+#ifdef THREAD_LOCAL_OBJECTS_OFFSET
+#undef THREAD_LOCAL_OBJECTS_OFFSET
+#endif
 #ifdef FRAME_SIZE_SAVE_ALL_CALLEE_SAVE
 #undef FRAME_SIZE_SAVE_ALL_CALLEE_SAVE
 #endif
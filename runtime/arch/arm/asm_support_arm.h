@@ -27,6 +27,12 @@
 #define THREAD_CARD_TABLE_OFFSET 112
 // Offset of field Thread::tlsPtr_.exception verified in InitCpu
 #define THREAD_EXCEPTION_OFFSET 116
+// Offset of field Thread::tlsPtr_.thread_local_pos verified in InitCpu
+#define THREAD_LOCAL_POS_OFFSET 748
+// Offset of field Thread::tlsPtr_.thread_local_end verified in InitCpu
+#define THREAD_LOCAL_END_OFFSET 752
+// Offset of field Thread::tlsPtr_.thread_local_objects verified in InitCpu
+#define THREAD_LOCAL_OBJECTS_OFFSET 756
 
 #define FRAME_SIZE_SAVE_ALL_CALLEE_SAVE 176
 #define FRAME_SIZE_REFS_ONLY_CALLEE_SAVE 32
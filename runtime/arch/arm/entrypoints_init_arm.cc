@@ -20,6 +20,7 @@
 #include "entrypoints/quick/quick_entrypoints.h"
 #include "entrypoints/entrypoint_utils.h"
 #include "entrypoints/math_entrypoints.h"
+#include "instruction_set.h"
 
 namespace art {
 
@@ -105,6 +106,8 @@ extern "C" uint64_t art_quick_ushr_long(uint64_t, uint32_t);
 extern "C" int32_t __memcmp16(void*, void*, int32_t);
 extern "C" int32_t art_quick_indexof(void*, uint32_t, uint32_t, uint32_t);
 extern "C" int32_t art_quick_string_compareto(void*, void*);
+extern "C" int32_t art_quick_indexof_neon(void*, uint32_t, uint32_t, uint32_t);
+extern "C" int32_t art_quick_string_compareto_neon(void*, void*);
 
 // Invoke entrypoints.
 extern "C" void art_quick_imt_conflict_trampoline(mirror::ArtMethod*);
@@ -128,6 +131,9 @@ extern "C" void art_quick_throw_no_such_method(int32_t method_idx);
 extern "C" void art_quick_throw_null_pointer_exception();
 extern "C" void art_quick_throw_stack_overflow(void*);
 
+// Deoptimization entrypoints.
+extern "C" void art_quick_deoptimize_from_compiled_code();
+
 // Generic JNI downcall
 extern "C" void art_quick_generic_jni_trampoline(mirror::ArtMethod*);
 
@@ -213,9 +219,14 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   qpoints->pUshrLong = art_quick_ushr_long;
 
   // Intrinsics
-  qpoints->pIndexOf = art_quick_indexof;
+  if (InstructionSetFeatures::GuessInstructionSetFeatures().HasNeon()) {
+    qpoints->pIndexOf = art_quick_indexof_neon;
+    qpoints->pStringCompareTo = art_quick_string_compareto_neon;
+  } else {
+    qpoints->pIndexOf = art_quick_indexof;
+    qpoints->pStringCompareTo = art_quick_string_compareto;
+  }
   qpoints->pMemcmp16 = __memcmp16;
-  qpoints->pStringCompareTo = art_quick_string_compareto;
   qpoints->pMemcpy = memcpy;
 
   // Invocation
@@ -239,6 +250,9 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   qpoints->pThrowNoSuchMethod = art_quick_throw_no_such_method;
   qpoints->pThrowNullPointer = art_quick_throw_null_pointer_exception;
   qpoints->pThrowStackOverflow = art_quick_throw_stack_overflow;
+
+  // Deoptimization
+  qpoints->pDeoptimize = art_quick_deoptimize_from_compiled_code;
 };
 
 }  // namespace art
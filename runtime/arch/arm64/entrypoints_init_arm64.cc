@@ -117,6 +117,9 @@ extern "C" void art_quick_throw_no_such_method(int32_t method_idx);
 extern "C" void art_quick_throw_null_pointer_exception();
 extern "C" void art_quick_throw_stack_overflow(void*);
 
+// Deoptimization entrypoints.
+extern "C" void art_quick_deoptimize_from_compiled_code();
+
 extern void ResetQuickAllocEntryPoints(QuickEntryPoints* qpoints);
 
 // Generic JNI downcall
@@ -231,6 +234,9 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   qpoints->pThrowNoSuchMethod = art_quick_throw_no_such_method;
   qpoints->pThrowNullPointer = art_quick_throw_null_pointer_exception;
   qpoints->pThrowStackOverflow = art_quick_throw_stack_overflow;
+
+  // Deoptimization
+  qpoints->pDeoptimize = art_quick_deoptimize_from_compiled_code;
 };
 
 }  // namespace art
@@ -1069,6 +1069,70 @@ TEST_F(StubTest, StringCompareTo) {
 }
 
 
+#if defined(__i386__) || defined(__x86_64__)
+extern "C" void art_quick_string_compareto_sse4_2(void);
+#elif defined(__arm__)
+extern "C" void art_quick_string_compareto_neon(void);
+#endif
+
+// The vector stubs only differ from the scalar one past 8 chars, so use longer strings that
+// differ inside the first block, inside a later block and in the scalar tail.
+TEST_F(StubTest, StringCompareToVector) {
+  TEST_DISABLED_FOR_HEAP_REFERENCE_POISONING();
+
+#if defined(__i386__) || defined(__x86_64__) || defined(__arm__)
+#if defined(__arm__)
+  bool supported = InstructionSetFeatures::GuessInstructionSetFeatures().HasNeon();
+  uintptr_t stub = reinterpret_cast<uintptr_t>(&art_quick_string_compareto_neon);
+#else
+  bool supported = InstructionSetFeatures::GuessInstructionSetFeatures().HasSse4_2();
+  uintptr_t stub = reinterpret_cast<uintptr_t>(&art_quick_string_compareto_sse4_2);
+#endif
+  if (!supported) {
+    LOG(INFO) << "Skipping string_compareto vector stub as the CPU does not support it";
+    return;
+  }
+
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+
+  static constexpr size_t kStringCount = 8;
+  const char* c[kStringCount] = {
+      "",
+      "abcdefg",
+      "abcdefghijklmnopqrstuvwxyz",
+      "abcdefghijklmnopqrstuvwxyz0",
+      "abcXefghijklmnopqrstuvwxyz",
+      "abcdefghijklmnopqrsXuvwxyz",
+      "abcdefghijklmnopqrstuvwxyY",
+      "abcdefghijklmnopqrstuvwxy",
+  };
+
+  StackHandleScope<kStringCount> hs(self);
+  Handle<mirror::String> s[kStringCount];
+  for (size_t i = 0; i < kStringCount; ++i) {
+    s[i] = hs.NewHandle(mirror::String::AllocFromModifiedUtf8(soa.Self(), c[i]));
+  }
+
+  for (size_t x = 0; x < kStringCount; ++x) {
+    for (size_t y = 0; y < kStringCount; ++y) {
+      size_t result = Invoke3(reinterpret_cast<size_t>(s[x].Get()),
+                              reinterpret_cast<size_t>(s[y].Get()), 0U, stub, self);
+      EXPECT_FALSE(self->IsExceptionPending());
+      int32_t res = static_cast<int32_t>(result);
+      int32_t e = s[x]->CompareTo(s[y].Get());
+      EXPECT_EQ(e < 0, res < 0) << "x=" << c[x] << " y=" << c[y] << " res=" << res;
+      EXPECT_EQ(e > 0, res > 0) << "x=" << c[x] << " y=" << c[y] << " res=" << res;
+    }
+  }
+#else
+  LOG(INFO) << "Skipping string_compareto vector stub on " << kRuntimeISA;
+  // Force-print to std::cout so it's also outside the logcat.
+  std::cout << "Skipping string_compareto vector stub on " << kRuntimeISA << std::endl;
+#endif
+}
+
+
 #if defined(__i386__) || defined(__arm__) || defined(__aarch64__) || defined(__x86_64__)
 extern "C" void art_quick_set32_static(void);
 extern "C" void art_quick_get32_static(void);
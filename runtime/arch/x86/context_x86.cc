@@ -37,8 +37,7 @@ void X86Context::Reset() {
 }
 
 void X86Context::FillCalleeSaves(const StackVisitor& fr) {
-  mirror::ArtMethod* method = fr.GetMethod();
-  const QuickMethodFrameInfo frame_info = method->GetQuickFrameInfo();
+  const QuickMethodFrameInfo frame_info = fr.GetCurrentQuickFrameInfo();
   size_t spill_count = POPCOUNT(frame_info.CoreSpillMask());
   DCHECK_EQ(frame_info.FpSpillMask(), 0u);
   if (spill_count > 0) {
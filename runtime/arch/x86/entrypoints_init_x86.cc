@@ -18,6 +18,7 @@
 #include "entrypoints/quick/quick_alloc_entrypoints.h"
 #include "entrypoints/quick/quick_entrypoints.h"
 #include "entrypoints/entrypoint_utils.h"
+#include "instruction_set.h"
 
 namespace art {
 
@@ -86,6 +87,7 @@ extern "C" uint64_t art_quick_lushr(uint64_t, uint32_t);
 // Intrinsic entrypoints.
 extern "C" int32_t art_quick_memcmp16(void*, void*, int32_t);
 extern "C" int32_t art_quick_string_compareto(void*, void*);
+extern "C" int32_t art_quick_string_compareto_sse4_2(void*, void*);
 extern "C" void* art_quick_memcpy(void*, const void*, size_t);
 
 // Invoke entrypoints.
@@ -110,6 +112,9 @@ extern "C" void art_quick_throw_no_such_method(int32_t method_idx);
 extern "C" void art_quick_throw_null_pointer_exception();
 extern "C" void art_quick_throw_stack_overflow(void*);
 
+// Deoptimization entrypoints.
+extern "C" void art_quick_deoptimize_from_compiled_code();
+
 // Generic JNI downcall
 extern "C" void art_quick_generic_jni_trampoline(mirror::ArtMethod*);
 
@@ -199,7 +204,11 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   // Intrinsics
   // qpoints->pIndexOf = nullptr;  // Not needed on x86
   qpoints->pMemcmp16 = art_quick_memcmp16;
-  qpoints->pStringCompareTo = art_quick_string_compareto;
+  if (InstructionSetFeatures::GuessInstructionSetFeatures().HasSse4_2()) {
+    qpoints->pStringCompareTo = art_quick_string_compareto_sse4_2;
+  } else {
+    qpoints->pStringCompareTo = art_quick_string_compareto;
+  }
   qpoints->pMemcpy = art_quick_memcpy;
 
   // Invocation
@@ -223,6 +232,9 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   qpoints->pThrowNoSuchMethod = art_quick_throw_no_such_method;
   qpoints->pThrowNullPointer = art_quick_throw_null_pointer_exception;
   qpoints->pThrowStackOverflow = art_quick_throw_stack_overflow;
+
+  // Deoptimization
+  qpoints->pDeoptimize = art_quick_deoptimize_from_compiled_code;
 };
 
 }  // namespace art
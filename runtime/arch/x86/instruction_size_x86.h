@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_ARCH_X86_INSTRUCTION_SIZE_X86_H_
+#define ART_RUNTIME_ARCH_X86_INSTRUCTION_SIZE_X86_H_
+
+#include <stdint.h>
+
+namespace art {
+
+// Returns the size in bytes of the x86, or x86-64 if is_64bit, instruction at pc, which the fault
+// handlers need to find the pc following a faulting memory access. Only the instructions with a
+// ModR/M memory operand which compiled code accesses memory with are decoded, 0 is returned for
+// the others.
+static inline uint32_t GetX86InstructionSize(const uint8_t* pc, bool is_64bit) {
+  const uint8_t* start = pc;
+  bool operand_size_prefix = false;
+  // Legacy prefixes.
+  while (true) {
+    uint8_t prefix = *pc;
+    if (prefix == 0x66) {
+      operand_size_prefix = true;
+    } else if (prefix != 0x67 && prefix != 0xF0 && prefix != 0xF2 && prefix != 0xF3 &&
+               prefix != 0x26 && prefix != 0x2E && prefix != 0x36 && prefix != 0x3E &&
+               prefix != 0x64 && prefix != 0x65) {
+      break;
+    }
+    ++pc;
+  }
+  // REX prefix, which doesn't change the size of the immediates of the decoded instructions.
+  if (is_64bit && (*pc & 0xF0) == 0x40) {
+    ++pc;
+  }
+  const uint32_t imm_z = operand_size_prefix ? 2 : 4;
+  uint32_t immediate_size = 0;
+  uint8_t opcode = *pc++;
+  if (opcode == 0x0F) {
+    opcode = *pc++;
+    if (opcode == 0x38) {
+      ++pc;
+    } else if (opcode == 0x3A) {
+      ++pc;
+      immediate_size = 1;
+    } else if ((opcode >= 0x70 && opcode <= 0x73) || opcode == 0xA4 || opcode == 0xAC ||
+               opcode == 0xBA || (opcode >= 0xC2 && opcode <= 0xC6 && opcode != 0xC3)) {
+      immediate_size = 1;
+    } else if (!((opcode >= 0x10 && opcode <= 0x2F && (opcode < 0x20 || opcode >= 0x28)) ||
+                 (opcode >= 0x40 && opcode <= 0x6F) || (opcode >= 0x74 && opcode <= 0x76) ||
+                 opcode == 0x7E || opcode == 0x7F || opcode == 0xA3 || opcode == 0xAB ||
+                 opcode == 0xAD || opcode == 0xAF || opcode == 0xB0 || opcode == 0xB1 ||
+                 opcode == 0xB3 || opcode == 0xB6 || opcode == 0xB7 ||
+                 (opcode >= 0xBB && opcode <= 0xBF) || opcode == 0xC0 || opcode == 0xC1 ||
+                 opcode == 0xC3 || opcode == 0xC7 || (opcode >= 0xD0 && opcode <= 0xFE))) {
+      return 0;
+    }
+  } else if (opcode == 0x6B || opcode == 0x80 || opcode == 0x82 || opcode == 0x83 ||
+             opcode == 0xC0 || opcode == 0xC1 || opcode == 0xC6) {
+    immediate_size = 1;
+  } else if (opcode == 0x69 || opcode == 0x81 || opcode == 0xC7) {
+    immediate_size = imm_z;
+  } else if (opcode == 0xF6 || opcode == 0xF7) {
+    // Only TEST, /0 and /1, has an immediate.
+    if (((*pc >> 3) & 7) < 2) {
+      immediate_size = (opcode == 0xF6) ? 1 : imm_z;
+    }
+  } else if (!((opcode < 0x40 && (opcode & 7) < 4) || opcode == 0x63 ||
+               (opcode >= 0x84 && opcode <= 0x8F) || (opcode >= 0xD0 && opcode <= 0xD3) ||
+               (opcode >= 0xD8 && opcode <= 0xDF) || opcode == 0xFE || opcode == 0xFF)) {
+    return 0;
+  }
+  // The ModR/M byte, with its SIB byte and displacement.
+  uint8_t modrm = *pc++;
+  uint8_t mod = modrm >> 6;
+  uint8_t rm = modrm & 7;
+  if (mod != 3) {
+    if (rm == 4) {
+      uint8_t sib = *pc++;
+      if (mod == 0 && (sib & 7) == 5) {
+        pc += 4;
+      }
+    } else if (mod == 0 && rm == 5) {
+      pc += 4;
+    }
+    if (mod == 1) {
+      pc += 1;
+    } else if (mod == 2) {
+      pc += 4;
+    }
+  }
+  pc += immediate_size;
+  return pc - start;
+}
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_ARCH_X86_INSTRUCTION_SIZE_X86_H_
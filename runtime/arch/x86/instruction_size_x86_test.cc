@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "instruction_size_x86.h"
+
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+static uint32_t SizeOf(std::initializer_list<uint8_t> bytes, bool is_64bit) {
+  uint8_t code[16] = {};
+  std::copy(bytes.begin(), bytes.end(), code);
+  return GetX86InstructionSize(code, is_64bit);
+}
+
+TEST(InstructionSizeX86Test, Loads) {
+  EXPECT_EQ(3u, SizeOf({0x8b, 0x40, 0x08}, false));                          // mov eax, [eax + 8]
+  EXPECT_EQ(4u, SizeOf({0x0f, 0xb7, 0x48, 0x0c}, false));                    // movzx ecx, [eax+12]
+  EXPECT_EQ(6u, SizeOf({0x8b, 0x80, 0x00, 0x01, 0x00, 0x00}, false));        // mov eax, [eax + 256]
+  EXPECT_EQ(7u, SizeOf({0x8b, 0x04, 0x85, 0x00, 0x00, 0x00, 0x00}, false));  // mov eax, [eax * 4]
+  EXPECT_EQ(5u, SizeOf({0xf2, 0x0f, 0x10, 0x40, 0x10}, false));              // movsd xmm0, [eax+16]
+  EXPECT_EQ(4u, SizeOf({0x83, 0x78, 0x08, 0x00}, false));                    // cmp [eax + 8], 0
+  EXPECT_EQ(4u, SizeOf({0x48, 0x8b, 0x47, 0x08}, true));                     // mov rax, [rdi + 8]
+}
+
+TEST(InstructionSizeX86Test, Stores) {
+  EXPECT_EQ(4u, SizeOf({0x89, 0x4c, 0x24, 0x10}, false));                    // mov [esp + 16], ecx
+  EXPECT_EQ(4u, SizeOf({0x66, 0x89, 0x48, 0x0c}, false));                    // mov [eax + 12], cx
+  EXPECT_EQ(7u, SizeOf({0xc7, 0x40, 0x08, 0x01, 0x00, 0x00, 0x00}, false));  // mov [eax + 8], 1
+  EXPECT_EQ(6u, SizeOf({0x66, 0xc7, 0x40, 0x08, 0x01, 0x00}, false));        // mov w[eax + 8], 1
+}
+
+TEST(InstructionSizeX86Test, Unsupported) {
+  EXPECT_EQ(0u, SizeOf({0xe8, 0x00, 0x00, 0x00, 0x00}, false));              // call
+}
+
+}  // namespace art
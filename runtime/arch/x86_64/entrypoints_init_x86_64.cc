@@ -18,6 +18,7 @@
 #include "entrypoints/quick/quick_alloc_entrypoints.h"
 #include "entrypoints/quick/quick_entrypoints.h"
 #include "entrypoints/entrypoint_utils.h"
+#include "instruction_set.h"
 
 namespace art {
 
@@ -69,8 +70,10 @@ extern "C" void art_quick_lock_object(void*);
 extern "C" void art_quick_unlock_object(void*);
 
 // Math entrypoints.
-extern "C" double art_quick_fmod(double, double);
-extern "C" float art_quick_fmodf(float, float);
+// The native calling convention already takes and returns floating point values
+// in XMM registers, so the remainders go straight to libm.
+extern "C" double fmod(double a, double b);
+extern "C" float fmodf(float a, float b);
 extern "C" double art_quick_l2d(int64_t);
 extern "C" float art_quick_l2f(int64_t);
 extern "C" int64_t art_quick_d2l(double);
@@ -87,6 +90,7 @@ extern "C" uint64_t art_quick_lushr(uint64_t, uint32_t);
 extern "C" int32_t art_quick_memcmp16(void*, void*, int32_t);
 extern "C" int32_t art_quick_indexof(void*, uint32_t, uint32_t, uint32_t);
 extern "C" int32_t art_quick_string_compareto(void*, void*);
+extern "C" int32_t art_quick_string_compareto_sse4_2(void*, void*);
 extern "C" void* art_quick_memcpy(void*, const void*, size_t);
 
 // Invoke entrypoints.
@@ -111,6 +115,9 @@ extern "C" void art_quick_throw_no_such_method(int32_t method_idx);
 extern "C" void art_quick_throw_null_pointer_exception();
 extern "C" void art_quick_throw_stack_overflow(void*);
 
+// Deoptimization entrypoints.
+extern "C" void art_quick_deoptimize_from_compiled_code();
+
 // Generic JNI entrypoint
 extern "C" void art_quick_generic_jni_trampoline(mirror::ArtMethod*);
 
@@ -180,10 +187,10 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   // points->pCmpgFloat = NULL;  // Not needed on x86.
   // points->pCmplDouble = NULL;  // Not needed on x86.
   // points->pCmplFloat = NULL;  // Not needed on x86.
-  qpoints->pFmod = art_quick_fmod;
+  qpoints->pFmod = fmod;
   // qpoints->pSqrt = NULL;  // Not needed on x86.
   qpoints->pL2d = art_quick_l2d;
-  qpoints->pFmodf = art_quick_fmodf;
+  qpoints->pFmodf = fmodf;
   qpoints->pL2f = art_quick_l2f;
   // points->pD2iz = NULL;  // Not needed on x86.
   // points->pF2iz = NULL;  // Not needed on x86.
@@ -200,7 +207,11 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   // Intrinsics
   qpoints->pIndexOf = art_quick_indexof;
   qpoints->pMemcmp16 = art_quick_memcmp16;
-  qpoints->pStringCompareTo = art_quick_string_compareto;
+  if (InstructionSetFeatures::GuessInstructionSetFeatures().HasSse4_2()) {
+    qpoints->pStringCompareTo = art_quick_string_compareto_sse4_2;
+  } else {
+    qpoints->pStringCompareTo = art_quick_string_compareto;
+  }
   qpoints->pMemcpy = art_quick_memcpy;
 
   // Invocation
@@ -224,6 +235,9 @@ void InitEntryPoints(InterpreterEntryPoints* ipoints, JniEntryPoints* jpoints,
   qpoints->pThrowNoSuchMethod = art_quick_throw_no_such_method;
   qpoints->pThrowNullPointer = art_quick_throw_null_pointer_exception;
   qpoints->pThrowStackOverflow = art_quick_throw_stack_overflow;
+
+  // Deoptimization
+  qpoints->pDeoptimize = art_quick_deoptimize_from_compiled_code;
 };
 
 }  // namespace art
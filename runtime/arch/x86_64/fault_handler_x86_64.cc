@@ -17,10 +17,12 @@
 
 #include "fault_handler.h"
 #include <sys/ucontext.h>
+#include "arch/x86/instruction_size_x86.h"
 #include "base/macros.h"
 #include "globals.h"
 #include "base/logging.h"
 #include "base/hex_dump.h"
+#include "mirror/art_method.h"
 
 
 //
@@ -29,12 +31,44 @@
 
 namespace art {
 
+extern "C" void art_quick_throw_null_pointer_exception();
+
 void FaultManager::GetMethodAndReturnPCAndSP(void* context, mirror::ArtMethod** out_method,
                                              uintptr_t* out_return_pc, uintptr_t* out_sp) {
+  ucontext_t* uc = reinterpret_cast<ucontext_t*>(context);
+  *out_sp = static_cast<uintptr_t>(uc->uc_mcontext.gregs[REG_RSP]);
+  VLOG(signals) << "sp: " << std::hex << *out_sp;
+  if (*out_sp == 0) {
+    return;
+  }
+
+  // The method is at the top of the stack.
+  *out_method = reinterpret_cast<mirror::ArtMethod*>(reinterpret_cast<uintptr_t*>(*out_sp)[0]);
+
+  // Work out the return PC, the address of the instruction following the faulting one, which
+  // the GC map of an implicit check is at. Without it the fault isn't looked at any further.
+  uint8_t* ptr = reinterpret_cast<uint8_t*>(uc->uc_mcontext.gregs[REG_RIP]);
+  VLOG(signals) << "pc: " << std::hex << static_cast<void*>(ptr);
+  uint32_t instr_size = GetX86InstructionSize(ptr, true);
+  *out_return_pc = (instr_size == 0) ? 0 : reinterpret_cast<uintptr_t>(ptr) + instr_size;
 }
 
 bool NullPointerHandler::Action(int sig, siginfo_t* info, void* context) {
-  return false;
+  // Make it look like the faulting instruction called art_quick_throw_null_pointer_exception,
+  // pushing the pc of the following instruction, where the GC map is, as the return address.
+  ucontext_t* uc = reinterpret_cast<ucontext_t*>(context);
+  uint8_t* ptr = reinterpret_cast<uint8_t*>(uc->uc_mcontext.gregs[REG_RIP]);
+  uint32_t instr_size = GetX86InstructionSize(ptr, true);
+  if (instr_size == 0) {
+    return false;
+  }
+  uintptr_t* sp = reinterpret_cast<uintptr_t*>(uc->uc_mcontext.gregs[REG_RSP]) - 1;
+  *sp = reinterpret_cast<uintptr_t>(ptr) + instr_size;
+  uc->uc_mcontext.gregs[REG_RSP] = reinterpret_cast<uintptr_t>(sp);
+  uc->uc_mcontext.gregs[REG_RIP] =
+      reinterpret_cast<uintptr_t>(art_quick_throw_null_pointer_exception);
+  VLOG(signals) << "Generating null pointer exception";
+  return true;
 }
 
 bool SuspensionHandler::Action(int sig, siginfo_t* info, void* context) {
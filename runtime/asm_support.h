@@ -27,10 +27,22 @@
 #define CLASS_OFFSET 0
 #define LOCK_WORD_OFFSET 4
 
+// Objects are allocated at multiples of kObjectAlignment.
+#define OBJECT_ALIGNMENT_MASK 7
+
+// Value of java.lang.Class.status for an initialized class.
+#define CLASS_STATUS_INITIALIZED 9
+
+// kAccClassIsFinalizable in java.lang.Class.accessFlags.
+#define ACCESS_FLAGS_CLASS_IS_FINALIZABLE 0x80000000
+
 #ifndef USE_BAKER_OR_BROOKS_READ_BARRIER
 
 // Offsets within java.lang.Class.
 #define CLASS_COMPONENT_TYPE_OFFSET 12
+#define CLASS_ACCESS_FLAGS_OFFSET 60
+#define CLASS_OBJECT_SIZE_OFFSET 88
+#define CLASS_STATUS_OFFSET 104
 
 // Array offsets.
 #define ARRAY_LENGTH_OFFSET 8
@@ -51,6 +63,9 @@
 
 // Offsets within java.lang.Class.
 #define CLASS_COMPONENT_TYPE_OFFSET 20
+#define CLASS_ACCESS_FLAGS_OFFSET 68
+#define CLASS_OBJECT_SIZE_OFFSET 96
+#define CLASS_STATUS_OFFSET 112
 
 // Array offsets.
 #define ARRAY_LENGTH_OFFSET 16
@@ -63,4 +63,18 @@ bool QuasiAtomic::SwapMutexCas64(int64_t old_value, int64_t new_value, volatile
   return false;
 }
 
+int64_t QuasiAtomic::SwapMutexFetchAndAdd64(volatile int64_t* addr, int64_t delta) {
+  MutexLock mu(Thread::Current(), *GetSwapMutex(addr));
+  int64_t prev = *addr;
+  *addr = prev + delta;
+  return prev;
+}
+
+int64_t QuasiAtomic::SwapMutexExchange64(volatile int64_t* addr, int64_t new_value) {
+  MutexLock mu(Thread::Current(), *GetSwapMutex(addr));
+  int64_t prev = *addr;
+  *addr = new_value;
+  return prev;
+}
+
 }  // namespace art
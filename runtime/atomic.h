@@ -194,6 +194,66 @@ class QuasiAtomic {
     }
   }
 
+  // Atomically add "delta" to the value at "addr" and return the previous value. The update is a
+  // single read-modify-write rather than a Read64 and Cas64 retry loop.
+  static int64_t FetchAndAdd64(volatile int64_t* addr, int64_t delta) {
+    if (!kNeedSwapMutexes) {
+#if defined(__arm__) && !defined(__LP64__)
+      int64_t prev;
+      int64_t sum;
+      int status;
+      MembarStoreLoad();
+      do {
+        __asm__ __volatile__("@ QuasiAtomic::FetchAndAdd64\n"
+          "ldrexd     %0, %H0, %3\n"
+          "adds       %Q1, %Q0, %Q4\n"
+          "adc        %R1, %R0, %R4\n"
+          "strexd     %2, %1, %H1, %3"
+          : "=&r" (prev), "=&r" (sum), "=&r" (status), "+Q" (*addr)
+          : "r" (delta)
+          : "cc");
+      } while (UNLIKELY(status != 0));
+      MembarStoreLoad();
+      return prev;
+#else
+      // A lock xadd on x86-64, an exclusive load/store loop on arm64 and a cmpxchg8b loop on x86.
+      return __sync_fetch_and_add(addr, delta);
+#endif
+    } else {
+      return SwapMutexFetchAndAdd64(addr, delta);
+    }
+  }
+
+  // Atomically replace the value at "addr" with "new_value" and return the previous value.
+  static int64_t Exchange64(volatile int64_t* addr, int64_t new_value) {
+    if (!kNeedSwapMutexes) {
+#if defined(__arm__) && !defined(__LP64__)
+      int64_t prev;
+      int status;
+      MembarStoreLoad();
+      do {
+        __asm__ __volatile__("@ QuasiAtomic::Exchange64\n"
+          "ldrexd     %0, %H0, %2\n"
+          "strexd     %1, %3, %H3, %2"
+          : "=&r" (prev), "=&r" (status), "+Q" (*addr)
+          : "r" (new_value)
+          : "cc");
+      } while (UNLIKELY(status != 0));
+      MembarStoreLoad();
+      return prev;
+#else
+      // __sync_lock_test_and_set is only an acquire barrier, use a full barrier compare and swap.
+      int64_t prev;
+      do {
+        prev = *addr;
+      } while (!__sync_bool_compare_and_swap(addr, prev, new_value));
+      return prev;
+#endif
+    } else {
+      return SwapMutexExchange64(addr, new_value);
+    }
+  }
+
   // Does the architecture provide reasonable atomic long operations or do we fall back on mutexes?
   static bool LongAtomicsUseMutexes() {
     return kNeedSwapMutexes;
@@ -252,6 +312,8 @@ class QuasiAtomic {
   static int64_t SwapMutexRead64(volatile const int64_t* addr);
   static void SwapMutexWrite64(volatile int64_t* addr, int64_t val);
   static bool SwapMutexCas64(int64_t old_value, int64_t new_value, volatile int64_t* addr);
+  static int64_t SwapMutexFetchAndAdd64(volatile int64_t* addr, int64_t delta);
+  static int64_t SwapMutexExchange64(volatile int64_t* addr, int64_t new_value);
 
   // We stripe across a bunch of different mutexes to reduce contention.
   static constexpr size_t kSwapMutexCount = 32;
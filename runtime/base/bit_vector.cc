@@ -32,6 +32,72 @@ static inline uint32_t BitsToWords(uint32_t bits) {
   return (bits + 31) >> 5;
 }
 
+// A range of bits of a sparse bit vector, with at least one bit set.
+struct BitVector::SparseElement {
+  SparseElement* next;
+  uint32_t index;  // The index of its first word is index * kSparseElementWords.
+  uint32_t words[kSparseElementWords];
+};
+
+// Iterates over the words of a bit vector which have bits set, in increasing order.
+class BitVector::WordIterator {
+  public:
+    explicit WordIterator(const BitVector* bit_vector)
+      : bit_vector_(bit_vector), element_(bit_vector->sparse_head_), word_(0) {
+      SkipZeroWords();
+    }
+
+    bool Done() const {
+      return bit_vector_->sparse_ ? element_ == nullptr : word_ >= bit_vector_->storage_size_;
+    }
+
+    uint32_t Index() const {
+      return bit_vector_->sparse_ ? element_->index * kSparseElementWords + word_ : word_;
+    }
+
+    uint32_t Word() const {
+      return bit_vector_->sparse_ ? element_->words[word_] : bit_vector_->storage_[word_];
+    }
+
+    void Advance() {
+      ++word_;
+      SkipZeroWords();
+    }
+
+    // Returns the word at word_index, advancing to it. Successive calls must use increasing
+    // word indexes.
+    uint32_t WordAt(uint32_t word_index) {
+      while (!Done() && Index() < word_index) {
+        Advance();
+      }
+      return (!Done() && Index() == word_index) ? Word() : 0u;
+    }
+
+  private:
+    void SkipZeroWords() {
+      if (!bit_vector_->sparse_) {
+        while (word_ < bit_vector_->storage_size_ && bit_vector_->storage_[word_] == 0) {
+          ++word_;
+        }
+        return;
+      }
+      while (element_ != nullptr) {
+        while (word_ < kSparseElementWords && element_->words[word_] == 0) {
+          ++word_;
+        }
+        if (word_ < kSparseElementWords) {
+          return;
+        }
+        element_ = element_->next;
+        word_ = 0;
+      }
+    }
+
+    const BitVector* const bit_vector_;
+    const SparseElement* element_;
+    uint32_t word_;  // Index in the raw storage, or in the words of element_.
+};
+
 // TODO: replace excessive argument defaulting when we are at gcc 4.7
 // or later on host with delegating constructor support. Specifically,
 // starts_bits and storage_size/storage are mutually exclusive.
@@ -39,27 +105,112 @@ BitVector::BitVector(uint32_t start_bits,
                      bool expandable,
                      Allocator* allocator,
                      uint32_t storage_size,
-                     uint32_t* storage)
+                     uint32_t* storage,
+                     bool sparse)
   : allocator_(allocator),
     expandable_(expandable),
     storage_size_(storage_size),
     storage_(storage),
-    number_of_bits_(start_bits) {
+    number_of_bits_(start_bits),
+    sparse_(sparse),
+    sparse_head_(nullptr) {
   DCHECK_EQ(sizeof(*storage_), 4U);  // Assuming 32-bit units.
-  if (storage_ == nullptr) {
+  if (sparse_) {
+    DCHECK(storage_ == nullptr);
+    storage_size_ = 0;
+  } else if (storage_ == nullptr) {
     storage_size_ = BitsToWords(start_bits);
     storage_ = static_cast<uint32_t*>(allocator_->Alloc(storage_size_ * sizeof(*storage_)));
   }
 }
 
 BitVector::~BitVector() {
+  ClearAllBits();
   allocator_->Free(storage_);
 }
 
+BitVector::SparseElement* BitVector::FindSparseElement(uint32_t index) const {
+  for (SparseElement* element = sparse_head_; element != nullptr; element = element->next) {
+    if (element->index >= index) {
+      return (element->index == index) ? element : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+BitVector::SparseElement* BitVector::GetOrAddSparseElement(uint32_t index, SparseElement* hint) {
+  DCHECK(hint == nullptr || hint->index <= index);
+  if (hint != nullptr && hint->index == index) {
+    return hint;
+  }
+  SparseElement* prev = hint;
+  SparseElement* current = (hint != nullptr) ? hint->next : sparse_head_;
+  while (current != nullptr && current->index < index) {
+    prev = current;
+    current = current->next;
+  }
+  if (current != nullptr && current->index == index) {
+    return current;
+  }
+  SparseElement* element = static_cast<SparseElement*>(allocator_->Alloc(sizeof(SparseElement)));
+  memset(element, 0, sizeof(SparseElement));
+  element->index = index;
+  element->next = current;
+  if (prev == nullptr) {
+    sparse_head_ = element;
+  } else {
+    prev->next = element;
+  }
+  return element;
+}
+
+void BitVector::RemoveEmptySparseElements() {
+  SparseElement** link = &sparse_head_;
+  while (*link != nullptr) {
+    SparseElement* element = *link;
+    bool empty = true;
+    for (uint32_t i = 0; i < kSparseElementWords && empty; i++) {
+      empty = (element->words[i] == 0);
+    }
+    if (empty) {
+      *link = element->next;
+      allocator_->Free(element);
+    } else {
+      link = &element->next;
+    }
+  }
+}
+
+bool BitVector::OrWord(uint32_t word_index, uint32_t bits, SparseElement** hint) {
+  if (bits == 0) {
+    return false;
+  }
+  uint32_t* word;
+  if (sparse_) {
+    *hint = GetOrAddSparseElement(word_index / kSparseElementWords, *hint);
+    word = &(*hint)->words[word_index % kSparseElementWords];
+  } else {
+    DCHECK_LT(word_index, storage_size_);
+    word = &storage_[word_index];
+  }
+  uint32_t update = *word | bits;
+  if (update == *word) {
+    return false;
+  }
+  *word = update;
+  return true;
+}
+
 /*
  * Determine whether or not the specified bit is set.
  */
 bool BitVector::IsBitSet(uint32_t num) const {
+  if (sparse_) {
+    const SparseElement* element = FindSparseElement((num >> 5) / kSparseElementWords);
+    return element != nullptr &&
+        (element->words[(num >> 5) % kSparseElementWords] & check_masks[num & 0x1f]) != 0;
+  }
+
   // If the index is over the size:
   if (num >= storage_size_ * sizeof(*storage_) * 8) {
     // Whether it is expandable or not, this bit does not exist: thus it is not set.
@@ -71,6 +222,11 @@ bool BitVector::IsBitSet(uint32_t num) const {
 
 // Mark all bits bit as "clear".
 void BitVector::ClearAllBits() {
+  while (sparse_head_ != nullptr) {
+    SparseElement* element = sparse_head_;
+    sparse_head_ = element->next;
+    allocator_->Free(element);
+  }
   memset(storage_, 0, storage_size_ * sizeof(*storage_));
 }
 
@@ -80,28 +236,52 @@ void BitVector::ClearAllBits() {
  * not using it badly or change resize mechanism.
  */
 void BitVector::SetBit(uint32_t num) {
+  if (sparse_) {
+    if (num >= number_of_bits_) {
+      DCHECK(expandable_) << "Attempted to expand a non-expandable bitmap to position " << num;
+      number_of_bits_ = num + 1;
+    }
+    SparseElement* element = GetOrAddSparseElement((num >> 5) / kSparseElementWords, nullptr);
+    element->words[(num >> 5) % kSparseElementWords] |= check_masks[num & 0x1f];
+    return;
+  }
+
   if (num >= storage_size_ * sizeof(*storage_) * 8) {
-    DCHECK(expandable_) << "Attempted to expand a non-expandable bitmap to position " << num;
-
-    /* Round up to word boundaries for "num+1" bits */
-    uint32_t new_size = BitsToWords(num + 1);
-    DCHECK_GT(new_size, storage_size_);
-    uint32_t *new_storage =
-        static_cast<uint32_t*>(allocator_->Alloc(new_size * sizeof(*storage_)));
-    memcpy(new_storage, storage_, storage_size_ * sizeof(*storage_));
-    // Zero out the new storage words.
-    memset(&new_storage[storage_size_], 0, (new_size - storage_size_) * sizeof(*storage_));
-    // TOTO: collect stats on space wasted because of resize.
-    storage_ = new_storage;
-    storage_size_ = new_size;
-    number_of_bits_ = num;
+    ExpandToBit(num);
   }
 
   storage_[num >> 5] |= check_masks[num & 0x1f];
 }
 
+void BitVector::ExpandToBit(uint32_t num) {
+  DCHECK(!sparse_);
+  DCHECK(expandable_) << "Attempted to expand a non-expandable bitmap to position " << num;
+
+  /* Round up to word boundaries for "num+1" bits */
+  uint32_t new_size = BitsToWords(num + 1);
+  DCHECK_GT(new_size, storage_size_);
+  uint32_t *new_storage =
+      static_cast<uint32_t*>(allocator_->Alloc(new_size * sizeof(*storage_)));
+  memcpy(new_storage, storage_, storage_size_ * sizeof(*storage_));
+  // Zero out the new storage words.
+  memset(&new_storage[storage_size_], 0, (new_size - storage_size_) * sizeof(*storage_));
+  // TOTO: collect stats on space wasted because of resize.
+  storage_ = new_storage;
+  storage_size_ = new_size;
+  number_of_bits_ = num;
+}
+
 // Mark the specified bit as "unset".
 void BitVector::ClearBit(uint32_t num) {
+  if (sparse_) {
+    SparseElement* element = FindSparseElement((num >> 5) / kSparseElementWords);
+    if (element != nullptr) {
+      element->words[(num >> 5) % kSparseElementWords] &= ~check_masks[num & 0x1f];
+      RemoveEmptySparseElements();
+    }
+    return;
+  }
+
   // If the index is over the size, we don't have to do anything, it is cleared.
   if (num < storage_size_ * sizeof(*storage_) * 8) {
     // Otherwise, go ahead and clear it.
@@ -110,6 +290,18 @@ void BitVector::ClearBit(uint32_t num) {
 }
 
 bool BitVector::SameBitsSet(const BitVector *src) {
+  if (sparse_ || src->sparse_) {
+    // Both have the same words with bits set.
+    WordIterator it(this);
+    WordIterator src_it(src);
+    for (; !it.Done() && !src_it.Done(); it.Advance(), src_it.Advance()) {
+      if (it.Index() != src_it.Index() || it.Word() != src_it.Word()) {
+        return false;
+      }
+    }
+    return it.Done() && src_it.Done();
+  }
+
   int our_highest = GetHighestBitSet();
   int src_highest = src->GetHighestBitSet();
 
@@ -137,6 +329,23 @@ bool BitVector::SameBitsSet(const BitVector *src) {
 
 // Intersect with another bit vector.
 void BitVector::Intersect(const BitVector* src) {
+  if (sparse_ || src->sparse_) {
+    WordIterator src_it(src);
+    if (sparse_) {
+      for (SparseElement* element = sparse_head_; element != nullptr; element = element->next) {
+        for (uint32_t i = 0; i < kSparseElementWords; i++) {
+          element->words[i] &= src_it.WordAt(element->index * kSparseElementWords + i);
+        }
+      }
+      RemoveEmptySparseElements();
+    } else {
+      for (uint32_t idx = 0; idx < storage_size_; idx++) {
+        storage_[idx] &= src_it.WordAt(idx);
+      }
+    }
+    return;
+  }
+
   uint32_t src_storage_size = src->storage_size_;
 
   // Get the minimum size between us and source.
@@ -169,6 +378,17 @@ bool BitVector::Union(const BitVector* src) {
     return changed;
   }
 
+  if (sparse_ || src->sparse_) {
+    if (!sparse_ && static_cast<uint32_t>(highest_bit) >= storage_size_ * sizeof(*storage_) * 8) {
+      ExpandToBit(highest_bit);
+    }
+    SparseElement* hint = nullptr;
+    for (WordIterator it(src); !it.Done(); it.Advance()) {
+      changed |= OrWord(it.Index(), it.Word(), &hint);
+    }
+    return changed;
+  }
+
   // Update src_size to how many cells we actually care about: where the bit is + 1.
   uint32_t src_size = BitsToWords(highest_bit + 1);
 
@@ -204,6 +424,18 @@ bool BitVector::UnionIfNotIn(const BitVector* union_with, const BitVector* not_i
     return changed;
   }
 
+  if (sparse_ || union_with->sparse_ || not_in->sparse_) {
+    if (!sparse_ && static_cast<uint32_t>(highest_bit) >= storage_size_ * sizeof(*storage_) * 8) {
+      ExpandToBit(highest_bit);
+    }
+    WordIterator not_in_it(not_in);
+    SparseElement* hint = nullptr;
+    for (WordIterator it(union_with); !it.Done(); it.Advance()) {
+      changed |= OrWord(it.Index(), it.Word() & ~not_in_it.WordAt(it.Index()), &hint);
+    }
+    return changed;
+  }
+
   // Update union_with_size to how many cells we actually care about: where the bit is + 1.
   uint32_t union_with_size = BitsToWords(highest_bit + 1);
 
@@ -243,6 +475,23 @@ bool BitVector::UnionIfNotIn(const BitVector* union_with, const BitVector* not_i
 }
 
 void BitVector::Subtract(const BitVector *src) {
+    if (sparse_ || src->sparse_) {
+      WordIterator src_it(src);
+      if (sparse_) {
+        for (SparseElement* element = sparse_head_; element != nullptr; element = element->next) {
+          for (uint32_t i = 0; i < kSparseElementWords; i++) {
+            element->words[i] &= ~src_it.WordAt(element->index * kSparseElementWords + i);
+          }
+        }
+        RemoveEmptySparseElements();
+      } else {
+        for (; !src_it.Done() && src_it.Index() < storage_size_; src_it.Advance()) {
+          storage_[src_it.Index()] &= ~src_it.Word();
+        }
+      }
+      return;
+    }
+
     uint32_t src_size = src->storage_size_;
 
     // We only need to operate on bytes up to the smaller of the sizes of the two operands.
@@ -260,6 +509,12 @@ void BitVector::Subtract(const BitVector *src) {
 // Count the number of bits that are set.
 uint32_t BitVector::NumSetBits() const {
   uint32_t count = 0;
+  if (sparse_) {
+    for (WordIterator it(this); !it.Done(); it.Advance()) {
+      count += POPCOUNT(it.Word());
+    }
+    return count;
+  }
   for (uint32_t word = 0; word < storage_size_; word++) {
     count += POPCOUNT(storage_[word]);
   }
@@ -268,6 +523,17 @@ uint32_t BitVector::NumSetBits() const {
 
 // Count the number of bits that are set in range [0, end).
 uint32_t BitVector::NumSetBits(uint32_t end) const {
+  if (sparse_) {
+    uint32_t count = 0u;
+    for (WordIterator it(this); !it.Done() && it.Index() <= (end >> 5); it.Advance()) {
+      uint32_t word = it.Word();
+      if (it.Index() == (end >> 5)) {
+        word &= ~(0xffffffffu << (end & 0x1f));
+      }
+      count += POPCOUNT(word);
+    }
+    return count;
+  }
   DCHECK_LE(end, storage_size_ * sizeof(*storage_) * 8);
   return NumSetBits(storage_, end);
 }
@@ -288,6 +554,20 @@ void BitVector::SetInitialBits(uint32_t num_bits) {
     return;
   }
 
+  if (sparse_) {
+    ClearAllBits();
+    SparseElement* hint = nullptr;
+    for (uint32_t idx = 0; idx < BitsToWords(num_bits); idx++) {
+      uint32_t rem_num_bits = num_bits - idx * 32;
+      OrWord(idx, (rem_num_bits >= 32) ? 0xffffffffu : (1u << rem_num_bits) - 1, &hint);
+    }
+    if (num_bits > number_of_bits_) {
+      DCHECK(expandable_);
+      number_of_bits_ = num_bits;
+    }
+    return;
+  }
+
   // Set the highest bit we want to set to get the BitVector allocated if need be.
   SetBit(num_bits - 1);
 
@@ -311,6 +591,23 @@ void BitVector::SetInitialBits(uint32_t num_bits) {
 }
 
 int BitVector::GetHighestBitSet() const {
+  if (sparse_) {
+    const SparseElement* last = sparse_head_;
+    if (last == nullptr) {
+      return -1;
+    }
+    while (last->next != nullptr) {
+      last = last->next;
+    }
+    for (int i = kSparseElementWords - 1; i >= 0; i--) {
+      if (last->words[i] != 0) {
+        return (last->index * kSparseElementWords + i) * 32 + 31 - CLZ(last->words[i]);
+      }
+    }
+    LOG(FATAL) << "Empty sparse element";
+    return -1;
+  }
+
   unsigned int max = storage_size_;
   for (int idx = max - 1; idx >= 0; idx--) {
     // If not 0, we have more work: check the bits.
@@ -344,7 +641,10 @@ bool BitVector::EnsureSizeAndClear(unsigned int num) {
     return false;
   }
 
-  if (num > 0) {
+  if (sparse_) {
+    // There is no storage to expand.
+    number_of_bits_ = std::max(number_of_bits_, static_cast<uint32_t>(num));
+  } else if (num > 0) {
     // Now try to expand by setting the last bit.
     SetBit(num - 1);
   }
@@ -365,6 +665,21 @@ void BitVector::Copy(const BitVector *src) {
     return;
   }
 
+  if (sparse_ || src->sparse_) {
+    if (src == this) {
+      return;
+    }
+    ClearAllBits();
+    if (!sparse_ && static_cast<uint32_t>(highest_bit) >= storage_size_ * sizeof(*storage_) * 8) {
+      ExpandToBit(highest_bit);
+    }
+    SparseElement* hint = nullptr;
+    for (WordIterator it(src); !it.Done(); it.Advance()) {
+      OrWord(it.Index(), it.Word(), &hint);
+    }
+    return;
+  }
+
   // Set upper bit to ensure right size before copy.
   SetBit(highest_bit);
 
@@ -399,6 +714,24 @@ uint32_t BitVector::NumSetBits(const uint32_t* storage, uint32_t end) {
   return count;
 }
 
+int32_t BitVector::Iterator::NextSparse() {
+  static constexpr uint32_t kElementBits = kSparseElementWords * 32;
+  while (element_ != nullptr) {
+    uint32_t first_bit = element_->index * kElementBits;
+    bit_index_ = std::max(bit_index_, first_bit);
+    while (bit_index_ < first_bit + kElementBits) {
+      uint32_t word = element_->words[(bit_index_ - first_bit) >> 5] >> (bit_index_ & 0x1f);
+      if (word != 0) {
+        bit_index_ += CTZ(word) + 1;
+        return bit_index_ - 1;
+      }
+      bit_index_ = (bit_index_ | 0x1f) + 1;
+    }
+    element_ = element_->next;
+  }
+  return -1;
+}
+
 void BitVector::Dump(std::ostream& os, const char *prefix) const {
   std::ostringstream buffer;
   DumpHelper(buffer, prefix);
@@ -29,8 +29,15 @@ namespace art {
 /*
  * Expanding bitmap, used for tracking resources.  Bits are numbered starting
  * from zero.  All operations on a BitVector are unsynchronized.
+ *
+ * A sparse bit vector only allocates the ranges of bits which have bits set, in
+ * a sorted list. It has no raw storage, and any operation may mix dense and
+ * sparse bit vectors.
  */
 class BitVector {
+  private:
+    struct SparseElement;
+
   public:
     class Iterator {
       public:
@@ -38,10 +45,14 @@ class BitVector {
           : p_bits_(bit_vector),
             bit_storage_(bit_vector->GetRawStorage()),
             bit_index_(0),
-            bit_size_(p_bits_->storage_size_ * sizeof(uint32_t) * 8) {}
+            bit_size_(p_bits_->storage_size_ * sizeof(uint32_t) * 8),
+            element_(bit_vector->sparse_head_) {}
 
         // Return the position of the next set bit.  -1 means end-of-element reached.
         int32_t Next() {
+          if (p_bits_->sparse_) {
+            return NextSparse();
+          }
           // Did anything obviously change since we started?
           DCHECK_EQ(bit_size_, p_bits_->GetStorageSize() * sizeof(uint32_t) * 8);
           DCHECK_EQ(bit_storage_, p_bits_->GetRawStorage());
@@ -79,10 +90,13 @@ class BitVector {
         }
 
       private:
+        int32_t NextSparse();
+
         const BitVector* const p_bits_;
         const uint32_t* const bit_storage_;
         uint32_t bit_index_;           // Current index (size in bits).
         const uint32_t bit_size_;      // Size of vector in bits.
+        const SparseElement* element_;  // Sparse element holding bit_index_, or the next one.
 
         friend class BitVector;
     };
@@ -91,7 +105,8 @@ class BitVector {
               bool expandable,
               Allocator* allocator,
               uint32_t storage_size = 0,
-              uint32_t* storage = nullptr);
+              uint32_t* storage = nullptr,
+              bool sparse = false);
 
     virtual ~BitVector();
 
@@ -111,6 +126,9 @@ class BitVector {
     void Subtract(const BitVector* src);
     // Are we equal to another bit vector?  Note: expandability attributes must also match.
     bool Equal(const BitVector* src) {
+      if (sparse_ || src->sparse_) {
+        return (expandable_ == src->IsExpandable()) && SameBitsSet(src);
+      }
       return (storage_size_ == src->GetStorageSize()) &&
         (expandable_ == src->IsExpandable()) &&
         (memcmp(storage_, src->GetRawStorage(), storage_size_ * sizeof(uint32_t)) == 0);
@@ -129,8 +147,10 @@ class BitVector {
 
     Iterator* GetIterator() const;
 
+    // The raw storage of a sparse bit vector is empty.
     uint32_t GetStorageSize() const { return storage_size_; }
     bool IsExpandable() const { return expandable_; }
+    bool IsSparse() const { return sparse_; }
     uint32_t GetRawStorageWord(size_t idx) const { return storage_[idx]; }
     uint32_t* GetRawStorage() { return storage_; }
     const uint32_t* GetRawStorage() const { return storage_; }
@@ -155,11 +175,33 @@ class BitVector {
     void DumpHelper(std::ostringstream& buffer, const char* prefix) const;
 
   private:
+    class WordIterator;
+
+    // Number of 32-bit words in a sparse element.
+    static constexpr uint32_t kSparseElementWords = 4;
+
+    // Grows the raw storage to hold bit num.
+    void ExpandToBit(uint32_t num);
+
+    // ORs bits into the 32-bit word at word_index, which the raw storage must already hold, and
+    // returns whether it changed. For a sparse bit vector, hint is the last element returned, and
+    // successive calls must use increasing word indexes to walk the list only once.
+    bool OrWord(uint32_t word_index, uint32_t bits, SparseElement** hint);
+
+    SparseElement* FindSparseElement(uint32_t index) const;
+    // Returns the element with the given index, adding it if needed. The search starts after hint,
+    // which precedes the element or is it, or at the head if hint is null.
+    SparseElement* GetOrAddSparseElement(uint32_t index, SparseElement* hint);
+    // Unlinks the sparse elements which have no bits set.
+    void RemoveEmptySparseElements();
+
     Allocator* const allocator_;
     const bool expandable_;         // expand bitmap if we run out?
     uint32_t   storage_size_;       // current size, in 32-bit words.
     uint32_t*  storage_;
     uint32_t number_of_bits_;
+    const bool sparse_;
+    SparseElement* sparse_head_;    // Sparse elements, sorted by index.
 };
 
 
@@ -139,4 +139,61 @@ TEST(BitVector, SetInitialBits) {
   EXPECT_EQ(64u, bv.NumSetBits());
 }
 
+TEST(BitVector, Sparse) {
+  const uint32_t kBits = 4096;
+
+  BitVector bv(kBits, false, Allocator::GetMallocAllocator(), 0U, nullptr, true);
+  EXPECT_TRUE(bv.IsSparse());
+  EXPECT_EQ(0U, bv.GetStorageSize());
+  EXPECT_EQ(0U, bv.NumSetBits());
+  EXPECT_EQ(-1, bv.GetHighestBitSet());
+
+  bv.SetBit(3);
+  bv.SetBit(1000);
+  bv.SetBit(kBits - 1);
+  EXPECT_EQ(3U, bv.NumSetBits());
+  EXPECT_EQ(1U, bv.NumSetBits(1000));
+  EXPECT_EQ(2U, bv.NumSetBits(1001));
+  EXPECT_TRUE(bv.IsBitSet(1000));
+  EXPECT_FALSE(bv.IsBitSet(1001));
+  EXPECT_EQ(static_cast<int>(kBits - 1), bv.GetHighestBitSet());
+
+  BitVector::Iterator iterator(&bv);
+  EXPECT_EQ(3, iterator.Next());
+  EXPECT_EQ(1000, iterator.Next());
+  EXPECT_EQ(static_cast<int>(kBits - 1), iterator.Next());
+  EXPECT_EQ(-1, iterator.Next());
+
+  bv.ClearBit(kBits - 1);
+  EXPECT_EQ(1000, bv.GetHighestBitSet());
+
+  // Mix it with a dense bit vector.
+  BitVector dense(kBits, false, Allocator::GetMallocAllocator());
+  dense.SetBit(3);
+  dense.SetBit(2000);
+  EXPECT_TRUE(bv.Union(&dense));
+  EXPECT_FALSE(bv.Union(&dense));
+  EXPECT_EQ(3U, bv.NumSetBits());
+  EXPECT_TRUE(bv.IsBitSet(2000));
+
+  bv.Subtract(&dense);
+  EXPECT_EQ(1U, bv.NumSetBits());
+  EXPECT_TRUE(bv.IsBitSet(1000));
+
+  EXPECT_TRUE(dense.UnionIfNotIn(&bv, &dense));
+  EXPECT_EQ(3U, dense.NumSetBits());
+  dense.Intersect(&bv);
+  EXPECT_TRUE(dense.SameBitsSet(&bv));
+  EXPECT_TRUE(bv.SameBitsSet(&dense));
+
+  BitVector copy(kBits, false, Allocator::GetMallocAllocator(), 0U, nullptr, true);
+  copy.Copy(&dense);
+  EXPECT_TRUE(copy.Equal(&bv));
+  copy.SetInitialBits(100);
+  EXPECT_EQ(100U, copy.NumSetBits());
+  EXPECT_EQ(99, copy.GetHighestBitSet());
+  copy.ClearAllBits();
+  EXPECT_EQ(0U, copy.NumSetBits());
+}
+
 }  // namespace art
@@ -161,6 +161,17 @@ inline void Histogram<Value>::PrintBins(std::ostream& os, const CumulativeData&
   }
 }
 
+template <class Value>
+inline void Histogram<Value>::DumpBins(std::ostream& os) const {
+  bool first = true;
+  for (size_t bin_idx = 0; bin_idx < frequency_.size(); ++bin_idx) {
+    if (frequency_[bin_idx] != 0) {
+      os << (first ? "" : ",") << GetRange(bin_idx) << ":" << frequency_[bin_idx];
+      first = false;
+    }
+  }
+}
+
 template <class Value>
 inline void Histogram<Value>::PrintConfidenceIntervals(std::ostream &os, double interval,
                                                        const CumulativeData& data) const {
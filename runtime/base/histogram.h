@@ -60,6 +60,8 @@ template <class Value> class Histogram {
   void PrintConfidenceIntervals(std::ostream& os, double interval,
                                 const CumulativeData& data) const;
   void PrintBins(std::ostream& os, const CumulativeData& data) const;
+  // Prints the non-empty buckets as a comma separated list of bucket start:frequency pairs.
+  void DumpBins(std::ostream& os) const;
   Value GetRange(size_t bucket_idx) const;
   size_t GetBucketCount() const;
 
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "latency_histogram.h"
+
+#include <algorithm>
+
+namespace art {
+
+void LatencyHistogram::Add(const LatencyHistogram& other) {
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+  sum_ += other.sum_;
+  max_ = std::max(max_, other.max_);
+}
+
+void LatencyHistogram::Clear() {
+  std::fill(counts_, counts_ + kNumBuckets, 0U);
+  count_ = 0;
+  sum_ = 0;
+  max_ = 0;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  size_t high_bit = index / kSubBuckets + kSubBucketBits - 1;
+  size_t sub_bucket = index % kSubBuckets;
+  uint64_t width = UINT64_C(1) << (high_bit - kSubBucketBits);
+  return (UINT64_C(1) << high_bit) + (sub_bucket + 1) * width - 1;
+}
+
+uint64_t LatencyHistogram::Percentile(double fraction) const {
+  // The bucket counts and the total may disagree when read while the owner records values.
+  uint64_t total = 0;
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    total += counts_[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+  uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(fraction * total + 0.5), 1);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return std::min(BucketUpperBound(i), max_);
+    }
+  }
+  return max_;
+}
+
+void LatencyHistogram::Dump(std::ostream& os) const {
+  os << "count=" << count_;
+  if (count_ != 0) {
+    os << " mean=" << sum_ / count_ << " p50=" << Percentile(0.5) << " p90=" << Percentile(0.9)
+       << " p99=" << Percentile(0.99) << " max=" << max_;
+  }
+}
+
+}  // namespace art
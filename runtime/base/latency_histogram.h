@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_BASE_LATENCY_HISTOGRAM_H_
+#define ART_RUNTIME_BASE_LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>
+
+#include <ostream>
+
+#include "base/macros.h"
+
+namespace art {
+
+// A histogram of latencies with fixed log-linear buckets: each power of two range of values is
+// split in kSubBuckets buckets, so a value is known to within 25% of itself. Unlike Histogram,
+// recording a value doesn't allocate nor lock. It is meant to be owned by a thread which records
+// its values with plain stores, readers merge it into their own copy and may miss the latest
+// values.
+class LatencyHistogram {
+ public:
+  LatencyHistogram() {
+    Clear();
+  }
+
+  void Record(uint64_t value) {
+    ++counts_[BucketIndex(value)];
+    ++count_;
+    sum_ += value;
+    if (value > max_) {
+      max_ = value;
+    }
+  }
+
+  void Add(const LatencyHistogram& other);
+  void Clear();
+
+  uint64_t GetCount() const {
+    return count_;
+  }
+
+  uint64_t GetSum() const {
+    return sum_;
+  }
+
+  uint64_t GetMax() const {
+    return max_;
+  }
+
+  // Returns the upper bound of the bucket holding the given percentile, in [0, 1], of the values.
+  uint64_t Percentile(double fraction) const;
+
+  // Prints the count, mean, median, 90th and 99th percentiles and maximum of the values.
+  void Dump(std::ostream& os) const;
+
+  static size_t BucketIndex(uint64_t value) {
+    if (value < kSubBuckets) {
+      return value;
+    }
+    size_t high_bit = 63 - __builtin_clzll(value);
+    if (high_bit >= kMaxValueBits) {
+      return kNumBuckets - 1;
+    }
+    size_t sub_bucket = (value >> (high_bit - kSubBucketBits)) & (kSubBuckets - 1);
+    return (high_bit - kSubBucketBits + 1) * kSubBuckets + sub_bucket;
+  }
+
+  static uint64_t BucketUpperBound(size_t index);
+
+  static constexpr size_t kSubBucketBits = 2;
+  static constexpr size_t kSubBuckets = 1 << kSubBucketBits;
+  // Larger values, over 18 minutes in nanoseconds, are counted in the last bucket.
+  static constexpr size_t kMaxValueBits = 40;
+  static constexpr size_t kNumBuckets = (kMaxValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+ private:
+  uint32_t counts_[kNumBuckets];
+  uint64_t count_;
+  uint64_t sum_;
+  uint64_t max_;
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_BASE_LATENCY_HISTOGRAM_H_
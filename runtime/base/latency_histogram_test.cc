@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "latency_histogram.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+TEST(LatencyHistogramTest, BucketIndex) {
+  for (uint64_t value = 0; value < 4; ++value) {
+    EXPECT_EQ(value, LatencyHistogram::BucketIndex(value));
+  }
+  // Every bucket holds the values up to its upper bound and above the previous one's.
+  for (size_t i = 1; i < LatencyHistogram::kNumBuckets; ++i) {
+    uint64_t upper_bound = LatencyHistogram::BucketUpperBound(i);
+    uint64_t lower_bound = LatencyHistogram::BucketUpperBound(i - 1) + 1;
+    EXPECT_EQ(i, LatencyHistogram::BucketIndex(lower_bound));
+    EXPECT_EQ(i, LatencyHistogram::BucketIndex(upper_bound));
+  }
+  EXPECT_EQ(LatencyHistogram::kNumBuckets - 1, LatencyHistogram::BucketIndex(UINT64_MAX));
+}
+
+TEST(LatencyHistogramTest, Percentile) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0U, histogram.Percentile(0.5));
+  for (uint64_t value = 1; value <= 100; ++value) {
+    histogram.Record(value * 1000);
+  }
+  EXPECT_EQ(100U, histogram.GetCount());
+  EXPECT_EQ(5050000U, histogram.GetSum());
+  EXPECT_EQ(100000U, histogram.GetMax());
+  // The percentiles are bucket upper bounds, within 25% of the values.
+  uint64_t median = histogram.Percentile(0.5);
+  EXPECT_LE(50000U, median);
+  EXPECT_GE(62500U, median);
+  EXPECT_EQ(100000U, histogram.Percentile(1.0));
+}
+
+TEST(LatencyHistogramTest, Add) {
+  LatencyHistogram first;
+  LatencyHistogram second;
+  first.Record(10);
+  second.Record(20);
+  second.Record(1000);
+  first.Add(second);
+  EXPECT_EQ(3U, first.GetCount());
+  EXPECT_EQ(1030U, first.GetSum());
+  EXPECT_EQ(1000U, first.GetMax());
+  first.Clear();
+  EXPECT_EQ(0U, first.GetCount());
+  EXPECT_EQ(0U, first.Percentile(0.99));
+}
+
+}  // namespace art
@@ -160,13 +160,8 @@ void BaseMutex::CheckSafeToWait(Thread* self) {
 inline void BaseMutex::ContentionLogData::AddToWaitTime(uint64_t value) {
   if (kLogLockContentions) {
     // Atomically add value to wait_time.
-    uint64_t new_val, old_val;
     volatile int64_t* addr = reinterpret_cast<volatile int64_t*>(&wait_time);
-    volatile const int64_t* caddr = const_cast<volatile const int64_t*>(addr);
-    do {
-      old_val = static_cast<uint64_t>(QuasiAtomic::Read64(caddr));
-      new_val = old_val + value;
-    } while (!QuasiAtomic::Cas64(static_cast<int64_t>(old_val), static_cast<int64_t>(new_val), addr));
+    QuasiAtomic::FetchAndAdd64(addr, static_cast<int64_t>(value));
   }
 }
 
@@ -177,11 +172,17 @@ void BaseMutex::RecordContention(uint64_t blocked_tid,
     ContentionLogData* data = contetion_log_data_;
     ++(data->contention_count);
     data->AddToWaitTime(nano_time_blocked);
+    size_t bucket = 0;
+    for (uint64_t us = nano_time_blocked / 1000; us != 0 && bucket + 1 < kContentionWaitTimeBuckets;
+         us >>= 1) {
+      ++bucket;
+    }
+    ++data->wait_time_histogram[bucket];
     ContentionLogEntry* log = data->contention_log;
     // This code is intentionally racy as it is only used for diagnostics.
     uint32_t slot = data->cur_content_log_entry;
     if (log[slot].blocked_tid == blocked_tid &&
-        log[slot].owner_tid == blocked_tid) {
+        log[slot].owner_tid == owner_tid) {
       ++log[slot].count;
     } else {
       uint32_t new_slot;
@@ -251,6 +252,18 @@ void BaseMutex::DumpContention(std::ostream& os) const {
       if (max_tid != 0) {
         os << " sample shows tid=" << max_tid << " owning during this time";
       }
+      os << " waits (us):";
+      for (size_t i = 0; i < kContentionWaitTimeBuckets; ++i) {
+        uint32_t count = data->wait_time_histogram[i];
+        if (count == 0) {
+          continue;
+        }
+        if (i + 1 == kContentionWaitTimeBuckets) {
+          os << " >=" << (UINT64_C(1) << (i - 1)) << ":" << count;
+        } else {
+          os << " <" << (UINT64_C(1) << i) << ":" << count;
+        }
+      }
     }
   }
 }
@@ -61,6 +61,7 @@ enum LockLevel {
   kRosAllocGlobalLock,
   kRosAllocBracketLock,
   kRosAllocBulkFreeLock,
+  kBumpPointerSpaceBlockLock,
   kAllocSpaceLock,
   kReferenceProcessorLock,
   kDexFileMethodInlinerLock,
@@ -107,6 +108,9 @@ const bool kLogLockContentions = false;
 const bool kLogLockContentions = false;
 #endif
 const size_t kContentionLogSize = 4;
+// Contention wait times are counted in buckets of powers of two microseconds, the last one
+// counting all the longer waits.
+const size_t kContentionWaitTimeBuckets = 16;
 const size_t kContentionLogDataSize = kLogLockContentions ? 1 : 0;
 const size_t kAllMutexDataSize = kLogLockContentions ? 1 : 0;
 
@@ -157,6 +161,8 @@ class BaseMutex {
     AtomicInteger contention_count;
     // Sum of time waited by all contenders in ns.
     volatile uint64_t wait_time;
+    // Number of contentions which waited [2^(i-1), 2^i) us in bucket i, under 1us in bucket 0.
+    AtomicInteger wait_time_histogram[kContentionWaitTimeBuckets];
     void AddToWaitTime(uint64_t value);
     ContentionLogData() : wait_time(0) {}
   };
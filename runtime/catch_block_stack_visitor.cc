@@ -18,6 +18,7 @@
 
 #include "dex_instruction.h"
 #include "mirror/art_method-inl.h"
+#include "object_utils.h"
 #include "quick_exception_handler.h"
 #include "handle_scope-inl.h"
 #include "verifier/method_verifier.h"
@@ -44,11 +45,17 @@ bool CatchBlockStackVisitor::VisitFrame() {
 }
 
 bool CatchBlockStackVisitor::HandleTryItems(mirror::ArtMethod* method) {
-  uint32_t dex_pc = DexFile::kDexNoIndex;
-  if (!method->IsNative()) {
-    dex_pc = GetDexPc();
+  if (method->IsNative() || method->IsProxyMethod()) {
+    return true;  // Continue stack walk.
   }
-  if (dex_pc != DexFile::kDexNoIndex) {
+  // Most frames unwound are of methods without any try item, don't map their pc to a dex pc.
+  const DexFile::CodeItem* code_item = MethodHelper(method).GetCodeItem();
+  if (code_item == nullptr || code_item->tries_size_ == 0) {
+    return true;  // Continue stack walk.
+  }
+  uint32_t dex_pc = GetDexPc();
+  // Nor look for a catch block, setting the exception aside, outside of the try items.
+  if (dex_pc != DexFile::kDexNoIndex && DexFile::FindTryItem(*code_item, dex_pc) != -1) {
     bool clear_exception = false;
     bool exc_changed = false;
     StackHandleScope<1> hs(Thread::Current());
@@ -153,6 +153,7 @@ class ScopedCheck {
       SHARED_LOCK_FUNCTION(Locks::mutator_lock_)
       : soa_(env) {
     Init(flags, functionName, true);
+    check_arguments_ = ShouldSampleCall(soa_.Env(), soa_.Vm());
     CheckThread(flags);
   }
 
@@ -162,6 +163,7 @@ class ScopedCheck {
       SHARED_LOCK_FUNCTION(Locks::mutator_lock_)
       : soa_(vm) {
     Init(kFlag_Invocation, functionName, has_method);
+    check_arguments_ = true;
   }
 
   ~ScopedCheck() UNLOCK_FUNCTION(Locks::mutator_lock_) {}
@@ -542,12 +544,15 @@ class ScopedCheck {
       }
     }
 
-    // We always do the thorough checks on entry, and never on exit...
+    // We always do the thorough checks on entry, and never on exit... The checks which look at the
+    // objects are only done for the sampled calls.
     if (entry) {
       va_start(ap, fmt0);
       for (const char* fmt = fmt0; *fmt; ++fmt) {
         char ch = *fmt;
-        if (ch == 'a') {
+        if (!check_arguments_ && strchr("acLsu", ch) != nullptr) {
+          va_arg(ap, void*);  // Skip this argument.
+        } else if (ch == 'a') {
           CheckArray(va_arg(ap, jarray));
         } else if (ch == 'c') {
           CheckInstance(kClass, va_arg(ap, jclass));
@@ -667,6 +672,17 @@ class ScopedCheck {
     has_method_ = has_method;
   }
 
+  // Returns whether the object arguments of this JNIEnv call are checked: with
+  // -XX:CheckJniSamplingInterval=N, those of one call in N are.
+  static bool ShouldSampleCall(JNIEnvExt* env, JavaVMExt* vm) {
+    if (LIKELY(env->check_jni_calls_until_sample == 0)) {
+      env->check_jni_calls_until_sample = vm->check_jni_sampling_interval - 1;
+      return true;
+    }
+    --env->check_jni_calls_until_sample;
+    return false;
+  }
+
   /*
    * Verify that "array" is non-NULL and points to an Array object.
    *
@@ -882,6 +898,7 @@ class ScopedCheck {
   const char* function_name_;
   int flags_;
   bool has_method_;
+  bool check_arguments_;
   int indent_;
 
   DISALLOW_COPY_AND_ASSIGN(ScopedCheck);
@@ -28,11 +28,13 @@
 #include "base/casts.h"
 #include "base/logging.h"
 #include "base/stl_util.h"
+#include "base/systrace.h"
 #include "base/unix_file/fd_file.h"
 #include "class_linker-inl.h"
 #include "compiler_callbacks.h"
 #include "debugger.h"
 #include "dex_file-inl.h"
+#include "dex_instruction-inl.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/accounting/heap_bitmap.h"
 #include "gc/heap.h"
@@ -40,6 +42,7 @@
 #include "handle_scope.h"
 #include "intern_table.h"
 #include "interpreter/interpreter.h"
+#include "jit/jit.h"
 #include "leb128.h"
 #include "oat.h"
 #include "oat_file.h"
@@ -56,6 +59,8 @@
 #include "mirror/stack_trace_element.h"
 #include "object_utils.h"
 #include "os.h"
+#include "perf_map.h"
+#include "resolved_field_cache.h"
 #include "runtime.h"
 #include "entrypoints/entrypoint_utils.h"
 #include "ScopedLocalRef.h"
@@ -561,8 +566,19 @@ void ClassLinker::RunRootClinits() {
 bool ClassLinker::GenerateOatFile(const char* dex_filename,
                                   int oat_fd,
                                   const char* oat_cache_filename,
+                                  bool verify_only,
                                   std::string* error_msg) {
   Locks::mutator_lock_->AssertNotHeld(Thread::Current());  // Avoid starving GC.
+  std::vector<std::string> argv;
+  GetDex2OatArguments(dex_filename, oat_fd, oat_cache_filename, verify_only, &argv);
+  return Exec(argv, error_msg);
+}
+
+void ClassLinker::GetDex2OatArguments(const char* dex_filename,
+                                      int oat_fd,
+                                      const char* oat_cache_filename,
+                                      bool verify_only,
+                                      std::vector<std::string>* argv) {
   std::string dex2oat(GetAndroidRoot());
   dex2oat += (kIsDebugBuild ? "/bin/dex2oatd" : "/bin/dex2oat");
 
@@ -579,48 +595,55 @@ bool ClassLinker::GenerateOatFile(const char* dex_filename,
   std::string oat_location_option("--oat-location=");
   oat_location_option += oat_cache_filename;
 
-  std::vector<std::string> argv;
-  argv.push_back(dex2oat);
-  argv.push_back("--runtime-arg");
-  argv.push_back("-Xms64m");
-  argv.push_back("--runtime-arg");
-  argv.push_back("-Xmx64m");
-  argv.push_back("--runtime-arg");
-  argv.push_back("-classpath");
-  argv.push_back("--runtime-arg");
-  argv.push_back(Runtime::Current()->GetClassPathString());
-
-  Runtime::Current()->AddCurrentRuntimeFeaturesAsDex2OatArguments(&argv);
+  argv->push_back(dex2oat);
+  argv->push_back("--runtime-arg");
+  argv->push_back("-Xms64m");
+  argv->push_back("--runtime-arg");
+  argv->push_back("-Xmx64m");
+  argv->push_back("--runtime-arg");
+  argv->push_back("-classpath");
+  argv->push_back("--runtime-arg");
+  argv->push_back(Runtime::Current()->GetClassPathString());
+
+  Runtime::Current()->AddCurrentRuntimeFeaturesAsDex2OatArguments(argv);
 
   if (!Runtime::Current()->IsVerificationEnabled()) {
-    argv.push_back("--compiler-filter=verify-none");
+    argv->push_back("--compiler-filter=verify-none");
   }
 
   if (!kIsTargetBuild) {
-    argv.push_back("--host");
+    argv->push_back("--host");
   }
 
-  argv.push_back(boot_image_option);
-  argv.push_back(dex_file_option);
-  argv.push_back(oat_fd_option);
-  argv.push_back(oat_location_option);
+  argv->push_back(boot_image_option);
+  argv->push_back(dex_file_option);
+  argv->push_back(oat_fd_option);
+  argv->push_back(oat_location_option);
   const std::vector<std::string>& compiler_options = Runtime::Current()->GetCompilerOptions();
   for (size_t i = 0; i < compiler_options.size(); ++i) {
-    argv.push_back(compiler_options[i].c_str());
+    argv->push_back(compiler_options[i].c_str());
+  }
+  if (verify_only && Runtime::Current()->IsVerificationEnabled()) {
+    // Overrides the filter of the compiler options.
+    argv->push_back("--compiler-filter=interpret-only");
   }
-
-  return Exec(argv, error_msg);
 }
 
 const OatFile* ClassLinker::RegisterOatFile(const OatFile* oat_file) {
-  WriterMutexLock mu(Thread::Current(), dex_lock_);
-  if (kIsDebugBuild) {
-    for (size_t i = 0; i < oat_files_.size(); ++i) {
-      CHECK_NE(oat_file, oat_files_[i]) << oat_file->GetLocation();
+  {
+    WriterMutexLock mu(Thread::Current(), dex_lock_);
+    if (kIsDebugBuild) {
+      for (size_t i = 0; i < oat_files_.size(); ++i) {
+        CHECK_NE(oat_file, oat_files_[i]) << oat_file->GetLocation();
+      }
     }
+    VLOG(class_linker) << "Registering " << oat_file->GetLocation();
+    oat_files_.push_back(oat_file);
+  }
+  PerfMap* perf_map = Runtime::Current()->GetPerfMap();
+  if (perf_map != nullptr) {
+    perf_map->AddOatFile(oat_file);
   }
-  VLOG(class_linker) << "Registering " << oat_file->GetLocation();
-  oat_files_.push_back(oat_file);
   return oat_file;
 }
 
@@ -761,6 +784,72 @@ class ScopedFlock {
   DISALLOW_COPY_AND_ASSIGN(ScopedFlock);
 };
 
+// A dex2oat run started by StartBackgroundDex2Oat. The thread running it is not attached, it
+// must not use the runtime.
+struct BackgroundDex2Oat {
+  std::vector<std::string> argv;
+  std::unique_ptr<File> file;
+  std::string temp_location;
+  std::string oat_location;
+};
+
+static void* RunBackgroundDex2Oat(void* arg) {
+  std::unique_ptr<BackgroundDex2Oat> job(reinterpret_cast<BackgroundDex2Oat*>(arg));
+  std::string error_msg;
+  bool success = Exec(job->argv, &error_msg);
+  if (success && (job->file->Flush() != 0 || job->file->Close() != 0)) {
+    error_msg = StringPrintf("Failed to write '%s': %s", job->temp_location.c_str(),
+                             strerror(errno));
+    success = false;
+  }
+  if (success) {
+    // The oat file may be opened by processes holding the lock, replace it once they are done.
+    ScopedFlock scoped_flock;
+    success = scoped_flock.Init(job->oat_location.c_str(), &error_msg);
+    if (success && rename(job->temp_location.c_str(), job->oat_location.c_str()) != 0) {
+      error_msg = StringPrintf("Failed to rename '%s' to '%s': %s", job->temp_location.c_str(),
+                               job->oat_location.c_str(), strerror(errno));
+      success = false;
+    }
+  }
+  if (!success) {
+    LOG(WARNING) << "Background dex2oat failed: " << error_msg;
+    unlink(job->temp_location.c_str());
+    return nullptr;
+  }
+  VLOG(class_linker) << "Generated oat file " << job->oat_location << " in the background";
+  return nullptr;
+}
+
+void ClassLinker::StartBackgroundDex2Oat(const char* dex_location, const char* oat_location) {
+  std::unique_ptr<BackgroundDex2Oat> job(new BackgroundDex2Oat);
+  job->oat_location = oat_location;
+  // The temporary file is per process, as other processes may compile the same dex file.
+  job->temp_location = StringPrintf("%s.%d.tmp", oat_location, getpid());
+  job->file.reset(OS::CreateEmptyFile(job->temp_location.c_str()));
+  if (job->file.get() == nullptr) {
+    PLOG(WARNING) << "Failed to create " << job->temp_location;
+    return;
+  }
+  GetDex2OatArguments(dex_location, job->file->Fd(), oat_location, false, &job->argv);
+
+  pthread_attr_t attr;
+  pthread_t thread;
+  CHECK_PTHREAD_CALL(pthread_attr_init, (&attr), "new background dex2oat thread");
+  CHECK_PTHREAD_CALL(pthread_attr_setdetachstate, (&attr, PTHREAD_CREATE_DETACHED),
+                     "PTHREAD_CREATE_DETACHED");
+  int pthread_create_result = pthread_create(&thread, &attr, RunBackgroundDex2Oat, job.get());
+  CHECK_PTHREAD_CALL(pthread_attr_destroy, (&attr), "new background dex2oat thread");
+  if (pthread_create_result != 0) {
+    errno = pthread_create_result;
+    PLOG(WARNING) << "Failed to start the background dex2oat of " << dex_location;
+    job->file.reset();
+    unlink(job->temp_location.c_str());
+    return;
+  }
+  job.release();  // Owned by the thread.
+}
+
 const DexFile* ClassLinker::FindOrCreateOatFileForDexLocation(
     const char* dex_location,
     uint32_t dex_location_checksum,
@@ -789,9 +878,13 @@ const DexFile* ClassLinker::FindOrCreateOatFileForDexLocation(
   VLOG(class_linker) << compound_msg;
   error_msgs->push_back(compound_msg);
 
-  // Generate the output oat file for the dex file
+  // Generate the output oat file for the dex file. In the background mode, the dex file is only
+  // verified, which is much quicker than compiling it, and the oat file with the compiled code
+  // replaces this one once generated.
+  const bool background_dex2oat = Runtime::Current()->IsBackgroundDex2OatEnabled();
   VLOG(class_linker) << "Generating oat file " << oat_location << " for " << dex_location;
-  if (!GenerateOatFile(dex_location, scoped_flock.GetFile().Fd(), oat_location, &error_msg)) {
+  if (!GenerateOatFile(dex_location, scoped_flock.GetFile().Fd(), oat_location,
+                       background_dex2oat, &error_msg)) {
     CHECK(!error_msg.empty());
     error_msgs->push_back(error_msg);
     return nullptr;
@@ -820,6 +913,10 @@ const DexFile* ClassLinker::FindOrCreateOatFileForDexLocation(
           << " dex_location_checksum=" << dex_location_checksum
           << " DexFile::GetLocationChecksum()=" << result->GetLocationChecksum();
   RegisterOatFile(oat_file.release());
+  if (background_dex2oat) {
+    // This process keeps the verified oat file it mapped, the compiled one is for the next ones.
+    StartBackgroundDex2Oat(dex_location, oat_location);
+  }
   return result;
 }
 
@@ -850,6 +947,17 @@ bool ClassLinker::VerifyOatFileChecksums(const OatFile* oat_file,
   bool image_check = ((oat_header.GetImageFileLocationOatChecksum() == image_oat_checksum)
                       && (oat_header.GetImageFileLocationOatDataBegin() == image_oat_data_begin));
 
+  // Code compiled for features this CPU lacks would die with SIGILL; recompile it instead.
+  if (instruction_set == kRuntimeISA &&
+      !oat_header.GetInstructionSetFeatures().IsRunnableOnThisCpu()) {
+    *error_msg = StringPrintf("oat file '%s' needs instruction set features '%s', CPU has '%s'",
+                              oat_file->GetLocation().c_str(),
+                              oat_header.GetInstructionSetFeatures().GetFeatureString().c_str(),
+                              InstructionSetFeatures::GuessInstructionSetFeatures()
+                                  .GetFeatureString().c_str());
+    return false;
+  }
+
   const OatFile::OatDexFile* oat_dex_file = oat_file->GetOatDexFile(dex_location,
                                                                     &dex_location_checksum);
   if (oat_dex_file == NULL) {
@@ -1149,24 +1257,16 @@ void ClassLinker::VisitRoots(RootCallback* callback, void* arg, VisitRootFlags f
   {
     WriterMutexLock mu(self, *Locks::classlinker_classes_lock_);
     if ((flags & kVisitRootFlagAllRoots) != 0) {
-      for (std::pair<const size_t, mirror::Class*>& it : class_table_) {
-        callback(reinterpret_cast<mirror::Object**>(&it.second), arg, 0, kRootStickyClass);
-      }
+      class_table_.VisitRoots(callback, arg);
     } else if ((flags & kVisitRootFlagNewRoots) != 0) {
       for (auto& pair : new_class_roots_) {
-        mirror::Object* old_ref = pair.second;
+        mirror::Class* old_ref = pair.second;
         callback(reinterpret_cast<mirror::Object**>(&pair.second), arg, 0, kRootStickyClass);
         if (UNLIKELY(pair.second != old_ref)) {
           // Uh ohes, GC moved a root in the log. Need to search the class_table and update the
           // corresponding object. This is slow, but luckily for us, this may only happen with a
           // concurrent moving GC.
-          for (auto it = class_table_.lower_bound(pair.first), end = class_table_.end();
-              it != end && it->first == pair.first; ++it) {
-            // If the class stored matches the old class, update it to the new value.
-            if (old_ref == it->second) {
-              it->second = pair.second;
-            }
-          }
+          class_table_.Update(pair.first, old_ref, pair.second);
         }
       }
     }
@@ -1196,11 +1296,7 @@ void ClassLinker::VisitClasses(ClassVisitor* visitor, void* arg) {
     MoveImageClassesToClassTable();
   }
   WriterMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  for (const std::pair<size_t, mirror::Class*>& it : class_table_) {
-    if (!visitor(it.second, arg)) {
-      return;
-    }
-  }
+  class_table_.Visit(visitor, arg);
 }
 
 static bool GetClassesVisitor(mirror::Class* c, void* arg) {
@@ -1269,8 +1365,15 @@ mirror::DexCache* ClassLinker::AllocDexCache(Thread* self, const DexFile& dex_fi
   if (methods.Get() == NULL) {
     return NULL;
   }
+  // Compiled code never reads the resolved fields, so application dex files with many field ids
+  // can keep them in a ResolvedFieldCache, of a fixed size, rather than in an array with an entry
+  // for each field id. The compiler keeps full arrays, which the image writer relies on.
+  size_t num_resolved_fields = dex_file.NumFieldIds();
+  if (!Runtime::Current()->IsCompiler() && num_resolved_fields > ResolvedFieldCache::kSize) {
+    num_resolved_fields = 0u;
+  }
   Handle<mirror::ObjectArray<mirror::ArtField>>
-      fields(hs.NewHandle(AllocArtFieldArray(self, dex_file.NumFieldIds())));
+      fields(hs.NewHandle(AllocArtFieldArray(self, num_resolved_fields)));
   if (fields.Get() == NULL) {
     return NULL;
   }
@@ -1455,6 +1558,7 @@ mirror::Class* ClassLinker::DefineClass(const char* descriptor,
                                         const Handle<mirror::ClassLoader>& class_loader,
                                         const DexFile& dex_file,
                                         const DexFile::ClassDef& dex_class_def) {
+  ScopedTrace trace(ATRACE_ENABLED() ? StringPrintf("DefineClass %s", descriptor) : std::string());
   Thread* self = Thread::Current();
   StackHandleScope<2> hs(self);
   auto klass = hs.NewHandle<mirror::Class>(nullptr);
@@ -1484,6 +1588,7 @@ mirror::Class* ClassLinker::DefineClass(const char* descriptor,
     return NULL;
   }
   klass->SetDexCache(FindDexCache(dex_file));
+  ++self->GetCounters()->class_loads;
   LoadClass(dex_file, dex_class_def, klass, class_loader.Get());
   // Check for a pending exception during load
   if (self->IsExceptionPending()) {
@@ -1660,6 +1765,13 @@ const void* ClassLinker::GetQuickOatCodeFor(mirror::ArtMethod* method) {
     return GetQuickProxyInvokeHandler();
   }
   const void* result = GetOatMethodFor(method).GetQuickCode();
+  if (result == nullptr) {
+    // Methods without oat code may have been compiled by the JIT.
+    jit::Jit* jit = Runtime::Current()->GetJit();
+    if (jit != nullptr) {
+      result = jit->GetCodeCache()->GetCodeFor(method);
+    }
+  }
   if (result == nullptr) {
     if (method->IsNative()) {
       // No code and native? Use generic trampoline.
@@ -1735,6 +1847,77 @@ static bool NeedsInterpreter(
          !method->IsNative() && !method->IsProxyMethod();
 }
 
+void ClassLinker::ResolveDirectCallees(mirror::Class* klass) {
+  DCHECK(klass->IsInitialized()) << PrettyDescriptor(klass);
+  Runtime* runtime = Runtime::Current();
+  if (!runtime->IsStarted() || runtime->UseCompileTimeClassPath()) {
+    return;
+  }
+  const DexFile::ClassDef* dex_class_def = klass->GetClassDef();
+  if (dex_class_def == nullptr) {
+    return;  // Proxy class.
+  }
+  const DexFile& dex_file = klass->GetDexFile();
+  const byte* class_data = dex_file.GetClassData(*dex_class_def);
+  if (class_data == nullptr) {
+    return;
+  }
+  // Compiled code calls static and direct methods through the dex cache, whose entries start as
+  // the resolution method: the first call to each then walks the stack and decodes the invoke in
+  // artQuickResolutionTrampoline. The callees whose classes are already resolved are found here
+  // by looking them up only, which doesn't load classes, allocate or throw; the trampoline still
+  // resolves the others, and initializes the classes of the static callees.
+  mirror::DexCache* dex_cache = klass->GetDexCache();
+  ClassDataItemIterator it(dex_file, class_data);
+  while (it.HasNextStaticField()) {
+    it.Next();
+  }
+  while (it.HasNextInstanceField()) {
+    it.Next();
+  }
+  for (; it.HasNextDirectMethod() || it.HasNextVirtualMethod(); it.Next()) {
+    const DexFile::CodeItem* code_item = it.GetMethodCodeItem();
+    if (code_item == nullptr) {
+      continue;
+    }
+    const uint16_t* insns_end = code_item->insns_ + code_item->insns_size_in_code_units_;
+    for (const Instruction* inst = Instruction::At(code_item->insns_);
+         reinterpret_cast<const uint16_t*>(inst) < insns_end; inst = inst->Next()) {
+      InvokeType type;
+      switch (inst->Opcode()) {
+        case Instruction::INVOKE_STATIC:
+        case Instruction::INVOKE_STATIC_RANGE:
+          type = kStatic;
+          break;
+        case Instruction::INVOKE_DIRECT:
+        case Instruction::INVOKE_DIRECT_RANGE:
+          type = kDirect;
+          break;
+        default:
+          continue;
+      }
+      uint32_t method_idx = inst->VRegB();
+      mirror::ArtMethod* resolved = dex_cache->GetResolvedMethod(method_idx);
+      if (resolved != nullptr && !resolved->IsRuntimeMethod()) {
+        continue;
+      }
+      const DexFile::MethodId& method_id = dex_file.GetMethodId(method_idx);
+      mirror::Class* callee_class = dex_cache->GetResolvedType(method_id.class_idx_);
+      if (callee_class == nullptr || callee_class->IsErroneous()) {
+        continue;
+      }
+      resolved = callee_class->FindDirectMethod(dex_cache, method_idx);
+      if (resolved == nullptr) {
+        resolved = callee_class->FindDirectMethod(dex_file.StringDataByIdx(method_id.name_idx_),
+                                                  dex_file.GetMethodSignature(method_id));
+      }
+      if (resolved != nullptr && !resolved->CheckIncompatibleClassChange(type)) {
+        dex_cache->SetResolvedMethod(method_idx, resolved);
+      }
+    }
+  }
+}
+
 void ClassLinker::FixupStaticTrampolines(mirror::Class* klass) {
   DCHECK(klass->IsInitialized()) << PrettyDescriptor(klass);
   if (klass->NumDirectMethods() == 0) {
@@ -2073,6 +2256,15 @@ mirror::ArtMethod* ClassLinker::LoadMethod(Thread* self, const DexFile& dex_file
       }
     }
   }
+  if (UNLIKELY((access_flags & kAccNative) != 0)) {
+    // Native methods annotated as fast are called without leaving the runnable state, as if
+    // registered with a signature starting with '!'.
+    const DexFile::ClassDef& class_def = dex_file.GetClassDef(klass->GetDexClassDefIndex());
+    if (dex_file.IsMethodAnnotatedWith(class_def, dex_method_idx,
+                                       "Ldalvik/annotation/optimization/FastNative;")) {
+      access_flags |= kAccFastNative;
+    }
+  }
   dst->SetAccessFlags(access_flags);
 
   self->EndAssertNoThreadSuspension(old_cause);
@@ -2117,6 +2309,10 @@ void ClassLinker::RegisterDexFileLocked(const DexFile& dex_file,
       << dex_cache->GetLocation()->ToModifiedUtf8() << " " << dex_file.GetLocation();
   dex_caches_.push_back(dex_cache.Get());
   dex_cache->SetDexFile(&dex_file);
+  if (dex_cache->NumResolvedFields() != dex_file.NumFieldIds()) {
+    // A compact DexCache, see AllocDexCache.
+    dex_file.SetResolvedFieldCache(new ResolvedFieldCache());
+  }
   if (log_new_dex_caches_roots_) {
     // TODO: This is not safe if we can remove dex caches.
     new_dex_cache_roots_.push_back(dex_caches_.size() - 1);
@@ -2388,8 +2584,7 @@ mirror::Class* ClassLinker::InsertClass(const char* descriptor, mirror::Class* k
     LOG(INFO) << "Loaded class " << descriptor << source;
   }
   WriterMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  mirror::Class* existing =
-      LookupClassFromTableLocked(descriptor, klass->GetClassLoader(), hash);
+  mirror::Class* existing = class_table_.Lookup(descriptor, klass->GetClassLoader(), hash);
   if (existing != NULL) {
     return existing;
   }
@@ -2402,7 +2597,7 @@ mirror::Class* ClassLinker::InsertClass(const char* descriptor, mirror::Class* k
     }
   }
   VerifyObject(klass);
-  class_table_.insert(std::make_pair(hash, klass));
+  class_table_.Insert(klass, hash);
   if (log_new_class_table_roots_) {
     new_class_roots_.push_back(std::make_pair(hash, klass));
   }
@@ -2412,33 +2607,23 @@ mirror::Class* ClassLinker::InsertClass(const char* descriptor, mirror::Class* k
 bool ClassLinker::RemoveClass(const char* descriptor, const mirror::ClassLoader* class_loader) {
   size_t hash = Hash(descriptor);
   WriterMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  for (auto it = class_table_.lower_bound(hash), end = class_table_.end();
-       it != end && it->first == hash;
-       ++it) {
-    mirror::Class* klass = it->second;
-    if (klass->GetClassLoader() == class_loader && descriptor == klass->GetDescriptor()) {
-      class_table_.erase(it);
-      return true;
-    }
-  }
-  return false;
+  return class_table_.Remove(descriptor, class_loader, hash);
 }
 
 mirror::Class* ClassLinker::LookupClass(const char* descriptor,
                                         const mirror::ClassLoader* class_loader) {
   size_t hash = Hash(descriptor);
-  {
-    ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-    mirror::Class* result = LookupClassFromTableLocked(descriptor, class_loader, hash);
-    if (result != NULL) {
-      return result;
-    }
+  // Without the classes lock, a class being inserted concurrently may be missed, in which case
+  // the caller defines it again and InsertClass returns the class that won the race.
+  mirror::Class* result = class_table_.Lookup(descriptor, class_loader, hash);
+  if (result != NULL) {
+    return result;
   }
   if (class_loader != NULL || !dex_cache_image_class_lookup_required_) {
     return NULL;
   } else {
     // Lookup failed but need to search dex_caches_.
-    mirror::Class* result = LookupClassFromImage(descriptor);
+    result = LookupClassFromImage(descriptor);
     if (result != NULL) {
       InsertClass(descriptor, result, hash);
     } else {
@@ -2454,29 +2639,6 @@ mirror::Class* ClassLinker::LookupClass(const char* descriptor,
   }
 }
 
-mirror::Class* ClassLinker::LookupClassFromTableLocked(const char* descriptor,
-                                                       const mirror::ClassLoader* class_loader,
-                                                       size_t hash) {
-  auto end = class_table_.end();
-  for (auto it = class_table_.lower_bound(hash); it != end && it->first == hash; ++it) {
-    mirror::Class* klass = it->second;
-    if (klass->GetClassLoader() == class_loader && descriptor == klass->GetDescriptor()) {
-      if (kIsDebugBuild) {
-        // Check for duplicates in the table.
-        for (++it; it != end && it->first == hash; ++it) {
-          mirror::Class* klass2 = it->second;
-          CHECK(!((klass2->GetClassLoader() == class_loader) &&
-              descriptor == klass2->GetDescriptor()))
-              << PrettyClass(klass) << " " << klass << " " << klass->GetClassLoader() << " "
-              << PrettyClass(klass2) << " " << klass2 << " " << klass2->GetClassLoader();
-        }
-      }
-      return klass;
-    }
-  }
-  return NULL;
-}
-
 static mirror::ObjectArray<mirror::DexCache>* GetImageDexCaches()
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   gc::space::ImageSpace* image = Runtime::Current()->GetHeap()->GetImageSpace();
@@ -2503,12 +2665,12 @@ void ClassLinker::MoveImageClassesToClassTable() {
         DCHECK(klass->GetClassLoader() == NULL);
         std::string descriptor = klass->GetDescriptor();
         size_t hash = Hash(descriptor.c_str());
-        mirror::Class* existing = LookupClassFromTableLocked(descriptor.c_str(), NULL, hash);
+        mirror::Class* existing = class_table_.Lookup(descriptor.c_str(), NULL, hash);
         if (existing != NULL) {
           CHECK(existing == klass) << PrettyClassAndClassLoader(existing) << " != "
               << PrettyClassAndClassLoader(klass);
         } else {
-          class_table_.insert(std::make_pair(hash, klass));
+          class_table_.Insert(klass, hash);
           if (log_new_class_table_roots_) {
             new_class_roots_.push_back(std::make_pair(hash, klass));
           }
@@ -2554,13 +2716,7 @@ void ClassLinker::LookupClasses(const char* descriptor, std::vector<mirror::Clas
   }
   size_t hash = Hash(descriptor);
   ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  for (auto it = class_table_.lower_bound(hash), end = class_table_.end();
-      it != end && it->first == hash; ++it) {
-    mirror::Class* klass = it->second;
-    if (descriptor == klass->GetDescriptor()) {
-      result.push_back(klass);
-    }
-  }
+  class_table_.LookupAll(descriptor, hash, &result);
 }
 
 void ClassLinker::VerifyClass(const Handle<mirror::Class>& klass) {
@@ -3129,6 +3285,9 @@ bool ClassLinker::InitializeClass(const Handle<mirror::Class>& klass, bool can_i
   if (klass->IsInitialized()) {
     return true;
   }
+  ScopedTrace trace(ATRACE_ENABLED()
+                    ? StringPrintf("InitializeClass %s", PrettyDescriptor(klass.Get()).c_str())
+                    : std::string());
 
   // Fast fail if initialization requires a full runtime. Not part of the JLS.
   if (!CanWeInitializeClass(klass.Get(), can_init_statics, can_init_parents)) {
@@ -3283,6 +3442,9 @@ bool ClassLinker::InitializeClass(const Handle<mirror::Class>& klass, bool can_i
       FixupStaticTrampolines(klass.Get());
     }
   }
+  if (success) {
+    ResolveDirectCallees(klass.Get());
+  }
   return success;
 }
 
@@ -3755,6 +3917,8 @@ bool ClassLinker::LinkInterfaceMethods(
     CHECK(self->IsExceptionPending());  // OOME.
     return false;
   }
+  // The interface methods of each IMT entry, and their implementations.
+  std::vector<std::pair<mirror::ArtMethod*, mirror::ArtMethod*>> imt_entries[kImtSize];
   std::vector<mirror::ArtMethod*> miranda_list;
   for (size_t i = 0; i < ifcount; ++i) {
     size_t num_methods = iftable->GetInterface(i)->NumVirtualMethods();
@@ -3794,14 +3958,9 @@ bool ClassLinker::LinkInterfaceMethods(
               return false;
             }
             method_array->Set<false>(j, vtable_method);
-            // Place method in imt if entry is empty, place conflict otherwise.
             uint32_t imt_index = interface_method->GetDexMethodIndex() % kImtSize;
-            if (imtable->Get(imt_index) == NULL) {
-              imtable->Set<false>(imt_index, vtable_method);
-              imtable_changed = true;
-            } else {
-              imtable->Set<false>(imt_index, Runtime::Current()->GetImtConflictMethod());
-            }
+            imt_entries[imt_index].push_back(std::make_pair(interface_method, vtable_method));
+            imtable_changed = true;
             break;
           }
         }
@@ -3832,11 +3991,21 @@ bool ClassLinker::LinkInterfaceMethods(
     }
   }
   if (imtable_changed) {
-    // Fill in empty entries in interface method table with conflict.
+    // Place the method in the imt entry if it is the only one there. Entries shared by several
+    // methods get a conflict method resolving them, empty entries the runtime's conflict method.
     mirror::ArtMethod* imt_conflict_method = Runtime::Current()->GetImtConflictMethod();
     for (size_t i = 0; i < kImtSize; i++) {
-      if (imtable->Get(i) == NULL) {
+      if (imt_entries[i].empty()) {
         imtable->Set<false>(i, imt_conflict_method);
+      } else if (imt_entries[i].size() == 1u) {
+        imtable->Set<false>(i, imt_entries[i][0].second);
+      } else {
+        mirror::ArtMethod* conflict_method = CreateImtConflictMethod(self, imt_entries[i]);
+        if (UNLIKELY(conflict_method == nullptr)) {
+          CHECK(self->IsExceptionPending());  // OOME.
+          return false;
+        }
+        imtable->Set<false>(i, conflict_method);
       }
     }
     klass->SetImTable(imtable.Get());
@@ -3894,6 +4063,27 @@ bool ClassLinker::LinkInstanceFields(const Handle<mirror::Class>& klass) {
   return LinkFields(klass, false);
 }
 
+mirror::ArtMethod* ClassLinker::CreateImtConflictMethod(
+    Thread* self, const std::vector<std::pair<mirror::ArtMethod*, mirror::ArtMethod*>>& entries) {
+  StackHandleScope<1> hs(self);
+  Handle<mirror::ObjectArray<mirror::ArtMethod>> conflict_table(
+      hs.NewHandle(AllocArtMethodArray(self, entries.size() * 2)));
+  if (UNLIKELY(conflict_table.Get() == nullptr)) {
+    return nullptr;
+  }
+  for (size_t i = 0; i < entries.size(); ++i) {
+    conflict_table->Set<false>(i * 2, entries[i].first);
+    conflict_table->Set<false>(i * 2 + 1, entries[i].second);
+  }
+  mirror::ArtMethod* conflict_method =
+      down_cast<mirror::ArtMethod*>(Runtime::Current()->GetImtConflictMethod()->Clone(self));
+  if (UNLIKELY(conflict_method == nullptr)) {
+    return nullptr;
+  }
+  conflict_method->SetImtConflictTable(conflict_table.Get());
+  return conflict_method;
+}
+
 bool ClassLinker::LinkStaticFields(const Handle<mirror::Class>& klass) {
   CHECK(klass.Get() != NULL);
   size_t allocated_class_size = klass->GetClassSize();
@@ -4427,6 +4617,11 @@ const char* ClassLinker::MethodShorty(uint32_t method_idx, mirror::ArtMethod* re
   return dex_file.GetMethodShorty(method_id, length);
 }
 
+static bool GetAllClassesVisitor(mirror::Class* c, void* arg) {
+  reinterpret_cast<std::vector<mirror::Class*>*>(arg)->push_back(c);
+  return true;
+}
+
 void ClassLinker::DumpAllClasses(int flags) {
   if (dex_cache_image_class_lookup_required_) {
     MoveImageClassesToClassTable();
@@ -4436,9 +4631,7 @@ void ClassLinker::DumpAllClasses(int flags) {
   std::vector<mirror::Class*> all_classes;
   {
     ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-    for (const std::pair<size_t, mirror::Class*>& it : class_table_) {
-      all_classes.push_back(it.second);
-    }
+    class_table_.Visit(GetAllClassesVisitor, &all_classes);
   }
 
   for (size_t i = 0; i < all_classes.size(); ++i) {
@@ -4451,7 +4644,7 @@ void ClassLinker::DumpForSigQuit(std::ostream& os) {
     MoveImageClassesToClassTable();
   }
   ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  os << "Loaded classes: " << class_table_.size() << " allocated classes\n";
+  os << "Loaded classes: " << class_table_.Size() << " allocated classes\n";
 }
 
 size_t ClassLinker::NumLoadedClasses() {
@@ -4459,7 +4652,7 @@ size_t ClassLinker::NumLoadedClasses() {
     MoveImageClassesToClassTable();
   }
   ReaderMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-  return class_table_.size();
+  return class_table_.Size();
 }
 
 pid_t ClassLinker::GetClassesLockOwner() {
@@ -23,6 +23,7 @@
 
 #include "base/macros.h"
 #include "base/mutex.h"
+#include "class_table.h"
 #include "dex_file.h"
 #include "gtest/gtest.h"
 #include "jni.h"
@@ -256,10 +257,12 @@ class ClassLinker {
       LOCKS_EXCLUDED(dex_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  // Generate an oat file from a dex file
+  // Generate an oat file from a dex file. A verify_only oat file has no compiled code, the
+  // methods of its dex file are interpreted.
   bool GenerateOatFile(const char* dex_filename,
                        int oat_fd,
                        const char* oat_cache_filename,
+                       bool verify_only,
                        std::string* error_msg)
       LOCKS_EXCLUDED(Locks::mutator_lock_);
 
@@ -458,6 +461,10 @@ class ClassLinker {
 
   void FixupStaticTrampolines(mirror::Class* klass) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Resolves in the dex cache the static and direct methods called by the methods of an
+  // initialized class, so that their first calls skip the resolution trampoline.
+  void ResolveDirectCallees(mirror::Class* klass) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Finds the associated oat class for a dex_file and descriptor
   OatFile::OatClass GetOatClass(const DexFile& dex_file, uint16_t class_def_idx)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -507,6 +514,12 @@ class ClassLinker {
                             const Handle<mirror::ObjectArray<mirror::Class>>& interfaces)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Returns a copy of the runtime's IMT conflict method resolving the interface methods of
+  // `entries`, which share an IMT entry, to their implementations, or null on OOME.
+  mirror::ArtMethod* CreateImtConflictMethod(
+      Thread* self, const std::vector<std::pair<mirror::ArtMethod*, mirror::ArtMethod*>>& entries)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   bool LinkStaticFields(const Handle<mirror::Class>& klass)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   bool LinkInstanceFields(const Handle<mirror::Class>& klass)
@@ -551,6 +564,17 @@ class ClassLinker {
                                                  bool* open_failed)
       LOCKS_EXCLUDED(dex_lock_);
 
+  void GetDex2OatArguments(const char* dex_filename,
+                           int oat_fd,
+                           const char* oat_cache_filename,
+                           bool verify_only,
+                           std::vector<std::string>* argv);
+
+  // Compiles the dex file into a temporary file on a new thread, and then replaces the oat file
+  // at oat_location with it, for the next processes which open the dex file.
+  void StartBackgroundDex2Oat(const char* dex_location, const char* oat_location)
+      LOCKS_EXCLUDED(Locks::mutator_lock_);
+
   mirror::ArtMethod* CreateProxyConstructor(Thread* self, const Handle<mirror::Class>& klass,
                                             mirror::Class* proxy_class)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -566,11 +590,9 @@ class ClassLinker {
   std::vector<const OatFile*> oat_files_ GUARDED_BY(dex_lock_);
 
 
-  // multimap from a string hash code of a class descriptor to
-  // mirror::Class* instances. Results should be compared for a matching
-  // Class::descriptor_ and Class::class_loader_.
-  typedef std::multimap<size_t, mirror::Class*> Table;
-  Table class_table_ GUARDED_BY(Locks::classlinker_classes_lock_);
+  // The loaded classes, by the hash of their descriptor. Modified with the
+  // classlinker_classes_lock_ held exclusively, looked up without it.
+  ClassTable class_table_;
   std::vector<std::pair<size_t, mirror::Class*>> new_class_roots_;
 
   // Do we need to search dex caches to find image classes?
@@ -579,11 +601,6 @@ class ClassLinker {
   // the classes into the class_table_ to avoid dex cache based searches.
   AtomicInteger failed_dex_cache_class_lookups_;
 
-  mirror::Class* LookupClassFromTableLocked(const char* descriptor,
-                                            const mirror::ClassLoader* class_loader,
-                                            size_t hash)
-      SHARED_LOCKS_REQUIRED(Locks::classlinker_classes_lock_, Locks::mutator_lock_);
-
   void MoveImageClassesToClassTable() LOCKS_EXCLUDED(Locks::classlinker_classes_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   mirror::Class* LookupClassFromImage(const char* descriptor)
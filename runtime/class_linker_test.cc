@@ -1105,6 +1105,37 @@ TEST_F(ClassLinkerTest, FinalizableBit) {
   EXPECT_TRUE(c->IsFinalizable());
 }
 
+TEST_F(ClassLinkerTest, ImtConflictMethods) {
+  ScopedObjectAccess soa(Thread::Current());
+  // Implements enough interface methods for some to share IMT entries.
+  mirror::Class* c = class_linker_->FindSystemClass(soa.Self(), "Ljava/util/ArrayList;");
+  ASSERT_TRUE(c != NULL);
+  mirror::ObjectArray<mirror::ArtMethod>* imt = c->GetImTable();
+  ASSERT_TRUE(imt != NULL);
+  mirror::IfTable* iftable = c->GetIfTable();
+  for (int32_t i = 0; i < c->GetIfTableCount(); ++i) {
+    mirror::Class* interface = iftable->GetInterface(i);
+    for (size_t j = 0; j < interface->NumVirtualMethods(); ++j) {
+      mirror::ArtMethod* interface_method = interface->GetVirtualMethod(j);
+      mirror::ArtMethod* implementation = c->FindVirtualMethodForInterface(interface_method);
+      mirror::ArtMethod* imt_method =
+          imt->Get(interface_method->GetDexMethodIndex() % ClassLinker::kImtSize);
+      if (imt_method->IsImtConflictMethod()) {
+        EXPECT_TRUE(imt_method->GetImtConflictTable() != NULL);
+        EXPECT_EQ(implementation, imt_method->FindImtConflictTarget(interface_method))
+            << PrettyMethod(interface_method);
+      } else {
+        EXPECT_EQ(implementation, imt_method) << PrettyMethod(interface_method);
+      }
+    }
+  }
+  // The runtime's conflict method, in the empty entries, has no conflicts to resolve.
+  mirror::ArtMethod* runtime_conflict_method = Runtime::Current()->GetImtConflictMethod();
+  EXPECT_TRUE(runtime_conflict_method->IsImtConflictMethod());
+  EXPECT_TRUE(runtime_conflict_method->GetImtConflictTable() == NULL);
+  EXPECT_TRUE(runtime_conflict_method->FindImtConflictTarget(imt->Get(0)) == NULL);
+}
+
 TEST_F(ClassLinkerTest, ClassRootDescriptors) {
   ScopedObjectAccess soa(Thread::Current());
   for (int i = 0; i < ClassLinker::kClassRootsMax; i++) {
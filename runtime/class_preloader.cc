@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_preloader.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "class_linker.h"
+#include "dex_file-inl.h"
+#include "handle_scope-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/class_loader.h"
+#include "runtime.h"
+#include "scoped_thread_state_change.h"
+#include "thread.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+namespace art {
+
+static constexpr size_t kMaxWorkers = 4;
+
+class ClassPreloader::PreloadTask : public Task {
+ public:
+  explicit PreloadTask(ClassPreloader* preloader) : preloader_(preloader) {}
+
+  void Run(Thread* self) OVERRIDE {
+    preloader_->PreloadClasses(self);
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  ClassPreloader* const preloader_;
+};
+
+ClassPreloader* ClassPreloader::Create(const std::string& profile_file, std::string* error_msg) {
+  std::string contents;
+  if (!ReadFileToString(profile_file, &contents)) {
+    *error_msg = StringPrintf("Failed to read class profile '%s'", profile_file.c_str());
+    return nullptr;
+  }
+  std::vector<std::string> lines;
+  Split(contents, '\n', lines);
+  std::vector<std::string> descriptors;
+  for (const std::string& line : lines) {
+    std::string name = Trim(line);
+    if (name.empty() || name[0] == '#') {
+      continue;
+    }
+    bool is_descriptor = (name[0] == 'L' && name[name.size() - 1] == ';') || name[0] == '[';
+    descriptors.push_back(is_descriptor ? name : DotToDescriptor(name.c_str()));
+  }
+  return new ClassPreloader(&descriptors);
+}
+
+ClassPreloader::ClassPreloader(std::vector<std::string>* descriptors)
+    : class_loader_(nullptr), next_class_(0), num_loaded_(0), num_failed_(0),
+      num_running_workers_(0), start_time_ns_(0u), stop_(false) {
+  descriptors_.swap(*descriptors);
+}
+
+ClassPreloader::~ClassPreloader() {
+  if (thread_pool_.get() != nullptr) {
+    stop_ = true;
+    thread_pool_->StopWorkers(Thread::Current());
+    thread_pool_.reset();
+  }
+}
+
+size_t ClassPreloader::Depth(const std::vector<const DexFile*>& class_path,
+                             const std::string& descriptor, SafeMap<std::string, size_t>* depths) {
+  auto it = depths->find(descriptor);
+  if (it != depths->end()) {
+    return it->second;
+  }
+  // Also ends the recursion on the cycles of malformed class hierarchies.
+  depths->Put(descriptor, 0u);
+  DexFile::ClassPathEntry pair = DexFile::FindInClassPath(descriptor.c_str(), class_path);
+  if (pair.second == nullptr) {
+    return 0u;
+  }
+  const DexFile& dex_file = *pair.first;
+  const DexFile::ClassDef& class_def = *pair.second;
+  size_t depth = 0u;
+  if (class_def.superclass_idx_ != DexFile::kDexNoIndex16) {
+    std::string super_descriptor(dex_file.StringByTypeIdx(class_def.superclass_idx_));
+    depth = std::max(depth, Depth(class_path, super_descriptor, depths) + 1u);
+  }
+  const DexFile::TypeList* interfaces = dex_file.GetInterfacesList(class_def);
+  if (interfaces != nullptr) {
+    for (size_t i = 0; i < interfaces->Size(); ++i) {
+      std::string interface_descriptor(
+          dex_file.StringByTypeIdx(interfaces->GetTypeItem(i).type_idx_));
+      depth = std::max(depth, Depth(class_path, interface_descriptor, depths) + 1u);
+    }
+  }
+  depths->Overwrite(descriptor, depth);
+  return depth;
+}
+
+void ClassPreloader::SortByDepth(const std::vector<const DexFile*>& class_path,
+                                 std::vector<std::string>* descriptors) {
+  SafeMap<std::string, size_t> depths;
+  for (const std::string& descriptor : *descriptors) {
+    Depth(class_path, descriptor, &depths);
+  }
+  // Stable, to keep the profile order, which is the order the classes were first touched in,
+  // among the classes of a depth.
+  std::stable_sort(descriptors->begin(), descriptors->end(),
+                   [&depths](const std::string& lhs, const std::string& rhs) {
+                     return depths.Get(lhs) < depths.Get(rhs);
+                   });
+}
+
+void ClassPreloader::Start(Thread* self, jobject class_loader) {
+  CHECK(thread_pool_.get() == nullptr);
+  SortByDepth(Runtime::Current()->GetClassLinker()->GetBootClassPath(), &descriptors_);
+  class_loader_ = class_loader;
+  start_time_ns_ = NanoTime();
+
+  // Leave a processor to the main thread.
+  size_t num_processors = static_cast<size_t>(sysconf(_SC_NPROCESSORS_CONF));
+  size_t num_workers = std::min(kMaxWorkers, num_processors > 1u ? num_processors - 1u : 1u);
+  num_workers = std::min(num_workers, descriptors_.size());
+  if (num_workers == 0u) {
+    return;
+  }
+  num_running_workers_ = static_cast<int32_t>(num_workers);
+  thread_pool_.reset(new ThreadPool("Class preloader thread pool", num_workers));
+  for (size_t i = 0; i < num_workers; ++i) {
+    thread_pool_->AddTask(self, new PreloadTask(this));
+  }
+  thread_pool_->StartWorkers(self);
+}
+
+void ClassPreloader::PreloadClasses(Thread* self) {
+  ScopedObjectAccess soa(self);
+  StackHandleScope<1> hs(self);
+  Handle<mirror::ClassLoader> class_loader(
+      hs.NewHandle(soa.Decode<mirror::ClassLoader*>(class_loader_)));
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  while (!stop_) {
+    size_t index = static_cast<size_t>(next_class_.FetchAndAdd(1));
+    if (index >= descriptors_.size()) {
+      break;
+    }
+    const std::string& descriptor = descriptors_[index];
+    if (class_linker->FindClass(self, descriptor.c_str(), class_loader) != nullptr) {
+      num_loaded_.FetchAndAdd(1);
+    } else {
+      // Left for the main thread to throw again, if it ever needs the class.
+      self->ClearException();
+      num_failed_.FetchAndAdd(1);
+      VLOG(class_linker) << "Failed to preload " << descriptor;
+    }
+  }
+  if (num_running_workers_.FetchAndSub(1) == 1) {
+    VLOG(startup) << "Preloaded " << num_loaded_.Load() << " classes, failed to load "
+                  << num_failed_.Load() << ", in " << PrettyDuration(NanoTime() - start_time_ns_);
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CLASS_PRELOADER_H_
+#define ART_RUNTIME_CLASS_PRELOADER_H_
+
+#include <jni.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "safe_map.h"
+
+namespace art {
+
+class DexFile;
+class Thread;
+class ThreadPool;
+
+// Loads and links the classes of a startup profile on a thread pool, while the main thread starts
+// running, so that it finds them already linked rather than loading them one by one as it first
+// touches them. The profile lists one class per line, as a descriptor or a dotted name; lines
+// starting with '#' are comments. The classes are loaded in the order of their depth in the
+// class hierarchy of the boot class path, superclasses and interfaces first, so that the workers
+// seldom wait for a class another worker is linking. They are not initialized, as running static
+// initializers ahead of time could be observed.
+class ClassPreloader {
+ public:
+  // Returns null, and sets error_msg, if the profile can't be read.
+  static ClassPreloader* Create(const std::string& profile_file, std::string* error_msg);
+
+  // Waits for the classes being loaded, the others are dropped.
+  ~ClassPreloader();
+
+  // Starts loading the classes with `class_loader`, a global reference, or the boot class loader
+  // if it is null.
+  void Start(Thread* self, jobject class_loader) LOCKS_EXCLUDED(Locks::mutator_lock_);
+
+  const std::vector<std::string>& GetDescriptors() const {
+    return descriptors_;
+  }
+
+  // Sorts `descriptors` by the depth of their classes in the class hierarchy of `class_path`.
+  // Classes that are not in it come first.
+  static void SortByDepth(const std::vector<const DexFile*>& class_path,
+                          std::vector<std::string>* descriptors);
+
+ private:
+  class PreloadTask;
+
+  explicit ClassPreloader(std::vector<std::string>* descriptors);
+
+  static size_t Depth(const std::vector<const DexFile*>& class_path, const std::string& descriptor,
+                      SafeMap<std::string, size_t>* depths);
+
+  // Called by the workers, in the native state, until there are no classes left.
+  void PreloadClasses(Thread* self) LOCKS_EXCLUDED(Locks::mutator_lock_);
+
+  std::vector<std::string> descriptors_;
+  jobject class_loader_;
+  std::unique_ptr<ThreadPool> thread_pool_;
+
+  // Index of the next class to load.
+  AtomicInteger next_class_;
+  AtomicInteger num_loaded_;
+  AtomicInteger num_failed_;
+  // Workers that haven't run out of classes yet.
+  AtomicInteger num_running_workers_;
+  uint64_t start_time_ns_;
+  // Set when the runtime shuts down, to drop the classes left.
+  volatile bool stop_;
+
+  DISALLOW_COPY_AND_ASSIGN(ClassPreloader);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CLASS_PRELOADER_H_
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_preloader.h"
+
+#include <memory>
+#include <string>
+
+#include "common_runtime_test.h"
+
+namespace art {
+
+class ClassPreloaderTest : public CommonRuntimeTest {};
+
+TEST_F(ClassPreloaderTest, ParseProfile) {
+  ScratchFile tmp;
+  std::string profile("# Startup classes\n"
+                      "java.lang.String\n"
+                      "  Ljava/util/ArrayList;\n"
+                      "\n"
+                      "[Ljava/lang/Object;\n");
+  ASSERT_TRUE(tmp.GetFile()->WriteFully(profile.c_str(), profile.size()));
+  std::string error_msg;
+  std::unique_ptr<ClassPreloader> preloader(ClassPreloader::Create(tmp.GetFilename(), &error_msg));
+  ASSERT_TRUE(preloader.get() != nullptr) << error_msg;
+  const std::vector<std::string>& descriptors = preloader->GetDescriptors();
+  ASSERT_EQ(3u, descriptors.size());
+  EXPECT_EQ("Ljava/lang/String;", descriptors[0]);
+  EXPECT_EQ("Ljava/util/ArrayList;", descriptors[1]);
+  EXPECT_EQ("[Ljava/lang/Object;", descriptors[2]);
+
+  EXPECT_TRUE(ClassPreloader::Create("/nonexistent/profile", &error_msg) == nullptr);
+}
+
+TEST_F(ClassPreloaderTest, SortByDepth) {
+  std::vector<std::string> descriptors;
+  descriptors.push_back("Ljava/util/ArrayList;");
+  descriptors.push_back("Ljava/lang/Object;");
+  descriptors.push_back("Ljava/util/AbstractList;");
+  descriptors.push_back("LNoSuchClass;");
+  descriptors.push_back("Ljava/util/Collection;");
+  ClassPreloader::SortByDepth(class_linker_->GetBootClassPath(), &descriptors);
+  ASSERT_EQ(5u, descriptors.size());
+  // Object and the unknown class come first, in the profile order, then the interface before the
+  // classes implementing it, and the superclass before its subclass.
+  EXPECT_EQ("Ljava/lang/Object;", descriptors[0]);
+  EXPECT_EQ("LNoSuchClass;", descriptors[1]);
+  EXPECT_EQ("Ljava/util/Collection;", descriptors[2]);
+  EXPECT_EQ("Ljava/util/AbstractList;", descriptors[3]);
+  EXPECT_EQ("Ljava/util/ArrayList;", descriptors[4]);
+}
+
+}  // namespace art
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_table.h"
+
+#include <algorithm>
+
+#include "atomic.h"
+#include "mirror/class-inl.h"
+#include "utils.h"
+
+namespace art {
+
+ClassTable::SlotArray::SlotArray(size_t capacity) : mask(capacity - 1), slots(new Slot[capacity]) {
+  DCHECK(IsPowerOfTwo(capacity));
+  for (size_t i = 0; i < capacity; ++i) {
+    slots[i].hash = 0u;
+    slots[i].klass = nullptr;
+  }
+}
+
+ClassTable::ClassTable()
+    : array_(new SlotArray(kInitialCapacity)), num_classes_(0u), num_used_slots_(0u) {
+}
+
+ClassTable::~ClassTable() {
+  delete array_;
+}
+
+mirror::Class* ClassTable::Lookup(const char* descriptor, const mirror::ClassLoader* class_loader,
+                                  size_t hash) {
+  // The slots are only read through the array pointer, so they're seen as published with it.
+  const SlotArray* array = array_;
+  mirror::Class* result = nullptr;
+  for (size_t i = hash & array->mask; ; i = (i + 1) & array->mask) {
+    const Slot& slot = array->slots[i];
+    mirror::Class* klass = slot.klass;
+    if (klass == nullptr) {
+      break;
+    }
+    // Don't read the hash of the slot before its class.
+    QuasiAtomic::MembarLoadLoad();
+    if (slot.hash != hash || !IsLive(klass) || klass->GetClassLoader() != class_loader ||
+        !klass->DescriptorEquals(descriptor)) {
+      continue;
+    }
+    if (!kIsDebugBuild) {
+      return klass;
+    }
+    // Check for duplicates in the rest of the probe sequence.
+    CHECK(result == nullptr)
+        << PrettyClass(result) << " " << result << " " << result->GetClassLoader() << " "
+        << PrettyClass(klass) << " " << klass << " " << klass->GetClassLoader();
+    result = klass;
+  }
+  return result;
+}
+
+void ClassTable::LookupAll(const char* descriptor, size_t hash,
+                           std::vector<mirror::Class*>* classes) {
+  const SlotArray* array = array_;
+  for (size_t i = hash & array->mask; array->slots[i].klass != nullptr; i = (i + 1) & array->mask) {
+    mirror::Class* klass = array->slots[i].klass;
+    if (array->slots[i].hash == hash && IsLive(klass) && klass->DescriptorEquals(descriptor)) {
+      classes->push_back(klass);
+    }
+  }
+}
+
+bool ClassTable::InsertInto(SlotArray* array, mirror::Class* klass, size_t hash) {
+  size_t i = hash & array->mask;
+  while (IsLive(array->slots[i].klass)) {
+    i = (i + 1) & array->mask;
+  }
+  // A reader which sees the tombstone skips the slot, one which sees the class sees its hash.
+  bool was_free = array->slots[i].klass == nullptr;
+  array->slots[i].hash = hash;
+  // Readers may find the slot as soon as its class is stored.
+  QuasiAtomic::MembarStoreStore();
+  array->slots[i].klass = klass;
+  return was_free;
+}
+
+void ClassTable::Insert(mirror::Class* klass, size_t hash) {
+  DCHECK(IsLive(klass));
+  if ((num_used_slots_ + 1) * 100 > (array_->mask + 1) * kMaxLoadPercent) {
+    Grow();
+  }
+  if (InsertInto(array_, klass, hash)) {
+    ++num_used_slots_;
+  }
+  ++num_classes_;
+}
+
+bool ClassTable::Remove(const char* descriptor, const mirror::ClassLoader* class_loader,
+                        size_t hash) {
+  SlotArray* array = array_;
+  for (size_t i = hash & array->mask; array->slots[i].klass != nullptr; i = (i + 1) & array->mask) {
+    mirror::Class* klass = array->slots[i].klass;
+    if (array->slots[i].hash == hash && IsLive(klass) && klass->GetClassLoader() == class_loader &&
+        klass->DescriptorEquals(descriptor)) {
+      // The slot stays in the probe sequences of the other classes.
+      array->slots[i].klass = reinterpret_cast<mirror::Class*>(kRemovedClass);
+      --num_classes_;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ClassTable::Update(size_t hash, mirror::Class* old_class, mirror::Class* new_class) {
+  SlotArray* array = array_;
+  for (size_t i = hash & array->mask; array->slots[i].klass != nullptr; i = (i + 1) & array->mask) {
+    if (array->slots[i].klass == old_class) {
+      array->slots[i].klass = new_class;
+    }
+  }
+}
+
+void ClassTable::VisitRoots(RootCallback* callback, void* arg) {
+  SlotArray* array = array_;
+  for (size_t i = 0; i <= array->mask; ++i) {
+    if (IsLive(array->slots[i].klass)) {
+      mirror::Class** root = const_cast<mirror::Class**>(&array->slots[i].klass);
+      callback(reinterpret_cast<mirror::Object**>(root), arg, 0, kRootStickyClass);
+    }
+  }
+}
+
+bool ClassTable::Visit(bool (*visitor)(mirror::Class*, void*), void* arg) {
+  const SlotArray* array = array_;
+  for (size_t i = 0; i <= array->mask; ++i) {
+    mirror::Class* klass = array->slots[i].klass;
+    if (IsLive(klass) && !visitor(klass, arg)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ClassTable::ClearTombstones() {
+  SlotArray* array = array_;
+  size_t capacity = array->mask + 1;
+  // Start after a free slot so that no cluster of used slots wraps around the walk. There is one
+  // since the table is at most kMaxLoadPercent full.
+  size_t start = 0;
+  while (array->slots[start].klass != nullptr) {
+    ++start;
+  }
+  // Walk each cluster backwards, tracking the lowest position from which a class further in the
+  // cluster is probed for. The tombstones below it can't be cleared, the others can.
+  size_t num_used_slots = 0;
+  size_t lowest_probe_start = capacity;
+  for (size_t pos = capacity - 1; pos != 0; --pos) {
+    size_t i = (start + pos) & array->mask;
+    mirror::Class* klass = array->slots[i].klass;
+    if (klass == nullptr) {
+      lowest_probe_start = capacity;
+      continue;
+    }
+    if (IsLive(klass)) {
+      size_t probe_length = (i - array->slots[i].hash) & array->mask;
+      lowest_probe_start = std::min(lowest_probe_start, pos - probe_length);
+    } else if (lowest_probe_start > pos) {
+      array->slots[i].klass = nullptr;
+      lowest_probe_start = capacity;
+      continue;
+    }
+    ++num_used_slots;
+  }
+  num_used_slots_ = num_used_slots;
+}
+
+void ClassTable::Grow() {
+  SlotArray* old_array = array_;
+  size_t capacity = old_array->mask + 1;
+  if (num_used_slots_ != num_classes_) {
+    ClearTombstones();
+    if ((num_used_slots_ + 1) * 100 <= capacity * kMaxLoadPercent) {
+      return;
+    }
+  }
+  // Only replace the array when it doubles, so that the retired arrays stay smaller than it.
+  SlotArray* new_array = new SlotArray(capacity * 2);
+  for (size_t i = 0; i <= old_array->mask; ++i) {
+    mirror::Class* klass = old_array->slots[i].klass;
+    if (IsLive(klass)) {
+      InsertInto(new_array, klass, old_array->slots[i].hash);
+    }
+  }
+  // Publish the array once all its classes are in.
+  QuasiAtomic::MembarStoreStore();
+  array_ = new_array;
+  retired_arrays_.push_back(std::unique_ptr<SlotArray>(old_array));
+  num_used_slots_ = num_classes_;
+}
+
+}  // namespace art
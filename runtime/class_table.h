@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CLASS_TABLE_H_
+#define ART_RUNTIME_CLASS_TABLE_H_
+
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "object_callbacks.h"
+
+namespace art {
+
+namespace mirror {
+  class Class;
+  class ClassLoader;
+}  // namespace mirror
+
+// The loaded classes, in an open-addressing hash table keyed by the hash of their descriptor.
+// Classes are inserted and removed with the classlinker_classes_lock_ held exclusively, but
+// looked up without any lock: a slot is published by storing its class after its hash, and the
+// slot array is only replaced, when it grows, by a complete copy. The replaced arrays are kept
+// until the table is destroyed as readers may still be probing them; with the array doubling
+// as it grows they take less memory than the current one. Removed classes leave a tombstone,
+// which insertions reuse and which is cleared in place once no probe sequence goes through it.
+class ClassTable {
+ public:
+  ClassTable();
+  ~ClassTable();
+
+  // Returns the class with `descriptor`, whose hash is `hash`, defined by `class_loader`, or
+  // null. Lock-free, may miss a class being inserted concurrently.
+  mirror::Class* Lookup(const char* descriptor, const mirror::ClassLoader* class_loader,
+                        size_t hash)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Appends the classes with `descriptor`, defined by any class loader, to `classes`.
+  void LookupAll(const char* descriptor, size_t hash, std::vector<mirror::Class*>* classes)
+      SHARED_LOCKS_REQUIRED(Locks::classlinker_classes_lock_, Locks::mutator_lock_);
+
+  // Inserts `klass`, whose descriptor hashes to `hash`. The class must not be in the table.
+  void Insert(mirror::Class* klass, size_t hash)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_);
+
+  // Returns true if the class was found and removed.
+  bool Remove(const char* descriptor, const mirror::ClassLoader* class_loader, size_t hash)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Replaces `old_class`, whose descriptor hashes to `hash`, with `new_class`, which the GC
+  // moved it to.
+  void Update(size_t hash, mirror::Class* old_class, mirror::Class* new_class)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_);
+
+  void VisitRoots(RootCallback* callback, void* arg)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_);
+
+  // Calls `visitor` with each class until it returns false. Returns false if it did.
+  bool Visit(bool (*visitor)(mirror::Class*, void*), void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::classlinker_classes_lock_, Locks::mutator_lock_);
+
+  size_t Size() const SHARED_LOCKS_REQUIRED(Locks::classlinker_classes_lock_) {
+    return num_classes_;
+  }
+
+ private:
+  struct Slot {
+    // The hash is only read once the class is seen.
+    volatile size_t hash;
+    // Null if the slot was never used, kRemovedClass for a tombstone.
+    mirror::Class* volatile klass;
+  };
+
+  struct SlotArray {
+    explicit SlotArray(size_t capacity);
+
+    const size_t mask;
+    std::unique_ptr<Slot[]> slots;
+  };
+
+  static constexpr size_t kInitialCapacity = 1024;
+  // Compared against num_used_slots_, which includes the tombstones.
+  static constexpr size_t kMaxLoadPercent = 50;
+
+  static constexpr uintptr_t kRemovedClass = 1u;
+
+  static bool IsLive(const mirror::Class* klass) {
+    return reinterpret_cast<uintptr_t>(klass) > kRemovedClass;
+  }
+
+  // Finds a free slot or a tombstone for `hash` in `array` and fills it, publishing the class
+  // last. Returns true if the slot was free.
+  static bool InsertInto(SlotArray* array, mirror::Class* klass, size_t hash);
+
+  // Makes room for an insertion, by clearing tombstones or by growing the table.
+  void Grow() EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_);
+
+  // Clears the tombstones which no probe sequence goes through, so that concurrent readers still
+  // find every class.
+  void ClearTombstones() EXCLUSIVE_LOCKS_REQUIRED(Locks::classlinker_classes_lock_);
+
+  // Read without the lock.
+  SlotArray* volatile array_;
+  std::vector<std::unique_ptr<SlotArray>> retired_arrays_
+      GUARDED_BY(Locks::classlinker_classes_lock_);
+  size_t num_classes_ GUARDED_BY(Locks::classlinker_classes_lock_);
+  size_t num_used_slots_ GUARDED_BY(Locks::classlinker_classes_lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(ClassTable);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CLASS_TABLE_H_
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_table.h"
+
+#include "common_runtime_test.h"
+#include "mirror/class-inl.h"
+
+namespace art {
+
+class ClassTableTest : public CommonRuntimeTest {};
+
+TEST_F(ClassTableTest, InsertLookupRemove) {
+  ScopedObjectAccess soa(Thread::Current());
+  mirror::Class* object = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  mirror::Class* string = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/String;");
+  ASSERT_TRUE(object != nullptr);
+  ASSERT_TRUE(string != nullptr);
+  ClassTable table;
+  WriterMutexLock mu(soa.Self(), *Locks::classlinker_classes_lock_);
+  // Both in the same probe sequence.
+  table.Insert(object, 7u);
+  table.Insert(string, 7u);
+  EXPECT_EQ(2u, table.Size());
+  EXPECT_EQ(object, table.Lookup("Ljava/lang/Object;", nullptr, 7u));
+  EXPECT_EQ(string, table.Lookup("Ljava/lang/String;", nullptr, 7u));
+  EXPECT_TRUE(table.Lookup("Ljava/lang/String;", nullptr, 8u) == nullptr);
+  EXPECT_TRUE(table.Lookup("Ljava/lang/Class;", nullptr, 7u) == nullptr);
+
+  // The string class stays reachable past the tombstone of the object class.
+  EXPECT_TRUE(table.Remove("Ljava/lang/Object;", nullptr, 7u));
+  EXPECT_FALSE(table.Remove("Ljava/lang/Object;", nullptr, 7u));
+  EXPECT_EQ(1u, table.Size());
+  EXPECT_TRUE(table.Lookup("Ljava/lang/Object;", nullptr, 7u) == nullptr);
+  EXPECT_EQ(string, table.Lookup("Ljava/lang/String;", nullptr, 7u));
+
+  std::vector<mirror::Class*> classes;
+  table.LookupAll("Ljava/lang/String;", 7u, &classes);
+  ASSERT_EQ(1u, classes.size());
+  EXPECT_EQ(string, classes[0]);
+}
+
+TEST_F(ClassTableTest, Grow) {
+  ScopedObjectAccess soa(Thread::Current());
+  mirror::Class* object = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  ASSERT_TRUE(object != nullptr);
+  ClassTable table;
+  WriterMutexLock mu(soa.Self(), *Locks::classlinker_classes_lock_);
+  // The same class under distinct hashes, enough of them to grow the table a few times.
+  static constexpr size_t kNumHashes = 5000;
+  for (size_t hash = 0; hash < kNumHashes; ++hash) {
+    table.Insert(object, hash * 3);
+  }
+  EXPECT_EQ(kNumHashes, table.Size());
+  for (size_t hash = 0; hash < kNumHashes; ++hash) {
+    EXPECT_EQ(object, table.Lookup("Ljava/lang/Object;", nullptr, hash * 3));
+    EXPECT_TRUE(table.Lookup("Ljava/lang/Object;", nullptr, hash * 3 + 1) == nullptr);
+  }
+}
+
+TEST_F(ClassTableTest, RemoveInsertChurn) {
+  ScopedObjectAccess soa(Thread::Current());
+  mirror::Class* object = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  ASSERT_TRUE(object != nullptr);
+  ClassTable table;
+  WriterMutexLock mu(soa.Self(), *Locks::classlinker_classes_lock_);
+  // Far more insertions than the table has slots, the tombstones they leave must be reclaimed.
+  static constexpr size_t kNumChurned = 100000;
+  // A few classes which stay, in the probe sequences of the ones coming and going.
+  static constexpr size_t kNumKept = 16;
+  static constexpr size_t kKeptHash = kNumChurned + 1;
+  for (size_t hash = 0; hash < kNumKept; ++hash) {
+    table.Insert(object, kKeptHash + hash * 64);
+  }
+  for (size_t hash = 1; hash <= kNumChurned; ++hash) {
+    table.Insert(object, hash);
+    if (hash > 8) {
+      EXPECT_TRUE(table.Remove("Ljava/lang/Object;", nullptr, hash - 8));
+    }
+  }
+  EXPECT_EQ(kNumKept + 8, table.Size());
+  for (size_t hash = 0; hash < kNumKept; ++hash) {
+    EXPECT_EQ(object, table.Lookup("Ljava/lang/Object;", nullptr, kKeptHash + hash * 64));
+  }
+  for (size_t hash = kNumChurned - 7; hash <= kNumChurned; ++hash) {
+    EXPECT_EQ(object, table.Lookup("Ljava/lang/Object;", nullptr, hash));
+  }
+  EXPECT_TRUE(table.Lookup("Ljava/lang/Object;", nullptr, kNumChurned - 8) == nullptr);
+}
+
+}  // namespace art
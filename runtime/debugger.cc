@@ -18,6 +18,7 @@
 
 #include <sys/uio.h>
 
+#include <algorithm>
 #include <set>
 
 #include "arch/context.h"
@@ -61,6 +62,8 @@ namespace art {
 
 static const size_t kMaxAllocRecordStackDepth = 16;  // Max 255.
 static const size_t kDefaultNumAllocRecords = 64*1024;  // Must be a power of 2.
+static const size_t kDefaultAllocRecordSamplingInterval = 1;  // Record every allocation.
+static const size_t kThreadAllocRecords = 64;  // Records buffered by a thread before merging them.
 
 struct AllocRecordStackTraceElement {
   mirror::ArtMethod* method;
@@ -68,19 +71,15 @@ struct AllocRecordStackTraceElement {
 
   AllocRecordStackTraceElement() : method(nullptr), dex_pc(0) {
   }
-
-  int32_t LineNumber() const SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    return MethodHelper(method).GetLineNumFromDexPC(dex_pc);
-  }
 };
 
-struct AllocRecord {
+// An allocation recorded by a thread, not merged into the shared records yet.
+struct ThreadAllocRecord {
   mirror::Class* type;
   size_t byte_count;
-  uint16_t thin_lock_id;
   AllocRecordStackTraceElement stack[kMaxAllocRecordStackDepth];  // Unused entries have NULL method.
 
-  size_t GetDepth() {
+  size_t GetDepth() const {
     size_t depth = 0;
     while (depth < kMaxAllocRecordStackDepth && stack[depth].method != NULL) {
       ++depth;
@@ -103,6 +102,109 @@ struct AllocRecord {
   }
 };
 
+// The allocations a thread recorded since it last merged them into the shared records. Only the
+// thread writes to its buffer, the other threads only use it while the thread is suspended.
+struct AllocRecordBuffer {
+  explicit AllocRecordBuffer(size_t sampling_interval)
+      : allocations_until_record(sampling_interval), count(0) {
+  }
+
+  size_t allocations_until_record;
+  size_t count;
+  ThreadAllocRecord records[kThreadAllocRecords];
+};
+
+// A frame of a recorded stack trace. It only keeps dex file locations, the GC doesn't need to
+// update the stack traces.
+struct AllocRecordFrame {
+  const DexFile* dex_file;
+  uint32_t method_idx;
+  uint32_t dex_pc;
+  // Looked up when the stack trace is first recorded, the strings are in the dex file.
+  const char* class_descriptor;
+  const char* method_name;
+  const char* source_file;
+  int32_t line_number;
+
+  bool operator<(const AllocRecordFrame& other) const {
+    if (dex_file != other.dex_file) {
+      return dex_file < other.dex_file;
+    }
+    if (method_idx != other.method_idx) {
+      return method_idx < other.method_idx;
+    }
+    return dex_pc < other.dex_pc;
+  }
+};
+
+typedef std::vector<AllocRecordFrame> AllocRecordStackTrace;
+
+// The distinct stack traces of the recorded allocations. Many allocations are made from the same
+// call stacks, so the records only keep the index of their stack trace.
+class AllocRecordStackTraces {
+ public:
+  AllocRecordStackTraces() {
+  }
+
+  // Returns the index of the stack trace of the given frames, adding it if it is new.
+  uint32_t Add(const AllocRecordStackTraceElement* stack, size_t depth)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    key_.resize(depth);
+    MethodHelper mh;
+    for (size_t i = 0; i < depth; ++i) {
+      mh.ChangeMethod(stack[i].method);
+      key_[i].dex_file = &mh.GetDexFile();
+      key_[i].method_idx = stack[i].method->GetDexMethodIndex();
+      key_[i].dex_pc = stack[i].dex_pc;
+    }
+    auto it = indexes_.find(key_);
+    if (it != indexes_.end()) {
+      return it->second;
+    }
+    for (size_t i = 0; i < depth; ++i) {
+      mh.ChangeMethod(stack[i].method);
+      const char* source_file = mh.GetDeclaringClassSourceFile();
+      key_[i].class_descriptor = mh.GetDeclaringClassDescriptor();
+      key_[i].method_name = mh.GetName();
+      key_[i].source_file = (source_file != nullptr) ? source_file : "";
+      key_[i].line_number = mh.GetLineNumFromDexPC(stack[i].dex_pc);
+    }
+    uint32_t index = traces_.size();
+    indexes_.Put(key_, index);
+    traces_.push_back(&indexes_.find(key_)->first);
+    return index;
+  }
+
+  const AllocRecordStackTrace& Get(uint32_t index) const {
+    return *traces_[index];
+  }
+
+  size_t Size() const {
+    return traces_.size();
+  }
+
+ private:
+  SafeMap<AllocRecordStackTrace, uint32_t> indexes_;
+  std::vector<const AllocRecordStackTrace*> traces_;
+  AllocRecordStackTrace key_;
+
+  DISALLOW_COPY_AND_ASSIGN(AllocRecordStackTraces);
+};
+
+struct AllocRecord {
+  mirror::Class* type;
+  size_t byte_count;
+  uint16_t thin_lock_id;
+  uint32_t stack_trace_index;
+
+  void UpdateObjectPointers(IsMarkedCallback* callback, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (type != nullptr) {
+      type = down_cast<mirror::Class*>(callback(type, arg));
+    }
+  }
+};
+
 struct Breakpoint {
   // The location of this breakpoint.
   mirror::ArtMethod* method;
@@ -221,6 +323,8 @@ AllocRecord* Dbg::recent_allocation_records_ = nullptr;  // TODO: CircularBuffer
 size_t Dbg::alloc_record_max_ = 0;
 size_t Dbg::alloc_record_head_ = 0;
 size_t Dbg::alloc_record_count_ = 0;
+AllocRecordStackTraces* Dbg::alloc_record_stack_traces_ = nullptr;
+size_t Dbg::alloc_record_sampling_interval_ = kDefaultAllocRecordSamplingInterval;
 
 // Deoptimization support.
 Mutex* Dbg::deoptimization_lock_ = nullptr;
@@ -237,9 +341,25 @@ size_t Dbg::field_write_event_ref_count_ = 0;
 size_t Dbg::exception_catch_event_ref_count_ = 0;
 uint32_t Dbg::instrumentation_events_ = 0;
 
-// Breakpoints.
+// Breakpoints, sorted by method and dex pc so that they're found with a binary search: the
+// interpreter looks them up for every instruction it executes while the debugger is active.
 static std::vector<Breakpoint> gBreakpoints GUARDED_BY(Locks::breakpoint_lock_);
 
+static bool BreakpointLess(const Breakpoint& lhs, const Breakpoint& rhs) {
+  if (lhs.method != rhs.method) {
+    return lhs.method < rhs.method;
+  }
+  return lhs.dex_pc < rhs.dex_pc;
+}
+
+// Returns the first breakpoint at or after the given location in gBreakpoints.
+static std::vector<Breakpoint>::iterator LowerBoundBreakpoint(const mirror::ArtMethod* m,
+                                                              uint32_t dex_pc)
+    EXCLUSIVE_LOCKS_REQUIRED(Locks::breakpoint_lock_) {
+  Breakpoint key(const_cast<mirror::ArtMethod*>(m), dex_pc, false);
+  return std::lower_bound(gBreakpoints.begin(), gBreakpoints.end(), key, BreakpointLess);
+}
+
 void DebugInvokeReq::VisitRoots(RootCallback* callback, void* arg, uint32_t tid,
                                 RootType root_type) {
   if (receiver != nullptr) {
@@ -291,11 +411,10 @@ static bool IsBreakpoint(const mirror::ArtMethod* m, uint32_t dex_pc)
     LOCKS_EXCLUDED(Locks::breakpoint_lock_)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   MutexLock mu(Thread::Current(), *Locks::breakpoint_lock_);
-  for (size_t i = 0, e = gBreakpoints.size(); i < e; ++i) {
-    if (gBreakpoints[i].method == m && gBreakpoints[i].dex_pc == dex_pc) {
-      VLOG(jdwp) << "Hit breakpoint #" << i << ": " << gBreakpoints[i];
-      return true;
-    }
+  auto it = LowerBoundBreakpoint(m, dex_pc);
+  if (it != gBreakpoints.end() && it->method == m && it->dex_pc == dex_pc) {
+    VLOG(jdwp) << "Hit breakpoint #" << (it - gBreakpoints.begin()) << ": " << *it;
+    return true;
   }
   return false;
 }
@@ -579,6 +698,8 @@ void Dbg::VisitRoots(RootCallback* callback, void* arg) {
     for (Breakpoint& bp : gBreakpoints) {
       bp.VisitRoots(callback, arg);
     }
+    // Moved methods may no longer be in order.
+    std::sort(gBreakpoints.begin(), gBreakpoints.end(), BreakpointLess);
   }
   if (deoptimization_lock_ != nullptr) {  // only true if the debugger is started.
     MutexLock mu(Thread::Current(), *deoptimization_lock_);
@@ -899,18 +1020,22 @@ JDWP::JdwpError Dbg::GetOwnedMonitors(JDWP::ObjectId thread_id,
 JDWP::JdwpError Dbg::GetContendedMonitor(JDWP::ObjectId thread_id,
                                          JDWP::ObjectId& contended_monitor) {
   ScopedObjectAccessUnchecked soa(Thread::Current());
-  MutexLock mu(soa.Self(), *Locks::thread_list_lock_);
-  Thread* thread;
-  JDWP::JdwpError error = DecodeThread(soa, thread_id, thread);
-  if (error != JDWP::ERR_NONE) {
-    return error;
-  }
-  if (!IsSuspendedForDebugger(soa, thread)) {
-    return JDWP::ERR_THREAD_NOT_SUSPENDED;
+  mirror::Object* contended_object;
+  {
+    MutexLock mu(soa.Self(), *Locks::thread_list_lock_);
+    Thread* thread;
+    JDWP::JdwpError error = DecodeThread(soa, thread_id, thread);
+    if (error != JDWP::ERR_NONE) {
+      return error;
+    }
+    if (!IsSuspendedForDebugger(soa, thread)) {
+      return JDWP::ERR_THREAD_NOT_SUSPENDED;
+    }
+    contended_object = Monitor::GetContendedMonitor(thread);
   }
-
-  contended_monitor = gRegistry->Add(Monitor::GetContendedMonitor(thread));
-
+  // Add may compute the identity hash code of the object, which must not happen while holding
+  // the thread_list_lock_.
+  contended_monitor = gRegistry->Add(contended_object);
   return JDWP::ERR_NONE;
 }
 
@@ -2888,10 +3013,9 @@ static bool IsMethodPossiblyInlined(Thread* self, mirror::ArtMethod* m)
 
 static const Breakpoint* FindFirstBreakpointForMethod(mirror::ArtMethod* m)
     EXCLUSIVE_LOCKS_REQUIRED(Locks::breakpoint_lock_) {
-  for (const Breakpoint& breakpoint : gBreakpoints) {
-    if (breakpoint.method == m) {
-      return &breakpoint;
-    }
+  auto it = LowerBoundBreakpoint(m, 0);
+  if (it != gBreakpoints.end() && it->method == m) {
+    return &*it;
   }
   return nullptr;
 }
@@ -2900,8 +3024,8 @@ static const Breakpoint* FindFirstBreakpointForMethod(mirror::ArtMethod* m)
 static void SanityCheckExistingBreakpoints(mirror::ArtMethod* m, bool need_full_deoptimization)
     EXCLUSIVE_LOCKS_REQUIRED(Locks::breakpoint_lock_)  {
   if (kIsDebugBuild) {
-    for (const Breakpoint& breakpoint : gBreakpoints) {
-      CHECK_EQ(need_full_deoptimization, breakpoint.need_full_deoptimization);
+    for (auto it = LowerBoundBreakpoint(m, 0); it != gBreakpoints.end() && it->method == m; ++it) {
+      CHECK_EQ(need_full_deoptimization, it->need_full_deoptimization);
     }
     if (need_full_deoptimization) {
       // We should have deoptimized everything but not "selectively" deoptimized this method.
@@ -2946,9 +3070,9 @@ void Dbg::WatchLocation(const JDWP::JdwpLocation* location, DeoptimizationReques
     SanityCheckExistingBreakpoints(m, need_full_deoptimization);
   }
 
-  gBreakpoints.push_back(Breakpoint(m, location->dex_pc, need_full_deoptimization));
-  VLOG(jdwp) << "Set breakpoint #" << (gBreakpoints.size() - 1) << ": "
-             << gBreakpoints[gBreakpoints.size() - 1];
+  auto it = gBreakpoints.insert(LowerBoundBreakpoint(m, location->dex_pc),
+                                Breakpoint(m, location->dex_pc, need_full_deoptimization));
+  VLOG(jdwp) << "Set breakpoint #" << (it - gBreakpoints.begin()) << ": " << *it;
 }
 
 // Uninstalls a breakpoint at the specified location. Also indicates through the deoptimization
@@ -2959,14 +3083,12 @@ void Dbg::UnwatchLocation(const JDWP::JdwpLocation* location, DeoptimizationRequ
 
   MutexLock mu(Thread::Current(), *Locks::breakpoint_lock_);
   bool need_full_deoptimization = false;
-  for (size_t i = 0, e = gBreakpoints.size(); i < e; ++i) {
-    if (gBreakpoints[i].method == m && gBreakpoints[i].dex_pc == location->dex_pc) {
-      VLOG(jdwp) << "Removed breakpoint #" << i << ": " << gBreakpoints[i];
-      need_full_deoptimization = gBreakpoints[i].need_full_deoptimization;
-      DCHECK_NE(need_full_deoptimization, Runtime::Current()->GetInstrumentation()->IsDeoptimized(m));
-      gBreakpoints.erase(gBreakpoints.begin() + i);
-      break;
-    }
+  auto it = LowerBoundBreakpoint(m, location->dex_pc);
+  if (it != gBreakpoints.end() && it->method == m && it->dex_pc == location->dex_pc) {
+    VLOG(jdwp) << "Removed breakpoint #" << (it - gBreakpoints.begin()) << ": " << *it;
+    need_full_deoptimization = it->need_full_deoptimization;
+    DCHECK_NE(need_full_deoptimization, Runtime::Current()->GetInstrumentation()->IsDeoptimized(m));
+    gBreakpoints.erase(it);
   }
   const Breakpoint* const existing_breakpoint = FindFirstBreakpointForMethod(m);
   if (existing_breakpoint == nullptr) {
@@ -4061,28 +4183,29 @@ void Dbg::DdmSendHeapSegments(bool native) {
   Dbg::DdmSendChunk(native ? CHUNK_TYPE("NHEN") : CHUNK_TYPE("HPEN"), sizeof(heap_id), heap_id);
 }
 
-static size_t GetAllocTrackerMax() {
+// Returns the value of a system property overriding a setting of the alloc tracker, or the
+// default value.
+static size_t GetAllocTrackerProperty(const char* property_name, size_t default_value,
+                                      bool power_of_two) {
 #ifdef HAVE_ANDROID_OS
-  // Check whether there's a system property overriding the number of records.
-  const char* propertyName = "dalvik.vm.allocTrackerMax";
-  char allocRecordMaxString[PROPERTY_VALUE_MAX];
-  if (property_get(propertyName, allocRecordMaxString, "") > 0) {
+  char value_string[PROPERTY_VALUE_MAX];
+  if (property_get(property_name, value_string, "") > 0) {
     char* end;
-    size_t value = strtoul(allocRecordMaxString, &end, 10);
-    if (*end != '\0') {
-      LOG(ERROR) << "Ignoring  " << propertyName << " '" << allocRecordMaxString
+    size_t value = strtoul(value_string, &end, 10);
+    if (*end != '\0' || value == 0) {
+      LOG(ERROR) << "Ignoring  " << property_name << " '" << value_string
                  << "' --- invalid";
-      return kDefaultNumAllocRecords;
+      return default_value;
     }
-    if (!IsPowerOfTwo(value)) {
-      LOG(ERROR) << "Ignoring  " << propertyName << " '" << allocRecordMaxString
+    if (power_of_two && !IsPowerOfTwo(value)) {
+      LOG(ERROR) << "Ignoring  " << property_name << " '" << value_string
                  << "' --- not power of two";
-      return kDefaultNumAllocRecords;
+      return default_value;
     }
     return value;
   }
 #endif
-  return kDefaultNumAllocRecords;
+  return default_value;
 }
 
 void Dbg::SetAllocTrackingEnabled(bool enabled) {
@@ -4090,11 +4213,17 @@ void Dbg::SetAllocTrackingEnabled(bool enabled) {
     {
       MutexLock mu(Thread::Current(), *alloc_tracker_lock_);
       if (recent_allocation_records_ == NULL) {
-        alloc_record_max_ = GetAllocTrackerMax();
+        alloc_record_max_ = GetAllocTrackerProperty("dalvik.vm.allocTrackerMax",
+                                                    kDefaultNumAllocRecords, true);
+        alloc_record_sampling_interval_ =
+            GetAllocTrackerProperty("dalvik.vm.allocTrackerSamplingInterval",
+                                    kDefaultAllocRecordSamplingInterval, false);
         LOG(INFO) << "Enabling alloc tracker (" << alloc_record_max_ << " entries of "
             << kMaxAllocRecordStackDepth << " frames, taking "
-            << PrettySize(sizeof(AllocRecord) * alloc_record_max_) << ")";
+            << PrettySize(sizeof(AllocRecord) * alloc_record_max_) << ", recording one of every "
+            << alloc_record_sampling_interval_ << " allocations)";
         alloc_record_head_ = alloc_record_count_ = 0;
+        alloc_record_stack_traces_ = new AllocRecordStackTraces;
         recent_allocation_records_ = new AllocRecord[alloc_record_max_];
         CHECK(recent_allocation_records_ != NULL);
       }
@@ -4102,16 +4231,27 @@ void Dbg::SetAllocTrackingEnabled(bool enabled) {
     Runtime::Current()->GetInstrumentation()->InstrumentQuickAllocEntryPoints();
   } else {
     Runtime::Current()->GetInstrumentation()->UninstrumentQuickAllocEntryPoints();
+    // Free the buffers of the threads while they can't record allocations.
+    Thread* self = Thread::Current();
+    ThreadList* thread_list = Runtime::Current()->GetThreadList();
+    thread_list->SuspendAll();
     {
-      MutexLock mu(Thread::Current(), *alloc_tracker_lock_);
+      MutexLock mu(self, *Locks::thread_list_lock_);
+      thread_list->ForEach(DeleteAllocRecordBufferCallback, nullptr);
+    }
+    {
+      MutexLock mu(self, *alloc_tracker_lock_);
       delete[] recent_allocation_records_;
       recent_allocation_records_ = NULL;
+      delete alloc_record_stack_traces_;
+      alloc_record_stack_traces_ = nullptr;
     }
+    thread_list->ResumeAll();
   }
 }
 
 struct AllocRecordStackVisitor : public StackVisitor {
-  AllocRecordStackVisitor(Thread* thread, AllocRecord* record)
+  AllocRecordStackVisitor(Thread* thread, ThreadAllocRecord* record)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
       : StackVisitor(thread, NULL), record(record), depth(0) {}
 
@@ -4138,7 +4278,7 @@ struct AllocRecordStackVisitor : public StackVisitor {
     }
   }
 
-  AllocRecord* record;
+  ThreadAllocRecord* record;
   size_t depth;
 };
 
@@ -4146,28 +4286,99 @@ void Dbg::RecordAllocation(mirror::Class* type, size_t byte_count) {
   Thread* self = Thread::Current();
   CHECK(self != NULL);
 
-  MutexLock mu(self, *alloc_tracker_lock_);
+  // The tracking can't be disabled while this thread is runnable.
   if (recent_allocation_records_ == NULL) {
     return;
   }
-
-  // Advance and clip.
-  if (++alloc_record_head_ == alloc_record_max_) {
-    alloc_record_head_ = 0;
+  AllocRecordBuffer* buffer = self->GetAllocRecordBuffer();
+  if (UNLIKELY(buffer == nullptr)) {
+    buffer = new AllocRecordBuffer(alloc_record_sampling_interval_);
+    self->SetAllocRecordBuffer(buffer);
   }
+  if (--buffer->allocations_until_record != 0) {
+    return;
+  }
+  buffer->allocations_until_record = alloc_record_sampling_interval_;
 
   // Fill in the basics.
-  AllocRecord* record = &recent_allocation_records_[alloc_record_head_];
+  ThreadAllocRecord* record = &buffer->records[buffer->count++];
   record->type = type;
   record->byte_count = byte_count;
-  record->thin_lock_id = self->GetThreadId();
 
   // Fill in the stack trace.
   AllocRecordStackVisitor visitor(self, record);
   visitor.WalkStack();
 
-  if (alloc_record_count_ < alloc_record_max_) {
-    ++alloc_record_count_;
+  if (buffer->count == kThreadAllocRecords) {
+    MutexLock mu(self, *alloc_tracker_lock_);
+    MergeAllocRecords(self, buffer);
+  }
+}
+
+void Dbg::MergeAllocRecords(Thread* thread, AllocRecordBuffer* buffer) {
+  if (recent_allocation_records_ != NULL) {
+    uint16_t thin_lock_id = thread->GetThreadId();
+    for (size_t i = 0; i < buffer->count; ++i) {
+      const ThreadAllocRecord& thread_record = buffer->records[i];
+
+      // Advance and clip.
+      if (++alloc_record_head_ == alloc_record_max_) {
+        alloc_record_head_ = 0;
+      }
+
+      AllocRecord* record = &recent_allocation_records_[alloc_record_head_];
+      record->type = thread_record.type;
+      record->byte_count = thread_record.byte_count;
+      record->thin_lock_id = thin_lock_id;
+      record->stack_trace_index =
+          alloc_record_stack_traces_->Add(thread_record.stack, thread_record.GetDepth());
+
+      if (alloc_record_count_ < alloc_record_max_) {
+        ++alloc_record_count_;
+      }
+    }
+  }
+  buffer->count = 0;
+}
+
+void Dbg::MergeAllocRecordsCallback(Thread* thread, void*) {
+  AllocRecordBuffer* buffer = thread->GetAllocRecordBuffer();
+  if (buffer != nullptr) {
+    MergeAllocRecords(thread, buffer);
+  }
+}
+
+void Dbg::DeleteAllocRecordBufferCallback(Thread* thread, void*) {
+  delete thread->GetAllocRecordBuffer();
+  thread->SetAllocRecordBuffer(nullptr);
+}
+
+void Dbg::MergeAllThreadAllocRecords(Thread* self) {
+  // Release the shared access to the mutator lock to suspend the other threads, a thread doesn't
+  // record allocations while suspended.
+  Locks::mutator_lock_->AssertSharedHeld(self);
+  self->TransitionFromRunnableToSuspended(kSuspended);
+  ThreadList* thread_list = Runtime::Current()->GetThreadList();
+  thread_list->SuspendAll();
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    MutexLock mu2(self, *alloc_tracker_lock_);
+    thread_list->ForEach(MergeAllocRecordsCallback, nullptr);
+  }
+  thread_list->ResumeAll();
+  self->TransitionFromSuspendedToRunnable();
+  Locks::mutator_lock_->AssertSharedHeld(self);
+}
+
+void Dbg::FlushThreadAllocRecords(Thread* self) {
+  AllocRecordBuffer* buffer = self->GetAllocRecordBuffer();
+  if (buffer != nullptr) {
+    {
+      MutexLock mu(self, *alloc_tracker_lock_);
+      MergeAllocRecords(self, buffer);
+    }
+    delete buffer;
+    self->SetAllocRecordBuffer(nullptr);
   }
 }
 
@@ -4186,6 +4397,7 @@ size_t Dbg::HeadIndex() {
 
 void Dbg::DumpRecentAllocations() {
   ScopedObjectAccess soa(Thread::Current());
+  MergeAllThreadAllocRecords(soa.Self());
   MutexLock mu(soa.Self(), *alloc_tracker_lock_);
   if (recent_allocation_records_ == NULL) {
     LOG(INFO) << "Not recording tracked allocations";
@@ -4204,12 +4416,11 @@ void Dbg::DumpRecentAllocations() {
     LOG(INFO) << StringPrintf(" Thread %-2d %6zd bytes ", record->thin_lock_id, record->byte_count)
               << PrettyClass(record->type);
 
-    for (size_t stack_frame = 0; stack_frame < kMaxAllocRecordStackDepth; ++stack_frame) {
-      mirror::ArtMethod* m = record->stack[stack_frame].method;
-      if (m == NULL) {
-        break;
-      }
-      LOG(INFO) << "    " << PrettyMethod(m) << " line " << record->stack[stack_frame].LineNumber();
+    const AllocRecordStackTrace& stack =
+        alloc_record_stack_traces_->Get(record->stack_trace_index);
+    for (const AllocRecordFrame& frame : stack) {
+      LOG(INFO) << "    " << PrettyMethod(frame.method_idx, *frame.dex_file) << " line "
+                << frame.line_number;
     }
 
     // pause periodically to help logcat catch up
@@ -4221,9 +4432,33 @@ void Dbg::DumpRecentAllocations() {
   }
 }
 
+struct UpdateAllocRecordBufferArgs {
+  IsMarkedCallback* callback;
+  void* arg;
+};
+
+void Dbg::UpdateAllocRecordBufferCallback(Thread* thread, void* arg) {
+  AllocRecordBuffer* buffer = thread->GetAllocRecordBuffer();
+  if (buffer != nullptr) {
+    UpdateAllocRecordBufferArgs* args = reinterpret_cast<UpdateAllocRecordBufferArgs*>(arg);
+    for (size_t i = 0; i < buffer->count; ++i) {
+      buffer->records[i].UpdateObjectPointers(args->callback, args->arg);
+    }
+  }
+}
+
 void Dbg::UpdateObjectPointers(IsMarkedCallback* callback, void* arg) {
   if (recent_allocation_records_ != nullptr) {
-    MutexLock mu(Thread::Current(), *alloc_tracker_lock_);
+    Thread* self = Thread::Current();
+    // The buffers of the threads can only be updated while they are suspended. The collectors
+    // which move objects sweep the system weaks with the threads suspended, and the classes and
+    // methods are not unloaded.
+    if (Locks::mutator_lock_->IsExclusiveHeld(self)) {
+      UpdateAllocRecordBufferArgs args = { callback, arg };
+      MutexLock mu(self, *Locks::thread_list_lock_);
+      Runtime::Current()->GetThreadList()->ForEach(UpdateAllocRecordBufferCallback, &args);
+    }
+    MutexLock mu(self, *alloc_tracker_lock_);
     size_t i = HeadIndex();
     size_t count = alloc_record_count_;
     while (count--) {
@@ -4233,21 +4468,6 @@ void Dbg::UpdateObjectPointers(IsMarkedCallback* callback, void* arg) {
       i = (i + 1) & (alloc_record_max_ - 1);
     }
   }
-  if (gRegistry != nullptr) {
-    gRegistry->UpdateObjectPointers(callback, arg);
-  }
-}
-
-void Dbg::AllowNewObjectRegistryObjects() {
-  if (gRegistry != nullptr) {
-    gRegistry->AllowNewObjects();
-  }
-}
-
-void Dbg::DisallowNewObjectRegistryObjects() {
-  if (gRegistry != nullptr) {
-    gRegistry->DisallowNewObjects();
-  }
 }
 
 class StringTable {
@@ -4286,13 +4506,6 @@ class StringTable {
   DISALLOW_COPY_AND_ASSIGN(StringTable);
 };
 
-static const char* GetMethodSourceFile(MethodHelper* mh)
-    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-  DCHECK(mh != nullptr);
-  const char* source_file = mh->GetDeclaringClassSourceFile();
-  return (source_file != nullptr) ? source_file : "";
-}
-
 /*
  * The data we send to DDMS contains everything we have recorded.
  *
@@ -4341,6 +4554,7 @@ jbyteArray Dbg::GetRecentAllocations() {
   }
 
   Thread* self = Thread::Current();
+  MergeAllThreadAllocRecords(self);
   std::vector<uint8_t> bytes;
   {
     MutexLock mu(self, *alloc_tracker_lock_);
@@ -4358,15 +4572,11 @@ jbyteArray Dbg::GetRecentAllocations() {
 
       class_names.Add(record->type->GetDescriptor().c_str());
 
-      MethodHelper mh;
-      for (size_t i = 0; i < kMaxAllocRecordStackDepth; i++) {
-        mirror::ArtMethod* m = record->stack[i].method;
-        if (m != NULL) {
-          mh.ChangeMethod(m);
-          class_names.Add(mh.GetDeclaringClassDescriptor());
-          method_names.Add(mh.GetName());
-          filenames.Add(GetMethodSourceFile(&mh));
-        }
+      for (const AllocRecordFrame& frame :
+           alloc_record_stack_traces_->Get(record->stack_trace_index)) {
+        class_names.Add(frame.class_descriptor);
+        method_names.Add(frame.method_name);
+        filenames.Add(frame.source_file);
       }
 
       idx = (idx + 1) & (alloc_record_max_ - 1);
@@ -4409,7 +4619,9 @@ jbyteArray Dbg::GetRecentAllocations() {
       // (2b) allocated object's class name index
       // (1b) stack depth
       AllocRecord* record = &recent_allocation_records_[idx];
-      size_t stack_depth = record->GetDepth();
+      const AllocRecordStackTrace& stack =
+          alloc_record_stack_traces_->Get(record->stack_trace_index);
+      size_t stack_depth = stack.size();
       size_t allocated_object_class_name_index =
           class_names.IndexOf(record->type->GetDescriptor().c_str());
       JDWP::Append4BE(bytes, record->byte_count);
@@ -4417,21 +4629,19 @@ jbyteArray Dbg::GetRecentAllocations() {
       JDWP::Append2BE(bytes, allocated_object_class_name_index);
       JDWP::Append1BE(bytes, stack_depth);
 
-      MethodHelper mh;
-      for (size_t stack_frame = 0; stack_frame < stack_depth; ++stack_frame) {
+      for (const AllocRecordFrame& frame : stack) {
         // For each stack frame:
         // (2b) method's class name
         // (2b) method name
         // (2b) method source file
         // (2b) line number, clipped to 32767; -2 if native; -1 if no source
-        mh.ChangeMethod(record->stack[stack_frame].method);
-        size_t class_name_index = class_names.IndexOf(mh.GetDeclaringClassDescriptor());
-        size_t method_name_index = method_names.IndexOf(mh.GetName());
-        size_t file_name_index = filenames.IndexOf(GetMethodSourceFile(&mh));
+        size_t class_name_index = class_names.IndexOf(frame.class_descriptor);
+        size_t method_name_index = method_names.IndexOf(frame.method_name);
+        size_t file_name_index = filenames.IndexOf(frame.source_file);
         JDWP::Append2BE(bytes, class_name_index);
         JDWP::Append2BE(bytes, method_name_index);
         JDWP::Append2BE(bytes, file_name_index);
-        JDWP::Append2BE(bytes, record->stack[stack_frame].LineNumber());
+        JDWP::Append2BE(bytes, frame.line_number);
       }
 
       idx = (idx + 1) & (alloc_record_max_ - 1);
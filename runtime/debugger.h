@@ -42,6 +42,8 @@ class Object;
 class Throwable;
 }  // namespace mirror
 struct AllocRecord;
+struct AllocRecordBuffer;
+class AllocRecordStackTraces;
 class Thread;
 class ThrowLocation;
 
@@ -517,19 +519,30 @@ class Dbg {
 
   /*
    * Recent allocation tracking support.
+   *
+   * Each thread records its allocations in its own buffer without taking a lock, and merges them
+   * into the shared records once the buffer is full. The records are read with the other threads
+   * suspended, after merging their buffers.
    */
   static void RecordAllocation(mirror::Class* type, size_t byte_count)
       LOCKS_EXCLUDED(alloc_tracker_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-  static void SetAllocTrackingEnabled(bool enabled) LOCKS_EXCLUDED(alloc_tracker_lock_);
+  static void SetAllocTrackingEnabled(bool enabled)
+      LOCKS_EXCLUDED(Locks::mutator_lock_, Locks::thread_list_lock_, alloc_tracker_lock_);
   static bool IsAllocTrackingEnabled() {
     return recent_allocation_records_ != nullptr;
   }
   static jbyteArray GetRecentAllocations()
-      LOCKS_EXCLUDED(alloc_tracker_lock_)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_, alloc_tracker_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   static size_t HeadIndex() EXCLUSIVE_LOCKS_REQUIRED(alloc_tracker_lock_);
-  static void DumpRecentAllocations() LOCKS_EXCLUDED(alloc_tracker_lock_);
+  static void DumpRecentAllocations()
+      LOCKS_EXCLUDED(Locks::mutator_lock_, Locks::thread_list_lock_, alloc_tracker_lock_);
+
+  // Merges the allocations recorded by an exiting thread and frees its buffer.
+  static void FlushThreadAllocRecords(Thread* self)
+      LOCKS_EXCLUDED(alloc_tracker_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // Updates the stored direct object pointers (called from SweepSystemWeaks).
   static void UpdateObjectPointers(IsMarkedCallback* callback, void* arg)
@@ -560,9 +573,6 @@ class Dbg {
   static void DdmSendHeapSegments(bool native)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  static void AllowNewObjectRegistryObjects() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-  static void DisallowNewObjectRegistryObjects() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-
  private:
   static void DdmBroadcast(bool connect) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   static void PostThreadStartOrStop(Thread*, uint32_t)
@@ -583,12 +593,32 @@ class Dbg {
       EXCLUSIVE_LOCKS_REQUIRED(deoptimization_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Appends the allocations recorded in the thread's buffer to the shared records.
+  static void MergeAllocRecords(Thread* thread, AllocRecordBuffer* buffer)
+      EXCLUSIVE_LOCKS_REQUIRED(alloc_tracker_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Suspends the other threads to merge the allocations recorded in their buffers.
+  static void MergeAllThreadAllocRecords(Thread* self)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_, alloc_tracker_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // ThreadList::ForEach callbacks.
+  static void MergeAllocRecordsCallback(Thread* thread, void* arg)
+      NO_THREAD_SAFETY_ANALYSIS;
+  static void DeleteAllocRecordBufferCallback(Thread* thread, void* arg);
+  static void UpdateAllocRecordBufferCallback(Thread* thread, void* arg)
+      NO_THREAD_SAFETY_ANALYSIS;
+
   static Mutex* alloc_tracker_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
 
   static AllocRecord* recent_allocation_records_ PT_GUARDED_BY(alloc_tracker_lock_);
   static size_t alloc_record_max_ GUARDED_BY(alloc_tracker_lock_);
   static size_t alloc_record_head_ GUARDED_BY(alloc_tracker_lock_);
   static size_t alloc_record_count_ GUARDED_BY(alloc_tracker_lock_);
+  // The distinct stack traces of the records, which refer to them by index.
+  static AllocRecordStackTraces* alloc_record_stack_traces_ PT_GUARDED_BY(alloc_tracker_lock_);
+  // A thread records one of every alloc_record_sampling_interval_ of its allocations. Only set
+  // while no thread records allocations.
+  static size_t alloc_record_sampling_interval_;
 
   // Guards deoptimization requests.
   // TODO rename to instrumentation_update_lock.
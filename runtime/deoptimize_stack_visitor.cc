@@ -20,6 +20,7 @@
 #include "object_utils.h"
 #include "quick_exception_handler.h"
 #include "handle_scope-inl.h"
+#include "stack_map.h"
 #include "verifier/method_verifier.h"
 
 namespace art {
@@ -47,9 +48,18 @@ bool DeoptimizeStackVisitor::HandleDeoptimization(mirror::ArtMethod* m) {
   CHECK(code_item != nullptr);
   uint16_t num_regs = code_item->registers_size_;
   uint32_t dex_pc = GetDexPc();
-  const Instruction* inst = Instruction::At(code_item->insns_ + dex_pc);
-  uint32_t new_dex_pc = dex_pc + inst->SizeInCodeUnits();
+  uint32_t new_dex_pc = dex_pc;
+  if (!reexecute_top_frame_ || prev_shadow_frame_ != nullptr) {
+    const Instruction* inst = Instruction::At(code_item->insns_ + dex_pc);
+    new_dex_pc = dex_pc + inst->SizeInCodeUnits();
+  }
   ShadowFrame* new_frame = ShadowFrame::Create(num_regs, nullptr, m, new_dex_pc);
+  const void* code_pointer = IsShadowFrame() ? nullptr : m->GetQuickOatCodePointer();
+  if (code_pointer != nullptr && m->HasStackMaps(code_pointer)) {
+    CopyVRegsFromStackMap(m, code_pointer, num_regs, new_frame);
+    LinkShadowFrame(new_frame);
+    return true;
+  }
   StackHandleScope<2> hs(self_);
   Handle<mirror::DexCache> dex_cache(hs.NewHandle(mh.GetDexCache()));
   Handle<mirror::ClassLoader> class_loader(hs.NewHandle(mh.GetClassLoader()));
@@ -76,13 +86,57 @@ bool DeoptimizeStackVisitor::HandleDeoptimization(mirror::ArtMethod* m) {
         break;
     }
   }
+  LinkShadowFrame(new_frame);
+  return true;
+}
+
+void DeoptimizeStackVisitor::CopyVRegsFromStackMap(mirror::ArtMethod* m, const void* code_pointer,
+                                                   uint16_t num_regs, ShadowFrame* new_frame) {
+  CodeInfo code_info = m->GetCodeInfo(code_pointer);
+  StackMap stack_map;
+  bool found = code_info.FindStackMapForNativePcOffset(GetNativePcOffset(), &stack_map);
+  CHECK(found) << "No stack map at " << std::hex << GetCurrentQuickFramePc() << " in "
+               << PrettyMethod(m);
+  DexRegisterMap dex_register_map = code_info.GetDexRegisterMapOf(stack_map);
+  byte* quick_frame = reinterpret_cast<byte*>(GetCurrentQuickFrame());
+  for (uint16_t reg = 0; reg < num_regs; ++reg) {
+    int32_t location;
+    bool is_reference = false;
+    uint32_t value = 0;
+    switch (dex_register_map.GetLocation(reg, &location)) {
+      case DexRegisterMap::kNone:
+        value = 0xEBADDE09;
+        break;
+      case DexRegisterMap::kConstant:
+        value = location;
+        break;
+      case DexRegisterMap::kInStack: {
+        size_t slot = location / kVRegSize;
+        is_reference = slot < stack_map.GetNumberOfStackSlots()
+            && stack_map.IsStackSlotReference(slot);
+        value = *reinterpret_cast<uint32_t*>(quick_frame + location);
+        break;
+      }
+      case DexRegisterMap::kInRegister:
+        is_reference = ((stack_map.GetRegisterMask() >> location) & 1) != 0;
+        value = GetGPR(location);
+        break;
+    }
+    if (is_reference) {
+      new_frame->SetVRegReference(reg, reinterpret_cast<mirror::Object*>(value));
+    } else {
+      new_frame->SetVReg(reg, value);
+    }
+  }
+}
+
+void DeoptimizeStackVisitor::LinkShadowFrame(ShadowFrame* new_frame) {
   if (prev_shadow_frame_ != nullptr) {
     prev_shadow_frame_->SetLink(new_frame);
   } else {
     self_->SetDeoptimizationShadowFrame(new_frame);
   }
   prev_shadow_frame_ = new_frame;
-  return true;
 }
 
 }  // namespace art
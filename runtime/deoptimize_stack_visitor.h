@@ -29,13 +29,15 @@ class ArtMethod;
 class QuickExceptionHandler;
 class Thread;
 
-// Prepares deoptimization.
+// Prepares deoptimization. The frames resume after the dex instruction they are at, which is an
+// invoke, except for the top frame of a guard failing in compiled code, which resumes at it.
 class DeoptimizeStackVisitor FINAL : public StackVisitor {
  public:
-  DeoptimizeStackVisitor(Thread* self, Context* context, QuickExceptionHandler* exception_handler)
+  DeoptimizeStackVisitor(Thread* self, Context* context, QuickExceptionHandler* exception_handler,
+                         bool reexecute_top_frame)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
       : StackVisitor(self, context), self_(self), exception_handler_(exception_handler),
-        prev_shadow_frame_(nullptr) {
+        prev_shadow_frame_(nullptr), reexecute_top_frame_(reexecute_top_frame) {
     CHECK(!self_->HasDeoptimizationShadowFrame());
   }
 
@@ -43,10 +45,16 @@ class DeoptimizeStackVisitor FINAL : public StackVisitor {
 
  private:
   bool HandleDeoptimization(mirror::ArtMethod* m) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Reads the dex registers of a frame compiled with stack maps, without running the verifier.
+  void CopyVRegsFromStackMap(mirror::ArtMethod* m, const void* code_pointer, uint16_t num_regs,
+                             ShadowFrame* new_frame)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void LinkShadowFrame(ShadowFrame* new_frame);
 
   Thread* const self_;
   QuickExceptionHandler* const exception_handler_;
   ShadowFrame* prev_shadow_frame_;
+  const bool reexecute_top_frame_;
 
   DISALLOW_COPY_AND_ASSIGN(DeoptimizeStackVisitor);
 };
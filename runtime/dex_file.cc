@@ -23,9 +23,11 @@
 #include <string.h>
 #include <sys/file.h>
 #include <sys/stat.h>
+#include <algorithm>
 #include <memory>
 
 #include "base/logging.h"
+#include "base/mutex.h"
 #include "base/stringprintf.h"
 #include "class_linker.h"
 #include "dex_file-inl.h"
@@ -39,7 +41,9 @@
 #include "safe_map.h"
 #include "ScopedFd.h"
 #include "handle_scope-inl.h"
+#include "resolved_field_cache.h"
 #include "thread.h"
+#include "type_lookup_table.h"
 #include "utf-inl.h"
 #include "utils.h"
 #include "well_known_classes.h"
@@ -52,9 +56,10 @@ const byte DexFile::kDexMagicVersion[] = { '0', '3', '5', '\0' };
 
 DexFile::ClassPathEntry DexFile::FindInClassPath(const char* descriptor,
                                                  const ClassPath& class_path) {
+  const uint32_t hash = ComputeModifiedUtf8Hash(descriptor);
   for (size_t i = 0; i != class_path.size(); ++i) {
     const DexFile* dex_file = class_path[i];
-    const DexFile::ClassDef* dex_class_def = dex_file->FindClassDef(descriptor);
+    const DexFile::ClassDef* dex_class_def = dex_file->FindClassDef(descriptor, hash);
     if (dex_class_def != NULL) {
       return ClassPathEntry(dex_file, dex_class_def);
     }
@@ -84,14 +89,64 @@ static int OpenAndReadMagic(const char* filename, uint32_t* magic, std::string*
   return fd.release();
 }
 
+// A checksum found by GetChecksum, valid as long as the file is the same.
+struct CachedChecksum {
+  dev_t dev;
+  ino_t ino;
+  off_t size;
+  time_t mtime;
+  uint32_t checksum;
+};
+
+static Mutex checksum_cache_lock("dex file checksum cache lock");
+static SafeMap<std::string, CachedChecksum>* checksum_cache GUARDED_BY(checksum_cache_lock) =
+    nullptr;
+
+static bool FindCachedChecksum(const char* filename, const struct stat& file_stat,
+                               uint32_t* checksum) {
+  MutexLock mu(Thread::Current(), checksum_cache_lock);
+  if (checksum_cache == nullptr) {
+    return false;
+  }
+  auto it = checksum_cache->find(filename);
+  if (it == checksum_cache->end()) {
+    return false;
+  }
+  const CachedChecksum& cached = it->second;
+  if (cached.dev != file_stat.st_dev || cached.ino != file_stat.st_ino ||
+      cached.size != file_stat.st_size || cached.mtime != file_stat.st_mtime) {
+    return false;
+  }
+  *checksum = cached.checksum;
+  return true;
+}
+
+static void CacheChecksum(const char* filename, const struct stat& file_stat, uint32_t checksum) {
+  MutexLock mu(Thread::Current(), checksum_cache_lock);
+  if (checksum_cache == nullptr) {
+    checksum_cache = new SafeMap<std::string, CachedChecksum>;
+  }
+  CachedChecksum cached = { file_stat.st_dev, file_stat.st_ino, file_stat.st_size,
+                            file_stat.st_mtime, checksum };
+  checksum_cache->Overwrite(filename, cached);
+}
+
 bool DexFile::GetChecksum(const char* filename, uint32_t* checksum, std::string* error_msg) {
   CHECK(checksum != NULL);
+  // Avoid opening the file, and parsing the central directory of a zip file, when it didn't
+  // change since the last time.
+  struct stat file_stat;
+  if (stat(filename, &file_stat) == 0 && FindCachedChecksum(filename, file_stat, checksum)) {
+    return true;
+  }
   uint32_t magic;
   ScopedFd fd(OpenAndReadMagic(filename, &magic, error_msg));
   if (fd.get() == -1) {
     DCHECK(!error_msg->empty());
     return false;
   }
+  // The checksum is cached for the file it is read from.
+  const bool can_cache = (fstat(fd.get(), &file_stat) == 0);
   if (IsZipMagic(magic)) {
     std::unique_ptr<ZipArchive> zip_archive(ZipArchive::OpenFromFd(fd.release(), filename, error_msg));
     if (zip_archive.get() == NULL) {
@@ -105,6 +160,9 @@ bool DexFile::GetChecksum(const char* filename, uint32_t* checksum, std::string*
       return false;
     }
     *checksum = zip_entry->GetCrc32();
+    if (can_cache) {
+      CacheChecksum(filename, file_stat, *checksum);
+    }
     return true;
   }
   if (IsDexMagic(magic)) {
@@ -113,6 +171,9 @@ bool DexFile::GetChecksum(const char* filename, uint32_t* checksum, std::string*
       return false;
     }
     *checksum = dex_file->GetHeader().checksum_;
+    if (can_cache) {
+      CacheChecksum(filename, file_stat, *checksum);
+    }
     return true;
   }
   *error_msg = StringPrintf("Expected valid zip or dex file: '%s'", filename);
@@ -245,11 +306,23 @@ const DexFile* DexFile::Open(const ZipArchive& zip_archive, const std::string& l
   if (zip_entry.get() == NULL) {
     return nullptr;
   }
-  std::unique_ptr<MemMap> map(zip_entry->ExtractToMemMap(kClassesDex, error_msg));
-  if (map.get() == NULL) {
-    *error_msg = StringPrintf("Failed to extract '%s' from '%s': %s", kClassesDex, location.c_str(),
-                              error_msg->c_str());
-    return nullptr;
+  std::unique_ptr<MemMap> map;
+  if (zip_entry->IsUncompressed() && zip_entry->IsAlignedTo(alignof(Header))) {
+    // A stored dex file is used in place, which saves a copy and the memory it would take.
+    map.reset(zip_entry->MapDirectlyFromFile(kClassesDex, error_msg));
+    if (map.get() == nullptr) {
+      LOG(WARNING) << "Falling back to extracting '" << kClassesDex << "' from '" << location
+                   << "': " << *error_msg;
+      error_msg->clear();
+    }
+  }
+  if (map.get() == nullptr) {
+    map.reset(zip_entry->ExtractToMemMap(kClassesDex, error_msg));
+    if (map.get() == nullptr) {
+      *error_msg = StringPrintf("Failed to extract '%s' from '%s': %s", kClassesDex,
+                                location.c_str(), error_msg->c_str());
+      return nullptr;
+    }
   }
   std::unique_ptr<const DexFile> dex_file(OpenMemory(location, zip_entry->GetCrc32(), map.release(),
                                                error_msg));
@@ -262,7 +335,8 @@ const DexFile* DexFile::Open(const ZipArchive& zip_archive, const std::string& l
                                location.c_str(), error_msg)) {
     return nullptr;
   }
-  if (!dex_file->DisableWrite()) {
+  // A dex file mapped from the zip file is read only already.
+  if (!dex_file->IsReadOnly() && !dex_file->DisableWrite()) {
     *error_msg = StringPrintf("Failed to make dex file '%s' read only", location.c_str());
     return nullptr;
   }
@@ -284,6 +358,22 @@ const DexFile* DexFile::OpenMemory(const byte* base,
   }
 }
 
+const DexFile* DexFile::Open(const uint8_t* base, size_t size,
+                             const std::string& location,
+                             uint32_t location_checksum,
+                             const uint8_t* lookup_table_data,
+                             std::string* error_msg) {
+  CHECK_ALIGNED(base, 4);  // various dex file structures must be word aligned
+  std::unique_ptr<DexFile> dex_file(new DexFile(base, size, location, location_checksum, NULL));
+  if (!dex_file->Init(error_msg)) {
+    return nullptr;
+  }
+  if (lookup_table_data != nullptr) {
+    dex_file->lookup_table_.reset(TypeLookupTable::Open(*dex_file, lookup_table_data));
+  }
+  return dex_file.release();
+}
+
 DexFile::DexFile(const byte* base, size_t size,
                  const std::string& location,
                  uint32_t location_checksum,
@@ -299,7 +389,10 @@ DexFile::DexFile(const byte* base, size_t size,
       field_ids_(reinterpret_cast<const FieldId*>(base + header_->field_ids_off_)),
       method_ids_(reinterpret_cast<const MethodId*>(base + header_->method_ids_off_)),
       proto_ids_(reinterpret_cast<const ProtoId*>(base + header_->proto_ids_off_)),
-      class_defs_(reinterpret_cast<const ClassDef*>(base + header_->class_defs_off_)) {
+      class_defs_(reinterpret_cast<const ClassDef*>(base + header_->class_defs_off_)),
+      string_lookups_(0),
+      string_index_(0),
+      line_tables_lock_("DexFile line tables lock") {
   CHECK(begin_ != NULL) << GetLocation();
   CHECK_GT(size_, 0U) << GetLocation();
 }
@@ -309,6 +402,12 @@ DexFile::~DexFile() {
   // that's only called after DetachCurrentThread, which means there's no JNIEnv. We could
   // re-attach, but cleaning up these global references is not obviously useful. It's not as if
   // the global reference table is otherwise empty!
+  delete reinterpret_cast<StringIndex*>(string_index_.Load());
+}
+
+void DexFile::SetResolvedFieldCache(ResolvedFieldCache* resolved_field_cache) const {
+  CHECK(resolved_field_cache_.get() == nullptr) << GetLocation();
+  resolved_field_cache_.reset(resolved_field_cache);
 }
 
 bool DexFile::Init(std::string* error_msg) {
@@ -358,6 +457,14 @@ uint32_t DexFile::GetVersion() const {
 }
 
 const DexFile::ClassDef* DexFile::FindClassDef(const char* descriptor) const {
+  return FindClassDef(descriptor, ComputeModifiedUtf8Hash(descriptor));
+}
+
+const DexFile::ClassDef* DexFile::FindClassDef(const char* descriptor, uint32_t hash) const {
+  if (lookup_table_.get() != nullptr) {
+    uint32_t class_def_idx = lookup_table_->Lookup(descriptor, hash);
+    return (class_def_idx != DexFile::kDexNoIndex) ? &GetClassDef(class_def_idx) : nullptr;
+  }
   size_t num_class_defs = NumClassDefs();
   if (num_class_defs == 0) {
     return NULL;
@@ -461,7 +568,65 @@ const DexFile::MethodId* DexFile::FindMethodId(const DexFile::TypeId& declaring_
   return NULL;
 }
 
+class DexFile::StringIndex {
+ public:
+  explicit StringIndex(const DexFile& dex_file) : dex_file_(dex_file) {
+    uint32_t num_string_ids = dex_file.NumStringIds();
+    // Keep the load factor at most 2/3 so that probe sequences stay short.
+    uint32_t capacity = RoundUpToPowerOfTwo(std::max(num_string_ids + num_string_ids / 2, 1U));
+    mask_ = capacity - 1;
+    entries_.reset(new uint32_t[capacity]);
+    std::fill_n(entries_.get(), capacity, DexFile::kDexNoIndex);
+    for (uint32_t i = 0; i < num_string_ids; ++i) {
+      uint32_t pos = ComputeModifiedUtf8Hash(dex_file.StringDataByIdx(i)) & mask_;
+      while (entries_[pos] != DexFile::kDexNoIndex) {
+        pos = (pos + 1) & mask_;
+      }
+      entries_[pos] = i;
+    }
+  }
+
+  const StringId* Find(const char* string) const {
+    uint32_t pos = ComputeModifiedUtf8Hash(string) & mask_;
+    while (true) {
+      uint32_t string_idx = entries_[pos];
+      if (string_idx == DexFile::kDexNoIndex) {
+        return nullptr;
+      }
+      // Modified utf8 has one encoding per string, equal strings have equal bytes.
+      const StringId& string_id = dex_file_.GetStringId(string_idx);
+      if (strcmp(dex_file_.GetStringData(string_id), string) == 0) {
+        return &string_id;
+      }
+      pos = (pos + 1) & mask_;
+    }
+  }
+
+ private:
+  const DexFile& dex_file_;
+  uint32_t mask_;
+  std::unique_ptr<uint32_t[]> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(StringIndex);
+};
+
 const DexFile::StringId* DexFile::FindStringId(const char* string) const {
+  const StringIndex* index = reinterpret_cast<const StringIndex*>(string_index_.Load());
+  if (LIKELY(index != nullptr)) {
+    return index->Find(string);
+  }
+  // Only one lookup sees the count reach the threshold, it builds and publishes the index while
+  // the others keep searching.
+  if (string_lookups_.FetchAndAdd(1) + 1 != kStringIndexMinLookups) {
+    return FindStringIdBinarySearch(string);
+  }
+  StringIndex* new_index = new StringIndex(*this);
+  QuasiAtomic::MembarStoreStore();
+  string_index_ = reinterpret_cast<uintptr_t>(new_index);
+  return new_index->Find(string);
+}
+
+const DexFile::StringId* DexFile::FindStringIdBinarySearch(const char* string) const {
   int32_t lo = 0;
   int32_t hi = NumStringIds() - 1;
   while (hi >= lo) {
@@ -630,11 +795,38 @@ int32_t DexFile::GetLineNumFromPC(mirror::ArtMethod* method, uint32_t rel_pc) co
   const CodeItem* code_item = GetCodeItem(method->GetCodeItemOffset());
   DCHECK(code_item != NULL) << PrettyMethod(method) << " " << GetLocation();
 
+  const LineTable& line_table =
+      GetLineTable(code_item, method->IsStatic(), method->GetDexMethodIndex());
+  // Like LineNumForPcCb, the first entry at rel_pc, else the last one before it.
+  auto it = std::lower_bound(line_table.begin(), line_table.end(), rel_pc,
+                             [](const LinePosition& entry, uint32_t address) {
+                               return entry.address_ < address;
+                             });
+  if (it != line_table.end() && it->address_ == rel_pc) {
+    return static_cast<int32_t>(it->line_num_);
+  }
   // A method with no line number info should return -1
-  LineNumFromPcContext context(rel_pc, -1);
-  DecodeDebugInfo(code_item, method->IsStatic(), method->GetDexMethodIndex(), LineNumForPcCb,
-                  NULL, &context);
-  return context.line_num_;
+  return (it != line_table.begin()) ? static_cast<int32_t>((it - 1)->line_num_) : -1;
+}
+
+const DexFile::LineTable& DexFile::GetLineTable(const CodeItem* code_item, bool is_static,
+                                                uint32_t method_idx) const {
+  uint32_t code_item_offset = reinterpret_cast<const byte*>(code_item) - begin_;
+  Thread* self = Thread::Current();
+  {
+    MutexLock mu(self, line_tables_lock_);
+    auto it = line_tables_.find(code_item_offset);
+    if (it != line_tables_.end()) {
+      return it->second;
+    }
+  }
+  // Decode without holding the lock. If another thread decoded the same table meanwhile, its
+  // table is kept.
+  LineTable line_table;
+  DecodeDebugInfo(code_item, is_static, method_idx, AddLinePositionCb, NULL, &line_table);
+  line_table.shrink_to_fit();
+  MutexLock mu(self, line_tables_lock_);
+  return line_tables_.emplace(code_item_offset, std::move(line_table)).first->second;
 }
 
 int32_t DexFile::FindTryItem(const CodeItem &code_item, uint32_t address) {
@@ -661,6 +853,38 @@ int32_t DexFile::FindTryItem(const CodeItem &code_item, uint32_t address) {
   return -1;
 }
 
+bool DexFile::IsMethodAnnotatedWith(const ClassDef& class_def, uint32_t method_idx,
+                                    const char* descriptor) const {
+  if (class_def.annotations_off_ == 0) {
+    return false;
+  }
+  const AnnotationsDirectoryItem* directory =
+      reinterpret_cast<const AnnotationsDirectoryItem*>(begin_ + class_def.annotations_off_);
+  const FieldAnnotationsItem* fields =
+      reinterpret_cast<const FieldAnnotationsItem*>(directory + 1);
+  const MethodAnnotationsItem* methods =
+      reinterpret_cast<const MethodAnnotationsItem*>(fields + directory->fields_size_);
+  // The methods are sorted by index.
+  for (uint32_t i = 0; i < directory->methods_size_ && methods[i].method_idx_ <= method_idx; ++i) {
+    if (methods[i].method_idx_ != method_idx) {
+      continue;
+    }
+    const AnnotationSetItem* set =
+        reinterpret_cast<const AnnotationSetItem*>(begin_ + methods[i].annotations_off_);
+    for (uint32_t j = 0; j < set->size_; ++j) {
+      const AnnotationItem* item =
+          reinterpret_cast<const AnnotationItem*>(begin_ + set->entries_[j]);
+      // The encoded annotation starts with the type index.
+      const byte* ptr = item->annotation_;
+      if (strcmp(StringByTypeIdx(DecodeUnsignedLeb128(&ptr)), descriptor) == 0) {
+        return true;
+      }
+    }
+    break;
+  }
+  return false;
+}
+
 int32_t DexFile::FindCatchHandlerOffset(const CodeItem &code_item, uint32_t address) {
   int32_t try_item = FindTryItem(code_item, address);
   if (try_item == -1) {
@@ -849,6 +1073,12 @@ void DexFile::DecodeDebugInfo(const CodeItem* code_item, bool is_static, uint32_
   }
 }
 
+bool DexFile::AddLinePositionCb(void* context, uint32_t address, uint32_t line_num) {
+  LinePosition position = { address, line_num };
+  reinterpret_cast<LineTable*>(context)->push_back(position);
+  return false;
+}
+
 bool DexFile::LineNumForPcCb(void* raw_context, uint32_t address, uint32_t line_num) {
   LineNumFromPcContext* context = reinterpret_cast<LineNumFromPcContext*>(raw_context);
 
@@ -925,15 +1155,19 @@ std::ostream& operator<<(std::ostream& os, const Signature& sig) {
 // Decodes the header section from the class data bytes.
 void ClassDataItemIterator::ReadClassDataHeader() {
   CHECK(ptr_pos_ != NULL);
-  header_.static_fields_size_ = DecodeUnsignedLeb128(&ptr_pos_);
-  header_.instance_fields_size_ = DecodeUnsignedLeb128(&ptr_pos_);
-  header_.direct_methods_size_ = DecodeUnsignedLeb128(&ptr_pos_);
-  header_.virtual_methods_size_ = DecodeUnsignedLeb128(&ptr_pos_);
+  uint32_t values[4];
+  ptr_pos_ = DecodeUnsignedLeb128Batch(ptr_pos_, DataEnd(), values, arraysize(values));
+  header_.static_fields_size_ = values[0];
+  header_.instance_fields_size_ = values[1];
+  header_.direct_methods_size_ = values[2];
+  header_.virtual_methods_size_ = values[3];
 }
 
 void ClassDataItemIterator::ReadClassDataField() {
-  field_.field_idx_delta_ = DecodeUnsignedLeb128(&ptr_pos_);
-  field_.access_flags_ = DecodeUnsignedLeb128(&ptr_pos_);
+  uint32_t values[2];
+  ptr_pos_ = DecodeUnsignedLeb128Batch(ptr_pos_, DataEnd(), values, arraysize(values));
+  field_.field_idx_delta_ = values[0];
+  field_.access_flags_ = values[1];
   if (last_idx_ != 0 && field_.field_idx_delta_ == 0) {
     LOG(WARNING) << "Duplicate field " << PrettyField(GetMemberIndex(), dex_file_)
                  << " in " << dex_file_.GetLocation();
@@ -941,9 +1175,11 @@ void ClassDataItemIterator::ReadClassDataField() {
 }
 
 void ClassDataItemIterator::ReadClassDataMethod() {
-  method_.method_idx_delta_ = DecodeUnsignedLeb128(&ptr_pos_);
-  method_.access_flags_ = DecodeUnsignedLeb128(&ptr_pos_);
-  method_.code_off_ = DecodeUnsignedLeb128(&ptr_pos_);
+  uint32_t values[3];
+  ptr_pos_ = DecodeUnsignedLeb128Batch(ptr_pos_, DataEnd(), values, arraysize(values));
+  method_.method_idx_delta_ = values[0];
+  method_.access_flags_ = values[1];
+  method_.code_off_ = values[2];
   if (last_idx_ != 0 && method_.method_idx_delta_ == 0) {
     LOG(WARNING) << "Duplicate method " << PrettyMethod(GetMemberIndex(), dex_file_)
                  << " in " << dex_file_.GetLocation();
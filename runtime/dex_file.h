@@ -19,8 +19,10 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "atomic.h"
 #include "base/logging.h"
 #include "base/mutex.h"  // For Locks::mutator_lock_.
 #include "globals.h"
@@ -41,9 +43,11 @@ namespace mirror {
   class DexCache;
 }  // namespace mirror
 class ClassLinker;
+class ResolvedFieldCache;
 class Signature;
 template<class T> class Handle;
 class StringPiece;
+class TypeLookupTable;
 class ZipArchive;
 
 // TODO: move all of the macro functionality into the DexCache class.
@@ -350,6 +354,8 @@ class DexFile {
   // For .dex files, this is the header checksum.
   // For zip files, this is the classes.dex zip entry CRC32 checksum.
   // Return true if the checksum could be found, false otherwise.
+  // The checksums are cached by file identity, size and modification time, and the cache is
+  // inherited by the processes forked from the zygote.
   static bool GetChecksum(const char* filename, uint32_t* checksum, std::string* error_msg);
 
   // Opens .dex file, guessing the container format based on file extension
@@ -363,6 +369,14 @@ class DexFile {
     return OpenMemory(base, size, location, location_checksum, NULL, error_msg);
   }
 
+  // Opens .dex file, backed by existing memory, with the TypeLookupTable dex2oat built for it at
+  // `lookup_table_data` if not null. The table must outlive the dex file.
+  static const DexFile* Open(const uint8_t* base, size_t size,
+                             const std::string& location,
+                             uint32_t location_checksum,
+                             const uint8_t* lookup_table_data,
+                             std::string* error_msg);
+
   // Opens .dex file from the classes.dex in a zip archive
   static const DexFile* Open(const ZipArchive& zip_archive, const std::string& location,
                              std::string* error_msg);
@@ -439,7 +453,8 @@ class DexFile {
     return StringDataAndUtf16LengthByIdx(idx, &unicode_length);
   }
 
-  // Looks up a string id for a given modified utf8 string.
+  // Looks up a string id for a given modified utf8 string. Once a dex file has been searched
+  // kStringIndexMinLookups times, this uses a hash index of the string ids built on first need.
   const StringId* FindStringId(const char* string) const;
 
   // Looks up a string id for a given utf16 string.
@@ -502,6 +517,15 @@ class DexFile {
     return &field_id - field_ids_;
   }
 
+  // Returns the fields resolved from the field ids, if the DexCache of the dex file doesn't keep
+  // an array of them, or null.
+  ResolvedFieldCache* GetResolvedFieldCache() const {
+    return resolved_field_cache_.get();
+  }
+
+  // Called once, by the ClassLinker, when it registers a compact DexCache for the dex file.
+  void SetResolvedFieldCache(ResolvedFieldCache* resolved_field_cache) const;
+
   // Looks up a field by its declaring class, name and type
   const FieldId* FindFieldId(const DexFile::TypeId& declaring_klass,
                              const DexFile::StringId& name,
@@ -600,6 +624,9 @@ class DexFile {
   // Looks up a class definition by its class descriptor.
   const ClassDef* FindClassDef(const char* descriptor) const;
 
+  // Looks up a class definition by its class descriptor, whose ComputeModifiedUtf8Hash is `hash`.
+  const ClassDef* FindClassDef(const char* descriptor, uint32_t hash) const;
+
   // Looks up a class definition by its type index.
   const ClassDef* FindClassDef(uint16_t type_idx) const;
 
@@ -707,6 +734,11 @@ class DexFile {
   // Find the handler offset associated with the given address (ie dex pc). Returns -1 if none.
   static int32_t FindCatchHandlerOffset(const CodeItem &code_item, uint32_t address);
 
+  // Returns whether the method `method_idx` of `class_def` has an annotation of the type with
+  // `descriptor`, of any visibility.
+  bool IsMethodAnnotatedWith(const ClassDef& class_def, uint32_t method_idx,
+                             const char* descriptor) const;
+
   // Get the pointer to the start of the debugging data
   const byte* GetDebugInfoStream(const CodeItem* code_item) const {
     if (code_item->debug_info_off_ == 0) {
@@ -762,6 +794,20 @@ class DexFile {
     DISALLOW_COPY_AND_ASSIGN(LocalInfo);
   };
 
+  // A position entry of the debug info of a code item.
+  struct LinePosition {
+    uint32_t address_;
+    uint32_t line_num_;
+  };
+  typedef std::vector<LinePosition> LineTable;
+
+  static bool AddLinePositionCb(void* context, uint32_t address, uint32_t line_num);
+
+  // Returns the position entries of the debug info of code_item, in address order, decoded on
+  // the first call for the code item.
+  const LineTable& GetLineTable(const CodeItem* code_item, bool is_static,
+                                uint32_t method_idx) const LOCKS_EXCLUDED(line_tables_lock_);
+
   struct LineNumFromPcContext {
     LineNumFromPcContext(uint32_t address, uint32_t line_num)
         : address_(address), line_num_(line_num) {}
@@ -787,7 +833,8 @@ class DexFile {
   // compiled without "-g", so no line number information is present).
   // Returns -2 for native methods (as expected in exception traces).
   //
-  // This is used by runtime; therefore use art::Method not art::DexFile::Method.
+  // This is used by runtime; therefore use art::Method not art::DexFile::Method. The positions of
+  // the debug info of the method are decoded on the first call, and kept for the next ones.
   int32_t GetLineNumFromPC(mirror::ArtMethod* method, uint32_t rel_pc) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -892,6 +939,26 @@ class DexFile {
 
   // Points to the base of the class definition list.
   const ClassDef* const class_defs_;
+
+  // Maps the class descriptors to the class defs, if the dex file is in an oat file.
+  std::unique_ptr<const TypeLookupTable> lookup_table_;
+
+  // Runtime state rather than part of the dex file, set once.
+  mutable std::unique_ptr<ResolvedFieldCache> resolved_field_cache_;
+
+  // Open addressed hash table of the string ids by the hash of their data, built by the lookup
+  // which reaches kStringIndexMinLookups, so that dex files which are rarely searched don't pay
+  // for it. Stored as a uintptr_t since Atomic has no pointer specialization.
+  class StringIndex;
+  static constexpr uint32_t kStringIndexMinLookups = 64;
+  const StringId* FindStringIdBinarySearch(const char* string) const;
+  mutable Atomic<uint32_t> string_lookups_;
+  mutable Atomic<uintptr_t> string_index_;
+
+  // The line tables of the code items GetLineNumFromPC() was called for, by code item offset.
+  // The entries are never removed, so the references to them stay valid.
+  mutable Mutex line_tables_lock_;
+  mutable std::unordered_map<uint32_t, LineTable> line_tables_ GUARDED_BY(line_tables_lock_);
 };
 std::ostream& operator<<(std::ostream& os, const DexFile& dex_file);
 
@@ -1117,6 +1184,11 @@ class ClassDataItemIterator {
   // Read and decode a method from a class_data_item stream into method
   void ReadClassDataMethod();
 
+  // The end of the dex file, which bounds the decoding of the class_data_item a word at a time.
+  const byte* DataEnd() const {
+    return dex_file_.Begin() + dex_file_.Size();
+  }
+
   const DexFile& dex_file_;
   size_t pos_;  // integral number of items passed
   const byte* ptr_pos_;  // pointer into stream of class_data_item
@@ -199,6 +199,32 @@ TEST_F(DexFileTest, GetChecksum) {
   EXPECT_EQ(java_lang_dex_file_->GetLocationChecksum(), checksum);
 }
 
+TEST_F(DexFileTest, GetChecksumOfReplacedFile) {
+  size_t length;
+  std::unique_ptr<byte[]> dex_bytes(DecodeBase64(kRawDex, &length));
+  ASSERT_TRUE(dex_bytes.get() != nullptr);
+  ScratchFile tmp;
+  ASSERT_TRUE(tmp.GetFile()->WriteFully(dex_bytes.get(), length));
+  uint32_t checksum;
+  std::string error_msg;
+  EXPECT_TRUE(DexFile::GetChecksum(tmp.GetFilename().c_str(), &checksum, &error_msg))
+      << error_msg;
+  EXPECT_EQ(0x00d87910U, checksum);
+  // Found in the cache.
+  EXPECT_TRUE(DexFile::GetChecksum(tmp.GetFilename().c_str(), &checksum, &error_msg))
+      << error_msg;
+  EXPECT_EQ(0x00d87910U, checksum);
+
+  // Replace the file with one whose header has another checksum.
+  reinterpret_cast<DexFile::Header*>(dex_bytes.get())->checksum_ = 0x12345678U;
+  ScratchFile replacement;
+  ASSERT_TRUE(replacement.GetFile()->WriteFully(dex_bytes.get(), length));
+  ASSERT_EQ(0, rename(replacement.GetFilename().c_str(), tmp.GetFilename().c_str()));
+  EXPECT_TRUE(DexFile::GetChecksum(tmp.GetFilename().c_str(), &checksum, &error_msg))
+      << error_msg;
+  EXPECT_EQ(0x12345678U, checksum);
+}
+
 TEST_F(DexFileTest, ClassDefs) {
   ScopedObjectAccess soa(Thread::Current());
   const DexFile* raw(OpenTestDexFile("Nested"));
@@ -278,6 +304,17 @@ TEST_F(DexFileTest, FindStringId) {
   }
 }
 
+TEST_F(DexFileTest, FindStringIdIndexed) {
+  // Enough lookups for the dex file to build its string index, the later ones use it.
+  for (size_t i = 0; i < java_lang_dex_file_->NumStringIds(); i++) {
+    const char* str = java_lang_dex_file_->StringDataByIdx(i);
+    const DexFile::StringId* str_id = java_lang_dex_file_->FindStringId(str);
+    ASSERT_TRUE(str_id != nullptr);
+    EXPECT_EQ(i, java_lang_dex_file_->GetIndexForStringId(*str_id));
+  }
+  EXPECT_TRUE(java_lang_dex_file_->FindStringId("LNoSuchClass;") == nullptr);
+}
+
 TEST_F(DexFileTest, FindTypeId) {
   for (size_t i = 0; i < java_lang_dex_file_->NumTypeIds(); i++) {
     const char* type_str = java_lang_dex_file_->StringByTypeIdx(i);
@@ -16,6 +16,7 @@
 
 #include "dex_file_verifier.h"
 
+#include <unistd.h>
 #include <zlib.h>
 #include <memory>
 
@@ -23,6 +24,8 @@
 #include "dex_file-inl.h"
 #include "leb128.h"
 #include "safe_map.h"
+#include "thread.h"
+#include "thread_pool.h"
 #include "utf-inl.h"
 #include "utils.h"
 
@@ -1217,16 +1220,53 @@ bool DexFileVerifier::CheckIntraDataSection(size_t offset, uint32_t count, uint1
   return true;
 }
 
+bool DexFileVerifier::CheckIntraSectionItems(const DexFile::MapItem& item) {
+  // Sections that do not fit in the file fail the checks in map order before theirs.
+  if (!CheckPointerRange(begin_ + item.offset_, begin_ + item.offset_, "section")) {
+    return false;
+  }
+  ptr_ = begin_ + item.offset_;
+  switch (item.type_) {
+    case DexFile::kDexTypeStringIdItem:
+    case DexFile::kDexTypeTypeIdItem:
+    case DexFile::kDexTypeProtoIdItem:
+    case DexFile::kDexTypeFieldIdItem:
+    case DexFile::kDexTypeMethodIdItem:
+    case DexFile::kDexTypeClassDefItem:
+      return CheckIntraIdSection(item.offset_, item.size_, item.type_);
+    case DexFile::kDexTypeTypeList:
+    case DexFile::kDexTypeAnnotationSetRefList:
+    case DexFile::kDexTypeAnnotationSetItem:
+    case DexFile::kDexTypeClassDataItem:
+    case DexFile::kDexTypeCodeItem:
+    case DexFile::kDexTypeStringDataItem:
+    case DexFile::kDexTypeDebugInfoItem:
+    case DexFile::kDexTypeAnnotationItem:
+    case DexFile::kDexTypeEncodedArrayItem:
+    case DexFile::kDexTypeAnnotationsDirectoryItem:
+      return CheckIntraDataSection(item.offset_, item.size_, item.type_);
+    default:
+      // The header and the map are checked by CheckIntraSection.
+      return true;
+  }
+}
+
 bool DexFileVerifier::CheckIntraSection() {
   const DexFile::MapList* map = reinterpret_cast<const DexFile::MapList*>(begin_ + header_->map_off_);
   const DexFile::MapItem* item = map->list_;
 
   uint32_t count = map->size_;
   size_t offset = 0;
+
+  // Check the items of the sections, then the sections themselves in map order, so that the
+  // first failure in the file is the one reported.
+  std::vector<std::unique_ptr<DexFileVerifier>> sections;
+  std::unique_ptr<bool[]> results;
+  CheckSections(&DexFileVerifier::CheckIntraSectionItems, &sections, &results);
   ptr_ = begin_;
 
   // Check the items listed in the map.
-  while (count--) {
+  for (uint32_t i = 0; i < count; ++i, ++item) {
     uint32_t section_offset = item->offset_;
     uint32_t section_count = item->size_;
     uint16_t type = item->type_;
@@ -1253,17 +1293,6 @@ bool DexFileVerifier::CheckIntraSection() {
         ptr_ = begin_ + header_->header_size_;
         offset = header_->header_size_;
         break;
-      case DexFile::kDexTypeStringIdItem:
-      case DexFile::kDexTypeTypeIdItem:
-      case DexFile::kDexTypeProtoIdItem:
-      case DexFile::kDexTypeFieldIdItem:
-      case DexFile::kDexTypeMethodIdItem:
-      case DexFile::kDexTypeClassDefItem:
-        if (!CheckIntraIdSection(section_offset, section_count, type)) {
-          return false;
-        }
-        offset = ptr_ - begin_;
-        break;
       case DexFile::kDexTypeMapList:
         if (UNLIKELY(section_count != 1)) {
           ErrorStringPrintf("Multiple map list items");
@@ -1277,6 +1306,12 @@ bool DexFileVerifier::CheckIntraSection() {
         ptr_ += sizeof(uint32_t) + (map->size_ * sizeof(DexFile::MapItem));
         offset = section_offset + sizeof(uint32_t) + (map->size_ * sizeof(DexFile::MapItem));
         break;
+      case DexFile::kDexTypeStringIdItem:
+      case DexFile::kDexTypeTypeIdItem:
+      case DexFile::kDexTypeProtoIdItem:
+      case DexFile::kDexTypeFieldIdItem:
+      case DexFile::kDexTypeMethodIdItem:
+      case DexFile::kDexTypeClassDefItem:
       case DexFile::kDexTypeTypeList:
       case DexFile::kDexTypeAnnotationSetRefList:
       case DexFile::kDexTypeAnnotationSetItem:
@@ -1286,26 +1321,31 @@ bool DexFileVerifier::CheckIntraSection() {
       case DexFile::kDexTypeDebugInfoItem:
       case DexFile::kDexTypeAnnotationItem:
       case DexFile::kDexTypeEncodedArrayItem:
-      case DexFile::kDexTypeAnnotationsDirectoryItem:
-        if (!CheckIntraDataSection(section_offset, section_count, type)) {
+      case DexFile::kDexTypeAnnotationsDirectoryItem: {
+        DexFileVerifier* section = sections[i].get();
+        if (!results[i]) {
+          failure_reason_ = section->failure_reason_;
           return false;
         }
+        for (const auto& entry : section->offset_to_type_map_) {
+          offset_to_type_map_.Put(entry.first, entry.second);
+        }
+        ptr_ = section->ptr_;
         offset = ptr_ - begin_;
         break;
+      }
       default:
         ErrorStringPrintf("Unknown map item type %x", type);
         return false;
     }
-
-    item++;
   }
 
   return true;
 }
 
 bool DexFileVerifier::CheckOffsetToTypeMap(size_t offset, uint16_t type) {
-  auto it = offset_to_type_map_.find(offset);
-  if (UNLIKELY(it == offset_to_type_map_.end())) {
+  auto it = data_item_types_->find(offset);
+  if (UNLIKELY(it == data_item_types_->end())) {
     ErrorStringPrintf("No data map entry found @ %zx; expected %x", offset, type);
     return false;
   }
@@ -1877,15 +1917,34 @@ bool DexFileVerifier::CheckInterSectionIterate(size_t offset, uint32_t count, ui
   return true;
 }
 
+bool DexFileVerifier::CheckInterSectionItems(const DexFile::MapItem& item) {
+  switch (item.type_) {
+    case DexFile::kDexTypeStringIdItem:
+    case DexFile::kDexTypeTypeIdItem:
+    case DexFile::kDexTypeProtoIdItem:
+    case DexFile::kDexTypeFieldIdItem:
+    case DexFile::kDexTypeMethodIdItem:
+    case DexFile::kDexTypeClassDefItem:
+    case DexFile::kDexTypeAnnotationSetRefList:
+    case DexFile::kDexTypeAnnotationSetItem:
+    case DexFile::kDexTypeClassDataItem:
+    case DexFile::kDexTypeAnnotationsDirectoryItem:
+      return CheckInterSectionIterate(item.offset_, item.size_, item.type_);
+    default:
+      return true;
+  }
+}
+
 bool DexFileVerifier::CheckInterSection() {
   const DexFile::MapList* map = reinterpret_cast<const DexFile::MapList*>(begin_ + header_->map_off_);
   const DexFile::MapItem* item = map->list_;
   uint32_t count = map->size_;
 
   // Cross check the items listed in the map.
-  while (count--) {
-    uint32_t section_offset = item->offset_;
-    uint32_t section_count = item->size_;
+  std::vector<std::unique_ptr<DexFileVerifier>> sections;
+  std::unique_ptr<bool[]> results;
+  CheckSections(&DexFileVerifier::CheckInterSectionItems, &sections, &results);
+  for (uint32_t i = 0; i < count; ++i, ++item) {
     uint16_t type = item->type_;
 
     switch (type) {
@@ -1908,7 +1967,8 @@ bool DexFileVerifier::CheckInterSection() {
       case DexFile::kDexTypeAnnotationSetItem:
       case DexFile::kDexTypeClassDataItem:
       case DexFile::kDexTypeAnnotationsDirectoryItem: {
-        if (!CheckInterSectionIterate(section_offset, section_count, type)) {
+        if (!results[i]) {
+          failure_reason_ = sections[i]->failure_reason_;
           return false;
         }
         break;
@@ -1917,10 +1977,78 @@ bool DexFileVerifier::CheckInterSection() {
         ErrorStringPrintf("Unknown map item type %x", type);
         return false;
     }
+  }
 
-    item++;
+  return true;
+}
+
+// Runs a section check of the verifier of a single section.
+class DexFileVerifier::SectionTask : public Task {
+ public:
+  SectionTask(DexFileVerifier* verifier, SectionCheck check, const DexFile::MapItem* item,
+              bool* result)
+      : verifier_(verifier), check_(check), item_(item), result_(result) {
+  }
+
+  void Run(Thread* self) OVERRIDE {
+    *result_ = (verifier_->*check_)(*item_);
   }
 
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  DexFileVerifier* const verifier_;
+  const SectionCheck check_;
+  const DexFile::MapItem* const item_;
+  bool* const result_;
+
+  DISALLOW_COPY_AND_ASSIGN(SectionTask);
+};
+
+void DexFileVerifier::CheckSections(SectionCheck check,
+                                    std::vector<std::unique_ptr<DexFileVerifier>>* sections,
+                                    std::unique_ptr<bool[]>* results) {
+  const DexFile::MapList* map =
+      reinterpret_cast<const DexFile::MapList*>(begin_ + header_->map_off_);
+  uint32_t count = map->size_;
+  results->reset(new bool[count]);
+  sections->reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    sections->emplace_back(new DexFileVerifier(this));
+    SectionTask* task =
+        new SectionTask(sections->back().get(), check, &map->list_[i], &(*results)[i]);
+    if (thread_pool_ != nullptr) {
+      thread_pool_->AddTask(Thread::Current(), task);
+    } else {
+      task->Run(Thread::Current());
+      task->Finalize();
+    }
+  }
+  if (thread_pool_ != nullptr) {
+    Thread* self = Thread::Current();
+    thread_pool_->StartWorkers(self);
+    thread_pool_->Wait(self, true, false);
+    thread_pool_->StopWorkers(self);
+  }
+}
+
+// Whether the sections of the dex file can be checked on a thread pool by the current thread. The
+// pool waits for its workers to start, which is only allowed without holding any lock.
+static bool CanVerifyInParallel(size_t size) {
+  if (size < DexFileVerifier::kMinParallelVerificationSize) {
+    return false;
+  }
+  Thread* self = Thread::Current();
+  if (self == nullptr) {
+    return false;
+  }
+  for (int i = 0; i < kLockLevelCount; ++i) {
+    if (self->GetHeldMutex(static_cast<LockLevel>(i)) != nullptr) {
+      return false;
+    }
+  }
   return true;
 }
 
@@ -1935,6 +2063,14 @@ bool DexFileVerifier::Verify() {
     return false;
   }
 
+  // The sections are checked independently, in parallel for large dex files.
+  std::unique_ptr<ThreadPool> thread_pool;
+  int thread_count = sysconf(_SC_NPROCESSORS_CONF);
+  if (thread_count > 1 && CanVerifyInParallel(size_)) {
+    thread_pool.reset(new ThreadPool("Dex file verifier thread pool", thread_count - 1));
+  }
+  thread_pool_ = thread_pool.get();
+
   // Check structure within remaining sections.
   if (!CheckIntraSection()) {
     return false;
@@ -17,13 +17,21 @@
 #ifndef ART_RUNTIME_DEX_FILE_VERIFIER_H_
 #define ART_RUNTIME_DEX_FILE_VERIFIER_H_
 
+#include <memory>
+#include <vector>
+
 #include "dex_file.h"
 #include "safe_map.h"
 
 namespace art {
 
+class ThreadPool;
+
 class DexFileVerifier {
  public:
+  // Dex files from this size on have their sections checked in parallel.
+  static constexpr size_t kMinParallelVerificationSize = 1 * MB;
+
   static bool Verify(const DexFile* dex_file, const byte* begin, size_t size,
                      const char* location, std::string* error_msg);
 
@@ -32,9 +40,22 @@ class DexFileVerifier {
   }
 
  private:
+  class SectionTask;
+  typedef bool (DexFileVerifier::*SectionCheck)(const DexFile::MapItem& item);
+
   DexFileVerifier(const DexFile* dex_file, const byte* begin, size_t size, const char* location)
       : dex_file_(dex_file), begin_(begin), size_(size), location_(location),
-        header_(&dex_file->GetHeader()), ptr_(NULL), previous_item_(NULL)  {
+        header_(&dex_file->GetHeader()), data_item_types_(&offset_to_type_map_),
+        thread_pool_(NULL), ptr_(NULL), previous_item_(NULL)  {
+  }
+
+  // A verifier for a single section of the dex file of `parent`, with its own position and
+  // failure reason. Its inter-section checks look up the data items found by `parent`.
+  explicit DexFileVerifier(const DexFileVerifier* parent)
+      : dex_file_(parent->dex_file_), begin_(parent->begin_), size_(parent->size_),
+        location_(parent->location_), header_(parent->header_),
+        data_item_types_(&parent->offset_to_type_map_), thread_pool_(NULL), ptr_(NULL),
+        previous_item_(NULL) {
   }
 
   bool Verify();
@@ -68,6 +89,7 @@ class DexFileVerifier {
   bool CheckIntraSectionIterate(size_t offset, uint32_t count, uint16_t type);
   bool CheckIntraIdSection(size_t offset, uint32_t count, uint16_t type);
   bool CheckIntraDataSection(size_t offset, uint32_t count, uint16_t type);
+  bool CheckIntraSectionItems(const DexFile::MapItem& item);
   bool CheckIntraSection();
 
   bool CheckOffsetToTypeMap(size_t offset, uint16_t type);
@@ -86,8 +108,14 @@ class DexFileVerifier {
   bool CheckInterAnnotationsDirectoryItem();
 
   bool CheckInterSectionIterate(size_t offset, uint32_t count, uint16_t type);
+  bool CheckInterSectionItems(const DexFile::MapItem& item);
   bool CheckInterSection();
 
+  // Runs `check` for each section of the map, in a verifier of its own, on the thread pool if
+  // there is one. The result of each section is at the section's index of `results`.
+  void CheckSections(SectionCheck check, std::vector<std::unique_ptr<DexFileVerifier>>* sections,
+                     std::unique_ptr<bool[]>* results);
+
   void ErrorStringPrintf(const char* fmt, ...)
       __attribute__((__format__(__printf__, 2, 3))) COLD_ATTR;
 
@@ -98,6 +126,9 @@ class DexFileVerifier {
   const DexFile::Header* const header_;
 
   SafeMap<uint32_t, uint16_t> offset_to_type_map_;
+  // The map of the data items of the whole dex file, looked up by the inter-section checks.
+  const SafeMap<uint32_t, uint16_t>* const data_item_types_;
+  ThreadPool* thread_pool_;
   const byte* ptr_;
   const void* previous_item_;
 
@@ -25,6 +25,117 @@
 
 namespace art {
 
+void Instruction::Decode(Decoded* decoded) const {
+  uint16_t inst_data = Fetch16(0);
+  decoded->opcode = Opcode(inst_data);
+  decoded->vA = 0;
+  decoded->vB = 0;
+  decoded->vB_wide = 0;
+  decoded->vC = 0;
+  switch (FormatOf(decoded->opcode)) {
+    case k10x:
+      decoded->vA = VRegA_10x(inst_data);
+      break;
+    case k12x:
+      decoded->vA = VRegA_12x(inst_data);
+      decoded->vB = VRegB_12x(inst_data);
+      break;
+    case k11n:
+      decoded->vA = VRegA_11n(inst_data);
+      decoded->vB = VRegB_11n(inst_data);
+      break;
+    case k11x:
+      decoded->vA = VRegA_11x(inst_data);
+      break;
+    case k10t:
+      decoded->vA = VRegA_10t(inst_data);
+      break;
+    case k20t:
+      decoded->vA = VRegA_20t();
+      break;
+    case k22x:
+      decoded->vA = VRegA_22x(inst_data);
+      decoded->vB = VRegB_22x();
+      break;
+    case k21t:
+      decoded->vA = VRegA_21t(inst_data);
+      decoded->vB = VRegB_21t();
+      break;
+    case k21s:
+      decoded->vA = VRegA_21s(inst_data);
+      decoded->vB = VRegB_21s();
+      break;
+    case k21h:
+      decoded->vA = VRegA_21h(inst_data);
+      decoded->vB = VRegB_21h();
+      break;
+    case k21c:
+      decoded->vA = VRegA_21c(inst_data);
+      decoded->vB = VRegB_21c();
+      break;
+    case k23x:
+      decoded->vA = VRegA_23x(inst_data);
+      decoded->vB = VRegB_23x();
+      decoded->vC = VRegC_23x();
+      break;
+    case k22b:
+      decoded->vA = VRegA_22b(inst_data);
+      decoded->vB = VRegB_22b();
+      decoded->vC = VRegC_22b();
+      break;
+    case k22t:
+      decoded->vA = VRegA_22t(inst_data);
+      decoded->vB = VRegB_22t(inst_data);
+      decoded->vC = VRegC_22t();
+      break;
+    case k22s:
+      decoded->vA = VRegA_22s(inst_data);
+      decoded->vB = VRegB_22s(inst_data);
+      decoded->vC = VRegC_22s();
+      break;
+    case k22c:
+      decoded->vA = VRegA_22c(inst_data);
+      decoded->vB = VRegB_22c(inst_data);
+      decoded->vC = VRegC_22c();
+      break;
+    case k32x:
+      decoded->vA = VRegA_32x();
+      decoded->vB = VRegB_32x();
+      break;
+    case k30t:
+      decoded->vA = VRegA_30t();
+      break;
+    case k31t:
+      decoded->vA = VRegA_31t(inst_data);
+      decoded->vB = VRegB_31t();
+      break;
+    case k31i:
+      decoded->vA = VRegA_31i(inst_data);
+      decoded->vB = VRegB_31i();
+      break;
+    case k31c:
+      decoded->vA = VRegA_31c(inst_data);
+      decoded->vB = VRegB_31c();
+      break;
+    case k35c:
+      decoded->vA = VRegA_35c(inst_data);
+      decoded->vB = VRegB_35c();
+      decoded->vC = VRegC_35c();
+      GetVarArgs(decoded->arg, inst_data);
+      break;
+    case k3rc:
+      decoded->vA = VRegA_3rc(inst_data);
+      decoded->vB = VRegB_3rc();
+      decoded->vC = VRegC_3rc();
+      break;
+    case k51l:
+      decoded->vA = VRegA_51l(inst_data);
+      decoded->vB_wide = VRegB_51l();
+      decoded->vB = static_cast<uint32_t>(decoded->vB_wide);
+      break;
+  }
+}
+
 const char* const Instruction::kInstructionNames[] = {
 #define INSTRUCTION_NAME(o, c, pname, f, r, i, a, v) pname,
 #include "dex_instruction_list.h"
@@ -373,6 +373,21 @@ class Instruction {
     return GetVarArgs(args, Fetch16(0));
   }
 
+  // The opcode and operands of an instruction. The operands its format doesn't have are 0, and
+  // arg is only filled for k35c.
+  struct Decoded {
+    uint32_t vA;
+    uint32_t vB;
+    uint64_t vB_wide;              // For k51l.
+    uint32_t vC;
+    uint32_t arg[kMaxVarArgRegs];  // vC/D/E/F/G in invoke or filled-new-array.
+    Code opcode;
+  };
+
+  // Unpacks the opcode and all the operands at once, which switches on the format once instead
+  // of once for each of the HasVRegX() and VRegX() calls.
+  void Decode(Decoded* decoded) const;
+
   // Returns the opcode field of the instruction. The given "inst_data" parameter must be the first
   // 16 bits of instruction.
   Code Opcode(uint16_t inst_data) const {
@@ -118,6 +118,7 @@ ElfFile::ElfFile(File* file, bool writable, bool program_header_only)
     strtab_section_start_(NULL),
     dynstr_section_start_(NULL),
     hash_section_start_(NULL),
+    gnu_hash_section_start_(NULL),
     symtab_symbol_table_(NULL),
     dynsym_symbol_table_(NULL),
     jit_elf_image_(NULL),
@@ -245,6 +246,10 @@ bool ElfFile::Setup(std::string* error_msg) {
           hash_section_start_ = reinterpret_cast<Elf32_Word*>(section_addr);
           break;
         }
+        case SHT_GNU_HASH: {
+          gnu_hash_section_start_ = reinterpret_cast<Elf32_Word*>(section_addr);
+          break;
+        }
       }
     }
   }
@@ -559,25 +564,79 @@ static unsigned elfhash(const char *_name) {
   return h;
 }
 
+// The hash function of .gnu.hash sections.
+static uint32_t gnuhash(const char* name) {
+  uint32_t h = 5381;
+  for (const unsigned char* p = reinterpret_cast<const unsigned char*>(name); *p != '\0'; ++p) {
+    h = (h << 5) + h + *p;
+  }
+  return h;
+}
+
 Elf32_Shdr& ElfFile::GetSectionNameStringSection() const {
   return GetSectionHeader(GetHeader().e_shstrndx);
 }
 
-const byte* ElfFile::FindDynamicSymbolAddress(const std::string& symbol_name) const {
+Elf32_Sym* ElfFile::FindDynamicSymbol(const std::string& symbol_name) const {
+  if (gnu_hash_section_start_ != NULL) {
+    // nbuckets, symoffset, bloom_size and bloom_shift, then the bloom filter, the buckets and the
+    // hashes of the symbols from symoffset on, with the low bit set on the last one of a chain.
+    const Elf32_Word* header = gnu_hash_section_start_;
+    Elf32_Word num_buckets = header[0];
+    Elf32_Word symbol_offset = header[1];
+    Elf32_Word bloom_size = header[2];
+    Elf32_Word bloom_shift = header[3];
+    const Elf32_Word* bloom = header + 4;
+    const Elf32_Word* buckets = bloom + bloom_size;
+    const Elf32_Word* chains = buckets + num_buckets;
+    Elf32_Word hash = gnuhash(symbol_name.c_str());
+    Elf32_Word bloom_word = bloom[(hash / 32) % bloom_size];
+    Elf32_Word bloom_mask = (1U << (hash % 32)) | (1U << ((hash >> bloom_shift) % 32));
+    if ((bloom_word & bloom_mask) != bloom_mask) {
+      return NULL;
+    }
+    Elf32_Word symbol_index = buckets[hash % num_buckets];
+    if (symbol_index < symbol_offset) {
+      return NULL;
+    }
+    while (true) {
+      Elf32_Word chain_hash = chains[symbol_index - symbol_offset];
+      if ((hash | 1) == (chain_hash | 1)) {
+        Elf32_Sym& symbol = GetSymbol(SHT_DYNSYM, symbol_index);
+        const char* name = GetString(SHT_DYNSYM, symbol.st_name);
+        if (name != NULL && symbol_name == name) {
+          return &symbol;
+        }
+      }
+      if ((chain_hash & 1) != 0) {
+        return NULL;
+      }
+      symbol_index++;
+    }
+  }
+
   Elf32_Word hash = elfhash(symbol_name.c_str());
   Elf32_Word bucket_index = hash % GetHashBucketNum();
   Elf32_Word symbol_and_chain_index = GetHashBucket(bucket_index);
   while (symbol_and_chain_index != 0 /* STN_UNDEF */) {
     Elf32_Sym& symbol = GetSymbol(SHT_DYNSYM, symbol_and_chain_index);
     const char* name = GetString(SHT_DYNSYM, symbol.st_name);
-    if (symbol_name == name) {
-      return base_address_ + symbol.st_value;
+    if (name != NULL && symbol_name == name) {
+      return &symbol;
     }
     symbol_and_chain_index = GetHashChain(symbol_and_chain_index);
   }
   return NULL;
 }
 
+const byte* ElfFile::FindDynamicSymbolAddress(const std::string& symbol_name) const {
+  Elf32_Sym* symbol = FindDynamicSymbol(symbol_name);
+  if (symbol == NULL) {
+    return NULL;
+  }
+  return base_address_ + symbol->st_value;
+}
+
 bool ElfFile::IsSymbolSectionType(Elf32_Word section_type) {
   return ((section_type == SHT_SYMTAB) || (section_type == SHT_DYNSYM));
 }
@@ -654,6 +713,10 @@ Elf32_Sym* ElfFile::FindSymbolByName(Elf32_Word section_type,
     return it->second;
   }
 
+  if (section_type == SHT_DYNSYM && HasDynamicSymbolHash()) {
+    return FindDynamicSymbol(symbol_name);
+  }
+
   // Fall back to linear search
   Elf32_Shdr* symbol_section = FindSectionByType(section_type);
   CHECK(symbol_section != NULL) << file_->GetPath();
@@ -902,6 +965,10 @@ bool ElfFile::Load(bool executable, std::string* error_msg) {
                                 i, file_->GetPath().c_str(), p_vaddr, segment->Begin());
       return false;
     }
+    if ((prot & PROT_EXEC) != 0) {
+      // Large compiled code suffers from iTLB misses.
+      segment->AdviseHugePages();
+    }
     segments_.push_back(segment.release());
   }
 
@@ -921,6 +988,15 @@ bool ElfFile::Load(bool executable, std::string* error_msg) {
         hash_section_start_ = reinterpret_cast<Elf32_Word*>(d_ptr);
         break;
       }
+      case DT_GNU_HASH: {
+        if (!ValidPointer(d_ptr)) {
+          *error_msg = StringPrintf("DT_GNU_HASH value %p does not refer to a loaded ELF segment "
+                                    "of %s", d_ptr, file_->GetPath().c_str());
+          return false;
+        }
+        gnu_hash_section_start_ = reinterpret_cast<Elf32_Word*>(d_ptr);
+        break;
+      }
       case DT_STRTAB: {
         if (!ValidPointer(d_ptr)) {
           *error_msg = StringPrintf("DT_HASH value %p does not refer to a loaded ELF segment of %s",
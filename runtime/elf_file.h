@@ -73,7 +73,7 @@ class ElfFile {
 
   Elf32_Shdr& GetSectionNameStringSection() const;
 
-  // Find .dynsym using .hash for more efficient lookup than FindSymbolAddress.
+  // Find .dynsym using .gnu.hash or .hash for more efficient lookup than FindSymbolAddress.
   const byte* FindDynamicSymbolAddress(const std::string& symbol_name) const;
 
   static bool IsSymbolSectionType(Elf32_Word section_type);
@@ -87,7 +87,8 @@ class ElfFile {
   // since they can contain duplicates. If build_map is false, the map
   // will be used if it was already created. Typically build_map
   // should be set unless only a small number of symbols will be
-  // looked up.
+  // looked up. Without a map, .dynsym is searched through its hash
+  // section when there is one, and other tables linearly.
   Elf32_Sym* FindSymbolByName(Elf32_Word section_type,
                               const std::string& symbol_name,
                               bool build_map);
@@ -142,6 +143,11 @@ class ElfFile {
   Elf32_Word GetHashChainNum() const;
   Elf32_Word GetHashBucket(size_t i) const;
   Elf32_Word GetHashChain(size_t i) const;
+  bool HasDynamicSymbolHash() const {
+    return gnu_hash_section_start_ != NULL || hash_section_start_ != NULL;
+  }
+  // Looks a .dynsym symbol up through .gnu.hash if present, .hash otherwise.
+  Elf32_Sym* FindDynamicSymbol(const std::string& symbol_name) const;
 
   typedef std::map<std::string, Elf32_Sym*> SymbolTable;
   SymbolTable** GetSymbolTable(Elf32_Word section_type);
@@ -174,6 +180,7 @@ class ElfFile {
   char* strtab_section_start_;
   char* dynstr_section_start_;
   Elf32_Word* hash_section_start_;
+  Elf32_Word* gnu_hash_section_start_;
 
   SymbolTable* symtab_symbol_table_;
   SymbolTable* dynsym_symbol_table_;
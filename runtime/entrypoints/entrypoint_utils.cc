@@ -140,34 +140,39 @@ void ThrowStackOverflowError(Thread* self) {
 }
 
 JValue InvokeProxyInvocationHandler(ScopedObjectAccessAlreadyRunnable& soa, const char* shorty,
-                                    jobject rcvr_jobj, jobject interface_method_jobj,
-                                    std::vector<jvalue>& args) {
+                                    jobject rcvr_jobj, mirror::ArtMethod* proxy_method,
+                                    jobject interface_method_jobj, std::vector<jvalue>& args) {
   DCHECK(soa.Env()->IsInstanceOf(rcvr_jobj, WellKnownClasses::java_lang_reflect_Proxy));
+  DCHECK(proxy_method->IsProxyMethod()) << PrettyMethod(proxy_method);
 
-  // Build argument array possibly triggering GC.
+  // Build argument array possibly triggering GC. The array and the boxes are allocated and
+  // filled directly, rather than through JNI calls checked for each argument.
   soa.Self()->AssertThreadSuspensionIsAllowable();
-  jobjectArray args_jobj = NULL;
+  StackHandleScope<2> hs(soa.Self());
+  Handle<mirror::ObjectArray<mirror::Object>> args_array(
+      hs.NewHandle<mirror::ObjectArray<mirror::Object>>(nullptr));
   const JValue zero;
   if (args.size() > 0) {
-    args_jobj = soa.Env()->NewObjectArray(args.size(), WellKnownClasses::java_lang_Object, NULL);
-    if (args_jobj == NULL) {
+    ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+    args_array.Assign(class_linker->AllocObjectArray<mirror::Object>(soa.Self(), args.size()));
+    if (args_array.Get() == nullptr) {
       CHECK(soa.Self()->IsExceptionPending());
       return zero;
     }
     for (size_t i = 0; i < args.size(); ++i) {
+      mirror::Object* val;
       if (shorty[i + 1] == 'L') {
-        jobject val = args.at(i).l;
-        soa.Env()->SetObjectArrayElement(args_jobj, i, val);
+        val = soa.Decode<mirror::Object*>(args[i].l);
       } else {
         JValue jv;
-        jv.SetJ(args.at(i).j);
-        mirror::Object* val = BoxPrimitive(Primitive::GetType(shorty[i + 1]), jv);
+        jv.SetJ(args[i].j);
+        val = BoxPrimitive(Primitive::GetType(shorty[i + 1]), jv);
         if (val == NULL) {
           CHECK(soa.Self()->IsExceptionPending());
           return zero;
         }
-        soa.Decode<mirror::ObjectArray<mirror::Object>* >(args_jobj)->Set<false>(i, val);
       }
+      args_array->Set<false>(i, val);
     }
   }
 
@@ -175,34 +180,26 @@ JValue InvokeProxyInvocationHandler(ScopedObjectAccessAlreadyRunnable& soa, cons
   jvalue invocation_args[3];
   invocation_args[0].l = rcvr_jobj;
   invocation_args[1].l = interface_method_jobj;
-  invocation_args[2].l = args_jobj;
-  jobject result =
-      soa.Env()->CallStaticObjectMethodA(WellKnownClasses::java_lang_reflect_Proxy,
-                                         WellKnownClasses::java_lang_reflect_Proxy_invoke,
-                                         invocation_args);
+  invocation_args[2].l = soa.AddLocalReference<jobjectArray>(args_array.Get());
+  JValue result = InvokeWithJValues(soa, nullptr, WellKnownClasses::java_lang_reflect_Proxy_invoke,
+                                    invocation_args);
 
   // Unbox result and handle error conditions.
   if (LIKELY(!soa.Self()->IsExceptionPending())) {
-    if (shorty[0] == 'V' || (shorty[0] == 'L' && result == NULL)) {
+    if (shorty[0] == 'V' || (shorty[0] == 'L' && result.GetL() == NULL)) {
       // Do nothing.
       return zero;
     } else {
-      mirror::Object* result_ref = soa.Decode<mirror::Object*>(result);
-      mirror::Object* rcvr = soa.Decode<mirror::Object*>(rcvr_jobj);
+      // Resolving the return type may suspend.
+      Handle<mirror::Object> result_ref(hs.NewHandle(result.GetL()));
       mirror::ArtMethod* interface_method =
           soa.Decode<mirror::ArtMethod*>(interface_method_jobj);
       mirror::Class* result_type = MethodHelper(interface_method).GetReturnType();
-      mirror::ArtMethod* proxy_method;
-      if (interface_method->GetDeclaringClass()->IsInterface()) {
-        proxy_method = rcvr->GetClass()->FindVirtualMethodForInterface(interface_method);
-      } else {
-        // Proxy dispatch to a method defined in Object.
-        DCHECK(interface_method->GetDeclaringClass()->IsObjectClass());
-        proxy_method = interface_method;
-      }
+      mirror::Object* rcvr = soa.Decode<mirror::Object*>(rcvr_jobj);
       ThrowLocation throw_location(rcvr, proxy_method, -1);
       JValue result_unboxed;
-      if (!UnboxPrimitiveForResult(throw_location, result_ref, result_type, &result_unboxed)) {
+      if (!UnboxPrimitiveForResult(throw_location, result_ref.Get(), result_type,
+                                   &result_unboxed)) {
         DCHECK(soa.Self()->IsExceptionPending());
         return zero;
       }
@@ -216,10 +213,6 @@ JValue InvokeProxyInvocationHandler(ScopedObjectAccessAlreadyRunnable& soa, cons
       mirror::Object* rcvr = soa.Decode<mirror::Object*>(rcvr_jobj);
       mirror::SynthesizedProxyClass* proxy_class =
           down_cast<mirror::SynthesizedProxyClass*>(rcvr->GetClass());
-      mirror::ArtMethod* interface_method =
-          soa.Decode<mirror::ArtMethod*>(interface_method_jobj);
-      mirror::ArtMethod* proxy_method =
-          rcvr->GetClass()->FindVirtualMethodForInterface(interface_method);
       int throws_index = -1;
       size_t num_virt_methods = proxy_class->NumVirtualMethods();
       for (size_t i = 0; i < num_virt_methods; i++) {
@@ -465,8 +465,11 @@ static inline mirror::ArtMethod* FindMethodFromCode(uint32_t method_idx,
       if (!imt_method->IsImtConflictMethod()) {
         return imt_method;
       } else {
-        mirror::ArtMethod* interface_method =
-            handle_scope_this->GetClass()->FindVirtualMethodForInterface(resolved_method);
+        mirror::ArtMethod* interface_method = imt_method->FindImtConflictTarget(resolved_method);
+        if (interface_method == nullptr) {
+          interface_method =
+              handle_scope_this->GetClass()->FindVirtualMethodForInterface(resolved_method);
+        }
         if (UNLIKELY(interface_method == nullptr)) {
           ThrowIncompatibleClassChangeErrorClassForInterfaceDispatch(resolved_method,
                                                                      handle_scope_this.Get(), referrer);
@@ -699,9 +702,11 @@ static inline void CheckSuspend(Thread* thread) SHARED_LOCKS_REQUIRED(Locks::mut
   }
 }
 
+// Calls the InvocationHandler of a proxy for a call to proxy_method, a method of the proxy class.
+// Methods are not movable, proxy_method is valid across the call.
 JValue InvokeProxyInvocationHandler(ScopedObjectAccessAlreadyRunnable& soa, const char* shorty,
-                                    jobject rcvr_jobj, jobject interface_art_method_jobj,
-                                    std::vector<jvalue>& args)
+                                    jobject rcvr_jobj, mirror::ArtMethod* proxy_method,
+                                    jobject interface_art_method_jobj, std::vector<jvalue>& args)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
 // Entry point for deoptimization.
@@ -55,6 +55,7 @@ extern "C" void art_portable_throw_exception_from_code(mirror::Throwable* except
   if (exception == NULL) {
     ThrowNullPointerException(NULL, "throw with null exception");
   } else {
+    ++self->GetCounters()->exceptions_thrown;
     self->SetException(throw_location, exception);
   }
 }
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_ENTRYPOINTS_QUICK_GENERIC_JNI_LAYOUT_CACHE_H_
+#define ART_RUNTIME_ENTRYPOINTS_QUICK_GENERIC_JNI_LAYOUT_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/macros.h"
+
+namespace art {
+
+// Per-thread cache of the native call frame layouts computed by the generic JNI trampoline, so
+// that a call doesn't run the shorty through the frame building state machine twice, once to size
+// the frame and once to fill it. Direct-mapped and keyed by the shorty pointer: shorties live in
+// the dex files, which are never unloaded, and all the methods of a proto share one. The layout
+// doesn't depend on the static or synchronized flags, the first argument after the JNIEnv is a
+// reference either way. Only the owning thread accesses it.
+class GenericJniLayoutCache {
+ public:
+  GenericJniLayoutCache() {
+    for (size_t i = 0; i < kSize; ++i) {
+      entries_[i].shorty = nullptr;
+    }
+  }
+
+  bool Get(const char* shorty, uint32_t* num_handle_scope_references,
+           uint32_t* num_stack_entries) const ALWAYS_INLINE {
+    const Entry& entry = entries_[IndexOf(shorty)];
+    if (entry.shorty != shorty) {
+      return false;
+    }
+    *num_handle_scope_references = entry.num_handle_scope_references;
+    *num_stack_entries = entry.num_stack_entries;
+    return true;
+  }
+
+  void Set(const char* shorty, uint32_t num_handle_scope_references, uint32_t num_stack_entries)
+      ALWAYS_INLINE {
+    Entry& entry = entries_[IndexOf(shorty)];
+    entry.shorty = shorty;
+    entry.num_handle_scope_references = num_handle_scope_references;
+    entry.num_stack_entries = num_stack_entries;
+  }
+
+ private:
+  static constexpr size_t kSize = 32;
+
+  struct Entry {
+    const char* shorty;
+    uint32_t num_handle_scope_references;
+    uint32_t num_stack_entries;
+  };
+
+  static size_t IndexOf(const char* shorty) ALWAYS_INLINE {
+    // Shorties are short strings packed together in the string data of a dex file.
+    uintptr_t address = reinterpret_cast<uintptr_t>(shorty);
+    return (address ^ (address >> 5)) & (kSize - 1);
+  }
+
+  Entry entries_[kSize];
+
+  DISALLOW_COPY_AND_ASSIGN(GenericJniLayoutCache);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_ENTRYPOINTS_QUICK_GENERIC_JNI_LAYOUT_CACHE_H_
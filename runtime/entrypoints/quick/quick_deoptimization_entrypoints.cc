@@ -22,6 +22,7 @@
 #include "mirror/object_array-inl.h"
 #include "mirror/object-inl.h"
 #include "object_utils.h"
+#include "quick_exception_handler.h"
 #include "stack.h"
 #include "thread.h"
 #include "verifier/method_verifier.h"
@@ -35,4 +36,17 @@ extern "C" void artDeoptimize(Thread* self, mirror::ArtMethod** sp)
   self->QuickDeliverException();
 }
 
+// Called by compiled code when a guard of a speculative optimization fails. The method continues
+// in the interpreter at the dex pc of the guard, as do its callers after their invoke.
+extern "C" void artDeoptimizeFromCompiledCode(Thread* self, mirror::ArtMethod** sp)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  FinishCalleeSaveFrameSetup(self, sp, Runtime::kSaveAll);
+  // The top frame has no result of an invoke to resume with.
+  self->SetDeoptimizationReturnValue(JValue());
+  QuickExceptionHandler exception_handler(self, true);
+  exception_handler.DeoptimizeStack(true);
+  exception_handler.UpdateInstrumentationStack();
+  exception_handler.DoLongJump();
+}
+
 }  // namespace art
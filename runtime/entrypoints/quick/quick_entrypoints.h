@@ -141,6 +141,9 @@ struct PACKED(4) QuickEntryPoints {
   void (*pThrowNoSuchMethod)(int32_t);
   void (*pThrowNullPointer)();
   void (*pThrowStackOverflow)(void*);
+
+  // Deoptimization
+  void (*pDeoptimize)();
 };
 
 
@@ -30,6 +30,7 @@ namespace art {
 
 // Called on entry to JNI, transition out of Runnable and release share of mutator_lock_.
 extern uint32_t JniMethodStart(Thread* self) {
+  ++self->GetCounters()->jni_calls;
   JNIEnvExt* env = self->GetJniEnv();
   DCHECK(env != nullptr);
   uint32_t saved_local_ref_cookie = env->local_ref_cookie;
@@ -48,6 +48,7 @@ extern "C" void artDeliverExceptionFromCode(mirror::Throwable* exception, Thread
     self->ThrowNewException(throw_location, "Ljava/lang/NullPointerException;",
                             "throw with null exception");
   } else {
+    ++self->GetCounters()->exceptions_thrown;
     self->SetException(throw_location, exception);
   }
   self->QuickDeliverException();
@@ -210,6 +210,45 @@ class QuickArgumentVisitor {
     return *reinterpret_cast<uintptr_t*>(lr);
   }
 
+  // Copies the arguments of the ref and args quick frame into the vregs of a shadow frame
+  // starting at first_arg_reg, without visiting them one by one, when they are all words in the
+  // spilled GPR arguments: at most kNumQuickGprArgs of them, counting this, and no long, double,
+  // or float with a hard float ABI. Most calls have such shorties. Returns false, having copied
+  // nothing, for the others.
+  static bool CopyGprArgsToShadowFrame(mirror::ArtMethod** sp, bool is_static, const char* shorty,
+                                       uint32_t shorty_len, ShadowFrame* sf, size_t first_arg_reg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    size_t num_args = (shorty_len - 1u) + (is_static ? 0u : 1u);
+    if (num_args > kNumQuickGprArgs) {
+      return false;
+    }
+    for (uint32_t shorty_index = 1; shorty_index < shorty_len; ++shorty_index) {
+      char c = shorty[shorty_index];
+      if (c == 'J' || c == 'D' || (c == 'F' && !kQuickSoftFloatAbi)) {
+        return false;
+      }
+    }
+    byte* gpr_args = reinterpret_cast<byte*>(sp) + kQuickCalleeSaveFrame_RefAndArgs_Gpr1Offset;
+    uint32_t gpr_index = 0;
+    if (!is_static) {
+      StackReference<mirror::Object>* this_ref =
+          reinterpret_cast<StackReference<mirror::Object>*>(gpr_args + GprIndexToGprOffset(0));
+      sf->SetVRegReference(first_arg_reg, this_ref->AsMirrorPtr());
+      ++gpr_index;
+    }
+    for (uint32_t shorty_index = 1; shorty_index < shorty_len; ++shorty_index, ++gpr_index) {
+      byte* arg = gpr_args + GprIndexToGprOffset(gpr_index);
+      if (shorty[shorty_index] == 'L') {
+        StackReference<mirror::Object>* ref =
+            reinterpret_cast<StackReference<mirror::Object>*>(arg);
+        sf->SetVRegReference(first_arg_reg + gpr_index, ref->AsMirrorPtr());
+      } else {
+        sf->SetVReg(first_arg_reg + gpr_index, *reinterpret_cast<jint*>(arg));
+      }
+    }
+    return true;
+  }
+
   QuickArgumentVisitor(mirror::ArtMethod** sp, bool is_static,
                        const char* shorty, uint32_t shorty_len)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) :
@@ -477,10 +516,14 @@ extern "C" uint64_t artQuickToInterpreterBridge(mirror::ArtMethod* method, Threa
     ShadowFrame* shadow_frame(ShadowFrame::Create(num_regs, NULL,  // No last shadow coming from quick.
                                                   method, 0, memory));
     size_t first_arg_reg = code_item->registers_size_ - code_item->ins_size_;
-    BuildQuickShadowFrameVisitor shadow_frame_builder(sp, mh.IsStatic(), mh.GetShorty(),
-                                                      mh.GetShortyLength(),
-                                                      shadow_frame, first_arg_reg);
-    shadow_frame_builder.VisitArguments();
+    if (!QuickArgumentVisitor::CopyGprArgsToShadowFrame(sp, mh.IsStatic(), mh.GetShorty(),
+                                                        mh.GetShortyLength(), shadow_frame,
+                                                        first_arg_reg)) {
+      BuildQuickShadowFrameVisitor shadow_frame_builder(sp, mh.IsStatic(), mh.GetShorty(),
+                                                        mh.GetShortyLength(),
+                                                        shadow_frame, first_arg_reg);
+      shadow_frame_builder.VisitArguments();
+    }
     // Push a transition back into managed code onto the linked list in thread.
     ManagedStack fragment;
     self->PushManagedStackFragment(&fragment);
@@ -602,6 +645,7 @@ extern "C" uint64_t artQuickProxyInvokeHandler(mirror::ArtMethod* proxy_method,
   MethodHelper proxy_mh(proxy_method);
   DCHECK(!proxy_mh.IsStatic()) << PrettyMethod(proxy_method);
   std::vector<jvalue> args;
+  args.reserve(proxy_mh.GetShortyLength());
   BuildQuickArgumentVisitor local_ref_visitor(sp, proxy_mh.IsStatic(), proxy_mh.GetShorty(),
                                               proxy_mh.GetShortyLength(), &soa, &args);
 
@@ -618,8 +662,8 @@ extern "C" uint64_t artQuickProxyInvokeHandler(mirror::ArtMethod* proxy_method,
   // All naked Object*s should now be in jobjects, so its safe to go into the main invoke code
   // that performs allocations.
   self->EndAssertNoThreadSuspension(old_cause);
-  JValue result = InvokeProxyInvocationHandler(soa, proxy_mh.GetShorty(),
-                                               rcvr_jobj, interface_method_jobj, args);
+  JValue result = InvokeProxyInvocationHandler(soa, proxy_mh.GetShorty(), rcvr_jobj,
+                                               proxy_method, interface_method_jobj, args);
   // Restore references which might have moved.
   local_ref_visitor.FixupReferences();
   return result.GetJ();
@@ -1170,12 +1214,17 @@ class ComputeGenericJniFrameSize FINAL {
   }
 
   // WARNING: After this, *sp won't be pointing to the method anymore!
-  void ComputeLayout(mirror::ArtMethod*** m, bool is_static, const char* shorty, uint32_t shorty_len,
-                     void* sp, HandleScope** table, uint32_t* handle_scope_entries,
-                     uintptr_t** start_stack, uintptr_t** start_gpr, uint32_t** start_fpr,
-                     void** code_return, size_t* overall_size)
+  void ComputeLayout(Thread* self, mirror::ArtMethod*** m, bool is_static, const char* shorty,
+                     uint32_t shorty_len, void* sp, HandleScope** table,
+                     uint32_t* handle_scope_entries, uintptr_t** start_stack,
+                     uintptr_t** start_gpr, uint32_t** start_fpr, void** code_return,
+                     size_t* overall_size)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    ComputeAll(is_static, shorty, shorty_len);
+    GenericJniLayoutCache* layout_cache = self->GetGenericJniLayoutCache();
+    if (!layout_cache->Get(shorty, &num_handle_scope_references_, &num_stack_entries_)) {
+      ComputeAll(is_static, shorty, shorty_len);
+      layout_cache->Set(shorty, num_handle_scope_references_, num_stack_entries_);
+    }
 
     mirror::ArtMethod* method = **m;
 
@@ -1309,9 +1358,9 @@ class BuildGenericJniFrameVisitor FINAL : public QuickArgumentVisitor {
                               uint32_t shorty_len, Thread* self) :
       QuickArgumentVisitor(*sp, is_static, shorty, shorty_len), sm_(this) {
     ComputeGenericJniFrameSize fsc;
-    fsc.ComputeLayout(sp, is_static, shorty, shorty_len, *sp, &handle_scope_, &handle_scope_expected_refs_,
-                      &cur_stack_arg_, &cur_gpr_reg_, &cur_fpr_reg_, &code_return_,
-                      &alloca_used_size_);
+    fsc.ComputeLayout(self, sp, is_static, shorty, shorty_len, *sp, &handle_scope_,
+                      &handle_scope_expected_refs_, &cur_stack_arg_, &cur_gpr_reg_, &cur_fpr_reg_,
+                      &code_return_, &alloca_used_size_);
     handle_scope_number_of_references_ = 0;
     cur_hs_entry_ = reinterpret_cast<StackReference<mirror::Object>*>(GetFirstHandleScopeEntry());
 
@@ -1726,7 +1775,18 @@ extern "C" uint64_t artInvokeInterfaceTrampoline(mirror::ArtMethod* interface_me
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   mirror::ArtMethod* method;
   if (LIKELY(interface_method->GetDexMethodIndex() != DexFile::kDexNoIndex)) {
-    method = this_object->GetClass()->FindVirtualMethodForInterface(interface_method);
+    // The conflict method of the IMT entry lists the few interface methods sharing it, which is
+    // shorter to search than all the interfaces of the class.
+    mirror::Class* klass = this_object->GetClass();
+    mirror::ObjectArray<mirror::ArtMethod>* imt = klass->GetImTable();
+    method = nullptr;
+    if (imt != nullptr) {
+      uint32_t imt_index = interface_method->GetDexMethodIndex() % ClassLinker::kImtSize;
+      method = imt->Get(imt_index)->FindImtConflictTarget(interface_method);
+    }
+    if (method == nullptr) {
+      method = klass->FindVirtualMethodForInterface(interface_method);
+    }
     if (UNLIKELY(method == NULL)) {
       FinishCalleeSaveFrameSetup(self, sp, Runtime::kRefsAndArgs);
       ThrowIncompatibleClassChangeErrorClassForInterfaceDispatch(interface_method, this_object,
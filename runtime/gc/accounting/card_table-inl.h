@@ -29,7 +29,7 @@ namespace accounting {
 
 static inline bool byte_cas(byte old_value, byte new_value, byte* address) {
   // Little endian means most significant byte is on the left.
-  const size_t shift_in_bytes = reinterpret_cast<uintptr_t>(address) % sizeof(uintptr_t);
+  const size_t shift_in_bytes = reinterpret_cast<uintptr_t>(address) % sizeof(int32_t);
   // Align the address down.
   address -= shift_in_bytes;
   const size_t shift_in_bits = shift_in_bytes * kBitsPerByte;
@@ -42,6 +42,26 @@ static inline bool byte_cas(byte old_value, byte new_value, byte* address) {
   return success;
 }
 
+static inline bool word_cas(uintptr_t old_value, uintptr_t new_value, uintptr_t* address) {
+  // A full word so that 64 bit targets update all of the cards of the word.
+  return __sync_bool_compare_and_swap(address, old_value, new_value);
+}
+
+// Returns the first word in [word_cur, word_end) which holds a card that isn't clean, or
+// word_end if they are all clean. Most cards are clean, so the words are checked a block at a
+// time, with one branch per block.
+static inline uintptr_t* SkipCleanCardWords(uintptr_t* word_cur, uintptr_t* word_end) {
+  static constexpr size_t kWordsPerBlock = 4;
+  while (word_end - word_cur >= static_cast<ptrdiff_t>(kWordsPerBlock) &&
+      (word_cur[0] | word_cur[1] | word_cur[2] | word_cur[3]) == 0) {
+    word_cur += kWordsPerBlock;
+  }
+  while (word_cur < word_end && *word_cur == 0) {
+    ++word_cur;
+  }
+  return word_cur;
+}
+
 template <typename Visitor>
 inline size_t CardTable::Scan(ContinuousSpaceBitmap* bitmap, byte* scan_begin, byte* scan_end,
                               const Visitor& visitor, const byte minimum_age) const {
@@ -69,11 +89,9 @@ inline size_t CardTable::Scan(ContinuousSpaceBitmap* bitmap, byte* scan_begin, b
   uintptr_t* word_end = reinterpret_cast<uintptr_t*>(aligned_end);
   for (uintptr_t* word_cur = reinterpret_cast<uintptr_t*>(card_cur); word_cur < word_end;
       ++word_cur) {
-    while (LIKELY(*word_cur == 0)) {
-      ++word_cur;
-      if (UNLIKELY(word_cur >= word_end)) {
-        goto exit_for;
-      }
+    word_cur = SkipCleanCardWords(word_cur, word_end);
+    if (UNLIKELY(word_cur >= word_end)) {
+      break;
     }
 
     // Find the first dirty card.
@@ -93,7 +111,6 @@ inline size_t CardTable::Scan(ContinuousSpaceBitmap* bitmap, byte* scan_begin, b
       start += kCardSize;
     }
   }
-  exit_for:
 
   // Handle any unaligned cards at the end.
   card_cur = reinterpret_cast<byte*>(word_end);
@@ -165,17 +182,21 @@ inline void CardTable::ModifyCardsAtomic(byte* scan_begin, byte* scan_end, const
   };
 
   // TODO: Parallelize.
-  while (word_cur < word_end) {
+  while (true) {
+    // Clean cards are mapped to clean cards by all the visitors, skip them without a CAS.
+    word_cur = SkipCleanCardWords(word_cur, word_end);
+    if (word_cur >= word_end) {
+      break;
+    }
     while (true) {
       expected_word = *word_cur;
-      if (LIKELY(expected_word == 0)) {
+      if (UNLIKELY(expected_word == 0)) {
         break;
       }
       for (size_t i = 0; i < sizeof(uintptr_t); ++i) {
         new_bytes[i] = visitor(expected_bytes[i]);
       }
-      if (LIKELY(android_atomic_cas(expected_word, new_word,
-                                    reinterpret_cast<int32_t*>(word_cur)) == 0)) {
+      if (LIKELY(word_cas(expected_word, new_word, word_cur))) {
         for (size_t i = 0; i < sizeof(uintptr_t); ++i) {
           const byte expected_byte = expected_bytes[i];
           const byte new_byte = new_bytes[i];
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "card_table.h"
+
+#include <memory>
+#include <vector>
+
+#include "card_table-inl.h"
+#include "common_runtime_test.h"
+#include "gc/heap.h"
+#include "globals.h"
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+class CardTableTest : public CommonRuntimeTest {};
+
+class CountModifiedCardsVisitor {
+ public:
+  explicit CountModifiedCardsVisitor(size_t* count) : count_(count) {
+  }
+  void operator()(byte* card, byte expected_value, byte new_value) const {
+    EXPECT_NE(expected_value, new_value);
+    ++*count_;
+  }
+
+ private:
+  size_t* const count_;
+};
+
+TEST_F(CardTableTest, AgeCards) {
+  byte* heap_begin = reinterpret_cast<byte*>(0x10000000);
+  const size_t heap_capacity = 16 * MB;
+  std::unique_ptr<CardTable> card_table(CardTable::Create(heap_begin, heap_capacity));
+  ASSERT_TRUE(card_table.get() != nullptr);
+  // Dirty cards at the start and end of the range, and at every offset within a word in the
+  // middle, surrounded by long runs of clean cards.
+  std::vector<byte*> addrs;
+  addrs.push_back(heap_begin);
+  for (size_t i = 0; i < sizeof(uintptr_t); ++i) {
+    addrs.push_back(heap_begin + MB + (i * sizeof(uintptr_t) + i) * CardTable::kCardSize);
+  }
+  addrs.push_back(heap_begin + heap_capacity - CardTable::kCardSize);
+  for (byte* addr : addrs) {
+    card_table->MarkCard(addr);
+  }
+  size_t modified = 0;
+  card_table->ModifyCardsAtomic(heap_begin, heap_begin + heap_capacity, AgeCardVisitor(),
+                                CountModifiedCardsVisitor(&modified));
+  EXPECT_EQ(addrs.size(), modified);
+  for (byte* addr : addrs) {
+    EXPECT_EQ(CardTable::kCardDirty - 1, *card_table->CardFromAddr(addr));
+  }
+  // Aging again cleans the cards.
+  modified = 0;
+  card_table->ModifyCardsAtomic(heap_begin, heap_begin + heap_capacity, AgeCardVisitor(),
+                                CountModifiedCardsVisitor(&modified));
+  EXPECT_EQ(addrs.size(), modified);
+  for (byte* addr : addrs) {
+    EXPECT_EQ(CardTable::kCardClean, *card_table->CardFromAddr(addr));
+  }
+}
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
@@ -25,6 +25,7 @@
 #include "gc/collector/mark_sweep.h"
 #include "gc/collector/mark_sweep-inl.h"
 #include "gc/heap.h"
+#include "gc/space/image_space.h"
 #include "gc/space/space.h"
 #include "mirror/art_field-inl.h"
 #include "mirror/object-inl.h"
@@ -333,6 +334,228 @@ void ModUnionTableCardCache::Dump(std::ostream& os) {
   os << "]";
 }
 
+ModUnionTableReferenceBitmap::ModUnionTableReferenceBitmap(const std::string& name, Heap* heap,
+                                                           space::ContinuousSpace* space)
+    : ModUnionTable(name, heap, space),
+      image_space_(heap->GetImageSpace()) {
+  const size_t capacity = space->Limit() - space->Begin();
+  cleared_cards_.reset(CardBitmap::Create(name + " cleared cards", space->Begin(), capacity));
+  CHECK(cleared_cards_.get() != nullptr) << "Failed to create the cleared cards of " << name;
+  reference_holders_.reset(
+      ContinuousSpaceBitmap::Create(name + " reference holders", space->Begin(), capacity));
+  CHECK(reference_holders_.get() != nullptr) << "Failed to create the reference holders of "
+                                             << name;
+}
+
+bool ModUnionTableReferenceBitmap::ShouldAddReference(const mirror::Object* ref) const {
+  return !space_->HasAddress(ref) && (image_space_ == nullptr || !image_space_->HasAddress(ref));
+}
+
+class ModUnionSetCardBitVisitor {
+ public:
+  explicit ModUnionSetCardBitVisitor(CardTable* card_table, CardBitmap* cleared_cards)
+    : card_table_(card_table), cleared_cards_(cleared_cards) {
+  }
+
+  inline void operator()(byte* card, byte expected_value, byte new_value) const {
+    if (expected_value == CardTable::kCardDirty) {
+      cleared_cards_->Set(reinterpret_cast<Object*>(card_table_->AddrFromCard(card)));
+    }
+  }
+
+ private:
+  CardTable* const card_table_;
+  CardBitmap* const cleared_cards_;
+};
+
+void ModUnionTableReferenceBitmap::ClearCards() {
+  CardTable* card_table = GetHeap()->GetCardTable();
+  ModUnionSetCardBitVisitor visitor(card_table, cleared_cards_.get());
+  // Clear dirty cards in the this space and update the corresponding mod-union bits.
+  card_table->ModifyCardsAtomic(space_->Begin(), space_->End(), AgeCardVisitor(), visitor);
+}
+
+class HoldsReferenceVisitor {
+ public:
+  HoldsReferenceVisitor(const ModUnionTableReferenceBitmap* mod_union_table, bool* holds_reference)
+    : mod_union_table_(mod_union_table), holds_reference_(holds_reference) {
+  }
+
+  void operator()(Object* obj, MemberOffset offset, bool /*is_static*/) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    mirror::Object* ref = obj->GetFieldObject<mirror::Object>(offset);
+    if (ref != nullptr && mod_union_table_->ShouldAddReference(ref)) {
+      *holds_reference_ = true;
+    }
+  }
+
+ private:
+  const ModUnionTableReferenceBitmap* const mod_union_table_;
+  bool* const holds_reference_;
+};
+
+static bool HoldsReference(const ModUnionTableReferenceBitmap* mod_union_table, Object* obj)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  bool holds_reference = false;
+  HoldsReferenceVisitor visitor(mod_union_table, &holds_reference);
+  obj->VisitReferences<kMovingClasses>(visitor, VoidFunctor());
+  return holds_reference;
+}
+
+class AddReferenceHolderVisitor {
+ public:
+  AddReferenceHolderVisitor(const ModUnionTableReferenceBitmap* mod_union_table,
+                            ContinuousSpaceBitmap* reference_holders)
+    : mod_union_table_(mod_union_table), reference_holders_(reference_holders) {
+  }
+
+  void operator()(Object* obj) const
+      SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_) {
+    if (HoldsReference(mod_union_table_, obj)) {
+      reference_holders_->Set(obj);
+    }
+  }
+
+ private:
+  const ModUnionTableReferenceBitmap* const mod_union_table_;
+  ContinuousSpaceBitmap* const reference_holders_;
+};
+
+class UpdateReferenceHoldersVisitor {
+ public:
+  UpdateReferenceHoldersVisitor(const ModUnionTableReferenceBitmap* mod_union_table,
+                                ContinuousSpaceBitmap* live_bitmap,
+                                ContinuousSpaceBitmap* reference_holders)
+    : live_bitmap_(live_bitmap), reference_holders_(reference_holders),
+      add_visitor_(mod_union_table, reference_holders) {
+  }
+
+  // Called with the begin of each cleared card. The write barrier dirties the card of the object
+  // header, so the objects which may have changed start in the cleared cards.
+  void operator()(Object* card_begin) const
+      SHARED_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_) {
+    uintptr_t start = reinterpret_cast<uintptr_t>(card_begin);
+    uintptr_t end = start + CardTable::kCardSize;
+    reference_holders_->VisitMarkedRange(start, end,
+                                         ContinuousSpaceBitmap::ClearVisitor(reference_holders_));
+    live_bitmap_->VisitMarkedRange(start, end, add_visitor_);
+  }
+
+ private:
+  ContinuousSpaceBitmap* const live_bitmap_;
+  ContinuousSpaceBitmap* const reference_holders_;
+  const AddReferenceHolderVisitor add_visitor_;
+};
+
+class ModUnionMarkHeldReferencesVisitor {
+ public:
+  ModUnionMarkHeldReferencesVisitor(const ModUnionTableReferenceBitmap* mod_union_table,
+                                    MarkHeapReferenceCallback* callback, void* arg)
+    : mod_union_table_(mod_union_table), callback_(callback), arg_(arg) {
+  }
+
+  void operator()(Object* obj) const
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    obj->VisitReferences<kMovingClasses>(*this, VoidFunctor());
+  }
+
+  void operator()(Object* obj, MemberOffset offset, bool /*is_static*/) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    mirror::HeapReference<Object>* obj_ptr = obj->GetFieldObjectReferenceAddr(offset);
+    mirror::Object* ref = obj_ptr->AsMirrorPtr();
+    if (ref != nullptr && mod_union_table_->ShouldAddReference(ref)) {
+      callback_(obj_ptr, arg_);
+    }
+  }
+
+ private:
+  const ModUnionTableReferenceBitmap* const mod_union_table_;
+  MarkHeapReferenceCallback* const callback_;
+  void* const arg_;
+};
+
+void ModUnionTableReferenceBitmap::UpdateAndMarkReferences(MarkHeapReferenceCallback* callback,
+                                                           void* arg) {
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(space_->Begin());
+  const uintptr_t end = reinterpret_cast<uintptr_t>(space_->End());
+  UpdateReferenceHoldersVisitor update_visitor(this, space_->GetLiveBitmap(),
+                                               reference_holders_.get());
+  cleared_cards_->VisitMarkedRange(begin, end, update_visitor);
+  cleared_cards_->Clear();
+  ModUnionMarkHeldReferencesVisitor mark_visitor(this, callback, arg);
+  reference_holders_->VisitMarkedRange(begin, end, mark_visitor);
+}
+
+class ModUnionCheckReferenceHolders {
+ public:
+  ModUnionCheckReferenceHolders(ModUnionTableReferenceBitmap* mod_union_table,
+                                CardTable* card_table, const CardBitmap* cleared_cards,
+                                const ContinuousSpaceBitmap* reference_holders)
+    : mod_union_table_(mod_union_table), card_table_(card_table), cleared_cards_(cleared_cards),
+      reference_holders_(reference_holders) {
+  }
+
+  void operator()(Object* obj) const NO_THREAD_SAFETY_ANALYSIS {
+    Locks::heap_bitmap_lock_->AssertSharedHeld(Thread::Current());
+    if (reference_holders_->Test(obj)) {
+      obj->VisitReferences<kMovingClasses>(*this, VoidFunctor());
+    } else if (card_table_->GetCard(obj) == CardTable::kCardClean &&
+               !cleared_cards_->Test(reinterpret_cast<Object*>(
+                   RoundDown(reinterpret_cast<uintptr_t>(obj), CardTable::kCardSize)))) {
+      // The object didn't change since its card was last scanned.
+      CHECK(!HoldsReference(mod_union_table_, obj))
+          << "Object " << reinterpret_cast<const void*>(obj) << "(" << PrettyTypeOf(obj)
+          << ") references another space without being in " << mod_union_table_->GetName();
+    }
+  }
+
+  void operator()(Object* obj, MemberOffset offset, bool /*is_static*/) const
+      NO_THREAD_SAFETY_ANALYSIS {
+    mirror::Object* ref = obj->GetFieldObject<mirror::Object>(offset);
+    if (ref != nullptr && mod_union_table_->ShouldAddReference(ref)) {
+      CHECK(mod_union_table_->GetHeap()->IsLiveObjectLocked(ref));
+    }
+  }
+
+ private:
+  ModUnionTableReferenceBitmap* const mod_union_table_;
+  CardTable* const card_table_;
+  const CardBitmap* const cleared_cards_;
+  const ContinuousSpaceBitmap* const reference_holders_;
+};
+
+void ModUnionTableReferenceBitmap::Verify() {
+  ModUnionCheckReferenceHolders visitor(this, heap_->GetCardTable(), cleared_cards_.get(),
+                                        reference_holders_.get());
+  space_->GetLiveBitmap()->VisitMarkedRange(reinterpret_cast<uintptr_t>(space_->Begin()),
+                                            reinterpret_cast<uintptr_t>(space_->End()), visitor);
+}
+
+class ModUnionDumpAddressVisitor {
+ public:
+  explicit ModUnionDumpAddressVisitor(std::ostream* os) : os_(os) {
+  }
+
+  void operator()(Object* obj) const {
+    *os_ << reinterpret_cast<const void*>(obj) << ",";
+  }
+
+ private:
+  std::ostream* const os_;
+};
+
+void ModUnionTableReferenceBitmap::Dump(std::ostream& os) {
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(space_->Begin());
+  const uintptr_t end = reinterpret_cast<uintptr_t>(space_->End());
+  ModUnionDumpAddressVisitor visitor(&os);
+  os << "ModUnionTable cleared cards: [";
+  cleared_cards_->VisitMarkedRange(begin, end, visitor);
+  os << "]\nModUnionTable reference holders: [";
+  reference_holders_->VisitMarkedRange(begin, end, visitor);
+  os << "]";
+}
+
 }  // namespace accounting
 }  // namespace gc
 }  // namespace art
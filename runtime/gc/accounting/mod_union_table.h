@@ -17,11 +17,14 @@
 #ifndef ART_RUNTIME_GC_ACCOUNTING_MOD_UNION_TABLE_H_
 #define ART_RUNTIME_GC_ACCOUNTING_MOD_UNION_TABLE_H_
 
+#include "card_table.h"
 #include "gc_allocator.h"
 #include "globals.h"
 #include "object_callbacks.h"
 #include "safe_map.h"
+#include "space_bitmap.h"
 
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -46,6 +49,9 @@ namespace accounting {
 
 class HeapBitmap;
 
+// A bitmap with one bit per card.
+typedef SpaceBitmap<CardTable::kCardSize> CardBitmap;
+
 // The mod-union table is the union of modified cards. It is used to allow the card table to be
 // cleared between GC phases, reducing the number of dirty cards that need to be scanned.
 class ModUnionTable {
@@ -155,6 +161,48 @@ class ModUnionTableCardCache : public ModUnionTable {
   CardSet cleared_cards_;
 };
 
+// Bitmap implementation. Instead of a set of cards and the references of each card, keeps a bitmap
+// of the cards cleared since the last update and a bitmap of the live objects of the space which
+// reference other spaces. Both are walked like the live bitmaps, and an update only rescans the
+// cleared cards.
+class ModUnionTableReferenceBitmap : public ModUnionTable {
+ public:
+  explicit ModUnionTableReferenceBitmap(const std::string& name, Heap* heap,
+                                        space::ContinuousSpace* space);
+  virtual ~ModUnionTableReferenceBitmap() {}
+
+  // Clear and store cards for a space.
+  void ClearCards();
+
+  // Update the reference holders of the cleared cards and mark all the references they hold to
+  // the other spaces.
+  void UpdateAndMarkReferences(MarkHeapReferenceCallback* callback, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+
+  // Exclusive lock is required since verify uses SpaceBitmap::VisitMarkedRange and
+  // VisitMarkedRange can't know if the callback will modify the bitmap or not.
+  void Verify()
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+
+  // Returns whether the table marks the reference. References within the space and to the image
+  // space don't need to be marked.
+  bool ShouldAddReference(const mirror::Object* ref) const;
+
+  void Dump(std::ostream& os) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+ protected:
+  // The image space, or null if there is none.
+  space::ContinuousSpace* const image_space_;
+
+  // Cards of the space cleared since the last update.
+  std::unique_ptr<CardBitmap> cleared_cards_;
+
+  // Live objects of the space which reference objects the table marks.
+  std::unique_ptr<ContinuousSpaceBitmap> reference_holders_;
+};
+
 }  // namespace accounting
 }  // namespace gc
 }  // namespace art
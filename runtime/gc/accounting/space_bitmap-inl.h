@@ -121,18 +121,18 @@ inline void SpaceBitmap<kAlignment>::VisitMarkedRange(uintptr_t visit_begin, uin
       } while (left_edge != 0);
     }
 
-    // Traverse the middle, full part.
-    for (size_t i = index_start + 1; i < index_end; ++i) {
+    // Traverse the middle, full part. Each word is read once the previous ones are visited, so
+    // that the bits set by the visitor ahead of the traversal are seen.
+    for (size_t i = FindNonZeroWord(bitmap_begin_, index_start + 1, index_end); i < index_end;
+         i = FindNonZeroWord(bitmap_begin_, i + 1, index_end)) {
       uword w = bitmap_begin_[i];
-      if (w != 0) {
-        const uintptr_t ptr_base = IndexToOffset(i) + heap_begin_;
-        do {
-          const size_t shift = CTZ(w);
-          mirror::Object* obj = reinterpret_cast<mirror::Object*>(ptr_base + shift * kAlignment);
-          visitor(obj);
-          w ^= (static_cast<uword>(1)) << shift;
-        } while (w != 0);
-      }
+      const uintptr_t ptr_base = IndexToOffset(i) + heap_begin_;
+      do {
+        const size_t shift = CTZ(w);
+        mirror::Object* obj = reinterpret_cast<mirror::Object*>(ptr_base + shift * kAlignment);
+        visitor(obj);
+        w ^= (static_cast<uword>(1)) << shift;
+      } while (w != 0);
     }
 
     // Right edge is unique.
@@ -162,6 +162,59 @@ inline void SpaceBitmap<kAlignment>::VisitMarkedRange(uintptr_t visit_begin, uin
 #endif
 }
 
+template<size_t kAlignment>
+inline size_t SpaceBitmap<kAlignment>::FindNonZeroWord(const uword* words, size_t begin,
+                                                       size_t end) {
+  static constexpr size_t kWordsPerGroup = 4;
+  size_t i = begin;
+  // Test a group of words with a single branch, as most words of a sparse bitmap are zero.
+  for (; i + kWordsPerGroup <= end; i += kWordsPerGroup) {
+    if ((words[i] | words[i + 1] | words[i + 2] | words[i + 3]) != 0) {
+      break;
+    }
+  }
+  while (i < end && words[i] == 0) {
+    ++i;
+  }
+  return i;
+}
+
+// Collects the objects visited by VisitMarkedRange into batches for a batch visitor.
+template<typename BatchVisitor>
+class BatchCollector {
+ public:
+  BatchCollector(mirror::Object** batch, size_t batch_size, size_t* count,
+                 const BatchVisitor& visitor)
+      : batch_(batch), batch_size_(batch_size), count_(count), visitor_(visitor) {}
+
+  void operator()(mirror::Object* obj) const {
+    batch_[(*count_)++] = obj;
+    if (*count_ == batch_size_) {
+      visitor_(batch_, batch_size_);
+      *count_ = 0;
+    }
+  }
+
+ private:
+  mirror::Object** const batch_;
+  const size_t batch_size_;
+  size_t* const count_;
+  const BatchVisitor& visitor_;
+};
+
+template<size_t kAlignment> template<typename BatchVisitor>
+inline void SpaceBitmap<kAlignment>::VisitMarkedRangeInBatches(uintptr_t visit_begin,
+                                                               uintptr_t visit_end,
+                                                               const BatchVisitor& visitor) const {
+  mirror::Object* batch[kVisitBatchSize];
+  size_t count = 0;
+  VisitMarkedRange(visit_begin, visit_end,
+                   BatchCollector<BatchVisitor>(batch, kVisitBatchSize, &count, visitor));
+  if (count != 0) {
+    visitor(batch, count);
+  }
+}
+
 template<size_t kAlignment> template<bool kSetBit>
 inline bool SpaceBitmap<kAlignment>::Modify(const mirror::Object* obj) {
   uintptr_t addr = reinterpret_cast<uintptr_t>(obj);
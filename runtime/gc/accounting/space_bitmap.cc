@@ -16,6 +16,8 @@
 
 #include "space_bitmap-inl.h"
 
+#include "card_table.h"
+
 namespace art {
 namespace gc {
 namespace accounting {
@@ -88,25 +90,33 @@ void SpaceBitmap<kAlignment>::CopyFrom(SpaceBitmap* source_bitmap) {
   std::copy(source_bitmap->Begin(), source_bitmap->Begin() + source_bitmap->Size() / kWordSize, Begin());
 }
 
+// Prefetches each batch of objects before passing them to the callback of a walk.
+class WalkBatchVisitor {
+ public:
+  WalkBatchVisitor(ObjectCallback* callback, void* arg) : callback_(callback), arg_(arg) {}
+
+  void operator()(mirror::Object** objects, size_t count) const {
+    for (size_t i = 0; i < count; ++i) {
+      __builtin_prefetch(objects[i]);
+    }
+    for (size_t i = 0; i < count; ++i) {
+      (*callback_)(objects[i], arg_);
+    }
+  }
+
+ private:
+  ObjectCallback* const callback_;
+  void* const arg_;
+};
+
 template<size_t kAlignment>
 void SpaceBitmap<kAlignment>::Walk(ObjectCallback* callback, void* arg) {
   CHECK(bitmap_begin_ != NULL);
   CHECK(callback != NULL);
 
-  uintptr_t end = OffsetToIndex(HeapLimit() - heap_begin_ - 1);
-  uword* bitmap_begin = bitmap_begin_;
-  for (uintptr_t i = 0; i <= end; ++i) {
-    uword w = bitmap_begin[i];
-    if (w != 0) {
-      uintptr_t ptr_base = IndexToOffset(i) + heap_begin_;
-      do {
-        const size_t shift = CTZ(w);
-        mirror::Object* obj = reinterpret_cast<mirror::Object*>(ptr_base + shift * kAlignment);
-        (*callback)(obj, arg);
-        w ^= (static_cast<uword>(1)) << shift;
-      } while (w != 0);
-    }
-  }
+  // The callback doesn't change the bits, so the objects can be visited in batches.
+  VisitMarkedRangeInBatches(heap_begin_, static_cast<uintptr_t>(HeapLimit()),
+                            WalkBatchVisitor(callback, arg));
 }
 
 template<size_t kAlignment>
@@ -249,6 +259,8 @@ void SpaceBitmap<kAlignment>::InOrderWalk(ObjectCallback* callback, void* arg) {
 
 template class SpaceBitmap<kObjectAlignment>;
 template class SpaceBitmap<kPageSize>;
+template class SpaceBitmap<kRelocationAlignment>;
+template class SpaceBitmap<CardTable::kCardSize>;
 
 }  // namespace accounting
 }  // namespace gc
@@ -91,6 +91,12 @@ class SpaceBitmap {
 
   bool Test(const mirror::Object* obj) const;
 
+  // Prefetch the bitmap word which holds the bit of obj, for a later Set or Test.
+  void PrefetchWord(const mirror::Object* obj) const ALWAYS_INLINE {
+    const uintptr_t offset = reinterpret_cast<uintptr_t>(obj) - heap_begin_;
+    __builtin_prefetch(&bitmap_begin_[OffsetToIndex(offset)]);
+  }
+
   // Return true iff <obj> is within the range of pointers that this bitmap could potentially cover,
   // even if a bit has not been set for it.
   bool HasAddress(const void* obj) const {
@@ -130,6 +136,17 @@ class SpaceBitmap {
   void VisitMarkedRange(uintptr_t visit_begin, uintptr_t visit_end, const Visitor& visitor) const
       NO_THREAD_SAFETY_ANALYSIS;
 
+  // Maximum number of objects passed to the visitor of VisitMarkedRangeInBatches at once.
+  static constexpr size_t kVisitBatchSize = 16;
+
+  // Visit the live objects in the range [visit_begin, visit_end) in address order, calling
+  // visitor(objects, count) with up to kVisitBatchSize of them at a time so that it can prefetch
+  // a batch before visiting it. The bits set by the visitor during the traversal may not be seen.
+  template <typename BatchVisitor>
+  void VisitMarkedRangeInBatches(uintptr_t visit_begin, uintptr_t visit_end,
+                                 const BatchVisitor& visitor) const
+      NO_THREAD_SAFETY_ANALYSIS;
+
   // Visits set bits in address order.  The callback is not permitted to change the bitmap bits or
   // max during the traversal.
   void Walk(ObjectCallback* callback, void* arg)
@@ -207,6 +224,10 @@ class SpaceBitmap {
   template<bool kSetBit>
   bool Modify(const mirror::Object* obj);
 
+  // Returns the index of the first non-zero word in [begin, end) of words, or end. The runs of
+  // zero words of sparse bitmaps are skipped several words at a time.
+  static size_t FindNonZeroWord(const uword* words, size_t begin, size_t end);
+
   // For an unvisited object, visit it then all its children found via fields.
   static void WalkFieldsInOrder(SpaceBitmap* visited, ObjectCallback* callback, mirror::Object* obj,
                                 void* arg) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -235,6 +256,7 @@ class SpaceBitmap {
 
 typedef SpaceBitmap<kObjectAlignment> ContinuousSpaceBitmap;
 typedef SpaceBitmap<kLargeObjectAlignment> LargeObjectBitmap;
+typedef SpaceBitmap<kRelocationAlignment> RelocationBitmap;
 
 template<size_t kAlignment>
 std::ostream& operator << (std::ostream& stream, const SpaceBitmap<kAlignment>& bitmap);
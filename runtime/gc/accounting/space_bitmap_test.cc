@@ -98,6 +98,25 @@ class SimpleCounter {
   size_t* count_;
 };
 
+class BatchCounter {
+ public:
+  BatchCounter(size_t* count, uintptr_t* last) : count_(count), last_(last) {}
+
+  void operator()(mirror::Object** objects, size_t count) const {
+    EXPECT_GT(count, 0U);
+    EXPECT_LE(count, static_cast<size_t>(ContinuousSpaceBitmap::kVisitBatchSize));
+    for (size_t i = 0; i < count; ++i) {
+      uintptr_t addr = reinterpret_cast<uintptr_t>(objects[i]);
+      EXPECT_LT(*last_, addr);
+      *last_ = addr;
+    }
+    *count_ += count;
+  }
+
+  size_t* count_;
+  uintptr_t* last_;
+};
+
 class RandGen {
  public:
   explicit RandGen(uint32_t seed) : val_(seed) {}
@@ -153,6 +172,13 @@ void RunTest() NO_THREAD_SAFETY_ANALYSIS {
       }
 
       EXPECT_EQ(count, manual);
+
+      size_t batched_count = 0;
+      uintptr_t last = 0;
+      space_bitmap->VisitMarkedRangeInBatches(reinterpret_cast<uintptr_t>(heap_begin) + offset,
+                                              reinterpret_cast<uintptr_t>(heap_begin) + end,
+                                              BatchCounter(&batched_count, &last));
+      EXPECT_EQ(batched_count, manual);
     }
   }
 }
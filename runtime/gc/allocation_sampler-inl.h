@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_ALLOCATION_SAMPLER_INL_H_
+#define ART_RUNTIME_GC_ALLOCATION_SAMPLER_INL_H_
+
+#include "allocation_sampler.h"
+
+#include "thread.h"
+
+namespace art {
+namespace gc {
+
+inline void AllocationSampler::RecordAllocation(Thread* self, size_t byte_count) {
+  // Only count down the thread local bytes until the next sample, this avoids any shared state on
+  // the common path.
+  const size_t remaining = self->GetAllocationSampleBytesRemaining();
+  if (LIKELY(remaining > byte_count)) {
+    self->SetAllocationSampleBytesRemaining(remaining - byte_count);
+    return;
+  }
+  SampleAllocation(self, byte_count);
+}
+
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_ALLOCATION_SAMPLER_INL_H_
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "allocation_sampler.h"
+
+#include <algorithm>
+
+#include "allocation_sampler-inl.h"
+#include "dex_file.h"
+#include "instrumentation.h"
+#include "mirror/art_method-inl.h"
+#include "object_utils.h"
+#include "runtime.h"
+#include "stack.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+namespace gc {
+
+class SampleStackVisitor : public StackVisitor {
+ public:
+  SampleStackVisitor(Thread* thread, AllocationSampler::CallStack* stack,
+                     std::vector<mirror::ArtMethod*>* methods)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      : StackVisitor(thread, nullptr), stack_(stack), methods_(methods) {}
+
+  // TODO: Enable annotalysis. We know lock is held in constructor, but abstraction confuses
+  // annotalysis.
+  bool VisitFrame() NO_THREAD_SAFETY_ANALYSIS {
+    if (stack_->size() >= AllocationSampler::kMaxStackDepth) {
+      return false;
+    }
+    mirror::ArtMethod* m = GetMethod();
+    if (!m->IsRuntimeMethod()) {
+      AllocationSampler::Frame frame;
+      frame.dex_file = &MethodHelper(m).GetDexFile();
+      frame.method_idx = m->GetDexMethodIndex();
+      frame.dex_pc = GetDexPc();
+      stack_->push_back(frame);
+      methods_->push_back(m);
+    }
+    return true;
+  }
+
+ private:
+  AllocationSampler::CallStack* const stack_;
+  std::vector<mirror::ArtMethod*>* const methods_;
+};
+
+AllocationSampler::AllocationSampler()
+    : lock_("allocation sampler lock"),
+      enabled_(false),
+      sampling_interval_(kDefaultSamplingInterval),
+      sample_count_(0) {
+}
+
+void AllocationSampler::Start(size_t sampling_interval) {
+  CHECK_GT(sampling_interval, 0U);
+  Thread* self = Thread::Current();
+  {
+    MutexLock mu(self, lock_);
+    if (enabled_) {
+      return;
+    }
+    sampling_interval_ = sampling_interval;
+    sample_count_ = 0;
+    sites_.clear();
+  }
+  // The uninstrumented allocation paths check that the sampler is disabled, so only enable it
+  // once every thread uses the instrumented entrypoints.
+  Runtime::Current()->GetInstrumentation()->InstrumentQuickAllocEntryPoints();
+  {
+    MutexLock mu(self, lock_);
+    enabled_ = true;
+  }
+  LOG(INFO) << "Started allocation sampling every " << PrettySize(sampling_interval);
+}
+
+void AllocationSampler::Stop() {
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    if (!enabled_) {
+      return;
+    }
+    enabled_ = false;
+  }
+  Runtime::Current()->GetInstrumentation()->UninstrumentQuickAllocEntryPoints();
+}
+
+void AllocationSampler::SampleAllocation(Thread* self, size_t byte_count) {
+  const bool first_countdown = self->GetAllocationSampleBytesRemaining() == 0;
+  size_t sampling_interval;
+  {
+    MutexLock mu(self, lock_);
+    sampling_interval = sampling_interval_;
+  }
+  self->SetAllocationSampleBytesRemaining(sampling_interval);
+  if (first_countdown) {
+    // The thread hasn't started counting down yet, sampling its first allocation would
+    // overrepresent code which runs early in a thread.
+    return;
+  }
+  // Walk the stack before taking the lock, it is the expensive part of a sample.
+  CallStack stack;
+  std::vector<mirror::ArtMethod*> methods;
+  SampleStackVisitor visitor(self, &stack, &methods);
+  visitor.WalkStack();
+  MutexLock mu(self, lock_);
+  if (!enabled_) {
+    return;
+  }
+  ++sample_count_;
+  auto it = sites_.find(stack);
+  if (it == sites_.end()) {
+    SiteStats stats;
+    for (size_t i = 0; i < methods.size(); ++i) {
+      MethodHelper mh(methods[i]);
+      stats.line_numbers.push_back(mh.GetLineNumFromDexPC(stack[i].dex_pc));
+    }
+    sites_.Put(stack, stats);
+    it = sites_.find(stack);
+  }
+  ++it->second.samples;
+  it->second.sampled_bytes += byte_count;
+}
+
+void AllocationSampler::Dump(std::ostream& os) {
+  MutexLock mu(Thread::Current(), lock_);
+  os << "Allocation samples (one every " << PrettySize(sampling_interval_) << "): "
+     << sample_count_ << " samples from " << sites_.size() << " call sites\n";
+  std::vector<std::pair<uint64_t, const CallStack*>> sorted_sites;
+  sorted_sites.reserve(sites_.size());
+  for (const auto& site : sites_) {
+    sorted_sites.push_back(std::make_pair(site.second.samples, &site.first));
+  }
+  std::sort(sorted_sites.begin(), sorted_sites.end(),
+            [](const std::pair<uint64_t, const CallStack*>& a,
+               const std::pair<uint64_t, const CallStack*>& b) {
+              return a.first > b.first;
+            });
+  const size_t num_dumped = std::min(sorted_sites.size(), kMaxDumpedSites);
+  for (size_t i = 0; i < num_dumped; ++i) {
+    const CallStack& stack = *sorted_sites[i].second;
+    const SiteStats& stats = sites_.Get(stack);
+    // Each sample accounts for a sampling interval of allocated bytes.
+    os << "  " << stats.samples << " samples (~" << PrettySize(stats.samples * sampling_interval_)
+       << " allocated, " << PrettySize(stats.sampled_bytes) << " sampled)\n";
+    if (stack.empty()) {
+      os << "    (no managed frames)\n";
+    }
+    for (size_t j = 0; j < stack.size(); ++j) {
+      const Frame& frame = stack[j];
+      os << "    at " << PrettyMethod(frame.method_idx, *frame.dex_file, false);
+      if (j < stats.line_numbers.size() && stats.line_numbers[j] >= 0) {
+        os << " (line " << stats.line_numbers[j] << ")";
+      }
+      os << "\n";
+    }
+  }
+}
+
+uint64_t AllocationSampler::GetSampleCount() {
+  MutexLock mu(Thread::Current(), lock_);
+  return sample_count_;
+}
+
+size_t AllocationSampler::GetSiteCount() {
+  MutexLock mu(Thread::Current(), lock_);
+  return sites_.size();
+}
+
+}  // namespace gc
+}  // namespace art
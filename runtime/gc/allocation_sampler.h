@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_ALLOCATION_SAMPLER_H_
+#define ART_RUNTIME_GC_ALLOCATION_SAMPLER_H_
+
+#include <ostream>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "globals.h"
+#include "safe_map.h"
+
+namespace art {
+
+class DexFile;
+class Thread;
+
+namespace gc {
+
+// Samples one allocation every sampling interval bytes of each thread and aggregates the sampled
+// allocations by the call stack which made them. Only the instrumented allocation paths are
+// sampled, so starting the sampler instruments the quick alloc entrypoints. The sampled stacks
+// only keep dex file locations, they don't need to be updated by the GC.
+class AllocationSampler {
+ public:
+  // Default number of bytes a thread allocates between two samples.
+  static constexpr size_t kDefaultSamplingInterval = 512 * KB;
+  // Maximum number of frames recorded for a sampled allocation.
+  static constexpr size_t kMaxStackDepth = 8;
+  // Maximum number of call sites printed by Dump.
+  static constexpr size_t kMaxDumpedSites = 32;
+
+  AllocationSampler();
+
+  // Start sampling an allocation every sampling_interval bytes, clears the previous samples.
+  void Start(size_t sampling_interval)
+      LOCKS_EXCLUDED(Locks::mutator_lock_, Locks::thread_list_lock_, lock_);
+  void Stop() LOCKS_EXCLUDED(Locks::mutator_lock_, Locks::thread_list_lock_, lock_);
+  bool IsEnabled() const {
+    return enabled_;
+  }
+
+  // Called for every instrumented allocation while the sampler is enabled.
+  ALWAYS_INLINE void RecordAllocation(Thread* self, size_t byte_count)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  // Dump the sampled call sites, the ones with the most samples first.
+  void Dump(std::ostream& os) LOCKS_EXCLUDED(lock_);
+
+  uint64_t GetSampleCount() LOCKS_EXCLUDED(lock_);
+  size_t GetSiteCount() LOCKS_EXCLUDED(lock_);
+
+ private:
+  // A frame of a sampled call stack.
+  struct Frame {
+    const DexFile* dex_file;
+    uint32_t method_idx;
+    uint32_t dex_pc;
+
+    bool operator<(const Frame& other) const {
+      if (dex_file != other.dex_file) {
+        return dex_file < other.dex_file;
+      }
+      if (method_idx != other.method_idx) {
+        return method_idx < other.method_idx;
+      }
+      return dex_pc < other.dex_pc;
+    }
+  };
+
+  struct SiteStats {
+    SiteStats() : samples(0), sampled_bytes(0) {}
+
+    // The number of sampled allocations made from the site.
+    uint64_t samples;
+    // The total size of the sampled allocations.
+    uint64_t sampled_bytes;
+    // The line number of each frame, computed when the site is first sampled.
+    std::vector<int32_t> line_numbers;
+  };
+
+  typedef std::vector<Frame> CallStack;
+
+  // Take a sample of the current allocation and reset the thread's countdown.
+  void SampleAllocation(Thread* self, size_t byte_count)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  volatile bool enabled_;
+  size_t sampling_interval_ GUARDED_BY(lock_);
+  uint64_t sample_count_ GUARDED_BY(lock_);
+  SafeMap<CallStack, SiteStats> sites_ GUARDED_BY(lock_);
+
+  friend class SampleStackVisitor;
+  DISALLOW_COPY_AND_ASSIGN(AllocationSampler);
+};
+
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_ALLOCATION_SAMPLER_H_
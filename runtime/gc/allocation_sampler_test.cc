@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "allocation_sampler.h"
+
+#include <sstream>
+
+#include "common_runtime_test.h"
+#include "gc/heap.h"
+#include "mirror/string.h"
+#include "scoped_thread_state_change.h"
+
+namespace art {
+namespace gc {
+
+class AllocationSamplerTest : public CommonRuntimeTest {};
+
+TEST_F(AllocationSamplerTest, SampleAllocations) {
+  AllocationSampler* sampler = Runtime::Current()->GetHeap()->GetAllocationSampler();
+  EXPECT_FALSE(sampler->IsEnabled());
+  sampler->Start(4 * KB);
+  EXPECT_TRUE(sampler->IsEnabled());
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    // Each string is at least 16 bytes, so 4096 of them take more than ten samples.
+    for (size_t i = 0; i < 4096; ++i) {
+      ASSERT_TRUE(mirror::String::AllocFromModifiedUtf8(soa.Self(), "hello, world!") != nullptr);
+    }
+  }
+  EXPECT_GE(sampler->GetSampleCount(), 10U);
+  // The test has no managed frames, all the samples come from the same call stack.
+  EXPECT_EQ(1U, sampler->GetSiteCount());
+  std::ostringstream oss;
+  sampler->Dump(oss);
+  EXPECT_NE(std::string::npos, oss.str().find("no managed frames"));
+  sampler->Stop();
+  EXPECT_FALSE(sampler->IsEnabled());
+  const uint64_t sample_count = sampler->GetSampleCount();
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    for (size_t i = 0; i < 1024; ++i) {
+      ASSERT_TRUE(mirror::String::AllocFromModifiedUtf8(soa.Self(), "hello, world!") != nullptr);
+    }
+  }
+  EXPECT_EQ(sample_count, sampler->GetSampleCount());
+}
+
+}  // namespace gc
+}  // namespace art
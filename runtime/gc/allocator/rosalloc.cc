@@ -72,6 +72,8 @@ RosAlloc::RosAlloc(void* base, size_t capacity, size_t max_capacity,
         StringPrintf("an rosalloc size bracket %d lock", static_cast<int>(i));
     size_bracket_locks_[i] = new Mutex(size_bracket_lock_names[i].c_str(), kRosAllocBracketLock);
     current_runs_[i] = dedicated_full_run_;
+    is_thread_local_size_bracket_[i] = i < kNumDefaultThreadLocalSizeBrackets;
+    bracket_alloc_counts_[i] = 0;
   }
   DCHECK_EQ(footprint_, capacity_);
   size_t num_of_pages = footprint_ / kPageSize;
@@ -529,10 +531,26 @@ size_t RosAlloc::FreeInternal(Thread* self, void* ptr) {
 }
 
 size_t RosAlloc::Free(Thread* self, void* ptr) {
-  ReaderMutexLock rmu(self, bulk_free_lock_);
+  WriterMutexLock wmu(self, bulk_free_lock_);
   return FreeInternal(self, ptr);
 }
 
+void* RosAlloc::AlignDownToRunBoundary(void* addr) {
+  byte* byte_addr = reinterpret_cast<byte*>(addr);
+  DCHECK_LE(base_, byte_addr);
+  MutexLock mu(Thread::Current(), lock_);
+  if (byte_addr >= base_ + footprint_) {
+    // Nothing is allocated past the footprint.
+    return AlignDown(byte_addr, kPageSize);
+  }
+  size_t pm_idx = RoundDownToPageMapIndex(byte_addr);
+  while (pm_idx > 0 && (page_map_[pm_idx] == kPageMapRunPart ||
+                        page_map_[pm_idx] == kPageMapLargeObjectPart)) {
+    --pm_idx;
+  }
+  return base_ + pm_idx * kPageSize;
+}
+
 RosAlloc::Run* RosAlloc::AllocRun(Thread* self, size_t idx) {
   RosAlloc::Run* new_run = nullptr;
   {
@@ -548,7 +566,7 @@ RosAlloc::Run* RosAlloc::AllocRun(Thread* self, size_t idx) {
     DCHECK(!new_run->IsThreadLocal());
     DCHECK_EQ(new_run->first_search_vec_idx_, 0U);
     DCHECK(!new_run->to_be_bulk_freed_);
-    if (kUsePrefetchDuringAllocRun && idx < kNumThreadLocalSizeBrackets) {
+    if (kUsePrefetchDuringAllocRun && IsThreadLocalSizeBracket(idx)) {
       // Take ownership of the cache lines if we are likely to be thread local run.
       if (kPrefetchNewRunDataByZeroing) {
         // Zeroing the data is sometimes faster than prefetching but it increases memory usage
@@ -650,7 +668,7 @@ void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated)
 
   void* slot_addr;
 
-  if (LIKELY(idx < kNumThreadLocalSizeBrackets)) {
+  if (LIKELY(IsThreadLocalSizeBracket(idx))) {
     // Use a thread-local run.
     Run* thread_local_run = reinterpret_cast<Run*>(self->GetRosAllocRun(idx));
     // Allow invalid since this will always fail the allocation.
@@ -703,6 +721,7 @@ void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated)
           self->SetRosAllocRun(idx, dedicated_full_run_);
           return nullptr;
         }
+        bracket_alloc_counts_[idx] += numOfSlots[idx];
         DCHECK(non_full_runs_[idx].find(thread_local_run) == non_full_runs_[idx].end());
         DCHECK(full_runs_[idx].find(thread_local_run) == full_runs_[idx].end());
         thread_local_run->SetIsThreadLocal(true);
@@ -726,6 +745,9 @@ void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated)
     // Use the (shared) current run.
     MutexLock mu(self, *size_bracket_locks_[idx]);
     slot_addr = AllocFromCurrentRunUnlocked(self, idx);
+    if (LIKELY(slot_addr != nullptr)) {
+      ++bracket_alloc_counts_[idx];
+    }
     if (kTraceRosAlloc) {
       LOG(INFO) << "RosAlloc::AllocFromRun() : 0x" << std::hex << reinterpret_cast<intptr_t>(slot_addr)
                 << "-0x" << (reinterpret_cast<intptr_t>(slot_addr) + bracket_size)
@@ -1153,7 +1175,9 @@ size_t RosAlloc::BulkFree(Thread* self, void** ptrs, size_t num_ptrs) {
     return freed_bytes;
   }
 
-  WriterMutexLock wmu(self, bulk_free_lock_);
+  // Concurrent bulk frees are fine as long as they free from disjoint sets of runs, see
+  // AlignDownToRunBoundary().
+  ReaderMutexLock rmu(self, bulk_free_lock_);
 
   // First mark slots to free in the bulk free bit map without locking the
   // size bracket locks. On host, unordered_set is faster than vector + flag.
@@ -1692,9 +1716,9 @@ void RosAlloc::RevokeRun(Thread* self, size_t idx, Run* run) {
 void RosAlloc::RevokeThreadUnsafeCurrentRuns() {
   // Revoke the current runs which share the same idx as thread local runs.
   Thread* self = Thread::Current();
-  for (size_t idx = 0; idx < kNumThreadLocalSizeBrackets; ++idx) {
+  for (size_t idx = 0; idx < kNumOfSizeBrackets; ++idx) {
     MutexLock mu(self, *size_bracket_locks_[idx]);
-    if (current_runs_[idx] != dedicated_full_run_) {
+    if (IsThreadLocalSizeBracket(idx) && current_runs_[idx] != dedicated_full_run_) {
       RevokeRun(self, idx, current_runs_[idx]);
       current_runs_[idx] = dedicated_full_run_;
     }
@@ -1710,9 +1734,36 @@ void RosAlloc::RevokeAllThreadLocalRuns() {
   for (Thread* thread : thread_list) {
     RevokeThreadLocalRuns(thread);
   }
+  if (kAdaptThreadLocalSizeBrackets) {
+    AdaptThreadLocalSizeBrackets();
+  }
   RevokeThreadUnsafeCurrentRuns();
 }
 
+void RosAlloc::AdaptThreadLocalSizeBrackets() {
+  Thread* self = Thread::Current();
+  for (size_t idx = 0; idx < kNumOfSizeBrackets; ++idx) {
+    MutexLock mu(self, *size_bracket_locks_[idx]);
+    if (idx >= kNumDefaultThreadLocalSizeBrackets) {
+      const size_t runs_allocated = bracket_alloc_counts_[idx] / numOfSlots[idx];
+      if (!is_thread_local_size_bracket_[idx] && runs_allocated >= kPromoteThreadLocalRuns) {
+        VLOG(heap) << "RosAlloc size bracket " << bracketSizes[idx] << " uses thread-local runs";
+        is_thread_local_size_bracket_[idx] = true;
+      } else if (is_thread_local_size_bracket_[idx] && runs_allocated < kDemoteThreadLocalRuns) {
+        VLOG(heap) << "RosAlloc size bracket " << bracketSizes[idx] << " uses shared runs";
+        is_thread_local_size_bracket_[idx] = false;
+      }
+    }
+    bracket_alloc_counts_[idx] = 0;
+  }
+}
+
+size_t RosAlloc::GetBracketAllocCount(size_t idx) {
+  DCHECK_LT(idx, kNumOfSizeBrackets);
+  MutexLock mu(Thread::Current(), *size_bracket_locks_[idx]);
+  return bracket_alloc_counts_[idx];
+}
+
 void RosAlloc::AssertThreadLocalRunsAreRevoked(Thread* thread) {
   if (kIsDebugBuild) {
     Thread* self = Thread::Current();
@@ -1735,9 +1786,11 @@ void RosAlloc::AssertAllThreadLocalRunsAreRevoked() {
     for (Thread* t : thread_list) {
       AssertThreadLocalRunsAreRevoked(t);
     }
-    for (size_t idx = 0; idx < kNumThreadLocalSizeBrackets; ++idx) {
+    for (size_t idx = 0; idx < kNumOfSizeBrackets; ++idx) {
       MutexLock mu(self, *size_bracket_locks_[idx]);
-      CHECK_EQ(current_runs_[idx], dedicated_full_run_);
+      if (IsThreadLocalSizeBracket(idx)) {
+        CHECK_EQ(current_runs_[idx], dedicated_full_run_);
+      }
     }
   }
 }
@@ -2088,6 +2141,22 @@ void RosAlloc::Run::Verify(Thread* self, RosAlloc* rosalloc) {
   }
 }
 
+void RosAlloc::GetNextFreePages(size_t max_bytes,
+                                std::vector<std::pair<byte*, byte*>>* ranges) {
+  MutexLock mu(Thread::Current(), lock_);
+  size_t total_bytes = 0;
+  // AllocPages takes the lowest address free page run which is large enough.
+  for (FreePageRun* fpr : free_page_runs_) {
+    if (total_bytes >= max_bytes) {
+      break;
+    }
+    const size_t byte_size = std::min(fpr->ByteSize(this), max_bytes - total_bytes);
+    byte* begin = reinterpret_cast<byte*>(fpr);
+    ranges->push_back(std::make_pair(begin, begin + byte_size));
+    total_bytes += byte_size;
+  }
+}
+
 size_t RosAlloc::ReleasePages() {
   VLOG(heap) << "RosAlloc::ReleasePages()";
   DCHECK(!DoesReleaseAllPages());
@@ -416,9 +416,23 @@ class RosAlloc {
   // The default value for page_release_size_threshold_.
   static constexpr size_t kDefaultPageReleaseSizeThreshold = 4 * MB;
 
-  // We use thread-local runs for the size Brackets whose indexes
-  // are less than this index. We use shared (current) runs for the rest.
-  static const size_t kNumThreadLocalSizeBrackets = 11;
+  // Every size bracket may use thread-local runs, threads have a
+  // thread-local run slot for each of them.
+  static const size_t kNumThreadLocalSizeBrackets = kNumOfSizeBrackets;
+  // We always use thread-local runs for the size brackets whose
+  // indexes are less than this index. The rest use shared (current)
+  // runs unless they are allocated from often enough that a run per
+  // thread pays off, see AdaptThreadLocalSizeBrackets().
+  static const size_t kNumDefaultThreadLocalSizeBrackets = 11;
+  // Whether the size brackets above the default ones switch between
+  // thread-local and shared runs based on their allocation counts.
+  static constexpr bool kAdaptThreadLocalSizeBrackets = true;
+  // A shared bracket becomes thread-local once it allocated at least
+  // this many runs worth of slots since the last adaptation. A
+  // thread-local bracket goes back to shared runs once it refilled
+  // fewer than kDemoteThreadLocalRuns runs.
+  static constexpr size_t kPromoteThreadLocalRuns = 16;
+  static constexpr size_t kDemoteThreadLocalRuns = 4;
 
  private:
   // The base address of the memory region that's managed by this allocator.
@@ -457,6 +471,17 @@ class RosAlloc {
   Mutex* size_bracket_locks_[kNumOfSizeBrackets];
   // Bracket lock names (since locks only have char* names).
   std::string size_bracket_lock_names[kNumOfSizeBrackets];
+  // Whether each size bracket currently uses thread-local runs. Only
+  // changed by AdaptThreadLocalSizeBrackets() while the thread-local
+  // runs are revoked, the allocation fast path reads it without a
+  // lock since either kind of run may serve an allocation.
+  bool is_thread_local_size_bracket_[kNumOfSizeBrackets];
+  // The number of slots allocated from each size bracket since the
+  // last adaptation. Exact for shared brackets, for thread-local
+  // brackets it counts a run worth of slots per refill so that the
+  // allocation fast path isn't slowed down. bracket_alloc_counts_[i]
+  // is guarded by size_bracket_locks_[i].
+  size_t bracket_alloc_counts_[kNumOfSizeBrackets];
   // The types of page map entries.
   enum {
     kPageMapEmpty           = 0,  // Not allocated.
@@ -478,10 +503,11 @@ class RosAlloc {
   // The global lock. Used to guard the page map, the free page set,
   // and the footprint.
   Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
-  // The reader-writer lock to allow one bulk free at a time while
-  // allowing multiple individual frees at the same time. Also, this
-  // is used to avoid race conditions between BulkFree() and
-  // RevokeThreadLocalRuns() on the bulk free bitmaps.
+  // The reader-writer lock to allow multiple bulk frees of disjoint
+  // sets of runs at the same time (the parallel sweep) while keeping
+  // individual frees out of their way. Also, this is used to avoid
+  // race conditions between BulkFree() and RevokeThreadLocalRuns() on
+  // the bulk free bitmaps.
   ReaderWriterMutex bulk_free_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
 
   // The page release mode.
@@ -545,8 +571,15 @@ class RosAlloc {
       LOCKS_EXCLUDED(lock_);
   size_t Free(Thread* self, void* ptr)
       LOCKS_EXCLUDED(bulk_free_lock_);
+  // Multiple threads may bulk free at the same time provided that no
+  // two of them free slots in the same run.
   size_t BulkFree(Thread* self, void** ptrs, size_t num_ptrs)
       LOCKS_EXCLUDED(bulk_free_lock_);
+  // Returns the beginning of the run or large object which contains
+  // addr, or addr rounded down to a page if it is in a free page run.
+  // Used to split a space into ranges which can be bulk freed in
+  // parallel.
+  void* AlignDownToRunBoundary(void* addr) LOCKS_EXCLUDED(lock_);
   // Returns the size of the allocated slot for a given allocated memory chunk.
   size_t UsableSize(void* ptr);
   // Returns the size of the allocated slot for a given size.
@@ -566,6 +599,10 @@ class RosAlloc {
       LOCKS_EXCLUDED(lock_);
   // Release empty pages.
   size_t ReleasePages() LOCKS_EXCLUDED(lock_);
+  // Append to ranges the free page runs that the next page allocations take, lowest address
+  // first, up to max_bytes in total. The pages may be allocated as soon as this returns.
+  void GetNextFreePages(size_t max_bytes, std::vector<std::pair<byte*, byte*>>* ranges)
+      LOCKS_EXCLUDED(lock_);
   // Returns the current footprint.
   size_t Footprint() LOCKS_EXCLUDED(lock_);
   // Returns the current capacity, maximum footprint.
@@ -576,6 +613,17 @@ class RosAlloc {
   void RevokeThreadLocalRuns(Thread* thread);
   // Releases the thread-local runs assigned to all the threads back to the common set of runs.
   void RevokeAllThreadLocalRuns() LOCKS_EXCLUDED(Locks::thread_list_lock_);
+  // Switch the size brackets between thread-local and shared runs
+  // based on their allocation counts and reset the counts. Called
+  // from RevokeAllThreadLocalRuns() once all the runs are revoked.
+  void AdaptThreadLocalSizeBrackets();
+  bool IsThreadLocalSizeBracket(size_t idx) const {
+    DCHECK_LT(idx, kNumOfSizeBrackets);
+    return is_thread_local_size_bracket_[idx];
+  }
+  // Returns the number of slots allocated from the size bracket since
+  // the last adaptation.
+  size_t GetBracketAllocCount(size_t idx);
   // Assert the thread local runs of a thread are revoked.
   void AssertThreadLocalRunsAreRevoked(Thread* thread);
   // Assert all the thread local runs are revoked.
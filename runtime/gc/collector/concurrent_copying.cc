@@ -16,10 +16,589 @@
 
 #include "concurrent_copying.h"
 
+#include "base/logging.h"
+#include "base/mutex-inl.h"
+#include "base/timing_logger.h"
+#include "gc/accounting/atomic_stack.h"
+#include "gc/accounting/heap_bitmap-inl.h"
+#include "gc/accounting/mod_union_table.h"
+#include "gc/accounting/space_bitmap-inl.h"
+#include "gc/heap.h"
+#include "gc/reference_processor.h"
+#include "gc/space/bump_pointer_space.h"
+#include "gc/space/bump_pointer_space-inl.h"
+#include "gc/space/image_space.h"
+#include "gc/space/large_object_space.h"
+#include "gc/space/space-inl.h"
+#include "mirror/art_field-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/object-inl.h"
+#include "mirror/object_array-inl.h"
+#include "mirror/reference-inl.h"
+#include "read_barrier.h"
+#include "runtime.h"
+#include "thread-inl.h"
+#include "thread_list.h"
+
+using ::art::mirror::Object;
+
 namespace art {
 namespace gc {
 namespace collector {
 
+static constexpr bool kProtectFromSpace = true;
+
+ConcurrentCopying::ConcurrentCopying(Heap* heap, bool generational, const std::string& name_prefix)
+    : GarbageCollector(heap,
+                       name_prefix + (name_prefix.empty() ? "" : " ") +
+                       "concurrent copying + mark sweep"),
+      mark_stack_(nullptr),
+      mutator_mark_stack_lock_("concurrent copying mutator mark stack lock",
+                               kMarkSweepMarkStackLock),
+      to_space_(nullptr),
+      from_space_(nullptr),
+      mark_bitmap_(nullptr),
+      self_(nullptr),
+      is_marking_(false),
+      bytes_moved_(0),
+      objects_moved_(0),
+      bytes_wasted_(0) {
+  CHECK(!generational) << "Generational concurrent copying is not supported";
+}
+
+void ConcurrentCopying::RunPhases() {
+  CHECK(kUseBrooksReadBarrier) << "Concurrent copying requires the Brooks read barrier";
+  Thread* self = Thread::Current();
+  InitializePhase();
+  Locks::mutator_lock_->AssertNotHeld(self);
+  {
+    ScopedPause pause(this);
+    GetHeap()->PreGcVerificationPaused(this);
+    FlipPhase();
+  }
+  {
+    ReaderMutexLock mu(self, *Locks::mutator_lock_);
+    CopyingPhase();
+  }
+  {
+    ScopedPause pause(this);
+    GetHeap()->PrePauseRosAllocVerification(this);
+    PausePhase();
+  }
+  {
+    ReaderMutexLock mu(self, *Locks::mutator_lock_);
+    ReclaimPhase();
+  }
+  GetHeap()->PostGcVerification(this);
+  FinishPhase();
+}
+
+void ConcurrentCopying::InitializePhase() {
+  TimingLogger::ScopedSplit split("InitializePhase", &timings_);
+  mark_stack_ = heap_->GetMarkStack();
+  DCHECK(mark_stack_ != nullptr);
+  immune_region_.Reset();
+  bytes_moved_ = 0;
+  objects_moved_ = 0;
+  bytes_wasted_ = 0;
+  self_ = Thread::Current();
+  CHECK(from_space_ != nullptr && to_space_ != nullptr);
+  CHECK(to_space_->IsEmpty()) << "To-space " << *to_space_ << " is not empty";
+  {
+    // TODO: I don't think we should need heap bitmap lock to Get the mark bitmap.
+    ReaderMutexLock mu(self_, *Locks::heap_bitmap_lock_);
+    mark_bitmap_ = heap_->GetMarkBitmap();
+  }
+  if (!clear_soft_references_) {
+    // The whole heap is collected, always clear soft references.
+    clear_soft_references_ = true;
+  }
+}
+
+void ConcurrentCopying::BindBitmaps() {
+  timings_.StartSplit("BindBitmaps");
+  WriterMutexLock mu(self_, *Locks::heap_bitmap_lock_);
+  // Mark all of the spaces we never collect as immune.
+  for (const auto& space : GetHeap()->GetContinuousSpaces()) {
+    if (space->GetGcRetentionPolicy() == space::kGcRetentionPolicyNeverCollect ||
+        space->GetGcRetentionPolicy() == space::kGcRetentionPolicyFullCollect) {
+      CHECK(immune_region_.AddContinuousSpace(space)) << "Failed to add space " << *space;
+    }
+  }
+  timings_.EndSplit();
+}
+
+void ConcurrentCopying::FlipPhase() {
+  TimingLogger::ScopedSplit split("(Paused)FlipPhase", &timings_);
+  Locks::mutator_lock_->AssertExclusiveHeld(self_);
+  // Revoke the thread local buffers so that no mutator keeps allocating into the from-space.
+  RevokeAllThreadLocalBuffers();
+  // From now on the mutators allocate into the to-space, these objects are implicitly live.
+  heap_->SwapSemiSpaces();
+  BindBitmaps();
+  // Process dirty cards and add dirty cards to mod union tables.
+  heap_->ProcessCards(timings_, false);
+  {
+    TimingLogger::ScopedSplit split("SwapStacks", &timings_);
+    WriterMutexLock mu(self_, *Locks::heap_bitmap_lock_);
+    if (kUseThreadLocalAllocationStack) {
+      heap_->RevokeAllThreadLocalAllocationStacks(self_);
+    }
+    heap_->SwapStacks(self_);
+    // The objects allocated in the non-moving spaces before the flip are collected like the rest
+    // of the non-moving spaces.
+    accounting::ObjectStack* live_stack = heap_->GetLiveStack();
+    heap_->MarkAllocStackAsLive(live_stack);
+    live_stack->Reset();
+  }
+  // New system weaks stay allowed, a mutator blocked on inserting one would hold up the final
+  // pause. The entries only hold to-space references once they are swept in the final pause, until
+  // then the system weak tables hand out their entries through ReadBarrier::BarrierForWeakRoot.
+  // Enable the read barrier slow path before the mutators resume.
+  is_marking_ = true;
+  ReadBarrier::SetIsGcMarking(true);
+  MarkRoots();
+}
+
+void ConcurrentCopying::MarkRoots() {
+  timings_.StartSplit("(Paused)MarkRoots");
+  Runtime::Current()->VisitRoots(MarkRootCallback, this);
+  timings_.EndSplit();
+}
+
+void ConcurrentCopying::CopyingPhase() {
+  TimingLogger::ScopedSplit split("CopyingPhase", &timings_);
+  UpdateAndMarkModUnion();
+  ProcessMarkStack();
+}
+
+void ConcurrentCopying::UpdateAndMarkModUnion() {
+  for (const auto& space : heap_->GetContinuousSpaces()) {
+    if (immune_region_.ContainsSpace(space)) {
+      const char* name = space->IsZygoteSpace() ? "UpdateAndMarkZygoteModUnionTable" :
+          "UpdateAndMarkImageModUnionTable";
+      TimingLogger::ScopedSplit split(name, &timings_);
+      accounting::ModUnionTable* mod_union_table = heap_->FindModUnionTableFromSpace(space);
+      CHECK(mod_union_table != nullptr);
+      mod_union_table->UpdateAndMarkReferences(MarkHeapReferenceCallback, this);
+    }
+  }
+}
+
+void ConcurrentCopying::PausePhase() {
+  TimingLogger::ScopedSplit split("(Paused)PausePhase", &timings_);
+  Locks::mutator_lock_->AssertExclusiveHeld(self_);
+  // Gray objects pushed by the mutators after the copying phase drained the mark stacks, and those
+  // still in their mark buffers.
+  RevokeAllThreadMarkBuffers();
+  ProcessMarkStack();
+  {
+    WriterMutexLock mu(self_, *Locks::heap_bitmap_lock_);
+    MarkAllocationStackAsLive();
+  }
+  ProcessReferences(self_);
+  // The mutators are suspended, no system weak is added while sweeping.
+  SweepSystemWeaks(self_);
+  CHECK(mark_stack_->IsEmpty());
+  {
+    MutexLock mu(self_, mutator_mark_stack_lock_);
+    CHECK(mutator_mark_stack_.empty());
+  }
+  // Every reference in the heap and in the roots now points to the to-space or to a non-moving
+  // object, disable the read barrier slow path.
+  ReadBarrier::SetIsGcMarking(false);
+  is_marking_ = false;
+  ReleaseFromSpace();
+  timings_.StartSplit("PreSweepingGcVerification");
+  heap_->PreSweepingGcVerification(this);
+  timings_.EndSplit();
+}
+
+void ConcurrentCopying::MarkAllocationStackAsLive() {
+  TimingLogger::ScopedSplit split("MarkAllocationStackAsLive", &timings_);
+  if (kUseThreadLocalAllocationStack) {
+    heap_->RevokeAllThreadLocalAllocationStacks(self_);
+  }
+  heap_->SwapStacks(self_);
+  accounting::ObjectStack* live_stack = heap_->GetLiveStack();
+  for (Object** it = live_stack->Begin(), **end = live_stack->End(); it != end; ++it) {
+    Object* obj = *it;
+    if (obj != nullptr) {
+      // Allocated after the flip, treat as black since any reference it holds was obtained through
+      // the read barrier.
+      MarkNonMoving(obj);
+    }
+  }
+  heap_->MarkAllocStackAsLive(live_stack);
+  live_stack->Reset();
+  // Marking the allocation stack may not push anything which still needs scanning, but be safe.
+  ProcessMarkStack();
+}
+
+void ConcurrentCopying::ReleaseFromSpace() {
+  timings_.StartSplit("RecordFree");
+  // Revoke buffers before measuring how many objects were moved since the TLABs need to be revoked
+  // before they are properly counted.
+  RevokeAllThreadLocalBuffers();
+  const int64_t from_bytes = from_space_->GetBytesAllocated();
+  const int64_t to_bytes = bytes_moved_.Load() + bytes_wasted_.Load();
+  const uint64_t from_objects = from_space_->GetObjectsAllocated();
+  const uint64_t to_objects = objects_moved_.Load();
+  CHECK_LE(to_objects, from_objects);
+  RecordFree(from_objects - to_objects, from_bytes - to_bytes);
+  if (bytes_wasted_.Load() > 0) {
+    VLOG(heap) << "Discarded " << PrettySize(bytes_wasted_.Load()) << " of racing copies";
+  }
+  // Clear and protect the from space.
+  from_space_->Clear();
+  VLOG(heap) << "Protecting from_space_: " << *from_space_;
+  from_space_->GetMemMap()->Protect(kProtectFromSpace ? PROT_NONE : PROT_READ);
+  timings_.EndSplit();
+}
+
+void ConcurrentCopying::ReclaimPhase() {
+  TimingLogger::ScopedSplit split("ReclaimPhase", &timings_);
+  WriterMutexLock mu(self_, *Locks::heap_bitmap_lock_);
+  // Reclaim unmarked objects.
+  Sweep(false);
+  // Swap the live and mark bitmaps for each space which we modified space. This is an
+  // optimization that enables us to not clear live bits inside of the sweep. Only swaps unbound
+  // bitmaps.
+  timings_.StartSplit("SwapBitmaps");
+  SwapBitmaps();
+  timings_.EndSplit();
+  // Unbind the live and mark bitmaps.
+  TimingLogger::ScopedSplit unbind_split("UnBindBitmaps", &timings_);
+  GetHeap()->UnBindBitmaps();
+}
+
+void ConcurrentCopying::FinishPhase() {
+  TimingLogger::ScopedSplit split("FinishPhase", &timings_);
+  // Null the "to" and "from" spaces since compacting from one to the other isn't valid until
+  // further action is done by the heap.
+  to_space_ = nullptr;
+  from_space_ = nullptr;
+  CHECK(mark_stack_->IsEmpty());
+  mark_stack_->Reset();
+  // Clear all of the spaces' mark bitmaps.
+  WriterMutexLock mu(self_, *Locks::heap_bitmap_lock_);
+  heap_->ClearMarkedObjects();
+}
+
+void ConcurrentCopying::ProcessReferences(Thread* self) {
+  TimingLogger::ScopedSplit split("ProcessReferences", &timings_);
+  WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
+  GetHeap()->GetReferenceProcessor()->ProcessReferences(
+      false, &timings_, clear_soft_references_, &IsMarkedCallback, &MarkObjectCallback,
+      &ProcessMarkStackCallback, this);
+}
+
+void ConcurrentCopying::SweepSystemWeaks(Thread* self) {
+  timings_.StartSplit("SweepSystemWeaks");
+  ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
+  Runtime::Current()->SweepSystemWeaks(IsMarkedCallback, this);
+  timings_.EndSplit();
+}
+
+bool ConcurrentCopying::ShouldSweepSpace(space::ContinuousSpace* space) const {
+  return space != from_space_ && space != to_space_ && !immune_region_.ContainsSpace(space);
+}
+
+void ConcurrentCopying::Sweep(bool swap_bitmaps) {
+  TimingLogger::ScopedSplit split("Sweep", &timings_);
+  for (const auto& space : GetHeap()->GetContinuousSpaces()) {
+    if (space->IsContinuousMemMapAllocSpace()) {
+      space::ContinuousMemMapAllocSpace* alloc_space = space->AsContinuousMemMapAllocSpace();
+      if (!ShouldSweepSpace(alloc_space)) {
+        continue;
+      }
+      TimingLogger::ScopedSplit split(
+          alloc_space->IsZygoteSpace() ? "SweepZygoteSpace" : "SweepAllocSpace", &timings_);
+      size_t freed_objects = 0;
+      size_t freed_bytes = 0;
+      alloc_space->Sweep(swap_bitmaps, &freed_objects, &freed_bytes);
+      RecordFree(freed_objects, freed_bytes);
+    }
+  }
+  SweepLargeObjects(swap_bitmaps);
+}
+
+void ConcurrentCopying::SweepLargeObjects(bool swap_bitmaps) {
+  TimingLogger::ScopedSplit split("SweepLargeObjects", &timings_);
+  size_t freed_objects = 0;
+  size_t freed_bytes = 0;
+  heap_->GetLargeObjectsSpace()->Sweep(swap_bitmaps, &freed_objects, &freed_bytes);
+  RecordFreeLargeObjects(freed_objects, freed_bytes);
+}
+
+void ConcurrentCopying::SetToSpace(space::BumpPointerSpace* to_space) {
+  DCHECK(to_space != nullptr);
+  to_space_ = to_space;
+}
+
+void ConcurrentCopying::SetFromSpace(space::BumpPointerSpace* from_space) {
+  DCHECK(from_space != nullptr);
+  from_space_ = from_space;
+}
+
+void ConcurrentCopying::RevokeAllThreadLocalBuffers() {
+  timings_.StartSplit("(Paused)RevokeAllThreadLocalBuffers");
+  GetHeap()->RevokeAllThreadLocalBuffers();
+  timings_.EndSplit();
+}
+
+inline mirror::Object* ConcurrentCopying::GetFwdPtr(mirror::Object* from_ref) {
+  DCHECK(from_space_->HasAddress(from_ref));
+  mirror::Object* fwd_ptr = from_ref->GetReadBarrierPointer();
+  // A from-space object which has not been copied still points to itself.
+  return fwd_ptr != from_ref ? fwd_ptr : nullptr;
+}
+
+mirror::Object* ConcurrentCopying::AllocateInToSpace(Thread* self, size_t num_bytes) {
+  if (heap_->use_tlab_) {
+    if (UNLIKELY(self->TlabSize() < num_bytes)) {
+      // Matches the TLAB allocation path in Heap::TryToAllocate.
+      if (!to_space_->AllocNewTlab(self, num_bytes + Heap::kDefaultTLABSize)) {
+        return nullptr;
+      }
+    }
+    return self->AllocTlab(num_bytes);
+  }
+  return to_space_->AllocNonvirtual(num_bytes);
+}
+
+mirror::Object* ConcurrentCopying::Copy(mirror::Object* from_ref) {
+  const size_t object_size = from_ref->SizeOf();
+  const size_t alloc_size = RoundUp(object_size, space::BumpPointerSpace::kAlignment);
+  Thread* const self = Thread::Current();
+  mirror::Object* to_ref = AllocateInToSpace(self, alloc_size);
+  CHECK(to_ref != nullptr) << "Out of memory in the to-space.";
+  // The from-space object is never written after the flip since the mutators only hold to-space
+  // references, copying it without synchronization is safe.
+  memcpy(reinterpret_cast<void*>(to_ref), from_ref, object_size);
+  to_ref->SetReadBarrierPointer(to_ref);
+  // Publish the copy. If another thread beat us to it, our copy stays behind as an unreachable
+  // object in the to-space which is reclaimed by the next collection.
+  if (!from_ref->AtomicSetReadBarrierPointer(from_ref, to_ref)) {
+    bytes_wasted_.FetchAndAdd(alloc_size);
+    mirror::Object* winner = GetFwdPtr(from_ref);
+    DCHECK(winner != nullptr);
+    return winner;
+  }
+  bytes_moved_.FetchAndAdd(alloc_size);
+  objects_moved_.FetchAndAdd(1);
+  to_ref->AssertReadBarrierPointer();
+  PushOntoMarkStack(to_ref);
+  return to_ref;
+}
+
+class ConcurrentCopyingMarkLargeObjectVisitor {
+ public:
+  explicit ConcurrentCopyingMarkLargeObjectVisitor(ConcurrentCopying* collector)
+      : collector_(collector) {
+  }
+
+  void operator()(const Object* obj) const ALWAYS_INLINE {
+    space::LargeObjectSpace* large_object_space = collector_->GetHeap()->GetLargeObjectsSpace();
+    if (UNLIKELY(obj == nullptr || !IsAligned<kPageSize>(obj) ||
+                 (kIsDebugBuild && !large_object_space->Contains(obj)))) {
+      collector_->GetHeap()->DumpSpaces();
+      LOG(FATAL) << "Tried to mark " << obj << " not contained by any spaces";
+    }
+  }
+
+ private:
+  ConcurrentCopying* const collector_;
+};
+
+// The mutators mark from the read barrier without holding the heap bitmap lock, the bitmap
+// updates are atomic.
+inline void ConcurrentCopying::MarkNonMoving(mirror::Object* ref) NO_THREAD_SAFETY_ANALYSIS {
+  ConcurrentCopyingMarkLargeObjectVisitor visitor(this);
+  if (!mark_bitmap_->AtomicTestAndSet(ref, visitor)) {
+    PushOntoMarkStack(ref);
+  }
+}
+
+mirror::Object* ConcurrentCopying::Mark(mirror::Object* from_ref) {
+  if (from_ref == nullptr) {
+    return nullptr;
+  }
+  if (from_space_->HasAddress(from_ref)) {
+    mirror::Object* to_ref = GetFwdPtr(from_ref);
+    if (to_ref == nullptr) {
+      to_ref = Copy(from_ref);
+    }
+    DCHECK(to_space_->HasAddress(to_ref)) << from_ref << " forwarded to " << to_ref;
+    return to_ref;
+  }
+  if (to_space_->HasAddress(from_ref) || immune_region_.ContainsObject(from_ref)) {
+    // Already copied, allocated since the flip or never collected.
+    return from_ref;
+  }
+  MarkNonMoving(from_ref);
+  return from_ref;
+}
+
+mirror::Object* ConcurrentCopying::IsMarked(mirror::Object* from_ref) {
+  if (from_space_->HasAddress(from_ref)) {
+    // Returns either the forwarding address or nullptr.
+    return GetFwdPtr(from_ref);
+  }
+  if (to_space_->HasAddress(from_ref) || immune_region_.ContainsObject(from_ref)) {
+    return from_ref;
+  }
+  return heap_->GetMarkBitmap()->Test(from_ref) ? from_ref : nullptr;
+}
+
+void ConcurrentCopying::PushOntoMarkStack(mirror::Object* obj) {
+  Thread* self = Thread::Current();
+  if (self == self_) {
+    if (UNLIKELY(mark_stack_->Size() >= mark_stack_->Capacity())) {
+      ResizeMarkStack(mark_stack_->Capacity() * 2);
+    }
+    mark_stack_->PushBack(obj);
+  } else if (UNLIKELY(!self->PushOnGcMarkBuffer(obj))) {
+    // Take the mutator mark stack lock once per block of gray objects rather than for every one.
+    RevokeThreadMarkBuffer(self, self);
+    self->PushOnGcMarkBuffer(obj);
+  }
+}
+
+void ConcurrentCopying::RevokeThreadMarkBuffer(Thread* self, Thread* thread) {
+  mirror::Object** buffer = thread->GetGcMarkBuffer();
+  size_t size = thread->GetGcMarkBufferSize();
+  if (size != 0) {
+    MutexLock mu(self, mutator_mark_stack_lock_);
+    mutator_mark_stack_.insert(mutator_mark_stack_.end(), buffer, buffer + size);
+  }
+  thread->ResetGcMarkBuffer();
+}
+
+void ConcurrentCopying::RevokeAllThreadMarkBuffers() {
+  TimingLogger::ScopedSplit split("(Paused)RevokeAllThreadMarkBuffers", &timings_);
+  MutexLock mu(self_, *Locks::runtime_shutdown_lock_);
+  MutexLock mu2(self_, *Locks::thread_list_lock_);
+  for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+    RevokeThreadMarkBuffer(self_, thread);
+  }
+}
+
+bool ConcurrentCopying::DrainMutatorMarkStack() {
+  std::vector<mirror::Object*> temp;
+  {
+    MutexLock mu(self_, mutator_mark_stack_lock_);
+    if (mutator_mark_stack_.empty()) {
+      return false;
+    }
+    temp.swap(mutator_mark_stack_);
+  }
+  for (mirror::Object* obj : temp) {
+    if (UNLIKELY(mark_stack_->Size() >= mark_stack_->Capacity())) {
+      ResizeMarkStack(mark_stack_->Capacity() * 2);
+    }
+    mark_stack_->PushBack(obj);
+  }
+  return true;
+}
+
+void ConcurrentCopying::ResizeMarkStack(size_t new_size) {
+  std::vector<Object*> temp(mark_stack_->Begin(), mark_stack_->End());
+  CHECK_LE(mark_stack_->Size(), new_size);
+  mark_stack_->Resize(new_size);
+  for (const auto& obj : temp) {
+    mark_stack_->PushBack(obj);
+  }
+}
+
+void ConcurrentCopying::ProcessMarkStack() {
+  timings_.StartSplit("ProcessMarkStack");
+  do {
+    while (!mark_stack_->IsEmpty()) {
+      ScanObject(mark_stack_->PopBack());
+    }
+  } while (DrainMutatorMarkStack());
+  timings_.EndSplit();
+}
+
+void ConcurrentCopying::UpdateField(mirror::Object* obj, MemberOffset offset) {
+  mirror::Object* ref = obj->GetFieldObject<mirror::Object, kVerifyNone, kWithoutReadBarrier>(
+      offset);
+  mirror::Object* to_ref = Mark(ref);
+  if (to_ref != ref) {
+    // A failed CAS means a mutator stored a new (to-space) reference after we read the field.
+    obj->CasFieldObject<false, false, kVerifyNone>(offset, ref, to_ref);
+  }
+}
+
+class ConcurrentCopyingRefFieldsVisitor {
+ public:
+  explicit ConcurrentCopyingRefFieldsVisitor(ConcurrentCopying* collector)
+      : collector_(collector) {
+  }
+
+  void operator()(Object* obj, MemberOffset offset, bool /* is_static */) const ALWAYS_INLINE
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    collector_->UpdateField(obj, offset);
+  }
+
+  void operator()(mirror::Class* klass, mirror::Reference* ref) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    collector_->DelayReferenceReferent(klass, ref);
+  }
+
+ private:
+  ConcurrentCopying* const collector_;
+};
+
+// Visit all of the references of an object and forward them.
+void ConcurrentCopying::ScanObject(mirror::Object* to_ref) {
+  DCHECK(!from_space_->HasAddress(to_ref)) << "Scanning object " << to_ref << " in from space";
+  ConcurrentCopyingRefFieldsVisitor visitor(this);
+  to_ref->VisitReferences<kMovingClasses>(visitor, visitor);
+}
+
+// Process the "referent" field in a java.lang.ref.Reference.  If the referent has not yet been
+// marked, put it on the appropriate list in the heap for later processing.
+void ConcurrentCopying::DelayReferenceReferent(mirror::Class* klass,
+                                               mirror::Reference* reference) {
+  heap_->GetReferenceProcessor()->DelayReferenceReferent(klass, reference, IsMarkedCallback, this);
+}
+
+void ConcurrentCopying::MarkRootCallback(mirror::Object** root, void* arg, uint32_t /*thread_id*/,
+                                         RootType /*root_type*/) {
+  mirror::Object* ref = *root;
+  mirror::Object* to_ref = reinterpret_cast<ConcurrentCopying*>(arg)->Mark(ref);
+  if (to_ref != ref) {
+    *root = to_ref;
+  }
+}
+
+mirror::Object* ConcurrentCopying::MarkObjectCallback(mirror::Object* root, void* arg) {
+  return reinterpret_cast<ConcurrentCopying*>(arg)->Mark(root);
+}
+
+void ConcurrentCopying::MarkHeapReferenceCallback(mirror::HeapReference<mirror::Object>* ref,
+                                                  void* arg) {
+  mirror::Object* from_ref = ref->AsMirrorPtr();
+  mirror::Object* to_ref = reinterpret_cast<ConcurrentCopying*>(arg)->Mark(from_ref);
+  if (to_ref != from_ref) {
+    // The immune spaces are mutated concurrently, only replace the reference we read.
+    uint32_t expected =
+        mirror::HeapReference<mirror::Object>::FromMirrorPtr(from_ref).AsVRegValue();
+    uint32_t desired = mirror::HeapReference<mirror::Object>::FromMirrorPtr(to_ref).AsVRegValue();
+    __sync_bool_compare_and_swap(reinterpret_cast<volatile uint32_t*>(ref), expected, desired);
+  }
+}
+
+void ConcurrentCopying::ProcessMarkStackCallback(void* arg) {
+  reinterpret_cast<ConcurrentCopying*>(arg)->ProcessMarkStack();
+}
+
+mirror::Object* ConcurrentCopying::IsMarkedCallback(mirror::Object* from_ref, void* arg) {
+  return reinterpret_cast<ConcurrentCopying*>(arg)->IsMarked(from_ref);
+}
+
 }  // namespace collector
 }  // namespace gc
 }  // namespace art
@@ -17,32 +17,245 @@
 #ifndef ART_RUNTIME_GC_COLLECTOR_CONCURRENT_COPYING_H_
 #define ART_RUNTIME_GC_COLLECTOR_CONCURRENT_COPYING_H_
 
+#include <vector>
+
+#include "atomic.h"
+#include "base/macros.h"
+#include "base/mutex.h"
 #include "garbage_collector.h"
+#include "immune_region.h"
+#include "object_callbacks.h"
+#include "offsets.h"
 
 namespace art {
+
+class Thread;
+
+namespace mirror {
+  class Class;
+  class Object;
+  class Reference;
+  template<class MirrorType> class HeapReference;
+}  // namespace mirror
+
 namespace gc {
+
+class Heap;
+
+namespace accounting {
+  template <typename T> class AtomicStack;
+  typedef AtomicStack<mirror::Object*> ObjectStack;
+  class HeapBitmap;
+}  // namespace accounting
+
+namespace space {
+  class BumpPointerSpace;
+  class ContinuousSpace;
+}  // namespace space
+
 namespace collector {
 
+// A mostly concurrent copying collector built on the Brooks read barrier. Objects in the
+// from-space bump pointer space are evacuated to the to-space while the mutators run. The
+// forwarding address of a from-space object is its Brooks pointer, and every reference load
+// through mirror::Object goes through ReadBarrier::Barrier() which copies (or looks up) the
+// referent so that the mutators only ever observe to-space references (the to-space invariant).
+// Objects in the non-moving spaces are marked in the mark bitmaps and swept concurrently.
+//
+// There are two short pauses: the flip pause which redirects allocation to the to-space and
+// forwards the roots, and the final pause which drains the mark stacks, processes references and
+// sweeps the system weaks before the from-space is released.
 class ConcurrentCopying : public GarbageCollector {
  public:
   explicit ConcurrentCopying(Heap* heap, bool generational = false,
-                             const std::string& name_prefix = "")
-      : GarbageCollector(heap,
-                         name_prefix + (name_prefix.empty() ? "" : " ") +
-                         "concurrent copying + mark sweep") {}
+                             const std::string& name_prefix = "");
 
   ~ConcurrentCopying() {}
 
-  virtual void RunPhases() OVERRIDE {}
+  virtual void RunPhases() OVERRIDE NO_THREAD_SAFETY_ANALYSIS;
+  void InitializePhase();
+  void FlipPhase() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
+      LOCKS_EXCLUDED(Locks::heap_bitmap_lock_);
+  void CopyingPhase() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      LOCKS_EXCLUDED(Locks::heap_bitmap_lock_);
+  void PausePhase() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
+      LOCKS_EXCLUDED(Locks::heap_bitmap_lock_);
+  void ReclaimPhase() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      LOCKS_EXCLUDED(Locks::heap_bitmap_lock_);
+  void FinishPhase() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   virtual GcType GetGcType() const OVERRIDE {
     return kGcTypePartial;
   }
   virtual CollectorType GetCollectorType() const OVERRIDE {
     return kCollectorTypeCC;
   }
-  virtual void RevokeAllThreadLocalBuffers() OVERRIDE {}
+  virtual void RevokeAllThreadLocalBuffers() OVERRIDE;
+
+  // Sets which space we will be copying objects to.
+  void SetToSpace(space::BumpPointerSpace* to_space);
+
+  // Set the space where we copy objects from.
+  void SetFromSpace(space::BumpPointerSpace* from_space);
+
+  // True between the flip pause and the end of the final pause, while references loaded by the
+  // mutators need to go through Mark().
+  bool IsMarking() const {
+    return is_marking_;
+  }
+
+  // Returns the to-space reference for from_ref, copying it out of the from-space or marking it in
+  // the non-moving spaces if required. Called by the GC thread as well as by the mutators from
+  // the read barrier slow path.
+  mirror::Object* Mark(mirror::Object* from_ref)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Returns null if the object is not marked, otherwise returns the forwarding address (same as
+  // object for non movable things).
+  mirror::Object* IsMarked(mirror::Object* from_ref)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  static void MarkRootCallback(mirror::Object** root, void* arg, uint32_t /*tid*/,
+                               RootType /*root_type*/)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  static mirror::Object* MarkObjectCallback(mirror::Object* root, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  static void MarkHeapReferenceCallback(mirror::HeapReference<mirror::Object>* ref, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  static void ProcessMarkStackCallback(void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  static mirror::Object* IsMarkedCallback(mirror::Object* from_ref, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Schedules an unmarked object for reference processing.
+  void DelayReferenceReferent(mirror::Class* klass, mirror::Reference* reference)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Update the field of obj at offset from from_ref to the to-space reference of from_ref. If a
+  // mutator has written a new value in the meantime the field is left alone since the mutator can
+  // only have written a to-space reference.
+  void UpdateField(mirror::Object* obj, MemberOffset offset)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Move the gray objects buffered by thread onto the shared mutator mark stack. Either called by
+  // thread itself or by the GC thread while thread is suspended.
+  void RevokeThreadMarkBuffer(Thread* self, Thread* thread)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(mutator_mark_stack_lock_);
 
  private:
+  // Returns the forwarding address of a from-space object or null if it has not been copied yet.
+  mirror::Object* GetFwdPtr(mirror::Object* from_ref)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Copy a from-space object to the to-space and install the forwarding pointer. Returns the
+  // winning to-space copy if another thread raced us.
+  mirror::Object* Copy(mirror::Object* from_ref)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Allocate storage for a copy in the to-space, either in the TLAB of self or directly in the
+  // space depending on how the heap allocates.
+  mirror::Object* AllocateInToSpace(Thread* self, size_t num_bytes)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Mark a non-moving object in the heap mark bitmap and push it onto a mark stack if it wasn't
+  // previously marked.
+  void MarkNonMoving(mirror::Object* ref)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Push a gray object, from the GC thread onto the GC mark stack, or from a mutator onto its
+  // thread-local mark buffer which is moved to the shared mutator mark stack once full.
+  void PushOntoMarkStack(mirror::Object* obj)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(mutator_mark_stack_lock_);
+
+  // Revoke the mark buffers of all the threads, the mutators must be suspended.
+  void RevokeAllThreadMarkBuffers()
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(mutator_mark_stack_lock_);
+
+  // Move the gray objects pushed by the mutators onto the GC mark stack, returns false if there
+  // were none.
+  bool DrainMutatorMarkStack() LOCKS_EXCLUDED(mutator_mark_stack_lock_);
+
+  // Expand mark stack to 2x its current size.
+  void ResizeMarkStack(size_t new_size);
+
+  // Blackens an object in the to-space or in a non-moving space.
+  void ScanObject(mirror::Object* to_ref)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Recursively blackens objects on the mark stacks.
+  void ProcessMarkStack()
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Marks (and forwards) the root set.
+  void MarkRoots()
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Mark the spaces we never collect, ie the image and zygote spaces, as immune.
+  void BindBitmaps() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      LOCKS_EXCLUDED(Locks::heap_bitmap_lock_);
+
+  // Update and mark references from immune spaces.
+  void UpdateAndMarkModUnion()
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Objects allocated in the non-moving spaces since the flip are implicitly marked.
+  void MarkAllocationStackAsLive()
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_, Locks::heap_bitmap_lock_);
+
+  void ProcessReferences(Thread* self)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  void SweepSystemWeaks(Thread* self)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(Locks::heap_bitmap_lock_);
+
+  // Sweeps unmarked objects in the non-moving spaces.
+  void Sweep(bool swap_bitmaps) EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+
+  void SweepLargeObjects(bool swap_bitmaps) EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+
+  // Returns true if we should sweep the space.
+  bool ShouldSweepSpace(space::ContinuousSpace* space) const;
+
+  // Record the freed from-space bytes, then release and protect the from-space.
+  void ReleaseFromSpace()
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Mark stack owned by the collector thread, only the GC thread pushes and pops.
+  accounting::ObjectStack* mark_stack_;
+
+  // Gray objects which the mutators pushed from the read barrier slow path, in blocks of up to
+  // Thread::kGcMarkBufferSize.
+  Mutex mutator_mark_stack_lock_;
+  std::vector<mirror::Object*> mutator_mark_stack_ GUARDED_BY(mutator_mark_stack_lock_);
+
+  // Immune region, every object inside the immune region is assumed to be marked.
+  ImmuneRegion immune_region_;
+
+  space::BumpPointerSpace* to_space_;
+  space::BumpPointerSpace* from_space_;
+
+  // Cached mark bitmap as an optimization.
+  accounting::HeapBitmap* mark_bitmap_;
+
+  // The thread running the collection.
+  Thread* self_;
+
+  // See IsMarking().
+  volatile bool is_marking_;
+
+  // How many objects and bytes we moved, used so that we don't need to Get the size of the
+  // to_space_ when calculating how many objects and bytes we freed.
+  AtomicInteger bytes_moved_;
+  AtomicInteger objects_moved_;
+
+  // Bytes of to-space copies discarded because another thread installed its copy first.
+  AtomicInteger bytes_wasted_;
+
+  friend class ConcurrentCopyingMarkLargeObjectVisitor;
   DISALLOW_COPY_AND_ASSIGN(ConcurrentCopying);
 };
 
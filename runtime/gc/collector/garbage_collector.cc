@@ -83,8 +83,11 @@ void GarbageCollector::Run(GcCause gc_cause, bool clear_soft_references) {
     RegisterPause(duration_ns_);
   }
   total_time_ns_ += GetDurationNs();
+  RuntimeLatencies* latencies = self->GetLatencies();
+  latencies->gc_ns.Record(duration_ns_);
   for (uint64_t pause_time : pause_times_) {
     pause_histogram_.AddValue(pause_time / 1000);
+    latencies->gc_pause_ns.Record(pause_time);
   }
 }
 
@@ -34,14 +34,17 @@
 #include "gc/reference_processor.h"
 #include "gc/space/image_space.h"
 #include "gc/space/large_object_space.h"
+#include "gc/space/rosalloc_space.h"
 #include "gc/space/space-inl.h"
 #include "mark_sweep-inl.h"
 #include "mirror/art_field-inl.h"
 #include "mirror/object-inl.h"
+#include "monitor.h"
 #include "runtime.h"
 #include "scoped_thread_state_change.h"
 #include "thread-inl.h"
 #include "thread_list.h"
+#include "work_stealing_mark_stack.h"
 
 using ::art::mirror::ArtField;
 using ::art::mirror::Class;
@@ -55,6 +58,10 @@ namespace collector {
 // Performance options.
 static constexpr bool kUseRecursiveMark = false;
 static constexpr bool kUseMarkStackPrefetch = true;
+// Defer marking the references found while processing the mark stack by kMarkPrefetchDistance
+// references, prefetching their mark bitmap words in the meantime.
+static constexpr bool kUseMarkBitmapPrefetch = true;
+static constexpr size_t kMarkPrefetchDistance = 8;
 static constexpr size_t kSweepArrayChunkFreeSize = 1024;
 static constexpr bool kPreCleanCards = true;
 
@@ -67,6 +74,10 @@ static constexpr bool kParallelRecursiveMark = true;
 // ProcessMarkStack with very small mark stacks.
 static constexpr size_t kMinimumParallelMarkStackSize = 128;
 static constexpr bool kParallelProcessMarkStack = true;
+// Sweep RosAlloc spaces with the GC thread pool, each thread gets kSweepTasksPerThread ranges on
+// average so that threads which finish early can pick up more work.
+static constexpr bool kParallelSweep = true;
+static constexpr size_t kSweepTasksPerThread = 4;
 
 // Profiling and information flags.
 static constexpr bool kProfileLargeObjects = false;
@@ -117,6 +128,7 @@ void MarkSweep::InitializePhase() {
   overhead_time_ = 0;
   work_chunks_created_ = 0;
   work_chunks_deleted_ = 0;
+  work_chunks_stolen_ = 0;
   reference_count_ = 0;
   mark_null_count_ = 0;
   mark_immune_count_ = 0;
@@ -196,11 +208,18 @@ void MarkSweep::PausePhase() {
   timings_.StartSplit("PreSweepingGcVerification");
   heap_->PreSweepingGcVerification(this);
   timings_.EndSplit();
+  Runtime* runtime = Runtime::Current();
+  if (runtime->IsIdleMonitorDeflationEnabled()) {
+    // Monitors can only be deflated with the mutators suspended. Deflating the idle ones returns
+    // their memory and monitor ids and makes locking them thin again.
+    TimingLogger::ScopedSplit split("DeflateIdleMonitors", &timings_);
+    runtime->GetMonitorList()->DeflateIdleMonitors();
+  }
   // Disallow new system weaks to prevent a race which occurs when someone adds a new system
   // weak before we sweep them. Since this new system weak may not be marked, the GC may
   // incorrectly sweep it. This also fixes a race where interning may attempt to return a strong
   // reference to a string that is about to be swept.
-  Runtime::Current()->DisallowNewSystemWeaks();
+  runtime->DisallowNewSystemWeaks();
   // Enable the reference processing slow path, needs to be done with mutators paused since there
   // is no lock in the GetReferent fast path.
   GetHeap()->GetReferenceProcessor()->EnableSlowPath();
@@ -331,11 +350,6 @@ void MarkSweep::ExpandMarkStack() {
 }
 
 void MarkSweep::ResizeMarkStack(size_t new_size) {
-  // Rare case, no need to have Thread::Current be a parameter.
-  if (UNLIKELY(mark_stack_->Size() < mark_stack_->Capacity())) {
-    // Someone else acquired the lock and expanded the mark stack before us.
-    return;
-  }
   std::vector<Object*> temp(mark_stack_->Begin(), mark_stack_->End());
   CHECK_LE(mark_stack_->Size(), new_size);
   mark_stack_->Resize(new_size);
@@ -344,15 +358,13 @@ void MarkSweep::ResizeMarkStack(size_t new_size) {
   }
 }
 
-inline void MarkSweep::MarkObjectNonNullParallel(Object* obj) {
-  DCHECK(obj != nullptr);
-  if (MarkObjectParallel(obj)) {
-    MutexLock mu(Thread::Current(), mark_stack_lock_);
-    if (UNLIKELY(mark_stack_->Size() >= mark_stack_->Capacity())) {
-      ExpandMarkStack();
-    }
-    // The object must be pushed on to the mark stack.
-    mark_stack_->PushBack(obj);
+void MarkSweep::PushOnMarkStackParallel(Object** objects, size_t count) {
+  MutexLock mu(Thread::Current(), mark_stack_lock_);
+  while (UNLIKELY(mark_stack_->Size() + count > mark_stack_->Capacity())) {
+    ExpandMarkStack();
+  }
+  for (size_t i = 0; i < count; ++i) {
+    mark_stack_->PushBack(objects[i]);
   }
 }
 
@@ -461,11 +473,6 @@ inline void MarkSweep::MarkObject(Object* obj) {
   }
 }
 
-void MarkSweep::MarkRootParallelCallback(Object** root, void* arg, uint32_t /*thread_id*/,
-                                         RootType /*root_type*/) {
-  reinterpret_cast<MarkSweep*>(arg)->MarkObjectNonNullParallel(*root);
-}
-
 void MarkSweep::VerifyRootMarked(Object** root, void* arg, uint32_t /*thread_id*/,
                                  RootType /*root_type*/) {
   CHECK(reinterpret_cast<MarkSweep*>(arg)->IsMarked(*root));
@@ -562,25 +569,30 @@ class DelayReferenceReferentVisitor {
 };
 
 template <bool kUseFinger = false>
-class MarkStackTask : public Task {
+class MarkStackTask : public WorkStealingTask {
  public:
   MarkStackTask(ThreadPool* thread_pool, MarkSweep* mark_sweep, size_t mark_stack_size,
                 Object** mark_stack)
       : mark_sweep_(mark_sweep),
         thread_pool_(thread_pool),
-        mark_stack_pos_(mark_stack_size) {
-    // We may have to copy part of an existing mark stack when another mark stack overflows.
-    if (mark_stack_size != 0) {
-      DCHECK(mark_stack != NULL);
-      // TODO: Check performance?
-      std::copy(mark_stack, mark_stack + mark_stack_size, mark_stack_);
-    }
+        // We may have to copy part of an existing mark stack when another mark stack overflows.
+        mark_stack_("mark stack task lock", mark_stack_size, mark_stack) {
     if (kCountTasks) {
       ++mark_sweep_->work_chunks_created_;
     }
   }
 
-  static const size_t kMaxSize = 1 * KB;
+  // Called by a worker which ran out of work. Takes the older half of the published references of
+  // source and scans them.
+  virtual void StealFrom(Thread* self, WorkStealingTask* source) NO_THREAD_SAFETY_ANALYSIS {
+    auto* victim = down_cast<MarkStackTask<kUseFinger>*>(source);
+    if (mark_stack_.StealFrom(self, &victim->mark_stack_) != 0) {
+      if (kCountTasks) {
+        ++mark_sweep_->work_chunks_stolen_;
+      }
+      ScanMarkStack();
+    }
+  }
 
  protected:
   class MarkObjectParallelVisitor {
@@ -628,8 +640,6 @@ class MarkStackTask : public Task {
   };
 
   virtual ~MarkStackTask() {
-    // Make sure that we have cleared our mark stack.
-    DCHECK_EQ(mark_stack_pos_, 0U);
     if (kCountTasks) {
       ++mark_sweep_->work_chunks_deleted_;
     }
@@ -638,21 +648,25 @@ class MarkStackTask : public Task {
   MarkSweep* const mark_sweep_;
   ThreadPool* const thread_pool_;
   // Thread local mark stack for this task.
-  Object* mark_stack_[kMaxSize];
-  // Mark stack position.
-  size_t mark_stack_pos_;
+  WorkStealingMarkStack mark_stack_;
 
   void MarkStackPush(Object* obj) ALWAYS_INLINE {
-    if (UNLIKELY(mark_stack_pos_ == kMaxSize)) {
-      // Mark stack overflow, give 1/2 the stack to the thread pool as a new work task.
-      mark_stack_pos_ /= 2;
-      auto* task = new MarkStackTask(thread_pool_, mark_sweep_, kMaxSize - mark_stack_pos_,
-                                     mark_stack_ + mark_stack_pos_);
-      thread_pool_->AddTask(Thread::Current(), task);
+    if (UNLIKELY(mark_stack_.IsFull())) {
+      HandleOverflow();
+    }
+    mark_stack_.Push(obj);
+  }
+
+  void HandleOverflow() {
+    Thread* self = Thread::Current();
+    size_t count;
+    Object** objects = mark_stack_.MakeRoom(self, &count);
+    if (objects != nullptr) {
+      // Mark stack overflow, give 1/2 the stack to the thread pool as a new work task. It goes
+      // ahead of the card and bitmap range tasks as its objects are still in the cache.
+      auto* task = new MarkStackTask(thread_pool_, mark_sweep_, count, objects);
+      thread_pool_->AddTask(self, task, kTaskPriorityHigh);
     }
-    DCHECK(obj != nullptr);
-    DCHECK_LT(mark_stack_pos_, kMaxSize);
-    mark_stack_[mark_stack_pos_++] = obj;
   }
 
   virtual void Finalize() {
@@ -662,6 +676,12 @@ class MarkStackTask : public Task {
   // Scans all of the objects
   virtual void Run(Thread* self) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_) {
+    ScanMarkStack();
+  }
+
+  // Scans until neither we nor the thieves have anything left on our mark stack.
+  void ScanMarkStack() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_) {
     ScanObjectParallelVisitor visitor(this);
     // TODO: Tune this.
     static const size_t kFifoSize = 4;
@@ -669,9 +689,11 @@ class MarkStackTask : public Task {
     for (;;) {
       Object* obj = nullptr;
       if (kUseMarkStackPrefetch) {
-        while (mark_stack_pos_ != 0 && prefetch_fifo.size() < kFifoSize) {
-          Object* obj = mark_stack_[--mark_stack_pos_];
-          DCHECK(obj != nullptr);
+        while (prefetch_fifo.size() < kFifoSize) {
+          Object* obj = mark_stack_.Pop();
+          if (obj == nullptr) {
+            break;
+          }
           __builtin_prefetch(obj);
           prefetch_fifo.push_back(obj);
         }
@@ -681,10 +703,10 @@ class MarkStackTask : public Task {
         obj = prefetch_fifo.front();
         prefetch_fifo.pop_front();
       } else {
-        if (UNLIKELY(mark_stack_pos_ == 0)) {
+        obj = mark_stack_.Pop();
+        if (UNLIKELY(obj == nullptr)) {
           break;
         }
-        obj = mark_stack_[--mark_stack_pos_];
       }
       DCHECK(obj != nullptr);
       visitor(obj);
@@ -754,7 +776,7 @@ void MarkSweep::ScanGrayObjects(bool paused, byte minimum_age) {
     // Estimated number of work tasks we will create.
     const size_t mark_stack_tasks = GetHeap()->GetContinuousSpaces().size() * thread_count;
     DCHECK_NE(mark_stack_tasks, 0U);
-    const size_t mark_stack_delta = std::min(CardScanTask::kMaxSize / 2,
+    const size_t mark_stack_delta = std::min(WorkStealingMarkStack::kMaxSize / 2,
                                              mark_stack_size / mark_stack_tasks + 1);
     for (const auto& space : GetHeap()->GetContinuousSpaces()) {
       if (space->GetMarkBitmap() == nullptr) {
@@ -926,7 +948,14 @@ void MarkSweep::RecursiveMarkDirtyObjects(bool paused, byte minimum_age) {
 void MarkSweep::ReMarkRoots() {
   Locks::mutator_lock_->AssertExclusiveHeld(Thread::Current());
   timings_.StartSplit("(Paused)ReMarkRoots");
-  Runtime::Current()->VisitRoots(
+  Runtime* runtime = Runtime::Current();
+  // The threads which stayed suspended since a checkpoint marked their roots, usually most of
+  // them, don't need to be scanned again.
+  size_t skipped_threads =
+      runtime->GetThreadList()->VisitRootsOfThreadsRunSinceMarked(MarkRootCallback, this);
+  VLOG(heap) << "Skipped re-marking the roots of " << skipped_threads << " suspended threads";
+  runtime->VisitNonThreadRoots(MarkRootCallback, this);
+  runtime->VisitConcurrentRoots(
       MarkRootCallback, this, static_cast<VisitRootFlags>(kVisitRootFlagNewRoots |
                                                           kVisitRootFlagStopLoggingNewRoots |
                                                           kVisitRootFlagClearRootLog));
@@ -967,6 +996,50 @@ void MarkSweep::VerifySystemWeaks() {
   Runtime::Current()->SweepSystemWeaks(VerifySystemWeakIsLiveCallback, this);
 }
 
+// Marks the roots of a thread from a checkpoint. The checkpoints of the threads run concurrently,
+// the newly marked roots are pushed on the shared mark stack in blocks so that they don't contend
+// on the mark stack lock for every root.
+class MarkThreadRootsBuffer {
+ public:
+  explicit MarkThreadRootsBuffer(MarkSweep* mark_sweep) : mark_sweep_(mark_sweep), count_(0) {
+  }
+
+  ~MarkThreadRootsBuffer() {
+    Flush();
+  }
+
+  static void MarkRootCallback(Object** root, void* arg, uint32_t /*thread_id*/,
+                               RootType /*root_type*/) {
+    reinterpret_cast<MarkThreadRootsBuffer*>(arg)->MarkRoot(*root);
+  }
+
+  void Flush() {
+    if (count_ != 0) {
+      mark_sweep_->PushOnMarkStackParallel(roots_, count_);
+      count_ = 0;
+    }
+  }
+
+ private:
+  static constexpr size_t kSize = 128;
+
+  void MarkRoot(Object* root) ALWAYS_INLINE {
+    DCHECK(root != nullptr);
+    if (mark_sweep_->MarkObjectParallel(root)) {
+      if (UNLIKELY(count_ == kSize)) {
+        Flush();
+      }
+      roots_[count_++] = root;
+    }
+  }
+
+  MarkSweep* const mark_sweep_;
+  Object* roots_[kSize];
+  size_t count_;
+
+  DISALLOW_COPY_AND_ASSIGN(MarkThreadRootsBuffer);
+};
+
 class CheckpointMarkThreadRoots : public Closure {
  public:
   explicit CheckpointMarkThreadRoots(MarkSweep* mark_sweep,
@@ -982,7 +1055,15 @@ class CheckpointMarkThreadRoots : public Closure {
     Thread* self = Thread::Current();
     CHECK(thread == self || thread->IsSuspended() || thread->GetState() == kWaitingPerformingGc)
         << thread->GetState() << " thread " << thread << " self " << self;
-    thread->VisitRoots(MarkSweep::MarkRootParallelCallback, mark_sweep_);
+    {
+      MarkThreadRootsBuffer buffer(mark_sweep_);
+      thread->VisitRoots(MarkThreadRootsBuffer::MarkRootCallback, &buffer);
+    }
+    if (thread != self) {
+      // The suspend count we hold keeps the thread from becoming runnable until we're done, it
+      // clears the mark when it does.
+      thread->SetRootsMarkedWhileSuspended(true);
+    }
     ATRACE_END();
     if (revoke_ros_alloc_thread_local_buffers_at_checkpoint_) {
       ATRACE_BEGIN("RevokeRosAllocThreadLocalBuffers");
@@ -1122,6 +1203,76 @@ void MarkSweep::SweepArray(accounting::ObjectStack* allocations, bool swap_bitma
   timings_.EndSplit();
 }
 
+class SweepTask : public Task {
+ public:
+  SweepTask(space::ContinuousMemMapAllocSpace* space, bool swap_bitmaps, byte* begin, byte* end,
+            Atomic<size_t>* freed_objects, Atomic<size_t>* freed_bytes)
+      : space_(space),
+        swap_bitmaps_(swap_bitmaps),
+        begin_(begin),
+        end_(end),
+        freed_objects_(freed_objects),
+        freed_bytes_(freed_bytes) {
+  }
+
+ protected:
+  space::ContinuousMemMapAllocSpace* const space_;
+  const bool swap_bitmaps_;
+  byte* const begin_;
+  byte* const end_;
+  Atomic<size_t>* const freed_objects_;
+  Atomic<size_t>* const freed_bytes_;
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+  // The GC thread holds the heap bitmap lock for us.
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    size_t freed_objects = 0;
+    size_t freed_bytes = 0;
+    space_->SweepRange(swap_bitmaps_, begin_, end_, true, &freed_objects, &freed_bytes);
+    freed_objects_->FetchAndAdd(freed_objects);
+    freed_bytes_->FetchAndAdd(freed_bytes);
+  }
+};
+
+void MarkSweep::SweepRosAllocSpaceParallel(space::RosAllocSpace* space, bool swap_bitmaps,
+                                           size_t thread_count, size_t* freed_objects,
+                                           size_t* freed_bytes) {
+  Thread* self = Thread::Current();
+  ThreadPool* thread_pool = GetHeap()->GetThreadPool();
+  allocator::RosAlloc* rosalloc = space->GetRosAlloc();
+  byte* const space_end = space->End();
+  const size_t task_count = thread_count * kSweepTasksPerThread;
+  const size_t delta = RoundUp((space_end - space->Begin()) / task_count + 1, kPageSize);
+  Atomic<size_t> total_freed_objects(0);
+  Atomic<size_t> total_freed_bytes(0);
+  byte* begin = space->Begin();
+  while (begin < space_end) {
+    // BulkFree can only run concurrently on disjoint runs, so each range has to end at the
+    // beginning of a run. If a single run or large object covers the split point, move the split
+    // point forward past it.
+    byte* end = begin;
+    for (byte* split = begin + delta; end <= begin; split += delta) {
+      if (split >= space_end) {
+        end = space_end;
+      } else {
+        end = reinterpret_cast<byte*>(rosalloc->AlignDownToRunBoundary(split));
+      }
+    }
+    thread_pool->AddTask(self, new SweepTask(space, swap_bitmaps, begin, end, &total_freed_objects,
+                                             &total_freed_bytes));
+    begin = end;
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count - 1);
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
+  *freed_objects += total_freed_objects.Load();
+  *freed_bytes += total_freed_bytes.Load();
+}
+
 void MarkSweep::Sweep(bool swap_bitmaps) {
   // Ensure that nobody inserted items in the live stack after we swapped the stacks.
   CHECK_GE(live_stack_freeze_size_, GetHeap()->GetLiveStack()->Size());
@@ -1134,6 +1285,7 @@ void MarkSweep::Sweep(bool swap_bitmaps) {
   timings_.EndSplit();
 
   DCHECK(mark_stack_->IsEmpty());
+  const size_t thread_count = GetThreadCount(false);
   for (const auto& space : GetHeap()->GetContinuousSpaces()) {
     if (space->IsContinuousMemMapAllocSpace()) {
       space::ContinuousMemMapAllocSpace* alloc_space = space->AsContinuousMemMapAllocSpace();
@@ -1141,7 +1293,12 @@ void MarkSweep::Sweep(bool swap_bitmaps) {
           alloc_space->IsZygoteSpace() ? "SweepZygoteSpace" : "SweepMallocSpace", &timings_);
       size_t freed_objects = 0;
       size_t freed_bytes = 0;
-      alloc_space->Sweep(swap_bitmaps, &freed_objects, &freed_bytes);
+      if (kParallelSweep && thread_count > 1 && alloc_space->IsRosAllocSpace()) {
+        SweepRosAllocSpaceParallel(alloc_space->AsRosAllocSpace(), swap_bitmaps, thread_count,
+                                   &freed_objects, &freed_bytes);
+      } else {
+        alloc_space->Sweep(swap_bitmaps, &freed_objects, &freed_bytes);
+      }
       RecordFree(freed_objects, freed_bytes);
     }
   }
@@ -1185,6 +1342,49 @@ class MarkObjectVisitor {
   MarkSweep* const mark_sweep_;
 };
 
+// Marks the references of the objects popped off the mark stack kMarkPrefetchDistance
+// references late, so that the mark bitmap words they need are already in the cache.
+class MarkObjectPrefetchVisitor {
+ public:
+  typedef BoundedFifoPowerOfTwo<Object*, kMarkPrefetchDistance> DeferredFifo;
+
+  MarkObjectPrefetchVisitor(MarkSweep* const mark_sweep, DeferredFifo* deferred) ALWAYS_INLINE
+      : mark_sweep_(mark_sweep), deferred_(deferred) {
+  }
+
+  void operator()(Object* obj, MemberOffset offset, bool /* is_static */) const
+      ALWAYS_INLINE SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_) {
+    Object* ref = obj->GetFieldObject<mirror::Object>(offset);
+    if (!kUseMarkBitmapPrefetch || ref == nullptr) {
+      mark_sweep_->MarkObject(ref);
+      return;
+    }
+    if (deferred_->size() == kMarkPrefetchDistance) {
+      mark_sweep_->MarkObjectNonNull(deferred_->front());
+      deferred_->pop_front();
+    }
+    accounting::ContinuousSpaceBitmap* bitmap = mark_sweep_->current_space_bitmap_;
+    if (LIKELY(bitmap->HasAddress(ref))) {
+      bitmap->PrefetchWord(ref);
+    }
+    deferred_->push_back(ref);
+  }
+
+  // Mark the references which are still deferred, this may push objects on the mark stack.
+  void Flush() const SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_) {
+    while (!deferred_->empty()) {
+      mark_sweep_->MarkObjectNonNull(deferred_->front());
+      deferred_->pop_front();
+    }
+  }
+
+ private:
+  MarkSweep* const mark_sweep_;
+  DeferredFifo* const deferred_;
+};
+
 // Scans an object reference.  Determines the type of the reference
 // and dispatches to a specialized scanning routine.
 void MarkSweep::ScanObject(Object* obj) {
@@ -1201,7 +1401,7 @@ void MarkSweep::ProcessMarkStackParallel(size_t thread_count) {
   Thread* self = Thread::Current();
   ThreadPool* thread_pool = GetHeap()->GetThreadPool();
   const size_t chunk_size = std::min(mark_stack_->Size() / thread_count + 1,
-                                     static_cast<size_t>(MarkStackTask<false>::kMaxSize));
+                                     WorkStealingMarkStack::kMaxSize);
   CHECK_GT(chunk_size, 0U);
   // Split the current mark stack up into work tasks.
   for (mirror::Object **it = mark_stack_->Begin(), **end = mark_stack_->End(); it < end; ) {
@@ -1228,6 +1428,9 @@ void MarkSweep::ProcessMarkStack(bool paused) {
     // TODO: Tune this.
     static const size_t kFifoSize = 4;
     BoundedFifoPowerOfTwo<Object*, kFifoSize> prefetch_fifo;
+    MarkObjectPrefetchVisitor::DeferredFifo deferred_fifo;
+    MarkObjectPrefetchVisitor mark_visitor(this, &deferred_fifo);
+    DelayReferenceReferentVisitor ref_visitor(this);
     for (;;) {
       Object* obj = NULL;
       if (kUseMarkStackPrefetch) {
@@ -1238,18 +1441,26 @@ void MarkSweep::ProcessMarkStack(bool paused) {
           prefetch_fifo.push_back(obj);
         }
         if (prefetch_fifo.empty()) {
-          break;
+          if (deferred_fifo.empty()) {
+            break;
+          }
+          mark_visitor.Flush();
+          continue;
         }
         obj = prefetch_fifo.front();
         prefetch_fifo.pop_front();
       } else {
         if (mark_stack_->IsEmpty()) {
-          break;
+          if (deferred_fifo.empty()) {
+            break;
+          }
+          mark_visitor.Flush();
+          continue;
         }
         obj = mark_stack_->PopBack();
       }
       DCHECK(obj != nullptr);
-      ScanObject(obj);
+      ScanObjectVisit(obj, mark_visitor, ref_visitor);
     }
   }
   timings_.EndSplit();
@@ -1273,7 +1484,8 @@ void MarkSweep::FinishPhase() {
              << " other=" << other_count_;
   }
   if (kCountTasks) {
-    VLOG(gc) << "Total number of work chunks allocated: " << work_chunks_created_;
+    VLOG(gc) << "Total number of work chunks allocated: " << work_chunks_created_
+             << " stolen: " << work_chunks_stolen_;
   }
   if (kMeasureOverhead) {
     VLOG(gc) << "Overhead time " << PrettyDuration(overhead_time_);
@@ -49,6 +49,10 @@ namespace accounting {
   typedef AtomicStack<mirror::Object*> ObjectStack;
 }  // namespace accounting
 
+namespace space {
+  class RosAllocSpace;
+}  // namespace space
+
 namespace collector {
 
 class MarkSweep : public GarbageCollector {
@@ -137,6 +141,12 @@ class MarkSweep : public GarbageCollector {
   // all allocation spaces. Partial and sticky GCs want to just sweep a subset of the heap.
   virtual void Sweep(bool swap_bitmaps) EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
 
+  // Sweeps a RosAlloc space by splitting it into ranges which don't share runs and handing them
+  // to the GC thread pool.
+  void SweepRosAllocSpaceParallel(space::RosAllocSpace* space, bool swap_bitmaps,
+                                  size_t thread_count, size_t* freed_objects, size_t* freed_bytes)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
+
   // Sweeps unmarked objects to complete the garbage collection.
   void SweepLargeObjects(bool swap_bitmaps) EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
 
@@ -192,10 +202,6 @@ class MarkSweep : public GarbageCollector {
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  static void MarkRootParallelCallback(mirror::Object** root, void* arg, uint32_t thread_id,
-                                       RootType root_type)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-
   // Marks an object.
   void MarkObject(mirror::Object* obj)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
@@ -223,12 +229,13 @@ class MarkSweep : public GarbageCollector {
         SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
         EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_);
 
-  // Marks an object atomically, safe to use from multiple threads.
-  void MarkObjectNonNullParallel(mirror::Object* obj);
-
   // Returns true if we need to add obj to a mark stack.
   bool MarkObjectParallel(const mirror::Object* obj) NO_THREAD_SAFETY_ANALYSIS;
 
+  // Pushes a block of objects marked with MarkObjectParallel, safe to use from multiple threads.
+  void PushOnMarkStackParallel(mirror::Object** objects, size_t count)
+      LOCKS_EXCLUDED(mark_stack_lock_);
+
   // Verify the roots of the heap and print out information related to any invalid roots.
   // Called in MarkObject, so may we may not hold the mutator lock.
   void VerifyRoots()
@@ -299,6 +306,7 @@ class MarkSweep : public GarbageCollector {
   AtomicInteger overhead_time_;
   AtomicInteger work_chunks_created_;
   AtomicInteger work_chunks_deleted_;
+  AtomicInteger work_chunks_stolen_;
   AtomicInteger reference_count_;
   AtomicInteger mark_null_count_;
   AtomicInteger mark_immune_count_;
@@ -319,6 +327,7 @@ class MarkSweep : public GarbageCollector {
   friend class CheckBitmapVisitor;
   friend class CheckReferenceVisitor;
   friend class art::gc::Heap;
+  friend class MarkObjectPrefetchVisitor;
   friend class MarkObjectVisitor;
   friend class ModUnionCheckReferences;
   friend class ModUnionClearCardVisitor;
@@ -330,6 +339,7 @@ class MarkSweep : public GarbageCollector {
   template<bool kUseFinger> friend class MarkStackTask;
   friend class FifoMarkStackChunk;
   friend class MarkSweepMarkObjectSlowPath;
+  friend class MarkThreadRootsBuffer;
 
   DISALLOW_COPY_AND_ASSIGN(MarkSweep);
 };
@@ -43,6 +43,7 @@
 #include "monitor.h"
 #include "mirror/art_field.h"
 #include "mirror/art_field-inl.h"
+#include "mirror/array-inl.h"
 #include "mirror/class-inl.h"
 #include "mirror/class_loader.h"
 #include "mirror/dex_cache.h"
@@ -54,7 +55,9 @@
 #include "stack.h"
 #include "thread-inl.h"
 #include "thread_list.h"
+#include "thread_pool.h"
 #include "verifier/method_verifier.h"
+#include "work_stealing_mark_stack.h"
 
 using ::art::mirror::Class;
 using ::art::mirror::Object;
@@ -67,6 +70,9 @@ static constexpr bool kProtectFromSpace = true;
 static constexpr bool kStoreStackTraces = false;
 static constexpr size_t kBytesPromotedThreshold = 4 * MB;
 static constexpr size_t kLargeObjectBytesAllocatedThreshold = 16 * MB;
+static constexpr bool kParallelCopying = true;
+// Don't start the thread pool for fewer objects than this on the mark stack.
+static constexpr size_t kMinimumParallelMarkStackSize = 128;
 
 void SemiSpace::BindBitmaps() {
   timings_.StartSplit("BindBitmaps");
@@ -107,6 +113,7 @@ SemiSpace::SemiSpace(Heap* heap, bool generational, const std::string& name_pref
       bytes_promoted_since_last_whole_heap_collection_(0),
       large_object_bytes_allocated_at_last_whole_heap_collection_(0),
       whole_heap_collection_(true),
+      copy_counters_lock_("semi space copy counters lock"),
       collector_name_(name_),
       swap_semi_spaces_(true) {
 }
@@ -729,8 +736,325 @@ void SemiSpace::ScanObject(Object* obj) {
   obj->VisitReferences<kMovingClasses>(visitor, visitor);
 }
 
+// Turns [dummy, dummy + size) into an unreachable object, so that the bump pointer space stays
+// walkable across the unused ends of the copy buffers and the copies which lost a race.
+static void FillWithDummyObject(mirror::Object* dummy, size_t size)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  DCHECK_ALIGNED(size, space::BumpPointerSpace::kAlignment);
+  mirror::Class* int_array_class = mirror::IntArray::GetArrayClass();
+  const size_t data_offset = mirror::Array::DataOffset(sizeof(int32_t)).SizeValue();
+  if (size < data_offset) {
+    // Too small for an array, use a java.lang.Object.
+    dummy->SetClass(int_array_class->GetSuperClass());
+  } else {
+    dummy->SetClass(int_array_class);
+    dummy->AsArray()->SetLength((size - data_offset) / sizeof(int32_t));
+  }
+  if (kUseBrooksReadBarrier) {
+    dummy->SetReadBarrierPointer(dummy);
+  }
+  DCHECK_EQ(RoundUp(dummy->SizeOf(), space::BumpPointerSpace::kAlignment), size);
+}
+
+// Blackens the objects of a part of the mark stack, in parallel with the other tasks. The objects
+// are copied to a buffer allocated by the task in the to-space (a PLAB), or promoted, and their
+// forwarding address is installed with a CAS of their lock word: when two tasks copy the same
+// object, the one whose CAS fails takes back its copy and uses the forwarding address of the other.
+class SemiSpaceCopyTask : public WorkStealingTask {
+ public:
+  SemiSpaceCopyTask(ThreadPool* thread_pool, SemiSpace* semi_space, size_t mark_stack_size,
+                    Object** mark_stack)
+      : semi_space_(semi_space),
+        thread_pool_(thread_pool),
+        to_space_(semi_space->to_space_->AsBumpPointerSpace()),
+        mark_stack_("semi space copy task lock", mark_stack_size, mark_stack),
+        plab_pos_(nullptr),
+        plab_end_(nullptr),
+        objects_allocated_(0),
+        bytes_allocated_(0),
+        objects_moved_(0),
+        bytes_moved_(0),
+        bytes_promoted_(0),
+        saved_bytes_(0) {
+  }
+
+  // Size of the to-space buffers, larger objects are allocated in the to-space on their own.
+  static const size_t kPlabSize = 32 * KB;
+  static const size_t kMaxPlabObjectSize = kPlabSize / 8;
+
+  // Called by a worker which ran out of work. Takes the older half of the published references of
+  // source and scans them.
+  virtual void StealFrom(Thread* self, WorkStealingTask* source) NO_THREAD_SAFETY_ANALYSIS {
+    auto* victim = down_cast<SemiSpaceCopyTask*>(source);
+    if (mark_stack_.StealFrom(self, &victim->mark_stack_) != 0) {
+      ScanMarkStack(self);
+    }
+  }
+
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    ScanMarkStack(self);
+  }
+
+  // Called once neither the owner nor the thieves use the task anymore.
+  virtual void Finalize() NO_THREAD_SAFETY_ANALYSIS {
+    DCHECK(mark_stack_.IsEmpty());
+    RetirePlab();
+    to_space_->RecordAllocations(objects_allocated_, bytes_allocated_);
+    {
+      MutexLock mu(Thread::Current(), semi_space_->copy_counters_lock_);
+      semi_space_->objects_moved_ += objects_moved_;
+      semi_space_->bytes_moved_ += bytes_moved_;
+      semi_space_->bytes_promoted_ += bytes_promoted_;
+      semi_space_->saved_bytes_ += saved_bytes_;
+    }
+    delete this;
+  }
+
+  // Marks the object a field of a scanned object references, and updates the field.
+  void MarkObject(mirror::HeapReference<mirror::Object>* obj_ptr) ALWAYS_INLINE
+      NO_THREAD_SAFETY_ANALYSIS {
+    mirror::Object* obj = obj_ptr->AsMirrorPtr();
+    if (obj == nullptr || semi_space_->immune_region_.ContainsObject(obj)) {
+      return;
+    }
+    if (kUseBakerOrBrooksReadBarrier) {
+      obj->AssertReadBarrierPointer();
+    }
+    if (semi_space_->from_space_->HasAddress(obj)) {
+      LockWord lock_word = obj->GetLockWord(false);
+      mirror::Object* forward_address;
+      if (lock_word.GetState() == LockWord::kForwardingAddress) {
+        forward_address = reinterpret_cast<mirror::Object*>(lock_word.ForwardingAddress());
+      } else {
+        forward_address = CopyObject(obj, lock_word);
+      }
+      obj_ptr->Assign(forward_address);
+    } else {
+      BitmapSetSlowPathVisitor visitor(semi_space_);
+      if (!semi_space_->mark_bitmap_->AtomicTestAndSet(obj, visitor)) {
+        MarkStackPush(obj);
+      }
+    }
+  }
+
+ private:
+  class CopyTaskMarkObjectVisitor {
+   public:
+    explicit CopyTaskMarkObjectVisitor(SemiSpaceCopyTask* task) : task_(task) {
+    }
+
+    void operator()(Object* obj, MemberOffset offset, bool /* is_static */) const ALWAYS_INLINE
+        NO_THREAD_SAFETY_ANALYSIS {
+      task_->MarkObject(obj->GetFieldObjectReferenceAddr<kVerifyNone>(offset));
+    }
+
+    void operator()(mirror::Class* klass, mirror::Reference* ref) const
+        NO_THREAD_SAFETY_ANALYSIS {
+      task_->semi_space_->DelayReferenceReferent(klass, ref);
+    }
+
+   private:
+    SemiSpaceCopyTask* const task_;
+  };
+
+  // Copies obj, which had lock_word before any task forwarded it, and returns its forwarding
+  // address.
+  mirror::Object* CopyObject(mirror::Object* obj, LockWord lock_word)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    Thread* self = Thread::Current();
+    size_t object_size = obj->SizeOf();
+    size_t bytes_allocated = RoundUp(object_size, space::BumpPointerSpace::kAlignment);
+    mirror::Object* forward_address = nullptr;
+    space::MallocSpace* promo_dest_space = nullptr;
+    if (semi_space_->generational_ &&
+        reinterpret_cast<byte*>(obj) < semi_space_->last_gc_to_space_end_) {
+      // Promote the objects allocated before the last GC, see MarkNonForwardedObject().
+      promo_dest_space = semi_space_->GetHeap()->GetPrimaryFreeListSpace();
+      forward_address = promo_dest_space->Alloc(self, object_size, &bytes_allocated, nullptr);
+      if (UNLIKELY(forward_address == nullptr)) {
+        // If out of space, fall back to the to-space.
+        promo_dest_space = nullptr;
+      }
+    }
+    if (forward_address == nullptr) {
+      forward_address = AllocInToSpace(bytes_allocated);
+    }
+    CHECK(forward_address != nullptr) << "Out of memory in the to-space.";
+    size_t saved_bytes = CopyAvoidingDirtyingPages(forward_address, obj, object_size);
+    if (kUseBakerOrBrooksReadBarrier) {
+      if (kUseBrooksReadBarrier) {
+        DCHECK_EQ(forward_address->GetReadBarrierPointer(), obj);
+        forward_address->SetReadBarrierPointer(forward_address);
+      }
+      forward_address->AssertReadBarrierPointer();
+    }
+    // The copy holds the lock word from before the forwarding address is installed.
+    LockWord forwarding_lock_word =
+        LockWord::FromForwardingAddress(reinterpret_cast<size_t>(forward_address));
+    if (!obj->CasLockWord(lock_word, forwarding_lock_word)) {
+      // Another task copied the object first.
+      if (promo_dest_space != nullptr) {
+        promo_dest_space->Free(self, forward_address);
+      } else {
+        FreeInToSpace(forward_address, bytes_allocated);
+      }
+      forward_address = semi_space_->GetForwardingAddressInFromSpace(obj);
+      DCHECK(forward_address != nullptr);
+      return forward_address;
+    }
+    ++objects_moved_;
+    bytes_moved_ += bytes_allocated;
+    saved_bytes_ += saved_bytes;
+    if (promo_dest_space != nullptr) {
+      bytes_promoted_ += bytes_allocated;
+      semi_space_->GetHeap()->WriteBarrierEveryFieldOf(forward_address);
+      // In a bump pointer space only collection, the live bit is set when the object is scanned,
+      // as in the serial ProcessMarkStack().
+      if (semi_space_->whole_heap_collection_) {
+        promo_dest_space->GetLiveBitmap()->AtomicTestAndSet(forward_address);
+        promo_dest_space->GetMarkBitmap()->AtomicTestAndSet(forward_address);
+      }
+    }
+    MarkStackPush(forward_address);
+    return forward_address;
+  }
+
+  mirror::Object* AllocInToSpace(size_t num_bytes) {
+    if (num_bytes <= kMaxPlabObjectSize) {
+      if (UNLIKELY(plab_pos_ + num_bytes > plab_end_)) {
+        RetirePlab();
+        plab_pos_ = reinterpret_cast<byte*>(to_space_->AllocNonvirtualWithoutAccounting(kPlabSize));
+        if (plab_pos_ != nullptr) {
+          plab_end_ = plab_pos_ + kPlabSize;
+          bytes_allocated_ += kPlabSize;
+        }
+      }
+      if (LIKELY(plab_pos_ != nullptr)) {
+        mirror::Object* obj = reinterpret_cast<mirror::Object*>(plab_pos_);
+        plab_pos_ += num_bytes;
+        ++objects_allocated_;
+        return obj;
+      }
+    }
+    // The object is large or the to-space can't fit another buffer.
+    mirror::Object* obj = to_space_->AllocNonvirtualWithoutAccounting(num_bytes);
+    if (obj != nullptr) {
+      ++objects_allocated_;
+      bytes_allocated_ += num_bytes;
+    }
+    return obj;
+  }
+
+  // Takes back the copy of an object another task forwarded first.
+  void FreeInToSpace(mirror::Object* obj, size_t num_bytes) NO_THREAD_SAFETY_ANALYSIS {
+    byte* begin = reinterpret_cast<byte*>(obj);
+    if (begin + num_bytes == plab_pos_) {
+      // The to-space must stay zeroed past the allocated objects, see CopyAvoidingDirtyingPages().
+      memset(begin, 0, num_bytes);
+      plab_pos_ = begin;
+      --objects_allocated_;
+    } else {
+      FillWithDummyObject(obj, num_bytes);
+    }
+  }
+
+  void RetirePlab() NO_THREAD_SAFETY_ANALYSIS {
+    if (plab_pos_ != plab_end_) {
+      FillWithDummyObject(reinterpret_cast<mirror::Object*>(plab_pos_), plab_end_ - plab_pos_);
+      ++objects_allocated_;
+    }
+    plab_pos_ = plab_end_ = nullptr;
+  }
+
+  void MarkStackPush(Object* obj) ALWAYS_INLINE {
+    if (UNLIKELY(mark_stack_.IsFull())) {
+      HandleOverflow();
+    }
+    mark_stack_.Push(obj);
+  }
+
+  void HandleOverflow() {
+    Thread* self = Thread::Current();
+    size_t count;
+    Object** objects = mark_stack_.MakeRoom(self, &count);
+    if (objects != nullptr) {
+      // Give half of the stack to the thread pool as a new task.
+      auto* task = new SemiSpaceCopyTask(thread_pool_, semi_space_, count, objects);
+      thread_pool_->AddTask(self, task, kTaskPriorityHigh);
+    }
+  }
+
+  // Scans until neither we nor the thieves have anything left on our mark stack.
+  void ScanMarkStack(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    accounting::ContinuousSpaceBitmap* promo_live_bitmap = nullptr;
+    space::MallocSpace* promo_dest_space = nullptr;
+    if (semi_space_->generational_ && !semi_space_->whole_heap_collection_) {
+      promo_dest_space = semi_space_->GetHeap()->GetPrimaryFreeListSpace();
+      promo_live_bitmap = promo_dest_space->GetLiveBitmap();
+    }
+    CopyTaskMarkObjectVisitor visitor(this);
+    for (Object* obj = mark_stack_.Pop(); obj != nullptr; obj = mark_stack_.Pop()) {
+      if (promo_live_bitmap != nullptr && promo_dest_space->HasAddress(obj)) {
+        // obj has just been promoted, see the serial ProcessMarkStack().
+        promo_live_bitmap->AtomicTestAndSet(obj);
+      }
+      DCHECK(!semi_space_->from_space_->HasAddress(obj)) << "Scanning object " << obj
+                                                        << " in from space";
+      obj->VisitReferences<kMovingClasses>(visitor, visitor);
+    }
+  }
+
+  SemiSpace* const semi_space_;
+  ThreadPool* const thread_pool_;
+  space::BumpPointerSpace* const to_space_;
+  // Thread local mark stack for this task.
+  WorkStealingMarkStack mark_stack_;
+  // The to-space buffer of the task, only used by the thread running it.
+  byte* plab_pos_;
+  byte* plab_end_;
+  // Counts the objects and dummy objects the task allocated in the to-space.
+  size_t objects_allocated_;
+  size_t bytes_allocated_;
+  size_t objects_moved_;
+  size_t bytes_moved_;
+  uint64_t bytes_promoted_;
+  size_t saved_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(SemiSpaceCopyTask);
+};
+
+size_t SemiSpace::GetThreadCount() const {
+  // The mutators are suspended for the whole collection.
+  if (GetHeap()->GetThreadPool() == nullptr) {
+    return 1;
+  }
+  return GetHeap()->GetParallelGCThreadCount() + 1;
+}
+
+void SemiSpace::ProcessMarkStackParallel(size_t thread_count) {
+  Thread* self = Thread::Current();
+  ThreadPool* thread_pool = GetHeap()->GetThreadPool();
+  const size_t chunk_size = std::min(mark_stack_->Size() / thread_count + 1,
+                                     WorkStealingMarkStack::kMaxSize);
+  // Split the current mark stack up into work tasks.
+  for (mirror::Object **it = mark_stack_->Begin(), **end = mark_stack_->End(); it < end; ) {
+    const size_t delta = std::min(static_cast<size_t>(end - it), chunk_size);
+    thread_pool->AddTask(self, new SemiSpaceCopyTask(thread_pool, this, delta, it));
+    it += delta;
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count - 1);
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
+  mark_stack_->Reset();
+}
+
 // Scan anything that's on the mark stack.
 void SemiSpace::ProcessMarkStack() {
+  // The copy tasks keep the to-space walkable with dummy objects, which only a bump pointer space
+  // supports.
+  const bool parallel = kParallelCopying && GetThreadCount() > 1 &&
+      to_space_->IsBumpPointerSpace();
   space::MallocSpace* promo_dest_space = nullptr;
   accounting::ContinuousSpaceBitmap* live_bitmap = nullptr;
   if (generational_ && !whole_heap_collection_) {
@@ -746,6 +1070,10 @@ void SemiSpace::ProcessMarkStack() {
   }
   timings_.StartSplit("ProcessMarkStack");
   while (!mark_stack_->IsEmpty()) {
+    if (parallel && mark_stack_->Size() >= kMinimumParallelMarkStackSize) {
+      ProcessMarkStackParallel(GetThreadCount());
+      break;
+    }
     Object* obj = mark_stack_->PopBack();
     if (generational_ && !whole_heap_collection_ && promo_dest_space->HasAddress(obj)) {
       // obj has just been promoted. Mark the live bitmap for it,
@@ -189,6 +189,14 @@ class SemiSpace : public GarbageCollector {
   void ProcessMarkStack()
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_, Locks::heap_bitmap_lock_);
 
+  // Blackens the objects on the mark stack with the GC thread pool, copying the objects they
+  // reference in parallel. Only used when the to-space is a bump pointer space.
+  void ProcessMarkStackParallel(size_t thread_count)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_, Locks::heap_bitmap_lock_);
+
+  // Returns how many threads may copy objects, including the GC thread.
+  size_t GetThreadCount() const;
+
   inline mirror::Object* GetForwardingAddressInFromSpace(mirror::Object* obj) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -251,6 +259,9 @@ class SemiSpace : public GarbageCollector {
   // How many bytes we avoided dirtying.
   size_t saved_bytes_;
 
+  // Guards the counters above while the parallel copy tasks add theirs.
+  Mutex copy_counters_lock_;
+
   // The name of the collector.
   std::string collector_name_;
 
@@ -264,6 +275,7 @@ class SemiSpace : public GarbageCollector {
 
  private:
   friend class BitmapSetSlowPathVisitor;
+  friend class SemiSpaceCopyTask;
   DISALLOW_COPY_AND_ASSIGN(SemiSpace);
 };
 
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "work_stealing_mark_stack.h"
+
+#include <sched.h>
+
+#include <algorithm>
+
+#include "base/mutex-inl.h"
+#include "thread-inl.h"
+
+namespace art {
+namespace gc {
+namespace collector {
+
+constexpr size_t WorkStealingMarkStack::kMaxSize;
+constexpr size_t WorkStealingMarkStack::kPublishThreshold;
+
+WorkStealingMarkStack::WorkStealingMarkStack(const char* lock_name, size_t size,
+                                             mirror::Object** objects)
+    : lock_(lock_name, kMarkSweepMarkStackLock), bottom_(0), split_(0), pos_(size) {
+  DCHECK_LE(size, kMaxSize);
+  if (size != 0) {
+    DCHECK(objects != nullptr);
+    std::copy(objects, objects + size, objects_);
+  }
+}
+
+void WorkStealingMarkStack::Publish() {
+  MutexLock mu(Thread::Current(), lock_);
+  split_ = pos_ - kPublishThreshold;
+}
+
+bool WorkStealingMarkStack::TakeBackPublished() {
+  MutexLock mu(Thread::Current(), lock_);
+  if (split_ == bottom_) {
+    return false;
+  }
+  split_ -= (split_ - bottom_ + 1) / 2;
+  return true;
+}
+
+mirror::Object** WorkStealingMarkStack::MakeRoom(Thread* self, size_t* count) {
+  {
+    MutexLock mu(self, lock_);
+    if (bottom_ != 0) {
+      std::copy(objects_ + bottom_, objects_ + pos_, objects_);
+      pos_ -= bottom_;
+      bottom_ = 0;
+    }
+    split_ = 0;
+  }
+  if (!IsFull()) {
+    return nullptr;
+  }
+  pos_ /= 2;
+  *count = kMaxSize - pos_;
+  return objects_ + pos_;
+}
+
+size_t WorkStealingMarkStack::StealFrom(Thread* self, WorkStealingMarkStack* victim) {
+  // Racy check to avoid contending on the lock of a victim which has nothing to give.
+  if (victim->split_ == victim->bottom_) {
+    sched_yield();
+    return 0;
+  }
+  {
+    MutexLock mu(self, lock_);
+    DCHECK(IsEmpty());
+    bottom_ = split_ = pos_ = 0;
+  }
+  size_t stolen = 0;
+  {
+    MutexLock mu(self, victim->lock_);
+    stolen = (victim->split_ - victim->bottom_ + 1) / 2;
+    mirror::Object** begin = victim->objects_ + victim->bottom_;
+    std::copy(begin, begin + stolen, objects_);
+    victim->bottom_ += stolen;
+  }
+  pos_ = stolen;
+  return stolen;
+}
+
+}  // namespace collector
+}  // namespace gc
+}  // namespace art
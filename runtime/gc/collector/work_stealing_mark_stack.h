@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_COLLECTOR_WORK_STEALING_MARK_STACK_H_
+#define ART_RUNTIME_GC_COLLECTOR_WORK_STEALING_MARK_STACK_H_
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "globals.h"
+
+namespace art {
+namespace mirror {
+class Object;
+}  // namespace mirror
+
+class Thread;
+
+namespace gc {
+namespace collector {
+
+// The thread local mark stack of a parallel collection task, from which the idle workers of a
+// WorkStealingThreadPool steal. [bottom, split) is published and may be stolen from the bottom,
+// [split, pos) is private to the thread running the task. Only the published part is guarded by
+// the lock, so the owner pushes and pops its private references without synchronization.
+class WorkStealingMarkStack {
+ public:
+  static constexpr size_t kMaxSize = 1 * KB;
+  // The owner keeps this many of its newest references private and publishes the older ones for
+  // idle workers to steal.
+  static constexpr size_t kPublishThreshold = 64;
+
+  // Starts with a copy of the `size` references at `objects`.
+  WorkStealingMarkStack(const char* lock_name, size_t size, mirror::Object** objects);
+
+  ~WorkStealingMarkStack() {
+    DCHECK(IsEmpty());
+  }
+
+  bool IsEmpty() const {
+    return pos_ == bottom_;
+  }
+
+  bool IsFull() const {
+    return pos_ == kMaxSize;
+  }
+
+  // The stack must not be full, see MakeRoom().
+  void Push(mirror::Object* obj) ALWAYS_INLINE {
+    DCHECK(obj != nullptr);
+    DCHECK_LT(pos_, kMaxSize);
+    objects_[pos_++] = obj;
+    if (UNLIKELY(pos_ - split_ >= 2 * kPublishThreshold)) {
+      Publish();
+    }
+  }
+
+  // Returns null once both the private and the published parts of the stack are empty.
+  mirror::Object* Pop() ALWAYS_INLINE {
+    if (UNLIKELY(pos_ == split_) && !TakeBackPublished()) {
+      return nullptr;
+    }
+    if (UNLIKELY(pos_ - split_ >= 2 * kPublishThreshold)) {
+      Publish();
+    }
+    return objects_[--pos_];
+  }
+
+  // Called when the stack is full. Takes back the published references and slides the stack
+  // down over the stolen ones. If the stack is still full, removes its newer half and returns
+  // it, with its size in `count`, for the caller to give to a new task: the references stay
+  // valid until the next push. Returns null otherwise.
+  mirror::Object** MakeRoom(Thread* self, size_t* count);
+
+  // Called by a worker which ran out of work, on its empty stack. Takes the older half of the
+  // published references of `victim`, and returns how many it took.
+  size_t StealFrom(Thread* self, WorkStealingMarkStack* victim);
+
+ private:
+  // Publishes the older private references, keeping kPublishThreshold of them private.
+  void Publish();
+
+  // Takes back the newer half of what the thieves left in the published part. Returns false if
+  // they left nothing.
+  bool TakeBackPublished();
+
+  // Guards the published part of the stack against thieves.
+  Mutex lock_;
+  mirror::Object* objects_[kMaxSize];
+  size_t bottom_;
+  size_t split_;
+  size_t pos_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingMarkStack);
+};
+
+}  // namespace collector
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_COLLECTOR_WORK_STEALING_MARK_STACK_H_
@@ -36,6 +36,8 @@ enum CollectorType {
   kCollectorTypeGSS,
   // Heap trimming collector, doesn't do any actual collecting.
   kCollectorTypeHeapTrim,
+  // Class histogram heap walk, doesn't do any actual collecting.
+  kCollectorTypeClassHistogram,
   // A (mostly) concurrent copying collector.
   kCollectorTypeCC,
 };
@@ -32,6 +32,9 @@ const char* PrettyCause(GcCause cause) {
     case kGcCauseCollectorTransition: return "CollectorTransition";
     case kGcCauseDisableMovingGc: return "DisableMovingGc";
     case kGcCauseTrim: return "HeapTrim";
+    case kGcCauseMetrics: return "Metrics";
+    case kGcCauseClassHistogram: return "ClassHistogram";
+    case kGcCauseHomogeneousSpaceCompact: return "HomogeneousSpaceCompact";
     default:
       LOG(FATAL) << "Unreachable";
   }
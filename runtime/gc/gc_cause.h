@@ -39,6 +39,12 @@ enum GcCause {
   kGcCauseDisableMovingGc,
   // Not a real GC cause, used when we trim the heap.
   kGcCauseTrim,
+  // Not a real GC cause, used when we dump the GC metrics.
+  kGcCauseMetrics,
+  // Not a real GC cause, used when we walk the heap for a class histogram.
+  kGcCauseClassHistogram,
+  // GC triggered for compacting the main space into the backup main space of an idle process.
+  kGcCauseHomogeneousSpaceCompact,
 };
 
 const char* PrettyCause(GcCause cause);
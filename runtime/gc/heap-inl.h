@@ -21,6 +21,7 @@
 
 #include "debugger.h"
 #include "gc/accounting/card_table-inl.h"
+#include "gc/allocation_sampler-inl.h"
 #include "gc/collector/semi_space.h"
 #include "gc/space/bump_pointer_space-inl.h"
 #include "gc/space/dlmalloc_space-inl.h"
@@ -59,8 +60,10 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self, mirror::Clas
                                             &usable_size);
   if (UNLIKELY(obj == nullptr)) {
     bool is_current_allocator = allocator == GetCurrentAllocator();
+    uint64_t slow_path_start_ns = NanoTime();
     obj = AllocateInternalWithGc(self, allocator, byte_count, &bytes_allocated, &usable_size,
                                  &klass);
+    self->GetLatencies()->alloc_slow_path_ns.Record(NanoTime() - slow_path_start_ns);
     if (obj == nullptr) {
       bool after_is_current_allocator = allocator == GetCurrentAllocator();
       if (is_current_allocator && !after_is_current_allocator) {
@@ -95,8 +98,13 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self, mirror::Clas
   if (kIsDebugBuild && Runtime::Current()->IsStarted()) {
     CHECK_LE(obj->SizeOf(), usable_size);
   }
-  const size_t new_num_bytes_allocated =
-      static_cast<size_t>(num_bytes_allocated_.FetchAndAdd(bytes_allocated)) + bytes_allocated;
+  // The bytes allocated in a TLAB are counted when it is refilled or revoked, as the quick
+  // entrypoints bump the TLAB pointer without coming here.
+  size_t new_num_bytes_allocated = 0u;
+  if (allocator != kAllocatorTypeTLAB) {
+    new_num_bytes_allocated =
+        static_cast<size_t>(num_bytes_allocated_.FetchAndAdd(bytes_allocated)) + bytes_allocated;
+  }
   // TODO: Deprecate.
   if (kInstrumented) {
     if (Runtime::Current()->HasStatsEnabled()) {
@@ -117,8 +125,12 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self, mirror::Clas
     if (Dbg::IsAllocTrackingEnabled()) {
       Dbg::RecordAllocation(klass, bytes_allocated);
     }
+    if (UNLIKELY(allocation_sampler_.IsEnabled())) {
+      allocation_sampler_.RecordAllocation(self, bytes_allocated);
+    }
   } else {
     DCHECK(!Dbg::IsAllocTrackingEnabled());
+    DCHECK(!allocation_sampler_.IsEnabled());
   }
   // IsConcurrentGc() isn't known at compile time so we can optimize by not checking it for
   // the BumpPointer or TLAB allocators. This is nice since it allows the entire if statement to be
@@ -188,6 +200,9 @@ inline mirror::Object* Heap::TryToAllocate(Thread* self, AllocatorType allocator
     case kAllocatorTypeBumpPointer: {
       DCHECK(bump_pointer_space_ != nullptr);
       alloc_size = RoundUp(alloc_size, space::BumpPointerSpace::kAlignment);
+      if (UNLIKELY(IsNurseryFull<kGrow>(alloc_size))) {
+        return nullptr;
+      }
       ret = bump_pointer_space_->AllocNonvirtual(alloc_size);
       if (LIKELY(ret != nullptr)) {
         *bytes_allocated = alloc_size;
@@ -232,7 +247,14 @@ inline mirror::Object* Heap::TryToAllocate(Thread* self, AllocatorType allocator
       if (UNLIKELY(self->TlabSize() < alloc_size)) {
         // Try allocating a new thread local buffer, if the allocaiton fails the space must be
         // full so return nullptr.
-        if (!bump_pointer_space_->AllocNewTlab(self, alloc_size + kDefaultTLABSize)) {
+        const size_t tlab_size = NextTlabSize(self);
+        if (UNLIKELY(IsNurseryFull<kGrow>(alloc_size + tlab_size))) {
+          return nullptr;
+        }
+        // The bytes of the old buffer are counted as it is retired, see AllocObjectWithAllocator.
+        RetireTlab(self);
+        tlab_refill_count_.FetchAndAdd(1);
+        if (!bump_pointer_space_->AllocNewTlab(self, alloc_size + tlab_size)) {
           return nullptr;
         }
       }
@@ -297,10 +319,17 @@ inline bool Heap::IsOutOfMemoryOnAllocation(AllocatorType allocator_type, size_t
   return false;
 }
 
+template <bool kGrow>
+inline bool Heap::IsNurseryFull(size_t alloc_size) const {
+  return !kGrow && bump_pointer_space_->Size() + alloc_size > nursery_limit_;
+}
+
 inline void Heap::CheckConcurrentGC(Thread* self, size_t new_num_bytes_allocated,
                                     mirror::Object** obj) {
   if (UNLIKELY(new_num_bytes_allocated >= concurrent_start_bytes_)) {
     RequestConcurrentGCAndSaveObject(self, obj);
+  } else if (UNLIKELY(new_num_bytes_allocated >= allocation_pacing_start_bytes_)) {
+    PaceAllocationAndSaveObject(self, new_num_bytes_allocated, obj);
   }
 }
 
@@ -18,13 +18,18 @@
 
 #define ATRACE_TAG ATRACE_TAG_DALVIK
 #include <cutils/trace.h>
+#include <stdlib.h>
 
+#include <algorithm>
 #include <limits>
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
 #include "base/histogram-inl.h"
 #include "base/stl_util.h"
+#include "base/systrace.h"
+#include "base/unix_file/fd_file.h"
 #include "common_throws.h"
 #include "cutils/sched_policy.h"
 #include "debugger.h"
@@ -53,6 +58,7 @@
 #include "image.h"
 #include "mirror/art_field-inl.h"
 #include "mirror/class-inl.h"
+#include "mirror/dex_cache.h"
 #include "mirror/object.h"
 #include "mirror/object-inl.h"
 #include "mirror/object_array-inl.h"
@@ -78,6 +84,11 @@ static constexpr size_t kGcAlotInterval = KB;
 // Minimum amount of remaining bytes before a concurrent GC is triggered.
 static constexpr size_t kMinConcurrentRemainingBytes = 128 * KB;
 static constexpr size_t kMaxConcurrentRemainingBytes = 512 * KB;
+// Number of pauses of the allocations made in the second half of the headroom left when a
+// concurrent GC starts, and the longest pause, for the allocations at the footprint limit.
+static constexpr size_t kAllocationPacingSteps = 16;
+static constexpr size_t kMinAllocationPacingStepBytes = 64 * KB;
+static constexpr uint64_t kMaxAllocationPacingPauseNs = MsToNs(2);
 // Sticky GC throughput adjustment, divided by 4. Increasing this causes sticky GC to occur more
 // relative to partial/full GC. This may be desirable since sticky GCs interfere less with mutator
 // threads (lower pauses, use less memory bandwidth).
@@ -89,19 +100,22 @@ static constexpr bool kCompactZygote = kMovingCollector;
 static constexpr size_t kNonMovingSpaceCapacity = 64 * MB;
 
 Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max_free,
-           double target_utilization, double foreground_heap_growth_multiplier, size_t capacity,
-           const std::string& image_file_name, const InstructionSet image_instruction_set,
+           double target_utilization, double foreground_heap_growth_multiplier,
+           double target_gc_time_ratio, size_t capacity, const std::string& image_file_name,
+           const InstructionSet image_instruction_set,
            CollectorType foreground_collector_type, CollectorType background_collector_type,
-           size_t parallel_gc_threads, size_t conc_gc_threads, bool low_memory_mode,
-           size_t long_pause_log_threshold, size_t long_gc_log_threshold,
+           size_t parallel_gc_threads, size_t conc_gc_threads, bool pin_gc_threads,
+           bool low_memory_mode, size_t long_pause_log_threshold, size_t long_gc_log_threshold,
            bool ignore_max_footprint, bool use_tlab,
            bool verify_pre_gc_heap, bool verify_pre_sweeping_heap, bool verify_post_gc_heap,
            bool verify_pre_gc_rosalloc, bool verify_pre_sweeping_rosalloc,
-           bool verify_post_gc_rosalloc)
+           bool verify_post_gc_rosalloc, uint64_t sampled_verification_budget,
+           const std::string& gc_metrics_file)
     : non_moving_space_(nullptr),
       rosalloc_space_(nullptr),
       dlmalloc_space_(nullptr),
       main_space_(nullptr),
+      main_space_backup_(nullptr),
       collector_type_(kCollectorTypeNone),
       foreground_collector_type_(foreground_collector_type),
       background_collector_type_(background_collector_type),
@@ -110,8 +124,14 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
       last_trim_time_(0),
       heap_transition_target_time_(0),
       heap_trim_request_pending_(false),
+      idle_check_pending_(false),
+      idle_check_target_time_(0),
+      idle_check_bytes_allocated_(0),
+      allocation_prefault_pending_(false),
+      heap_trim_signal_count_(0),
       parallel_gc_threads_(parallel_gc_threads),
       conc_gc_threads_(conc_gc_threads),
+      pin_gc_threads_(pin_gc_threads),
       low_memory_mode_(low_memory_mode),
       long_pause_log_threshold_(long_pause_log_threshold),
       long_gc_log_threshold_(long_gc_log_threshold),
@@ -126,14 +146,25 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
       max_allowed_footprint_(initial_size),
       native_footprint_gc_watermark_(initial_size),
       native_footprint_limit_(2 * initial_size),
+      native_concurrent_start_bytes_(initial_size),
       native_need_to_run_finalization_(false),
       // Initially assume we perceive jank in case the process state is never updated.
       process_state_(kProcessStateJankPerceptible),
       concurrent_start_bytes_(std::numeric_limits<size_t>::max()),
+      allocation_pacing_start_bytes_(std::numeric_limits<size_t>::max()),
+      allocation_pacing_begin_bytes_(0),
+      allocation_pacing_step_bytes_(0),
       total_bytes_freed_ever_(0),
       total_objects_freed_ever_(0),
       num_bytes_allocated_(0),
       native_bytes_allocated_(0),
+      native_bytes_registered_ever_(0),
+      last_gc_native_bytes_registered_(0),
+      native_concurrent_gc_request_count_(0),
+      native_blocking_gc_count_(0),
+      gc_count_(0),
+      tlab_refill_count_(0),
+      tlab_wasted_bytes_(0),
       gc_memory_overhead_(0),
       verify_missing_card_marks_(false),
       verify_system_weaks_(false),
@@ -144,7 +175,16 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
       verify_pre_gc_rosalloc_(verify_pre_gc_rosalloc),
       verify_pre_sweeping_rosalloc_(verify_pre_sweeping_rosalloc),
       verify_post_gc_rosalloc_(verify_post_gc_rosalloc),
+      sampled_verification_budget_(sampled_verification_budget),
+      sampled_verification_seed_(static_cast<unsigned int>(NanoTime())),
       allocation_rate_(0),
+      native_allocation_rate_(0),
+      last_gc_duration_ns_(0),
+      heap_growth_count_(0),
+      heap_shrink_count_(0),
+      homogeneous_space_compact_count_(0),
+      gc_metrics_file_(gc_metrics_file),
+      last_gc_metrics_write_ns_(0),
       /* For GC a lot mode, we limit the allocations stacks to be kGcAlotInterval allocations. This
        * causes a lot of GC since we do a GC for alloc whenever the stack is full. When heap
        * verification is enabled, we limit the size of allocation stacks to speed up their
@@ -156,11 +196,15 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
       current_non_moving_allocator_(kAllocatorTypeNonMoving),
       bump_pointer_space_(nullptr),
       temp_space_(nullptr),
+      nursery_limit_(std::numeric_limits<size_t>::max()),
       min_free_(min_free),
       max_free_(max_free),
       target_utilization_(target_utilization),
       foreground_heap_growth_multiplier_(foreground_heap_growth_multiplier),
+      target_gc_time_ratio_(target_gc_time_ratio),
       total_wait_time_(0),
+      allocation_pacing_count_(0),
+      total_allocation_pacing_time_(0),
       total_allocation_time_(0),
       verify_object_mode_(kVerifyObjectModeDisabled),
       disable_moving_gc_count_(0),
@@ -169,6 +213,16 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
   if (VLOG_IS_ON(heap) || VLOG_IS_ON(startup)) {
     LOG(INFO) << "Heap() entering";
   }
+  if (foreground_collector_type_ == kCollectorTypeCC) {
+    if (!kUseBrooksReadBarrier) {
+      LOG(WARNING) << "Concurrent copying requires the Brooks read barrier, using semi-space";
+      foreground_collector_type_ = kCollectorTypeSS;
+      desired_collector_type_ = foreground_collector_type_;
+    } else {
+      // Compiled code doesn't have read barriers yet.
+      Runtime::Current()->GetInstrumentation()->ForceInterpretOnly();
+    }
+  }
   const bool is_zygote = Runtime::Current()->IsZygote();
   // If we aren't the zygote, switch to the default non zygote allocator. This may update the
   // entrypoints.
@@ -195,7 +249,9 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
     // isn't going to get in the middle
     byte* oat_file_end_addr = image_space->GetImageHeader().GetOatFileEnd();
     CHECK_GT(oat_file_end_addr, image_space->End());
-    requested_alloc_space_begin = AlignUp(oat_file_end_addr, kPageSize);
+    // Start the alloc space on a huge page when they are used, so that none of it is left out.
+    size_t alignment = MemMap::HugePagesEnabled() ? MemMap::kHugePageSize : kPageSize;
+    requested_alloc_space_begin = AlignUp(oat_file_end_addr, alignment);
   }
   if (is_zygote) {
     // Reserve the address range before we create the non moving space to make sure bitmaps don't
@@ -205,6 +261,7 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
         "main space", requested_alloc_space_begin + kNonMovingSpaceCapacity, capacity,
         PROT_READ | PROT_WRITE, true, &error_str);
     CHECK(mem_map != nullptr) << error_str;
+    mem_map->AdviseHugePages();
     // Non moving space is always dlmalloc since we currently don't have support for multiple
     // rosalloc spaces.
     non_moving_space_ = space::DlMallocSpace::Create(
@@ -212,11 +269,26 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
         requested_alloc_space_begin, false);
     non_moving_space_->SetFootprintLimit(non_moving_space_->Capacity());
     CreateMainMallocSpace(mem_map, initial_size, growth_limit, capacity);
+    if (kUseHomogeneousSpaceCompaction) {
+      // Reserve the backup space right after the main space so that the card table stays small.
+      MemMap* backup_mem_map = MemMap::MapAnonymous("main space (backup)", mem_map->End(),
+                                                    capacity, PROT_READ | PROT_WRITE, true,
+                                                    &error_str);
+      if (backup_mem_map != nullptr) {
+        backup_mem_map->AdviseHugePages();
+        main_space_backup_ = CreateMallocSpaceFromMemMap(backup_mem_map, initial_size,
+                                                         growth_limit, capacity,
+                                                         "main space (backup)", true);
+      } else {
+        LOG(WARNING) << "Disabling homogeneous space compaction: " << error_str;
+      }
+    }
   } else {
     std::string error_str;
     MemMap* mem_map = MemMap::MapAnonymous("main/non-moving space", requested_alloc_space_begin,
                                            capacity, PROT_READ | PROT_WRITE, true, &error_str);
     CHECK(mem_map != nullptr) << error_str;
+    mem_map->AdviseHugePages();
     // Create the main free list space, which doubles as the non moving space. We can do this since
     // non zygote means that we won't have any background compaction.
     CreateMainMallocSpace(mem_map, initial_size, growth_limit, capacity);
@@ -248,6 +320,10 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
   if (main_space_ != nullptr) {
     AddSpace(main_space_);
   }
+  if (main_space_backup_ != nullptr) {
+    // Only added so that the card table covers it.
+    AddSpace(main_space_backup_);
+  }
 
   // Allocate the large object space.
   if (kUseFreeListSpaceForLOS) {
@@ -269,12 +345,16 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
   // Allocate the card table.
   card_table_.reset(accounting::CardTable::Create(heap_begin, heap_capacity));
   CHECK(card_table_.get() != NULL) << "Failed to create card table";
+  if (main_space_backup_ != nullptr) {
+    // The spare space isn't allocated into, don't let the GC visit it.
+    RemoveSpace(main_space_backup_);
+  }
 
-  // Card cache for now since it makes it easier for us to update the references to the copying
-  // spaces.
+  // Marks the references the image objects hold to the other spaces, which lets the moving
+  // collectors update them.
   accounting::ModUnionTable* mod_union_table =
-      new accounting::ModUnionTableToZygoteAllocspace("Image mod-union table", this,
-                                                      GetImageSpace());
+      new accounting::ModUnionTableReferenceBitmap("Image mod-union table", this,
+                                                   GetImageSpace());
   CHECK(mod_union_table != nullptr) << "Failed to create image mod-union table";
   AddModUnionTable(mod_union_table);
 
@@ -309,6 +389,8 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
   gc_complete_cond_.reset(new ConditionVariable("GC complete condition variable",
                                                 *gc_complete_lock_));
   heap_trim_request_lock_ = new Mutex("Heap trim request lock");
+  heap_trim_request_cond_.reset(new ConditionVariable("Heap trim request condition variable",
+                                                      *heap_trim_request_lock_));
   last_gc_size_ = GetBytesAllocated();
 
   if (ignore_max_footprint_) {
@@ -344,6 +426,24 @@ Heap::Heap(size_t initial_size, size_t growth_limit, size_t min_free, size_t max
   }
 }
 
+space::MallocSpace* Heap::CreateMallocSpaceFromMemMap(MemMap* mem_map, size_t initial_size,
+                                                      size_t growth_limit, size_t capacity,
+                                                      const char* name, bool can_move_objects) {
+  space::MallocSpace* malloc_space = nullptr;
+  if (kUseRosAlloc) {
+    malloc_space = space::RosAllocSpace::CreateFromMemMap(
+        mem_map, name, kDefaultStartingSize, initial_size, growth_limit, capacity,
+        low_memory_mode_, can_move_objects);
+  } else {
+    malloc_space = space::DlMallocSpace::CreateFromMemMap(
+        mem_map, name, kDefaultStartingSize, initial_size, growth_limit, capacity,
+        can_move_objects);
+  }
+  CHECK(malloc_space != nullptr) << "Failed to create " << name;
+  malloc_space->SetFootprintLimit(malloc_space->Capacity());
+  return malloc_space;
+}
+
 void Heap::CreateMainMallocSpace(MemMap* mem_map, size_t initial_size, size_t growth_limit,
                                  size_t capacity) {
   // Is background compaction is enabled?
@@ -358,20 +458,19 @@ void Heap::CreateMainMallocSpace(MemMap* mem_map, size_t initial_size, size_t gr
     // that getting primitive array elements is faster.
     can_move_objects = !have_zygote_space_;
   }
+  // The zygote and its children have a separate non moving space, so the main space can be
+  // compacted into the backup space when the process is idle.
+  if (kUseHomogeneousSpaceCompaction && Runtime::Current()->IsZygote()) {
+    can_move_objects = true;
+  }
+  main_space_ = CreateMallocSpaceFromMemMap(
+      mem_map, initial_size, growth_limit, capacity,
+      kUseRosAlloc ? "main rosalloc space" : "main dlmalloc space", can_move_objects);
   if (kUseRosAlloc) {
-    rosalloc_space_ = space::RosAllocSpace::CreateFromMemMap(
-        mem_map, "main rosalloc space", kDefaultStartingSize, initial_size, growth_limit, capacity,
-        low_memory_mode_, can_move_objects);
-    main_space_ = rosalloc_space_;
-    CHECK(main_space_ != nullptr) << "Failed to create rosalloc space";
+    rosalloc_space_ = main_space_->AsRosAllocSpace();
   } else {
-    dlmalloc_space_ = space::DlMallocSpace::CreateFromMemMap(
-        mem_map, "main dlmalloc space", kDefaultStartingSize, initial_size, growth_limit, capacity,
-        can_move_objects);
-    main_space_ = dlmalloc_space_;
-    CHECK(main_space_ != nullptr) << "Failed to create dlmalloc space";
+    dlmalloc_space_ = main_space_->AsDlMallocSpace();
   }
-  main_space_->SetFootprintLimit(main_space_->Capacity());
   VLOG(heap) << "Created main space " << main_space_;
 }
 
@@ -533,7 +632,10 @@ void Heap::UpdateProcessState(ProcessState process_state) {
 void Heap::CreateThreadPool() {
   const size_t num_threads = std::max(parallel_gc_threads_, conc_gc_threads_);
   if (num_threads != 0) {
-    thread_pool_.reset(new ThreadPool("Heap thread pool", num_threads));
+    thread_pool_.reset(new WorkStealingThreadPool("Heap thread pool", num_threads));
+    if (pin_gc_threads_) {
+      thread_pool_->PinWorkers();
+    }
   }
 }
 
@@ -719,10 +821,104 @@ void Heap::DumpGcPerformanceInfo(std::ostream& os) {
   }
   os << "Total mutator paused time: " << PrettyDuration(total_paused_time) << "\n";
   os << "Total time waiting for GC to complete: " << PrettyDuration(total_wait_time_) << "\n";
+  os << "Allocations paced: " << allocation_pacing_count_
+     << " total pacing time: " << PrettyDuration(total_allocation_pacing_time_) << "\n";
+  os << "Native bytes allocated: " << PrettySize(native_bytes_allocated_.Load())
+     << " native allocation rate: " << PrettySize(native_allocation_rate_) << "/s\n";
+  os << "Concurrent GCs requested for native allocations: "
+     << native_concurrent_gc_request_count_.Load()
+     << " blocking GCs for native allocations: " << native_blocking_gc_count_.Load() << "\n";
+  if (tlab_refill_count_.Load() != 0) {
+    os << "TLABs allocated: " << tlab_refill_count_.Load()
+       << " TLAB bytes wasted: " << PrettySize(tlab_wasted_bytes_.Load()) << "\n";
+  }
+  reference_processor_.DumpStats(os);
   os << "Approximate GC data structures memory overhead: " << gc_memory_overhead_;
   BaseMutex::DumpAll(os);
 }
 
+void Heap::DumpGcMetrics(std::ostream& os) {
+  Thread* self = Thread::Current();
+  ScopedThreadStateChange tsc(self, kWaitingForGcToComplete);
+  MutexLock mu(self, *gc_complete_lock_);
+  // No GC can start while we hold the lock, wait for the running one so that the collector
+  // measurements are consistent.
+  WaitForGcToCompleteLocked(kGcCauseMetrics, self);
+  DumpGcMetricsLocked(os);
+}
+
+void Heap::DumpGcMetricsLocked(std::ostream& os) {
+  os << "heap.time_ns " << NanoTime() << "\n"
+     << "heap.bytes_allocated " << GetBytesAllocated() << "\n"
+     << "heap.bytes_allocated_ever " << GetBytesAllocatedEver() << "\n"
+     << "heap.objects_allocated_ever " << GetObjectsAllocatedEver() << "\n"
+     << "heap.bytes_freed_ever " << GetBytesFreedEver() << "\n"
+     << "heap.objects_freed_ever " << GetObjectsFreedEver() << "\n"
+     << "heap.allocation_rate_bytes_per_s " << allocation_rate_ << "\n"
+     << "heap.footprint_limit " << max_allowed_footprint_ << "\n"
+     << "heap.total_memory " << GetTotalMemory() << "\n"
+     << "heap.growth_count " << heap_growth_count_ << "\n"
+     << "heap.shrink_count " << heap_shrink_count_ << "\n"
+     << "heap.homogeneous_space_compact_count " << homogeneous_space_compact_count_ << "\n"
+     << "heap.gc_wait_time_ns " << total_wait_time_ << "\n"
+     << "heap.allocation_pacing_count " << allocation_pacing_count_ << "\n"
+     << "heap.allocation_pacing_time_ns " << total_allocation_pacing_time_ << "\n"
+     << "heap.native_bytes_allocated " << native_bytes_allocated_.Load() << "\n"
+     << "heap.native_allocation_rate_bytes_per_s " << native_allocation_rate_ << "\n"
+     << "heap.native_concurrent_gc_requests " << native_concurrent_gc_request_count_.Load() << "\n"
+     << "heap.native_blocking_gcs " << native_blocking_gc_count_.Load() << "\n"
+     << "heap.tlabs_allocated " << tlab_refill_count_.Load() << "\n"
+     << "heap.tlab_wasted_bytes " << tlab_wasted_bytes_.Load() << "\n";
+  for (const auto& collector : garbage_collectors_) {
+    const size_t iterations = collector->GetIterations();
+    if (iterations == 0) {
+      continue;
+    }
+    std::string name(collector->GetName());
+    std::replace(name.begin(), name.end(), ' ', '_');
+    const std::string prefix = "gc." + name + ".";
+    const Histogram<uint64_t>& pause_histogram = collector->GetPauseHistogram();
+    os << prefix << "iterations " << iterations << "\n"
+       << prefix << "total_time_ns " << collector->GetCumulativeTimings().GetTotalNs() << "\n"
+       << prefix << "freed_bytes " << collector->GetTotalFreedBytes() << "\n"
+       << prefix << "freed_objects " << collector->GetTotalFreedObjects() << "\n"
+       << prefix << "pause_count " << pause_histogram.SampleSize() << "\n";
+    if (pause_histogram.SampleSize() != 0) {
+      // The pause histogram records microseconds.
+      os << prefix << "pause_total_us " << pause_histogram.Sum() << "\n"
+         << prefix << "pause_max_us " << pause_histogram.Max() << "\n"
+         << prefix << "pause_histogram_us ";
+      pause_histogram.DumpBins(os);
+      os << "\n";
+    }
+  }
+}
+
+void Heap::MaybeWriteGcMetricsFile() {
+  const uint64_t now = NanoTime();
+  if (gc_metrics_file_.empty() || now - last_gc_metrics_write_ns_ < kGcMetricsWriteIntervalNs) {
+    return;
+  }
+  last_gc_metrics_write_ns_ = now;
+  std::ostringstream oss;
+  DumpGcMetricsLocked(oss);
+  const std::string metrics = oss.str();
+  // Write to a temporary file and rename it so that readers never see a partial file.
+  const std::string temp_file = gc_metrics_file_ + ".tmp";
+  std::unique_ptr<File> file(OS::CreateEmptyFile(temp_file.c_str()));
+  if (file.get() == nullptr) {
+    PLOG(WARNING) << "Failed to create GC metrics file " << temp_file;
+    return;
+  }
+  if (!file->WriteFully(metrics.data(), metrics.size()) || file->Close() != 0) {
+    PLOG(WARNING) << "Failed to write GC metrics file " << temp_file;
+    return;
+  }
+  if (rename(temp_file.c_str(), gc_metrics_file_.c_str()) != 0) {
+    PLOG(WARNING) << "Failed to rename " << temp_file << " to " << gc_metrics_file_;
+  }
+}
+
 Heap::~Heap() {
   VLOG(heap) << "Starting ~Heap()";
   STLDeleteElements(&garbage_collectors_);
@@ -733,6 +929,7 @@ Heap::~Heap() {
   STLDeleteValues(&remembered_sets_);
   STLDeleteElements(&continuous_spaces_);
   STLDeleteElements(&discontinuous_spaces_);
+  delete main_space_backup_;
   delete gc_complete_lock_;
   delete heap_trim_request_lock_;
   VLOG(heap) << "Finished ~Heap()";
@@ -818,6 +1015,34 @@ void Heap::ThrowOutOfMemoryError(Thread* self, size_t byte_count, bool large_obj
 
 void Heap::DoPendingTransitionOrTrim() {
   Thread* self = Thread::Current();
+  // Stay on the daemon until a pending idle check is done, nothing else wakes it up in an idle
+  // process. Requests made meanwhile interrupt the wait.
+  uint64_t signal_count;
+  do {
+    {
+      MutexLock mu(self, *heap_trim_request_lock_);
+      signal_count = heap_trim_signal_count_;
+    }
+    DoPendingHeapTasks(self);
+  } while (WaitForPendingIdleCheck(self, signal_count));
+}
+
+bool Heap::WaitForPendingIdleCheck(Thread* self, uint64_t signal_count) {
+  ScopedThreadStateChange tsc(self, kSleeping);
+  MutexLock mu(self, *heap_trim_request_lock_);
+  const uint64_t current_time = NanoTime();
+  if (!idle_check_pending_ || current_time >= idle_check_target_time_) {
+    // An overdue check was held back by a transition or prefault, the next request retries it.
+    return false;
+  }
+  if (heap_trim_signal_count_ == signal_count) {
+    const uint64_t wait_time = idle_check_target_time_ - current_time;
+    heap_trim_request_cond_->TimedWait(self, wait_time / MsToNs(1), wait_time % MsToNs(1));
+  }
+  return true;
+}
+
+void Heap::DoPendingHeapTasks(Thread* self) {
   CollectorType desired_collector_type;
   // Wait until we reach the desired transition time.
   while (true) {
@@ -837,6 +1062,8 @@ void Heap::DoPendingTransitionOrTrim() {
   // Transition the collector if the desired collector type is not the same as the current
   // collector type.
   TransitionCollector(desired_collector_type);
+  DoPendingAllocationPrefault(self);
+  DoPendingIdleCheck(self);
   if (!CareAboutPauseTimes()) {
     // Deflate the monitors, this can cause a pause but shouldn't matter since we don't care
     // about pauses.
@@ -859,6 +1086,7 @@ void Heap::Trim() {
     last_trim_time_ = NanoTime();
     heap_trim_request_pending_ = false;
   }
+  ScopedTrace trace(__FUNCTION__);
   {
     // Need to do this before acquiring the locks since we don't want to get suspended while
     // holding any locks.
@@ -882,6 +1110,7 @@ void Heap::Trim() {
       managed_reclaimed += alloc_space->Trim();
     }
   }
+  managed_reclaimed += large_object_space_->Trim();
   total_alloc_space_allocated = GetBytesAllocated() - large_object_space_->GetBytesAllocated();
   if (bump_pointer_space_ != nullptr) {
     total_alloc_space_allocated -= bump_pointer_space_->Size();
@@ -903,6 +1132,91 @@ void Heap::Trim() {
       << "%.";
 }
 
+bool Heap::PerformHomogeneousSpaceCompact() {
+  Thread* self = Thread::Current();
+  ScopedThreadStateChange tsc(self, kWaitingPerformingGc);
+  Locks::mutator_lock_->AssertNotHeld(self);
+  {
+    ScopedThreadStateChange tsc(self, kWaitingForGcToComplete);
+    MutexLock mu(self, *gc_complete_lock_);
+    // Ensure there is only one GC at a time.
+    WaitForGcToCompleteLocked(kGcCauseHomogeneousSpaceCompact, self);
+    // The backup space may have been used by a collector transition, and GetPrimitiveArrayCritical
+    // callers may hold pointers into the main space.
+    if (main_space_backup_ == nullptr || disable_moving_gc_count_ != 0 ||
+        IsMovingGc(collector_type_)) {
+      return false;
+    }
+    collector_type_running_ = kCollectorTypeSS;
+  }
+  if (Runtime::Current()->IsShuttingDown(self)) {
+    // Don't allow the compaction to happen if the runtime is shutting down since it can cause
+    // objects to get finalized.
+    FinishGC(self, collector::kGcTypeNone);
+    return false;
+  }
+  uint64_t start_time = NanoTime();
+  const size_t before_size = main_space_->Size();
+  ThreadList* tl = Runtime::Current()->GetThreadList();
+  tl->SuspendAll();
+  space::MallocSpace* to_space = main_space_backup_;
+  space::MallocSpace* from_space = main_space_;
+  to_space->GetMemMap()->Protect(PROT_READ | PROT_WRITE);
+  if (collector::SemiSpace::kUseRememberedSet) {
+    // The remembered set follows the main space to its new location.
+    accounting::RememberedSet* main_space_rem_set = FindRememberedSetFromSpace(from_space);
+    CHECK(main_space_rem_set != nullptr);
+    RemoveRememberedSet(from_space);
+    delete main_space_rem_set;
+  }
+  AddSpace(to_space);
+  Compact(to_space, from_space, kGcCauseHomogeneousSpaceCompact);
+  RemoveSpace(from_space);
+  main_space_ = to_space;
+  main_space_backup_ = from_space;
+  SetSpaceAsDefault(main_space_);
+  if (collector::SemiSpace::kUseRememberedSet) {
+    accounting::RememberedSet* main_space_rem_set =
+        new accounting::RememberedSet("Main space remembered set", this, main_space_);
+    CHECK(main_space_rem_set != nullptr) << "Failed to create main space remembered set";
+    AddRememberedSet(main_space_rem_set);
+  }
+  ++homogeneous_space_compact_count_;
+  tl->ResumeAll();
+  // Can't call into java code with all threads suspended.
+  reference_processor_.EnqueueClearedReferences();
+  uint64_t duration = NanoTime() - start_time;
+  GrowForUtilization(semi_space_collector_);
+  FinishGC(self, collector::kGcTypeFull);
+  LOG(INFO) << "Heap homogeneous space compaction took " << PrettyDuration(duration) << " size: "
+      << PrettySize(before_size) << " -> " << PrettySize(main_space_->Size()) << " from "
+      << from_space->GetName() << " to " << to_space->GetName();
+  return true;
+}
+
+bool Heap::IsMainSpaceFragmented() {
+  if (main_space_ == nullptr) {
+    return false;
+  }
+  const size_t size = main_space_->Size();
+  const size_t allocated = main_space_->GetBytesAllocated();
+  if (size <= allocated || size - allocated < kHomogeneousSpaceCompactMinFree) {
+    return false;
+  }
+  return static_cast<double>(allocated) <
+      kHomogeneousSpaceCompactUtilization * static_cast<double>(size);
+}
+
+bool Heap::HasRunnableMutators(Thread* self) {
+  MutexLock mu(self, *Locks::thread_list_lock_);
+  for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+    if (thread != self && thread->GetState() == kRunnable) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool Heap::IsValidObjectAddress(const mirror::Object* obj) const {
   // Note: we deliberately don't take the lock here, and mustn't test anything that would require
   // taking the lock.
@@ -1252,6 +1566,185 @@ void Heap::GetInstances(mirror::Class* c, int32_t max_count,
   self->EndAssertNoThreadSuspension(old_cause);
 }
 
+// Adds the objects it visits to a class histogram or, with a set of retaining classes, the arrays
+// referenced by the instances of these classes to the retained bytes of the classes.
+class ClassHistogramVisitor {
+ public:
+  ClassHistogramVisitor(Heap::ClassHistogram* histogram,
+                        const std::set<mirror::Class*>* retaining_classes)
+      : histogram_(histogram), retaining_classes_(retaining_classes), retaining_entry_(nullptr) {
+  }
+
+  static void Callback(mirror::Object* obj, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_, Locks::heap_bitmap_lock_) {
+    reinterpret_cast<ClassHistogramVisitor*>(arg)->operator()(obj);
+  }
+
+  // For bitmap Visit.
+  void operator()(mirror::Object* obj) const NO_THREAD_SAFETY_ANALYSIS {
+    mirror::Class* klass = obj->GetClass();
+    if (retaining_classes_ == nullptr) {
+      Heap::ClassHistogramEntry& entry = (*histogram_)[klass];
+      ++entry.count;
+      entry.bytes += obj->SizeOf();
+    } else if (retaining_classes_->find(klass) != retaining_classes_->end()) {
+      retaining_entry_ = &(*histogram_)[klass];
+      obj->VisitReferences<false>(*this, VoidFunctor());
+    }
+  }
+
+  // For Object::VisitReferences.
+  void operator()(mirror::Object* obj, MemberOffset offset, bool /* is_static */) const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    mirror::Object* ref = obj->GetFieldObject<mirror::Object>(offset);
+    if (ref != nullptr && ref->IsArrayInstance()) {
+      retaining_entry_->retained_bytes += ref->SizeOf();
+    }
+  }
+
+ private:
+  Heap::ClassHistogram* const histogram_;
+  const std::set<mirror::Class*>* const retaining_classes_;
+  mutable Heap::ClassHistogramEntry* retaining_entry_;
+};
+
+static void MergeClassHistogram(const Heap::ClassHistogram& from, Heap::ClassHistogram* to) {
+  for (const auto& from_entry : from) {
+    Heap::ClassHistogramEntry& entry = (*to)[from_entry.first];
+    entry.count += from_entry.second.count;
+    entry.bytes += from_entry.second.bytes;
+    entry.retained_bytes += from_entry.second.retained_bytes;
+  }
+}
+
+// Walks a range of a live bitmap into a histogram of its own, merged into the result at the end.
+class ClassHistogramTask : public Task {
+ public:
+  ClassHistogramTask(accounting::ContinuousSpaceBitmap* bitmap, uintptr_t begin, uintptr_t end,
+                     const std::set<mirror::Class*>* retaining_classes, Mutex* lock,
+                     Heap::ClassHistogram* result)
+      : bitmap_(bitmap), begin_(begin), end_(end), retaining_classes_(retaining_classes),
+        lock_(lock), result_(result) {
+  }
+
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    Heap::ClassHistogram histogram;
+    ClassHistogramVisitor visitor(&histogram, retaining_classes_);
+    bitmap_->VisitMarkedRange(begin_, end_, visitor);
+    MutexLock mu(self, *lock_);
+    MergeClassHistogram(histogram, result_);
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  accounting::ContinuousSpaceBitmap* const bitmap_;
+  const uintptr_t begin_;
+  const uintptr_t end_;
+  const std::set<mirror::Class*>* const retaining_classes_;
+  Mutex* const lock_;
+  Heap::ClassHistogram* const result_;
+};
+
+void Heap::AddToClassHistogram(ThreadPool* thread_pool,
+                               const std::set<mirror::Class*>* retaining_classes,
+                               ClassHistogram* histogram) {
+  // The objects which aren't in the continuous space bitmaps are visited by this thread, as in
+  // VisitObjects.
+  ClassHistogramVisitor visitor(histogram, retaining_classes);
+  if (bump_pointer_space_ != nullptr) {
+    bump_pointer_space_->Walk(ClassHistogramVisitor::Callback, &visitor);
+  }
+  for (mirror::Object** it = allocation_stack_->Begin(), **end = allocation_stack_->End();
+      it < end; ++it) {
+    mirror::Object* obj = *it;
+    if (obj != nullptr && obj->GetClass() != nullptr) {
+      visitor(obj);
+    }
+  }
+  for (const auto& bitmap : live_bitmap_->large_object_bitmaps_) {
+    bitmap->Walk(ClassHistogramVisitor::Callback, &visitor);
+  }
+  // The continuous space bitmaps are walked in ranges, by the thread pool if any.
+  static constexpr size_t kClassHistogramRangeSize = 4 * MB;
+  Thread* self = Thread::Current();
+  Mutex lock("class histogram lock");
+  for (const auto& bitmap : live_bitmap_->continuous_space_bitmaps_) {
+    const uintptr_t limit = static_cast<uintptr_t>(bitmap->HeapLimit());
+    for (uintptr_t begin = bitmap->HeapBegin(); begin < limit; begin += kClassHistogramRangeSize) {
+      uintptr_t end = std::min(begin + kClassHistogramRangeSize, limit);
+      if (thread_pool == nullptr) {
+        bitmap->VisitMarkedRange(begin, end, visitor);
+      } else {
+        thread_pool->AddTask(self, new ClassHistogramTask(bitmap, begin, end, retaining_classes,
+                                                          &lock, histogram));
+      }
+    }
+  }
+  if (thread_pool != nullptr) {
+    // The histogram is only merged into under the lock from now on.
+    thread_pool->SetMaxActiveWorkers(thread_pool->GetThreadCount());
+    thread_pool->StartWorkers(self);
+    thread_pool->Wait(self, true, true);
+    thread_pool->StopWorkers(self);
+  }
+}
+
+void Heap::DumpClassHistogramLocked(std::ostream& os, size_t max_classes,
+                                    ThreadPool* thread_pool) {
+  uint64_t start_time = NanoTime();
+  ClassHistogram histogram;
+  AddToClassHistogram(thread_pool, nullptr, &histogram);
+  size_t total_count = 0;
+  size_t total_bytes = 0;
+  std::vector<std::pair<size_t, mirror::Class*>> by_bytes;
+  for (const auto& entry : histogram) {
+    total_count += entry.second.count;
+    total_bytes += entry.second.bytes;
+    by_bytes.push_back(std::make_pair(entry.second.bytes, entry.first));
+  }
+  std::sort(by_bytes.begin(), by_bytes.end(),
+            std::greater<std::pair<size_t, mirror::Class*>>());
+  if (by_bytes.size() > max_classes) {
+    by_bytes.resize(max_classes);
+  }
+  std::set<mirror::Class*> top_classes;
+  for (const auto& entry : by_bytes) {
+    top_classes.insert(entry.second);
+  }
+  AddToClassHistogram(thread_pool, &top_classes, &histogram);
+
+  os << "Class histogram: " << histogram.size() << " classes, " << total_count << " objects, "
+     << total_bytes << " bytes, walked in " << PrettyDuration(NanoTime() - start_time) << "\n"
+     << StringPrintf("%12s %12s %12s  %s\n", "bytes", "count", "retained", "class");
+  for (const auto& entry : by_bytes) {
+    const ClassHistogramEntry& histogram_entry = histogram[entry.second];
+    os << StringPrintf("%12zu %12zu %12zu  ", histogram_entry.bytes, histogram_entry.count,
+                       histogram_entry.bytes + histogram_entry.retained_bytes)
+       << PrettyClass(entry.second) << "\n";
+  }
+}
+
+void Heap::DumpClassHistogram(std::ostream& os, size_t max_classes) {
+  Thread* self = Thread::Current();
+  {
+    ScopedThreadStateChange tsc(self, kWaitingForGcToComplete);
+    // Pretend we are doing a GC so that no GC moves or frees objects, or uses the thread pool,
+    // during the walk.
+    MutexLock mu(self, *gc_complete_lock_);
+    WaitForGcToCompleteLocked(kGcCauseClassHistogram, self);
+    collector_type_running_ = kCollectorTypeClassHistogram;
+  }
+  {
+    ScopedObjectAccess soa(self);
+    ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
+    DumpClassHistogramLocked(os, max_classes, thread_pool_.get());
+  }
+  FinishGC(self, collector::kGcTypeNone);
+}
+
 class ReferringObjectsFinder {
  public:
   ReferringObjectsFinder(mirror::Object* object, int32_t max_count,
@@ -1311,6 +1804,7 @@ void Heap::TransitionCollector(CollectorType collector_type) {
   }
   VLOG(heap) << "TransitionCollector: " << static_cast<int>(collector_type_)
              << " -> " << static_cast<int>(collector_type);
+  ScopedTrace trace(__FUNCTION__);
   uint64_t start_time = NanoTime();
   uint32_t before_allocated = num_bytes_allocated_.Load();
   ThreadList* tl = Runtime::Current()->GetThreadList();
@@ -1351,6 +1845,8 @@ void Heap::TransitionCollector(CollectorType collector_type) {
   }
   tl->SuspendAll();
   switch (collector_type) {
+    case kCollectorTypeCC:
+      // Fall-through.
     case kCollectorTypeSS:
       // Fall-through.
     case kCollectorTypeGSS: {
@@ -1358,7 +1854,7 @@ void Heap::TransitionCollector(CollectorType collector_type) {
         // We are transitioning from non moving GC -> moving GC, since we copied from the bump
         // pointer space last transition it will be protected.
         bump_pointer_space_->GetMemMap()->Protect(PROT_READ | PROT_WRITE);
-        Compact(bump_pointer_space_, main_space_);
+        Compact(bump_pointer_space_, main_space_, kGcCauseCollectorTransition);
         // Remove the main space so that we don't try to trim it, this doens't work for debug
         // builds since RosAlloc attempts to read the magic number from a protected page.
         // TODO: Clean this up by getting rid of the remove_as_default parameter.
@@ -1373,7 +1869,7 @@ void Heap::TransitionCollector(CollectorType collector_type) {
         // Compact to the main space from the bump pointer space, don't need to swap semispaces.
         AddSpace(main_space_);
         main_space_->GetMemMap()->Protect(PROT_READ | PROT_WRITE);
-        Compact(main_space_, bump_pointer_space_);
+        Compact(main_space_, bump_pointer_space_, kGcCauseCollectorTransition);
       }
       break;
     }
@@ -1458,6 +1954,8 @@ class ZygoteCompactingCollector FINAL : public collector::SemiSpace {
     bin_live_bitmap_->Walk(Callback, reinterpret_cast<void*>(&context));
     // Add the last bin which spans after the last object to the end of the space.
     AddBin(reinterpret_cast<uintptr_t>(space->End()) - context.prev_, context.prev_);
+    // Every dex cache is reachable from the classes of its dex file.
+    GetHeap()->VisitObjects(FindDexCachesCallback, reinterpret_cast<void*>(this));
   }
 
  private:
@@ -1471,6 +1969,40 @@ class ZygoteCompactingCollector FINAL : public collector::SemiSpace {
   accounting::ContinuousSpaceBitmap* bin_live_bitmap_;
   // Mark bitmap of the space which contains the bins.
   accounting::ContinuousSpaceBitmap* bin_mark_bitmap_;
+  // The dex caches and their arrays, which are written as the children resolve strings, types,
+  // methods and fields.
+  std::unordered_set<const mirror::Object*> dex_cache_objects_;
+
+  static void FindDexCachesCallback(mirror::Object* obj, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (!obj->IsClass()) {
+      return;
+    }
+    ZygoteCompactingCollector* collector = reinterpret_cast<ZygoteCompactingCollector*>(arg);
+    mirror::DexCache* dex_cache = obj->AsClass()->GetDexCache();
+    if (dex_cache == nullptr || !collector->dex_cache_objects_.insert(dex_cache).second) {
+      return;
+    }
+    const mirror::Object* arrays[] = {
+        dex_cache->GetStrings(), dex_cache->GetResolvedTypes(), dex_cache->GetResolvedMethods(),
+        dex_cache->GetResolvedFields()
+    };
+    for (const mirror::Object* array : arrays) {
+      if (array != nullptr) {
+        collector->dex_cache_objects_.insert(array);
+      }
+    }
+  }
+
+  // Whether the zygote's children are likely to write `obj`, dirtying its page: classes have
+  // statics and get initialized, dex caches get filled in, and objects that were hashed or locked
+  // before the fork are likely to be locked again.
+  bool IsLikelyWritten(mirror::Object* obj) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (obj->IsClass() || dex_cache_objects_.find(obj) != dex_cache_objects_.end()) {
+      return true;
+    }
+    return obj->GetLockWord(false).GetState() != LockWord::kUnlocked;
+  }
 
   static void Callback(mirror::Object* obj, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
@@ -1500,8 +2032,11 @@ class ZygoteCompactingCollector FINAL : public collector::SemiSpace {
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_) {
     size_t object_size = RoundUp(obj->SizeOf(), kObjectAlignment);
     mirror::Object* forward_address;
-    // Find the smallest bin which we can move obj in.
-    auto it = bins_.lower_bound(object_size);
+    // Find the smallest bin which we can move obj in. The bins are between the classes of the
+    // non moving space, whose pages get dirty anyway, so only the objects likely to be written go
+    // there; the others are kept together in the target space, whose pages then stay shared with
+    // the children.
+    auto it = IsLikelyWritten(obj) ? bins_.lower_bound(object_size) : bins_.end();
     if (it == bins_.end()) {
       // No available space in the bins, place it in the target space instead (grows the zygote
       // space).
@@ -1550,6 +2085,7 @@ void Heap::UnBindBitmaps() {
 }
 
 void Heap::PreZygoteFork() {
+  ScopedTrace trace(__FUNCTION__);
   CollectGarbageInternal(collector::kGcTypeFull, kGcCauseBackground, false);
   static Mutex zygote_creation_lock_("zygote creation lock", kZygoteCreationLock);
   Thread* self = Thread::Current();
@@ -1641,7 +2177,8 @@ void Heap::PreZygoteFork() {
   large_object_threshold_ = kDefaultLargeObjectThreshold;
   // Create the zygote space mod union table.
   accounting::ModUnionTable* mod_union_table =
-      new accounting::ModUnionTableCardCache("zygote space mod-union table", this, zygote_space);
+      new accounting::ModUnionTableReferenceBitmap("zygote space mod-union table", this,
+                                                   zygote_space);
   CHECK(mod_union_table != nullptr) << "Failed to create zygote space mod-union table";
   AddModUnionTable(mod_union_table);
   if (collector::SemiSpace::kUseRememberedSet) {
@@ -1688,7 +2225,7 @@ void Heap::SwapSemiSpaces() {
 }
 
 void Heap::Compact(space::ContinuousMemMapAllocSpace* target_space,
-                   space::ContinuousMemMapAllocSpace* source_space) {
+                   space::ContinuousMemMapAllocSpace* source_space, GcCause gc_cause) {
   CHECK(kMovingCollector);
   CHECK_NE(target_space, source_space) << "In-place compaction currently unsupported";
   if (target_space != source_space) {
@@ -1696,7 +2233,7 @@ void Heap::Compact(space::ContinuousMemMapAllocSpace* target_space,
     semi_space_collector_->SetSwapSemiSpaces(false);
     semi_space_collector_->SetFromSpace(source_space);
     semi_space_collector_->SetToSpace(target_space);
-    semi_space_collector_->Run(kGcCauseCollectorTransition, false);
+    semi_space_collector_->Run(gc_cause, false);
   }
 }
 
@@ -1750,6 +2287,18 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type, GcCaus
   if (LIKELY(ms_delta != 0)) {
     allocation_rate_ = ((gc_start_size - last_gc_size_) * 1000) / ms_delta;
     VLOG(heap) << "Allocation rate: " << PrettySize(allocation_rate_) << "/s";
+    const size_t native_bytes_registered =
+        native_bytes_registered_ever_.Load() - last_gc_native_bytes_registered_;
+    native_allocation_rate_ = (static_cast<uint64_t>(native_bytes_registered) * 1000) / ms_delta;
+  }
+  if (IsGcConcurrent() && gc_start_size < max_allowed_footprint_) {
+    // Pace the allocations made while the GC runs, rather than letting them run into the footprint
+    // limit, where the allocating threads would block for the rest of the GC.
+    size_t headroom = max_allowed_footprint_ - gc_start_size;
+    allocation_pacing_begin_bytes_ = gc_start_size + headroom / 2;
+    allocation_pacing_step_bytes_ = std::max(headroom / (2 * kAllocationPacingSteps),
+                                             kMinAllocationPacingStepBytes);
+    allocation_pacing_start_bytes_ = allocation_pacing_begin_bytes_;
   }
 
   DCHECK_LT(gc_type, collector::kGcTypeMax);
@@ -1768,6 +2317,10 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type, GcCaus
       semi_space_collector_->SetSwapSemiSpaces(true);
     } else if (collector_type_ == kCollectorTypeCC) {
       gc_type = concurrent_copying_collector_->GetGcType();
+      // The collector swaps the semi-spaces in the flip pause, before the mutators allocate into
+      // the to-space.
+      concurrent_copying_collector_->SetFromSpace(bump_pointer_space_);
+      concurrent_copying_collector_->SetToSpace(temp_space_);
       collector = concurrent_copying_collector_;
     } else {
       LOG(FATAL) << "Unreachable - invalid collector type " << static_cast<size_t>(collector_type_);
@@ -1786,11 +2339,16 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type, GcCaus
       << static_cast<size_t>(collector_type_) << " and gc_type=" << gc_type;
   ATRACE_BEGIN(StringPrintf("%s %s GC", PrettyCause(gc_cause), collector->GetName()).c_str());
   collector->Run(gc_cause, clear_soft_references || runtime->IsZygote());
+  gc_count_.FetchAndAdd(1);
   total_objects_freed_ever_ += collector->GetFreedObjects();
   total_bytes_freed_ever_ += collector->GetFreedBytes();
   RequestHeapTrim();
+  RequestAllocationPrefault(self);
+  RequestIdleCheck(self);
   // Enqueue cleared references.
   reference_processor_.EnqueueClearedReferences();
+  // Free the native memory of the objects which died.
+  native_cleaner_.RunQueuedCleaners(self);
   // Grow the heap so that we know when to perform the next GC.
   GrowForUtilization(collector);
   const size_t duration = collector->GetDurationNs();
@@ -1825,6 +2383,8 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type, GcCaus
               << " total " << PrettyDuration((duration / 1000) * 1000);
     VLOG(heap) << ConstDumpable<TimingLogger>(collector->GetTimings());
   }
+  // Still marked as running a GC, so no other GC can change the metrics while we write them.
+  MaybeWriteGcMetricsFile();
   FinishGC(self, gc_type);
   ATRACE_END();
 
@@ -1836,6 +2396,7 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type, GcCaus
 void Heap::FinishGC(Thread* self, collector::GcType gc_type) {
   MutexLock mu(self, *gc_complete_lock_);
   collector_type_running_ = kCollectorTypeNone;
+  allocation_pacing_start_bytes_ = std::numeric_limits<size_t>::max();
   if (gc_type != collector::kGcTypeNone) {
     last_gc_type_ = gc_type;
   }
@@ -2064,6 +2625,115 @@ size_t Heap::VerifyHeapReferences(bool verify_referents) {
   return visitor.GetFailureCount();
 }
 
+// A card of a continuous space, with the live bitmap of the space.
+typedef std::pair<accounting::ContinuousSpaceBitmap*, uintptr_t> SampledCard;
+
+// Verifies the objects starting in the sampled cards it takes from the shared index, until the
+// cards or the time run out.
+class SampledVerifyTask : public Task {
+ public:
+  SampledVerifyTask(Heap* heap, const std::vector<SampledCard>* cards, Atomic<size_t>* next_card,
+                    Atomic<size_t>* verified_cards, Atomic<size_t>* fail_count, uint64_t deadline)
+      : heap_(heap), cards_(cards), next_card_(next_card), verified_cards_(verified_cards),
+        fail_count_(fail_count), deadline_(deadline) {
+  }
+
+  // The GC thread holds the heap bitmap lock and the mutator lock for us.
+  virtual void Run(Thread* self) NO_THREAD_SAFETY_ANALYSIS {
+    VerifyObjectVisitor visitor(heap_, fail_count_, true);
+    while (NanoTime() < deadline_) {
+      const size_t index = next_card_->FetchAndAdd(1);
+      if (index >= cards_->size()) {
+        break;
+      }
+      accounting::ContinuousSpaceBitmap* bitmap = (*cards_)[index].first;
+      const uintptr_t begin = (*cards_)[index].second;
+      const uintptr_t end = std::min(begin + accounting::CardTable::kCardSize,
+                                     static_cast<uintptr_t>(bitmap->HeapLimit()));
+      bitmap->VisitMarkedRange(begin, end, visitor);
+      verified_cards_->FetchAndAdd(1);
+    }
+  }
+
+  virtual void Finalize() {
+    delete this;
+  }
+
+ private:
+  Heap* const heap_;
+  const std::vector<SampledCard>* const cards_;
+  Atomic<size_t>* const next_card_;
+  Atomic<size_t>* const verified_cards_;
+  Atomic<size_t>* const fail_count_;
+  const uint64_t deadline_;
+};
+
+size_t Heap::SampledVerifyHeapReferences() {
+  // How many cards are drawn per GC, more than the budget usually allows to verify.
+  static constexpr size_t kSampledCards = 1024;
+  const uint64_t start_time = NanoTime();
+  const uint64_t deadline = start_time + sampled_verification_budget_;
+  Thread* self = Thread::Current();
+  Locks::mutator_lock_->AssertExclusiveHeld(self);
+  // As in VerifyHeapReferences, the references to the objects of the allocation stack are looked
+  // up in it with a binary search.
+  allocation_stack_->Sort();
+  live_stack_->Sort();
+  RevokeAllThreadLocalAllocationStacks(self);
+  // Draw the cards uniformly over the bytes of the continuous spaces with a live bitmap.
+  uint64_t total_size = 0;
+  for (const auto& space : continuous_spaces_) {
+    if (space->GetLiveBitmap() != nullptr) {
+      total_size += space->Size();
+    }
+  }
+  if (total_size == 0) {
+    return 0;
+  }
+  std::vector<SampledCard> cards;
+  cards.reserve(kSampledCards);
+  for (size_t i = 0; i < kSampledCards; ++i) {
+    uint64_t offset = ((static_cast<uint64_t>(rand_r(&sampled_verification_seed_)) << 31) ^
+        static_cast<uint64_t>(rand_r(&sampled_verification_seed_))) % total_size;
+    for (const auto& space : continuous_spaces_) {
+      if (space->GetLiveBitmap() == nullptr) {
+        continue;
+      }
+      if (offset < space->Size()) {
+        uintptr_t addr = reinterpret_cast<uintptr_t>(space->Begin()) + offset;
+        cards.push_back(SampledCard(space->GetLiveBitmap(),
+                                    RoundDown(addr, accounting::CardTable::kCardSize)));
+        break;
+      }
+      offset -= space->Size();
+    }
+  }
+  Atomic<size_t> next_card(0);
+  Atomic<size_t> verified_cards(0);
+  Atomic<size_t> fail_count(0);
+  ThreadPool* thread_pool = thread_pool_.get();
+  if (thread_pool == nullptr) {
+    SampledVerifyTask task(this, &cards, &next_card, &verified_cards, &fail_count, deadline);
+    task.Run(self);
+  } else {
+    const size_t thread_count = thread_pool->GetThreadCount();
+    for (size_t i = 0; i <= thread_count; ++i) {
+      thread_pool->AddTask(self, new SampledVerifyTask(this, &cards, &next_card, &verified_cards,
+                                                       &fail_count, deadline));
+    }
+    thread_pool->SetMaxActiveWorkers(thread_count);
+    thread_pool->StartWorkers(self);
+    thread_pool->Wait(self, true, true);
+    thread_pool->StopWorkers(self);
+  }
+  VLOG(heap) << "Sampled heap verification checked " << verified_cards.Load() << " of "
+             << cards.size() << " cards in " << PrettyDuration(NanoTime() - start_time);
+  if (fail_count.Load() > 0) {
+    DumpSpaces();
+  }
+  return fail_count.Load();
+}
+
 class VerifyReferenceCardVisitor {
  public:
   VerifyReferenceCardVisitor(Heap* heap, bool* failed)
@@ -2269,6 +2939,14 @@ void Heap::PreGcVerificationPaused(collector::GarbageCollector* gc) {
       LOG(FATAL) << "Pre " << gc->GetName() << " heap verification failed with " << failures
           << " failures";
     }
+  } else if (sampled_verification_budget_ != 0) {
+    TimingLogger::ScopedSplit split("PreGcSampledVerifyHeapReferences", timings);
+    ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
+    size_t failures = SampledVerifyHeapReferences();
+    if (failures > 0) {
+      LOG(FATAL) << "Pre " << gc->GetName() << " sampled heap verification failed with "
+          << failures << " failures";
+    }
   }
   // Check that all objects which reference things in the live stack are on dirty cards.
   if (verify_missing_card_marks_) {
@@ -2293,7 +2971,8 @@ void Heap::PreGcVerificationPaused(collector::GarbageCollector* gc) {
 }
 
 void Heap::PreGcVerification(collector::GarbageCollector* gc) {
-  if (verify_pre_gc_heap_ || verify_missing_card_marks_ || verify_mod_union_table_) {
+  if (verify_pre_gc_heap_ || sampled_verification_budget_ != 0 || verify_missing_card_marks_ ||
+      verify_mod_union_table_) {
     collector::GarbageCollector::ScopedPause pause(gc);
     PreGcVerificationPaused(gc);
   }
@@ -2402,6 +3081,16 @@ void Heap::DumpForSigQuit(std::ostream& os) {
   os << "Heap: " << GetPercentFree() << "% free, " << PrettySize(GetBytesAllocated()) << "/"
      << PrettySize(GetTotalMemory()) << "; " << GetObjectsAllocated() << " objects\n";
   DumpGcPerformanceInfo(os);
+  if (allocation_sampler_.IsEnabled()) {
+    allocation_sampler_.Dump(os);
+  }
+  // The threads are suspended, so the GC can't progress. Skip the walk if one was running, as the
+  // bitmaps may be half swept. The thread pool isn't used since its workers are suspended too.
+  static constexpr size_t kSigQuitHistogramClasses = 20;
+  if (collector_type_running_ == kCollectorTypeNone) {
+    ReaderMutexLock mu(Thread::Current(), *Locks::heap_bitmap_lock_);
+    DumpClassHistogramLocked(os, kSigQuitHistogramClasses, nullptr);
+  }
 }
 
 size_t Heap::GetPercentFree() {
@@ -2439,6 +3128,15 @@ void Heap::UpdateMaxNativeFootprint() {
   }
   native_footprint_gc_watermark_ = target_size;
   native_footprint_limit_ = 2 * target_size - native_size;
+  // Start the concurrent GCs early enough for them to finish, at the current native allocation
+  // rate, before the native allocations reach the limit. But not before half of the room to the
+  // watermark is used, so that fast native allocations don't cause back to back GCs.
+  const double gc_duration_seconds = NsToMs(last_gc_duration_ns_) / 1000.0;
+  const size_t remaining_bytes = std::min(
+      static_cast<size_t>(native_allocation_rate_ * gc_duration_seconds), native_footprint_limit_);
+  native_concurrent_start_bytes_ = std::max(
+      std::min(native_footprint_limit_ - remaining_bytes, native_footprint_gc_watermark_),
+      native_size + (target_size - native_size) / 2);
 }
 
 collector::GarbageCollector* Heap::FindCollectorByGcType(collector::GcType gc_type) {
@@ -2465,19 +3163,43 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran) {
   const uint64_t bytes_allocated = GetBytesAllocated();
   last_gc_size_ = bytes_allocated;
   last_gc_time_ns_ = NanoTime();
+  last_gc_native_bytes_registered_ = native_bytes_registered_ever_.Load();
+  last_gc_duration_ns_ = collector_ran->GetDurationNs();
+  if (collector_type_ == kCollectorTypeGSS && kDefaultNurserySize != 0) {
+    // The survivors which weren't promoted stay in the bump pointer space, the nursery starts
+    // after them.
+    nursery_limit_ = bump_pointer_space_->Size() + kDefaultNurserySize;
+  } else {
+    nursery_limit_ = std::numeric_limits<size_t>::max();
+  }
   uint64_t target_size;
   collector::GcType gc_type = collector_ran->GetGcType();
   if (gc_type != collector::kGcTypeSticky) {
     // Grow the heap for non sticky GC.
     const float multiplier = HeapGrowthMultiplier();  // Use the multiplier to grow more for
     // foreground.
-    intptr_t delta = bytes_allocated / GetTargetHeapUtilization() - bytes_allocated;
-    CHECK_GE(delta, 0);
-    target_size = bytes_allocated + delta * multiplier;
-    target_size = std::min(target_size,
-                           bytes_allocated + static_cast<uint64_t>(max_free_ * multiplier));
-    target_size = std::max(target_size,
-                           bytes_allocated + static_cast<uint64_t>(min_free_ * multiplier));
+    if (target_gc_time_ratio_ != 0.0 && allocation_rate_ != 0) {
+      // GC cost is mostly proportional to the live bytes, so the time between GCs is what the heap
+      // size controls. Leave enough free space for the mutators to run, at the current allocation
+      // rate, long enough for a GC of this duration to take target_gc_time_ratio_ of the time.
+      const double gc_duration_seconds = NsToMs(collector_ran->GetDurationNs()) / 1000.0;
+      const double mutator_seconds =
+          gc_duration_seconds * (1.0 - target_gc_time_ratio_) / target_gc_time_ratio_;
+      const double free_bytes = allocation_rate_ * mutator_seconds;
+      // SetIdealFootprint clamps the target to the growth limit.
+      target_size = bytes_allocated + static_cast<uint64_t>(
+          std::min(free_bytes, static_cast<double>(GetMaxMemory())));
+      target_size = std::max(target_size,
+                             bytes_allocated + static_cast<uint64_t>(min_free_ * multiplier));
+    } else {
+      intptr_t delta = bytes_allocated / GetTargetHeapUtilization() - bytes_allocated;
+      CHECK_GE(delta, 0);
+      target_size = bytes_allocated + delta * multiplier;
+      target_size = std::min(target_size,
+                             bytes_allocated + static_cast<uint64_t>(max_free_ * multiplier));
+      target_size = std::max(target_size,
+                             bytes_allocated + static_cast<uint64_t>(min_free_ * multiplier));
+    }
     native_need_to_run_finalization_ = true;
     next_gc_type_ = collector::kGcTypeSticky;
   } else {
@@ -2498,15 +3220,22 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran) {
     } else {
       next_gc_type_ = non_sticky_gc_type;
     }
-    // If we have freed enough memory, shrink the heap back down.
-    if (bytes_allocated + max_free_ < max_allowed_footprint_) {
+    // If we have freed enough memory, shrink the heap back down. With a GC time target only the
+    // non sticky GCs resize the heap.
+    if (target_gc_time_ratio_ == 0.0 && bytes_allocated + max_free_ < max_allowed_footprint_) {
       target_size = bytes_allocated + max_free_;
     } else {
       target_size = std::max(bytes_allocated, static_cast<uint64_t>(max_allowed_footprint_));
     }
   }
   if (!ignore_max_footprint_) {
+    const size_t old_footprint = max_allowed_footprint_;
     SetIdealFootprint(target_size);
+    if (max_allowed_footprint_ > old_footprint) {
+      ++heap_growth_count_;
+    } else if (max_allowed_footprint_ < old_footprint) {
+      ++heap_shrink_count_;
+    }
     if (IsGcConcurrent()) {
       // Calculate when to perform the next ConcurrentGC.
       // Calculate the estimated GC duration.
@@ -2553,6 +3282,34 @@ void Heap::RequestConcurrentGCAndSaveObject(Thread* self, mirror::Object** obj)
   RequestConcurrentGC(self);
 }
 
+void Heap::PaceAllocationAndSaveObject(Thread* self, size_t new_num_bytes_allocated,
+                                       mirror::Object** obj) {
+  // The next step of allocations, by any thread, pays for the next pause. A thread allocating
+  // faster pays more of them.
+  allocation_pacing_start_bytes_ = new_num_bytes_allocated + allocation_pacing_step_bytes_;
+  const size_t begin = allocation_pacing_begin_bytes_;
+  const size_t limit = max_allowed_footprint_;
+  if (limit <= begin || new_num_bytes_allocated <= begin || self->IsHandlingStackOverflow()) {
+    return;
+  }
+  const uint64_t pause_ns = kMaxAllocationPacingPauseNs *
+      (std::min(new_num_bytes_allocated, limit) - begin) / (limit - begin);
+  StackHandleScope<1> hs(self);
+  HandleWrapper<mirror::Object> wrapper(hs.NewHandleWrapper(obj));
+  ScopedThreadStateChange tsc(self, kWaitingForGcToComplete);
+  MutexLock mu(self, *gc_complete_lock_);
+  if (collector_type_running_ == kCollectorTypeNone) {
+    return;
+  }
+  ATRACE_BEGIN("GC: Pace Allocation");
+  uint64_t pause_start = NanoTime();
+  // The GC completing ends the pause early.
+  gc_complete_cond_->TimedWait(self, pause_ns / MsToNs(1), pause_ns % MsToNs(1));
+  ++allocation_pacing_count_;
+  total_allocation_pacing_time_ += NanoTime() - pause_start;
+  ATRACE_END();
+}
+
 void Heap::RequestConcurrentGC(Thread* self) {
   // Make sure that we can do a concurrent GC.
   Runtime* runtime = Runtime::Current();
@@ -2644,7 +3401,140 @@ void Heap::RequestHeapTrim() {
   SignalHeapTrimDaemon(self);
 }
 
+void Heap::RequestIdleCheck(Thread* self) {
+  Runtime* runtime = Runtime::Current();
+  if (runtime == nullptr || !runtime->IsFinishedStarting() || runtime->IsShuttingDown(self) ||
+      runtime->IsZygote()) {
+    // Same as heap trims, idle checks are done by the heap trimmer daemon. The zygote compacts
+    // before forking, and waiting for a check would hold up stopping the daemons for the fork.
+    return;
+  }
+  {
+    MutexLock mu(self, *heap_trim_request_lock_);
+    if (idle_check_pending_) {
+      // The pending check samples the allocations since the earlier GC, which is good enough.
+      return;
+    }
+    idle_check_pending_ = true;
+    idle_check_target_time_ = NanoTime() + kIdleCheckWait;
+    idle_check_bytes_allocated_ = GetBytesAllocatedEver();
+  }
+  SignalHeapTrimDaemon(self);
+}
+
+void Heap::DoPendingIdleCheck(Thread* self) {
+  uint64_t bytes_allocated_at_request;
+  uint64_t idle_duration;
+  {
+    MutexLock mu(self, *heap_trim_request_lock_);
+    if (!idle_check_pending_) {
+      return;
+    }
+    if (desired_collector_type_ != collector_type_ || allocation_prefault_pending_) {
+      // Leave the check pending, the transition or prefault is done first.
+      return;
+    }
+    // Not due yet, DoPendingTransitionOrTrim waits for the deadline.
+    const uint64_t current_time = NanoTime();
+    if (current_time < idle_check_target_time_) {
+      return;
+    }
+    idle_check_pending_ = false;
+    bytes_allocated_at_request = idle_check_bytes_allocated_;
+    idle_duration = current_time - idle_check_target_time_ + kIdleCheckWait;
+  }
+  const uint64_t bytes_allocated = GetBytesAllocatedEver() - bytes_allocated_at_request;
+  if (bytes_allocated >= kIdleAllocationThreshold || HasRunnableMutators(self)) {
+    return;
+  }
+  VLOG(heap) << "Process is idle, allocated " << PrettySize(bytes_allocated) << " in "
+      << PrettyDuration(idle_duration);
+  if (main_space_backup_ != nullptr && IsMainSpaceFragmented()) {
+    PerformHomogeneousSpaceCompact();
+  }
+  {
+    MutexLock mu(self, *heap_trim_request_lock_);
+    heap_trim_request_pending_ = true;
+  }
+  Trim();
+}
+
+void Heap::RequestAllocationPrefault(Thread* self) {
+  // Only worth the extra resident memory if the process cares about allocation latency.
+  if (!CareAboutPauseTimes()) {
+    return;
+  }
+  Runtime* runtime = Runtime::Current();
+  if (runtime == nullptr || !runtime->IsFinishedStarting() || runtime->IsShuttingDown(self)) {
+    return;
+  }
+  {
+    MutexLock mu(self, *heap_trim_request_lock_);
+    if (allocation_prefault_pending_) {
+      return;
+    }
+    allocation_prefault_pending_ = true;
+  }
+  SignalHeapTrimDaemon(self);
+}
+
+void Heap::DoPendingAllocationPrefault(Thread* self) {
+  {
+    MutexLock mu(self, *heap_trim_request_lock_);
+    if (!allocation_prefault_pending_) {
+      return;
+    }
+    allocation_prefault_pending_ = false;
+  }
+  uint64_t start_ns = NanoTime();
+  // Holding the mutator lock keeps the spaces from being cleared or swapped by a moving GC while
+  // we touch them.
+  ScopedObjectAccess soa(self);
+  std::vector<std::pair<byte*, byte*>> ranges;
+  switch (current_allocator_) {
+    case kAllocatorTypeBumpPointer:
+      // Fall-through.
+    case kAllocatorTypeTLAB: {
+      // Objects and TLABs are bumped off the end of the space.
+      byte* begin = bump_pointer_space_->End();
+      byte* end = std::min(begin + kAllocationPrefaultBytes, bump_pointer_space_->Limit());
+      ranges.push_back(std::make_pair(begin, end));
+      break;
+    }
+    case kAllocatorTypeRosAlloc: {
+      // New runs and large allocations are taken from the lowest free page runs.
+      rosalloc_space_->GetRosAlloc()->GetNextFreePages(kAllocationPrefaultBytes, &ranges);
+      break;
+    }
+    default:
+      // Dlmalloc doesn't tell which pages it will use next.
+      return;
+  }
+  size_t prefaulted_bytes = 0;
+  for (const auto& range : ranges) {
+    PrefaultPages(range.first, range.second);
+    prefaulted_bytes += range.second - range.first;
+  }
+  VLOG(heap) << "Prefaulted " << PrettySize(prefaulted_bytes) << " of allocation pages in "
+      << PrettyDuration(NanoTime() - start_ns);
+}
+
+void Heap::PrefaultPages(byte* begin, byte* end) {
+  // The pages are expected to be zero but another thread may start allocating from them at any
+  // time, so use an atomic add of zero: it makes the kernel back the page with a private writable
+  // page without ever changing what is stored in it.
+  for (byte* page = AlignUp(begin, kPageSize); page < end; page += kPageSize) {
+    __sync_fetch_and_add(reinterpret_cast<volatile int32_t*>(page), 0);
+  }
+}
+
 void Heap::SignalHeapTrimDaemon(Thread* self) {
+  {
+    // The daemon may be waiting for an idle check in DoPendingTransitionOrTrim.
+    MutexLock mu(self, *heap_trim_request_lock_);
+    ++heap_trim_signal_count_;
+    heap_trim_request_cond_->Broadcast(self);
+  }
   JNIEnv* env = self->GetJniEnv();
   DCHECK(WellKnownClasses::java_lang_Daemons != nullptr);
   DCHECK(WellKnownClasses::java_lang_Daemons_requestHeapTrim != nullptr);
@@ -2658,10 +3548,39 @@ void Heap::RevokeThreadLocalBuffers(Thread* thread) {
     rosalloc_space_->RevokeThreadLocalBuffers(thread);
   }
   if (bump_pointer_space_ != nullptr) {
+    RetireTlab(thread);
     bump_pointer_space_->RevokeThreadLocalBuffers(thread);
   }
 }
 
+static size_t TlabSizeFor(size_t bytes_allocated) {
+  const size_t size = RoundUpToPowerOfTwo(bytes_allocated / Heap::kTLABRefillsPerGC);
+  return std::min(std::max(size, Heap::kMinTLABSize), Heap::kMaxTLABSize);
+}
+
+size_t Heap::NextTlabSize(Thread* self) {
+  Thread::TlabSizing* sizing = self->GetTlabSizing();
+  const uint32_t gc_count = gc_count_.Load();
+  if (sizing->gc_count != gc_count) {
+    // The bytes allocated before the GC give the allocation rate of the thread.
+    sizing->size = TlabSizeFor(sizing->bytes_since_gc);
+    sizing->bytes_since_gc = 0;
+    sizing->gc_count = gc_count;
+  } else {
+    // Grow the TLABs of a thread which allocates more than it did before the GC.
+    const size_t bytes_allocated = sizing->bytes_since_gc + self->GetThreadLocalBytesAllocated();
+    sizing->size = std::max(sizing->size, TlabSizeFor(bytes_allocated));
+  }
+  return sizing->size;
+}
+
+void Heap::RetireTlab(Thread* thread) {
+  const size_t bytes_allocated = thread->GetThreadLocalBytesAllocated();
+  num_bytes_allocated_.FetchAndAdd(bytes_allocated);
+  thread->GetTlabSizing()->bytes_since_gc += bytes_allocated;
+  tlab_wasted_bytes_.FetchAndAdd(thread->TlabSize());
+}
+
 void Heap::RevokeRosAllocThreadLocalBuffers(Thread* thread) {
   if (rosalloc_space_ != nullptr) {
     rosalloc_space_->RevokeThreadLocalBuffers(thread);
@@ -2673,7 +3592,14 @@ void Heap::RevokeAllThreadLocalBuffers() {
     rosalloc_space_->RevokeAllThreadLocalBuffers();
   }
   if (bump_pointer_space_ != nullptr) {
-    bump_pointer_space_->RevokeAllThreadLocalBuffers();
+    // Count the bytes of each buffer as it is revoked.
+    Thread* self = Thread::Current();
+    MutexLock mu(self, *Locks::runtime_shutdown_lock_);
+    MutexLock mu2(self, *Locks::thread_list_lock_);
+    for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+      RetireTlab(thread);
+      bump_pointer_space_->RevokeThreadLocalBuffers(thread);
+    }
   }
 }
 
@@ -2695,18 +3621,23 @@ void Heap::RunFinalization(JNIEnv* env) {
 
 void Heap::RegisterNativeAllocation(JNIEnv* env, int bytes) {
   Thread* self = ThreadForEnv(env);
-  if (native_need_to_run_finalization_) {
+  // Total number of native bytes allocated.
+  native_bytes_allocated_.FetchAndAdd(bytes);
+  native_bytes_registered_ever_.FetchAndAdd(bytes);
+  if (static_cast<size_t>(native_bytes_allocated_) > native_concurrent_start_bytes_ &&
+      native_need_to_run_finalization_) {
+    // The finalizers of the objects the last GC found dead free native memory. They have most
+    // likely run by now: wait for the remaining ones, rather than after each GC, before updating
+    // the watermarks.
     RunFinalization(env);
     UpdateMaxNativeFootprint();
     native_need_to_run_finalization_ = false;
   }
-  // Total number of native bytes allocated.
-  native_bytes_allocated_.FetchAndAdd(bytes);
-  if (static_cast<size_t>(native_bytes_allocated_) > native_footprint_gc_watermark_) {
+  if (static_cast<size_t>(native_bytes_allocated_) > native_concurrent_start_bytes_) {
     collector::GcType gc_type = have_zygote_space_ ? collector::kGcTypePartial :
         collector::kGcTypeFull;
 
-    // The second watermark is higher than the gc watermark. If you hit this it means you are
+    // The limit is higher than the concurrent start. If you hit this it means you are
     // allocating native objects faster than the GC can keep up with.
     if (static_cast<size_t>(native_bytes_allocated_) > native_footprint_limit_) {
       if (WaitForGcToComplete(kGcCauseForNativeAlloc, self) != collector::kGcTypeNone) {
@@ -2716,6 +3647,7 @@ void Heap::RegisterNativeAllocation(JNIEnv* env, int bytes) {
       }
       // If we still are over the watermark, attempt a GC for alloc and run finalizers.
       if (static_cast<size_t>(native_bytes_allocated_) > native_footprint_limit_) {
+        native_blocking_gc_count_.FetchAndAdd(1);
         CollectGarbageInternal(gc_type, kGcCauseForNativeAlloc, false);
         RunFinalization(env);
         native_need_to_run_finalization_ = false;
@@ -2726,8 +3658,10 @@ void Heap::RegisterNativeAllocation(JNIEnv* env, int bytes) {
       UpdateMaxNativeFootprint();
     } else if (!IsGCRequestPending()) {
       if (IsGcConcurrent()) {
+        native_concurrent_gc_request_count_.FetchAndAdd(1);
         RequestConcurrentGC(self);
       } else {
+        native_blocking_gc_count_.FetchAndAdd(1);
         CollectGarbageInternal(gc_type, kGcCauseForNativeAlloc, false);
       }
     }
@@ -18,6 +18,8 @@
 #define ART_RUNTIME_GC_HEAP_H_
 
 #include <iosfwd>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -26,9 +28,11 @@
 #include "base/timing_logger.h"
 #include "gc/accounting/atomic_stack.h"
 #include "gc/accounting/card_table.h"
+#include "gc/allocation_sampler.h"
 #include "gc/gc_cause.h"
 #include "gc/collector/gc_type.h"
 #include "gc/collector_type.h"
+#include "gc/native_cleaner.h"
 #include "globals.h"
 #include "gtest/gtest.h"
 #include "instruction_set.h"
@@ -101,6 +105,10 @@ static constexpr bool kUseRosAlloc = true;
 // If true, use thread-local allocation stack.
 static constexpr bool kUseThreadLocalAllocationStack = true;
 
+// If true, the zygote reserves a backup main space so that an idle process can compact its main
+// space into it without transitioning to a moving collector.
+static constexpr bool kUseHomogeneousSpaceCompaction = true;
+
 // The process state passed in from the activity manager, used to determine when to do trimming
 // and compaction.
 enum ProcessState {
@@ -124,8 +132,23 @@ class Heap {
   static constexpr size_t kDefaultLongPauseLogThreshold = MsToNs(5);
   static constexpr size_t kDefaultLongGCLogThreshold = MsToNs(100);
   static constexpr size_t kDefaultTLABSize = 256 * KB;
+  // The TLABs of a thread are sized so that it needs about kTLABRefillsPerGC of them between two
+  // GCs, within these bounds: a mostly idle thread doesn't hold on to a large buffer, and a thread
+  // allocating a lot doesn't refill it for every few objects.
+  static constexpr size_t kMinTLABSize = 16 * KB;
+  static constexpr size_t kMaxTLABSize = 1 * MB;
+  static constexpr size_t kTLABRefillsPerGC = 8;
+  // The generational semi-space collector runs a minor collection once this many bytes got
+  // allocated into the bump pointer space since the last collection, 0 to only collect when the
+  // heap footprint limit is reached.
+  static constexpr size_t kDefaultNurserySize = 8 * MB;
+  // Minimum time between two writes of the GC metrics file.
+  static constexpr uint64_t kGcMetricsWriteIntervalNs = MsToNs(1000);
   static constexpr double kDefaultTargetUtilization = 0.5;
   static constexpr double kDefaultHeapGrowthMultiplier = 2.0;
+  // Fraction of the time spent in GC which the heap growth targets, 0 to size the heap by the
+  // target utilization instead.
+  static constexpr double kDefaultTargetGcTimeRatio = 0.0;
 
   // Used so that we don't overflow the allocation time atomic integer.
   static constexpr size_t kTimeAdjust = 1024;
@@ -134,22 +157,34 @@ class Heap {
   static constexpr uint64_t kHeapTrimWait = MsToNs(5000);
   // How long we wait after a transition request to perform a collector transition (nanoseconds).
   static constexpr uint64_t kCollectorTransitionWait = MsToNs(5000);
+  // How long we watch the process after a GC before deciding whether it is idle (nanoseconds).
+  static constexpr uint64_t kIdleCheckWait = MsToNs(10000);
+  // The process is considered idle if it allocated less than this during the idle check wait.
+  static constexpr size_t kIdleAllocationThreshold = 256 * KB;
+  // An idle process compacts its main space only if at least this much of it is free, and the
+  // main space utilization is below kHomogeneousSpaceCompactUtilization.
+  static constexpr size_t kHomogeneousSpaceCompactMinFree = 4 * MB;
+  static constexpr double kHomogeneousSpaceCompactUtilization = 0.75;
+  // How much of the memory the next allocations will use is faulted in by the heap trimmer daemon
+  // after a GC, so that the allocating threads don't take the page faults.
+  static constexpr size_t kAllocationPrefaultBytes = 1 * MB;
 
   // Create a heap with the requested sizes. The possible empty
   // image_file_names names specify Spaces to load based on
   // ImageWriter output.
   explicit Heap(size_t initial_size, size_t growth_limit, size_t min_free,
                 size_t max_free, double target_utilization,
-                double foreground_heap_growth_multiplier, size_t capacity,
-                const std::string& original_image_file_name,
+                double foreground_heap_growth_multiplier, double target_gc_time_ratio,
+                size_t capacity, const std::string& original_image_file_name,
                 InstructionSet image_instruction_set,
                 CollectorType foreground_collector_type, CollectorType background_collector_type,
-                size_t parallel_gc_threads, size_t conc_gc_threads, bool low_memory_mode,
-                size_t long_pause_threshold, size_t long_gc_threshold,
+                size_t parallel_gc_threads, size_t conc_gc_threads, bool pin_gc_threads,
+                bool low_memory_mode, size_t long_pause_threshold, size_t long_gc_threshold,
                 bool ignore_max_footprint, bool use_tlab,
                 bool verify_pre_gc_heap, bool verify_pre_sweeping_heap, bool verify_post_gc_heap,
                 bool verify_pre_gc_rosalloc, bool verify_pre_sweeping_rosalloc,
-                bool verify_post_gc_rosalloc);
+                bool verify_post_gc_rosalloc, uint64_t sampled_verification_budget,
+                const std::string& gc_metrics_file);
 
   ~Heap();
 
@@ -219,6 +254,10 @@ class Heap {
   // Returns how many failures occured.
   size_t VerifyHeapReferences(bool verify_referents = true)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
+  // Verifies the objects of random cards of the continuous spaces, on the thread pool if any,
+  // until sampled_verification_budget_ is spent. Returns how many failures occured.
+  size_t SampledVerifyHeapReferences()
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
   bool VerifyMissingCardMarks()
       EXCLUSIVE_LOCKS_REQUIRED(Locks::heap_bitmap_lock_, Locks::mutator_lock_);
 
@@ -262,6 +301,21 @@ class Heap {
                       uint64_t* counts)
       LOCKS_EXCLUDED(Locks::heap_bitmap_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // The instance count, bytes and retained bytes estimate of a class, see DumpClassHistogram.
+  struct ClassHistogramEntry {
+    ClassHistogramEntry() : count(0), bytes(0), retained_bytes(0) {}
+    size_t count;
+    size_t bytes;
+    size_t retained_bytes;
+  };
+  typedef std::map<mirror::Class*, ClassHistogramEntry> ClassHistogram;
+
+  // Dumps the max_classes classes whose instances take the most bytes, with their instance count
+  // and an estimate of the bytes the instances retain: their own plus those of the arrays they
+  // reference directly, such as the value of a String or the table of a HashMap. Cheaper than a
+  // heap dump: the objects are counted by walking the live bitmaps on the GC thread pool.
+  void DumpClassHistogram(std::ostream& os, size_t max_classes)
+      LOCKS_EXCLUDED(Locks::heap_bitmap_lock_, gc_complete_lock_);
   // Implements JDWP RT_Instances.
   void GetInstances(mirror::Class* c, int32_t max_count, std::vector<mirror::Object*>& instances)
       LOCKS_EXCLUDED(Locks::heap_bitmap_lock_)
@@ -428,6 +482,10 @@ class Heap {
   // Trim the managed and native heaps by releasing unused memory back to the OS.
   void Trim() LOCKS_EXCLUDED(heap_trim_request_lock_);
 
+  // Compact the main space into the backup main space and swap them, returns false if the
+  // compaction couldn't be done.
+  bool PerformHomogeneousSpaceCompact() LOCKS_EXCLUDED(Locks::mutator_lock_);
+
   void RevokeThreadLocalBuffers(Thread* thread);
   void RevokeRosAllocThreadLocalBuffers(Thread* thread);
   void RevokeAllThreadLocalBuffers();
@@ -522,6 +580,11 @@ class Heap {
   // GC performance measuring
   void DumpGcPerformanceInfo(std::ostream& os);
 
+  // Dump the GC metrics in a machine readable format, one "name value" pair per line. The
+  // collector metrics cover the iterations since the last DumpGcPerformanceInfo, the heap metrics
+  // are totals since the start of the runtime.
+  void DumpGcMetrics(std::ostream& os) LOCKS_EXCLUDED(gc_complete_lock_);
+
   // Returns true if we currently care about pause times.
   bool CareAboutPauseTimes() const {
     return process_state_ == kProcessStateJankPerceptible;
@@ -556,11 +619,46 @@ class Heap {
     return &reference_processor_;
   }
 
+  AllocationSampler* GetAllocationSampler() {
+    return &allocation_sampler_;
+  }
+
+  NativeCleaner* GetNativeCleaner() {
+    return &native_cleaner_;
+  }
+
+  collector::ConcurrentCopying* ConcurrentCopyingCollector() {
+    return concurrent_copying_collector_;
+  }
+
  private:
   void Compact(space::ContinuousMemMapAllocSpace* target_space,
-               space::ContinuousMemMapAllocSpace* source_space)
+               space::ContinuousMemMapAllocSpace* source_space, GcCause gc_cause)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Ask the heap trimmer daemon to check whether the process went idle after the last GC.
+  void RequestIdleCheck(Thread* self) LOCKS_EXCLUDED(heap_trim_request_lock_);
+  // Do a pending idle check once its deadline passed, if the process looks idle compact the main
+  // space when it is fragmented and trim the heap.
+  void DoPendingIdleCheck(Thread* self) LOCKS_EXCLUDED(heap_trim_request_lock_);
+  // The work of one DoPendingTransitionOrTrim round.
+  void DoPendingHeapTasks(Thread* self) LOCKS_EXCLUDED(heap_trim_request_lock_);
+  // Waits until the deadline of the pending idle check or the next signal of the daemon, unless
+  // there was a signal since signal_count was read. Returns false if no check is left to wait for.
+  bool WaitForPendingIdleCheck(Thread* self, uint64_t signal_count)
+      LOCKS_EXCLUDED(heap_trim_request_lock_);
+  // Whether the main space has enough free memory for a homogeneous space compaction to pay off.
+  bool IsMainSpaceFragmented();
+  // Whether any thread other than self is runnable.
+  static bool HasRunnableMutators(Thread* self) LOCKS_EXCLUDED(Locks::thread_list_lock_);
+
+  // Ask the heap trimmer daemon to fault in the pages the next allocations will use.
+  void RequestAllocationPrefault(Thread* self) LOCKS_EXCLUDED(heap_trim_request_lock_);
+  void DoPendingAllocationPrefault(Thread* self) LOCKS_EXCLUDED(heap_trim_request_lock_);
+  // Fault in the pages in [begin, end) without changing their contents, even if other threads
+  // are allocating from them concurrently.
+  static void PrefaultPages(byte* begin, byte* end);
+
   void FinishGC(Thread* self, collector::GcType gc_type) LOCKS_EXCLUDED(gc_complete_lock_);
 
   static ALWAYS_INLINE bool AllocatorHasAllocationStack(AllocatorType allocator_type) {
@@ -568,8 +666,10 @@ class Heap {
         allocator_type != kAllocatorTypeBumpPointer &&
         allocator_type != kAllocatorTypeTLAB;
   }
-  static ALWAYS_INLINE bool AllocatorMayHaveConcurrentGC(AllocatorType allocator_type) {
-    return AllocatorHasAllocationStack(allocator_type);
+  ALWAYS_INLINE bool AllocatorMayHaveConcurrentGC(AllocatorType allocator_type) const {
+    // The concurrent copying collector runs concurrently with bump pointer allocation.
+    return AllocatorHasAllocationStack(allocator_type) ||
+        (kUseBrooksReadBarrier && collector_type_ == kCollectorTypeCC);
   }
   static bool IsMovingGc(CollectorType collector_type) {
     return collector_type == kCollectorTypeSS || collector_type == kCollectorTypeGSS ||
@@ -621,6 +721,18 @@ class Heap {
 
   template <bool kGrow>
   bool IsOutOfMemoryOnAllocation(AllocatorType allocator_type, size_t alloc_size);
+  // Returns true if allocating alloc_size more bytes into the bump pointer space would go past the
+  // nursery limit. Growing allocations ignore the limit so that we don't throw an OOME when the
+  // minor collection can't run or doesn't free enough.
+  template <bool kGrow>
+  bool IsNurseryFull(size_t alloc_size) const;
+
+  // Returns the size of the next TLAB of self, from the bytes it allocated in TLABs during the
+  // previous GC cycle, or during this one if that is more.
+  size_t NextTlabSize(Thread* self);
+  // Counts the bytes allocated in the TLAB of thread, and the bytes it leaves unused, before the
+  // TLAB is revoked.
+  void RetireTlab(Thread* thread);
 
   // Returns true if the address passed in is within the address range of a continuous space.
   bool IsValidContinuousSpaceObjectAddress(const mirror::Object* obj) const
@@ -634,11 +746,34 @@ class Heap {
   collector::GcType WaitForGcToCompleteLocked(GcCause cause, Thread* self)
       EXCLUSIVE_LOCKS_REQUIRED(gc_complete_lock_);
 
+  // Dump the GC metrics, requires that no GC runs concurrently.
+  void DumpGcMetricsLocked(std::ostream& os);
+
+  // Adds the objects of the heap to histogram, or with retaining_classes, the arrays referenced by
+  // the instances of these classes to their retained bytes. Uses thread_pool if not null. Requires
+  // that no GC runs concurrently.
+  void AddToClassHistogram(ThreadPool* thread_pool,
+                           const std::set<mirror::Class*>* retaining_classes,
+                           ClassHistogram* histogram)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_, Locks::heap_bitmap_lock_);
+
+  // Does the job of DumpClassHistogram, requires that no GC runs concurrently.
+  void DumpClassHistogramLocked(std::ostream& os, size_t max_classes, ThreadPool* thread_pool)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_, Locks::heap_bitmap_lock_);
+  // Write the GC metrics to gc_metrics_file_ if the last write is older than
+  // kGcMetricsWriteIntervalNs, called at the end of a GC.
+  void MaybeWriteGcMetricsFile();
+
   void RequestCollectorTransition(CollectorType desired_collector_type, uint64_t delta_time)
       LOCKS_EXCLUDED(heap_trim_request_lock_);
   void RequestHeapTrim() LOCKS_EXCLUDED(Locks::runtime_shutdown_lock_);
   void RequestConcurrentGCAndSaveObject(Thread* self, mirror::Object** obj)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Pauses an allocating thread while a concurrent GC runs, longer as the allocations get closer
+  // to the footprint limit, so that the GC finishes before they reach it.
+  void PaceAllocationAndSaveObject(Thread* self, size_t new_num_bytes_allocated,
+                                   mirror::Object** obj)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(gc_complete_lock_);
   void RequestConcurrentGC(Thread* self)
       LOCKS_EXCLUDED(Locks::runtime_shutdown_lock_);
   bool IsGCRequestPending() const;
@@ -671,6 +806,10 @@ class Heap {
   // Find a collector based on GC type.
   collector::GarbageCollector* FindCollectorByGcType(collector::GcType gc_type);
 
+  // Create a malloc space from the mem map, uses RosAlloc if kUseRosAlloc is true.
+  space::MallocSpace* CreateMallocSpaceFromMemMap(MemMap* mem_map, size_t initial_size,
+                                                  size_t growth_limit, size_t capacity,
+                                                  const char* name, bool can_move_objects);
   // Create the main free list space, typically either a RosAlloc space or DlMalloc space.
   void CreateMainMallocSpace(MemMap* mem_map, size_t initial_size, size_t growth_limit,
                              size_t capacity);
@@ -728,6 +867,10 @@ class Heap {
   // space is typically either the dlmalloc_space_ or the rosalloc_space_.
   space::MallocSpace* main_space_;
 
+  // The spare space the main space is compacted into when the process is idle, swapped with the
+  // main space after each homogeneous space compaction. Not added to the heap's spaces.
+  space::MallocSpace* main_space_backup_;
+
   // The large object space we are currently allocating into.
   space::LargeObjectSpace* large_object_space_;
 
@@ -757,6 +900,18 @@ class Heap {
   uint64_t heap_transition_target_time_ GUARDED_BY(heap_trim_request_lock_);
   // If we have a heap trim request pending.
   bool heap_trim_request_pending_ GUARDED_BY(heap_trim_request_lock_);
+  // If we have an idle check pending.
+  bool idle_check_pending_ GUARDED_BY(heap_trim_request_lock_);
+  // When the pending idle check decides whether the process is idle (nano seconds).
+  uint64_t idle_check_target_time_ GUARDED_BY(heap_trim_request_lock_);
+  // The bytes allocated ever when the pending idle check was requested.
+  uint64_t idle_check_bytes_allocated_ GUARDED_BY(heap_trim_request_lock_);
+  // If we have an allocation prefault request pending.
+  bool allocation_prefault_pending_ GUARDED_BY(heap_trim_request_lock_);
+  // Signaled along with the heap trimmer daemon, wakes it up from waiting for an idle check.
+  std::unique_ptr<ConditionVariable> heap_trim_request_cond_ GUARDED_BY(heap_trim_request_lock_);
+  // How many times the heap trimmer daemon was signaled.
+  uint64_t heap_trim_signal_count_ GUARDED_BY(heap_trim_request_lock_);
 
   // How many GC threads we may use for paused parts of garbage collection.
   const size_t parallel_gc_threads_;
@@ -764,6 +919,9 @@ class Heap {
   // How many GC threads we may use for unpaused parts of garbage collection.
   const size_t conc_gc_threads_;
 
+  // Whether the GC threads are pinned to CPUs, see ThreadPool::PinWorkers.
+  const bool pin_gc_threads_;
+
   // Boolean for if we are in low memory mode.
   const bool low_memory_mode_;
 
@@ -792,6 +950,12 @@ class Heap {
   // Reference processor;
   ReferenceProcessor reference_processor_;
 
+  // Samples the instrumented allocations by call site.
+  AllocationSampler allocation_sampler_;
+
+  // Frees the native memory of the unreachable objects registered with it.
+  NativeCleaner native_cleaner_;
+
   // True while the garbage collector is running.
   volatile CollectorType collector_type_running_ GUARDED_BY(gc_complete_lock_);
 
@@ -816,6 +980,11 @@ class Heap {
   // The watermark at which a GC is performed inside of registerNativeAllocation.
   size_t native_footprint_limit_;
 
+  // The native bytes at which registerNativeAllocation requests a concurrent GC. Lower than
+  // native_footprint_gc_watermark_ when, at the native allocation rate, a concurrent GC started at
+  // the watermark wouldn't finish before the native allocations reach native_footprint_limit_.
+  size_t native_concurrent_start_bytes_;
+
   // Whether or not we need to run finalizers in the next native allocation.
   bool native_need_to_run_finalization_;
 
@@ -826,6 +995,14 @@ class Heap {
   // it completes ahead of an allocation failing.
   size_t concurrent_start_bytes_;
 
+  // While a concurrent GC runs, the allocation which makes num_bytes_allocated_ exceed
+  // allocation_pacing_start_bytes_ pauses its thread briefly, and moves the threshold up by
+  // allocation_pacing_step_bytes_. The pauses start at allocation_pacing_begin_bytes_, halfway
+  // between the bytes allocated when the GC started and the footprint limit.
+  size_t allocation_pacing_start_bytes_;
+  size_t allocation_pacing_begin_bytes_;
+  size_t allocation_pacing_step_bytes_;
+
   // Since the heap was created, how many bytes have been freed.
   size_t total_bytes_freed_ever_;
 
@@ -838,6 +1015,21 @@ class Heap {
   // Bytes which are allocated and managed by native code but still need to be accounted for.
   Atomic<size_t> native_bytes_allocated_;
 
+  // Bytes registered by registerNativeAllocation since the heap was created, and at the end of
+  // the last GC, to estimate the native allocation rate.
+  Atomic<size_t> native_bytes_registered_ever_;
+  size_t last_gc_native_bytes_registered_;
+
+  // The GCs registerNativeAllocation requested concurrently, and the ones it ran itself.
+  Atomic<size_t> native_concurrent_gc_request_count_;
+  Atomic<size_t> native_blocking_gc_count_;
+
+  // The number of GCs run, which starts a new TLAB sizing period for every thread.
+  Atomic<uint32_t> gc_count_;
+  // The TLABs allocated, and the bytes left unused at the end of the retired ones.
+  Atomic<size_t> tlab_refill_count_;
+  Atomic<size_t> tlab_wasted_bytes_;
+
   // Data structure GC overhead.
   Atomic<size_t> gc_memory_overhead_;
 
@@ -851,6 +1043,10 @@ class Heap {
   bool verify_pre_gc_rosalloc_;
   bool verify_pre_sweeping_rosalloc_;
   bool verify_post_gc_rosalloc_;
+  // The time in ns each GC may spend verifying sampled cards before the GC, 0 if disabled.
+  const uint64_t sampled_verification_budget_;
+  // The seed of the random choice of the verified cards.
+  unsigned int sampled_verification_seed_;
 
   // RAII that temporarily disables the rosalloc verification during
   // the zygote fork.
@@ -891,6 +1087,23 @@ class Heap {
   // and the start of the current one.
   uint64_t allocation_rate_;
 
+  // Estimated native allocation rate (bytes / second), computed as allocation_rate_.
+  uint64_t native_allocation_rate_;
+
+  // The duration of the last GC, which concurrent GCs for native allocations start early for.
+  uint64_t last_gc_duration_ns_;
+
+  // The number of GCs after which the heap footprint limit grew or shrank.
+  uint64_t heap_growth_count_;
+  uint64_t heap_shrink_count_;
+  // The number of homogeneous space compactions done by idle checks.
+  uint64_t homogeneous_space_compact_count_;
+
+  // The file the GC metrics are periodically written to, empty if disabled.
+  const std::string gc_metrics_file_;
+  // When the GC metrics were last written to gc_metrics_file_.
+  uint64_t last_gc_metrics_write_ns_;
+
   // For a GC cycle, a bitmap that is set corresponding to the
   std::unique_ptr<accounting::HeapBitmap> live_bitmap_ GUARDED_BY(Locks::heap_bitmap_lock_);
   std::unique_ptr<accounting::HeapBitmap> mark_bitmap_ GUARDED_BY(Locks::heap_bitmap_lock_);
@@ -917,6 +1130,9 @@ class Heap {
   space::BumpPointerSpace* bump_pointer_space_;
   // Temp space is the space which the semispace collector copies to.
   space::BumpPointerSpace* temp_space_;
+  // Size of the bump pointer space at which the nursery is full and allocations fail over to a
+  // minor collection, see kDefaultNurserySize.
+  size_t nursery_limit_;
 
   // Minimum free guarantees that you always have at least min_free_ free bytes after growing for
   // utilization, regardless of target utilization ratio.
@@ -931,9 +1147,17 @@ class Heap {
   // How much more we grow the heap when we are a foreground app instead of background.
   double foreground_heap_growth_multiplier_;
 
+  // If non zero, the fraction of the time the GC should take. A non sticky GC then sizes the free
+  // space from its duration and the allocation rate instead of from target_utilization_.
+  const double target_gc_time_ratio_;
+
   // Total time which mutators are paused or waiting for GC to complete.
   uint64_t total_wait_time_;
 
+  // How many times, and for how long in total, allocations were paced.
+  uint64_t allocation_pacing_count_;
+  uint64_t total_allocation_pacing_time_;
+
   // Total number of objects allocated in microseconds.
   AtomicInteger total_allocation_time_;
 
@@ -950,6 +1174,7 @@ class Heap {
   const bool running_on_valgrind_;
   const bool use_tlab_;
 
+  friend class collector::ConcurrentCopying;
   friend class collector::GarbageCollector;
   friend class collector::MarkSweep;
   friend class collector::SemiSpace;
@@ -60,6 +60,28 @@ TEST_F(HeapTest, GarbageCollectClassLinkerInit) {
   Runtime::Current()->GetHeap()->CollectGarbage(false);
 }
 
+TEST_F(HeapTest, DumpGcMetrics) {
+  Heap* heap = Runtime::Current()->GetHeap();
+  heap->CollectGarbage(false);
+  std::ostringstream os;
+  heap->DumpGcMetrics(os);
+  const std::string metrics = os.str();
+  EXPECT_NE(std::string::npos, metrics.find("heap.bytes_allocated_ever "));
+  EXPECT_NE(std::string::npos, metrics.find("heap.growth_count "));
+  // The explicit GC above ran at least one collector with at least one pause.
+  EXPECT_NE(std::string::npos, metrics.find(".pause_histogram_us "));
+}
+
+TEST_F(HeapTest, DumpClassHistogram) {
+  Heap* heap = Runtime::Current()->GetHeap();
+  std::ostringstream os;
+  heap->DumpClassHistogram(os, 10);
+  const std::string histogram = os.str();
+  EXPECT_EQ(0u, histogram.find("Class histogram: "));
+  // Two header lines and the ten classes taking the most bytes, the boot image has more classes.
+  EXPECT_EQ(12, std::count(histogram.begin(), histogram.end(), '\n'));
+}
+
 TEST_F(HeapTest, HeapBitmapCapacityTest) {
   byte* heap_begin = reinterpret_cast<byte*>(0x1000);
   const size_t heap_capacity = kObjectAlignment * (sizeof(intptr_t) * 8 + 1);
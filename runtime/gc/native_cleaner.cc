@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "native_cleaner.h"
+
+#include "thread.h"
+
+namespace art {
+namespace gc {
+
+NativeCleaner::NativeCleaner()
+    : lock_("native cleaner lock"), allow_new_cleaners_(true),
+      new_cleaner_condition_("native cleaner condition", lock_) {
+}
+
+void NativeCleaner::Register(Thread* self, mirror::Object* obj, NativeFreeFunction* free_function,
+                             void* native_ptr) {
+  DCHECK(obj != nullptr);
+  DCHECK(free_function != nullptr);
+  MutexLock mu(self, lock_);
+  while (UNLIKELY(!allow_new_cleaners_)) {
+    new_cleaner_condition_.WaitHoldingLocks(self);
+  }
+  Cleaner cleaner = { obj, free_function, native_ptr };
+  cleaners_.push_back(cleaner);
+}
+
+void NativeCleaner::Sweep(IsMarkedCallback* callback, void* arg) {
+  MutexLock mu(Thread::Current(), lock_);
+  size_t live_count = 0;
+  for (const Cleaner& cleaner : cleaners_) {
+    mirror::Object* new_obj = callback(cleaner.object, arg);
+    if (new_obj == nullptr) {
+      queued_cleaners_.push_back(cleaner);
+    } else {
+      Cleaner& live_cleaner = cleaners_[live_count++];
+      live_cleaner = cleaner;
+      live_cleaner.object = new_obj;
+    }
+  }
+  cleaners_.resize(live_count);
+}
+
+void NativeCleaner::AllowNewCleaners() {
+  Thread* self = Thread::Current();
+  MutexLock mu(self, lock_);
+  allow_new_cleaners_ = true;
+  new_cleaner_condition_.Broadcast(self);
+}
+
+void NativeCleaner::DisallowNewCleaners() {
+  MutexLock mu(Thread::Current(), lock_);
+  allow_new_cleaners_ = false;
+}
+
+void NativeCleaner::RunQueuedCleaners(Thread* self) {
+  Locks::mutator_lock_->AssertNotHeld(self);
+  std::vector<Cleaner> cleaners;
+  {
+    MutexLock mu(self, lock_);
+    cleaners.swap(queued_cleaners_);
+  }
+  for (const Cleaner& cleaner : cleaners) {
+    cleaner.free_function(cleaner.native_ptr);
+  }
+}
+
+size_t NativeCleaner::GetCleanerCount() {
+  MutexLock mu(Thread::Current(), lock_);
+  return cleaners_.size();
+}
+
+}  // namespace gc
+}  // namespace art
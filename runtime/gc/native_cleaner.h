@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_NATIVE_CLEANER_H_
+#define ART_RUNTIME_GC_NATIVE_CLEANER_H_
+
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "object_callbacks.h"
+
+namespace art {
+
+class Thread;
+
+namespace mirror {
+class Object;
+}  // namespace mirror
+
+namespace gc {
+
+// Frees the native memory of objects once they are unreachable, for the objects which only need
+// to free native memory when they die. Unlike a finalizer, a cleaner needs no FinalizerReference,
+// doesn't keep its object alive for another GC and doesn't wait for the FinalizerDaemon: the
+// cleaners are swept with the system weaks, and the free functions of the dead objects are called
+// by the thread which ran the GC, once it is done. A free function must not call into the runtime.
+// Managed code registers cleaners with VMRuntime.registerNativeCleaner.
+class NativeCleaner {
+ public:
+  typedef void NativeFreeFunction(void* native_ptr);
+
+  NativeCleaner();
+
+  // Calls free_function(native_ptr) after a GC finds obj unreachable.
+  void Register(Thread* self, mirror::Object* obj, NativeFreeFunction* free_function,
+                void* native_ptr) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  // Updates the objects of the cleaners, and queues the cleaners of the unmarked objects.
+  void Sweep(IsMarkedCallback* callback, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+  void AllowNewCleaners() LOCKS_EXCLUDED(lock_);
+  void DisallowNewCleaners() LOCKS_EXCLUDED(lock_);
+
+  // Calls the free functions of the cleaners queued by Sweep.
+  void RunQueuedCleaners(Thread* self) LOCKS_EXCLUDED(Locks::mutator_lock_, lock_);
+
+  size_t GetCleanerCount() LOCKS_EXCLUDED(lock_);
+
+ private:
+  struct Cleaner {
+    mirror::Object* object;
+    NativeFreeFunction* free_function;
+    void* native_ptr;
+  };
+
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  // As for monitors, a cleaner registered while sweeping may be for an object allocated in memory
+  // the sweep frees, the sweep would then wrongly run it.
+  bool allow_new_cleaners_ GUARDED_BY(lock_);
+  ConditionVariable new_cleaner_condition_ GUARDED_BY(lock_);
+  std::vector<Cleaner> cleaners_ GUARDED_BY(lock_);
+  std::vector<Cleaner> queued_cleaners_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(NativeCleaner);
+};
+
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_NATIVE_CLEANER_H_
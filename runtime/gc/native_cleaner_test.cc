@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "native_cleaner.h"
+
+#include "common_runtime_test.h"
+#include "gc/heap.h"
+#include "handle_scope-inl.h"
+#include "mirror/string.h"
+#include "scoped_thread_state_change.h"
+
+namespace art {
+namespace gc {
+
+class NativeCleanerTest : public CommonRuntimeTest {};
+
+static size_t freed_count = 0;
+
+static void CountFree(void* native_ptr) {
+  ++freed_count;
+  delete reinterpret_cast<int*>(native_ptr);
+}
+
+TEST_F(NativeCleanerTest, CleanUnreachableObjects) {
+  Heap* heap = Runtime::Current()->GetHeap();
+  NativeCleaner* cleaner = heap->GetNativeCleaner();
+  const size_t cleaner_count = cleaner->GetCleanerCount();
+  freed_count = 0;
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<1> hs(soa.Self());
+  Handle<mirror::String> live(
+      hs.NewHandle(mirror::String::AllocFromModifiedUtf8(soa.Self(), "live")));
+  ASSERT_TRUE(live.Get() != nullptr);
+  cleaner->Register(soa.Self(), live.Get(), CountFree, new int(0));
+  for (size_t i = 0; i < 16; ++i) {
+    mirror::String* dead = mirror::String::AllocFromModifiedUtf8(soa.Self(), "dead");
+    ASSERT_TRUE(dead != nullptr);
+    cleaner->Register(soa.Self(), dead, CountFree, new int(0));
+  }
+  EXPECT_EQ(cleaner_count + 17, cleaner->GetCleanerCount());
+  {
+    ScopedThreadStateChange tsc(soa.Self(), kNative);
+    heap->CollectGarbage(false);
+  }
+  // Only the cleaners of the unreachable strings ran.
+  EXPECT_EQ(16U, freed_count);
+  EXPECT_EQ(cleaner_count + 1, cleaner->GetCleanerCount());
+}
+
+}  // namespace gc
+}  // namespace art
@@ -29,7 +29,8 @@ namespace gc {
 ReferenceProcessor::ReferenceProcessor()
     : process_references_args_(nullptr, nullptr, nullptr), slow_path_enabled_(false),
       preserving_references_(false), lock_("reference processor lock", kReferenceProcessorLock),
-      condition_("reference processor condition", lock_) {
+      condition_("reference processor condition", lock_), slow_path_count_(0), blocked_count_(0),
+      total_blocked_ns_(0), max_blocked_ns_(0), references_cleared_(0) {
 }
 
 void ReferenceProcessor::EnableSlowPath() {
@@ -53,11 +54,18 @@ mirror::Object* ReferenceProcessor::GetReferent(Thread* self, mirror::Reference*
     return nullptr;
   }
   MutexLock mu(self, lock_);
-  while (slow_path_enabled_) {
+  ++slow_path_count_;
+  uint64_t wait_start_ns = 0;
+  mirror::Object* result = nullptr;
+  for (;;) {
+    if (!slow_path_enabled_) {
+      result = reference->GetReferent();
+      break;
+    }
     mirror::Object* const referent = reference->GetReferent();
     // If the referent became cleared, return it.
     if (referent == nullptr) {
-      return nullptr;
+      break;
     }
     // Try to see if the referent is already marked by using the is_marked_callback. We can return
     // it to the mutator as long as the GC is not preserving references. If the GC is
@@ -69,12 +77,22 @@ mirror::Object* ReferenceProcessor::GetReferent(Thread* self, mirror::Reference*
       // If it's null it means not marked, but it could become marked if the referent is reachable
       // by finalizer referents. So we can not return in this case and must block.
       if (obj != nullptr) {
-        return obj;
+        result = obj;
+        break;
       }
     }
+    if (wait_start_ns == 0) {
+      wait_start_ns = NanoTime();
+      ++blocked_count_;
+    }
     condition_.WaitHoldingLocks(self);
   }
-  return reference->GetReferent();
+  if (wait_start_ns != 0) {
+    const uint64_t blocked_ns = NanoTime() - wait_start_ns;
+    total_blocked_ns_ += blocked_ns;
+    max_blocked_ns_ = std::max(max_blocked_ns_, blocked_ns);
+  }
+  return result;
 }
 
 mirror::Object* ReferenceProcessor::PreserveSoftReferenceCallback(mirror::Object* obj, void* arg) {
@@ -95,6 +113,22 @@ void ReferenceProcessor::StopPreservingReferences(Thread* self) {
   condition_.Broadcast(self);
 }
 
+void ReferenceProcessor::ClearWhiteReferences(Thread* self, bool concurrent,
+                                              ReferenceQueue* queue,
+                                              IsMarkedCallback* is_marked_callback, void* arg) {
+  const size_t batch_size = concurrent ? kClearWhiteReferencesBatchSize :
+      std::numeric_limits<size_t>::max();
+  while (!queue->IsEmpty()) {
+    const size_t cleared = queue->ClearWhiteReferences(cleared_references_, is_marked_callback,
+                                                       arg, batch_size);
+    MutexLock mu(self, lock_);
+    references_cleared_ += cleared;
+    if (concurrent && cleared != 0) {
+      condition_.Broadcast(self);
+    }
+  }
+}
+
 // Process reference class instances and schedule finalizations.
 void ReferenceProcessor::ProcessReferences(bool concurrent, TimingLogger* timings,
                                            bool clear_soft_references,
@@ -127,8 +161,16 @@ void ReferenceProcessor::ProcessReferences(bool concurrent, TimingLogger* timing
     }
   }
   // Clear all remaining soft and weak references with white referents.
-  soft_reference_queue_.ClearWhiteReferences(cleared_references_, is_marked_callback, arg);
-  weak_reference_queue_.ClearWhiteReferences(cleared_references_, is_marked_callback, arg);
+  ClearWhiteReferences(self, concurrent, &soft_reference_queue_, is_marked_callback, arg);
+  ClearWhiteReferences(self, concurrent, &weak_reference_queue_, is_marked_callback, arg);
+  if (concurrent) {
+    // Every reference the mutators can reach is now either cleared or has a marked referent, the
+    // references which are still queued after the finalizer references are processed are only
+    // reachable through finalizable objects. So there is no need to keep GetReferent blocked while
+    // we mark from the finalizable objects.
+    MutexLock mu(self, lock_);
+    DisableSlowPath(self);
+  }
   {
     TimingLogger::ScopedSplit split(concurrent ? "EnqueueFinalizerReferences" :
         "(Paused)EnqueueFinalizerReferences", timings);
@@ -144,10 +186,10 @@ void ReferenceProcessor::ProcessReferences(bool concurrent, TimingLogger* timing
     }
   }
   // Clear all finalizer referent reachable soft and weak references with white referents.
-  soft_reference_queue_.ClearWhiteReferences(cleared_references_, is_marked_callback, arg);
-  weak_reference_queue_.ClearWhiteReferences(cleared_references_, is_marked_callback, arg);
+  ClearWhiteReferences(self, false, &soft_reference_queue_, is_marked_callback, arg);
+  ClearWhiteReferences(self, false, &weak_reference_queue_, is_marked_callback, arg);
   // Clear all phantom references with white referents.
-  phantom_reference_queue_.ClearWhiteReferences(cleared_references_, is_marked_callback, arg);
+  ClearWhiteReferences(self, false, &phantom_reference_queue_, is_marked_callback, arg);
   // At this point all reference queues other than the cleared references should be empty.
   DCHECK(soft_reference_queue_.IsEmpty());
   DCHECK(weak_reference_queue_.IsEmpty());
@@ -160,10 +202,6 @@ void ReferenceProcessor::ProcessReferences(bool concurrent, TimingLogger* timing
     // starts since there is a small window of time where slow_path_enabled_ is enabled but the
     // callback isn't yet set.
     process_references_args_.is_marked_callback_ = nullptr;
-    if (concurrent) {
-      // Done processing, disable the slow path and broadcast to the waiters.
-      DisableSlowPath(self);
-    }
   }
   timings->EndSplit();
 }
@@ -202,6 +240,18 @@ void ReferenceProcessor::DelayReferenceReferent(mirror::Class* klass, mirror::Re
   }
 }
 
+void ReferenceProcessor::DumpStats(std::ostream& os) {
+  MutexLock mu(Thread::Current(), lock_);
+  os << "Reference.get() slow path calls: " << slow_path_count_ << " blocked: " << blocked_count_
+     << "\n";
+  if (blocked_count_ != 0) {
+    os << "Reference.get() total blocked time: " << PrettyDuration(total_blocked_ns_)
+       << " mean: " << PrettyDuration(total_blocked_ns_ / blocked_count_)
+       << " max: " << PrettyDuration(max_blocked_ns_) << "\n";
+  }
+  os << "Total references cleared: " << references_cleared_ << "\n";
+}
+
 void ReferenceProcessor::EnqueueClearedReferences() {
   Thread* self = Thread::Current();
   Locks::mutator_lock_->AssertNotHeld(self);
@@ -58,8 +58,14 @@ class ReferenceProcessor {
   void DelayReferenceReferent(mirror::Class* klass, mirror::Reference* ref,
                               IsMarkedCallback is_marked_callback, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Dump how often and for how long GetReferent blocked, and how many references got cleared.
+  void DumpStats(std::ostream& os) LOCKS_EXCLUDED(lock_);
 
  private:
+  // Number of references cleared between two wake ups of the threads blocked in GetReferent when
+  // processing references concurrently.
+  static constexpr size_t kClearWhiteReferencesBatchSize = 1024;
+
   class ProcessReferencesArgs {
    public:
     ProcessReferencesArgs(IsMarkedCallback* is_marked_callback,
@@ -79,6 +85,12 @@ class ReferenceProcessor {
   // referents.
   void StartPreservingReferences(Thread* self) LOCKS_EXCLUDED(lock_);
   void StopPreservingReferences(Thread* self) LOCKS_EXCLUDED(lock_);
+  // Clear the white referents of a queue. When concurrent this is done in batches, waking up the
+  // threads blocked in GetReferent after each batch since the reference they are waiting on may
+  // have been cleared.
+  void ClearWhiteReferences(Thread* self, bool concurrent, ReferenceQueue* queue,
+                            IsMarkedCallback* is_marked_callback, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
   // Process args, used by the GetReferent to return referents which are already marked.
   ProcessReferencesArgs process_references_args_ GUARDED_BY(lock_);
   // Boolean for whether or not we need to go slow path in GetReferent.
@@ -91,6 +103,14 @@ class ReferenceProcessor {
   // Condition that people wait on if they attempt to get the referent of a reference while
   // processing is in progress.
   ConditionVariable condition_ GUARDED_BY(lock_);
+  // Number of GetReferent calls which took the slow path, and how many of them had to wait.
+  uint64_t slow_path_count_ GUARDED_BY(lock_);
+  uint64_t blocked_count_ GUARDED_BY(lock_);
+  // Total and longest time spent waiting in GetReferent.
+  uint64_t total_blocked_ns_ GUARDED_BY(lock_);
+  uint64_t max_blocked_ns_ GUARDED_BY(lock_);
+  // Number of soft, weak and phantom references cleared.
+  uint64_t references_cleared_ GUARDED_BY(lock_);
   // Reference queues used by the GC.
   ReferenceQueue soft_reference_queue_;
   ReferenceQueue weak_reference_queue_;
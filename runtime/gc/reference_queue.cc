@@ -104,10 +104,11 @@ void ReferenceQueue::Dump(std::ostream& os) const {
   }
 }
 
-void ReferenceQueue::ClearWhiteReferences(ReferenceQueue& cleared_references,
-                                          IsMarkedCallback* preserve_callback,
-                                          void* arg) {
-  while (!IsEmpty()) {
+size_t ReferenceQueue::ClearWhiteReferences(ReferenceQueue& cleared_references,
+                                            IsMarkedCallback* preserve_callback,
+                                            void* arg, size_t max_references) {
+  size_t cleared = 0;
+  for (size_t i = 0; i < max_references && !IsEmpty(); ++i) {
     mirror::Reference* ref = DequeuePendingReference();
     mirror::Object* referent = ref->GetReferent<kWithoutReadBarrier>();
     if (referent != nullptr) {
@@ -122,12 +123,14 @@ void ReferenceQueue::ClearWhiteReferences(ReferenceQueue& cleared_references,
         if (ref->IsEnqueuable()) {
           cleared_references.EnqueuePendingReference(ref);
         }
+        ++cleared;
       } else if (referent != forward_address) {
         // Object moved, need to updated the referent.
         ref->SetReferent<false>(forward_address);
       }
     }
   }
+  return cleared;
 }
 
 void ReferenceQueue::EnqueueFinalizerReferences(ReferenceQueue& cleared_references,
@@ -18,6 +18,7 @@
 #define ART_RUNTIME_GC_REFERENCE_QUEUE_H_
 
 #include <iosfwd>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -68,10 +69,13 @@ class ReferenceQueue {
   void PreserveSomeSoftReferences(IsMarkedCallback* preserve_callback, void* arg)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   // Unlink the reference list clearing references objects with white referents.  Cleared references
-  // registered to a reference queue are scheduled for appending by the heap worker thread.
-  void ClearWhiteReferences(ReferenceQueue& cleared_references,
-                            IsMarkedCallback* is_marked_callback,
-                            void* arg)
+  // registered to a reference queue are scheduled for appending by the heap worker thread. Stops
+  // after max_references references so that the caller can process the list in batches, returns
+  // the number of referents which got cleared.
+  size_t ClearWhiteReferences(ReferenceQueue& cleared_references,
+                              IsMarkedCallback* is_marked_callback,
+                              void* arg,
+                              size_t max_references = std::numeric_limits<size_t>::max())
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void Dump(std::ostream& os) const
         SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -56,6 +56,12 @@ class BumpPointerSpace FINAL : public ContinuousMemMapAllocSpace {
   mirror::Object* AllocNonvirtual(size_t num_bytes);
   mirror::Object* AllocNonvirtualWithoutAccounting(size_t num_bytes);
 
+  // Accounts for objects allocated in memory obtained with AllocNonvirtualWithoutAccounting.
+  void RecordAllocations(size_t num_objects, size_t num_bytes) {
+    objects_allocated_.FetchAndAdd(num_objects);
+    bytes_allocated_.FetchAndAdd(num_bytes);
+  }
+
   // Return the storage space required by obj.
   size_t AllocationSize(mirror::Object* obj, size_t* usable_size) OVERRIDE
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
@@ -99,6 +99,37 @@ static bool GenerateImage(const std::string& image_filename, std::string* error_
   return Exec(arg_vector, error_msg);
 }
 
+// Largest distance RelocateImage() moves an image by, either way.
+static constexpr int32_t kMaxRelocationDelta = 16 * MB;
+
+// Writes a copy of the image and oat file at `image_filename` moved to a random base to
+// `dest_filename`. This only patches the addresses listed by the image's relocation tables, which
+// takes far less time than generating a new image.
+static bool RelocateImage(const std::string& image_filename, const std::string& dest_filename,
+                          std::string* error_msg) {
+  std::vector<std::string> arg_vector;
+
+  std::string patchoat(GetAndroidRoot());
+  patchoat += (kIsDebugBuild ? "/bin/patchoatd" : "/bin/patchoat");
+  arg_vector.push_back(patchoat);
+
+  arg_vector.push_back(std::string("--input-image=") + image_filename);
+  arg_vector.push_back(std::string("--output-image=") + dest_filename);
+
+  // A non-zero page aligned delta in [-kMaxRelocationDelta, kMaxRelocationDelta].
+  unsigned int seed = static_cast<unsigned int>(NanoTime());
+  const int32_t max_pages = kMaxRelocationDelta / kPageSize;
+  int32_t pages = rand_r(&seed) % (2 * max_pages) - max_pages;
+  if (pages >= 0) {
+    ++pages;
+  }
+  arg_vector.push_back(StringPrintf("--base-offset-delta=%d", pages * kPageSize));
+
+  std::string command_line(Join(arg_vector, ' '));
+  LOG(INFO) << "RelocateImage: " << command_line;
+  return Exec(arg_vector, error_msg);
+}
+
 bool ImageSpace::FindImageFilename(const char* image_location,
                                    const InstructionSet image_isa,
                                    std::string* image_filename,
@@ -156,10 +187,22 @@ ImageSpace* ImageSpace::Create(const char* image_location,
       return space;
     }
 
-    // If the /system file exists, it should be up-to-date, don't try to generate it.
+    // If the /system file exists, it should be up-to-date, don't try to generate it. It failed
+    // to load because its addresses are taken, move a copy of it into the dalvik-cache instead.
     // If it's not the /system file, log a warning and fall through to GenerateImage.
     if (is_system) {
-      LOG(FATAL) << "Failed to load image '" << image_filename << "': " << error_msg;
+      LOG(WARNING) << "Failed to load image '" << image_filename << "': " << error_msg;
+      const std::string dalvik_cache = GetDalvikCacheOrDie(GetInstructionSetString(image_isa));
+      std::string relocated_filename(GetDalvikCacheFilenameOrDie(image_location,
+                                                                 dalvik_cache.c_str()));
+      if (RelocateImage(image_filename, relocated_filename, &error_msg)) {
+        space = ImageSpace::Init(relocated_filename.c_str(), image_location, true, &error_msg);
+        if (space != nullptr) {
+          return space;
+        }
+      }
+      LOG(FATAL) << "Failed to relocate image '" << image_filename << "' to '"
+                 << relocated_filename << "': " << error_msg;
       return nullptr;
     } else {
       LOG(WARNING) << error_msg;
@@ -228,6 +271,12 @@ ImageSpace* ImageSpace::Init(const char* image_filename, const char* image_locat
   }
   CHECK_EQ(image_header.GetImageBegin(), map->Begin());
   DCHECK_EQ(0, memcmp(&image_header, map->Begin(), sizeof(ImageHeader)));
+  // The whole image is touched at startup, when the class roots and the dex caches are set up and
+  // the classes used; start reading it in rather than faulting it in a page at a time. Unlike
+  // MAP_POPULATE this doesn't block until it's all read.
+  if (madvise(map->Begin(), map->Size(), MADV_WILLNEED) != 0) {
+    PLOG(WARNING) << "madvise(MADV_WILLNEED) failed for " << image_filename;
+  }
 
   std::unique_ptr<MemMap> image_map(MemMap::MapFileAtAddress(nullptr, image_header.GetImageBitmapSize(),
                                                        PROT_READ, MAP_PRIVATE,
@@ -97,7 +97,13 @@ void LargeObjectSpace::CopyLiveToMarked() {
 
 LargeObjectMapSpace::LargeObjectMapSpace(const std::string& name)
     : LargeObjectSpace(name, nullptr, nullptr),
-      lock_("large object map space lock", kAllocSpaceLock) {}
+      lock_("large object map space lock", kAllocSpaceLock), cached_bytes_(0) {}
+
+LargeObjectMapSpace::~LargeObjectMapSpace() {
+  for (auto& pair : cached_mem_maps_) {
+    delete pair.second.mem_map;
+  }
+}
 
 LargeObjectMapSpace* LargeObjectMapSpace::Create(const std::string& name) {
   if (Runtime::Current()->RunningOnValgrind()) {
@@ -107,14 +113,39 @@ LargeObjectMapSpace* LargeObjectMapSpace::Create(const std::string& name) {
   }
 }
 
+MemMap* LargeObjectMapSpace::TakeCachedMemMap(Thread* self, size_t num_bytes) {
+  const size_t size = RoundUp(num_bytes, kPageSize);
+  CachedMemMap cached;
+  {
+    MutexLock mu(self, lock_);
+    // Best fit, the smallest cached mem map which is large enough.
+    auto it = cached_mem_maps_.lower_bound(size);
+    if (it == cached_mem_maps_.end() || it->first > size + size / kCachedMemMapWasteRatio) {
+      return nullptr;
+    }
+    cached = it->second;
+    cached_bytes_ -= it->first;
+    cached_mem_maps_.erase(it);
+  }
+  if (cached.dirty) {
+    // Newly allocated objects must be zeroed, do it outside of the lock.
+    memset(cached.mem_map->Begin(), 0, cached.mem_map->Size());
+  }
+  return cached.mem_map;
+}
+
 mirror::Object* LargeObjectMapSpace::Alloc(Thread* self, size_t num_bytes,
                                            size_t* bytes_allocated, size_t* usable_size) {
-  std::string error_msg;
-  MemMap* mem_map = MemMap::MapAnonymous("large object space allocation", NULL, num_bytes,
-                                         PROT_READ | PROT_WRITE, true, &error_msg);
-  if (UNLIKELY(mem_map == NULL)) {
-    LOG(WARNING) << "Large object allocation failed: " << error_msg;
-    return NULL;
+  MemMap* mem_map = TakeCachedMemMap(self, num_bytes);
+  if (mem_map == nullptr) {
+    std::string error_msg;
+    mem_map = MemMap::MapAnonymous("large object space allocation", NULL, num_bytes,
+                                   PROT_READ | PROT_WRITE, true, &error_msg);
+    if (UNLIKELY(mem_map == NULL)) {
+      LOG(WARNING) << "Large object allocation failed: " << error_msg;
+      return NULL;
+    }
+    mem_map->AdviseHugePages();
   }
   MutexLock mu(self, lock_);
   mirror::Object* obj = reinterpret_cast<mirror::Object*>(mem_map->Begin());
@@ -144,14 +175,37 @@ size_t LargeObjectMapSpace::Free(Thread* self, mirror::Object* ptr) {
   CHECK(found != mem_maps_.end()) << "Attempted to free large object" << ptr
       << "which was not live";
   DCHECK_GE(num_bytes_allocated_, found->second->Size());
-  size_t allocation_size = found->second->Size();
+  MemMap* mem_map = found->second;
+  size_t allocation_size = mem_map->Size();
   num_bytes_allocated_ -= allocation_size;
   --num_objects_allocated_;
-  delete found->second;
   mem_maps_.erase(found);
+  if (cached_bytes_ + allocation_size <= kMaxCachedBytes) {
+    // Keep the mem map around for a later allocation, the pages are only released by Trim.
+    CachedMemMap cached = { mem_map, true };
+    cached_mem_maps_.insert(std::make_pair(allocation_size, cached));
+    cached_bytes_ += allocation_size;
+  } else {
+    delete mem_map;
+  }
   return allocation_size;
 }
 
+size_t LargeObjectMapSpace::Trim() {
+  MutexLock mu(Thread::Current(), lock_);
+  size_t reclaimed = 0;
+  for (auto& pair : cached_mem_maps_) {
+    CachedMemMap& cached = pair.second;
+    if (cached.dirty) {
+      CHECK_NE(madvise(cached.mem_map->Begin(), cached.mem_map->Size(), MADV_DONTNEED), -1)
+          << "madvise failed";
+      cached.dirty = false;
+      reclaimed += cached.mem_map->Size();
+    }
+  }
+  return reclaimed;
+}
+
 size_t LargeObjectMapSpace::AllocationSize(mirror::Object* obj, size_t* usable_size) {
   MutexLock mu(Thread::Current(), lock_);
   auto found = mem_maps_.find(obj);
@@ -196,6 +250,7 @@ FreeListSpace* FreeListSpace::Create(const std::string& name, byte* requested_be
   MemMap* mem_map = MemMap::MapAnonymous(name.c_str(), requested_begin, size,
                                          PROT_READ | PROT_WRITE, true, &error_msg);
   CHECK(mem_map != NULL) << "Failed to allocate large object space mem map: " << error_msg;
+  mem_map->AdviseHugePages();
   return new FreeListSpace(name, mem_map, mem_map->Begin(), mem_map->End());
 }
 
@@ -22,6 +22,7 @@
 #include "safe_map.h"
 #include "space.h"
 
+#include <map>
 #include <set>
 #include <vector>
 
@@ -79,6 +80,12 @@ class LargeObjectSpace : public DiscontinuousSpace, public AllocSpace {
     return false;
   }
 
+  // Release the pages of memory the space keeps around for reuse, returns the number of bytes
+  // released. Called from the heap trim.
+  virtual size_t Trim() {
+    return 0;
+  }
+
   // Current address at which the space begins, which may vary as the space is filled.
   byte* Begin() const {
     return begin_;
@@ -125,10 +132,22 @@ class LargeObjectMapSpace : public LargeObjectSpace {
   void Walk(DlMallocSpace::WalkCallback, void* arg) OVERRIDE LOCKS_EXCLUDED(lock_);
   // TODO: disabling thread safety analysis as this may be called when we already hold lock_.
   bool Contains(const mirror::Object* obj) const NO_THREAD_SAFETY_ANALYSIS;
+  // Madvise the pages of the cached mem maps.
+  size_t Trim() OVERRIDE LOCKS_EXCLUDED(lock_);
+
+  // Freed mem maps are cached for reuse by later allocations of a similar size up to this many
+  // bytes in total, this saves the mmap and munmap calls.
+  static constexpr size_t kMaxCachedBytes = 16 * MB;
+  // A cached mem map is only reused if it is at most 1 / kCachedMemMapWasteRatio larger than the
+  // allocation.
+  static constexpr size_t kCachedMemMapWasteRatio = 4;
 
  protected:
   explicit LargeObjectMapSpace(const std::string& name);
-  virtual ~LargeObjectMapSpace() {}
+  virtual ~LargeObjectMapSpace();
+
+  // Take a cached mem map which fits num_bytes, returns nullptr if there is none.
+  MemMap* TakeCachedMemMap(Thread* self, size_t num_bytes) LOCKS_EXCLUDED(lock_);
 
   // Used to ensure mutual exclusion when the allocation spaces data structures are being modified.
   mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
@@ -137,6 +156,17 @@ class LargeObjectMapSpace : public LargeObjectSpace {
   typedef SafeMap<mirror::Object*, MemMap*, std::less<mirror::Object*>,
       accounting::GcAllocator<std::pair<mirror::Object*, MemMap*>>> MemMaps;
   MemMaps mem_maps_ GUARDED_BY(lock_);
+  struct CachedMemMap {
+    MemMap* mem_map;
+    // Whether the pages may still hold the freed object, they are zeroed before reuse unless the
+    // trim already released them.
+    bool dirty;
+  };
+  typedef std::multimap<size_t, CachedMemMap, std::less<size_t>,
+      accounting::GcAllocator<std::pair<const size_t, CachedMemMap>>> CachedMemMaps;
+  // Mem maps of freed objects, sorted by size.
+  CachedMemMaps cached_mem_maps_ GUARDED_BY(lock_);
+  size_t cached_bytes_ GUARDED_BY(lock_);
 };
 
 // A continuous large object space with a free-list to handle holes.
@@ -94,6 +94,36 @@ TEST_F(LargeObjectSpaceTest, LargeObjectTest) {
   LargeObjectTest();
 }
 
+TEST_F(LargeObjectSpaceTest, ReuseFreedMemMaps) {
+  std::unique_ptr<LargeObjectSpace> los(LargeObjectMapSpace::Create("large object space"));
+  Thread* self = Thread::Current();
+  const size_t request_size = 256 * KB;
+  size_t allocation_size = 0;
+  mirror::Object* obj = los->Alloc(self, request_size, &allocation_size, nullptr);
+  ASSERT_TRUE(obj != nullptr);
+  memset(obj, 0xAB, request_size);
+  los->Free(self, obj);
+  // A slightly smaller allocation reuses the mem map and must see zeroed memory.
+  mirror::Object* reused = los->Alloc(self, request_size - kPageSize, &allocation_size, nullptr);
+  ASSERT_EQ(obj, reused);
+  EXPECT_EQ(request_size, allocation_size);
+  for (size_t i = 0; i < request_size; ++i) {
+    ASSERT_EQ(0, reinterpret_cast<const byte*>(reused)[i]);
+  }
+  los->Free(self, reused);
+  // The trim releases the pages of the cached mem map, which stays available for reuse.
+  EXPECT_EQ(request_size, los->Trim());
+  EXPECT_EQ(0U, los->Trim());
+  // A much smaller allocation doesn't take the cached mem map.
+  mirror::Object* small = los->Alloc(self, request_size / 2, &allocation_size, nullptr);
+  ASSERT_TRUE(small != nullptr);
+  EXPECT_NE(obj, small);
+  EXPECT_EQ(request_size / 2, allocation_size);
+  los->Free(self, small);
+  EXPECT_EQ(0U, los->GetBytesAllocated());
+  EXPECT_EQ(0U, los->GetObjectsAllocated());
+}
+
 }  // namespace space
 }  // namespace gc
 }  // namespace art
@@ -82,6 +82,12 @@ DiscontinuousSpace::DiscontinuousSpace(const std::string& name,
 }
 
 void ContinuousMemMapAllocSpace::Sweep(bool swap_bitmaps, size_t* freed_objects, size_t* freed_bytes) {
+  SweepRange(swap_bitmaps, Begin(), End(), false, freed_objects, freed_bytes);
+}
+
+void ContinuousMemMapAllocSpace::SweepRange(bool swap_bitmaps, byte* begin, byte* end,
+                                            bool parallel, size_t* freed_objects,
+                                            size_t* freed_bytes) {
   DCHECK(freed_objects != nullptr);
   DCHECK(freed_bytes != nullptr);
   accounting::ContinuousSpaceBitmap* live_bitmap = GetLiveBitmap();
@@ -90,14 +96,16 @@ void ContinuousMemMapAllocSpace::Sweep(bool swap_bitmaps, size_t* freed_objects,
   if (live_bitmap == mark_bitmap) {
     return;
   }
-  SweepCallbackContext scc(swap_bitmaps, this);
+  DCHECK_LE(Begin(), begin);
+  DCHECK_LE(end, End());
+  SweepCallbackContext scc(swap_bitmaps, this, parallel);
   if (swap_bitmaps) {
     std::swap(live_bitmap, mark_bitmap);
   }
   // Bitmaps are pre-swapped for optimization which enables sweeping with the heap unlocked.
   accounting::ContinuousSpaceBitmap::SweepWalk(
-      *live_bitmap, *mark_bitmap, reinterpret_cast<uintptr_t>(Begin()),
-      reinterpret_cast<uintptr_t>(End()), GetSweepCallback(), reinterpret_cast<void*>(&scc));
+      *live_bitmap, *mark_bitmap, reinterpret_cast<uintptr_t>(begin),
+      reinterpret_cast<uintptr_t>(end), GetSweepCallback(), reinterpret_cast<void*>(&scc));
   *freed_objects += scc.freed_objects;
   *freed_bytes += scc.freed_bytes;
 }
@@ -136,9 +144,10 @@ void ContinuousMemMapAllocSpace::SwapBitmaps() {
   mark_bitmap_->SetName(temp_name);
 }
 
-Space::SweepCallbackContext::SweepCallbackContext(bool swap_bitmaps, space::Space* space)
-    : swap_bitmaps(swap_bitmaps), space(space), self(Thread::Current()), freed_objects(0),
-      freed_bytes(0) {
+Space::SweepCallbackContext::SweepCallbackContext(bool swap_bitmaps, space::Space* space,
+                                                  bool parallel)
+    : swap_bitmaps(swap_bitmaps), space(space), self(Thread::Current()), parallel(parallel),
+      freed_objects(0), freed_bytes(0) {
 }
 
 }  // namespace space
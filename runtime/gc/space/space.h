@@ -174,10 +174,13 @@ class Space {
  protected:
   struct SweepCallbackContext {
    public:
-    SweepCallbackContext(bool swap_bitmaps, space::Space* space);
+    SweepCallbackContext(bool swap_bitmaps, space::Space* space, bool parallel = false);
     const bool swap_bitmaps;
     space::Space* const space;
     Thread* const self;
+    // Set when self is a GC worker thread sweeping part of the space, the GC thread holds the
+    // heap bitmap lock on its behalf.
+    const bool parallel;
     size_t freed_objects;
     size_t freed_bytes;
   };
@@ -416,6 +419,11 @@ class ContinuousMemMapAllocSpace : public MemMapSpace, public AllocSpace {
   }
 
   void Sweep(bool swap_bitmaps, size_t* freed_objects, size_t* freed_bytes);
+  // Sweep the objects in [begin, end). Several threads may sweep disjoint ranges of the same
+  // space if parallel is set, it is up to the caller to pick ranges whose objects the allocator
+  // can free concurrently.
+  void SweepRange(bool swap_bitmaps, byte* begin, byte* end, bool parallel,
+                  size_t* freed_objects, size_t* freed_bytes);
   virtual accounting::ContinuousSpaceBitmap::SweepCallback* GetSweepCallback() = 0;
 
  protected:
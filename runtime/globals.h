@@ -48,6 +48,9 @@ static constexpr size_t kBitsPerByteLog2 = 3;
 static constexpr int kBitsPerWord = kWordSize * kBitsPerByte;
 static constexpr size_t kWordHighBitMask = static_cast<size_t>(1) << (kBitsPerWord - 1);
 
+// Size of a dex register in a compiled frame.
+static constexpr size_t kVRegSize = 4;
+
 // Required stack alignment
 static constexpr size_t kStackAlignment = 16;
 
@@ -73,6 +76,9 @@ static constexpr int kPageSize = 4096;
 static constexpr size_t kObjectAlignment = 8;
 static constexpr size_t kLargeObjectAlignment = kPageSize;
 
+// Granularity of image relocations, the size of a heap reference or the low word of a pointer.
+static constexpr size_t kRelocationAlignment = 4;
+
 // Whether or not this is a debug build. Useful in conditionals where NDEBUG isn't.
 #if defined(NDEBUG)
 static constexpr bool kIsDebugBuild = false;
@@ -31,9 +31,11 @@
 #include <string.h>
 #include <sys/time.h>
 #include <sys/uio.h>
+#include <sys/wait.h>
 #include <time.h>
 #include <time.h>
 #include <unistd.h>
+#include <zlib.h>
 
 #include <set>
 
@@ -382,10 +384,11 @@ class HprofRecord {
 
 class Hprof {
  public:
-  Hprof(const char* output_filename, int fd, bool direct_to_ddms)
+  Hprof(const char* output_filename, int fd, bool direct_to_ddms, bool compress)
       : filename_(output_filename),
         fd_(fd),
         direct_to_ddms_(direct_to_ddms),
+        compress_(compress),
         start_ns_(NanoTime()),
         current_record_(),
         gc_thread_serial_number_(0),
@@ -423,7 +426,8 @@ class Hprof {
     free(body_data_ptr_);
   }
 
-  void Dump()
+  // Returns false if the dump couldn't be written.
+  bool Dump()
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
       LOCKS_EXCLUDED(Locks::heap_bitmap_lock_) {
     // Walk the roots and the heap.
@@ -464,20 +468,24 @@ class Hprof {
         out_fd = dup(fd_);
         if (out_fd < 0) {
           ThrowRuntimeException("Couldn't dump heap; dup(%d) failed: %s", fd_, strerror(errno));
-          return;
+          return false;
         }
       } else {
         out_fd = open(filename_.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
         if (out_fd < 0) {
           ThrowRuntimeException("Couldn't dump heap; open(\"%s\") failed: %s", filename_.c_str(),
                                 strerror(errno));
-          return;
+          return false;
         }
       }
 
-      std::unique_ptr<File> file(new File(out_fd, filename_));
-      okay = file->WriteFully(header_data_ptr_, header_data_size_) &&
-          file->WriteFully(body_data_ptr_, body_data_size_);
+      if (compress_) {
+        okay = WriteCompressed(out_fd);
+      } else {
+        std::unique_ptr<File> file(new File(out_fd, filename_));
+        okay = file->WriteFully(header_data_ptr_, header_data_size_) &&
+            file->WriteFully(body_data_ptr_, body_data_size_);
+      }
       if (!okay) {
         std::string msg(StringPrintf("Couldn't dump heap; writing \"%s\" failed: %s",
                                      filename_.c_str(), strerror(errno)));
@@ -493,9 +501,36 @@ class Hprof {
           << PrettySize(header_data_size_ + body_data_size_ + 1023)
           << ") in " << PrettyDuration(duration);
     }
+    return okay;
   }
 
  private:
+  // Streams the header and the body to out_fd through zlib, in the gzip format. Closes out_fd.
+  bool WriteCompressed(int out_fd) {
+    gzFile gz = gzdopen(out_fd, "wb");
+    if (gz == nullptr) {
+      close(out_fd);
+      return false;
+    }
+    bool okay = WriteCompressed(gz, header_data_ptr_, header_data_size_) &&
+        WriteCompressed(gz, body_data_ptr_, body_data_size_);
+    return gzclose(gz) == Z_OK && okay;
+  }
+
+  // gzwrite() takes an unsigned length, so the data is written in chunks.
+  static bool WriteCompressed(gzFile gz, const char* data, size_t size) {
+    static constexpr size_t kChunkSize = 1 * MB;
+    while (size != 0) {
+      unsigned int chunk = std::min(size, kChunkSize);
+      if (gzwrite(gz, data, chunk) != static_cast<int>(chunk)) {
+        return false;
+      }
+      data += chunk;
+      size -= chunk;
+    }
+    return true;
+  }
+
   static void RootVisitor(mirror::Object** obj, void* arg, uint32_t thread_id, RootType root_type)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     DCHECK(arg != nullptr);
@@ -670,6 +705,8 @@ class Hprof {
   std::string filename_;
   int fd_;
   bool direct_to_ddms_;
+  // Whether the dump is written gzip compressed.
+  bool compress_;
 
   uint64_t start_ns_;
 
@@ -1076,16 +1113,57 @@ void Hprof::VisitRoot(const mirror::Object* obj, uint32_t thread_id, RootType ty
   gc_thread_serial_number_ = 0;
 }
 
+// Dumps the heap from a child process, whose copy-on-write address space keeps a snapshot of the
+// heap, so that the threads of this process can be resumed as soon as the child is started. The
+// child forks the dumping process and exits right away, so that init reaps the dumping process.
+// Only the forking thread runs in the children; the other threads were suspended, not holding
+// any of the locks the dump takes. Returns false if the dump has to be done in this process.
+static bool ForkAndDumpHeap(const char* filename, int fd, bool compress)
+    EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  pid_t pid = fork();
+  if (pid == -1) {
+    PLOG(WARNING) << "hprof: fork failed, dumping the heap in process";
+    return false;
+  }
+  if (pid == 0) {
+    pid_t dumper_pid = fork();
+    if (dumper_pid == 0) {
+      Hprof hprof(filename, fd, false, compress);
+      _exit(hprof.Dump() ? 0 : 1);
+    }
+    _exit(dumper_pid == -1 ? 1 : 0);
+  }
+  // With SIGCHLD ignored the child is reaped by the kernel, and its status is lost.
+  int status;
+  pid_t rc = TEMP_FAILURE_RETRY(waitpid(pid, &status, 0));
+  if (rc == -1 && errno == ECHILD) {
+    LOG(INFO) << "hprof: heap dump \"" << filename << "\" forked";
+    return true;
+  }
+  if (rc != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    LOG(WARNING) << "hprof: couldn't fork the heap dump, dumping the heap in process";
+    return false;
+  }
+  LOG(INFO) << "hprof: heap dump \"" << filename << "\" forked";
+  return true;
+}
+
 // If "direct_to_ddms" is true, the other arguments are ignored, and data is
 // sent directly to DDMS.
 // If "fd" is >= 0, the output will be written to that file descriptor.
 // Otherwise, "filename" is used to create an output file.
+// The output to a file is gzip compressed if "filename" ends with ".gz", and written by a forked
+// child if the runtime was started with -Xhprof-fork.
 void DumpHeap(const char* filename, int fd, bool direct_to_ddms) {
   CHECK(filename != NULL);
 
+  bool compress = !direct_to_ddms && EndsWith(filename, ".gz");
   Runtime::Current()->GetThreadList()->SuspendAll();
-  Hprof hprof(filename, fd, direct_to_ddms);
-  hprof.Dump();
+  if (direct_to_ddms || !Runtime::Current()->IsHprofForked() ||
+      !ForkAndDumpHeap(filename, fd, compress)) {
+    Hprof hprof(filename, fd, direct_to_ddms, compress);
+    hprof.Dump();
+  }
   Runtime::Current()->GetThreadList()->ResumeAll();
 }
 
@@ -88,6 +88,30 @@ class PACKED(4) ImageHeader {
     return RoundUp(image_size_, kPageSize);
   }
 
+  size_t GetRelocationBitmapOffset() const {
+    return relocation_bitmap_offset_;
+  }
+
+  size_t GetRelocationBitmapSize() const {
+    return relocation_bitmap_size_;
+  }
+
+  size_t GetOatRelocationsOffset() const {
+    return oat_relocations_offset_;
+  }
+
+  size_t GetOatRelocationsCount() const {
+    return oat_relocations_size_ / sizeof(uint32_t);
+  }
+
+  int32_t GetPatchDelta() const {
+    return patch_delta_;
+  }
+
+  // Moves the addresses in the header by delta bytes, which must be page aligned. The image words
+  // and oat locations listed by the relocation tables have to be moved by the same delta.
+  void Relocate(int32_t delta);
+
   static std::string GetOatLocationFromImageLocation(const std::string& image) {
     std::string oat_filename = image;
     if (oat_filename.length() <= 3) {
@@ -153,6 +177,19 @@ class PACKED(4) ImageHeader {
   // Absolute address of an Object[] of objects needed to reinitialize from an image.
   uint32_t image_roots_;
 
+  // Relocation bitmap offset and size in the file. The bitmap has one bit per 32-bit word of the
+  // image, set for the words holding an absolute image or oat address.
+  uint32_t relocation_bitmap_offset_;
+  uint32_t relocation_bitmap_size_;
+
+  // Offset and size in the file of the uint32_t offsets from oat_data_begin_ of the absolute
+  // addresses patched into the oat file's code.
+  uint32_t oat_relocations_offset_;
+  uint32_t oat_relocations_size_;
+
+  // Distance the image and oat file were moved by since they were written.
+  int32_t patch_delta_;
+
   friend class ImageWriter;
   friend class ImageDumper;  // For GetImageRoots()
 };
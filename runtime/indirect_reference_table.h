@@ -27,6 +27,7 @@
 #include "mem_map.h"
 #include "object_callbacks.h"
 #include "offsets.h"
+#include "verify_object.h"
 
 namespace art {
 namespace mirror {
@@ -98,6 +99,9 @@ class Object;
  * memory accesses on add/get.  It will catch additional problems, e.g.:
  * create iref1 for obj, delete iref1, create iref2 for same obj, lookup
  * iref1.  A pattern based on object bits will miss this.
+ *
+ * Bits 18 and 19 hold the shard of the table, for the references kept in
+ * several tables such as the JNI globals. The serial number starts at bit 20.
  */
 typedef void* IndirectRef;
 
@@ -245,7 +249,11 @@ bool inline operator!=(const IrtIterator& lhs, const IrtIterator& rhs) {
 
 class IndirectReferenceTable {
  public:
-  IndirectReferenceTable(size_t initialCount, size_t maxCount, IndirectRefKind kind);
+  // Number of tables the references of a kind can be spread over, as told apart by their shard.
+  static constexpr uint32_t kMaxShards = 4;
+
+  IndirectReferenceTable(size_t initialCount, size_t maxCount, IndirectRefKind kind,
+                         uint32_t shard = 0);
 
   ~IndirectReferenceTable();
 
@@ -256,7 +264,22 @@ class IndirectReferenceTable {
    * failed during expansion).
    */
   IndirectRef Add(uint32_t cookie, mirror::Object* obj)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    // Native code mostly adds references and returns without deleting any, which leaves no
+    // hole in the segment: the reference then goes on top of it.
+    IRTSegmentState prevState;
+    prevState.all = cookie;
+    const uint32_t topIndex = segment_state_.parts.topIndex;
+    if (LIKELY(segment_state_.parts.numHoles == prevState.parts.numHoles &&
+               topIndex < alloc_entries_ && obj != nullptr &&
+               kVerifyObjectSupport == kVerifyObjectModeDisabled)) {
+      UpdateSlotAdd(obj, topIndex);
+      table_[topIndex] = obj;
+      segment_state_.parts.topIndex = topIndex + 1;
+      return ToIndirectRef(obj, topIndex);
+    }
+    return AddSlowPath(cookie, obj);
+  }
 
   /*
    * Given an IndirectRef in the table, return the Object it refers to.
@@ -296,6 +319,18 @@ class IndirectReferenceTable {
     return segment_state_.parts.topIndex;
   }
 
+  // Whether Add would overflow the table, which it does once the top index reaches the maximum
+  // even if there are holes below.
+  bool IsFull() const {
+    return segment_state_.parts.topIndex == max_entries_;
+  }
+
+  // Extract the shard of the table from an indirect reference.
+  static uint32_t ExtractShard(IndirectRef iref) {
+    uintptr_t uref = reinterpret_cast<uintptr_t>(iref);
+    return (uref >> 18) & (kMaxShards - 1);
+  }
+
   IrtIterator begin() {
     return IrtIterator(table_, 0, Capacity());
   }
@@ -334,7 +369,7 @@ class IndirectReferenceTable {
   IndirectRef ToIndirectRef(const mirror::Object* /*o*/, uint32_t tableIndex) const {
     DCHECK_LT(tableIndex, 65536U);
     uint32_t serialChunk = slot_data_[tableIndex].serial;
-    uintptr_t uref = serialChunk << 20 | (tableIndex << 2) | kind_;
+    uintptr_t uref = serialChunk << 20 | (shard_ << 18) | (tableIndex << 2) | kind_;
     return reinterpret_cast<IndirectRef>(uref);
   }
 
@@ -352,6 +387,10 @@ class IndirectReferenceTable {
     }
   }
 
+  // Add for the segments with holes, the full table, and the null or verified objects.
+  IndirectRef AddSlowPath(uint32_t cookie, mirror::Object* obj)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Abort if check_jni is not enabled.
   static void AbortIfNoCheckJNI();
 
@@ -370,6 +409,8 @@ class IndirectReferenceTable {
   mirror::Object** table_;
   /* bit mask, ORed into all irefs */
   IndirectRefKind kind_;
+  /* shifted and ORed into all irefs */
+  uint32_t shard_;
   /* extended debugging info */
   IndirectRefSlot* slot_data_;
   /* #of entries we have space for */
@@ -249,4 +249,36 @@ TEST_F(IndirectReferenceTableTest, BasicTest) {
   CheckDump(&irt, 0, 0);
 }
 
+TEST_F(IndirectReferenceTableTest, Shards) {
+  ScopedObjectAccess soa(Thread::Current());
+  IndirectReferenceTable irt0(1, 2, kGlobal, 0);
+  IndirectReferenceTable irt2(1, 2, kGlobal, 2);
+
+  mirror::Class* c = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  ASSERT_TRUE(c != NULL);
+  mirror::Object* obj0 = c->AllocObject(soa.Self());
+  ASSERT_TRUE(obj0 != NULL);
+  mirror::Object* obj1 = c->AllocObject(soa.Self());
+  ASSERT_TRUE(obj1 != NULL);
+
+  const uint32_t cookie = IRT_FIRST_SEGMENT;
+  IndirectRef iref0 = irt0.Add(cookie, obj0);
+  IndirectRef iref2 = irt2.Add(cookie, obj1);
+  EXPECT_EQ(0U, IndirectReferenceTable::ExtractShard(iref0));
+  EXPECT_EQ(2U, IndirectReferenceTable::ExtractShard(iref2));
+  EXPECT_EQ(kGlobal, GetIndirectRefKind(iref2));
+  EXPECT_EQ(obj0, irt0.Get(iref0));
+  EXPECT_EQ(obj1, irt2.Get(iref2));
+  // Same index and serial, but not of the same shard.
+  EXPECT_NE(iref0, iref2);
+
+  EXPECT_FALSE(irt2.IsFull());
+  IndirectRef iref2_top = irt2.Add(cookie, obj0);
+  EXPECT_TRUE(irt2.IsFull());
+  EXPECT_TRUE(irt2.Remove(cookie, iref2_top));
+  EXPECT_FALSE(irt2.IsFull());
+  EXPECT_TRUE(irt2.Remove(cookie, iref2));
+  EXPECT_TRUE(irt0.Remove(cookie, iref0));
+}
+
 }  // namespace art
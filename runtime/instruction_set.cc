@@ -16,8 +16,17 @@
 
 #include "instruction_set.h"
 
+#include <stdlib.h>
+
+#include <algorithm>
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
 #include "globals.h"
 #include "base/logging.h"  // Logging is required for FATAL in the helper functions.
+#include "utils.h"
 
 namespace art {
 
@@ -176,11 +185,172 @@ bool Is64BitInstructionSet(InstructionSet isa) {
   }
 }
 
+#if defined(__arm__)
+// Returns whether the "Features" line of /proc/cpuinfo lists the given feature.
+static bool CpuInfoHasFeature(const std::string& cpu_info, const char* feature) {
+  size_t start = cpu_info.find("\nFeatures");
+  if (start == std::string::npos) {
+    return false;
+  }
+  size_t end = cpu_info.find('\n', start + 1);
+  std::vector<std::string> features;
+  Split(cpu_info.substr(start, end - start), ' ', features);
+  return std::find(features.begin(), features.end(), feature) != features.end();
+}
+
+// Returns the core named by the "CPU part" line of /proc/cpuinfo, if it has a scheduling model.
+static ArmCpu CpuInfoArmCpu(const std::string& cpu_info) {
+  size_t start = cpu_info.find("\nCPU part");
+  if (start == std::string::npos) {
+    return kArmCpuGeneric;
+  }
+  size_t colon = cpu_info.find(':', start);
+  if (colon == std::string::npos) {
+    return kArmCpuGeneric;
+  }
+  switch (strtoul(cpu_info.c_str() + colon + 1, nullptr, 16)) {
+    case 0xc07: return kArmCpuCortexA7;
+    case 0xc09: return kArmCpuCortexA9;
+    case 0xc0f: return kArmCpuCortexA15;
+    default: return kArmCpuGeneric;
+  }
+}
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
+// Returns whether the OS saves the XMM and YMM registers on a context switch.
+static bool OsSavesYmmState() {
+  uint32_t xcr0_lo;
+  uint32_t xcr0_hi;
+  __asm__ __volatile__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+  return (xcr0_lo & 0x6) == 0x6;
+}
+#endif
+
+// Sets *detected to whether the features of this CPU could be determined.
+static InstructionSetFeatures ComputeInstructionSetFeatures(bool* detected) {
+  InstructionSetFeatures result;
+  *detected = false;
+#if defined(__arm__)
+  std::string cpu_info;
+  if (ReadFileToString("/proc/cpuinfo", &cpu_info)) {
+    result.SetHasDivideInstruction(CpuInfoHasFeature(cpu_info, "idiva"));
+    result.SetHasLpae(CpuInfoHasFeature(cpu_info, "lpae"));
+    result.SetHasNeon(CpuInfoHasFeature(cpu_info, "neon"));
+    result.SetHasVfpv4(CpuInfoHasFeature(cpu_info, "vfpv4"));
+    // A 32-bit kernel on an ARMv8 core reports the cryptography extension by its instructions.
+    result.SetHasCrypto(CpuInfoHasFeature(cpu_info, "aes"));
+    result.SetArmCpu(CpuInfoArmCpu(cpu_info));
+    *detected = true;
+  } else {
+    PLOG(WARNING) << "Failed to read /proc/cpuinfo, assuming no optional features";
+  }
+#elif defined(__i386__) || defined(__x86_64__)
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) != 0) {
+    result.SetHasSsse3((ecx & bit_SSSE3) != 0);
+    result.SetHasSse4_1((ecx & bit_SSE4_1) != 0);
+    result.SetHasSse4_2((ecx & bit_SSE4_2) != 0);
+    result.SetHasPopcnt((ecx & bit_POPCNT) != 0);
+    result.SetHasAvx((ecx & bit_AVX) != 0 && (ecx & bit_OSXSAVE) != 0 && OsSavesYmmState());
+    *detected = true;
+  }
+#endif
+  return result;
+}
+
+struct GuessedInstructionSetFeatures {
+  GuessedInstructionSetFeatures() : features(ComputeInstructionSetFeatures(&detected)) {}
+
+  bool detected;
+  InstructionSetFeatures features;
+};
+
+static const GuessedInstructionSetFeatures& GetGuessedInstructionSetFeatures() {
+  // The CPU does not change under us, so only ask once.
+  static const GuessedInstructionSetFeatures guessed;
+  return guessed;
+}
+
+InstructionSetFeatures InstructionSetFeatures::GuessInstructionSetFeatures() {
+  return GetGuessedInstructionSetFeatures().features;
+}
+
+bool InstructionSetFeatures::IsRunnableOnThisCpu() const {
+  const GuessedInstructionSetFeatures& guessed = GetGuessedInstructionSetFeatures();
+  if (!guessed.detected) {
+    return true;
+  }
+  uint32_t required = mask_ & ~kArmCpuMask;
+  return (required & guessed.features.mask_) == required;
+}
+
 std::string InstructionSetFeatures::GetFeatureString() const {
   std::string result;
   if ((mask_ & kHwDiv) != 0) {
     result += "div";
   }
+  if ((mask_ & kHwNeon) != 0) {
+    if (result.size() != 0) {
+      result += ",";
+    }
+    result += "neon";
+  }
+  if ((mask_ & kHwSse4_1) != 0) {
+    if (result.size() != 0) {
+      result += ",";
+    }
+    result += "sse4.1";
+  }
+  if ((mask_ & kHwSse4_2) != 0) {
+    if (result.size() != 0) {
+      result += ",";
+    }
+    result += "sse4.2";
+  }
+  if ((mask_ & kHwLpae) != 0) {
+    if (result.size() != 0) {
+      result += ",";
+    }
+    result += "lpae";
+  }
+  if ((mask_ & kHwVfpv4) != 0) {
+    if (result.size() != 0) {
+      result += ",";
+    }
+    result += "vfpv4";
+  }
+  if ((mask_ & kHwCrypto) != 0) {
+    if (result.size() != 0) {
+      result += ",";
+    }
+    result += "crypto";
+  }
+  if ((mask_ & kHwSsse3) != 0) {
+    if (result.size() != 0) {
+      result += ",";
+    }
+    result += "ssse3";
+  }
+  if ((mask_ & kHwPopcnt) != 0) {
+    if (result.size() != 0) {
+      result += ",";
+    }
+    result += "popcnt";
+  }
+  if ((mask_ & kHwAvx) != 0) {
+    if (result.size() != 0) {
+      result += ",";
+    }
+    result += "avx";
+  }
+  static const char* const kArmCpuNames[] = { nullptr, "cortex-a7", "cortex-a9", "cortex-a15" };
+  if (GetArmCpu() != kArmCpuGeneric) {
+    if (result.size() != 0) {
+      result += ",";
+    }
+    result += kArmCpuNames[GetArmCpu()];
+  }
   if (result.size() == 0) {
     result = "none";
   }
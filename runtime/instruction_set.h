@@ -61,14 +61,33 @@ static constexpr InstructionSet kRuntimeISA = kNone;
 enum InstructionFeatures {
   kHwDiv  = 0x1,              // Supports hardware divide.
   kHwLpae = 0x2,              // Supports Large Physical Address Extension.
+  kHwNeon = 0x4,              // Supports the ARM Advanced SIMD (NEON) extension.
+  kHwSse4_1 = 0x8,            // Supports the x86 SSE4.1 extension.
+  kHwSse4_2 = 0x10,           // Supports the x86 SSE4.2 extension.
+  kHwVfpv4 = 0x20,            // Supports the ARM VFPv4 fused multiply-accumulate instructions.
+  kHwCrypto = 0x40,           // Supports the ARMv8 cryptography extension.
+  kHwSsse3 = 0x80,            // Supports the x86 SSSE3 extension.
+  kArmCpuMask = 0x300,        // The ArmCpu to tune the generated code for.
+  kHwPopcnt = 0x400,          // Supports the x86 POPCNT instruction.
+  kHwAvx = 0x800,             // Supports the x86 AVX extension, with OS support for the YMM state.
 };
 
+// ARM cores with a scheduling model in the Quick backend.
+enum ArmCpu {
+  kArmCpuGeneric = 0,
+  kArmCpuCortexA7 = 1,
+  kArmCpuCortexA9 = 2,
+  kArmCpuCortexA15 = 3,
+};
+static constexpr int kArmCpuShift = 8;
+
 // This is a bitmask of supported features per architecture.
 class PACKED(4) InstructionSetFeatures {
  public:
   InstructionSetFeatures() : mask_(0) {}
   explicit InstructionSetFeatures(uint32_t mask) : mask_(mask) {}
 
+  // Returns the features of the CPU we are running on, as reported by the kernel or cpuid.
   static InstructionSetFeatures GuessInstructionSetFeatures();
 
   bool HasDivideInstruction() const {
@@ -87,8 +106,85 @@ class PACKED(4) InstructionSetFeatures {
     mask_ = (mask_ & ~kHwLpae) | (v ? kHwLpae : 0);
   }
 
+  bool HasNeon() const {
+    return (mask_ & kHwNeon) != 0;
+  }
+
+  void SetHasNeon(bool v) {
+    mask_ = (mask_ & ~kHwNeon) | (v ? kHwNeon : 0);
+  }
+
+  bool HasSse4_1() const {
+    return (mask_ & kHwSse4_1) != 0;
+  }
+
+  void SetHasSse4_1(bool v) {
+    mask_ = (mask_ & ~kHwSse4_1) | (v ? kHwSse4_1 : 0);
+  }
+
+  bool HasSse4_2() const {
+    return (mask_ & kHwSse4_2) != 0;
+  }
+
+  void SetHasSse4_2(bool v) {
+    mask_ = (mask_ & ~kHwSse4_2) | (v ? kHwSse4_2 : 0);
+  }
+
+  bool HasVfpv4() const {
+    return (mask_ & kHwVfpv4) != 0;
+  }
+
+  void SetHasVfpv4(bool v) {
+    mask_ = (mask_ & ~kHwVfpv4) | (v ? kHwVfpv4 : 0);
+  }
+
+  bool HasCrypto() const {
+    return (mask_ & kHwCrypto) != 0;
+  }
+
+  void SetHasCrypto(bool v) {
+    mask_ = (mask_ & ~kHwCrypto) | (v ? kHwCrypto : 0);
+  }
+
+  bool HasSsse3() const {
+    return (mask_ & kHwSsse3) != 0;
+  }
+
+  void SetHasSsse3(bool v) {
+    mask_ = (mask_ & ~kHwSsse3) | (v ? kHwSsse3 : 0);
+  }
+
+  bool HasPopcnt() const {
+    return (mask_ & kHwPopcnt) != 0;
+  }
+
+  void SetHasPopcnt(bool v) {
+    mask_ = (mask_ & ~kHwPopcnt) | (v ? kHwPopcnt : 0);
+  }
+
+  bool HasAvx() const {
+    return (mask_ & kHwAvx) != 0;
+  }
+
+  void SetHasAvx(bool v) {
+    mask_ = (mask_ & ~kHwAvx) | (v ? kHwAvx : 0);
+  }
+
+  ArmCpu GetArmCpu() const {
+    return static_cast<ArmCpu>((mask_ & kArmCpuMask) >> kArmCpuShift);
+  }
+
+  void SetArmCpu(ArmCpu cpu) {
+    mask_ = (mask_ & ~kArmCpuMask) | (static_cast<uint32_t>(cpu) << kArmCpuShift);
+  }
+
   std::string GetFeatureString() const;
 
+  // Returns whether code compiled for these features can run on the CPU we are running on.
+  // The ArmCpu only tunes the code, so it is ignored. If the features of the CPU could not be
+  // detected, the code is assumed to be runnable.
+  bool IsRunnableOnThisCpu() const;
+
   // Other features in here.
 
   bool operator==(const InstructionSetFeatures &peer) const {
@@ -45,4 +45,22 @@ TEST_F(InstructionSetTest, TestRoundTrip) {
   EXPECT_EQ(kRuntimeISA, GetInstructionSetFromString(GetInstructionSetString(kRuntimeISA)));
 }
 
+TEST_F(InstructionSetTest, IsRunnableOnThisCpu) {
+  InstructionSetFeatures guessed = InstructionSetFeatures::GuessInstructionSetFeatures();
+  EXPECT_TRUE(guessed.IsRunnableOnThisCpu());
+  EXPECT_TRUE(InstructionSetFeatures().IsRunnableOnThisCpu());
+  // The core to schedule for does not make code unrunnable.
+  InstructionSetFeatures tuned = guessed;
+  tuned.SetArmCpu(kArmCpuCortexA15);
+  EXPECT_TRUE(tuned.IsRunnableOnThisCpu());
+}
+
+TEST_F(InstructionSetTest, GetFeatureString) {
+  InstructionSetFeatures features;
+  EXPECT_EQ("none", features.GetFeatureString());
+  features.SetHasSse4_2(true);
+  features.SetHasPopcnt(true);
+  EXPECT_EQ("sse4.2,popcnt", features.GetFeatureString());
+}
+
 }  // namespace art
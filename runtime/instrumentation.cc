@@ -132,6 +132,11 @@ void Instrumentation::InstallStubsForMethod(mirror::ArtMethod* method) {
     } else if (is_class_initialized || !method->IsStatic() || method->IsConstructor()) {
       new_portable_code = class_linker->GetPortableOatCodeFor(method, &have_portable_code);
       new_quick_code = class_linker->GetQuickOatCodeFor(method);
+      if (new_quick_code != GetQuickToInterpreterBridge() && IsMethodInstrumented(method)) {
+        new_portable_code = GetPortableToInterpreterBridge();
+        new_quick_code = GetQuickInstrumentationEntryPoint();
+        have_portable_code = false;
+      }
     } else {
       new_portable_code = GetPortableResolutionTrampoline(class_linker);
       new_quick_code = GetQuickResolutionTrampoline(class_linker);
@@ -485,11 +490,12 @@ void Instrumentation::ConfigureStubs(bool require_entry_exit_stubs, bool require
     interpreter_stubs_installed_ = false;
     entry_exit_stubs_installed_ = false;
     runtime->GetClassLinker()->VisitClasses(InstallStubsClassVisitor, this);
-    // Restore stack only if there is no method currently deoptimized.
+    // Restore stack only if there is no method currently deoptimized or instrumented.
     bool empty;
     {
       ReaderMutexLock mu(self, deoptimized_methods_lock_);
-      empty = deoptimized_methods_.empty();  // Avoid lock violation.
+      // Avoid lock violation.
+      empty = deoptimized_methods_.empty() && instrumented_methods_.empty();
     }
     if (empty) {
       instrumentation_stubs_installed_ = false;
@@ -571,7 +577,7 @@ void Instrumentation::UpdateMethodsCode(mirror::ArtMethod* method, const void* q
       new_portable_code = portable_code;
       new_quick_code = quick_code;
       new_have_portable_code = have_portable_code;
-    } else if (entry_exit_stubs_installed_) {
+    } else if (entry_exit_stubs_installed_ || IsMethodInstrumented(method)) {
       new_quick_code = GetQuickInstrumentationEntryPoint();
       new_portable_code = GetPortableToInterpreterBridge();
       new_have_portable_code = false;
@@ -623,7 +629,7 @@ void Instrumentation::Undeoptimize(mirror::ArtMethod* method) {
     CHECK(it != deoptimized_methods_.end()) << "Method " << PrettyMethod(method)
         << " is not deoptimized";
     deoptimized_methods_.erase(it);
-    empty = deoptimized_methods_.empty();
+    empty = deoptimized_methods_.empty() && instrumented_methods_.empty();
   }
 
   // Restore code and possibly stack only if we did not deoptimize everything.
@@ -638,10 +644,17 @@ void Instrumentation::Undeoptimize(mirror::ArtMethod* method) {
       bool have_portable_code = false;
       const void* quick_code = class_linker->GetQuickOatCodeFor(method);
       const void* portable_code = class_linker->GetPortableOatCodeFor(method, &have_portable_code);
-      UpdateEntrypoints(method, quick_code, portable_code, have_portable_code);
+      if (!entry_exit_stubs_installed_ && IsMethodInstrumented(method) &&
+          quick_code != GetQuickToInterpreterBridge()) {
+        UpdateEntrypoints(method, GetQuickInstrumentationEntryPoint(),
+                          GetPortableToInterpreterBridge(), false);
+      } else {
+        UpdateEntrypoints(method, quick_code, portable_code, have_portable_code);
+      }
     }
 
-    // If there is no deoptimized method left, we can restore the stack of each thread.
+    // If there is no deoptimized or instrumented method left, we can restore the stack of each
+    // thread.
     if (empty) {
       MutexLock mu(self, *Locks::thread_list_lock_);
       Runtime::Current()->GetThreadList()->ForEach(InstrumentationRestoreStack, this);
@@ -656,6 +669,117 @@ bool Instrumentation::IsDeoptimized(mirror::ArtMethod* method) const {
   return deoptimized_methods_.find(method) != deoptimized_methods_.end();
 }
 
+void Instrumentation::InstrumentMethod(mirror::ArtMethod* method) {
+  CHECK(!method->IsProxyMethod());
+  CHECK(!method->IsAbstract());
+
+  Thread* self = Thread::Current();
+  bool deoptimized;
+  {
+    WriterMutexLock mu(self, deoptimized_methods_lock_);
+    bool inserted = instrumented_methods_.insert(method).second;
+    CHECK(inserted) << "Method " << PrettyMethod(method) << " is already instrumented";
+    deoptimized = deoptimized_methods_.find(method) != deoptimized_methods_.end();
+  }
+
+  // The stubs are already in place when every method has them, and the interpreter posts the
+  // events of the methods it runs.
+  if (entry_exit_stubs_installed_ || interpreter_stubs_installed_ || forced_interpret_only_ ||
+      deoptimized) {
+    return;
+  }
+  // A static method of a class not yet initialized gets the entry stub from UpdateMethodsCode
+  // when ClassLinker::FixupStaticTrampolines replaces its resolution trampoline.
+  if (!method->IsStatic() || method->IsConstructor() ||
+      method->GetDeclaringClass()->IsInitialized()) {
+    ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+    if (class_linker->GetQuickOatCodeFor(method) != GetQuickToInterpreterBridge()) {
+      UpdateEntrypoints(method, GetQuickInstrumentationEntryPoint(),
+                        GetPortableToInterpreterBridge(), false);
+    }
+  }
+  // The frames of the calls already running are left alone: unlike Deoptimize, only the calls
+  // made from now on go through the stubs, so the other methods of the stacks don't post events.
+  instrumentation_stubs_installed_ = true;
+}
+
+void Instrumentation::UninstrumentMethod(mirror::ArtMethod* method) {
+  CHECK(!method->IsProxyMethod());
+  CHECK(!method->IsAbstract());
+
+  Thread* self = Thread::Current();
+  bool deoptimized;
+  bool empty;
+  {
+    WriterMutexLock mu(self, deoptimized_methods_lock_);
+    auto it = instrumented_methods_.find(method);
+    CHECK(it != instrumented_methods_.end()) << "Method " << PrettyMethod(method)
+        << " is not instrumented";
+    instrumented_methods_.erase(it);
+    deoptimized = deoptimized_methods_.find(method) != deoptimized_methods_.end();
+    empty = deoptimized_methods_.empty() && instrumented_methods_.empty();
+  }
+
+  if (entry_exit_stubs_installed_ || interpreter_stubs_installed_) {
+    return;
+  }
+  if (!deoptimized && !forced_interpret_only_) {
+    ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+    if (method->IsStatic() && !method->IsConstructor() &&
+        !method->GetDeclaringClass()->IsInitialized()) {
+      UpdateEntrypoints(method, GetQuickResolutionTrampoline(class_linker),
+                        GetPortableResolutionTrampoline(class_linker), false);
+    } else {
+      bool have_portable_code = false;
+      const void* quick_code = class_linker->GetQuickOatCodeFor(method);
+      const void* portable_code = class_linker->GetPortableOatCodeFor(method, &have_portable_code);
+      UpdateEntrypoints(method, quick_code, portable_code, have_portable_code);
+    }
+  }
+  // Calls still running in the method return through the exit stub until the stacks are restored.
+  if (empty) {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    Runtime::Current()->GetThreadList()->ForEach(InstrumentationRestoreStack, this);
+    instrumentation_stubs_installed_ = false;
+  }
+}
+
+void Instrumentation::InstrumentClass(mirror::Class* klass) {
+  for (size_t i = 0, e = klass->NumDirectMethods(); i < e; ++i) {
+    mirror::ArtMethod* method = klass->GetDirectMethod(i);
+    if (!IsMethodInstrumented(method)) {
+      InstrumentMethod(method);
+    }
+  }
+  for (size_t i = 0, e = klass->NumVirtualMethods(); i < e; ++i) {
+    mirror::ArtMethod* method = klass->GetVirtualMethod(i);
+    if (!method->IsAbstract() && !IsMethodInstrumented(method)) {
+      InstrumentMethod(method);
+    }
+  }
+}
+
+void Instrumentation::UninstrumentClass(mirror::Class* klass) {
+  for (size_t i = 0, e = klass->NumDirectMethods(); i < e; ++i) {
+    mirror::ArtMethod* method = klass->GetDirectMethod(i);
+    if (IsMethodInstrumented(method)) {
+      UninstrumentMethod(method);
+    }
+  }
+  for (size_t i = 0, e = klass->NumVirtualMethods(); i < e; ++i) {
+    mirror::ArtMethod* method = klass->GetVirtualMethod(i);
+    if (IsMethodInstrumented(method)) {
+      UninstrumentMethod(method);
+    }
+  }
+}
+
+bool Instrumentation::IsMethodInstrumented(mirror::ArtMethod* method) const {
+  ReaderMutexLock mu(Thread::Current(), deoptimized_methods_lock_);
+  DCHECK(method != nullptr);
+  return instrumented_methods_.find(method) != instrumented_methods_.end();
+}
+
 void Instrumentation::EnableDeoptimization() {
   ReaderMutexLock mu(Thread::Current(), deoptimized_methods_lock_);
   CHECK(deoptimized_methods_.empty());
@@ -924,16 +1048,19 @@ void Instrumentation::PopMethodForUnwind(Thread* self, bool is_deoptimization) c
 
 void Instrumentation::VisitRoots(RootCallback* callback, void* arg) {
   WriterMutexLock mu(Thread::Current(), deoptimized_methods_lock_);
-  if (deoptimized_methods_.empty()) {
-    return;
-  }
-  std::set<mirror::ArtMethod*> new_deoptimized_methods;
-  for (mirror::ArtMethod* method : deoptimized_methods_) {
-    DCHECK(method != nullptr);
-    callback(reinterpret_cast<mirror::Object**>(&method), arg, 0, kRootVMInternal);
-    new_deoptimized_methods.insert(method);
+  // The sets are ordered by address, so they are rebuilt with the visited methods.
+  for (std::set<mirror::ArtMethod*>* methods : {&deoptimized_methods_, &instrumented_methods_}) {
+    if (methods->empty()) {
+      continue;
+    }
+    std::set<mirror::ArtMethod*> new_methods;
+    for (mirror::ArtMethod* method : *methods) {
+      DCHECK(method != nullptr);
+      callback(reinterpret_cast<mirror::Object**>(&method), arg, 0, kRootVMInternal);
+      new_methods.insert(method);
+    }
+    *methods = new_methods;
   }
-  deoptimized_methods_ = new_deoptimized_methods;
 }
 
 std::string InstrumentationStackFrame::Dump() const {
@@ -173,6 +173,31 @@ class Instrumentation {
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_)
       LOCKS_EXCLUDED(Locks::thread_list_lock_, Locks::classlinker_classes_lock_);
 
+  // Installs the instrumentation entry/exit stubs in this method only, so that the method entry
+  // and exit listeners hear about its calls while every other method keeps running its compiled
+  // code. Like Deoptimize, a static method set to the resolution trampoline gets the stubs once
+  // its declaring class is initialized. Methods run by the interpreter still notify the listeners
+  // of all their calls.
+  void InstrumentMethod(mirror::ArtMethod* method)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_, deoptimized_methods_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Restores the entrypoints of a method given to InstrumentMethod.
+  void UninstrumentMethod(mirror::ArtMethod* method)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_, deoptimized_methods_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Calls InstrumentMethod, or UninstrumentMethod, for each method with code declared by klass.
+  void InstrumentClass(mirror::Class* klass)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_, deoptimized_methods_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void UninstrumentClass(mirror::Class* klass)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_, deoptimized_methods_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  bool IsMethodInstrumented(mirror::ArtMethod* method) const
+      LOCKS_EXCLUDED(deoptimized_methods_lock_);
+
   InterpreterHandlerTable GetInterpreterHandlerTable() const {
     return interpreter_handler_table_;
   }
@@ -419,6 +444,9 @@ class Instrumentation {
   std::set<mirror::ArtMethod*> deoptimized_methods_ GUARDED_BY(deoptimized_methods_lock_);
   bool deoptimization_enabled_;
 
+  // The methods given the instrumentation entry/exit stubs by InstrumentMethod.
+  std::set<mirror::ArtMethod*> instrumented_methods_ GUARDED_BY(deoptimized_methods_lock_);
+
   // Current interpreter handler table. This is updated each time the thread state flags are
   // modified.
   InterpreterHandlerTable interpreter_handler_table_;
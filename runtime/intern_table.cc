@@ -16,18 +16,149 @@
 
 #include "intern_table.h"
 
+#include <algorithm>
 #include <memory>
 
+#include "atomic.h"
+#include "gc/heap.h"
 #include "gc/space/image_space.h"
 #include "mirror/dex_cache.h"
 #include "mirror/object_array-inl.h"
 #include "mirror/object-inl.h"
 #include "mirror/string.h"
+#include "read_barrier.h"
 #include "thread.h"
+#include "thread_pool.h"
 #include "utf.h"
 
 namespace art {
 
+InternTable::Table::Table()
+    : slots_(kInitialCapacity, nullptr), num_strings_(0u), num_used_slots_(0u) {
+}
+
+mirror::String* InternTable::Table::Find(mirror::String* s, int32_t hash_code) {
+  for (size_t i = FirstSlot(hash_code); slots_[i] != nullptr; i = NextSlot(i)) {
+    mirror::String* existing_string = slots_[i];
+    if (existing_string != Tombstone() && existing_string->GetHashCode() == hash_code &&
+        existing_string->Equals(s)) {
+      // Forward the slot so that Remove finds the string we return.
+      existing_string = ReadBarrier::BarrierForWeakRoot(existing_string);
+      slots_[i] = existing_string;
+      return existing_string;
+    }
+  }
+  return nullptr;
+}
+
+void InternTable::Table::Insert(mirror::String* s, int32_t hash_code) {
+  DCHECK(IsLive(s));
+  if ((num_used_slots_ + 1) * 100 > slots_.size() * kMaxLoadPercent) {
+    Rehash();
+  }
+  size_t i = FirstSlot(hash_code);
+  while (IsLive(slots_[i])) {
+    i = NextSlot(i);
+  }
+  if (slots_[i] == nullptr) {
+    ++num_used_slots_;
+  }
+  slots_[i] = s;
+  ++num_strings_;
+}
+
+void InternTable::Table::Remove(mirror::String* s, int32_t hash_code) {
+  for (size_t i = FirstSlot(hash_code); slots_[i] != nullptr; i = NextSlot(i)) {
+    if (slots_[i] == s) {
+      slots_[i] = Tombstone();
+      --num_strings_;
+      return;
+    }
+  }
+}
+
+void InternTable::Table::Update(int32_t hash_code, mirror::String* old_ref,
+                                mirror::String* new_ref) {
+  for (size_t i = FirstSlot(hash_code); slots_[i] != nullptr; i = NextSlot(i)) {
+    if (slots_[i] == old_ref) {
+      slots_[i] = new_ref;
+    }
+  }
+}
+
+void InternTable::Table::VisitRoots(RootCallback* callback, void* arg) {
+  for (mirror::String*& s : slots_) {
+    if (IsLive(s)) {
+      callback(reinterpret_cast<mirror::Object**>(&s), arg, 0, kRootInternedString);
+      DCHECK(s != nullptr);
+    }
+  }
+}
+
+size_t InternTable::Table::SweepWeaks(size_t begin, size_t end, IsMarkedCallback* callback,
+                                      void* arg) {
+  size_t num_swept = 0u;
+  for (size_t i = begin; i != end; ++i) {
+    if (IsLive(slots_[i])) {
+      mirror::Object* new_object = callback(slots_[i], arg);
+      if (new_object == nullptr) {
+        slots_[i] = Tombstone();
+        ++num_swept;
+      } else {
+        slots_[i] = down_cast<mirror::String*>(new_object);
+      }
+    }
+  }
+  return num_swept;
+}
+
+void InternTable::Table::Rehash() {
+  // Grow only if the strings, rather than the tombstones, fill the table.
+  size_t capacity = slots_.size();
+  if ((num_strings_ + 1) * 100 > capacity * kMaxLoadPercent / 2) {
+    capacity *= 2;
+  }
+  std::vector<mirror::String*> old_slots(capacity, nullptr);
+  old_slots.swap(slots_);
+  for (mirror::String* s : old_slots) {
+    if (IsLive(s)) {
+      size_t i = FirstSlot(s->GetHashCode());
+      while (slots_[i] != nullptr) {
+        i = NextSlot(i);
+      }
+      slots_[i] = s;
+    }
+  }
+  num_used_slots_ = num_strings_;
+}
+
+// Sweeps a range of the slots of the weak interns on a GC thread.
+class InternTable::SweepTask : public Task {
+ public:
+  SweepTask(Table* table, size_t begin, size_t end, IsMarkedCallback* callback, void* arg,
+            Atomic<size_t>* num_swept)
+      : table_(table), begin_(begin), end_(end), callback_(callback), arg_(arg),
+        num_swept_(num_swept) {}
+
+  void Run(Thread*) OVERRIDE {
+    num_swept_->FetchAndAdd(table_->SweepWeaks(begin_, end_, callback_, arg_));
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  Table* const table_;
+  const size_t begin_;
+  const size_t end_;
+  IsMarkedCallback* const callback_;
+  void* const arg_;
+  Atomic<size_t>* const num_swept_;
+
+  DISALLOW_COPY_AND_ASSIGN(SweepTask);
+};
+
 InternTable::InternTable()
     : log_new_roots_(false), allow_new_interns_(true),
       new_intern_condition_("New intern condition", *Locks::intern_table_lock_) {
@@ -35,23 +166,19 @@ InternTable::InternTable()
 
 size_t InternTable::Size() const {
   MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  return strong_interns_.size() + weak_interns_.size();
+  return strong_interns_.Size() + weak_interns_.Size();
 }
 
 void InternTable::DumpForSigQuit(std::ostream& os) const {
   MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  os << "Intern table: " << strong_interns_.size() << " strong; "
-     << weak_interns_.size() << " weak\n";
+  os << "Intern table: " << strong_interns_.Size() << " strong; "
+     << weak_interns_.Size() << " weak\n";
 }
 
 void InternTable::VisitRoots(RootCallback* callback, void* arg, VisitRootFlags flags) {
   MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
   if ((flags & kVisitRootFlagAllRoots) != 0) {
-    for (auto& strong_intern : strong_interns_) {
-      callback(reinterpret_cast<mirror::Object**>(&strong_intern.second), arg, 0,
-               kRootInternedString);
-      DCHECK(strong_intern.second != nullptr);
-    }
+    strong_interns_.VisitRoots(callback, arg);
   } else if ((flags & kVisitRootFlagNewRoots) != 0) {
     for (auto& pair : new_strong_intern_roots_) {
        mirror::String* old_ref = pair.second;
@@ -60,13 +187,7 @@ void InternTable::VisitRoots(RootCallback* callback, void* arg, VisitRootFlags f
          // Uh ohes, GC moved a root in the log. Need to search the strong interns and update the
          // corresponding object. This is slow, but luckily for us, this may only happen with a
          // concurrent moving GC.
-         for (auto it = strong_interns_.lower_bound(pair.first), end = strong_interns_.end();
-             it != end && it->first == pair.first; ++it) {
-           // If the class stored matches the old class, update it to the new value.
-           if (old_ref == it->second) {
-             it->second = pair.second;
-           }
-         }
+         strong_interns_.Update(pair.first, old_ref, pair.second);
        }
      }
   }
@@ -82,15 +203,9 @@ void InternTable::VisitRoots(RootCallback* callback, void* arg, VisitRootFlags f
   // Note: we deliberately don't visit the weak_interns_ table and the immutable image roots.
 }
 
-mirror::String* InternTable::Lookup(Table& table, mirror::String* s, int32_t hash_code) {
+mirror::String* InternTable::Lookup(Table* table, mirror::String* s, int32_t hash_code) {
   Locks::intern_table_lock_->AssertHeld(Thread::Current());
-  for (auto it = table.find(hash_code), end = table.end(); it != end; ++it) {
-    mirror::String* existing_string = it->second;
-    if (existing_string->Equals(s)) {
-      return existing_string;
-    }
-  }
-  return NULL;
+  return table->Find(s, hash_code);
 }
 
 mirror::String* InternTable::InsertStrong(mirror::String* s, int32_t hash_code) {
@@ -101,7 +216,7 @@ mirror::String* InternTable::InsertStrong(mirror::String* s, int32_t hash_code)
   if (log_new_roots_) {
     new_strong_intern_roots_.push_back(std::make_pair(hash_code, s));
   }
-  strong_interns_.insert(std::make_pair(hash_code, s));
+  strong_interns_.Insert(s, hash_code);
   return s;
 }
 
@@ -110,7 +225,7 @@ mirror::String* InternTable::InsertWeak(mirror::String* s, int32_t hash_code) {
   if (runtime->IsActiveTransaction()) {
     runtime->RecordWeakStringInsertion(s, hash_code);
   }
-  weak_interns_.insert(std::make_pair(hash_code, s));
+  weak_interns_.Insert(s, hash_code);
   return s;
 }
 
@@ -119,16 +234,11 @@ void InternTable::RemoveWeak(mirror::String* s, int32_t hash_code) {
   if (runtime->IsActiveTransaction()) {
     runtime->RecordWeakStringRemoval(s, hash_code);
   }
-  Remove(weak_interns_, s, hash_code);
+  Remove(&weak_interns_, s, hash_code);
 }
 
-void InternTable::Remove(Table& table, mirror::String* s, int32_t hash_code) {
-  for (auto it = table.find(hash_code), end = table.end(); it != end; ++it) {
-    if (it->second == s) {
-      table.erase(it);
-      return;
-    }
-  }
+void InternTable::Remove(Table* table, mirror::String* s, int32_t hash_code) {
+  table->Remove(s, hash_code);
 }
 
 // Insert/remove methods used to undo changes made during an aborted transaction.
@@ -142,11 +252,11 @@ mirror::String* InternTable::InsertWeakFromTransaction(mirror::String* s, int32_
 }
 void InternTable::RemoveStrongFromTransaction(mirror::String* s, int32_t hash_code) {
   DCHECK(!Runtime::Current()->IsActiveTransaction());
-  Remove(strong_interns_, s, hash_code);
+  Remove(&strong_interns_, s, hash_code);
 }
 void InternTable::RemoveWeakFromTransaction(mirror::String* s, int32_t hash_code) {
   DCHECK(!Runtime::Current()->IsActiveTransaction());
-  Remove(weak_interns_, s, hash_code);
+  Remove(&weak_interns_, s, hash_code);
 }
 
 static mirror::String* LookupStringFromImage(mirror::String* s)
@@ -200,7 +310,7 @@ mirror::String* InternTable::Insert(mirror::String* s, bool is_strong) {
 
   if (is_strong) {
     // Check the strong table for a match.
-    mirror::String* strong = Lookup(strong_interns_, s, hash_code);
+    mirror::String* strong = Lookup(&strong_interns_, s, hash_code);
     if (strong != NULL) {
       return strong;
     }
@@ -212,7 +322,7 @@ mirror::String* InternTable::Insert(mirror::String* s, bool is_strong) {
     }
 
     // There is no match in the strong table, check the weak table.
-    mirror::String* weak = Lookup(weak_interns_, s, hash_code);
+    mirror::String* weak = Lookup(&weak_interns_, s, hash_code);
     if (weak != NULL) {
       // A match was found in the weak table. Promote to the strong table.
       RemoveWeak(weak, hash_code);
@@ -225,7 +335,7 @@ mirror::String* InternTable::Insert(mirror::String* s, bool is_strong) {
   }
 
   // Check the strong table for a match.
-  mirror::String* strong = Lookup(strong_interns_, s, hash_code);
+  mirror::String* strong = Lookup(&strong_interns_, s, hash_code);
   if (strong != NULL) {
     return strong;
   }
@@ -235,7 +345,7 @@ mirror::String* InternTable::Insert(mirror::String* s, bool is_strong) {
     return InsertWeak(image, hash_code);
   }
   // Check the weak table for a match.
-  mirror::String* weak = Lookup(weak_interns_, s, hash_code);
+  mirror::String* weak = Lookup(&weak_interns_, s, hash_code);
   if (weak != NULL) {
     return weak;
   }
@@ -270,23 +380,42 @@ mirror::String* InternTable::InternWeak(mirror::String* s) {
 
 bool InternTable::ContainsWeak(mirror::String* s) {
   MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  const mirror::String* found = Lookup(weak_interns_, s, s->GetHashCode());
+  const mirror::String* found = Lookup(&weak_interns_, s, s->GetHashCode());
   return found == s;
 }
 
 void InternTable::SweepInternTableWeaks(IsMarkedCallback* callback, void* arg) {
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  for (auto it = weak_interns_.begin(), end = weak_interns_.end(); it != end;) {
-    mirror::Object* object = it->second;
-    mirror::Object* new_object = callback(object, arg);
-    if (new_object == nullptr) {
-      // TODO: use it = weak_interns_.erase(it) when we get a c++11 stl.
-      weak_interns_.erase(it++);
-    } else {
-      it->second = down_cast<mirror::String*>(new_object);
-      ++it;
+  Thread* self = Thread::Current();
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  ThreadPool* thread_pool = heap->GetThreadPool();
+  const size_t thread_count = heap->GetParallelGCThreadCount() + 1;
+  Table* weak_interns;
+  size_t capacity;
+  {
+    MutexLock mu(self, *Locks::intern_table_lock_);
+    weak_interns = &weak_interns_;
+    capacity = weak_interns_.Capacity();
+    if (thread_pool == nullptr || thread_count == 1 || capacity < kMinParallelSweepCapacity) {
+      weak_interns_.RecordSweptStrings(weak_interns_.SweepWeaks(0u, capacity, callback, arg));
+      return;
     }
   }
+  // The task queue lock of the thread pool is above the intern table lock, so the lock is not
+  // held while the GC threads sweep. New interns are disallowed during the sweep, so the slots
+  // don't move, and the GC threads each sweep their own range.
+  Atomic<size_t> num_swept(0u);
+  const size_t range_size = RoundUp(capacity / thread_count + 1, kMinParallelSweepCapacity / 4);
+  for (size_t begin = 0u; begin < capacity; begin += range_size) {
+    size_t end = std::min(begin + range_size, capacity);
+    thread_pool->AddTask(self, new SweepTask(weak_interns, begin, end, callback, arg,
+                                             &num_swept));
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count - 1);
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, true, true);
+  thread_pool->StopWorkers(self);
+  MutexLock mu(self, *Locks::intern_table_lock_);
+  weak_interns_.RecordSweptStrings(num_swept.Load());
 }
 
 }  // namespace art
@@ -17,7 +17,7 @@
 #ifndef ART_RUNTIME_INTERN_TABLE_H_
 #define ART_RUNTIME_INTERN_TABLE_H_
 
-#include <map>
+#include <vector>
 
 #include "base/mutex.h"
 #include "object_callbacks.h"
@@ -59,7 +59,10 @@ class InternTable {
   // Interns a potentially new string in the 'weak' table. (See above.)
   mirror::String* InternWeak(mirror::String* s) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  void SweepInternTableWeaks(IsMarkedCallback* callback, void* arg);
+  // Large tables are swept by the GC threads without holding the intern table lock: nothing may
+  // intern strings meanwhile, which the GC ensures by disallowing new interns.
+  void SweepInternTableWeaks(IsMarkedCallback* callback, void* arg)
+      LOCKS_EXCLUDED(Locks::intern_table_lock_);
 
   bool ContainsWeak(mirror::String* s) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -73,28 +76,97 @@ class InternTable {
   void AllowNewInterns() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
  private:
-  typedef std::multimap<int32_t, mirror::String*> Table;
+  // Open-addressing hash set of strings with linear probing. Only the string references are
+  // stored, the hash codes are cached in the strings themselves; the callers pass them in since
+  // the strings may have moved. Removed strings leave a tombstone until the next rehash.
+  class Table {
+   public:
+    Table();
+
+    mirror::String* Find(mirror::String* s, int32_t hash_code)
+        SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+    // The string must not be in the table.
+    void Insert(mirror::String* s, int32_t hash_code) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+    void Remove(mirror::String* s, int32_t hash_code);
+    // Replaces `old_ref` with `new_ref`, which the GC moved it to.
+    void Update(int32_t hash_code, mirror::String* old_ref, mirror::String* new_ref);
+    void VisitRoots(RootCallback* callback, void* arg);
+    // Sweeps the strings in the slots [begin, end), returning how many were removed. Distinct
+    // ranges may be swept in parallel.
+    size_t SweepWeaks(size_t begin, size_t end, IsMarkedCallback* callback, void* arg);
+    // Accounts for the strings removed by SweepWeaks.
+    void RecordSweptStrings(size_t count) {
+      num_strings_ -= count;
+    }
+
+    size_t Size() const {
+      return num_strings_;
+    }
+
+    size_t Capacity() const {
+      return slots_.size();
+    }
+
+   private:
+    static constexpr size_t kInitialCapacity = 1024;
+    // Tombstones count as used as they lengthen the probe sequences just as much.
+    static constexpr size_t kMaxLoadPercent = 50;
+
+    static mirror::String* Tombstone() {
+      return reinterpret_cast<mirror::String*>(1);
+    }
+
+    static bool IsLive(mirror::String* s) {
+      return s != nullptr && s != Tombstone();
+    }
+
+    size_t FirstSlot(int32_t hash_code) const {
+      return static_cast<uint32_t>(hash_code) & (slots_.size() - 1);
+    }
+
+    size_t NextSlot(size_t slot) const {
+      return (slot + 1) & (slots_.size() - 1);
+    }
+
+    void Rehash() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+    std::vector<mirror::String*> slots_;
+    size_t num_strings_;
+    size_t num_used_slots_;
+
+    DISALLOW_COPY_AND_ASSIGN(Table);
+  };
+
+  class SweepTask;
+
+  // Tables with fewer slots are swept by the calling thread only.
+  static constexpr size_t kMinParallelSweepCapacity = 16 * 1024;
 
   mirror::String* Insert(mirror::String* s, bool is_strong)
       LOCKS_EXCLUDED(Locks::intern_table_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  mirror::String* Lookup(Table& table, mirror::String* s, int32_t hash_code)
+  mirror::String* Lookup(Table* table, mirror::String* s, int32_t hash_code)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   mirror::String* InsertStrong(mirror::String* s, int32_t hash_code)
-      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   mirror::String* InsertWeak(mirror::String* s, int32_t hash_code)
-      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void RemoveWeak(mirror::String* s, int32_t hash_code)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
-  void Remove(Table& table, mirror::String* s, int32_t hash_code)
+  void Remove(Table* table, mirror::String* s, int32_t hash_code)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
 
   // Transaction rollback access.
   mirror::String* InsertStrongFromTransaction(mirror::String* s, int32_t hash_code)
-      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   mirror::String* InsertWeakFromTransaction(mirror::String* s, int32_t hash_code)
-      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void RemoveStrongFromTransaction(mirror::String* s, int32_t hash_code)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::intern_table_lock_);
   void RemoveWeakFromTransaction(mirror::String* s, int32_t hash_code)
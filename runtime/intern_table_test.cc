@@ -16,7 +16,10 @@
 
 #include "intern_table.h"
 
+#include <set>
+
 #include "common_runtime_test.h"
+#include "gc/heap.h"
 #include "mirror/object.h"
 #include "handle_scope-inl.h"
 
@@ -125,6 +128,74 @@ TEST_F(InternTableTest, SweepInternTableWeaks) {
   EXPECT_EQ(3U, t.Size());
 }
 
+TEST_F(InternTableTest, GrowAndSweep) {
+  ScopedObjectAccess soa(Thread::Current());
+  InternTable t;
+  // Enough strings to rehash the tables a few times.
+  static constexpr size_t kNumStrings = 3000;
+  TestPredicate p;
+  for (size_t i = 0; i < kNumStrings; ++i) {
+    std::string s = StringPrintf("string %zu", i);
+    if (i % 2 == 0) {
+      t.InternStrong(s.c_str());
+    } else {
+      p.Expect(t.InternWeak(mirror::String::AllocFromModifiedUtf8(soa.Self(), s.c_str())));
+    }
+  }
+  EXPECT_EQ(kNumStrings, t.Size());
+  {
+    ReaderMutexLock mu(soa.Self(), *Locks::heap_bitmap_lock_);
+    t.SweepInternTableWeaks(IsMarkedSweepingCallback, &p);
+  }
+  EXPECT_EQ(kNumStrings / 2, t.Size());
+  // The strong strings are still found past the tombstones of the weak ones.
+  for (size_t i = 0; i < kNumStrings; i += 2) {
+    std::string s = StringPrintf("string %zu", i);
+    t.InternStrong(s.c_str());
+  }
+  EXPECT_EQ(kNumStrings / 2, t.Size());
+}
+
+// Only reads the set of live strings, so that the GC threads can call it in parallel.
+mirror::Object* IsInSetSweepingCallback(mirror::Object* object, void* arg) {
+  const std::set<const mirror::Object*>* live =
+      reinterpret_cast<const std::set<const mirror::Object*>*>(arg);
+  return live->count(object) != 0 ? object : nullptr;
+}
+
+TEST_F(InternTableTest, ParallelSweep) {
+  ScopedObjectAccess soa(Thread::Current());
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  const bool create_thread_pool = heap->GetThreadPool() == nullptr;
+  if (create_thread_pool) {
+    heap->CreateThreadPool();
+  }
+  InternTable t;
+  // Enough strings for the weak table to be swept by the GC threads.
+  static constexpr size_t kNumStrings = 12000;
+  std::set<const mirror::Object*> live;
+  for (size_t i = 0; i < kNumStrings; ++i) {
+    std::string s = StringPrintf("weak %zu", i);
+    mirror::String* interned =
+        t.InternWeak(mirror::String::AllocFromModifiedUtf8(soa.Self(), s.c_str()));
+    if (i % 3 == 0) {
+      live.insert(interned);
+    }
+  }
+  EXPECT_EQ(kNumStrings, t.Size());
+  {
+    ReaderMutexLock mu(soa.Self(), *Locks::heap_bitmap_lock_);
+    t.SweepInternTableWeaks(IsInSetSweepingCallback, &live);
+  }
+  EXPECT_EQ(live.size(), t.Size());
+  // The table is still usable after the sweep.
+  t.InternStrong(3, "foo");
+  EXPECT_EQ(live.size() + 1, t.Size());
+  if (create_thread_pool) {
+    heap->DeleteThreadPool();
+  }
+}
+
 TEST_F(InternTableTest, ContainsWeak) {
   ScopedObjectAccess soa(Thread::Current());
   {
@@ -59,6 +59,21 @@ static void UnstartedRuntimeJni(Thread* self, ArtMethod* method,
     JValue value;
     value.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
     result->SetD(exp(value.GetD()));
+  } else if (name == "double java.lang.Math.sqrt(double)") {
+    JValue value;
+    value.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+    result->SetD(sqrt(value.GetD()));
+  } else if (name == "double java.lang.Math.floor(double)") {
+    JValue value;
+    value.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+    result->SetD(floor(value.GetD()));
+  } else if (name == "double java.lang.Math.ceil(double)") {
+    JValue value;
+    value.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+    result->SetD(ceil(value.GetD()));
+  } else if (name == "long java.lang.Double.doubleToRawLongBits(double)" ||
+             name == "double java.lang.Double.longBitsToDouble(long)") {
+    result->SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
   } else if (name == "java.lang.Object java.lang.Object.internalClone()") {
     result->SetL(receiver->Clone(self));
   } else if (name == "void java.lang.Object.notifyAll()") {
@@ -69,6 +84,16 @@ static void UnstartedRuntimeJni(Thread* self, ArtMethod* method,
     result->SetI(receiver->AsString()->CompareTo(rhs));
   } else if (name == "java.lang.String java.lang.String.intern()") {
     result->SetL(receiver->AsString()->Intern());
+  } else if (name == "char java.lang.String.charAt(int)") {
+    String* string = receiver->AsString();
+    int32_t index = args[0];
+    if (index < 0 || index >= string->GetLength()) {
+      self->ThrowNewExceptionF(self->GetCurrentLocationForThrow(),
+                               "Ljava/lang/StringIndexOutOfBoundsException;",
+                               "length=%d; index=%d", string->GetLength(), index);
+    } else {
+      result->SetC(string->CharAt(index));
+    }
   } else if (name == "int java.lang.String.fastIndexOf(int, int)") {
     result->SetI(receiver->AsString()->FastIndexOf(args[0], args[1]));
   } else if (name == "java.lang.Object java.lang.reflect.Array.createMultiArray(java.lang.Class, int[])") {
@@ -354,6 +379,7 @@ static inline JValue Execute(Thread* self, MethodHelper& mh, const DexFile::Code
          shadow_frame.GetMethod()->GetDeclaringClass()->IsProxyClass());
   DCHECK(!shadow_frame.GetMethod()->IsAbstract());
   DCHECK(!shadow_frame.GetMethod()->IsNative());
+  ++self->GetCounters()->interpreter_entries;
 
   bool transaction_active = Runtime::Current()->IsActiveTransaction();
   if (LIKELY(shadow_frame.GetMethod()->IsPreverified())) {
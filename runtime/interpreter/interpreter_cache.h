@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_INTERPRETER_INTERPRETER_CACHE_H_
+#define ART_RUNTIME_INTERPRETER_INTERPRETER_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/macros.h"
+
+namespace art {
+
+class Instruction;
+
+// Per-thread side table of what the interpreter resolved for its field access and invoke
+// instructions, the runtime counterpart of the quickened instructions of the DEX-to-DEX compiler:
+// the dex files are mapped read-only so the instructions themselves can't be rewritten.
+// Direct-mapped and keyed by the address of the instruction, which is stable since only
+// unregistered dex files, whose code never runs, are closed. Only the owning thread accesses it.
+class InterpreterCache {
+ public:
+  InterpreterCache() {
+    Clear();
+  }
+
+  void Clear() {
+    for (size_t i = 0; i < kSize; ++i) {
+      entries_[i].key = nullptr;
+      entries_[i].value = 0u;
+    }
+  }
+
+  bool Get(const Instruction* key, size_t* value) const ALWAYS_INLINE {
+    const Entry& entry = entries_[IndexOf(key)];
+    if (entry.key != key) {
+      return false;
+    }
+    *value = entry.value;
+    return true;
+  }
+
+  void Set(const Instruction* key, size_t value) ALWAYS_INLINE {
+    Entry& entry = entries_[IndexOf(key)];
+    entry.key = key;
+    entry.value = value;
+  }
+
+ private:
+  static constexpr size_t kSize = 256;
+
+  struct Entry {
+    const Instruction* key;
+    size_t value;
+  };
+
+  static size_t IndexOf(const Instruction* key) ALWAYS_INLINE {
+    // Instructions are 16-bit code units.
+    return (reinterpret_cast<uintptr_t>(key) >> 1) & (kSize - 1);
+  }
+
+  Entry entries_[kSize];
+
+  DISALLOW_COPY_AND_ASSIGN(InterpreterCache);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_INTERPRETER_INTERPRETER_CACHE_H_
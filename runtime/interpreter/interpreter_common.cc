@@ -20,6 +20,25 @@
 namespace art {
 namespace interpreter {
 
+// Copies the elements one at a time with Set, so that a transaction records the writes, and
+// backwards if the destination overlaps the end of the source.
+template <typename ArrayType>
+static void UnstartedRuntimeArrayCopy(Object* src, jint src_pos, Object* dst, jint dst_pos,
+                                      jint length)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  ArrayType* src_array = down_cast<ArrayType*>(src);
+  ArrayType* dst_array = down_cast<ArrayType*>(dst);
+  if (src_array == dst_array && src_pos < dst_pos) {
+    for (jint i = length - 1; i >= 0; --i) {
+      dst_array->Set(dst_pos + i, src_array->Get(src_pos + i));
+    }
+  } else {
+    for (jint i = 0; i < length; ++i) {
+      dst_array->Set(dst_pos + i, src_array->Get(src_pos + i));
+    }
+  }
+}
+
 static void UnstartedRuntimeInvoke(Thread* self, MethodHelper& mh,
                                    const DexFile::CodeItem* code_item, ShadowFrame* shadow_frame,
                                    JValue* result, size_t arg_offset)
@@ -372,32 +391,66 @@ static void UnstartedRuntimeInvoke(Thread* self, MethodHelper& mh,
   } else if (name == "void java.lang.System.arraycopy(java.lang.Object, int, java.lang.Object, int, int)" ||
              name == "void java.lang.System.arraycopy(char[], int, char[], int, int)") {
     // Special case array copying without initializing System.
-    Class* ctype = shadow_frame->GetVRegReference(arg_offset)->GetClass()->GetComponentType();
+    Object* src = shadow_frame->GetVRegReference(arg_offset);
+    Object* dst = shadow_frame->GetVRegReference(arg_offset + 2);
     jint srcPos = shadow_frame->GetVReg(arg_offset + 1);
     jint dstPos = shadow_frame->GetVReg(arg_offset + 3);
     jint length = shadow_frame->GetVReg(arg_offset + 4);
-    if (!ctype->IsPrimitive()) {
-      ObjectArray<Object>* src = shadow_frame->GetVRegReference(arg_offset)->AsObjectArray<Object>();
-      ObjectArray<Object>* dst = shadow_frame->GetVRegReference(arg_offset + 2)->AsObjectArray<Object>();
-      for (jint i = 0; i < length; ++i) {
-        dst->Set(dstPos + i, src->Get(srcPos + i));
-      }
-    } else if (ctype->IsPrimitiveChar()) {
-      CharArray* src = shadow_frame->GetVRegReference(arg_offset)->AsCharArray();
-      CharArray* dst = shadow_frame->GetVRegReference(arg_offset + 2)->AsCharArray();
-      for (jint i = 0; i < length; ++i) {
-        dst->Set(dstPos + i, src->Get(srcPos + i));
-      }
-    } else if (ctype->IsPrimitiveInt()) {
-      IntArray* src = shadow_frame->GetVRegReference(arg_offset)->AsIntArray();
-      IntArray* dst = shadow_frame->GetVRegReference(arg_offset + 2)->AsIntArray();
-      for (jint i = 0; i < length; ++i) {
-        dst->Set(dstPos + i, src->Get(srcPos + i));
-      }
-    } else {
-      self->ThrowNewExceptionF(self->GetCurrentLocationForThrow(), "Ljava/lang/InternalError;",
-                               "Unimplemented System.arraycopy for type '%s'",
-                               PrettyDescriptor(ctype).c_str());
+    if (src == nullptr || dst == nullptr) {
+      self->ThrowNewException(self->GetCurrentLocationForThrow(),
+                              "Ljava/lang/NullPointerException;", "null array in arraycopy");
+      return;
+    }
+    if (!src->IsArrayInstance() || !dst->IsArrayInstance() ||
+        (src->GetClass() != dst->GetClass() &&
+         (src->GetClass()->GetComponentType()->IsPrimitive() ||
+          dst->GetClass()->GetComponentType()->IsPrimitive()))) {
+      self->ThrowNewExceptionF(self->GetCurrentLocationForThrow(),
+                               "Ljava/lang/ArrayStoreException;", "%s and %s are incompatible",
+                               PrettyTypeOf(src).c_str(), PrettyTypeOf(dst).c_str());
+      return;
+    }
+    int32_t src_length = src->AsArray()->GetLength();
+    int32_t dst_length = dst->AsArray()->GetLength();
+    if (srcPos < 0 || dstPos < 0 || length < 0 || srcPos > src_length - length ||
+        dstPos > dst_length - length) {
+      self->ThrowNewExceptionF(self->GetCurrentLocationForThrow(),
+                               "Ljava/lang/ArrayIndexOutOfBoundsException;",
+                               "src.length=%d srcPos=%d dst.length=%d dstPos=%d length=%d",
+                               src_length, srcPos, dst_length, dstPos, length);
+      return;
+    }
+    Class* ctype = src->GetClass()->GetComponentType();
+    switch (ctype->GetPrimitiveType()) {
+      case Primitive::kPrimNot:
+        UnstartedRuntimeArrayCopy<ObjectArray<Object>>(src, srcPos, dst, dstPos, length);
+        break;
+      case Primitive::kPrimBoolean:
+        UnstartedRuntimeArrayCopy<BooleanArray>(src, srcPos, dst, dstPos, length);
+        break;
+      case Primitive::kPrimByte:
+        UnstartedRuntimeArrayCopy<ByteArray>(src, srcPos, dst, dstPos, length);
+        break;
+      case Primitive::kPrimChar:
+        UnstartedRuntimeArrayCopy<CharArray>(src, srcPos, dst, dstPos, length);
+        break;
+      case Primitive::kPrimShort:
+        UnstartedRuntimeArrayCopy<ShortArray>(src, srcPos, dst, dstPos, length);
+        break;
+      case Primitive::kPrimInt:
+        UnstartedRuntimeArrayCopy<IntArray>(src, srcPos, dst, dstPos, length);
+        break;
+      case Primitive::kPrimLong:
+        UnstartedRuntimeArrayCopy<LongArray>(src, srcPos, dst, dstPos, length);
+        break;
+      case Primitive::kPrimFloat:
+        UnstartedRuntimeArrayCopy<mirror::FloatArray>(src, srcPos, dst, dstPos, length);
+        break;
+      case Primitive::kPrimDouble:
+        UnstartedRuntimeArrayCopy<mirror::DoubleArray>(src, srcPos, dst, dstPos, length);
+        break;
+      default:
+        LOG(FATAL) << "Unexpected component type " << PrettyDescriptor(ctype);
     }
   } else  if (name == "java.lang.Object java.lang.ThreadLocal.get()") {
     std::string caller(PrettyMethod(shadow_frame->GetLink()->GetMethod()));
@@ -29,6 +29,8 @@
 #include "dex_instruction.h"
 #include "entrypoints/entrypoint_utils.h"
 #include "gc/accounting/card_table-inl.h"
+#include "interpreter/interpreter_cache.h"
+#include "jit/jit.h"
 #include "nth_caller_visitor.h"
 #include "mirror/art_field-inl.h"
 #include "mirror/art_method.h"
@@ -38,6 +40,7 @@
 #include "mirror/object-inl.h"
 #include "mirror/object_array-inl.h"
 #include "object_utils.h"
+#include "profiler.h"
 #include "ScopedLocalRef.h"
 #include "scoped_thread_state_change.h"
 #include "thread.h"
@@ -104,6 +107,41 @@ template<bool is_range, bool do_assignability_check>
 bool DoCall(ArtMethod* method, Thread* self, ShadowFrame& shadow_frame,
             const Instruction* inst, uint16_t inst_data, JValue* result);
 
+// Finds the method invoked by `inst` like FindMethodFromCode, from what an earlier execution of
+// `inst` recorded in the interpreter cache of `self`: the method of a static or direct invoke,
+// the vtable index of a virtual one. Only verified code, which needs no access checks, is cached.
+template<InvokeType type, bool do_access_check>
+static inline ArtMethod* FindMethodFromInterpreterCache(Thread* self,
+                                                        const ShadowFrame& shadow_frame,
+                                                        const Instruction* inst,
+                                                        uint32_t method_idx, Object* receiver)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  CHECK(!kMovingMethods);
+  const bool cacheable =
+      !do_access_check && (type == kStatic || type == kDirect || type == kVirtual);
+  InterpreterCache* cache = self->GetInterpreterCache();
+  size_t value;
+  if (cacheable && cache->Get(inst, &value)) {
+    if (type != kStatic && UNLIKELY(receiver == nullptr)) {
+      ThrowNullPointerExceptionForMethodAccess(shadow_frame.GetCurrentLocationForThrow(),
+                                               method_idx, type);
+      return nullptr;
+    }
+    if (type == kVirtual) {
+      return receiver->GetClass()->GetVTable()->GetWithoutChecks(value);
+    }
+    return reinterpret_cast<ArtMethod*>(value);
+  }
+  ArtMethod* method = FindMethodFromCode<type, do_access_check>(method_idx, receiver,
+                                                                shadow_frame.GetMethod(), self);
+  if (cacheable && method != nullptr) {
+    // Overriding methods share the vtable index of the method they override.
+    cache->Set(inst, (type == kVirtual) ? method->GetMethodIndex()
+                                        : reinterpret_cast<size_t>(method));
+  }
+  return method;
+}
+
 // Handles invoke-XXX/range instructions.
 // Returns true on success, otherwise throws an exception and returns false.
 template<InvokeType type, bool is_range, bool do_access_check>
@@ -112,9 +150,8 @@ static inline bool DoInvoke(Thread* self, ShadowFrame& shadow_frame, const Instr
   const uint32_t method_idx = (is_range) ? inst->VRegB_3rc() : inst->VRegB_35c();
   const uint32_t vregC = (is_range) ? inst->VRegC_3rc() : inst->VRegC_35c();
   Object* receiver = (type == kStatic) ? nullptr : shadow_frame.GetVRegReference(vregC);
-  ArtMethod* const method = FindMethodFromCode<type, do_access_check>(method_idx, receiver,
-                                                                      shadow_frame.GetMethod(),
-                                                                      self);
+  ArtMethod* const method = FindMethodFromInterpreterCache<type, do_access_check>(
+      self, shadow_frame, inst, method_idx, receiver);
   if (UNLIKELY(method == nullptr)) {
     CHECK(self->IsExceptionPending());
     result->SetJ(0);
@@ -124,6 +161,12 @@ static inline bool DoInvoke(Thread* self, ShadowFrame& shadow_frame, const Instr
     result->SetJ(0);
     return false;
   } else {
+    if ((type == kVirtual || type == kInterface) &&
+        UNLIKELY(BackgroundMethodSamplingProfiler::IsRecordingReceiverTypes())) {
+      BackgroundMethodSamplingProfiler::RecordReceiverType(self, shadow_frame.GetMethod(),
+                                                           shadow_frame.GetDexPC(),
+                                                           receiver->GetClass());
+    }
     return DoCall<is_range, do_access_check>(method, self, shadow_frame, inst, inst_data, result);
   }
 }
@@ -153,11 +196,41 @@ static inline bool DoInvokeVirtualQuick(Thread* self, ShadowFrame& shadow_frame,
     result->SetJ(0);
     return false;
   } else {
+    if (UNLIKELY(BackgroundMethodSamplingProfiler::IsRecordingReceiverTypes())) {
+      BackgroundMethodSamplingProfiler::RecordReceiverType(self, shadow_frame.GetMethod(),
+                                                           shadow_frame.GetDexPC(),
+                                                           receiver->GetClass());
+    }
     // No need to check since we've been quickened.
     return DoCall<is_range, false>(method, self, shadow_frame, inst, inst_data, result);
   }
 }
 
+// Finds the field accessed by `inst` like FindFieldFromCode, from the interpreter cache of `self`
+// once `inst` has been executed. Only verified code, which needs no access checks, is cached, and
+// static fields only once their class is initialized.
+template<FindFieldType find_type, Primitive::Type field_type, bool do_access_check>
+static inline ArtField* FindFieldFromInterpreterCache(Thread* self,
+                                                      const ShadowFrame& shadow_frame,
+                                                      const Instruction* inst, uint32_t field_idx)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  CHECK(!kMovingFields);
+  InterpreterCache* cache = self->GetInterpreterCache();
+  size_t value;
+  if (!do_access_check && cache->Get(inst, &value)) {
+    return reinterpret_cast<ArtField*>(value);
+  }
+  ArtField* f = FindFieldFromCode<find_type, do_access_check>(field_idx, shadow_frame.GetMethod(),
+                                                              self,
+                                                              Primitive::FieldSize(field_type));
+  // The class of a static field may still be being initialized by this thread.
+  if (!do_access_check && f != nullptr &&
+      (!f->IsStatic() || f->GetDeclaringClass()->IsInitialized())) {
+    cache->Set(inst, reinterpret_cast<size_t>(f));
+  }
+  return f;
+}
+
 // Handles iget-XXX and sget-XXX instructions.
 // Returns true on success, otherwise throws an exception and returns false.
 template<FindFieldType find_type, Primitive::Type field_type, bool do_access_check>
@@ -165,8 +238,8 @@ static SOMETIMES_INLINE_KEYWORD bool DoFieldGet(Thread* self, ShadowFrame& shado
                                                 const Instruction* inst, uint16_t inst_data) {
   const bool is_static = (find_type == StaticObjectRead) || (find_type == StaticPrimitiveRead);
   const uint32_t field_idx = is_static ? inst->VRegB_21c() : inst->VRegC_22c();
-  ArtField* f = FindFieldFromCode<find_type, do_access_check>(field_idx, shadow_frame.GetMethod(), self,
-                                                              Primitive::FieldSize(field_type));
+  ArtField* f = FindFieldFromInterpreterCache<find_type, field_type, do_access_check>(
+      self, shadow_frame, inst, field_idx);
   if (UNLIKELY(f == nullptr)) {
     CHECK(self->IsExceptionPending());
     return false;
@@ -299,8 +372,8 @@ static SOMETIMES_INLINE_KEYWORD bool DoFieldPut(Thread* self, const ShadowFrame&
   bool do_assignability_check = do_access_check;
   bool is_static = (find_type == StaticObjectWrite) || (find_type == StaticPrimitiveWrite);
   uint32_t field_idx = is_static ? inst->VRegB_21c() : inst->VRegC_22c();
-  ArtField* f = FindFieldFromCode<find_type, do_access_check>(field_idx, shadow_frame.GetMethod(), self,
-                                                              Primitive::FieldSize(field_type));
+  ArtField* f = FindFieldFromInterpreterCache<find_type, field_type, do_access_check>(
+      self, shadow_frame, inst, field_idx);
   if (UNLIKELY(f == nullptr)) {
     CHECK(self->IsExceptionPending());
     return false;
@@ -645,6 +718,45 @@ static inline bool IsBackwardBranch(int32_t branch_offset) {
   return branch_offset <= 0;
 }
 
+// Whether the if-XX instruction `inst`, comparing two registers, takes its branch.
+static inline bool IsIfTestTaken(const ShadowFrame& shadow_frame, const Instruction* inst,
+                                 uint16_t inst_data) {
+  const int32_t lhs = shadow_frame.GetVReg(inst->VRegA_22t(inst_data));
+  const int32_t rhs = shadow_frame.GetVReg(inst->VRegB_22t(inst_data));
+  switch (inst->Opcode(inst_data)) {
+    case Instruction::IF_EQ: return lhs == rhs;
+    case Instruction::IF_NE: return lhs != rhs;
+    case Instruction::IF_LT: return lhs < rhs;
+    case Instruction::IF_GE: return lhs >= rhs;
+    case Instruction::IF_GT: return lhs > rhs;
+    case Instruction::IF_LE: return lhs <= rhs;
+    default:
+      LOG(FATAL) << "Unexpected opcode " << inst->Opcode(inst_data);
+      return false;
+  }
+}
+
+// Taken backward branches are reported to the JIT in batches, so that interpreted loops don't
+// take its lock on every iteration.
+static constexpr uint32_t kJitBackwardBranchBatch = 64;
+
+// Counts the backward branch by `offset` the frame is taking. After each batch the JIT may move
+// the frame into the compiled code of its method at the loop header the branch goes to; the
+// method has then run to its end, and this returns true with its result in `osr_result`.
+static inline bool AddBackwardBranchSample(Thread* self, jit::Jit* jit, ShadowFrame& shadow_frame,
+                                           int32_t offset, uint32_t* backward_branches,
+                                           JValue* osr_result)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  if (UNLIKELY(jit != nullptr) && ++*backward_branches == kJitBackwardBranchBatch) {
+    jit->AddSamples(self, shadow_frame.GetMethod(), kJitBackwardBranchBatch);
+    *backward_branches = 0;
+    uint32_t target_dex_pc =
+        static_cast<uint32_t>(static_cast<int32_t>(shadow_frame.GetDexPC()) + offset);
+    return jit->MaybeDoOnStackReplacement(self, &shadow_frame, target_dex_pc, osr_result);
+  }
+  return false;
+}
+
 // Explicitly instantiate all DoInvoke functions.
 #define EXPLICIT_DO_INVOKE_TEMPLATE_DECL(_type, _is_range, _do_check)                      \
   template SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) SOMETIMES_INLINE                    \
@@ -28,8 +28,8 @@ namespace interpreter {
 // - "mh": the current MethodHelper.
 // - "currentHandlersTable": the current table of pointer to each instruction handler.
 
-// Advance to the next instruction and updates interpreter state.
-#define ADVANCE(_offset)                                                    \
+// Moves to the instruction at the given offset and updates interpreter state.
+#define MOVE_TO_INSTRUCTION(_offset)                                        \
   do {                                                                      \
     int32_t disp = static_cast<int32_t>(_offset);                           \
     inst = inst->RelativeAt(disp);                                          \
@@ -37,9 +37,88 @@ namespace interpreter {
     shadow_frame.SetDexPC(dex_pc);                                          \
     TraceExecution(shadow_frame, inst, dex_pc, mh);                         \
     inst_data = inst->Fetch16(0);                                           \
+  } while (false)
+
+// Advance to the next instruction and updates interpreter state.
+#define ADVANCE(_offset)                                                    \
+  do {                                                                      \
+    MOVE_TO_INSTRUCTION(_offset);                                           \
     goto *currentHandlersTable[inst->Opcode(inst_data)];                    \
   } while (false)
 
+// Superinstructions. Instructions commonly followed by a given instruction check for it and run
+// its handler with a direct branch, or execute it themselves, rather than going through the
+// indirect dispatch. Only with the main handler table: the alternative handlers must see each
+// instruction for instrumentation.
+#define IS_MAIN_HANDLER_TABLE() \
+  (currentHandlersTable == handlersTable[instrumentation::kMainHandlerTable])
+
+// Advance to the next instruction, branching directly to the handler of _opcode if the next
+// instruction is one, as for runs of iget or aget instructions.
+#define ADVANCE_EXPECTING(_offset, _opcode)                                                 \
+  do {                                                                                      \
+    if (IS_MAIN_HANDLER_TABLE()) {                                                          \
+      const Instruction* next_inst = inst->RelativeAt(_offset);                             \
+      if (next_inst->Opcode(next_inst->Fetch16(0)) == Instruction::_opcode) {               \
+        MOVE_TO_INSTRUCTION(_offset);                                                       \
+        goto op_##_opcode;                                                                  \
+      }                                                                                     \
+    }                                                                                       \
+    ADVANCE(_offset);                                                                       \
+  } while (false)
+
+// Finishes an instruction setting the result register, executing the move-result instruction
+// following it, if any, as part of it.
+#define POSSIBLY_HANDLE_PENDING_EXCEPTION_AND_MOVE_RESULT(_is_exception_pending, _offset)   \
+  do {                                                                                      \
+    if (UNLIKELY(_is_exception_pending)) {                                                  \
+      HANDLE_PENDING_EXCEPTION();                                                           \
+    }                                                                                       \
+    if (IS_MAIN_HANDLER_TABLE()) {                                                          \
+      const Instruction* next_inst = inst->RelativeAt(_offset);                             \
+      uint16_t next_inst_data = next_inst->Fetch16(0);                                      \
+      switch (next_inst->Opcode(next_inst_data)) {                                          \
+        case Instruction::MOVE_RESULT:                                                      \
+          shadow_frame.SetVReg(next_inst->VRegA_11x(next_inst_data),                        \
+                               result_register.GetI());                                     \
+          ADVANCE((_offset) + 1);                                                           \
+        case Instruction::MOVE_RESULT_WIDE:                                                 \
+          shadow_frame.SetVRegLong(next_inst->VRegA_11x(next_inst_data),                    \
+                                   result_register.GetJ());                                 \
+          ADVANCE((_offset) + 1);                                                           \
+        case Instruction::MOVE_RESULT_OBJECT:                                               \
+          shadow_frame.SetVRegReference(next_inst->VRegA_11x(next_inst_data),               \
+                                        result_register.GetL());                            \
+          ADVANCE((_offset) + 1);                                                           \
+        default:                                                                            \
+          break;                                                                            \
+      }                                                                                     \
+    }                                                                                       \
+    ADVANCE(_offset);                                                                       \
+  } while (false)
+
+// Finishes a const instruction, executing the if-XX instruction comparing two registers that
+// follows it, if any, as part of it. Taken backward branches are left to the if-XX handler for
+// its suspend check and JIT sampling.
+#define ADVANCE_CONST(_offset)                                                              \
+  do {                                                                                      \
+    if (IS_MAIN_HANDLER_TABLE()) {                                                          \
+      const Instruction* next_inst = inst->RelativeAt(_offset);                             \
+      uint16_t next_inst_data = next_inst->Fetch16(0);                                      \
+      Instruction::Code next_opcode = next_inst->Opcode(next_inst_data);                    \
+      if (next_opcode >= Instruction::IF_EQ && next_opcode <= Instruction::IF_LE) {         \
+        if (!IsIfTestTaken(shadow_frame, next_inst, next_inst_data)) {                      \
+          ADVANCE((_offset) + 2);                                                           \
+        }                                                                                   \
+        int16_t branch_offset = next_inst->VRegC_22t();                                     \
+        if (!IsBackwardBranch(branch_offset)) {                                             \
+          ADVANCE((_offset) + branch_offset);                                               \
+        }                                                                                   \
+      }                                                                                     \
+    }                                                                                       \
+    ADVANCE(_offset);                                                                       \
+  } while (false)
+
 #define HANDLE_PENDING_EXCEPTION() goto exception_pending_label
 
 #define POSSIBLY_HANDLE_PENDING_EXCEPTION(_is_exception_pending, _offset)   \
@@ -146,6 +225,9 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   uint16_t inst_data;
   const void* const* currentHandlersTable;
   bool notified_method_entry_event = false;
+  jit::Jit* const jit = Runtime::Current()->GetJit();
+  uint32_t backward_branches = 0;
+  JValue osr_result;
   UPDATE_HANDLER_TABLE();
   if (LIKELY(dex_pc == 0)) {  // We are entering the method as opposed to deoptimizing..
     instrumentation::Instrumentation* instrumentation = Runtime::Current()->GetInstrumentation();
@@ -154,6 +236,9 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
                                         shadow_frame.GetMethod(), 0);
       notified_method_entry_event = true;
     }
+    if (UNLIKELY(jit != nullptr)) {
+      jit->AddMethodEntrySample(self, shadow_frame.GetMethod());
+    }
   }
 
   // Jump to first instruction.
@@ -367,7 +452,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (val == 0) {
       shadow_frame.SetVRegReference(dst, NULL);
     }
-    ADVANCE(1);
+    ADVANCE_CONST(1);
   }
   HANDLE_INSTRUCTION_END();
 
@@ -378,7 +463,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (val == 0) {
       shadow_frame.SetVRegReference(dst, NULL);
     }
-    ADVANCE(2);
+    ADVANCE_CONST(2);
   }
   HANDLE_INSTRUCTION_END();
 
@@ -389,7 +474,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (val == 0) {
       shadow_frame.SetVRegReference(dst, NULL);
     }
-    ADVANCE(3);
+    ADVANCE_CONST(3);
   }
   HANDLE_INSTRUCTION_END();
 
@@ -564,7 +649,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     bool success =
         DoFilledNewArray<false, do_access_check, transaction_active>(inst, shadow_frame,
                                                                      self, &result_register);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_AND_MOVE_RESULT(!success, 3);
   }
   HANDLE_INSTRUCTION_END();
 
@@ -572,7 +657,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     bool success =
         DoFilledNewArray<true, do_access_check, transaction_active>(inst, shadow_frame,
                                                                     self, &result_register);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_AND_MOVE_RESULT(!success, 3);
   }
   HANDLE_INSTRUCTION_END();
 
@@ -616,6 +701,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
                                "Throwing '%s' that is not instance of Throwable",
                                exception->GetClass()->GetDescriptor().c_str());
     } else {
+      ++self->GetCounters()->exceptions_thrown;
       self->SetException(shadow_frame.GetCurrentLocationForThrow(), exception->AsThrowable());
     }
     HANDLE_PENDING_EXCEPTION();
@@ -625,6 +711,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(GOTO) {
     int8_t offset = inst->VRegA_10t(inst_data);
     if (IsBackwardBranch(offset)) {
+      if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                  &osr_result)) {
+        return osr_result;
+      }
       if (UNLIKELY(self->TestAllFlags())) {
         CheckSuspend(self);
         UPDATE_HANDLER_TABLE();
@@ -637,6 +727,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(GOTO_16) {
     int16_t offset = inst->VRegA_20t();
     if (IsBackwardBranch(offset)) {
+      if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                  &osr_result)) {
+        return osr_result;
+      }
       if (UNLIKELY(self->TestAllFlags())) {
         CheckSuspend(self);
         UPDATE_HANDLER_TABLE();
@@ -649,6 +743,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(GOTO_32) {
     int32_t offset = inst->VRegA_30t();
     if (IsBackwardBranch(offset)) {
+      if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                  &osr_result)) {
+        return osr_result;
+      }
       if (UNLIKELY(self->TestAllFlags())) {
         CheckSuspend(self);
         UPDATE_HANDLER_TABLE();
@@ -661,6 +759,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(PACKED_SWITCH) {
     int32_t offset = DoPackedSwitch(inst, shadow_frame, inst_data);
     if (IsBackwardBranch(offset)) {
+      if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                  &osr_result)) {
+        return osr_result;
+      }
       if (UNLIKELY(self->TestAllFlags())) {
         CheckSuspend(self);
         UPDATE_HANDLER_TABLE();
@@ -673,6 +775,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(SPARSE_SWITCH) {
     int32_t offset = DoSparseSwitch(inst, shadow_frame, inst_data);
     if (IsBackwardBranch(offset)) {
+      if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                  &osr_result)) {
+        return osr_result;
+      }
       if (UNLIKELY(self->TestAllFlags())) {
         CheckSuspend(self);
         UPDATE_HANDLER_TABLE();
@@ -766,6 +872,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) == shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                    &osr_result)) {
+          return osr_result;
+        }
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -782,6 +892,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) != shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                    &osr_result)) {
+          return osr_result;
+        }
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -798,6 +912,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) < shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                    &osr_result)) {
+          return osr_result;
+        }
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -814,6 +932,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) >= shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                    &osr_result)) {
+          return osr_result;
+        }
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -830,6 +952,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) > shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                    &osr_result)) {
+          return osr_result;
+        }
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -846,6 +972,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) <= shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
       int16_t offset = inst->VRegC_22t();
       if (IsBackwardBranch(offset)) {
+        if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                    &osr_result)) {
+          return osr_result;
+        }
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -862,6 +992,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) == 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                    &osr_result)) {
+          return osr_result;
+        }
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -878,6 +1012,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) != 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                    &osr_result)) {
+          return osr_result;
+        }
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -894,6 +1032,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) < 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                    &osr_result)) {
+          return osr_result;
+        }
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -910,6 +1052,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) >= 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                    &osr_result)) {
+          return osr_result;
+        }
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -926,6 +1072,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) > 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                    &osr_result)) {
+          return osr_result;
+        }
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -942,6 +1092,10 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
     if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) <= 0) {
       int16_t offset = inst->VRegB_21t();
       if (IsBackwardBranch(offset)) {
+        if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                    &osr_result)) {
+          return osr_result;
+        }
         if (UNLIKELY(self->TestAllFlags())) {
           CheckSuspend(self);
           UPDATE_HANDLER_TABLE();
@@ -964,7 +1118,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
       BooleanArray* array = a->AsBooleanArray();
       if (LIKELY(array->CheckIsValidIndex(index))) {
         shadow_frame.SetVReg(inst->VRegA_23x(inst_data), array->GetWithoutChecks(index));
-        ADVANCE(2);
+        ADVANCE_EXPECTING(2, AGET_BOOLEAN);
       } else {
         HANDLE_PENDING_EXCEPTION();
       }
@@ -982,7 +1136,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
       ByteArray* array = a->AsByteArray();
       if (LIKELY(array->CheckIsValidIndex(index))) {
         shadow_frame.SetVReg(inst->VRegA_23x(inst_data), array->GetWithoutChecks(index));
-        ADVANCE(2);
+        ADVANCE_EXPECTING(2, AGET_BYTE);
       } else {
         HANDLE_PENDING_EXCEPTION();
       }
@@ -1000,7 +1154,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
       CharArray* array = a->AsCharArray();
       if (LIKELY(array->CheckIsValidIndex(index))) {
         shadow_frame.SetVReg(inst->VRegA_23x(inst_data), array->GetWithoutChecks(index));
-        ADVANCE(2);
+        ADVANCE_EXPECTING(2, AGET_CHAR);
       } else {
         HANDLE_PENDING_EXCEPTION();
       }
@@ -1018,7 +1172,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
       ShortArray* array = a->AsShortArray();
       if (LIKELY(array->CheckIsValidIndex(index))) {
         shadow_frame.SetVReg(inst->VRegA_23x(inst_data), array->GetWithoutChecks(index));
-        ADVANCE(2);
+        ADVANCE_EXPECTING(2, AGET_SHORT);
       } else {
         HANDLE_PENDING_EXCEPTION();
       }
@@ -1036,7 +1190,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
       IntArray* array = a->AsIntArray();
       if (LIKELY(array->CheckIsValidIndex(index))) {
         shadow_frame.SetVReg(inst->VRegA_23x(inst_data), array->GetWithoutChecks(index));
-        ADVANCE(2);
+        ADVANCE_EXPECTING(2, AGET);
       } else {
         HANDLE_PENDING_EXCEPTION();
       }
@@ -1054,7 +1208,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
       LongArray* array = a->AsLongArray();
       if (LIKELY(array->CheckIsValidIndex(index))) {
         shadow_frame.SetVRegLong(inst->VRegA_23x(inst_data), array->GetWithoutChecks(index));
-        ADVANCE(2);
+        ADVANCE_EXPECTING(2, AGET_WIDE);
       } else {
         HANDLE_PENDING_EXCEPTION();
       }
@@ -1072,7 +1226,7 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
       ObjectArray<Object>* array = a->AsObjectArray<Object>();
       if (LIKELY(array->CheckIsValidIndex(index))) {
         shadow_frame.SetVRegReference(inst->VRegA_23x(inst_data), array->GetWithoutChecks(index));
-        ADVANCE(2);
+        ADVANCE_EXPECTING(2, AGET_OBJECT);
       } else {
         HANDLE_PENDING_EXCEPTION();
       }
@@ -1215,61 +1369,91 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
 
   HANDLE_INSTRUCTION_START(IGET_BOOLEAN) {
     bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimBoolean, do_access_check>(self, shadow_frame, inst, inst_data);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+    if (UNLIKELY(!success)) {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    ADVANCE_EXPECTING(2, IGET_BOOLEAN);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(IGET_BYTE) {
     bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimByte, do_access_check>(self, shadow_frame, inst, inst_data);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+    if (UNLIKELY(!success)) {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    ADVANCE_EXPECTING(2, IGET_BYTE);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(IGET_CHAR) {
     bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimChar, do_access_check>(self, shadow_frame, inst, inst_data);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+    if (UNLIKELY(!success)) {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    ADVANCE_EXPECTING(2, IGET_CHAR);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(IGET_SHORT) {
     bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimShort, do_access_check>(self, shadow_frame, inst, inst_data);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+    if (UNLIKELY(!success)) {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    ADVANCE_EXPECTING(2, IGET_SHORT);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(IGET) {
     bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimInt, do_access_check>(self, shadow_frame, inst, inst_data);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+    if (UNLIKELY(!success)) {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    ADVANCE_EXPECTING(2, IGET);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(IGET_WIDE) {
     bool success = DoFieldGet<InstancePrimitiveRead, Primitive::kPrimLong, do_access_check>(self, shadow_frame, inst, inst_data);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+    if (UNLIKELY(!success)) {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    ADVANCE_EXPECTING(2, IGET_WIDE);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(IGET_OBJECT) {
     bool success = DoFieldGet<InstanceObjectRead, Primitive::kPrimNot, do_access_check>(self, shadow_frame, inst, inst_data);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+    if (UNLIKELY(!success)) {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    ADVANCE_EXPECTING(2, IGET_OBJECT);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(IGET_QUICK) {
     bool success = DoIGetQuick<Primitive::kPrimInt>(shadow_frame, inst, inst_data);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+    if (UNLIKELY(!success)) {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    ADVANCE_EXPECTING(2, IGET_QUICK);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(IGET_WIDE_QUICK) {
     bool success = DoIGetQuick<Primitive::kPrimLong>(shadow_frame, inst, inst_data);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+    if (UNLIKELY(!success)) {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    ADVANCE_EXPECTING(2, IGET_WIDE_QUICK);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(IGET_OBJECT_QUICK) {
     bool success = DoIGetQuick<Primitive::kPrimNot>(shadow_frame, inst, inst_data);
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 2);
+    if (UNLIKELY(!success)) {
+      HANDLE_PENDING_EXCEPTION();
+    }
+    ADVANCE_EXPECTING(2, IGET_OBJECT_QUICK);
   }
   HANDLE_INSTRUCTION_END();
 
@@ -1420,84 +1604,84 @@ JValue ExecuteGotoImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem*
   HANDLE_INSTRUCTION_START(INVOKE_VIRTUAL) {
     bool success = DoInvoke<kVirtual, false, do_access_check>(self, shadow_frame, inst, inst_data, &result_register);
     UPDATE_HANDLER_TABLE();
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_AND_MOVE_RESULT(!success, 3);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(INVOKE_VIRTUAL_RANGE) {
     bool success = DoInvoke<kVirtual, true, do_access_check>(self, shadow_frame, inst, inst_data, &result_register);
     UPDATE_HANDLER_TABLE();
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_AND_MOVE_RESULT(!success, 3);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(INVOKE_SUPER) {
     bool success = DoInvoke<kSuper, false, do_access_check>(self, shadow_frame, inst, inst_data, &result_register);
     UPDATE_HANDLER_TABLE();
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_AND_MOVE_RESULT(!success, 3);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(INVOKE_SUPER_RANGE) {
     bool success = DoInvoke<kSuper, true, do_access_check>(self, shadow_frame, inst, inst_data, &result_register);
     UPDATE_HANDLER_TABLE();
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_AND_MOVE_RESULT(!success, 3);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(INVOKE_DIRECT) {
     bool success = DoInvoke<kDirect, false, do_access_check>(self, shadow_frame, inst, inst_data, &result_register);
     UPDATE_HANDLER_TABLE();
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_AND_MOVE_RESULT(!success, 3);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(INVOKE_DIRECT_RANGE) {
     bool success = DoInvoke<kDirect, true, do_access_check>(self, shadow_frame, inst, inst_data, &result_register);
     UPDATE_HANDLER_TABLE();
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_AND_MOVE_RESULT(!success, 3);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(INVOKE_INTERFACE) {
     bool success = DoInvoke<kInterface, false, do_access_check>(self, shadow_frame, inst, inst_data, &result_register);
     UPDATE_HANDLER_TABLE();
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_AND_MOVE_RESULT(!success, 3);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(INVOKE_INTERFACE_RANGE) {
     bool success = DoInvoke<kInterface, true, do_access_check>(self, shadow_frame, inst, inst_data, &result_register);
     UPDATE_HANDLER_TABLE();
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_AND_MOVE_RESULT(!success, 3);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(INVOKE_STATIC) {
     bool success = DoInvoke<kStatic, false, do_access_check>(self, shadow_frame, inst, inst_data, &result_register);
     UPDATE_HANDLER_TABLE();
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_AND_MOVE_RESULT(!success, 3);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(INVOKE_STATIC_RANGE) {
     bool success = DoInvoke<kStatic, true, do_access_check>(self, shadow_frame, inst, inst_data, &result_register);
     UPDATE_HANDLER_TABLE();
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_AND_MOVE_RESULT(!success, 3);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(INVOKE_VIRTUAL_QUICK) {
     bool success = DoInvokeVirtualQuick<false>(self, shadow_frame, inst, inst_data, &result_register);
     UPDATE_HANDLER_TABLE();
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_AND_MOVE_RESULT(!success, 3);
   }
   HANDLE_INSTRUCTION_END();
 
   HANDLE_INSTRUCTION_START(INVOKE_VIRTUAL_RANGE_QUICK) {
     bool success = DoInvokeVirtualQuick<true>(self, shadow_frame, inst, inst_data, &result_register);
     UPDATE_HANDLER_TABLE();
-    POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, 3);
+    POSSIBLY_HANDLE_PENDING_EXCEPTION_AND_MOVE_RESULT(!success, 3);
   }
   HANDLE_INSTRUCTION_END();
 
@@ -72,12 +72,18 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
   uint32_t dex_pc = shadow_frame.GetDexPC();
   bool notified_method_entry_event = false;
   const instrumentation::Instrumentation* const instrumentation = Runtime::Current()->GetInstrumentation();
+  jit::Jit* const jit = Runtime::Current()->GetJit();
+  uint32_t backward_branches = 0;
+  JValue osr_result;
   if (LIKELY(dex_pc == 0)) {  // We are entering the method as opposed to deoptimizing..
     if (UNLIKELY(instrumentation->HasMethodEntryListeners())) {
       instrumentation->MethodEnterEvent(self, shadow_frame.GetThisObject(code_item->ins_size_),
                                         shadow_frame.GetMethod(), 0);
       notified_method_entry_event = true;
     }
+    if (UNLIKELY(jit != nullptr)) {
+      jit->AddMethodEntrySample(self, shadow_frame.GetMethod());
+    }
   }
   const uint16_t* const insns = code_item->insns_;
   const Instruction* inst = Instruction::At(insns + dex_pc);
@@ -530,6 +536,7 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
                                    "Throwing '%s' that is not instance of Throwable",
                                    exception->GetClass()->GetDescriptor().c_str());
         } else {
+          ++self->GetCounters()->exceptions_thrown;
           self->SetException(shadow_frame.GetCurrentLocationForThrow(), exception->AsThrowable());
         }
         HANDLE_PENDING_EXCEPTION();
@@ -539,6 +546,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         PREAMBLE();
         int8_t offset = inst->VRegA_10t(inst_data);
         if (IsBackwardBranch(offset)) {
+          if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                      &osr_result)) {
+            return osr_result;
+          }
           if (UNLIKELY(self->TestAllFlags())) {
             CheckSuspend(self);
           }
@@ -550,6 +561,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         PREAMBLE();
         int16_t offset = inst->VRegA_20t();
         if (IsBackwardBranch(offset)) {
+          if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                      &osr_result)) {
+            return osr_result;
+          }
           if (UNLIKELY(self->TestAllFlags())) {
             CheckSuspend(self);
           }
@@ -561,6 +576,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         PREAMBLE();
         int32_t offset = inst->VRegA_30t();
         if (IsBackwardBranch(offset)) {
+          if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                      &osr_result)) {
+            return osr_result;
+          }
           if (UNLIKELY(self->TestAllFlags())) {
             CheckSuspend(self);
           }
@@ -572,6 +591,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         PREAMBLE();
         int32_t offset = DoPackedSwitch(inst, shadow_frame, inst_data);
         if (IsBackwardBranch(offset)) {
+          if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                      &osr_result)) {
+            return osr_result;
+          }
           if (UNLIKELY(self->TestAllFlags())) {
             CheckSuspend(self);
           }
@@ -583,6 +606,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         PREAMBLE();
         int32_t offset = DoSparseSwitch(inst, shadow_frame, inst_data);
         if (IsBackwardBranch(offset)) {
+          if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                      &osr_result)) {
+            return osr_result;
+          }
           if (UNLIKELY(self->TestAllFlags())) {
             CheckSuspend(self);
           }
@@ -676,6 +703,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) == shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                        &osr_result)) {
+              return osr_result;
+            }
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -691,6 +722,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) != shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                        &osr_result)) {
+              return osr_result;
+            }
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -706,6 +741,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) < shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                        &osr_result)) {
+              return osr_result;
+            }
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -721,6 +760,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) >= shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                        &osr_result)) {
+              return osr_result;
+            }
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -736,6 +779,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) > shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                        &osr_result)) {
+              return osr_result;
+            }
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -751,6 +798,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) <= shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
           if (IsBackwardBranch(offset)) {
+            if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                        &osr_result)) {
+              return osr_result;
+            }
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -766,6 +817,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) == 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                        &osr_result)) {
+              return osr_result;
+            }
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -781,6 +836,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) != 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                        &osr_result)) {
+              return osr_result;
+            }
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -796,6 +855,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) < 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                        &osr_result)) {
+              return osr_result;
+            }
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -811,6 +874,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) >= 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                        &osr_result)) {
+              return osr_result;
+            }
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -826,6 +893,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) > 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                        &osr_result)) {
+              return osr_result;
+            }
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
@@ -841,6 +912,10 @@ JValue ExecuteSwitchImpl(Thread* self, MethodHelper& mh, const DexFile::CodeItem
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) <= 0) {
           int16_t offset = inst->VRegB_21t();
           if (IsBackwardBranch(offset)) {
+            if (AddBackwardBranchSample(self, jit, shadow_frame, offset, &backward_branches,
+                                        &osr_result)) {
+              return osr_result;
+            }
             if (UNLIKELY(self->TestAllFlags())) {
               CheckSuspend(self);
             }
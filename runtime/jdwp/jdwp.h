@@ -28,6 +28,10 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <map>
+#include <utility>
+#include <vector>
+
 struct iovec;
 
 namespace art {
@@ -307,6 +311,8 @@ struct JdwpState {
   void UnregisterEvent(JdwpEvent* pEvent)
       EXCLUSIVE_LOCKS_REQUIRED(event_list_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void AddToEventIndex(JdwpEvent* pEvent) EXCLUSIVE_LOCKS_REQUIRED(event_list_lock_);
+  void RemoveFromEventIndex(JdwpEvent* pEvent) EXCLUSIVE_LOCKS_REQUIRED(event_list_lock_);
   void SendBufferedRequest(uint32_t type, const std::vector<iovec>& iov);
 
   void StartProcessingRequest() LOCKS_EXCLUDED(process_request_lock_);
@@ -351,6 +357,13 @@ struct JdwpState {
   JdwpEvent* event_list_ GUARDED_BY(event_list_lock_);
   size_t event_list_size_ GUARDED_BY(event_list_lock_);  // Number of elements in event_list_.
 
+  // The events of event_list_ by kind, so that FindMatchingEvents only checks the mods of the
+  // events of the kind it's looking for. Events with a LocationOnly mod are instead indexed by
+  // kind and method, as they can only match in that method.
+  std::map<JdwpEventKind, std::vector<JdwpEvent*>> events_by_kind_ GUARDED_BY(event_list_lock_);
+  std::multimap<std::pair<JdwpEventKind, MethodId>, JdwpEvent*> events_by_method_
+      GUARDED_BY(event_list_lock_);
+
   // Used to synchronize suspension of the event thread (to avoid receiving "resume"
   // events before the thread has finished suspending itself).
   Mutex event_thread_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
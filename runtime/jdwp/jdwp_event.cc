@@ -21,6 +21,8 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/stringprintf.h"
 #include "debugger.h"
@@ -122,6 +124,30 @@ struct ModBasket {
   /* nothing for StepOnly -- handled differently */
 };
 
+/*
+ * The class name is only needed by ClassMatch and ClassExclude mods, and
+ * for logging: look it up on first use rather than for every event.
+ */
+static const std::string& GetClassName(ModBasket* basket)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  if (basket->className.empty() && basket->classId != 0) {
+    basket->className = Dbg::GetClassName(basket->classId);
+  }
+  return basket->className;
+}
+
+/*
+ * Returns the location of the event's LocationOnly mod, or NULL.
+ */
+static const JdwpLocation* GetLocationOnly(const JdwpEvent* pEvent) {
+  for (int i = 0; i < pEvent->modCount; i++) {
+    if (pEvent->mods[i].modKind == MK_LOCATION_ONLY) {
+      return &pEvent->mods[i].locationOnly.loc;
+    }
+  }
+  return NULL;
+}
+
 static bool NeedsFullDeoptimization(JdwpEventKind eventKind) {
   switch (eventKind) {
       case EK_METHOD_ENTRY:
@@ -217,6 +243,7 @@ JdwpError JdwpState::RegisterEvent(JdwpEvent* pEvent) {
     }
     event_list_ = pEvent;
     ++event_list_size_;
+    AddToEventIndex(pEvent);
   }
 
   Dbg::ManageDeoptimization();
@@ -247,6 +274,7 @@ void JdwpState::UnregisterEvent(JdwpEvent* pEvent) {
     pEvent->next = NULL;
   }
   pEvent->prev = NULL;
+  RemoveFromEventIndex(pEvent);
 
   {
     /*
@@ -292,6 +320,41 @@ void JdwpState::UnregisterEvent(JdwpEvent* pEvent) {
   CHECK(event_list_size_ != 0 || event_list_ == NULL);
 }
 
+void JdwpState::AddToEventIndex(JdwpEvent* pEvent) {
+  const JdwpLocation* pLoc = GetLocationOnly(pEvent);
+  if (pLoc != NULL) {
+    events_by_method_.insert(std::make_pair(std::make_pair(pEvent->eventKind, pLoc->method_id),
+                                            pEvent));
+  } else {
+    events_by_kind_[pEvent->eventKind].push_back(pEvent);
+  }
+}
+
+void JdwpState::RemoveFromEventIndex(JdwpEvent* pEvent) {
+  const JdwpLocation* pLoc = GetLocationOnly(pEvent);
+  if (pLoc != NULL) {
+    auto range = events_by_method_.equal_range(std::make_pair(pEvent->eventKind,
+                                                              pLoc->method_id));
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == pEvent) {
+        events_by_method_.erase(it);
+        return;
+      }
+    }
+    LOG(FATAL) << "Event " << pEvent->requestId << " not in the index";
+  } else {
+    auto kind_it = events_by_kind_.find(pEvent->eventKind);
+    CHECK(kind_it != events_by_kind_.end()) << pEvent->eventKind;
+    std::vector<JdwpEvent*>& events = kind_it->second;
+    auto it = std::find(events.begin(), events.end(), pEvent);
+    CHECK(it != events.end()) << pEvent->requestId;
+    events.erase(it);
+    if (events.empty()) {
+      events_by_kind_.erase(kind_it);
+    }
+  }
+}
+
 /*
  * Remove the event with the given ID from the list.
  *
@@ -472,12 +535,12 @@ static bool ModsMatch(JdwpEvent* pEvent, ModBasket* basket)
       }
       break;
     case MK_CLASS_MATCH:
-      if (!PatternMatch(pMod->classMatch.classPattern, basket->className)) {
+      if (!PatternMatch(pMod->classMatch.classPattern, GetClassName(basket))) {
         return false;
       }
       break;
     case MK_CLASS_EXCLUDE:
-      if (PatternMatch(pMod->classMatch.classPattern, basket->className)) {
+      if (PatternMatch(pMod->classMatch.classPattern, GetClassName(basket))) {
         return false;
       }
       break;
@@ -522,7 +585,9 @@ static bool ModsMatch(JdwpEvent* pEvent, ModBasket* basket)
 
 /*
  * Find all events of type "eventKind" with mods that match up with the
- * rest of the arguments.
+ * rest of the arguments.  Only the events of that kind, and for those
+ * with a LocationOnly mod only the ones in the basket's method, are
+ * checked.
  *
  * Found events are appended to "match_list", and "*pMatchCount" is advanced,
  * so this may be called multiple times for grouped events.
@@ -535,14 +600,23 @@ void JdwpState::FindMatchingEvents(JdwpEventKind eventKind, ModBasket* basket,
   /* start after the existing entries */
   match_list += *pMatchCount;
 
-  JdwpEvent* pEvent = event_list_;
-  while (pEvent != NULL) {
-    if (pEvent->eventKind == eventKind && ModsMatch(pEvent, basket)) {
-      *match_list++ = pEvent;
-      (*pMatchCount)++;
+  auto kind_it = events_by_kind_.find(eventKind);
+  if (kind_it != events_by_kind_.end()) {
+    for (JdwpEvent* pEvent : kind_it->second) {
+      if (ModsMatch(pEvent, basket)) {
+        *match_list++ = pEvent;
+        (*pMatchCount)++;
+      }
+    }
+  }
+  if (basket->pLoc != NULL) {
+    auto range = events_by_method_.equal_range(std::make_pair(eventKind, basket->pLoc->method_id));
+    for (auto it = range.first; it != range.second; ++it) {
+      if (ModsMatch(it->second, basket)) {
+        *match_list++ = it->second;
+        (*pMatchCount)++;
+      }
     }
-
-    pEvent = pEvent->next;
   }
 }
 
@@ -802,7 +876,6 @@ bool JdwpState::PostLocationEvent(const JdwpLocation* pLoc, ObjectId thisPtr, in
   basket.classId = pLoc->class_id;
   basket.thisPtr = thisPtr;
   basket.threadId = Dbg::GetThreadSelfId();
-  basket.className = Dbg::GetClassName(pLoc->class_id);
 
   /*
    * On rare occasions we may need to execute interpreted code in the VM
@@ -825,7 +898,7 @@ bool JdwpState::PostLocationEvent(const JdwpLocation* pLoc, ObjectId thisPtr, in
    * method invocation to complete.
    */
   if (InvokeInProgress()) {
-    VLOG(jdwp) << "Not checking breakpoints during invoke (" << basket.className << ")";
+    VLOG(jdwp) << "Not checking breakpoints during invoke (" << GetClassName(&basket) << ")";
     return false;
   }
 
@@ -850,7 +923,7 @@ bool JdwpState::PostLocationEvent(const JdwpLocation* pLoc, ObjectId thisPtr, in
     }
     if (match_count != 0) {
       VLOG(jdwp) << "EVENT: " << match_list[0]->eventKind << "(" << match_count << " total) "
-                 << basket.className << "." << Dbg::GetMethodName(pLoc->method_id)
+                 << GetClassName(&basket) << "." << Dbg::GetMethodName(pLoc->method_id)
                  << StringPrintf(" thread=%#" PRIx64 "  dex_pc=%#" PRIx64 ")",
                                  basket.threadId, pLoc->dex_pc);
 
@@ -888,7 +961,6 @@ bool JdwpState::PostFieldEvent(const JdwpLocation* pLoc, RefTypeId typeId, Field
   basket.classId = pLoc->class_id;
   basket.thisPtr = thisPtr;
   basket.threadId = Dbg::GetThreadSelfId();
-  basket.className = Dbg::GetClassName(pLoc->class_id);
   basket.fieldTypeID = typeId;
   basket.fieldId = fieldId;
 
@@ -926,7 +998,7 @@ bool JdwpState::PostFieldEvent(const JdwpLocation* pLoc, RefTypeId typeId, Field
     }
     if (match_count != 0) {
       VLOG(jdwp) << "EVENT: " << match_list[0]->eventKind << "(" << match_count << " total) "
-                 << basket.className << "." << Dbg::GetMethodName(pLoc->method_id)
+                 << GetClassName(&basket) << "." << Dbg::GetMethodName(pLoc->method_id)
                  << StringPrintf(" thread=%#" PRIx64 "  dex_pc=%#" PRIx64 ")",
                                  basket.threadId, pLoc->dex_pc);
 
@@ -16,6 +16,7 @@
 
 #include "object_registry.h"
 
+#include "handle_scope-inl.h"
 #include "scoped_thread_state_change.h"
 
 namespace art {
@@ -31,8 +32,7 @@ std::ostream& operator<<(std::ostream& os, const ObjectRegistryEntry& rhs) {
 }
 
 ObjectRegistry::ObjectRegistry()
-    : lock_("ObjectRegistry lock", kJdwpObjectRegistryLock), allow_new_objects_(true),
-      condition_("object registry condition", lock_), next_id_(1) {
+    : lock_("ObjectRegistry lock", kJdwpObjectRegistryLock), next_id_(1) {
 }
 
 JDWP::RefTypeId ObjectRegistry::AddRefType(mirror::Class* c) {
@@ -49,15 +49,17 @@ JDWP::ObjectId ObjectRegistry::InternalAdd(mirror::Object* o) {
   }
 
   ScopedObjectAccessUnchecked soa(Thread::Current());
+  // Computing the identity hash code may inflate the lock of the object, which must not happen
+  // while holding lock_, and which can suspend: keep the object in a handle.
+  StackHandleScope<1> hs(soa.Self());
+  Handle<mirror::Object> h_o(hs.NewHandle(o));
+  const int32_t identity_hash_code = h_o->IdentityHashCode();
+  o = h_o.Get();
+
   MutexLock mu(soa.Self(), lock_);
-  while (UNLIKELY(!allow_new_objects_)) {
-    condition_.WaitHoldingLocks(soa.Self());
-  }
-  ObjectRegistryEntry* entry;
-  auto it = object_to_entry_.find(o);
-  if (it != object_to_entry_.end()) {
+  ObjectRegistryEntry* entry = FindLocked(soa.Self(), o, identity_hash_code);
+  if (entry != nullptr) {
     // This object was already in our map.
-    entry = it->second;
     ++entry->reference_count;
   } else {
     entry = new ObjectRegistryEntry;
@@ -65,7 +67,8 @@ JDWP::ObjectId ObjectRegistry::InternalAdd(mirror::Object* o) {
     entry->jni_reference = nullptr;
     entry->reference_count = 0;
     entry->id = 0;
-    object_to_entry_.insert(std::make_pair(o, entry));
+    entry->identity_hash_code = identity_hash_code;
+    object_to_entry_.insert(std::make_pair(identity_hash_code, entry));
 
     // This object isn't in the registry yet, so add it.
     JNIEnv* env = soa.Env();
@@ -77,7 +80,7 @@ JDWP::ObjectId ObjectRegistry::InternalAdd(mirror::Object* o) {
     entry->reference_count = 1;
     entry->id = next_id_++;
 
-    id_to_entry_.Put(entry->id, entry);
+    id_to_entry_.insert(std::make_pair(entry->id, entry));
 
     env->DeleteLocalRef(local_reference);
   }
@@ -85,8 +88,35 @@ JDWP::ObjectId ObjectRegistry::InternalAdd(mirror::Object* o) {
 }
 
 bool ObjectRegistry::Contains(mirror::Object* o) {
-  MutexLock mu(Thread::Current(), lock_);
-  return object_to_entry_.find(o) != object_to_entry_.end();
+  Thread* self = Thread::Current();
+  StackHandleScope<1> hs(self);
+  Handle<mirror::Object> h_o(hs.NewHandle(o));
+  const int32_t identity_hash_code = h_o->IdentityHashCode();
+  MutexLock mu(self, lock_);
+  return FindLocked(self, h_o.Get(), identity_hash_code) != nullptr;
+}
+
+ObjectRegistryEntry* ObjectRegistry::FindLocked(Thread* self, mirror::Object* o,
+                                                int32_t identity_hash_code) {
+  auto range = object_to_entry_.equal_range(identity_hash_code);
+  for (auto it = range.first; it != range.second; ++it) {
+    ObjectRegistryEntry* entry = it->second;
+    if (self->DecodeJObject(entry->jni_reference) == o) {
+      return entry;
+    }
+  }
+  return nullptr;
+}
+
+void ObjectRegistry::RemoveFromObjectToEntryLocked(ObjectRegistryEntry* entry) {
+  auto range = object_to_entry_.equal_range(entry->identity_hash_code);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == entry) {
+      object_to_entry_.erase(it);
+      return;
+    }
+  }
+  LOG(FATAL) << "Entry not in the registry: " << *entry;
 }
 
 void ObjectRegistry::Clear() {
@@ -194,47 +224,15 @@ void ObjectRegistry::DisposeObject(JDWP::ObjectId id, uint32_t reference_count)
   entry->reference_count -= reference_count;
   if (entry->reference_count <= 0) {
     JNIEnv* env = self->GetJniEnv();
-    mirror::Object* object = self->DecodeJObject(entry->jni_reference);
     if (entry->jni_reference_type == JNIWeakGlobalRefType) {
       env->DeleteWeakGlobalRef(entry->jni_reference);
     } else {
       env->DeleteGlobalRef(entry->jni_reference);
     }
-    object_to_entry_.erase(object);
-    id_to_entry_.erase(id);
+    RemoveFromObjectToEntryLocked(entry);
+    id_to_entry_.erase(it);
     delete entry;
   }
 }
 
-void ObjectRegistry::UpdateObjectPointers(IsMarkedCallback* callback, void* arg) {
-  MutexLock mu(Thread::Current(), lock_);
-  if (object_to_entry_.empty()) {
-    return;
-  }
-  std::map<mirror::Object*, ObjectRegistryEntry*> new_object_to_entry;
-  for (auto& pair : object_to_entry_) {
-    mirror::Object* new_obj;
-    if (pair.first != nullptr) {
-      new_obj = callback(pair.first, arg);
-      if (new_obj != nullptr) {
-        new_object_to_entry.insert(std::make_pair(new_obj, pair.second));
-      }
-    }
-  }
-  object_to_entry_ = new_object_to_entry;
-}
-
-void ObjectRegistry::AllowNewObjects() {
-  Thread* self = Thread::Current();
-  MutexLock mu(self, lock_);
-  allow_new_objects_ = true;
-  condition_.Broadcast(self);
-}
-
-void ObjectRegistry::DisallowNewObjects() {
-  Thread* self = Thread::Current();
-  MutexLock mu(self, lock_);
-  allow_new_objects_ = false;
-}
-
 }  // namespace art
@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit.h"
+
+#include <dlfcn.h>
+
+#include <algorithm>
+
+#include "ScopedLocalRef.h"
+
+#include "base/stringprintf.h"
+#include "dex_file-inl.h"
+#include "instrumentation.h"
+#include "interpreter/interpreter.h"
+#include "jni_internal.h"
+#include "mapping_table.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/dex_cache.h"
+#include "oat.h"
+#include "object_utils.h"
+#include "scoped_thread_state_change.h"
+#include "stack.h"
+#include "thread.h"
+
+namespace art {
+namespace jit {
+
+// The Quick backends generating OSR entries, see Mir2Lir::GenOsrEntries.
+static constexpr bool kOsrSupported = (kRuntimeISA == kArm) || (kRuntimeISA == kX86);
+
+#if defined(__arm__) || defined(__i386__)
+extern "C" void art_quick_osr_stub(mirror::ArtMethod*, uint32_t*, uint32_t, Thread*, JValue*,
+                                   const char*, const void*);
+#endif
+
+static void InvokeOsrStub(mirror::ArtMethod* method, uint32_t* args, uint32_t args_size,
+                          Thread* self, JValue* result, const char* shorty,
+                          const void* osr_entry) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+#if defined(__arm__) || defined(__i386__)
+  art_quick_osr_stub(method, args, args_size, self, result, shorty, osr_entry);
+#else
+  LOG(FATAL) << "No on-stack replacement on " << kRuntimeISA;
+#endif
+}
+
+// Whether the handler of a catch clause of `code_item` starts at `dex_pc`. The native pcs of
+// catch handlers share the dex-to-pc mapping table with the OSR entries.
+static bool IsCatchHandler(const DexFile::CodeItem* code_item, uint32_t dex_pc) {
+  if (code_item->tries_size_ == 0) {
+    return false;
+  }
+  const byte* handlers_ptr = DexFile::GetCatchHandlerData(*code_item, 0);
+  uint32_t handlers_size = DecodeUnsignedLeb128(&handlers_ptr);
+  for (uint32_t i = 0; i < handlers_size; ++i) {
+    CatchHandlerIterator iterator(handlers_ptr);
+    for (; iterator.HasNext(); iterator.Next()) {
+      if (iterator.GetHandlerAddress() == dex_pc) {
+        return true;
+      }
+    }
+    handlers_ptr = iterator.EndDataPointer();
+  }
+  return false;
+}
+
+// Compiles a method on the JIT thread.
+class Jit::CompileTask : public Task {
+ public:
+  // Takes ownership of the global reference to the method.
+  CompileTask(Jit* jit, jobject method) : jit_(jit), method_(method) {}
+
+  void Run(Thread* self) OVERRIDE {
+    if (!jit_->CompileMethod(self, method_)) {
+      VLOG(compiler) << "JIT declined to compile a method";
+    }
+    self->GetJniEnv()->DeleteGlobalRef(method_);
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  Jit* const jit_;
+  const jobject method_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompileTask);
+};
+
+Jit* Jit::Create(uint32_t compile_threshold, std::string* error_msg) {
+  std::unique_ptr<Jit> jit(new Jit(compile_threshold));
+  if (!jit->LoadCompiler(error_msg)) {
+    return nullptr;
+  }
+  jit->code_cache_.reset(JitCodeCache::Create(JitCodeCache::kDefaultCapacity, error_msg));
+  if (jit->code_cache_.get() == nullptr) {
+    return nullptr;
+  }
+  // A single thread: compilation is in the background of the application's threads and is
+  // throttled by the compile threshold rather than by parallelism.
+  jit->thread_pool_.reset(new ThreadPool("Jit thread pool", 1));
+  jit->thread_pool_->StartWorkers(Thread::Current());
+  return jit.release();
+}
+
+Jit::Jit(uint32_t compile_threshold)
+    : compile_threshold_(compile_threshold),
+      compiler_library_handle_(nullptr),
+      jit_compiler_handle_(nullptr),
+      jit_load_(nullptr),
+      jit_unload_(nullptr),
+      jit_compile_method_(nullptr),
+      lock_("Jit samples lock") {
+}
+
+Jit::~Jit() {
+  if (thread_pool_.get() != nullptr) {
+    // Waits for the method being compiled, the queued ones are dropped.
+    thread_pool_->StopWorkers(Thread::Current());
+    thread_pool_.reset();
+  }
+  if (jit_compiler_handle_ != nullptr) {
+    jit_unload_(jit_compiler_handle_);
+  }
+  if (compiler_library_handle_ != nullptr) {
+    dlclose(compiler_library_handle_);
+  }
+}
+
+bool Jit::LoadCompiler(std::string* error_msg) {
+  const char* library_name = kIsDebugBuild ? "libartd-compiler.so" : "libart-compiler.so";
+  compiler_library_handle_ = dlopen(library_name, RTLD_NOW);
+  if (compiler_library_handle_ == nullptr) {
+    *error_msg = StringPrintf("Failed to load %s: %s", library_name, dlerror());
+    return false;
+  }
+  jit_load_ = reinterpret_cast<void* (*)()>(dlsym(compiler_library_handle_, "jit_load"));
+  jit_unload_ = reinterpret_cast<void (*)(void*)>(dlsym(compiler_library_handle_, "jit_unload"));
+  jit_compile_method_ = reinterpret_cast<bool (*)(void*, jobject, Thread*)>(
+      dlsym(compiler_library_handle_, "jit_compile_method"));
+  if (jit_load_ == nullptr || jit_unload_ == nullptr || jit_compile_method_ == nullptr) {
+    *error_msg = StringPrintf("%s has no JIT entry points", library_name);
+    return false;
+  }
+  jit_compiler_handle_ = jit_load_();
+  if (jit_compiler_handle_ == nullptr) {
+    *error_msg = "Failed to create the JIT compiler";
+    return false;
+  }
+  return true;
+}
+
+bool Jit::CountSamples(const MethodReference& ref, uint32_t count, bool may_request) {
+  auto it = samples_.find(ref);
+  if (it == samples_.end()) {
+    samples_.Put(ref, 0u);
+    it = samples_.find(ref);
+  } else if (it->second == kCompileRequested) {
+    return false;
+  }
+  it->second = std::min(it->second + count, compile_threshold_);
+  if (it->second < compile_threshold_ || !may_request) {
+    return false;
+  }
+  it->second = kCompileRequested;
+  return true;
+}
+
+void Jit::AddMethodEntrySample(Thread* self, mirror::ArtMethod* method) {
+  JitSampleBuffer* buffer = self->GetJitSampleBuffer();
+  if (UNLIKELY(buffer == nullptr)) {
+    buffer = new JitSampleBuffer();
+    self->SetJitSampleBuffer(buffer);
+  }
+  const DexFile* dex_file = method->GetDeclaringClass()->GetDexCache()->GetDexFile();
+  uint32_t method_idx = method->GetDexMethodIndex();
+  JitSampleBuffer::Entry* entry = &buffer->entries[method_idx % JitSampleBuffer::kSize];
+  if (UNLIKELY(entry->dex_file != dex_file || entry->method_idx != method_idx)) {
+    if (entry->count != 0) {
+      // The buffer has no ArtMethod to queue, the evicted method is queued by its next samples.
+      MutexLock mu(self, lock_);
+      CountSamples(MethodReference(entry->dex_file, entry->method_idx), entry->count, false);
+    }
+    entry->dex_file = dex_file;
+    entry->method_idx = method_idx;
+    entry->count = 0;
+  }
+  if (++entry->count == kMethodEntryBatch) {
+    entry->count = 0;
+    AddSamples(self, method, kMethodEntryBatch);
+  }
+}
+
+void Jit::AddSamples(Thread* self, mirror::ArtMethod* method, uint32_t count) {
+  MethodReference ref(method->GetDeclaringClass()->GetDexCache()->GetDexFile(),
+                      method->GetDexMethodIndex());
+  {
+    MutexLock mu(self, lock_);
+    if (!CountSamples(ref, count, true)) {
+      return;
+    }
+  }
+  ScopedObjectAccessUnchecked soa(self);
+  ScopedLocalRef<jobject> local_method(soa.Env(), soa.AddLocalReference<jobject>(method));
+  jobject global_method = soa.Env()->NewGlobalRef(local_method.get());
+  thread_pool_->AddTask(self, new CompileTask(this, global_method));
+}
+
+bool Jit::MaybeDoOnStackReplacement(Thread* self, ShadowFrame* shadow_frame, uint32_t dex_pc,
+                                    JValue* result) {
+  if (!kOsrSupported) {
+    return false;
+  }
+  // Debuggers and other instrumentation want the frame to keep running in the interpreter.
+  instrumentation::Instrumentation* instrumentation = Runtime::Current()->GetInstrumentation();
+  if (instrumentation->InterpretOnly() || instrumentation->AreExitStubsInstalled() ||
+      instrumentation->IsActive()) {
+    return false;
+  }
+  mirror::ArtMethod* method = shadow_frame->GetMethod();
+  const void* entry_point = code_cache_->GetCodeFor(method);
+  if (entry_point == nullptr) {
+    return false;
+  }
+  MethodHelper mh(method);
+  const DexFile::CodeItem* code_item = mh.GetCodeItem();
+  if (IsCatchHandler(code_item, dex_pc)) {
+    return false;
+  }
+  const void* code_pointer = mirror::ArtMethod::EntryPointToCodePointer(entry_point);
+  uint32_t mapping_table_offset =
+      reinterpret_cast<const OatQuickMethodHeader*>(code_pointer)[-1].mapping_table_offset_;
+  if (mapping_table_offset == 0u) {
+    return false;
+  }
+  MappingTable table(reinterpret_cast<const uint8_t*>(code_pointer) - mapping_table_offset);
+  const void* osr_entry = nullptr;
+  for (auto it = table.DexToPcBegin(), end = table.DexToPcEnd(); it != end; ++it) {
+    if (it.DexPc() == dex_pc) {
+      osr_entry = reinterpret_cast<const uint8_t*>(entry_point) + it.NativePcOffset();
+      break;
+    }
+  }
+  if (osr_entry == nullptr) {
+    return false;
+  }
+  VLOG(compiler) << "On-stack replacement of " << PrettyMethod(method) << " at dex pc 0x"
+                 << std::hex << dex_pc;
+
+  // The ins are passed as the arguments of a call, the OSR entry reads the locals from the
+  // thread. Nothing can suspend the thread until the entry has read them.
+  const size_t num_ins = code_item->ins_size_;
+  const size_t num_locals = code_item->registers_size_ - num_ins;
+  std::unique_ptr<uint32_t[]> vregs(new uint32_t[code_item->registers_size_]);
+  for (size_t i = 0; i < code_item->registers_size_; ++i) {
+    vregs[i] = shadow_frame->GetVReg(i);
+  }
+  self->SetOsrLocals(vregs.get());
+
+  // The compiled frame replaces the interpreted one, which is pushed back for the interpreter to
+  // pop once the method has returned.
+  ShadowFrame* popped_frame = self->PopShadowFrame();
+  DCHECK_EQ(popped_frame, shadow_frame);
+  ManagedStack fragment;
+  self->PushManagedStackFragment(&fragment);
+  InvokeOsrStub(method, vregs.get() + num_locals, num_ins * sizeof(uint32_t), self, result,
+                mh.GetShorty(), osr_entry);
+  if (UNLIKELY(self->GetException(nullptr) == Thread::GetDeoptimizationException())) {
+    // As in ArtMethod::Invoke, the debugger wants the rest of the method interpreted.
+    self->ClearException();
+    ShadowFrame* deoptimized_frame = self->GetAndClearDeoptimizationShadowFrame(result);
+    self->SetTopOfStack(nullptr, 0);
+    self->SetTopOfShadowStack(deoptimized_frame);
+    interpreter::EnterInterpreterFromDeoptimize(self, deoptimized_frame, result);
+  }
+  self->PopManagedStackFragment(fragment);
+  self->PushShadowFrame(shadow_frame);
+  self->SetOsrLocals(nullptr);
+  return true;
+}
+
+bool Jit::CompileMethod(Thread* self, jobject method) {
+  return jit_compile_method_(jit_compiler_handle_, method, self);
+}
+
+}  // namespace jit
+}  // namespace art
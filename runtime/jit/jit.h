@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_JIT_H_
+#define ART_RUNTIME_JIT_JIT_H_
+
+#include <jni.h>
+
+#include <memory>
+#include <string>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "jit_code_cache.h"
+#include "method_reference.h"
+#include "safe_map.h"
+#include "thread_pool.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+}  // namespace mirror
+class DexFile;
+class ShadowFrame;
+class Thread;
+union JValue;
+
+namespace jit {
+
+// The method entries a thread interpreted and has not reported to the Jit yet, by method, in a
+// direct-mapped cache. Only the thread uses its buffer.
+struct JitSampleBuffer {
+  struct Entry {
+    const DexFile* dex_file;
+    uint32_t method_idx;
+    uint32_t count;
+  };
+
+  static constexpr size_t kSize = 64;
+  Entry entries[kSize];
+};
+
+// Compiles the methods the interpreter spends the most time in, on a background thread, with the
+// Quick compiler loaded from the compiler library. The interpreter counts the invocations and
+// taken backward branches of each method; once they reach the compile threshold the method is
+// compiled and its entry points switched to the compiled code, which runs from the next call on.
+// Frames already running a loop of the method move into the compiled code by on-stack
+// replacement, on ISAs with an OSR stub.
+class Jit {
+ public:
+  static constexpr uint32_t kDefaultCompileThreshold = 10000;
+
+  // Returns null, and sets error_msg, if the compiler library or the code cache can't be set up.
+  static Jit* Create(uint32_t compile_threshold, std::string* error_msg)
+      LOCKS_EXCLUDED(Locks::mutator_lock_);
+
+  ~Jit();
+
+  // Number of interpreted entries of a method a thread counts before reporting them.
+  static constexpr uint32_t kMethodEntryBatch = 16;
+
+  // Counts `count` invocations or taken backward branches of `method`, interpreted by `self`,
+  // and queues the method for compilation when they reach the compile threshold. Takes lock_, the
+  // interpreter calls it once per batch of samples.
+  void AddSamples(Thread* self, mirror::ArtMethod* method, uint32_t count)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  // Counts an invocation of `method` interpreted by `self` in the JitSampleBuffer of the thread,
+  // and reports the invocations to AddSamples by batches of kMethodEntryBatch.
+  void AddMethodEntrySample(Thread* self, mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  // Moves `shadow_frame`, which is about to run the loop header at `dex_pc`, into the compiled
+  // code of its method, if that code has an OSR entry for the loop header. Returns true if it did,
+  // once the method has returned or thrown, with its result in `result`.
+  bool MaybeDoOnStackReplacement(Thread* self, ShadowFrame* shadow_frame, uint32_t dex_pc,
+                                 JValue* result)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  JitCodeCache* GetCodeCache() {
+    return code_cache_.get();
+  }
+
+  uint32_t GetCompileThreshold() const {
+    return compile_threshold_;
+  }
+
+ private:
+  class CompileTask;
+
+  // Samples of a method already queued for compilation.
+  static constexpr uint32_t kCompileRequested = 0xFFFFFFFFu;
+
+  explicit Jit(uint32_t compile_threshold);
+
+  bool LoadCompiler(std::string* error_msg);
+
+  // Adds `count` samples to the method `ref`. Returns true if the caller is to queue the method for
+  // compilation, which only happens if `may_request`; otherwise the samples stop at the compile
+  // threshold, and the method is queued by its next samples.
+  bool CountSamples(const MethodReference& ref, uint32_t count, bool may_request)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Called by the compile thread, in the native state.
+  bool CompileMethod(Thread* self, jobject method) LOCKS_EXCLUDED(Locks::mutator_lock_);
+
+  const uint32_t compile_threshold_;
+
+  // Handle of the compiler library, the compiler it created and its entry points.
+  void* compiler_library_handle_;
+  void* jit_compiler_handle_;
+  void* (*jit_load_)();
+  void (*jit_unload_)(void*);
+  bool (*jit_compile_method_)(void*, jobject, Thread*);
+
+  std::unique_ptr<JitCodeCache> code_cache_;
+  std::unique_ptr<ThreadPool> thread_pool_;
+
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  // Samples of the methods interpreted so far. Methods are identified by their dex file and
+  // index, which, unlike the ArtMethod objects, don't move.
+  SafeMap<MethodReference, uint32_t, MethodReferenceComparator> samples_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(Jit);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_JIT_H_
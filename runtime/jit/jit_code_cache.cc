@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_code_cache.h"
+
+#include <string.h>
+#include <sys/mman.h>
+
+#include "instruction_set.h"
+#include "mirror/art_method-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/dex_cache.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+namespace jit {
+
+JitCodeCache* JitCodeCache::Create(size_t capacity, std::string* error_msg) {
+  CHECK_GT(capacity, 0U);
+  MemMap* mem_map = MemMap::MapAnonymous("jit-code-cache", nullptr, capacity,
+                                         PROT_READ | PROT_WRITE | PROT_EXEC, false, error_msg);
+  if (mem_map == nullptr) {
+    return nullptr;
+  }
+  return new JitCodeCache(mem_map);
+}
+
+JitCodeCache::JitCodeCache(MemMap* mem_map)
+    : lock_("Jit code cache lock"), mem_map_(mem_map), top_(mem_map->Begin()) {
+}
+
+uint8_t* JitCodeCache::CommitData(Thread* self, const std::vector<uint8_t>& data) {
+  DCHECK(!data.empty());
+  uint8_t* result;
+  {
+    MutexLock mu(self, lock_);
+    const size_t alignment = GetInstructionSetAlignment(kRuntimeISA);
+    uint8_t* begin = reinterpret_cast<uint8_t*>(RoundUp(reinterpret_cast<uintptr_t>(top_),
+                                                        alignment));
+    if (begin + data.size() > mem_map_->End()) {
+      return nullptr;
+    }
+    top_ = begin + data.size();
+    result = begin;
+  }
+  // The copy is not visible to other threads until an entry point refers to it.
+  memcpy(result, &data[0], data.size());
+  // Flush instruction cache
+  // Only uses __builtin___clear_cache if GCC >= 4.3.3
+#if GCC_VERSION >= 40303
+  __builtin___clear_cache(reinterpret_cast<void*>(result),
+                          reinterpret_cast<void*>(result + data.size()));
+#else
+  LOG(WARNING) << "UNIMPLEMENTED: cache flush";
+#endif
+  return result;
+}
+
+void JitCodeCache::SaveCompiledCode(Thread* self, mirror::ArtMethod* method,
+                                    const void* entry_point) {
+  DCHECK(ContainsCodePointer(entry_point));
+  MethodReference ref(method->GetDeclaringClass()->GetDexCache()->GetDexFile(),
+                      method->GetDexMethodIndex());
+  MutexLock mu(self, lock_);
+  entry_points_.Overwrite(ref, entry_point);
+}
+
+const void* JitCodeCache::GetCodeFor(mirror::ArtMethod* method) {
+  MethodReference ref(method->GetDeclaringClass()->GetDexCache()->GetDexFile(),
+                      method->GetDexMethodIndex());
+  MutexLock mu(Thread::Current(), lock_);
+  auto it = entry_points_.find(ref);
+  return (it != entry_points_.end()) ? it->second : nullptr;
+}
+
+size_t JitCodeCache::CodeCacheSize() {
+  MutexLock mu(Thread::Current(), lock_);
+  return top_ - mem_map_->Begin();
+}
+
+size_t JitCodeCache::NumberOfCompiledCode() {
+  MutexLock mu(Thread::Current(), lock_);
+  return entry_points_.size();
+}
+
+}  // namespace jit
+}  // namespace art
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_JIT_CODE_CACHE_H_
+#define ART_RUNTIME_JIT_JIT_CODE_CACHE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "globals.h"
+#include "mem_map.h"
+#include "method_reference.h"
+#include "safe_map.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+}  // namespace mirror
+class Thread;
+
+namespace jit {
+
+// Executable memory holding the code compiled by the JIT. Each method's code is preceded by its
+// tables and OatQuickMethodHeader, as in an oat file, so that stack walks find them the same way.
+// The cache only grows: compiled code is never freed, as nothing tells when a method can't be on
+// a stack anymore.
+class JitCodeCache {
+ public:
+  static constexpr size_t kDefaultCapacity = 16 * MB;
+
+  // Returns null, and sets error_msg, if the memory can't be mapped.
+  static JitCodeCache* Create(size_t capacity, std::string* error_msg);
+
+  // Copies `data` into the cache, at an address aligned for the code of the runtime instruction
+  // set, and flushes it to the instruction cache. Returns the copy, or null if the cache is full.
+  uint8_t* CommitData(Thread* self, const std::vector<uint8_t>& data) LOCKS_EXCLUDED(lock_);
+
+  // Records `entry_point`, in the cache, as the compiled code of `method`.
+  void SaveCompiledCode(Thread* self, mirror::ArtMethod* method, const void* entry_point)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  // Returns the entry point of the compiled code of `method`, or null if it wasn't compiled.
+  const void* GetCodeFor(mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) LOCKS_EXCLUDED(lock_);
+
+  bool ContainsCodePointer(const void* ptr) const {
+    return ptr >= mem_map_->Begin() && ptr < mem_map_->End();
+  }
+
+  size_t CodeCacheSize() LOCKS_EXCLUDED(lock_);
+  size_t NumberOfCompiledCode() LOCKS_EXCLUDED(lock_);
+
+ private:
+  explicit JitCodeCache(MemMap* mem_map);
+
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::unique_ptr<MemMap> mem_map_;
+  // The next free byte of the cache.
+  uint8_t* top_ GUARDED_BY(lock_);
+  SafeMap<MethodReference, const void*, MethodReferenceComparator> entry_points_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(JitCodeCache);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_JIT_CODE_CACHE_H_
@@ -43,6 +43,7 @@
 #include "mirror/throwable.h"
 #include "object_utils.h"
 #include "parsed_options.h"
+#include "read_barrier.h"
 #include "reflection.h"
 #include "runtime.h"
 #include "safe_map.h"
@@ -297,6 +298,7 @@ int ThrowNewException(JNIEnv* env, jclass exception_class, const char* msg, jobj
     return JNI_ERR;
   }
   ScopedObjectAccess soa(env);
+  ++soa.Self()->GetCounters()->exceptions_thrown;
   ThrowLocation throw_location = soa.Self()->GetCurrentLocationForThrow();
   soa.Self()->SetException(throw_location, soa.Decode<mirror::Throwable*>(exception.get()));
   return JNI_OK;
@@ -654,6 +656,7 @@ class JNI {
     if (exception == nullptr) {
       return JNI_ERR;
     }
+    ++soa.Self()->GetCounters()->exceptions_thrown;
     ThrowLocation throw_location = soa.Self()->GetCurrentLocationForThrow();
     soa.Self()->SetException(throw_location, exception);
     return JNI_OK;
@@ -751,11 +754,7 @@ class JNI {
     if (decoded_obj == nullptr) {
       return nullptr;
     }
-    JavaVMExt* vm = soa.Vm();
-    IndirectReferenceTable& globals = vm->globals;
-    WriterMutexLock mu(soa.Self(), vm->globals_lock);
-    IndirectRef ref = globals.Add(IRT_FIRST_SEGMENT, decoded_obj);
-    return reinterpret_cast<jobject>(ref);
+    return soa.Vm()->AddGlobalReference(soa.Self(), decoded_obj);
   }
 
   static void DeleteGlobalRef(JNIEnv* env, jobject obj) {
@@ -763,14 +762,8 @@ class JNI {
       return;
     }
     JavaVMExt* vm = reinterpret_cast<JNIEnvExt*>(env)->vm;
-    IndirectReferenceTable& globals = vm->globals;
     Thread* self = reinterpret_cast<JNIEnvExt*>(env)->self;
-    WriterMutexLock mu(self, vm->globals_lock);
-
-    if (!globals.Remove(IRT_FIRST_SEGMENT, obj)) {
-      LOG(WARNING) << "JNI WARNING: DeleteGlobalRef(" << obj << ") "
-                   << "failed to find entry";
-    }
+    vm->DeleteGlobalRef(self, obj);
   }
 
   static jweak NewWeakGlobalRef(JNIEnv* env, jobject obj) {
@@ -2863,6 +2856,7 @@ JNIEnvExt::JNIEnvExt(Thread* self, JavaVMExt* vm)
       local_ref_cookie(IRT_FIRST_SEGMENT),
       locals(kLocalsInitial, kLocalsMax, kLocal),
       check_jni(false),
+      check_jni_calls_until_sample(0),
       critical(0),
       monitors("monitors", kMonitorsInitial, kMonitorsMax) {
   functions = unchecked_functions = &gJniNativeInterface;
@@ -3027,11 +3021,10 @@ JavaVMExt::JavaVMExt(Runtime* runtime, ParsedOptions* options)
       check_jni_abort_hook_data(nullptr),
       check_jni(false),
       force_copy(false),  // TODO: add a way to enable this
+      check_jni_sampling_interval(options->check_jni_sampling_interval_),
       trace(options->jni_trace_),
       pins_lock("JNI pin table lock", kPinTableLock),
       pin_table("pin table", kPinTableInitial, kPinTableMax),
-      globals_lock("JNI global reference table lock"),
-      globals(gGlobalsInitial, gGlobalsMax, kGlobal),
       libraries_lock("JNI shared libraries map lock", kLoadLibraryLock),
       libraries(new Libraries),
       weak_globals_lock_("JNI weak global reference table lock"),
@@ -3042,12 +3035,51 @@ JavaVMExt::JavaVMExt(Runtime* runtime, ParsedOptions* options)
   if (options->check_jni_) {
     SetCheckJniEnabled(true);
   }
+  for (uint32_t i = 0; i < IndirectReferenceTable::kMaxShards; ++i) {
+    globals_[i].reset(new GlobalsShard(i));
+  }
 }
 
 JavaVMExt::~JavaVMExt() {
   delete libraries;
 }
 
+JavaVMExt::GlobalsShard::GlobalsShard(uint32_t shard)
+    : lock("JNI global reference table lock"),
+      table(gGlobalsInitial / IndirectReferenceTable::kMaxShards,
+            gGlobalsMax / IndirectReferenceTable::kMaxShards, kGlobal, shard) {
+}
+
+jobject JavaVMExt::AddGlobalReference(Thread* self, mirror::Object* obj) {
+  const uint32_t num_shards = IndirectReferenceTable::kMaxShards;
+  uint32_t home = self->GetThreadId() % num_shards;
+  // Fall back on the other shards when the one of the thread is full, and let the table of
+  // the thread report the overflow when they all are.
+  for (uint32_t i = 0; i < num_shards; ++i) {
+    GlobalsShard* shard = globals_[(home + i) % num_shards].get();
+    WriterMutexLock mu(self, shard->lock);
+    if (!shard->table.IsFull() || i == num_shards - 1) {
+      return reinterpret_cast<jobject>(shard->table.Add(IRT_FIRST_SEGMENT, obj));
+    }
+  }
+  LOG(FATAL) << "Unreachable";
+  return nullptr;
+}
+
+void JavaVMExt::DeleteGlobalRef(Thread* self, jobject obj) {
+  GlobalsShard* shard = globals_[IndirectReferenceTable::ExtractShard(obj)].get();
+  WriterMutexLock mu(self, shard->lock);
+  if (!shard->table.Remove(IRT_FIRST_SEGMENT, obj)) {
+    LOG(WARNING) << "JNI WARNING: DeleteGlobalRef(" << obj << ") "
+                 << "failed to find entry";
+  }
+}
+
+mirror::Object* JavaVMExt::DecodeGlobal(Thread* self, IndirectRef ref) {
+  GlobalsShard* shard = globals_[IndirectReferenceTable::ExtractShard(ref)].get();
+  return shard->table.SynchronizedGet(self, &shard->lock, ref);
+}
+
 jweak JavaVMExt::AddWeakGlobalReference(Thread* self, mirror::Object* obj) {
   if (obj == nullptr) {
     return nullptr;
@@ -3083,10 +3115,12 @@ void JavaVMExt::DumpForSigQuit(std::ostream& os) {
     MutexLock mu(self, pins_lock);
     os << "; pins=" << pin_table.Size();
   }
-  {
-    ReaderMutexLock mu(self, globals_lock);
-    os << "; globals=" << globals.Capacity();
+  size_t num_globals = 0;
+  for (const std::unique_ptr<GlobalsShard>& shard : globals_) {
+    ReaderMutexLock mu(self, shard->lock);
+    num_globals += shard->table.Capacity();
   }
+  os << "; globals=" << num_globals;
   {
     MutexLock mu(self, weak_globals_lock_);
     if (weak_globals_.Capacity() > 0) {
@@ -3118,14 +3152,15 @@ mirror::Object* JavaVMExt::DecodeWeakGlobal(Thread* self, IndirectRef ref) {
   while (UNLIKELY(!allow_new_weak_globals_)) {
     weak_globals_add_condition_.WaitHoldingLocks(self);
   }
-  return weak_globals_.Get(ref);
+  mirror::Object* obj = weak_globals_.Get(ref);
+  return obj != kClearedJniWeakGlobal ? ReadBarrier::BarrierForWeakRoot(obj) : obj;
 }
 
 void JavaVMExt::DumpReferenceTables(std::ostream& os) {
   Thread* self = Thread::Current();
-  {
-    ReaderMutexLock mu(self, globals_lock);
-    globals.Dump(os);
+  for (const std::unique_ptr<GlobalsShard>& shard : globals_) {
+    ReaderMutexLock mu(self, shard->lock);
+    shard->table.Dump(os);
   }
   {
     MutexLock mu(self, weak_globals_lock_);
@@ -3309,9 +3344,9 @@ void JavaVMExt::SweepJniWeakGlobals(IsMarkedCallback* callback, void* arg) {
 
 void JavaVMExt::VisitRoots(RootCallback* callback, void* arg) {
   Thread* self = Thread::Current();
-  {
-    ReaderMutexLock mu(self, globals_lock);
-    globals.VisitRoots(callback, arg, 0, kRootJNIGlobal);
+  for (const std::unique_ptr<GlobalsShard>& shard : globals_) {
+    ReaderMutexLock mu(self, shard->lock);
+    shard->table.VisitRoots(callback, arg, 0, kRootJNIGlobal);
   }
   {
     MutexLock mu(self, pins_lock);
@@ -87,6 +87,12 @@ class JavaVMExt : public JavaVM {
 
   void VisitRoots(RootCallback* callback, void* arg);
 
+  jobject AddGlobalReference(Thread* self, mirror::Object* obj)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void DeleteGlobalRef(Thread* self, jobject obj);
+  mirror::Object* DecodeGlobal(Thread* self, IndirectRef ref)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   void DisallowNewWeakGlobals() EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
   void AllowNewWeakGlobals() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   jweak AddWeakGlobalReference(Thread* self, mirror::Object* obj)
@@ -107,6 +113,10 @@ class JavaVMExt : public JavaVM {
   bool check_jni;
   bool force_copy;
 
+  // With -Xcheck:jni, the arguments of only one JNIEnv call in this many are checked. The cheap
+  // checks, such as the thread and the pending exception checks, are done on every call.
+  uint32_t check_jni_sampling_interval;
+
   // Extra diagnostics.
   std::string trace;
 
@@ -114,11 +124,6 @@ class JavaVMExt : public JavaVM {
   Mutex pins_lock DEFAULT_MUTEX_ACQUIRED_AFTER;
   ReferenceTable pin_table GUARDED_BY(pins_lock);
 
-  // JNI global references.
-  ReaderWriterMutex globals_lock DEFAULT_MUTEX_ACQUIRED_AFTER;
-  // Not guarded by globals_lock since we sometimes use SynchronizedGet in Thread::DecodeJObject.
-  IndirectReferenceTable globals;
-
   Mutex libraries_lock DEFAULT_MUTEX_ACQUIRED_AFTER;
   Libraries* libraries GUARDED_BY(libraries_lock);
 
@@ -127,6 +132,18 @@ class JavaVMExt : public JavaVM {
 
  private:
   // TODO: Make the other members of this class also private.
+  // JNI global references, spread over tables each with its own lock so that threads adding
+  // and deleting global references at the same time mostly don't contend. A thread adds to the
+  // shard of its thread id unless it's full, the shard of a reference is encoded in it.
+  struct GlobalsShard {
+    explicit GlobalsShard(uint32_t shard);
+
+    ReaderWriterMutex lock DEFAULT_MUTEX_ACQUIRED_AFTER;
+    // Not guarded by the lock as global references are decoded without it.
+    IndirectReferenceTable table;
+  };
+  std::unique_ptr<GlobalsShard> globals_[IndirectReferenceTable::kMaxShards];
+
   // JNI weak global references.
   Mutex weak_globals_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   IndirectReferenceTable weak_globals_ GUARDED_BY(weak_globals_lock_);
@@ -180,6 +197,9 @@ struct JNIEnvExt : public JNIEnv {
   // Frequently-accessed fields cached from JavaVM.
   bool check_jni;
 
+  // Number of JNIEnv calls before -Xcheck:jni next checks the arguments of a call.
+  uint32_t check_jni_calls_until_sample;
+
   // How many nested "critical" JNI calls are we in?
   int critical;
 
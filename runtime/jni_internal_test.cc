@@ -1557,6 +1557,29 @@ TEST_F(JniInternalTest, MonitorEnterExit) {
   }
 }
 
+TEST_F(JniInternalTest, CheckJniSampling) {
+  JNIEnvExt* env = reinterpret_cast<JNIEnvExt*>(env_);
+  uint32_t old_sampling_interval = vm_->check_jni_sampling_interval;
+  vm_->check_jni_sampling_interval = 100;
+  env->check_jni_calls_until_sample = 0;
+  {
+    CheckJniAbortCatcher check_jni_abort_catcher;
+    // The sampled call checks its arguments.
+    env_->GetArrayLength(nullptr);
+    check_jni_abort_catcher.Check("jarray was NULL");
+    EXPECT_EQ(99U, env->check_jni_calls_until_sample);
+
+    // The calls which aren't sampled still check for a pending exception.
+    env_->ThrowNew(aioobe_, "hello world");
+    env_->FindClass("java/lang/Object");
+    check_jni_abort_catcher.Check("called with pending exception");
+    EXPECT_EQ(97U, env->check_jni_calls_until_sample);
+    env_->ExceptionClear();
+  }
+  vm_->check_jni_sampling_interval = old_sampling_interval;
+  env->check_jni_calls_until_sample = 0;
+}
+
 TEST_F(JniInternalTest, DetachCurrentThread) {
   CleanUpJniEnv();  // cleanup now so TearDown won't have junk from wrong JNIEnv
   jint ok = vm_->DetachCurrentThread();
@@ -17,6 +17,8 @@
 #ifndef ART_RUNTIME_LEB128_H_
 #define ART_RUNTIME_LEB128_H_
 
+#include <string.h>
+
 #include "globals.h"
 #include "utils.h"
 
@@ -94,6 +96,60 @@ static inline int32_t DecodeSignedLeb128(const uint8_t** data) {
   return result;
 }
 
+// Loads the 8 bytes at data, and returns the bits of the LEB128 value they start with, the 7-bit
+// groups put together, and its length in bytes. The value ends at the first byte without the
+// continuation bit, or at the fifth byte whatever its continuation bit.
+static inline uint64_t LoadLeb128Word(const uint8_t* data, size_t* length) {
+  uint64_t word;
+  memcpy(&word, data, sizeof(word));  // All our targets are little-endian.
+  uint64_t ends = (~word & UINT64_C(0x80808080)) | UINT64_C(0x8000000000);
+  int end_bit = CTZ(ends);
+  *length = (end_bit >> 3) + 1;
+  word &= (UINT64_C(2) << end_bit) - 1;
+  return (word & 0x7f) |
+      ((word >> 1) & 0x3f80) |
+      ((word >> 2) & 0x1fc000) |
+      ((word >> 3) & 0xfe00000) |
+      ((word >> 4) & UINT64_C(0xff0000000));
+}
+
+// Like DecodeUnsignedLeb128(), but decodes the value with a single load instead of a load and a
+// branch per byte. The 8 bytes at *data must be readable, even if the value is shorter.
+static inline uint32_t DecodeUnsignedLeb128Word(const uint8_t** data) {
+  size_t length;
+  uint32_t result = static_cast<uint32_t>(LoadLeb128Word(*data, &length));
+  *data += length;
+  return result;
+}
+
+// Like DecodeSignedLeb128(), but decodes the value with a single load instead of a load and a
+// branch per byte. The 8 bytes at *data must be readable, even if the value is shorter.
+static inline int32_t DecodeSignedLeb128Word(const uint8_t** data) {
+  size_t length;
+  uint32_t bits = static_cast<uint32_t>(LoadLeb128Word(*data, &length));
+  *data += length;
+  if (length == 5) {
+    return static_cast<int32_t>(bits);
+  }
+  int shift = 32 - 7 * length;
+  return static_cast<int32_t>(bits << shift) >> shift;
+}
+
+// Decodes count unsigned LEB128 values from data, which holds them before end, into values.
+// Returns the position just past the last value. Uses DecodeUnsignedLeb128Word() while 8 bytes
+// remain before end.
+static inline const uint8_t* DecodeUnsignedLeb128Batch(const uint8_t* data, const uint8_t* end,
+                                                       uint32_t* values, size_t count) {
+  size_t i = 0;
+  for (; i != count && end - data >= 8; ++i) {
+    values[i] = DecodeUnsignedLeb128Word(&data);
+  }
+  for (; i != count; ++i) {
+    values[i] = DecodeUnsignedLeb128(&data);
+  }
+  return data;
+}
+
 // Returns the number of bytes needed to encode the value in unsigned LEB128.
 static inline uint32_t UnsignedLeb128Size(uint32_t data) {
   // bits_to_encode = (data != 0) ? 32 - CLZ(x) : 1  // 32 - CLZ(data | 1)
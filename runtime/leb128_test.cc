@@ -252,6 +252,45 @@ TEST(Leb128Test, SignedStream) {
   EXPECT_EQ(data_size, static_cast<size_t>(encoded_data_ptr - encoded_data));
 }
 
+TEST(Leb128Test, UnsignedWord) {
+  for (size_t i = 0; i < arraysize(uleb128_tests); ++i) {
+    // Garbage after the value must not change the result.
+    uint8_t data[8];
+    memset(data, 0xFF, sizeof(data));
+    memcpy(data, uleb128_tests[i].leb128_data, UnsignedLeb128Size(uleb128_tests[i].decoded));
+    const uint8_t* data_ptr = data;
+    EXPECT_EQ(DecodeUnsignedLeb128Word(&data_ptr), uleb128_tests[i].decoded) << " i = " << i;
+    EXPECT_EQ(UnsignedLeb128Size(uleb128_tests[i].decoded),
+              static_cast<size_t>(data_ptr - data)) << " i = " << i;
+  }
+}
+
+TEST(Leb128Test, SignedWord) {
+  for (size_t i = 0; i < arraysize(sleb128_tests); ++i) {
+    uint8_t data[8];
+    memset(data, 0xFF, sizeof(data));
+    memcpy(data, sleb128_tests[i].leb128_data, SignedLeb128Size(sleb128_tests[i].decoded));
+    const uint8_t* data_ptr = data;
+    EXPECT_EQ(DecodeSignedLeb128Word(&data_ptr), sleb128_tests[i].decoded) << " i = " << i;
+    EXPECT_EQ(SignedLeb128Size(sleb128_tests[i].decoded),
+              static_cast<size_t>(data_ptr - data)) << " i = " << i;
+  }
+}
+
+TEST(Leb128Test, UnsignedBatch) {
+  uint8_t encoded_data[5 * arraysize(uleb128_tests)];
+  uint8_t* end = encoded_data;
+  for (size_t i = 0; i < arraysize(uleb128_tests); ++i) {
+    end = EncodeUnsignedLeb128(end, uleb128_tests[i].decoded);
+  }
+  // The values near the end can't be decoded a word at a time.
+  uint32_t values[arraysize(uleb128_tests)];
+  EXPECT_EQ(end, DecodeUnsignedLeb128Batch(encoded_data, end, values, arraysize(values)));
+  for (size_t i = 0; i < arraysize(uleb128_tests); ++i) {
+    EXPECT_EQ(uleb128_tests[i].decoded, values[i]) << " i = " << i;
+  }
+}
+
 TEST(Leb128Test, Speed) {
   std::unique_ptr<Histogram<uint64_t>> enc_hist(new Histogram<uint64_t>("Leb128EncodeSpeedTest", 5));
   std::unique_ptr<Histogram<uint64_t>> dec_hist(new Histogram<uint64_t>("Leb128DecodeSpeedTest", 5));
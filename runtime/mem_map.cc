@@ -18,6 +18,8 @@
 
 #include <inttypes.h>
 #include <backtrace/BacktraceMap.h>
+#include <pthread.h>
+#include <map>
 #include <memory>
 
 // See CreateStartPos below.
@@ -107,6 +109,115 @@ static uintptr_t GenerateNextMemPos() {
 
 // Initialize linear scan to random position.
 uintptr_t MemMap::next_mem_pos_ = GenerateNextMemPos();
+
+// The free ranges of the low 4GB, from their begin to their end. They are built from the process
+// maps on the first low_4gb reservation, then kept up to date by the maps made and released
+// through MemMap. A range mapped by someone else since is found when mmap doesn't return the
+// address it is hinted, and the ranges are then rebuilt. Pointers and a static mutex initializer,
+// so that no dynamic initializer is needed.
+static std::map<uintptr_t, uintptr_t>* gLowMemFreeRanges = nullptr;
+static pthread_mutex_t gLowMemFreeRangesLock = PTHREAD_MUTEX_INITIALIZER;
+
+class ScopedLowMemFreeRangesLock {
+ public:
+  ScopedLowMemFreeRangesLock() {
+    CHECK_EQ(pthread_mutex_lock(&gLowMemFreeRangesLock), 0);
+  }
+  ~ScopedLowMemFreeRangesLock() {
+    CHECK_EQ(pthread_mutex_unlock(&gLowMemFreeRangesLock), 0);
+  }
+};
+
+// Marks [begin, end) as mapped. Requires the lock.
+static void TakeLowMemRange(uintptr_t begin, uintptr_t end) {
+  std::map<uintptr_t, uintptr_t>& ranges = *gLowMemFreeRanges;
+  auto it = ranges.upper_bound(begin);
+  if (it != ranges.begin()) {
+    --it;
+  }
+  while (it != ranges.end() && it->first < end) {
+    const uintptr_t range_begin = it->first;
+    const uintptr_t range_end = it->second;
+    if (range_end <= begin) {
+      ++it;
+      continue;
+    }
+    it = ranges.erase(it);
+    if (range_begin < begin) {
+      ranges[range_begin] = begin;
+    }
+    if (range_end > end) {
+      ranges[end] = range_end;
+      break;
+    }
+  }
+}
+
+// Marks [begin, end) as free, merging it with the free ranges it touches. Requires the lock.
+static void ReleaseLowMemRange(uintptr_t begin, uintptr_t end) {
+  begin = std::max(begin, LOW_MEM_START);
+  end = std::min(end, static_cast<uintptr_t>(4 * GB));
+  if (begin >= end) {
+    return;
+  }
+  std::map<uintptr_t, uintptr_t>& ranges = *gLowMemFreeRanges;
+  auto it = ranges.upper_bound(begin);
+  if (it != ranges.begin()) {
+    auto prev = it;
+    --prev;
+    if (prev->second >= begin) {
+      begin = prev->first;
+      end = std::max(end, prev->second);
+      ranges.erase(prev);
+    }
+  }
+  while (it != ranges.end() && it->first <= end) {
+    end = std::max(end, it->second);
+    it = ranges.erase(it);
+  }
+  ranges[begin] = end;
+}
+
+// Rebuilds the free ranges from the gaps between the process maps. Requires the lock.
+static bool BuildLowMemFreeRanges() {
+  std::unique_ptr<BacktraceMap> map(BacktraceMap::Create(getpid()));
+  if (!map->Build()) {
+    LOG(ERROR) << "Failed to build process map to find low-memory space.";
+    return false;
+  }
+  if (gLowMemFreeRanges == nullptr) {
+    gLowMemFreeRanges = new std::map<uintptr_t, uintptr_t>;
+  }
+  gLowMemFreeRanges->clear();
+  ReleaseLowMemRange(LOW_MEM_START, 4 * GB);
+  for (BacktraceMap::const_iterator it = map->begin(); it != map->end(); ++it) {
+    TakeLowMemRange(RoundDown(static_cast<uintptr_t>(it->start), kPageSize),
+                    RoundUp(static_cast<uintptr_t>(it->end), kPageSize));
+  }
+  return true;
+}
+
+// Returns the first free address at which byte_count bytes fit, from start and then wrapping
+// around, or 0. Requires the lock.
+static uintptr_t FindLowMemRange(uintptr_t start, size_t byte_count) {
+  const std::map<uintptr_t, uintptr_t>& ranges = *gLowMemFreeRanges;
+  auto first = ranges.upper_bound(start);
+  if (first != ranges.begin()) {
+    --first;
+  }
+  for (auto it = first; it != ranges.end(); ++it) {
+    const uintptr_t begin = std::max(it->first, start);
+    if (begin < it->second && it->second - begin >= byte_count) {
+      return begin;
+    }
+  }
+  for (auto it = ranges.begin(); it != first; ++it) {
+    if (it->second - it->first >= byte_count) {
+      return it->first;
+    }
+  }
+  return 0;
+}
 #endif
 
 static bool CheckMapRequest(byte* expected_ptr, void* actual_ptr, size_t byte_count,
@@ -158,6 +269,8 @@ static bool CheckMapRequest(byte* expected_ptr, void* actual_ptr, size_t byte_co
   return false;
 }
 
+bool MemMap::huge_pages_enabled_ = false;
+
 MemMap* MemMap::MapAnonymous(const char* name, byte* expected, size_t byte_count, int prot,
                              bool low_4gb, std::string* error_msg) {
   if (byte_count == 0) {
@@ -199,55 +312,33 @@ MemMap* MemMap::MapAnonymous(const char* name, byte* expected, size_t byte_count
 #endif
 
   // TODO:
-  // A page allocator would be a useful abstraction here, as
-  // 1) It is doubtful that MAP_32BIT on x86_64 is doing the right job for us
-  // 2) The linear scheme, even with simple saving of the last known position, is very crude
+  // It is doubtful that MAP_32BIT on x86_64 is doing the right job for us.
 #if defined(__LP64__) && !defined(__x86_64__)
   // MAP_32BIT only available on x86_64.
   void* actual = MAP_FAILED;
   if (low_4gb && expected == nullptr) {
-    flags |= MAP_FIXED;
-
-    bool first_run = true;
-
-    for (uintptr_t ptr = next_mem_pos_; ptr < 4 * GB; ptr += kPageSize) {
-      if (4U * GB - ptr < page_aligned_byte_count) {
-        // Not enough memory until 4GB.
-        if (first_run) {
-          // Try another time from the bottom;
-          ptr = LOW_MEM_START - kPageSize;
-          first_run = false;
-          continue;
-        } else {
-          // Second try failed.
-          break;
-        }
+    ScopedLowMemFreeRangesLock lock;
+    // The address is only a hint, so that a range mapped by someone else since the free ranges
+    // were built is not clobbered: the ranges are rebuilt once if the kernel maps elsewhere.
+    for (size_t attempt = 0; attempt < 2 && actual == MAP_FAILED; ++attempt) {
+      if ((gLowMemFreeRanges == nullptr || attempt != 0) && !BuildLowMemFreeRanges()) {
+        break;
       }
-
-      uintptr_t tail_ptr;
-
-      // Check pages are free.
-      bool safe = true;
-      for (tail_ptr = ptr; tail_ptr < ptr + page_aligned_byte_count; tail_ptr += kPageSize) {
-        if (msync(reinterpret_cast<void*>(tail_ptr), kPageSize, 0) == 0) {
-          safe = false;
-          break;
-        } else {
-          DCHECK_EQ(errno, ENOMEM);
-        }
+      uintptr_t ptr = FindLowMemRange(next_mem_pos_, page_aligned_byte_count);
+      if (ptr == 0) {
+        continue;
       }
-
-      next_mem_pos_ = tail_ptr;  // update early, as we break out when we found and mapped a region
-
-      if (safe == true) {
-        actual = mmap(reinterpret_cast<void*>(ptr), page_aligned_byte_count, prot, flags, fd.get(),
-                      0);
-        if (actual != MAP_FAILED) {
-          break;
-        }
-      } else {
-        // Skip over last page.
-        ptr = tail_ptr;
+      void* hinted = mmap(reinterpret_cast<void*>(ptr), page_aligned_byte_count, prot, flags,
+                          fd.get(), 0);
+      if (hinted == MAP_FAILED) {
+        break;
+      }
+      if (reinterpret_cast<uintptr_t>(hinted) == ptr) {
+        actual = hinted;
+        TakeLowMemRange(ptr, ptr + page_aligned_byte_count);
+        next_mem_pos_ = ptr + page_aligned_byte_count;
+      } else if (munmap(hinted, page_aligned_byte_count) == -1) {
+        PLOG(WARNING) << StringPrintf("munmap(%p, %zd) failed", hinted, page_aligned_byte_count);
       }
     }
 
@@ -351,6 +442,15 @@ MemMap::~MemMap() {
   if (result == -1) {
     PLOG(FATAL) << "munmap failed";
   }
+#if defined(__LP64__) && !defined(__x86_64__)
+  const uintptr_t base_begin = reinterpret_cast<uintptr_t>(base_begin_);
+  if (base_begin < 4 * GB) {
+    ScopedLowMemFreeRangesLock lock;
+    if (gLowMemFreeRanges != nullptr) {
+      ReleaseLowMemRange(base_begin, base_begin + base_size_);
+    }
+  }
+#endif
 }
 
 MemMap::MemMap(const std::string& name, byte* begin, size_t size, void* base_begin,
@@ -365,6 +465,16 @@ MemMap::MemMap(const std::string& name, byte* begin, size_t size, void* base_beg
     CHECK(begin_ != nullptr);
     CHECK(base_begin_ != nullptr);
     CHECK_NE(base_size_, 0U);
+#if defined(__LP64__) && !defined(__x86_64__)
+    // Also track the maps made at an expected address or of a file.
+    const uintptr_t base_begin = reinterpret_cast<uintptr_t>(base_begin_);
+    if (base_begin < 4 * GB) {
+      ScopedLowMemFreeRangesLock lock;
+      if (gLowMemFreeRanges != nullptr) {
+        TakeLowMemRange(base_begin, base_begin + base_size_);
+      }
+    }
+#endif
   }
 };
 
@@ -437,6 +547,27 @@ MemMap* MemMap::RemapAtEnd(byte* new_end, const char* tail_name, int tail_prot,
   return new MemMap(tail_name, actual, tail_size, actual, tail_base_size, tail_prot);
 }
 
+bool MemMap::AdviseHugePages() {
+  if (!huge_pages_enabled_) {
+    return false;
+  }
+#ifdef MADV_HUGEPAGE
+  byte* begin = AlignUp(reinterpret_cast<byte*>(base_begin_), kHugePageSize);
+  byte* end = AlignDown(reinterpret_cast<byte*>(BaseEnd()), kHugePageSize);
+  if (begin >= end) {
+    return false;
+  }
+  if (madvise(begin, end - begin, MADV_HUGEPAGE) != 0) {
+    // Kernels without transparent huge pages refuse it, and most refuse it for file mappings.
+    VLOG(heap) << "madvise(MADV_HUGEPAGE) failed for " << *this << ": " << strerror(errno);
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
 bool MemMap::Protect(int prot) {
   if (base_begin_ == nullptr && base_size_ == 0) {
     prot_ = prot;
@@ -29,9 +29,9 @@ namespace art {
 
 // Used to keep track of mmap segments.
 //
-// On 64b systems not supporting MAP_32BIT, the implementation of MemMap will do a linear scan
-// for free pages. For security, the start of this scan should be randomized. This requires a
-// dynamic initializer.
+// On 64b systems not supporting MAP_32BIT, the implementation of MemMap will search the free
+// ranges of the low 4GB, first fit from a position. For security, the start of this search should
+// be randomized. This requires a dynamic initializer.
 // For this to work, it is paramount that there are no other static initializers that access MemMap.
 // Otherwise, calls might see uninitialized values.
 class MemMap {
@@ -68,6 +68,23 @@ class MemMap {
   // Releases the memory mapping
   ~MemMap();
 
+  // Size of the transparent huge pages of the kernel.
+  static constexpr size_t kHugePageSize = 2 * MB;
+
+  // Set from -XX:UseHugePages, before the heap is created.
+  static void SetHugePagesEnabled(bool enabled) {
+    huge_pages_enabled_ = enabled;
+  }
+
+  static bool HugePagesEnabled() {
+    return huge_pages_enabled_;
+  }
+
+  // If huge pages are enabled, asks the kernel to back the huge page aligned part of the map
+  // with transparent huge pages. Returns false if they are disabled, if the map covers no aligned
+  // huge page or if the kernel refused.
+  bool AdviseHugePages();
+
   const std::string& GetName() const {
     return name_;
   }
@@ -122,8 +139,10 @@ class MemMap {
   size_t base_size_;  // Length of mapping. May be changed by RemapAtEnd (ie Zygote).
   int prot_;  // Protection of the map.
 
+  static bool huge_pages_enabled_;
+
 #if defined(__LP64__) && !defined(__x86_64__)
-  static uintptr_t next_mem_pos_;   // next memory location to check for low_4g extent
+  static uintptr_t next_mem_pos_;   // next memory location to search for low_4g extent
 #endif
 
   friend class MemMapTest;  // To allow access to base_begin_ and base_size_.
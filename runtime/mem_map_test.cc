@@ -17,6 +17,7 @@
 #include "mem_map.h"
 
 #include <memory>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -152,6 +153,39 @@ TEST_F(MemMapTest, MapAnonymousEmpty32bit) {
   ASSERT_TRUE(error_msg.empty());
   ASSERT_LT(reinterpret_cast<uintptr_t>(BaseBegin(map.get())), 1ULL << 32);
 }
+
+TEST_F(MemMapTest, MapAnonymousMany32bit) {
+  std::string error_msg;
+  std::vector<MemMap*> maps;
+  // Map regions of various sizes, release every other one, then map more in the holes or after.
+  for (size_t i = 0; i < 24; ++i) {
+    if (i == 16) {
+      for (size_t j = 0; j < maps.size(); j += 2) {
+        delete maps[j];
+        maps[j] = nullptr;
+      }
+    }
+    MemMap* map = MemMap::MapAnonymous("MapAnonymousMany32bit",
+                                       nullptr,
+                                       (i % 4 + 1) * kPageSize,
+                                       PROT_READ | PROT_WRITE,
+                                       true,
+                                       &error_msg);
+    ASSERT_TRUE(map != nullptr) << error_msg;
+    ASSERT_LT(reinterpret_cast<uintptr_t>(map->BaseEnd()), 1ULL << 32);
+    for (MemMap* other : maps) {
+      if (other != nullptr) {
+        ASSERT_TRUE(map->BaseEnd() <= other->BaseBegin() ||
+                    other->BaseEnd() <= map->BaseBegin());
+      }
+    }
+    map->Begin()[0] = 42;
+    maps.push_back(map);
+  }
+  for (MemMap* map : maps) {
+    delete map;
+  }
+}
 #endif
 
 TEST_F(MemMapTest, MapAnonymousExactAddr) {
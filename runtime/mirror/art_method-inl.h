@@ -212,6 +212,15 @@ inline const uint8_t* ArtMethod::GetVmapTable(const void* code_pointer) {
   return reinterpret_cast<const uint8_t*>(code_pointer) - offset;
 }
 
+inline bool ArtMethod::HasStackMaps(const void* code_pointer) {
+  return GetMappingTable(code_pointer) == nullptr && GetVmapTable(code_pointer) != nullptr;
+}
+
+inline CodeInfo ArtMethod::GetCodeInfo(const void* code_pointer) {
+  DCHECK(HasStackMaps(code_pointer));
+  return CodeInfo(GetVmapTable(code_pointer));
+}
+
 inline void ArtMethod::SetOatNativeGcMapOffset(uint32_t gc_map_offset) {
   DCHECK(!Runtime::Current()->IsStarted());
   SetNativeGcMap(reinterpret_cast<uint8_t*>(gc_map_offset));
@@ -249,12 +258,35 @@ inline bool ArtMethod::IsResolutionMethod() {
 }
 
 inline bool ArtMethod::IsImtConflictMethod() {
-  bool result = this == Runtime::Current()->GetImtConflictMethod();
+  bool result = this == Runtime::Current()->GetImtConflictMethod() ||
+      GetImtConflictTable() != nullptr;
   // Check that if we do think it is phony it looks like the imt conflict method.
   DCHECK(!result || IsRuntimeMethod());
   return result;
 }
 
+inline ObjectArray<ArtMethod>* ArtMethod::GetImtConflictTable() {
+  return IsRuntimeMethod() ? GetDexCacheResolvedMethods() : nullptr;
+}
+
+inline void ArtMethod::SetImtConflictTable(ObjectArray<ArtMethod>* conflict_table) {
+  DCHECK(IsRuntimeMethod());
+  SetDexCacheResolvedMethods(conflict_table);
+}
+
+inline ArtMethod* ArtMethod::FindImtConflictTarget(ArtMethod* interface_method) {
+  ObjectArray<ArtMethod>* conflict_table = GetImtConflictTable();
+  if (conflict_table == nullptr) {
+    return nullptr;
+  }
+  for (int32_t i = 0, length = conflict_table->GetLength(); i < length; i += 2) {
+    if (conflict_table->GetWithoutChecks(i) == interface_method) {
+      return conflict_table->GetWithoutChecks(i + 1);
+    }
+  }
+  return nullptr;
+}
+
 inline uintptr_t ArtMethod::NativePcOffset(const uintptr_t pc) {
   const void* code = Runtime::Current()->GetInstrumentation()->GetQuickCodeFor(this);
   return pc - reinterpret_cast<uintptr_t>(code);
@@ -171,6 +171,19 @@ uint32_t ArtMethod::ToDexPc(const uintptr_t pc, bool abort_on_failure) {
     return static_cast<uint32_t>(pc);
   }
   const void* entry_point = GetQuickOatEntryPoint();
+  uint32_t sought_offset = pc - reinterpret_cast<uintptr_t>(entry_point);
+  if (entry_point != nullptr && HasStackMaps(EntryPointToCodePointer(entry_point))) {
+    CodeInfo code_info = GetCodeInfo(EntryPointToCodePointer(entry_point));
+    StackMap stack_map;
+    if (code_info.FindStackMapForNativePcOffset(sought_offset, &stack_map)) {
+      return stack_map.GetDexPc();
+    }
+    if (abort_on_failure) {
+      LOG(FATAL) << "Failed to find stack map for PC offset "
+                 << reinterpret_cast<void*>(sought_offset) << " in " << PrettyMethod(this);
+    }
+    return DexFile::kDexNoIndex;
+  }
   MappingTable table(
       entry_point != nullptr ? GetMappingTable(EntryPointToCodePointer(entry_point)) : nullptr);
   if (table.TotalSize() == 0) {
@@ -179,7 +192,6 @@ uint32_t ArtMethod::ToDexPc(const uintptr_t pc, bool abort_on_failure) {
     DCHECK(IsNative() || IsCalleeSaveMethod() || IsProxyMethod()) << PrettyMethod(this);
     return DexFile::kDexNoIndex;   // Special no mapping case
   }
-  uint32_t sought_offset = pc - reinterpret_cast<uintptr_t>(entry_point);
   // Assume the caller wants a pc-to-dex mapping so check here first.
   typedef MappingTable::PcToDexIterator It;
   for (It cur = table.PcToDexBegin(), end = table.PcToDexEnd(); cur != end; ++cur) {
@@ -204,6 +216,16 @@ uint32_t ArtMethod::ToDexPc(const uintptr_t pc, bool abort_on_failure) {
 
 uintptr_t ArtMethod::ToNativePc(const uint32_t dex_pc) {
   const void* entry_point = GetQuickOatEntryPoint();
+  if (entry_point != nullptr && HasStackMaps(EntryPointToCodePointer(entry_point))) {
+    CodeInfo code_info = GetCodeInfo(EntryPointToCodePointer(entry_point));
+    StackMap stack_map;
+    if (code_info.FindStackMapForDexPc(dex_pc, &stack_map)) {
+      return reinterpret_cast<uintptr_t>(entry_point) + stack_map.GetNativePcOffset();
+    }
+    LOG(FATAL) << "Failed to find stack map for dex pc 0x" << std::hex << dex_pc
+               << " in " << PrettyMethod(this);
+    return 0;
+  }
   MappingTable table(
       entry_point != nullptr ? GetMappingTable(EntryPointToCodePointer(entry_point)) : nullptr);
   if (table.TotalSize() == 0) {
@@ -363,7 +385,6 @@ bool ArtMethod::IsRegistered() {
 void ArtMethod::RegisterNative(Thread* self, const void* native_method, bool is_fast) {
   DCHECK(Thread::Current() == self);
   CHECK(IsNative()) << PrettyMethod(this);
-  CHECK(!IsFastNative()) << PrettyMethod(this);
   CHECK(native_method != NULL) << PrettyMethod(this);
   if (is_fast) {
     SetAccessFlags(GetAccessFlags() | kAccFastNative);
@@ -372,8 +393,8 @@ void ArtMethod::RegisterNative(Thread* self, const void* native_method, bool is_
 }
 
 void ArtMethod::UnregisterNative(Thread* self) {
-  CHECK(IsNative() && !IsFastNative()) << PrettyMethod(this);
-  // restore stub to lookup native pointer via dlsym
+  CHECK(IsNative()) << PrettyMethod(this);
+  // restore stub to lookup native pointer via dlsym, a fast native method stays fast
   RegisterNative(self, GetJniDlsymLookupStub(), false);
 }
 
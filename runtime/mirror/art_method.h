@@ -24,6 +24,7 @@
 #include "object.h"
 #include "object_callbacks.h"
 #include "quick/quick_method_frame_info.h"
+#include "stack_map.h"
 
 namespace art {
 
@@ -234,6 +235,10 @@ class MANAGED ArtMethod : public Object {
         entry_point_from_interpreter);
   }
 
+  static MemberOffset EntryPointFromInterpreterOffset() {
+    return OFFSET_OF_OBJECT_MEMBER(ArtMethod, entry_point_from_interpreter_);
+  }
+
   static MemberOffset EntryPointFromPortableCompiledCodeOffset() {
     return MemberOffset(OFFSETOF_MEMBER(ArtMethod, entry_point_from_portable_compiled_code_));
   }
@@ -312,6 +317,12 @@ class MANAGED ArtMethod : public Object {
   const uint8_t* GetVmapTable(const void* code_pointer)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Whether the code at `code_pointer` describes its safepoints with stack maps
+  // instead of a mapping table, a vmap table and a native GC map. The stack
+  // maps are stored in place of the vmap table, and there is no mapping table.
+  bool HasStackMaps(const void* code_pointer) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  CodeInfo GetCodeInfo(const void* code_pointer) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   const uint8_t* GetNativeGcMap() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     return GetFieldPtr<uint8_t*>(OFFSET_OF_OBJECT_MEMBER(ArtMethod, gc_map_));
   }
@@ -320,6 +331,10 @@ class MANAGED ArtMethod : public Object {
     SetFieldPtr<false, true, kVerifyFlags>(OFFSET_OF_OBJECT_MEMBER(ArtMethod, gc_map_), data);
   }
 
+  static MemberOffset NativeGcMapOffset() {
+    return OFFSET_OF_OBJECT_MEMBER(ArtMethod, gc_map_);
+  }
+
   // When building the oat need a convenient place to stuff the offset of the native GC map.
   void SetOatNativeGcMapOffset(uint32_t gc_map_offset) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   uint32_t GetOatNativeGcMapOffset() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -382,8 +397,21 @@ class MANAGED ArtMethod : public Object {
 
   bool IsResolutionMethod() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Is this the runtime's IMT conflict method, or a copy of it resolving the conflicts of an IMT
+  // entry of a class?
   bool IsImtConflictMethod() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // The interface methods sharing the IMT entry of a class, each followed by its implementation.
+  // Conflict methods keep it in place of the resolved methods, which runtime methods don't have.
+  // Null for the runtime's conflict method and for the other methods.
+  ObjectArray<ArtMethod>* GetImtConflictTable() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void SetImtConflictTable(ObjectArray<ArtMethod>* conflict_table)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Returns the implementation of `interface_method` in the conflict table, or null.
+  ArtMethod* FindImtConflictTarget(ArtMethod* interface_method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   uintptr_t NativePcOffset(const uintptr_t pc) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   uintptr_t NativePcOffset(const uintptr_t pc, const void* quick_entry_point)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -151,6 +151,10 @@ inline void Class::SetImTable(ObjectArray<ArtMethod>* new_imtable) {
 inline bool Class::Implements(Class* klass) {
   DCHECK(klass != NULL);
   DCHECK(klass->IsInterface()) << PrettyClass(this);
+  MemberOffset cache_offset = OFFSET_OF_OBJECT_MEMBER(Class, secondary_super_cache_);
+  if (GetFieldObject<Class>(cache_offset) == klass) {
+    return true;
+  }
   // All interfaces implemented directly and by our superclass, and
   // recursively all super-interfaces of those interfaces, are listed
   // in iftable_, so we can just do a linear scan through that.
@@ -158,6 +162,9 @@ inline bool Class::Implements(Class* klass) {
   IfTable* iftable = GetIfTable();
   for (int32_t i = 0; i < iftable_count; i++) {
     if (iftable->GetInterface(i) == klass) {
+      // Racy but harmless: any interface in the cache is implemented. Not undone with a
+      // transaction, for the same reason.
+      SetFieldObject<false, false>(cache_offset, klass);
       return true;
     }
   }
@@ -289,17 +296,30 @@ inline bool Class::CheckResolvedMethodAccess(Class* access_to, ArtMethod* method
                                                                  nullptr);
 }
 
+inline Class* Class::GetSupertypeDisplayEntry(size_t depth) {
+  DCHECK_LT(depth, kSupertypeDisplaySize);
+  return GetFieldObject<Class>(SupertypeDisplayOffset(depth));
+}
+
 inline bool Class::IsSubClass(Class* klass) {
   DCHECK(!IsInterface()) << PrettyClass(this);
   DCHECK(!IsArrayClass()) << PrettyClass(this);
+  if (this == klass) {
+    return true;
+  }
+  uint32_t klass_depth = klass->GetSupertypeDepth();
+  uint32_t depth = GetSupertypeDepth();
+  if (klass_depth >= depth) {
+    return false;
+  }
+  if (klass_depth < kSupertypeDisplaySize) {
+    return GetSupertypeDisplayEntry(klass_depth) == klass;
+  }
   Class* current = this;
-  do {
-    if (current == klass) {
-      return true;
-    }
+  for (; depth != klass_depth; --depth) {
     current = current->GetSuperClass();
-  } while (current != NULL);
-  return false;
+  }
+  return current == klass;
 }
 
 inline ArtMethod* Class::FindVirtualMethodForInterface(ArtMethod* method) {
@@ -507,6 +527,10 @@ template <bool kVisitClass, typename Visitor>
 inline void Class::VisitReferences(mirror::Class* klass, const Visitor& visitor) {
   VisitInstanceFieldsReferences<kVisitClass>(klass, visitor);
   VisitStaticFieldsReferences<kVisitClass>(this, visitor);
+  for (size_t i = 0; i < kSupertypeDisplaySize; ++i) {
+    visitor(this, SupertypeDisplayOffset(i), false);
+  }
+  visitor(this, OFFSET_OF_OBJECT_MEMBER(Class, secondary_super_cache_), false);
 }
 
 inline bool Class::IsArtFieldClass() const {
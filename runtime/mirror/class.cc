@@ -38,6 +38,7 @@ namespace art {
 namespace mirror {
 
 Class* Class::java_lang_Class_ = NULL;
+constexpr size_t Class::kSupertypeDisplaySize;
 
 void Class::SetClassClass(Class* java_lang_Class) {
   CHECK(java_lang_Class_ == NULL) << java_lang_Class_ << " " << java_lang_Class;
@@ -132,6 +133,17 @@ void Class::SetClassSize(uint32_t new_class_size) {
   SetField32<false>(OFFSET_OF_OBJECT_MEMBER(Class, class_size_), new_class_size);
 }
 
+void Class::SetSupertypeDisplay(Class* super_class) {
+  uint32_t super_depth = super_class->GetSupertypeDepth();
+  for (size_t i = 0; i < super_depth && i < kSupertypeDisplaySize; ++i) {
+    SetFieldObject<false>(SupertypeDisplayOffset(i), super_class->GetSupertypeDisplayEntry(i));
+  }
+  if (super_depth < kSupertypeDisplaySize) {
+    SetFieldObject<false>(SupertypeDisplayOffset(super_depth), super_class);
+  }
+  SetField32<false>(OFFSET_OF_OBJECT_MEMBER(Class, supertype_depth_), super_depth + 1);
+}
+
 // Return the class' name. The exact format is bizarre, but it's the specified behavior for
 // Class.getName: keywords for primitive types, regular "[I" form for primitive arrays (so "int"
 // but "[I"), and arrays of reference types written between "L" and ";" but with dots rather than
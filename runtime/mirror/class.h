@@ -130,6 +130,14 @@ class MANAGED Class : public Object {
 
   void SetStatus(Status new_status, Thread* self) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  static MemberOffset AccessFlagsOffset() {
+    return OFFSET_OF_OBJECT_MEMBER(Class, access_flags_);
+  }
+
+  static MemberOffset ObjectSizeOffset() {
+    return OFFSET_OF_OBJECT_MEMBER(Class, object_size_);
+  }
+
   static MemberOffset StatusOffset() {
     return OFFSET_OF_OBJECT_MEMBER(Class, status_);
   }
@@ -286,6 +294,10 @@ class MANAGED Class : public Object {
     return (access_flags & kAccClassIsProxy) != 0;
   }
 
+  static MemberOffset PrimitiveTypeOffset() {
+    return OFFSET_OF_OBJECT_MEMBER(Class, primitive_type_);
+  }
+
   template<VerifyObjectFlags kVerifyFlags = kDefaultVerifyFlags>
   Primitive::Type GetPrimitiveType() ALWAYS_INLINE SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -515,6 +527,11 @@ class MANAGED Class : public Object {
                                  uint32_t method_idx)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // The number of superclass levels in the supertype display, see supertype_display_.
+  static constexpr size_t kSupertypeDisplaySize = 8;
+
+  // Is this class klass or one of its subclasses? Constant time if klass is less than
+  // kSupertypeDisplaySize levels below java.lang.Object.
   bool IsSubClass(Class* klass) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // Can src be assigned to this class? For example, String can be assigned to Object (by an
@@ -547,6 +564,13 @@ class MANAGED Class : public Object {
     DCHECK(old_super_class == nullptr || old_super_class == new_super_class);
     DCHECK(new_super_class != nullptr);
     SetFieldObject<false>(OFFSET_OF_OBJECT_MEMBER(Class, super_class_), new_super_class);
+    SetSupertypeDisplay(new_super_class);
+  }
+
+  // The number of superclasses of this class: 0 for java.lang.Object, interfaces and primitive
+  // classes.
+  uint32_t GetSupertypeDepth() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    return GetField32(OFFSET_OF_OBJECT_MEMBER(Class, supertype_depth_));
   }
 
   bool HasSuperClass() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
@@ -888,6 +912,16 @@ class MANAGED Class : public Object {
   bool IsArrayAssignableFromArray(Class* klass) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   bool IsAssignableFromArray(Class* klass) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  static MemberOffset SupertypeDisplayOffset(size_t depth) {
+    return MemberOffset(OFFSETOF_MEMBER(Class, supertype_display_) +
+                        depth * sizeof(HeapReference<Class>));
+  }
+
+  Class* GetSupertypeDisplayEntry(size_t depth) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Fills the supertype display and depth from those of the superclass.
+  void SetSupertypeDisplay(Class* super_class) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   void CheckObjectAlloc() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   // defining class loader, or NULL for the "bootstrap" system loader
@@ -994,6 +1028,21 @@ class MANAGED Class : public Object {
   // State of class initialization.
   Status status_;
 
+  // The following fields are not in java.lang.Class; Class::VisitReferences visits the
+  // references.
+
+  // The superclasses of this class by depth, java.lang.Object first, for constant time subclass
+  // checks: a class is a subclass of the class at depth d if that's its entry d. Only the first
+  // kSupertypeDisplaySize levels are recorded, deeper superclasses are found by walking up the
+  // superclass chain.
+  HeapReference<Class> supertype_display_[kSupertypeDisplaySize];
+
+  // The last interface Implements found in the iftable, checked before scanning it.
+  HeapReference<Class> secondary_super_cache_;
+
+  // See GetSupertypeDepth.
+  uint32_t supertype_depth_;
+
   // TODO: ?
   // initiating class loader list
   // NOTE: for classes with low serialNumber, these are unused, and the
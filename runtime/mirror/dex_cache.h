@@ -21,6 +21,7 @@
 #include "class.h"
 #include "object.h"
 #include "object_array.h"
+#include "resolved_field_cache.h"
 #include "string.h"
 
 namespace art {
@@ -80,6 +81,7 @@ class MANAGED DexCache : public Object {
     return GetResolvedMethods()->GetLength();
   }
 
+  // 0 for a compact DexCache.
   size_t NumResolvedFields() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     return GetResolvedFields()->GetLength();
   }
@@ -114,12 +116,22 @@ class MANAGED DexCache : public Object {
 
   ArtField* GetResolvedField(uint32_t field_idx) ALWAYS_INLINE
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    return GetResolvedFields()->Get(field_idx);
+    ObjectArray<ArtField>* resolved_fields = GetResolvedFields();
+    if (UNLIKELY(resolved_fields->GetLength() == 0)) {
+      // A compact DexCache, see ClassLinker::AllocDexCache.
+      return GetDexFile()->GetResolvedFieldCache()->Get(field_idx);
+    }
+    return resolved_fields->Get(field_idx);
   }
 
   void SetResolvedField(uint32_t field_idx, ArtField* resolved) ALWAYS_INLINE
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    GetResolvedFields()->Set(field_idx, resolved);
+    ObjectArray<ArtField>* resolved_fields = GetResolvedFields();
+    if (UNLIKELY(resolved_fields->GetLength() == 0)) {
+      GetDexFile()->GetResolvedFieldCache()->Set(field_idx, resolved);
+      return;
+    }
+    resolved_fields->Set(field_idx, resolved);
   }
 
   ObjectArray<String>* GetStrings() ALWAYS_INLINE SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
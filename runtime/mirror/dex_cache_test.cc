@@ -21,9 +21,11 @@
 #include "class_linker.h"
 #include "common_runtime_test.h"
 #include "gc/heap.h"
+#include "mirror/art_field-inl.h"
 #include "mirror/object_array-inl.h"
 #include "mirror/object-inl.h"
 #include "handle_scope-inl.h"
+#include "resolved_field_cache.h"
 
 namespace art {
 namespace mirror {
@@ -57,5 +59,29 @@ TEST_F(DexCacheTest, Open) {
             static_cast<uint32_t>(dex_cache->GetResolvedFields()->GetLength()));
 }
 
+TEST_F(DexCacheTest, ResolvedFieldCache) {
+  ScopedObjectAccess soa(Thread::Current());
+  Class* string_class = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/String;");
+  ASSERT_TRUE(string_class != NULL);
+  ASSERT_LE(2U, string_class->NumInstanceFields());
+  ArtField* field0 = string_class->GetInstanceField(0);
+  ArtField* field1 = string_class->GetInstanceField(1);
+
+  ResolvedFieldCache cache;
+  EXPECT_TRUE(cache.Get(0) == NULL);
+  EXPECT_TRUE(cache.Get(5) == NULL);
+  cache.Set(5, field0);
+  EXPECT_EQ(field0, cache.Get(5));
+  // Same entry, another field id.
+  const uint32_t colliding_idx = 5 + ResolvedFieldCache::kSize;
+  EXPECT_TRUE(cache.Get(colliding_idx) == NULL);
+  cache.Set(colliding_idx, field1);
+  EXPECT_EQ(field1, cache.Get(colliding_idx));
+  EXPECT_TRUE(cache.Get(5) == NULL);
+  cache.Set(6, field0);
+  EXPECT_EQ(field0, cache.Get(6));
+  EXPECT_EQ(field1, cache.Get(colliding_idx));
+}
+
 }  // namespace mirror
 }  // namespace art
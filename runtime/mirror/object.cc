@@ -65,6 +65,16 @@ class CopyReferenceFieldsWithReadBarrierVisitor {
   Object* const dest_obj_;
 };
 
+// Returns whether the objects of class c have reference fields other than their class, which the
+// allocator stores. The copies of the other objects need no read or write barriers.
+static bool HasReferenceFieldsToCopy(Class* c) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  if (c->IsArrayClass()) {
+    return !c->GetComponentType()->IsPrimitive();
+  }
+  const uint32_t class_only_offsets = CLASS_BIT_FROM_OFFSET(Object::ClassOffset().Uint32Value());
+  return c->GetReferenceInstanceOffsets() != class_only_offsets;
+}
+
 static Object* CopyObject(Thread* self, mirror::Object* dest, mirror::Object* src, size_t num_bytes)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   // Copy instance data.  We assume memcpy copies by words.
@@ -73,23 +83,22 @@ static Object* CopyObject(Thread* self, mirror::Object* dest, mirror::Object* sr
   byte* dst_bytes = reinterpret_cast<byte*>(dest);
   size_t offset = sizeof(Object);
   memcpy(dst_bytes + offset, src_bytes + offset, num_bytes - offset);
-  if (kUseBakerOrBrooksReadBarrier) {
-    // We need a RB here. After the memcpy that covers the whole
-    // object above, copy references fields one by one again with a
-    // RB. TODO: Optimize this later?
-    CopyReferenceFieldsWithReadBarrierVisitor visitor(dest);
-    src->VisitReferences<true>(visitor, visitor);
-  }
   gc::Heap* heap = Runtime::Current()->GetHeap();
-  // Perform write barriers on copied object references.
   Class* c = src->GetClass();
-  if (c->IsArrayClass()) {
-    if (!c->GetComponentType()->IsPrimitive()) {
-      ObjectArray<Object>* array = dest->AsObjectArray<Object>();
-      heap->WriteBarrierArray(dest, 0, array->GetLength());
+  if (HasReferenceFieldsToCopy(c)) {
+    if (kUseBakerOrBrooksReadBarrier) {
+      // We need a RB here. After the memcpy that covers the whole
+      // object above, copy references fields one by one again with a
+      // RB. TODO: Optimize this later?
+      CopyReferenceFieldsWithReadBarrierVisitor visitor(dest);
+      src->VisitReferences<true>(visitor, visitor);
+    }
+    // Perform write barriers on copied object references.
+    if (c->IsArrayClass()) {
+      heap->WriteBarrierArray(dest, 0, dest->AsObjectArray<Object>()->GetLength());
+    } else {
+      heap->WriteBarrierEveryFieldOf(dest);
     }
-  } else {
-    heap->WriteBarrierEveryFieldOf(dest);
   }
   if (c->IsFinalizable()) {
     heap->AddFinalizerReference(self, &dest);
@@ -136,6 +145,15 @@ Object* Object::Clone(Thread* self) {
 }
 
 int32_t Object::GenerateIdentityHashCode() {
+  Thread* self = Thread::Current();
+  if (LIKELY(self != nullptr)) {
+    // Each thread has its own generator, so there's no shared seed to update atomically.
+    uint32_t hash;
+    do {
+      hash = self->NextIdentityHashState() & LockWord::kHashMask;
+    } while (hash == 0);
+    return hash;
+  }
   static AtomicInteger seed(987654321 + std::time(nullptr));
   int32_t expected_value, new_value;
   do {
@@ -31,6 +31,7 @@
 #include "entrypoints/entrypoint_utils.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/heap.h"
+#include "gc/space/bump_pointer_space.h"
 #include "iftable-inl.h"
 #include "art_method-inl.h"
 #include "object-inl.h"
@@ -77,7 +78,15 @@ TEST_F(ObjectTest, AsmConstants) {
   EXPECT_EQ(CLASS_OFFSET, Object::ClassOffset().Int32Value());
   EXPECT_EQ(LOCK_WORD_OFFSET, Object::MonitorOffset().Int32Value());
 
+  EXPECT_EQ(OBJECT_ALIGNMENT_MASK + 1, static_cast<int>(kObjectAlignment));
+  EXPECT_EQ(OBJECT_ALIGNMENT_MASK + 1, static_cast<int>(gc::space::BumpPointerSpace::kAlignment));
+  EXPECT_EQ(CLASS_STATUS_INITIALIZED, Class::kStatusInitialized);
+  EXPECT_EQ(ACCESS_FLAGS_CLASS_IS_FINALIZABLE, kAccClassIsFinalizable);
+
   EXPECT_EQ(CLASS_COMPONENT_TYPE_OFFSET, Class::ComponentTypeOffset().Int32Value());
+  EXPECT_EQ(CLASS_ACCESS_FLAGS_OFFSET, Class::AccessFlagsOffset().Int32Value());
+  EXPECT_EQ(CLASS_OBJECT_SIZE_OFFSET, Class::ObjectSizeOffset().Int32Value());
+  EXPECT_EQ(CLASS_STATUS_OFFSET, Class::StatusOffset().Int32Value());
 
   EXPECT_EQ(ARRAY_LENGTH_OFFSET, Array::LengthOffset().Int32Value());
   EXPECT_EQ(OBJECT_ARRAY_DATA_OFFSET, Array::DataOffset(sizeof(HeapReference<Object>)).Int32Value());
@@ -113,6 +122,19 @@ TEST_F(ObjectTest, Clone) {
   EXPECT_TRUE(clone->GetClass() == a1->GetClass());
 }
 
+TEST_F(ObjectTest, ClonePrimitiveArray) {
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<1> hs(soa.Self());
+  Handle<IntArray> a1(hs.NewHandle(IntArray::Alloc(soa.Self(), 3)));
+  a1->Set(0, 1);
+  a1->Set(2, 3);
+  IntArray* clone = a1->Clone(soa.Self())->AsIntArray();
+  ASSERT_EQ(3, clone->GetLength());
+  EXPECT_EQ(1, clone->Get(0));
+  EXPECT_EQ(0, clone->Get(1));
+  EXPECT_EQ(3, clone->Get(2));
+}
+
 TEST_F(ObjectTest, AllocObjectArray) {
   ScopedObjectAccess soa(Thread::Current());
   StackHandleScope<2> hs(soa.Self());
@@ -592,6 +614,33 @@ TEST_F(ObjectTest, IsAssignableFrom) {
   }
 }
 
+TEST_F(ObjectTest, SupertypeDisplay) {
+  ScopedObjectAccess soa(Thread::Current());
+  Class* object = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  Class* collection = class_linker_->FindSystemClass(soa.Self(), "Ljava/util/AbstractCollection;");
+  Class* list = class_linker_->FindSystemClass(soa.Self(), "Ljava/util/AbstractList;");
+  Class* array_list = class_linker_->FindSystemClass(soa.Self(), "Ljava/util/ArrayList;");
+  Class* string = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/String;");
+  Class* random_access = class_linker_->FindSystemClass(soa.Self(), "Ljava/util/RandomAccess;");
+  ASSERT_TRUE(array_list != nullptr);
+  ASSERT_TRUE(random_access != nullptr);
+
+  EXPECT_EQ(0U, object->GetSupertypeDepth());
+  EXPECT_EQ(0U, random_access->GetSupertypeDepth());
+  EXPECT_EQ(3U, array_list->GetSupertypeDepth());
+  EXPECT_TRUE(array_list->IsSubClass(object));
+  EXPECT_TRUE(array_list->IsSubClass(collection));
+  EXPECT_TRUE(array_list->IsSubClass(list));
+  EXPECT_TRUE(array_list->IsSubClass(array_list));
+  EXPECT_FALSE(list->IsSubClass(array_list));
+  EXPECT_FALSE(string->IsSubClass(collection));
+
+  // The second check hits the secondary super cache.
+  EXPECT_TRUE(random_access->IsAssignableFrom(array_list));
+  EXPECT_TRUE(random_access->IsAssignableFrom(array_list));
+  EXPECT_FALSE(random_access->IsAssignableFrom(list));
+}
+
 TEST_F(ObjectTest, IsAssignableFromArray) {
   ScopedObjectAccess soa(Thread::Current());
   jobject jclass_loader = LoadDex("XandY");
@@ -713,5 +762,23 @@ TEST_F(ObjectTest, FindStaticField) {
   // TODO: test that interfaces trump superclasses.
 }
 
+TEST_F(ObjectTest, IdentityHashCode) {
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<2> hs(soa.Self());
+  Handle<String> s1(hs.NewHandle(String::AllocFromModifiedUtf8(soa.Self(), "ABC")));
+  Handle<String> s2(hs.NewHandle(String::AllocFromModifiedUtf8(soa.Self(), "ABC")));
+  ASSERT_TRUE(s1.Get() != NULL);
+  ASSERT_TRUE(s2.Get() != NULL);
+
+  int32_t hash1 = s1->IdentityHashCode();
+  int32_t hash2 = s2->IdentityHashCode();
+  EXPECT_NE(0, hash1);
+  EXPECT_NE(0, hash2);
+  EXPECT_NE(hash1, hash2);
+  // Stable, and stored in the lock word.
+  EXPECT_EQ(hash1, s1->IdentityHashCode());
+  EXPECT_EQ(LockWord::kHashCode, s1->GetLockWord(false).GetState());
+}
+
 }  // namespace mirror
 }  // namespace art
@@ -246,6 +246,16 @@ int32_t String::CompareTo(String* rhs) {
   return countDiff;
 }
 
+void String::ShareArray(CharArray* array, int32_t offset) {
+  DCHECK_LE(0, offset);
+  DCHECK_LE(offset + GetLength(), array->GetLength());
+  DCHECK_EQ(0, MemCmp16(array->GetData() + offset, GetCharArray()->GetData() + GetOffset(),
+                        GetLength()));
+  SetArray(array);
+  // Like the array, the offset is invariant.
+  SetField32<false, false>(OFFSET_OF_OBJECT_MEMBER(String, offset_), offset);
+}
+
 void String::VisitRoots(RootCallback* callback, void* arg) {
   if (java_lang_String_ != nullptr) {
     callback(reinterpret_cast<mirror::Object**>(&java_lang_String_), arg, 0, kRootStickyClass);
@@ -102,6 +102,10 @@ class MANAGED String : public Object {
 
   int32_t CompareTo(String* other) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Makes the string use the chars of `array` from `offset`, which must be the same as its own
+  // chars. The image writer shares the arrays of strings that are prefixes of other strings.
+  void ShareArray(CharArray* array, int32_t offset) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   static Class* GetJavaLangString() {
     DCHECK(java_lang_String_ != NULL);
     return java_lang_String_;
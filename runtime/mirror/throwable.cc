@@ -25,6 +25,7 @@
 #include "object_array-inl.h"
 #include "object_utils.h"
 #include "stack_trace_element.h"
+#include "thread.h"
 #include "utils.h"
 #include "well_known_classes.h"
 
@@ -84,7 +85,7 @@ std::string Throwable::Dump() {
     // Decode the internal stack trace into the depth and method trace
     ObjectArray<Object>* method_trace = down_cast<ObjectArray<Object>*>(stack_state);
     int32_t depth = method_trace->GetLength() - 1;
-    IntArray* pc_trace = down_cast<IntArray*>(method_trace->Get(depth));
+    LongArray* pc_trace = down_cast<LongArray*>(method_trace->Get(depth));
     MethodHelper mh;
     if (depth == 0) {
       result += "(Throwable with empty stack trace)";
@@ -92,7 +93,7 @@ std::string Throwable::Dump() {
       for (int32_t i = 0; i < depth; ++i) {
         ArtMethod* method = down_cast<ArtMethod*>(method_trace->Get(i));
         mh.ChangeMethod(method);
-        uint32_t dex_pc = pc_trace->Get(i);
+        uint32_t dex_pc = Thread::InternalStackTraceDexPc(method, pc_trace->Get(i));
         int32_t line_number = mh.GetLineNumFromDexPC(dex_pc);
         const char* source_file = mh.GetDeclaringClassSourceFile();
         result += StringPrintf("  at %s (%s:%d)\n", PrettyMethod(method, true).c_str(),
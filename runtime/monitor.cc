@@ -16,10 +16,15 @@
 
 #include "monitor.h"
 
+#include <algorithm>
+#include <map>
+#include <sstream>
 #include <vector>
 
 #include "base/mutex.h"
 #include "base/stl_util.h"
+#include "base/stringprintf.h"
+#include "base/systrace.h"
 #include "class_linker.h"
 #include "dex_file-inl.h"
 #include "dex_instruction.h"
@@ -64,6 +69,107 @@ namespace art {
  * at any given time.
  */
 
+// Tells the processor the thread is in a spin-wait loop.
+static inline void SpinPause() {
+#if defined(__i386__) || defined(__x86_64__)
+  __asm__ __volatile__("pause" : : : "memory");
+#elif defined(__arm__) || defined(__aarch64__)
+  __asm__ __volatile__("yield" : : : "memory");
+#else
+  __asm__ __volatile__("" : : : "memory");
+#endif
+}
+
+// Aggregates the waits for inflated monitors by lock site when lock profiling is enabled, see
+// Monitor::DumpContentionProfile.
+class LockContentionProfile {
+ public:
+  LockContentionProfile() : lock_("lock contention profile lock") {}
+
+  void Record(const std::string& descriptor, mirror::ArtMethod* method, uint32_t dex_pc,
+              mirror::ArtMethod* owners_method, uint32_t owners_dex_pc, uint64_t wait_ns)
+      LOCKS_EXCLUDED(lock_) {
+    MutexLock mu(Thread::Current(), lock_);
+    SiteStats& stats = sites_[std::make_pair(descriptor, Location(method, dex_pc))];
+    ++stats.count;
+    stats.total_wait_ns += wait_ns;
+    stats.max_wait_ns = std::max(stats.max_wait_ns, wait_ns);
+    stats.wait_ns_by_owner_location[Location(owners_method, owners_dex_pc)] += wait_ns;
+  }
+
+  void Dump(std::ostream& os) LOCKS_EXCLUDED(lock_) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+ private:
+  // Methods don't move, and their classes are never unloaded.
+  typedef std::pair<mirror::ArtMethod*, uint32_t> Location;
+
+  struct SiteStats {
+    SiteStats() : count(0), total_wait_ns(0), max_wait_ns(0) {}
+
+    uint64_t count;
+    uint64_t total_wait_ns;
+    uint64_t max_wait_ns;
+    // Where the owners had locked the monitor while the waits happened.
+    std::map<Location, uint64_t> wait_ns_by_owner_location;
+  };
+
+  // The number of lock sites and owner locations of each site that are dumped.
+  static constexpr size_t kMaxDumpedSites = 50;
+  static constexpr size_t kMaxDumpedOwnerLocations = 3;
+
+  static std::string PrettyLocation(const Location& location)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  // Keyed by the descriptor of the locked object's class and where it was being locked.
+  std::map<std::pair<std::string, Location>, SiteStats> sites_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(LockContentionProfile);
+};
+
+std::string LockContentionProfile::PrettyLocation(const Location& location) {
+  if (location.first == nullptr) {
+    return "an unknown location";
+  }
+  const char* source_file;
+  uint32_t line_number;
+  Monitor::TranslateLocation(location.first, location.second, &source_file, &line_number);
+  return StringPrintf("%s (%s:%u)", PrettyMethod(location.first).c_str(), source_file,
+                      line_number);
+}
+
+void LockContentionProfile::Dump(std::ostream& os) {
+  std::vector<std::pair<uint64_t, std::string>> lines;
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    for (const auto& site : sites_) {
+      const SiteStats& stats = site.second;
+      std::ostringstream oss;
+      oss << "  " << PrettyDuration(stats.total_wait_ns) << " in " << stats.count
+          << " waits (max " << PrettyDuration(stats.max_wait_ns) << ") to lock "
+          << PrettyDescriptor(site.first.first) << " at " << PrettyLocation(site.first.second)
+          << "\n";
+      std::vector<std::pair<uint64_t, Location>> owner_locations;
+      for (const auto& owner_location : stats.wait_ns_by_owner_location) {
+        owner_locations.push_back(std::make_pair(owner_location.second, owner_location.first));
+      }
+      std::sort(owner_locations.rbegin(), owner_locations.rend());
+      for (size_t i = 0; i < owner_locations.size() && i < kMaxDumpedOwnerLocations; ++i) {
+        oss << "    " << PrettyDuration(owner_locations[i].first) << " held from "
+            << PrettyLocation(owner_locations[i].second) << "\n";
+      }
+      lines.push_back(std::make_pair(stats.total_wait_ns, oss.str()));
+    }
+  }
+  std::sort(lines.rbegin(), lines.rend());
+  os << "Monitor contention (" << lines.size() << " lock sites, by total wait time):\n";
+  for (size_t i = 0; i < lines.size() && i < kMaxDumpedSites; ++i) {
+    os << lines[i].second;
+  }
+}
+
+static LockContentionProfile* lock_contention_profile_ = nullptr;
+
 bool (*Monitor::is_sensitive_thread_hook_)() = NULL;
 uint32_t Monitor::lock_profiling_threshold_ = 0;
 
@@ -77,6 +183,23 @@ bool Monitor::IsSensitiveThread() {
 void Monitor::Init(uint32_t lock_profiling_threshold, bool (*is_sensitive_thread_hook)()) {
   lock_profiling_threshold_ = lock_profiling_threshold;
   is_sensitive_thread_hook_ = is_sensitive_thread_hook;
+  if (lock_profiling_threshold != 0 && lock_contention_profile_ == nullptr) {
+    lock_contention_profile_ = new LockContentionProfile;
+  }
+}
+
+void Monitor::DumpContentionProfile(std::ostream& os) {
+  if (lock_contention_profile_ != nullptr) {
+    lock_contention_profile_->Dump(os);
+  }
+}
+
+void Monitor::RecordContention(Thread* self, uint64_t wait_ns, mirror::ArtMethod* owners_method,
+                               uint32_t owners_dex_pc) {
+  uint32_t dex_pc;
+  mirror::ArtMethod* method = self->GetCurrentMethod(&dex_pc);
+  lock_contention_profile_->Record(obj_->GetClass()->GetDescriptor(), method, dex_pc,
+                                   owners_method, owners_dex_pc, wait_ns);
 }
 
 Monitor::Monitor(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_code)
@@ -90,13 +213,39 @@ Monitor::Monitor(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_
       hash_code_(hash_code),
       locking_method_(NULL),
       locking_dex_pc_(0),
-      monitor_id_(MonitorPool::CreateMonitorId(self, this)) {
+      monitor_id_(MonitorPool::MonitorIdFromMonitor(this)),
+      spin_limit_(kInitialMonitorSpins),
+      contention_count_(0),
+      spin_acquired_count_(0),
+      blocked_count_(0),
+      idle_check_contention_count_(0) {
   // We should only inflate a lock if the owner is ourselves or suspended. This avoids a race
   // with the owner unlocking the thin-lock.
   CHECK(owner == nullptr || owner == self || owner->IsSuspended());
   // The identity hash code is set for the life time of the monitor.
 }
 
+Monitor::Monitor(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_code,
+                 MonitorId id)
+    : monitor_lock_("a monitor lock", kMonitorLock),
+      monitor_contenders_("monitor contenders", monitor_lock_),
+      num_waiters_(0),
+      owner_(owner),
+      lock_count_(0),
+      obj_(obj),
+      wait_set_(NULL),
+      hash_code_(hash_code),
+      locking_method_(NULL),
+      locking_dex_pc_(0),
+      monitor_id_(id),
+      spin_limit_(kInitialMonitorSpins),
+      contention_count_(0),
+      spin_acquired_count_(0),
+      blocked_count_(0),
+      idle_check_contention_count_(0) {
+  CHECK(owner == nullptr || owner == self || owner->IsSuspended());
+}
+
 int32_t Monitor::GetHashCode() {
   while (!HasHashCode()) {
     if (hash_code_.CompareAndSwap(0, mirror::Object::GenerateIdentityHashCode())) {
@@ -146,7 +295,6 @@ bool Monitor::Install(Thread* self) {
 }
 
 Monitor::~Monitor() {
-  MonitorPool::ReleaseMonitorId(monitor_id_);
   // Deflated monitors have a null object.
 }
 
@@ -219,22 +367,53 @@ void Monitor::Lock(Thread* self) {
       return;
     }
     // Contended.
+    ++contention_count_;
+    ++self->GetCounters()->monitor_contentions;
     const bool log_contention = (lock_profiling_threshold_ != 0);
-    uint64_t wait_start_ms = log_contention ? 0 : MilliTime();
+    // Contended entries are slow anyway, always time them for the latency histogram.
+    uint64_t wait_start_ns = NanoTime();
     mirror::ArtMethod* owners_method = locking_method_;
     uint32_t owners_dex_pc = locking_dex_pc_;
+    if (spin_limit_ != 0) {
+      // Owners holding the monitor briefly release it sooner than blocking would take.
+      const uint32_t spins = spin_limit_;
+      monitor_lock_.Unlock(self);
+      const bool released = SpinWhileOwned(self, spins);
+      monitor_lock_.Lock(self);
+      if (released && owner_ == nullptr) {
+        ++spin_acquired_count_;
+        spin_limit_ = (spin_limit_ < kMaxMonitorSpins / 2) ? 2 * spin_limit_ : kMaxMonitorSpins;
+        uint64_t wait_ns = NanoTime() - wait_start_ns;
+        self->GetLatencies()->monitor_contention_ns.Record(wait_ns);
+        if (log_contention) {
+          RecordContention(self, wait_ns, owners_method, owners_dex_pc);
+        }
+        continue;  // Take the monitor.
+      }
+      spin_limit_ /= 2;
+    } else if (blocked_count_ % kBlocksBeforeSpinRetry == 0) {
+      // The hold times may have changed.
+      spin_limit_ = kInitialMonitorSpins;
+    }
+    ++blocked_count_;
     // Do this before releasing the lock so that we don't get deflated.
     ++num_waiters_;
     monitor_lock_.Unlock(self);  // Let go of locks in order.
+    bool waited = false;
     {
       ScopedThreadStateChange tsc(self, kBlocked);  // Change to blocked and give up mutator_lock_.
       self->SetMonitorEnterObject(obj_);
       MutexLock mu2(self, monitor_lock_);  // Reacquire monitor_lock_ without mutator_lock_ for Wait.
       if (owner_ != NULL) {  // Did the owner_ give the lock up?
+        ScopedTrace trace(ATRACE_ENABLED()
+                          ? StringPrintf("Lock contention on a monitor lock (owner tid: %d)",
+                                         owner_->GetTid())
+                          : std::string());
         monitor_contenders_.Wait(self);  // Still contended so wait.
+        waited = true;
         // Woken from contention.
         if (log_contention) {
-          uint64_t wait_ms = MilliTime() - wait_start_ms;
+          uint64_t wait_ms = NsToMs(NanoTime() - wait_start_ns);
           uint32_t sample_percent;
           if (wait_ms >= lock_profiling_threshold_) {
             sample_percent = 100;
@@ -251,11 +430,31 @@ void Monitor::Lock(Thread* self) {
       }
       self->SetMonitorEnterObject(nullptr);
     }
+    uint64_t wait_ns = NanoTime() - wait_start_ns;
+    self->GetLatencies()->monitor_contention_ns.Record(wait_ns);
+    if (log_contention && waited) {
+      RecordContention(self, wait_ns, owners_method, owners_dex_pc);
+    }
     monitor_lock_.Lock(self);  // Reacquire locks in order.
     --num_waiters_;
   }
 }
 
+bool Monitor::SpinWhileOwned(Thread* self, uint32_t spins) NO_THREAD_SAFETY_ANALYSIS {
+  // Reading owner_ without monitor_lock_ is racy, the caller checks it again under the lock.
+  for (uint32_t i = 0; i != spins; ++i) {
+    if (owner_ == nullptr) {
+      return true;
+    }
+    if (UNLIKELY(self->TestAllFlags())) {
+      // Don't hold up a suspend all, the caller blocks in a suspendable state instead.
+      return false;
+    }
+    SpinPause();
+  }
+  return owner_ == nullptr;
+}
+
 static void ThrowIllegalMonitorStateExceptionF(const char* fmt, ...)
                                               __attribute__((format(printf, 1, 2)));
 
@@ -607,6 +806,9 @@ bool Monitor::Deflate(Thread* self, mirror::Object* obj) {
       obj->SetLockWord(LockWord(), false);
       VLOG(monitor) << "Deflated" << obj << " to empty lock word";
     }
+    VLOG(monitor) << "Monitor " << monitor << " was contended " << monitor->contention_count_
+        << " times, acquired by spinning " << monitor->spin_acquired_count_ << " times, blocked "
+        << monitor->blocked_count_ << " times";
     // The monitor is deflated, mark the object as nullptr so that we know to delete it during the
     // next GC.
     monitor->obj_ = nullptr;
@@ -614,6 +816,13 @@ bool Monitor::Deflate(Thread* self, mirror::Object* obj) {
   return true;
 }
 
+bool Monitor::IsIdle(Thread* self) {
+  MutexLock mu(self, monitor_lock_);
+  const bool contended = contention_count_ != idle_check_contention_count_;
+  idle_check_contention_count_ = contention_count_;
+  return !contended && owner_ == nullptr && num_waiters_ == 0 && wait_set_ == nullptr;
+}
+
 /*
  * Changes the shape of a monitor from thin to fat, preserving the internal lock state. The calling
  * thread must own the lock or the owner must be suspended. There's a race with other threads
@@ -623,17 +832,19 @@ void Monitor::Inflate(Thread* self, Thread* owner, mirror::Object* obj, int32_t
   DCHECK(self != NULL);
   DCHECK(obj != NULL);
   // Allocate and acquire a new monitor.
-  std::unique_ptr<Monitor> m(new Monitor(self, owner, obj, hash_code));
+  Monitor* m = MonitorPool::CreateMonitor(self, owner, obj, hash_code);
   if (m->Install(self)) {
     if (owner != nullptr) {
       VLOG(monitor) << "monitor: thread" << owner->GetThreadId()
-          << " created monitor " << m.get() << " for object " << obj;
+          << " created monitor " << m << " for object " << obj;
     } else {
       VLOG(monitor) << "monitor: Inflate with hashcode " << hash_code
-          << " created monitor " << m.get() << " for object " << obj;
+          << " created monitor " << m << " for object " << obj;
     }
-    Runtime::Current()->GetMonitorList()->Add(m.release());
+    Runtime::Current()->GetMonitorList()->Add(m);
     CHECK_EQ(obj->GetLockWord(true).GetState(), LockWord::kFatLocked);
+  } else {
+    MonitorPool::ReleaseMonitor(self, m);
   }
 }
 
@@ -680,6 +891,10 @@ static mirror::Object* FakeUnlock(mirror::Object* obj)
   return obj;
 }
 
+// Rounds of busy waiting, of 2, 4, ... 2^kThinLockBusySpinRounds spins, for a contended thin lock
+// before sleeping between attempts.
+static constexpr size_t kThinLockBusySpinRounds = 10;
+
 mirror::Object* Monitor::MonitorEnter(Thread* self, mirror::Object* obj) {
   DCHECK(self != NULL);
   DCHECK(obj != NULL);
@@ -717,7 +932,14 @@ mirror::Object* Monitor::MonitorEnter(Thread* self, mirror::Object* obj) {
           contention_count++;
           Runtime* runtime = Runtime::Current();
           if (contention_count <= runtime->GetMaxSpinsBeforeThinkLockInflation()) {
-            NanoSleep(1000);  // Sleep for 1us and re-attempt.
+            if (contention_count <= kThinLockBusySpinRounds) {
+              // Back off exponentially while busy waiting, most thin locks are held briefly.
+              for (size_t i = 0; i != (1u << contention_count); ++i) {
+                SpinPause();
+              }
+            } else {
+              NanoSleep(1000);  // Sleep for 1us and re-attempt.
+            }
           } else {
             contention_count = 0;
             InflateThinLocked(self, h_obj, lock_word, 0);
@@ -1041,7 +1263,7 @@ bool Monitor::IsLocked() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
 }
 
 void Monitor::TranslateLocation(mirror::ArtMethod* method, uint32_t dex_pc,
-                                const char** source_file, uint32_t* line_number) const {
+                                const char** source_file, uint32_t* line_number) {
   // If method is null, location is unknown
   if (method == NULL) {
     *source_file = "";
@@ -1072,8 +1294,12 @@ MonitorList::MonitorList()
 }
 
 MonitorList::~MonitorList() {
-  MutexLock mu(Thread::Current(), monitor_list_lock_);
-  STLDeleteElements(&list_);
+  Thread* self = Thread::Current();
+  MutexLock mu(self, monitor_list_lock_);
+  for (Monitor* m : list_) {
+    MonitorPool::ReleaseMonitor(self, m);
+  }
+  list_.clear();
 }
 
 void MonitorList::DisallowNewMonitors() {
@@ -1098,16 +1324,17 @@ void MonitorList::Add(Monitor* m) {
 }
 
 void MonitorList::SweepMonitorList(IsMarkedCallback* callback, void* arg) {
-  MutexLock mu(Thread::Current(), monitor_list_lock_);
+  Thread* self = Thread::Current();
+  MutexLock mu(self, monitor_list_lock_);
   for (auto it = list_.begin(); it != list_.end(); ) {
     Monitor* m = *it;
-    mirror::Object* obj = m->GetObject();
+    mirror::Object* obj = m->GetObject<kWithoutReadBarrier>();
     // The object of a monitor can be null if we have deflated it.
     mirror::Object* new_obj = obj != nullptr ? callback(obj, arg) : nullptr;
     if (new_obj == nullptr) {
       VLOG(monitor) << "freeing monitor " << m << " belonging to unmarked object "
-                    << m->GetObject();
-      delete m;
+                    << m->GetObject<kWithoutReadBarrier>();
+      MonitorPool::ReleaseMonitor(self, m);
       it = list_.erase(it);
     } else {
       m->SetObject(new_obj);
@@ -1132,6 +1359,25 @@ void MonitorList::DeflateMonitors() {
   SweepMonitorList(MonitorDeflateCallback, reinterpret_cast<Thread*>(self));
 }
 
+void MonitorList::DeflateIdleMonitors() {
+  Thread* self = Thread::Current();
+  Locks::mutator_lock_->AssertExclusiveHeld(self);
+  MutexLock mu(self, monitor_list_lock_);
+  size_t deflated_count = 0;
+  for (auto it = list_.begin(); it != list_.end(); ) {
+    Monitor* m = *it;
+    mirror::Object* obj = m->GetObject<kWithoutReadBarrier>();
+    if (obj != nullptr && m->IsIdle(self) && Monitor::Deflate(self, obj)) {
+      MonitorPool::ReleaseMonitor(self, m);
+      it = list_.erase(it);
+      ++deflated_count;
+    } else {
+      ++it;
+    }
+  }
+  VLOG(monitor) << "Deflated " << deflated_count << " idle monitors, " << list_.size() << " left";
+}
+
 MonitorInfo::MonitorInfo(mirror::Object* obj) : owner_(NULL), entry_count_(0) {
   DCHECK(obj != nullptr);
   LockWord lock_word = obj->GetLockWord(true);
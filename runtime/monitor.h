@@ -27,6 +27,8 @@
 #include "atomic.h"
 #include "base/mutex.h"
 #include "object_callbacks.h"
+#include "read_barrier.h"
+#include "read_barrier_option.h"
 #include "thread_state.h"
 
 namespace art {
@@ -48,11 +50,31 @@ class Monitor {
   // a lock word. See Runtime::max_spins_before_thin_lock_inflation_.
   constexpr static size_t kDefaultMaxSpinsBeforeThinLockInflation = 50;
 
+  // Bounds of the number of times a thread spins on a contended inflated monitor before blocking.
+  // The count adapts to how long the owners of the monitor recently held it: it doubles when
+  // spinning got the monitor and halves when it didn't.
+  constexpr static uint32_t kInitialMonitorSpins = 128;
+  constexpr static uint32_t kMaxMonitorSpins = 4096;
+  // Once spinning stopped paying off, the number of times a thread blocks on the monitor before
+  // spinning is tried again.
+  constexpr static uint32_t kBlocksBeforeSpinRetry = 64;
+
   ~Monitor();
 
   static bool IsSensitiveThread();
   static void Init(uint32_t lock_profiling_threshold, bool (*is_sensitive_thread_hook)());
 
+  // Dumps the total, count and maximum of the waits for inflated monitors by the class of the
+  // locked object and the method and dex pc locking it, with where the owners had locked the
+  // monitors. Only recorded with lock profiling, see -Xlockprofthreshold.
+  static void DumpContentionProfile(std::ostream& os)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Translates the provided method and pc into its declaring class' source file and line number.
+  static void TranslateLocation(mirror::ArtMethod* method, uint32_t pc,
+                                const char** source_file, uint32_t* line_number)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Return the thread id of the lock owner or 0 when there is no owner.
   static uint32_t GetLockOwnerThreadId(mirror::Object* obj)
       NO_THREAD_SAFETY_ANALYSIS;  // TODO: Reading lock owner without holding lock is racy.
@@ -92,7 +114,12 @@ class Monitor {
 
   static bool IsValidLockWord(LockWord lock_word);
 
+  // The GC reads obj_ without the read barrier when it sweeps or deflates the monitors.
+  template<ReadBarrierOption kReadBarrierOption = kWithReadBarrier>
   mirror::Object* GetObject() const SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (kReadBarrierOption == kWithReadBarrier) {
+      return ReadBarrier::BarrierForWeakRoot(obj_);
+    }
     return obj_;
   }
 
@@ -120,10 +147,17 @@ class Monitor {
   static bool Deflate(Thread* self, mirror::Object* obj)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Whether nobody owns or waits on the monitor and it wasn't contended since the previous call.
+  bool IsIdle(Thread* self) LOCKS_EXCLUDED(monitor_lock_);
+
  private:
   explicit Monitor(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_code)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // For the monitors allocated by the MonitorPool, which assigns their id.
+  Monitor(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_code, MonitorId id)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Install the monitor into its object, may fail if another thread installs a different monitor
   // first.
   bool Install(Thread* self)
@@ -151,6 +185,12 @@ class Monitor {
       LOCKS_EXCLUDED(monitor_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Spins up to `spins` times while the monitor is owned, without holding monitor_lock_. Returns
+  // true if the owner released the monitor. Gives up early if the thread is asked to suspend.
+  bool SpinWhileOwned(Thread* self, uint32_t spins)
+      LOCKS_EXCLUDED(monitor_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   static void DoNotify(Thread* self, mirror::Object* obj, bool notify_all)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -167,9 +207,9 @@ class Monitor {
       LOCKS_EXCLUDED(monitor_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  // Translates the provided method and pc into its declaring class' source file and line number.
-  void TranslateLocation(mirror::ArtMethod* method, uint32_t pc,
-                         const char** source_file, uint32_t* line_number) const
+  // Adds a wait of `self` for this monitor to the lock contention profile.
+  void RecordContention(Thread* self, uint64_t wait_ns, mirror::ArtMethod* owners_method,
+                        uint32_t owners_dex_pc)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   uint32_t GetOwnerThreadId();
@@ -208,8 +248,22 @@ class Monitor {
   // The denser encoded version of this monitor as stored in the lock word.
   MonitorId monitor_id_;
 
+  // How many times a contender spins before blocking, see kInitialMonitorSpins. Zero when
+  // spinning is off for the next kBlocksBeforeSpinRetry blocks.
+  uint32_t spin_limit_ GUARDED_BY(monitor_lock_);
+
+  // Contention statistics: how many times the monitor was found owned by another thread, and how
+  // many of those times spinning got it or the contender blocked.
+  uint32_t contention_count_ GUARDED_BY(monitor_lock_);
+  uint32_t spin_acquired_count_ GUARDED_BY(monitor_lock_);
+  uint32_t blocked_count_ GUARDED_BY(monitor_lock_);
+
+  // contention_count_ at the last IsIdle check.
+  uint32_t idle_check_contention_count_ GUARDED_BY(monitor_lock_);
+
   friend class MonitorInfo;
   friend class MonitorList;
+  friend class MonitorPool;
   friend class mirror::Object;
   DISALLOW_COPY_AND_ASSIGN(Monitor);
 };
@@ -227,6 +281,10 @@ class MonitorList {
   void AllowNewMonitors() LOCKS_EXCLUDED(monitor_list_lock_);
   void DeflateMonitors() LOCKS_EXCLUDED(monitor_list_lock_)
       EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Deflates the monitors which are idle since the previous call, see Monitor::IsIdle. Their
+  // objects are unlikely to be contended again soon.
+  void DeflateIdleMonitors() LOCKS_EXCLUDED(monitor_list_lock_)
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
 
  private:
   // During sweeping we may free an object and on a separate thread have an object created using
@@ -18,41 +18,131 @@
 
 #include "base/logging.h"
 #include "base/mutex-inl.h"
+#include "lock_word.h"
 #include "thread-inl.h"
 #include "monitor.h"
 
 namespace art {
 
-MonitorPool::MonitorPool() : allocated_ids_lock_("allocated monitor ids lock",
-                                                 LockLevel::kMonitorPoolLock) {
+#ifdef __LP64__
+
+MonitorPool::MonitorPool()
+    : lock_("monitor pool lock", LockLevel::kMonitorPoolLock),
+      chunks_(reinterpret_cast<uintptr_t>(new uint8_t*[kInitialChunkCapacity])),
+      num_chunks_(0), chunk_capacity_(kInitialChunkCapacity), free_list_(nullptr),
+      free_list_size_(0) {
 }
 
-Monitor* MonitorPool::LookupMonitorFromTable(MonitorId mon_id) {
-  ReaderMutexLock mu(Thread::Current(), allocated_ids_lock_);
-  return table_.Get(mon_id);
+MonitorPool::~MonitorPool() {
+  uint8_t** chunks = reinterpret_cast<uint8_t**>(chunks_.Load());
+  for (size_t i = 0; i < num_chunks_.Load(); ++i) {
+    delete[] chunks[i];
+  }
+  delete[] chunks;
+  for (uint8_t** old_chunks : old_chunk_arrays_) {
+    delete[] old_chunks;
+  }
 }
 
-MonitorId MonitorPool::AllocMonitorIdFromTable(Thread* self, Monitor* mon) {
-  WriterMutexLock mu(self, allocated_ids_lock_);
-  for (size_t i = 0; i < allocated_ids_.size(); ++i) {
-    if (!allocated_ids_[i]) {
-      allocated_ids_.set(i);
-      MonitorId mon_id = i + 1;  // Zero is reserved to mean "invalid".
-      table_.Put(mon_id, mon);
-      return mon_id;
-    }
-  }
-  LOG(FATAL) << "Out of internal monitor ids";
-  return 0;
+void MonitorPool::AllocateChunk() {
+  size_t num_chunks = num_chunks_.Load();
+  // The ids must fit in the lock word, beside its state.
+  static constexpr size_t kMaxChunks = (1U << (32 - LockWord::kStateSize)) / kMonitorsPerChunk;
+  if (UNLIKELY(num_chunks == kMaxChunks)) {
+    LOG(FATAL) << "Out of internal monitor ids";
+  }
+  uint8_t** chunks = reinterpret_cast<uint8_t**>(chunks_.Load());
+  if (num_chunks == chunk_capacity_) {
+    // Lookups may be reading the current array, publish a larger copy and keep the old one.
+    uint8_t** new_chunks = new uint8_t*[2 * chunk_capacity_];
+    std::copy(chunks, chunks + num_chunks, new_chunks);
+    QuasiAtomic::MembarStoreStore();
+    chunks_ = reinterpret_cast<uintptr_t>(new_chunks);
+    old_chunk_arrays_.push_back(chunks);
+    chunks = new_chunks;
+    chunk_capacity_ *= 2;
+  }
+  uint8_t* chunk = new uint8_t[kChunkSize];
+  chunks[num_chunks] = chunk;
+  // The monitors of the chunk are only looked up once one is installed in a lock word, after the
+  // chunk is published.
+  QuasiAtomic::MembarStoreStore();
+  num_chunks_ = num_chunks + 1;
+  // Link the monitors of the chunk in the free list, lowest id first.
+  for (size_t i = kMonitorsPerChunk; i != 0; --i) {
+    FreeMonitor* free_monitor =
+        reinterpret_cast<FreeMonitor*>(chunk + (i - 1) * kAlignedMonitorSize);
+    free_monitor->next = free_list_;
+    free_monitor->id = (num_chunks << kMonitorsPerChunkBits) + i;  // Zero is invalid.
+    free_list_ = free_monitor;
+  }
+  free_list_size_ += kMonitorsPerChunk;
 }
 
-void MonitorPool::ReleaseMonitorIdFromTable(MonitorId mon_id) {
-  WriterMutexLock mu(Thread::Current(), allocated_ids_lock_);
-  DCHECK(table_.Get(mon_id) != nullptr);
-  table_.erase(mon_id);
-  --mon_id;  // Zero is reserved to mean "invalid".
-  DCHECK(allocated_ids_[mon_id]) << mon_id;
-  allocated_ids_.reset(mon_id);
+void MonitorPool::RefillThreadCache(Thread* self) {
+  MutexLock mu(self, lock_);
+  if (free_list_size_ < kThreadCacheRefill) {
+    AllocateChunk();
+  }
+  FreeMonitor* head = free_list_;
+  FreeMonitor* tail = head;
+  for (size_t i = 1; i < kThreadCacheRefill; ++i) {
+    tail = tail->next;
+  }
+  free_list_ = tail->next;
+  free_list_size_ -= kThreadCacheRefill;
+  tail->next = reinterpret_cast<FreeMonitor*>(self->GetMonitorPoolCache());
+  self->SetMonitorPoolCache(head, self->GetMonitorPoolCacheSize() + kThreadCacheRefill);
 }
 
+Monitor* MonitorPool::CreateMonitorInPool(Thread* self, Thread* owner, mirror::Object* obj,
+                                          int32_t hash_code) {
+  if (UNLIKELY(self->GetMonitorPoolCache() == nullptr)) {
+    RefillThreadCache(self);
+  }
+  FreeMonitor* free_monitor = reinterpret_cast<FreeMonitor*>(self->GetMonitorPoolCache());
+  self->SetMonitorPoolCache(free_monitor->next, self->GetMonitorPoolCacheSize() - 1);
+  MonitorId id = free_monitor->id;
+  Monitor* monitor = new (free_monitor) Monitor(self, owner, obj, hash_code, id);
+  DCHECK_EQ(LookupMonitor(id), monitor);
+  return monitor;
+}
+
+void MonitorPool::ReleaseMonitorToPool(Thread* self, Monitor* monitor) {
+  MonitorId id = monitor->GetMonitorId();
+  DCHECK_EQ(LookupMonitor(id), monitor);
+  monitor->~Monitor();
+  FreeMonitor* free_monitor = reinterpret_cast<FreeMonitor*>(monitor);
+  free_monitor->id = id;
+  // The monitors are usually released by the thread running the GC, keep a few of them for its
+  // next inflations and return the others to the pool.
+  if (self != nullptr && self->GetMonitorPoolCacheSize() < kMaxThreadCacheSize) {
+    free_monitor->next = reinterpret_cast<FreeMonitor*>(self->GetMonitorPoolCache());
+    self->SetMonitorPoolCache(free_monitor, self->GetMonitorPoolCacheSize() + 1);
+    return;
+  }
+  MutexLock mu(self, lock_);
+  free_monitor->next = free_list_;
+  free_list_ = free_monitor;
+  ++free_list_size_;
+}
+
+void MonitorPool::ReleaseThreadCacheToPool(Thread* self) {
+  FreeMonitor* head = reinterpret_cast<FreeMonitor*>(self->GetMonitorPoolCache());
+  if (head == nullptr) {
+    return;
+  }
+  FreeMonitor* tail = head;
+  while (tail->next != nullptr) {
+    tail = tail->next;
+  }
+  MutexLock mu(self, lock_);
+  tail->next = free_list_;
+  free_list_ = head;
+  free_list_size_ += self->GetMonitorPoolCacheSize();
+  self->SetMonitorPoolCache(nullptr, 0);
+}
+
+#endif  // __LP64__
+
 }  // namespace art
@@ -20,17 +20,23 @@
 #include "monitor.h"
 
 #ifdef __LP64__
-#include <bitset>
 #include <stdint.h>
+#include <vector>
 
+#include "atomic.h"
 #include "runtime.h"
-#include "safe_map.h"
+#include "utils.h"
 #endif
 
 namespace art {
 
 // Abstraction to keep monitors small enough to fit in a lock word (32bits). On 32bit systems the
 // monitor id loses the alignment bits of the Monitor*.
+//
+// On 64bit systems the pool owns the memory of the monitors, which lives in chunks of
+// kMonitorsPerChunk monitors. The id of a monitor is its index in the chunks plus one, so that
+// looking a monitor up from a lock word is two loads and no lock. Threads allocate monitors from
+// a cache of free monitors of their own, refilled from the free list of the pool.
 class MonitorPool {
  public:
   static MonitorPool* Create() {
@@ -41,55 +47,108 @@ class MonitorPool {
 #endif
   }
 
-  static Monitor* MonitorFromMonitorId(MonitorId mon_id) {
+  static Monitor* CreateMonitor(Thread* self, Thread* owner, mirror::Object* obj,
+                                int32_t hash_code) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
 #ifndef __LP64__
-    return reinterpret_cast<Monitor*>(mon_id << 3);
+    return new Monitor(self, owner, obj, hash_code);
 #else
-    return Runtime::Current()->GetMonitorPool()->LookupMonitorFromTable(mon_id);
+    return Runtime::Current()->GetMonitorPool()->CreateMonitorInPool(self, owner, obj, hash_code);
 #endif
   }
 
-  static MonitorId MonitorIdFromMonitor(Monitor* mon) {
+  static void ReleaseMonitor(Thread* self, Monitor* monitor) {
 #ifndef __LP64__
-    return reinterpret_cast<MonitorId>(mon) >> 3;
+    UNUSED(self);
+    delete monitor;
 #else
-    return mon->GetMonitorId();
+    Runtime::Current()->GetMonitorPool()->ReleaseMonitorToPool(self, monitor);
 #endif
   }
 
-  static MonitorId CreateMonitorId(Thread* self, Monitor* mon) {
+  // Returns the free monitors cached by an exiting thread to the pool.
+  static void ReleaseThreadCache(Thread* self) {
 #ifndef __LP64__
     UNUSED(self);
-    return MonitorIdFromMonitor(mon);
 #else
-    return Runtime::Current()->GetMonitorPool()->AllocMonitorIdFromTable(self, mon);
+    Runtime::Current()->GetMonitorPool()->ReleaseThreadCacheToPool(self);
 #endif
   }
 
-  static void ReleaseMonitorId(MonitorId mon_id) {
+  static Monitor* MonitorFromMonitorId(MonitorId mon_id) {
 #ifndef __LP64__
-    UNUSED(mon_id);
+    return reinterpret_cast<Monitor*>(mon_id << 3);
 #else
-    Runtime::Current()->GetMonitorPool()->ReleaseMonitorIdFromTable(mon_id);
+    return Runtime::Current()->GetMonitorPool()->LookupMonitor(mon_id);
 #endif
   }
 
+  static MonitorId MonitorIdFromMonitor(Monitor* mon) {
+#ifndef __LP64__
+    return reinterpret_cast<MonitorId>(mon) >> 3;
+#else
+    return mon->GetMonitorId();
+#endif
+  }
+
+#ifdef __LP64__
+  ~MonitorPool();
+#endif
+
  private:
 #ifdef __LP64__
+  // A monitor slot which is not in use, linked in a free list.
+  struct FreeMonitor {
+    FreeMonitor* next;
+    MonitorId id;
+  };
+
+  static constexpr size_t kMonitorsPerChunkBits = 6;
+  static constexpr size_t kMonitorsPerChunk = 1 << kMonitorsPerChunkBits;
+  static constexpr size_t kAlignedMonitorSize = RoundUp(sizeof(Monitor), 8);
+  static constexpr size_t kChunkSize = kMonitorsPerChunk * kAlignedMonitorSize;
+  static constexpr size_t kInitialChunkCapacity = 8;
+  // Monitors moved between the free list of the pool and the cache of a thread at once.
+  static constexpr size_t kThreadCacheRefill = 16;
+  // The maximum size of the cache of a thread, released monitors beyond it go back to the pool.
+  static constexpr size_t kMaxThreadCacheSize = 2 * kThreadCacheRefill;
+
   MonitorPool();
 
-  Monitor* LookupMonitorFromTable(MonitorId mon_id);
+  Monitor* LookupMonitor(MonitorId mon_id) {
+    DCHECK_NE(mon_id, 0U);
+    size_t index = mon_id - 1;  // Zero is reserved to mean "invalid".
+    // The chunk array is only replaced by a larger copy, and the old arrays are kept alive, so
+    // this needs no lock.
+    uint8_t** chunks = reinterpret_cast<uint8_t**>(chunks_.Load());
+    DCHECK_LT(index >> kMonitorsPerChunkBits, num_chunks_.Load());
+    uint8_t* chunk = chunks[index >> kMonitorsPerChunkBits];
+    return reinterpret_cast<Monitor*>(
+        chunk + (index & (kMonitorsPerChunk - 1)) * kAlignedMonitorSize);
+  }
+
+  Monitor* CreateMonitorInPool(Thread* self, Thread* owner, mirror::Object* obj,
+                               int32_t hash_code)
+      LOCKS_EXCLUDED(lock_) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  void ReleaseMonitorToPool(Thread* self, Monitor* monitor) LOCKS_EXCLUDED(lock_);
 
-  MonitorId LookupMonitorIdFromTable(Monitor* mon);
+  void ReleaseThreadCacheToPool(Thread* self) LOCKS_EXCLUDED(lock_);
 
-  MonitorId AllocMonitorIdFromTable(Thread* self, Monitor* mon);
+  // Moves up to kThreadCacheRefill free monitors of the pool to the cache of self.
+  void RefillThreadCache(Thread* self) LOCKS_EXCLUDED(lock_);
 
-  void ReleaseMonitorIdFromTable(MonitorId mon_id);
+  // Adds a chunk of free monitors to the free list.
+  void AllocateChunk() EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
-  ReaderWriterMutex allocated_ids_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
-  static constexpr uint32_t kMaxMonitorId = 0xFFFF;
-  std::bitset<kMaxMonitorId> allocated_ids_ GUARDED_BY(allocated_ids_lock_);
-  SafeMap<MonitorId, Monitor*> table_ GUARDED_BY(allocated_ids_lock_);
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  // The array of chunks, as a uintptr_t since Atomic has no pointer specialization.
+  Atomic<uintptr_t> chunks_;
+  Atomic<size_t> num_chunks_;
+  size_t chunk_capacity_ GUARDED_BY(lock_);
+  // The chunk arrays replaced by larger ones, which concurrent lookups may still read.
+  std::vector<uint8_t**> old_chunk_arrays_ GUARDED_BY(lock_);
+  FreeMonitor* free_list_ GUARDED_BY(lock_);
+  size_t free_list_size_ GUARDED_BY(lock_);
 #endif
 };
 
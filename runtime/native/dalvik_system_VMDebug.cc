@@ -17,6 +17,8 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <sstream>
+
 #include "class_linker.h"
 #include "common_throws.h"
 #include "debugger.h"
@@ -28,9 +30,11 @@
 #include "hprof/hprof.h"
 #include "jni_internal.h"
 #include "mirror/class.h"
+#include "monitor.h"
 #include "ScopedLocalRef.h"
 #include "ScopedUtfChars.h"
 #include "scoped_fast_native_object_access.h"
+#include "thread_list.h"
 #include "trace.h"
 #include "well_known_classes.h"
 
@@ -77,7 +81,7 @@ static void VMDebug_resetAllocCount(JNIEnv*, jclass, jint kinds) {
 
 static void VMDebug_startMethodTracingDdmsImpl(JNIEnv*, jclass, jint bufferSize, jint flags,
                                                jboolean samplingEnabled, jint intervalUs) {
-  Trace::Start("[DDMS]", -1, bufferSize, flags, true, samplingEnabled, intervalUs);
+  Trace::Start("[DDMS]", -1, bufferSize, flags, true, samplingEnabled, intervalUs, false);
 }
 
 static void VMDebug_startMethodTracingFd(JNIEnv* env, jclass, jstring javaTraceFilename,
@@ -101,7 +105,8 @@ static void VMDebug_startMethodTracingFd(JNIEnv* env, jclass, jstring javaTraceF
   if (traceFilename.c_str() == NULL) {
     return;
   }
-  Trace::Start(traceFilename.c_str(), fd, bufferSize, flags, false, samplingEnabled, intervalUs);
+  Trace::Start(traceFilename.c_str(), fd, bufferSize, flags, false, samplingEnabled, intervalUs,
+               false);
 }
 
 static void VMDebug_startMethodTracingFilename(JNIEnv* env, jclass, jstring javaTraceFilename,
@@ -111,7 +116,8 @@ static void VMDebug_startMethodTracingFilename(JNIEnv* env, jclass, jstring java
   if (traceFilename.c_str() == NULL) {
     return;
   }
-  Trace::Start(traceFilename.c_str(), -1, bufferSize, flags, false, samplingEnabled, intervalUs);
+  Trace::Start(traceFilename.c_str(), -1, bufferSize, flags, false, samplingEnabled, intervalUs,
+               false);
 }
 
 static jint VMDebug_getMethodTracingMode(JNIEnv*, jclass) {
@@ -323,6 +329,54 @@ static void VMDebug_getHeapSpaceStats(JNIEnv* env, jclass, jlongArray data) {
   env->ReleasePrimitiveArrayCritical(data, arr, 0);
 }
 
+// Returns the GC metrics (pause histograms, allocation and freed bytes, heap growth) as
+// "name value" lines, see Heap::DumpGcMetrics.
+static jstring VMDebug_getGcMetrics(JNIEnv* env, jclass) {
+  std::ostringstream os;
+  Runtime::Current()->GetHeap()->DumpGcMetrics(os);
+  return env->NewStringUTF(os.str().c_str());
+}
+
+// Returns the classes whose instances take the most bytes, with their instance count and retained
+// bytes estimate, see Heap::DumpClassHistogram.
+static jstring VMDebug_getClassHistogram(JNIEnv* env, jclass, jint max_classes) {
+  std::ostringstream os;
+  Runtime::Current()->GetHeap()->DumpClassHistogram(os, max_classes < 0 ? 0 : max_classes);
+  return env->NewStringUTF(os.str().c_str());
+}
+
+// Returns the waits for contended monitors by lock site, see Monitor::DumpContentionProfile.
+// Empty unless lock profiling is enabled.
+static jstring VMDebug_getLockContentionProfile(JNIEnv* env, jclass) {
+  std::ostringstream os;
+  {
+    ScopedObjectAccess soa(env);
+    Monitor::DumpContentionProfile(os);
+  }
+  return env->NewStringUTF(os.str().c_str());
+}
+
+// Returns the runtime counters of each thread, see ThreadList::DumpRuntimeCounters.
+static jstring VMDebug_getRuntimeCounters(JNIEnv* env, jclass) {
+  std::ostringstream os;
+  Runtime::Current()->GetThreadList()->DumpRuntimeCounters(os);
+  return env->NewStringUTF(os.str().c_str());
+}
+
+// Returns the distributions of the runtime latencies, see ThreadList::DumpRuntimeLatencies.
+static jstring VMDebug_getRuntimeLatencies(JNIEnv* env, jclass) {
+  std::ostringstream os;
+  Runtime::Current()->GetThreadList()->DumpRuntimeLatencies(os);
+  return env->NewStringUTF(os.str().c_str());
+}
+
+// Returns the time spent in each phase of the runtime startup, see Runtime::GetStartupTimings.
+static jstring VMDebug_getStartupTimings(JNIEnv* env, jclass) {
+  std::ostringstream os;
+  Runtime::Current()->GetStartupTimings().Dump(os);
+  return env->NewStringUTF(os.str().c_str());
+}
+
 static JNINativeMethod gMethods[] = {
   NATIVE_METHOD(VMDebug, countInstancesOfClass, "(Ljava/lang/Class;Z)J"),
   NATIVE_METHOD(VMDebug, crash, "()V"),
@@ -330,14 +384,20 @@ static JNINativeMethod gMethods[] = {
   NATIVE_METHOD(VMDebug, dumpHprofDataDdms, "()V"),
   NATIVE_METHOD(VMDebug, dumpReferenceTables, "()V"),
   NATIVE_METHOD(VMDebug, getAllocCount, "(I)I"),
+  NATIVE_METHOD(VMDebug, getClassHistogram, "(I)Ljava/lang/String;"),
+  NATIVE_METHOD(VMDebug, getGcMetrics, "()Ljava/lang/String;"),
   NATIVE_METHOD(VMDebug, getHeapSpaceStats, "([J)V"),
   NATIVE_METHOD(VMDebug, getInstructionCount, "([I)V"),
   NATIVE_METHOD(VMDebug, getLoadedClassCount, "!()I"),
+  NATIVE_METHOD(VMDebug, getLockContentionProfile, "()Ljava/lang/String;"),
   NATIVE_METHOD(VMDebug, getVmFeatureList, "()[Ljava/lang/String;"),
   NATIVE_METHOD(VMDebug, infopoint, "(I)V"),
   NATIVE_METHOD(VMDebug, isDebuggerConnected, "!()Z"),
   NATIVE_METHOD(VMDebug, isDebuggingEnabled, "!()Z"),
   NATIVE_METHOD(VMDebug, getMethodTracingMode, "()I"),
+  NATIVE_METHOD(VMDebug, getRuntimeCounters, "()Ljava/lang/String;"),
+  NATIVE_METHOD(VMDebug, getRuntimeLatencies, "()Ljava/lang/String;"),
+  NATIVE_METHOD(VMDebug, getStartupTimings, "()Ljava/lang/String;"),
   NATIVE_METHOD(VMDebug, lastDebuggerActivity, "!()J"),
   NATIVE_METHOD(VMDebug, printLoadedClasses, "!(I)V"),
   NATIVE_METHOD(VMDebug, resetAllocCount, "(I)V"),
@@ -182,6 +182,26 @@ static void VMRuntime_registerNativeFree(JNIEnv* env, jobject, jint bytes) {
   Runtime::Current()->GetHeap()->RegisterNativeFree(env, bytes);
 }
 
+// Has the GC call the native function at free_function with native_ptr once javaObject is
+// unreachable, see gc::NativeCleaner.
+static void VMRuntime_registerNativeCleaner(JNIEnv* env, jobject, jobject javaObject,
+                                            jlong free_function, jlong native_ptr) {
+  ScopedObjectAccess soa(env);
+  if (UNLIKELY(javaObject == nullptr)) {
+    ThrowNullPointerException(nullptr, "object == null");
+    return;
+  }
+  if (UNLIKELY(free_function == 0)) {
+    ThrowIllegalArgumentException(nullptr, "freeFunction == 0");
+    return;
+  }
+  mirror::Object* obj = soa.Decode<mirror::Object*>(javaObject);
+  auto* function = reinterpret_cast<gc::NativeCleaner::NativeFreeFunction*>(
+      static_cast<uintptr_t>(free_function));
+  Runtime::Current()->GetHeap()->GetNativeCleaner()->Register(
+      soa.Self(), obj, function, reinterpret_cast<void*>(static_cast<uintptr_t>(native_ptr)));
+}
+
 static void VMRuntime_updateProcessState(JNIEnv* env, jobject, jint process_state) {
   Runtime::Current()->GetHeap()->UpdateProcessState(static_cast<gc::ProcessState>(process_state));
   Runtime::Current()->UpdateProfilerState(process_state);
@@ -524,6 +544,7 @@ static JNINativeMethod gMethods[] = {
   NATIVE_METHOD(VMRuntime, setTargetSdkVersionNative, "(I)V"),
   NATIVE_METHOD(VMRuntime, registerNativeAllocation, "(I)V"),
   NATIVE_METHOD(VMRuntime, registerNativeFree, "(I)V"),
+  NATIVE_METHOD(VMRuntime, registerNativeCleaner, "(Ljava/lang/Object;JJ)V"),
   NATIVE_METHOD(VMRuntime, updateProcessState, "(I)V"),
   NATIVE_METHOD(VMRuntime, startJitCompilation, "()V"),
   NATIVE_METHOD(VMRuntime, trimHeap, "()V"),
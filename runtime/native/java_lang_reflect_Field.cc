@@ -94,6 +94,11 @@ static bool CheckReceiver(const ScopedFastNativeObjectAccess& soa, jobject j_rcv
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   soa.Self()->AssertThreadSuspensionIsAllowable();
   if (f->IsStatic()) {
+    mirror::Class* declaring_class = f->GetDeclaringClass();
+    if (LIKELY(declaring_class->IsInitialized())) {
+      *class_or_rcvr = declaring_class;
+      return true;
+    }
     StackHandleScope<1> hs(soa.Self());
     Handle<mirror::Class> h_klass(hs.NewHandle(f->GetDeclaringClass()));
     if (UNLIKELY(!Runtime::Current()->GetClassLinker()->EnsureInitialized(h_klass, true, true))) {
@@ -271,7 +276,10 @@ static void Field_set(JNIEnv* env, jobject javaField, jobject javaObj, jobject j
     FieldHelper fh(f);
     const char* field_type_desciptor = fh.GetTypeDescriptor();
     field_prim_type = Primitive::GetType(field_type_desciptor[0]);
-    if (field_prim_type == Primitive::kPrimNot) {
+    if (field_prim_type == Primitive::kPrimNot && javaValue == nullptr) {
+      // Null can be stored in any reference field, don't resolve its type.
+      field_type = nullptr;
+    } else if (field_prim_type == Primitive::kPrimNot) {
       StackHandleScope<1> hs(soa.Self());
       HandleWrapper<mirror::Object> h(hs.NewHandleWrapper(&o));
       // May cause resolution.
@@ -289,7 +297,8 @@ static void Field_set(JNIEnv* env, jobject javaField, jobject javaObj, jobject j
   // Unbox the value, if necessary.
   mirror::Object* boxed_value = soa.Decode<mirror::Object*>(javaValue);
   JValue unboxed_value;
-  if (!UnboxPrimitiveForField(boxed_value, field_type, f, &unboxed_value)) {
+  if (field_type != nullptr &&
+      !UnboxPrimitiveForField(boxed_value, field_type, f, &unboxed_value)) {
     DCHECK(soa.Self()->IsExceptionPending());
     return;
   }
@@ -22,7 +22,7 @@
 namespace art {
 
 const uint8_t OatHeader::kOatMagic[] = { 'o', 'a', 't', '\n' };
-const uint8_t OatHeader::kOatVersion[] = { '0', '2', '8', '\0' };
+const uint8_t OatHeader::kOatVersion[] = { '0', '3', '2', '\0' };
 
 OatHeader::OatHeader() {
   memset(this, 0, sizeof(*this));
@@ -30,6 +30,7 @@ OatHeader::OatHeader() {
 
 OatHeader::OatHeader(InstructionSet instruction_set,
                      const InstructionSetFeatures& instruction_set_features,
+                     uint32_t compiler_options_checksum,
                      const std::vector<const DexFile*>* dex_files,
                      uint32_t image_file_location_oat_checksum,
                      uint32_t image_file_location_oat_data_begin,
@@ -46,6 +47,9 @@ OatHeader::OatHeader(InstructionSet instruction_set,
   instruction_set_features_ = instruction_set_features;
   UpdateChecksum(&instruction_set_features_, sizeof(instruction_set_features_));
 
+  compiler_options_checksum_ = compiler_options_checksum;
+  UpdateChecksum(&compiler_options_checksum_, sizeof(compiler_options_checksum_));
+
   dex_file_count_ = dex_files->size();
   UpdateChecksum(&dex_file_count_, sizeof(dex_file_count_));
 
@@ -71,6 +75,10 @@ OatHeader::OatHeader(InstructionSet instruction_set,
   quick_imt_conflict_trampoline_offset_ = 0;
   quick_resolution_trampoline_offset_ = 0;
   quick_to_interpreter_bridge_offset_ = 0;
+  startup_maps_offset_ = 0;
+  startup_maps_size_ = 0;
+  startup_code_offset_ = 0;
+  startup_code_size_ = 0;
 }
 
 bool OatHeader::IsValid() const {
@@ -109,6 +117,11 @@ const InstructionSetFeatures& OatHeader::GetInstructionSetFeatures() const {
   return instruction_set_features_;
 }
 
+uint32_t OatHeader::GetCompilerOptionsChecksum() const {
+  CHECK(IsValid());
+  return compiler_options_checksum_;
+}
+
 uint32_t OatHeader::GetExecutableOffset() const {
   DCHECK(IsValid());
   DCHECK_ALIGNED(executable_offset_, kPageSize);
@@ -317,6 +330,46 @@ void OatHeader::SetQuickToInterpreterBridgeOffset(uint32_t offset) {
   UpdateChecksum(&quick_to_interpreter_bridge_offset_, sizeof(offset));
 }
 
+uint32_t OatHeader::GetStartupMapsOffset() const {
+  DCHECK(IsValid());
+  return startup_maps_offset_;
+}
+
+uint32_t OatHeader::GetStartupMapsSize() const {
+  DCHECK(IsValid());
+  return startup_maps_size_;
+}
+
+void OatHeader::SetStartupMaps(uint32_t offset, uint32_t size) {
+  DCHECK(IsValid());
+  DCHECK_EQ(startup_maps_size_, 0U) << offset;
+
+  startup_maps_offset_ = offset;
+  UpdateChecksum(&startup_maps_offset_, sizeof(offset));
+  startup_maps_size_ = size;
+  UpdateChecksum(&startup_maps_size_, sizeof(size));
+}
+
+uint32_t OatHeader::GetStartupCodeOffset() const {
+  DCHECK(IsValid());
+  return startup_code_offset_;
+}
+
+uint32_t OatHeader::GetStartupCodeSize() const {
+  DCHECK(IsValid());
+  return startup_code_size_;
+}
+
+void OatHeader::SetStartupCode(uint32_t offset, uint32_t size) {
+  DCHECK(IsValid());
+  DCHECK_EQ(startup_code_size_, 0U) << offset;
+
+  startup_code_offset_ = offset;
+  UpdateChecksum(&startup_code_offset_, sizeof(offset));
+  startup_code_size_ = size;
+  UpdateChecksum(&startup_code_size_, sizeof(size));
+}
+
 uint32_t OatHeader::GetImageFileLocationOatChecksum() const {
   CHECK(IsValid());
   return image_file_location_oat_checksum_;
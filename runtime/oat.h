@@ -34,6 +34,7 @@ class PACKED(4) OatHeader {
   OatHeader();
   OatHeader(InstructionSet instruction_set,
             const InstructionSetFeatures& instruction_set_features,
+            uint32_t compiler_options_checksum,
             const std::vector<const DexFile*>* dex_files,
             uint32_t image_file_location_oat_checksum,
             uint32_t image_file_location_oat_data_begin,
@@ -84,8 +85,19 @@ class PACKED(4) OatHeader {
   uint32_t GetQuickToInterpreterBridgeOffset() const;
   void SetQuickToInterpreterBridgeOffset(uint32_t offset);
 
+  // The ranges of the maps and of the code of the methods laid out before the cold ones, which
+  // the runtime reads ahead when it opens the oat file. Empty without a profile.
+  uint32_t GetStartupMapsOffset() const;
+  uint32_t GetStartupMapsSize() const;
+  void SetStartupMaps(uint32_t offset, uint32_t size);
+  uint32_t GetStartupCodeOffset() const;
+  uint32_t GetStartupCodeSize() const;
+  void SetStartupCode(uint32_t offset, uint32_t size);
+
   InstructionSet GetInstructionSet() const;
   const InstructionSetFeatures& GetInstructionSetFeatures() const;
+  // A checksum of the compiler options the code was generated with.
+  uint32_t GetCompilerOptionsChecksum() const;
   uint32_t GetImageFileLocationOatChecksum() const;
   uint32_t GetImageFileLocationOatDataBegin() const;
   uint32_t GetImageFileLocationSize() const;
@@ -99,6 +111,7 @@ class PACKED(4) OatHeader {
 
   InstructionSet instruction_set_;
   InstructionSetFeatures instruction_set_features_;
+  uint32_t compiler_options_checksum_;
   uint32_t dex_file_count_;
   uint32_t executable_offset_;
   uint32_t interpreter_to_interpreter_bridge_offset_;
@@ -112,6 +125,11 @@ class PACKED(4) OatHeader {
   uint32_t quick_resolution_trampoline_offset_;
   uint32_t quick_to_interpreter_bridge_offset_;
 
+  uint32_t startup_maps_offset_;
+  uint32_t startup_maps_size_;
+  uint32_t startup_code_offset_;
+  uint32_t startup_code_size_;
+
   uint32_t image_file_location_oat_checksum_;
   uint32_t image_file_location_oat_data_begin_;
   uint32_t image_file_location_size_;
@@ -17,6 +17,7 @@
 #include "oat_file.h"
 
 #include <dlfcn.h>
+#include <sys/mman.h>
 
 #include "base/bit_vector.h"
 #include "base/stl_util.h"
@@ -28,6 +29,7 @@
 #include "mirror/class.h"
 #include "mirror/object-inl.h"
 #include "os.h"
+#include "type_lookup_table.h"
 #include "utils.h"
 #include "vmap_table.h"
 
@@ -37,14 +39,14 @@ void OatFile::CheckLocation(const std::string& location) {
   CHECK(!location.empty());
 }
 
-OatFile* OatFile::OpenMemory(std::vector<uint8_t>& oat_contents,
+OatFile* OatFile::OpenMemory(const byte* oat_contents, size_t size,
                              const std::string& location,
                              std::string* error_msg) {
-  CHECK(!oat_contents.empty()) << location;
+  CHECK_NE(size, 0U) << location;
   CheckLocation(location);
   std::unique_ptr<OatFile> oat_file(new OatFile(location));
-  oat_file->begin_ = &oat_contents[0];
-  oat_file->end_ = &oat_contents[oat_contents.size()];
+  oat_file->begin_ = oat_contents;
+  oat_file->end_ = oat_contents + size;
   return oat_file->Setup(error_msg) ? oat_file.release() : nullptr;
 }
 
@@ -93,6 +95,7 @@ OatFile* OatFile::OpenDlopen(const std::string& elf_filename,
   if (!success) {
     return nullptr;
   }
+  oat_file->AdviseStartupRanges();
   return oat_file.release();
 }
 
@@ -108,9 +111,30 @@ OatFile* OatFile::OpenElfFile(File* file,
     CHECK(!error_msg->empty());
     return nullptr;
   }
+  if (executable) {
+    oat_file->AdviseStartupRanges();
+  }
   return oat_file.release();
 }
 
+static void AdviseWillNeed(const byte* begin, size_t size) {
+  if (size == 0) {
+    return;
+  }
+  byte* aligned_begin = AlignDown(const_cast<byte*>(begin), kPageSize);
+  size_t aligned_size = RoundUp(begin + size - aligned_begin, kPageSize);
+  if (madvise(aligned_begin, aligned_size, MADV_WILLNEED) != 0) {
+    PLOG(WARNING) << "madvise(" << reinterpret_cast<void*>(aligned_begin) << ", " << aligned_size
+                  << ", MADV_WILLNEED) failed";
+  }
+}
+
+void OatFile::AdviseStartupRanges() const {
+  const OatHeader& oat_header = GetOatHeader();
+  AdviseWillNeed(Begin() + oat_header.GetStartupMapsOffset(), oat_header.GetStartupMapsSize());
+  AdviseWillNeed(Begin() + oat_header.GetStartupCodeOffset(), oat_header.GetStartupCodeSize());
+}
+
 OatFile::OatFile(const std::string& location)
     : location_(location), begin_(NULL), end_(NULL), dlopen_handle_(NULL) {
   CHECK(!location_.empty());
@@ -268,6 +292,15 @@ bool OatFile::Setup(std::string* error_msg) {
       return false;
     }
 
+    uint32_t lookup_table_offset = *reinterpret_cast<const uint32_t*>(oat);
+    oat += sizeof(lookup_table_offset);
+    if (UNLIKELY(oat > End())) {
+      *error_msg = StringPrintf("In oat file '%s' found OatDexFile #%zd for '%s' truncated "
+                                " after lookup table offset", GetLocation().c_str(), i,
+                                dex_file_location.c_str());
+      return false;
+    }
+
     const uint8_t* dex_file_pointer = Begin() + dex_file_offset;
     if (UNLIKELY(!DexFile::IsMagicValid(dex_file_pointer))) {
       *error_msg = StringPrintf("In oat file '%s' found OatDexFile #%zd for '%s' with invalid "
@@ -292,10 +325,25 @@ bool OatFile::Setup(std::string* error_msg) {
       return false;
     }
 
+    const uint8_t* lookup_table_data = nullptr;
+    if (lookup_table_offset != 0u) {
+      if (UNLIKELY(!TypeLookupTable::SupportedSize(header->class_defs_size_) ||
+                   lookup_table_offset > Size() ||
+                   TypeLookupTable::RawDataLength(header->class_defs_size_) >
+                       Size() - lookup_table_offset)) {
+        *error_msg = StringPrintf("In oat file '%s' found OatDexFile #%zd for '%s' with invalid "
+                                  "lookup table offset %u", GetLocation().c_str(), i,
+                                  dex_file_location.c_str(), lookup_table_offset);
+        return false;
+      }
+      lookup_table_data = Begin() + lookup_table_offset;
+    }
+
     oat_dex_files_.Put(dex_file_location, new OatDexFile(this,
                                                          dex_file_location,
                                                          dex_file_checksum,
                                                          dex_file_pointer,
+                                                         lookup_table_data,
                                                          methods_offsets_pointer));
   }
   return true;
@@ -357,11 +405,13 @@ OatFile::OatDexFile::OatDexFile(const OatFile* oat_file,
                                 const std::string& dex_file_location,
                                 uint32_t dex_file_location_checksum,
                                 const byte* dex_file_pointer,
+                                const uint8_t* lookup_table_data,
                                 const uint32_t* oat_class_offsets_pointer)
     : oat_file_(oat_file),
       dex_file_location_(dex_file_location),
       dex_file_location_checksum_(dex_file_location_checksum),
       dex_file_pointer_(dex_file_pointer),
+      lookup_table_data_(lookup_table_data),
       oat_class_offsets_pointer_(oat_class_offsets_pointer) {}
 
 OatFile::OatDexFile::~OatDexFile() {}
@@ -372,7 +422,7 @@ size_t OatFile::OatDexFile::FileSize() const {
 
 const DexFile* OatFile::OatDexFile::OpenDexFile(std::string* error_msg) const {
   return DexFile::Open(dex_file_pointer_, FileSize(), dex_file_location_,
-                       dex_file_location_checksum_, error_msg);
+                       dex_file_location_checksum_, lookup_table_data_, error_msg);
 }
 
 OatFile::OatClass OatFile::OatDexFile::GetOatClass(uint16_t class_def_index) const {
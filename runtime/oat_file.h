@@ -52,8 +52,9 @@ class OatFile {
   // file descriptor for patching.
   static OatFile* OpenWritable(File* file, const std::string& location, std::string* error_msg);
 
-  // Open an oat file backed by a std::vector with the given location.
-  static OatFile* OpenMemory(std::vector<uint8_t>& oat_contents,
+  // Open an oat file backed by `size` bytes of memory at `oat_contents` with the given location.
+  // The memory must outlive the OatFile.
+  static OatFile* OpenMemory(const byte* oat_contents, size_t size,
                              const std::string& location,
                              std::string* error_msg);
 
@@ -204,12 +205,15 @@ class OatFile {
                const std::string& dex_file_location,
                uint32_t dex_file_checksum,
                const byte* dex_file_pointer,
+               const uint8_t* lookup_table_data,
                const uint32_t* oat_class_offsets_pointer);
 
     const OatFile* oat_file_;
     std::string dex_file_location_;
     uint32_t dex_file_location_checksum_;
     const byte* dex_file_pointer_;
+    // The TypeLookupTable of the dex file, null if dex2oat didn't write one.
+    const uint8_t* lookup_table_data_;
     const uint32_t* oat_class_offsets_pointer_;
 
     friend class OatFile;
@@ -247,6 +251,10 @@ class OatFile {
                    std::string* error_msg);
   bool Setup(std::string* error_msg);
 
+  // Starts reading in the maps and code the profile marked as used at startup, so that running
+  // them doesn't wait on a page fault for each of their pages.
+  void AdviseStartupRanges() const;
+
   const byte* Begin() const;
   const byte* End() const;
 
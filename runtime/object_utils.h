@@ -192,7 +192,7 @@ class MethodHelper {
       Runtime* runtime = Runtime::Current();
       if (method_ == runtime->GetResolutionMethod()) {
         return "<runtime internal resolution method>";
-      } else if (method_ == runtime->GetImtConflictMethod()) {
+      } else if (method_->IsImtConflictMethod()) {
         return "<runtime internal imt conflict method>";
       } else if (method_ == runtime->GetCalleeSaveMethod(Runtime::kSaveAll)) {
         return "<runtime internal callee-save all registers method>";
@@ -20,6 +20,7 @@
 #endif
 
 #include "debugger.h"
+#include "jit/jit.h"
 #include "monitor.h"
 
 namespace art {
@@ -169,6 +170,7 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
   }
   // -Xcheck:jni is off by default for regular builds but on by default in debug builds.
   check_jni_ = kIsDebugBuild;
+  check_jni_sampling_interval_ = 1;
 
   heap_initial_size_ = gc::Heap::kDefaultInitialSize;
   heap_maximum_size_ = gc::Heap::kDefaultMaximumSize;
@@ -176,11 +178,13 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
   heap_max_free_ = gc::Heap::kDefaultMaxFree;
   heap_target_utilization_ = gc::Heap::kDefaultTargetUtilization;
   foreground_heap_growth_multiplier_ = gc::Heap::kDefaultHeapGrowthMultiplier;
+  heap_target_gc_time_ratio_ = gc::Heap::kDefaultTargetGcTimeRatio;
   heap_growth_limit_ = 0;  // 0 means no growth limit .
   // Default to number of processors minus one since the main GC thread also does work.
   parallel_gc_threads_ = sysconf(_SC_NPROCESSORS_CONF) - 1;
   // Only the main GC thread, no workers.
   conc_gc_threads_ = 0;
+  pin_gc_threads_ = false;
   // The default GC type is set in makefiles.
 #if ART_DEFAULT_GC_TYPE_IS_CMS
   collector_type_ = gc::kCollectorTypeCMS;
@@ -196,8 +200,10 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
   background_collector_type_ = gc::kCollectorTypeNone;
   stack_size_ = 0;  // 0 means default.
   max_spins_before_thin_lock_inflation_ = Monitor::kDefaultMaxSpinsBeforeThinLockInflation;
+  deflate_idle_monitors_ = false;
   low_memory_mode_ = false;
   use_tlab_ = false;
+  use_huge_pages_ = false;
   verify_pre_gc_heap_ = false;
   // Pre sweeping is the one that usually fails if the GC corrupted the heap.
   verify_pre_sweeping_heap_ = kIsDebugBuild;
@@ -205,6 +211,7 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
   verify_pre_gc_rosalloc_ = kIsDebugBuild;
   verify_pre_sweeping_rosalloc_ = false;
   verify_post_gc_rosalloc_ = false;
+  sampled_verification_budget_ = 0;
 
   compiler_callbacks_ = nullptr;
   is_zygote_ = false;
@@ -220,6 +227,7 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
   long_pause_log_threshold_ = gc::Heap::kDefaultLongPauseLogThreshold;
   long_gc_log_threshold_ = gc::Heap::kDefaultLongGCLogThreshold;
   dump_gc_performance_on_shutdown_ = false;
+  dump_startup_timings_ = false;
   ignore_max_footprint_ = false;
 
   lock_profiling_threshold_ = 0;
@@ -246,6 +254,8 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
   method_trace_ = false;
   method_trace_file_ = "/data/method-trace-file.bin";
   method_trace_file_size_ = 10 * MB;
+  method_trace_stream_ = false;
+  hprof_fork_ = false;
 
   profile_ = false;
   profile_period_s_ = 10;           // Seconds.
@@ -253,7 +263,15 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
   profile_interval_us_ = 500;       // Microseconds.
   profile_backoff_coefficient_ = 2.0;
   profile_start_immediately_ = true;
+  profile_hw_counters_ = false;
   profile_clock_source_ = kDefaultProfilerClockSource;
+  // 0 means no allocation sampling.
+  allocation_sampling_interval_ = 0;
+
+  use_jit_ = false;
+  jit_compile_threshold_ = jit::Jit::kDefaultCompileThreshold;
+  perf_map_ = false;
+  background_dex2oat_ = false;
 
   verify_ = true;
   image_isa_ = kRuntimeISA;
@@ -373,6 +391,10 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
       if (!ParseDouble(option, '=', 0.1, 0.9, &heap_target_utilization_)) {
         return false;
       }
+    } else if (StartsWith(option, "-XX:HeapTargetGcTimeRatio=")) {
+      if (!ParseDouble(option, '=', 0.01, 0.5, &heap_target_gc_time_ratio_)) {
+        return false;
+      }
     } else if (StartsWith(option, "-XX:ForegroundHeapGrowthMultiplier=")) {
       if (!ParseDouble(option, '=', 0.1, 10.0, &foreground_heap_growth_multiplier_)) {
         return false;
@@ -385,6 +407,8 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
       if (!ParseUnsignedInteger(option, '=', &conc_gc_threads_)) {
         return false;
       }
+    } else if (option == "-XX:PinGCThreads") {
+      pin_gc_threads_ = true;
     } else if (StartsWith(option, "-Xss")) {
       size_t size = ParseMemoryOption(option.substr(strlen("-Xss")).c_str(), 1);
       if (size == 0) {
@@ -392,10 +416,20 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
         return false;
       }
       stack_size_ = size;
+    } else if (StartsWith(option, "-XX:CheckJniSamplingInterval=")) {
+      if (!ParseUnsignedInteger(option, '=', &check_jni_sampling_interval_)) {
+        return false;
+      }
+      if (check_jni_sampling_interval_ == 0) {
+        Usage("-XX:CheckJniSamplingInterval must be at least 1\n");
+        return false;
+      }
     } else if (StartsWith(option, "-XX:MaxSpinsBeforeThinLockInflation=")) {
       if (!ParseUnsignedInteger(option, '=', &max_spins_before_thin_lock_inflation_)) {
         return false;
       }
+    } else if (option == "-XX:DeflateIdleMonitors") {
+      deflate_idle_monitors_ = true;
     } else if (StartsWith(option, "-XX:LongPauseLogThreshold=")) {
       unsigned int value;
       if (!ParseUnsignedInteger(option, '=', &value)) {
@@ -408,14 +442,29 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
         return false;
       }
       long_gc_log_threshold_ = MsToNs(value);
+    } else if (StartsWith(option, "-XX:SampledHeapVerificationBudget=")) {
+      unsigned int value;
+      if (!ParseUnsignedInteger(option, '=', &value)) {
+        return false;
+      }
+      // The budget is given in microseconds.
+      sampled_verification_budget_ = static_cast<uint64_t>(value) * 1000;
     } else if (option == "-XX:DumpGCPerformanceOnShutdown") {
       dump_gc_performance_on_shutdown_ = true;
+    } else if (option == "-XX:DumpStartupTimings") {
+      dump_startup_timings_ = true;
+    } else if (StartsWith(option, "-XX:GcMetricsFile=")) {
+      if (!ParseStringAfterChar(option, '=', &gc_metrics_file_)) {
+        return false;
+      }
     } else if (option == "-XX:IgnoreMaxFootprint") {
       ignore_max_footprint_ = true;
     } else if (option == "-XX:LowMemoryMode") {
       low_memory_mode_ = true;
     } else if (option == "-XX:UseTLAB") {
       use_tlab_ = true;
+    } else if (option == "-XX:UseHugePages") {
+      use_huge_pages_ = true;
     } else if (StartsWith(option, "-D")) {
       properties_.push_back(option.substr(strlen("-D")));
     } else if (StartsWith(option, "-Xjnitrace:")) {
@@ -430,6 +479,18 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
       is_zygote_ = true;
     } else if (option == "-Xint") {
       interpreter_only_ = true;
+    } else if (option == "-Xjit") {
+      use_jit_ = true;
+    } else if (StartsWith(option, "-Xjitthreshold:")) {
+      if (!ParseUnsignedInteger(option, ':', &jit_compile_threshold_)) {
+        return false;
+      }
+    } else if (option == "-Xperf-map") {
+      perf_map_ = true;
+    } else if (StartsWith(option, "-Xpreloaded-classes:")) {
+      if (!ParseStringAfterChar(option, ':', &preloaded_classes_file_)) {
+        return false;
+      }
     } else if (StartsWith(option, "-Xgc:")) {
       if (!ParseXGcOption(option)) {
         return false;
@@ -527,6 +588,10 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
       if (!ParseUnsignedInteger(option, ':', &method_trace_file_size_)) {
         return false;
       }
+    } else if (option == "-Xmethod-trace-stream") {
+      method_trace_stream_ = true;
+    } else if (option == "-Xhprof-fork") {
+      hprof_fork_ = true;
     } else if (option == "-Xprofile:threadcpuclock") {
       Trace::SetDefaultClockSource(kProfilerClockSourceThreadCpu);
     } else if (option == "-Xprofile:wallclock") {
@@ -556,6 +621,16 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
       }
     } else if (option == "-Xprofile-start-lazy") {
       profile_start_immediately_ = false;
+    } else if (option == "-Xprofile-hw-counters") {
+      profile_hw_counters_ = true;
+    } else if (StartsWith(option, "-XX:AllocationSamplingInterval=")) {
+      size_t size = ParseMemoryOption(
+          option.substr(strlen("-XX:AllocationSamplingInterval=")).c_str(), 1);
+      if (size == 0) {
+        Usage("Failed to parse memory option %s\n", option.c_str());
+        return false;
+      }
+      allocation_sampling_interval_ = size;
     } else if (StartsWith(option, "-implicit-checks:")) {
       std::string checks;
       if (!ParseStringAfterChar(option, ':', &checks)) {
@@ -618,6 +693,8 @@ bool ParsedOptions::Parse(const Runtime::Options& options, bool ignore_unrecogni
         return false;
       }
       image_compiler_options_.push_back(options[i].first);
+    } else if (option == "-Xbackground-dex2oat") {
+      background_dex2oat_ = true;
     } else if (StartsWith(option, "-Xverify:")) {
       std::string verify_mode = option.substr(strlen("-Xverify:"));
       if (verify_mode == "none") {
@@ -764,6 +841,7 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -XX:HeapMaxFree=N\n");
   UsageMessage(stream, "  -XX:HeapTargetUtilization=doublevalue\n");
   UsageMessage(stream, "  -XX:ForegroundHeapGrowthMultiplier=doublevalue\n");
+  UsageMessage(stream, "  -XX:HeapTargetGcTimeRatio=doublevalue\n");
   UsageMessage(stream, "  -XX:LowMemoryMode\n");
   UsageMessage(stream, "  -Xprofile:{threadcpuclock,wallclock,dualclock}\n");
   UsageMessage(stream, "\n");
@@ -776,23 +854,39 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -Ximage:filename\n");
   UsageMessage(stream, "  -XX:ParallelGCThreads=integervalue\n");
   UsageMessage(stream, "  -XX:ConcGCThreads=integervalue\n");
+  UsageMessage(stream, "  -XX:PinGCThreads\n");
+  UsageMessage(stream, "  -XX:CheckJniSamplingInterval=integervalue\n");
   UsageMessage(stream, "  -XX:MaxSpinsBeforeThinLockInflation=integervalue\n");
+  UsageMessage(stream, "  -XX:DeflateIdleMonitors\n");
   UsageMessage(stream, "  -XX:LongPauseLogThreshold=integervalue\n");
   UsageMessage(stream, "  -XX:LongGCLogThreshold=integervalue\n");
+  UsageMessage(stream, "  -XX:SampledHeapVerificationBudget=integervalue\n");
   UsageMessage(stream, "  -XX:DumpGCPerformanceOnShutdown\n");
+  UsageMessage(stream, "  -XX:DumpStartupTimings\n");
+  UsageMessage(stream, "  -XX:GcMetricsFile=filename\n");
   UsageMessage(stream, "  -XX:IgnoreMaxFootprint\n");
   UsageMessage(stream, "  -XX:UseTLAB\n");
+  UsageMessage(stream, "  -XX:UseHugePages\n");
   UsageMessage(stream, "  -XX:BackgroundGC=none\n");
   UsageMessage(stream, "  -Xmethod-trace\n");
   UsageMessage(stream, "  -Xmethod-trace-file:filename");
   UsageMessage(stream, "  -Xmethod-trace-file-size:integervalue\n");
+  UsageMessage(stream, "  -Xmethod-trace-stream\n");
+  UsageMessage(stream, "  -Xhprof-fork\n");
   UsageMessage(stream, "  -Xprofile=filename\n");
   UsageMessage(stream, "  -Xprofile-period:integervalue\n");
   UsageMessage(stream, "  -Xprofile-duration:integervalue\n");
   UsageMessage(stream, "  -Xprofile-interval:integervalue\n");
   UsageMessage(stream, "  -Xprofile-backoff:integervalue\n");
+  UsageMessage(stream, "  -Xprofile-hw-counters\n");
+  UsageMessage(stream, "  -XX:AllocationSamplingInterval=N\n");
+  UsageMessage(stream, "  -Xjit\n");
+  UsageMessage(stream, "  -Xjitthreshold:integervalue\n");
+  UsageMessage(stream, "  -Xperf-map\n");
+  UsageMessage(stream, "  -Xpreloaded-classes:filename\n");
   UsageMessage(stream, "  -Xcompiler-option dex2oat-option\n");
   UsageMessage(stream, "  -Ximage-compiler-option dex2oat-option\n");
+  UsageMessage(stream, "  -Xbackground-dex2oat\n");
   UsageMessage(stream, "\n");
 
   UsageMessage(stream, "The following previously supported Dalvik options are ignored:\n");
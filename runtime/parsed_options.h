@@ -34,21 +34,27 @@ class ParsedOptions {
   std::string class_path_string_;
   std::string image_;
   bool check_jni_;
+  unsigned int check_jni_sampling_interval_;
   std::string jni_trace_;
   CompilerCallbacks* compiler_callbacks_;
   bool is_zygote_;
   bool interpreter_only_;
   bool is_explicit_gc_disabled_;
   bool use_tlab_;
+  bool use_huge_pages_;
   bool verify_pre_gc_heap_;
   bool verify_pre_sweeping_heap_;
   bool verify_post_gc_heap_;
   bool verify_pre_gc_rosalloc_;
   bool verify_pre_sweeping_rosalloc_;
   bool verify_post_gc_rosalloc_;
+  // In nanoseconds, 0 if sampled heap verification is disabled.
+  uint64_t sampled_verification_budget_;
   unsigned int long_pause_log_threshold_;
   unsigned int long_gc_log_threshold_;
   bool dump_gc_performance_on_shutdown_;
+  bool dump_startup_timings_;
+  std::string gc_metrics_file_;
   bool ignore_max_footprint_;
   size_t heap_initial_size_;
   size_t heap_maximum_size_;
@@ -57,18 +63,23 @@ class ParsedOptions {
   size_t heap_max_free_;
   double heap_target_utilization_;
   double foreground_heap_growth_multiplier_;
+  double heap_target_gc_time_ratio_;
   unsigned int parallel_gc_threads_;
   unsigned int conc_gc_threads_;
+  bool pin_gc_threads_;
   gc::CollectorType collector_type_;
   gc::CollectorType background_collector_type_;
   size_t stack_size_;
   unsigned int max_spins_before_thin_lock_inflation_;
+  bool deflate_idle_monitors_;
   bool low_memory_mode_;
   unsigned int lock_profiling_threshold_;
   std::string stack_trace_file_;
   bool method_trace_;
   std::string method_trace_file_;
   unsigned int method_trace_file_size_;
+  bool method_trace_stream_;
+  bool hprof_fork_;
   bool (*hook_is_sensitive_thread_)();
   jint (*hook_vfprintf_)(FILE* stream, const char* format, va_list ap);
   void (*hook_exit_)(jint status);
@@ -76,6 +87,7 @@ class ParsedOptions {
   std::vector<std::string> properties_;
   std::vector<std::string> compiler_options_;
   std::vector<std::string> image_compiler_options_;
+  bool background_dex2oat_;
   bool profile_;
   std::string profile_output_filename_;
   uint32_t profile_period_s_;
@@ -83,7 +95,13 @@ class ParsedOptions {
   uint32_t profile_interval_us_;
   double profile_backoff_coefficient_;
   bool profile_start_immediately_;
+  bool profile_hw_counters_;
   ProfilerClockSource profile_clock_source_;
+  size_t allocation_sampling_interval_;
+  bool use_jit_;
+  unsigned int jit_compile_threshold_;
+  bool perf_map_;
+  std::string preloaded_classes_file_;
   bool verify_;
   InstructionSet image_isa_;
 
@@ -48,6 +48,7 @@ TEST_F(ParsedOptionsTest, ParsedOptions) {
   options.push_back(std::make_pair("-Xmx4k", null));
   options.push_back(std::make_pair("-Xss1m", null));
   options.push_back(std::make_pair("-XX:HeapTargetUtilization=0.75", null));
+  options.push_back(std::make_pair("-XX:HeapTargetGcTimeRatio=0.05", null));
   options.push_back(std::make_pair("-Dfoo=bar", null));
   options.push_back(std::make_pair("-Dbaz=qux", null));
   options.push_back(std::make_pair("-verbose:gc,class,jni", null));
@@ -65,6 +66,7 @@ TEST_F(ParsedOptionsTest, ParsedOptions) {
   EXPECT_EQ(4 * KB, parsed->heap_maximum_size_);
   EXPECT_EQ(1 * MB, parsed->stack_size_);
   EXPECT_EQ(0.75, parsed->heap_target_utilization_);
+  EXPECT_EQ(0.05, parsed->heap_target_gc_time_ratio_);
   EXPECT_TRUE(test_vfprintf == parsed->hook_vfprintf_);
   EXPECT_TRUE(test_exit == parsed->hook_exit_);
   EXPECT_TRUE(test_abort == parsed->hook_abort_);
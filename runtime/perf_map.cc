@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "perf_map.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/stringprintf.h"
+#include "base/unix_file/fd_file.h"
+#include "dex_file-inl.h"
+#include "oat.h"
+#include "oat_file.h"
+#include "thread.h"
+#include "utils.h"
+
+namespace art {
+
+PerfMap* PerfMap::Create(const std::string& filename, std::string* error_msg) {
+  File* file = OS::CreateEmptyFile(filename.c_str());
+  if (file == nullptr) {
+    *error_msg = StringPrintf("Failed to create perf map '%s': %s", filename.c_str(),
+                              strerror(errno));
+    return nullptr;
+  }
+  return new PerfMap(file);
+}
+
+std::string PerfMap::GetDefaultFilename() {
+  return StringPrintf("/tmp/perf-%d.map", getpid());
+}
+
+PerfMap::PerfMap(File* file) : lock_("perf map lock"), file_(file) {
+}
+
+PerfMap::~PerfMap() {
+}
+
+void PerfMap::AppendLine(const void* code, size_t size, const std::string& name,
+                         std::string* lines) {
+  // Code is at least 2-byte aligned, the low bit can only be the Thumb bit.
+  uintptr_t start = reinterpret_cast<uintptr_t>(code) & ~static_cast<uintptr_t>(1);
+  StringAppendF(lines, "%" PRIxPTR " %zx ", start, size);
+  *lines += name;
+  *lines += '\n';
+}
+
+void PerfMap::AppendOatFileLines(const OatFile* oat_file, std::string* lines) {
+  // The oat header is at the beginning of the oat data, its offsets are from there.
+  const OatHeader& oat_header = oat_file->GetOatHeader();
+  const byte* oat_begin = reinterpret_cast<const byte*>(&oat_header);
+  const byte* first_code = oat_begin + oat_file->Size();
+  for (const OatFile::OatDexFile* oat_dex_file : oat_file->GetOatDexFiles()) {
+    std::string error_msg;
+    std::unique_ptr<const DexFile> dex_file(oat_dex_file->OpenDexFile(&error_msg));
+    if (dex_file.get() == nullptr) {
+      LOG(WARNING) << "Failed to open dex file '" << oat_dex_file->GetDexFileLocation()
+          << "' for the perf map: " << error_msg;
+      continue;
+    }
+    for (size_t class_def_index = 0;
+         class_def_index < dex_file->NumClassDefs();
+         class_def_index++) {
+      const DexFile::ClassDef& class_def = dex_file->GetClassDef(class_def_index);
+      const byte* class_data = dex_file->GetClassData(class_def);
+      if (class_data == nullptr) {
+        continue;
+      }
+      const OatFile::OatClass oat_class = oat_dex_file->GetOatClass(class_def_index);
+      ClassDataItemIterator it(*dex_file, class_data);
+      while (it.HasNextStaticField() || it.HasNextInstanceField()) {
+        it.Next();
+      }
+      for (uint32_t class_method_index = 0; it.HasNextDirectMethod() || it.HasNextVirtualMethod();
+           class_method_index++, it.Next()) {
+        const OatFile::OatMethod oat_method = oat_class.GetOatMethod(class_method_index);
+        const void* code = oat_method.GetQuickCode();
+        if (code == nullptr) {
+          continue;
+        }
+        AppendLine(code, oat_method.GetQuickCodeSize(),
+                   PrettyMethod(it.GetMemberIndex(), *dex_file, true), lines);
+        const byte* header = reinterpret_cast<const byte*>(code) - sizeof(OatQuickMethodHeader);
+        first_code = std::min(first_code, header);
+      }
+    }
+  }
+
+  // Only the oat file of the boot image has trampolines. The oat header doesn't record their
+  // sizes: each one extends to the next, the last one to the code of the first method.
+  std::vector<std::pair<uint32_t, const char*>> trampolines;
+#define ADD_TRAMPOLINE(name) \
+  if (oat_header.Get ## name ## Offset() != 0) { \
+    trampolines.push_back(std::make_pair(oat_header.Get ## name ## Offset(), #name)); \
+  }
+  ADD_TRAMPOLINE(InterpreterToInterpreterBridge);
+  ADD_TRAMPOLINE(InterpreterToCompiledCodeBridge);
+  ADD_TRAMPOLINE(JniDlsymLookup);
+  ADD_TRAMPOLINE(PortableImtConflictTrampoline);
+  ADD_TRAMPOLINE(PortableResolutionTrampoline);
+  ADD_TRAMPOLINE(PortableToInterpreterBridge);
+  ADD_TRAMPOLINE(QuickGenericJniTrampoline);
+  ADD_TRAMPOLINE(QuickImtConflictTrampoline);
+  ADD_TRAMPOLINE(QuickResolutionTrampoline);
+  ADD_TRAMPOLINE(QuickToInterpreterBridge);
+#undef ADD_TRAMPOLINE
+  std::sort(trampolines.begin(), trampolines.end());
+  for (size_t i = 0; i != trampolines.size(); ++i) {
+    const byte* begin = oat_begin + trampolines[i].first;
+    const byte* end =
+        (i + 1 != trampolines.size()) ? oat_begin + trampolines[i + 1].first : first_code;
+    if (end > begin) {
+      AppendLine(begin, end - begin, trampolines[i].second, lines);
+    }
+  }
+}
+
+void PerfMap::Write(const std::string& lines) {
+  if (!file_->WriteFully(lines.data(), lines.size())) {
+    PLOG(WARNING) << "Failed to write perf map '" << file_->GetPath() << "'";
+  }
+}
+
+void PerfMap::AddOatFile(const OatFile* oat_file) {
+  std::string lines;
+  AppendOatFileLines(oat_file, &lines);
+  MutexLock mu(Thread::Current(), lock_);
+  oat_files_.push_back(oat_file);
+  Write(lines);
+}
+
+void PerfMap::AddCode(const void* code, size_t size, const std::string& name) {
+  std::string line;
+  AppendLine(code, size, name, &line);
+  MutexLock mu(Thread::Current(), lock_);
+  Write(line);
+}
+
+bool PerfMap::Reopen(const std::string& filename, std::string* error_msg) {
+  File* file = OS::CreateEmptyFile(filename.c_str());
+  if (file == nullptr) {
+    *error_msg = StringPrintf("Failed to create perf map '%s': %s", filename.c_str(),
+                              strerror(errno));
+    return false;
+  }
+  MutexLock mu(Thread::Current(), lock_);
+  file_.reset(file);
+  std::string lines;
+  for (const OatFile* oat_file : oat_files_) {
+    AppendOatFileLines(oat_file, &lines);
+  }
+  Write(lines);
+  return true;
+}
+
+}  // namespace art
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_PERF_MAP_H_
+#define ART_RUNTIME_PERF_MAP_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "os.h"
+
+namespace art {
+
+class OatFile;
+
+// Writes the map file that perf and simpleperf read, as /tmp/perf-<pid>.map, to symbolize the
+// samples in code they find no symbols for: a "<start> <size> <name>" line, in hex but for the
+// name, for each compiled method and trampoline of the oat files the runtime opens, and for each
+// method the JIT compiles. Enabled with -Xperf-map.
+class PerfMap {
+ public:
+  // Returns null, and sets error_msg, if `filename` can't be created.
+  static PerfMap* Create(const std::string& filename, std::string* error_msg);
+
+  // Returns the file name the runtime uses for the current process.
+  static std::string GetDefaultFilename();
+
+  ~PerfMap();
+
+  // Adds the compiled methods and the trampolines of `oat_file`, which must outlive the map.
+  void AddOatFile(const OatFile* oat_file) LOCKS_EXCLUDED(lock_);
+
+  // Adds the `size` bytes of code at `code`, ignoring the Thumb bit.
+  void AddCode(const void* code, size_t size, const std::string& name) LOCKS_EXCLUDED(lock_);
+
+  // Writes the oat files added so far to a new `filename`, for a process forked from the zygote,
+  // whose map has another name. Returns false, and sets error_msg, on failure.
+  bool Reopen(const std::string& filename, std::string* error_msg) LOCKS_EXCLUDED(lock_);
+
+ private:
+  explicit PerfMap(File* file);
+
+  static void AppendLine(const void* code, size_t size, const std::string& name,
+                         std::string* lines);
+  static void AppendOatFileLines(const OatFile* oat_file, std::string* lines);
+
+  void Write(const std::string& lines) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::unique_ptr<File> file_ GUARDED_BY(lock_);
+  std::vector<const OatFile*> oat_files_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(PerfMap);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_PERF_MAP_H_
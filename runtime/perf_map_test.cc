@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "perf_map.h"
+
+#include <memory>
+
+#include "common_runtime_test.h"
+#include "utils.h"
+
+namespace art {
+
+class PerfMapTest : public CommonRuntimeTest {};
+
+TEST_F(PerfMapTest, AddCode) {
+  ScratchFile file;
+  std::string error_msg;
+  std::unique_ptr<PerfMap> perf_map(PerfMap::Create(file.GetFilename(), &error_msg));
+  ASSERT_TRUE(perf_map.get() != nullptr) << error_msg;
+  // The Thumb bit is not part of the address.
+  perf_map->AddCode(reinterpret_cast<const void*>(0x1001), 0x20, "void Foo.bar()");
+  perf_map->AddCode(reinterpret_cast<const void*>(0x2000), 0x8, "int Foo.baz(int)");
+  std::string contents;
+  ASSERT_TRUE(ReadFileToString(file.GetFilename(), &contents));
+  EXPECT_EQ("1000 20 void Foo.bar()\n2000 8 int Foo.baz(int)\n", contents);
+
+  // The map of a forked process only has the code of the oat files, none were added here.
+  ScratchFile reopened;
+  ASSERT_TRUE(perf_map->Reopen(reopened.GetFilename(), &error_msg)) << error_msg;
+  ASSERT_TRUE(ReadFileToString(reopened.GetFilename(), &contents));
+  EXPECT_EQ("", contents);
+}
+
+}  // namespace art
@@ -16,10 +16,17 @@
 
 #include "profiler.h"
 
+#include <inttypes.h>
+
 #include <fstream>
 #include <sys/uio.h>
 #include <sys/file.h>
 
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
 #include "base/stl_util.h"
 #include "base/unix_file/fd_file.h"
 #include "class_linker.h"
@@ -52,31 +59,166 @@ namespace art {
 BackgroundMethodSamplingProfiler* BackgroundMethodSamplingProfiler::profiler_ = nullptr;
 pthread_t BackgroundMethodSamplingProfiler::profiler_pthread_ = 0U;
 volatile bool BackgroundMethodSamplingProfiler::shutting_down_ = false;
+volatile bool BackgroundMethodSamplingProfiler::recording_receiver_types_ = false;
+
+// The number of receiver types recorded for a call site. One more than the compiler caches,
+// so that it can tell the megamorphic call sites apart.
+static constexpr size_t kMaxReceiverTypesPerCallSite = 3;
+
+// The number of receiver types a thread records before merging them into the profile.
+static constexpr size_t kThreadReceiverTypes = 64;
+
+// The number of callees recorded for a call site. Only the virtual and interface calls have more
+// than one, and the compiler only looks for the hot ones.
+static constexpr size_t kMaxCalleesPerCallSite = 3;
+
+
+// The hardware counters of a thread, a perf event group led by the cycle counter so that all the
+// counters are read at once.
+class HwCounterGroup {
+ public:
+  explicit HwCounterGroup(pid_t tid) {
+    for (size_t i = 0; i < kNumHwCounters; ++i) {
+      fds_[i] = -1;
+    }
+#if defined(__linux__)
+    static const uint64_t kConfigs[kNumHwCounters] = {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES,
+    };
+    for (size_t i = 0; i < kNumHwCounters; ++i) {
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = kConfigs[i];
+      attr.read_format = PERF_FORMAT_GROUP;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      fds_[i] = syscall(__NR_perf_event_open, &attr, tid, -1, fds_[0], 0);
+      if (fds_[i] < 0) {
+        PLOG(WARNING) << "Failed to open hardware counter " << i << " of thread " << tid;
+        Close();
+        return;
+      }
+    }
+#else
+    UNUSED(tid);
+#endif
+  }
 
+  ~HwCounterGroup() {
+    Close();
+  }
+
+  // Reads the events counted since the previous call. Returns false if the counters could not be
+  // opened or read, or on the first call.
+  bool ReadDelta(ProfileHwCounts* delta) {
+    if (fds_[0] < 0) {
+      return false;
+    }
+    // The number of counters, then their values.
+    uint64_t values[1 + kNumHwCounters];
+    if (TEMP_FAILURE_RETRY(read(fds_[0], values, sizeof(values))) !=
+        static_cast<ssize_t>(sizeof(values))) {
+      return false;
+    }
+    bool first = (last_read_ == nullptr);
+    if (first) {
+      last_read_.reset(new ProfileHwCounts());
+    }
+    for (size_t i = 0; i < kNumHwCounters; ++i) {
+      delta->counts_[i] = values[1 + i] - last_read_->counts_[i];
+      last_read_->counts_[i] = values[1 + i];
+    }
+    return !first;
+  }
+
+ private:
+  void Close() {
+    for (size_t i = kNumHwCounters; i != 0; --i) {
+      if (fds_[i - 1] >= 0) {
+        close(fds_[i - 1]);
+        fds_[i - 1] = -1;
+      }
+    }
+  }
+
+  int fds_[kNumHwCounters];
+  std::unique_ptr<ProfileHwCounts> last_read_;
+
+  DISALLOW_COPY_AND_ASSIGN(HwCounterGroup);
+};
 
 // TODO: this profiler runs regardless of the state of the machine.  Maybe we should use the
 // wakelock or something to modify the run characteristics.  This can be done when we
 // have some performance data after it's been used for a while.
 
 
+// Finds the method a thread is running and, if any, the method that called it and the dex pc
+// of the call.
+struct SampleStackVisitor FINAL : public StackVisitor {
+  explicit SampleStackVisitor(Thread* thread) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
+      : StackVisitor(thread, nullptr), method_(nullptr), dex_pc_(0), caller_(nullptr),
+        caller_dex_pc_(0) {}
+
+  bool VisitFrame() OVERRIDE SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    mirror::ArtMethod* m = GetMethod();
+    if (m->IsRuntimeMethod()) {
+      return true;
+    }
+    if (method_ == nullptr) {
+      method_ = m;
+      dex_pc_ = GetDexPc(false);
+      return true;
+    }
+    caller_ = m;
+    caller_dex_pc_ = GetDexPc();
+    return false;
+  }
+
+  mirror::ArtMethod* method_;
+  uint32_t dex_pc_;
+  mirror::ArtMethod* caller_;
+  uint32_t caller_dex_pc_;
+};
+
 // This is called from either a thread list traversal or from a checkpoint.  Regardless
 // of which caller, the mutator lock must be held.
 static void GetSample(Thread* thread, void* arg) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   BackgroundMethodSamplingProfiler* profiler =
       reinterpret_cast<BackgroundMethodSamplingProfiler*>(arg);
-  mirror::ArtMethod* method = thread->GetCurrentMethod(nullptr);
-  if (false && method == nullptr) {
-    LOG(INFO) << "No current method available";
-    std::ostringstream os;
-    thread->Dump(os);
-    std::string data(os.str());
-    LOG(INFO) << data;
+  SampleStackVisitor visitor(thread);
+  visitor.WalkStack(false);
+  profiler->RecordMethod(visitor.method_);
+  if (visitor.method_ != nullptr) {
+    profiler->RecordHwCounters(thread, visitor.method_, visitor.dex_pc_);
   }
-  profiler->RecordMethod(method);
+  if (visitor.caller_ != nullptr) {
+    profiler->RecordCallEdge(visitor.caller_, visitor.caller_dex_pc_, visitor.method_);
+  }
+  BackgroundMethodSamplingProfiler::MergeReceiverTypes(thread);
 }
 
 
 
+// The receiver types a thread recorded since it last merged them into the profile. Only the thread
+// uses its buffer, the profiler merges it from a checkpoint of the thread.
+struct ReceiverTypeBuffer {
+  ReceiverTypeBuffer() : count(0) {}
+
+  struct Record {
+    mirror::ArtMethod* caller;
+    uint32_t dex_pc;
+    mirror::Class* klass;
+  };
+
+  size_t count;
+  Record records[kThreadReceiverTypes];
+};
+
 // A closure that is called by the thread checkpoint code.
 class SampleCheckpoint : public Closure {
  public:
@@ -172,6 +314,7 @@ void* BackgroundMethodSamplingProfiler::RunProfilerThread(void* arg) {
 
     SampleCheckpoint check_point(profiler);
 
+    recording_receiver_types_ = true;
     size_t valid_samples = 0;
     while (now_us < end_us) {
       if (ShuttingDown(self)) {
@@ -216,6 +359,9 @@ void* BackgroundMethodSamplingProfiler::RunProfilerThread(void* arg) {
       // Update the current time.
       now_us = MicroTime();
     }
+    recording_receiver_types_ = false;
+    // The threads may be gone by the next run, and their tids reused.
+    profiler->CloseHwCounters();
 
     if (valid_samples > 0 && !ShuttingDown(self)) {
       // After the profile has been taken, write it out.
@@ -291,7 +437,7 @@ uint32_t BackgroundMethodSamplingProfiler::WriteProfile() {
 void BackgroundMethodSamplingProfiler::Start(int period, int duration,
                   const std::string& profile_file_name, const std::string& procName,
                   int interval_us,
-                  double backoff_coefficient, bool startImmediately) {
+                  double backoff_coefficient, bool startImmediately, bool hw_counters) {
   Thread* self = Thread::Current();
   {
     MutexLock mu(self, *Locks::profiler_lock_);
@@ -313,14 +459,15 @@ void BackgroundMethodSamplingProfiler::Start(int period, int duration,
 #endif
 
   LOG(INFO) << "Starting profile with period " << period << "s, duration " << duration <<
-      "s, interval " << interval_us << "us.  Profile file " << profile_file_name;
+      "s, interval " << interval_us << "us" << (hw_counters ? " with hardware counters" : "") <<
+      ".  Profile file " << profile_file_name;
 
   {
     MutexLock mu(self, *Locks::profiler_lock_);
     profiler_ = new BackgroundMethodSamplingProfiler(period, duration, profile_file_name,
                                       procName,
                                       backoff_coefficient,
-                                      interval_us, startImmediately);
+                                      interval_us, startImmediately, hw_counters);
 
     CHECK_PTHREAD_CALL(pthread_create, (&profiler_pthread_, nullptr, &RunProfilerThread,
         reinterpret_cast<void*>(profiler_)),
@@ -337,6 +484,7 @@ void BackgroundMethodSamplingProfiler::Stop() {
     MutexLock trace_mu(Thread::Current(), *Locks::profiler_lock_);
     profiler = profiler_;
     shutting_down_ = true;
+    recording_receiver_types_ = false;
     profiler_pthread = profiler_pthread_;
   }
 
@@ -363,7 +511,8 @@ void BackgroundMethodSamplingProfiler::Shutdown() {
 BackgroundMethodSamplingProfiler::BackgroundMethodSamplingProfiler(int period, int duration,
                    const std::string& profile_file_name,
                    const std::string& process_name,
-                   double backoff_coefficient, int interval_us, bool startImmediately)
+                   double backoff_coefficient, int interval_us, bool startImmediately,
+                   bool hw_counters)
     : profile_file_name_(profile_file_name), process_name_(process_name),
       period_s_(period), start_immediately_(startImmediately),
       interval_us_(interval_us), backoff_factor_(1.0),
@@ -371,6 +520,8 @@ BackgroundMethodSamplingProfiler::BackgroundMethodSamplingProfiler(int period, i
       wait_lock_("Profile wait lock"),
       period_condition_("Profile condition", wait_lock_),
       profile_table_(wait_lock_),
+      hw_counters_(hw_counters),
+      hw_counters_lock_("Profiler hardware counters lock"),
       profiler_barrier_(new Barrier(0)) {
   // Populate the filtered_methods set.
   // This is empty right now, but to add a method, do this:
@@ -418,6 +569,88 @@ void BackgroundMethodSamplingProfiler::RecordMethod(mirror::ArtMethod* method) {
   }
 }
 
+void BackgroundMethodSamplingProfiler::RecordCallEdge(mirror::ArtMethod* caller, uint32_t dex_pc,
+                                                      mirror::ArtMethod* callee) {
+  // Only the calls between the methods of the application are of use to the compiler.
+  if (caller->GetDeclaringClass()->GetClassLoader() == nullptr ||
+      callee->GetDeclaringClass()->GetClassLoader() == nullptr) {
+    return;
+  }
+  profile_table_.PutCallEdge(caller, dex_pc, callee);
+}
+
+void BackgroundMethodSamplingProfiler::RecordHwCounters(Thread* thread, mirror::ArtMethod* method,
+                                                        uint32_t dex_pc) {
+  if (!hw_counters_) {
+    return;
+  }
+  ProfileHwCounts delta;
+  {
+    MutexLock mu(Thread::Current(), hw_counters_lock_);
+    HwCounterGroup*& group = hw_counter_groups_[thread->GetTid()];
+    if (group == nullptr) {
+      group = new HwCounterGroup(thread->GetTid());
+    }
+    // The events counted since the previous sample of the thread are all attributed to the
+    // method it runs now, which is statistically where they happened.
+    if (!group->ReadDelta(&delta)) {
+      return;
+    }
+  }
+  // Like the samples, the boot path is not profiled.
+  if (method->GetDeclaringClass()->GetClassLoader() == nullptr) {
+    return;
+  }
+  profile_table_.PutHwCounts(method, dex_pc, delta);
+}
+
+void BackgroundMethodSamplingProfiler::CloseHwCounters() {
+  MutexLock mu(Thread::Current(), hw_counters_lock_);
+  STLDeleteValues(&hw_counter_groups_);
+}
+
+void BackgroundMethodSamplingProfiler::RecordReceiverType(Thread* self,
+                                                          mirror::ArtMethod* caller,
+                                                          uint32_t dex_pc, mirror::Class* klass) {
+  if (caller->GetDeclaringClass()->GetClassLoader() == nullptr) {
+    // Like the samples, the call sites in the boot path are not profiled.
+    return;
+  }
+  ReceiverTypeBuffer* buffer = self->GetReceiverTypeBuffer();
+  if (UNLIKELY(buffer == nullptr)) {
+    buffer = new ReceiverTypeBuffer();
+    self->SetReceiverTypeBuffer(buffer);
+  }
+  ReceiverTypeBuffer::Record& record = buffer->records[buffer->count++];
+  record.caller = caller;
+  record.dex_pc = dex_pc;
+  record.klass = klass;
+  if (UNLIKELY(buffer->count == kThreadReceiverTypes)) {
+    MergeReceiverTypes(self);
+  }
+}
+
+void BackgroundMethodSamplingProfiler::MergeReceiverTypes(Thread* thread) {
+  ReceiverTypeBuffer* buffer = thread->GetReceiverTypeBuffer();
+  if (buffer == nullptr || buffer->count == 0) {
+    return;
+  }
+  {
+    MutexLock mu(Thread::Current(), *Locks::profiler_lock_);
+    // The records of a stopped profiler are dropped.
+    if (profiler_ != nullptr) {
+      profiler_->profile_table_.PutReceiverTypes(*buffer);
+    }
+  }
+  buffer->count = 0;
+}
+
+void BackgroundMethodSamplingProfiler::FlushReceiverTypes(Thread* self) {
+  MergeReceiverTypes(self);
+  delete self->GetReceiverTypeBuffer();
+  self->SetReceiverTypeBuffer(nullptr);
+}
+
 // Clean out any recordings for the method traces.
 void BackgroundMethodSamplingProfiler::CleanProfile() {
   profile_table_.Clear();
@@ -462,6 +695,165 @@ void ProfileSampleResults::Put(mirror::ArtMethod* method) {
   lock_.Unlock(Thread::Current());
 }
 
+// Count the receiver types a thread recorded.  A call site keeps the first
+// kMaxReceiverTypesPerCallSite types it sees.
+void ProfileSampleResults::PutReceiverTypes(const ReceiverTypeBuffer& buffer) {
+  MutexLock mu(Thread::Current(), lock_);
+  for (size_t i = 0; i < buffer.count; ++i) {
+    const ReceiverTypeBuffer::Record& record = buffer.records[i];
+    std::map<mirror::Class*, uint32_t>& types = receiver_types_[record.caller][record.dex_pc];
+    std::map<mirror::Class*, uint32_t>::iterator it = types.find(record.klass);
+    if (it != types.end()) {
+      it->second++;
+    } else if (types.size() < kMaxReceiverTypesPerCallSite) {
+      types[record.klass] = 1;
+    }
+  }
+}
+
+// Count a callee of a call site.  A call site keeps the first kMaxCalleesPerCallSite
+// callees it sees.
+void ProfileSampleResults::PutCallEdge(mirror::ArtMethod* caller, uint32_t dex_pc,
+                                       mirror::ArtMethod* callee) {
+  MutexLock mu(Thread::Current(), lock_);
+  std::map<mirror::ArtMethod*, uint32_t>& callees = call_edges_[caller][dex_pc];
+  std::map<mirror::ArtMethod*, uint32_t>::iterator it = callees.find(callee);
+  if (it != callees.end()) {
+    it->second++;
+  } else if (callees.size() < kMaxCalleesPerCallSite) {
+    callees[callee] = 1;
+  }
+}
+
+void ProfileSampleResults::PutHwCounts(mirror::ArtMethod* method, uint32_t dex_pc,
+                                       const ProfileHwCounts& counts) {
+  MutexLock mu(Thread::Current(), lock_);
+  ProfileHwCounts& total = hw_counters_[method][dex_pc];
+  for (size_t i = 0; i < kNumHwCounters; ++i) {
+    total.counts_[i] += counts.counts_[i];
+  }
+}
+
+static void MergeHwCounters(const ProfileHwCounters& from, ProfileHwCounters* to) {
+  for (const auto& site : from) {
+    ProfileHwCounts& total = (*to)[site.first];
+    for (size_t i = 0; i < kNumHwCounters; ++i) {
+      total.counts_[i] += site.second.counts_[i];
+    }
+  }
+}
+
+// Add the counts of the call sites in from to those in to, keeping at most max_per_site
+// entries for each call site.
+static void MergeCallSites(const ProfileCallSites& from, size_t max_per_site,
+                           ProfileCallSites* to) {
+  for (const auto& site : from) {
+    std::map<std::string, uint32_t>& types = (*to)[site.first];
+    for (const auto& type : site.second) {
+      std::map<std::string, uint32_t>::iterator it = types.find(type.first);
+      if (it != types.end()) {
+        it->second += type.second;
+      } else if (types.size() < max_per_site) {
+        types.insert(type);
+      }
+    }
+  }
+}
+
+// The receiver types of the call sites are written as an optional fourth field of a method's
+// line, in the form "dex_pc:class=count,class=count;dex_pc:class=count". The callees are written
+// as an optional fifth field in the same form, but separated by '|' as method names have commas.
+// The hardware counter events are written as an optional sixth field, in the form
+// "dex_pc:cycles,instructions,cache_misses,branch_misses;dex_pc:...". A field is "-" if it is
+// empty but a later one is not.
+static constexpr char kReceiverTypeSeparator = ',';
+static constexpr char kCalleeSeparator = '|';
+static constexpr const char* kEmptyField = "-";
+
+static std::string FormatCallSites(const ProfileCallSites& call_sites, char separator) {
+  std::string result;
+  for (const auto& site : call_sites) {
+    if (!result.empty()) {
+      result += ';';
+    }
+    StringAppendF(&result, "%u:", site.first);
+    bool first = true;
+    for (const auto& type : site.second) {
+      if (!first) {
+        result += separator;
+      }
+      StringAppendF(&result, "%s=%u", type.first.c_str(), type.second);
+      first = false;
+    }
+  }
+  return result;
+}
+
+static std::string FormatHwCounters(const ProfileHwCounters& hw_counters) {
+  std::string result;
+  for (const auto& site : hw_counters) {
+    if (!result.empty()) {
+      result += ';';
+    }
+    StringAppendF(&result, "%u:", site.first);
+    for (size_t i = 0; i < kNumHwCounters; ++i) {
+      StringAppendF(&result, i == 0 ? "%" PRIu64 : ",%" PRIu64, site.second.counts_[i]);
+    }
+  }
+  return result;
+}
+
+// Parse the hardware counters written by FormatHwCounters().  Returns false if they are
+// malformed.
+static bool ParseHwCounters(const std::string& field, ProfileHwCounters* hw_counters) {
+  std::vector<std::string> sites;
+  Split(field, ';', sites);
+  for (const std::string& site : sites) {
+    size_t colon = site.find(':');
+    if (colon == std::string::npos) {
+      return false;
+    }
+    uint32_t dex_pc = atoi(site.substr(0, colon).c_str());
+    std::vector<std::string> counts;
+    Split(site.substr(colon + 1), ',', counts);
+    if (counts.size() != kNumHwCounters) {
+      return false;
+    }
+    ProfileHwCounts& total = (*hw_counters)[dex_pc];
+    for (size_t i = 0; i < kNumHwCounters; ++i) {
+      total.counts_[i] += strtoull(counts[i].c_str(), nullptr, 10);
+    }
+  }
+  return true;
+}
+
+// Parse the call sites written by FormatCallSites().  Returns false if they are malformed.
+static bool ParseCallSites(const std::string& field, char separator,
+                           ProfileCallSites* call_sites) {
+  if (field == kEmptyField) {
+    return true;
+  }
+  std::vector<std::string> sites;
+  Split(field, ';', sites);
+  for (const std::string& site : sites) {
+    size_t colon = site.find(':');
+    if (colon == std::string::npos) {
+      return false;
+    }
+    uint32_t dex_pc = atoi(site.substr(0, colon).c_str());
+    std::vector<std::string> types;
+    Split(site.substr(colon + 1), separator, types);
+    for (const std::string& type : types) {
+      size_t equals = type.find('=');
+      if (equals == std::string::npos || equals == 0) {
+        return false;
+      }
+      (*call_sites)[dex_pc][type.substr(0, equals)] += atoi(type.substr(equals + 1).c_str());
+    }
+  }
+  return true;
+}
+
 // Write the profile table to the output stream.  Also merge with the previous profile.
 uint32_t ProfileSampleResults::Write(std::ostream &os) {
   ScopedObjectAccess soa(Thread::Current());
@@ -471,41 +863,73 @@ uint32_t ProfileSampleResults::Write(std::ostream &os) {
 
   VLOG(profiler) << "Profile: " << num_samples_ << "/" << num_null_methods_ << "/" << num_boot_methods_;
   os << num_samples_ << "/" << num_null_methods_ << "/" << num_boot_methods_ << "\n";
-  uint32_t num_methods = 0;
+
+  // Merge this run into the profile of the previous runs, then write the result. The callers
+  // sampled only through their calls are written too, with no samples of their own.
   for (int i = 0 ; i < kHashSize; i++) {
     Map *map = table[i];
     if (map != nullptr) {
       for (const auto &meth_iter : *map) {
-        mirror::ArtMethod *method = meth_iter.first;
-        std::string method_name = PrettyMethod(method);
-
-        MethodHelper mh(method);
-        const DexFile::CodeItem* codeitem = mh.GetCodeItem();
-        uint32_t method_size = 0;
-        if (codeitem != nullptr) {
-          method_size = codeitem->insns_size_in_code_units_;
-        }
-        uint32_t count = meth_iter.second;
-
-        // Merge this profile entry with one from a previous run (if present).  Also
-        // remove the previous entry.
-        PreviousProfile::iterator pi = previous_.find(method_name);
-        if (pi != previous_.end()) {
-          count += pi->second.count_;
-          previous_.erase(pi);
-        }
-        os << StringPrintf("%s/%u/%u\n",  method_name.c_str(), count, method_size);
-        ++num_methods;
+        PreviousValue& value = GetMergedValue(meth_iter.first);
+        value.count_ += meth_iter.second;
       }
     }
   }
+  for (const auto& receiver_types : receiver_types_) {
+    ProfileCallSites call_sites;
+    for (const auto& site : receiver_types.second) {
+      for (const auto& type : site.second) {
+        call_sites[site.first][PrettyDescriptor(type.first)] = type.second;
+      }
+    }
+    PreviousValue& value = GetMergedValue(receiver_types.first);
+    MergeCallSites(call_sites, kMaxReceiverTypesPerCallSite, &value.call_sites_);
+  }
+  for (const auto& call_edges : call_edges_) {
+    ProfileCallSites callees;
+    for (const auto& site : call_edges.second) {
+      for (const auto& callee : site.second) {
+        callees[site.first][PrettyMethod(callee.first)] = callee.second;
+      }
+    }
+    PreviousValue& value = GetMergedValue(call_edges.first);
+    MergeCallSites(callees, kMaxCalleesPerCallSite, &value.callees_);
+  }
+  for (const auto& hw_counters : hw_counters_) {
+    PreviousValue& value = GetMergedValue(hw_counters.first);
+    MergeHwCounters(hw_counters.second, &value.hw_counters_);
+  }
 
-  // Now we write out the remaining previous methods.
   for (PreviousProfile::iterator pi = previous_.begin(); pi != previous_.end(); ++pi) {
-    os << StringPrintf("%s/%u/%u\n",  pi->first.c_str(), pi->second.count_, pi->second.method_size_);
-    ++num_methods;
+    const PreviousValue& value = pi->second;
+    os << StringPrintf("%s/%u/%u",  pi->first.c_str(), value.count_, value.method_size_);
+    bool has_hw_counters = !value.hw_counters_.empty();
+    bool has_callees = !value.callees_.empty() || has_hw_counters;
+    if (!value.call_sites_.empty() || has_callees) {
+      os << "/" << (value.call_sites_.empty()
+                    ? kEmptyField : FormatCallSites(value.call_sites_, kReceiverTypeSeparator));
+    }
+    if (has_callees) {
+      os << "/" << (value.callees_.empty()
+                    ? kEmptyField : FormatCallSites(value.callees_, kCalleeSeparator));
+    }
+    if (has_hw_counters) {
+      os << "/" << FormatHwCounters(value.hw_counters_);
+    }
+    os << "\n";
   }
-  return num_methods;
+  return previous_.size();
+}
+
+ProfileSampleResults::PreviousValue& ProfileSampleResults::GetMergedValue(
+    mirror::ArtMethod* method) {
+  PreviousValue& value = previous_[PrettyMethod(method)];
+  MethodHelper mh(method);
+  const DexFile::CodeItem* codeitem = mh.GetCodeItem();
+  if (codeitem != nullptr) {
+    value.method_size_ = codeitem->insns_size_in_code_units_;
+  }
+  return value;
 }
 
 void ProfileSampleResults::Clear() {
@@ -516,6 +940,9 @@ void ProfileSampleResults::Clear() {
      delete table[i];
      table[i] = nullptr;
   }
+  receiver_types_.clear();
+  call_edges_.clear();
+  hw_counters_.clear();
   previous_.clear();
 }
 
@@ -561,21 +988,37 @@ void ProfileSampleResults::ReadPrevious(int fd) {
   previous_num_null_methods_ = atoi(summary_info[1].c_str());
   previous_num_boot_methods_ = atoi(summary_info[2].c_str());
 
-  // Now read each line until the end of file.  Each line consists of 3 fields separated by /
+  // Now read each line until the end of file.  Each line consists of 3 fields separated by /,
+  // and the receiver types and callees of the call sites and the hardware counters of the method
+  // if any.
   while (true) {
     if (!ReadProfileLine(fd, line)) {
       break;
     }
     std::vector<std::string> info;
     Split(line, '/', info);
-    if (info.size() != 3) {
+    if (info.size() < 3 || info.size() > 6) {
       // Malformed.
       break;
     }
     std::string methodname = info[0];
     uint32_t count = atoi(info[1].c_str());
     uint32_t size = atoi(info[2].c_str());
-    previous_[methodname] = PreviousValue(count, size);
+    PreviousValue& previous = previous_[methodname];
+    previous = PreviousValue(count, size);
+    if (info.size() >= 4 &&
+        !ParseCallSites(info[3], kReceiverTypeSeparator, &previous.call_sites_)) {
+      // Malformed.
+      break;
+    }
+    if (info.size() >= 5 && !ParseCallSites(info[4], kCalleeSeparator, &previous.callees_)) {
+      // Malformed.
+      break;
+    }
+    if (info.size() == 6 && !ParseHwCounters(info[5], &previous.hw_counters_)) {
+      // Malformed.
+      break;
+    }
   }
 }
 
@@ -617,8 +1060,9 @@ bool ProfileHelper::LoadProfileMap(ProfileMap& profileMap, const std::string& fi
     total_count += atoi(summary_info[i].c_str());
   }
 
-  // Now read each line until the end of file.  Each line consists of 3 fields separated by '/'.
-  // Store the info in descending order given by the most used methods.
+  // Now read each line until the end of file.  Each line consists of 3 fields separated by '/',
+  // and the receiver types and callees of the call sites and the hardware counters of the method
+  // if any. Store the info in descending order given by the most used methods.
   typedef std::set<std::pair<int, std::vector<std::string>>> ProfileSet;
   ProfileSet countSet;
   while (!in.eof()) {
@@ -628,7 +1072,7 @@ bool ProfileHelper::LoadProfileMap(ProfileMap& profileMap, const std::string& fi
     }
     std::vector<std::string> info;
     Split(line, '/', info);
-    if (info.size() != 3) {
+    if (info.size() < 3 || info.size() > 6) {
       // Malformed.
       break;
     }
@@ -651,8 +1095,26 @@ bool ProfileHelper::LoadProfileMap(ProfileMap& profileMap, const std::string& fi
       ? prevData->GetTopKUsedPercentage()
       : 100 * static_cast<double>(curTotalCount) / static_cast<double>(total_count);
 
+    ProfileCallSites call_sites;
+    if (it->second.size() >= 4 &&
+        !ParseCallSites(it->second[3], kReceiverTypeSeparator, &call_sites)) {
+      LOG(VERBOSE) << "malformed call sites for " << methodname;
+      call_sites.clear();
+    }
+    ProfileCallSites callees;
+    if (it->second.size() >= 5 && !ParseCallSites(it->second[4], kCalleeSeparator, &callees)) {
+      LOG(VERBOSE) << "malformed callees for " << methodname;
+      callees.clear();
+    }
+    ProfileHwCounters hw_counters;
+    if (it->second.size() == 6 && !ParseHwCounters(it->second[5], &hw_counters)) {
+      LOG(VERBOSE) << "malformed hardware counters for " << methodname;
+      hw_counters.clear();
+    }
+
     // Add it to the profile map.
-    ProfileData curData = ProfileData(methodname, count, size, usedPercent, topKPercentage);
+    ProfileData curData = ProfileData(methodname, count, size, usedPercent, topKPercentage,
+                                      call_sites, callees, hw_counters);
     profileMap[methodname] = curData;
     prevData = &curData;
   }
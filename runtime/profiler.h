@@ -17,6 +17,7 @@
 #ifndef ART_RUNTIME_PROFILER_H_
 #define ART_RUNTIME_PROFILER_H_
 
+#include <map>
 #include <memory>
 #include <ostream>
 #include <set>
@@ -39,6 +40,33 @@ namespace mirror {
 }  // namespace mirror
 class Thread;
 
+// The receiver classes seen by the virtual and interface calls of a method: for each dex pc,
+// the count of each class, by pretty descriptor. Also the call graph edges out of a method: for
+// each dex pc, the number of samples taken in each callee, by pretty method name, called there.
+typedef std::map<uint32_t, std::map<std::string, uint32_t>> ProfileCallSites;
+
+// The hardware counters the profiler can attribute to the sampled methods.
+enum ProfileHwCounter {
+  kHwCounterCycles,
+  kHwCounterInstructions,
+  kHwCounterCacheMisses,
+  kHwCounterBranchMisses,
+  kNumHwCounters
+};
+
+// Counts of hardware counter events, indexed by ProfileHwCounter.
+struct ProfileHwCounts {
+  ProfileHwCounts() : counts_() {}
+  uint64_t counts_[kNumHwCounters];
+};
+
+// The hardware counter events attributed to a method, by dex pc of the samples they were
+// attributed to.
+typedef std::map<uint32_t, ProfileHwCounts> ProfileHwCounters;
+
+class HwCounterGroup;
+struct ReceiverTypeBuffer;
+
 //
 // This class holds all the results for all runs of the profiler.  It also
 // counts the number of null methods (where we can't determine the method) and
@@ -52,6 +80,9 @@ class ProfileSampleResults {
   ~ProfileSampleResults();
 
   void Put(mirror::ArtMethod* method);
+  void PutReceiverTypes(const ReceiverTypeBuffer& buffer);
+  void PutCallEdge(mirror::ArtMethod* caller, uint32_t dex_pc, mirror::ArtMethod* callee);
+  void PutHwCounts(mirror::ArtMethod* method, uint32_t dex_pc, const ProfileHwCounts& counts);
   uint32_t Write(std::ostream &os);
   void ReadPrevious(int fd);
   void Clear();
@@ -70,13 +101,31 @@ class ProfileSampleResults {
   typedef std::map<mirror::ArtMethod*, uint32_t> Map;   // Map of method vs its count.
   Map *table[kHashSize];
 
+  // Receiver classes by dex pc, for each caller.
+  typedef std::map<uint32_t, std::map<mirror::Class*, uint32_t>> ReceiverTypes;
+  std::map<mirror::ArtMethod*, ReceiverTypes> receiver_types_;
+
+  // Samples by callee and dex pc of the call, for each caller.
+  typedef std::map<uint32_t, std::map<mirror::ArtMethod*, uint32_t>> CallEdges;
+  std::map<mirror::ArtMethod*, CallEdges> call_edges_;
+
+  // Hardware counter events by dex pc, for each method.
+  std::map<mirror::ArtMethod*, ProfileHwCounters> hw_counters_;
+
   struct PreviousValue {
     PreviousValue() : count_(0), method_size_(0) {}
     PreviousValue(uint32_t count, uint32_t method_size) : count_(count), method_size_(method_size) {}
     uint32_t count_;
     uint32_t method_size_;
+    ProfileCallSites call_sites_;
+    ProfileCallSites callees_;
+    ProfileHwCounters hw_counters_;
   };
 
+  // The entry of method in the previous profile, to merge this run into.
+  PreviousValue& GetMergedValue(mirror::ArtMethod* method)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   typedef std::map<std::string, PreviousValue> PreviousProfile;
   PreviousProfile previous_;
   uint32_t previous_num_samples_;
@@ -103,7 +152,7 @@ class BackgroundMethodSamplingProfiler {
  public:
   static void Start(int period, int duration, const std::string& profile_filename,
                     const std::string& procName, int interval_us,
-                    double backoff_coefficient, bool startImmediately)
+                    double backoff_coefficient, bool startImmediately, bool hw_counters)
   LOCKS_EXCLUDED(Locks::mutator_lock_,
                  Locks::thread_list_lock_,
                  Locks::thread_suspend_count_lock_,
@@ -114,6 +163,37 @@ class BackgroundMethodSamplingProfiler {
 
   void RecordMethod(mirror::ArtMethod *method) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Record that a sample found callee called by the call at dex_pc in caller.
+  void RecordCallEdge(mirror::ArtMethod* caller, uint32_t dex_pc, mirror::ArtMethod* callee)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Attribute the hardware counter events of thread since its previous sample to dex_pc in
+  // method, its current method. Does nothing unless the profiler samples hardware counters.
+  void RecordHwCounters(Thread* thread, mirror::ArtMethod* method, uint32_t dex_pc)
+      LOCKS_EXCLUDED(hw_counters_lock_) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Whether the interpreter should record the receiver types of virtual and interface calls.
+  // This is only the case during a profiling run.
+  static bool IsRecordingReceiverTypes() {
+    return recording_receiver_types_;
+  }
+
+  // Record the class of the receiver of the call at dex_pc in caller, made by self. The record
+  // goes to the ReceiverTypeBuffer of self, which is merged into the profile when it is full and
+  // when the profiler samples the thread, so that the calls don't take the profiler lock.
+  static void RecordReceiverType(Thread* self, mirror::ArtMethod* caller, uint32_t dex_pc,
+                                 mirror::Class* klass)
+      LOCKS_EXCLUDED(Locks::profiler_lock_) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Merge the receiver types recorded by thread into the profile. Called by thread, or from a
+  // checkpoint of thread.
+  static void MergeReceiverTypes(Thread* thread)
+      LOCKS_EXCLUDED(Locks::profiler_lock_) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Merge the receiver types recorded by self, and free its buffer. Called when self exits.
+  static void FlushReceiverTypes(Thread* self)
+      LOCKS_EXCLUDED(Locks::profiler_lock_) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   Barrier& GetBarrier() {
     return *profiler_barrier_;
   }
@@ -122,7 +202,8 @@ class BackgroundMethodSamplingProfiler {
   explicit BackgroundMethodSamplingProfiler(int period, int duration,
                                             const std::string& profile_filename,
                                             const std::string& process_name,
-                                            double backoff_coefficient, int interval_us, bool startImmediately);
+                                            double backoff_coefficient, int interval_us,
+                                            bool startImmediately, bool hw_counters);
 
   // The sampling interval in microseconds is passed as an argument.
   static void* RunProfilerThread(void* arg) LOCKS_EXCLUDED(Locks::profiler_lock_);
@@ -130,6 +211,7 @@ class BackgroundMethodSamplingProfiler {
   uint32_t WriteProfile() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   void CleanProfile();
+  void CloseHwCounters() LOCKS_EXCLUDED(hw_counters_lock_);
   uint32_t DumpProfile(std::ostream& os) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   static bool ShuttingDown(Thread* self) LOCKS_EXCLUDED(Locks::profiler_lock_);
 
@@ -138,6 +220,9 @@ class BackgroundMethodSamplingProfiler {
   // We need to shut the sample thread down at exit.  Setting this to true will do that.
   static volatile bool shutting_down_ GUARDED_BY(Locks::profiler_lock_);
 
+  // Set by the sampling thread for the duration of a profiling run.
+  static volatile bool recording_receiver_types_;
+
   // Sampling thread, non-zero when sampling.
   static pthread_t profiler_pthread_;
 
@@ -177,6 +262,12 @@ class BackgroundMethodSamplingProfiler {
 
   ProfileSampleResults profile_table_;
 
+  // Whether the samples attribute hardware counter events to the methods, read from a perf
+  // event group opened for each thread sampled during a run.
+  const bool hw_counters_;
+  Mutex hw_counters_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::map<pid_t, HwCounterGroup*> hw_counter_groups_ GUARDED_BY(hw_counters_lock_);
+
   std::unique_ptr<Barrier> profiler_barrier_;
 
   // Set of methods to be filtered out.  This will probably be rare because
@@ -196,18 +287,24 @@ class ProfileData {
  public:
   ProfileData() : count_(0), method_size_(0), usedPercent_(0) {}
   ProfileData(const std::string& method_name, uint32_t count, uint32_t method_size,
-    double usedPercent, double topKUsedPercentage) :
+    double usedPercent, double topKUsedPercentage,
+    const ProfileCallSites& call_sites = ProfileCallSites(),
+    const ProfileCallSites& callees = ProfileCallSites(),
+    const ProfileHwCounters& hw_counters = ProfileHwCounters()) :
     method_name_(method_name), count_(count), method_size_(method_size),
-    usedPercent_(usedPercent), topKUsedPercentage_(topKUsedPercentage) {
-    // TODO: currently method_size_ and count_ are unused.
+    usedPercent_(usedPercent), topKUsedPercentage_(topKUsedPercentage),
+    call_sites_(call_sites), callees_(callees), hw_counters_(hw_counters) {
+    // TODO: currently method_size_ is unused.
     UNUSED(method_size_);
-    UNUSED(count_);
   }
 
   bool IsAbove(double v) const { return usedPercent_ >= v; }
   double GetUsedPercent() const { return usedPercent_; }
   uint32_t GetCount() const { return count_; }
   double GetTopKUsedPercentage() const { return topKUsedPercentage_; }
+  const ProfileCallSites& GetCallSites() const { return call_sites_; }
+  const ProfileCallSites& GetCallees() const { return callees_; }
+  const ProfileHwCounters& GetHwCounters() const { return hw_counters_; }
 
  private:
   std::string method_name_;    // Method name.
@@ -216,6 +313,9 @@ class ProfileData {
   double usedPercent_;         // Percentage of how many times this method was called.
   double topKUsedPercentage_;  // The percentage of the group that comprise K% of the total used
                                // methods this methods belongs to.
+  ProfileCallSites call_sites_;  // Receiver types seen by the calls of the method.
+  ProfileCallSites callees_;     // Samples taken in the methods called by the method.
+  ProfileHwCounters hw_counters_;  // Hardware counter events attributed to the method.
 };
 
 // Profile data is stored in a map, indexed by the full method name.
@@ -80,6 +80,19 @@ COMPILE_ASSERT(InlineMethodAnalyser::IGetVariant(Instruction::IGET_CHAR) ==
 COMPILE_ASSERT(InlineMethodAnalyser::IGetVariant(Instruction::IGET_SHORT) ==
     InlineMethodAnalyser::IPutVariant(Instruction::IPUT_SHORT), check_iget_iput_short_variant);
 
+COMPILE_ASSERT(InlineMethodAnalyser::SGetVariant(Instruction::SGET_WIDE) ==
+    InlineMethodAnalyser::IGetVariant(Instruction::IGET_WIDE), check_sget_iget_wide_variant);
+COMPILE_ASSERT(InlineMethodAnalyser::SGetVariant(Instruction::SGET_OBJECT) ==
+    InlineMethodAnalyser::IGetVariant(Instruction::IGET_OBJECT), check_sget_iget_object_variant);
+COMPILE_ASSERT(InlineMethodAnalyser::SGetVariant(Instruction::SGET_SHORT) ==
+    InlineMethodAnalyser::IGetVariant(Instruction::IGET_SHORT), check_sget_iget_short_variant);
+COMPILE_ASSERT(InlineMethodAnalyser::SPutVariant(Instruction::SPUT_WIDE) ==
+    InlineMethodAnalyser::IPutVariant(Instruction::IPUT_WIDE), check_sput_iput_wide_variant);
+COMPILE_ASSERT(InlineMethodAnalyser::SPutVariant(Instruction::SPUT_OBJECT) ==
+    InlineMethodAnalyser::IPutVariant(Instruction::IPUT_OBJECT), check_sput_iput_object_variant);
+COMPILE_ASSERT(InlineMethodAnalyser::SPutVariant(Instruction::SPUT_SHORT) ==
+    InlineMethodAnalyser::IPutVariant(Instruction::IPUT_SHORT), check_sput_iput_short_variant);
+
 // This is used by compiler and debugger. We look into the dex cache for resolved methods and
 // fields. However, in the context of the debugger, not all methods and fields are resolved. Since
 // we need to be able to detect possibly inlined method, we pass a null inline method to indicate
@@ -89,7 +102,7 @@ bool InlineMethodAnalyser::AnalyseMethodCode(verifier::MethodVerifier* verifier,
   DCHECK(verifier != nullptr);
   DCHECK_EQ(Runtime::Current()->IsCompiler(), method != nullptr);
   DCHECK_EQ(verifier->CanLoadClasses(), method != nullptr);
-  // We currently support only plain return or 2-instruction methods.
+  // We support plain return or 2-instruction methods, and short straight-line methods.
 
   const DexFile::CodeItem* code_item = verifier->CodeItem();
   DCHECK_NE(code_item->insns_size_in_code_units_, 0u);
@@ -113,7 +126,10 @@ bool InlineMethodAnalyser::AnalyseMethodCode(verifier::MethodVerifier* verifier,
     case Instruction::CONST_16:
     case Instruction::CONST_HIGH16:
       // TODO: Support wide constants (RETURN_WIDE).
-      return AnalyseConstMethod(code_item, method);
+      if (AnalyseConstMethod(code_item, method)) {
+        return true;
+      }
+      break;
     case Instruction::IGET:
     case Instruction::IGET_OBJECT:
     case Instruction::IGET_BOOLEAN:
@@ -130,9 +146,26 @@ bool InlineMethodAnalyser::AnalyseMethodCode(verifier::MethodVerifier* verifier,
     case Instruction::IPUT_SHORT:
     case Instruction::IPUT_WIDE:
       return AnalyseIPutMethod(verifier, method);
+    case Instruction::SGET:
+    case Instruction::SGET_OBJECT:
+    case Instruction::SGET_BOOLEAN:
+    case Instruction::SGET_BYTE:
+    case Instruction::SGET_CHAR:
+    case Instruction::SGET_SHORT:
+    case Instruction::SGET_WIDE:
+      return AnalyseSGetMethod(verifier, method);
+    case Instruction::SPUT:
+    case Instruction::SPUT_OBJECT:
+    case Instruction::SPUT_BOOLEAN:
+    case Instruction::SPUT_BYTE:
+    case Instruction::SPUT_CHAR:
+    case Instruction::SPUT_SHORT:
+    case Instruction::SPUT_WIDE:
+      return AnalyseSPutMethod(verifier, method);
     default:
-      return false;
+      break;
   }
+  return AnalyseStraightLineMethod(verifier, method);
 }
 
 bool InlineMethodAnalyser::IsSyntheticAccessor(MethodReference ref) {
@@ -245,7 +278,7 @@ bool InlineMethodAnalyser::AnalyseIGetMethod(verifier::MethodVerifier* verifier,
 
   if (result != nullptr) {
     InlineIGetIPutData* data = &result->d.ifield_data;
-    if (!ComputeSpecialAccessorInfo(field_idx, false, verifier, data)) {
+    if (!ComputeSpecialAccessorInfo(field_idx, false, false, verifier, data)) {
       return false;
     }
     result->opcode = kInlineOpIGet;
@@ -312,7 +345,7 @@ bool InlineMethodAnalyser::AnalyseIPutMethod(verifier::MethodVerifier* verifier,
 
   if (result != nullptr) {
     InlineIGetIPutData* data = &result->d.ifield_data;
-    if (!ComputeSpecialAccessorInfo(field_idx, true, verifier, data)) {
+    if (!ComputeSpecialAccessorInfo(field_idx, true, false, verifier, data)) {
       return false;
     }
     result->opcode = kInlineOpIPut;
@@ -326,18 +359,109 @@ bool InlineMethodAnalyser::AnalyseIPutMethod(verifier::MethodVerifier* verifier,
   return true;
 }
 
+bool InlineMethodAnalyser::AnalyseSGetMethod(verifier::MethodVerifier* verifier,
+                                             InlineMethod* result) {
+  if (result == nullptr) {
+    // Static accessors are only compiled without a frame, they are never inlined.
+    return false;
+  }
+
+  const DexFile::CodeItem* code_item = verifier->CodeItem();
+  const Instruction* instruction = Instruction::At(code_item->insns_);
+  Instruction::Code opcode = instruction->Opcode();
+  DCHECK(IsInstructionSGet(opcode));
+
+  const Instruction* return_instruction = instruction->Next();
+  Instruction::Code return_opcode = return_instruction->Opcode();
+  if (!(return_opcode == Instruction::RETURN_WIDE && opcode == Instruction::SGET_WIDE) &&
+      !(return_opcode == Instruction::RETURN_OBJECT && opcode == Instruction::SGET_OBJECT) &&
+      !(return_opcode == Instruction::RETURN && opcode != Instruction::SGET_WIDE &&
+          opcode != Instruction::SGET_OBJECT)) {
+    return false;
+  }
+
+  uint32_t return_reg = return_instruction->VRegA_11x();
+  uint32_t dst_reg = instruction->VRegA_21c();
+  uint32_t field_idx = instruction->VRegB_21c();
+  if (dst_reg != return_reg) {
+    return false;  // Not returning the value retrieved by SGET?
+  }
+
+  InlineIGetIPutData* data = &result->d.ifield_data;
+  if (!ComputeSpecialAccessorInfo(field_idx, false, true, verifier, data)) {
+    return false;
+  }
+  result->opcode = kInlineOpSGet;
+  result->flags = kInlineSpecial;
+  data->op_variant = SGetVariant(opcode);
+  data->method_is_static = (verifier->GetAccessFlags() & kAccStatic) != 0u ? 1u : 0u;
+  data->object_arg = 0u;
+  data->src_arg = 0u;
+  data->return_arg_plus1 = 0u;
+  return true;
+}
+
+bool InlineMethodAnalyser::AnalyseSPutMethod(verifier::MethodVerifier* verifier,
+                                             InlineMethod* result) {
+  if (result == nullptr) {
+    // Not inlined, see AnalyseSGetMethod().
+    return false;
+  }
+
+  const DexFile::CodeItem* code_item = verifier->CodeItem();
+  const Instruction* instruction = Instruction::At(code_item->insns_);
+  Instruction::Code opcode = instruction->Opcode();
+  DCHECK(IsInstructionSPut(opcode));
+
+  const Instruction* return_instruction = instruction->Next();
+  if (return_instruction->Opcode() != Instruction::RETURN_VOID) {
+    return false;
+  }
+
+  uint32_t src_reg = instruction->VRegA_21c();
+  uint32_t field_idx = instruction->VRegB_21c();
+  uint32_t arg_start = code_item->registers_size_ - code_item->ins_size_;
+  if (src_reg < arg_start) {
+    return false;  // Not storing an argument?
+  }
+  uint32_t src_arg = src_reg - arg_start;
+
+  // InlineIGetIPutData::src_arg is only 4 bits wide.
+  static constexpr uint16_t kMaxSrcArg = 15u;
+  if (src_arg > kMaxSrcArg) {
+    return false;
+  }
+
+  InlineIGetIPutData* data = &result->d.ifield_data;
+  if (!ComputeSpecialAccessorInfo(field_idx, true, true, verifier, data)) {
+    return false;
+  }
+  result->opcode = kInlineOpSPut;
+  result->flags = kInlineSpecial;
+  data->op_variant = SPutVariant(opcode);
+  data->method_is_static = (verifier->GetAccessFlags() & kAccStatic) != 0u ? 1u : 0u;
+  data->object_arg = 0u;
+  data->src_arg = src_arg;
+  data->return_arg_plus1 = 0u;
+  return true;
+}
+
 bool InlineMethodAnalyser::ComputeSpecialAccessorInfo(uint32_t field_idx, bool is_put,
+                                                      bool is_static,
                                                       verifier::MethodVerifier* verifier,
                                                       InlineIGetIPutData* result) {
   mirror::DexCache* dex_cache = verifier->GetDexCache();
   uint32_t method_idx = verifier->GetMethodReference().dex_method_index;
   mirror::ArtMethod* method = dex_cache->GetResolvedMethod(method_idx);
   mirror::ArtField* field = dex_cache->GetResolvedField(field_idx);
-  if (method == nullptr || field == nullptr || field->IsStatic()) {
+  if (method == nullptr || field == nullptr || field->IsStatic() != is_static) {
     return false;
   }
   mirror::Class* method_class = method->GetDeclaringClass();
   mirror::Class* field_class = field->GetDeclaringClass();
+  if (is_static && method_class != field_class) {
+    return false;  // Accessing the field would need a class initialization check.
+  }
   if (!method_class->CanAccessResolvedField(field_class, field, dex_cache, field_idx) ||
       (is_put && field->IsFinal() && method_class != field_class)) {
     return false;
@@ -349,4 +473,56 @@ bool InlineMethodAnalyser::ComputeSpecialAccessorInfo(uint32_t field_idx, bool i
   return true;
 }
 
+bool InlineMethodAnalyser::AnalyseStraightLineMethod(verifier::MethodVerifier* verifier,
+                                                     InlineMethod* result) {
+  const DexFile::CodeItem* code_item = verifier->CodeItem();
+  uint32_t arg_start = code_item->registers_size_ - code_item->ins_size_;
+  if (code_item->tries_size_ != 0u ||
+      code_item->insns_size_in_code_units_ > kMaxStraightLineCodeUnits ||
+      arg_start > kMaxStraightLineLocals) {
+    return false;
+  }
+
+  const uint16_t* insns = code_item->insns_;
+  const Instruction* instruction = Instruction::At(insns);
+  while (!instruction->IsReturn()) {
+    Instruction::Code opcode = instruction->Opcode();
+    if (!IsStraightLineInstruction(opcode)) {
+      return false;
+    }
+    // The arguments must keep their values, they are read from the registers of the caller.
+    bool is_wide = (Instruction::VerifyFlagsOf(opcode) & Instruction::kVerifyRegAWide) != 0;
+    uint32_t last_def = instruction->VRegA() + (is_wide ? 1u : 0u);
+    if (last_def >= arg_start) {
+      return false;
+    }
+    instruction = instruction->Next();
+  }
+  uint32_t size = reinterpret_cast<const uint16_t*>(instruction->Next()) - insns;
+  if (size != code_item->insns_size_in_code_units_) {
+    return false;  // The return is not the last instruction.
+  }
+
+  if (result != nullptr) {
+    const DexFile* dex_file = verifier->GetMethodReference().dex_file;
+    result->opcode = kInlineOpStraightLine;
+    result->flags = kInlineBody;
+    InlineStraightLineData* data = &result->d.straight_line_data;
+    data->code_item_offset = reinterpret_cast<const byte*>(code_item) - dex_file->Begin();
+    data->insns_size = size;
+    data->reserved = 0u;
+  }
+  return true;
+}
+
+bool InlineMethodAnalyser::IsStraightLineInstruction(Instruction::Code opcode) {
+  if ((Instruction::FlagsOf(opcode) & Instruction::kThrow) != 0) {
+    return false;  // Division and remainder.
+  }
+  return (Instruction::MOVE <= opcode && opcode <= Instruction::MOVE_OBJECT_16) ||
+      (Instruction::CONST_4 <= opcode && opcode <= Instruction::CONST_WIDE_HIGH16) ||
+      (Instruction::CMPL_FLOAT <= opcode && opcode <= Instruction::CMP_LONG) ||
+      (Instruction::NEG_INT <= opcode && opcode <= Instruction::USHR_INT_LIT8);
+}
+
 }  // namespace art
@@ -38,14 +38,19 @@ enum InlineMethodOpcode : uint16_t {
   kIntrinsicDoubleCvt,
   kIntrinsicFloatCvt,
   kIntrinsicReverseBytes,
+  kIntrinsicBitCount,
   kIntrinsicAbsInt,
   kIntrinsicAbsLong,
   kIntrinsicAbsFloat,
   kIntrinsicAbsDouble,
   kIntrinsicMinMaxInt,
+  kIntrinsicMinMaxLong,
+  kIntrinsicMinMaxFloat,
+  kIntrinsicMinMaxDouble,
   kIntrinsicSqrt,
   kIntrinsicCharAt,
   kIntrinsicCompareTo,
+  kIntrinsicEquals,
   kIntrinsicIsEmptyOrLength,
   kIntrinsicIndexOf,
   kIntrinsicCurrentThread,
@@ -54,12 +59,17 @@ enum InlineMethodOpcode : uint16_t {
   kIntrinsicCas,
   kIntrinsicUnsafeGet,
   kIntrinsicUnsafePut,
+  kIntrinsicSystemArrayCopy,
+  kIntrinsicArraysFill,
 
   kInlineOpNop,
   kInlineOpReturnArg,
   kInlineOpNonWideConst,
   kInlineOpIGet,
   kInlineOpIPut,
+  kInlineOpSGet,
+  kInlineOpSPut,
+  kInlineOpStraightLine,
 };
 std::ostream& operator<<(std::ostream& os, const InlineMethodOpcode& rhs);
 
@@ -67,13 +77,14 @@ enum InlineMethodFlags : uint16_t {
   kNoInlineMethodFlags = 0x0000,
   kInlineIntrinsic     = 0x0001,
   kInlineSpecial       = 0x0002,
+  kInlineBody          = 0x0004,  // The code of the method can be copied into its callers.
 };
 
 // IntrinsicFlags are stored in InlineMethod::d::raw_data
 enum IntrinsicFlags {
   kIntrinsicFlagNone = 0,
 
-  // kIntrinsicMinMaxInt
+  // kIntrinsicMinMaxInt, kIntrinsicMinMaxLong, kIntrinsicMinMaxFloat, kIntrinsicMinMaxDouble
   kIntrinsicFlagMax = kIntrinsicFlagNone,
   kIntrinsicFlagMin = 1,
 
@@ -94,10 +105,12 @@ enum IntrinsicFlags {
   kIntrinsicFlagIsOrdered  = 8,
 };
 
+// Also used by kInlineOpSGet and kInlineOpSPut, where the field is a static field of the
+// method's own class and object_arg is unused.
 struct InlineIGetIPutData {
   // The op_variant below is opcode-Instruction::IGET for IGETs and
-  // opcode-Instruction::IPUT for IPUTs. This is because the runtime
-  // doesn't know the OpSize enumeration.
+  // opcode-Instruction::IPUT for IPUTs, and the same for the matching SGETs and SPUTs.
+  // This is because the runtime doesn't know the OpSize enumeration.
   uint16_t op_variant : 3;
   uint16_t method_is_static : 1;
   uint16_t object_arg : 4;
@@ -118,6 +131,14 @@ struct InlineReturnArgData {
 };
 COMPILE_ASSERT(sizeof(InlineReturnArgData) == sizeof(uint64_t), InvalidSizeOfInlineReturnArgData);
 
+struct InlineStraightLineData {
+  uint32_t code_item_offset;  // Offset of the code item in the dex file.
+  uint16_t insns_size;        // Size of the code in code units.
+  uint16_t reserved;
+};
+COMPILE_ASSERT(sizeof(InlineStraightLineData) == sizeof(uint64_t),
+               InvalidSizeOfInlineStraightLineData);
+
 struct InlineMethod {
   InlineMethodOpcode opcode;
   InlineMethodFlags flags;
@@ -125,11 +146,20 @@ struct InlineMethod {
     uint64_t data;
     InlineIGetIPutData ifield_data;
     InlineReturnArgData return_data;
+    InlineStraightLineData straight_line_data;
   } d;
 };
 
 class InlineMethodAnalyser {
  public:
+  /**
+   * The largest straight-line method, in code units, and the most registers other than its
+   * arguments it may use, to be a candidate for inlining. The compiler maps these registers
+   * to the ones receiving the result in the caller.
+   */
+  static constexpr uint32_t kMaxStraightLineCodeUnits = 24u;
+  static constexpr uint32_t kMaxStraightLineLocals = 2u;
+
   /**
    * Analyse method code to determine if the method is a candidate for inlining.
    * If it is, record the inlining data.
@@ -157,9 +187,29 @@ class InlineMethodAnalyser {
     return opcode - Instruction::IPUT;
   }
 
+  static constexpr bool IsInstructionSGet(Instruction::Code opcode) {
+    return Instruction::SGET <= opcode && opcode <= Instruction::SGET_SHORT;
+  }
+
+  static constexpr bool IsInstructionSPut(Instruction::Code opcode) {
+    return Instruction::SPUT <= opcode && opcode <= Instruction::SPUT_SHORT;
+  }
+
+  static constexpr uint16_t SGetVariant(Instruction::Code opcode) {
+    return opcode - Instruction::SGET;
+  }
+
+  static constexpr uint16_t SPutVariant(Instruction::Code opcode) {
+    return opcode - Instruction::SPUT;
+  }
+
   // Determines whether the method is a synthetic accessor (method name starts with "access$").
   static bool IsSyntheticAccessor(MethodReference ref);
 
+  // Is the instruction one that a straight-line method may contain besides its return? Such
+  // instructions do not throw, do not branch, refer to no dex file index and define vA.
+  static bool IsStraightLineInstruction(Instruction::Code opcode);
+
  private:
   static bool AnalyseReturnMethod(const DexFile::CodeItem* code_item, InlineMethod* result);
   static bool AnalyseConstMethod(const DexFile::CodeItem* code_item, InlineMethod* result);
@@ -167,10 +217,16 @@ class InlineMethodAnalyser {
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   static bool AnalyseIPutMethod(verifier::MethodVerifier* verifier, InlineMethod* result)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static bool AnalyseSGetMethod(verifier::MethodVerifier* verifier, InlineMethod* result)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static bool AnalyseSPutMethod(verifier::MethodVerifier* verifier, InlineMethod* result)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static bool AnalyseStraightLineMethod(verifier::MethodVerifier* verifier, InlineMethod* result);
 
-  // Can we fast path instance field access in a verified accessor?
-  // If yes, computes field's offset and volatility and whether the method is static or not.
-  static bool ComputeSpecialAccessorInfo(uint32_t field_idx, bool is_put,
+  // Can we fast path instance field access in a verified accessor, or static field access
+  // if is_static? A static field must belong to the method's own class, which is initialized
+  // whenever the method runs. If yes, computes field's offset and volatility.
+  static bool ComputeSpecialAccessorInfo(uint32_t field_idx, bool is_put, bool is_static,
                                          verifier::MethodVerifier* verifier,
                                          InlineIGetIPutData* result)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_QUICK_QUICK_FRAME_INFO_CACHE_H_
+#define ART_RUNTIME_QUICK_QUICK_FRAME_INFO_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/macros.h"
+#include "quick/quick_method_frame_info.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtMethod;
+}  // namespace mirror
+
+// Per-thread cache of the frame layouts the stack walks of the thread found, so that unwinding
+// a quick frame doesn't need to go through the access flags, the entry point and the method
+// header of its method again, twice with a context. Direct-mapped and keyed by the method and
+// the pc in the frame: methods are non-movable, neither they nor their code are ever unloaded,
+// and the method disambiguates the frames of the trampolines shared by many methods such as the
+// generic JNI one. Only the owning thread accesses it, although the stacks walked may be of other
+// threads.
+class QuickFrameInfoCache {
+ public:
+  QuickFrameInfoCache() {
+    Clear();
+  }
+
+  void Clear() {
+    for (size_t i = 0; i < kSize; ++i) {
+      entries_[i].method = nullptr;
+      entries_[i].pc = 0u;
+    }
+  }
+
+  bool Get(const mirror::ArtMethod* method, uintptr_t pc, QuickMethodFrameInfo* frame_info) const
+      ALWAYS_INLINE {
+    const Entry& entry = entries_[IndexOf(method, pc)];
+    if (entry.method != method || entry.pc != pc) {
+      return false;
+    }
+    *frame_info = entry.frame_info;
+    return true;
+  }
+
+  void Set(const mirror::ArtMethod* method, uintptr_t pc, const QuickMethodFrameInfo& frame_info)
+      ALWAYS_INLINE {
+    Entry& entry = entries_[IndexOf(method, pc)];
+    entry.method = method;
+    entry.pc = pc;
+    entry.frame_info = frame_info;
+  }
+
+ private:
+  static constexpr size_t kSize = 128;
+
+  struct Entry {
+    const mirror::ArtMethod* method;
+    uintptr_t pc;
+    QuickMethodFrameInfo frame_info;
+  };
+
+  static size_t IndexOf(const mirror::ArtMethod* method, uintptr_t pc) ALWAYS_INLINE {
+    // The pcs of the frames of a method differ in their low bits, the methods in their middle
+    // ones as they are objects of a few dozen bytes.
+    return (pc ^ (reinterpret_cast<uintptr_t>(method) >> 4)) & (kSize - 1);
+  }
+
+  Entry entries_[kSize];
+
+  DISALLOW_COPY_AND_ASSIGN(QuickFrameInfoCache);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_QUICK_QUICK_FRAME_INFO_CACHE_H_
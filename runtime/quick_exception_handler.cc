@@ -66,10 +66,11 @@ void QuickExceptionHandler::FindCatch(const ThrowLocation& throw_location,
                                         exception_ref.Get());
 }
 
-void QuickExceptionHandler::DeoptimizeStack() {
+void QuickExceptionHandler::DeoptimizeStack(bool reexecute_top_frame) {
   DCHECK(is_deoptimization_);
+  ++self_->GetCounters()->deoptimizations;
 
-  DeoptimizeStackVisitor visitor(self_, context_, this);
+  DeoptimizeStackVisitor visitor(self_, context_, this, reexecute_top_frame);
   visitor.WalkStack(true);
 
   // Restore deoptimization exception
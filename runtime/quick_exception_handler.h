@@ -46,7 +46,9 @@ class QuickExceptionHandler {
 
   void FindCatch(const ThrowLocation& throw_location, mirror::Throwable* exception)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
-  void DeoptimizeStack() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Deoptimizes the frames up to the upcall. With reexecute_top_frame, the top frame is at a
+  // failed guard of compiled code and resumes at its dex pc rather than after it.
+  void DeoptimizeStack(bool reexecute_top_frame) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void UpdateInstrumentationStack() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void DoLongJump() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -19,6 +19,7 @@
 
 #include "read_barrier.h"
 
+#include "base/casts.h"
 #include "mirror/object_reference.h"
 
 namespace art {
@@ -29,14 +30,25 @@ inline MirrorType* ReadBarrier::Barrier(
   // Unused for now.
   UNUSED(obj);
   UNUSED(offset);
-  UNUSED(ref_addr);
   const bool with_read_barrier = kReadBarrierOption == kWithReadBarrier;
   if (with_read_barrier && kUseBakerReadBarrier) {
     // To be implemented.
     return ref_addr->AsMirrorPtr();
   } else if (with_read_barrier && kUseBrooksReadBarrier) {
-    // To be implemented.
-    return ref_addr->AsMirrorPtr();
+    MirrorType* ref = ref_addr->AsMirrorPtr();
+    if (UNLIKELY(ref != nullptr && IsGcMarking())) {
+      MirrorType* to_ref = down_cast<MirrorType*>(Mark(ref));
+      if (to_ref != ref) {
+        // Heal the field so that later loads take the fast path. A failed CAS means another
+        // thread already stored a to-space reference.
+        uint32_t expected = mirror::HeapReference<MirrorType>::FromMirrorPtr(ref).AsVRegValue();
+        uint32_t desired = mirror::HeapReference<MirrorType>::FromMirrorPtr(to_ref).AsVRegValue();
+        __sync_bool_compare_and_swap(reinterpret_cast<volatile uint32_t*>(ref_addr), expected,
+                                     desired);
+      }
+      return to_ref;
+    }
+    return ref;
   } else {
     // No read barrier.
     return ref_addr->AsMirrorPtr();
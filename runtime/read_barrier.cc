@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "read_barrier.h"
+
+#include "gc/collector/concurrent_copying.h"
+#include "gc/heap.h"
+#include "runtime.h"
+
+namespace art {
+
+volatile bool ReadBarrier::is_gc_marking_ = false;
+
+mirror::Object* ReadBarrier::Mark(mirror::Object* ref) {
+  return Runtime::Current()->GetHeap()->ConcurrentCopyingCollector()->Mark(ref);
+}
+
+}  // namespace art
@@ -37,6 +37,36 @@ class ReadBarrier {
   ALWAYS_INLINE static MirrorType* Barrier(
       mirror::Object* obj, MemberOffset offset, mirror::HeapReference<MirrorType>* ref_addr)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // True while the concurrent copying collector is running and references loaded from the heap
+  // may point to the from-space.
+  ALWAYS_INLINE static bool IsGcMarking() {
+    return is_gc_marking_;
+  }
+
+  // Called by the concurrent copying collector while the mutators are suspended.
+  static void SetIsGcMarking(bool is_gc_marking) {
+    is_gc_marking_ = is_gc_marking;
+  }
+
+  // The read barrier slow path, returns the to-space reference of ref.
+  static mirror::Object* Mark(mirror::Object* ref)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Returns the to-space reference of an object read from a system weak table. The concurrent
+  // copying collector only forwards the system weaks when it sweeps them at the end of marking,
+  // until then an entry handed out to a mutator is marked (and kept alive) here.
+  template <typename MirrorType>
+  ALWAYS_INLINE static MirrorType* BarrierForWeakRoot(MirrorType* ref)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    if (kUseBrooksReadBarrier && ref != nullptr && IsGcMarking()) {
+      return reinterpret_cast<MirrorType*>(Mark(reinterpret_cast<mirror::Object*>(ref)));
+    }
+    return ref;
+  }
+
+ private:
+  static volatile bool is_gc_marking_;
 };
 
 }  // namespace art
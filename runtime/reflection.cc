@@ -486,8 +486,12 @@ jobject InvokeMethod(const ScopedObjectAccessAlreadyRunnable& soa, jobject javaM
       return NULL;
     }
 
-    // Find the actual implementation of the virtual method.
-    m = receiver->GetClass()->FindVirtualMethodForVirtualOrInterface(m);
+    // Find the actual implementation of the virtual method, unless it can't be overridden for
+    // the receiver: looking up an interface method searches the whole iftable.
+    mirror::Class* receiver_class = receiver->GetClass();
+    if (receiver_class != declaring_class && !m->IsFinal() && !declaring_class->IsFinal()) {
+      m = receiver_class->FindVirtualMethodForVirtualOrInterface(m);
+    }
   }
 
   // Get our arrays of arguments and their types, and check they're the same size.
@@ -799,11 +803,15 @@ bool UnboxPrimitiveForResult(const ThrowLocation& throw_location, mirror::Object
 }
 
 bool VerifyAccess(mirror::Object* obj, mirror::Class* declaring_class, uint32_t access_flags) {
+  // Public members are accessible from any caller, don't walk the stack to find it.
+  if ((access_flags & kAccPublic) != 0) {
+    return true;
+  }
   NthCallerVisitor visitor(Thread::Current(), 2);
   visitor.WalkStack();
   mirror::Class* caller_class = visitor.caller->GetDeclaringClass();
 
-  if (((access_flags & kAccPublic) != 0) || (caller_class == declaring_class)) {
+  if (caller_class == declaring_class) {
     return true;
   }
   if ((access_flags & kAccPrivate) != 0) {
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_RESOLVED_FIELD_CACHE_H_
+#define ART_RUNTIME_RESOLVED_FIELD_CACHE_H_
+
+#include <stdint.h>
+
+#include "atomic.h"
+#include "base/logging.h"
+#include "base/macros.h"
+
+namespace art {
+
+namespace mirror {
+  class ArtField;
+}  // namespace mirror
+
+// Direct-mapped cache of the fields resolved from the field ids of a dex file, which the DexCache
+// of an application dex file with many field ids uses in place of an array with an entry for each
+// field id, as most of them are never resolved at run time. Compiled code doesn't read the
+// resolved fields, so, unlike the other DexCache arrays, they can be kept anywhere; a miss only
+// means resolving the field again. Each entry holds a field id and its field in a single word, so
+// that a reader can't see the field of one id with another. Fields are never moved nor freed,
+// and are kept live by their class, so the GC doesn't need to know about the entries.
+class ResolvedFieldCache {
+ public:
+  static constexpr size_t kSize = 1024;
+
+  ResolvedFieldCache() {
+    for (size_t i = 0; i < kSize; ++i) {
+      entries_[i] = kEmptyEntry;
+    }
+  }
+
+  // Returns the field resolved for `field_idx`, or null if it isn't cached.
+  mirror::ArtField* Get(uint32_t field_idx) const {
+    uint64_t entry = static_cast<uint64_t>(QuasiAtomic::Read64(&entries_[field_idx % kSize]));
+    if (static_cast<uint32_t>(entry >> 32) != field_idx) {
+      return nullptr;
+    }
+    return reinterpret_cast<mirror::ArtField*>(static_cast<uintptr_t>(entry & 0xFFFFFFFFu));
+  }
+
+  void Set(uint32_t field_idx, mirror::ArtField* field) {
+    uintptr_t address = reinterpret_cast<uintptr_t>(field);
+    // Like all heap references.
+    DCHECK_EQ(address, static_cast<uint32_t>(address));
+    uint64_t entry = (static_cast<uint64_t>(field_idx) << 32) | address;
+    QuasiAtomic::Write64(&entries_[field_idx % kSize], static_cast<int64_t>(entry));
+  }
+
+ private:
+  // No field id is this large.
+  static constexpr int64_t kEmptyEntry = -1;
+
+  volatile int64_t entries_[kSize];
+
+  DISALLOW_COPY_AND_ASSIGN(ResolvedFieldCache);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_RESOLVED_FIELD_CACHE_H_
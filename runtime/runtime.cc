@@ -43,6 +43,7 @@
 #include "arch/x86_64/registers_x86_64.h"
 #include "atomic.h"
 #include "class_linker.h"
+#include "class_preloader.h"
 #include "debugger.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/heap.h"
@@ -50,6 +51,7 @@
 #include "image.h"
 #include "instrumentation.h"
 #include "intern_table.h"
+#include "jit/jit.h"
 #include "jni_internal.h"
 #include "mirror/art_field-inl.h"
 #include "mirror/art_method-inl.h"
@@ -61,6 +63,7 @@
 #include "monitor.h"
 #include "parsed_options.h"
 #include "oat_file.h"
+#include "perf_map.h"
 #include "quick/quick_method_frame_info.h"
 #include "reflection.h"
 #include "ScopedLocalRef.h"
@@ -99,9 +102,11 @@ Runtime::Runtime()
       is_zygote_(false),
       is_concurrent_gc_enabled_(true),
       is_explicit_gc_disabled_(false),
+      background_dex2oat_(false),
       default_stack_size_(0),
       heap_(nullptr),
       max_spins_before_thin_lock_inflation_(Monitor::kDefaultMaxSpinsBeforeThinLockInflation),
+      deflate_idle_monitors_(false),
       monitor_list_(nullptr),
       monitor_pool_(nullptr),
       thread_list_(nullptr),
@@ -129,6 +134,13 @@ Runtime::Runtime()
       profile_interval_us_(0),
       profile_backoff_coefficient_(0),
       profile_start_immediately_(true),
+      profile_hw_counters_(false),
+      allocation_sampling_interval_(0),
+      use_jit_(false),
+      jit_compile_threshold_(0),
+      jit_(nullptr),
+      perf_map_(nullptr),
+      class_preloader_(nullptr),
       method_trace_(false),
       method_trace_file_size_(0),
       instrumentation_(),
@@ -137,11 +149,14 @@ Runtime::Runtime()
       system_thread_group_(nullptr),
       system_class_loader_(nullptr),
       dump_gc_performance_on_shutdown_(false),
+      dump_startup_timings_(false),
+      startup_timings_("Startup", true, false),
       preinitialization_transaction_(nullptr),
       null_pointer_handler_(nullptr),
       suspend_handler_(nullptr),
       stack_overflow_handler_(nullptr),
-      verify_(false) {
+      verify_(false),
+      hprof_fork_(false) {
   for (int i = 0; i < Runtime::kLastCalleeSaveType; i++) {
     callee_save_methods_[i] = nullptr;
   }
@@ -169,6 +184,9 @@ Runtime::~Runtime() {
   // Make sure to let the GC complete if it is running.
   heap_->WaitForGcToComplete(gc::kGcCauseBackground, self);
   heap_->DeleteThreadPool();
+  // Stop the JIT and class preloading threads before the threads are torn down.
+  delete jit_;
+  delete class_preloader_;
 
   // Make sure our internal threads are dead before we start tearing down things they're using.
   Dbg::StopJdwp();
@@ -179,6 +197,7 @@ Runtime::~Runtime() {
   delete monitor_list_;
   delete monitor_pool_;
   delete class_linker_;
+  delete perf_map_;
   delete heap_;
   delete intern_table_;
   delete java_vm_;
@@ -306,6 +325,7 @@ void Runtime::SweepSystemWeaks(IsMarkedCallback* visitor, void* arg) {
   GetMonitorList()->SweepMonitorList(visitor, arg);
   GetJavaVM()->SweepJniWeakGlobals(visitor, arg);
   Dbg::UpdateObjectPointers(visitor, arg);
+  GetHeap()->GetNativeCleaner()->Sweep(visitor, arg);
 }
 
 bool Runtime::Create(const Options& options, bool ignore_unrecognized) {
@@ -376,24 +396,43 @@ bool Runtime::Start() {
 
   // InitNativeMethods needs to be after started_ so that the classes
   // it touches will have methods linked to the oat file if necessary.
+  startup_timings_.StartSplit("InitNativeMethods");
   InitNativeMethods();
 
   // Initialize well known thread group values that may be accessed threads while attaching.
+  startup_timings_.NewSplit("InitThreadGroups");
   InitThreadGroups(self);
 
   Thread::FinishStartup();
 
   if (is_zygote_) {
+    startup_timings_.NewSplit("InitZygote");
     if (!InitZygote()) {
+      startup_timings_.EndSplit();
       return false;
     }
   } else {
+    startup_timings_.NewSplit("DidForkFromZygote");
     DidForkFromZygote();
   }
 
+  startup_timings_.NewSplit("StartDaemonThreads");
   StartDaemonThreads();
 
+  startup_timings_.NewSplit("CreateSystemClassLoader");
   system_class_loader_ = CreateSystemClassLoader();
+  startup_timings_.EndSplit();
+
+  // The zygote must stay single threaded to fork; it preloads its classes itself.
+  if (!is_zygote_ && !preloaded_classes_file_.empty()) {
+    std::string error_msg;
+    class_preloader_ = ClassPreloader::Create(preloaded_classes_file_, &error_msg);
+    if (class_preloader_ == nullptr) {
+      LOG(WARNING) << error_msg;
+    } else {
+      class_preloader_->Start(self, system_class_loader_);
+    }
+  }
 
   {
     ScopedObjectAccess soa(self);
@@ -401,6 +440,9 @@ bool Runtime::Start() {
   }
 
   VLOG(startup) << "Runtime::Start exiting";
+  if (dump_startup_timings_) {
+    LOG(INFO) << ConstDumpable<TimingLogger>(startup_timings_);
+  }
 
   finished_starting_ = true;
 
@@ -414,6 +456,10 @@ bool Runtime::Start() {
     StartProfiler(profile_output_filename_.c_str(), "");
   }
 
+  if (allocation_sampling_interval_ != 0) {
+    heap_->GetAllocationSampler()->Start(allocation_sampling_interval_);
+  }
+
   return true;
 }
 
@@ -467,6 +513,18 @@ void Runtime::DidForkFromZygote() {
 
   StartSignalCatcher();
 
+  if (perf_map_ != nullptr) {
+    // The map of the zygote has its pid in its name.
+    std::string error_msg;
+    if (!perf_map_->Reopen(PerfMap::GetDefaultFilename(), &error_msg)) {
+      LOG(WARNING) << error_msg;
+    }
+  }
+
+  if (use_jit_) {
+    CreateJit();
+  }
+
   // Start the JDWP thread. If the command-line debugger flags specified "suspend=y",
   // this will pause the runtime, so we probably want this to come last.
   Dbg::StartJdwp();
@@ -478,6 +536,19 @@ void Runtime::StartSignalCatcher() {
   }
 }
 
+void Runtime::CreateJit() {
+  CHECK(jit_ == nullptr);
+  if (IsCompiler() || GetInstrumentation()->InterpretOnly()) {
+    LOG(WARNING) << "The JIT is not used when compiling or when interpreting only";
+    return;
+  }
+  std::string error_msg;
+  jit_ = jit::Jit::Create(jit_compile_threshold_, &error_msg);
+  if (jit_ == nullptr) {
+    LOG(WARNING) << "Failed to start the JIT: " << error_msg;
+  }
+}
+
 bool Runtime::IsShuttingDown(Thread* self) {
   MutexLock mu(self, *Locks::runtime_shutdown_lock_);
   return IsShuttingDownLocked();
@@ -505,11 +576,14 @@ void Runtime::StartDaemonThreads() {
 bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
   CHECK_EQ(sysconf(_SC_PAGE_SIZE), kPageSize);
 
+  startup_timings_.StartSplit("ParseOptions");
   std::unique_ptr<ParsedOptions> options(ParsedOptions::Create(raw_options, ignore_unrecognized));
   if (options.get() == NULL) {
     LOG(ERROR) << "Failed to parse options";
+    startup_timings_.EndSplit();
     return false;
   }
+  dump_startup_timings_ = options->dump_startup_timings_;
   VLOG(startup) << "Runtime::Init -verbose:startup enabled";
 
   QuasiAtomic::Startup();
@@ -533,15 +607,19 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
 
   compiler_options_ = options->compiler_options_;
   image_compiler_options_ = options->image_compiler_options_;
+  background_dex2oat_ = options->background_dex2oat_;
 
   max_spins_before_thin_lock_inflation_ = options->max_spins_before_thin_lock_inflation_;
+  deflate_idle_monitors_ = options->deflate_idle_monitors_;
 
+  startup_timings_.NewSplit("CreateRuntimeObjects");
   monitor_list_ = new MonitorList;
   monitor_pool_ = MonitorPool::Create();
   thread_list_ = new ThreadList;
   intern_table_ = new InternTable;
 
   verify_ = options->verify_;
+  hprof_fork_ = options->hprof_fork_;
 
   if (options->interpreter_only_) {
     GetInstrumentation()->ForceInterpretOnly();
@@ -550,6 +628,7 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
   if (options->explicit_checks_ != (ParsedOptions::kExplicitSuspendCheck |
         ParsedOptions::kExplicitNullCheck |
         ParsedOptions::kExplicitStackOverflowCheck) || kEnableJavaStackTraceHandler) {
+    startup_timings_.NewSplit("InitFaultHandlers");
     fault_manager.Init();
 
     // These need to be in a specific order.  The null point check handler must be
@@ -571,12 +650,15 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
     }
   }
 
+  startup_timings_.NewSplit("CreateHeap");
+  MemMap::SetHugePagesEnabled(options->use_huge_pages_);
   heap_ = new gc::Heap(options->heap_initial_size_,
                        options->heap_growth_limit_,
                        options->heap_min_free_,
                        options->heap_max_free_,
                        options->heap_target_utilization_,
                        options->foreground_heap_growth_multiplier_,
+                       options->heap_target_gc_time_ratio_,
                        options->heap_maximum_size_,
                        options->image_,
                        options->image_isa_,
@@ -584,6 +666,7 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
                        options->background_collector_type_,
                        options->parallel_gc_threads_,
                        options->conc_gc_threads_,
+                       options->pin_gc_threads_,
                        options->low_memory_mode_,
                        options->long_pause_log_threshold_,
                        options->long_gc_log_threshold_,
@@ -594,13 +677,17 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
                        options->verify_post_gc_heap_,
                        options->verify_pre_gc_rosalloc_,
                        options->verify_pre_sweeping_rosalloc_,
-                       options->verify_post_gc_rosalloc_);
+                       options->verify_post_gc_rosalloc_,
+                       options->sampled_verification_budget_,
+                       options->gc_metrics_file_);
 
   dump_gc_performance_on_shutdown_ = options->dump_gc_performance_on_shutdown_;
 
+  startup_timings_.NewSplit("InitSignalHandlers");
   BlockSignals();
   InitPlatformSignalHandlers();
 
+  startup_timings_.NewSplit("AttachMainThread");
   java_vm_ = new JavaVMExt(this, options.get());
 
   Thread::Startup();
@@ -619,6 +706,15 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
   GetHeap()->EnableObjectValidation();
 
   CHECK_GE(GetHeap()->GetContinuousSpaces().size(), 1U);
+  // Before the class linker opens the oat files, for it to add them to the map.
+  if (options->perf_map_) {
+    std::string error_msg;
+    perf_map_ = PerfMap::Create(PerfMap::GetDefaultFilename(), &error_msg);
+    if (perf_map_ == nullptr) {
+      LOG(WARNING) << error_msg;
+    }
+  }
+  startup_timings_.NewSplit("InitClassLinker");
   class_linker_ = new ClassLinker(intern_table_);
   if (GetHeap()->HasImageSpace()) {
     class_linker_->InitFromImage();
@@ -632,6 +728,7 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
   }
   CHECK(class_linker_ != NULL);
   verifier::MethodVerifier::Init();
+  startup_timings_.NewSplit("InitTracingAndProfiling");
 
   method_trace_ = options->method_trace_;
   method_trace_file_ = options->method_trace_file_;
@@ -644,14 +741,19 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
   profile_interval_us_ = options->profile_interval_us_;
   profile_backoff_coefficient_ = options->profile_backoff_coefficient_;
   profile_start_immediately_ = options->profile_start_immediately_;
+  profile_hw_counters_ = options->profile_hw_counters_;
   profile_ = options->profile_;
   profile_output_filename_ = options->profile_output_filename_;
+  allocation_sampling_interval_ = options->allocation_sampling_interval_;
+  use_jit_ = options->use_jit_;
+  jit_compile_threshold_ = options->jit_compile_threshold_;
+  preloaded_classes_file_ = options->preloaded_classes_file_;
   // TODO: move this to just be an Trace::Start argument
   Trace::SetDefaultClockSource(options->profile_clock_source_);
 
   if (options->method_trace_) {
     Trace::Start(options->method_trace_file_.c_str(), -1, options->method_trace_file_size_, 0,
-                 false, false, 0);
+                 false, false, 0, options->method_trace_stream_);
   }
 
   // Pre-allocate an OutOfMemoryError for the double-OOME case.
@@ -660,6 +762,7 @@ bool Runtime::Init(const Options& raw_options, bool ignore_unrecognized) {
                           "no stack available");
   pre_allocated_OutOfMemoryError_ = self->GetException(NULL);
   self->ClearException();
+  startup_timings_.EndSplit();
 
   VLOG(startup) << "Runtime::Init exiting";
   return true;
@@ -763,14 +866,21 @@ void Runtime::RegisterRuntimeNativeMethods(JNIEnv* env) {
 }
 
 void Runtime::DumpForSigQuit(std::ostream& os) {
-  GetClassLinker()->DumpForSigQuit(os);
-  GetInternTable()->DumpForSigQuit(os);
-  GetJavaVM()->DumpForSigQuit(os);
-  GetHeap()->DumpForSigQuit(os);
+  Thread* self = Thread::Current();
+  {
+    ScopedObjectAccess soa(self);
+    GetClassLinker()->DumpForSigQuit(os);
+    GetInternTable()->DumpForSigQuit(os);
+    GetJavaVM()->DumpForSigQuit(os);
+    GetHeap()->DumpForSigQuit(os);
+  }
   os << "\n";
 
-  thread_list_->DumpForSigQuit(os);
+  // Doesn't suspend all the threads, a dump for an ANR shouldn't itself cause ANRs.
+  thread_list_->Dump(os);
   BaseMutex::DumpAll(os);
+  ScopedObjectAccess soa(self);
+  Monitor::DumpContentionProfile(os);
 }
 
 void Runtime::DumpLockHolders(std::ostream& os) {
@@ -1020,14 +1130,14 @@ void Runtime::DisallowNewSystemWeaks() {
   monitor_list_->DisallowNewMonitors();
   intern_table_->DisallowNewInterns();
   java_vm_->DisallowNewWeakGlobals();
-  Dbg::DisallowNewObjectRegistryObjects();
+  heap_->GetNativeCleaner()->DisallowNewCleaners();
 }
 
 void Runtime::AllowNewSystemWeaks() {
   monitor_list_->AllowNewMonitors();
   intern_table_->AllowNewInterns();
   java_vm_->AllowNewWeakGlobals();
-  Dbg::AllowNewObjectRegistryObjects();
+  heap_->GetNativeCleaner()->AllowNewCleaners();
 }
 
 void Runtime::SetInstructionSet(InstructionSet instruction_set) {
@@ -1100,7 +1210,8 @@ void Runtime::RemoveMethodVerifier(verifier::MethodVerifier* verifier) {
 
 void Runtime::StartProfiler(const char* appDir, const char* procName) {
   BackgroundMethodSamplingProfiler::Start(profile_period_s_, profile_duration_s_, appDir,
-      procName, profile_interval_us_, profile_backoff_coefficient_, profile_start_immediately_);
+      procName, profile_interval_us_, profile_backoff_coefficient_, profile_start_immediately_,
+      profile_hw_counters_);
 }
 
 // Transaction support.
@@ -1219,6 +1330,12 @@ void Runtime::AddCurrentRuntimeFeaturesAsDex2OatArguments(std::vector<std::strin
 
   std::string features("--instruction-set-features=");
   features += GetDefaultInstructionSetFeatures();
+  // The device may have more than the build assumed; let dex2oat use what this CPU reports.
+  InstructionSetFeatures guessed = InstructionSetFeatures::GuessInstructionSetFeatures();
+  if (guessed != InstructionSetFeatures()) {
+    features += ",";
+    features += guessed.GetFeatureString();
+  }
   argv->push_back(features);
 }
 
@@ -27,6 +27,7 @@
 
 #include "base/macros.h"
 #include "base/stringpiece.h"
+#include "base/timing_logger.h"
 #include "gc/collector_type.h"
 #include "gc/heap.h"
 #include "globals.h"
@@ -44,6 +45,9 @@ namespace art {
 namespace gc {
   class Heap;
 }
+namespace jit {
+  class Jit;
+}  // namespace jit
 namespace mirror {
   class ArtMethod;
   class ClassLoader;
@@ -58,12 +62,14 @@ namespace verifier {
 class MethodVerifier;
 }
 class ClassLinker;
+class ClassPreloader;
 class CompilerCallbacks;
 class DexFile;
 class InternTable;
 class JavaVMExt;
 class MonitorList;
 class MonitorPool;
+class PerfMap;
 class SignalCatcher;
 class ThreadList;
 class Trace;
@@ -112,6 +118,12 @@ class Runtime {
     return image_compiler_options_;
   }
 
+  // Whether the oat files generated for the dex files opened at runtime are first only verified,
+  // and then compiled in the background.
+  bool IsBackgroundDex2OatEnabled() const {
+    return background_dex2oat_;
+  }
+
   // Starts a runtime, which may cause threads to be started and code to run.
   bool Start() UNLOCK_FUNCTION(Locks::mutator_lock_);
 
@@ -168,7 +180,7 @@ class Runtime {
   void DetachCurrentThread() LOCKS_EXCLUDED(Locks::mutator_lock_);
 
   void DumpForSigQuit(std::ostream& os)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+      LOCKS_EXCLUDED(Locks::mutator_lock_, Locks::thread_list_lock_);
   void DumpLockHolders(std::ostream& os);
 
   ~Runtime();
@@ -193,6 +205,21 @@ class Runtime {
     return heap_;
   }
 
+  // Returns null unless the JIT is enabled and running.
+  jit::Jit* GetJit() const {
+    return jit_;
+  }
+
+  // Returns null unless -Xperf-map was given.
+  PerfMap* GetPerfMap() const {
+    return perf_map_;
+  }
+
+  // The time spent in each phase of Init and Start.
+  const TimingLogger& GetStartupTimings() const {
+    return startup_timings_;
+  }
+
   InternTable* GetInternTable() const {
     DCHECK(intern_table_ != NULL);
     return intern_table_;
@@ -206,6 +233,11 @@ class Runtime {
     return max_spins_before_thin_lock_inflation_;
   }
 
+  // Whether the GC deflates the monitors that have been idle since the previous GC.
+  bool IsIdleMonitorDeflationEnabled() const {
+    return deflate_idle_monitors_;
+  }
+
   MonitorList* GetMonitorList() const {
     return monitor_list_;
   }
@@ -439,6 +471,11 @@ class Runtime {
     return running_on_valgrind_;
   }
 
+  // Whether heap dumps to files are written by a forked child.
+  bool IsHprofForked() const {
+    return hprof_fork_;
+  }
+
   static const char* GetDefaultInstructionSetFeatures() {
     return kDefaultInstructionSetFeatures;
   }
@@ -458,6 +495,7 @@ class Runtime {
 
   void StartDaemonThreads();
   void StartSignalCatcher();
+  void CreateJit();
 
   // A pointer to the active runtime or NULL.
   static Runtime* instance_;
@@ -484,6 +522,7 @@ class Runtime {
 
   std::vector<std::string> compiler_options_;
   std::vector<std::string> image_compiler_options_;
+  bool background_dex2oat_;
 
   std::string boot_class_path_string_;
   std::string class_path_string_;
@@ -496,6 +535,7 @@ class Runtime {
 
   // The number of spins that are done before thread suspension is used to forcibly inflate.
   size_t max_spins_before_thin_lock_inflation_;
+  bool deflate_idle_monitors_;
   MonitorList* monitor_list_;
   MonitorPool* monitor_pool_;
 
@@ -557,6 +597,23 @@ class Runtime {
   double profile_backoff_coefficient_;  // Coefficient to exponential backoff.
   bool profile_start_immediately_;      // Whether the profile should start upon app
                                         // startup or be delayed by some random offset.
+  bool profile_hw_counters_;            // Whether the samples read the hardware counters.
+
+  // Bytes between two allocation samples, 0 if allocation sampling is disabled.
+  size_t allocation_sampling_interval_;
+
+  // Whether to compile the hot interpreted methods, and how many invocations and backward
+  // branches make a method hot.
+  bool use_jit_;
+  uint32_t jit_compile_threshold_;
+  jit::Jit* jit_;
+
+  // The perf map of the compiled code, or null.
+  PerfMap* perf_map_;
+
+  // Profile of the classes to load on a thread pool at startup, empty if there is none.
+  std::string preloaded_classes_file_;
+  ClassPreloader* class_preloader_;
 
   bool method_trace_;
   std::string method_trace_file_;
@@ -576,6 +633,10 @@ class Runtime {
   // If true, then we dump the GC cumulative timings on shutdown.
   bool dump_gc_performance_on_shutdown_;
 
+  // If true, then we log the startup timings once started.
+  bool dump_startup_timings_;
+  TimingLogger startup_timings_;
+
   // Transaction used for pre-initializing classes at compilation time.
   Transaction* preinitialization_transaction_;
   NullPointerHandler* null_pointer_handler_;
@@ -585,6 +646,10 @@ class Runtime {
   // If false, verification is disabled. True by default.
   bool verify_;
 
+  // If true, heap dumps to files are written by a forked child so the threads resume as soon as
+  // the child is started.
+  bool hprof_fork_;
+
   DISALLOW_COPY_AND_ASSIGN(Runtime);
 };
 
@@ -19,6 +19,8 @@
 
 #include <stdint.h>
 
+#include "base/latency_histogram.h"
+
 namespace art {
 
 // These must match the values in dalvik.system.VMDebug.
@@ -109,6 +111,78 @@ struct PACKED(4) RuntimeStats {
   DISALLOW_COPY_AND_ASSIGN(RuntimeStats);
 };
 
+/*
+ * Counts of the expensive runtime work done by a thread. The counters are
+ * always on: only the thread updates its counters, and the other threads read
+ * them without suspending it, see ThreadList::DumpRuntimeCounters.
+ */
+struct RuntimeCounters {
+  RuntimeCounters() {
+    Clear();
+  }
+
+  void Clear() {
+    jni_calls = 0;
+    monitor_contentions = 0;
+    suspend_waits = 0;
+    class_loads = 0;
+    exceptions_thrown = 0;
+    interpreter_entries = 0;
+    deoptimizations = 0;
+  }
+
+  void Add(const RuntimeCounters& other) {
+    jni_calls += other.jni_calls;
+    monitor_contentions += other.monitor_contentions;
+    suspend_waits += other.suspend_waits;
+    class_loads += other.class_loads;
+    exceptions_thrown += other.exceptions_thrown;
+    interpreter_entries += other.interpreter_entries;
+    deoptimizations += other.deoptimizations;
+  }
+
+  // Number of calls of native methods through their JNI stubs.
+  uint64_t jni_calls;
+  // Number of times a monitor was locked by another thread when entering it.
+  uint64_t monitor_contentions;
+  // Number of times the thread waited for its suspension to end to become runnable.
+  uint64_t suspend_waits;
+  // Number of classes defined from dex files.
+  uint64_t class_loads;
+  // Number of exceptions thrown by managed code, JNI and the runtime.
+  uint64_t exceptions_thrown;
+  // Number of methods run by the interpreter.
+  uint64_t interpreter_entries;
+  // Number of times compiled frames were deoptimized to continue in the interpreter.
+  uint64_t deoptimizations;
+};
+
+// Distributions of the latencies of a thread, in nanoseconds.
+struct RuntimeLatencies {
+  void Clear() {
+    alloc_slow_path_ns.Clear();
+    monitor_contention_ns.Clear();
+    gc_pause_ns.Clear();
+    gc_ns.Clear();
+  }
+
+  void Add(const RuntimeLatencies& other) {
+    alloc_slow_path_ns.Add(other.alloc_slow_path_ns);
+    monitor_contention_ns.Add(other.monitor_contention_ns);
+    gc_pause_ns.Add(other.gc_pause_ns);
+    gc_ns.Add(other.gc_ns);
+  }
+
+  // Allocations which didn't fit in the heap as it was and had to collect garbage or grow it.
+  LatencyHistogram alloc_slow_path_ns;
+  // Waits to enter a monitor locked by another thread.
+  LatencyHistogram monitor_contention_ns;
+  // Pauses of the collections run by the thread.
+  LatencyHistogram gc_pause_ns;
+  // Whole collections run by the thread.
+  LatencyHistogram gc_ns;
+};
+
 }  // namespace art
 
 #endif  // ART_RUNTIME_RUNTIME_STATS_H_
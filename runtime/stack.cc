@@ -25,6 +25,7 @@
 #include "object_utils.h"
 #include "quick/quick_method_frame_info.h"
 #include "runtime.h"
+#include "stack_map.h"
 #include "thread.h"
 #include "thread_list.h"
 #include "throw_location.h"
@@ -135,12 +136,39 @@ size_t StackVisitor::GetNativePcOffset() const {
   return GetMethod()->NativePcOffset(cur_quick_frame_pc_);
 }
 
+// Looks up where the safepoint at `pc` of a method compiled with stack maps
+// keeps `vreg`.
+static DexRegisterMap::LocationKind GetStackMapLocation(mirror::ArtMethod* m,
+                                                        const void* code_pointer, uintptr_t pc,
+                                                        uint16_t vreg, int32_t* value)
+    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+  CodeInfo code_info = m->GetCodeInfo(code_pointer);
+  StackMap stack_map;
+  bool found = code_info.FindStackMapForNativePcOffset(m->NativePcOffset(pc), &stack_map);
+  CHECK(found) << "No stack map at " << std::hex << pc << " in " << PrettyMethod(m);
+  return code_info.GetDexRegisterMapOf(stack_map).GetLocation(vreg, value);
+}
+
 uint32_t StackVisitor::GetVReg(mirror::ArtMethod* m, uint16_t vreg, VRegKind kind) const {
   if (cur_quick_frame_ != NULL) {
     DCHECK(context_ != NULL);  // You can't reliably read registers without a context.
     DCHECK(m == GetMethod());
     const void* code_pointer = m->GetQuickOatCodePointer();
     DCHECK(code_pointer != nullptr);
+    if (m->HasStackMaps(code_pointer)) {
+      int32_t value;
+      switch (GetStackMapLocation(m, code_pointer, cur_quick_frame_pc_, vreg, &value)) {
+        case DexRegisterMap::kInStack:
+          return *reinterpret_cast<uint32_t*>(reinterpret_cast<byte*>(cur_quick_frame_) + value);
+        case DexRegisterMap::kInRegister:
+          return GetGPR(value);
+        case DexRegisterMap::kConstant:
+          return value;
+        case DexRegisterMap::kNone:
+          LOG(FATAL) << "Dex register " << vreg << " is not live in " << PrettyMethod(m);
+          return 0;
+      }
+    }
     const VmapTable vmap_table(m->GetVmapTable(code_pointer));
     QuickMethodFrameInfo frame_info = m->GetQuickFrameInfo(code_pointer);
     uint32_t vmap_offset;
@@ -167,6 +195,22 @@ void StackVisitor::SetVReg(mirror::ArtMethod* m, uint16_t vreg, uint32_t new_val
     DCHECK(m == GetMethod());
     const void* code_pointer = m->GetQuickOatCodePointer();
     DCHECK(code_pointer != nullptr);
+    if (m->HasStackMaps(code_pointer)) {
+      int32_t value;
+      switch (GetStackMapLocation(m, code_pointer, cur_quick_frame_pc_, vreg, &value)) {
+        case DexRegisterMap::kInStack:
+          *reinterpret_cast<uint32_t*>(reinterpret_cast<byte*>(cur_quick_frame_) + value) =
+              new_value;
+          return;
+        case DexRegisterMap::kInRegister:
+          SetGPR(value, new_value);
+          return;
+        case DexRegisterMap::kConstant:
+        case DexRegisterMap::kNone:
+          LOG(FATAL) << "Dex register " << vreg << " has no storage in " << PrettyMethod(m);
+          return;
+      }
+    }
     const VmapTable vmap_table(m->GetVmapTable(code_pointer));
     QuickMethodFrameInfo frame_info = m->GetQuickFrameInfo(code_pointer);
     uint32_t vmap_offset;
@@ -292,6 +336,31 @@ void StackVisitor::SanityCheckFrame() const {
   }
 }
 
+QuickMethodFrameInfo StackVisitor::GetCurrentQuickFrameInfo() const {
+  DCHECK(cur_quick_frame_ != nullptr);
+  mirror::ArtMethod* method = *cur_quick_frame_;
+  uintptr_t pc = cur_quick_frame_pc_;
+  // The top frame of a fragment may have no pc, and the frames returning to the instrumentation
+  // exit stub aren't told apart by it.
+  if (UNLIKELY(pc == 0u || pc == GetQuickInstrumentationExitPc())) {
+    return method->GetQuickFrameInfo();
+  }
+  QuickFrameInfoCache* cache = Thread::Current()->GetQuickFrameInfoCache();
+  QuickMethodFrameInfo frame_info;
+  if (cache->Get(method, pc, &frame_info)) {
+    if (kIsDebugBuild) {
+      QuickMethodFrameInfo expected = method->GetQuickFrameInfo();
+      DCHECK_EQ(frame_info.FrameSizeInBytes(), expected.FrameSizeInBytes()) << PrettyMethod(method);
+      DCHECK_EQ(frame_info.CoreSpillMask(), expected.CoreSpillMask()) << PrettyMethod(method);
+      DCHECK_EQ(frame_info.FpSpillMask(), expected.FpSpillMask()) << PrettyMethod(method);
+    }
+    return frame_info;
+  }
+  frame_info = method->GetQuickFrameInfo();
+  cache->Set(method, pc, frame_info);
+  return frame_info;
+}
+
 void StackVisitor::WalkStack(bool include_transitions) {
   DCHECK(thread_ == Thread::Current() || thread_->IsSuspended());
   CHECK_EQ(cur_depth_, 0U);
@@ -318,7 +387,7 @@ void StackVisitor::WalkStack(bool include_transitions) {
         if (context_ != NULL) {
           context_->FillCalleeSaves(*this);
         }
-        size_t frame_size = method->GetFrameSizeInBytes();
+        size_t frame_size = GetCurrentQuickFrameInfo().FrameSizeInBytes();
         // Compute PC for next stack frame from return PC.
         size_t return_pc_offset = method->GetReturnPcOffsetInBytes(frame_size);
         byte* return_pc_addr = reinterpret_cast<byte*>(cur_quick_frame_) + return_pc_offset;
@@ -25,6 +25,7 @@
 #include "instruction_set.h"
 #include "mirror/object.h"
 #include "mirror/object_reference.h"
+#include "quick/quick_method_frame_info.h"
 #include "utils.h"
 #include "verify_object.h"
 
@@ -538,6 +539,10 @@ class StackVisitor {
 
   size_t GetNativePcOffset() const SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // The layout of the current quick frame, looked up in the cache of the walking thread first.
+  QuickMethodFrameInfo GetCurrentQuickFrameInfo() const
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   uintptr_t* CalleeSaveAddress(int num, size_t frame_size) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
     // Callee saves are held at the top of the frame
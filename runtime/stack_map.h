@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_STACK_MAP_H_
+#define ART_RUNTIME_STACK_MAP_H_
+
+#include <stdint.h>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "globals.h"
+#include "leb128.h"
+
+namespace art {
+
+// Stack maps describe the safepoints of a method in a single table, replacing
+// its mapping table, vmap table and native GC map. A stack map holds the native
+// pc offset and dex pc of a safepoint, the stack slots and core registers that
+// hold references there, and the location of each dex register.
+//
+// The encoding is:
+//
+//   [header][stack map 0]...[stack map N - 1][dex register maps]
+//
+// The header is kHeaderSize bytes:
+//   byte 0      number of bytes of a native pc offset
+//   byte 1      number of bytes of a dex pc
+//   byte 2      number of bytes of a dex register map offset
+//   byte 3      number of bytes of a register mask
+//   bytes 4-5   number of bytes of a stack mask
+//   bytes 6-7   number of dex registers
+//   bytes 8-11  number of stack maps
+//
+// Stack maps all have the same size and are sorted by native pc offset, so a
+// lookup is a binary search in place. Each of their fields is stored little
+// endian, in the fewest bytes that fit its largest value in the method. Bit i
+// of the stack mask is the kVRegSize slot at i * kVRegSize from the stack
+// pointer.
+//
+// A dex register map has one ULEB128 entry per dex register, holding the
+// location kind in its low kLocationKindBits and, above them, the stack slot in
+// kVRegSize units or the register number. A constant is a kConstant entry
+// followed by its SLEB128 value. Stack maps with equal dex register maps share
+// them, the offset of a map being relative to the end of the stack maps.
+
+class DexRegisterMap {
+ public:
+  enum LocationKind {
+    kNone = 0,
+    kInStack = 1,
+    kInRegister = 2,
+    kConstant = 3,
+  };
+
+  static constexpr size_t kLocationKindBits = 2;
+  static constexpr uint32_t kLocationKindMask = (1u << kLocationKindBits) - 1;
+
+  DexRegisterMap(const uint8_t* data, uint16_t number_of_dex_registers)
+      : data_(data), number_of_dex_registers_(number_of_dex_registers) {}
+
+  // Returns where `dex_register` lives. `value` is set to its offset in bytes
+  // from the stack pointer, its register number or its constant value.
+  LocationKind GetLocation(uint16_t dex_register, int32_t* value) const {
+    DCHECK_LT(dex_register, number_of_dex_registers_);
+    const uint8_t* data = data_;
+    for (uint16_t i = 0; ; ++i) {
+      uint32_t entry = DecodeUnsignedLeb128(&data);
+      LocationKind kind = static_cast<LocationKind>(entry & kLocationKindMask);
+      int32_t payload = (kind == kConstant)
+          ? DecodeSignedLeb128(&data)
+          : static_cast<int32_t>(entry >> kLocationKindBits);
+      if (i == dex_register) {
+        *value = (kind == kInStack) ? payload * static_cast<int32_t>(kVRegSize) : payload;
+        return kind;
+      }
+    }
+  }
+
+ private:
+  const uint8_t* const data_;
+  const uint16_t number_of_dex_registers_;
+};
+
+class StackMap;
+
+class CodeInfo {
+ public:
+  static constexpr size_t kHeaderSize = 12;
+
+  CodeInfo() : data_(nullptr) {}
+
+  explicit CodeInfo(const uint8_t* data) : data_(data) {
+    DCHECK(data_ != nullptr);
+  }
+
+  size_t GetNativePcOffsetSize() const { return data_[0]; }
+  size_t GetDexPcSize() const { return data_[1]; }
+  size_t GetDexRegisterMapOffsetSize() const { return data_[2]; }
+  size_t GetRegisterMaskSize() const { return data_[3]; }
+  size_t GetStackMaskSize() const { return LoadUnsigned(data_ + 4, 2); }
+  uint16_t GetNumberOfDexRegisters() const { return LoadUnsigned(data_ + 6, 2); }
+  size_t GetNumberOfStackMaps() const { return LoadUnsigned(data_ + 8, 4); }
+
+  size_t GetStackMapSize() const {
+    return GetNativePcOffsetSize() + GetDexPcSize() + GetDexRegisterMapOffsetSize()
+        + GetRegisterMaskSize() + GetStackMaskSize();
+  }
+
+  StackMap GetStackMapAt(size_t index) const;
+
+  // Looks up the stack map of the safepoint at `native_pc_offset`. Returns
+  // false if there is none.
+  bool FindStackMapForNativePcOffset(uint32_t native_pc_offset, StackMap* stack_map) const;
+
+  // Looks up the first stack map of the safepoints at `dex_pc`. Dex pcs are not
+  // sorted, so this is a linear search. Returns false if there is none.
+  bool FindStackMapForDexPc(uint32_t dex_pc, StackMap* stack_map) const;
+
+  DexRegisterMap GetDexRegisterMapOf(const StackMap& stack_map) const;
+
+  // Reads the little endian value stored in `size` bytes at `data`.
+  static uint32_t LoadUnsigned(const uint8_t* data, size_t size) {
+    DCHECK_LE(size, sizeof(uint32_t));
+    uint32_t value = 0;
+    for (size_t i = 0; i < size; ++i) {
+      value |= static_cast<uint32_t>(data[i]) << (i * kBitsPerByte);
+    }
+    return value;
+  }
+
+ private:
+  const uint8_t* GetDexRegisterMaps() const {
+    return data_ + kHeaderSize + GetNumberOfStackMaps() * GetStackMapSize();
+  }
+
+  const uint8_t* data_;
+};
+
+class StackMap {
+ public:
+  StackMap() : data_(nullptr) {}
+
+  StackMap(const CodeInfo& info, const uint8_t* data) : info_(info), data_(data) {}
+
+  uint32_t GetNativePcOffset() const {
+    return CodeInfo::LoadUnsigned(data_, info_.GetNativePcOffsetSize());
+  }
+
+  uint32_t GetDexPc() const {
+    return CodeInfo::LoadUnsigned(data_ + GetDexPcOffset(), info_.GetDexPcSize());
+  }
+
+  uint32_t GetDexRegisterMapOffset() const {
+    return CodeInfo::LoadUnsigned(data_ + GetDexRegisterMapOffsetOffset(),
+                                  info_.GetDexRegisterMapOffsetSize());
+  }
+
+  // The mask of the core registers holding references.
+  uint32_t GetRegisterMask() const {
+    return CodeInfo::LoadUnsigned(data_ + GetRegisterMaskOffset(), info_.GetRegisterMaskSize());
+  }
+
+  size_t GetNumberOfStackSlots() const {
+    return info_.GetStackMaskSize() * kBitsPerByte;
+  }
+
+  // Whether the kVRegSize slot at `slot` * kVRegSize from the stack pointer
+  // holds a reference.
+  bool IsStackSlotReference(size_t slot) const {
+    DCHECK_LT(slot, GetNumberOfStackSlots());
+    const uint8_t* stack_mask = data_ + GetStackMaskOffset();
+    return ((stack_mask[slot / kBitsPerByte] >> (slot % kBitsPerByte)) & 1) != 0;
+  }
+
+ private:
+  size_t GetDexPcOffset() const {
+    return info_.GetNativePcOffsetSize();
+  }
+
+  size_t GetDexRegisterMapOffsetOffset() const {
+    return GetDexPcOffset() + info_.GetDexPcSize();
+  }
+
+  size_t GetRegisterMaskOffset() const {
+    return GetDexRegisterMapOffsetOffset() + info_.GetDexRegisterMapOffsetSize();
+  }
+
+  size_t GetStackMaskOffset() const {
+    return GetRegisterMaskOffset() + info_.GetRegisterMaskSize();
+  }
+
+  CodeInfo info_;
+  const uint8_t* data_;
+};
+
+inline StackMap CodeInfo::GetStackMapAt(size_t index) const {
+  DCHECK_LT(index, GetNumberOfStackMaps());
+  return StackMap(*this, data_ + kHeaderSize + index * GetStackMapSize());
+}
+
+inline bool CodeInfo::FindStackMapForNativePcOffset(uint32_t native_pc_offset,
+                                                    StackMap* stack_map) const {
+  size_t low = 0;
+  size_t high = GetNumberOfStackMaps();
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    StackMap candidate = GetStackMapAt(mid);
+    uint32_t candidate_offset = candidate.GetNativePcOffset();
+    if (candidate_offset == native_pc_offset) {
+      *stack_map = candidate;
+      return true;
+    } else if (candidate_offset < native_pc_offset) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return false;
+}
+
+inline bool CodeInfo::FindStackMapForDexPc(uint32_t dex_pc, StackMap* stack_map) const {
+  for (size_t i = 0, e = GetNumberOfStackMaps(); i < e; ++i) {
+    StackMap candidate = GetStackMapAt(i);
+    if (candidate.GetDexPc() == dex_pc) {
+      *stack_map = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+inline DexRegisterMap CodeInfo::GetDexRegisterMapOf(const StackMap& stack_map) const {
+  return DexRegisterMap(GetDexRegisterMaps() + stack_map.GetDexRegisterMapOffset(),
+                        GetNumberOfDexRegisters());
+}
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_STACK_MAP_H_
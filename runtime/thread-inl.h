@@ -122,6 +122,9 @@ inline ThreadState Thread::TransitionFromSuspendedToRunnable() {
       MutexLock mu(this, *Locks::thread_suspend_count_lock_);
       old_state_and_flags.as_int = tls32_.state_and_flags.as_int;
       DCHECK_EQ(old_state_and_flags.as_struct.state, old_state);
+      if ((old_state_and_flags.as_struct.flags & kSuspendRequest) != 0) {
+        ++counters_.suspend_waits;
+      }
       while ((old_state_and_flags.as_struct.flags & kSuspendRequest) != 0) {
         // Re-check when Thread::resume_cond_ is notified.
         Thread::resume_cond_->Wait(this);
@@ -147,6 +150,8 @@ inline ThreadState Thread::TransitionFromSuspendedToRunnable() {
       // Failed to transition to Runnable. Release shared mutator_lock_ access and try again.
       Locks::mutator_lock_->SharedUnlock(this);
     } else {
+      // Our roots may change from now on, the GC has to mark them again.
+      roots_marked_while_suspended_ = false;
       return static_cast<ThreadState>(old_state);
     }
   } while (true);
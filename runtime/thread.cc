@@ -29,6 +29,7 @@
 #include <cerrno>
 #include <iostream>
 #include <list>
+#include <vector>
 
 #include "arch/context.h"
 #include "base/mutex.h"
@@ -42,10 +43,12 @@
 #include "entrypoints/quick/quick_alloc_entrypoints.h"
 #include "gc_map.h"
 #include "gc/accounting/card_table-inl.h"
+#include "gc/collector/concurrent_copying.h"
 #include "gc/heap.h"
 #include "gc/space/space.h"
 #include "handle_scope.h"
 #include "indirect_reference_table-inl.h"
+#include "jit/jit.h"
 #include "jni_internal.h"
 #include "mirror/art_field-inl.h"
 #include "mirror/art_method-inl.h"
@@ -54,7 +57,9 @@
 #include "mirror/object_array-inl.h"
 #include "mirror/stack_trace_element.h"
 #include "monitor.h"
+#include "monitor_pool.h"
 #include "object_utils.h"
+#include "profiler.h"
 #include "quick_exception_handler.h"
 #include "quick/quick_method_frame_info.h"
 #include "reflection.h"
@@ -64,8 +69,10 @@
 #include "ScopedUtfChars.h"
 #include "handle_scope-inl.h"
 #include "stack.h"
+#include "stack_map.h"
 #include "thread-inl.h"
 #include "thread_list.h"
+#include "trace.h"
 #include "utils.h"
 #include "verifier/dex_gc_map.h"
 #include "verify_object-inl.h"
@@ -77,6 +84,22 @@ namespace art {
 bool Thread::is_started_ = false;
 pthread_key_t Thread::pthread_key_self_;
 ConditionVariable* Thread::resume_cond_ = nullptr;
+Mutex* Thread::idle_native_threads_lock_ = nullptr;
+ConditionVariable* Thread::idle_native_threads_cond_ = nullptr;
+std::list<Thread::IdleNativeThread*>* Thread::idle_native_threads_ = nullptr;
+
+// Parking the native threads of finished Threads saves creating a native thread, with its stack
+// and stack overflow protection, for each Thread.start of the applications starting many short
+// lived threads.
+static constexpr size_t kMaxIdleNativeThreads = 4;
+static constexpr uint64_t kIdleNativeThreadTimeoutMs = 2000;
+
+struct Thread::IdleNativeThread {
+  explicit IdleNativeThread(size_t size) : stack_size(size), next(nullptr) {}
+
+  const size_t stack_size;
+  Thread* next;
+};
 
 static const char* kThreadNameDuringStartup = "<native thread without managed peer>";
 
@@ -134,41 +157,85 @@ void Thread::InitAfterFork() {
 
 void* Thread::CreateCallback(void* arg) {
   Thread* self = reinterpret_cast<Thread*>(arg);
-  Runtime* runtime = Runtime::Current();
-  if (runtime == nullptr) {
-    LOG(ERROR) << "Thread attaching to non-existent runtime: " << *self;
+  const size_t stack_size = self->native_stack_size_;
+  do {
+    Runtime* runtime = Runtime::Current();
+    if (runtime == nullptr) {
+      LOG(ERROR) << "Thread attaching to non-existent runtime: " << *self;
+      return nullptr;
+    }
+    // The zygote can only fork when it has no other native thread.
+    const bool can_idle = !runtime->IsZygote();
+    {
+      // TODO: pass self to MutexLock - requires self to equal Thread::Current(), which is only
+      //       true after self->Init().
+      MutexLock mu(nullptr, *Locks::runtime_shutdown_lock_);
+      // Check that if we got here we cannot be shutting down (as shutdown should never have
+      // started while threads are being born).
+      CHECK(!runtime->IsShuttingDownLocked());
+      self->Init(runtime->GetThreadList(), runtime->GetJavaVM());
+      Runtime::Current()->EndThreadBirth();
+    }
+    {
+      ScopedObjectAccess soa(self);
+
+      // Copy peer into self, deleting global reference when done.
+      CHECK(self->tlsPtr_.jpeer != nullptr);
+      self->tlsPtr_.opeer = soa.Decode<mirror::Object*>(self->tlsPtr_.jpeer);
+      self->GetJniEnv()->DeleteGlobalRef(self->tlsPtr_.jpeer);
+      self->tlsPtr_.jpeer = nullptr;
+      self->SetThreadName(self->GetThreadName(soa)->ToModifiedUtf8().c_str());
+      // The native thread may have run a Thread of another priority.
+      self->SetNativePriority(soa.DecodeField(WellKnownClasses::java_lang_Thread_priority)->
+          GetInt(self->tlsPtr_.opeer));
+      Dbg::PostThreadStart(self);
+
+      // Invoke the 'run' method of our java.lang.Thread.
+      mirror::Object* receiver = self->tlsPtr_.opeer;
+      jmethodID mid = WellKnownClasses::java_lang_Thread_run;
+      InvokeVirtualOrInterfaceWithJValues(soa, receiver, mid, nullptr);
+    }
+    // Detach and delete self.
+    Runtime::Current()->GetThreadList()->Unregister(self);
+
+    self = can_idle ? WaitForNextThread(stack_size) : nullptr;
+    if (self != nullptr) {
+      VLOG(threads) << "Reusing native thread " << ::art::GetTid();
+    }
+  } while (self != nullptr);
+
+  return nullptr;
+}
+
+Thread* Thread::WaitForNextThread(size_t stack_size) {
+  IdleNativeThread idle(stack_size);
+  MutexLock mu(nullptr, *idle_native_threads_lock_);
+  if (idle_native_threads_->size() >= kMaxIdleNativeThreads) {
     return nullptr;
   }
-  {
-    // TODO: pass self to MutexLock - requires self to equal Thread::Current(), which is only true
-    //       after self->Init().
-    MutexLock mu(nullptr, *Locks::runtime_shutdown_lock_);
-    // Check that if we got here we cannot be shutting down (as shutdown should never have started
-    // while threads are being born).
-    CHECK(!runtime->IsShuttingDownLocked());
-    self->Init(runtime->GetThreadList(), runtime->GetJavaVM());
-    Runtime::Current()->EndThreadBirth();
+  idle_native_threads_->push_front(&idle);
+  const uint64_t deadline = NanoTime() + MsToNs(kIdleNativeThreadTimeoutMs);
+  for (uint64_t now = NanoTime(); idle.next == nullptr && now < deadline; now = NanoTime()) {
+    const uint64_t timeout_ns = deadline - now;
+    idle_native_threads_cond_->TimedWait(nullptr, NsToMs(timeout_ns), timeout_ns % MsToNs(1));
   }
-  {
-    ScopedObjectAccess soa(self);
-
-    // Copy peer into self, deleting global reference when done.
-    CHECK(self->tlsPtr_.jpeer != nullptr);
-    self->tlsPtr_.opeer = soa.Decode<mirror::Object*>(self->tlsPtr_.jpeer);
-    self->GetJniEnv()->DeleteGlobalRef(self->tlsPtr_.jpeer);
-    self->tlsPtr_.jpeer = nullptr;
-    self->SetThreadName(self->GetThreadName(soa)->ToModifiedUtf8().c_str());
-    Dbg::PostThreadStart(self);
-
-    // Invoke the 'run' method of our java.lang.Thread.
-    mirror::Object* receiver = self->tlsPtr_.opeer;
-    jmethodID mid = WellKnownClasses::java_lang_Thread_run;
-    InvokeVirtualOrInterfaceWithJValues(soa, receiver, mid, nullptr);
+  if (idle.next == nullptr) {
+    idle_native_threads_->remove(&idle);
   }
-  // Detach and delete self.
-  Runtime::Current()->GetThreadList()->Unregister(self);
+  return idle.next;
+}
 
-  return nullptr;
+bool Thread::RunOnIdleNativeThread(Thread* self, Thread* child, size_t stack_size) {
+  MutexLock mu(self, *idle_native_threads_lock_);
+  for (auto it = idle_native_threads_->begin(); it != idle_native_threads_->end(); ++it) {
+    if ((*it)->stack_size == stack_size) {
+      (*it)->next = child;
+      idle_native_threads_->erase(it);
+      idle_native_threads_cond_->Broadcast(self);
+      return true;
+    }
+  }
+  return false;
 }
 
 Thread* Thread::FromManagedThread(const ScopedObjectAccessAlreadyRunnable& soa,
@@ -292,12 +359,18 @@ void Thread::CreateNativeThread(JNIEnv* env, jobject java_peer, size_t stack_siz
   // Use global JNI ref to hold peer live while child thread starts.
   child_thread->tlsPtr_.jpeer = env->NewGlobalRef(java_peer);
   stack_size = FixStackSize(stack_size);
+  child_thread->native_stack_size_ = stack_size;
 
   // Thread.start is synchronized, so we know that nativePeer is 0, and know that we're not racing to
   // assign it.
   env->SetLongField(java_peer, WellKnownClasses::java_lang_Thread_nativePeer,
                     reinterpret_cast<jlong>(child_thread));
 
+  // The native thread of a finished Thread already has its stack and its protected region.
+  if (RunOnIdleNativeThread(self, child_thread, stack_size)) {
+    return;
+  }
+
   pthread_t new_pthread;
   pthread_attr_t attr;
   CHECK_PTHREAD_CALL(pthread_attr_init, (&attr), "new thread");
@@ -910,9 +983,8 @@ struct StackDumpVisitor : public StackVisitor {
   int frame_count;
 };
 
-static bool ShouldShowNativeStack(const Thread* thread)
-    SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-  ThreadState state = thread->GetState();
+bool Thread::ShouldDumpNativeStack() const {
+  ThreadState state = GetState();
 
   // In native code somewhere in the VM (one of the kWaitingFor* states)? That's interesting.
   if (state > kWaiting && state < kStarting) {
@@ -928,7 +1000,7 @@ static bool ShouldShowNativeStack(const Thread* thread)
   // We don't just check kNative because native methods will be in state kSuspended if they're
   // calling back into the VM, or kBlocked if they're blocked on a monitor, or one of the
   // thread-startup states if it's early enough in their life cycle (http://b/7432159).
-  mirror::ArtMethod* current_method = thread->GetCurrentMethod(nullptr);
+  mirror::ArtMethod* current_method = GetCurrentMethod(nullptr);
   return current_method != nullptr && current_method->IsNative();
 }
 
@@ -947,7 +1019,7 @@ void Thread::DumpStack(std::ostream& os) const {
   bool dump_for_abort = (gAborting > 0) && !kIsDebugBuild;
   if (this == Thread::Current() || IsSuspended() || dump_for_abort) {
     // If we're currently in native code, dump that stack before dumping the managed stack.
-    if (dump_for_abort || ShouldShowNativeStack(this)) {
+    if (dump_for_abort || ShouldDumpNativeStack()) {
       DumpKernelStack(os, GetTid(), "  kernel: ", false);
       DumpNativeStack(os, GetTid(), "  native: ", GetCurrentMethod(nullptr));
     }
@@ -984,6 +1056,12 @@ void Thread::Startup() {
     resume_cond_ = new ConditionVariable("Thread resumption condition variable",
                                          *Locks::thread_suspend_count_lock_);
   }
+  if (idle_native_threads_lock_ == nullptr) {
+    idle_native_threads_lock_ = new Mutex("idle native threads lock");
+    idle_native_threads_cond_ = new ConditionVariable("idle native threads condition variable",
+                                                      *idle_native_threads_lock_);
+    idle_native_threads_ = new std::list<IdleNativeThread*>();
+  }
 
   // Allocate a TLS slot.
   CHECK_PTHREAD_CALL(pthread_key_create, (&Thread::pthread_key_self_, Thread::ThreadExitCallback), "self key");
@@ -1016,7 +1094,15 @@ void Thread::Shutdown() {
   }
 }
 
-Thread::Thread(bool daemon) : tls32_(daemon), wait_monitor_(nullptr), interrupted_(false) {
+Thread::Thread(bool daemon)
+    : tls32_(daemon), wait_monitor_(nullptr), interrupted_(false),
+      roots_marked_while_suspended_(false),
+      identity_hash_state_((static_cast<uint32_t>(NanoTime()) ^
+                            static_cast<uint32_t>(reinterpret_cast<uintptr_t>(this))) | 1u),
+      native_stack_size_(0) {
+  tlab_sizing_.size = 0;
+  tlab_sizing_.bytes_since_gc = 0;
+  tlab_sizing_.gc_count = 0;
   wait_mutex_ = new Mutex("a thread wait mutex");
   wait_cond_ = new ConditionVariable("a thread wait condition variable", *wait_mutex_);
   tlsPtr_.debug_invoke_req = new DebugInvokeReq;
@@ -1115,6 +1201,36 @@ void Thread::Destroy() {
   if (tlsPtr_.jni_env != nullptr) {
     tlsPtr_.jni_env->monitors.VisitRoots(MonitorExitVisitor, self, 0, kRootVMInternal);
   }
+
+  // Write out the events of a streaming method trace while the thread's name is still known.
+  if (tlsPtr_.trace_buffer != nullptr) {
+    ScopedObjectAccess soa(self);
+    Trace::FlushThreadOnExit(self);
+  }
+
+  // Merge the allocations recorded for DDMS while the thread's id is still valid.
+  if (tlsPtr_.alloc_record_buffer != nullptr) {
+    ScopedObjectAccess soa(self);
+    Dbg::FlushThreadAllocRecords(self);
+  }
+
+  // Likewise for the receiver types recorded for the profiler.
+  if (tlsPtr_.receiver_type_buffer != nullptr) {
+    ScopedObjectAccess soa(self);
+    BackgroundMethodSamplingProfiler::FlushReceiverTypes(self);
+  }
+
+  // Hand the gray objects the read barrier found to the collector, which may still be marking.
+  if (tlsPtr_.gc_mark_buffer_size != 0) {
+    ScopedObjectAccess soa(self);
+    gc::collector::ConcurrentCopying* collector =
+        Runtime::Current()->GetHeap()->ConcurrentCopyingCollector();
+    collector->RevokeThreadMarkBuffer(self, self);
+  }
+
+  if (tlsPtr_.monitor_pool_cache != nullptr) {
+    MonitorPool::ReleaseThreadCache(self);
+  }
 }
 
 Thread::~Thread() {
@@ -1155,6 +1271,9 @@ Thread::~Thread() {
   delete tlsPtr_.instrumentation_stack;
   delete tlsPtr_.name;
   delete tlsPtr_.stack_trace_sample;
+  delete[] tlsPtr_.trace_buffer;
+  // The entries not reported yet are fewer than a batch per method, they are dropped.
+  delete tlsPtr_.jit_sample_buffer;
 
   Runtime::Current()->GetHeap()->RevokeThreadLocalBuffers(this);
 
@@ -1265,8 +1384,7 @@ mirror::Object* Thread::DecodeJObject(jobject obj) const {
       result = kInvalidIndirectRefObject;
     }
   } else if (kind == kGlobal) {
-    JavaVMExt* const vm = Runtime::Current()->GetJavaVM();
-    result = vm->globals.SynchronizedGet(const_cast<Thread*>(this), &vm->globals_lock, ref);
+    result = Runtime::Current()->GetJavaVM()->DecodeGlobal(const_cast<Thread*>(this), ref);
   } else {
     DCHECK_EQ(kind, kWeakGlobal);
     result = Runtime::Current()->GetJavaVM()->DecodeWeakGlobal(const_cast<Thread*>(this), ref);
@@ -1317,150 +1435,104 @@ void Thread::NotifyLocked(Thread* self) {
   }
 }
 
-class CountStackDepthVisitor : public StackVisitor {
+// Tags the dex pcs in the pcs of an internal stack trace, set apart from the native pcs.
+static constexpr int64_t kInternalStackTraceDexPcFlag = INT64_MIN;
+
+// Records the methods and the pcs of the frames of the stack trace, that is without the runtime
+// frames and the frames up to and including the constructor of the exception. A single walk
+// that doesn't decode the native pcs of the quick frames, which is left to when the elements of
+// the stack trace are needed, if ever.
+class BuildInternalStackTraceVisitor : public StackVisitor {
  public:
-  explicit CountStackDepthVisitor(Thread* thread)
+  explicit BuildInternalStackTraceVisitor(Thread* thread)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_)
-      : StackVisitor(thread, nullptr),
-        depth_(0), skip_depth_(0), skipping_(true) {}
+      : StackVisitor(thread, nullptr), skipping_(true) {}
 
   bool VisitFrame() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    // We want to skip frames up to and including the exception's constructor.
-    // Note we also skip the frame if it doesn't have a method (namely the callee
-    // save frame)
     mirror::ArtMethod* m = GetMethod();
-    if (skipping_ && !m->IsRuntimeMethod() &&
-        !mirror::Throwable::GetJavaLangThrowable()->IsAssignableFrom(m->GetDeclaringClass())) {
-      skipping_ = false;
+    if (m->IsRuntimeMethod()) {
+      return true;  // Ignore runtime frames (in particular callee save).
     }
-    if (!skipping_) {
-      if (!m->IsRuntimeMethod()) {  // Ignore runtime frames (in particular callee save).
-        ++depth_;
+    if (skipping_) {
+      if (mirror::Throwable::GetJavaLangThrowable()->IsAssignableFrom(m->GetDeclaringClass())) {
+        return true;
       }
+      skipping_ = false;
+    }
+    int64_t pc;
+    if (m->IsProxyMethod()) {
+      pc = kInternalStackTraceDexPcFlag | DexFile::kDexNoIndex;
+    } else if (IsShadowFrame()) {
+      pc = kInternalStackTraceDexPcFlag | GetDexPc();
     } else {
-      ++skip_depth_;
+      pc = static_cast<int64_t>(GetCurrentQuickFramePc());
     }
+    methods_.push_back(m);
+    pcs_.push_back(pc);
     return true;
   }
 
-  int GetDepth() const {
-    return depth_;
+  const std::vector<mirror::ArtMethod*>& GetMethods() const {
+    return methods_;
   }
 
-  int GetSkipDepth() const {
-    return skip_depth_;
+  const std::vector<int64_t>& GetPcs() const {
+    return pcs_;
   }
 
  private:
-  uint32_t depth_;
-  uint32_t skip_depth_;
   bool skipping_;
+  std::vector<mirror::ArtMethod*> methods_;
+  std::vector<int64_t> pcs_;
 };
 
 template<bool kTransactionActive>
-class BuildInternalStackTraceVisitor : public StackVisitor {
- public:
-  explicit BuildInternalStackTraceVisitor(Thread* self, Thread* thread, int skip_depth)
-      : StackVisitor(thread, nullptr), self_(self),
-        skip_depth_(skip_depth), count_(0), dex_pc_trace_(nullptr), method_trace_(nullptr) {}
-
-  bool Init(int depth)
-      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    // Allocate method trace with an extra slot that will hold the PC trace
-    StackHandleScope<1> hs(self_);
-    ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
-    Handle<mirror::ObjectArray<mirror::Object>> method_trace(
-        hs.NewHandle(class_linker->AllocObjectArray<mirror::Object>(self_, depth + 1)));
-    if (method_trace.Get() == nullptr) {
-      return false;
-    }
-    mirror::IntArray* dex_pc_trace = mirror::IntArray::Alloc(self_, depth);
-    if (dex_pc_trace == nullptr) {
-      return false;
-    }
-    // Save PC trace in last element of method trace, also places it into the
-    // object graph.
-    // We are called from native: use non-transactional mode.
-    method_trace->Set<kTransactionActive>(depth, dex_pc_trace);
-    // Set the Object*s and assert that no thread suspension is now possible.
-    const char* last_no_suspend_cause =
-        self_->StartAssertNoThreadSuspension("Building internal stack trace");
-    CHECK(last_no_suspend_cause == nullptr) << last_no_suspend_cause;
-    method_trace_ = method_trace.Get();
-    dex_pc_trace_ = dex_pc_trace;
-    return true;
-  }
-
-  virtual ~BuildInternalStackTraceVisitor() {
-    if (method_trace_ != nullptr) {
-      self_->EndAssertNoThreadSuspension(nullptr);
-    }
-  }
+jobject Thread::CreateInternalStackTrace(const ScopedObjectAccessAlreadyRunnable& soa) const {
+  BuildInternalStackTraceVisitor build_trace_visitor(const_cast<Thread*>(this));
+  build_trace_visitor.WalkStack();
+  // The methods stay valid across the allocations as they are non-movable.
+  const std::vector<mirror::ArtMethod*>& methods = build_trace_visitor.GetMethods();
+  const std::vector<int64_t>& pcs = build_trace_visitor.GetPcs();
+  int32_t depth = methods.size();
 
-  bool VisitFrame() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
-    if (method_trace_ == nullptr || dex_pc_trace_ == nullptr) {
-      return true;  // We're probably trying to fillInStackTrace for an OutOfMemoryError.
-    }
-    if (skip_depth_ > 0) {
-      skip_depth_--;
-      return true;
-    }
-    mirror::ArtMethod* m = GetMethod();
-    if (m->IsRuntimeMethod()) {
-      return true;  // Ignore runtime frames (in particular callee save).
-    }
-    method_trace_->Set<kTransactionActive>(count_, m);
-    dex_pc_trace_->Set<kTransactionActive>(count_,
-        m->IsProxyMethod() ? DexFile::kDexNoIndex : GetDexPc());
-    ++count_;
-    return true;
+  // Allocate method trace with an extra slot that will hold the PC trace.
+  StackHandleScope<1> hs(soa.Self());
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  Handle<mirror::ObjectArray<mirror::Object>> trace(
+      hs.NewHandle(class_linker->AllocObjectArray<mirror::Object>(soa.Self(), depth + 1)));
+  if (trace.Get() == nullptr) {
+    return nullptr;  // Allocation failed, we're probably filling in an OutOfMemoryError.
   }
-
-  mirror::ObjectArray<mirror::Object>* GetInternalStackTrace() const {
-    return method_trace_;
+  mirror::LongArray* pc_trace = mirror::LongArray::Alloc(soa.Self(), depth);
+  if (pc_trace == nullptr) {
+    return nullptr;
   }
-
- private:
-  Thread* const self_;
-  // How many more frames to skip.
-  int32_t skip_depth_;
-  // Current position down stack trace.
-  uint32_t count_;
-  // Array of dex PC values.
-  mirror::IntArray* dex_pc_trace_;
-  // An array of the methods on the stack, the last entry is a reference to the PC trace.
-  mirror::ObjectArray<mirror::Object>* method_trace_;
-};
-
-template<bool kTransactionActive>
-jobject Thread::CreateInternalStackTrace(const ScopedObjectAccessAlreadyRunnable& soa) const {
-  // Compute depth of stack
-  CountStackDepthVisitor count_visitor(const_cast<Thread*>(this));
-  count_visitor.WalkStack();
-  int32_t depth = count_visitor.GetDepth();
-  int32_t skip_depth = count_visitor.GetSkipDepth();
-
-  // Build internal stack trace.
-  BuildInternalStackTraceVisitor<kTransactionActive> build_trace_visitor(soa.Self(),
-                                                                         const_cast<Thread*>(this),
-                                                                         skip_depth);
-  if (!build_trace_visitor.Init(depth)) {
-    return nullptr;  // Allocation failed.
+  for (int32_t i = 0; i < depth; ++i) {
+    trace->Set<kTransactionActive>(i, methods[i]);
+    pc_trace->Set<kTransactionActive>(i, pcs[i]);
   }
-  build_trace_visitor.WalkStack();
-  mirror::ObjectArray<mirror::Object>* trace = build_trace_visitor.GetInternalStackTrace();
+  // Save PC trace in last element of method trace, also places it into the object graph.
+  trace->Set<kTransactionActive>(depth, pc_trace);
   if (kIsDebugBuild) {
     for (int32_t i = 0; i < trace->GetLength(); ++i) {
       CHECK(trace->Get(i) != nullptr);
     }
   }
-  return soa.AddLocalReference<jobjectArray>(trace);
+  return soa.AddLocalReference<jobjectArray>(trace.Get());
 }
 template jobject Thread::CreateInternalStackTrace<false>(
     const ScopedObjectAccessAlreadyRunnable& soa) const;
 template jobject Thread::CreateInternalStackTrace<true>(
     const ScopedObjectAccessAlreadyRunnable& soa) const;
 
+uint32_t Thread::InternalStackTraceDexPc(mirror::ArtMethod* method, int64_t pc) {
+  if ((pc & kInternalStackTraceDexPcFlag) != 0) {
+    return static_cast<uint32_t>(pc);
+  }
+  // Don't abort on a pc the code of the method no longer has, that the JIT replaced since.
+  return method->ToDexPc(static_cast<uintptr_t>(pc), false);
+}
+
 jobjectArray Thread::InternalStackTraceToStackTraceElementArray(
     const ScopedObjectAccessAlreadyRunnable& soa, jobject internal, jobjectArray output_array,
     int* stack_depth) {
@@ -1507,8 +1579,8 @@ jobjectArray Thread::InternalStackTraceToStackTraceElementArray(
       class_name_object.Assign(method->GetDeclaringClass()->GetName());
       // source_name_object intentionally left null for proxy methods
     } else {
-      mirror::IntArray* pc_trace = down_cast<mirror::IntArray*>(method_trace->Get(depth));
-      uint32_t dex_pc = pc_trace->Get(i);
+      mirror::LongArray* pc_trace = down_cast<mirror::LongArray*>(method_trace->Get(depth));
+      uint32_t dex_pc = InternalStackTraceDexPc(method, pc_trace->Get(i));
       line_number = mh.GetLineNumFromDexPC(dex_pc);
       // Allocate element, potentially triggering GC
       // TODO: reuse class_name_object via Class::name_?
@@ -1573,6 +1645,7 @@ void Thread::ThrowNewWrappedException(const ThrowLocation& throw_location,
                                       const char* exception_class_descriptor,
                                       const char* msg) {
   DCHECK_EQ(this, Thread::Current());
+  ++counters_.exceptions_thrown;
   ScopedObjectAccessUnchecked soa(this);
   StackHandleScope<5> hs(soa.Self());
   // Ensure we don't forget arguments over object allocation.
@@ -1737,6 +1810,7 @@ void Thread::DumpThreadOffset(std::ostream& os, uint32_t offset) {
   DO_THREAD_OFFSET(TopShadowFrameOffset<ptr_size>(), "top_shadow_frame")
   DO_THREAD_OFFSET(TopHandleScopeOffset<ptr_size>(), "top_handle_scope")
   DO_THREAD_OFFSET(ThreadSuspendTriggerOffset<ptr_size>(), "suspend_trigger")
+  DO_THREAD_OFFSET(OsrLocalsOffset<ptr_size>(), "osr_locals")
 #undef DO_THREAD_OFFSET
 
 #define INTERPRETER_ENTRY_POINT_INFO(x) \
@@ -1851,6 +1925,7 @@ void Thread::DumpThreadOffset(std::ostream& os, uint32_t offset) {
   QUICK_ENTRY_POINT_INFO(pThrowNoSuchMethod)
   QUICK_ENTRY_POINT_INFO(pThrowNullPointer)
   QUICK_ENTRY_POINT_INFO(pThrowStackOverflow)
+  QUICK_ENTRY_POINT_INFO(pDeoptimize)
 #undef QUICK_ENTRY_POINT_INFO
 
   os << offset;
@@ -1877,7 +1952,7 @@ void Thread::QuickDeliverException() {
   }
   QuickExceptionHandler exception_handler(this, is_deoptimization);
   if (is_deoptimization) {
-    exception_handler.DeoptimizeStack();
+    exception_handler.DeoptimizeStack(false);
   } else {
     exception_handler.FindCatch(throw_location, exception);
   }
@@ -2015,6 +2090,12 @@ class ReferenceMapVisitor : public StackVisitor {
     mirror::ArtMethod* m = *method_addr;
     // Process register map (which native and runtime methods don't have)
     if (!m->IsNative() && !m->IsRuntimeMethod() && !m->IsProxyMethod()) {
+      const void* entry_point = Runtime::Current()->GetInstrumentation()->GetQuickCodeFor(m);
+      const void* code_pointer = mirror::ArtMethod::EntryPointToCodePointer(entry_point);
+      if (m->HasStackMaps(code_pointer)) {
+        VisitQuickFrameWithStackMaps(m, entry_point, code_pointer);
+        return;
+      }
       const uint8_t* native_gc_map = m->GetNativeGcMap();
       CHECK(native_gc_map != nullptr) << PrettyMethod(m);
       mh_.ChangeMethod(m);
@@ -2024,12 +2105,9 @@ class ReferenceMapVisitor : public StackVisitor {
       size_t num_regs = std::min(map.RegWidth() * 8,
                                  static_cast<size_t>(code_item->registers_size_));
       if (num_regs > 0) {
-        Runtime* runtime = Runtime::Current();
-        const void* entry_point = runtime->GetInstrumentation()->GetQuickCodeFor(m);
         uintptr_t native_pc_offset = m->NativePcOffset(GetCurrentQuickFramePc(), entry_point);
         const uint8_t* reg_bitmap = map.FindBitMap(native_pc_offset);
         DCHECK(reg_bitmap != nullptr);
-        const void* code_pointer = mirror::ArtMethod::EntryPointToCodePointer(entry_point);
         const VmapTable vmap_table(m->GetVmapTable(code_pointer));
         QuickMethodFrameInfo frame_info = m->GetQuickFrameInfo(code_pointer);
         // For all dex registers in the bitmap
@@ -2067,6 +2145,45 @@ class ReferenceMapVisitor : public StackVisitor {
     }
   }
 
+  // Stack maps record the references of a safepoint by stack slot and core
+  // register rather than by dex register, so the slot or register number is
+  // what is passed to the visitor.
+  void VisitQuickFrameWithStackMaps(mirror::ArtMethod* m, const void* entry_point,
+                                    const void* code_pointer)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
+    uintptr_t native_pc_offset = m->NativePcOffset(GetCurrentQuickFramePc(), entry_point);
+    StackMap stack_map;
+    bool found = m->GetCodeInfo(code_pointer).FindStackMapForNativePcOffset(native_pc_offset,
+                                                                            &stack_map);
+    CHECK(found) << "No stack map at native pc offset " << native_pc_offset << " in "
+                 << PrettyMethod(m);
+    byte* cur_quick_frame = reinterpret_cast<byte*>(GetCurrentQuickFrame());
+    DCHECK(cur_quick_frame != nullptr);
+    for (size_t slot = 0, e = stack_map.GetNumberOfStackSlots(); slot < e; ++slot) {
+      if (stack_map.IsStackSlotReference(slot)) {
+        StackReference<mirror::Object>* ref_addr =
+            reinterpret_cast<StackReference<mirror::Object>*>(cur_quick_frame + slot * kVRegSize);
+        mirror::Object* ref = ref_addr->AsMirrorPtr();
+        if (ref != nullptr) {
+          mirror::Object* new_ref = ref;
+          visitor_(&new_ref, slot, this);
+          if (ref != new_ref) {
+            ref_addr->Assign(new_ref);
+          }
+        }
+      }
+    }
+    uint32_t register_mask = stack_map.GetRegisterMask();
+    for (size_t reg = 0; register_mask != 0; ++reg, register_mask >>= 1) {
+      if ((register_mask & 1) != 0) {
+        mirror::Object** ref_addr = reinterpret_cast<mirror::Object**>(GetGPRAddress(reg));
+        if (*ref_addr != nullptr) {
+          visitor_(ref_addr, reg, this);
+        }
+      }
+    }
+  }
+
   static bool TestBitmap(size_t reg, const uint8_t* reg_vector) {
     return ((reg_vector[reg / kBitsPerByte] >> (reg % kBitsPerByte)) & 0x01) != 0;
   }
@@ -29,10 +29,13 @@
 #include "entrypoints/interpreter/interpreter_entrypoints.h"
 #include "entrypoints/jni/jni_entrypoints.h"
 #include "entrypoints/portable/portable_entrypoints.h"
+#include "entrypoints/quick/generic_jni_layout_cache.h"
 #include "entrypoints/quick/quick_entrypoints.h"
 #include "gc/allocator/rosalloc.h"
 #include "globals.h"
 #include "handle_scope.h"
+#include "interpreter/interpreter_cache.h"
+#include "quick/quick_frame_info_cache.h"
 #include "jvalue.h"
 #include "object_callbacks.h"
 #include "offsets.h"
@@ -49,6 +52,10 @@ class SemiSpace;
 }  // namespace collector
 }  // namespace gc
 
+namespace jit {
+struct JitSampleBuffer;
+}  // namespace jit
+
 namespace mirror {
   class ArtMethod;
   class Array;
@@ -62,11 +69,13 @@ namespace mirror {
   class StaticStorageBase;
   class Throwable;
 }  // namespace mirror
+struct AllocRecordBuffer;
 class BaseMutex;
 class ClassLinker;
 class Closure;
 class Context;
 struct DebugInvokeReq;
+struct ReceiverTypeBuffer;
 class DexFile;
 class JavaVMExt;
 struct JNIEnvExt;
@@ -165,6 +174,12 @@ class Thread {
       LOCKS_EXCLUDED(Locks::thread_suspend_count_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Dumps the SIGQUIT per-thread header of this thread.
+  void DumpState(std::ostream& os) const SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
+  // Whether the thread is in native code where its native stack is worth dumping.
+  bool ShouldDumpNativeStack() const SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   // Dumps the SIGQUIT per-thread header. 'thread' can be NULL for a non-attached thread, in which
   // case we use 'tid' to identify the thread, and we'll include as much information as we can.
   static void DumpState(std::ostream& os, const Thread* thread, pid_t tid)
@@ -301,6 +316,69 @@ class Thread {
     return &tls64_.stats;
   }
 
+  RuntimeCounters* GetCounters() {
+    return &counters_;
+  }
+
+  const RuntimeCounters* GetCounters() const {
+    return &counters_;
+  }
+
+  RuntimeLatencies* GetLatencies() {
+    return &latencies_;
+  }
+
+  const RuntimeLatencies* GetLatencies() const {
+    return &latencies_;
+  }
+
+  // Bytes this thread may allocate before the allocation sampler takes its next sample.
+  size_t GetAllocationSampleBytesRemaining() const {
+    return tlsPtr_.allocation_sample_bytes_remaining;
+  }
+  void SetAllocationSampleBytesRemaining(size_t bytes) {
+    tlsPtr_.allocation_sample_bytes_remaining = bytes;
+  }
+
+  // The locals handed to the OSR entry of compiled code by on-stack replacement.
+  void SetOsrLocals(uint32_t* locals) {
+    tlsPtr_.osr_locals = locals;
+  }
+
+  // What the interpreter resolved for the instructions this thread interpreted.
+  InterpreterCache* GetInterpreterCache() {
+    return &interpreter_cache_;
+  }
+
+  // Advances the thread's identity hash code generator, a xorshift which never returns 0.
+  uint32_t NextIdentityHashState() {
+    uint32_t x = identity_hash_state_;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    identity_hash_state_ = x;
+    return x;
+  }
+
+  // The layouts of the quick frames the stack walks of this thread went through.
+  QuickFrameInfoCache* GetQuickFrameInfoCache() {
+    return &quick_frame_info_cache_;
+  }
+
+  // The native call frame layouts of the generic JNI calls of this thread.
+  GenericJniLayoutCache* GetGenericJniLayoutCache() {
+    return &generic_jni_layout_cache_;
+  }
+
+  // Whether the GC marked the roots of this thread at a checkpoint it ran on its behalf while it
+  // was suspended, and the thread hasn't been runnable since, so that its roots haven't changed.
+  bool AreRootsMarkedWhileSuspended() const {
+    return roots_marked_while_suspended_;
+  }
+  void SetRootsMarkedWhileSuspended(bool marked) {
+    roots_marked_while_suspended_ = marked;
+  }
+
   bool IsStillStarting() const;
 
   bool IsExceptionPending() const {
@@ -469,6 +547,11 @@ class Thread {
       jobjectArray output_array = nullptr, int* stack_depth = nullptr)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Returns the dex pc of a frame of `method` from the pc the internal stack trace recorded for
+  // it, which is the native pc of quick frames: their dex pcs are only looked up when needed.
+  static uint32_t InternalStackTraceDexPc(mirror::ArtMethod* method, int64_t pc)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   void VisitRoots(RootCallback* visitor, void* arg) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
   ALWAYS_INLINE void VerifyStack() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -546,6 +629,11 @@ class Thread {
     return ThreadOffsetFromTlsPtr<pointer_size>(OFFSETOF_MEMBER(tls_ptr_sized_values, exception));
   }
 
+  template<size_t pointer_size>
+  static ThreadOffset<pointer_size> OsrLocalsOffset() {
+    return ThreadOffsetFromTlsPtr<pointer_size>(OFFSETOF_MEMBER(tls_ptr_sized_values, osr_locals));
+  }
+
   template<size_t pointer_size>
   static ThreadOffset<pointer_size> PeerOffset() {
     return ThreadOffsetFromTlsPtr<pointer_size>(OFFSETOF_MEMBER(tls_ptr_sized_values, opeer));
@@ -557,6 +645,24 @@ class Thread {
     return ThreadOffsetFromTlsPtr<pointer_size>(OFFSETOF_MEMBER(tls_ptr_sized_values, card_table));
   }
 
+  template<size_t pointer_size>
+  static ThreadOffset<pointer_size> ThreadLocalPosOffset() {
+    return ThreadOffsetFromTlsPtr<pointer_size>(
+        OFFSETOF_MEMBER(tls_ptr_sized_values, thread_local_pos));
+  }
+
+  template<size_t pointer_size>
+  static ThreadOffset<pointer_size> ThreadLocalEndOffset() {
+    return ThreadOffsetFromTlsPtr<pointer_size>(
+        OFFSETOF_MEMBER(tls_ptr_sized_values, thread_local_end));
+  }
+
+  template<size_t pointer_size>
+  static ThreadOffset<pointer_size> ThreadLocalObjectsOffset() {
+    return ThreadOffsetFromTlsPtr<pointer_size>(
+        OFFSETOF_MEMBER(tls_ptr_sized_values, thread_local_objects));
+  }
+
   template<size_t pointer_size>
   static ThreadOffset<pointer_size> ThreadSuspendTriggerOffset() {
     return ThreadOffsetFromTlsPtr<pointer_size>(
@@ -723,6 +829,23 @@ class Thread {
     tlsPtr_.stack_trace_sample = sample;
   }
 
+  // Events of the thread not written out yet by a streaming method trace, or null.
+  uint8_t* GetTraceBuffer() const {
+    return tlsPtr_.trace_buffer;
+  }
+
+  void SetTraceBuffer(uint8_t* buffer) {
+    tlsPtr_.trace_buffer = buffer;
+  }
+
+  size_t GetTraceBufferPos() const {
+    return tlsPtr_.trace_buffer_pos;
+  }
+
+  void SetTraceBufferPos(size_t pos) {
+    tlsPtr_.trace_buffer_pos = pos;
+  }
+
   uint64_t GetTraceClockBase() const {
     return tls64_.trace_clock_base;
   }
@@ -731,6 +854,71 @@ class Thread {
     tls64_.trace_clock_base = clock_base;
   }
 
+  // Allocations the thread recorded for DDMS which are not merged into the shared records yet, or
+  // null.
+  AllocRecordBuffer* GetAllocRecordBuffer() const {
+    return tlsPtr_.alloc_record_buffer;
+  }
+
+  void SetAllocRecordBuffer(AllocRecordBuffer* buffer) {
+    tlsPtr_.alloc_record_buffer = buffer;
+  }
+
+  // The receiver types the thread recorded for the profiler which are not merged into the
+  // profile yet, or null.
+  ReceiverTypeBuffer* GetReceiverTypeBuffer() const {
+    return tlsPtr_.receiver_type_buffer;
+  }
+
+  void SetReceiverTypeBuffer(ReceiverTypeBuffer* buffer) {
+    tlsPtr_.receiver_type_buffer = buffer;
+  }
+
+  // The method entries the thread interpreted which are not reported to the JIT yet, or null.
+  jit::JitSampleBuffer* GetJitSampleBuffer() const {
+    return tlsPtr_.jit_sample_buffer;
+  }
+
+  void SetJitSampleBuffer(jit::JitSampleBuffer* buffer) {
+    tlsPtr_.jit_sample_buffer = buffer;
+  }
+
+  // The free monitors the MonitorPool cached for the thread, see MonitorPool::CreateMonitor.
+  void* GetMonitorPoolCache() const {
+    return tlsPtr_.monitor_pool_cache;
+  }
+
+  size_t GetMonitorPoolCacheSize() const {
+    return tlsPtr_.monitor_pool_cache_size;
+  }
+
+  void SetMonitorPoolCache(void* cache, size_t size) {
+    tlsPtr_.monitor_pool_cache = cache;
+    tlsPtr_.monitor_pool_cache_size = size;
+  }
+
+  // The gray objects the read barrier of the concurrent copying collector found, which the
+  // collector takes in blocks rather than one at a time, see ConcurrentCopying::PushOntoMarkStack.
+  bool PushOnGcMarkBuffer(mirror::Object* obj) {
+    if (UNLIKELY(tlsPtr_.gc_mark_buffer_size == kGcMarkBufferSize)) {
+      return false;
+    }
+    tlsPtr_.gc_mark_buffer[tlsPtr_.gc_mark_buffer_size++] = obj;
+    return true;
+  }
+
+  mirror::Object** GetGcMarkBuffer() {
+    return tlsPtr_.gc_mark_buffer;
+  }
+
+  size_t GetGcMarkBufferSize() const {
+    return tlsPtr_.gc_mark_buffer_size;
+  }
+
+  void ResetGcMarkBuffer() {
+    tlsPtr_.gc_mark_buffer_size = 0;
+  }
+
   BaseMutex* GetHeldMutex(LockLevel level) const {
     return tlsPtr_.held_mutexes[level];
   }
@@ -762,6 +950,18 @@ class Thread {
   void SetTlab(byte* start, byte* end);
   bool HasTlab() const;
 
+  // The state the heap sizes the TLABs of this thread by, see Heap::NextTlabSize.
+  struct TlabSizing {
+    // The size of the last TLAB, not counting the allocation which needed it.
+    size_t size;
+    // The bytes allocated in the TLABs retired since the GC gc_count counts.
+    size_t bytes_since_gc;
+    uint32_t gc_count;
+  };
+  TlabSizing* GetTlabSizing() {
+    return &tlab_sizing_;
+  }
+
   // Remove the suspend trigger for this thread by making the suspend_trigger_ TLS value
   // equal to a valid pointer.
   // TODO: does this need to atomic?  I don't think so.
@@ -820,12 +1020,14 @@ class Thread {
   ThreadState SetStateUnsafe(ThreadState new_state) {
     ThreadState old_state = GetState();
     tls32_.state_and_flags.as_struct.state = new_state;
+    if (new_state == kRunnable) {
+      roots_marked_while_suspended_ = false;
+    }
     return old_state;
   }
 
   void VerifyStackImpl() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
-  void DumpState(std::ostream& os) const SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void DumpStack(std::ostream& os) const
       LOCKS_EXCLUDED(Locks::thread_suspend_count_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -837,6 +1039,15 @@ class Thread {
 
   static void* CreateCallback(void* arg);
 
+  // Parks the native thread of a finished Thread, whose stack is `stack_size` bytes, until
+  // CreateNativeThread gives it another Thread to run. Returns that Thread, or nullptr if the
+  // native thread should exit instead.
+  static Thread* WaitForNextThread(size_t stack_size) LOCKS_EXCLUDED(idle_native_threads_lock_);
+
+  // Gives `child` to a parked native thread with a stack of `stack_size` bytes, if there is one.
+  static bool RunOnIdleNativeThread(Thread* self, Thread* child, size_t stack_size)
+      LOCKS_EXCLUDED(idle_native_threads_lock_);
+
   void HandleUncaughtExceptions(ScopedObjectAccess& soa)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   void RemoveFromThreadGroup(ScopedObjectAccess& soa) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -880,6 +1091,9 @@ class Thread {
   // Maximum number of checkpoint functions.
   static constexpr uint32_t kMaxCheckpoints = 3;
 
+  // Size of the buffer of gray objects, see PushOnGcMarkBuffer.
+  static constexpr size_t kGcMarkBufferSize = 32;
+
   // Has Thread::Startup been called?
   static bool is_started_;
 
@@ -890,6 +1104,13 @@ class Thread {
   // their suspend count is > 0.
   static ConditionVariable* resume_cond_ GUARDED_BY(Locks::thread_suspend_count_lock_);
 
+  // The native threads parked by WaitForNextThread, most recently parked first. They are never
+  // deleted, as parked native threads may outlive the runtime.
+  struct IdleNativeThread;
+  static Mutex* idle_native_threads_lock_;
+  static ConditionVariable* idle_native_threads_cond_ GUARDED_BY(idle_native_threads_lock_);
+  static std::list<IdleNativeThread*>* idle_native_threads_ GUARDED_BY(idle_native_threads_lock_);
+
   /***********************************************************************************************/
   // Thread local storage. Fields are grouped by size to enable 32 <-> 64 searching to account for
   // pointer size differences. To encourage shorter encoding, more frequently used values appear
@@ -965,7 +1186,11 @@ class Thread {
       deoptimization_shadow_frame(nullptr), name(nullptr), pthread_self(0),
       last_no_thread_suspension_cause(nullptr), thread_local_start(nullptr),
       thread_local_pos(nullptr), thread_local_end(nullptr), thread_local_objects(0),
-      thread_local_alloc_stack_top(nullptr), thread_local_alloc_stack_end(nullptr) {
+      thread_local_alloc_stack_top(nullptr), thread_local_alloc_stack_end(nullptr),
+      allocation_sample_bytes_remaining(0), osr_locals(nullptr), trace_buffer(nullptr),
+      trace_buffer_pos(0), alloc_record_buffer(nullptr), monitor_pool_cache(nullptr),
+      monitor_pool_cache_size(0), gc_mark_buffer_size(0), jit_sample_buffer(nullptr),
+      receiver_type_buffer(nullptr) {
     }
 
     // The biased card table, see CardTable for details.
@@ -1074,6 +1299,34 @@ class Thread {
     // Thread-local allocation stack data/routines.
     mirror::Object** thread_local_alloc_stack_top;
     mirror::Object** thread_local_alloc_stack_end;
+
+    // Allocation sampler countdown, zero until the thread's first instrumented allocation.
+    size_t allocation_sample_bytes_remaining;
+
+    // Values of the locals of an interpreted frame being replaced by a compiled one, read by the
+    // OSR entry the compiled code is called at.
+    uint32_t* osr_locals;
+
+    // Events recorded for a streaming method trace and the size of those in the buffer.
+    uint8_t* trace_buffer;
+    size_t trace_buffer_pos;
+
+    // Allocations recorded by the DDMS allocation tracker, see Dbg::RecordAllocation.
+    AllocRecordBuffer* alloc_record_buffer;
+
+    // Free monitors of the 64bit MonitorPool, allocated from without taking its lock.
+    void* monitor_pool_cache;
+    size_t monitor_pool_cache_size;
+
+    // Gray objects not yet handed to the concurrent copying collector.
+    mirror::Object* gc_mark_buffer[kGcMarkBufferSize];
+    size_t gc_mark_buffer_size;
+
+    // Method entries counted for the JIT, see Jit::AddMethodEntrySample.
+    jit::JitSampleBuffer* jit_sample_buffer;
+
+    // Receiver types recorded for the profiler, see BackgroundMethodSamplingProfiler.
+    ReceiverTypeBuffer* receiver_type_buffer;
   } tlsPtr_;
 
   // Guards the 'interrupted_' and 'wait_monitor_' members.
@@ -1087,6 +1340,31 @@ class Thread {
   // Thread "interrupted" status; stays raised until queried or thrown.
   bool interrupted_ GUARDED_BY(wait_mutex_);
 
+  // Only accessed by the thread itself.
+  InterpreterCache interpreter_cache_;
+
+  // Only accessed by the thread itself, for the stacks it walks.
+  QuickFrameInfoCache quick_frame_info_cache_;
+
+  // Only accessed by the thread itself.
+  GenericJniLayoutCache generic_jni_layout_cache_;
+
+  // Set by the GC while the thread is suspended, cleared by the thread when it becomes runnable.
+  bool roots_marked_while_suspended_;
+
+  // Only accessed by the thread itself. Never 0.
+  uint32_t identity_hash_state_;
+
+  // The stack size CreateNativeThread requested for the native thread of this Thread, which
+  // is passed on to the Threads that native thread runs next. 0 for attached threads.
+  size_t native_stack_size_;
+
+  TlabSizing tlab_sizing_;
+
+  // Not in tls64_, the offsets of the thread-local values used by the generated code are fixed.
+  RuntimeCounters counters_;
+  RuntimeLatencies latencies_;
+
   friend class Dbg;  // For SetStateUnsafe.
   friend class gc::collector::SemiSpace;  // For getting stack traces.
   friend class Runtime;  // For CreatePeer.
@@ -25,6 +25,10 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <sstream>
+
+#include "barrier.h"
 #include "base/mutex.h"
 #include "base/mutex-inl.h"
 #include "base/timing_logger.h"
@@ -94,6 +98,136 @@ void ThreadList::DumpForSigQuit(std::ostream& os) {
   DumpUnattachedThreads(os);
 }
 
+// Records the state and managed stack of each thread for ThreadList::Dump.
+class DumpCheckpoint : public Closure {
+ public:
+  struct ThreadDump {
+    pid_t tid;
+    std::string state;
+    bool dump_native_stack;
+    std::string java_stack;
+
+    bool operator<(const ThreadDump& other) const {
+      return tid < other.tid;
+    }
+  };
+
+  explicit DumpCheckpoint(Thread* dumping_thread)
+      : dumping_thread_(dumping_thread), lock_("dump checkpoint lock"), barrier_(0) {}
+
+  virtual void Run(Thread* thread) OVERRIDE {
+    // Note: self is not necessarily equal to thread since thread may be suspended.
+    Thread* self = Thread::Current();
+    ThreadDump dump;
+    dump.tid = thread->GetTid();
+    {
+      ScopedObjectAccess soa(self);
+      std::ostringstream state;
+      thread->DumpState(state);
+      dump.state = state.str();
+      // The native stack of the dumping thread is this code.
+      dump.dump_native_stack = thread != dumping_thread_ && thread->ShouldDumpNativeStack();
+      std::ostringstream java_stack;
+      thread->DumpJavaStack(java_stack);
+      dump.java_stack = java_stack.str();
+    }
+    {
+      MutexLock mu(self, lock_);
+      dumps_.push_back(dump);
+    }
+    barrier_.Pass(self);
+  }
+
+  void WaitForThreadsToRunThroughCheckpoint(size_t threads_running_checkpoint) {
+    Thread* self = Thread::Current();
+    ScopedThreadStateChange tsc(self, kWaitingForCheckPointsToRun);
+    barrier_.Increment(self, threads_running_checkpoint);
+  }
+
+  // Only called once every thread ran the checkpoint.
+  std::vector<ThreadDump>& GetDumps() NO_THREAD_SAFETY_ANALYSIS {
+    return dumps_;
+  }
+
+ private:
+  Thread* const dumping_thread_;
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::vector<ThreadDump> dumps_ GUARDED_BY(lock_);
+  Barrier barrier_;
+};
+
+void ThreadList::Dump(std::ostream& os) {
+  Thread* self = Thread::Current();
+  DumpCheckpoint checkpoint(self);
+  size_t threads_running_checkpoint = RunCheckpoint(&checkpoint);
+  checkpoint.WaitForThreadsToRunThroughCheckpoint(threads_running_checkpoint);
+
+  // The threads run again, unwinding and symbolizing their native stacks doesn't pause them.
+  std::vector<DumpCheckpoint::ThreadDump>& dumps = checkpoint.GetDumps();
+  std::sort(dumps.begin(), dumps.end());
+  os << "DALVIK THREADS (" << dumps.size() << "):\n";
+  for (const DumpCheckpoint::ThreadDump& dump : dumps) {
+    os << dump.state;
+    if (dump.dump_native_stack) {
+      DumpKernelStack(os, dump.tid, "  kernel: ", false);
+      DumpNativeStack(os, dump.tid, "  native: ");
+    }
+    os << dump.java_stack << "\n";
+  }
+  DumpUnattachedThreads(os);
+}
+
+static void DumpRuntimeCountersLine(std::ostream& os, const RuntimeCounters& counters) {
+  os << " jni_calls=" << counters.jni_calls
+     << " monitor_contentions=" << counters.monitor_contentions
+     << " suspend_waits=" << counters.suspend_waits
+     << " class_loads=" << counters.class_loads
+     << " exceptions_thrown=" << counters.exceptions_thrown
+     << " interpreter_entries=" << counters.interpreter_entries
+     << " deoptimizations=" << counters.deoptimizations << "\n";
+}
+
+void ThreadList::DumpRuntimeCounters(std::ostream& os) {
+  MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
+  RuntimeCounters total;
+  std::string name;
+  for (const auto& thread : list_) {
+    // Read while the thread updates them, a counter may miss its latest increments.
+    RuntimeCounters counters;
+    counters.Add(*thread->GetCounters());
+    total.Add(counters);
+    thread->GetThreadName(name);
+    os << "\"" << name << "\" tid=" << thread->GetTid() << ":";
+    DumpRuntimeCountersLine(os, counters);
+  }
+  os << "Exited threads:";
+  DumpRuntimeCountersLine(os, exited_thread_counters_);
+  total.Add(exited_thread_counters_);
+  os << "Total:";
+  DumpRuntimeCountersLine(os, total);
+}
+
+void ThreadList::DumpRuntimeLatencies(std::ostream& os) {
+  RuntimeLatencies total;
+  {
+    MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
+    // Read while the threads record values, a histogram may miss its latest values.
+    for (const auto& thread : list_) {
+      total.Add(*thread->GetLatencies());
+    }
+    total.Add(exited_thread_latencies_);
+  }
+  os << "alloc_slow_path_ns: ";
+  total.alloc_slow_path_ns.Dump(os);
+  os << "\nmonitor_contention_ns: ";
+  total.monitor_contention_ns.Dump(os);
+  os << "\ngc_pause_ns: ";
+  total.gc_pause_ns.Dump(os);
+  os << "\ngc_ns: ";
+  total.gc_ns.Dump(os);
+  os << "\n";
+}
+
 static void DumpUnattachedThread(std::ostream& os, pid_t tid) NO_THREAD_SAFETY_ANALYSIS {
   // TODO: No thread safety analysis as DumpState with a NULL thread won't access fields, should
   // refactor DumpState to avoid skipping analysis.
@@ -152,6 +286,27 @@ void ThreadList::AssertThreadsAreSuspended(Thread* self, Thread* ignore1, Thread
   }
 }
 
+void ThreadList::LogThreadsSlowToSuspend(Thread* self, int64_t waited_ms) {
+  std::ostringstream ss;
+  size_t num_runnable = 0;
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    for (const auto& thread : list_) {
+      // Threads may suspend while we look at them, the others are at least in managed code or the
+      // runtime, their native pcs show where they don't check for suspension.
+      if (thread != self && thread->GetState() == kRunnable) {
+        ++num_runnable;
+        ss << *thread << "\n";
+        DumpNativeStack(ss, thread->GetTid(), "  native: ");
+      }
+    }
+  }
+  if (num_runnable != 0) {
+    LOG(WARNING) << "SuspendAll waited over " << waited_ms << "ms for " << num_runnable
+                 << " runnable threads:\n" << ss.str();
+  }
+}
+
 #if HAVE_TIMED_RWLOCK
 // Attempt to rectify locks so that we dump thread list with required locks before exiting.
 static void UnsafeLogFatalForThreadSuspendAllTimeout(Thread* self) NO_THREAD_SAFETY_ANALYSIS __attribute__((noreturn));
@@ -333,9 +488,14 @@ void ThreadList::SuspendAll() {
 
   // Block on the mutator lock until all Runnable threads release their share of access.
 #if HAVE_TIMED_RWLOCK
-  // Timeout if we wait more than 30 seconds.
-  if (!Locks::mutator_lock_->ExclusiveLockWithTimeout(self, 30 * 1000, 0)) {
-    UnsafeLogFatalForThreadSuspendAllTimeout(self);
+  // Name the threads which are slow to reach a suspend point, then keep waiting for them and
+  // timeout if we wait more than 30 seconds in total.
+  if (!Locks::mutator_lock_->ExclusiveLockWithTimeout(self, kSlowSuspendAllThresholdMs, 0)) {
+    LogThreadsSlowToSuspend(self, kSlowSuspendAllThresholdMs);
+    if (!Locks::mutator_lock_->ExclusiveLockWithTimeout(
+        self, kSuspendAllTimeoutMs - kSlowSuspendAllThresholdMs, 0)) {
+      UnsafeLogFatalForThreadSuspendAllTimeout(self);
+    }
   }
 #else
   Locks::mutator_lock_->ExclusiveLock(self);
@@ -589,7 +749,7 @@ void ThreadList::SuspendAllForDebugger() {
   // immediately unlock again.
 #if HAVE_TIMED_RWLOCK
   // Timeout if we wait more than 30 seconds.
-  if (!Locks::mutator_lock_->ExclusiveLockWithTimeout(self, 30 * 1000, 0)) {
+  if (!Locks::mutator_lock_->ExclusiveLockWithTimeout(self, kSuspendAllTimeoutMs, 0)) {
     UnsafeLogFatalForThreadSuspendAllTimeout(self);
   } else {
     Locks::mutator_lock_->ExclusiveUnlock(self);
@@ -793,6 +953,8 @@ void ThreadList::Unregister(Thread* self) {
     // Note: we don't take the thread_suspend_count_lock_ here as to be suspending a thread other
     // than yourself you need to hold the thread_list_lock_ (see Thread::ModifySuspendCount).
     if (!self->IsSuspended()) {
+      exited_thread_counters_.Add(*self->GetCounters());
+      exited_thread_latencies_.Add(*self->GetLatencies());
       list_.remove(self);
       delete self;
       self = nullptr;
@@ -826,6 +988,22 @@ void ThreadList::VisitRoots(RootCallback* callback, void* arg) const {
   }
 }
 
+size_t ThreadList::VisitRootsOfThreadsRunSinceMarked(RootCallback* callback, void* arg) const {
+  // The debugger can write references into the frames of suspended threads.
+  const bool debugger_active = Dbg::IsDebuggerActive();
+  size_t skipped = 0;
+  MutexLock mu(Thread::Current(), *Locks::thread_list_lock_);
+  for (const auto& thread : list_) {
+    if (thread->AreRootsMarkedWhileSuspended() && !debugger_active) {
+      ++skipped;
+    } else {
+      thread->VisitRoots(callback, arg);
+    }
+    thread->SetRootsMarkedWhileSuspended(false);
+  }
+  return skipped;
+}
+
 class VerifyRootWrapperArg {
  public:
   VerifyRootWrapperArg(VerifyRootCallback* callback, void* arg) : callback_(callback), arg_(arg) {
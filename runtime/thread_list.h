@@ -20,6 +20,7 @@
 #include "base/mutex.h"
 #include "jni.h"
 #include "object_callbacks.h"
+#include "runtime_stats.h"
 
 #include <bitset>
 #include <list>
@@ -34,6 +35,10 @@ class ThreadList {
   static const uint32_t kMaxThreadId = 0xFFFF;
   static const uint32_t kInvalidThreadId = 0;
   static const uint32_t kMainThreadId = 1;
+  // SuspendAll names the threads still runnable after waiting this long for them.
+  static constexpr int64_t kSlowSuspendAllThresholdMs = 20;
+  // SuspendAll aborts after waiting this long for the runnable threads.
+  static constexpr int64_t kSuspendAllTimeoutMs = 30 * 1000;
 
   explicit ThreadList();
   ~ThreadList();
@@ -41,6 +46,16 @@ class ThreadList {
   void DumpForSigQuit(std::ostream& os)
       LOCKS_EXCLUDED(Locks::thread_list_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  // Dumps the threads like DumpForSigQuit without suspending all of them: each thread dumps its
+  // managed stack in a checkpoint, and the native stacks are unwound after the checkpoints, without
+  // the mutator lock.
+  void Dump(std::ostream& os)
+      LOCKS_EXCLUDED(Locks::mutator_lock_, Locks::thread_list_lock_);
+  // Dumps the runtime counters of each thread, and of the exited threads, without suspending the
+  // threads. The counters of the running threads may be slightly stale.
+  void DumpRuntimeCounters(std::ostream& os) LOCKS_EXCLUDED(Locks::thread_list_lock_);
+  // Dumps the latency distributions of all threads, live and exited, merged.
+  void DumpRuntimeLatencies(std::ostream& os) LOCKS_EXCLUDED(Locks::thread_list_lock_);
   void DumpLocked(std::ostream& os)  // For thread suspend timeout dumps.
       EXCLUSIVE_LOCKS_REQUIRED(Locks::thread_list_lock_)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -119,6 +134,12 @@ class ThreadList {
   void VisitRoots(RootCallback* callback, void* arg) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
+  // Visit the roots of the threads which may have changed them since the GC last marked them, the
+  // others stayed suspended since a checkpoint marked their roots. Resets the marks for the next
+  // GC. Returns the number of threads skipped. Requires the mutators to be suspended.
+  size_t VisitRootsOfThreadsRunSinceMarked(RootCallback* callback, void* arg) const
+      EXCLUSIVE_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   void VerifyRoots(VerifyRootCallback* callback, void* arg) const
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
@@ -151,6 +172,11 @@ class ThreadList {
       LOCKS_EXCLUDED(Locks::thread_list_lock_,
                      Locks::thread_suspend_count_lock_);
 
+  // Logs the threads other than self which are still runnable, with their native stacks, for
+  // SuspendAll calls which wait on them for long.
+  void LogThreadsSlowToSuspend(Thread* self, int64_t waited_ms)
+      LOCKS_EXCLUDED(Locks::thread_list_lock_);
+
   mutable Mutex allocated_ids_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   std::bitset<kMaxThreadId> allocated_ids_ GUARDED_BY(allocated_ids_lock_);
 
@@ -164,6 +190,10 @@ class ThreadList {
   // Signaled when threads terminate. Used to determine when all non-daemons have terminated.
   ConditionVariable thread_exit_cond_ GUARDED_BY(Locks::thread_list_lock_);
 
+  // The sum of the runtime counters of the threads removed from list_.
+  RuntimeCounters exited_thread_counters_ GUARDED_BY(Locks::thread_list_lock_);
+  RuntimeLatencies exited_thread_latencies_ GUARDED_BY(Locks::thread_list_lock_);
+
   friend class Thread;
 
   DISALLOW_COPY_AND_ASSIGN(ThreadList);
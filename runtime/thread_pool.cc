@@ -16,10 +16,19 @@
 
 #include "thread_pool.h"
 
+#include <stdio.h>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
 #include "base/casts.h"
 #include "base/stl_util.h"
+#include "base/stringprintf.h"
 #include "runtime.h"
 #include "thread-inl.h"
+#include "utils.h"
 
 namespace art {
 
@@ -28,7 +37,9 @@ static constexpr bool kMeasureWaitTime = false;
 ThreadPoolWorker::ThreadPoolWorker(ThreadPool* thread_pool, const std::string& name,
                                    size_t stack_size)
     : thread_pool_(thread_pool),
-      name_(name) {
+      name_(name),
+      queue_index_(thread_pool->GetThreadCount()),
+      thread_(nullptr) {
   std::string error_msg;
   stack_.reset(MemMap::MapAnonymous(name.c_str(), nullptr, stack_size, PROT_READ | PROT_WRITE,
                                     false, &error_msg));
@@ -49,7 +60,7 @@ void ThreadPoolWorker::Run() {
   Thread* self = Thread::Current();
   Task* task = NULL;
   thread_pool_->creation_barier_.Wait(self);
-  while ((task = thread_pool_->GetTask(self)) != NULL) {
+  while ((task = thread_pool_->GetTask(self, queue_index_)) != NULL) {
     task->Run(self);
     task->Finalize();
   }
@@ -59,17 +70,39 @@ void* ThreadPoolWorker::Callback(void* arg) {
   ThreadPoolWorker* worker = reinterpret_cast<ThreadPoolWorker*>(arg);
   Runtime* runtime = Runtime::Current();
   CHECK(runtime->AttachCurrentThread(worker->name_.c_str(), true, NULL, false));
+  worker->thread_ = Thread::Current();
   // Do work until its time to shut down.
   worker->Run();
   runtime->DetachCurrentThread();
   return NULL;
 }
 
-void ThreadPool::AddTask(Thread* self, Task* task) {
-  MutexLock mu(self, task_queue_lock_);
-  tasks_.push_back(task);
-  // If we have any waiters, signal one.
-  if (started_ && waiting_count_ != 0) {
+void ThreadPool::AddTask(Thread* self, Task* task, TaskPriority priority, size_t worker_hint) {
+  size_t queue_index = worker_hint;
+  if (queue_index == kAnyWorker) {
+    // Keep the tasks a worker adds, like the subtasks of its task, in its own queue.
+    for (ThreadPoolWorker* worker : threads_) {
+      if (worker->thread_ == self) {
+        queue_index = worker->queue_index_;
+        break;
+      }
+    }
+    if (queue_index == kAnyWorker) {
+      queue_index = static_cast<size_t>(next_queue_++);
+    }
+  }
+  TaskQueue* queue = queues_[queue_index % queues_.size()].get();
+  {
+    MutexLock mu(self, queue->lock);
+    queue->tasks[priority].push_back(task);
+    queue->size = queue->size + 1;
+  }
+  // A worker about to wait counts itself as waiting before looking at the queued tasks, so it
+  // either sees this task or is seen waiting here.
+  ++num_queued_tasks_;
+  if (waiting_count_.Load() != 0) {
+    // Signal one of the waiters, it may steal the task.
+    MutexLock mu(self, task_queue_lock_);
     task_queue_condition_.Signal(self);
   }
 }
@@ -82,12 +115,15 @@ ThreadPool::ThreadPool(const char* name, size_t num_threads)
     started_(false),
     shutting_down_(false),
     waiting_count_(0),
+    num_queued_tasks_(0),
+    next_queue_(0),
     start_time_(0),
     total_wait_time_(0),
     // Add one since the caller of constructor waits on the barrier too.
     creation_barier_(num_threads + 1),
     max_active_workers_(num_threads) {
   Thread* self = Thread::Current();
+  CreateQueues(num_threads);
   while (GetThreadCount() < num_threads) {
     const std::string name = StringPrintf("%s worker thread %zu", name_.c_str(), GetThreadCount());
     threads_.push_back(new ThreadPoolWorker(this, name, ThreadPoolWorker::kDefaultStackSize));
@@ -96,6 +132,85 @@ ThreadPool::ThreadPool(const char* name, size_t num_threads)
   creation_barier_.Wait(self);
 }
 
+void ThreadPool::CreateQueues(size_t num_threads) {
+  CHECK(threads_.empty());
+  while (queues_.size() < std::max<size_t>(num_threads, 1u)) {
+    queues_.push_back(std::unique_ptr<TaskQueue>(new TaskQueue));
+  }
+}
+
+#if defined(__linux__)
+// Adds the CPUs of a sysfs cpulist such as "0-7,16-23" which are in `allowed` and not yet in
+// `cpus`.
+static void AddCpuList(const std::string& cpu_list, const cpu_set_t& allowed,
+                       std::vector<int>* cpus) {
+  std::vector<std::string> ranges;
+  Split(cpu_list, ',', ranges);
+  for (const std::string& range : ranges) {
+    int first;
+    int last;
+    if (sscanf(range.c_str(), "%d-%d", &first, &last) != 2) {
+      if (sscanf(range.c_str(), "%d", &first) != 1) {
+        continue;
+      }
+      last = first;
+    }
+    for (int cpu = std::max(first, 0); cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &allowed) && std::find(cpus->begin(), cpus->end(), cpu) == cpus->end()) {
+        cpus->push_back(cpu);
+      }
+    }
+  }
+}
+#endif
+
+// Returns the CPUs the process may run on, those of NUMA node 0 first, then node 1 and so on.
+static std::vector<int> GetCpusByNode() {
+  std::vector<int> cpus;
+#if defined(__linux__)
+  cpu_set_t allowed;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    PLOG(WARNING) << "sched_getaffinity failed";
+    return cpus;
+  }
+  for (int node = 0; ; ++node) {
+    std::string cpu_list;
+    if (!ReadFileToString(StringPrintf("/sys/devices/system/node/node%d/cpulist", node),
+                          &cpu_list)) {
+      break;
+    }
+    AddCpuList(Trim(cpu_list), allowed, &cpus);
+  }
+  // Kernels without NUMA support have no node directory, and CPUs may be missing from them.
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &allowed) && std::find(cpus.begin(), cpus.end(), cpu) == cpus.end()) {
+      cpus.push_back(cpu);
+    }
+  }
+#endif
+  return cpus;
+}
+
+void ThreadPool::PinWorkers() {
+#if defined(__linux__)
+  std::vector<int> cpus = GetCpusByNode();
+  if (cpus.empty()) {
+    return;
+  }
+  for (size_t i = 0; i < threads_.size(); ++i) {
+    int cpu = cpus[i % cpus.size()];
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    // The workers attached before the constructor returned.
+    pid_t tid = threads_[i]->thread_->GetTid();
+    if (sched_setaffinity(tid, sizeof(cpu_set), &cpu_set) != 0) {
+      PLOG(WARNING) << "Failed to pin " << threads_[i]->name_ << " to CPU " << cpu;
+    }
+  }
+#endif
+}
+
 void ThreadPool::SetMaxActiveWorkers(size_t threads) {
   MutexLock mu(Thread::Current(), task_queue_lock_);
   CHECK_LE(threads, GetThreadCount());
@@ -129,48 +244,80 @@ void ThreadPool::StopWorkers(Thread* self) {
   started_ = false;
 }
 
-Task* ThreadPool::GetTask(Thread* self) {
-  MutexLock mu(self, task_queue_lock_);
-  while (!IsShuttingDown()) {
-    const size_t thread_count = GetThreadCount();
-    // Ensure that we don't use more threads than the maximum active workers.
-    const size_t active_threads = thread_count - waiting_count_;
-    // <= since self is considered an active worker.
-    if (active_threads <= max_active_workers_) {
-      Task* task = TryGetTaskLocked(self);
-      if (task != NULL) {
-        return task;
-      }
+Task* ThreadPool::GetTask(Thread* self, size_t queue_index) {
+  while (true) {
+    // A worker which just ran a task is already active, it doesn't need to check the maximum.
+    Task* task = TryGetTask(self, queue_index);
+    if (task != NULL) {
+      return task;
     }
 
+    MutexLock mu(self, task_queue_lock_);
     ++waiting_count_;
-    if (waiting_count_ == GetThreadCount() && tasks_.empty()) {
-      // We may be done, lets broadcast to the completion condition.
-      completion_condition_.Broadcast(self);
-    }
-    const uint64_t wait_start = kMeasureWaitTime ? NanoTime() : 0;
-    task_queue_condition_.Wait(self);
-    if (kMeasureWaitTime) {
-      const uint64_t wait_end = NanoTime();
-      total_wait_time_ += wait_end - std::max(wait_start, start_time_);
+    while (!IsShuttingDown() && !CanRunQueuedTask()) {
+      if (waiting_count_.Load() == GetThreadCount() && num_queued_tasks_.Load() <= 0) {
+        // We may be done, lets broadcast to the completion condition.
+        completion_condition_.Broadcast(self);
+      }
+      const uint64_t wait_start = kMeasureWaitTime ? NanoTime() : 0;
+      task_queue_condition_.Wait(self);
+      if (kMeasureWaitTime) {
+        const uint64_t wait_end = NanoTime();
+        total_wait_time_ += wait_end - std::max(wait_start, start_time_);
+      }
     }
     --waiting_count_;
+    if (IsShuttingDown()) {
+      // We are shutting down, return NULL to tell the worker thread to stop looping.
+      return NULL;
+    }
   }
-
-  // We are shutting down, return NULL to tell the worker thread to stop looping.
-  return NULL;
 }
 
-Task* ThreadPool::TryGetTask(Thread* self) {
-  MutexLock mu(self, task_queue_lock_);
-  return TryGetTaskLocked(self);
+bool ThreadPool::CanRunQueuedTask() const {
+  // Ensure that we don't use more threads than the maximum active workers, self is counted as
+  // waiting.
+  const size_t active_threads = GetThreadCount() - waiting_count_.Load();
+  return started_ && num_queued_tasks_.Load() > 0 && active_threads < max_active_workers_;
 }
 
-Task* ThreadPool::TryGetTaskLocked(Thread* self) {
-  if (started_ && !tasks_.empty()) {
-    Task* task = tasks_.front();
-    tasks_.pop_front();
-    return task;
+Task* ThreadPool::TryGetTask(Thread* self, size_t queue_index) {
+  if (!started_) {
+    return NULL;
+  }
+  const size_t num_queues = queues_.size();
+  const size_t first_victim = (queue_index == kAnyWorker) ? 0 : queue_index + 1;
+  for (size_t priority = kTaskPriorityHigh; priority <= kTaskPriorityNormal; ++priority) {
+    if (queue_index != kAnyWorker) {
+      TaskQueue* queue = queues_[queue_index].get();
+      if (queue->size != 0) {
+        MutexLock mu(self, queue->lock);
+        std::deque<Task*>& tasks = queue->tasks[priority];
+        if (!tasks.empty()) {
+          Task* task = tasks.back();
+          tasks.pop_back();
+          queue->size = queue->size - 1;
+          --num_queued_tasks_;
+          return task;
+        }
+      }
+    }
+    for (size_t i = 0; i < num_queues; ++i) {
+      const size_t victim_index = (first_victim + i) % num_queues;
+      TaskQueue* victim = queues_[victim_index].get();
+      if (victim_index == queue_index || victim->size == 0) {
+        continue;
+      }
+      MutexLock mu(self, victim->lock);
+      std::deque<Task*>& tasks = victim->tasks[priority];
+      if (!tasks.empty()) {
+        Task* task = tasks.front();
+        tasks.pop_front();
+        victim->size = victim->size - 1;
+        --num_queued_tasks_;
+        return task;
+      }
+    }
   }
   return NULL;
 }
@@ -178,14 +325,15 @@ Task* ThreadPool::TryGetTaskLocked(Thread* self) {
 void ThreadPool::Wait(Thread* self, bool do_work, bool may_hold_locks) {
   if (do_work) {
     Task* task = NULL;
-    while ((task = TryGetTask(self)) != NULL) {
+    while ((task = TryGetTask(self, kAnyWorker)) != NULL) {
       task->Run(self);
       task->Finalize();
     }
   }
   // Wait until each thread is waiting and the task list is empty.
   MutexLock mu(self, task_queue_lock_);
-  while (!shutting_down_ && (waiting_count_ != GetThreadCount() || !tasks_.empty())) {
+  while (!shutting_down_ &&
+         (waiting_count_.Load() != GetThreadCount() || num_queued_tasks_.Load() > 0)) {
     if (!may_hold_locks) {
       completion_condition_.Wait(self);
     } else {
@@ -195,8 +343,7 @@ void ThreadPool::Wait(Thread* self, bool do_work, bool may_hold_locks) {
 }
 
 size_t ThreadPool::GetTaskCount(Thread* self) {
-  MutexLock mu(self, task_queue_lock_);
-  return tasks_.size();
+  return static_cast<size_t>(std::max(num_queued_tasks_.Load(), 0));
 }
 
 WorkStealingWorker::WorkStealingWorker(ThreadPool* thread_pool, const std::string& name,
@@ -207,8 +354,15 @@ void WorkStealingWorker::Run() {
   Thread* self = Thread::Current();
   Task* task = NULL;
   WorkStealingThreadPool* thread_pool = down_cast<WorkStealingThreadPool*>(thread_pool_);
-  while ((task = thread_pool_->GetTask(self)) != NULL) {
-    WorkStealingTask* stealing_task = down_cast<WorkStealingTask*>(task);
+  thread_pool_->creation_barier_.Wait(self);
+  while ((task = thread_pool_->GetTask(self, queue_index_)) != NULL) {
+    WorkStealingTask* stealing_task = task->AsWorkStealingTask();
+    if (stealing_task == NULL) {
+      // Plain tasks are run like in a regular thread pool.
+      task->Run(self);
+      task->Finalize();
+      continue;
+    }
 
     {
       CHECK(task_ == NULL);
@@ -278,10 +432,19 @@ WorkStealingThreadPool::WorkStealingThreadPool(const char* name, size_t num_thre
     : ThreadPool(name, 0),
       work_steal_lock_("work stealing lock"),
       steal_index_(0) {
+  Thread* self = Thread::Current();
+  // The base class didn't create any workers, wait for ours to attach instead.
+  creation_barier_.Init(self, num_threads + 1);
+  CreateQueues(num_threads);
+  {
+    MutexLock mu(self, task_queue_lock_);
+    max_active_workers_ = num_threads;
+  }
   while (GetThreadCount() < num_threads) {
-    const std::string name = StringPrintf("Work stealing worker %zu", GetThreadCount());
+    const std::string name = StringPrintf("%s worker thread %zu", name_.c_str(), GetThreadCount());
     threads_.push_back(new WorkStealingWorker(this, name, ThreadPoolWorker::kDefaultStackSize));
   }
+  creation_barier_.Wait(self);
 }
 
 WorkStealingTask* WorkStealingThreadPool::FindTaskToStealFrom(Thread* self) {
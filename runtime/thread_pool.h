@@ -18,8 +18,10 @@
 #define ART_RUNTIME_THREAD_POOL_H_
 
 #include <deque>
+#include <memory>
 #include <vector>
 
+#include "atomic.h"
 #include "barrier.h"
 #include "base/mutex.h"
 #include "closure.h"
@@ -28,11 +30,23 @@
 namespace art {
 
 class ThreadPool;
+class WorkStealingTask;
+
+// Queued tasks of a higher priority are taken before any other, by their worker or a thief.
+enum TaskPriority {
+  kTaskPriorityHigh = 0,
+  kTaskPriorityNormal,
+};
 
 class Task : public Closure {
  public:
   // Called when references reaches 0.
   virtual void Finalize() { }
+
+  // Returns non-null if idle workers of a WorkStealingThreadPool may steal work from this task.
+  virtual WorkStealingTask* AsWorkStealingTask() {
+    return nullptr;
+  }
 };
 
 class ThreadPoolWorker {
@@ -53,6 +67,10 @@ class ThreadPoolWorker {
 
   ThreadPool* const thread_pool_;
   const std::string name_;
+  // Index of the task queue of the worker in the thread pool.
+  const size_t queue_index_;
+  // Set once the worker attached, before the creation barrier is passed.
+  Thread* thread_;
   std::unique_ptr<MemMap> stack_;
   pthread_t pthread_;
 
@@ -75,8 +93,11 @@ class ThreadPool {
   void StopWorkers(Thread* self);
 
   // Add a new task, the first available started worker will process it. Does not delete the task
-  // after running it, it is the caller's responsibility.
-  void AddTask(Thread* self, Task* task);
+  // after running it, it is the caller's responsibility. The task is queued for the worker
+  // `worker_hint` modulo the thread count if given, else for the calling worker, or round-robin
+  // when called from outside the pool; idle workers steal it if its worker is busy.
+  void AddTask(Thread* self, Task* task, TaskPriority priority = kTaskPriorityNormal,
+               size_t worker_hint = kAnyWorker);
 
   explicit ThreadPool(const char* name, size_t num_threads);
   virtual ~ThreadPool();
@@ -84,6 +105,7 @@ class ThreadPool {
   // Wait for all tasks currently on queue to get completed.
   void Wait(Thread* self, bool do_work, bool may_hold_locks);
 
+  // Returns the number of queued tasks, not counting those being run.
   size_t GetTaskCount(Thread* self);
 
   // Returns the total amount of workers waited for tasks.
@@ -95,13 +117,37 @@ class ThreadPool {
   // thread count of the thread pool.
   void SetMaxActiveWorkers(size_t threads);
 
+  // Pins each worker to one of the CPUs the process may run on, filling a NUMA node before using
+  // the next one, so that a pool smaller than a node keeps its work and memory on that node.
+  // Does nothing where affinity isn't supported.
+  void PinWorkers();
+
+  static constexpr size_t kAnyWorker = static_cast<size_t>(-1);
+
  protected:
-  // get a task to run, blocks if there are no tasks left
-  virtual Task* GetTask(Thread* self);
+  // The tasks queued for one worker. The worker takes its newest task first, thieves the oldest.
+  struct TaskQueue {
+    TaskQueue() : lock("thread pool task queue lock"), size(0) {}
 
-  // Try to get a task, returning NULL if there is none available.
-  Task* TryGetTask(Thread* self);
-  Task* TryGetTaskLocked(Thread* self) EXCLUSIVE_LOCKS_REQUIRED(task_queue_lock_);
+    Mutex lock;
+    std::deque<Task*> tasks[kTaskPriorityNormal + 1] GUARDED_BY(lock);
+    // Changed with the lock held, read without it to skip empty queues.
+    volatile size_t size;
+  };
+
+  // Get a task to run for the worker of the queue `queue_index`, blocks if there are no tasks
+  // left.
+  virtual Task* GetTask(Thread* self, size_t queue_index);
+
+  // Try to get a task, from the queue `queue_index` first unless it is kAnyWorker, then by
+  // stealing from the others. Returns NULL if there is none available.
+  Task* TryGetTask(Thread* self, size_t queue_index);
+
+  // Whether a waiting worker may take a queued task.
+  bool CanRunQueuedTask() const EXCLUSIVE_LOCKS_REQUIRED(task_queue_lock_);
+
+  // Adds queues until there is one per worker about to be created.
+  void CreateQueues(size_t num_threads);
 
   // Are we shutting down?
   bool IsShuttingDown() const EXCLUSIVE_LOCKS_REQUIRED(task_queue_lock_) {
@@ -109,14 +155,23 @@ class ThreadPool {
   }
 
   const std::string name_;
+  // Only guards the sleeping and waking of the workers, the tasks are in the queues.
   Mutex task_queue_lock_;
   ConditionVariable task_queue_condition_ GUARDED_BY(task_queue_lock_);
   ConditionVariable completion_condition_ GUARDED_BY(task_queue_lock_);
-  volatile bool started_ GUARDED_BY(task_queue_lock_);
+  // Changed with the lock held, read without it by TryGetTask.
+  volatile bool started_;
   volatile bool shutting_down_ GUARDED_BY(task_queue_lock_);
-  // How many worker threads are waiting on the condition.
-  volatile size_t waiting_count_ GUARDED_BY(task_queue_lock_);
-  std::deque<Task*> tasks_ GUARDED_BY(task_queue_lock_);
+  // How many worker threads are waiting on the condition. Only changed with the lock held, but
+  // read without it by AddTask to decide whether to signal.
+  Atomic<size_t> waiting_count_;
+  // Tasks in all the queues. Incremented after the push and decremented after the pop, so it may
+  // be transiently negative.
+  AtomicInteger num_queued_tasks_;
+  // One per worker, or a single one for a pool without workers.
+  std::vector<std::unique_ptr<TaskQueue>> queues_;
+  // Queue of the next task added from outside the pool.
+  AtomicInteger next_queue_;
   // TODO: make this immutable/const?
   std::vector<ThreadPoolWorker*> threads_;
   // Work balance detection.
@@ -141,6 +196,10 @@ class WorkStealingTask : public Task {
 
   virtual void StealFrom(Thread* self, WorkStealingTask* source) = 0;
 
+  WorkStealingTask* AsWorkStealingTask() OVERRIDE {
+    return this;
+  }
+
  private:
   // How many people are referencing this task.
   size_t ref_count_;
@@ -17,6 +17,7 @@
 #include "thread_pool.h"
 
 #include <string>
+#include <vector>
 
 #include "atomic.h"
 #include "common_runtime_test.h"
@@ -72,6 +73,22 @@ TEST_F(ThreadPoolTest, CheckRun) {
   EXPECT_EQ(num_tasks, count);
 }
 
+// Check that a work stealing thread pool also runs tasks which don't support stealing.
+TEST_F(ThreadPoolTest, WorkStealingRunsPlainTasks) {
+  Thread* self = Thread::Current();
+  WorkStealingThreadPool thread_pool("Thread pool test thread pool", num_threads);
+  AtomicInteger count(0);
+  static const int32_t num_tasks = num_threads * 4;
+  for (int32_t i = 0; i < num_tasks; ++i) {
+    thread_pool.AddTask(self, new CountTask(&count));
+  }
+  thread_pool.StartWorkers(self);
+  // Wait for tasks to complete.
+  thread_pool.Wait(self, true, false);
+  // Make sure that we finished all the work.
+  EXPECT_EQ(num_tasks, count);
+}
+
 TEST_F(ThreadPoolTest, StopStart) {
   Thread* self = Thread::Current();
   ThreadPool thread_pool("Thread pool test thread pool", num_threads);
@@ -100,6 +117,59 @@ TEST_F(ThreadPoolTest, StopStart) {
   thread_pool.StopWorkers(self);
 }
 
+class RecordTask : public Task {
+ public:
+  RecordTask(std::vector<int>* order, int id) : order_(order), id_(id) {}
+
+  void Run(Thread* self) {
+    order_->push_back(id_);
+  }
+
+  void Finalize() {
+    delete this;
+  }
+
+ private:
+  std::vector<int>* const order_;
+  const int id_;
+};
+
+// Check that high priority tasks are run before the normal ones queued earlier.
+TEST_F(ThreadPoolTest, Priorities) {
+  Thread* self = Thread::Current();
+  // A single worker, which runs all the tasks as the waiting thread doesn't work.
+  ThreadPool thread_pool("Thread pool test thread pool", 1);
+  std::vector<int> order;
+  static const int num_tasks = 8;
+  for (int i = 0; i < num_tasks; ++i) {
+    thread_pool.AddTask(self, new RecordTask(&order, 0));
+  }
+  for (int i = 0; i < num_tasks; ++i) {
+    thread_pool.AddTask(self, new RecordTask(&order, 1), kTaskPriorityHigh);
+  }
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, false, false);
+  ASSERT_EQ(static_cast<size_t>(2 * num_tasks), order.size());
+  for (int i = 0; i < 2 * num_tasks; ++i) {
+    EXPECT_EQ(i < num_tasks ? 1 : 0, order[i]);
+  }
+}
+
+// Check that the tasks queued for one worker are stolen by the others.
+TEST_F(ThreadPoolTest, WorkerHint) {
+  Thread* self = Thread::Current();
+  ThreadPool thread_pool("Thread pool test thread pool", num_threads);
+  AtomicInteger count(0);
+  static const int32_t num_tasks = num_threads * 4;
+  for (int32_t i = 0; i < num_tasks; ++i) {
+    thread_pool.AddTask(self, new CountTask(&count), kTaskPriorityNormal, 0);
+  }
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, false, false);
+  EXPECT_EQ(num_tasks, count);
+  EXPECT_EQ(0u, thread_pool.GetTaskCount(self));
+}
+
 class TreeTask : public Task {
  public:
   TreeTask(ThreadPool* const thread_pool, AtomicInteger* count, int depth)
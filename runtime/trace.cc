@@ -75,6 +75,24 @@ namespace art {
 // 32 bits of microseconds is 70 minutes.
 //
 // All values are stored in little-endian order.
+//
+// A streaming trace has no text header, its version has the 0xF0 bits set and the records are
+// interleaved with definitions, which have a thread ID of 0:
+//     u2  0
+//     u1  kOpNewMethod
+//     u2  length of the method line
+//     ... method line, as in the methods section of the text header
+// or
+//     u2  0
+//     u1  kOpNewThread
+//     u2  thread ID
+//     u2  length of the thread name
+//     ... thread name
+// and end with the text header without the method list:
+//     u2  0
+//     u1  kOpTraceSummary
+//     u4  length of the summary
+//     ... summary
 
 enum TraceAction {
     kTraceMethodEnter = 0x00,       // method entry
@@ -114,6 +132,12 @@ static const uint16_t kTraceVersionSingleClock    = 2;
 static const uint16_t kTraceVersionDualClock      = 3;
 static const uint16_t kTraceRecordSizeSingleClock = 10;  // using v2
 static const uint16_t kTraceRecordSizeDualClock   = 14;  // using v3 with two timestamps
+static const uint16_t kTraceVersionStreamingFlag  = 0xF0;
+static const uint8_t  kOpNewMethod                = 1;
+static const uint8_t  kOpNewThread                = 2;
+static const uint8_t  kOpTraceSummary             = 3;
+// Size of the per-thread buffers of a streaming trace.
+static const size_t   kStreamingBufferSize        = 16 * KB;
 
 ProfilerClockSource Trace::default_clock_source_ = kDefaultProfilerClockSource;
 
@@ -326,8 +350,12 @@ void* Trace::RunSamplingThread(void* arg) {
 }
 
 void Trace::Start(const char* trace_filename, int trace_fd, int buffer_size, int flags,
-                  bool direct_to_ddms, bool sampling_enabled, int interval_us) {
+                  bool direct_to_ddms, bool sampling_enabled, int interval_us, bool streaming) {
   Thread* self = Thread::Current();
+  if (streaming && direct_to_ddms) {
+    LOG(WARNING) << "Streaming traces can't be sent to DDMS, buffering the trace instead";
+    streaming = false;
+  }
   {
     MutexLock mu(self, *Locks::trace_lock_);
     if (the_trace_ != NULL) {
@@ -362,7 +390,8 @@ void Trace::Start(const char* trace_filename, int trace_fd, int buffer_size, int
     if (the_trace_ != NULL) {
       LOG(ERROR) << "Trace already in progress, ignoring this request";
     } else {
-      the_trace_ = new Trace(trace_file.release(), buffer_size, flags, sampling_enabled);
+      the_trace_ = new Trace(trace_file.release(), buffer_size, flags, sampling_enabled,
+                             streaming);
 
       // Enable count of allocs if specified in the flags.
       if ((flags && kTraceCountAllocs) != 0) {
@@ -431,6 +460,13 @@ void Trace::Shutdown() {
   }
 }
 
+void Trace::FlushThreadOnExit(Thread* self) {
+  MutexLock mu(self, *Locks::trace_lock_);
+  if (the_trace_ != NULL && the_trace_->streaming_) {
+    the_trace_->FlushStreamingBuffer(self);
+  }
+}
+
 TracingMode Trace::GetMethodTracingMode() {
   MutexLock mu(Thread::Current(), *Locks::trace_lock_);
   if (the_trace_ == NULL) {
@@ -442,15 +478,19 @@ TracingMode Trace::GetMethodTracingMode() {
   }
 }
 
-Trace::Trace(File* trace_file, int buffer_size, int flags, bool sampling_enabled)
-    : trace_file_(trace_file), buf_(new uint8_t[buffer_size]()), flags_(flags),
+Trace::Trace(File* trace_file, int buffer_size, int flags, bool sampling_enabled, bool streaming)
+    : trace_file_(trace_file),
+      buf_(new uint8_t[streaming ? kTraceHeaderLength : buffer_size]()), flags_(flags),
       sampling_enabled_(sampling_enabled), clock_source_(default_clock_source_),
-      buffer_size_(buffer_size), start_time_(MicroTime()), cur_offset_(0),  overflow_(false) {
+      buffer_size_(streaming ? kTraceHeaderLength : buffer_size), start_time_(MicroTime()),
+      cur_offset_(0),  overflow_(false), streaming_(streaming),
+      streaming_lock_("trace streaming lock"), num_streamed_records_(0),
+      streaming_write_failed_(false) {
   // Set up the beginning of the trace.
   uint16_t trace_version = GetTraceVersion(clock_source_);
   memset(buf_.get(), 0, kTraceHeaderLength);
   Append4LE(buf_.get(), kTraceMagicValue);
-  Append2LE(buf_.get() + 4, trace_version);
+  Append2LE(buf_.get() + 4, trace_version | (streaming ? kTraceVersionStreamingFlag : 0));
   Append2LE(buf_.get() + 6, kTraceHeaderLength);
   Append8LE(buf_.get() + 8, start_time_);
   if (trace_version >= kTraceVersionDualClock) {
@@ -460,6 +500,11 @@ Trace::Trace(File* trace_file, int buffer_size, int flags, bool sampling_enabled
 
   // Update current offset.
   cur_offset_ = kTraceHeaderLength;
+
+  if (streaming_) {
+    MutexLock mu(Thread::Current(), streaming_lock_);
+    WriteStreaming(buf_.get(), kTraceHeaderLength);
+  }
 }
 
 static void DumpBuf(uint8_t* buf, size_t buf_size, ProfilerClockSource clock_source)
@@ -477,6 +522,12 @@ static void DumpBuf(uint8_t* buf, size_t buf_size, ProfilerClockSource clock_sou
 }
 
 void Trace::FinishTracing() {
+  Thread* self = Thread::Current();
+  if (streaming_) {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    Runtime::Current()->GetThreadList()->ForEach(FlushAndFreeStreamingBuffer, this);
+  }
+
   // Compute elapsed time.
   uint64_t elapsed = MicroTime() - start_time_;
 
@@ -506,6 +557,10 @@ void Trace::FinishTracing() {
   }
   os << StringPrintf("elapsed-time-usec=%" PRIu64 "\n", elapsed);
   size_t num_records = (final_offset - kTraceHeaderLength) / GetRecordSize(clock_source_);
+  if (streaming_) {
+    MutexLock mu(self, streaming_lock_);
+    num_records = num_streamed_records_;
+  }
   os << StringPrintf("num-method-calls=%zd\n", num_records);
   os << StringPrintf("clock-call-overhead-nsec=%d\n", clock_overhead_ns);
   os << StringPrintf("vm=art\n");
@@ -521,7 +576,15 @@ void Trace::FinishTracing() {
   os << StringPrintf("%cend\n", kTraceTokenChar);
 
   std::string header(os.str());
-  if (trace_file_.get() == NULL) {
+  if (streaming_) {
+    uint8_t op[7];
+    Append2LE(op, 0);
+    op[2] = kOpTraceSummary;
+    Append4LE(op + 3, header.length());
+    MutexLock mu(self, streaming_lock_);
+    WriteStreaming(op, sizeof(op));
+    WriteStreaming(header.c_str(), header.length());
+  } else if (trace_file_.get() == NULL) {
     iovec iov[2];
     iov[0].iov_base = reinterpret_cast<void*>(const_cast<char*>(header.c_str()));
     iov[0].iov_len = header.length();
@@ -619,17 +682,34 @@ void Trace::ReadClocks(Thread* thread, uint32_t* thread_clock_diff, uint32_t* wa
 void Trace::LogMethodTraceEvent(Thread* thread, mirror::ArtMethod* method,
                                 instrumentation::Instrumentation::InstrumentationEvent event,
                                 uint32_t thread_clock_diff, uint32_t wall_clock_diff) {
-  // Advance cur_offset_ atomically.
-  int32_t new_offset;
-  int32_t old_offset;
-  do {
-    old_offset = cur_offset_;
-    new_offset = old_offset + GetRecordSize(clock_source_);
-    if (new_offset > buffer_size_) {
-      overflow_ = true;
-      return;
+  uint8_t* ptr;
+  if (streaming_) {
+    // Only this thread, or the sampling thread while it is suspended, records its events.
+    const size_t record_size = GetRecordSize(clock_source_);
+    uint8_t* buffer = thread->GetTraceBuffer();
+    if (buffer == NULL) {
+      buffer = new uint8_t[kStreamingBufferSize];
+      thread->SetTraceBuffer(buffer);
+      thread->SetTraceBufferPos(0);
+    } else if (thread->GetTraceBufferPos() + record_size > kStreamingBufferSize) {
+      FlushStreamingBuffer(thread);
     }
-  } while (android_atomic_release_cas(old_offset, new_offset, &cur_offset_) != 0);
+    ptr = buffer + thread->GetTraceBufferPos();
+    thread->SetTraceBufferPos(thread->GetTraceBufferPos() + record_size);
+  } else {
+    // Advance cur_offset_ atomically.
+    int32_t new_offset;
+    int32_t old_offset;
+    do {
+      old_offset = cur_offset_;
+      new_offset = old_offset + GetRecordSize(clock_source_);
+      if (new_offset > buffer_size_) {
+        overflow_ = true;
+        return;
+      }
+    } while (android_atomic_release_cas(old_offset, new_offset, &cur_offset_) != 0);
+    ptr = buf_.get() + old_offset;
+  }
 
   TraceAction action = kTraceMethodEnter;
   switch (event) {
@@ -649,7 +729,6 @@ void Trace::LogMethodTraceEvent(Thread* thread, mirror::ArtMethod* method,
   uint32_t method_value = EncodeTraceMethodAndAction(method, action);
 
   // Write data
-  uint8_t* ptr = buf_.get() + old_offset;
   Append2LE(ptr, thread->GetTid());
   Append4LE(ptr + 2, method_value);
   ptr += 6;
@@ -663,6 +742,60 @@ void Trace::LogMethodTraceEvent(Thread* thread, mirror::ArtMethod* method,
   }
 }
 
+void Trace::FlushStreamingBuffer(Thread* thread) {
+  uint8_t* buffer = thread->GetTraceBuffer();
+  const size_t size = thread->GetTraceBufferPos();
+  const size_t record_size = GetRecordSize(clock_source_);
+  std::string definitions;
+  MutexLock mu(Thread::Current(), streaming_lock_);
+  if (streamed_threads_.insert(thread->GetTid()).second) {
+    std::string name;
+    thread->GetThreadName(name);
+    uint8_t op[7];
+    Append2LE(op, 0);
+    op[2] = kOpNewThread;
+    Append2LE(op + 3, thread->GetTid());
+    Append2LE(op + 5, name.length());
+    definitions.append(reinterpret_cast<char*>(op), sizeof(op));
+    definitions.append(name);
+  }
+  for (size_t offset = 0; offset < size; offset += record_size) {
+    const uint8_t* ptr = buffer + offset;
+    uint32_t tmid = ptr[2] | (ptr[3] << 8) | (ptr[4] << 16) | (ptr[5] << 24);
+    mirror::ArtMethod* method = DecodeTraceMethodId(tmid);
+    if (streamed_methods_.insert(method).second) {
+      std::ostringstream os;
+      DumpMethodList(os, std::set<mirror::ArtMethod*>(&method, &method + 1));
+      std::string line(os.str());
+      uint8_t op[5];
+      Append2LE(op, 0);
+      op[2] = kOpNewMethod;
+      Append2LE(op + 3, line.length());
+      definitions.append(reinterpret_cast<char*>(op), sizeof(op));
+      definitions.append(line);
+    }
+  }
+  WriteStreaming(definitions.data(), definitions.length());
+  WriteStreaming(buffer, size);
+  num_streamed_records_ += size / record_size;
+  thread->SetTraceBufferPos(0);
+}
+
+void Trace::FlushAndFreeStreamingBuffer(Thread* thread, void* arg) {
+  if (thread->GetTraceBuffer() != NULL) {
+    reinterpret_cast<Trace*>(arg)->FlushStreamingBuffer(thread);
+    delete[] thread->GetTraceBuffer();
+    thread->SetTraceBuffer(NULL);
+  }
+}
+
+void Trace::WriteStreaming(const void* data, size_t size) {
+  if (!streaming_write_failed_ && !trace_file_->WriteFully(data, size)) {
+    PLOG(ERROR) << "Trace data write failed, dropping the rest of the trace";
+    streaming_write_failed_ = true;
+  }
+}
+
 void Trace::GetVisitedMethods(size_t buf_size,
                               std::set<mirror::ArtMethod*>* visited_methods) {
   uint8_t* ptr = buf_.get() + kTraceHeaderLength;
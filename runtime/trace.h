@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "base/macros.h"
+#include "base/mutex.h"
 #include "globals.h"
 #include "instrumentation.h"
 #include "os.h"
@@ -63,8 +64,10 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
 
   static void SetDefaultClockSource(ProfilerClockSource clock_source);
 
+  // With `streaming`, the events are written to the trace file as they come instead of being
+  // kept in a buffer of `buffer_size` bytes until the trace stops.
   static void Start(const char* trace_filename, int trace_fd, int buffer_size, int flags,
-                    bool direct_to_ddms, bool sampling_enabled, int interval_us)
+                    bool direct_to_ddms, bool sampling_enabled, int interval_us, bool streaming)
   LOCKS_EXCLUDED(Locks::mutator_lock_,
                  Locks::thread_list_lock_,
                  Locks::thread_suspend_count_lock_,
@@ -73,6 +76,11 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
   static void Shutdown() LOCKS_EXCLUDED(Locks::trace_lock_);
   static TracingMode GetMethodTracingMode() LOCKS_EXCLUDED(Locks::trace_lock_);
 
+  // Writes out the events a streaming trace buffered for the exiting thread `self`.
+  static void FlushThreadOnExit(Thread* self)
+      LOCKS_EXCLUDED(Locks::trace_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   bool UseWallClock();
   bool UseThreadCpuClock();
 
@@ -111,7 +119,7 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
   static void FreeStackTrace(std::vector<mirror::ArtMethod*>* stack_trace);
 
  private:
-  explicit Trace(File* trace_file, int buffer_size, int flags, bool sampling_enabled);
+  Trace(File* trace_file, int buffer_size, int flags, bool sampling_enabled, bool streaming);
 
   // The sampling interval in microseconds is passed as an argument.
   static void* RunSamplingThread(void* arg) LOCKS_EXCLUDED(Locks::trace_lock_);
@@ -124,6 +132,16 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
                            instrumentation::Instrumentation::InstrumentationEvent event,
                            uint32_t thread_clock_diff, uint32_t wall_clock_diff);
 
+  // Writes the buffered events of `thread` to the trace file, preceded by the definitions of the
+  // thread and of the methods not written out before. The events of a thread are only recorded
+  // by itself or, when sampling, by the sampling thread with all the threads suspended.
+  void FlushStreamingBuffer(Thread* thread)
+      LOCKS_EXCLUDED(streaming_lock_)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  static void FlushAndFreeStreamingBuffer(Thread* thread, void* arg)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void WriteStreaming(const void* data, size_t size) EXCLUSIVE_LOCKS_REQUIRED(streaming_lock_);
+
   // Methods to output traced methods and threads.
   void GetVisitedMethods(size_t end_offset, std::set<mirror::ArtMethod*>* visited_methods);
   void DumpMethodList(std::ostream& os, const std::set<mirror::ArtMethod*>& visited_methods)
@@ -168,6 +186,21 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
   // Did we overflow the buffer recording traces?
   bool overflow_;
 
+  // True if the events are written to trace_file_ as they come rather than kept in buf_.
+  const bool streaming_;
+
+  // Guards the writes of a streaming trace.
+  Mutex streaming_lock_;
+
+  // The threads and methods defined in the streaming trace so far.
+  std::set<pid_t> streamed_threads_ GUARDED_BY(streaming_lock_);
+  std::set<mirror::ArtMethod*> streamed_methods_ GUARDED_BY(streaming_lock_);
+
+  size_t num_streamed_records_ GUARDED_BY(streaming_lock_);
+
+  // Set after the first failed write of the streaming trace, which drops the rest.
+  bool streaming_write_failed_ GUARDED_BY(streaming_lock_);
+
   DISALLOW_COPY_AND_ASSIGN(Trace);
 };
 
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "type_lookup_table.h"
+
+#include <string.h>
+
+#include <vector>
+
+#include "dex_file-inl.h"
+#include "leb128.h"
+#include "utf.h"
+#include "utils.h"
+
+namespace art {
+
+static uint32_t NumEntries(uint32_t num_class_defs) {
+  return RoundUpToPowerOfTwo(num_class_defs);
+}
+
+TypeLookupTable::~TypeLookupTable() {
+}
+
+bool TypeLookupTable::SupportedSize(uint32_t num_class_defs) {
+  // The chains are linked with 16-bit distances.
+  return num_class_defs != 0u && num_class_defs <= 0x10000u;
+}
+
+uint32_t TypeLookupTable::RawDataLength(uint32_t num_class_defs) {
+  return SupportedSize(num_class_defs) ? NumEntries(num_class_defs) * sizeof(Entry) : 0u;
+}
+
+TypeLookupTable* TypeLookupTable::Create(const DexFile& dex_file) {
+  const uint32_t num_class_defs = dex_file.NumClassDefs();
+  CHECK(SupportedSize(num_class_defs)) << dex_file.GetLocation();
+  const uint32_t num_entries = NumEntries(num_class_defs);
+  const uint32_t mask = num_entries - 1;
+  Entry* entries = new Entry[num_entries];
+  memset(entries, 0, num_entries * sizeof(Entry));
+
+  // First the entries at their hash, so that no chain starts in an entry of another chain.
+  std::vector<Entry> collisions;
+  for (uint32_t i = 0; i < num_class_defs; ++i) {
+    const DexFile::TypeId& type_id = dex_file.GetTypeId(dex_file.GetClassDef(i).class_idx_);
+    const DexFile::StringId& string_id = dex_file.GetStringId(type_id.descriptor_idx_);
+    Entry entry;
+    entry.str_offset = string_id.string_data_off_;
+    entry.hash = ComputeModifiedUtf8Hash(dex_file.GetStringData(string_id));
+    entry.class_def_idx = static_cast<uint16_t>(i);
+    entry.next_pos_delta = 0u;
+    Entry& home = entries[entry.hash & mask];
+    if (home.str_offset == 0u) {
+      home = entry;
+    } else {
+      collisions.push_back(entry);
+    }
+  }
+  // Then the others, in free entries after the end of their chain.
+  for (const Entry& entry : collisions) {
+    uint32_t tail_pos = entry.hash & mask;
+    while (entries[tail_pos].next_pos_delta != 0u) {
+      tail_pos = (tail_pos + entries[tail_pos].next_pos_delta) & mask;
+    }
+    uint32_t pos = (tail_pos + 1) & mask;
+    while (entries[pos].str_offset != 0u) {
+      pos = (pos + 1) & mask;
+    }
+    entries[pos] = entry;
+    entries[tail_pos].next_pos_delta = static_cast<uint16_t>((pos - tail_pos) & mask);
+  }
+  return new TypeLookupTable(dex_file, entries, entries);
+}
+
+TypeLookupTable* TypeLookupTable::Open(const DexFile& dex_file, const uint8_t* raw_data) {
+  CHECK(SupportedSize(dex_file.NumClassDefs())) << dex_file.GetLocation();
+  DCHECK_ALIGNED(raw_data, alignof(Entry));
+  return new TypeLookupTable(dex_file, reinterpret_cast<const Entry*>(raw_data), nullptr);
+}
+
+TypeLookupTable::TypeLookupTable(const DexFile& dex_file, const Entry* entries,
+                                 Entry* owned_entries)
+    : dex_file_begin_(dex_file.Begin()),
+      mask_(NumEntries(dex_file.NumClassDefs()) - 1),
+      entries_(entries),
+      owned_entries_(owned_entries) {
+}
+
+bool TypeLookupTable::IsDescriptorAt(const Entry& entry, const char* descriptor) const {
+  const uint8_t* ptr = dex_file_begin_ + entry.str_offset;
+  // Skip the UTF-16 length.
+  DecodeUnsignedLeb128(&ptr);
+  return strcmp(descriptor, reinterpret_cast<const char*>(ptr)) == 0;
+}
+
+uint32_t TypeLookupTable::Lookup(const char* descriptor, uint32_t hash) const {
+  uint32_t pos = hash & mask_;
+  const Entry* entry = &entries_[pos];
+  if (entry->str_offset == 0u) {
+    return DexFile::kDexNoIndex;
+  }
+  while (true) {
+    if (entry->hash == hash && IsDescriptorAt(*entry, descriptor)) {
+      return entry->class_def_idx;
+    }
+    if (entry->next_pos_delta == 0u) {
+      return DexFile::kDexNoIndex;
+    }
+    pos = (pos + entry->next_pos_delta) & mask_;
+    entry = &entries_[pos];
+  }
+}
+
+}  // namespace art
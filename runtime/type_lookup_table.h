@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_TYPE_LOOKUP_TABLE_H_
+#define ART_RUNTIME_TYPE_LOOKUP_TABLE_H_
+
+#include <stdint.h>
+
+#include <memory>
+
+#include "base/macros.h"
+
+namespace art {
+
+class DexFile;
+
+// Hash table from the descriptors of the classes a dex file defines to their class def indexes,
+// built by dex2oat and stored in the oat file after the dex files, so that DexFile::FindClassDef
+// doesn't have to search the string ids, the type ids and then scan the class defs. The table
+// has as many entries as the class defs rounded up to a power of two. Each class is chained from
+// the entry at its hash: the first class of each hash is in that entry, the others in entries
+// no hash maps to.
+class TypeLookupTable {
+ public:
+  ~TypeLookupTable();
+
+  // Whether a dex file with `num_class_defs` class defs can have a table.
+  static bool SupportedSize(uint32_t num_class_defs);
+
+  // The size of the table of a dex file with `num_class_defs` class defs.
+  static uint32_t RawDataLength(uint32_t num_class_defs);
+
+  // Builds the table of `dex_file`, which must have a supported number of class defs.
+  static TypeLookupTable* Create(const DexFile& dex_file);
+
+  // Opens the table previously built for `dex_file` at `raw_data`, which must outlive it.
+  static TypeLookupTable* Open(const DexFile& dex_file, const uint8_t* raw_data);
+
+  // Returns the class def index of the class with `descriptor`, whose ComputeModifiedUtf8Hash is
+  // `hash`, or DexFile::kDexNoIndex.
+  uint32_t Lookup(const char* descriptor, uint32_t hash) const;
+
+  const uint8_t* RawData() const {
+    return reinterpret_cast<const uint8_t*>(entries_);
+  }
+
+  uint32_t RawDataLength() const {
+    return (mask_ + 1) * sizeof(Entry);
+  }
+
+ private:
+  struct Entry {
+    // Offset of the string data of the descriptor in the dex file, 0 for an empty entry.
+    uint32_t str_offset;
+    uint32_t hash;
+    uint16_t class_def_idx;
+    // Distance, modulo the table size, to the next entry of the chain; 0 ends the chain.
+    uint16_t next_pos_delta;
+  };
+
+  TypeLookupTable(const DexFile& dex_file, const Entry* entries, Entry* owned_entries);
+
+  bool IsDescriptorAt(const Entry& entry, const char* descriptor) const;
+
+  const uint8_t* const dex_file_begin_;
+  const uint32_t mask_;
+  const Entry* const entries_;
+  // Null if the entries are in an oat file.
+  std::unique_ptr<Entry[]> owned_entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(TypeLookupTable);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_TYPE_LOOKUP_TABLE_H_
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "type_lookup_table.h"
+
+#include <memory>
+
+#include "common_runtime_test.h"
+#include "dex_file-inl.h"
+#include "utf.h"
+
+namespace art {
+
+class TypeLookupTableTest : public CommonRuntimeTest {};
+
+TEST_F(TypeLookupTableTest, Nested) {
+  ScopedObjectAccess soa(Thread::Current());
+  const DexFile* dex_file(OpenTestDexFile("Nested"));
+  ASSERT_TRUE(dex_file != NULL);
+  std::unique_ptr<TypeLookupTable> table(TypeLookupTable::Create(*dex_file));
+  EXPECT_EQ(TypeLookupTable::RawDataLength(dex_file->NumClassDefs()), table->RawDataLength());
+  EXPECT_EQ(1U, table->Lookup("LNested;", ComputeModifiedUtf8Hash("LNested;")));
+  EXPECT_EQ(0U, table->Lookup("LNested$Inner;", ComputeModifiedUtf8Hash("LNested$Inner;")));
+  EXPECT_EQ(DexFile::kDexNoIndex,
+            table->Lookup("LNested$Other;", ComputeModifiedUtf8Hash("LNested$Other;")));
+  // The right hash is needed to find a class.
+  EXPECT_EQ(DexFile::kDexNoIndex,
+            table->Lookup("LNested;", ComputeModifiedUtf8Hash("LNested;") + 1));
+}
+
+TEST_F(TypeLookupTableTest, AllClassDefs) {
+  ScopedObjectAccess soa(Thread::Current());
+  // Enough classes for chains of colliding hashes.
+  const DexFile* dex_file = java_lang_dex_file_;
+  ASSERT_TRUE(TypeLookupTable::SupportedSize(dex_file->NumClassDefs()));
+  std::unique_ptr<TypeLookupTable> created(TypeLookupTable::Create(*dex_file));
+  // As the oat file maps it.
+  std::unique_ptr<TypeLookupTable> opened(TypeLookupTable::Open(*dex_file, created->RawData()));
+  for (size_t i = 0; i < dex_file->NumClassDefs(); ++i) {
+    const char* descriptor = dex_file->GetClassDescriptor(dex_file->GetClassDef(i));
+    uint32_t hash = ComputeModifiedUtf8Hash(descriptor);
+    EXPECT_EQ(i, created->Lookup(descriptor, hash)) << descriptor;
+    EXPECT_EQ(i, opened->Lookup(descriptor, hash)) << descriptor;
+    EXPECT_EQ(&dex_file->GetClassDef(i), dex_file->FindClassDef(descriptor, hash));
+  }
+  EXPECT_EQ(DexFile::kDexNoIndex,
+            opened->Lookup("Ljava/lang/NoSuchClass;",
+                           ComputeModifiedUtf8Hash("Ljava/lang/NoSuchClass;")));
+}
+
+}  // namespace art
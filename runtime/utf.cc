@@ -16,17 +16,64 @@
 
 #include "utf.h"
 
+#include <string.h>
+
 #include "base/logging.h"
 #include "mirror/array.h"
 #include "mirror/object-inl.h"
 #include "utf-inl.h"
+#include "utils.h"
 
 namespace art {
 
+// The ASCII fast paths below check 8 bytes or 4 UTF-16 chars at a time in a 64-bit word, which
+// the compiler keeps in registers on every ISA we support, without needing SIMD intrinsics.
+static constexpr uint64_t kByteOnes = UINT64_C(0x0101010101010101);
+static constexpr uint64_t kByteHighBits = UINT64_C(0x8080808080808080);
+static constexpr uint64_t kCharOnes = UINT64_C(0x0001000100010001);
+static constexpr uint64_t kCharNonAsciiBits = UINT64_C(0xff80ff80ff80ff80);
+
+// Are all the bytes of the word in [1, 0x7f], i.e. ASCII chars that don't end the string? A zero
+// byte has its high bit set once one is subtracted from it. Only a zero byte borrows from the
+// bytes above it, so the other bytes can't be mistaken for non-ASCII or zero ones.
+static inline bool IsNonZeroAscii8(uint64_t word) {
+  return ((word | (word - kByteOnes)) & kByteHighBits) == 0;
+}
+
+// The same for the UTF-16 chars of the word, which are encoded as a single modified UTF-8 byte.
+static inline bool IsNonZeroAscii16(uint64_t word) {
+  return ((word | (word - kCharOnes)) & kCharNonAsciiBits) == 0;
+}
+
+// Reads the aligned 8 bytes at `utf8`. Modified UTF-8 strings are only NUL-terminated so this may
+// read past the end of the string, but never into another page as the read is aligned.
+static inline uint64_t LoadAlignedUtf8Word(const char* utf8) {
+  DCHECK(IsAligned<sizeof(uint64_t)>(utf8));
+  uint64_t word;
+  memcpy(&word, utf8, sizeof(word));
+  return word;
+}
+
+static inline uint64_t LoadUtf16Word(const uint16_t* utf16) {
+  uint64_t word;
+  memcpy(&word, utf16, sizeof(word));
+  return word;
+}
+
 size_t CountModifiedUtf8Chars(const char* utf8) {
   size_t len = 0;
   int ic;
-  while ((ic = *utf8++) != '\0') {
+  while (true) {
+    if (IsAligned<sizeof(uint64_t)>(utf8)) {
+      const char* ascii_start = utf8;
+      while (IsNonZeroAscii8(LoadAlignedUtf8Word(utf8))) {
+        utf8 += sizeof(uint64_t);
+      }
+      len += utf8 - ascii_start;
+    }
+    if ((ic = *utf8++) == '\0') {
+      break;
+    }
     len++;
     if ((ic & 0x80) == 0) {
       // one-byte encoding
@@ -45,13 +92,36 @@ size_t CountModifiedUtf8Chars(const char* utf8) {
 }
 
 void ConvertModifiedUtf8ToUtf16(uint16_t* utf16_data_out, const char* utf8_data_in) {
-  while (*utf8_data_in != '\0') {
+  while (true) {
+    if (IsAligned<sizeof(uint64_t)>(utf8_data_in)) {
+      while (IsNonZeroAscii8(LoadAlignedUtf8Word(utf8_data_in))) {
+        for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+          utf16_data_out[i] = static_cast<uint8_t>(utf8_data_in[i]);
+        }
+        utf8_data_in += sizeof(uint64_t);
+        utf16_data_out += sizeof(uint64_t);
+      }
+    }
+    if (*utf8_data_in == '\0') {
+      break;
+    }
     *utf16_data_out++ = GetUtf16FromUtf8(&utf8_data_in);
   }
 }
 
+static constexpr size_t kCharsPerWord = sizeof(uint64_t) / sizeof(uint16_t);
+
 void ConvertUtf16ToModifiedUtf8(char* utf8_out, const uint16_t* utf16_in, size_t char_count) {
   while (char_count--) {
+    if (char_count + 1 >= kCharsPerWord && IsNonZeroAscii16(LoadUtf16Word(utf16_in))) {
+      for (size_t i = 0; i < kCharsPerWord; ++i) {
+        utf8_out[i] = utf16_in[i];
+      }
+      utf8_out += kCharsPerWord;
+      utf16_in += kCharsPerWord;
+      char_count -= kCharsPerWord - 1;
+      continue;
+    }
     uint16_t ch = *utf16_in++;
     if (ch > 0 && ch <= 0x7f) {
       *utf8_out++ = ch;
@@ -70,18 +140,32 @@ void ConvertUtf16ToModifiedUtf8(char* utf8_out, const uint16_t* utf16_in, size_t
 
 int32_t ComputeUtf16Hash(mirror::CharArray* chars, int32_t offset,
                          size_t char_count) {
-  int32_t hash = 0;
-  for (size_t i = 0; i < char_count; i++) {
-    hash = hash * 31 + chars->Get(offset + i);
-  }
-  return hash;
+  DCHECK_LE(offset + char_count, static_cast<size_t>(chars->GetLength()));
+  return ComputeUtf16Hash(chars->GetData() + offset, char_count);
 }
 
 int32_t ComputeUtf16Hash(const uint16_t* chars, size_t char_count) {
-  int32_t hash = 0;
+  // Four chars at a time, so that the multiplications don't all wait for the previous one:
+  // h * 31^4 + c0 * 31^3 + c1 * 31^2 + c2 * 31 + c3. Wraps around like the Java int arithmetic.
+  uint32_t hash = 0;
+  while (char_count >= 4) {
+    hash = hash * (31 * 31 * 31 * 31) + chars[0] * (31 * 31 * 31) + chars[1] * (31 * 31) +
+        chars[2] * 31 + chars[3];
+    chars += 4;
+    char_count -= 4;
+  }
   while (char_count--) {
     hash = hash * 31 + *chars++;
   }
+  return static_cast<int32_t>(hash);
+}
+
+uint32_t ComputeModifiedUtf8Hash(const char* chars) {
+  uint32_t hash = 0;
+  while (*chars != '\0') {
+    // Not sign extended, char is signed on some ISAs only.
+    hash = hash * 31 + static_cast<uint8_t>(*chars++);
+  }
   return hash;
 }
 
@@ -105,6 +189,12 @@ int CompareModifiedUtf8ToUtf16AsCodePointValues(const char* utf8_1, const uint16
 size_t CountUtf8Bytes(const uint16_t* chars, size_t char_count) {
   size_t result = 0;
   while (char_count--) {
+    if (char_count + 1 >= kCharsPerWord && IsNonZeroAscii16(LoadUtf16Word(chars))) {
+      result += kCharsPerWord;
+      chars += kCharsPerWord;
+      char_count -= kCharsPerWord - 1;
+      continue;
+    }
     uint16_t ch = *chars++;
     if (ch > 0 && ch <= 0x7f) {
       ++result;
@@ -78,6 +78,12 @@ int32_t ComputeUtf16Hash(mirror::CharArray* chars, int32_t offset, size_t char_c
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 int32_t ComputeUtf16Hash(const uint16_t* chars, size_t char_count);
 
+/*
+ * The same hash over the bytes of a modified UTF-8 string, which is stable across ISAs, for the
+ * hash tables stored in oat files.
+ */
+uint32_t ComputeModifiedUtf8Hash(const char* chars);
+
 /*
  * Retrieve the next UTF-16 character from a UTF-8 string.
  *
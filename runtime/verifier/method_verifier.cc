@@ -20,6 +20,7 @@
 
 #include "base/logging.h"
 #include "base/mutex-inl.h"
+#include "base/systrace.h"
 #include "class_linker.h"
 #include "compiler_callbacks.h"
 #include "dex_file-inl.h"
@@ -127,6 +128,9 @@ MethodVerifier::FailureKind MethodVerifier::VerifyClass(const DexFile* dex_file,
                                                         bool allow_soft_failures,
                                                         std::string* error) {
   DCHECK(class_def != nullptr);
+  ScopedTrace trace(ATRACE_ENABLED()
+                    ? StringPrintf("VerifyClass %s", dex_file->GetClassDescriptor(*class_def))
+                    : std::string());
   const byte* class_data = dex_file->GetClassData(*class_def);
   if (class_data == NULL) {
     // empty class, probably a marker interface
@@ -139,6 +143,10 @@ MethodVerifier::FailureKind MethodVerifier::VerifyClass(const DexFile* dex_file,
   size_t error_count = 0;
   bool hard_fail = false;
   ClassLinker* linker = Runtime::Current()->GetClassLinker();
+  // At runtime, the methods which verified without failures in a class with soft failures don't
+  // need access checks in the interpreter, only the failing ones do. ArtMethods don't move.
+  bool record_clean_methods = !Runtime::Current()->IsCompiler();
+  std::vector<mirror::ArtMethod*> clean_methods;
   int64_t previous_direct_method_idx = -1;
   while (it.HasNextDirectMethod()) {
     uint32_t method_idx = it.GetMemberIndex();
@@ -166,6 +174,9 @@ MethodVerifier::FailureKind MethodVerifier::VerifyClass(const DexFile* dex_file,
                                                       method,
                                                       it.GetMemberAccessFlags(),
                                                       allow_soft_failures);
+    if (result == kNoFailure && record_clean_methods && method != nullptr) {
+      clean_methods.push_back(method);
+    }
     if (result != kNoFailure) {
       if (result == kHardFailure) {
         hard_fail = true;
@@ -208,6 +219,9 @@ MethodVerifier::FailureKind MethodVerifier::VerifyClass(const DexFile* dex_file,
                                                       method,
                                                       it.GetMemberAccessFlags(),
                                                       allow_soft_failures);
+    if (result == kNoFailure && record_clean_methods && method != nullptr) {
+      clean_methods.push_back(method);
+    }
     if (result != kNoFailure) {
       if (result == kHardFailure) {
         hard_fail = true;
@@ -225,8 +239,16 @@ MethodVerifier::FailureKind MethodVerifier::VerifyClass(const DexFile* dex_file,
   }
   if (error_count == 0) {
     return kNoFailure;
+  } else if (hard_fail) {
+    return kHardFailure;
   } else {
-    return hard_fail ? kHardFailure : kSoftFailure;
+    // The class linker sets the flag on all the methods of a class without failures.
+    for (mirror::ArtMethod* method : clean_methods) {
+      if (!method->IsNative() && !method->IsAbstract()) {
+        method->SetPreverified();
+      }
+    }
+    return kSoftFailure;
   }
 }
 
@@ -648,53 +670,55 @@ bool MethodVerifier::VerifyInstructions() {
 }
 
 bool MethodVerifier::VerifyInstruction(const Instruction* inst, uint32_t code_offset) {
+  Instruction::Decoded decoded;
+  inst->Decode(&decoded);
   bool result = true;
   switch (inst->GetVerifyTypeArgumentA()) {
     case Instruction::kVerifyRegA:
-      result = result && CheckRegisterIndex(inst->VRegA());
+      result = result && CheckRegisterIndex(decoded.vA);
       break;
     case Instruction::kVerifyRegAWide:
-      result = result && CheckWideRegisterIndex(inst->VRegA());
+      result = result && CheckWideRegisterIndex(decoded.vA);
       break;
   }
   switch (inst->GetVerifyTypeArgumentB()) {
     case Instruction::kVerifyRegB:
-      result = result && CheckRegisterIndex(inst->VRegB());
+      result = result && CheckRegisterIndex(decoded.vB);
       break;
     case Instruction::kVerifyRegBField:
-      result = result && CheckFieldIndex(inst->VRegB());
+      result = result && CheckFieldIndex(decoded.vB);
       break;
     case Instruction::kVerifyRegBMethod:
-      result = result && CheckMethodIndex(inst->VRegB());
+      result = result && CheckMethodIndex(decoded.vB);
       break;
     case Instruction::kVerifyRegBNewInstance:
-      result = result && CheckNewInstance(inst->VRegB());
+      result = result && CheckNewInstance(decoded.vB);
       break;
     case Instruction::kVerifyRegBString:
-      result = result && CheckStringIndex(inst->VRegB());
+      result = result && CheckStringIndex(decoded.vB);
       break;
     case Instruction::kVerifyRegBType:
-      result = result && CheckTypeIndex(inst->VRegB());
+      result = result && CheckTypeIndex(decoded.vB);
       break;
     case Instruction::kVerifyRegBWide:
-      result = result && CheckWideRegisterIndex(inst->VRegB());
+      result = result && CheckWideRegisterIndex(decoded.vB);
       break;
   }
   switch (inst->GetVerifyTypeArgumentC()) {
     case Instruction::kVerifyRegC:
-      result = result && CheckRegisterIndex(inst->VRegC());
+      result = result && CheckRegisterIndex(decoded.vC);
       break;
     case Instruction::kVerifyRegCField:
-      result = result && CheckFieldIndex(inst->VRegC());
+      result = result && CheckFieldIndex(decoded.vC);
       break;
     case Instruction::kVerifyRegCNewArray:
-      result = result && CheckNewArray(inst->VRegC());
+      result = result && CheckNewArray(decoded.vC);
       break;
     case Instruction::kVerifyRegCType:
-      result = result && CheckTypeIndex(inst->VRegC());
+      result = result && CheckTypeIndex(decoded.vC);
       break;
     case Instruction::kVerifyRegCWide:
-      result = result && CheckWideRegisterIndex(inst->VRegC());
+      result = result && CheckWideRegisterIndex(decoded.vC);
       break;
   }
   switch (inst->GetVerifyExtraFlags()) {
@@ -707,14 +731,11 @@ bool MethodVerifier::VerifyInstruction(const Instruction* inst, uint32_t code_of
     case Instruction::kVerifySwitchTargets:
       result = result && CheckSwitchTargets(code_offset);
       break;
-    case Instruction::kVerifyVarArg: {
-      uint32_t args[Instruction::kMaxVarArgRegs];
-      inst->GetVarArgs(args);
-      result = result && CheckVarArgRegs(inst->VRegA(), args);
+    case Instruction::kVerifyVarArg:
+      result = result && CheckVarArgRegs(decoded.vA, decoded.arg);
       break;
-    }
     case Instruction::kVerifyVarArgRange:
-      result = result && CheckVarArgRangeRegs(inst->VRegA(), inst->VRegC());
+      result = result && CheckVarArgRangeRegs(decoded.vA, decoded.vC);
       break;
     case Instruction::kVerifyError:
       Fail(VERIFY_ERROR_BAD_CLASS_HARD) << "unexpected opcode " << inst->Name();
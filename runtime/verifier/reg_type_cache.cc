@@ -16,9 +16,13 @@
 
 #include "reg_type_cache-inl.h"
 
+#include <pthread.h>
+
 #include "base/casts.h"
 #include "class_linker-inl.h"
 #include "dex_file-inl.h"
+#include "gc/heap.h"
+#include "gc/space/space.h"
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
 #include "object_utils.h"
@@ -30,6 +34,15 @@ bool RegTypeCache::primitive_initialized_ = false;
 uint16_t RegTypeCache::primitive_count_ = 0;
 PreciseConstType* RegTypeCache::small_precise_constants_[kMaxSmallConstant - kMinSmallConstant + 1];
 
+// Bounds the copying done when creating a cache.
+static constexpr size_t kMaxSharedTypes = 256;
+
+static pthread_once_t shared_types_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t shared_types_key;
+// Bumped on ShutDown so that the types resolved in a previous runtime are dropped.
+static uint32_t shared_types_generation = 0;
+
+
 static bool MatchingPrecisionForClass(RegType* entry, bool precise)
     SHARED_LOCKS_REQUIRED(Locks::mutator_lock_) {
   if (entry->IsPreciseReference() == precise) {
@@ -123,6 +136,75 @@ const RegType& RegTypeCache::RegTypeFromPrimitiveType(Primitive::Type prim_type)
   }
 }
 
+void RegTypeCache::CreateSharedTypesKey() {
+  CHECK_PTHREAD_CALL(pthread_key_create, (&shared_types_key, DeleteSharedTypes),
+                     "reg type cache shared types key");
+}
+
+void RegTypeCache::DeleteSharedTypes(void* shared_types) {
+  delete reinterpret_cast<SharedTypes*>(shared_types);
+}
+
+RegTypeCache::SharedTypes* RegTypeCache::GetSharedTypes() {
+  CHECK_PTHREAD_CALL(pthread_once, (&shared_types_key_once, CreateSharedTypesKey),
+                     "reg type cache shared types key");
+  SharedTypes* shared_types =
+      reinterpret_cast<SharedTypes*>(pthread_getspecific(shared_types_key));
+  if (shared_types == nullptr || shared_types->generation != shared_types_generation) {
+    delete shared_types;
+    shared_types = new SharedTypes(shared_types_generation);
+    CHECK_PTHREAD_CALL(pthread_setspecific, (shared_types_key, shared_types),
+                       "reg type cache shared types");
+  }
+  return shared_types;
+}
+
+const RegType* RegTypeCache::FindSharedType(const char* descriptor, bool precise) {
+  // Only the types shared before this cache was created have an id here.
+  StringPiece key(descriptor);
+  if (!precise) {
+    auto it = shared_types_->imprecise_ids.find(key);
+    if (it != shared_types_->imprecise_ids.end() && it->second < local_begin_) {
+      return entries_[it->second];
+    }
+  }
+  auto it = shared_types_->precise_ids.find(key);
+  if (it != shared_types_->precise_ids.end() && it->second < local_begin_ &&
+      MatchingPrecisionForClass(entries_[it->second], precise)) {
+    return entries_[it->second];
+  }
+  return nullptr;
+}
+
+void RegTypeCache::AddSharedType(const RegType& type) {
+  mirror::Class* klass = type.GetClass();
+  if (shared_types_->entries.size() >= kMaxSharedTypes || klass->GetClassLoader() != nullptr) {
+    return;
+  }
+  gc::space::Space* space =
+      Runtime::Current()->GetHeap()->FindSpaceFromObject(klass, true);
+  if (space == nullptr || !space->IsImageSpace()) {
+    // The class may move or, for an array class, be created again by another runtime.
+    return;
+  }
+  SafeMap<StringPiece, uint16_t>* ids =
+      type.IsPreciseReference() ? &shared_types_->precise_ids : &shared_types_->imprecise_ids;
+  if (ids->find(StringPiece(type.GetDescriptor())) != ids->end()) {
+    // Shared by another cache after this one was created.
+    return;
+  }
+  uint16_t id = primitive_count_ + shared_types_->entries.size();
+  RegType* entry;
+  if (type.IsPreciseReference()) {
+    entry = new PreciseReferenceType(klass, type.GetDescriptor(), id);
+  } else {
+    entry = new ReferenceType(klass, type.GetDescriptor(), id);
+  }
+  shared_types_->entries.push_back(entry);
+  // The key refers to the descriptor of the shared entry, which lives as long as the map.
+  ids->Put(StringPiece(entry->GetDescriptor()), id);
+}
+
 bool RegTypeCache::MatchDescriptor(size_t idx, const char* descriptor, bool precise) {
   RegType* entry = entries_[idx];
   if (entry->descriptor_ != descriptor) {
@@ -159,8 +241,13 @@ mirror::Class* RegTypeCache::ResolveClass(const char* descriptor, mirror::ClassL
 
 const RegType& RegTypeCache::From(mirror::ClassLoader* loader, const char* descriptor,
                                   bool precise) {
-  // Try looking up the class in the cache first.
-  for (size_t i = primitive_count_; i < entries_.size(); i++) {
+  // Try looking up the class in the types shared with the other caches of the thread, then in
+  // the cache's own types.
+  const RegType* shared_type = FindSharedType(descriptor, precise);
+  if (shared_type != nullptr) {
+    return *shared_type;
+  }
+  for (size_t i = local_begin_; i < entries_.size(); i++) {
     if (MatchDescriptor(i, descriptor, precise)) {
       return *(entries_[i]);
     }
@@ -187,6 +274,7 @@ const RegType& RegTypeCache::From(mirror::ClassLoader* loader, const char* descr
       entry = new ReferenceType(klass, descriptor, entries_.size());
     }
     entries_.push_back(entry);
+    AddSharedType(*entry);
     return *entry;
   } else {  // Class not resolved.
     // We tried loading the class and failed, this might get an exception raised
@@ -216,8 +304,12 @@ const RegType& RegTypeCache::FromClass(const char* descriptor, mirror::Class* kl
     // primitive classes are final.
     return RegTypeFromPrimitiveType(klass->GetPrimitiveType());
   } else {
-    // Look for the reference in the list of entries to have.
-    for (size_t i = primitive_count_; i < entries_.size(); i++) {
+    // Look for the reference in the shared types, then in the list of entries to have.
+    const RegType* shared_type = FindSharedType(descriptor, precise);
+    if (shared_type != nullptr && shared_type->GetClass() == klass) {
+      return *shared_type;
+    }
+    for (size_t i = local_begin_; i < entries_.size(); i++) {
       RegType* cur_entry = entries_[i];
       if (cur_entry->klass_ == klass && MatchingPrecisionForClass(cur_entry, precise)) {
         return *cur_entry;
@@ -231,28 +323,31 @@ const RegType& RegTypeCache::FromClass(const char* descriptor, mirror::Class* kl
       entry = new ReferenceType(klass, descriptor, entries_.size());
     }
     entries_.push_back(entry);
+    AddSharedType(*entry);
     return *entry;
   }
 }
 
-RegTypeCache::RegTypeCache(bool can_load_classes) : can_load_classes_(can_load_classes) {
+RegTypeCache::RegTypeCache(bool can_load_classes)
+    : can_load_classes_(can_load_classes), shared_types_(GetSharedTypes()), local_begin_(0) {
   if (kIsDebugBuild && can_load_classes) {
     Thread::Current()->AssertThreadSuspensionIsAllowable();
   }
-  entries_.reserve(64);
+  entries_.reserve(64 + shared_types_->entries.size());
   FillPrimitiveAndSmallConstantTypes();
+  entries_.insert(entries_.end(), shared_types_->entries.begin(), shared_types_->entries.end());
+  local_begin_ = entries_.size();
 }
 
 RegTypeCache::~RegTypeCache() {
-  CHECK_LE(primitive_count_, entries_.size());
-  // Delete only the non primitive types.
-  if (entries_.size() == kNumPrimitivesAndSmallConstants) {
-    // All entries are from the global pool, nothing to delete.
+  CHECK_LE(local_begin_, entries_.size());
+  // Delete only the types owned by this cache, the primitive and shared ones are global.
+  if (entries_.size() == local_begin_) {
     return;
   }
-  std::vector<RegType*>::iterator non_primitive_begin = entries_.begin();
-  std::advance(non_primitive_begin, kNumPrimitivesAndSmallConstants);
-  STLDeleteContainerPointers(non_primitive_begin, entries_.end());
+  std::vector<RegType*>::iterator local_entries_begin = entries_.begin();
+  std::advance(local_entries_begin, local_begin_);
+  STLDeleteContainerPointers(local_entries_begin, entries_.end());
 }
 
 void RegTypeCache::ShutDown() {
@@ -276,6 +371,8 @@ void RegTypeCache::ShutDown() {
     }
     RegTypeCache::primitive_initialized_ = false;
     RegTypeCache::primitive_count_ = 0;
+    // The shared types refer to the classes of this runtime.
+    shared_types_generation++;
   }
 }
 
@@ -582,8 +679,11 @@ void RegTypeCache::Dump(std::ostream& os) {
 }
 
 void RegTypeCache::VisitRoots(RootCallback* callback, void* arg) {
-  for (RegType* entry : entries_) {
-    entry->VisitRoots(callback, arg);
+  // The shared types refer to image classes, which are neither moved nor freed.
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    if (i < primitive_count_ || i >= local_begin_) {
+      entries_[i]->VisitRoots(callback, arg);
+    }
   }
 }
 
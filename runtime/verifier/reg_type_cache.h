@@ -27,6 +27,9 @@
 #include <stdint.h>
 #include <vector>
 
+#include "base/stringpiece.h"
+#include "safe_map.h"
+
 namespace art {
 namespace mirror {
 class Class;
@@ -146,6 +149,32 @@ class RegTypeCache {
   void VisitRoots(RootCallback* callback, void* arg) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
 
  private:
+  // The reference types of boot image classes met by the caches of a thread. Such types are
+  // immutable and their classes are never moved nor unloaded, so every cache of the thread starts
+  // with the ones known when it is created, at the same ids, rather than resolving and allocating
+  // them again for each method.
+  struct SharedTypes {
+    explicit SharedTypes(uint32_t generation) : generation(generation) {}
+    ~SharedTypes() {
+      STLDeleteElements(&entries);
+    }
+
+    // The runtime the types were resolved in, see ShutDown.
+    const uint32_t generation;
+    // The entry at index i has the id primitive_count_ + i.
+    std::vector<RegType*> entries;
+    // Ids of the precise and imprecise types, keyed by their descriptor.
+    SafeMap<StringPiece, uint16_t> precise_ids;
+    SafeMap<StringPiece, uint16_t> imprecise_ids;
+  };
+
+  static void CreateSharedTypesKey();
+  static void DeleteSharedTypes(void* shared_types);
+  static SharedTypes* GetSharedTypes();
+  const RegType* FindSharedType(const char* descriptor, bool precise)
+      SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+  void AddSharedType(const RegType& type) SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
+
   void FillPrimitiveAndSmallConstantTypes() SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
   mirror::Class* ResolveClass(const char* descriptor, mirror::ClassLoader* loader)
       SHARED_LOCKS_REQUIRED(Locks::mutator_lock_);
@@ -179,6 +208,10 @@ class RegTypeCache {
   // Whether or not we're allowed to load classes.
   const bool can_load_classes_;
 
+  // The shared types of the current thread, and the id of the first entry owned by this cache.
+  SharedTypes* const shared_types_;
+  uint16_t local_begin_;
+
   DISALLOW_COPY_AND_ASSIGN(RegTypeCache);
 };
 
@@ -448,6 +448,27 @@ TEST_F(RegTypeReferenceTest, JavalangObject) {
   EXPECT_TRUE(ref_type_3.Equals(ref_type_2));
   EXPECT_EQ(ref_type.GetId(), ref_type_3.GetId());
 }
+
+TEST_F(RegTypeReferenceTest, SuccessiveCaches) {
+  // Caches of a thread share the types of boot image classes: each cache must still hand out
+  // types of its own ids, whether or not the class comes from an image.
+  ScopedObjectAccess soa(Thread::Current());
+  RegTypeCache cache(true);
+  const RegType& string = cache.JavaLangString();
+  const RegType& unresolved = cache.FromDescriptor(NULL, "Ljava/lang/DoesNotExist;", true);
+  RegTypeCache cache_2(true);
+  const RegType& object_2 = cache_2.JavaLangObject(false);
+  const RegType& string_2 = cache_2.JavaLangString();
+  const RegType& unresolved_2 = cache_2.FromDescriptor(NULL, "Ljava/lang/DoesNotExist;", true);
+  EXPECT_EQ(string.GetClass(), string_2.GetClass());
+  EXPECT_TRUE(string_2.Equals(cache_2.FromDescriptor(NULL, "Ljava/lang/String;", false)));
+  EXPECT_TRUE(object_2.Equals(cache_2.FromDescriptor(NULL, "Ljava/lang/Object;", false)));
+  EXPECT_TRUE(unresolved_2.IsUnresolvedReference());
+  EXPECT_FALSE(unresolved.Equals(string));
+  EXPECT_TRUE(cache_2.GetFromId(string_2.GetId()).Equals(string_2));
+  EXPECT_TRUE(cache_2.GetFromId(unresolved_2.GetId()).Equals(unresolved_2));
+}
+
 TEST_F(RegTypeReferenceTest, Merging) {
   // Tests merging logic
   // String and object , LUB is object.
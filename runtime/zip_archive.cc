@@ -25,6 +25,7 @@
 
 #include "base/stringprintf.h"
 #include "base/unix_file/fd_file.h"
+#include "utils.h"
 
 namespace art {
 
@@ -36,6 +37,15 @@ uint32_t ZipEntry::GetCrc32() {
   return zip_entry_->crc32;
 }
 
+bool ZipEntry::IsUncompressed() {
+  return zip_entry_->method == kCompressStored;
+}
+
+bool ZipEntry::IsAlignedTo(size_t alignment) {
+  DCHECK(IsPowerOfTwo(alignment)) << alignment;
+  return (zip_entry_->offset & (alignment - 1)) == 0;
+}
+
 ZipEntry::~ZipEntry() {
   delete zip_entry_;
 }
@@ -72,6 +82,24 @@ MemMap* ZipEntry::ExtractToMemMap(const char* entry_filename, std::string* error
   return map.release();
 }
 
+MemMap* ZipEntry::MapDirectlyFromFile(const char* entry_filename, std::string* error_msg) {
+  if (!IsUncompressed()) {
+    *error_msg = StringPrintf("Cannot map '%s' directly: it is compressed", entry_filename);
+    return nullptr;
+  }
+  std::string name(entry_filename);
+  name += " mapped directly from zip file";
+  // MAP_PRIVATE so that the dex file can still be made writable, e.g. for breakpoints, without
+  // changing the zip file.
+  MemMap* map = MemMap::MapFile(GetUncompressedLength(), PROT_READ, MAP_PRIVATE,
+                                GetFileDescriptor(handle_), zip_entry_->offset, name.c_str(),
+                                error_msg);
+  if (map == nullptr) {
+    DCHECK(!error_msg->empty());
+  }
+  return map;
+}
+
 static void SetCloseOnExec(int fd) {
   // This dance is more portable than Linux's O_CLOEXEC open(2) flag.
   int flags = fcntl(fd, F_GETFD);
@@ -38,11 +38,19 @@ class ZipEntry {
  public:
   bool ExtractToFile(File& file, std::string* error_msg);
   MemMap* ExtractToMemMap(const char* entry_filename, std::string* error_msg);
+  // Maps the entry read only straight from the zip file, sharing its pages with the page cache
+  // instead of copying them. The entry must be stored uncompressed, see IsUncompressed, and
+  // starts anywhere in the file: the mapping begins at the entry data, whatever its alignment.
+  MemMap* MapDirectlyFromFile(const char* entry_filename, std::string* error_msg);
   virtual ~ZipEntry();
 
   uint32_t GetUncompressedLength();
   uint32_t GetCrc32();
 
+  bool IsUncompressed();
+  // Whether the entry data starts at an offset of the zip file that is a multiple of alignment.
+  bool IsAlignedTo(size_t alignment);
+
  private:
   ZipEntry(ZipArchiveHandle handle,
            ::ZipEntry* zip_entry) : handle_(handle), zip_entry_(zip_entry) {}
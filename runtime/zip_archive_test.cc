@@ -21,6 +21,7 @@
 #include <sys/types.h>
 #include <zlib.h>
 #include <memory>
+#include <vector>
 
 #include "common_runtime_test.h"
 #include "os.h"
@@ -62,4 +63,85 @@ TEST_F(ZipArchiveTest, FindAndExtract) {
   EXPECT_EQ(zip_entry->GetCrc32(), computed_crc);
 }
 
+static void AppendUint16(uint16_t value, std::vector<uint8_t>* data) {
+  data->push_back(value & 0xff);
+  data->push_back(value >> 8);
+}
+
+static void AppendUint32(uint32_t value, std::vector<uint8_t>* data) {
+  AppendUint16(value & 0xffff, data);
+  AppendUint16(value >> 16, data);
+}
+
+TEST_F(ZipArchiveTest, MapDirectlyFromFile) {
+  // A zip file with a single stored entry, padded so that its data is 4 byte aligned.
+  static const char kName[] = "classes.dex";
+  const uint16_t name_length = strlen(kName);
+  std::vector<uint8_t> contents;
+  for (size_t i = 0; i < 1000; ++i) {
+    contents.push_back(static_cast<uint8_t>(i * 7));
+  }
+  uint32_t crc = crc32(crc32(0L, Z_NULL, 0), &contents[0], contents.size());
+  std::vector<uint8_t> zip;
+  AppendUint32(0x04034b50, &zip);  // Local file header.
+  AppendUint16(10, &zip);  // Version needed.
+  AppendUint16(0, &zip);  // Flags.
+  AppendUint16(0, &zip);  // Stored.
+  AppendUint32(0, &zip);  // Modification time and date.
+  AppendUint32(crc, &zip);
+  AppendUint32(contents.size(), &zip);
+  AppendUint32(contents.size(), &zip);
+  AppendUint16(name_length, &zip);
+  const uint16_t extra_length = RoundUp(30 + name_length, 4) - (30 + name_length);
+  AppendUint16(extra_length, &zip);
+  zip.insert(zip.end(), kName, kName + name_length);
+  zip.insert(zip.end(), extra_length, 0);
+  const uint32_t data_offset = zip.size();
+  zip.insert(zip.end(), contents.begin(), contents.end());
+  const uint32_t central_directory_offset = zip.size();
+  AppendUint32(0x02014b50, &zip);  // Central directory file header.
+  AppendUint16(10, &zip);  // Version made by.
+  AppendUint16(10, &zip);  // Version needed.
+  AppendUint16(0, &zip);  // Flags.
+  AppendUint16(0, &zip);  // Stored.
+  AppendUint32(0, &zip);  // Modification time and date.
+  AppendUint32(crc, &zip);
+  AppendUint32(contents.size(), &zip);
+  AppendUint32(contents.size(), &zip);
+  AppendUint16(name_length, &zip);
+  AppendUint16(0, &zip);  // Extra field length.
+  AppendUint16(0, &zip);  // Comment length.
+  AppendUint16(0, &zip);  // Disk number.
+  AppendUint16(0, &zip);  // Internal attributes.
+  AppendUint32(0, &zip);  // External attributes.
+  AppendUint32(0, &zip);  // Offset of the local file header.
+  zip.insert(zip.end(), kName, kName + name_length);
+  const uint32_t central_directory_size = zip.size() - central_directory_offset;
+  AppendUint32(0x06054b50, &zip);  // End of central directory.
+  AppendUint16(0, &zip);  // Disk number.
+  AppendUint16(0, &zip);  // Disk with the central directory.
+  AppendUint16(1, &zip);  // Entries on this disk.
+  AppendUint16(1, &zip);  // Entries.
+  AppendUint32(central_directory_size, &zip);
+  AppendUint32(central_directory_offset, &zip);
+  AppendUint16(0, &zip);  // Comment length.
+
+  ScratchFile tmp;
+  ASSERT_TRUE(tmp.GetFile()->WriteFully(&zip[0], zip.size()));
+  std::string error_msg;
+  std::unique_ptr<ZipArchive> zip_archive(ZipArchive::Open(tmp.GetFilename().c_str(),
+                                                           &error_msg));
+  ASSERT_TRUE(zip_archive.get() != nullptr) << error_msg;
+  std::unique_ptr<ZipEntry> zip_entry(zip_archive->Find(kName, &error_msg));
+  ASSERT_TRUE(zip_entry.get() != nullptr) << error_msg;
+  ASSERT_TRUE(zip_entry->IsUncompressed());
+  ASSERT_TRUE(zip_entry->IsAlignedTo(4));
+  ASSERT_EQ(IsAligned<8>(data_offset), zip_entry->IsAlignedTo(8));
+
+  std::unique_ptr<MemMap> map(zip_entry->MapDirectlyFromFile(kName, &error_msg));
+  ASSERT_TRUE(map.get() != nullptr) << error_msg;
+  ASSERT_EQ(contents.size(), map->Size());
+  EXPECT_EQ(0, memcmp(&contents[0], map->Begin(), contents.size()));
+}
+
 }  // namespace art
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Note that $opt$ is a marker for the optimizing compiler to ensure
+// it does compile the method.
+
+public class Main {
+  public static void expectEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  public static void main(String[] args) {
+    int[] array = new int[] { 1, 2, 3, 4 };
+    int sum = $opt$Sum(array);
+    expectEquals(10, sum);
+    System.out.println("Sum: " + sum);
+
+    expectEquals(4, $opt$Length(array));
+    expectEquals(3, $opt$Get(array, 2));
+    $opt$Set(array, 2, 42);
+    expectEquals(42, array[2]);
+    expectEquals(7, $opt$Div(42, 6));
+
+    try {
+      $opt$Sum(null);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException e) {
+      // Expected.
+    }
+
+    try {
+      $opt$Length(null);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException e) {
+      // Expected.
+    }
+
+    try {
+      $opt$Get(array, 4);
+      throw new Error("Expected ArrayIndexOutOfBoundsException");
+    } catch (ArrayIndexOutOfBoundsException e) {
+      // Expected.
+    }
+
+    try {
+      $opt$Set(array, -1, 42);
+      throw new Error("Expected ArrayIndexOutOfBoundsException");
+    } catch (ArrayIndexOutOfBoundsException e) {
+      // Expected.
+    }
+
+    try {
+      $opt$Div(42, 0);
+      throw new Error("Expected ArithmeticException");
+    } catch (ArithmeticException e) {
+      // Expected.
+    }
+  }
+
+  static int $opt$Sum(int[] array) {
+    int sum = 0;
+    for (int i = 0; i < array.length; i++) {
+      sum += array[i];
+    }
+    return sum;
+  }
+
+  static int $opt$Length(int[] array) {
+    return array.length;
+  }
+
+  static int $opt$Get(int[] array, int index) {
+    return array[index];
+  }
+
+  static void $opt$Set(int[] array, int index, int value) {
+    array[index] = value;
+  }
+
+  static int $opt$Div(int a, int b) {
+    return a / b;
+  }
+}
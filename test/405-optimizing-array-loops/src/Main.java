@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Note that $opt$ is a marker for the optimizing compiler to ensure
+// it does compile the method.
+
+public class Main {
+  public static void expectEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  public static void main(String[] args) {
+    for (int length = 0; length < 20; length++) {
+      int[] a = new int[length];
+      int[] b = new int[length];
+      int[] c = new int[length + 3];
+      for (int i = 0; i < c.length; i++) {
+        c[i] = i * 3;
+      }
+
+      $opt$Fill(a, 42);
+      for (int i = 0; i < length; i++) {
+        expectEquals(42, a[i]);
+      }
+
+      $opt$Copy(b, c);
+      for (int i = 0; i < length; i++) {
+        expectEquals(i * 3, b[i]);
+      }
+
+      $opt$Add(a, b, c);
+      for (int i = 0; i < length; i++) {
+        expectEquals(i * 6, a[i]);
+      }
+
+      $opt$SubFromInvariant(a, 100);
+      for (int i = 0; i < length; i++) {
+        expectEquals(100 - i * 6, a[i]);
+      }
+    }
+
+    short[] shorts = new short[13];
+    $opt$FillShorts(shorts, (short) 7);
+    for (int i = 0; i < shorts.length; i++) {
+      expectEquals(7, shorts[i]);
+    }
+
+    // The destination is shorter than the source: the remaining iterations
+    // throw after the vectorized ones.
+    int[] small = new int[5];
+    try {
+      $opt$CopyUpTo(small, new int[9], 9);
+      throw new Error("Expected ArrayIndexOutOfBoundsException");
+    } catch (ArrayIndexOutOfBoundsException e) {
+      // Expected.
+    }
+
+    int[] numbers = new int[101];
+    for (int i = 0; i < numbers.length; i++) {
+      numbers[i] = i;
+    }
+    int[] copy = new int[101];
+    $opt$Copy(copy, numbers);
+    int sum = 0;
+    for (int i = 0; i < copy.length; i++) {
+      sum += copy[i];
+    }
+    expectEquals(5050, sum);
+    System.out.println("Sum: " + sum);
+  }
+
+  static void $opt$Fill(int[] a, int value) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] = value;
+    }
+  }
+
+  static void $opt$FillShorts(short[] a, short value) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] = value;
+    }
+  }
+
+  static void $opt$Copy(int[] a, int[] b) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] = b[i];
+    }
+  }
+
+  static void $opt$CopyUpTo(int[] a, int[] b, int bound) {
+    for (int i = 0; i < bound; i++) {
+      a[i] = b[i];
+    }
+  }
+
+  static void $opt$Add(int[] a, int[] b, int[] c) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] = b[i] + c[i];
+    }
+  }
+
+  static void $opt$SubFromInvariant(int[] a, int value) {
+    for (int i = 0; i < a.length; i++) {
+      a[i] = value - a[i];
+    }
+  }
+}
@@ -56,6 +56,10 @@ TEST_OAT_DIRECTORIES := \
 # TODO: Enable when the StackWalk2 tests are passing
 #	StackWalk2 \
 
+# subdirectories of which are used with test-art-*-benchmark
+TEST_BENCHMARK_DIRECTORIES := \
+	Benchmark
+
 ART_TEST_TARGET_DEX_FILES :=
 ART_TEST_TARGET_DEX_FILES$(ART_PHONY_TEST_TARGET_SUFFIX) :=
 ART_TEST_TARGET_DEX_FILES$(2ND_ART_PHONY_TEST_TARGET_SUFFIX) :=
@@ -99,6 +103,7 @@ define build-art-test-dex
 endef
 $(foreach dir,$(TEST_DEX_DIRECTORIES), $(eval $(call build-art-test-dex,art-test-dex,$(dir),$(ART_NATIVETEST_OUT))))
 $(foreach dir,$(TEST_OAT_DIRECTORIES), $(eval $(call build-art-test-dex,oat-test-dex,$(dir),$(ART_TEST_OUT))))
+$(foreach dir,$(TEST_BENCHMARK_DIRECTORIES), $(eval $(call build-art-test-dex,benchmark-dex,$(dir),$(ART_TEST_OUT))))
 
 # Used outside the art project to get a list of the current tests
 ART_TEST_DEX_MAKE_TARGETS := $(addprefix art-test-dex-, $(TEST_DEX_DIRECTORIES))
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Allocation throughput. The byte array lengths cover the size brackets of the allocators:
+ * the small brackets served from thread local runs, the larger ones, and the large object space.
+ */
+class AllocationBenchmarks {
+    private static final int[] ARRAY_LENGTHS = { 8, 64, 256, 1024, 4 * 1024, 16 * 1024, 64 * 1024 };
+
+    // The allocations stay live until this many more are done.
+    private static final int LIVE_COUNT = 16;
+
+    static class FourFields {
+        int a;
+        int b;
+        long c;
+        Object d;
+    }
+
+    static void run() throws Exception {
+        Benchmark.measure(new Benchmark.Loop("alloc.object") {
+            void run(int reps) {
+                Object[] live = new Object[LIVE_COUNT];
+                for (int i = 0; i < reps; i++) {
+                    live[i % LIVE_COUNT] = new Object();
+                }
+                Benchmark.objectSink = live;
+            }
+        });
+        Benchmark.measure(new Benchmark.Loop("alloc.object_with_fields") {
+            void run(int reps) {
+                Object[] live = new Object[LIVE_COUNT];
+                for (int i = 0; i < reps; i++) {
+                    live[i % LIVE_COUNT] = new FourFields();
+                }
+                Benchmark.objectSink = live;
+            }
+        });
+        for (final int length : ARRAY_LENGTHS) {
+            Benchmark.measure(new Benchmark.Loop("alloc.byte_array." + length) {
+                void run(int reps) {
+                    Object[] live = new Object[LIVE_COUNT];
+                    for (int i = 0; i < reps; i++) {
+                        live[i % LIVE_COUNT] = new byte[length];
+                    }
+                    Benchmark.objectSink = live;
+                }
+            });
+        }
+    }
+}
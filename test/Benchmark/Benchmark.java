@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.Arrays;
+import java.util.Locale;
+
+/**
+ * Runtime microbenchmarks. Each measurement is printed on its own line as
+ * "<name> <value> <unit>", in a fixed order, so that the output of two builds
+ * can be compared line by line. The arguments, if any, are prefixes of the
+ * names of the benchmarks to run.
+ */
+class Benchmark {
+    /** An operation timed by running it in a loop. */
+    static abstract class Loop {
+        final String name;
+
+        Loop(String name) {
+            this.name = name;
+        }
+
+        /** Runs the operation {@code reps} times. */
+        abstract void run(int reps) throws Exception;
+    }
+
+    // A loop is timed once a run of it takes at least this long.
+    private static final long MIN_RUN_NS = 100 * 1000 * 1000L;
+    // The reported time per operation is the median of this many runs.
+    private static final int MEASURED_RUNS = 5;
+
+    // Where the loops store their results, so that their work is not dead.
+    static volatile Object objectSink;
+    static volatile int intSink;
+
+    private static String[] prefixes;
+
+    public static void main(String[] args) throws Exception {
+        prefixes = args;
+        System.loadLibrary("artbenchmark");
+        AllocationBenchmarks.run();
+        GcPauseBenchmarks.run();
+        MonitorBenchmarks.run();
+        JniBenchmarks.run();
+        DispatchBenchmarks.run();
+        ReflectionBenchmarks.run();
+    }
+
+    static boolean isSelected(String name) {
+        if (prefixes.length == 0) {
+            return true;
+        }
+        for (String prefix : prefixes) {
+            if (name.startsWith(prefix)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Reports the time per operation of {@code loop}, if it is selected. */
+    static void measure(Loop loop) throws Exception {
+        if (!isSelected(loop.name)) {
+            return;
+        }
+        // The runs doubling the repetitions until a run is long enough also warm up the loop.
+        int reps = 1;
+        while (time(loop, reps) < MIN_RUN_NS && reps < (1 << 30)) {
+            reps *= 2;
+        }
+        double[] nsPerOp = new double[MEASURED_RUNS];
+        for (int i = 0; i < MEASURED_RUNS; i++) {
+            nsPerOp[i] = (double) time(loop, reps) / reps;
+        }
+        Arrays.sort(nsPerOp);
+        report(loop.name, nsPerOp[MEASURED_RUNS / 2], "ns/op");
+    }
+
+    private static long time(Loop loop, int reps) throws Exception {
+        long start = System.nanoTime();
+        loop.run(reps);
+        return System.nanoTime() - start;
+    }
+
+    /** Reports the percentiles of {@code durationsNs}, in microseconds. */
+    static void reportDistribution(String name, long[] durationsNs, int count) {
+        report(name + ".count", count, "events");
+        long[] sorted = Arrays.copyOf(durationsNs, count);
+        Arrays.sort(sorted);
+        report(name + ".p50", percentile(sorted, 50) / 1000.0, "us");
+        report(name + ".p90", percentile(sorted, 90) / 1000.0, "us");
+        report(name + ".p99", percentile(sorted, 99) / 1000.0, "us");
+        report(name + ".max", percentile(sorted, 100) / 1000.0, "us");
+    }
+
+    private static long percentile(long[] sorted, int percent) {
+        if (sorted.length == 0) {
+            return 0;
+        }
+        int index = (sorted.length * percent + 99) / 100 - 1;
+        return sorted[Math.max(index, 0)];
+    }
+
+    static void report(String name, double value, String unit) {
+        System.out.println(String.format(Locale.US, "%s %.2f %s", name, value, unit));
+    }
+}
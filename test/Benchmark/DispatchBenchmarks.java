@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Virtual and interface calls, with one receiver class at the call site and with several.
+ */
+class DispatchBenchmarks {
+    interface Valued {
+        int value();
+    }
+
+    static abstract class Base implements Valued {
+        public abstract int value();
+    }
+
+    static class A extends Base {
+        public int value() {
+            return 1;
+        }
+    }
+
+    static class B extends Base {
+        public int value() {
+            return 2;
+        }
+    }
+
+    static class C extends Base {
+        public int value() {
+            return 3;
+        }
+    }
+
+    static class D extends Base {
+        public int value() {
+            return 4;
+        }
+    }
+
+    private static final Base[] MONOMORPHIC = { new A(), new A(), new A(), new A() };
+    private static final Base[] MEGAMORPHIC = { new A(), new B(), new C(), new D() };
+
+    static void run() throws Exception {
+        measureVirtual("dispatch.virtual.monomorphic", MONOMORPHIC);
+        measureVirtual("dispatch.virtual.megamorphic", MEGAMORPHIC);
+        measureInterface("dispatch.interface.monomorphic", MONOMORPHIC);
+        measureInterface("dispatch.interface.megamorphic", MEGAMORPHIC);
+    }
+
+    private static void measureVirtual(String name, final Base[] receivers) throws Exception {
+        Benchmark.measure(new Benchmark.Loop(name) {
+            void run(int reps) {
+                int sum = 0;
+                for (int i = 0; i < reps; i++) {
+                    sum += receivers[i & 3].value();
+                }
+                Benchmark.intSink = sum;
+            }
+        });
+    }
+
+    private static void measureInterface(String name, final Valued[] receivers) throws Exception {
+        Benchmark.measure(new Benchmark.Loop(name) {
+            void run(int reps) {
+                int sum = 0;
+                for (int i = 0; i < reps; i++) {
+                    sum += receivers[i & 3].value();
+                }
+                Benchmark.intSink = sum;
+            }
+        });
+    }
+}
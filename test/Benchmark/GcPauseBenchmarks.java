@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.Arrays;
+
+/**
+ * Distributions of the pauses of the collector, measured with a live set large enough for the
+ * collections to have work to do.
+ */
+class GcPauseBenchmarks {
+    private static final int LIVE_ARRAYS = 16 * 1024;
+    private static final int ARRAY_LENGTH = 256;
+    private static final int EXPLICIT_GCS = 20;
+    private static final int CHURN_ALLOCATIONS = 4 * 1000 * 1000;
+    // The churning thread records the gaps between two of its allocations longer than this,
+    // which are mostly the pauses of the collections.
+    private static final long STALL_THRESHOLD_NS = 100 * 1000L;
+
+    static void run() {
+        if (Benchmark.isSelected("gc.explicit")) {
+            explicit();
+        }
+        if (Benchmark.isSelected("gc.churn_stall")) {
+            churn();
+        }
+    }
+
+    private static Object[] newLiveSet() {
+        Object[] live = new Object[LIVE_ARRAYS];
+        for (int i = 0; i < live.length; i++) {
+            live[i] = new byte[ARRAY_LENGTH];
+        }
+        return live;
+    }
+
+    // The durations of explicit collections.
+    private static void explicit() {
+        Object[] live = newLiveSet();
+        long[] durations = new long[EXPLICIT_GCS];
+        for (int i = 0; i < EXPLICIT_GCS; i++) {
+            long start = System.nanoTime();
+            Runtime.getRuntime().gc();
+            durations[i] = System.nanoTime() - start;
+        }
+        Benchmark.objectSink = live;
+        Benchmark.reportDistribution("gc.explicit", durations, EXPLICIT_GCS);
+    }
+
+    // The stalls of a thread replacing the arrays of its live set, which triggers collections.
+    private static void churn() {
+        Object[] live = newLiveSet();
+        long[] stalls = new long[1024];
+        int stallCount = 0;
+        long last = System.nanoTime();
+        for (int i = 0; i < CHURN_ALLOCATIONS; i++) {
+            live[i % LIVE_ARRAYS] = new byte[ARRAY_LENGTH];
+            long now = System.nanoTime();
+            if (now - last > STALL_THRESHOLD_NS) {
+                if (stallCount == stalls.length) {
+                    stalls = Arrays.copyOf(stalls, stalls.length * 2);
+                }
+                stalls[stallCount++] = now - last;
+            }
+            last = now;
+        }
+        Benchmark.objectSink = live;
+        Benchmark.reportDistribution("gc.churn_stall", stalls, stallCount);
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * The cost of calls from managed code to native methods, and from native code to managed
+ * methods.
+ */
+class JniBenchmarks {
+    static native void nativeStatic();
+    native void nativeVirtual();
+    static native int nativeStaticArgs(int i, long l, Object o);
+    static native Object nativeStaticReturnObject(Object o);
+    // Calls callee() through CallStaticVoidMethod {@code reps} times.
+    static native void nativeCallStaticVoidMethod(int reps);
+
+    static void callee() {
+    }
+
+    static void run() throws Exception {
+        Benchmark.measure(new Benchmark.Loop("jni.static") {
+            void run(int reps) {
+                for (int i = 0; i < reps; i++) {
+                    nativeStatic();
+                }
+            }
+        });
+        final JniBenchmarks receiver = new JniBenchmarks();
+        Benchmark.measure(new Benchmark.Loop("jni.virtual") {
+            void run(int reps) {
+                for (int i = 0; i < reps; i++) {
+                    receiver.nativeVirtual();
+                }
+            }
+        });
+        Benchmark.measure(new Benchmark.Loop("jni.static_args") {
+            void run(int reps) {
+                int sum = 0;
+                for (int i = 0; i < reps; i++) {
+                    sum += nativeStaticArgs(i, 1L, receiver);
+                }
+                Benchmark.intSink = sum;
+            }
+        });
+        Benchmark.measure(new Benchmark.Loop("jni.static_return_object") {
+            void run(int reps) {
+                Object result = null;
+                for (int i = 0; i < reps; i++) {
+                    result = nativeStaticReturnObject(receiver);
+                }
+                Benchmark.objectSink = result;
+            }
+        });
+        Benchmark.measure(new Benchmark.Loop("jni.call_static_void_method") {
+            void run(int reps) {
+                nativeCallStaticVoidMethod(reps);
+            }
+        });
+    }
+}
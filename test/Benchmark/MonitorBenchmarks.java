@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Monitor enter and exit, on thin and inflated locks, and under contention.
+ */
+class MonitorBenchmarks {
+    private static final int[] CONTENDING_THREADS = { 2, 4 };
+
+    private static int counter;
+
+    static void run() throws Exception {
+        final Object thin = new Object();
+        Benchmark.measure(new Benchmark.Loop("monitor.uncontended.thin") {
+            void run(int reps) {
+                for (int i = 0; i < reps; i++) {
+                    synchronized (thin) {
+                        counter++;
+                    }
+                }
+            }
+        });
+        // Locking an object with an identity hash code inflates its lock.
+        final Object fat = new Object();
+        Benchmark.intSink = fat.hashCode();
+        Benchmark.measure(new Benchmark.Loop("monitor.uncontended.fat") {
+            void run(int reps) {
+                for (int i = 0; i < reps; i++) {
+                    synchronized (fat) {
+                        counter++;
+                    }
+                }
+            }
+        });
+        Benchmark.measure(new Benchmark.Loop("monitor.recursive") {
+            void run(int reps) {
+                synchronized (thin) {
+                    for (int i = 0; i < reps; i++) {
+                        synchronized (thin) {
+                            counter++;
+                        }
+                    }
+                }
+            }
+        });
+        for (final int threadCount : CONTENDING_THREADS) {
+            Benchmark.measure(new Benchmark.Loop("monitor.contended." + threadCount) {
+                void run(final int reps) throws Exception {
+                    final Object lock = new Object();
+                    Thread[] threads = new Thread[threadCount];
+                    for (int t = 0; t < threadCount; t++) {
+                        threads[t] = new Thread() {
+                            public void run() {
+                                for (int i = 0; i < reps / threadCount; i++) {
+                                    synchronized (lock) {
+                                        counter++;
+                                    }
+                                }
+                            }
+                        };
+                    }
+                    for (Thread thread : threads) {
+                        thread.start();
+                    }
+                    for (Thread thread : threads) {
+                        thread.join();
+                    }
+                }
+            });
+        }
+        Benchmark.intSink = counter;
+    }
+}
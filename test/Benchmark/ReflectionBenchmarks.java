@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.lang.reflect.Constructor;
+import java.lang.reflect.Field;
+import java.lang.reflect.Method;
+
+/**
+ * Calls, field accesses and allocations through reflection, and member lookups.
+ */
+class ReflectionBenchmarks {
+    public int field;
+
+    public ReflectionBenchmarks() {
+    }
+
+    public static void staticMethod() {
+    }
+
+    public int virtualMethod(int i) {
+        return i;
+    }
+
+    static void run() throws Exception {
+        final Method staticMethod = ReflectionBenchmarks.class.getMethod("staticMethod");
+        final Method virtualMethod =
+            ReflectionBenchmarks.class.getMethod("virtualMethod", int.class);
+        final Field field = ReflectionBenchmarks.class.getField("field");
+        final Constructor<ReflectionBenchmarks> constructor =
+            ReflectionBenchmarks.class.getConstructor();
+        final ReflectionBenchmarks receiver = new ReflectionBenchmarks();
+
+        Benchmark.measure(new Benchmark.Loop("reflect.invoke_static") {
+            void run(int reps) throws Exception {
+                for (int i = 0; i < reps; i++) {
+                    staticMethod.invoke(null);
+                }
+            }
+        });
+        Benchmark.measure(new Benchmark.Loop("reflect.invoke_virtual_boxed_arg") {
+            void run(int reps) throws Exception {
+                Object result = null;
+                for (int i = 0; i < reps; i++) {
+                    result = virtualMethod.invoke(receiver, i);
+                }
+                Benchmark.objectSink = result;
+            }
+        });
+        Benchmark.measure(new Benchmark.Loop("reflect.field_get_int") {
+            void run(int reps) throws Exception {
+                int sum = 0;
+                for (int i = 0; i < reps; i++) {
+                    sum += field.getInt(receiver);
+                }
+                Benchmark.intSink = sum;
+            }
+        });
+        Benchmark.measure(new Benchmark.Loop("reflect.field_set_int") {
+            void run(int reps) throws Exception {
+                for (int i = 0; i < reps; i++) {
+                    field.setInt(receiver, i);
+                }
+            }
+        });
+        Benchmark.measure(new Benchmark.Loop("reflect.new_instance") {
+            void run(int reps) throws Exception {
+                Object result = null;
+                for (int i = 0; i < reps; i++) {
+                    result = constructor.newInstance();
+                }
+                Benchmark.objectSink = result;
+            }
+        });
+        Benchmark.measure(new Benchmark.Loop("reflect.get_method") {
+            void run(int reps) throws Exception {
+                Object result = null;
+                for (int i = 0; i < reps; i++) {
+                    result = ReflectionBenchmarks.class.getMethod("virtualMethod", int.class);
+                }
+                Benchmark.objectSink = result;
+            }
+        });
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2014 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jni.h"
+
+// The native methods of JniBenchmarks. The library doesn't link against the runtime, so that the
+// benchmarks can load it in the non-debug runtime.
+
+extern "C" JNIEXPORT void JNICALL Java_JniBenchmarks_nativeStatic(JNIEnv*, jclass) {
+}
+
+extern "C" JNIEXPORT void JNICALL Java_JniBenchmarks_nativeVirtual(JNIEnv*, jobject) {
+}
+
+extern "C" JNIEXPORT jint JNICALL Java_JniBenchmarks_nativeStaticArgs(JNIEnv*, jclass, jint i,
+                                                                      jlong, jobject) {
+  return i;
+}
+
+extern "C" JNIEXPORT jobject JNICALL Java_JniBenchmarks_nativeStaticReturnObject(JNIEnv*, jclass,
+                                                                                 jobject o) {
+  return o;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_JniBenchmarks_nativeCallStaticVoidMethod(JNIEnv* env,
+                                                                                jclass klass,
+                                                                                jint reps) {
+  jmethodID callee = env->GetStaticMethodID(klass, "callee", "()V");
+  if (callee == nullptr) {
+    return;
+  }
+  for (jint i = 0; i < reps; ++i) {
+    env->CallStaticVoidMethod(klass, callee);
+  }
+}
@@ -0,0 +1,97 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2014 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Compares two dex2oat --dump-method-stats files of the same dex files.
+
+Prints the total compile time, peak arena memory and code size of each file
+and their change, then the methods that regressed the most for each of them.
+Exits with 1 if the total code size or the total arena memory grew by more
+than --max-regression percent. The compile time is only reported, it is too
+noisy to fail on.
+"""
+
+import optparse
+import sys
+
+
+_COLUMNS = ('compile ns', 'arena bytes', 'code bytes')
+_CHECKED_COLUMNS = (1, 2)
+
+
+def ReadStats(filename):
+  stats = {}
+  for line in open(filename):
+    fields = line.rstrip('\n').split(' ', 3)
+    if len(fields) != 4:
+      sys.stderr.write('%s: malformed line: %s' % (filename, line))
+      sys.exit(2)
+    stats[fields[3]] = tuple(int(field) for field in fields[:3])
+  return stats
+
+
+def Percent(old, new):
+  if old == 0:
+    return 0.0
+  return 100.0 * (new - old) / old
+
+
+def main():
+  parser = optparse.OptionParser(usage='%prog [options] <baseline> <new>')
+  parser.add_option('--max-regression', type='float', default=1.0,
+                    help='percent growth of the total code size or arena memory that fails')
+  parser.add_option('--top', type='int', default=10,
+                    help='number of most regressed methods to list per column')
+  options, args = parser.parse_args()
+  if len(args) != 2:
+    parser.error('expected a baseline and a new stats file')
+  baseline = ReadStats(args[0])
+  new = ReadStats(args[1])
+
+  common = [method for method in new if method in baseline]
+  print('%d methods in both, %d only in the baseline, %d only in the new file' %
+        (len(common), len(baseline) - len(common), len(new) - len(common)))
+
+  failed = False
+  for column, name in enumerate(_COLUMNS):
+    old_total = sum(baseline[method][column] for method in common)
+    new_total = sum(new[method][column] for method in common)
+    change = Percent(old_total, new_total)
+    print('%-12s %14d -> %14d  %+.2f%%' % (name, old_total, new_total, change))
+    if column in _CHECKED_COLUMNS and change > options.max_regression:
+      failed = True
+
+  for column, name in enumerate(_COLUMNS):
+    regressions = sorted(common,
+                         key=lambda method: baseline[method][column] - new[method][column])
+    regressions = [method for method in regressions[:options.top]
+                   if new[method][column] > baseline[method][column]]
+    if regressions:
+      print('')
+      print('Most regressed %s:' % name)
+      for method in regressions:
+        print('  %+d (%d -> %d) %s' % (new[method][column] - baseline[method][column],
+                                      baseline[method][column], new[method][column], method))
+
+  if failed:
+    print('')
+    print('FAILED: the total code size or arena memory grew by more than %.2f%%' %
+          options.max_regression)
+    return 1
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())